@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+#
+#  compare_benchmarks.py
+#
+#  Compare two JSON result files written by osmium_benchmark_pipeline and
+#  report configurations that got slower or use more memory.
+#
+#  Exits with status 1 if any regression was found, so it can be used in
+#  scripts.
+#
+
+import argparse
+import json
+import sys
+
+
+def load(filename):
+    with open(filename) as f:
+        data = json.load(f)
+    if data.get('benchmark') != 'pipeline':
+        sys.exit(f"{filename}: not a pipeline benchmark result")
+    return data
+
+
+def key(result):
+    return (result['threads'], result['buffer_size'])
+
+
+def change(old, new):
+    if old == 0:
+        return 0.0
+    return (new - old) / old * 100.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare two pipeline benchmark results.')
+    parser.add_argument('old', help='baseline result file')
+    parser.add_argument('new', help='result file to check')
+    parser.add_argument('--threshold', type=float, default=5.0,
+                        help='allowed slowdown/memory growth in percent (default 5)')
+    args = parser.parse_args()
+
+    old = load(args.old)
+    new = load(args.new)
+
+    if old['mode'] != new['mode'] or old['input']['size'] != new['input']['size']:
+        print("warning: results are for different modes or input files", file=sys.stderr)
+
+    old_results = {key(r): r for r in old['results']}
+
+    print(f"{'threads':>7} {'buffer':>10} {'old s':>9} {'new s':>9} {'time %':>8} "
+          f"{'old MB':>7} {'new MB':>7} {'mem %':>7}")
+
+    regressions = 0
+    for result in new['results']:
+        base = old_results.get(key(result))
+        if base is None:
+            continue
+
+        old_time = base['time']['median']
+        new_time = result['time']['median']
+        time_change = change(old_time, new_time)
+
+        # A slowdown only counts if it is larger than the noise of both runs.
+        noise = base['time']['stddev'] + result['time']['stddev']
+        slower = time_change > args.threshold and new_time - old_time > noise
+
+        # Memory is reported in whole MBytes, ignore differences of 1 MB.
+        mem_change = change(base['peak_rss_mb'], result['peak_rss_mb'])
+        bigger = mem_change > args.threshold and result['peak_rss_mb'] - base['peak_rss_mb'] > 1
+
+        mark = ''
+        if slower or bigger:
+            regressions += 1
+            mark = ' <-- regression'
+
+        print(f"{result['threads']:>7} {result['buffer_size']:>10} "
+              f"{old_time:>9.3f} {new_time:>9.3f} {time_change:>+7.1f}% "
+              f"{base['peak_rss_mb']:>7} {result['peak_rss_mb']:>7} {mem_change:>+6.1f}%{mark}")
+
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,20 @@
+#!/bin/sh
+#
+#  download_area_data.sh
+#
+#  Downloads some very large boundary relations with all their members
+#  from the OSM API into $DATA_DIR/areas for the area benchmark. Set
+#  OB_AREA_RELATIONS to a list of relation ids to get different ones.
+#
+
+set -e
+
+# Germany, Russia, Canada
+OB_AREA_RELATIONS=${OB_AREA_RELATIONS:-"51477 60189 1428125"}
+
+mkdir -p $DATA_DIR/areas
+cd $DATA_DIR/areas
+for id in $OB_AREA_RELATIONS; do
+    curl --location --output relation_$id.osm https://api.openstreetmap.org/api/0.6/relation/$id/full
+done
+
@@ -0,0 +1,507 @@
+/*
+
+  Benchmark for the area assembly.
+
+  The first part runs the Assembler on every multipolygon and boundary
+  relation in the input file on its own and measures the time and the
+  number and size of memory allocations for each of them. It reports
+  the sum of the assembler statistics (including the time spent in the
+  different phases), a histogram of the assembly time by number of
+  segments, and the relations that took longest.
+
+  The second part runs the MultipolygonManager on the whole file the way
+  a program would, once with serial assembly and once with parallel
+  assembly for each of the given thread pool sizes, and reports the run
+  time of the second pass and the speedup.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/multipolygon_manager.hpp>
+#include <osmium/area/timing_stats.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/relations/relations_manager.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Count all allocations done through the global operator new. The
+// counters are only read while no other threads allocate memory.
+// GCC sees the malloc/free behind inlined new/delete and warns about
+// a mismatch that isn't there.
+#pragma GCC diagnostic push
+#if !defined(__clang__) && defined(__GNUC__) && (__GNUC__ > 10)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+static std::atomic<uint64_t> allocation_count{0};
+static std::atomic<uint64_t> allocation_bytes{0};
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    void* ptr = std::malloc(size == 0 ? 1 : size); // NOLINT(cppcoreguidelines-no-malloc,hicpp-no-malloc)
+    if (!ptr) {
+        throw std::bad_alloc{};
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr); // NOLINT(cppcoreguidelines-no-malloc,hicpp-no-malloc)
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr); // NOLINT(cppcoreguidelines-no-malloc,hicpp-no-malloc)
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+    std::free(ptr); // NOLINT(cppcoreguidelines-no-malloc,hicpp-no-malloc)
+}
+
+void operator delete[](void* ptr, std::size_t /*size*/) noexcept {
+    std::free(ptr); // NOLINT(cppcoreguidelines-no-malloc,hicpp-no-malloc)
+}
+#pragma GCC diagnostic pop
+
+using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
+using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+
+struct Options {
+    std::string input_filename;
+    std::string json_filename;
+    std::vector<int> threads;
+    std::size_t top = 10;
+    int runs = 3;
+};
+
+struct RelationResult {
+    osmium::object_id_type id;
+    std::size_t members;
+    uint64_t segments;
+    uint64_t nanoseconds;
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+    bool okay;
+};
+
+struct ScalingResult {
+    std::string mode;
+    int threads;
+    uint64_t areas;
+    double seconds;
+    double speedup;
+};
+
+static std::vector<std::string> split(const std::string& value) {
+    std::vector<std::string> result;
+    std::istringstream in{value};
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        result.push_back(item);
+    }
+    if (result.empty()) {
+        throw std::invalid_argument{"empty list"};
+    }
+    return result;
+}
+
+static void print_help(const char* program) {
+    std::cout << "Usage: " << program << " [OPTIONS] INPUT-FILE\n\n"
+              << "Options:\n"
+              << "  --threads=N[,N...]  Pool sizes for parallel assembly (default: 1,2,4,... up to number of cores)\n"
+              << "  --runs=N            Runs per relation and configuration (default 3)\n"
+              << "  --top=N             Number of slowest relations to show (default 10)\n"
+              << "  --json=FILE         Also write results as JSON to FILE\n";
+}
+
+static Options parse_options(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg{argv[i]};
+        if (arg == "-h" || arg == "--help") {
+            print_help(argv[0]);
+            std::exit(0); // NOLINT(concurrency-mt-unsafe)
+        }
+        if (arg.substr(0, 2) != "--") {
+            if (!options.input_filename.empty()) {
+                throw std::invalid_argument{"only one input file allowed"};
+            }
+            options.input_filename = arg;
+            continue;
+        }
+        const auto eq = arg.find('=');
+        if (eq == std::string::npos) {
+            throw std::invalid_argument{"option needs a value: " + arg};
+        }
+        const std::string name = arg.substr(2, eq - 2);
+        const std::string value = arg.substr(eq + 1);
+        if (name == "threads") {
+            for (const auto& item : split(value)) {
+                options.threads.push_back(std::stoi(item));
+            }
+        } else if (name == "runs") {
+            options.runs = std::max(1, std::stoi(value));
+        } else if (name == "top") {
+            options.top = static_cast<std::size_t>(std::max(0, std::stoi(value)));
+        } else if (name == "json") {
+            options.json_filename = value;
+        } else {
+            throw std::invalid_argument{"unknown option: " + arg};
+        }
+    }
+
+    if (options.input_filename.empty()) {
+        throw std::invalid_argument{"missing input file"};
+    }
+
+    if (options.threads.empty()) {
+        const auto cores = std::max(1U, std::thread::hardware_concurrency());
+        for (unsigned int n = 1; n < cores; n *= 2) {
+            options.threads.push_back(static_cast<int>(n));
+        }
+        options.threads.push_back(static_cast<int>(cores));
+    }
+    std::sort(options.threads.begin(), options.threads.end());
+    if (options.threads.front() < 1) {
+        throw std::invalid_argument{"thread counts must be at least 1"};
+    }
+
+    return options;
+}
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const auto mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+static bool is_area_relation(const osmium::Relation& relation) {
+    const char* type = relation.tags().get_value_by_key("type");
+    return type && (!std::strcmp(type, "multipolygon") || !std::strcmp(type, "boundary"));
+}
+
+/**
+ * The relations and the member ways (with locations) needed for the
+ * per-relation benchmark.
+ */
+class AreaData {
+
+    osmium::memory::Buffer m_relations{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    osmium::memory::Buffer m_ways{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    std::vector<std::pair<osmium::object_id_type, const osmium::Way*>> m_way_index;
+
+public:
+
+    explicit AreaData(const std::string& filename) {
+        std::vector<osmium::object_id_type> way_ids;
+        {
+            osmium::io::Reader reader{filename, osmium::osm_entity_bits::relation};
+            while (const osmium::memory::Buffer buffer = reader.read()) {
+                for (const auto& relation : buffer.select<osmium::Relation>()) {
+                    if (!is_area_relation(relation)) {
+                        continue;
+                    }
+                    m_relations.add_item(relation);
+                    m_relations.commit();
+                    for (const auto& member : relation.members()) {
+                        if (member.type() == osmium::item_type::way) {
+                            way_ids.push_back(member.ref());
+                        }
+                    }
+                }
+            }
+            reader.close();
+        }
+        std::sort(way_ids.begin(), way_ids.end());
+
+        index_type index;
+        location_handler_type location_handler{index};
+        location_handler.ignore_errors();
+
+        osmium::io::Reader reader{filename, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way};
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            osmium::apply(buffer, location_handler);
+            for (const auto& way : buffer.select<osmium::Way>()) {
+                if (std::binary_search(way_ids.begin(), way_ids.end(), way.id())) {
+                    m_ways.add_item(way);
+                    m_ways.commit();
+                }
+            }
+        }
+        reader.close();
+
+        // The buffer doesn't move any more, so it is safe to keep pointers.
+        for (const auto& way : m_ways.select<osmium::Way>()) {
+            m_way_index.emplace_back(way.id(), &way);
+        }
+        std::sort(m_way_index.begin(), m_way_index.end());
+    }
+
+    const osmium::memory::Buffer& relations() const noexcept {
+        return m_relations;
+    }
+
+    /**
+     * Get the member ways of the relation in the order of the members.
+     * Returns false if any of them is missing.
+     */
+    bool members(const osmium::Relation& relation, std::vector<const osmium::Way*>& ways) const {
+        ways.clear();
+        for (const auto& member : relation.members()) {
+            if (member.type() != osmium::item_type::way) {
+                continue;
+            }
+            const auto it = std::lower_bound(m_way_index.begin(), m_way_index.end(),
+                                             std::make_pair(member.ref(), static_cast<const osmium::Way*>(nullptr)));
+            if (it == m_way_index.end() || it->first != member.ref()) {
+                return false;
+            }
+            ways.push_back(it->second);
+        }
+        return true;
+    }
+
+}; // class AreaData
+
+static void benchmark_relations(const Options& options, std::vector<RelationResult>& results,
+                                osmium::area::area_timing_stats& timing_stats, std::size_t& incomplete) {
+    std::cerr << "Reading relations and member ways...\n";
+    const AreaData data{options.input_filename};
+
+    osmium::area::AssemblerConfig config;
+    config.collect_timings = true;
+
+    std::cerr << "Assembling relations one by one...\n";
+    osmium::memory::Buffer out_buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    std::vector<const osmium::Way*> members;
+    for (const auto& relation : data.relations().select<osmium::Relation>()) {
+        if (!data.members(relation, members)) {
+            ++incomplete;
+            continue;
+        }
+
+        RelationResult result{relation.id(), members.size(), 0,
+                              std::numeric_limits<uint64_t>::max(), 0, 0, false};
+        for (int run = 0; run < options.runs; ++run) {
+            osmium::area::Assembler assembler{config};
+
+            const auto count = allocation_count.load();
+            const auto bytes = allocation_bytes.load();
+            const auto start = std::chrono::steady_clock::now();
+            const bool okay = assembler(relation, members, out_buffer);
+            const auto nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            const auto allocations = allocation_count.load() - count;
+            const auto allocated_bytes = allocation_bytes.load() - bytes;
+
+            if (run == 0) {
+                result.segments = assembler.stats().nodes;
+                result.allocations = allocations;
+                result.allocated_bytes = allocated_bytes;
+                result.okay = okay;
+                timing_stats.add(osmium::item_type::relation, relation.id(), assembler.stats());
+            }
+            result.nanoseconds = std::min(result.nanoseconds, nanoseconds);
+            out_buffer.clear();
+        }
+        results.push_back(result);
+    }
+}
+
+static std::pair<double, uint64_t> run_manager_once(const std::string& filename, int threads, bool parallel) {
+    osmium::thread::Pool pool{threads};
+
+    const osmium::area::Assembler::config_type config;
+    osmium::area::MultipolygonManager<osmium::area::Assembler> mp_manager{config};
+    if (parallel) {
+        mp_manager.enable_parallel_assembly(pool);
+    }
+
+    osmium::relations::read_relations(osmium::io::File{filename}, mp_manager);
+
+    index_type index;
+    location_handler_type location_handler{index};
+    location_handler.ignore_errors();
+
+    uint64_t areas = 0;
+    const auto start = std::chrono::steady_clock::now();
+    osmium::io::Reader reader{filename, pool};
+    osmium::apply(reader, location_handler, mp_manager.handler([&areas](const osmium::memory::Buffer& buffer) {
+        areas += static_cast<uint64_t>(std::distance(buffer.cbegin(), buffer.cend()));
+    }));
+    reader.close();
+
+    return std::make_pair(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), areas);
+}
+
+static ScalingResult run_manager(const Options& options, int threads, bool parallel) {
+    std::vector<double> times;
+    uint64_t areas = 0;
+    for (int run = 0; run < options.runs; ++run) {
+        const auto result = run_manager_once(options.input_filename, threads, parallel);
+        times.push_back(result.first);
+        areas = result.second;
+    }
+    return ScalingResult{parallel ? "parallel" : "serial", threads, areas, median(times), 1.0};
+}
+
+static void print_relations(const Options& options, std::vector<RelationResult> results,
+                            const osmium::area::area_timing_stats& timing_stats, std::size_t incomplete) {
+    uint64_t nanoseconds = 0;
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+    std::size_t failed = 0;
+    for (const auto& r : results) {
+        nanoseconds += r.nanoseconds;
+        allocations += r.allocations;
+        allocated_bytes += r.allocated_bytes;
+        if (!r.okay) {
+            ++failed;
+        }
+    }
+
+    std::cout << "relations: " << results.size() << " assembled (" << failed << " with errors), "
+              << incomplete << " incomplete\n"
+              << std::fixed << std::setprecision(3)
+              << "time: " << static_cast<double>(nanoseconds) / 1e9 << "s\n"
+              << "allocations: " << allocations << " ("
+              << std::setprecision(1) << static_cast<double>(allocated_bytes) / (1024.0 * 1024.0) << " MBytes)\n\n"
+              << "assembler statistics:\n" << timing_stats.stats() << "\n\n"
+              << "time by number of segments:\n"
+              << "segments relations       ms\n";
+    for (std::size_t n = 0; n < osmium::area::area_timing_stats::num_buckets; ++n) {
+        if (timing_stats.count(n) > 0) {
+            std::cout << std::setw(8) << (1ULL << n)
+                      << std::setw(10) << timing_stats.count(n)
+                      << std::setprecision(3) << std::setw(9) << static_cast<double>(timing_stats.nanoseconds(n)) / 1e6 << '\n';
+        }
+    }
+    std::cout << '\n';
+
+    std::sort(results.begin(), results.end(), [](const RelationResult& a, const RelationResult& b) {
+        return a.nanoseconds > b.nanoseconds;
+    });
+    if (results.size() > options.top) {
+        results.resize(options.top);
+    }
+
+    std::cout << "slowest relations:\n"
+              << "      relation members segments       ms allocations   KBytes ok\n";
+    for (const auto& r : results) {
+        std::cout << std::setw(14) << r.id
+                  << std::setw(8) << r.members
+                  << std::setw(9) << r.segments
+                  << std::setprecision(3) << std::setw(9) << static_cast<double>(r.nanoseconds) / 1e6
+                  << std::setw(12) << r.allocations
+                  << std::setprecision(1) << std::setw(9) << static_cast<double>(r.allocated_bytes) / 1024.0
+                  << std::setw(3) << (r.okay ? "y" : "n") << '\n';
+    }
+    std::cout << '\n';
+}
+
+static void print_scaling(const std::vector<ScalingResult>& results) {
+    std::cout << "mode     threads    areas  seconds speedup\n";
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(8) << r.mode << std::right
+                  << std::setw(8) << r.threads
+                  << std::setw(9) << r.areas
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(9) << r.seconds
+                  << std::setprecision(2)
+                  << std::setw(8) << r.speedup << '\n';
+    }
+}
+
+static void write_json(const Options& options, const std::vector<RelationResult>& relations,
+                       std::size_t incomplete, const std::vector<ScalingResult>& scaling) {
+    std::ofstream out{options.json_filename};
+    out << "{\n  \"benchmark\": \"area\",\n  \"format_version\": 1,\n"
+        << "  \"cores\": " << std::thread::hardware_concurrency() << ",\n"
+        << "  \"runs\": " << options.runs << ",\n"
+        << "  \"incomplete_relations\": " << incomplete << ",\n  \"relations\": [";
+    bool first = true;
+    for (const auto& r : relations) {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        out << "    {\"id\": " << r.id
+            << ", \"members\": " << r.members
+            << ", \"segments\": " << r.segments
+            << ", \"nanoseconds\": " << r.nanoseconds
+            << ", \"allocations\": " << r.allocations
+            << ", \"allocated_bytes\": " << r.allocated_bytes
+            << ", \"okay\": " << (r.okay ? "true" : "false") << '}';
+    }
+    out << "\n  ],\n  \"scaling\": [";
+    first = true;
+    for (const auto& r : scaling) {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        out << "    {\"mode\": \"" << r.mode << "\", \"threads\": " << r.threads
+            << ", \"areas\": " << r.areas
+            << ", \"seconds\": " << r.seconds
+            << ", \"speedup\": " << r.speedup << '}';
+    }
+    out << "\n  ]\n}\n";
+    if (!out) {
+        throw std::runtime_error{"could not write " + options.json_filename};
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        const Options options = parse_options(argc, argv);
+
+        std::vector<RelationResult> relations;
+        osmium::area::area_timing_stats timing_stats{0};
+        std::size_t incomplete = 0;
+        benchmark_relations(options, relations, timing_stats, incomplete);
+        print_relations(options, relations, timing_stats, incomplete);
+
+        std::cerr << "Running multipolygon manager...\n";
+        std::vector<ScalingResult> scaling;
+        scaling.push_back(run_manager(options, options.threads.front(), false));
+        for (const int threads : options.threads) {
+            scaling.push_back(run_manager(options, threads, true));
+            scaling.back().speedup = scaling.front().seconds / scaling.back().seconds;
+        }
+        print_scaling(scaling);
+
+        if (!options.json_filename.empty()) {
+            write_json(options, relations, incomplete, scaling);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
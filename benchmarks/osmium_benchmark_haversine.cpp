@@ -0,0 +1,106 @@
+/*
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <osmium/geom/haversine.hpp>
+#include <osmium/geom/spherical_area.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/visitor.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
+using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+
+struct WayCollector : public osmium::handler::Handler {
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    void way(const osmium::Way& way) {
+        for (const auto& node_ref : way.nodes()) {
+            if (!node_ref.location().valid()) {
+                return;
+            }
+        }
+        buffer.add_item(way);
+        buffer.commit();
+    }
+
+};
+
+// Length of a way calculated one segment at a time.
+double scalar_length(const osmium::WayNodeList& wnl) {
+    double sum = 0.0;
+    for (std::size_t i = 1; i < wnl.size(); ++i) {
+        sum += osmium::geom::haversine::distance(wnl[i - 1].location(), wnl[i].location());
+    }
+    return sum;
+}
+
+// Compare calculating the length of all ways one segment at a time with
+// the batched version and calculate the area of all closed ways.
+void compare_scalar_and_batch(const osmium::memory::Buffer& buffer) {
+    double scalar_sum = 0.0;
+    double batch_sum = 0.0;
+    double area_sum = 0.0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        scalar_sum += scalar_length(way.nodes());
+    }
+    const auto middle = std::chrono::steady_clock::now();
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        batch_sum += osmium::geom::haversine::distance(way.nodes());
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        if (way.is_closed()) {
+            area_sum += std::abs(osmium::geom::spherical_signed_ring_area(way.nodes()));
+        }
+    }
+    const auto area_stop = std::chrono::steady_clock::now();
+
+    std::cout << "length scalar: " << scalar_sum << "m in " << std::chrono::duration_cast<std::chrono::microseconds>(middle - start).count()
+              << "us\nlength batch: " << batch_sum << "m in " << std::chrono::duration_cast<std::chrono::microseconds>(stop - middle).count()
+              << "us\narea of closed ways: " << area_sum << "m^2 in " << std::chrono::duration_cast<std::chrono::microseconds>(area_stop - stop).count()
+              << "us\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " OSMFILE\n";
+        return 1;
+    }
+
+    try {
+        const std::string input_filename{argv[1]};
+
+        osmium::io::Reader reader{input_filename, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way};
+
+        index_type index;
+        location_handler_type location_handler{index};
+        location_handler.ignore_errors();
+
+        WayCollector collector;
+        osmium::apply(reader, location_handler, collector);
+        reader.close();
+
+        compare_scalar_and_batch(collector.buffer);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,488 @@
+/*
+
+  Location index trace benchmark.
+
+  "record" mode reads an OSM file and writes a compact trace file with
+  all node locations stored in the index and the node ids looked up for
+  the ways, in the order NodeLocationsForWays would do it. Only positive
+  ids are recorded.
+
+  "replay" mode reads the trace and replays it against location index
+  maps created with the MapFactory: first all locations are set and the
+  index is sorted, then the lookups are done with a number of threads.
+  The threads share the (then read-only) index and each replays an equal
+  part of the ways. Lookups are done way by way either with get_many(),
+  which prefetches, or with one get_noexcept() call per node.
+
+  The trace file is delta and varint encoded:
+
+    "OSMIDXT1" magic
+    varint number of nodes
+      for each node: zigzag varint deltas of id, x, and y
+    varint number of ways
+      for each way: varint number of nodes, then zigzag varint deltas of
+      the node ids (continued across ways)
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/index/map/all.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/visitor.hpp>
+
+#include <protozero/varint.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using index_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+
+static const char trace_magic[] = "OSMIDXT1";
+
+struct Trace {
+    std::vector<std::pair<osmium::unsigned_object_id_type, osmium::Location>> nodes;
+    std::vector<osmium::unsigned_object_id_type> lookups;
+    std::vector<std::size_t> way_offsets{0};
+};
+
+struct Options {
+    std::string mode;
+    std::string input_filename;
+    std::string trace_filename;
+    std::string json_filename;
+    std::vector<std::string> maps;
+    std::vector<int> threads{1};
+    std::vector<std::string> prefetch{"yes"};
+    std::vector<std::string> huge_pages{"no"};
+    int runs = 3;
+};
+
+struct Result {
+    std::string map;
+    std::string prefetch;
+    std::string huge_pages;
+    int threads;
+    double load_seconds;
+    double lookup_seconds;
+    std::size_t found;
+};
+
+/* ------------------------------------------------------------------ */
+
+class TraceWriter {
+
+    std::string m_data;
+    int64_t m_last_id = 0;
+    int64_t m_last_x = 0;
+    int64_t m_last_y = 0;
+
+    void add_varint(uint64_t value) {
+        protozero::write_varint(std::back_inserter(m_data), value);
+    }
+
+    void add_delta(int64_t value, int64_t& last) {
+        add_varint(protozero::encode_zigzag64(value - last));
+        last = value;
+    }
+
+public:
+
+    void nodes(const Trace& trace) {
+        add_varint(trace.nodes.size());
+        for (const auto& node : trace.nodes) {
+            add_delta(static_cast<int64_t>(node.first), m_last_id);
+            add_delta(node.second.x(), m_last_x);
+            add_delta(node.second.y(), m_last_y);
+        }
+        m_last_id = 0;
+    }
+
+    void ways(const Trace& trace) {
+        add_varint(trace.way_offsets.size() - 1);
+        for (std::size_t i = 1; i < trace.way_offsets.size(); ++i) {
+            add_varint(trace.way_offsets[i] - trace.way_offsets[i - 1]);
+            for (std::size_t n = trace.way_offsets[i - 1]; n < trace.way_offsets[i]; ++n) {
+                add_delta(static_cast<int64_t>(trace.lookups[n]), m_last_id);
+            }
+        }
+    }
+
+    const std::string& data() const noexcept {
+        return m_data;
+    }
+
+}; // class TraceWriter
+
+// Collects the trace in memory. The lookups are the same NodeLocationsForWays
+// does: all node refs of all ways in order.
+class TraceRecorder : public osmium::handler::Handler {
+
+    Trace& m_trace;
+
+public:
+
+    explicit TraceRecorder(Trace& trace) :
+        m_trace(trace) {
+    }
+
+    void node(const osmium::Node& node) {
+        if (node.id() > 0 && node.location().valid()) {
+            m_trace.nodes.emplace_back(node.positive_id(), node.location());
+        }
+    }
+
+    void way(const osmium::Way& way) {
+        for (const auto& node_ref : way.nodes()) {
+            if (node_ref.ref() > 0) {
+                m_trace.lookups.push_back(node_ref.positive_ref());
+            }
+        }
+        m_trace.way_offsets.push_back(m_trace.lookups.size());
+    }
+
+}; // class TraceRecorder
+
+static void record(const Options& options) {
+    Trace trace;
+    TraceRecorder recorder{trace};
+
+    osmium::io::Reader reader{options.input_filename, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way};
+    osmium::apply(reader, recorder);
+    reader.close();
+
+    TraceWriter writer;
+    writer.nodes(trace);
+    writer.ways(trace);
+
+    std::ofstream out{options.trace_filename, std::ios::binary};
+    out.write(trace_magic, std::strlen(trace_magic));
+    out.write(writer.data().data(), static_cast<std::streamsize>(writer.data().size()));
+    if (!out) {
+        throw std::runtime_error{"could not write " + options.trace_filename};
+    }
+
+    std::cerr << "Recorded " << trace.nodes.size() << " nodes and "
+              << trace.lookups.size() << " lookups in "
+              << (trace.way_offsets.size() - 1) << " ways ("
+              << writer.data().size() << " bytes)\n";
+}
+
+static Trace read_trace(const std::string& filename) {
+    std::ifstream in{filename, std::ios::binary};
+    const std::string data{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    const auto magic_size = std::strlen(trace_magic);
+    if (data.size() < magic_size || data.compare(0, magic_size, trace_magic) != 0) {
+        throw std::runtime_error{"not a trace file: " + filename};
+    }
+
+    const char* pos = data.data() + magic_size;
+    const char* const end = data.data() + data.size();
+    const auto delta = [&](int64_t& last) {
+        last += protozero::decode_zigzag64(protozero::decode_varint(&pos, end));
+        return last;
+    };
+
+    Trace trace;
+    int64_t id = 0;
+    int64_t x = 0;
+    int64_t y = 0;
+    trace.nodes.resize(protozero::decode_varint(&pos, end));
+    for (auto& node : trace.nodes) {
+        node.first = static_cast<osmium::unsigned_object_id_type>(delta(id));
+        const auto nx = static_cast<int32_t>(delta(x));
+        node.second = osmium::Location{nx, static_cast<int32_t>(delta(y))};
+    }
+
+    id = 0;
+    const auto num_ways = protozero::decode_varint(&pos, end);
+    trace.way_offsets.reserve(num_ways + 1);
+    for (uint64_t i = 0; i < num_ways; ++i) {
+        const auto count = protozero::decode_varint(&pos, end);
+        for (uint64_t n = 0; n < count; ++n) {
+            trace.lookups.push_back(static_cast<osmium::unsigned_object_id_type>(delta(id)));
+        }
+        trace.way_offsets.push_back(trace.lookups.size());
+    }
+
+    return trace;
+}
+
+/* ------------------------------------------------------------------ */
+
+static std::vector<std::string> split(const std::string& value) {
+    std::vector<std::string> result;
+    std::istringstream in{value};
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        result.push_back(item);
+    }
+    if (result.empty()) {
+        throw std::invalid_argument{"empty list"};
+    }
+    return result;
+}
+
+static std::vector<std::string> split_yes_no(const std::string& name, const std::string& value) {
+    auto result = split(value);
+    for (const auto& v : result) {
+        if (v != "yes" && v != "no") {
+            throw std::invalid_argument{"--" + name + " must be yes or no"};
+        }
+    }
+    return result;
+}
+
+static void print_help(const char* program) {
+    std::cout << "Usage: " << program << " record INPUT-FILE TRACE-FILE\n"
+              << "       " << program << " replay [OPTIONS] TRACE-FILE\n\n"
+              << "Replay options:\n"
+              << "  --map=TYPE           Map type (can be given several times, default: all\n"
+              << "                       map types available)\n"
+              << "  --threads=N[,N...]   Number of lookup threads (default: 1)\n"
+              << "  --prefetch=yes,no    Look up ways with get_many() (prefetching) or\n"
+              << "                       one get_noexcept() per node (default: yes)\n"
+              << "  --hugepages=yes,no   Use huge pages for the *_mmap_array maps (default: no)\n"
+              << "  --runs=N             Lookup runs per configuration (default 3)\n"
+              << "  --json=FILE          Also write results as JSON to FILE\n";
+}
+
+static Options parse_options(int argc, char* argv[]) {
+    Options options;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg{argv[i]};
+        if (arg == "-h" || arg == "--help") {
+            print_help(argv[0]);
+            std::exit(0); // NOLINT(concurrency-mt-unsafe)
+        }
+        if (arg.substr(0, 2) != "--") {
+            args.push_back(arg);
+            continue;
+        }
+        const auto eq = arg.find('=');
+        if (eq == std::string::npos) {
+            throw std::invalid_argument{"option needs a value: " + arg};
+        }
+        const std::string name = arg.substr(2, eq - 2);
+        const std::string value = arg.substr(eq + 1);
+        if (name == "map") {
+            options.maps.push_back(value);
+        } else if (name == "threads") {
+            options.threads.clear();
+            for (const auto& t : split(value)) {
+                options.threads.push_back(std::max(1, std::stoi(t)));
+            }
+        } else if (name == "prefetch") {
+            options.prefetch = split_yes_no(name, value);
+        } else if (name == "hugepages") {
+            options.huge_pages = split_yes_no(name, value);
+        } else if (name == "runs") {
+            options.runs = std::max(1, std::stoi(value));
+        } else if (name == "json") {
+            options.json_filename = value;
+        } else {
+            throw std::invalid_argument{"unknown option: " + arg};
+        }
+    }
+
+    if (args.empty()) {
+        throw std::invalid_argument{"missing mode (record or replay)"};
+    }
+    options.mode = args[0];
+    if (options.mode == "record") {
+        if (args.size() != 3) {
+            throw std::invalid_argument{"record needs INPUT-FILE and TRACE-FILE"};
+        }
+        options.input_filename = args[1];
+        options.trace_filename = args[2];
+    } else if (options.mode == "replay") {
+        if (args.size() != 2) {
+            throw std::invalid_argument{"replay needs TRACE-FILE"};
+        }
+        options.trace_filename = args[1];
+    } else {
+        throw std::invalid_argument{"unknown mode: " + options.mode};
+    }
+
+    if (options.maps.empty()) {
+        options.maps = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance().map_types();
+    }
+
+    return options;
+}
+
+/* ------------------------------------------------------------------ */
+
+static std::size_t replay_ways(const index_type& index, const Trace& trace, std::size_t first_way, std::size_t last_way, bool prefetch) {
+    std::size_t found = 0;
+    std::vector<osmium::Location> locations;
+    for (std::size_t w = first_way; w < last_way; ++w) {
+        const auto begin = trace.way_offsets[w];
+        const auto count = trace.way_offsets[w + 1] - begin;
+        if (prefetch) {
+            locations.resize(count);
+            index.get_many(trace.lookups.data() + begin, count, locations.data());
+            for (const auto& location : locations) {
+                found += location.valid() ? 1 : 0;
+            }
+        } else {
+            for (std::size_t n = begin; n < begin + count; ++n) {
+                found += index.get_noexcept(trace.lookups[n]).valid() ? 1 : 0;
+            }
+        }
+    }
+    return found;
+}
+
+static std::pair<double, std::size_t> replay_lookups(const index_type& index, const Trace& trace, int threads, bool prefetch) {
+    const std::size_t num_ways = trace.way_offsets.size() - 1;
+    std::vector<std::size_t> found(static_cast<std::size_t>(threads), 0);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        const auto n = static_cast<std::size_t>(t);
+        const std::size_t first = num_ways * n / static_cast<std::size_t>(threads);
+        const std::size_t last = num_ways * (n + 1) / static_cast<std::size_t>(threads);
+        workers.emplace_back([&, n, first, last]() {
+            found[n] = replay_ways(index, trace, first, last, prefetch);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::size_t total = 0;
+    for (const auto f : found) {
+        total += f;
+    }
+
+    return std::make_pair(seconds, total);
+}
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const auto mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+static void print_result(const Result& r, const Trace& trace) {
+    std::cout << std::left << std::setw(28) << r.map << std::right
+              << std::setw(5) << r.prefetch
+              << std::setw(5) << r.huge_pages
+              << std::setw(5) << r.threads
+              << std::fixed << std::setprecision(3)
+              << std::setw(9) << r.load_seconds
+              << std::setw(9) << r.lookup_seconds
+              << std::setprecision(1)
+              << std::setw(9) << r.lookup_seconds * 1e9 / static_cast<double>(std::max<std::size_t>(1, trace.lookups.size()))
+              << std::setw(9) << static_cast<double>(trace.lookups.size()) / r.lookup_seconds / 1e6
+              << std::setw(12) << r.found << '\n';
+}
+
+static void write_json(const Options& options, const Trace& trace, const std::vector<Result>& results) {
+    std::ofstream out{options.json_filename};
+    out << "{\n  \"benchmark\": \"index_trace\",\n  \"format_version\": 1,\n"
+        << "  \"nodes\": " << trace.nodes.size() << ",\n"
+        << "  \"lookups\": " << trace.lookups.size() << ",\n"
+        << "  \"runs\": " << options.runs << ",\n  \"results\": [";
+    bool first = true;
+    for (const auto& r : results) {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        out << "    {\"map\": \"" << r.map << "\", \"prefetch\": \"" << r.prefetch
+            << "\", \"hugepages\": \"" << r.huge_pages
+            << "\", \"threads\": " << r.threads
+            << ", \"load_seconds\": " << r.load_seconds
+            << ", \"lookup_seconds\": " << r.lookup_seconds
+            << ", \"found\": " << r.found << '}';
+    }
+    out << "\n  ]\n}\n";
+    if (!out) {
+        throw std::runtime_error{"could not write " + options.json_filename};
+    }
+}
+
+static void replay(const Options& options) {
+    const Trace trace = read_trace(options.trace_filename);
+    std::cerr << "Trace has " << trace.nodes.size() << " nodes and "
+              << trace.lookups.size() << " lookups\n";
+
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    std::vector<Result> results;
+
+    std::cout << "# map prefetch hugepages threads load_s lookup_s ns/lookup Mlookups/s found\n";
+    for (const auto& map : options.maps) {
+        const bool mmap_map = map.find("_mmap_array") != std::string::npos;
+        for (const auto& huge_pages : options.huge_pages) {
+            if (huge_pages == "yes" && !mmap_map) {
+                continue;
+            }
+
+            const auto load_start = std::chrono::steady_clock::now();
+            std::unique_ptr<index_type> index = map_factory.create_map(huge_pages == "yes" ? map + ",hugepages" : map);
+            for (const auto& node : trace.nodes) {
+                index->set(node.first, node.second);
+            }
+            index->sort();
+            const auto load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count();
+
+            for (const auto& prefetch : options.prefetch) {
+                for (const int threads : options.threads) {
+                    const auto found = replay_lookups(*index, trace, threads, prefetch == "yes").second; // warmup
+                    std::vector<double> times;
+                    for (int i = 0; i < options.runs; ++i) {
+                        times.push_back(replay_lookups(*index, trace, threads, prefetch == "yes").first);
+                    }
+                    Result r{map, prefetch, huge_pages, threads, load_seconds, median(times), found};
+                    print_result(r, trace);
+                    results.push_back(r);
+                }
+            }
+        }
+    }
+
+    if (!options.json_filename.empty()) {
+        write_json(options, trace, results);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        const Options options = parse_options(argc, argv);
+        if (options.mode == "record") {
+            record(options);
+        } else {
+            replay(options);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
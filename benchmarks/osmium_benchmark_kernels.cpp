@@ -0,0 +1,515 @@
+/*
+
+  Microbenchmarks for the hot kernels of the decoders, encoders and
+  indexes.
+
+  All sample data is generated deterministically when the program starts,
+  so this doesn't need any data files and gives comparable numbers on any
+  machine. Each kernel is run repeatedly until it has run for at least
+  --min-time seconds, this is repeated --repeat times and the best and
+  median time per item are reported.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+// Register the index types with the map factory.
+#define OSMIUM_WANT_NODE_LOCATION_MAPS
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/map/all.hpp>
+#include <osmium/io/any_output.hpp>
+#include <osmium/io/detail/opl_parser_functions.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/pbf_output_format.hpp>
+#include <osmium/io/detail/string_table.hpp>
+#include <osmium/io/indexed_pbf_reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    // Simple deterministic pseudo random numbers, the same on every
+    // platform (unlike the distributions from <random>).
+    class Random {
+
+        uint64_t m_state;
+
+    public:
+
+        explicit Random(uint64_t seed) noexcept :
+            m_state(seed) {
+        }
+
+        uint32_t next() noexcept {
+            m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<uint32_t>(m_state >> 33U);
+        }
+
+        uint32_t below(uint32_t max) noexcept {
+            return next() % max;
+        }
+
+    }; // class Random
+
+    const char* const keys[] = {"highway", "name", "building", "amenity", "surface", "source", "oneway", "landuse", "addr:street", "addr:housenumber"};
+    const char* const values[] = {"residential", "yes", "primary", "no", "asphalt", "survey", "Main Street", "forest", "school", "12"};
+
+    constexpr const std::size_t num_nodes = 8000;
+    constexpr const std::size_t num_ways = 8000;
+    constexpr const std::size_t num_relations = 2000;
+
+    // Sample objects similar to real OSM data: most nodes untagged, ways
+    // with 10 nodes and 3 tags, relations with 5 members and 2 tags.
+    osmium::memory::Buffer generate_sample_data() {
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        Random random{42};
+
+        for (std::size_t i = 0; i < num_nodes; ++i) {
+            const osmium::object_id_type id = 1000000 + static_cast<osmium::object_id_type>(i) * 3;
+            const osmium::Location location{static_cast<int32_t>(100000000 + random.below(1000000)),
+                                            static_cast<int32_t>(500000000 + random.below(1000000))};
+            std::vector<std::pair<std::string, std::string>> tags;
+            if (random.below(10) == 0) {
+                tags.emplace_back(keys[random.below(10)], values[random.below(10)]);
+                tags.emplace_back(keys[random.below(10)], values[random.below(10)]);
+            }
+            osmium::builder::add_node(buffer, _id(id), _version(1 + random.below(5)),
+                                      _timestamp(osmium::Timestamp{1500000000 + random.below(100000000)}),
+                                      _cid(50000000 + random.below(1000000)), _uid(1000 + random.below(50)),
+                                      _user("user"), _location(location), _tags(tags));
+        }
+
+        for (std::size_t i = 0; i < num_ways; ++i) {
+            const osmium::object_id_type id = 200000 + static_cast<osmium::object_id_type>(i);
+            std::vector<osmium::object_id_type> nodes;
+            const auto first = random.below(num_nodes - 10);
+            for (uint32_t n = 0; n < 10; ++n) {
+                nodes.push_back(1000000 + static_cast<osmium::object_id_type>(first + n) * 3);
+            }
+            osmium::builder::add_way(buffer, _id(id), _version(1 + random.below(5)),
+                                     _timestamp(osmium::Timestamp{1500000000 + random.below(100000000)}),
+                                     _cid(50000000 + random.below(1000000)), _uid(1000 + random.below(50)),
+                                     _user("user"), _nodes(nodes),
+                                     _tag(keys[random.below(10)], values[random.below(10)]),
+                                     _tag(keys[random.below(10)], values[random.below(10)]),
+                                     _tag(keys[random.below(10)], values[random.below(10)]));
+        }
+
+        for (std::size_t i = 0; i < num_relations; ++i) {
+            const osmium::object_id_type id = 10000 + static_cast<osmium::object_id_type>(i);
+            std::vector<osmium::builder::attr::member_type> members;
+            for (uint32_t n = 0; n < 5; ++n) {
+                members.emplace_back(osmium::item_type::way, 200000 + random.below(num_ways), n == 0 ? "outer" : "inner");
+            }
+            osmium::builder::add_relation(buffer, _id(id), _version(1 + random.below(5)),
+                                          _timestamp(osmium::Timestamp{1500000000 + random.below(100000000)}),
+                                          _cid(50000000 + random.below(1000000)), _uid(1000 + random.below(50)),
+                                          _user("user"), _members(members),
+                                          _tag("type", "multipolygon"),
+                                          _tag(keys[random.below(10)], values[random.below(10)]));
+        }
+
+        return buffer;
+    }
+
+    std::string temp_filename(const char* suffix) {
+        const char* dir = std::getenv("TMPDIR"); // NOLINT(concurrency-mt-unsafe)
+        std::string name{dir ? dir : "/tmp"};
+        name += "/osmium_benchmark_kernels.";
+        name += suffix;
+        return name;
+    }
+
+    void write_file(const osmium::memory::Buffer& buffer, const std::string& filename, const char* format) {
+        osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+        for (const auto& item : buffer) {
+            writer(item);
+        }
+        writer.close();
+    }
+
+    std::string file_content(const osmium::memory::Buffer& buffer, const std::string& filename, const char* format) {
+        write_file(buffer, filename, format);
+        std::ifstream in{filename, std::ios::binary};
+        std::stringstream content;
+        content << in.rdbuf();
+        std::remove(filename.c_str());
+        return content.str();
+    }
+
+    // Uncompressed PrimitiveBlocks from PBF file: dense nodes, ways and
+    // relations in this order.
+    std::vector<std::string> generate_pbf_blocks(const osmium::memory::Buffer& buffer) {
+        const std::string filename = temp_filename("osm.pbf");
+        write_file(buffer, filename, "pbf,pbf_compression=none");
+
+        std::vector<std::string> blocks;
+        {
+            const osmium::io::IndexedPBFReader reader{filename, "-"};
+            for (std::size_t n = 0; n < reader.num_data_blobs(); ++n) {
+                std::string output;
+                const auto data = osmium::io::detail::decode_blob(reader.raw_blob(n), output);
+                blocks.emplace_back(data.data(), data.size());
+            }
+        }
+        std::remove(filename.c_str());
+
+        if (blocks.size() != 3) {
+            throw std::runtime_error{"expected exactly three PBF blocks"};
+        }
+        return blocks;
+    }
+
+    struct Options {
+        std::string filter;
+        double min_time = 0.2;
+        int repeat = 5;
+        bool json = false;
+    };
+
+    struct Result {
+        std::string name;
+        std::size_t items_per_iteration;
+        uint64_t iterations;
+        double best_ns;
+        double median_ns;
+    };
+
+    class Runner {
+
+        Options m_options;
+        std::vector<Result> m_results;
+
+        // Keeps the compiler from optimizing away the work of a kernel.
+        uint64_t m_sink = 0;
+
+        template <typename TFunc>
+        double time_iterations(uint64_t iterations, TFunc&& func) {
+            const auto start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) {
+                m_sink += func();
+            }
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+    public:
+
+        explicit Runner(Options options) :
+            m_options(std::move(options)) {
+        }
+
+        /**
+         * Run a kernel. The function returns some value derived from its
+         * work and processes items_per_iteration items each time it is
+         * called.
+         */
+        bool enabled(const std::string& name) const {
+            return name.find(m_options.filter) != std::string::npos;
+        }
+
+        template <typename TFunc>
+        void run(const std::string& name, std::size_t items_per_iteration, TFunc&& func) {
+            if (!enabled(name)) {
+                return;
+            }
+
+            // Warmup and calibration: double the number of iterations
+            // until one round takes long enough.
+            uint64_t iterations = 1;
+            while (time_iterations(iterations, func) < m_options.min_time) {
+                iterations *= 2;
+            }
+
+            std::vector<double> times;
+            for (int r = 0; r < m_options.repeat; ++r) {
+                times.push_back(time_iterations(iterations, func) * 1e9 / static_cast<double>(iterations * items_per_iteration));
+            }
+            std::sort(times.begin(), times.end());
+
+            m_results.push_back(Result{name, items_per_iteration, iterations, times.front(), times[times.size() / 2]});
+
+            if (!m_options.json) {
+                std::cout << std::left << std::setw(40) << name << std::right
+                          << std::fixed << std::setprecision(2)
+                          << std::setw(12) << times.front()
+                          << std::setw(12) << times[times.size() / 2]
+                          << std::setw(14) << std::setprecision(0) << 1e9 / times.front()
+                          << '\n';
+            }
+        }
+
+        void print_header() const {
+            if (!m_options.json) {
+                std::cout << std::left << std::setw(40) << "kernel" << std::right
+                          << std::setw(12) << "best ns" << std::setw(12) << "median ns"
+                          << std::setw(14) << "items/s" << '\n';
+            }
+        }
+
+        void print_json() const {
+            if (!m_options.json) {
+                return;
+            }
+            std::cout << "{\n  \"benchmark\": \"kernels\",\n  \"format_version\": 1,\n  \"results\": [";
+            bool first = true;
+            for (const auto& result : m_results) {
+                std::cout << (first ? "\n" : ",\n");
+                first = false;
+                std::cout << "    {\"name\": \"" << result.name
+                          << "\", \"items_per_iteration\": " << result.items_per_iteration
+                          << ", \"iterations\": " << result.iterations
+                          << ", \"best_ns_per_item\": " << result.best_ns
+                          << ", \"median_ns_per_item\": " << result.median_ns << '}';
+            }
+            std::cout << "\n  ]\n}\n";
+        }
+
+        uint64_t sink() const noexcept {
+            return m_sink;
+        }
+
+    }; // class Runner
+
+    Options parse_options(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg{argv[i]};
+            if (arg == "-h" || arg == "--help") {
+                std::cout << "Usage: " << argv[0] << " [OPTIONS]\n\n"
+                          << "Options:\n"
+                          << "  --filter=TEXT   Only run kernels with TEXT in their name\n"
+                          << "  --min-time=SEC  Minimum time for each measurement (default 0.2)\n"
+                          << "  --repeat=N      Number of measurements per kernel (default 5)\n"
+                          << "  --json          Output results as JSON\n";
+                std::exit(0); // NOLINT(concurrency-mt-unsafe)
+            }
+            if (arg == "--json") {
+                options.json = true;
+            } else if (arg.substr(0, 9) == "--filter=") {
+                options.filter = arg.substr(9);
+            } else if (arg.substr(0, 11) == "--min-time=") {
+                options.min_time = std::stod(arg.substr(11));
+            } else if (arg.substr(0, 9) == "--repeat=") {
+                options.repeat = std::max(1, std::stoi(arg.substr(9)));
+            } else {
+                throw std::invalid_argument{"unknown option: " + arg};
+            }
+        }
+        return options;
+    }
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        Runner runner{parse_options(argc, argv)};
+
+        const osmium::memory::Buffer sample = generate_sample_data();
+        const std::vector<std::string> blocks = generate_pbf_blocks(sample);
+
+        runner.print_header();
+
+        // PBF decoding
+
+        const char* const block_names[] = {"pbf_decode_dense_nodes", "pbf_decode_ways", "pbf_decode_relations"};
+        const std::size_t block_sizes[] = {num_nodes, num_ways, num_relations};
+        for (std::size_t n = 0; n < blocks.size(); ++n) {
+            const osmium::io::detail::data_view data{blocks[n].data(), blocks[n].size()};
+            runner.run(block_names[n], block_sizes[n], [&]() {
+                osmium::io::detail::PBFPrimitiveBlockDecoder decoder{data, osmium::osm_entity_bits::all, osmium::io::read_meta::yes};
+                return decoder().committed();
+            });
+        }
+
+        // PBF encoding
+
+        {
+            osmium::io::detail::pbf_output_options options;
+            options.add_metadata = osmium::metadata_options{"all"};
+            osmium::io::detail::StringTable stringtable;
+            osmium::io::detail::DenseNodes dense_nodes{&stringtable, &options};
+            for (const auto& node : sample.select<osmium::Node>()) {
+                dense_nodes.add_node(node);
+            }
+            runner.run("dense_nodes_serialize", num_nodes, [&]() {
+                return dense_nodes.serialize().size();
+            });
+        }
+
+        {
+            std::vector<std::string> strings;
+            for (const auto& object : sample.select<osmium::OSMObject>()) {
+                strings.emplace_back(object.user());
+                for (const auto& tag : object.tags()) {
+                    strings.emplace_back(tag.key());
+                    strings.emplace_back(tag.value());
+                }
+            }
+            runner.run("string_table_add", strings.size(), [&]() {
+                osmium::io::detail::StringTable stringtable;
+                int32_t sum = 0;
+                for (const auto& s : strings) {
+                    sum += stringtable.add(s.c_str());
+                }
+                return static_cast<uint64_t>(sum);
+            });
+        }
+
+        // OPL parsing
+
+        {
+            const std::string opl = file_content(sample, temp_filename("opl"), "opl");
+            std::vector<std::string> lines;
+            std::istringstream in{opl};
+            std::string line;
+            while (std::getline(in, line)) {
+                lines.push_back(line);
+            }
+            osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+            runner.run("opl_parse_line", lines.size(), [&]() {
+                buffer.clear();
+                uint64_t line_count = 0;
+                for (const auto& l : lines) {
+                    osmium::io::detail::opl_parse_line(++line_count, l.c_str(), buffer);
+                }
+                return buffer.committed();
+            });
+        }
+
+        // XML attribute parsing, does the same as the XML parser does for
+        // the attributes of each node element.
+
+        {
+            const char* attrs[] = {"id", "123456789", "version", "3", "timestamp", "2017-04-02T15:01:24Z",
+                                   "uid", "12345", "user", "someone", "changeset", "47519864",
+                                   "lat", "52.5170365", "lon", "13.3888599", nullptr};
+            osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+            osmium::builder::add_node(buffer, _id(1));
+            auto& node = buffer.get<osmium::Node>(0);
+            runner.run("xml_node_attributes", 1000, [&]() {
+                uint64_t sum = 0;
+                for (int i = 0; i < 1000; ++i) {
+                    osmium::Location location;
+                    const char* user = "";
+                    for (const char** a = attrs; *a; a += 2) {
+                        if (!std::strcmp(a[0], "lon")) {
+                            location.set_lon(a[1]);
+                        } else if (!std::strcmp(a[0], "lat")) {
+                            location.set_lat(a[1]);
+                        } else if (!std::strcmp(a[0], "user")) {
+                            user = a[1];
+                        } else {
+                            node.set_attribute(a[0], a[1]);
+                        }
+                    }
+                    node.set_location(location);
+                    sum += static_cast<uint64_t>(node.id()) + static_cast<uint64_t>(location.x()) + *user;
+                }
+                return sum;
+            });
+        }
+
+        // Buffer iteration
+
+        runner.run("buffer_iterate_objects", num_nodes + num_ways + num_relations, [&]() {
+            uint64_t sum = 0;
+            for (const auto& object : sample.select<osmium::OSMObject>()) {
+                sum += static_cast<uint64_t>(object.id());
+            }
+            return sum;
+        });
+
+        // Tags filter
+
+        {
+            osmium::TagsFilter filter{false};
+            filter.add_rule(true, osmium::TagMatcher{"highway"});
+            filter.add_rule(false, osmium::TagMatcher{"building", "no"});
+            filter.add_rule(true, osmium::TagMatcher{"building"});
+            filter.add_rule(true, osmium::TagMatcher{osmium::StringMatcher::prefix{"addr:"}});
+            filter.add_rule(true, "landuse", "forest");
+
+            std::size_t num_tags = 0;
+            for (const auto& object : sample.select<osmium::OSMObject>()) {
+                num_tags += object.tags().size();
+            }
+
+            runner.run("tags_filter", num_tags, [&]() {
+                uint64_t matches = 0;
+                for (const auto& object : sample.select<osmium::OSMObject>()) {
+                    for (const auto& tag : object.tags()) {
+                        matches += filter(tag) ? 1 : 0;
+                    }
+                }
+                return matches;
+            });
+        }
+
+        // Location index lookups, all in-memory index types.
+
+        {
+            constexpr const std::size_t num_ids = 1000000;
+            constexpr const std::size_t num_lookups = 100000;
+
+            Random random{17};
+            std::vector<osmium::unsigned_object_id_type> lookups;
+            lookups.reserve(num_lookups);
+            for (std::size_t i = 0; i < num_lookups; ++i) {
+                lookups.push_back(static_cast<osmium::unsigned_object_id_type>(random.below(num_ids)) * 3);
+            }
+
+            const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+            for (const auto& map_type : map_factory.map_types()) {
+                if (map_type.find("file") != std::string::npos) {
+                    continue;
+                }
+                const std::string name = "map_get_" + map_type;
+                if (!runner.enabled(name)) {
+                    continue;
+                }
+                auto index = map_factory.create_map(map_type);
+                for (std::size_t i = 0; i < num_ids; ++i) {
+                    index->set(i * 3, osmium::Location{static_cast<int32_t>(i), static_cast<int32_t>(i)});
+                }
+                index->sort();
+                runner.run(name, num_lookups, [&]() {
+                    uint64_t sum = 0;
+                    for (const auto id : lookups) {
+                        sum += static_cast<uint64_t>(index->get_noexcept(id).x());
+                    }
+                    return sum;
+                });
+            }
+        }
+
+        runner.print_json();
+
+        // Print to stderr so the work can't be optimized away.
+        std::cerr << "checksum: " << runner.sink() << '\n';
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -4,27 +4,57 @@
 
 */
 
+#include <osmium/geom/coordinates.hpp>
 #include <osmium/geom/mercator_projection.hpp>
 #include <osmium/geom/wkb.hpp>
 #include <osmium/handler.hpp>
 #include <osmium/io/any_input.hpp>
+#include <osmium/osm/location.hpp>
 #include <osmium/visitor.hpp>
 
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <vector>
 
 struct GeomHandler : public osmium::handler::Handler {
 
     osmium::geom::WKBFactory<osmium::geom::MercatorProjection> factory;
 
+    std::vector<osmium::Location> locations;
+
     void node(const osmium::Node& node) {
         const std::string geom = factory.create_point(node);
+        if (node.location().lat() >= -osmium::geom::MERCATOR_MAX_LAT &&
+            node.location().lat() <= osmium::geom::MERCATOR_MAX_LAT) {
+            locations.push_back(node.location());
+        }
     }
 
 };
 
+// Compare projecting all locations one at a time with projecting them
+// all at once using the batch interface.
+void compare_scalar_and_batch(const std::vector<osmium::Location>& locations) {
+    const osmium::geom::MercatorProjection projection;
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < locations.size(); ++i) {
+        coordinates[i] = projection(locations[i]);
+    }
+    const auto middle = std::chrono::steady_clock::now();
+    projection(locations.data(), locations.size(), coordinates.data());
+    const auto stop = std::chrono::steady_clock::now();
+
+    std::cout << "locations: " << locations.size()
+              << "\nscalar: " << std::chrono::duration_cast<std::chrono::microseconds>(middle - start).count()
+              << "us\nbatch: " << std::chrono::duration_cast<std::chrono::microseconds>(stop - middle).count()
+              << "us\n";
+}
+
 int main(int argc, char* argv[]) {
     if (argc != 2) {
         std::cerr << "Usage: " << argv[0] << " OSMFILE\n";
@@ -39,6 +69,8 @@ int main(int argc, char* argv[]) {
         GeomHandler handler;
         osmium::apply(reader, handler);
         reader.close();
+
+        compare_scalar_and_batch(handler.locations);
     } catch (const std::exception& e) {
         std::cerr << e.what() << '\n';
         return 1;
@@ -46,4 +78,3 @@ int main(int argc, char* argv[]) {
 
     return 0;
 }
-
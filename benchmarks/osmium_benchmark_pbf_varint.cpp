@@ -0,0 +1,95 @@
+/*
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <osmium/io/detail/pbf_varint.hpp>
+
+#include <protozero/varint.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Straightforward byte-by-byte decoder as baseline.
+static std::size_t decode_scalar(const char* data, const char* end, int64_t* out) {
+    std::size_t n = 0;
+    uint64_t value = 0;
+    while (data != end) {
+        uint64_t v = 0;
+        unsigned int shift = 0;
+        uint64_t byte = 0;
+        do {
+            byte = static_cast<unsigned char>(*data++);
+            v |= (byte & 0x7fU) << shift;
+            shift += 7;
+        } while (byte >= 0x80U);
+        value += static_cast<uint64_t>(protozero::decode_zigzag64(v));
+        out[n++] = static_cast<int64_t>(value);
+    }
+    return n;
+}
+
+template <typename TFunc>
+static void run(const char* name, const std::string& data, std::size_t count, int rounds, TFunc&& func) {
+    std::vector<int64_t> out(count);
+    int64_t checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        func(data, out);
+        checksum += out.back();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    std::cout << name << ": " << ms << "ms (checksum " << checksum << ")\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 2) {
+        std::cerr << "Usage: " << argv[0] << " [COUNT]\n";
+        return 1;
+    }
+
+    const std::size_t count = argc == 2 ? std::strtoul(argv[1], nullptr, 10) : 8000;
+    const int rounds = static_cast<int>(100000000 / count);
+
+    // Data similar to dense nodes: ids mostly increasing by one,
+    // coordinates changing by a few hundred to a few thousand units.
+    std::mt19937_64 gen{42};
+    std::uniform_int_distribution<int64_t> id_gap{1, 20};
+    std::normal_distribution<double> coord_delta{0.0, 2000.0};
+
+    std::vector<int64_t> ids;
+    std::vector<int64_t> coords;
+    int64_t id = 100000000;
+    int64_t coord = 500000000;
+    for (std::size_t i = 0; i < count; ++i) {
+        id += id_gap(gen) <= 18 ? 1 : id_gap(gen) * 1000;
+        ids.push_back(id);
+        coord += static_cast<int64_t>(coord_delta(gen));
+        coords.push_back(coord);
+    }
+
+    const auto identity = [](int64_t v) { return v; };
+    for (const auto* values : {&ids, &coords}) {
+        std::string data;
+        osmium::io::detail::append_delta_encoded_sint64(values->cbegin(), values->cend(), identity, data);
+        std::cout << (values == &ids ? "ids" : "coordinates") << " (" << data.size() << " bytes):\n";
+
+        run("  scalar", data, count, rounds, [](const std::string& d, std::vector<int64_t>& out) {
+            decode_scalar(d.data(), d.data() + d.size(), out.data());
+        });
+        run("  kernel", data, count, rounds, [](const std::string& d, std::vector<int64_t>& out) {
+            const char* pos = d.data();
+            osmium::io::detail::decode_delta_encoded_sint64(&pos, d.data() + d.size(), out.data(), out.size());
+        });
+    }
+
+    return 0;
+}
+
@@ -0,0 +1,358 @@
+/*
+
+  Benchmark harness for the reading and writing pipeline.
+
+  Runs the same workload repeatedly for every combination of thread count
+  and (output) buffer size given on the command line and writes the results
+  as JSON. Use compare_benchmarks.py to compare two such result files.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/io/any_output.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct CountHandler : public osmium::handler::Handler {
+
+    uint64_t objects = 0;
+
+    void osm_object(const osmium::OSMObject& /*object*/) noexcept {
+        ++objects;
+    }
+
+}; // struct CountHandler
+
+struct Options {
+    std::string mode{"count"};
+    std::string input_filename;
+    std::string output_filename{"/dev/null"};
+    std::string json_filename;
+    std::vector<int> threads{osmium::thread::Pool::default_num_threads};
+    std::vector<std::size_t> buffer_sizes{10UL * 1024UL * 1024UL};
+    int warmup = 1;
+    int runs = 5;
+};
+
+struct RunResult {
+    double seconds = 0.0;
+    uint64_t objects = 0;
+    osmium::io::reader_stats reader;
+    osmium::io::writer_stats writer;
+};
+
+struct Summary {
+    double mean = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double median = 0.0;
+    double max = 0.0;
+};
+
+static void print_help(const char* program) {
+    std::cout << "Usage: " << program << " [OPTIONS] INPUT-FILE\n\n"
+              << "Options:\n"
+              << "  --mode=MODE            read, count (default) or write\n"
+              << "  --threads=N[,N...]     Thread pool sizes to run with (0: default)\n"
+              << "  --buffer-size=MB[,MB...] Writer buffer sizes (write mode only)\n"
+              << "  --warmup=N             Warmup runs per configuration (default 1)\n"
+              << "  --runs=N               Measured runs per configuration (default 5)\n"
+              << "  --output-file=FILE     Output for write mode (default /dev/null)\n"
+              << "  --json=FILE            Write results to FILE instead of stdout\n";
+}
+
+template <typename T>
+static std::vector<T> parse_list(const std::string& value, T multiplier, long long min) {
+    std::vector<T> result;
+    std::istringstream in{value};
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        const auto number = std::stoll(item);
+        if (number < min) {
+            throw std::invalid_argument{"value out of range: " + value};
+        }
+        result.push_back(static_cast<T>(number) * multiplier);
+    }
+    if (result.empty()) {
+        throw std::invalid_argument{"empty list"};
+    }
+    return result;
+}
+
+static Options parse_options(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg{argv[i]};
+        if (arg == "-h" || arg == "--help") {
+            print_help(argv[0]);
+            std::exit(0); // NOLINT(concurrency-mt-unsafe)
+        }
+        if (arg.substr(0, 2) != "--") {
+            if (!options.input_filename.empty()) {
+                throw std::invalid_argument{"only one input file allowed"};
+            }
+            options.input_filename = arg;
+            continue;
+        }
+        const auto eq = arg.find('=');
+        if (eq == std::string::npos) {
+            throw std::invalid_argument{"option needs a value: " + arg};
+        }
+        const std::string name = arg.substr(2, eq - 2);
+        const std::string value = arg.substr(eq + 1);
+        if (name == "mode") {
+            if (value != "read" && value != "count" && value != "write") {
+                throw std::invalid_argument{"unknown mode: " + value};
+            }
+            options.mode = value;
+        } else if (name == "threads") {
+            options.threads = parse_list<int>(value, 1, 0);
+        } else if (name == "buffer-size") {
+            options.buffer_sizes = parse_list<std::size_t>(value, 1024UL * 1024UL, 1);
+        } else if (name == "warmup") {
+            options.warmup = std::stoi(value);
+        } else if (name == "runs") {
+            options.runs = std::max(1, std::stoi(value));
+        } else if (name == "output-file") {
+            options.output_filename = value;
+        } else if (name == "json") {
+            options.json_filename = value;
+        } else {
+            throw std::invalid_argument{"unknown option: " + arg};
+        }
+    }
+    if (options.input_filename.empty()) {
+        throw std::invalid_argument{"missing input file"};
+    }
+    return options;
+}
+
+// Reset the peak resident set size of this process so that each
+// configuration gets its own value. Only works on Linux 4.0 and later,
+// elsewhere the peak is that of the whole process.
+static void reset_peak_rss() {
+#ifdef __linux__
+    std::ofstream clear_refs{"/proc/self/clear_refs"};
+    if (clear_refs) {
+        clear_refs << "5";
+    }
+#endif
+}
+
+static RunResult run_once(const Options& options, int threads, std::size_t buffer_size) {
+    RunResult result;
+    osmium::thread::Pool pool{threads};
+
+    const auto start = std::chrono::steady_clock::now();
+    osmium::io::Reader reader{options.input_filename, pool};
+
+    if (options.mode == "read") {
+        while (const osmium::memory::Buffer buffer = reader.read()) {
+            result.objects += static_cast<uint64_t>(std::distance(buffer.cbegin(), buffer.cend()));
+        }
+    } else if (options.mode == "count") {
+        CountHandler handler;
+        osmium::apply(reader, handler);
+        result.objects = handler.objects;
+    } else {
+        const osmium::io::File output_file{options.output_filename, "pbf"};
+        osmium::io::Writer writer{output_file, reader.header(), osmium::io::overwrite::allow, pool};
+        writer.set_buffer_size(buffer_size);
+        while (osmium::memory::Buffer buffer = reader.read()) { // NOLINT(bugprone-use-after-move) Bug in clang-tidy https://bugs.llvm.org/show_bug.cgi?id=36516
+            result.objects += static_cast<uint64_t>(std::distance(buffer.cbegin(), buffer.cend()));
+            writer(std::move(buffer));
+        }
+        writer.close();
+        result.writer = writer.stats();
+    }
+    reader.close();
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.reader = reader.stats();
+    return result;
+}
+
+static Summary summarize(std::vector<double> values) {
+    Summary summary;
+    std::sort(values.begin(), values.end());
+    const auto n = static_cast<double>(values.size());
+    for (const double v : values) {
+        summary.mean += v;
+    }
+    summary.mean /= n;
+    for (const double v : values) {
+        summary.stddev += (v - summary.mean) * (v - summary.mean);
+    }
+    summary.stddev = values.size() > 1 ? std::sqrt(summary.stddev / (n - 1)) : 0.0;
+    summary.min = values.front();
+    summary.max = values.back();
+    const auto mid = values.size() / 2;
+    summary.median = values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+    return summary;
+}
+
+static std::string json_string(const std::string& str) {
+    std::string out{"\""};
+    for (const char c : str) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += ' ';
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+    return out;
+}
+
+static double seconds(std::chrono::nanoseconds time) {
+    return std::chrono::duration<double>(time).count();
+}
+
+static void write_stage(std::ostream& out, const char* name, const osmium::io::stage_stats& stats) {
+    out << "        " << json_string(name) << ": {\"bytes\": " << stats.bytes
+        << ", \"items\": " << stats.items
+        << ", \"busy_time\": " << seconds(stats.busy_time) << "},\n";
+}
+
+static void write_queue(std::ostream& out, const osmium::thread::queue_stats& stats) {
+    out << "        " << json_string(stats.name) << ": {\"max_size\": " << stats.max_size
+        << ", \"largest_size\": " << stats.largest_size
+        << ", \"pushes\": " << stats.pushes
+        << ", \"full_waits\": " << stats.full_waits
+        << ", \"full_wait_time\": " << seconds(stats.full_wait_time)
+        << ", \"empty_waits\": " << stats.empty_waits
+        << ", \"empty_wait_time\": " << seconds(stats.empty_wait_time) << "},\n";
+}
+
+static void write_pool(std::ostream& out, const osmium::thread::pool_stats& stats) {
+    out << "        \"pool\": {\"num_threads\": " << stats.num_threads
+        << ", \"tasks_done\": " << stats.tasks_done
+        << ", \"busy_time\": " << seconds(stats.busy_time) << "}\n";
+}
+
+static void write_summary(std::ostream& out, const char* name, const Summary& summary) {
+    out << "      " << json_string(name) << ": {\"mean\": " << summary.mean
+        << ", \"stddev\": " << summary.stddev
+        << ", \"min\": " << summary.min
+        << ", \"median\": " << summary.median
+        << ", \"max\": " << summary.max << "},\n";
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        const Options options = parse_options(argc, argv);
+        const auto file_size = osmium::file_size(options.input_filename);
+
+        std::vector<std::size_t> buffer_sizes{options.buffer_sizes};
+        if (options.mode != "write") {
+            buffer_sizes.resize(1);
+        }
+
+        std::ostringstream json;
+        json.precision(6);
+        json << "{\n"
+             << "  \"benchmark\": \"pipeline\",\n"
+             << "  \"format_version\": 1,\n"
+             << "  \"mode\": " << json_string(options.mode) << ",\n"
+             << "  \"input\": {\"file\": " << json_string(options.input_filename)
+             << ", \"size\": " << file_size << "},\n"
+             << "  \"warmup\": " << options.warmup << ",\n"
+             << "  \"runs\": " << options.runs << ",\n"
+             << "  \"results\": [";
+
+        bool first = true;
+        for (const int threads : options.threads) {
+            for (const std::size_t buffer_size : buffer_sizes) {
+                std::cerr << "threads=" << threads << " buffer_size=" << buffer_size << ' ';
+                for (int i = 0; i < options.warmup; ++i) {
+                    run_once(options, threads, buffer_size);
+                    std::cerr << 'w';
+                }
+
+                reset_peak_rss();
+                std::vector<double> times;
+                RunResult last;
+                for (int i = 0; i < options.runs; ++i) {
+                    last = run_once(options, threads, buffer_size);
+                    times.push_back(last.seconds);
+                    std::cerr << '.';
+                }
+                std::cerr << '\n';
+
+                const osmium::MemoryUsage memory;
+                const Summary time = summarize(times);
+
+                json << (first ? "\n" : ",\n");
+                first = false;
+                json << "    {\n"
+                     << "      \"threads\": " << last.reader.pool.num_threads << ",\n"
+                     << "      \"buffer_size\": " << buffer_size << ",\n"
+                     << "      \"objects\": " << last.objects << ",\n"
+                     << "      \"peak_rss_mb\": " << memory.peak_resident() << ",\n";
+                write_summary(json, "time", time);
+                json << "      \"throughput\": {\"bytes_per_second\": " << static_cast<double>(file_size) / time.median
+                     << ", \"objects_per_second\": " << static_cast<double>(last.objects) / time.median << "},\n"
+                     << "      \"reader\": {\n";
+                write_stage(json, "read", last.reader.read);
+                write_queue(json, last.reader.input_queue);
+                write_queue(json, last.reader.osmdata_queue);
+                write_stage(json, "output", last.reader.output);
+                write_pool(json, last.reader.pool);
+                json << "      }";
+                if (options.mode == "write") {
+                    json << ",\n      \"writer\": {\n";
+                    write_stage(json, "input", last.writer.input);
+                    write_queue(json, last.writer.output_queue);
+                    write_stage(json, "write", last.writer.write);
+                    write_pool(json, last.writer.pool);
+                    json << "      }";
+                }
+                json << "\n    }";
+            }
+        }
+        json << "\n  ]\n}\n";
+
+        if (options.json_filename.empty()) {
+            std::cout << json.str();
+        } else {
+            std::ofstream out{options.json_filename};
+            out << json.str();
+            if (!out) {
+                throw std::runtime_error{"could not write " + options.json_filename};
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
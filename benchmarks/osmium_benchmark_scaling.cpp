@@ -0,0 +1,319 @@
+/*
+
+  Scaling benchmark for the Reader.
+
+  Converts the input file into several formats and compressions and then
+  reads each of them with all combinations of thread pool size, queue
+  sizes, and (for PBF) decoding in the pool or in the parser thread. The
+  settings are passed to the Pool and Reader directly, the environment
+  variables usually used for them are ignored.
+
+  For each combination the median run time, throughput, speedup relative
+  to the smallest thread count with otherwise the same settings, and the
+  parallel efficiency (speedup divided by the increase in threads) are
+  reported.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <osmium/io/any_input.hpp>
+#include <osmium/io/any_output.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct Options {
+    std::string input_filename;
+    std::string tmp_dir;
+    std::string json_filename;
+    std::vector<std::string> formats{"pbf", "osm", "osm.gz", "osm.bz2", "opl", "opl.gz"};
+    std::vector<int> threads;
+    std::vector<std::size_t> work_queue_sizes{0};
+    std::vector<std::size_t> input_queue_sizes{0};
+    std::vector<std::size_t> osmdata_queue_sizes{0};
+    std::vector<std::string> pbf_pool{"yes", "no"};
+    int runs = 3;
+};
+
+struct Result {
+    std::string format;
+    std::string pbf_pool;
+    std::size_t work_queue_size;
+    std::size_t input_queue_size;
+    std::size_t osmdata_queue_size;
+    int threads;
+    std::size_t file_size;
+    uint64_t objects;
+    double seconds;
+    double speedup;
+    double efficiency;
+};
+
+static std::vector<std::string> split(const std::string& value) {
+    std::vector<std::string> result;
+    std::istringstream in{value};
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        result.push_back(item);
+    }
+    if (result.empty()) {
+        throw std::invalid_argument{"empty list"};
+    }
+    return result;
+}
+
+template <typename T>
+static std::vector<T> split_numbers(const std::string& value) {
+    std::vector<T> result;
+    for (const auto& item : split(value)) {
+        const auto number = std::stoll(item);
+        if (number < 0) {
+            throw std::invalid_argument{"negative value: " + value};
+        }
+        result.push_back(static_cast<T>(number));
+    }
+    return result;
+}
+
+static void print_help(const char* program) {
+    std::cout << "Usage: " << program << " [OPTIONS] INPUT-FILE\n\n"
+              << "Options:\n"
+              << "  --formats=F[,F...]       Formats to test (default: pbf,osm,osm.gz,osm.bz2,opl,opl.gz)\n"
+              << "  --threads=N[,N...]       Pool sizes (default: 1,2,4,... up to number of cores)\n"
+              << "  --work-queue=N[,N...]    Pool work queue sizes (0: default)\n"
+              << "  --input-queue=N[,N...]   Reader input queue sizes (0: default)\n"
+              << "  --osmdata-queue=N[,N...] Reader osmdata queue sizes (0: default)\n"
+              << "  --pbf-pool=yes,no        Decode PBF in pool threads and/or parser thread\n"
+              << "  --runs=N                 Runs per configuration (default 3)\n"
+              << "  --tmp-dir=DIR            Where to put converted files (default: $TMPDIR or /tmp)\n"
+              << "  --json=FILE              Also write results as JSON to FILE\n";
+}
+
+static Options parse_options(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg{argv[i]};
+        if (arg == "-h" || arg == "--help") {
+            print_help(argv[0]);
+            std::exit(0); // NOLINT(concurrency-mt-unsafe)
+        }
+        if (arg.substr(0, 2) != "--") {
+            if (!options.input_filename.empty()) {
+                throw std::invalid_argument{"only one input file allowed"};
+            }
+            options.input_filename = arg;
+            continue;
+        }
+        const auto eq = arg.find('=');
+        if (eq == std::string::npos) {
+            throw std::invalid_argument{"option needs a value: " + arg};
+        }
+        const std::string name = arg.substr(2, eq - 2);
+        const std::string value = arg.substr(eq + 1);
+        if (name == "formats") {
+            options.formats = split(value);
+        } else if (name == "threads") {
+            options.threads = split_numbers<int>(value);
+        } else if (name == "work-queue") {
+            options.work_queue_sizes = split_numbers<std::size_t>(value);
+        } else if (name == "input-queue") {
+            options.input_queue_sizes = split_numbers<std::size_t>(value);
+        } else if (name == "osmdata-queue") {
+            options.osmdata_queue_sizes = split_numbers<std::size_t>(value);
+        } else if (name == "pbf-pool") {
+            options.pbf_pool = split(value);
+            for (const auto& p : options.pbf_pool) {
+                if (p != "yes" && p != "no") {
+                    throw std::invalid_argument{"--pbf-pool must be yes or no"};
+                }
+            }
+        } else if (name == "runs") {
+            options.runs = std::max(1, std::stoi(value));
+        } else if (name == "tmp-dir") {
+            options.tmp_dir = value;
+        } else if (name == "json") {
+            options.json_filename = value;
+        } else {
+            throw std::invalid_argument{"unknown option: " + arg};
+        }
+    }
+
+    if (options.input_filename.empty()) {
+        throw std::invalid_argument{"missing input file"};
+    }
+
+    if (options.tmp_dir.empty()) {
+        const char* dir = std::getenv("TMPDIR"); // NOLINT(concurrency-mt-unsafe)
+        options.tmp_dir = dir ? dir : "/tmp";
+    }
+
+    if (options.threads.empty()) {
+        const auto cores = std::max(1U, std::thread::hardware_concurrency());
+        for (unsigned int n = 1; n < cores; n *= 2) {
+            options.threads.push_back(static_cast<int>(n));
+        }
+        options.threads.push_back(static_cast<int>(cores));
+    }
+    std::sort(options.threads.begin(), options.threads.end());
+    if (options.threads.front() < 1) {
+        throw std::invalid_argument{"thread counts must be at least 1"};
+    }
+
+    return options;
+}
+
+static std::string convert(const Options& options, const std::string& format) {
+    const std::string filename = options.tmp_dir + "/osmium_benchmark_scaling." + format;
+    std::cerr << "Converting input to " << filename << "...\n";
+
+    osmium::io::Reader reader{options.input_filename};
+    osmium::io::Writer writer{filename, reader.header(), osmium::io::overwrite::allow};
+    while (osmium::memory::Buffer buffer = reader.read()) { // NOLINT(bugprone-use-after-move) Bug in clang-tidy https://bugs.llvm.org/show_bug.cgi?id=36516
+        writer(std::move(buffer));
+    }
+    writer.close();
+    reader.close();
+
+    return filename;
+}
+
+static std::pair<double, uint64_t> run_once(const std::string& filename, const Result& config) {
+    osmium::thread::Pool pool{config.threads, config.work_queue_size};
+
+    const auto start = std::chrono::steady_clock::now();
+
+    osmium::io::Reader reader{filename, pool,
+                              osmium::io::reader_queue_sizes{config.input_queue_size, config.osmdata_queue_size},
+                              config.pbf_pool == "no" ? osmium::io::pool_for_pbf_parsing::no : osmium::io::pool_for_pbf_parsing::yes};
+    uint64_t objects = 0;
+    while (const osmium::memory::Buffer buffer = reader.read()) {
+        objects += static_cast<uint64_t>(std::distance(buffer.cbegin(), buffer.cend()));
+    }
+    reader.close();
+
+    return std::make_pair(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), objects);
+}
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const auto mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+static void print_result(const Result& r) {
+    std::cout << std::left << std::setw(8) << r.format << std::right
+              << std::setw(5) << r.pbf_pool
+              << std::setw(6) << r.work_queue_size
+              << std::setw(6) << r.input_queue_size
+              << std::setw(6) << r.osmdata_queue_size
+              << std::setw(5) << r.threads
+              << std::fixed << std::setprecision(3)
+              << std::setw(9) << r.seconds
+              << std::setprecision(1)
+              << std::setw(9) << static_cast<double>(r.file_size) / r.seconds / (1024.0 * 1024.0)
+              << std::setw(9) << static_cast<double>(r.objects) / r.seconds / 1e6
+              << std::setprecision(2)
+              << std::setw(8) << r.speedup
+              << std::setw(7) << r.efficiency << '\n';
+}
+
+static void write_json(const Options& options, const std::vector<Result>& results) {
+    std::ofstream out{options.json_filename};
+    out << "{\n  \"benchmark\": \"scaling\",\n  \"format_version\": 1,\n"
+        << "  \"cores\": " << std::thread::hardware_concurrency() << ",\n"
+        << "  \"runs\": " << options.runs << ",\n  \"results\": [";
+    bool first = true;
+    for (const auto& r : results) {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        out << "    {\"format\": \"" << r.format << "\", \"pbf_pool\": \"" << r.pbf_pool
+            << "\", \"work_queue_size\": " << r.work_queue_size
+            << ", \"input_queue_size\": " << r.input_queue_size
+            << ", \"osmdata_queue_size\": " << r.osmdata_queue_size
+            << ", \"threads\": " << r.threads
+            << ", \"file_size\": " << r.file_size
+            << ", \"objects\": " << r.objects
+            << ", \"seconds\": " << r.seconds
+            << ", \"speedup\": " << r.speedup
+            << ", \"efficiency\": " << r.efficiency << '}';
+    }
+    out << "\n  ]\n}\n";
+    if (!out) {
+        throw std::runtime_error{"could not write " + options.json_filename};
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        const Options options = parse_options(argc, argv);
+
+        std::vector<Result> results;
+
+        std::cout << "# format pool wq iq oq threads seconds MB/s Mobj/s speedup efficiency\n";
+        for (const auto& format : options.formats) {
+            const std::string filename = convert(options, format);
+            const auto file_size = osmium::file_size(filename);
+            const bool is_pbf = osmium::io::File{filename}.format() == osmium::io::file_format::pbf;
+            const std::vector<std::string> pbf_pool = is_pbf ? options.pbf_pool : std::vector<std::string>{"-"};
+
+            for (const auto& pool_setting : pbf_pool) {
+                for (const auto wq : options.work_queue_sizes) {
+                    for (const auto iq : options.input_queue_sizes) {
+                        for (const auto oq : options.osmdata_queue_sizes) {
+                            double base_seconds = 0.0;
+                            for (const int threads : options.threads) {
+                                Result r{format, pool_setting, wq, iq, oq, threads, file_size, 0, 0.0, 1.0, 1.0};
+
+                                run_once(filename, r); // warmup, gets the file into the cache
+                                std::vector<double> times;
+                                for (int i = 0; i < options.runs; ++i) {
+                                    const auto run = run_once(filename, r);
+                                    times.push_back(run.first);
+                                    r.objects = run.second;
+                                }
+                                r.seconds = median(times);
+
+                                if (threads == options.threads.front()) {
+                                    base_seconds = r.seconds;
+                                }
+                                r.speedup = base_seconds / r.seconds;
+                                r.efficiency = r.speedup * options.threads.front() / threads;
+
+                                print_result(r);
+                                results.push_back(r);
+                            }
+                        }
+                    }
+                }
+            }
+
+            std::remove(filename.c_str());
+        }
+
+        if (!options.json_filename.empty()) {
+            write_json(options, results);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*
+
+  Generate synthetic OSM data and write it to a file.
+
+  This creates test data of any size without downloading anything and
+  measures how fast it can be generated and written. All objects are
+  generated in the thread pool, so with enough threads this mostly
+  measures the writer. The same options always give the same data.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <osmium/builder/synthetic_data.hpp>
+#include <osmium/io/any_output.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+struct Options {
+    osmium::builder::SyntheticDataConfig config;
+    std::string output_filename;
+    bool keep = false;
+    int threads = 0;
+};
+
+static void print_help(const char* program) {
+    std::cout << "Usage: " << program << " [OPTIONS] [OUTPUT-FILE]\n\n"
+              << "Without OUTPUT-FILE a temporary PBF file is written and removed afterwards.\n\n"
+              << "Options:\n"
+              << "  --nodes=N          Number of nodes (default 1000000)\n"
+              << "  --ways=N           Number of ways (default: nodes / 8)\n"
+              << "  --relations=N      Number of relations (default: nodes / 500)\n"
+              << "  --id-gap=N         Average distance between ids (default 1)\n"
+              << "  --way-nodes=N      Average number of nodes in ways (default 10)\n"
+              << "  --members=N        Average number of members in relations (default 12)\n"
+              << "  --nested=N         Percent of relation members that are relations (default 5)\n"
+              << "  --metadata=yes|no  Add metadata to objects (default yes)\n"
+              << "  --seed=N           Seed for random numbers (default 1)\n"
+              << "  --threads=N        Pool size (default: OSMIUM_POOL_THREADS or number of cores)\n";
+}
+
+static Options parse_options(int argc, char* argv[]) {
+    Options options;
+    bool ways_set = false;
+    bool relations_set = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg{argv[i]};
+        if (arg == "-h" || arg == "--help") {
+            print_help(argv[0]);
+            std::exit(0); // NOLINT(concurrency-mt-unsafe)
+        }
+        if (arg.substr(0, 2) != "--") {
+            if (!options.output_filename.empty()) {
+                throw std::invalid_argument{"only one output file allowed"};
+            }
+            options.output_filename = arg;
+            options.keep = true;
+            continue;
+        }
+        const auto eq = arg.find('=');
+        if (eq == std::string::npos) {
+            throw std::invalid_argument{"option needs a value: " + arg};
+        }
+        const std::string name = arg.substr(2, eq - 2);
+        const std::string value = arg.substr(eq + 1);
+        auto& config = options.config;
+        if (name == "nodes") {
+            config.nodes = std::stoull(value);
+        } else if (name == "ways") {
+            config.ways = std::stoull(value);
+            ways_set = true;
+        } else if (name == "relations") {
+            config.relations = std::stoull(value);
+            relations_set = true;
+        } else if (name == "id-gap") {
+            config.id_gap = static_cast<uint32_t>(std::stoul(value));
+        } else if (name == "way-nodes") {
+            config.way_nodes_mean = static_cast<uint32_t>(std::stoul(value));
+        } else if (name == "members") {
+            config.relation_members_mean = static_cast<uint32_t>(std::stoul(value));
+        } else if (name == "nested") {
+            config.relation_members_relations_percent = static_cast<uint32_t>(std::stoul(value));
+        } else if (name == "metadata") {
+            if (value != "yes" && value != "no") {
+                throw std::invalid_argument{"--metadata must be yes or no"};
+            }
+            config.with_metadata = value == "yes";
+        } else if (name == "seed") {
+            config.seed = std::stoull(value);
+        } else if (name == "threads") {
+            options.threads = std::stoi(value);
+        } else {
+            throw std::invalid_argument{"unknown option: " + arg};
+        }
+    }
+
+    if (!ways_set) {
+        options.config.ways = options.config.nodes / 8;
+    }
+    if (!relations_set) {
+        options.config.relations = options.config.nodes / 500;
+    }
+
+    if (options.output_filename.empty()) {
+        const char* dir = std::getenv("TMPDIR"); // NOLINT(concurrency-mt-unsafe)
+        options.output_filename = std::string{dir ? dir : "/tmp"} + "/osmium_benchmark_synthetic.osm.pbf";
+    }
+
+    return options;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        const Options options = parse_options(argc, argv);
+        const osmium::builder::SyntheticDataGenerator generator{options.config};
+        osmium::thread::Pool pool{options.threads};
+
+        const auto start = std::chrono::steady_clock::now();
+
+        osmium::io::Header header;
+        header.set("generator", "osmium_benchmark_synthetic");
+        header.add_box(options.config.bounding_box);
+        osmium::io::Writer writer{options.output_filename, header, pool, osmium::io::overwrite::allow};
+        generator.generate(writer, pool);
+        writer.close();
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const auto objects = options.config.nodes + options.config.ways + options.config.relations;
+        const auto size = osmium::file_size(options.output_filename);
+
+        std::cout << "threads: " << pool.num_threads() << '\n'
+                  << "objects: " << objects << '\n'
+                  << "file size: " << size << '\n'
+                  << std::fixed << std::setprecision(3)
+                  << "seconds: " << seconds << '\n'
+                  << std::setprecision(1)
+                  << "MBytes/s: " << static_cast<double>(size) / seconds / (1024.0 * 1024.0) << '\n'
+                  << "million objects/s: " << static_cast<double>(objects) / seconds / 1e6 << '\n';
+
+        if (!options.keep) {
+            std::remove(options.output_filename.c_str());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
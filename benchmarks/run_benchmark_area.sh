@@ -0,0 +1,35 @@
+#!/bin/sh
+#
+#  run_benchmark_area.sh
+#
+#  Runs the benchmark on all data files, on the files downloaded with
+#  download_area_data.sh into $DATA_DIR/areas, and on the multipolygon
+#  test cases from osm-testdata if OSM_TESTDATA points to a checkout of
+#  https://github.com/osmcode/osm-testdata. Set OB_AREA_OPTIONS to pass
+#  options to the benchmark, for instance OB_AREA_OPTIONS="--threads=1,4 --top=20".
+#
+
+set -e
+
+BENCHMARK_NAME=area
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+AREA_FILES=""
+if [ -d $DATA_DIR/areas ]; then
+    AREA_FILES=`find -L $DATA_DIR/areas -mindepth 1 -maxdepth 1 -type f | sort`
+fi
+
+TESTDATA_FILES=""
+if [ -n "$OSM_TESTDATA" -a -f "$OSM_TESTDATA/grid/data/all.osm" ]; then
+    TESTDATA_FILES=$OSM_TESTDATA/grid/data/all.osm
+fi
+
+for data in $TESTDATA_FILES $AREA_FILES $OB_DATA_FILES; do
+    filename=`basename $data`
+    echo "# $filename"
+    $CMD --runs=$OB_RUNS $OB_AREA_OPTIONS $data
+done
+
@@ -0,0 +1,25 @@
+#!/bin/sh
+#
+#  run_benchmark_index_trace.sh
+#
+#  Set OB_INDEX_TRACE_OPTIONS to pass options to the replay, for instance
+#  OB_INDEX_TRACE_OPTIONS="--map=sparse_mmap_array --threads=1,4 --hugepages=no,yes".
+#
+
+set -e
+
+BENCHMARK_NAME=index_trace
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+TRACE=${TMPDIR:-/tmp}/osmium_benchmark_index_trace.$$
+
+for data in $OB_DATA_FILES; do
+    filename=`basename $data`
+    echo "# $filename"
+    $CMD record $data $TRACE
+    $CMD replay --runs=$OB_RUNS $OB_INDEX_TRACE_OPTIONS $TRACE
+    rm -f $TRACE
+done
+
@@ -0,0 +1,21 @@
+#!/bin/sh
+#
+#  run_benchmark_kernels.sh
+#
+#  The kernel microbenchmarks generate their own sample data, so unlike
+#  the other benchmarks this doesn't need DATA_DIR.
+#
+
+set -e
+
+BENCHMARK_NAME=kernels
+
+CMD=@CMAKE_BINARY_DIR@/benchmarks/osmium_benchmark_$BENCHMARK_NAME
+
+echo "BENCHMARK: $BENCHMARK_NAME"
+echo "---------------------"
+echo "build type\t: @CMAKE_BUILD_TYPE@"
+echo "compiler\t: @CMAKE_CXX_COMPILER@"
+echo "---------------------"
+$CMD "$@"
+
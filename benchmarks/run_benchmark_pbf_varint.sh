@@ -0,0 +1,17 @@
+#!/bin/sh
+#
+#  run_benchmark_pbf_varint.sh
+#
+#  Microbenchmark for decoding packed varint fields. Does not use the data
+#  files.
+#
+
+set -e
+
+BENCHMARK_NAME=pbf_varint
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+$CMD
@@ -0,0 +1,31 @@
+#!/bin/sh
+#
+#  run_benchmark_pipeline.sh
+#
+#  Runs the pipeline benchmark harness on all data files and writes one JSON
+#  result file per data file and mode into $OB_RESULTS_DIR (default: current
+#  directory). Compare result files from different builds with
+#  compare_benchmarks.py.
+#
+
+set -e
+
+BENCHMARK_NAME=pipeline
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+OB_RESULTS_DIR=${OB_RESULTS_DIR:-.}
+OB_PIPELINE_THREADS=${OB_PIPELINE_THREADS:-1,2,4,8}
+OB_PIPELINE_BUFFER_SIZES=${OB_PIPELINE_BUFFER_SIZES:-1,10,50}
+
+for data in $OB_DATA_FILES; do
+    filename=`basename $data`
+    for mode in count write; do
+        result=$OB_RESULTS_DIR/${BENCHMARK_NAME}_${mode}_$filename.json
+        echo "$filename $mode -> $result"
+        $CMD --mode=$mode --threads=$OB_PIPELINE_THREADS --buffer-size=$OB_PIPELINE_BUFFER_SIZES --runs=$OB_RUNS --json=$result $data
+    done
+done
+
@@ -0,0 +1,22 @@
+#!/bin/sh
+#
+#  run_benchmark_scaling.sh
+#
+#  Set OB_SCALING_OPTIONS to pass options to the benchmark, for instance
+#  OB_SCALING_OPTIONS="--threads=1,2,4,8 --input-queue=10,20,40".
+#
+
+set -e
+
+BENCHMARK_NAME=scaling
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+for data in $OB_DATA_FILES; do
+    filename=`basename $data`
+    echo "# $filename"
+    $CMD --runs=$OB_RUNS $OB_SCALING_OPTIONS $data
+done
+
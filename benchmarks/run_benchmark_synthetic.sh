@@ -0,0 +1,21 @@
+#!/bin/sh
+#
+#  run_benchmark_synthetic.sh
+#
+#  Generates synthetic data, so unlike most other benchmarks this doesn't
+#  need DATA_DIR. Options are passed to the benchmark program, for
+#  instance "--nodes=100000000 --threads=8".
+#
+
+set -e
+
+BENCHMARK_NAME=synthetic
+
+CMD=@CMAKE_BINARY_DIR@/benchmarks/osmium_benchmark_$BENCHMARK_NAME
+
+echo "BENCHMARK: $BENCHMARK_NAME"
+echo "---------------------"
+echo "build type\t: @CMAKE_BUILD_TYPE@"
+echo "compiler\t: @CMAKE_CXX_COMPILER@"
+echo "---------------------"
+$CMD "$@"
@@ -0,0 +1,36 @@
+find_path(LIBDEFLATE_INCLUDE_DIR
+  NAMES libdeflate.h
+  DOC "libdeflate include directory")
+mark_as_advanced(LIBDEFLATE_INCLUDE_DIR)
+find_library(LIBDEFLATE_LIBRARY
+  NAMES deflate libdeflate
+  DOC "libdeflate library")
+mark_as_advanced(LIBDEFLATE_LIBRARY)
+
+if (LIBDEFLATE_INCLUDE_DIR)
+  file(STRINGS "${LIBDEFLATE_INCLUDE_DIR}/libdeflate.h" _libdeflate_version_lines
+    REGEX "#define[ \t]+LIBDEFLATE_VERSION_(MAJOR|MINOR)")
+  string(REGEX REPLACE ".*LIBDEFLATE_VERSION_MAJOR *\([0-9]*\).*" "\\1" _libdeflate_version_major "${_libdeflate_version_lines}")
+  string(REGEX REPLACE ".*LIBDEFLATE_VERSION_MINOR *\([0-9]*\).*" "\\1" _libdeflate_version_minor "${_libdeflate_version_lines}")
+  set(LIBDEFLATE_VERSION "${_libdeflate_version_major}.${_libdeflate_version_minor}")
+  unset(_libdeflate_version_major)
+  unset(_libdeflate_version_minor)
+  unset(_libdeflate_version_lines)
+endif ()
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(LIBDEFLATE
+  REQUIRED_VARS LIBDEFLATE_LIBRARY LIBDEFLATE_INCLUDE_DIR
+  VERSION_VAR LIBDEFLATE_VERSION)
+
+if (LIBDEFLATE_FOUND)
+  set(LIBDEFLATE_INCLUDE_DIRS "${LIBDEFLATE_INCLUDE_DIR}")
+  set(LIBDEFLATE_LIBRARIES "${LIBDEFLATE_LIBRARY}")
+
+  if (NOT TARGET LIBDEFLATE::LIBDEFLATE)
+    add_library(LIBDEFLATE::LIBDEFLATE UNKNOWN IMPORTED)
+    set_target_properties(LIBDEFLATE::LIBDEFLATE PROPERTIES
+      IMPORTED_LOCATION "${LIBDEFLATE_LIBRARY}"
+      INTERFACE_INCLUDE_DIRECTORIES "${LIBDEFLATE_INCLUDE_DIR}")
+  endif ()
+endif ()
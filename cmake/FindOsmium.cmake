@@ -35,6 +35,10 @@
 #      proj       - include if you want to use any of the Proj.4 functions
 #      sparsehash - include if you use the sparsehash index (deprecated!)
 #      lz4        - include support for LZ4 compression of PBF files
+#      zstd       - include support for zstd compression of PBF files
+#      libdeflate - use libdeflate instead of zlib for (de)compressing
+#                   zlib-compressed PBF blobs
+#      re2        - use RE2 for regular expressions in string matchers
 #
 #    You can check for success with something like this:
 #
@@ -122,16 +126,30 @@ if(Osmium_USE_PBF)
         add_definitions(-DOSMIUM_WITH_LZ4)
     endif()
 
+    if(Osmium_USE_ZSTD)
+        find_package(ZSTD REQUIRED)
+        add_definitions(-DOSMIUM_WITH_ZSTD)
+    endif()
+
+    if(Osmium_USE_LIBDEFLATE)
+        find_package(LIBDEFLATE REQUIRED)
+        add_definitions(-DOSMIUM_WITH_LIBDEFLATE)
+    endif()
+
     list(APPEND OSMIUM_EXTRA_FIND_VARS ZLIB_FOUND Threads_FOUND PROTOZERO_INCLUDE_DIR)
     if(ZLIB_FOUND AND Threads_FOUND AND PROTOZERO_FOUND)
         list(APPEND OSMIUM_PBF_LIBRARIES
             ${ZLIB_LIBRARIES}
             ${LZ4_LIBRARIES}
+            ${ZSTD_LIBRARIES}
+            ${LIBDEFLATE_LIBRARIES}
             ${CMAKE_THREAD_LIBS_INIT}
         )
         list(APPEND OSMIUM_INCLUDE_DIRS
             ${ZLIB_INCLUDE_DIR}
             ${LZ4_INCLUDE_DIRS}
+            ${ZSTD_INCLUDE_DIRS}
+            ${LIBDEFLATE_INCLUDE_DIRS}
             ${PROTOZERO_INCLUDE_DIR}
         )
     else()
@@ -189,6 +207,15 @@ if(Osmium_USE_GEOS)
     else()
         message(WARNING "Osmium: GEOS library is required but not found, please install it or configure the paths.")
     endif()
+
+    # The C API is needed for osmium/geom/geos_c.hpp.
+    find_path(GEOS_C_INCLUDE_DIR geos_c.h)
+    find_library(GEOS_C_LIBRARY NAMES geos_c)
+    if(GEOS_C_INCLUDE_DIR AND GEOS_C_LIBRARY)
+        SET(GEOS_C_FOUND 1)
+        list(APPEND OSMIUM_LIBRARIES ${GEOS_C_LIBRARY})
+        list(APPEND OSMIUM_INCLUDE_DIRS ${GEOS_C_INCLUDE_DIR})
+    endif()
 endif()
 
 #----------------------------------------------------------------------
@@ -221,6 +248,23 @@ if(Osmium_USE_PROJ)
     endif()
 endif()
 
+#----------------------------------------------------------------------
+# Component 're2'
+if(Osmium_USE_RE2)
+    find_path(RE2_INCLUDE_DIR re2/re2.h)
+    find_library(RE2_LIBRARY NAMES re2)
+
+    list(APPEND OSMIUM_EXTRA_FIND_VARS RE2_INCLUDE_DIR RE2_LIBRARY)
+    if(RE2_INCLUDE_DIR AND RE2_LIBRARY)
+        set(RE2_FOUND 1)
+        add_definitions(-DOSMIUM_WITH_RE2)
+        list(APPEND OSMIUM_LIBRARIES ${RE2_LIBRARY})
+        list(APPEND OSMIUM_INCLUDE_DIRS ${RE2_INCLUDE_DIR})
+    else()
+        message(WARNING "Osmium: RE2 library is required but not found, please install it or configure the paths.")
+    endif()
+endif()
+
 #----------------------------------------------------------------------
 # Component 'sparsehash'
 if(Osmium_USE_SPARSEHASH)
@@ -0,0 +1,203 @@
+#ifndef OSMIUM_APPLY_DIFF_PARALLEL_HPP
+#define OSMIUM_APPLY_DIFF_PARALLEL_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/apply_parallel.hpp>
+#include <osmium/diff_visitor.hpp>
+#include <osmium/io/indexed_pbf_reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <type_traits>
+#include <utility>
+
+namespace osmium {
+
+    namespace detail {
+
+        inline bool same_object(const osmium::OSMObject& lhs, const osmium::OSMObject& rhs) noexcept {
+            return lhs.type() == rhs.type() && lhs.id() == rhs.id();
+        }
+
+        /**
+         * Read all versions of all objects whose first version is in one
+         * of the data blobs [first, last) of a history file. Versions of
+         * an object continued from the blob before first are left out,
+         * versions in blobs after last are added, so every object is
+         * complete in exactly one range.
+         */
+        inline osmium::memory::Buffer read_history_range(const osmium::io::IndexedPBFReader& reader, std::size_t first, std::size_t last) {
+            osmium::memory::Buffer result{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+
+            // The object the previous blob ends with, its versions at the
+            // start of this range belong to the previous range.
+            osmium::memory::Buffer previous;
+            const osmium::OSMObject* skip = nullptr;
+            if (first > 0) {
+                previous = reader.read_blob(first - 1, osmium::osm_entity_bits::nwr, osmium::io::read_meta::no);
+                for (const auto& object : previous.select<osmium::OSMObject>()) {
+                    skip = &object;
+                }
+            }
+
+            const osmium::OSMObject* last_object = nullptr;
+            for (std::size_t n = first; n < last; ++n) {
+                const auto buffer = reader.read_blob(n);
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (skip) {
+                        if (same_object(*skip, object)) {
+                            continue;
+                        }
+                        skip = nullptr;
+                    }
+                    result.add_item(object);
+                    result.commit();
+                }
+            }
+
+            for (const auto& object : result.select<osmium::OSMObject>()) {
+                last_object = &object;
+            }
+            if (!last_object) {
+                return result;
+            }
+
+            // Add the versions of the last object continuing in the
+            // following blobs.
+            for (std::size_t n = last; n < reader.num_data_blobs(); ++n) {
+                const auto buffer = reader.read_blob(n);
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (!same_object(*last_object, object)) {
+                        return result;
+                    }
+                    // Adding to the buffer might move its data, so look up
+                    // the last object again afterwards.
+                    const auto offset = result.committed();
+                    result.add_item(object);
+                    result.commit();
+                    last_object = &result.get<osmium::OSMObject>(offset);
+                }
+            }
+
+            return result;
+        }
+
+    } // namespace detail
+
+    /**
+     * Apply diff handlers (see apply_diff()) to all objects in a history
+     * PBF file using the threads in the pool. The file must be sorted by
+     * type, ID, and version. It is split into ranges of data blobs at
+     * object boundaries, all versions of an object are always handled
+     * together by the same task, even if they are spread out over several
+     * blobs. Each range is processed by one pool task with its own
+     * DiffIterator and handler instance, see apply_parallel() for how
+     * handler instances are used and merged.
+     *
+     * @code
+     * osmium::io::IndexedPBFReader reader{"history.osh.pbf"};
+     * EditStatistics stats;
+     * osmium::apply_diff_parallel(reader,
+     *     []() { return EditStatistics{}; },
+     *     [&](EditStatistics&& s) { stats += s; });
+     * @endcode
+     *
+     * @param reader The history file.
+     * @param factory Function returning a new diff handler. It is called
+     *        in pool threads, but never in two at the same time.
+     * @param merge Function called with each handler instance (as rvalue)
+     *        in the calling thread at the end.
+     * @param pool The thread pool to use.
+     * @param blobs_per_range Number of data blobs handled by one task.
+     *        Each task decodes up to two blobs more than this to find the
+     *        object boundaries.
+     * @throws Any exception thrown while reading, by a handler, or by the
+     *         merge function.
+     */
+    template <typename THandlerFactory, typename TMerge>
+    void apply_diff_parallel(const osmium::io::IndexedPBFReader& reader, THandlerFactory&& factory, TMerge&& merge, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(), std::size_t blobs_per_range = 16) {
+        using handler_type = typename std::decay<decltype(factory())>::type;
+        using factory_type = typename std::remove_reference<THandlerFactory>::type;
+
+        if (blobs_per_range == 0) {
+            blobs_per_range = 1;
+        }
+
+        detail::handler_instances<handler_type, factory_type> instances{factory};
+
+        const auto max_tasks = static_cast<std::size_t>(pool.num_threads()) * 2;
+        std::deque<std::future<void>> futures;
+
+        try {
+            for (std::size_t first = 0; first < reader.num_data_blobs(); first += blobs_per_range) {
+                const std::size_t last = std::min(first + blobs_per_range, reader.num_data_blobs());
+                futures.push_back(pool.submit([&reader, &instances, first, last]() {
+                    const auto buffer = detail::read_history_range(reader, first, last);
+                    const detail::handler_lease<handler_type, factory_type> handler{instances};
+                    osmium::apply_diff(buffer.cbegin<osmium::OSMObject>(), buffer.cend<osmium::OSMObject>(), *handler);
+                }));
+                while (futures.size() >= max_tasks) {
+                    futures.front().get();
+                    futures.pop_front();
+                }
+            }
+            while (!futures.empty()) {
+                futures.front().get();
+                futures.pop_front();
+            }
+        } catch (...) {
+            // The tasks still running reference the reader and the
+            // handler instances, so wait for them before leaving.
+            for (auto& future : futures) {
+                if (future.valid()) {
+                    future.wait();
+                }
+            }
+            throw;
+        }
+
+        for (auto& handler : instances.all()) {
+            merge(std::move(*handler));
+        }
+    }
+
+} // namespace osmium
+
+#endif // OSMIUM_APPLY_DIFF_PARALLEL_HPP
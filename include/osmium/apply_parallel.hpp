@@ -0,0 +1,268 @@
+#ifndef OSMIUM_APPLY_PARALLEL_HPP
+#define OSMIUM_APPLY_PARALLEL_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace detail {
+
+        /**
+         * Handler instances for use by pool workers. A task takes an
+         * instance that isn't in use by another task or creates a new
+         * one if there is none, so there are never more instances than
+         * tasks running at the same time.
+         */
+        template <typename THandler, typename THandlerFactory>
+        class handler_instances {
+
+            THandlerFactory& m_factory;
+            std::mutex m_mutex;
+            std::vector<std::unique_ptr<THandler>> m_all;
+            std::vector<THandler*> m_free;
+
+        public:
+
+            explicit handler_instances(THandlerFactory& factory) :
+                m_factory(factory) {
+            }
+
+            THandler* get() {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                if (m_free.empty()) {
+                    m_all.emplace_back(new THandler(m_factory()));
+                    return m_all.back().get();
+                }
+                THandler* handler = m_free.back();
+                m_free.pop_back();
+                return handler;
+            }
+
+            void put_back(THandler* handler) {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_free.push_back(handler);
+            }
+
+            std::vector<std::unique_ptr<THandler>>& all() noexcept {
+                return m_all;
+            }
+
+        }; // class handler_instances
+
+        template <typename THandler, typename THandlerFactory>
+        class handler_lease {
+
+            handler_instances<THandler, THandlerFactory>& m_instances;
+            THandler* m_handler;
+
+        public:
+
+            explicit handler_lease(handler_instances<THandler, THandlerFactory>& instances) :
+                m_instances(instances),
+                m_handler(instances.get()) {
+            }
+
+            handler_lease(const handler_lease&) = delete;
+            handler_lease& operator=(const handler_lease&) = delete;
+
+            handler_lease(handler_lease&&) = delete;
+            handler_lease& operator=(handler_lease&&) = delete;
+
+            ~handler_lease() noexcept {
+                m_instances.put_back(m_handler);
+            }
+
+            THandler& operator*() const noexcept {
+                return *m_handler;
+            }
+
+        }; // class handler_lease
+
+        template <typename THandler>
+        void apply_without_flush(const osmium::memory::Buffer& buffer, THandler& handler) {
+            for (auto& item : buffer) {
+                osmium::apply_item(item, handler);
+            }
+        }
+
+        template <typename T, typename TConsume>
+        void consume_future(std::future<T>& future, TConsume& consume) {
+            consume(future.get());
+        }
+
+        template <typename TConsume>
+        void consume_future(std::future<void>& future, TConsume& /*consume*/) {
+            future.get();
+        }
+
+        // Read all buffers from the source and call func with each of them
+        // in a pool task. At most max_tasks are queued at the same time,
+        // the results are handed to consume in the order of the buffers.
+        template <typename TSource, typename TFunc, typename TConsume>
+        void for_each_buffer_parallel(TSource& source, TFunc&& func, TConsume&& consume, osmium::thread::Pool& pool) {
+            using result_type = decltype(func(std::declval<osmium::memory::Buffer&>()));
+
+            const auto max_tasks = static_cast<std::size_t>(pool.num_threads()) * 2;
+            std::deque<std::future<result_type>> futures;
+
+            try {
+                while (osmium::memory::Buffer buffer = source.read()) {
+                    auto shared_buffer = std::make_shared<osmium::memory::Buffer>(std::move(buffer));
+                    futures.push_back(pool.submit([&func, shared_buffer]() {
+                        return func(*shared_buffer);
+                    }));
+                    while (futures.size() >= max_tasks) {
+                        consume_future(futures.front(), consume);
+                        futures.pop_front();
+                    }
+                }
+                while (!futures.empty()) {
+                    consume_future(futures.front(), consume);
+                    futures.pop_front();
+                }
+            } catch (...) {
+                // The tasks still running reference func, so wait for
+                // them before leaving.
+                for (auto& future : futures) {
+                    if (future.valid()) {
+                        future.wait();
+                    }
+                }
+                throw;
+            }
+        }
+
+    } // namespace detail
+
+    /**
+     * Apply handlers to all objects from the source using the threads in
+     * the pool. Each buffer is processed as a whole by one pool task.
+     * Every task uses its own handler instance which is never used by
+     * another task at the same time, so the handlers don't need to be
+     * thread-safe. But an instance sees only some of the buffers and
+     * these are not necessarily in order.
+     *
+     * At the end flush() is called on each handler instance and the
+     * instances are handed to the merge function one after the other
+     * in the calling thread. Use this for handlers collecting some
+     * statistics or checking objects independently of each other.
+     *
+     * @code
+     * osmium::io::Reader reader{"input.osm.pbf"};
+     * std::size_t count = 0;
+     * osmium::apply_parallel(reader,
+     *     []() { return CountHandler{}; },
+     *     [&](CountHandler&& handler) { count += handler.count; });
+     * @endcode
+     *
+     * @param source Where the buffers come from. Usually an
+     *        osmium::io::Reader, but anything with a read() function
+     *        returning an osmium::memory::Buffer (an invalid one at the
+     *        end) will do.
+     * @param factory Function returning a new handler. It is called in
+     *        pool threads, but never in two at the same time.
+     * @param merge Function called with each handler instance (as
+     *        rvalue) at the end.
+     * @param pool The thread pool to use.
+     * @throws Any exception thrown by the source, a handler, or the
+     *         merge function.
+     */
+    template <typename TSource, typename THandlerFactory, typename TMerge>
+    void apply_parallel(TSource& source, THandlerFactory&& factory, TMerge&& merge, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+        using handler_type = typename std::decay<decltype(factory())>::type;
+
+        detail::handler_instances<handler_type, typename std::remove_reference<THandlerFactory>::type> instances{factory};
+
+        detail::for_each_buffer_parallel(source, [&instances](const osmium::memory::Buffer& buffer) {
+            const detail::handler_lease<handler_type, typename std::remove_reference<THandlerFactory>::type> handler{instances};
+            detail::apply_without_flush(buffer, *handler);
+        }, [](){}, pool);
+
+        for (auto& handler : instances.all()) {
+            handler->flush();
+            merge(std::move(*handler));
+        }
+    }
+
+    /**
+     * Like apply_parallel() above, but for handlers producing some output
+     * for each buffer, for instance a buffer with the objects matching
+     * some filter. After a handler has seen all objects in a buffer, the
+     * extract function is called with the handler in the same pool task
+     * and returns the output for this buffer. The outputs are handed to
+     * the consume function in the calling thread in the same order as
+     * the buffers were read.
+     *
+     * @param source Where the buffers come from, see apply_parallel().
+     * @param factory Function returning a new handler.
+     * @param extract Function called with a handler after each buffer,
+     *        it must return the output for the buffer (not void) and
+     *        should reset the handler for the next buffer. It is called
+     *        in pool threads, but never for the same handler at the same
+     *        time.
+     * @param consume Function called with each output (as rvalue) in
+     *        the calling thread.
+     * @param pool The thread pool to use.
+     * @throws Any exception thrown by the source, a handler, or the
+     *         extract or consume functions.
+     */
+    template <typename TSource, typename THandlerFactory, typename TExtract, typename TConsume>
+    void apply_parallel_ordered(TSource& source, THandlerFactory&& factory, TExtract&& extract, TConsume&& consume, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+        using handler_type = typename std::decay<decltype(factory())>::type;
+
+        detail::handler_instances<handler_type, typename std::remove_reference<THandlerFactory>::type> instances{factory};
+
+        detail::for_each_buffer_parallel(source, [&instances, &extract](const osmium::memory::Buffer& buffer) {
+            const detail::handler_lease<handler_type, typename std::remove_reference<THandlerFactory>::type> handler{instances};
+            detail::apply_without_flush(buffer, *handler);
+            return extract(*handler);
+        }, consume, pool);
+    }
+
+} // namespace osmium
+
+#endif // OSMIUM_APPLY_PARALLEL_HPP
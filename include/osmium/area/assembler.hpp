@@ -35,18 +35,27 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/area/assembler_config.hpp>
 #include <osmium/area/detail/basic_assembler_with_tags.hpp>
+#include <osmium/area/detail/node_ref_segment.hpp>
+#include <osmium/area/detail/vector.hpp>
 #include <osmium/area/detail/segment_list.hpp>
 #include <osmium/area/problem_reporter.hpp>
 #include <osmium/area/stats.hpp>
 #include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/item_type.hpp>
+#include <osmium/osm/bounding_box.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/tag.hpp>
 #include <osmium/osm/way.hpp>
+#include <osmium/util/tracepoint.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
@@ -60,6 +69,96 @@ namespace osmium {
          */
         class Assembler : public detail::BasicAssemblerWithTags {
 
+            enum : std::size_t {
+                max_simple_ring_segments = 64
+            };
+
+            /**
+             * Fast path for small closed ways where all nodes (except the
+             * last) have different locations, like most buildings. Checks
+             * all pairs of segments for intersections directly and writes
+             * the way nodes as outer ring without building a segment list,
+             * location index and proto rings. The result is the same as
+             * with the general algorithm: A single outer ring starting at
+             * the smallest location in counter-clockwise direction.
+             *
+             * @returns false if the fast path can not be used.
+             */
+            bool create_simple_area(osmium::memory::Buffer& out_buffer, const osmium::Way& way) {
+                const auto& nodes = way.nodes();
+                const std::size_t num_segments = nodes.size() - 1;
+
+                if (config().debug_level > 0 || config().problem_reporter ||
+                    num_segments < 3 || num_segments > max_simple_ring_segments ||
+                    !way.ends_have_same_id() ||
+                    nodes.front().location() != nodes.back().location()) {
+                    return false;
+                }
+
+                std::vector<osmium::Location> locations;
+                locations.reserve(num_segments);
+                for (std::size_t i = 0; i < num_segments; ++i) {
+                    if (!nodes[i].location().valid()) {
+                        return false;
+                    }
+                    locations.push_back(nodes[i].location());
+                }
+                std::sort(locations.begin(), locations.end());
+                if (std::adjacent_find(locations.begin(), locations.end()) != locations.end()) {
+                    return false;
+                }
+
+                std::vector<detail::NodeRefSegment> segments;
+                segments.reserve(num_segments);
+                for (std::size_t i = 0; i < num_segments; ++i) {
+                    segments.emplace_back(nodes[i], nodes[i + 1], detail::role_type::unknown, &way);
+                }
+                for (std::size_t i = 0; i < num_segments - 1; ++i) {
+                    for (std::size_t j = i + 1; j < num_segments; ++j) {
+                        if (detail::calculate_intersection(segments[i], segments[j])) {
+                            return false;
+                        }
+                    }
+                }
+
+                std::size_t start = 0;
+                int64_t sum = 0;
+                for (std::size_t i = 0; i < num_segments; ++i) {
+                    if (nodes[i].location() == locations.front()) {
+                        start = i;
+                    }
+                    sum += detail::vec{nodes[i]} * detail::vec{nodes[i + 1]};
+                }
+
+                stats().nodes += num_segments;
+                ++stats().area_simple_case;
+                stats().outer_rings = 1;
+                stats().inner_rings = 0;
+
+                osmium::builder::AreaBuilder builder{out_buffer};
+                builder.initialize_from_object(way);
+                builder.add_item(way.tags());
+                {
+                    osmium::builder::OuterRingBuilder ring_builder{builder};
+                    auto* node_refs = ring_builder.add_empty_node_refs(num_segments + 1);
+                    for (std::size_t i = 0; i <= num_segments; ++i) {
+                        // counter-clockwise means positive sum
+                        const auto n = sum > 0 ? (start + i) % num_segments
+                                               : (start + num_segments - i) % num_segments;
+                        *node_refs++ = nodes[n];
+                    }
+                }
+                if (config().add_bounding_box) {
+                    osmium::Box box;
+                    for (const auto& location : locations) {
+                        box.extend(location);
+                    }
+                    builder.add_item(osmium::BoundingBox{box});
+                }
+
+                return true;
+            }
+
             bool create_area(osmium::memory::Buffer& out_buffer, const osmium::Way& way) {
                 osmium::builder::AreaBuilder builder{out_buffer};
                 builder.initialize_from_object(way);
@@ -105,43 +204,43 @@ namespace osmium {
                 return area_okay || config().create_empty_areas;
             }
 
-        public:
-
-            explicit Assembler(const config_type& config) :
-                detail::BasicAssemblerWithTags(config) {
-            }
-
-            /**
-             * Assemble an area from the given way.
-             * The resulting area is put into the out_buffer.
-             *
-             * @returns false if there was some kind of error building the
-             *          area, true otherwise.
-             */
-            bool operator()(const osmium::Way& way, osmium::memory::Buffer& out_buffer) {
+            bool assemble_way(const osmium::Way& way, osmium::memory::Buffer& out_buffer) {
                 if (!config().create_way_polygons) {
                     return true;
                 }
 
+                // The way can have a normal or a compressed node list.
+                const auto* compressed_nodes = way.compressed_nodes();
+                const std::size_t num_nodes = compressed_nodes ? compressed_nodes->size() : way.nodes().size();
+
                 if (config().problem_reporter) {
                     config().problem_reporter->set_object(osmium::item_type::way, way.id());
-                    config().problem_reporter->set_nodes(way.nodes().size());
+                    config().problem_reporter->set_nodes(num_nodes);
                 }
 
                 // Ignore (but count) ways without segments.
-                if (way.nodes().size() < 2) {
+                if (num_nodes < 2) {
                     ++stats().short_ways;
                     return false;
                 }
 
-                if (!way.ends_have_same_id()) {
+                const osmium::NodeRef first = compressed_nodes ? compressed_nodes->front() : way.nodes().front();
+                const osmium::NodeRef last = compressed_nodes ? compressed_nodes->back() : way.nodes().back();
+                if (first.ref() != last.ref()) {
                     ++stats().duplicate_nodes;
                     if (config().problem_reporter) {
-                        config().problem_reporter->report_duplicate_node(way.nodes().front().ref(), way.nodes().back().ref(), way.nodes().front().location());
+                        config().problem_reporter->report_duplicate_node(first.ref(), last.ref(), first.location());
                     }
                 }
 
                 ++stats().from_ways;
+
+                // The fast path needs random access to the nodes.
+                if (!compressed_nodes && create_simple_area(out_buffer, way)) {
+                    out_buffer.commit();
+                    return true;
+                }
+
                 stats().invalid_locations = segment_list().extract_segments_from_way(config().problem_reporter,
                                                                                      stats().duplicate_nodes,
                                                                                      way);
@@ -169,14 +268,7 @@ namespace osmium {
                 return okay;
             }
 
-            /**
-             * Assemble an area from the given relation and its members.
-             * The resulting area is put into the out_buffer.
-             *
-             * @returns false if there was some kind of error building the
-             *          area(s), true otherwise.
-             */
-            bool operator()(const osmium::Relation& relation, const std::vector<const osmium::Way*>& members, osmium::memory::Buffer& out_buffer) {
+            bool assemble_relation(const osmium::Relation& relation, const std::vector<const osmium::Way*>& members, osmium::memory::Buffer& out_buffer) {
                 if (!config().create_new_style_polygons) {
                     return true;
                 }
@@ -223,6 +315,48 @@ namespace osmium {
                 return okay;
             }
 
+        public:
+
+            explicit Assembler(const config_type& config) :
+                detail::BasicAssemblerWithTags(config) {
+            }
+
+            /**
+             * Assemble an area from the given way.
+             * The resulting area is put into the out_buffer.
+             *
+             * @returns false if there was some kind of error building the
+             *          area, true otherwise.
+             */
+            bool operator()(const osmium::Way& way, osmium::memory::Buffer& out_buffer) {
+                reset();
+
+                const detail::phase_timer timer{config().collect_timings};
+                const bool okay = assemble_way(way, out_buffer);
+                timer.add_to(stats().total_nanoseconds);
+
+                return okay;
+            }
+
+            /**
+             * Assemble an area from the given relation and its members.
+             * The resulting area is put into the out_buffer.
+             *
+             * @returns false if there was some kind of error building the
+             *          area(s), true otherwise.
+             */
+            bool operator()(const osmium::Relation& relation, const std::vector<const osmium::Way*>& members, osmium::memory::Buffer& out_buffer) {
+                reset();
+
+                const detail::phase_timer timer{config().collect_timings};
+                OSMIUM_TRACEPOINT2(assembler_relation_start, relation.id(), members.size());
+                const bool okay = assemble_relation(relation, members, out_buffer);
+                OSMIUM_TRACEPOINT2(assembler_relation_end, relation.id(), okay);
+                timer.add_to(stats().total_nanoseconds);
+
+                return okay;
+            }
+
         }; // class Assembler
 
     } // namespace area
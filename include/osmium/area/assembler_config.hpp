@@ -33,6 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cstddef>
+
 namespace osmium {
 
     namespace area {
@@ -122,6 +124,38 @@ namespace osmium {
              */
             bool ignore_invalid_locations = false;
 
+            /**
+             * Areas with at least this many segments are checked for
+             * intersections with a sweep line algorithm. It is much faster
+             * for large areas with many segments such as national borders
+             * or coastlines, but has more overhead for small areas.
+             */
+            std::size_t sweep_line_threshold = 1000;
+
+            /**
+             * Measure the time spent in the different phases of the
+             * assembly and record it in the area_stats. Off by default,
+             * because reading the clock several times per area has a
+             * small cost.
+             */
+            bool collect_timings = false;
+
+            /**
+             * Add a BoundingBox subitem with the envelope of the outer
+             * rings to each area created. Area::envelope() will then
+             * return it without having to look at all node locations.
+             */
+            bool add_bounding_box = false;
+
+            /**
+             * Store the nodes of member ways in a CompressedWayNodeList
+             * in the MultipolygonManager. This needs much less memory for
+             * large multipolygons, but the member ways handed to the
+             * problem reporter then have no WayNodeList. Only used if
+             * create_old_style_polygons is not set.
+             */
+            bool compress_member_ways = false;
+
             AssemblerConfig() noexcept = default;
 
         }; // struct AssemblerConfig
@@ -211,6 +211,8 @@ namespace osmium {
              *          area, true otherwise.
              */
             bool operator()(const osmium::Way& way, osmium::memory::Buffer& out_buffer) {
+                reset();
+
                 if (!config().create_way_polygons) {
                     return true;
                 }
@@ -273,6 +275,8 @@ namespace osmium {
              *          area(s), true otherwise.
              */
             bool operator()(const osmium::Relation& relation, const std::vector<const osmium::Way*>& members, osmium::memory::Buffer& out_buffer) {
+                reset();
+
                 assert(relation.members().size() >= members.size());
 
                 if (config().problem_reporter) {
@@ -40,6 +40,8 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/area/problem_reporter.hpp>
 #include <osmium/area/stats.hpp>
 #include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/osm/bounding_box.hpp>
+#include <osmium/osm/box.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/types.hpp>
@@ -49,6 +51,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <exception>
@@ -97,6 +100,38 @@ namespace osmium {
                 return lhs.location < rhs.location;
             }
 
+            /**
+             * Measures the time of consecutive phases of the assembly if
+             * enabled. Each call to add_to() adds the time since the
+             * timer was created or since the last call to add_to() to
+             * the given counter.
+             */
+            class phase_timer {
+
+                using clock = std::chrono::steady_clock;
+
+                mutable clock::time_point m_start{};
+                bool m_enabled;
+
+            public:
+
+                explicit phase_timer(bool enabled) :
+                    m_enabled(enabled) {
+                    if (enabled) {
+                        m_start = clock::now();
+                    }
+                }
+
+                void add_to(uint64_t& counter) const {
+                    if (m_enabled) {
+                        const auto now = clock::now();
+                        counter += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_start).count());
+                        m_start = now;
+                    }
+                }
+
+            }; // class phase_timer
+
             /**
              * Class for assembling ways and relations into multipolygons
              * (areas). Contains the basic functionality needed but is not
@@ -159,24 +194,44 @@ namespace osmium {
                 // The rings we are building from the segments
                 std::list<ProtoRing> m_rings;
 
+                // Rings not used any more. They are kept so that their
+                // memory can be re-used for new rings.
+                std::list<ProtoRing> m_free_rings;
+
                 // All node locations
                 std::vector<slocation> m_locations;
 
                 // All locations where more than two segments start/end
                 std::vector<Location> m_split_locations;
 
+                // Index for finding segments below a location
+                SegmentXIndex m_segment_x_index;
+
                 // Statistics
                 area_stats m_stats;
 
                 // The number of members the multipolygon relation has
                 std::size_t m_num_members = 0;
 
+                // Add a new ring to the list of rings, re-using a ring from
+                // an earlier run of the assembler if possible.
+                ProtoRing* new_ring(NodeRefSegment* segment) {
+                    if (m_free_rings.empty()) {
+                        m_rings.emplace_back(segment);
+                    } else {
+                        m_rings.splice(m_rings.end(), m_free_rings, m_free_rings.begin());
+                        m_rings.back().restart(segment);
+                    }
+                    return &m_rings.back();
+                }
+
                 template <typename TBuilder>
                 static void build_ring_from_proto_ring(osmium::builder::AreaBuilder& builder, const ProtoRing& ring) {
                     TBuilder ring_builder{builder};
-                    ring_builder.add_node_ref(ring.get_node_ref_start());
+                    auto* node_refs = ring_builder.add_empty_node_refs(ring.segments().size() + 1);
+                    *node_refs++ = ring.get_node_ref_start();
                     for (const auto& segment : ring.segments()) {
-                        ring_builder.add_node_ref(segment->stop());
+                        *node_refs++ = segment->stop();
                     }
                 }
 
@@ -307,19 +362,25 @@ namespace osmium {
 
                     int nesting = 0;
 
+                    // Only segments reaching at least to the x coordinate of
+                    // the location can be below it, the index finds them
+                    // without looking at all segments to the left.
+                    assert(m_segment_x_index.size() == m_segment_list.size());
+                    const auto last = static_cast<std::size_t>(segment - &m_segment_list.front());
+
                     rings_stack outer_rings;
-                    while (segment >= &m_segment_list.front()) {
-                        if (!segment->is_direction_done()) {
-                            --segment;
-                            continue;
+                    m_segment_x_index.for_each_reaching(last, location.x(), [&](const std::size_t n) {
+                        const NodeRefSegment* other = &m_segment_list[n];
+                        if (!other->is_direction_done()) {
+                            return;
                         }
                         if (debug()) {
-                            std::cerr << "      Checking against " << *segment << "\n";
+                            std::cerr << "      Checking against " << *other << "\n";
                         }
-                        const osmium::Location& a = segment->first().location();
-                        const osmium::Location& b = segment->second().location();
+                        const osmium::Location& a = other->first().location();
+                        const osmium::Location& b = other->second().location();
 
-                        if (segment->first().location() == location) {
+                        if (other->first().location() == location) {
                             const int64_t ax = a.x();
                             const int64_t bx = b.x();
                             const int64_t lx = end_location.x();
@@ -331,15 +392,15 @@ namespace osmium {
                                 std::cerr << "      Segment z=" << z << '\n';
                             }
                             if (z > 0) {
-                                nesting += segment->is_reverse() ? -1 : 1;
+                                nesting += other->is_reverse() ? -1 : 1;
                                 if (debug()) {
                                     std::cerr << "        Segment is below (nesting=" << nesting << ")\n";
                                 }
-                                if (segment->ring()->is_outer()) {
+                                if (other->ring()->is_outer()) {
                                     if (debug()) {
-                                        std::cerr << "        Segment belongs to outer ring (y=" << a.y() << " ring=" << *segment->ring() << ")\n";
+                                        std::cerr << "        Segment belongs to outer ring (y=" << a.y() << " ring=" << *other->ring() << ")\n";
                                     }
-                                    outer_rings.emplace_back(a.y(), segment->ring());
+                                    outer_rings.emplace_back(a.y(), other->ring());
                                 }
                             }
                         } else if (a.x() <= location.x() && location.x() < b.x()) {
@@ -356,22 +417,21 @@ namespace osmium {
                             const auto z = (bx - ax) * (ly - ay) - (by - ay) * (lx - ax);
 
                             if (z >= 0) {
-                                nesting += segment->is_reverse() ? -1 : 1;
+                                nesting += other->is_reverse() ? -1 : 1;
                                 if (debug()) {
                                     std::cerr << "        Segment is below (nesting=" << nesting << ")\n";
                                 }
-                                if (segment->ring()->is_outer()) {
+                                if (other->ring()->is_outer()) {
                                     const double y = static_cast<double>(ay) +
                                                      static_cast<double>((by - ay) * (lx - ax)) / static_cast<double>(bx - ax);
                                     if (debug()) {
-                                        std::cerr << "        Segment belongs to outer ring (y=" << y << " ring=" << *segment->ring() << ")\n";
+                                        std::cerr << "        Segment belongs to outer ring (y=" << y << " ring=" << *other->ring() << ")\n";
                                     }
-                                    outer_rings.emplace_back(y, segment->ring());
+                                    outer_rings.emplace_back(y, other->ring());
                                 }
                             }
                         }
-                        --segment;
-                    }
+                    });
 
                     if (nesting % 2 == 0) {
                         if (debug()) {
@@ -427,8 +487,7 @@ namespace osmium {
                     }
                     segment->mark_direction_done();
 
-                    m_rings.emplace_back(segment);
-                    ProtoRing* ring = &m_rings.back();
+                    ProtoRing* ring = new_ring(segment);
                     if (outer_ring) {
                         if (debug()) {
                             std::cerr << "    This is an inner ring. Outer ring is " << *outer_ring << "\n";
@@ -478,8 +537,7 @@ namespace osmium {
                         segment->reverse();
                     }
 
-                    m_rings.emplace_back(segment);
-                    ProtoRing* ring = &m_rings.back();
+                    ProtoRing* ring = new_ring(segment);
 
                     const osmium::Location& first_location = node.location(m_segment_list);
                     osmium::Location last_location = segment->stop().location();
@@ -655,7 +713,7 @@ namespace osmium {
                     }
 
                     open_ring_its.erase(std::find(open_ring_its.begin(), open_ring_its.end(), r2));
-                    m_rings.erase(r2);
+                    m_free_rings.splice(m_free_rings.end(), m_rings, r2);
 
                     if (r1->closed()) {
                         open_ring_its.erase(std::find(open_ring_its.begin(), open_ring_its.end(), r1));
@@ -1007,17 +1065,27 @@ namespace osmium {
 
                 /**
                  * Append each outer ring together with its inner rings to the
-                 * area in the buffer.
+                 * area in the buffer. If configured, a bounding box of all
+                 * outer rings is appended after them.
                  */
                 void add_rings_to_area(osmium::builder::AreaBuilder& builder) const {
+                    osmium::Box box;
                     for (const ProtoRing& ring : m_rings) {
                         if (ring.is_outer()) {
                             build_ring_from_proto_ring<osmium::builder::OuterRingBuilder>(builder, ring);
                             for (const ProtoRing* inner : ring.inner_rings()) {
                                 build_ring_from_proto_ring<osmium::builder::InnerRingBuilder>(builder, *inner);
                             }
+                            if (m_config.add_bounding_box) {
+                                for (const auto& segment : ring.segments()) {
+                                    box.extend(segment->stop().location());
+                                }
+                            }
                         }
                     }
+                    if (m_config.add_bounding_box) {
+                        builder.add_item(osmium::BoundingBox{box});
+                    }
                 }
 
                 /**
@@ -1026,11 +1094,14 @@ namespace osmium {
                 bool create_rings() {
                     m_stats.nodes += m_segment_list.size();
 
+                    const phase_timer phase{m_config.collect_timings};
+
                     // Sort the list of segments (from left to right and bottom
                     // to top).
                     osmium::Timer timer_sort;
                     m_segment_list.sort();
                     timer_sort.stop();
+                    phase.add_to(m_stats.sort_nanoseconds);
 
                     // Remove duplicate segments. Removal is in pairs, so if there
                     // are two identical segments, they will both be removed. If
@@ -1038,6 +1109,7 @@ namespace osmium {
                     osmium::Timer timer_dupl;
                     m_segment_list.erase_duplicate_segments(m_config.problem_reporter, m_stats.duplicate_segments, m_stats.overlapping_segments);
                     timer_dupl.stop();
+                    phase.add_to(m_stats.duplicates_nanoseconds);
 
                     // If there are no segments left at this point, this isn't
                     // a valid area.
@@ -1060,8 +1132,9 @@ namespace osmium {
                     // In the future this could be improved by trying to fix those
                     // cases.
                     osmium::Timer timer_intersection;
-                    m_stats.intersections = m_segment_list.find_intersections(m_config.problem_reporter);
+                    m_stats.intersections = m_segment_list.find_intersections(m_config.problem_reporter, m_config.sweep_line_threshold);
                     timer_intersection.stop();
+                    phase.add_to(m_stats.intersections_nanoseconds);
 
                     if (m_stats.intersections) {
                         return false;
@@ -1074,6 +1147,7 @@ namespace osmium {
                     osmium::Timer timer_locations_list;
                     create_locations_list();
                     timer_locations_list.stop();
+                    phase.add_to(m_stats.locations_nanoseconds);
 
                     // Find all locations where more than two segments start or
                     // end. We call those "split" locations. If there are any
@@ -1084,6 +1158,7 @@ namespace osmium {
                         return false;
                     }
                     timer_split.stop();
+                    phase.add_to(m_stats.split_locations_nanoseconds);
 
                     // Now report all split locations to the problem reporter.
                     m_stats.touching_rings += m_split_locations.size();
@@ -1106,6 +1181,9 @@ namespace osmium {
                         }
                     }
 
+                    // The segments don't change from here on.
+                    m_segment_x_index.build(m_segment_list);
+
                     // From here on we use two different algorithms depending on
                     // whether there were any split locations or not. If there
                     // are no splits, we use the faster "simple algorithm", if
@@ -1143,6 +1221,7 @@ namespace osmium {
                         }
                         timer.stop();
                     }
+                    phase.add_to(m_stats.rings_nanoseconds);
 
                     // If the assembler was so configured, now check whether the
                     // member roles are correctly tagged.
@@ -1150,6 +1229,7 @@ namespace osmium {
                         osmium::Timer timer_roles;
                         check_inner_outer_roles();
                         timer_roles.stop();
+                        phase.add_to(m_stats.roles_nanoseconds);
                     }
 
                     m_stats.outer_rings = std::count_if(m_rings.cbegin(), m_rings.cend(), [](const ProtoRing& ring) {
@@ -1199,6 +1279,22 @@ namespace osmium {
                     return m_config;
                 }
 
+                /**
+                 * Reset the assembler so that it can be used to assemble
+                 * the next area. This also resets the statistics. All data
+                 * structures are cleared, but the memory allocated for them
+                 * is kept for re-use.
+                 */
+                void reset() {
+                    m_segment_list.clear();
+                    m_free_rings.splice(m_free_rings.end(), m_rings);
+                    m_locations.clear();
+                    m_split_locations.clear();
+                    m_segment_x_index.clear();
+                    m_stats = area_stats{};
+                    m_num_members = 0;
+                }
+
                 bool debug() const noexcept {
                     return m_config.debug_level > 1;
                 }
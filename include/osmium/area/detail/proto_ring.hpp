@@ -99,6 +99,23 @@ namespace osmium {
                     add_segment_back(segment);
                 }
 
+                /**
+                 * Re-initialize this ring so that it only contains the given
+                 * segment. This is used when re-using a ring object, the
+                 * memory allocated for the segments is kept.
+                 */
+                void restart(NodeRefSegment* segment) {
+                    m_segments.clear();
+                    m_inner.clear();
+                    m_min_segment = segment;
+                    m_outer_ring = nullptr;
+#ifdef OSMIUM_DEBUG_RING_NO
+                    m_num = next_num();
+#endif
+                    m_sum = 0;
+                    add_segment_back(segment);
+                }
+
                 void add_segment_back(NodeRefSegment* segment) {
                     assert(segment);
                     if (*segment < *m_min_segment) {
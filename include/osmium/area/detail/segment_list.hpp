@@ -45,11 +45,17 @@ DEALINGS IN THE SOFTWARE.
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <map>
 #include <numeric>
+#include <queue>
+#include <set>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -106,18 +112,38 @@ namespace osmium {
                  */
                 static std::size_t get_num_segments(const std::vector<const osmium::Way*>& members) noexcept {
                     return std::accumulate(members.cbegin(), members.cend(), static_cast<std::size_t>(0), [](std::size_t sum, const osmium::Way* way) {
-                        if (way->nodes().empty()) {
+                        const auto num_nodes = num_way_nodes(*way);
+                        if (num_nodes == 0) {
                             return sum;
                         }
-                        return sum + way->nodes().size() - 1;
+                        return sum + num_nodes - 1;
                     });
                 }
 
+                /**
+                 * Number of nodes in the way, which might have a normal
+                 * or a compressed node list.
+                 */
+                static std::size_t num_way_nodes(const osmium::Way& way) noexcept {
+                    const auto* compressed_nodes = way.compressed_nodes();
+                    return compressed_nodes ? compressed_nodes->size() : way.nodes().size();
+                }
+
                 uint32_t extract_segments_from_way_impl(ProblemReporter* problem_reporter, uint64_t& duplicate_nodes, const osmium::Way& way, role_type role) {
+                    const auto* compressed_nodes = way.compressed_nodes();
+                    if (compressed_nodes) {
+                        return extract_segments_from_node_refs(problem_reporter, duplicate_nodes, way, role, compressed_nodes->cbegin(), compressed_nodes->cend());
+                    }
+                    return extract_segments_from_node_refs(problem_reporter, duplicate_nodes, way, role, way.nodes().cbegin(), way.nodes().cend());
+                }
+
+                template <typename TIter>
+                uint32_t extract_segments_from_node_refs(ProblemReporter* problem_reporter, uint64_t& duplicate_nodes, const osmium::Way& way, role_type role, TIter it, TIter end) {
                     uint32_t invalid_locations = 0;
 
                     osmium::NodeRef previous_nr;
-                    for (const osmium::NodeRef& nr : way.nodes()) {
+                    for (; it != end; ++it) {
+                        const osmium::NodeRef& nr = *it;
                         if (!nr.location().valid()) {
                             ++invalid_locations;
                             if (problem_reporter) {
@@ -141,6 +167,86 @@ namespace osmium {
                     return invalid_locations;
                 }
 
+                bool check_intersection(const NodeRefSegment& s1, const NodeRefSegment& s2, ProblemReporter* problem_reporter) const {
+                    assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
+
+                    const osmium::Location intersection{calculate_intersection(s1, s2)};
+                    if (!intersection) {
+                        return false;
+                    }
+
+                    if (m_debug) {
+                        std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
+                    }
+                    if (problem_reporter) {
+                        problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(),
+                                                              s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
+                    }
+
+                    return true;
+                }
+
+                uint32_t find_intersections_sweep_line(ProblemReporter* problem_reporter) const {
+                    // Segments overlapping the sweep line in x ordered by
+                    // their minimum y, together with the heights of those
+                    // segments and a queue ordered by their maximum x to
+                    // remove them once the sweep line has passed them.
+                    using active_type = std::multimap<int64_t, std::size_t>;
+                    using expiry_type = std::pair<int32_t, active_type::iterator>;
+                    const auto later = [](const expiry_type& a, const expiry_type& b) noexcept {
+                        return a.first > b.first;
+                    };
+
+                    active_type active;
+                    std::multiset<int64_t> heights;
+                    std::priority_queue<expiry_type, std::vector<expiry_type>, decltype(later)> expiry{later};
+
+                    std::vector<std::pair<std::size_t, std::size_t>> candidates;
+
+                    for (std::size_t n = 0; n < m_segments.size(); ++n) {
+                        const NodeRefSegment& s2 = m_segments[n];
+
+                        while (!expiry.empty() && expiry.top().first < s2.first().location().x()) {
+                            const auto it = expiry.top().second;
+                            heights.erase(heights.find(y_height(m_segments[it->second])));
+                            active.erase(it);
+                            expiry.pop();
+                        }
+
+                        const std::pair<int32_t, int32_t> y = std::minmax(s2.first().location().y(), s2.second().location().y());
+
+                        if (!active.empty()) {
+                            const int64_t max_height = *heights.rbegin();
+                            for (auto it = active.lower_bound(y.first - max_height); it != active.end() && it->first <= y.second; ++it) {
+                                if (y_range_overlap(m_segments[it->second], s2)) {
+                                    candidates.emplace_back(it->second, n);
+                                }
+                            }
+                        }
+
+                        heights.insert(y_height(s2));
+                        expiry.emplace(s2.second().location().x(), active.emplace(y.first, n));
+                    }
+
+                    // Check candidates in the same order as the simple
+                    // algorithm would so that problems are reported in the
+                    // same order.
+                    std::sort(candidates.begin(), candidates.end());
+
+                    uint32_t found_intersections = 0;
+                    for (const auto& candidate : candidates) {
+                        if (check_intersection(m_segments[candidate.first], m_segments[candidate.second], problem_reporter)) {
+                            ++found_intersections;
+                        }
+                    }
+
+                    return found_intersections;
+                }
+
+                static int64_t y_height(const NodeRefSegment& segment) noexcept {
+                    return std::abs(static_cast<int64_t>(segment.second().location().y()) - static_cast<int64_t>(segment.first().location().y()));
+                }
+
             public:
 
                 explicit SegmentList(bool debug) noexcept :
@@ -155,6 +261,11 @@ namespace osmium {
 
                 ~SegmentList() noexcept = default;
 
+                /// Clear the list. Allocated memory is kept.
+                void clear() noexcept {
+                    m_segments.clear();
+                }
+
                 /// The number of segments in the list.
                 std::size_t size() const noexcept {
                     return m_segments.size();
@@ -223,10 +334,11 @@ namespace osmium {
                  * removed after reporting the duplicate node.
                  */
                 uint32_t extract_segments_from_way(ProblemReporter* problem_reporter, uint64_t& duplicate_nodes, const osmium::Way& way) {
-                    if (way.nodes().empty()) {
+                    const auto num_nodes = num_way_nodes(way);
+                    if (num_nodes == 0) {
                         return 0;
                     }
-                    m_segments.reserve(way.nodes().size() - 1);
+                    m_segments.reserve(num_nodes - 1);
                     return extract_segments_from_way_impl(problem_reporter, duplicate_nodes, way, role_type::outer);
                 }
 
@@ -310,15 +422,32 @@ namespace osmium {
                 /**
                  * Find intersection between segments.
                  *
+                 * The segments must be sorted. Each segment is compared
+                 * with all following segments overlapping it in the x
+                 * range. This degrades towards O(n^2) if many segments
+                 * overlap in x, for instance for long rings running mostly
+                 * north-south. So for lists with at least
+                 * sweep_line_threshold segments a sweep line is used which
+                 * keeps the segments overlapping in x ordered by y and only
+                 * compares segments overlapping in both ranges. Both
+                 * methods report the same intersections in the same order.
+                 *
                  * @param problem_reporter Any intersections found are
                  *                         reported to this object.
+                 * @param sweep_line_threshold Use the sweep line algorithm
+                 *                             if there are at least this
+                 *                             many segments.
                  * @returns true if there are intersections.
                  */
-                uint32_t find_intersections(ProblemReporter* problem_reporter) const {
+                uint32_t find_intersections(ProblemReporter* problem_reporter, std::size_t sweep_line_threshold = std::numeric_limits<std::size_t>::max()) const {
                     if (m_segments.empty()) {
                         return 0;
                     }
 
+                    if (m_segments.size() >= sweep_line_threshold) {
+                        return find_intersections_sweep_line(problem_reporter);
+                    }
+
                     uint32_t found_intersections = 0;
 
                     for (auto it1 = m_segments.cbegin(); it1 != m_segments.cend() - 1; ++it1) {
@@ -326,24 +455,12 @@ namespace osmium {
                         for (auto it2 = it1 + 1; it2 != m_segments.end(); ++it2) {
                             const NodeRefSegment& s2 = *it2;
 
-                            assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
-
                             if (outside_x_range(s2, s1)) {
                                 break;
                             }
 
-                            if (y_range_overlap(s1, s2)) {
-                                const osmium::Location intersection{calculate_intersection(s1, s2)};
-                                if (intersection) {
-                                    ++found_intersections;
-                                    if (m_debug) {
-                                        std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
-                                    }
-                                    if (problem_reporter) {
-                                        problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(),
-                                                                              s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
-                                    }
-                                }
+                            if (y_range_overlap(s1, s2) && check_intersection(s1, s2, problem_reporter)) {
+                                ++found_intersections;
                             }
                         }
                     }
@@ -353,6 +470,87 @@ namespace osmium {
 
             }; // class SegmentList
 
+            /**
+             * Index over the segments of a sorted SegmentList to quickly
+             * find all segments crossing a vertical line. It is an implicit
+             * binary tree over the segments in list order where each node
+             * holds the largest x coordinate of the second (right) end of
+             * the segments below it. Because the list is sorted by the first
+             * location of the segments, all segments up to some position
+             * start left of (or at) the x coordinate of the segment at that
+             * position. Subtrees that end before the line can be skipped
+             * completely, so finding the segments crossing the line is
+             * proportional to their number times the depth of the tree
+             * instead of the number of all segments.
+             */
+            class SegmentXIndex {
+
+                std::vector<int32_t> m_max_x;
+                std::size_t m_leaves = 0;
+                std::size_t m_size = 0;
+
+                template <typename TFunc>
+                void visit(std::size_t node, std::size_t begin, std::size_t end, std::size_t last, int32_t x, TFunc& func) const {
+                    if (begin > last || m_max_x[node] < x) {
+                        return;
+                    }
+                    if (end - begin == 1) {
+                        func(begin);
+                        return;
+                    }
+                    const std::size_t middle = begin + (end - begin) / 2;
+                    visit(2 * node + 1, middle, end, last, x, func);
+                    visit(2 * node, begin, middle, last, x, func);
+                }
+
+            public:
+
+                /**
+                 * Build the index. Must be called again whenever the
+                 * segment list changes.
+                 */
+                void build(const SegmentList& segments) {
+                    m_size = segments.size();
+                    m_leaves = 1;
+                    while (m_leaves < m_size) {
+                        m_leaves *= 2;
+                    }
+                    m_max_x.assign(2 * m_leaves, std::numeric_limits<int32_t>::min());
+                    for (std::size_t n = 0; n < m_size; ++n) {
+                        m_max_x[m_leaves + n] = segments[n].second().location().x();
+                    }
+                    for (std::size_t n = m_leaves - 1; n > 0; --n) {
+                        m_max_x[n] = std::max(m_max_x[2 * n], m_max_x[2 * n + 1]);
+                    }
+                }
+
+                void clear() noexcept {
+                    m_max_x.clear();
+                    m_leaves = 0;
+                    m_size = 0;
+                }
+
+                /// The number of segments in the index.
+                std::size_t size() const noexcept {
+                    return m_size;
+                }
+
+                /**
+                 * Call func(n) with the position n of all segments up to and
+                 * including position last whose second location has an x
+                 * coordinate of at least x. The segments are visited from
+                 * the highest to the lowest position.
+                 */
+                template <typename TFunc>
+                void for_each_reaching(std::size_t last, int32_t x, TFunc&& func) const {
+                    if (m_size == 0) {
+                        return;
+                    }
+                    visit(1, 0, m_leaves, last, x, func);
+                }
+
+            }; // class SegmentXIndex
+
         } // namespace detail
 
     } // namespace area
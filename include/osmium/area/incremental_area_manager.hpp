@@ -0,0 +1,415 @@
+#ifndef OSMIUM_AREA_INCREMENTAL_AREA_MANAGER_HPP
+#define OSMIUM_AREA_INCREMENTAL_AREA_MANAGER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/area/stats.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/index/multimap/sparse_mem_multimap.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/storage/item_stash.hpp>
+#include <osmium/tags/taglist.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        /**
+         * Result of IncrementalAreaManager::assemble_changed().
+         */
+        struct area_changes {
+
+            /**
+             * Ids of all areas that might have changed. Any existing area
+             * with one of these ids should be removed and replaced by the
+             * area with the same id in the buffer, if there is one.
+             */
+            std::vector<osmium::object_id_type> affected_area_ids{};
+
+            /// Buffer with the newly assembled areas.
+            osmium::memory::Buffer areas{1024, osmium::memory::Buffer::auto_grow::yes};
+
+        }; // struct area_changes
+
+        /**
+         * Keeps the data needed to build areas from closed ways and from
+         * multipolygon relations (type=multipolygon or type=boundary) in
+         * memory, so that the areas can be updated from change files
+         * without reading a full extract again.
+         *
+         * Use this as a handler. First feed it the full data (nodes, ways,
+         * and relations), then call assemble_changed() to build all areas.
+         * After that feed it the contents of change files and call
+         * assemble_changed() again to build only the areas affected by
+         * the changes. Deleted objects must have the visible flag set to
+         * false as is the case when reading .osc files.
+         *
+         * All ways are stored together with reverse indexes from nodes to
+         * ways and from ways to the multipolygon relations they are a
+         * member of. Node locations are written to the location index
+         * given to the constructor, the locations in the stored ways are
+         * updated from this index before an area is assembled. An area is
+         * re-assembled if the closed way or relation it was built from or
+         * any of its member ways or any of their nodes changed.
+         *
+         * Nodes with negative ids are ignored.
+         *
+         * @tparam TAssembler Area assembler class.
+         * @pre The Ids of all objects must be unique in the input data.
+         */
+        template <typename TAssembler>
+        class IncrementalAreaManager : public osmium::handler::Handler {
+
+        public:
+
+            using assembler_config_type = typename TAssembler::config_type;
+            using index_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+
+        private:
+
+            using handle_map_type = std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type>;
+            using reverse_index_type = osmium::index::multimap::SparseMemMultimap<osmium::unsigned_object_id_type, osmium::object_id_type>;
+
+            TAssembler m_assembler;
+            osmium::TagsFilter m_filter;
+            index_type& m_location_index;
+
+            osmium::ItemStash m_stash{};
+            handle_map_type m_ways{};
+            handle_map_type m_relations{};
+
+            reverse_index_type m_node_to_ways{};
+            reverse_index_type m_way_to_relations{};
+
+            std::set<osmium::object_id_type> m_changed_ways{};
+            std::set<osmium::object_id_type> m_changed_relations{};
+
+            area_stats m_stats{};
+
+            // Scratch buffer for copies of ways with updated locations.
+            osmium::memory::Buffer m_ways_buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+            // The reverse indexes need unsigned keys, negative ids are
+            // mapped to large numbers.
+            static osmium::unsigned_object_id_type key(const osmium::object_id_type id) noexcept {
+                return static_cast<osmium::unsigned_object_id_type>(id);
+            }
+
+            bool is_multipolygon(const osmium::Relation& relation) const {
+                const char* type = relation.tags().get_value_by_key("type");
+                if (type == nullptr) {
+                    return false;
+                }
+
+                if ((!std::strcmp(type, "multipolygon") || !std::strcmp(type, "boundary")) && osmium::tags::match_any_of(relation.tags(), m_filter)) {
+                    return std::any_of(relation.members().cbegin(), relation.members().cend(), [](const osmium::RelationMember& member) {
+                        return member.type() == osmium::item_type::way;
+                    });
+                }
+
+                return false;
+            }
+
+            const osmium::Way* find_way(const osmium::object_id_type id) const {
+                const auto it = m_ways.find(id);
+                if (it == m_ways.end()) {
+                    return nullptr;
+                }
+                return &m_stash.get<osmium::Way>(it->second);
+            }
+
+            const osmium::Relation* find_relation(const osmium::object_id_type id) const {
+                const auto it = m_relations.find(id);
+                if (it == m_relations.end()) {
+                    return nullptr;
+                }
+                return &m_stash.get<osmium::Relation>(it->second);
+            }
+
+            void remove_way(const osmium::object_id_type id) {
+                const auto it = m_ways.find(id);
+                if (it == m_ways.end()) {
+                    return;
+                }
+                for (const auto& node_ref : m_stash.get<osmium::Way>(it->second).nodes()) {
+                    m_node_to_ways.remove(key(node_ref.ref()), id);
+                }
+                m_stash.remove_item(it->second);
+                m_ways.erase(it);
+            }
+
+            // Returns true if the relation was stored.
+            bool remove_relation(const osmium::object_id_type id) {
+                const auto it = m_relations.find(id);
+                if (it == m_relations.end()) {
+                    return false;
+                }
+                for (const auto& member : m_stash.get<osmium::Relation>(it->second).members()) {
+                    if (member.ref() != 0) {
+                        m_way_to_relations.remove(key(member.ref()), id);
+                    }
+                }
+                m_stash.remove_item(it->second);
+                m_relations.erase(it);
+                return true;
+            }
+
+            // Copy the way into the scratch buffer and update the locations
+            // of its nodes from the location index. Returns the offset of
+            // the copy in the buffer.
+            std::size_t copy_way_with_locations(const osmium::Way& way) {
+                const auto offset = m_ways_buffer.committed();
+                m_ways_buffer.add_item(way);
+                m_ways_buffer.commit();
+                for (auto& node_ref : m_ways_buffer.get<osmium::Way>(offset).nodes()) {
+                    node_ref.set_location(node_ref.ref() < 0 ? osmium::Location{} :
+                        m_location_index.get_noexcept(static_cast<osmium::unsigned_object_id_type>(node_ref.ref())));
+                }
+                return offset;
+            }
+
+            void assemble_way(const osmium::Way& stored_way, osmium::memory::Buffer& out) {
+                // you need at least 4 nodes to make up a polygon
+                if (stored_way.nodes().size() <= 3 ||
+                    !stored_way.is_closed() ||
+                    stored_way.tags().has_tag("area", "no") ||
+                    osmium::tags::match_none_of(stored_way.tags(), m_filter)) {
+                    return;
+                }
+
+                m_ways_buffer.clear();
+                const auto& way = m_ways_buffer.get<osmium::Way>(copy_way_with_locations(stored_way));
+                if (!way.nodes().front().location() ||
+                    !way.nodes().back().location() ||
+                    !way.ends_have_same_location()) {
+                    return;
+                }
+
+                try {
+                    m_assembler(way, out);
+                    m_stats += m_assembler.stats();
+                } catch (const osmium::invalid_location&) {
+                    // XXX ignore
+                }
+            }
+
+            void assemble_relation(const osmium::Relation& relation, osmium::memory::Buffer& out) {
+                m_ways_buffer.clear();
+
+                std::vector<std::size_t> offsets;
+                offsets.reserve(relation.members().size());
+                for (const auto& member : relation.members()) {
+                    if (member.ref() != 0) {
+                        const osmium::Way* way = find_way(member.ref());
+                        if (!way) {
+                            return; // relation is incomplete
+                        }
+                        offsets.push_back(copy_way_with_locations(*way));
+                    }
+                }
+
+                std::vector<const osmium::Way*> ways;
+                ways.reserve(offsets.size());
+                for (const auto offset : offsets) {
+                    ways.push_back(&m_ways_buffer.get<osmium::Way>(offset));
+                }
+
+                try {
+                    m_assembler(relation, ways, out);
+                    m_stats += m_assembler.stats();
+                } catch (const osmium::invalid_location&) {
+                    // XXX ignore
+                }
+            }
+
+        public:
+
+            /**
+             * Construct an IncrementalAreaManager.
+             *
+             * @param assembler_config The configuration for the area
+             *                         assembler.
+             * @param location_index The index used for the node locations.
+             *                       Its set() must overwrite existing
+             *                       values.
+             * @param filter An optional filter specifying what tags are
+             *               needed on closed ways or multipolygon relations
+             *               to build the area.
+             */
+            IncrementalAreaManager(const assembler_config_type& assembler_config, index_type& location_index, osmium::TagsFilter filter = osmium::TagsFilter{true}) :
+                m_assembler(assembler_config),
+                m_filter(std::move(filter)),
+                m_location_index(location_index) {
+            }
+
+            /**
+             * Access the aggregated statistics generated by the assembler.
+             */
+            const area_stats& stats() const noexcept {
+                return m_stats;
+            }
+
+            /// The number of ways currently stored.
+            std::size_t num_ways() const noexcept {
+                return m_ways.size();
+            }
+
+            /// The number of multipolygon relations currently stored.
+            std::size_t num_relations() const noexcept {
+                return m_relations.size();
+            }
+
+            /**
+             * Return an estimate of the number of bytes used for the stored
+             * objects and indexes, not including the location index.
+             */
+            std::size_t used_memory() const noexcept {
+                return m_stash.used_memory() +
+                       m_node_to_ways.used_memory() +
+                       m_way_to_relations.used_memory() +
+                       (m_ways.size() + m_relations.size()) * (sizeof(handle_map_type::value_type) + sizeof(void*));
+            }
+
+            void node(const osmium::Node& node) {
+                if (node.id() < 0) {
+                    return;
+                }
+                m_location_index.set(static_cast<osmium::unsigned_object_id_type>(node.id()),
+                                     node.visible() ? node.location() : osmium::index::empty_value<osmium::Location>());
+                const auto ways = m_node_to_ways.get_all(key(node.id()));
+                for (auto it = ways.first; it != ways.second; ++it) {
+                    m_changed_ways.insert(it->second);
+                }
+            }
+
+            void way(const osmium::Way& way) {
+                remove_way(way.id());
+                m_changed_ways.insert(way.id());
+
+                if (!way.visible()) {
+                    return;
+                }
+
+                m_ways.emplace(way.id(), m_stash.add_item(way));
+                for (const auto& node_ref : way.nodes()) {
+                    m_node_to_ways.set(key(node_ref.ref()), way.id());
+                }
+            }
+
+            void relation(const osmium::Relation& relation) {
+                if (remove_relation(relation.id())) {
+                    m_changed_relations.insert(relation.id());
+                }
+
+                if (!relation.visible() || !is_multipolygon(relation)) {
+                    return;
+                }
+
+                m_changed_relations.insert(relation.id());
+
+                const auto handle = m_stash.add_item(relation);
+                m_relations.emplace(relation.id(), handle);
+
+                // Set ids of members which are not ways to zero, the
+                // assembler will ignore them.
+                for (auto& member : m_stash.get<osmium::Relation>(handle).members()) {
+                    if (member.type() == osmium::item_type::way) {
+                        m_way_to_relations.set(key(member.ref()), relation.id());
+                    } else {
+                        member.set_ref(0);
+                    }
+                }
+            }
+
+            /**
+             * Assemble all areas affected by the objects seen since the
+             * last call. Areas from closed ways come first, ordered by way
+             * id, followed by the areas from relations ordered by relation
+             * id.
+             */
+            area_changes assemble_changed() {
+                area_changes changes;
+
+                std::set<osmium::object_id_type> relations;
+                relations.swap(m_changed_relations);
+                for (const auto id : m_changed_ways) {
+                    const auto parents = m_way_to_relations.get_all(key(id));
+                    for (auto it = parents.first; it != parents.second; ++it) {
+                        relations.insert(it->second);
+                    }
+                }
+
+                for (const auto id : m_changed_ways) {
+                    changes.affected_area_ids.push_back(osmium::object_id_to_area_id(id, osmium::item_type::way));
+                    if (const osmium::Way* way = find_way(id)) {
+                        assemble_way(*way, changes.areas);
+                    }
+                }
+                m_changed_ways.clear();
+
+                for (const auto id : relations) {
+                    changes.affected_area_ids.push_back(osmium::object_id_to_area_id(id, osmium::item_type::relation));
+                    if (const osmium::Relation* relation = find_relation(id)) {
+                        assemble_relation(*relation, changes.areas);
+                    }
+                }
+
+                return changes;
+            }
+
+        }; // class IncrementalAreaManager
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_INCREMENTAL_AREA_MANAGER_HPP
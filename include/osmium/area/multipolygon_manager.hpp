@@ -33,8 +33,13 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/area/assembler_config.hpp>
+#include <osmium/area/problem_recorder.hpp>
 #include <osmium/area/stats.hpp>
+#include <osmium/area/timing_stats.hpp>
+#include <osmium/memory/buffer.hpp>
 #include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/tag.hpp>
 #include <osmium/osm/way.hpp>
@@ -45,12 +50,17 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/storage/item_stash.hpp>
 #include <osmium/tags/taglist.hpp>
 #include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <deque>
+#include <future>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -60,6 +70,143 @@ namespace osmium {
      */
     namespace area {
 
+        namespace detail {
+
+            /**
+             * Add statistics from an assembler run. Timings are only
+             * recorded if they are collected by the assembler.
+             */
+            inline void add_assembler_stats(const AssemblerConfig& config, area_stats& stats, area_timing_stats& timings, const osmium::OSMObject& object, const area_stats& assembler_stats) {
+                stats += assembler_stats;
+                if (config.collect_timings) {
+                    timings.add(object.type(), object.id(), assembler_stats);
+                }
+            }
+
+            /**
+             * Areas assembled from a batch of relations in a worker thread
+             * together with the statistics of the assemblers and the
+             * problems they found.
+             */
+            struct assembled_batch {
+
+                osmium::memory::Buffer buffer;
+                area_stats stats{};
+                area_timing_stats timings{};
+                ProblemRecorder problems{};
+
+                explicit assembled_batch(std::size_t initial_buffer_size) :
+                    buffer(initial_buffer_size, osmium::memory::Buffer::auto_grow::yes) {
+                }
+
+            }; // struct assembled_batch
+
+            /**
+             * Get the config for an assembler running in a worker thread.
+             * Problems are recorded in the batch result instead of being
+             * reported directly, they are replayed into the problem
+             * reporter from the config in the main thread.
+             */
+            template <typename TConfig>
+            TConfig worker_config(const TConfig& config, assembled_batch& result) {
+                TConfig new_config{config};
+                if (new_config.problem_reporter) {
+                    new_config.problem_reporter = &result.problems;
+                }
+                return new_config;
+            }
+
+            /**
+             * Task for the thread pool assembling all relations in a batch.
+             * The batch buffer contains copies of the relations each
+             * followed by the member ways needed to assemble it.
+             */
+            template <typename TAssembler>
+            class assemble_relation_batch_task {
+
+                typename TAssembler::config_type m_config;
+                osmium::memory::Buffer m_batch;
+
+                static void assemble(const typename TAssembler::config_type& config, TAssembler& assembler, const osmium::Relation* relation, const std::vector<const osmium::Way*>& ways, assembled_batch& result) {
+                    if (!relation) {
+                        return;
+                    }
+                    try {
+                        assembler(*relation, ways, result.buffer);
+                        add_assembler_stats(config, result.stats, result.timings, *relation, assembler.stats());
+                    } catch (const osmium::invalid_location&) {
+                        // XXX ignore
+                    }
+                }
+
+            public:
+
+                assemble_relation_batch_task(const typename TAssembler::config_type& config, osmium::memory::Buffer&& batch) :
+                    m_config(config),
+                    m_batch(std::move(batch)) {
+                }
+
+                assembled_batch operator()() const {
+                    assembled_batch result{m_batch.committed()};
+                    const auto config = worker_config(m_config, result);
+                    TAssembler assembler{config};
+
+                    const osmium::Relation* relation = nullptr;
+                    std::vector<const osmium::Way*> ways;
+                    for (const auto& item : m_batch) {
+                        if (item.type() == osmium::item_type::relation) {
+                            assemble(config, assembler, relation, ways, result);
+                            relation = static_cast<const osmium::Relation*>(&item);
+                            ways.clear();
+                        } else {
+                            ways.push_back(static_cast<const osmium::Way*>(&item));
+                        }
+                    }
+                    assemble(config, assembler, relation, ways, result);
+
+                    return result;
+                }
+
+            }; // class assemble_relation_batch_task
+
+            /**
+             * Task for the thread pool assembling areas from all closed ways
+             * in a batch.
+             */
+            template <typename TAssembler>
+            class assemble_way_batch_task {
+
+                typename TAssembler::config_type m_config;
+                osmium::memory::Buffer m_batch;
+
+            public:
+
+                assemble_way_batch_task(const typename TAssembler::config_type& config, osmium::memory::Buffer&& batch) :
+                    m_config(config),
+                    m_batch(std::move(batch)) {
+                }
+
+                assembled_batch operator()() const {
+                    assembled_batch result{m_batch.committed()};
+                    const auto config = worker_config(m_config, result);
+                    TAssembler assembler{config};
+
+                    for (const auto& way : m_batch.select<osmium::Way>()) {
+                        try {
+                            assembler(way, result.buffer);
+                            add_assembler_stats(config, result.stats, result.timings, way, assembler.stats());
+                        } catch (const osmium::invalid_location&) {
+                            // XXX ignore
+                        }
+                    }
+
+                    return result;
+                }
+
+            }; // class assemble_way_batch_task
+
+        } // namespace detail
+
         /**
          * This class collects all data needed for creating areas from
          * relations tagged with type=multipolygon or type=boundary.
@@ -67,7 +214,9 @@ namespace osmium {
          * osmium::relations::RelationsManager.
          *
          * The actual assembling of the areas is done by the assembler
-         * class given as template argument.
+         * class given as template argument. One assembler object is used
+         * for all areas, so it must reset its state whenever it is called. Call enable_parallel_assembly()
+         * to assemble the areas from relations in a thread pool.
          *
          * @tparam TAssembler Multipolygon Assembler class.
          * @pre The Ids of all objects must be unique in the input data.
@@ -78,10 +227,97 @@ namespace osmium {
             using assembler_config_type = typename TAssembler::config_type;
             const assembler_config_type m_assembler_config;
 
+            // The assembler is re-used for all areas, so that the memory
+            // it allocates internally can be re-used.
+            TAssembler m_assembler;
+
             area_stats m_stats;
+            area_timing_stats m_timing_stats{};
 
             osmium::TagsFilter m_filter;
 
+            osmium::thread::Pool* m_pool = nullptr;
+            std::size_t m_batch_size = 0;
+            std::size_t m_relation_batch_count = 0;
+            std::size_t m_way_batch_count = 0;
+            osmium::memory::Buffer m_relation_batch{};
+            osmium::memory::Buffer m_way_batch{};
+            std::deque<std::future<detail::assembled_batch>> m_pending{};
+
+            void add_assembled_batch(detail::assembled_batch&& result) {
+                if (!result.problems.empty()) {
+                    result.problems.replay(*m_assembler_config.problem_reporter);
+                }
+                m_stats += result.stats;
+                m_timing_stats += result.timings;
+                if (result.buffer.committed() > 0) {
+                    this->buffer().add_buffer(result.buffer);
+                    this->buffer().commit();
+                    this->possibly_flush();
+                }
+            }
+
+            // Add results of finished batches to the output in the order
+            // the batches were submitted. If wait is set, wait for all
+            // batches, otherwise only until there are no more than twice
+            // as many batches pending as there are threads.
+            void collect_batches(bool wait) {
+                const auto max_pending = wait ? 0 : 2 * static_cast<std::size_t>(m_pool->num_threads());
+                while (!m_pending.empty()) {
+                    auto& future = m_pending.front();
+                    if (m_pending.size() <= max_pending &&
+                        future.wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
+                        break;
+                    }
+                    add_assembled_batch(future.get());
+                    m_pending.pop_front();
+                }
+            }
+
+            template <typename TTask>
+            void submit_batch(osmium::memory::Buffer& batch, std::size_t& count) {
+                if (count == 0) {
+                    return;
+                }
+                m_pending.push_back(m_pool->submit(TTask{m_assembler_config, std::move(batch)}));
+                batch = osmium::memory::Buffer{};
+                count = 0;
+                collect_batches(false);
+            }
+
+            void submit_relation_batch() {
+                submit_batch<detail::assemble_relation_batch_task<TAssembler>>(m_relation_batch, m_relation_batch_count);
+            }
+
+            void submit_way_batch() {
+                submit_batch<detail::assemble_way_batch_task<TAssembler>>(m_way_batch, m_way_batch_count);
+            }
+
+            static void add_to_batch(osmium::memory::Buffer& batch, const osmium::memory::Item& item) {
+                if (!batch) {
+                    batch = osmium::memory::Buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+                }
+                batch.add_item(item);
+                batch.commit();
+            }
+
+            void add_to_relation_batch(const osmium::Relation& relation, const std::vector<const osmium::Way*>& ways) {
+                add_to_batch(m_relation_batch, relation);
+                for (const auto* way : ways) {
+                    add_to_batch(m_relation_batch, *way);
+                }
+                if (++m_relation_batch_count >= m_batch_size) {
+                    submit_relation_batch();
+                }
+            }
+
+            void add_to_way_batch(const osmium::Way& way) {
+                add_to_batch(m_way_batch, way);
+                if (++m_way_batch_count >= m_batch_size) {
+                    submit_way_batch();
+                }
+            }
+
         public:
 
             /**
@@ -89,13 +325,29 @@ namespace osmium {
              *
              * @param assembler_config The configuration that will be given to
              *                         any newly constructed area assembler.
+             *                         If create_old_style_polygons is not
+             *                         set, member ways are stored without
+             *                         tags and metadata and, if
+             *                         compress_member_ways is set, with
+             *                         compressed node lists.
              * @param filter An optional filter specifying what tags are
              *               needed on closed ways or multipolygon relations
              *               to build the area.
              */
             explicit MultipolygonManager(assembler_config_type assembler_config, osmium::TagsFilter filter = osmium::TagsFilter{true}) :
                 m_assembler_config(std::move(assembler_config)),
+                m_assembler(m_assembler_config),
                 m_filter(std::move(filter)) {
+                // Tags on member ways are only needed for old-style
+                // multipolygons, so without them only the node references
+                // of the member ways have to be stored.
+                if (!m_assembler_config.create_old_style_polygons) {
+                    if (m_assembler_config.compress_member_ways) {
+                        this->member_ways_database().use_compressed_way_nodes();
+                    } else {
+                        this->member_ways_database().use_lean_storage();
+                    }
+                }
             }
 
             /**
@@ -106,6 +358,56 @@ namespace osmium {
                 return m_stats;
             }
 
+            /**
+             * Access the aggregated timings of the assemblers called from
+             * the manager. This is only filled if collect_timings is set
+             * in the assembler config. If areas are assembled in parallel,
+             * the timings are complete after the output was flushed.
+             */
+            const area_timing_stats& timing_stats() const noexcept {
+                return m_timing_stats;
+            }
+
+            /**
+             * Assemble areas in the thread pool. Completed relations are
+             * copied together with their member ways into batches, closed
+             * ways are copied into separate batches. Each batch is
+             * assembled by its own assembler in a worker thread. The
+             * resulting areas are added to the output in the order in
+             * which the batches were created, so the output is
+             * deterministic, but areas will appear later in the output
+             * than they would without this option and areas from ways and
+             * relations are not interleaved in the same way.
+             *
+             * Call this before the second pass. All areas are available
+             * after the output was flushed. If a problem reporter is set in
+             * the assembler config, the problems are recorded in the worker
+             * threads and reported from the main thread when the areas
+             * from a batch are added to the output, so the problem reporter
+             * doesn't have to be thread safe.
+             *
+             * @param pool The thread pool to use.
+             * @param batch_size Number of relations or ways assembled
+             *                   together in one task.
+             */
+            void enable_parallel_assembly(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(), std::size_t batch_size = 100) {
+                m_pool = &pool;
+                m_batch_size = batch_size > 0 ? batch_size : 1;
+            }
+
+            /**
+             * Assemble all batches of relations still pending and add the
+             * areas to the output buffer. This is called automatically
+             * when the output is flushed or read.
+             */
+            void before_flush() {
+                if (m_pool) {
+                    submit_relation_batch();
+                    submit_way_batch();
+                    collect_batches(true);
+                }
+            }
+
             /**
              * We are interested in all relations tagged with type=multipolygon
              * or type=boundary with at least one way member.
@@ -142,10 +444,14 @@ namespace osmium {
                     }
                 }
 
+                if (m_pool) {
+                    add_to_relation_batch(relation, ways);
+                    return;
+                }
+
                 try {
-                    TAssembler assembler{m_assembler_config};
-                    assembler(relation, ways, this->buffer());
-                    m_stats += assembler.stats();
+                    m_assembler(relation, ways, this->buffer());
+                    detail::add_assembler_stats(m_assembler_config, m_stats, m_timing_stats, relation, m_assembler.stats());
                 } catch (const osmium::invalid_location&) {
                     // XXX ignore
                 }
@@ -170,9 +476,13 @@ namespace osmium {
                             return;
                         }
 
-                        TAssembler assembler{m_assembler_config};
-                        assembler(way, this->buffer());
-                        m_stats += assembler.stats();
+                        if (m_pool) {
+                            add_to_way_batch(way);
+                            return;
+                        }
+
+                        m_assembler(way, this->buffer());
+                        detail::add_assembler_stats(m_assembler_config, m_stats, m_timing_stats, way, m_assembler.stats());
                         this->possibly_flush();
                     }
                 } catch (const osmium::invalid_location&) {
@@ -0,0 +1,305 @@
+#ifndef OSMIUM_AREA_PROBLEM_RECORDER_HPP
+#define OSMIUM_AREA_PROBLEM_RECORDER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/area/problem_reporter.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        /**
+         * A problem reporter that doesn't report the problems anywhere,
+         * but records them in a compact form, so that they can be
+         * replayed into another problem reporter later.
+         *
+         * Use one recorder per thread, for instance one per task when
+         * assembling areas in a thread pool, and replay the recorded
+         * problems into the real reporter from a single thread. This
+         * also allows writing many problems in one go, for instance into
+         * an OGR dataset inside a large transaction.
+         *
+         * The MultipolygonManager does this automatically when areas are
+         * assembled in parallel.
+         */
+        class ProblemRecorder : public ProblemReporter {
+
+            enum class problem_type : uint8_t {
+                duplicate_node,
+                touching_ring,
+                intersection,
+                duplicate_segment,
+                overlapping_segment,
+                ring_not_closed,
+                role_should_be_outer,
+                role_should_be_inner,
+                way_in_multiple_rings,
+                inner_with_same_tags,
+                invalid_location,
+                duplicate_way,
+                way
+            }; // enum class problem_type
+
+            enum : std::size_t {
+                no_way = std::numeric_limits<std::size_t>::max()
+            };
+
+            struct problem {
+                osmium::object_id_type object_id;
+                osmium::object_id_type id1;
+                osmium::object_id_type id2;
+                std::size_t nodes;
+
+                // Index of the first location of this problem in
+                // m_locations. The number of locations depends on the
+                // problem type.
+                std::size_t locations;
+
+                // Offset of the way in m_ways or no_way.
+                std::size_t way;
+
+                osmium::item_type object_type;
+                problem_type type;
+            }; // struct problem
+
+            std::vector<problem> m_problems;
+            std::vector<osmium::Location> m_locations;
+            osmium::memory::Buffer m_ways{1024, osmium::memory::Buffer::auto_grow::yes};
+
+            void add(problem_type type, osmium::object_id_type id1, osmium::object_id_type id2, const osmium::Way* way = nullptr) {
+                std::size_t way_offset = no_way;
+                if (way) {
+                    way_offset = m_ways.committed();
+                    m_ways.add_item(*way);
+                    m_ways.commit();
+                }
+                m_problems.push_back(problem{m_object_id, id1, id2, m_nodes, m_locations.size(), way_offset, m_object_type, type});
+            }
+
+            const osmium::Way& get_way(const problem& p) const {
+                return m_ways.get<const osmium::Way>(p.way);
+            }
+
+        public:
+
+            ProblemRecorder() = default;
+
+            /**
+             * Is this recorder empty?
+             */
+            bool empty() const noexcept {
+                return m_problems.empty();
+            }
+
+            /**
+             * The number of problems recorded.
+             */
+            std::size_t size() const noexcept {
+                return m_problems.size();
+            }
+
+            /**
+             * Remove all recorded problems.
+             */
+            void clear() {
+                m_problems.clear();
+                m_locations.clear();
+                m_ways.clear();
+            }
+
+            /**
+             * Add all problems recorded in another recorder after the
+             * problems in this one.
+             */
+            void append(const ProblemRecorder& other) {
+                const std::size_t locations_offset = m_locations.size();
+                const std::size_t ways_offset = m_ways.committed();
+
+                m_locations.insert(m_locations.end(), other.m_locations.begin(), other.m_locations.end());
+                if (other.m_ways.committed() > 0) {
+                    m_ways.add_buffer(other.m_ways);
+                    m_ways.commit();
+                }
+
+                m_problems.reserve(m_problems.size() + other.m_problems.size());
+                for (auto p : other.m_problems) {
+                    p.locations += locations_offset;
+                    if (p.way != no_way) {
+                        p.way += ways_offset;
+                    }
+                    m_problems.push_back(p);
+                }
+            }
+
+            /**
+             * Report all recorded problems to the given reporter in the
+             * order they were recorded.
+             */
+            void replay(ProblemReporter& reporter) const {
+                for (const auto& p : m_problems) {
+                    reporter.set_object(p.object_type, p.object_id);
+                    reporter.set_nodes(p.nodes);
+                    const osmium::Location* loc = m_locations.data() + p.locations;
+                    switch (p.type) {
+                        case problem_type::duplicate_node:
+                            reporter.report_duplicate_node(p.id1, p.id2, loc[0]);
+                            break;
+                        case problem_type::touching_ring:
+                            reporter.report_touching_ring(p.id1, loc[0]);
+                            break;
+                        case problem_type::intersection:
+                            reporter.report_intersection(p.id1, loc[0], loc[1], p.id2, loc[2], loc[3], loc[4]);
+                            break;
+                        case problem_type::duplicate_segment:
+                            reporter.report_duplicate_segment(osmium::NodeRef{p.id1, loc[0]}, osmium::NodeRef{p.id2, loc[1]});
+                            break;
+                        case problem_type::overlapping_segment:
+                            reporter.report_overlapping_segment(osmium::NodeRef{p.id1, loc[0]}, osmium::NodeRef{p.id2, loc[1]});
+                            break;
+                        case problem_type::ring_not_closed:
+                            reporter.report_ring_not_closed(osmium::NodeRef{p.id1, loc[0]}, p.way == no_way ? nullptr : &get_way(p));
+                            break;
+                        case problem_type::role_should_be_outer:
+                            reporter.report_role_should_be_outer(p.id1, loc[0], loc[1]);
+                            break;
+                        case problem_type::role_should_be_inner:
+                            reporter.report_role_should_be_inner(p.id1, loc[0], loc[1]);
+                            break;
+                        case problem_type::way_in_multiple_rings:
+                            reporter.report_way_in_multiple_rings(get_way(p));
+                            break;
+                        case problem_type::inner_with_same_tags:
+                            reporter.report_inner_with_same_tags(get_way(p));
+                            break;
+                        case problem_type::invalid_location:
+                            reporter.report_invalid_location(p.id1, p.id2);
+                            break;
+                        case problem_type::duplicate_way:
+                            reporter.report_duplicate_way(get_way(p));
+                            break;
+                        case problem_type::way:
+                            reporter.report_way(get_way(p));
+                            break;
+                    }
+                }
+            }
+
+            void report_duplicate_node(osmium::object_id_type node_id1, osmium::object_id_type node_id2, osmium::Location location) override {
+                add(problem_type::duplicate_node, node_id1, node_id2);
+                m_locations.push_back(location);
+            }
+
+            void report_touching_ring(osmium::object_id_type node_id, osmium::Location location) override {
+                add(problem_type::touching_ring, node_id, 0);
+                m_locations.push_back(location);
+            }
+
+            void report_intersection(osmium::object_id_type way1_id, osmium::Location way1_seg_start, osmium::Location way1_seg_end,
+                                     osmium::object_id_type way2_id, osmium::Location way2_seg_start, osmium::Location way2_seg_end, osmium::Location intersection) override {
+                add(problem_type::intersection, way1_id, way2_id);
+                m_locations.push_back(way1_seg_start);
+                m_locations.push_back(way1_seg_end);
+                m_locations.push_back(way2_seg_start);
+                m_locations.push_back(way2_seg_end);
+                m_locations.push_back(intersection);
+            }
+
+            void report_duplicate_segment(const osmium::NodeRef& nr1, const osmium::NodeRef& nr2) override {
+                add(problem_type::duplicate_segment, nr1.ref(), nr2.ref());
+                m_locations.push_back(nr1.location());
+                m_locations.push_back(nr2.location());
+            }
+
+            void report_overlapping_segment(const osmium::NodeRef& nr1, const osmium::NodeRef& nr2) override {
+                add(problem_type::overlapping_segment, nr1.ref(), nr2.ref());
+                m_locations.push_back(nr1.location());
+                m_locations.push_back(nr2.location());
+            }
+
+            void report_ring_not_closed(const osmium::NodeRef& nr, const osmium::Way* way) override {
+                add(problem_type::ring_not_closed, nr.ref(), 0, way);
+                m_locations.push_back(nr.location());
+            }
+
+            void report_role_should_be_outer(osmium::object_id_type way_id, osmium::Location seg_start, osmium::Location seg_end) override {
+                add(problem_type::role_should_be_outer, way_id, 0);
+                m_locations.push_back(seg_start);
+                m_locations.push_back(seg_end);
+            }
+
+            void report_role_should_be_inner(osmium::object_id_type way_id, osmium::Location seg_start, osmium::Location seg_end) override {
+                add(problem_type::role_should_be_inner, way_id, 0);
+                m_locations.push_back(seg_start);
+                m_locations.push_back(seg_end);
+            }
+
+            void report_way_in_multiple_rings(const osmium::Way& way) override {
+                add(problem_type::way_in_multiple_rings, way.id(), 0, &way);
+            }
+
+            void report_inner_with_same_tags(const osmium::Way& way) override {
+                add(problem_type::inner_with_same_tags, way.id(), 0, &way);
+            }
+
+            void report_invalid_location(osmium::object_id_type way_id, osmium::object_id_type node_id) override {
+                add(problem_type::invalid_location, way_id, node_id);
+            }
+
+            void report_duplicate_way(const osmium::Way& way) override {
+                add(problem_type::duplicate_way, way.id(), 0, &way);
+            }
+
+            void report_way(const osmium::Way& way) override {
+                add(problem_type::way, way.id(), 0, &way);
+            }
+
+        }; // class ProblemRecorder
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_PROBLEM_RECORDER_HPP
@@ -63,6 +63,12 @@ namespace osmium {
         /**
          * Report problems when assembling areas by adding them to
          * layers in an OGR datasource.
+         *
+         * Every problem is written as a separate feature. For most
+         * drivers this is only fast inside transactions, so enable them
+         * with dataset.enable_auto_transactions(). Use a ProblemRecorder
+         * to collect the problems from several threads and replay them
+         * into this reporter in batches.
          */
         class ProblemReporterOGR : public ProblemReporter {
 
@@ -72,6 +72,17 @@ namespace osmium {
             uint64_t wrong_role = 0; ///< Member has wrong role (not "outer", "inner", or empty)
             uint64_t invalid_locations = 0; ///< Invalid location found
 
+            // Time spent in the different phases of the assembly. Only
+            // measured if AssemblerConfig::collect_timings is set.
+            uint64_t sort_nanoseconds = 0; ///< Sorting segments
+            uint64_t duplicates_nanoseconds = 0; ///< Removing duplicate segments
+            uint64_t intersections_nanoseconds = 0; ///< Finding intersections
+            uint64_t locations_nanoseconds = 0; ///< Creating locations list
+            uint64_t split_locations_nanoseconds = 0; ///< Finding split locations
+            uint64_t rings_nanoseconds = 0; ///< Creating rings
+            uint64_t roles_nanoseconds = 0; ///< Checking roles
+            uint64_t total_nanoseconds = 0; ///< Whole assembly
+
             area_stats& operator+=(const area_stats& other) noexcept {
                 area_really_complex_case += other.area_really_complex_case;
                 area_simple_case += other.area_simple_case;
@@ -90,12 +101,21 @@ namespace osmium {
                 nodes += other.nodes;
                 open_rings += other.open_rings;
                 outer_rings += other.outer_rings;
+                overlapping_segments += other.overlapping_segments;
                 short_ways += other.short_ways;
                 single_way_in_mp_relation += other.single_way_in_mp_relation;
                 touching_rings += other.touching_rings;
                 ways_in_multiple_rings += other.ways_in_multiple_rings;
                 wrong_role += other.wrong_role;
-                invalid_locations += invalid_locations;
+                invalid_locations += other.invalid_locations;
+                sort_nanoseconds += other.sort_nanoseconds;
+                duplicates_nanoseconds += other.duplicates_nanoseconds;
+                intersections_nanoseconds += other.intersections_nanoseconds;
+                locations_nanoseconds += other.locations_nanoseconds;
+                split_locations_nanoseconds += other.split_locations_nanoseconds;
+                rings_nanoseconds += other.rings_nanoseconds;
+                roles_nanoseconds += other.roles_nanoseconds;
+                total_nanoseconds += other.total_nanoseconds;
                 return *this;
             }
 
@@ -125,7 +145,15 @@ namespace osmium {
                        << " touching_rings=" << s.touching_rings
                        << " ways_in_multiple_rings=" << s.ways_in_multiple_rings
                        << " wrong_role=" << s.wrong_role
-                       << " invalid_locations=" << s.invalid_locations;
+                       << " invalid_locations=" << s.invalid_locations
+                       << " sort_nanoseconds=" << s.sort_nanoseconds
+                       << " duplicates_nanoseconds=" << s.duplicates_nanoseconds
+                       << " intersections_nanoseconds=" << s.intersections_nanoseconds
+                       << " locations_nanoseconds=" << s.locations_nanoseconds
+                       << " split_locations_nanoseconds=" << s.split_locations_nanoseconds
+                       << " rings_nanoseconds=" << s.rings_nanoseconds
+                       << " roles_nanoseconds=" << s.roles_nanoseconds
+                       << " total_nanoseconds=" << s.total_nanoseconds;
         }
 
     } // namespace area
@@ -0,0 +1,213 @@
+#ifndef OSMIUM_AREA_TIMING_STATS_HPP
+#define OSMIUM_AREA_TIMING_STATS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/area/stats.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        /**
+         * Timing of the assembly of one area.
+         */
+        struct area_timing {
+
+            osmium::item_type type; ///< Type of the object the area was created from
+            osmium::object_id_type id; ///< Id of the object the area was created from
+            uint64_t segments; ///< Number of segments in the area
+            uint64_t nanoseconds; ///< Time needed for the assembly
+
+            area_timing(osmium::item_type t, osmium::object_id_type i, uint64_t s, uint64_t ns) noexcept :
+                type(t),
+                id(i),
+                segments(s),
+                nanoseconds(ns) {
+            }
+
+        }; // struct area_timing
+
+        inline bool operator>(const area_timing& lhs, const area_timing& rhs) noexcept {
+            return lhs.nanoseconds > rhs.nanoseconds;
+        }
+
+        /**
+         * Aggregated timings of area assemblies. Use this with assemblers
+         * configured with AssemblerConfig::collect_timings set, otherwise
+         * all times will be zero.
+         *
+         * Contains the sum of the area_stats of all assemblies (including
+         * the time spent in the different phases), a histogram with the
+         * number of areas and total time by number of segments on a log
+         * scale, and the slowest areas.
+         */
+        class area_timing_stats {
+
+        public:
+
+            enum : std::size_t {
+                num_buckets = 32
+            };
+
+        private:
+
+            area_stats m_stats{};
+            std::array<uint64_t, num_buckets> m_count{};
+            std::array<uint64_t, num_buckets> m_nanoseconds{};
+
+            std::size_t m_max_slowest;
+
+            // Min-heap of the slowest areas
+            std::vector<area_timing> m_slowest{};
+
+            void add_slowest(const area_timing& timing) {
+                if (m_max_slowest == 0) {
+                    return;
+                }
+                if (m_slowest.size() < m_max_slowest) {
+                    m_slowest.push_back(timing);
+                    std::push_heap(m_slowest.begin(), m_slowest.end(), std::greater<area_timing>{});
+                } else if (timing > m_slowest.front()) {
+                    std::pop_heap(m_slowest.begin(), m_slowest.end(), std::greater<area_timing>{});
+                    m_slowest.back() = timing;
+                    std::push_heap(m_slowest.begin(), m_slowest.end(), std::greater<area_timing>{});
+                }
+            }
+
+        public:
+
+            /**
+             * Construct timing statistics.
+             *
+             * @param max_slowest The number of slowest areas to remember.
+             */
+            explicit area_timing_stats(std::size_t max_slowest = 10) :
+                m_max_slowest(max_slowest) {
+            }
+
+            /**
+             * The histogram bucket for an area with the given number of
+             * segments. Bucket n contains areas with 2^n to 2^(n+1)-1
+             * segments, bucket 0 also contains areas without segments.
+             */
+            static std::size_t bucket(uint64_t segments) noexcept {
+                std::size_t n = 0;
+                while (segments > 1 && n < num_buckets - 1) {
+                    segments >>= 1U;
+                    ++n;
+                }
+                return n;
+            }
+
+            /**
+             * Add the statistics from one run of an assembler.
+             *
+             * @param type Type of the object the area was created from.
+             * @param id Id of the object the area was created from.
+             * @param stats Statistics of the assembler run.
+             */
+            void add(osmium::item_type type, osmium::object_id_type id, const area_stats& stats) {
+                m_stats += stats;
+                const auto n = bucket(stats.nodes);
+                ++m_count[n];
+                m_nanoseconds[n] += stats.total_nanoseconds;
+                add_slowest(area_timing{type, id, stats.nodes, stats.total_nanoseconds});
+            }
+
+            area_timing_stats& operator+=(const area_timing_stats& other) {
+                m_stats += other.m_stats;
+                for (std::size_t n = 0; n < num_buckets; ++n) {
+                    m_count[n] += other.m_count[n];
+                    m_nanoseconds[n] += other.m_nanoseconds[n];
+                }
+                for (const auto& timing : other.m_slowest) {
+                    add_slowest(timing);
+                }
+                return *this;
+            }
+
+            /// Sum of the statistics of all assembler runs.
+            const area_stats& stats() const noexcept {
+                return m_stats;
+            }
+
+            /// Number of areas in the given histogram bucket.
+            uint64_t count(std::size_t bucket) const noexcept {
+                return m_count[bucket];
+            }
+
+            /// Total time for all areas in the given histogram bucket.
+            uint64_t nanoseconds(std::size_t bucket) const noexcept {
+                return m_nanoseconds[bucket];
+            }
+
+            /// The slowest areas, slowest first.
+            std::vector<area_timing> slowest() const {
+                std::vector<area_timing> result{m_slowest};
+                std::sort(result.begin(), result.end(), std::greater<area_timing>{});
+                return result;
+            }
+
+        }; // class area_timing_stats
+
+        template <typename TChar, typename TTraits>
+        inline std::basic_ostream<TChar, TTraits>& operator<<(std::basic_ostream<TChar, TTraits>& out, const area_timing_stats& timing_stats) {
+            out << "segments areas nanoseconds\n";
+            for (std::size_t n = 0; n < area_timing_stats::num_buckets; ++n) {
+                if (timing_stats.count(n) > 0) {
+                    out << (1ULL << n) << ' ' << timing_stats.count(n) << ' ' << timing_stats.nanoseconds(n) << '\n';
+                }
+            }
+            out << "slowest:\n";
+            for (const auto& timing : timing_stats.slowest()) {
+                out << osmium::item_type_to_char(timing.type) << timing.id << ' ' << timing.segments << ' ' << timing.nanoseconds << '\n';
+            }
+            return out;
+        }
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_TIMING_STATS_HPP
@@ -0,0 +1,387 @@
+#ifndef OSMIUM_AREA_WAY_MERGER_HPP
+#define OSMIUM_AREA_WAY_MERGER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        /**
+         * A line or ring created by WayMerger from one or more ways.
+         */
+        class MergedWay {
+
+            friend class WayMerger;
+
+            std::deque<osmium::NodeRef> m_nodes{};
+            std::deque<osmium::object_id_type> m_way_ids{};
+
+            void reverse() {
+                std::reverse(m_nodes.begin(), m_nodes.end());
+                std::reverse(m_way_ids.begin(), m_way_ids.end());
+            }
+
+            // Append other, whose first location is the same as our last
+            // location.
+            void append(MergedWay& other) {
+                m_nodes.insert(m_nodes.end(), std::next(other.m_nodes.begin()), other.m_nodes.end());
+                m_way_ids.insert(m_way_ids.end(), other.m_way_ids.begin(), other.m_way_ids.end());
+            }
+
+            // Prepend other, whose last location is the same as our first
+            // location.
+            void prepend(MergedWay& other) {
+                m_nodes.insert(m_nodes.begin(), other.m_nodes.begin(), std::prev(other.m_nodes.end()));
+                m_way_ids.insert(m_way_ids.begin(), other.m_way_ids.begin(), other.m_way_ids.end());
+            }
+
+        public:
+
+            /// The nodes of the line or ring.
+            const std::deque<osmium::NodeRef>& nodes() const noexcept {
+                return m_nodes;
+            }
+
+            /// The ids of the ways this was created from, in order.
+            const std::deque<osmium::object_id_type>& way_ids() const noexcept {
+                return m_way_ids;
+            }
+
+            osmium::Location first_location() const noexcept {
+                return m_nodes.front().location();
+            }
+
+            osmium::Location last_location() const noexcept {
+                return m_nodes.back().location();
+            }
+
+            /// Is this a ring, ie. are the first and last locations the same?
+            bool closed() const noexcept {
+                return m_nodes.size() > 2 && first_location() == last_location();
+            }
+
+        }; // class MergedWay
+
+        /**
+         * Joins ways into rings and lines by their shared end points,
+         * for instance for coastlines, rivers, or the members of route
+         * relations. Ways are joined where the locations of their end
+         * nodes are the same, the node ids don't matter.
+         *
+         * The open ends of all lines merged so far are kept in hash maps,
+         * so every way is joined as soon as it is added. Joining copies
+         * the shorter line into the longer one, so the total time is
+         * linear in practice.
+         *
+         * If reversing is not allowed (for coastlines, which have land
+         * on the left), ways are only joined end to start. Otherwise
+         * ways are reversed where needed, and the direction of the
+         * resulting lines and rings is arbitrary. Where more than two
+         * ways meet at the same location, lines closing a ring are
+         * preferred, otherwise which of them are joined is not defined.
+         *
+         * To use several threads, add the ways to one WayMerger per
+         * thread, then add the others to one of them with
+         * add(WayMerger&&). Only the open lines have to be joined again
+         * in that step.
+         *
+         * Usage:
+         * @code
+         * osmium::area::WayMerger merger{false};
+         * for (const auto& way : buffer.select<osmium::Way>()) {
+         *     if (way.tags().has_tag("natural", "coastline")) {
+         *         merger.add(way);
+         *     }
+         * }
+         * merger.for_each_ring([](const osmium::area::MergedWay& ring) {
+         *     ...
+         * });
+         * @endcode
+         */
+        class WayMerger {
+
+            using location_map = std::unordered_multimap<osmium::Location, std::size_t>;
+
+            std::vector<MergedWay> m_lines;
+            std::vector<std::size_t> m_free_lines;
+            std::vector<MergedWay> m_rings;
+
+            // Open lines by their first and last locations.
+            location_map m_starts;
+            location_map m_ends;
+
+            std::size_t m_num_lines = 0;
+            bool m_allow_reverse;
+
+            static void erase(location_map& map, const osmium::Location& location, std::size_t line) {
+                const auto range = map.equal_range(location);
+                for (auto it = range.first; it != range.second; ++it) {
+                    if (it->second == line) {
+                        map.erase(it);
+                        return;
+                    }
+                }
+            }
+
+            // Take an open line out of the maps. If there are several
+            // lines at the location, prefer one whose other end is at
+            // close_location, so that it closes a ring. Returns the
+            // number of the line or m_lines.size() if there is none.
+            std::size_t take(location_map& map, const osmium::Location& location, const osmium::Location& close_location) {
+                const bool starts = &map == &m_starts;
+                const auto range = map.equal_range(location);
+                if (range.first == range.second) {
+                    return m_lines.size();
+                }
+                auto found = range.first;
+                for (auto it = range.first; it != range.second; ++it) {
+                    const auto& line = m_lines[it->second];
+                    if ((starts ? line.last_location() : line.first_location()) == close_location) {
+                        found = it;
+                        break;
+                    }
+                }
+                const std::size_t line = found->second;
+                map.erase(found);
+                if (starts) {
+                    erase(m_ends, m_lines[line].last_location(), line);
+                } else {
+                    erase(m_starts, m_lines[line].first_location(), line);
+                }
+                --m_num_lines;
+                return line;
+            }
+
+            void release(std::size_t line) {
+                m_lines[line] = MergedWay{};
+                m_free_lines.push_back(line);
+            }
+
+            // Join lines a and b, the last location of a is the first
+            // location of b. Returns the line which is left.
+            std::size_t join(std::size_t a, std::size_t b) {
+                if (m_lines[a].m_nodes.size() >= m_lines[b].m_nodes.size()) {
+                    m_lines[a].append(m_lines[b]);
+                    release(b);
+                    return a;
+                }
+                m_lines[b].prepend(m_lines[a]);
+                release(a);
+                return b;
+            }
+
+            bool shorter(std::size_t a, std::size_t b) const noexcept {
+                return m_lines[a].m_nodes.size() <= m_lines[b].m_nodes.size();
+            }
+
+            // Join the line with all open lines it connects to until it
+            // is closed or there are no more.
+            void add_line(std::size_t line) {
+                while (!m_lines[line].closed()) {
+                    const osmium::Location first = m_lines[line].first_location();
+                    const osmium::Location last = m_lines[line].last_location();
+                    std::size_t other = take(m_ends, first, last);
+                    if (other != m_lines.size()) {
+                        line = join(other, line);
+                        continue;
+                    }
+                    other = take(m_starts, last, first);
+                    if (other != m_lines.size()) {
+                        line = join(line, other);
+                        continue;
+                    }
+                    if (m_allow_reverse) {
+                        other = take(m_starts, first, last);
+                        if (other != m_lines.size()) {
+                            // Reverse the shorter of the two lines.
+                            if (shorter(other, line)) {
+                                m_lines[other].reverse();
+                                line = join(other, line);
+                            } else {
+                                m_lines[line].reverse();
+                                line = join(line, other);
+                            }
+                            continue;
+                        }
+                        other = take(m_ends, last, first);
+                        if (other != m_lines.size()) {
+                            if (shorter(other, line)) {
+                                m_lines[other].reverse();
+                                line = join(line, other);
+                            } else {
+                                m_lines[line].reverse();
+                                line = join(other, line);
+                            }
+                            continue;
+                        }
+                    }
+                    m_starts.emplace(first, line);
+                    m_ends.emplace(last, line);
+                    ++m_num_lines;
+                    return;
+                }
+                m_rings.push_back(std::move(m_lines[line]));
+                release(line);
+            }
+
+            std::size_t new_line() {
+                if (m_free_lines.empty()) {
+                    m_lines.emplace_back();
+                    return m_lines.size() - 1;
+                }
+                const std::size_t line = m_free_lines.back();
+                m_free_lines.pop_back();
+                return line;
+            }
+
+        public:
+
+            /**
+             * Constructor.
+             *
+             * @param allow_reverse Allow reversing ways to join them.
+             */
+            explicit WayMerger(bool allow_reverse = true) :
+                m_allow_reverse(allow_reverse) {
+            }
+
+            /**
+             * Add a way. The way must have its node locations set. Ways
+             * with less than two nodes or with invalid locations are
+             * ignored.
+             *
+             * @returns true if the way was added, false otherwise.
+             */
+            bool add(const osmium::Way& way) {
+                const osmium::WayNodeList& nodes = way.nodes();
+                if (nodes.size() < 2) {
+                    return false;
+                }
+                for (const auto& node_ref : nodes) {
+                    if (!node_ref.location().valid()) {
+                        return false;
+                    }
+                }
+
+                const std::size_t line = new_line();
+                m_lines[line].m_nodes.assign(nodes.begin(), nodes.end());
+                m_lines[line].m_way_ids.push_back(way.id());
+                add_line(line);
+                return true;
+            }
+
+            /**
+             * Add all rings and lines from another WayMerger. The lines
+             * are joined with the lines in this merger. The other merger
+             * is empty afterwards.
+             */
+            void add(WayMerger&& other) {
+                m_rings.insert(m_rings.end(),
+                               std::make_move_iterator(other.m_rings.begin()),
+                               std::make_move_iterator(other.m_rings.end()));
+                for (const auto& entry : other.m_starts) {
+                    const std::size_t line = new_line();
+                    m_lines[line] = std::move(other.m_lines[entry.second]);
+                    add_line(line);
+                }
+                other.clear();
+            }
+
+            /// Remove all rings and lines.
+            void clear() {
+                m_lines.clear();
+                m_free_lines.clear();
+                m_rings.clear();
+                m_starts.clear();
+                m_ends.clear();
+                m_num_lines = 0;
+            }
+
+            /// The number of rings found so far.
+            std::size_t num_rings() const noexcept {
+                return m_rings.size();
+            }
+
+            /// The number of open lines left.
+            std::size_t num_lines() const noexcept {
+                return m_num_lines;
+            }
+
+            /// The rings found so far.
+            const std::vector<MergedWay>& rings() const noexcept {
+                return m_rings;
+            }
+
+            /**
+             * Call func(const MergedWay&) for all rings.
+             */
+            template <typename TFunc>
+            void for_each_ring(TFunc&& func) const {
+                for (const auto& ring : m_rings) {
+                    func(ring);
+                }
+            }
+
+            /**
+             * Call func(const MergedWay&) for all open lines. The order
+             * is unspecified.
+             */
+            template <typename TFunc>
+            void for_each_line(TFunc&& func) const {
+                for (const auto& entry : m_starts) {
+                    func(m_lines[entry.second]);
+                }
+            }
+
+        }; // class WayMerger
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_WAY_MERGER_HPP
@@ -36,6 +36,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/builder/builder.hpp>
 #include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
 #include <osmium/osm/changeset.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
@@ -43,12 +44,15 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/object.hpp>
 #include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
 #include <osmium/osm/timestamp.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/util/string.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <ctime>
 #include <initializer_list>
 #include <iterator>
@@ -670,6 +674,27 @@ namespace osmium {
 
             // ==============================================================
 
+            // Node refs from forward iterators are added in one go, from
+            // input iterators one by one.
+            template <typename TBuilder, typename TIterator>
+            inline void add_node_refs(TBuilder& builder, TIterator first, TIterator last, std::forward_iterator_tag /*category*/) {
+                builder.add_node_refs(first, last);
+            }
+
+            template <typename TBuilder, typename TIterator>
+            inline void add_node_refs(TBuilder& builder, TIterator first, TIterator last, std::input_iterator_tag /*category*/) {
+                for (; first != last; ++first) {
+                    builder.add_node_ref(*first);
+                }
+            }
+
+            template <typename TBuilder, typename TIterator>
+            inline void add_node_refs(TBuilder& builder, TIterator first, TIterator last) {
+                add_node_refs(builder, first, last, typename std::iterator_traits<TIterator>::iterator_category{});
+            }
+
+            // ==============================================================
+
             struct tags_handler {
 
                 template <typename TDummy>
@@ -728,9 +753,7 @@ namespace osmium {
 
                 template <typename TIterator>
                 static void set_value(WayNodeListBuilder& builder, const attr::detail::nodes_from_iterator_pair<TIterator>& nodes) {
-                    for (const auto& ref : nodes) {
-                        builder.add_node_ref(ref);
-                    }
+                    add_node_refs(builder, nodes.begin(), nodes.end());
                 }
 
             }; // struct nodes_handler
@@ -784,17 +807,13 @@ namespace osmium {
                 template <typename TIterator>
                 static void set_value(AreaBuilder& parent, const attr::detail::outer_ring_from_iterator_pair<TIterator>& nodes) {
                     OuterRingBuilder builder(parent.buffer(), &parent);
-                    for (const auto& ref : nodes) {
-                        builder.add_node_ref(ref);
-                    }
+                    add_node_refs(builder, nodes.begin(), nodes.end());
                 }
 
                 template <typename TIterator>
                 static void set_value(AreaBuilder& parent, const attr::detail::inner_ring_from_iterator_pair<TIterator>& nodes) {
                     InnerRingBuilder builder(parent.buffer(), &parent);
-                    for (const auto& ref : nodes) {
-                        builder.add_node_ref(ref);
-                    }
+                    add_node_refs(builder, nodes.begin(), nodes.end());
                 }
 
             }; // struct ring_handler
@@ -815,6 +834,87 @@ namespace osmium {
                 };
             }
 
+            // ==============================================================
+            //
+            // Estimate of the number of bytes the attributes will take up
+            // in the buffer. Attributes with a fixed size are computed at
+            // compile time, strings are measured. Lists from input
+            // iterators and lists of tags, members, and comments given as
+            // iterator ranges are not counted.
+
+            template <typename TDummy>
+            inline constexpr std::size_t attribute_size(const TDummy& /*dummy*/) noexcept {
+                return 0;
+            }
+
+            inline std::size_t attribute_size(const attr::_user& user) noexcept {
+                return std::strlen(user.value) + 1;
+            }
+
+            inline std::size_t attribute_size(const attr::_tag& tag) noexcept {
+                // "key=value" needs one byte less than this
+                return std::strlen(tag.value.first) + 2 +
+                       (tag.value.second ? std::strlen(tag.value.second) : 0);
+            }
+
+            inline std::size_t attribute_size(const attr::_t& tags) noexcept {
+                return std::strlen(tags.value) + 2;
+            }
+
+            inline constexpr std::size_t attribute_size(const attr::_node& /*node_ref*/) noexcept {
+                return sizeof(osmium::NodeRef);
+            }
+
+            inline std::size_t attribute_size(const attr::_member& member) noexcept {
+                return sizeof(osmium::RelationMember) + std::strlen(member.value.role()) + 1 + osmium::memory::align_bytes;
+            }
+
+            template <typename TIterator>
+            inline std::size_t node_refs_size(TIterator first, TIterator last, std::forward_iterator_tag /*category*/) {
+                return static_cast<std::size_t>(std::distance(first, last)) * sizeof(osmium::NodeRef);
+            }
+
+            template <typename TIterator>
+            inline constexpr std::size_t node_refs_size(TIterator /*first*/, TIterator /*last*/, std::input_iterator_tag /*category*/) noexcept {
+                return 0;
+            }
+
+            template <typename TIterator>
+            inline std::size_t attribute_size(const attr::detail::nodes_from_iterator_pair<TIterator>& nodes) {
+                return node_refs_size(nodes.begin(), nodes.end(), typename std::iterator_traits<TIterator>::iterator_category{});
+            }
+
+            template <typename TIterator>
+            inline std::size_t attribute_size(const attr::detail::outer_ring_from_iterator_pair<TIterator>& nodes) {
+                return sizeof(osmium::OuterRing) + node_refs_size(nodes.begin(), nodes.end(), typename std::iterator_traits<TIterator>::iterator_category{});
+            }
+
+            template <typename TIterator>
+            inline std::size_t attribute_size(const attr::detail::inner_ring_from_iterator_pair<TIterator>& nodes) {
+                return sizeof(osmium::InnerRing) + node_refs_size(nodes.begin(), nodes.end(), typename std::iterator_traits<TIterator>::iterator_category{});
+            }
+
+            /**
+             * Make sure there is enough space in the buffer for an object
+             * of the given base size with the given attributes, so that
+             * the buffer doesn't have to grow while the object is being
+             * built. Only buffers with auto_grow::yes are grown, for other
+             * buffers the builders will report a full buffer as usual.
+             */
+            template <typename... TArgs>
+            inline void reserve_for_attributes(osmium::memory::Buffer& buffer, std::size_t base_size, const TArgs&... args) {
+                // Space for the lists and padding
+                std::size_t size = base_size + 4 * (sizeof(osmium::TagList) + osmium::memory::align_bytes);
+                (void)std::initializer_list<int>{
+                    (size += attribute_size(args), 0)...
+                };
+
+                if (buffer.get_auto_grow() == osmium::memory::Buffer::auto_grow::yes &&
+                    buffer.capacity() - buffer.written() < size) {
+                    buffer.grow(std::max(buffer.capacity() * 2, buffer.written() + size));
+                }
+            }
+
             struct any_node_handlers : public node_handler, public tags_handler {};
             struct any_way_handlers : public object_handler, public tags_handler, public nodes_handler {};
             struct any_relation_handlers : public object_handler, public tags_handler, public members_handler {};
@@ -836,6 +936,8 @@ namespace osmium {
             static_assert(sizeof...(args) > 0, "add_node() must have buffer and at least one additional argument");
             static_assert(detail::are_all_handled_by<detail::any_node_handlers, TArgs...>::value, "Attribute not allowed in add_node()");
 
+            detail::reserve_for_attributes(buffer, sizeof(osmium::Node), args...);
+
             {
                 NodeBuilder builder{buffer};
 
@@ -859,6 +961,8 @@ namespace osmium {
             static_assert(sizeof...(args) > 0, "add_way() must have buffer and at least one additional argument");
             static_assert(detail::are_all_handled_by<detail::any_way_handlers, TArgs...>::value, "Attribute not allowed in add_way()");
 
+            detail::reserve_for_attributes(buffer, sizeof(osmium::Way), args...);
+
             {
                 WayBuilder builder{buffer};
 
@@ -883,6 +987,8 @@ namespace osmium {
             static_assert(sizeof...(args) > 0, "add_relation() must have buffer and at least one additional argument");
             static_assert(detail::are_all_handled_by<detail::any_relation_handlers, TArgs...>::value, "Attribute not allowed in add_relation()");
 
+            detail::reserve_for_attributes(buffer, sizeof(osmium::Relation), args...);
+
             {
                 RelationBuilder builder{buffer};
 
@@ -907,6 +1013,8 @@ namespace osmium {
             static_assert(sizeof...(args) > 0, "add_changeset() must have buffer and at least one additional argument");
             static_assert(detail::are_all_handled_by<detail::any_changeset_handlers, TArgs...>::value, "Attribute not allowed in add_changeset()");
 
+            detail::reserve_for_attributes(buffer, sizeof(osmium::Changeset), args...);
+
             {
                 ChangesetBuilder builder{buffer};
 
@@ -931,6 +1039,8 @@ namespace osmium {
             static_assert(sizeof...(args) > 0, "add_area() must have buffer and at least one additional argument");
             static_assert(detail::are_all_handled_by<detail::any_area_handlers, TArgs...>::value, "Attribute not allowed in add_area()");
 
+            detail::reserve_for_attributes(buffer, sizeof(osmium::Area), args...);
+
             {
                 AreaBuilder builder{buffer};
 
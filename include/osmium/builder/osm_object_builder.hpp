@@ -38,6 +38,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/area.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/changeset.hpp>
+#include <osmium/osm/compressed_way_node_list.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
@@ -48,6 +49,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/timestamp.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
+#include <osmium/util/delta.hpp>
 
 #include <algorithm>
 #include <cassert>
@@ -55,7 +57,9 @@ DEALINGS IN THE SOFTWARE.
 #include <cstdint>
 #include <cstring>
 #include <initializer_list>
+#include <iterator>
 #include <limits>
+#include <memory>
 #include <new>
 #include <stdexcept>
 #include <string>
@@ -183,6 +187,52 @@ namespace osmium {
                 add_tag(tag.first, tag.second);
             }
 
+            /**
+             * Add several tags at once. Space in the buffer is reserved
+             * only once and the sizes of the parent items are only updated
+             * once, so this is faster than adding tags one by one.
+             *
+             * @tparam TIter Forward iterator over objects with members
+             *         `first` (pointer to string) and `second` (length of
+             *         string not including the \0 byte), such as
+             *         std::pair<const char*, std::size_t>. Keys and values
+             *         alternate.
+             * @param first Iterator to the first key.
+             * @param last Iterator one past the last value.
+             * @throws std::length_error If any key or value is too long.
+             */
+            template <typename TIter>
+            void add_tags(TIter first, TIter last) {
+                std::size_t size = 0;
+                bool is_key = true;
+                for (auto it = first; it != last; ++it) {
+                    if (static_cast<std::size_t>(it->second) > osmium::max_osm_string_length) {
+                        throw std::length_error{is_key ? "OSM tag key is too long" : "OSM tag value is too long"};
+                    }
+                    size += static_cast<std::size_t>(it->second) + 1;
+                    is_key = !is_key;
+                }
+                assert(is_key && "keys and values must come in pairs");
+
+                unsigned char* target = reserve_space(size);
+                for (auto it = first; it != last; ++it) {
+                    const auto length = static_cast<std::size_t>(it->second);
+                    std::copy_n(reinterpret_cast<const unsigned char*>(it->first), length, target);
+                    target[length] = '\0';
+                    target += length + 1;
+                }
+                add_size(static_cast<osmium::memory::item_size_type>(size));
+            }
+
+            /**
+             * Sort the tags added so far by key and mark the tag list as
+             * sorted (see TagList::sort_by_key()). Call this after the
+             * last tag was added.
+             */
+            void sort_by_key() {
+                static_cast<osmium::TagList&>(item()).sort_by_key();
+            }
+
         }; // class TagListBuilder
 
         template <typename T>
@@ -219,12 +269,114 @@ namespace osmium {
                 add_node_ref(NodeRef{ref, location});
             }
 
+            /**
+             * Add several node refs at once. Space in the buffer is
+             * reserved only once and the sizes of the parent items are
+             * only updated once, so this is faster than adding node refs
+             * one by one.
+             *
+             * @tparam TIter Forward iterator over NodeRefs or node IDs.
+             * @param first Iterator to the first node ref.
+             * @param last Iterator one past the last node ref.
+             */
+            template <typename TIter>
+            void add_node_refs(TIter first, TIter last) {
+                const auto count = static_cast<std::size_t>(std::distance(first, last));
+                auto* target = add_empty_node_refs(count);
+                for (; first != last; ++first, ++target) {
+                    *target = osmium::NodeRef{*first};
+                }
+            }
+
+            /**
+             * Add count default-constructed node refs at once and return a
+             * pointer to the first of them so the caller can fill them in.
+             * The pointer is only valid until anything else is added to
+             * the buffer.
+             *
+             * @param count Number of node refs to add.
+             * @returns Pointer to the first of the new node refs.
+             */
+            osmium::NodeRef* add_empty_node_refs(std::size_t count) {
+                const auto size = count * sizeof(osmium::NodeRef);
+                auto* target = reinterpret_cast<osmium::NodeRef*>(reserve_space(size));
+                std::uninitialized_fill_n(target, count, osmium::NodeRef{});
+                add_size(static_cast<osmium::memory::item_size_type>(size));
+                return target;
+            }
+
         }; // class NodeRefListBuilder
 
         using WayNodeListBuilder = NodeRefListBuilder<WayNodeList>;
         using OuterRingBuilder   = NodeRefListBuilder<OuterRing>;
         using InnerRingBuilder   = NodeRefListBuilder<InnerRing>;
 
+        /**
+         * Builder for a CompressedWayNodeList. The NodeRefs are encoded
+         * as they are added.
+         */
+        class CompressedWayNodeListBuilder : public Builder {
+
+            osmium::DeltaEncode<osmium::object_id_type> m_ref;
+            osmium::DeltaEncode<int32_t> m_x;
+            osmium::DeltaEncode<int32_t> m_y;
+
+            CompressedWayNodeList& object() noexcept {
+                return static_cast<CompressedWayNodeList&>(item());
+            }
+
+        public:
+
+            explicit CompressedWayNodeListBuilder(osmium::memory::Buffer& buffer, Builder* parent = nullptr) :
+                Builder(buffer, parent, sizeof(CompressedWayNodeList)) {
+                new (&item()) CompressedWayNodeList{};
+            }
+
+            explicit CompressedWayNodeListBuilder(Builder& parent) :
+                Builder(parent.buffer(), &parent, sizeof(CompressedWayNodeList)) {
+                new (&item()) CompressedWayNodeList{};
+            }
+
+            CompressedWayNodeListBuilder(const CompressedWayNodeListBuilder&) = delete;
+            CompressedWayNodeListBuilder& operator=(const CompressedWayNodeListBuilder&) = delete;
+
+            CompressedWayNodeListBuilder(CompressedWayNodeListBuilder&&) = delete;
+            CompressedWayNodeListBuilder& operator=(CompressedWayNodeListBuilder&&) = delete;
+
+            ~CompressedWayNodeListBuilder() {
+                add_padding();
+            }
+
+            void add_node_ref(const NodeRef& node_ref) {
+                unsigned char data[3 * osmium::detail::max_compressed_varint_length];
+                std::size_t length = osmium::detail::write_compressed_varint(data, osmium::detail::encode_zigzag(m_ref.update(node_ref.ref())));
+                length += osmium::detail::write_compressed_varint(data + length, osmium::detail::encode_zigzag(m_x.update(node_ref.location().x())));
+                length += osmium::detail::write_compressed_varint(data + length, osmium::detail::encode_zigzag(m_y.update(node_ref.location().y())));
+                std::copy_n(data, length, reserve_space(length));
+                add_size(static_cast<osmium::memory::item_size_type>(length));
+                ++object().m_num_nodes;
+            }
+
+            void add_node_ref(const object_id_type ref, const osmium::Location& location = Location{}) {
+                add_node_ref(NodeRef{ref, location});
+            }
+
+            /**
+             * Add all NodeRefs from the range.
+             *
+             * @tparam TIter Input iterator over NodeRefs.
+             * @param first Iterator to the first node ref.
+             * @param last Iterator one past the last node ref.
+             */
+            template <typename TIter>
+            void add_node_refs(TIter first, TIter last) {
+                for (; first != last; ++first) {
+                    add_node_ref(*first);
+                }
+            }
+
+        }; // class CompressedWayNodeListBuilder
+
         class RelationMemberListBuilder : public Builder {
 
             /**
@@ -368,8 +520,11 @@ namespace osmium {
 
             void add_comment(osmium::Timestamp date, osmium::user_id_type uid, const char* user) {
                 assert(!m_comment && "You have to always call both add_comment() and then add_comment_text() in that order for each comment!");
-                m_comment = reserve_space_for<osmium::ChangesetComment>();
-                new (m_comment) osmium::ChangesetComment{date, uid};
+                // ChangesetComment has padding at the end, clear it so that
+                // the buffer contents don't depend on earlier buffer use.
+                unsigned char* space = reserve_space(sizeof(osmium::ChangesetComment));
+                std::fill_n(space, sizeof(osmium::ChangesetComment), 0);
+                m_comment = new (space) osmium::ChangesetComment{date, uid};
                 add_size(sizeof(ChangesetComment));
                 add_user(*m_comment, user, std::strlen(user));
             }
@@ -548,6 +703,42 @@ namespace osmium {
 
         }; // class WayBuilder
 
+        /**
+         * Add a copy of the way to the buffer with a CompressedWayNodeList
+         * instead of the WayNodeList. All attributes and other subitems are
+         * copied unchanged. The buffer is committed.
+         *
+         * @param buffer The buffer to add the way to. Must not be the
+         *               buffer the way is in.
+         * @param way The way to copy.
+         * @returns The offset of the new way in the buffer.
+         */
+        inline std::size_t add_compressed_way(osmium::memory::Buffer& buffer, const osmium::Way& way) {
+            {
+                WayBuilder builder{buffer};
+                builder.set_id(way.id())
+                       .set_version(way.version())
+                       .set_changeset(way.changeset())
+                       .set_timestamp(way.timestamp())
+                       .set_uid(way.uid())
+                       .set_visible(way.visible());
+                builder.set_user(std::string{way.user()});
+                for (const auto& item : way) {
+                    if (item.removed()) {
+                        continue;
+                    }
+                    if (item.type() == osmium::item_type::way_node_list) {
+                        const auto& nodes = static_cast<const osmium::WayNodeList&>(item);
+                        CompressedWayNodeListBuilder nodes_builder{builder};
+                        nodes_builder.add_node_refs(nodes.cbegin(), nodes.cend());
+                    } else {
+                        builder.add_item(item);
+                    }
+                }
+            }
+            return buffer.commit();
+        }
+
         class RelationBuilder : public OSMObjectBuilder<RelationBuilder, Relation> {
 
             using type = RelationBuilder;
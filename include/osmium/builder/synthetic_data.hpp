@@ -0,0 +1,537 @@
+#ifndef OSMIUM_BUILDER_SYNTHETIC_DATA_HPP
+#define OSMIUM_BUILDER_SYNTHETIC_DATA_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace builder {
+
+        /**
+         * Configuration for the SyntheticDataGenerator. All counts and
+         * distributions are fixed by these settings, so the same
+         * configuration always generates the same data.
+         */
+        struct SyntheticDataConfig {
+
+            /// Seed for the pseudo random numbers.
+            uint64_t seed = 1;
+
+            /// Number of nodes, ways, and relations to generate.
+            uint64_t nodes = 1000000;
+            uint64_t ways = 120000;
+            uint64_t relations = 2000;
+
+            /**
+             * Average distance between consecutive ids. With 1 all ids
+             * from 1 upwards are used, larger values leave gaps of random
+             * size like in extracts or in the planet with deleted objects.
+             */
+            uint32_t id_gap = 1;
+
+            /// Percentage of nodes with tags.
+            uint32_t tagged_nodes_percent = 5;
+
+            /// Average number of tags on tagged nodes, ways, and relations.
+            uint32_t node_tags_mean = 2;
+            uint32_t way_tags_mean = 3;
+            uint32_t relation_tags_mean = 3;
+
+            /**
+             * Way lengths have a geometric distribution with this mean,
+             * so most ways are short and some are very long.
+             */
+            uint32_t way_nodes_mean = 10;
+
+            /// Maximum number of nodes in a way.
+            uint32_t way_nodes_max = 2000;
+
+            /// Percentage of ways that are closed.
+            uint32_t closed_ways_percent = 30;
+
+            /// Average number of members of a relation (geometric distribution).
+            uint32_t relation_members_mean = 12;
+
+            /// Maximum number of members of a relation.
+            uint32_t relation_members_max = 5000;
+
+            /**
+             * Percentage of relation members that are relations. They
+             * always refer to relations generated earlier, so relations
+             * can be nested arbitrarily deep but never form cycles.
+             */
+            uint32_t relation_members_relations_percent = 5;
+
+            /// Nodes are placed into this box.
+            osmium::Box bounding_box{5.0, 47.0, 15.0, 55.0};
+
+            /// Add version, timestamp, changeset, uid, and user to all objects.
+            bool with_metadata = true;
+
+            /// Number of objects in each generated buffer.
+            std::size_t chunk_size = 10000;
+
+        }; // struct SyntheticDataConfig
+
+        namespace detail {
+
+            inline uint64_t synthetic_mix(uint64_t value) noexcept {
+                value += 0x9e3779b97f4a7c15ULL;
+                value = (value ^ (value >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+                value = (value ^ (value >> 27U)) * 0x94d049bb133111ebULL;
+                return value ^ (value >> 31U);
+            }
+
+            // Pseudo random numbers that are the same on every platform
+            // (unlike the distributions from <random>).
+            class SyntheticRandom {
+
+                uint64_t m_state;
+
+            public:
+
+                explicit SyntheticRandom(uint64_t seed) noexcept :
+                    m_state(synthetic_mix(seed)) {
+                }
+
+                uint64_t next() noexcept {
+                    m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+                    return synthetic_mix(m_state);
+                }
+
+                uint64_t below(uint64_t max) noexcept {
+                    return max == 0 ? 0 : next() % max;
+                }
+
+                bool percent(uint32_t value) noexcept {
+                    return below(100) < value;
+                }
+
+                // Skewed towards small values like word frequencies.
+                uint64_t skewed(uint64_t max) noexcept {
+                    return below(below(max) + 1);
+                }
+
+                // Geometric distribution with the given minimum and mean.
+                uint32_t geometric(uint32_t min, uint32_t mean, uint32_t max) noexcept {
+                    uint32_t value = min;
+                    if (mean > min) {
+                        const uint64_t n = mean - min + 1;
+                        while (value < max && below(n) != 0) {
+                            ++value;
+                        }
+                    }
+                    return std::min(value, max);
+                }
+
+            }; // class SyntheticRandom
+
+            struct synthetic_tag {
+                const char* key;
+                const char* const* values; // nullptr-terminated, nullptr for generated names
+            };
+
+            // Keys are ordered by how often they should appear.
+            inline const synthetic_tag* synthetic_node_tags(std::size_t* size) noexcept {
+                static const char* const highway[] = {"crossing", "bus_stop", "traffic_signals", "street_lamp", "stop", "turning_circle", nullptr};
+                static const char* const amenity[] = {"bench", "parking", "restaurant", "waste_basket", "cafe", "school", "pharmacy", nullptr};
+                static const char* const natural[] = {"tree", "peak", "spring", "rock", nullptr};
+                static const char* const barrier[] = {"gate", "bollard", "lift_gate", "kerb", nullptr};
+                static const char* const shop[] = {"supermarket", "bakery", "convenience", "clothes", "hairdresser", nullptr};
+                static const char* const source[] = {"survey", "Bing", "gps", "local knowledge", nullptr};
+                static const synthetic_tag tags[] = {
+                    {"highway", highway},
+                    {"name", nullptr},
+                    {"amenity", amenity},
+                    {"natural", natural},
+                    {"barrier", barrier},
+                    {"source", source},
+                    {"shop", shop},
+                    {"addr:housenumber", nullptr}
+                };
+                *size = sizeof(tags) / sizeof(tags[0]);
+                return tags;
+            }
+
+            inline const synthetic_tag* synthetic_way_tags(std::size_t* size) noexcept {
+                static const char* const building[] = {"yes", "house", "residential", "garage", "apartments", "industrial", nullptr};
+                static const char* const highway[] = {"residential", "service", "track", "footway", "unclassified", "path", "tertiary", "secondary", "primary", nullptr};
+                static const char* const source[] = {"survey", "Bing", "gps", "local knowledge", nullptr};
+                static const char* const surface[] = {"asphalt", "unpaved", "gravel", "paved", "ground", "concrete", nullptr};
+                static const char* const landuse[] = {"residential", "farmland", "grass", "forest", "meadow", "industrial", nullptr};
+                static const char* const oneway[] = {"yes", "no", "-1", nullptr};
+                static const char* const natural[] = {"wood", "water", "scrub", "wetland", "coastline", nullptr};
+                static const char* const waterway[] = {"stream", "ditch", "river", "drain", "canal", nullptr};
+                static const char* const maxspeed[] = {"50", "30", "100", "70", "60", nullptr};
+                static const synthetic_tag tags[] = {
+                    {"building", building},
+                    {"highway", highway},
+                    {"source", source},
+                    {"name", nullptr},
+                    {"surface", surface},
+                    {"landuse", landuse},
+                    {"oneway", oneway},
+                    {"natural", natural},
+                    {"waterway", waterway},
+                    {"maxspeed", maxspeed},
+                    {"addr:housenumber", nullptr}
+                };
+                *size = sizeof(tags) / sizeof(tags[0]);
+                return tags;
+            }
+
+            inline const synthetic_tag* synthetic_relation_tags(std::size_t* size) noexcept {
+                static const char* const type[] = {"multipolygon", "route", "restriction", "boundary", "associatedStreet", "site", nullptr};
+                static const char* const route[] = {"bus", "hiking", "bicycle", "road", "train", nullptr};
+                static const char* const boundary[] = {"administrative", "protected_area", "postal_code", nullptr};
+                static const char* const network[] = {"lwn", "rwn", "ncn", "local", nullptr};
+                static const synthetic_tag tags[] = {
+                    {"type", type},
+                    {"name", nullptr},
+                    {"route", route},
+                    {"boundary", boundary},
+                    {"network", network},
+                    {"ref", nullptr}
+                };
+                *size = sizeof(tags) / sizeof(tags[0]);
+                return tags;
+            }
+
+        } // namespace detail
+
+        /**
+         * Generates synthetic OSM data for tests and benchmarks. The data
+         * is similar to real OSM data: node locations follow random walks
+         * so that nodes with neighbouring ids are close together, ways
+         * mostly use nodes with neighbouring ids, the number of nodes in
+         * ways and members in relations varies widely, some tags are much
+         * more common than others, and relations can contain relations.
+         *
+         * The data is generated in chunks of SyntheticDataConfig::chunk_size
+         * objects, all nodes first, then all ways, then all relations,
+         * each sorted by id. Each chunk only depends on the configuration
+         * and its number, so chunks can be generated in any order and in
+         * parallel and only the current chunks have to be kept in memory.
+         * That makes it possible to generate files of any size.
+         */
+        class SyntheticDataGenerator {
+
+            enum {
+                initial_buffer_size = 1024UL * 1024UL
+            };
+
+            SyntheticDataConfig m_config;
+            std::size_t m_node_chunks;
+            std::size_t m_way_chunks;
+            std::size_t m_relation_chunks;
+            std::size_t m_next_chunk = 0;
+
+            std::size_t chunks_for(uint64_t count) const noexcept {
+                return static_cast<std::size_t>((count + m_config.chunk_size - 1) / m_config.chunk_size);
+            }
+
+            osmium::object_id_type id(uint64_t salt, uint64_t index) const noexcept {
+                uint64_t id = 1 + index * m_config.id_gap;
+                if (m_config.id_gap > 1) {
+                    id += detail::synthetic_mix(m_config.seed ^ salt ^ index) % m_config.id_gap;
+                }
+                return static_cast<osmium::object_id_type>(id);
+            }
+
+            template <typename TBuilder>
+            void set_attributes(TBuilder& builder, detail::SyntheticRandom& random, osmium::object_id_type id) const {
+                builder.set_id(id);
+                if (!m_config.with_metadata) {
+                    return;
+                }
+                const auto uid = static_cast<osmium::user_id_type>(1 + random.skewed(100000));
+                builder.set_version(static_cast<osmium::object_version_type>(1 + random.skewed(20)));
+                builder.set_changeset(static_cast<osmium::changeset_id_type>(1 + random.below(120000000)));
+                builder.set_timestamp(osmium::Timestamp{static_cast<uint32_t>(1167609600 + random.below(500000000))});
+                builder.set_uid(uid);
+                builder.set_user("user" + std::to_string(uid));
+            }
+
+            static void add_tags(osmium::builder::Builder& parent, detail::SyntheticRandom& random,
+                                 const detail::synthetic_tag* tags, std::size_t num_tags, uint32_t count) {
+                if (count == 0) {
+                    return;
+                }
+                osmium::builder::TagListBuilder builder{parent};
+                uint64_t used = 0;
+                std::string value;
+                for (uint32_t i = 0; i < count && i < num_tags; ++i) {
+                    std::size_t n = 0;
+                    do {
+                        n = static_cast<std::size_t>(random.skewed(num_tags));
+                    } while (used & (1ULL << n));
+                    used |= 1ULL << n;
+
+                    const auto& tag = tags[n];
+                    if (tag.values) {
+                        std::size_t num_values = 0;
+                        while (tag.values[num_values]) {
+                            ++num_values;
+                        }
+                        builder.add_tag(tag.key, tag.values[random.skewed(num_values)]);
+                    } else {
+                        value = std::to_string(1 + random.skewed(10000));
+                        if (tag.key[0] == 'n') {
+                            value.insert(0, "Name ");
+                        }
+                        builder.add_tag(tag.key, value);
+                    }
+                }
+            }
+
+            void add_nodes(osmium::memory::Buffer& buffer, detail::SyntheticRandom& random, uint64_t first, uint64_t last) const {
+                const auto& box = m_config.bounding_box;
+                const int32_t min_x = box.bottom_left().x();
+                const int32_t min_y = box.bottom_left().y();
+                const int64_t width = int64_t(box.top_right().x()) - min_x;
+                const int64_t height = int64_t(box.top_right().y()) - min_y;
+
+                // Start at a random location and walk in steps of up to
+                // about 50m from there.
+                int64_t x = static_cast<int64_t>(random.below(static_cast<uint64_t>(width) + 1));
+                int64_t y = static_cast<int64_t>(random.below(static_cast<uint64_t>(height) + 1));
+                const int64_t step = 5000;
+
+                std::size_t num_tags = 0;
+                const auto* tags = detail::synthetic_node_tags(&num_tags);
+
+                for (uint64_t n = first; n < last; ++n) {
+                    x = std::max<int64_t>(0, std::min(width, x + static_cast<int64_t>(random.below(2 * step + 1)) - step));
+                    y = std::max<int64_t>(0, std::min(height, y + static_cast<int64_t>(random.below(2 * step + 1)) - step));
+                    {
+                        osmium::builder::NodeBuilder builder{buffer};
+                        set_attributes(builder, random, id(1, n));
+                        builder.set_location(osmium::Location{static_cast<int32_t>(min_x + x), static_cast<int32_t>(min_y + y)});
+                        if (random.percent(m_config.tagged_nodes_percent)) {
+                            add_tags(builder, random, tags, num_tags, random.geometric(1, m_config.node_tags_mean, 64));
+                        }
+                    }
+                    buffer.commit();
+                }
+            }
+
+            void add_ways(osmium::memory::Buffer& buffer, detail::SyntheticRandom& random, uint64_t first, uint64_t last) const {
+                std::size_t num_tags = 0;
+                const auto* tags = detail::synthetic_way_tags(&num_tags);
+
+                for (uint64_t n = first; n < last; ++n) {
+                    {
+                        osmium::builder::WayBuilder builder{buffer};
+                        set_attributes(builder, random, id(2, n));
+                        add_tags(builder, random, tags, num_tags, random.geometric(0, m_config.way_tags_mean, 64));
+                        if (m_config.nodes > 0) {
+                            const bool closed = random.percent(m_config.closed_ways_percent);
+                            const auto max = std::max<uint32_t>(m_config.way_nodes_max, closed ? 4 : 2);
+                            const auto count = random.geometric(closed ? 3 : 2, m_config.way_nodes_mean, closed ? max - 1 : max);
+
+                            // Mostly consecutive nodes with some jumps.
+                            osmium::builder::WayNodeListBuilder wnl_builder{builder};
+                            uint64_t node = random.below(m_config.nodes);
+                            const auto first_node = id(1, node);
+                            for (uint32_t i = 0; i < count; ++i) {
+                                wnl_builder.add_node_ref(id(1, node));
+                                node += random.percent(80) ? 1 : 1 + random.below(100);
+                                node %= m_config.nodes;
+                            }
+                            if (closed) {
+                                wnl_builder.add_node_ref(first_node);
+                            }
+                        }
+                    }
+                    buffer.commit();
+                }
+            }
+
+            void add_relations(osmium::memory::Buffer& buffer, detail::SyntheticRandom& random, uint64_t first, uint64_t last) const {
+                static const char* const roles[] = {"", "outer", "inner", "stop", "platform", "from", "to", "via"};
+
+                std::size_t num_tags = 0;
+                const auto* tags = detail::synthetic_relation_tags(&num_tags);
+
+                for (uint64_t n = first; n < last; ++n) {
+                    {
+                        osmium::builder::RelationBuilder builder{buffer};
+                        set_attributes(builder, random, id(3, n));
+                        add_tags(builder, random, tags, num_tags, random.geometric(1, m_config.relation_tags_mean, 64));
+
+                        const auto count = random.geometric(1, m_config.relation_members_mean, std::max<uint32_t>(m_config.relation_members_max, 1));
+                        osmium::builder::RelationMemberListBuilder rml_builder{builder};
+                        for (uint32_t i = 0; i < count; ++i) {
+                            const char* role = roles[random.skewed(sizeof(roles) / sizeof(roles[0]))];
+                            if (n > 0 && random.percent(m_config.relation_members_relations_percent)) {
+                                rml_builder.add_member(osmium::item_type::relation, id(3, random.below(n)), role);
+                            } else if (m_config.ways > 0 && random.percent(85)) {
+                                rml_builder.add_member(osmium::item_type::way, id(2, random.below(m_config.ways)), role);
+                            } else if (m_config.nodes > 0) {
+                                rml_builder.add_member(osmium::item_type::node, id(1, random.below(m_config.nodes)), role);
+                            }
+                        }
+                    }
+                    buffer.commit();
+                }
+            }
+
+        public:
+
+            explicit SyntheticDataGenerator(const SyntheticDataConfig& config = SyntheticDataConfig{}) :
+                m_config(config) {
+                if (m_config.chunk_size == 0) {
+                    m_config.chunk_size = 1;
+                }
+                if (m_config.id_gap == 0) {
+                    m_config.id_gap = 1;
+                }
+                m_node_chunks = chunks_for(m_config.nodes);
+                m_way_chunks = chunks_for(m_config.ways);
+                m_relation_chunks = chunks_for(m_config.relations);
+            }
+
+            const SyntheticDataConfig& config() const noexcept {
+                return m_config;
+            }
+
+            /// Total number of chunks.
+            std::size_t num_chunks() const noexcept {
+                return m_node_chunks + m_way_chunks + m_relation_chunks;
+            }
+
+            /// Id of the node with the given index (0 <= index < config().nodes).
+            osmium::object_id_type node_id(uint64_t index) const noexcept {
+                return id(1, index);
+            }
+
+            /// Id of the way with the given index (0 <= index < config().ways).
+            osmium::object_id_type way_id(uint64_t index) const noexcept {
+                return id(2, index);
+            }
+
+            /// Id of the relation with the given index (0 <= index < config().relations).
+            osmium::object_id_type relation_id(uint64_t index) const noexcept {
+                return id(3, index);
+            }
+
+            /**
+             * Generate the chunk with the given number. This is thread
+             * safe, several chunks can be generated at the same time.
+             *
+             * @pre chunk < num_chunks()
+             */
+            osmium::memory::Buffer chunk(std::size_t chunk) const {
+                osmium::memory::Buffer buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                detail::SyntheticRandom random{m_config.seed * 0x100000001b3ULL + chunk};
+
+                if (chunk < m_node_chunks) {
+                    const uint64_t first = uint64_t(chunk) * m_config.chunk_size;
+                    add_nodes(buffer, random, first, std::min(first + m_config.chunk_size, m_config.nodes));
+                } else if (chunk < m_node_chunks + m_way_chunks) {
+                    const uint64_t first = uint64_t(chunk - m_node_chunks) * m_config.chunk_size;
+                    add_ways(buffer, random, first, std::min(first + m_config.chunk_size, m_config.ways));
+                } else {
+                    const uint64_t first = uint64_t(chunk - m_node_chunks - m_way_chunks) * m_config.chunk_size;
+                    add_relations(buffer, random, first, std::min(first + m_config.chunk_size, m_config.relations));
+                }
+
+                return buffer;
+            }
+
+            /**
+             * Generate the next chunk. Works like Reader::read(): Returns
+             * an invalid buffer after the last chunk.
+             */
+            osmium::memory::Buffer read() {
+                if (m_next_chunk >= num_chunks()) {
+                    return osmium::memory::Buffer{};
+                }
+                return chunk(m_next_chunk++);
+            }
+
+            /**
+             * Generate all chunks in the thread pool and call func with
+             * each buffer in order. Func is called in the thread calling
+             * this function. Can be used with a Writer as func to write
+             * the data to a file:
+             *
+             * @code
+             * osmium::io::Writer writer{"synthetic.osm.pbf"};
+             * generator.generate(writer);
+             * writer.close();
+             * @endcode
+             */
+            template <typename TFunc>
+            void generate(TFunc&& func, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) const {
+                const auto window = static_cast<std::size_t>(pool.num_threads()) * 2 + 1;
+                std::deque<std::future<osmium::memory::Buffer>> results;
+                std::size_t next = 0;
+                while (next < num_chunks() || !results.empty()) {
+                    while (next < num_chunks() && results.size() < window) {
+                        const std::size_t n = next++;
+                        results.push_back(pool.submit([this, n]() {
+                            return chunk(n);
+                        }));
+                    }
+                    osmium::memory::Buffer buffer{results.front().get()};
+                    results.pop_front();
+                    std::forward<TFunc>(func)(std::move(buffer));
+                }
+            }
+
+        }; // class SyntheticDataGenerator
+
+    } // namespace builder
+
+} // namespace osmium
+
+#endif // OSMIUM_BUILDER_SYNTHETIC_DATA_HPP
@@ -35,15 +35,31 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/area/assembler.hpp>
 #include <osmium/area/multipolygon_collector.hpp>
+#include <osmium/area/multipolygon_manager.hpp>
 #include <osmium/handler/node_locations_for_ways.hpp> // IWYU pragma: keep
+#include <osmium/index/add_locations_to_ways.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/decoded_buffer_callback.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/io/reader.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/relations/manager_util.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/visitor.hpp>
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <set>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -54,17 +70,234 @@ namespace osmium {
      */
     namespace experimental {
 
+        namespace detail {
+
+            /**
+             * Adds node locations to an index which supports
+             * set_concurrent() from several decoder threads at the same
+             * time. Nodes which don't fit into the index (or have negative
+             * IDs) can not be added this way. All buffers that were not
+             * indexed completely by add_concurrent() are indexed by
+             * add_exclusive() when the user gets to them. While that
+             * happens the index can be grown and no other thread writes to
+             * it.
+             */
+            template <typename TLocationHandler>
+            class ConcurrentNodeIndexer {
+
+                std::mutex m_mutex;
+                std::condition_variable m_cv;
+                int m_writers = 0;
+                bool m_exclusive = false;
+
+                // Data pointers of the buffers that were indexed completely
+                // by add_concurrent().
+                std::set<const unsigned char*> m_complete;
+
+            public:
+
+                // Called from the decoder threads.
+                void add_concurrent(TLocationHandler& handler, const osmium::memory::Buffer& buffer) {
+                    {
+                        std::unique_lock<std::mutex> lock{m_mutex};
+                        m_cv.wait(lock, [this] { return !m_exclusive; });
+                        ++m_writers;
+                    }
+
+                    bool complete = true;
+                    auto& storage = handler.storage_pos();
+                    for (const auto& node : buffer.select<osmium::Node>()) {
+                        if (node.id() < 0 || !storage.set_concurrent(node.positive_id(), node.location())) {
+                            complete = false;
+                        }
+                    }
+
+                    {
+                        const std::lock_guard<std::mutex> lock{m_mutex};
+                        --m_writers;
+                        if (complete) {
+                            m_complete.insert(buffer.data());
+                        }
+                    }
+                    m_cv.notify_all();
+                }
+
+                // Called from the thread reading the buffers.
+                void add_exclusive(TLocationHandler& handler, const osmium::memory::Buffer& buffer) {
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    if (m_complete.erase(buffer.data()) > 0) {
+                        return;
+                    }
+
+                    const auto nodes = buffer.select<osmium::Node>();
+                    if (nodes.empty()) {
+                        return;
+                    }
+
+                    m_exclusive = true;
+                    m_cv.wait(lock, [this] { return m_writers == 0; });
+
+                    // Grow the index with some room to spare, so that the
+                    // decoder threads can add the nodes of the next buffers.
+                    osmium::unsigned_object_id_type max_id = 0;
+                    for (const auto& node : nodes) {
+                        if (node.id() > 0) {
+                            max_id = std::max(max_id, node.positive_id());
+                        }
+                    }
+                    auto& storage = handler.storage_pos();
+                    if (storage.size() <= max_id) {
+                        storage.resize(max_id + 1 + std::max<std::size_t>(max_id / 16, 1024UL * 1024UL));
+                    }
+
+                    for (const auto& node : nodes) {
+                        handler.node(node);
+                    }
+
+                    m_exclusive = false;
+                    lock.unlock();
+                    m_cv.notify_all();
+                }
+
+            }; // class ConcurrentNodeIndexer
+
+        } // namespace detail
+
+        /**
+         * Reader that adds node locations to ways and optionally assembles
+         * areas on the fly.
+         *
+         * By default all work is done in read() in the calling thread. If
+         * a thread pool is given to the constructor, FlexReader works as
+         * a pipeline:
+         *
+         * - If the location index for positive IDs supports
+         *   set_concurrent() (the dense indexes), node locations are
+         *   added to the index in the threads decoding the input. The
+         *   index is grown in the reading thread when needed. Call
+         *   resize() on the index before creating the FlexReader if you
+         *   know the largest node ID, then this never happens. The
+         *   locations of the way nodes are then filled in using
+         *   osmium::index::add_locations_to_ways() in the pool. Other
+         *   location indexes are filled and read in the calling thread.
+         * - Areas are assembled in the pool with a MultipolygonManager
+         *   (see MultipolygonManager::enable_parallel_assembly()) instead
+         *   of the MultipolygonCollector. They are added to the buffers
+         *   returned from read() in the order they were created, but
+         *   usually appear in later buffers than without a pool. Areas
+         *   still pending at the end of the input are returned in extra
+         *   buffers before read() returns an invalid buffer. Unlike the
+         *   MultipolygonCollector, the MultipolygonManager doesn't create
+         *   areas from closed ways without tags.
+         */
         template <typename TLocationHandler>
         class FlexReader {
 
+            using node_indexer_type = detail::ConcurrentNodeIndexer<TLocationHandler>;
+
+            enum {
+                concurrent_index = osmium::index::supports_concurrent_set<typename TLocationHandler::index_pos_type>::value
+            };
+
             bool m_with_areas;
             osmium::osm_entity_bits::type m_entities;
 
             TLocationHandler& m_location_handler;
 
+            osmium::thread::Pool* m_pool = nullptr;
+            node_indexer_type m_node_indexer;
+
             osmium::io::Reader m_reader;
             osmium::area::Assembler::config_type m_assembler_config;
             osmium::area::MultipolygonCollector<osmium::area::Assembler> m_collector;
+            osmium::area::MultipolygonManager<osmium::area::Assembler> m_manager;
+
+            // Areas assembled in the pool not yet returned to the user.
+            std::vector<osmium::memory::Buffer> m_area_buffers;
+            bool m_areas_flushed = false;
+
+            osmium::io::decoded_buffer_callback decoder_callback() {
+                if (!m_pool || !concurrent_index || !(m_entities & osmium::osm_entity_bits::node)) {
+                    return osmium::io::decoded_buffer_callback{};
+                }
+                return osmium::io::decoded_buffer_callback{[this](osmium::memory::Buffer& buffer) {
+                    add_nodes_concurrent(buffer, std::integral_constant<bool, concurrent_index>{});
+                }};
+            }
+
+            void add_nodes_concurrent(const osmium::memory::Buffer& buffer, std::true_type /*concurrent_index*/) {
+                m_node_indexer.add_concurrent(m_location_handler, buffer);
+            }
+
+            void add_nodes_concurrent(const osmium::memory::Buffer& /*buffer*/, std::false_type /*concurrent_index*/) noexcept {
+            }
+
+            void add_locations_in_pool(osmium::memory::Buffer& buffer, std::true_type /*concurrent_index*/) {
+                m_node_indexer.add_exclusive(m_location_handler, buffer);
+                osmium::index::add_locations_to_ways(buffer, m_location_handler.storage_pos(), m_location_handler.storage_neg(), *m_pool);
+            }
+
+            void add_locations_in_pool(osmium::memory::Buffer& buffer, std::false_type /*concurrent_index*/) {
+                osmium::apply(buffer, m_location_handler);
+            }
+
+            void add_locations(osmium::memory::Buffer& buffer) {
+                if (!(m_entities & (osmium::osm_entity_bits::node | osmium::osm_entity_bits::way))) {
+                    return;
+                }
+                if (m_pool) {
+                    add_locations_in_pool(buffer, std::integral_constant<bool, concurrent_index>{});
+                } else {
+                    osmium::apply(buffer, m_location_handler);
+                }
+            }
+
+            // Add the areas to the end of the buffer. The buffers from the
+            // Reader don't grow, so if there is not enough space, the
+            // contents is copied into a new buffer first.
+            static void append_areas(osmium::memory::Buffer& buffer, const std::vector<osmium::memory::Buffer>& area_buffers) {
+                std::size_t size = 0;
+                for (const osmium::memory::Buffer& b : area_buffers) {
+                    size += b.committed();
+                }
+                if (size == 0) {
+                    return;
+                }
+
+                if (buffer.capacity() - buffer.committed() < size) {
+                    osmium::memory::Buffer new_buffer{buffer.committed() + size, osmium::memory::Buffer::auto_grow::no};
+                    new_buffer.add_buffer(buffer);
+                    new_buffer.commit();
+                    buffer = std::move(new_buffer);
+                }
+
+                for (const osmium::memory::Buffer& b : area_buffers) {
+                    buffer.add_buffer(b);
+                    buffer.commit();
+                }
+            }
+
+            std::function<void(osmium::memory::Buffer&&)> area_callback() {
+                return [this](osmium::memory::Buffer&& area_buffer) {
+                    m_area_buffers.push_back(std::move(area_buffer));
+                };
+            }
+
+            osmium::memory::Buffer read_remaining_areas() {
+                if (!m_areas_flushed) {
+                    m_areas_flushed = true;
+                    osmium::memory::Buffer rest = m_manager.read();
+                    if (rest.committed() > 0) {
+                        m_area_buffers.push_back(std::move(rest));
+                    }
+                }
+                if (m_area_buffers.empty()) {
+                    return osmium::memory::Buffer{};
+                }
+                osmium::memory::Buffer buffer = std::move(m_area_buffers.front());
+                m_area_buffers.erase(m_area_buffers.begin());
+                return buffer;
+            }
 
         public:
 
@@ -73,7 +306,8 @@ namespace osmium {
                 m_entities((entities & ~osmium::osm_entity_bits::area) | (m_with_areas ? osmium::osm_entity_bits::node | osmium::osm_entity_bits::way : osmium::osm_entity_bits::nothing)),
                 m_location_handler(location_handler),
                 m_reader(file, m_entities),
-                m_collector(m_assembler_config)
+                m_collector(m_assembler_config),
+                m_manager(m_assembler_config)
             {
                 m_location_handler.ignore_errors();
                 if (m_with_areas) {
@@ -91,22 +325,58 @@ namespace osmium {
                 FlexReader(osmium::io::File(filename), location_handler, entities) {
             }
 
+            /**
+             * Create a FlexReader working as a pipeline in the thread pool.
+             * The pool is also used by the Reader for decoding the input.
+             * See the class description for details.
+             */
+            FlexReader(const osmium::io::File& file, TLocationHandler& location_handler, osmium::thread::Pool& pool, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr) :
+                m_with_areas((entities & osmium::osm_entity_bits::area) != 0),
+                m_entities((entities & ~osmium::osm_entity_bits::area) | (m_with_areas ? osmium::osm_entity_bits::node | osmium::osm_entity_bits::way : osmium::osm_entity_bits::nothing)),
+                m_location_handler(location_handler),
+                m_pool(&pool),
+                m_reader(file, m_entities, pool, decoder_callback()),
+                m_collector(m_assembler_config),
+                m_manager(m_assembler_config)
+            {
+                m_location_handler.ignore_errors();
+                if (m_with_areas) {
+                    m_manager.enable_parallel_assembly(pool);
+                    osmium::relations::read_relations(file, m_manager);
+                }
+            }
+
+            FlexReader(const std::string& filename, TLocationHandler& location_handler, osmium::thread::Pool& pool, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr) :
+                FlexReader(osmium::io::File(filename), location_handler, pool, entities) {
+            }
+
+            FlexReader(const char* filename, TLocationHandler& location_handler, osmium::thread::Pool& pool, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr) :
+                FlexReader(osmium::io::File(filename), location_handler, pool, entities) {
+            }
+
             osmium::memory::Buffer read() {
                 osmium::memory::Buffer buffer = m_reader.read();
 
-                if (buffer) {
-                    if (m_with_areas) {
-                        std::vector<osmium::memory::Buffer> area_buffers;
-                        osmium::apply(buffer, m_location_handler, m_collector.handler([&area_buffers](osmium::memory::Buffer&& area_buffer) {
+                if (!buffer) {
+                    if (m_with_areas && m_pool) {
+                        return read_remaining_areas();
+                    }
+                    return buffer;
+                }
+
+                add_locations(buffer);
+
+                if (m_with_areas) {
+                    std::vector<osmium::memory::Buffer> area_buffers;
+                    if (m_pool) {
+                        osmium::apply(buffer, m_manager.handler(area_callback()));
+                        area_buffers.swap(m_area_buffers);
+                    } else {
+                        osmium::apply(buffer, m_collector.handler([&area_buffers](osmium::memory::Buffer&& area_buffer) {
                             area_buffers.push_back(std::move(area_buffer));
                         }));
-                        for (const osmium::memory::Buffer& b : area_buffers) {
-                            buffer.add_buffer(b);
-                            buffer.commit();
-                        }
-                    } else if (m_entities & (osmium::osm_entity_bits::node | osmium::osm_entity_bits::way)) {
-                        osmium::apply(buffer, m_location_handler);
                     }
+                    append_areas(buffer, area_buffers);
                 }
 
                 return buffer;
@@ -121,13 +391,21 @@ namespace osmium {
             }
 
             bool eof() const {
-                return m_reader.eof();
+                return m_reader.eof() && (!m_with_areas || !m_pool || (m_areas_flushed && m_area_buffers.empty()));
             }
 
             const osmium::area::MultipolygonCollector<osmium::area::Assembler>& collector() const {
                 return m_collector;
             }
 
+            /**
+             * The manager used for assembling areas if a thread pool was
+             * given to the constructor.
+             */
+            const osmium::area::MultipolygonManager<osmium::area::Assembler>& manager() const {
+                return m_manager;
+            }
+
         }; // class FlexReader
 
     } // namespace experimental
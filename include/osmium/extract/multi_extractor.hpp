@@ -0,0 +1,405 @@
+#ifndef OSMIUM_EXTRACT_MULTI_EXTRACTOR_HPP
+#define OSMIUM_EXTRACT_MULTI_EXTRACTOR_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/extract/polygon.hpp>
+#include <osmium/handler/check_order.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace extract {
+
+        /**
+         * One extract of a MultiExtractor. It keeps track of the IDs of
+         * all objects in the extract and collects them in a buffer which
+         * is handed to the output function whenever it is full.
+         *
+         * This uses the "simple" strategy: An extract contains all nodes
+         * inside the polygon, all ways with at least one of those nodes
+         * and all relations with at least one member in the extract.
+         * Relations referencing relations later in the input are not
+         * found. Input must be sorted in the usual order (nodes, then
+         * ways, then relations).
+         */
+        class Extract {
+
+        public:
+
+            using output_type = std::function<void(osmium::memory::Buffer&&)>;
+            using id_set_type = osmium::index::IdSetDense<osmium::unsigned_object_id_type>;
+
+        private:
+
+            Polygon m_polygon;
+            output_type m_output;
+            std::size_t m_buffer_size;
+            osmium::memory::Buffer m_buffer;
+
+            id_set_type m_node_ids;
+            id_set_type m_way_ids;
+            id_set_type m_relation_ids;
+
+            void add(const osmium::OSMObject& object) {
+                m_buffer.add_item(object);
+                m_buffer.commit();
+                if (m_buffer.committed() >= m_buffer_size) {
+                    flush();
+                }
+            }
+
+            bool has_member(const osmium::RelationMember& member) const noexcept {
+                switch (member.type()) {
+                    case osmium::item_type::node:
+                        return m_node_ids.get(member.positive_ref());
+                    case osmium::item_type::way:
+                        return m_way_ids.get(member.positive_ref());
+                    case osmium::item_type::relation:
+                        return m_relation_ids.get(member.positive_ref());
+                    default:
+                        break;
+                }
+                return false;
+            }
+
+        public:
+
+            Extract(Polygon polygon, output_type output, std::size_t buffer_size) :
+                m_polygon(std::move(polygon)),
+                m_output(std::move(output)),
+                m_buffer_size(buffer_size),
+                m_buffer(buffer_size, osmium::memory::Buffer::auto_grow::yes) {
+            }
+
+            const Polygon& polygon() const noexcept {
+                return m_polygon;
+            }
+
+            /// IDs of all nodes in the extract.
+            const id_set_type& node_ids() const noexcept {
+                return m_node_ids;
+            }
+
+            /// IDs of all ways in the extract.
+            const id_set_type& way_ids() const noexcept {
+                return m_way_ids;
+            }
+
+            /// IDs of all relations in the extract.
+            const id_set_type& relation_ids() const noexcept {
+                return m_relation_ids;
+            }
+
+            void node(const osmium::Node& node) {
+                if (m_polygon.contains(node.location())) {
+                    m_node_ids.set(node.positive_id());
+                    add(node);
+                }
+            }
+
+            void way(const osmium::Way& way) {
+                for (const auto& node_ref : way.nodes()) {
+                    if (m_node_ids.get(node_ref.positive_ref())) {
+                        m_way_ids.set(way.positive_id());
+                        add(way);
+                        return;
+                    }
+                }
+            }
+
+            void relation(const osmium::Relation& relation) {
+                for (const auto& member : relation.members()) {
+                    if (has_member(member)) {
+                        m_relation_ids.set(relation.positive_id());
+                        add(relation);
+                        return;
+                    }
+                }
+            }
+
+            /**
+             * Hand the buffer with all objects collected so far to the
+             * output function, even if it isn't full yet.
+             */
+            void flush() {
+                if (m_buffer.committed() == 0) {
+                    return;
+                }
+                osmium::memory::Buffer buffer{m_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                using std::swap;
+                swap(buffer, m_buffer);
+                m_output(std::move(buffer));
+            }
+
+        }; // class Extract
+
+        /**
+         * Cut any number of extracts from OSM data in a single pass.
+         *
+         * Add all extracts with add_extract(), then feed the buffers with
+         * the input data in order into operator() and call flush() at the
+         * end (or call run() which does all this for a Reader). The
+         * objects in each extract are given to its output function in
+         * buffers in the order they appear in the input. Usually the
+         * output function will give the buffers to an osmium::io::Writer.
+         *
+         * The extracts are distributed over the threads of the pool.
+         * Each extract is handled by one thread only, so the output
+         * functions of different extracts can be called at the same time,
+         * but the output function of one extract is never called
+         * concurrently.
+         *
+         * See Extract for which objects end up in which extract. The
+         * input must be sorted, this is checked in the calling thread
+         * unless it is known to be sorted (see assume_sorted_input()).
+         */
+        class MultiExtractor {
+
+            osmium::thread::Pool& m_pool;
+            std::vector<std::unique_ptr<Extract>> m_extracts;
+            std::size_t m_buffer_size;
+            osmium::handler::CheckOrder m_check_order;
+            bool m_input_is_sorted = false;
+
+            void check_order(const osmium::memory::Buffer& buffer) {
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    switch (object.type()) {
+                        case osmium::item_type::node:
+                            m_check_order.node(static_cast<const osmium::Node&>(object));
+                            break;
+                        case osmium::item_type::way:
+                            m_check_order.way(static_cast<const osmium::Way&>(object));
+                            break;
+                        case osmium::item_type::relation:
+                            m_check_order.relation(static_cast<const osmium::Relation&>(object));
+                            break;
+                        default:
+                            break;
+                    }
+                }
+            }
+
+            void process(const osmium::memory::Buffer& buffer, std::size_t begin, std::size_t end) {
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    switch (object.type()) {
+                        case osmium::item_type::node: {
+                                const auto& node = static_cast<const osmium::Node&>(object);
+                                for (auto i = begin; i != end; ++i) {
+                                    m_extracts[i]->node(node);
+                                }
+                            }
+                            break;
+                        case osmium::item_type::way: {
+                                const auto& way = static_cast<const osmium::Way&>(object);
+                                for (auto i = begin; i != end; ++i) {
+                                    m_extracts[i]->way(way);
+                                }
+                            }
+                            break;
+                        case osmium::item_type::relation: {
+                                const auto& relation = static_cast<const osmium::Relation&>(object);
+                                for (auto i = begin; i != end; ++i) {
+                                    m_extracts[i]->relation(relation);
+                                }
+                            }
+                            break;
+                        default:
+                            break;
+                    }
+                }
+            }
+
+        public:
+
+            enum : std::size_t {
+                default_buffer_size = 1024UL * 1024UL
+            };
+
+            /**
+             * Constructor.
+             *
+             * @param pool The thread pool to use.
+             * @param buffer_size Size of the output buffers of each extract.
+             */
+            explicit MultiExtractor(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(),
+                                    std::size_t buffer_size = default_buffer_size) :
+                m_pool(pool),
+                m_buffer_size(buffer_size) {
+            }
+
+            /**
+             * Add an extract.
+             *
+             * @param polygon The area covered by the extract.
+             * @param output Function called with buffers of objects in the
+             *               extract.
+             * @returns The index of the new extract.
+             */
+            std::size_t add_extract(Polygon polygon, Extract::output_type output) {
+                m_extracts.emplace_back(new Extract{std::move(polygon), std::move(output), m_buffer_size});
+                return m_extracts.size() - 1;
+            }
+
+            /// The number of extracts.
+            std::size_t size() const noexcept {
+                return m_extracts.size();
+            }
+
+            /// Access extract with the given index.
+            const Extract& extract(std::size_t n) const {
+                return *m_extracts.at(n);
+            }
+
+            /**
+             * Tell the extractor that the input is known to be sorted, so
+             * that it doesn't have to check the order of the objects
+             * itself.
+             */
+            void assume_sorted_input(bool sorted = true) noexcept {
+                m_input_is_sorted = sorted;
+            }
+
+            /**
+             * Don't check the order of the objects if the header says
+             * that the input is sorted and this is verified by the Reader
+             * (see osmium::io::Header::sorted_and_verified() and the
+             * osmium::io::verify_sorting option of the Reader).
+             */
+            void assume_sorted_input(const osmium::io::Header& header) noexcept {
+                m_input_is_sorted = header.sorted_and_verified();
+            }
+
+            /**
+             * Add all objects in the buffer to the extracts they belong
+             * to. Call this with all buffers in the input data in order.
+             *
+             * @throws osmium::out_of_order_error If the input is not
+             *         sorted. Nothing from the buffer is added to any
+             *         extract in this case.
+             * @throws Any exception thrown by an output function.
+             */
+            void operator()(const osmium::memory::Buffer& buffer) {
+                if (!m_input_is_sorted) {
+                    check_order(buffer);
+                }
+
+                const auto num_tasks = std::min(m_extracts.size(), static_cast<std::size_t>(m_pool.num_threads()));
+                if (num_tasks <= 1) {
+                    process(buffer, 0, m_extracts.size());
+                    return;
+                }
+
+                std::vector<std::future<void>> futures;
+                futures.reserve(num_tasks);
+                for (std::size_t task = 0; task < num_tasks; ++task) {
+                    const auto begin = m_extracts.size() * task / num_tasks;
+                    const auto end = m_extracts.size() * (task + 1) / num_tasks;
+                    futures.push_back(m_pool.submit([this, &buffer, begin, end] {
+                        process(buffer, begin, end);
+                    }));
+                }
+
+                // The tasks use the buffer, wait for all of them even if
+                // one fails.
+                std::exception_ptr exception;
+                for (auto& future : futures) {
+                    try {
+                        future.get();
+                    } catch (...) {
+                        if (!exception) {
+                            exception = std::current_exception();
+                        }
+                    }
+                }
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+            }
+
+            /**
+             * Hand the remaining objects of all extracts to their output
+             * functions. Call this after the last buffer.
+             *
+             * @throws Any exception thrown by an output function.
+             */
+            void flush() {
+                for (auto& extract : m_extracts) {
+                    extract->flush();
+                }
+            }
+
+            /**
+             * Read all buffers from the source (usually an
+             * osmium::io::Reader), add their objects to the extracts
+             * and flush the extracts at the end. If the header of the
+             * source says the input is sorted and this is verified, the
+             * order of the objects is not checked again.
+             */
+            template <typename TSource>
+            void run(TSource& source) {
+                if (source.header().sorted_and_verified()) {
+                    m_input_is_sorted = true;
+                }
+                while (osmium::memory::Buffer buffer = source.read()) {
+                    (*this)(buffer);
+                }
+                flush();
+            }
+
+        }; // class MultiExtractor
+
+    } // namespace extract
+
+} // namespace osmium
+
+#endif // OSMIUM_EXTRACT_MULTI_EXTRACTOR_HPP
@@ -0,0 +1,351 @@
+#ifndef OSMIUM_EXTRACT_POLYGON_HPP
+#define OSMIUM_EXTRACT_POLYGON_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * @brief Extracting parts of OSM data sets.
+     */
+    namespace extract {
+
+        /**
+         * A (multi)polygon with a precomputed acceleration structure for
+         * fast point-in-polygon checks.
+         *
+         * The bounding box of the polygon is divided into a grid of
+         * cells. Each cell is marked as completely inside, completely
+         * outside, or as a boundary cell crossed by at least one segment
+         * of the polygon. Only locations in boundary cells need an actual
+         * point-in-polygon check, and that check only looks at the
+         * segments overlapping the row of cells the location is in.
+         *
+         * Rings are interpreted using the even-odd rule, so inner rings
+         * are holes. The direction of the rings doesn't matter. Whether
+         * a location exactly on the boundary is inside or not is not
+         * defined.
+         */
+        class Polygon {
+
+            enum class cell_state : uint8_t {
+                outside  = 0,
+                inside   = 1,
+                boundary = 2
+            };
+
+            // Segments are stored with y1 <= y2. Horizontal segments are
+            // never needed for the crossing test, they are only used
+            // while building the grid.
+            struct segment {
+                int32_t x1;
+                int32_t y1;
+                int32_t x2;
+                int32_t y2;
+            };
+
+            osmium::Box m_box;
+            std::vector<segment> m_segments;
+            std::vector<segment> m_horizontal_segments;
+
+            // Polygon is just the box, no index needed.
+            bool m_is_box = false;
+
+            int64_t m_min_x = 0;
+            int64_t m_min_y = 0;
+            int64_t m_cell_width = 1;
+            int64_t m_cell_height = 1;
+            std::size_t m_grid_size = 0;
+
+            std::vector<cell_state> m_cells;
+
+            // Indexes into m_segments for all segments overlapping a row
+            // of cells. The segments for row r are at positions
+            // m_row_offsets[r] to m_row_offsets[r + 1] in m_row_segments.
+            std::vector<std::size_t> m_row_offsets;
+            std::vector<uint32_t> m_row_segments;
+
+            std::size_t column(const int64_t x) const noexcept {
+                return static_cast<std::size_t>((x - m_min_x) / m_cell_width);
+            }
+
+            std::size_t row(const int64_t y) const noexcept {
+                return static_cast<std::size_t>((y - m_min_y) / m_cell_height);
+            }
+
+            // Does a ray from the location to the right cross the segment?
+            static bool crosses(const segment& seg, const int64_t x, const int64_t y) noexcept {
+                if (y < seg.y1 || y >= seg.y2) {
+                    return false;
+                }
+                // Compare x with the x coordinate of the segment at y.
+                // All values fit into 64 bit: the differences in x are at
+                // most 360 degrees, in y at most 180 degrees.
+                return (x - seg.x1) * (int64_t(seg.y2) - seg.y1) < (y - seg.y1) * (int64_t(seg.x2) - seg.x1);
+            }
+
+            bool check_row(const std::size_t r, const int64_t x, const int64_t y) const noexcept {
+                bool inside = false;
+                for (auto i = m_row_offsets[r]; i < m_row_offsets[r + 1]; ++i) {
+                    inside ^= crosses(m_segments[m_row_segments[i]], x, y);
+                }
+                return inside;
+            }
+
+            void add_ring(const std::vector<osmium::Location>& ring) {
+                if (ring.size() < 3) {
+                    return;
+                }
+                for (std::size_t i = 0; i < ring.size(); ++i) {
+                    const auto& a = ring[i];
+                    const auto& b = ring[(i + 1) % ring.size()];
+                    if (!a.valid() || !b.valid()) {
+                        throw std::invalid_argument{"invalid location in extract polygon"};
+                    }
+                    m_box.extend(a);
+                    if (a.y() < b.y()) {
+                        m_segments.push_back(segment{a.x(), a.y(), b.x(), b.y()});
+                    } else if (a.y() > b.y()) {
+                        m_segments.push_back(segment{b.x(), b.y(), a.x(), a.y()});
+                    } else {
+                        m_horizontal_segments.push_back(segment{std::min(a.x(), b.x()), a.y(), std::max(a.x(), b.x()), b.y()});
+                    }
+                }
+            }
+
+            // Rows overlapped by the segment, and for each of those rows
+            // the columns.
+            template <typename TFunc>
+            void for_each_cell(const segment& seg, TFunc&& func) const {
+                if (seg.y1 == seg.y2) {
+                    const auto r = row(seg.y1);
+                    for (auto c = column(seg.x1); c <= column(seg.x2); ++c) {
+                        func(r, c);
+                    }
+                    return;
+                }
+                const auto first_row = row(seg.y1);
+                const auto last_row = row(seg.y2);
+                for (auto r = first_row; r <= last_row; ++r) {
+                    // Part of the segment in this row.
+                    const auto row_y1 = std::max(int64_t(seg.y1), m_min_y + int64_t(r) * m_cell_height);
+                    const auto row_y2 = std::min(int64_t(seg.y2), m_min_y + int64_t(r + 1) * m_cell_height);
+                    const double dx = double(seg.x2) - double(seg.x1);
+                    const double dy = double(seg.y2) - double(seg.y1);
+                    const double xa = double(seg.x1) + dx * double(row_y1 - seg.y1) / dy;
+                    const double xb = double(seg.x1) + dx * double(row_y2 - seg.y1) / dy;
+                    auto first_col = column(std::max(m_min_x, static_cast<int64_t>(std::min(xa, xb))));
+                    auto last_col = column(std::min(int64_t(m_box.top_right().x()), static_cast<int64_t>(std::max(xa, xb))));
+                    // Rounding errors could miss a cell, be generous.
+                    first_col = first_col > 0 ? first_col - 1 : 0;
+                    last_col = std::min(last_col + 1, m_grid_size - 1);
+                    for (auto c = first_col; c <= last_col; ++c) {
+                        func(r, c);
+                    }
+                }
+            }
+
+            void build_index(std::size_t grid_size) {
+                if (m_segments.empty()) {
+                    throw std::invalid_argument{"extract polygon without area"};
+                }
+
+                m_min_x = m_box.bottom_left().x();
+                m_min_y = m_box.bottom_left().y();
+                const int64_t width = int64_t(m_box.top_right().x()) - m_min_x + 1;
+                const int64_t height = int64_t(m_box.top_right().y()) - m_min_y + 1;
+                m_grid_size = std::max(std::size_t(1), std::min(grid_size, static_cast<std::size_t>(std::min(width, height))));
+                m_cell_width = (width + int64_t(m_grid_size) - 1) / int64_t(m_grid_size);
+                m_cell_height = (height + int64_t(m_grid_size) - 1) / int64_t(m_grid_size);
+
+                // Collect segments per row (counting first, then filling)
+                // and mark boundary cells.
+                m_cells.assign(m_grid_size * m_grid_size, cell_state::outside);
+                m_row_offsets.assign(m_grid_size + 1, 0);
+                for (const auto& seg : m_segments) {
+                    for (auto r = row(seg.y1); r <= row(seg.y2); ++r) {
+                        ++m_row_offsets[r + 1];
+                    }
+                    for_each_cell(seg, [this](std::size_t r, std::size_t c) {
+                        m_cells[r * m_grid_size + c] = cell_state::boundary;
+                    });
+                }
+                for (const auto& seg : m_horizontal_segments) {
+                    for_each_cell(seg, [this](std::size_t r, std::size_t c) {
+                        m_cells[r * m_grid_size + c] = cell_state::boundary;
+                    });
+                }
+                m_horizontal_segments.clear();
+                m_horizontal_segments.shrink_to_fit();
+                for (std::size_t r = 0; r < m_grid_size; ++r) {
+                    m_row_offsets[r + 1] += m_row_offsets[r];
+                }
+                m_row_segments.resize(m_row_offsets.back());
+                std::vector<std::size_t> fill{m_row_offsets.begin(), m_row_offsets.end() - 1};
+                for (std::size_t i = 0; i < m_segments.size(); ++i) {
+                    for (auto r = row(m_segments[i].y1); r <= row(m_segments[i].y2); ++r) {
+                        m_row_segments[fill[r]++] = static_cast<uint32_t>(i);
+                    }
+                }
+
+                // Cells not crossed by any segment are either completely
+                // inside or outside. Check their centers.
+                for (std::size_t r = 0; r < m_grid_size; ++r) {
+                    const int64_t y = m_min_y + int64_t(r) * m_cell_height + m_cell_height / 2;
+                    for (std::size_t c = 0; c < m_grid_size; ++c) {
+                        auto& cell = m_cells[r * m_grid_size + c];
+                        if (cell != cell_state::boundary) {
+                            const int64_t x = m_min_x + int64_t(c) * m_cell_width + m_cell_width / 2;
+                            cell = check_row(r, x, y) ? cell_state::inside : cell_state::outside;
+                        }
+                    }
+                }
+            }
+
+        public:
+
+            enum : std::size_t {
+                default_grid_size = 256
+            };
+
+            /**
+             * Create polygon from rings given as lists of locations. The
+             * rings don't need to be closed explicitly, the last location
+             * is always connected to the first.
+             *
+             * @param rings The outer and inner rings.
+             * @param grid_size Number of grid cells in x and y direction.
+             * @throws std::invalid_argument if a location is invalid or
+             *         the polygon has no area.
+             */
+            explicit Polygon(const std::vector<std::vector<osmium::Location>>& rings, std::size_t grid_size = default_grid_size) {
+                for (const auto& ring : rings) {
+                    add_ring(ring);
+                }
+                build_index(grid_size);
+            }
+
+            /**
+             * Create polygon from a box. Locations on the boundary of the
+             * box are inside, just like with Box::contains().
+             *
+             * @throws std::invalid_argument if the box is invalid.
+             */
+            explicit Polygon(const osmium::Box& box) :
+                m_box(box),
+                m_is_box(true) {
+                if (!box.valid()) {
+                    throw std::invalid_argument{"invalid box for extract polygon"};
+                }
+            }
+
+            /**
+             * Create polygon from the outer and inner rings of an area.
+             *
+             * @throws std::invalid_argument if a location is invalid or
+             *         the polygon has no area.
+             */
+            explicit Polygon(const osmium::Area& area, std::size_t grid_size = default_grid_size) {
+                std::vector<osmium::Location> ring;
+                const auto add = [&](const osmium::NodeRefList& node_refs) {
+                    ring.clear();
+                    for (const auto& node_ref : node_refs) {
+                        ring.push_back(node_ref.location());
+                    }
+                    add_ring(ring);
+                };
+                for (const auto& outer : area.outer_rings()) {
+                    add(outer);
+                    for (const auto& inner : area.inner_rings(outer)) {
+                        add(inner);
+                    }
+                }
+                build_index(grid_size);
+            }
+
+            /**
+             * The bounding box of the polygon.
+             */
+            const osmium::Box& envelope() const noexcept {
+                return m_box;
+            }
+
+            /**
+             * The number of grid cells in x and y direction. This is 0 if
+             * the polygon was created from a box.
+             */
+            std::size_t grid_size() const noexcept {
+                return m_grid_size;
+            }
+
+            /**
+             * Is the location inside the polygon? Invalid and undefined
+             * locations are never inside.
+             */
+            bool contains(const osmium::Location& location) const noexcept {
+                if (!location.valid() || !m_box.contains(location)) {
+                    return false;
+                }
+                if (m_is_box) {
+                    return true;
+                }
+                const int64_t x = location.x();
+                const int64_t y = location.y();
+                const auto r = row(y);
+                const auto cell = m_cells[r * m_grid_size + column(x)];
+                if (cell != cell_state::boundary) {
+                    return cell == cell_state::inside;
+                }
+                return check_row(r, x, y);
+            }
+
+        }; // class Polygon
+
+    } // namespace extract
+
+} // namespace osmium
+
+#endif // OSMIUM_EXTRACT_POLYGON_HPP
@@ -0,0 +1,266 @@
+#ifndef OSMIUM_EXTRACT_SNAPSHOT_EXTRACTOR_HPP
+#define OSMIUM_EXTRACT_SNAPSHOT_EXTRACTOR_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/diff_object.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/timestamp.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace extract {
+
+        /**
+         * One snapshot of a SnapshotExtractor. It collects the objects
+         * visible at its point in time in a buffer which is handed to
+         * the output function whenever it is full.
+         */
+        class Snapshot {
+
+        public:
+
+            using output_type = std::function<void(osmium::memory::Buffer&&)>;
+
+        private:
+
+            osmium::Timestamp m_timestamp;
+            output_type m_output;
+            std::size_t m_buffer_size;
+            osmium::memory::Buffer m_buffer;
+
+        public:
+
+            Snapshot(const osmium::Timestamp& timestamp, output_type output, std::size_t buffer_size) :
+                m_timestamp(timestamp),
+                m_output(std::move(output)),
+                m_buffer_size(buffer_size),
+                m_buffer(buffer_size, osmium::memory::Buffer::auto_grow::yes) {
+            }
+
+            const osmium::Timestamp& timestamp() const noexcept {
+                return m_timestamp;
+            }
+
+            void add(const osmium::OSMObject& object) {
+                m_buffer.add_item(object);
+                m_buffer.commit();
+                if (m_buffer.committed() >= m_buffer_size) {
+                    flush();
+                }
+            }
+
+            /**
+             * Hand the buffer with all objects collected so far to the
+             * output function, even if it isn't full yet.
+             */
+            void flush() {
+                if (m_buffer.committed() == 0) {
+                    return;
+                }
+                osmium::memory::Buffer buffer{m_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                using std::swap;
+                swap(buffer, m_buffer);
+                m_output(std::move(buffer));
+            }
+
+        }; // class Snapshot
+
+        /**
+         * Create any number of snapshots (the data as it was at some point
+         * in time) from a history file in a single pass.
+         *
+         * Add all snapshots with add_snapshot(), then feed the buffers with
+         * the history data in order into operator() and call flush() at the
+         * end (or call run() which does all this for a Reader). The input
+         * must be sorted by type, ID, and version. Each snapshot gets the
+         * versions of the objects visible at its point in time, using the
+         * same rules as DiffObject::is_visible_at(). Deleted objects are
+         * not in the snapshots. The objects are given to the output
+         * function of the snapshot in buffers in the order they appear in
+         * the input. Usually the output function will give the buffers to
+         * an osmium::io::Writer.
+         */
+        class SnapshotExtractor {
+
+            std::vector<std::unique_ptr<Snapshot>> m_snapshots;
+
+            // Snapshots sorted by timestamp.
+            std::vector<Snapshot*> m_by_time;
+
+            // The last object from the previous buffer. It can only be
+            // handled when we know the next object.
+            osmium::memory::Buffer m_last_object{1024, osmium::memory::Buffer::auto_grow::yes};
+
+            std::size_t m_buffer_size;
+
+            // Add the current object version to all snapshots it is
+            // visible in. The next object is used to find out until when
+            // this version is valid.
+            void handle(const osmium::OSMObject& curr, const osmium::OSMObject& next) {
+                if (!curr.visible()) {
+                    return;
+                }
+
+                const bool same = curr.type() == next.type() && curr.id() == next.id();
+                const osmium::DiffObject diff{curr, curr, same ? next : curr};
+                const auto start = diff.start_time();
+
+                // The snapshots the version is visible in are the ones
+                // with a timestamp in [start, end).
+                auto it = std::lower_bound(m_by_time.begin(), m_by_time.end(), start, [](const Snapshot* snapshot, const osmium::Timestamp& timestamp) {
+                    return snapshot->timestamp() < timestamp;
+                });
+                for (; it != m_by_time.end() && diff.is_visible_at((*it)->timestamp()); ++it) {
+                    (*it)->add(curr);
+                }
+            }
+
+        public:
+
+            enum : std::size_t {
+                default_buffer_size = 1024UL * 1024UL
+            };
+
+            /**
+             * Constructor.
+             *
+             * @param buffer_size Size of the output buffers of each snapshot.
+             */
+            explicit SnapshotExtractor(std::size_t buffer_size = default_buffer_size) :
+                m_buffer_size(buffer_size) {
+            }
+
+            /**
+             * Add a snapshot.
+             *
+             * @param timestamp The point in time for the snapshot.
+             * @param output Function called with buffers of objects in the
+             *               snapshot.
+             * @returns The index of the new snapshot.
+             */
+            std::size_t add_snapshot(const osmium::Timestamp& timestamp, Snapshot::output_type output) {
+                m_snapshots.emplace_back(new Snapshot{timestamp, std::move(output), m_buffer_size});
+                const auto it = std::upper_bound(m_by_time.begin(), m_by_time.end(), timestamp, [](const osmium::Timestamp& ts, const Snapshot* snapshot) {
+                    return ts < snapshot->timestamp();
+                });
+                m_by_time.insert(it, m_snapshots.back().get());
+                return m_snapshots.size() - 1;
+            }
+
+            /// The number of snapshots.
+            std::size_t size() const noexcept {
+                return m_snapshots.size();
+            }
+
+            /// Access snapshot with the given index.
+            const Snapshot& snapshot(std::size_t n) const {
+                return *m_snapshots.at(n);
+            }
+
+            /**
+             * Add all objects in the buffer to the snapshots they belong
+             * to. Call this with all buffers in the input data in order.
+             *
+             * @throws Any exception thrown by an output function.
+             */
+            void operator()(const osmium::memory::Buffer& buffer) {
+                const osmium::OSMObject* prev = nullptr;
+                if (m_last_object.committed() > 0) {
+                    prev = &*m_last_object.begin<osmium::OSMObject>();
+                }
+
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (prev) {
+                        handle(*prev, object);
+                    }
+                    prev = &object;
+                }
+
+                if (prev && m_last_object.committed() > 0 && prev == &*m_last_object.begin<osmium::OSMObject>()) {
+                    return;
+                }
+                m_last_object.clear();
+                if (prev) {
+                    m_last_object.add_item(*prev);
+                    m_last_object.commit();
+                }
+            }
+
+            /**
+             * Handle the last object and hand the remaining objects of all
+             * snapshots to their output functions. Call this after the last
+             * buffer.
+             *
+             * @throws Any exception thrown by an output function.
+             */
+            void flush() {
+                if (m_last_object.committed() > 0) {
+                    const auto& object = *m_last_object.begin<osmium::OSMObject>();
+                    handle(object, object);
+                    m_last_object.clear();
+                }
+                for (auto& snapshot : m_snapshots) {
+                    snapshot->flush();
+                }
+            }
+
+            /**
+             * Read all buffers from the source (usually an
+             * osmium::io::Reader opened on a history file), add their
+             * objects to the snapshots and flush the snapshots at the end.
+             */
+            template <typename TSource>
+            void run(TSource& source) {
+                while (osmium::memory::Buffer buffer = source.read()) {
+                    (*this)(buffer);
+                }
+                flush();
+            }
+
+        }; // class SnapshotExtractor
+
+    } // namespace extract
+
+} // namespace osmium
+
+#endif // OSMIUM_EXTRACT_SNAPSHOT_EXTRACTOR_HPP
@@ -44,8 +44,10 @@ DEALINGS IN THE SOFTWARE.
 namespace osmium {
 
     class Area;
+    class BoundingBox;
     class Box;
     class Changeset;
+    class CompressedWayNodeList;
     class ChangesetComment;
     class ChangesetDiscussion;
     class InnerRing;
@@ -34,9 +34,11 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/simplify.hpp>
 #include <osmium/memory/collection.hpp>
 #include <osmium/memory/item.hpp>
 #include <osmium/osm/area.hpp>
+#include <osmium/osm/compressed_way_node_list.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
@@ -49,7 +51,9 @@ DEALINGS IN THE SOFTWARE.
 #include <cstddef>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -120,6 +124,28 @@ namespace osmium {
             forward  = false ///< Linestring has same direction as way.
         }; // enum class direction
 
+        namespace detail {
+
+            /**
+             * Check whether a projection has a batch version of its
+             * operator() taking a pointer to the first of a number of
+             * locations and a pointer to the output coordinates.
+             */
+            template <typename TProjection>
+            struct has_batch_projection {
+
+                template <typename T>
+                static auto check(int) -> decltype(std::declval<const T&>()(std::declval<const osmium::Location*>(), std::size_t{}, std::declval<Coordinates*>()), std::true_type{});
+
+                template <typename T>
+                static std::false_type check(...);
+
+                using type = decltype(check<TProjection>(0));
+
+            }; // struct has_batch_projection
+
+        } // namespace detail
+
         /**
          * This pseudo projection just returns its WGS84 input unchanged.
          * Used as a template parameter if a real projection is not needed.
@@ -148,25 +174,91 @@ namespace osmium {
         template <typename TGeomImpl, typename TProjection = IdentityProjection>
         class GeometryFactory {
 
-            /**
-             * Add all points of an outer or inner ring to a multipolygon.
-             */
-            void add_points(const osmium::NodeRefList& nodes) {
+            TProjection m_projection;
+            TGeomImpl m_impl;
+
+            // Used for projections with a batch version of operator().
+            std::vector<osmium::Location> m_locations;
+            std::vector<Coordinates> m_coordinates;
+
+            // Used for simplification.
+            double m_simplification_tolerance = 0.0;
+            DouglasPeucker m_simplifier{0.0};
+            std::vector<Coordinates> m_unsimplified;
+            std::vector<Coordinates> m_simplified;
+
+            template <typename TIter, typename TFunc>
+            std::size_t add_locations(TIter it, TIter end, bool unique, TFunc&& func, std::false_type /*batch*/) {
+                std::size_t num_points = 0;
                 osmium::Location last_location;
-                for (const osmium::NodeRef& node_ref : nodes) {
-                    if (last_location != node_ref.location()) {
-                        last_location = node_ref.location();
-                        m_impl.multipolygon_add_location(m_projection(last_location));
+                for (; it != end; ++it) {
+                    if (!unique || last_location != it->location()) {
+                        last_location = it->location();
+                        func(m_projection(last_location));
+                        ++num_points;
                     }
                 }
+                return num_points;
             }
 
-            TProjection m_projection;
-            TGeomImpl m_impl;
+            template <typename TIter, typename TFunc>
+            std::size_t add_locations(TIter it, TIter end, bool unique, TFunc&& func, std::true_type /*batch*/) {
+                m_locations.clear();
+                for (; it != end; ++it) {
+                    if (!unique || m_locations.empty() || m_locations.back() != it->location()) {
+                        m_locations.push_back(it->location());
+                    }
+                }
+                if (unique && !m_locations.empty() && !m_locations.front()) {
+                    // the loop above doesn't skip leading undefined
+                    // locations like the non-batch version does
+                    m_locations.erase(m_locations.begin());
+                }
+
+                m_coordinates.resize(m_locations.size());
+                m_projection(m_locations.data(), m_locations.size(), m_coordinates.data());
+                for (const auto& coordinates : m_coordinates) {
+                    func(coordinates);
+                }
+                return m_coordinates.size();
+            }
+
+            /**
+             * Project the locations from the node refs between it and end
+             * and call func with the resulting coordinates. If unique is
+             * set, consecutive nodes with the same location are only used
+             * once. Returns the number of points added.
+             */
+            template <typename TIter, typename TFunc>
+            std::size_t add_locations(TIter it, TIter end, bool unique, TFunc&& func) {
+                using batch = typename detail::has_batch_projection<TProjection>::type;
+                if (m_simplification_tolerance <= 0.0) {
+                    return add_locations(it, end, unique, std::forward<TFunc>(func), batch{});
+                }
+
+                m_unsimplified.clear();
+                add_locations(it, end, unique, [this](const Coordinates& coordinates) {
+                    m_unsimplified.push_back(coordinates);
+                }, batch{});
+                m_simplifier(m_unsimplified, m_simplified);
+                for (const auto& coordinates : m_simplified) {
+                    func(coordinates);
+                }
+                return m_simplified.size();
+            }
+
+            /**
+             * Add all points of an outer or inner ring to a multipolygon.
+             */
+            void add_points(const osmium::NodeRefList& nodes) {
+                add_locations(nodes.cbegin(), nodes.cend(), true, [this](const Coordinates& coordinates) {
+                    m_impl.multipolygon_add_location(coordinates);
+                });
+            }
 
         public:
 
-            GeometryFactory<TGeomImpl, TProjection>() :
+            GeometryFactory() :
                 m_projection(),
                 m_impl(m_projection.epsg()) {
             }
@@ -175,7 +267,7 @@ namespace osmium {
              * Constructor for default initialized projection.
              */
             template <typename... TArgs>
-            explicit GeometryFactory<TGeomImpl, TProjection>(TArgs&&... args) :
+            explicit GeometryFactory(TArgs&&... args) :
                 m_projection(),
                 m_impl(m_projection.epsg(), std::forward<TArgs>(args)...) {
             }
@@ -185,7 +277,7 @@ namespace osmium {
              * projection is moved into the GeometryFactory.
              */
             template <typename... TArgs>
-            explicit GeometryFactory<TGeomImpl, TProjection>(TProjection&& projection, TArgs&&... args) :
+            explicit GeometryFactory(TProjection&& projection, TArgs&&... args) :
                 m_projection(std::move(projection)),
                 m_impl(m_projection.epsg(), std::forward<TArgs>(args)...) {
             }
@@ -202,6 +294,22 @@ namespace osmium {
                 return m_projection.epsg();
             }
 
+            /**
+             * Simplify all linestrings and rings with the Douglas-Peucker
+             * algorithm before they are handed to the geometry
+             * implementation. The tolerance is in projected coordinates
+             * (the units of the projection). Use 0 (the default) to
+             * disable simplification. See DouglasPeucker for details.
+             */
+            void set_simplification_tolerance(double tolerance) {
+                m_simplification_tolerance = tolerance;
+                m_simplifier = DouglasPeucker{tolerance};
+            }
+
+            double simplification_tolerance() const noexcept {
+                return m_simplification_tolerance;
+            }
+
             std::string proj_string() const {
                 return m_projection.proj_string();
             }
@@ -238,25 +346,16 @@ namespace osmium {
 
             template <typename TIter>
             size_t fill_linestring(TIter it, TIter end) {
-                size_t num_points = 0;
-                for (; it != end; ++it, ++num_points) {
-                    m_impl.linestring_add_location(m_projection(it->location()));
-                }
-                return num_points;
+                return add_locations(it, end, false, [this](const Coordinates& coordinates) {
+                    m_impl.linestring_add_location(coordinates);
+                });
             }
 
             template <typename TIter>
             size_t fill_linestring_unique(TIter it, TIter end) {
-                size_t num_points = 0;
-                osmium::Location last_location;
-                for (; it != end; ++it) {
-                    if (last_location != it->location()) {
-                        last_location = it->location();
-                        m_impl.linestring_add_location(m_projection(last_location));
-                        ++num_points;
-                    }
-                }
-                return num_points;
+                return add_locations(it, end, true, [this](const Coordinates& coordinates) {
+                    m_impl.linestring_add_location(coordinates);
+                });
             }
 
             linestring_type linestring_finish(size_t num_points) {
@@ -294,8 +393,33 @@ namespace osmium {
                 return linestring_finish(num_points);
             }
 
+            linestring_type create_linestring(const osmium::CompressedWayNodeList& cwnl, use_nodes un = use_nodes::unique, direction dir = direction::forward) {
+                linestring_start();
+                size_t num_points = 0;
+
+                if (dir == direction::forward) {
+                    num_points = un == use_nodes::unique ? fill_linestring_unique(cwnl.cbegin(), cwnl.cend())
+                                                         : fill_linestring(cwnl.cbegin(), cwnl.cend());
+                } else {
+                    // The compressed list can only be decoded forwards.
+                    const std::vector<osmium::NodeRef> nodes(cwnl.cbegin(), cwnl.cend());
+                    num_points = un == use_nodes::unique ? fill_linestring_unique(nodes.crbegin(), nodes.crend())
+                                                         : fill_linestring(nodes.crbegin(), nodes.crend());
+                }
+
+                if (num_points < 2) {
+                    throw osmium::geometry_error{"need at least two points for linestring"};
+                }
+
+                return linestring_finish(num_points);
+            }
+
             linestring_type create_linestring(const osmium::Way& way, use_nodes un = use_nodes::unique, direction dir = direction::forward) {
                 try {
+                    const auto* compressed_nodes = way.compressed_nodes();
+                    if (compressed_nodes) {
+                        return create_linestring(*compressed_nodes, un, dir);
+                    }
                     return create_linestring(way.nodes(), un, dir);
                 } catch (osmium::geometry_error& e) {
                     e.set_id("way", way.id());
@@ -311,25 +435,16 @@ namespace osmium {
 
             template <typename TIter>
             size_t fill_polygon(TIter it, TIter end) {
-                size_t num_points = 0;
-                for (; it != end; ++it, ++num_points) {
-                    m_impl.polygon_add_location(m_projection(it->location()));
-                }
-                return num_points;
+                return add_locations(it, end, false, [this](const Coordinates& coordinates) {
+                    m_impl.polygon_add_location(coordinates);
+                });
             }
 
             template <typename TIter>
             size_t fill_polygon_unique(TIter it, TIter end) {
-                size_t num_points = 0;
-                osmium::Location last_location;
-                for (; it != end; ++it) {
-                    if (last_location != it->location()) {
-                        last_location = it->location();
-                        m_impl.polygon_add_location(m_projection(last_location));
-                        ++num_points;
-                    }
-                }
-                return num_points;
+                return add_locations(it, end, true, [this](const Coordinates& coordinates) {
+                    m_impl.polygon_add_location(coordinates);
+                });
             }
 
             polygon_type polygon_finish(size_t num_points) {
@@ -367,8 +482,33 @@ namespace osmium {
                 return polygon_finish(num_points);
             }
 
+            polygon_type create_polygon(const osmium::CompressedWayNodeList& cwnl, use_nodes un = use_nodes::unique, direction dir = direction::forward) {
+                polygon_start();
+                size_t num_points = 0;
+
+                if (dir == direction::forward) {
+                    num_points = un == use_nodes::unique ? fill_polygon_unique(cwnl.cbegin(), cwnl.cend())
+                                                         : fill_polygon(cwnl.cbegin(), cwnl.cend());
+                } else {
+                    // The compressed list can only be decoded forwards.
+                    const std::vector<osmium::NodeRef> nodes(cwnl.cbegin(), cwnl.cend());
+                    num_points = un == use_nodes::unique ? fill_polygon_unique(nodes.crbegin(), nodes.crend())
+                                                         : fill_polygon(nodes.crbegin(), nodes.crend());
+                }
+
+                if (num_points < 4) {
+                    throw osmium::geometry_error{"need at least four points for polygon"};
+                }
+
+                return polygon_finish(num_points);
+            }
+
             polygon_type create_polygon(const osmium::Way& way, use_nodes un = use_nodes::unique, direction dir = direction::forward) {
                 try {
+                    const auto* compressed_nodes = way.compressed_nodes();
+                    if (compressed_nodes) {
+                        return create_polygon(*compressed_nodes, un, dir);
+                    }
                     return create_polygon(way.nodes(), un, dir);
                 } catch (osmium::geometry_error& e) {
                     e.set_id("way", way.id());
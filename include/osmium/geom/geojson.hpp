@@ -171,11 +171,149 @@ namespace osmium {
 
             }; // class GeoJSONFactoryImpl
 
+            /**
+             * GeoJSON factory implementation appending all geometries to
+             * an output string given in the constructor instead of
+             * returning a new string for each geometry. If the string is
+             * reused for many objects (for instance by clearing it after
+             * each object has been written out), no memory allocations are
+             * needed once it has grown large enough.
+             *
+             * All create functions return the number of characters
+             * appended. If a geometry_error is thrown, a partial geometry
+             * might have been appended to the output.
+             */
+            class GeoJSONSinkFactoryImpl {
+
+                std::string* m_out;
+                std::size_t m_start = 0;
+                int m_precision;
+
+                void start(const char* type) {
+                    m_start = m_out->size();
+                    *m_out += type;
+                }
+
+                std::size_t finish() const noexcept {
+                    return m_out->size() - m_start;
+                }
+
+            public:
+
+                using point_type        = std::size_t;
+                using linestring_type   = std::size_t;
+                using polygon_type      = std::size_t;
+                using multipolygon_type = std::size_t;
+                using ring_type         = std::size_t;
+
+                GeoJSONSinkFactoryImpl(int /*srid*/, std::string& out, int precision = 7) :
+                    m_out(&out),
+                    m_precision(precision) {
+                }
+
+                /* Point */
+
+                point_type make_point(const osmium::geom::Coordinates& xy) const {
+                    const auto size = m_out->size();
+                    *m_out += "{\"type\":\"Point\",\"coordinates\":";
+                    xy.append_to_string(*m_out, '[', ',', ']', m_precision);
+                    *m_out += '}';
+                    return m_out->size() - size;
+                }
+
+                /* LineString */
+
+                void linestring_start() {
+                    start("{\"type\":\"LineString\",\"coordinates\":[");
+                }
+
+                void linestring_add_location(const osmium::geom::Coordinates& xy) {
+                    xy.append_to_string(*m_out, '[', ',', ']', m_precision);
+                    *m_out += ',';
+                }
+
+                linestring_type linestring_finish(size_t /*num_points*/) {
+                    assert(!m_out->empty());
+                    m_out->back() = ']';
+                    *m_out += '}';
+                    return finish();
+                }
+
+                /* Polygon */
+                void polygon_start() {
+                    start("{\"type\":\"Polygon\",\"coordinates\":[[");
+                }
+
+                void polygon_add_location(const osmium::geom::Coordinates& xy) {
+                    xy.append_to_string(*m_out, '[', ',', ']', m_precision);
+                    *m_out += ',';
+                }
+
+                polygon_type polygon_finish(size_t /*num_points*/) {
+                    assert(!m_out->empty());
+                    m_out->back() = ']';
+                    *m_out += "]}";
+                    return finish();
+                }
+
+                /* MultiPolygon */
+
+                void multipolygon_start() {
+                    start("{\"type\":\"MultiPolygon\",\"coordinates\":[");
+                }
+
+                void multipolygon_polygon_start() {
+                    *m_out += '[';
+                }
+
+                void multipolygon_polygon_finish() {
+                    *m_out += "],";
+                }
+
+                void multipolygon_outer_ring_start() {
+                    *m_out += '[';
+                }
+
+                void multipolygon_outer_ring_finish() {
+                    assert(!m_out->empty());
+                    m_out->back() = ']';
+                }
+
+                void multipolygon_inner_ring_start() {
+                    *m_out += ",[";
+                }
+
+                void multipolygon_inner_ring_finish() {
+                    assert(!m_out->empty());
+                    m_out->back() = ']';
+                }
+
+                void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
+                    xy.append_to_string(*m_out, '[', ',', ']', m_precision);
+                    *m_out += ',';
+                }
+
+                multipolygon_type multipolygon_finish() {
+                    assert(!m_out->empty());
+                    m_out->back() = ']';
+                    *m_out += '}';
+                    return finish();
+                }
+
+            }; // class GeoJSONSinkFactoryImpl
+
         } // namespace detail
 
         template <typename TProjection = IdentityProjection>
         using GeoJSONFactory = GeometryFactory<osmium::geom::detail::GeoJSONFactoryImpl, TProjection>;
 
+        /**
+         * GeoJSON factory appending to the output string given in the
+         * constructor. See detail::GeoJSONSinkFactoryImpl for details.
+         */
+        template <typename TProjection = IdentityProjection>
+        using GeoJSONSinkFactory = GeometryFactory<osmium::geom::detail::GeoJSONSinkFactoryImpl, TProjection>;
+
     } // namespace geom
 
 } // namespace osmium
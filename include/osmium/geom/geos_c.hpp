@@ -0,0 +1,399 @@
+#ifndef OSMIUM_GEOM_GEOS_C_HPP
+#define OSMIUM_GEOM_GEOS_C_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+// Make sure only the reentrant functions of the GEOS C API are used.
+#ifndef GEOS_USE_ONLY_R_API
+# define GEOS_USE_ONLY_R_API
+#endif
+
+#include <geos_c.h>
+
+#if defined(GEOS_VERSION_MAJOR) && defined(GEOS_VERSION_MINOR) && (GEOS_VERSION_MAJOR > 3 || (GEOS_VERSION_MAJOR == 3 && GEOS_VERSION_MINOR >= 6))
+
+#define OSMIUM_WITH_GEOS_C
+
+/**
+ * @file
+ *
+ * This file contains code for conversion of OSM geometries into GEOS
+ * geometries using the reentrant ("_r") functions of the GEOS C API.
+ * It needs GEOS 3.6 or newer.
+ *
+ * Unlike the deprecated factory in geos.hpp this one can be used from
+ * several threads at the same time as long as each thread has its own
+ * factory (and so its own GEOS context).
+ *
+ * @attention If you include this file, you'll need to link with `libgeos_c`.
+ */
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/factory.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    struct geos_geometry_error : public geometry_error {
+
+        explicit geos_geometry_error(const char* message) :
+            geometry_error(std::string{"geometry creation failed in GEOS library: "} + message) {
+        }
+
+    }; // struct geos_geometry_error
+
+    namespace geom {
+
+        /**
+         * A GEOS context handle together with the last error message GEOS
+         * reported through it.
+         *
+         * GEOS contexts must not be used from several threads at the same
+         * time. Create one per thread, for instance as thread_local
+         * variable in the function running in the pool workers, and use
+         * it with all the GEOS functions called in that thread.
+         */
+        class GEOSContext {
+
+            GEOSContextHandle_t m_handle;
+            std::string m_last_error;
+
+            static void error_handler(const char* message, void* user_data) {
+                static_cast<GEOSContext*>(user_data)->m_last_error = message;
+            }
+
+        public:
+
+            GEOSContext() :
+                m_handle(GEOS_init_r()) {
+                if (!m_handle) {
+                    throw osmium::geos_geometry_error{"could not initialize GEOS context"};
+                }
+                GEOSContext_setErrorMessageHandler_r(m_handle, error_handler, this);
+            }
+
+            // The error handler has a pointer to this object, so it can
+            // neither be copied nor moved.
+            GEOSContext(const GEOSContext&) = delete;
+            GEOSContext& operator=(const GEOSContext&) = delete;
+
+            GEOSContext(GEOSContext&&) = delete;
+            GEOSContext& operator=(GEOSContext&&) = delete;
+
+            ~GEOSContext() noexcept {
+                GEOS_finish_r(m_handle);
+            }
+
+            /// The GEOS context handle for use with the GEOS_*_r functions.
+            GEOSContextHandle_t get() const noexcept {
+                return m_handle;
+            }
+
+            /// The last error message reported by GEOS.
+            const std::string& last_error() const noexcept {
+                return m_last_error;
+            }
+
+            /**
+             * Throw a geos_geometry_error with the last error message
+             * reported by GEOS.
+             */
+            [[noreturn]] void throw_error() const {
+                throw osmium::geos_geometry_error{m_last_error.empty() ? "unknown error" : m_last_error.c_str()};
+            }
+
+        }; // class GEOSContext
+
+        /**
+         * Deleter for GEOS geometries. It keeps the context alive the
+         * geometry was created with.
+         */
+        class GEOSGeometryDeleter {
+
+            std::shared_ptr<GEOSContext> m_context;
+
+        public:
+
+            GEOSGeometryDeleter() = default;
+
+            explicit GEOSGeometryDeleter(std::shared_ptr<GEOSContext> context) noexcept :
+                m_context(std::move(context)) {
+            }
+
+            void operator()(GEOSGeometry* geometry) const noexcept {
+                if (geometry) {
+                    assert(m_context);
+                    GEOSGeom_destroy_r(m_context->get(), geometry);
+                }
+            }
+
+            const std::shared_ptr<GEOSContext>& context() const noexcept {
+                return m_context;
+            }
+
+        }; // class GEOSGeometryDeleter
+
+        /// Owning pointer to a GEOS geometry.
+        using geos_geometry_ptr = std::unique_ptr<GEOSGeometry, GEOSGeometryDeleter>;
+
+        namespace detail {
+
+            class GEOSCFactoryImpl {
+
+            public:
+
+                using point_type        = geos_geometry_ptr;
+                using linestring_type   = geos_geometry_ptr;
+                using polygon_type      = geos_geometry_ptr;
+                using multipolygon_type = geos_geometry_ptr;
+                using ring_type         = geos_geometry_ptr;
+
+            private:
+
+                std::shared_ptr<GEOSContext> m_context;
+                int m_srid;
+
+                // Coordinates (x and y interleaved) of the linestring or
+                // ring currently being built. They are copied into a GEOS
+                // coordinate sequence in one go when it is finished.
+                std::vector<double> m_coordinates;
+
+                std::vector<geos_geometry_ptr> m_rings;
+                std::vector<geos_geometry_ptr> m_polygons;
+
+                GEOSContextHandle_t handle() const noexcept {
+                    return m_context->get();
+                }
+
+                geos_geometry_ptr wrap(GEOSGeometry* geometry) const {
+                    if (!geometry) {
+                        m_context->throw_error();
+                    }
+                    geos_geometry_ptr result{geometry, GEOSGeometryDeleter{m_context}};
+                    GEOSSetSRID_r(handle(), geometry, m_srid);
+                    return result;
+                }
+
+                void add_coordinates(const osmium::geom::Coordinates& xy) {
+                    m_coordinates.push_back(xy.x);
+                    m_coordinates.push_back(xy.y);
+                }
+
+                GEOSCoordSequence* make_sequence() {
+                    const auto size = static_cast<unsigned int>(m_coordinates.size() / 2);
+#if GEOS_VERSION_MAJOR > 3 || (GEOS_VERSION_MAJOR == 3 && GEOS_VERSION_MINOR >= 10)
+                    GEOSCoordSequence* sequence = GEOSCoordSeq_copyFromBuffer_r(handle(), m_coordinates.data(), size, 0, 0);
+                    if (!sequence) {
+                        m_context->throw_error();
+                    }
+#else
+                    GEOSCoordSequence* sequence = GEOSCoordSeq_create_r(handle(), size, 2);
+                    if (!sequence) {
+                        m_context->throw_error();
+                    }
+                    for (unsigned int i = 0; i < size; ++i) {
+                        if (!GEOSCoordSeq_setX_r(handle(), sequence, i, m_coordinates[2 * i]) ||
+                            !GEOSCoordSeq_setY_r(handle(), sequence, i, m_coordinates[2 * i + 1])) {
+                            GEOSCoordSeq_destroy_r(handle(), sequence);
+                            m_context->throw_error();
+                        }
+                    }
+#endif
+                    m_coordinates.clear();
+                    return sequence;
+                }
+
+                // The GEOS functions creating geometries take ownership
+                // of the coordinate sequences and geometries passed to
+                // them.
+
+                geos_geometry_ptr make_ring() {
+                    return wrap(GEOSGeom_createLinearRing_r(handle(), make_sequence()));
+                }
+
+                geos_geometry_ptr make_polygon(std::vector<geos_geometry_ptr>& rings) {
+                    assert(!rings.empty());
+                    std::vector<GEOSGeometry*> holes;
+                    holes.reserve(rings.size() - 1);
+                    for (auto it = std::next(rings.begin()); it != rings.end(); ++it) {
+                        holes.push_back(it->release());
+                    }
+                    GEOSGeometry* shell = rings.front().release();
+                    rings.clear();
+                    return wrap(GEOSGeom_createPolygon_r(handle(), shell, holes.data(), static_cast<unsigned int>(holes.size())));
+                }
+
+            public:
+
+                /**
+                 * Create a factory with its own GEOS context.
+                 */
+                explicit GEOSCFactoryImpl(int srid) :
+                    m_context(std::make_shared<GEOSContext>()),
+                    m_srid(srid) {
+                }
+
+                /**
+                 * Create a factory using the given GEOS context. It must
+                 * only be used in the thread using the context.
+                 */
+                GEOSCFactoryImpl(int srid, std::shared_ptr<GEOSContext> context) :
+                    m_context(std::move(context)),
+                    m_srid(srid) {
+                    assert(m_context);
+                }
+
+                const std::shared_ptr<GEOSContext>& context() const noexcept {
+                    return m_context;
+                }
+
+                /* Point */
+
+                point_type make_point(const osmium::geom::Coordinates& xy) const {
+#if GEOS_VERSION_MAJOR > 3 || (GEOS_VERSION_MAJOR == 3 && GEOS_VERSION_MINOR >= 8)
+                    return wrap(GEOSGeom_createPointFromXY_r(handle(), xy.x, xy.y));
+#else
+                    GEOSCoordSequence* sequence = GEOSCoordSeq_create_r(handle(), 1, 2);
+                    if (!sequence) {
+                        m_context->throw_error();
+                    }
+                    GEOSCoordSeq_setX_r(handle(), sequence, 0, xy.x);
+                    GEOSCoordSeq_setY_r(handle(), sequence, 0, xy.y);
+                    return wrap(GEOSGeom_createPoint_r(handle(), sequence));
+#endif
+                }
+
+                /* LineString */
+
+                void linestring_start() {
+                    m_coordinates.clear();
+                }
+
+                void linestring_add_location(const osmium::geom::Coordinates& xy) {
+                    add_coordinates(xy);
+                }
+
+                linestring_type linestring_finish(std::size_t /* num_points */) {
+                    return wrap(GEOSGeom_createLineString_r(handle(), make_sequence()));
+                }
+
+                /* Polygon */
+
+                void polygon_start() {
+                    m_coordinates.clear();
+                }
+
+                void polygon_add_location(const osmium::geom::Coordinates& xy) {
+                    add_coordinates(xy);
+                }
+
+                polygon_type polygon_finish(std::size_t /* num_points */) {
+                    std::vector<geos_geometry_ptr> rings;
+                    rings.push_back(make_ring());
+                    return make_polygon(rings);
+                }
+
+                /* MultiPolygon */
+
+                void multipolygon_start() {
+                    m_polygons.clear();
+                }
+
+                void multipolygon_polygon_start() {
+                    m_rings.clear();
+                }
+
+                void multipolygon_polygon_finish() {
+                    m_polygons.push_back(make_polygon(m_rings));
+                }
+
+                void multipolygon_outer_ring_start() {
+                    m_coordinates.clear();
+                }
+
+                void multipolygon_outer_ring_finish() {
+                    m_rings.push_back(make_ring());
+                }
+
+                void multipolygon_inner_ring_start() {
+                    m_coordinates.clear();
+                }
+
+                void multipolygon_inner_ring_finish() {
+                    m_rings.push_back(make_ring());
+                }
+
+                void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
+                    add_coordinates(xy);
+                }
+
+                multipolygon_type multipolygon_finish() {
+                    std::vector<GEOSGeometry*> polygons;
+                    polygons.reserve(m_polygons.size());
+                    for (auto& polygon : m_polygons) {
+                        polygons.push_back(polygon.release());
+                    }
+                    m_polygons.clear();
+                    return wrap(GEOSGeom_createCollection_r(handle(), GEOS_MULTIPOLYGON, polygons.data(), static_cast<unsigned int>(polygons.size())));
+                }
+
+            }; // class GEOSCFactoryImpl
+
+        } // namespace detail
+
+        /**
+         * Geometry factory creating GEOS geometries using the reentrant
+         * GEOS C API.
+         *
+         * Each factory has its own GEOS context unless you give it one
+         * in the constructor, so use one factory per thread. Use the
+         * context of the geometries (geometry.get_deleter().context())
+         * when calling other GEOS functions like GEOSisValid_r() on them.
+         */
+        template <typename TProjection = IdentityProjection>
+        using GEOSCFactory = GeometryFactory<osmium::geom::detail::GEOSCFactoryImpl, TProjection>;
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif
+
+#endif // OSMIUM_GEOM_GEOS_C_HPP
@@ -0,0 +1,117 @@
+#ifndef OSMIUM_GEOM_HILBERT_HPP
+#define OSMIUM_GEOM_HILBERT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/location.hpp>
+
+#include <cstdint>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * Position of a point on the Hilbert curve filling a
+         * 2^16 x 2^16 grid. This is the branch-free algorithm from
+         * https://github.com/rawrunprotected/hilbert_curves (public
+         * domain).
+         */
+        inline uint32_t hilbert_index(uint32_t x, uint32_t y) noexcept {
+            uint32_t a = x ^ y;
+            uint32_t b = 0xFFFFU ^ a;
+            uint32_t c = 0xFFFFU ^ (x | y);
+            uint32_t d = x & (y ^ 0xFFFFU);
+
+            uint32_t A = a | (b >> 1U);
+            uint32_t B = (a >> 1U) ^ a;
+            uint32_t C = ((c >> 1U) ^ (b & (d >> 1U))) ^ c;
+            uint32_t D = ((a & (c >> 1U)) ^ (d >> 1U)) ^ d;
+
+            a = A; b = B; c = C; d = D;
+            A = ((a & (a >> 2U)) ^ (b & (b >> 2U)));
+            B = ((a & (b >> 2U)) ^ (b & ((a ^ b) >> 2U)));
+            C ^= ((a & (c >> 2U)) ^ (b & (d >> 2U)));
+            D ^= ((b & (c >> 2U)) ^ ((a ^ b) & (d >> 2U)));
+
+            a = A; b = B; c = C; d = D;
+            A = ((a & (a >> 4U)) ^ (b & (b >> 4U)));
+            B = ((a & (b >> 4U)) ^ (b & ((a ^ b) >> 4U)));
+            C ^= ((a & (c >> 4U)) ^ (b & (d >> 4U)));
+            D ^= ((b & (c >> 4U)) ^ ((a ^ b) & (d >> 4U)));
+
+            a = A; b = B; c = C; d = D;
+            C ^= ((a & (c >> 8U)) ^ (b & (d >> 8U)));
+            D ^= ((b & (c >> 8U)) ^ ((a ^ b) & (d >> 8U)));
+
+            a = C ^ (C >> 1U);
+            b = D ^ (D >> 1U);
+
+            uint32_t i0 = x ^ y;
+            uint32_t i1 = b | (0xFFFFU ^ (i0 | a));
+
+            i0 = (i0 | (i0 << 8U)) & 0x00FF00FFU;
+            i0 = (i0 | (i0 << 4U)) & 0x0F0F0F0FU;
+            i0 = (i0 | (i0 << 2U)) & 0x33333333U;
+            i0 = (i0 | (i0 << 1U)) & 0x55555555U;
+
+            i1 = (i1 | (i1 << 8U)) & 0x00FF00FFU;
+            i1 = (i1 | (i1 << 4U)) & 0x0F0F0F0FU;
+            i1 = (i1 | (i1 << 2U)) & 0x33333333U;
+            i1 = (i1 | (i1 << 1U)) & 0x55555555U;
+
+            return (i1 << 1U) | i0;
+        }
+
+        /**
+         * Position of a location on a Hilbert curve filling the whole
+         * world with a 2^16 x 2^16 grid (cells are about 0.005 degrees
+         * wide). Nearby locations usually have nearby positions. Invalid
+         * locations are all put at the end of the curve.
+         */
+        inline uint32_t hilbert_index(const osmium::Location& location) noexcept {
+            if (!location.valid()) {
+                return 0xFFFFFFFFU;
+            }
+            const auto x = (static_cast<uint64_t>(static_cast<int64_t>(location.x()) + 180 * osmium::detail::coordinate_precision) << 16U) /
+                           (360ULL * osmium::detail::coordinate_precision + 1);
+            const auto y = (static_cast<uint64_t>(static_cast<int64_t>(location.y()) + 90 * osmium::detail::coordinate_precision) << 16U) /
+                           (180ULL * osmium::detail::coordinate_precision + 1);
+            return hilbert_index(static_cast<uint32_t>(x), static_cast<uint32_t>(y));
+        }
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_HILBERT_HPP
@@ -37,7 +37,10 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/geom/util.hpp>
 #include <osmium/osm/location.hpp>
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstddef>
 #include <string>
 
 namespace osmium {
@@ -66,11 +69,10 @@ namespace osmium {
             // This is a much faster implementation than the canonical
             // implementation using the tan() function. For details
             // see https://github.com/osmcode/mercator-projection .
-            inline double lat_to_y(double lat) { // not constexpr because math functions aren't
-                if (lat < -78.0 || lat > 78.0) {
-                    return lat_to_y_with_tan(lat);
-                }
-
+            // Polynomial approximation of lat_to_y() which is only good for
+            // latitudes between -78 and +78 degrees. This has no branches,
+            // so the compiler can vectorize loops calling it.
+            inline double lat_to_y_polynomial(double lat) noexcept {
                 return earth_radius_for_epsg3857 *
                     ((((((((((-3.1112583378460085319e-23  * lat +
                                2.0465852743943268009e-19) * lat +
@@ -94,8 +96,75 @@ namespace osmium {
                               -3.4554675198786337842e-4)  * lat +
                               -5.4367203601085991108e-4)  * lat + 1.0);
             }
+
+            inline double lat_to_y(double lat) { // not constexpr because math functions aren't
+                if (lat < -78.0 || lat > 78.0) {
+                    return lat_to_y_with_tan(lat);
+                }
+
+                return lat_to_y_polynomial(lat);
+            }
+#endif
+
+            enum : std::size_t {
+                mercator_batch_size = 256
+            };
+
+            // Project a batch of at most mercator_batch_size locations. The
+            // locations are first copied into separate arrays for the
+            // longitudes and latitudes, so that the loops doing the actual
+            // calculations can be vectorized by the compiler.
+            inline void lonlat_to_mercator_batch(const osmium::Location* locations, std::size_t count, Coordinates* out) {
+                assert(count <= mercator_batch_size);
+                double x[mercator_batch_size];
+                double y[mercator_batch_size];
+
+                for (std::size_t i = 0; i < count; ++i) {
+                    if (!locations[i].valid()) {
+                        throw osmium::invalid_location{"invalid location"};
+                    }
+                }
+
+                for (std::size_t i = 0; i < count; ++i) {
+                    x[i] = locations[i].lon_without_check();
+                    y[i] = locations[i].lat_without_check();
+                }
+
+                for (std::size_t i = 0; i < count; ++i) {
+                    x[i] = lon_to_x(x[i]);
+                }
+
+#ifdef OSMIUM_USE_SLOW_MERCATOR_PROJECTION
+                for (std::size_t i = 0; i < count; ++i) {
+                    y[i] = lat_to_y_with_tan(y[i]);
+                }
+#else
+                int needs_tan = 0;
+                for (std::size_t i = 0; i < count; ++i) {
+                    needs_tan |= static_cast<int>(y[i] < -78.0) | static_cast<int>(y[i] > 78.0);
+                }
+
+                for (std::size_t i = 0; i < count; ++i) {
+                    y[i] = lat_to_y_polynomial(y[i]);
+                }
+
+                // Latitudes outside the range of the polynomial are rare,
+                // they are fixed up afterwards.
+                if (needs_tan) {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        const double lat = locations[i].lat_without_check();
+                        if (lat < -78.0 || lat > 78.0) {
+                            y[i] = lat_to_y_with_tan(lat);
+                        }
+                    }
+                }
 #endif
 
+                for (std::size_t i = 0; i < count; ++i) {
+                    out[i] = Coordinates{x[i], y[i]};
+                }
+            }
+
             constexpr inline double x_to_lon(double x) {
                 return rad_to_deg(x) / earth_radius_for_epsg3857;
             }
@@ -161,6 +230,29 @@ namespace osmium {
                 return Coordinates{detail::lon_to_x(location.lon()), detail::lat_to_y(location.lat())};
             }
 
+            /**
+             * Do coordinate transformation for count locations starting at
+             * locations and write the results to out. This gives the same
+             * results as calling the single location version for each
+             * location, but is faster for many locations.
+             *
+             * @throws osmium::invalid_location if one of the locations is
+             *         invalid.
+             * @pre Coordinates must be in valid range, longitude between
+             *      -180 and +180 degree, latitude between -MERCATOR_MAX_LAT
+             *      and MERCATOR_MAX_LAT.
+             * @pre out must have space for count Coordinates.
+             */
+            void operator()(const osmium::Location* locations, std::size_t count, Coordinates* out) const {
+                while (count > 0) {
+                    const std::size_t n = std::min(count, static_cast<std::size_t>(detail::mercator_batch_size));
+                    detail::lonlat_to_mercator_batch(locations, n, out);
+                    locations += n;
+                    out += n;
+                    count -= n;
+                }
+            }
+
             static int epsg() noexcept {
                 return 3857;
             }
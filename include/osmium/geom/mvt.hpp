@@ -0,0 +1,478 @@
+#ifndef OSMIUM_GEOM_MVT_HPP
+#define OSMIUM_GEOM_MVT_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/factory.hpp>
+#include <osmium/geom/mercator_projection.hpp>
+#include <osmium/geom/tile.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        namespace detail {
+
+            /// A point in integer tile coordinates (origin top left).
+            struct mvt_point {
+                int64_t x;
+                int64_t y;
+            };
+
+            inline bool operator==(const mvt_point& lhs, const mvt_point& rhs) noexcept {
+                return lhs.x == rhs.x && lhs.y == rhs.y;
+            }
+
+            inline bool operator!=(const mvt_point& lhs, const mvt_point& rhs) noexcept {
+                return !(lhs == rhs);
+            }
+
+            /// Zigzag encode a parameter integer as described in the MVT spec.
+            inline uint32_t mvt_zigzag(int32_t value) noexcept {
+                return value >= 0 ? static_cast<uint32_t>(value) << 1U
+                                  : (static_cast<uint32_t>(-(value + 1)) << 1U) | 1U;
+            }
+
+            enum mvt_command : uint32_t {
+                mvt_move_to    = 1,
+                mvt_line_to    = 2,
+                mvt_close_path = 7
+            }; // enum mvt_command
+
+            /**
+             * Geometry factory implementation creating the geometry
+             * encoding of the Mapbox Vector Tile format (version 2) for one
+             * tile. Coordinates must be in Web Mercator (EPSG:3857), use
+             * the MVTFactory with the MercatorProjection.
+             *
+             * All geometries are returned as vector of integers ready to
+             * be written as packed "geometry" field of a feature. Each
+             * geometry is clipped to the tile (plus a buffer around it)
+             * and consecutive points falling on the same tile coordinate
+             * are removed. If nothing of the geometry remains after this,
+             * an empty vector is returned. Linestrings can be split into
+             * several parts by the clipping, the result is then a
+             * multilinestring.
+             *
+             * Rings of (multi)polygons are oriented as required by the
+             * spec: outer rings clockwise, inner rings counter-clockwise
+             * (in tile coordinates with the y axis pointing down). Inner
+             * rings of an outer ring that was clipped away are dropped.
+             */
+            class MVTFactoryImpl {
+
+                std::vector<uint32_t> m_geometry;
+                std::vector<mvt_point> m_points;
+                std::vector<mvt_point> m_clipped;
+                std::vector<mvt_point> m_part;
+
+                double m_origin_x;
+                double m_origin_y;
+                double m_scale;
+                int64_t m_min;
+                int64_t m_max;
+
+                mvt_point m_cursor{0, 0};
+                bool m_outer_ring_added = false;
+
+                mvt_point to_tile(const osmium::geom::Coordinates& xy) const noexcept {
+                    return mvt_point{std::llround((xy.x - m_origin_x) * m_scale),
+                                     std::llround((m_origin_y - xy.y) * m_scale)};
+                }
+
+                bool inside(const mvt_point& p) const noexcept {
+                    return p.x >= m_min && p.x <= m_max && p.y >= m_min && p.y <= m_max;
+                }
+
+                void start() {
+                    m_geometry.clear();
+                    m_points.clear();
+                    m_cursor = mvt_point{0, 0};
+                }
+
+                std::vector<uint32_t> finish() {
+                    std::vector<uint32_t> geometry;
+                    using std::swap;
+                    swap(geometry, m_geometry);
+                    return geometry;
+                }
+
+                void add_command(mvt_command command, std::size_t count) {
+                    m_geometry.push_back(static_cast<uint32_t>(command) | (static_cast<uint32_t>(count) << 3U));
+                }
+
+                void add_point(const mvt_point& p) {
+                    m_geometry.push_back(mvt_zigzag(static_cast<int32_t>(p.x - m_cursor.x)));
+                    m_geometry.push_back(mvt_zigzag(static_cast<int32_t>(p.y - m_cursor.y)));
+                    m_cursor = p;
+                }
+
+                // Encode points as MoveTo and LineTo commands.
+                void add_points(const std::vector<mvt_point>& points) {
+                    add_command(mvt_move_to, 1);
+                    add_point(points.front());
+                    add_command(mvt_line_to, points.size() - 1);
+                    for (auto it = std::next(points.begin()); it != points.end(); ++it) {
+                        add_point(*it);
+                    }
+                }
+
+                void flush_part() {
+                    if (m_part.size() >= 2) {
+                        add_points(m_part);
+                    }
+                    m_part.clear();
+                }
+
+                /**
+                 * Clip the segment from a to b to the clip box using the
+                 * Liang-Barsky algorithm. Returns false if the segment is
+                 * completely outside, otherwise a and b are set to the
+                 * clipped end points.
+                 */
+                bool clip_segment(mvt_point& a, mvt_point& b) const noexcept {
+                    const bool a_inside = inside(a);
+                    const bool b_inside = inside(b);
+                    if (a_inside && b_inside) {
+                        return true;
+                    }
+
+                    const auto dx = static_cast<double>(b.x - a.x);
+                    const auto dy = static_cast<double>(b.y - a.y);
+                    const double p[4] = {-dx, dx, -dy, dy};
+                    const double q[4] = {static_cast<double>(a.x - m_min),
+                                         static_cast<double>(m_max - a.x),
+                                         static_cast<double>(a.y - m_min),
+                                         static_cast<double>(m_max - a.y)};
+                    double t0 = 0.0;
+                    double t1 = 1.0;
+                    for (int i = 0; i < 4; ++i) {
+                        if (p[i] == 0.0) {
+                            if (q[i] < 0.0) {
+                                return false;
+                            }
+                        } else {
+                            const double t = q[i] / p[i];
+                            if (p[i] < 0.0) {
+                                t0 = std::max(t0, t);
+                            } else {
+                                t1 = std::min(t1, t);
+                            }
+                        }
+                    }
+                    if (t0 > t1) {
+                        return false;
+                    }
+
+                    const mvt_point start = a;
+                    if (!a_inside) {
+                        a = mvt_point{start.x + std::llround(t0 * dx), start.y + std::llround(t0 * dy)};
+                    }
+                    if (!b_inside) {
+                        b = mvt_point{start.x + std::llround(t1 * dx), start.y + std::llround(t1 * dy)};
+                    }
+                    return true;
+                }
+
+                // Clip ring in m_clipped against one edge of the clip box
+                // (Sutherland-Hodgman).
+                template <typename TInside, typename TIntersect>
+                void clip_ring_edge(TInside&& is_inside, TIntersect&& intersect) {
+                    if (m_clipped.empty()) {
+                        return;
+                    }
+                    m_part.clear();
+                    mvt_point prev = m_clipped.back();
+                    bool prev_inside = is_inside(prev);
+                    for (const auto& cur : m_clipped) {
+                        const bool cur_inside = is_inside(cur);
+                        if (cur_inside != prev_inside) {
+                            m_part.push_back(intersect(prev, cur));
+                        }
+                        if (cur_inside) {
+                            m_part.push_back(cur);
+                        }
+                        prev = cur;
+                        prev_inside = cur_inside;
+                    }
+                    using std::swap;
+                    swap(m_part, m_clipped);
+                }
+
+                static int64_t interpolate(int64_t a, int64_t b, double t) noexcept {
+                    return a + std::llround(t * static_cast<double>(b - a));
+                }
+
+                void clip_ring() {
+                    const int64_t min = m_min;
+                    const int64_t max = m_max;
+                    clip_ring_edge([min](const mvt_point& p) { return p.x >= min; },
+                                   [min](const mvt_point& a, const mvt_point& b) {
+                                       return mvt_point{min, interpolate(a.y, b.y, static_cast<double>(min - a.x) / static_cast<double>(b.x - a.x))};
+                                   });
+                    clip_ring_edge([max](const mvt_point& p) { return p.x <= max; },
+                                   [max](const mvt_point& a, const mvt_point& b) {
+                                       return mvt_point{max, interpolate(a.y, b.y, static_cast<double>(max - a.x) / static_cast<double>(b.x - a.x))};
+                                   });
+                    clip_ring_edge([min](const mvt_point& p) { return p.y >= min; },
+                                   [min](const mvt_point& a, const mvt_point& b) {
+                                       return mvt_point{interpolate(a.x, b.x, static_cast<double>(min - a.y) / static_cast<double>(b.y - a.y)), min};
+                                   });
+                    clip_ring_edge([max](const mvt_point& p) { return p.y <= max; },
+                                   [max](const mvt_point& a, const mvt_point& b) {
+                                       return mvt_point{interpolate(a.x, b.x, static_cast<double>(max - a.y) / static_cast<double>(b.y - a.y)), max};
+                                   });
+                }
+
+                /**
+                 * Clip, deduplicate and orient the ring in m_points and
+                 * add it to the geometry. Returns false if nothing remains
+                 * of the ring.
+                 */
+                bool add_ring(bool outer) {
+                    m_clipped.clear();
+                    for (const auto& p : m_points) {
+                        if (m_clipped.empty() || m_clipped.back() != p) {
+                            m_clipped.push_back(p);
+                        }
+                    }
+                    while (m_clipped.size() > 1 && m_clipped.front() == m_clipped.back()) {
+                        m_clipped.pop_back();
+                    }
+                    m_points.clear();
+
+                    if (!std::all_of(m_clipped.cbegin(), m_clipped.cend(), [this](const mvt_point& p) {
+                        return inside(p);
+                    })) {
+                        clip_ring();
+                        // clipping can create duplicate points
+                        const auto last = std::unique(m_clipped.begin(), m_clipped.end());
+                        m_clipped.erase(last, m_clipped.end());
+                        while (m_clipped.size() > 1 && m_clipped.front() == m_clipped.back()) {
+                            m_clipped.pop_back();
+                        }
+                    }
+
+                    if (m_clipped.size() < 3) {
+                        return false;
+                    }
+
+                    int64_t area = 0;
+                    mvt_point prev = m_clipped.back();
+                    for (const auto& p : m_clipped) {
+                        area += prev.x * p.y - p.x * prev.y;
+                        prev = p;
+                    }
+                    if (area == 0) {
+                        return false;
+                    }
+                    if ((area > 0) != outer) {
+                        std::reverse(m_clipped.begin(), m_clipped.end());
+                    }
+
+                    add_points(m_clipped);
+                    add_command(mvt_close_path, 1);
+                    return true;
+                }
+
+            public:
+
+                using point_type        = std::vector<uint32_t>;
+                using linestring_type   = std::vector<uint32_t>;
+                using polygon_type      = std::vector<uint32_t>;
+                using multipolygon_type = std::vector<uint32_t>;
+                using ring_type         = std::vector<uint32_t>;
+
+                /**
+                 * Constructor.
+                 *
+                 * @param srid Must be 3857.
+                 * @param tile The tile to create geometries for.
+                 * @param extent The extent of the tile in tile coordinates.
+                 * @param buffer Geometries are clipped to a box this many
+                 *               tile coordinates larger than the tile on
+                 *               each side.
+                 * @throws std::invalid_argument If srid is not 3857 or the
+                 *         tile is invalid.
+                 */
+                MVTFactoryImpl(int srid, const osmium::geom::Tile& tile, uint32_t extent = 4096, uint32_t buffer = 0) :
+                    m_origin_x(-detail::max_coordinate_epsg3857 + tile.x * tile_extent_in_zoom(tile.z)),
+                    m_origin_y(detail::max_coordinate_epsg3857 - tile.y * tile_extent_in_zoom(tile.z)),
+                    m_scale(extent / tile_extent_in_zoom(tile.z)),
+                    m_min(-static_cast<int64_t>(buffer)),
+                    m_max(static_cast<int64_t>(extent) + buffer) {
+                    if (srid != 3857) {
+                        throw std::invalid_argument{"MVT factory needs coordinates in EPSG:3857"};
+                    }
+                    if (!tile.valid()) {
+                        throw std::invalid_argument{"invalid tile"};
+                    }
+                }
+
+                /* Point */
+
+                point_type make_point(const osmium::geom::Coordinates& xy) const {
+                    const auto p = to_tile(xy);
+                    if (!inside(p)) {
+                        return {};
+                    }
+                    return {mvt_move_to | (1U << 3U),
+                            mvt_zigzag(static_cast<int32_t>(p.x)),
+                            mvt_zigzag(static_cast<int32_t>(p.y))};
+                }
+
+                /* LineString */
+
+                void linestring_start() {
+                    start();
+                }
+
+                void linestring_add_location(const osmium::geom::Coordinates& xy) {
+                    const auto p = to_tile(xy);
+                    if (m_points.empty() || m_points.back() != p) {
+                        m_points.push_back(p);
+                    }
+                }
+
+                linestring_type linestring_finish(std::size_t /*num_points*/) {
+                    m_part.clear();
+                    for (std::size_t i = 1; i < m_points.size(); ++i) {
+                        mvt_point a = m_points[i - 1];
+                        mvt_point b = m_points[i];
+                        if (!clip_segment(a, b)) {
+                            flush_part();
+                            continue;
+                        }
+                        if (!m_part.empty() && m_part.back() != a) {
+                            flush_part();
+                        }
+                        if (m_part.empty()) {
+                            m_part.push_back(a);
+                        }
+                        if (m_part.back() != b) {
+                            m_part.push_back(b);
+                        }
+                    }
+                    flush_part();
+                    return finish();
+                }
+
+                /* Polygon */
+
+                void polygon_start() {
+                    start();
+                }
+
+                void polygon_add_location(const osmium::geom::Coordinates& xy) {
+                    m_points.push_back(to_tile(xy));
+                }
+
+                polygon_type polygon_finish(std::size_t /*num_points*/) {
+                    add_ring(true);
+                    return finish();
+                }
+
+                /* MultiPolygon */
+
+                void multipolygon_start() {
+                    start();
+                }
+
+                void multipolygon_polygon_start() {
+                    m_outer_ring_added = false;
+                }
+
+                void multipolygon_polygon_finish() {
+                }
+
+                void multipolygon_outer_ring_start() {
+                    m_points.clear();
+                }
+
+                void multipolygon_outer_ring_finish() {
+                    m_outer_ring_added = add_ring(true);
+                }
+
+                void multipolygon_inner_ring_start() {
+                    m_points.clear();
+                }
+
+                void multipolygon_inner_ring_finish() {
+                    if (m_outer_ring_added) {
+                        add_ring(false);
+                    } else {
+                        m_points.clear();
+                    }
+                }
+
+                void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
+                    m_points.push_back(to_tile(xy));
+                }
+
+                multipolygon_type multipolygon_finish() {
+                    return finish();
+                }
+
+            }; // class MVTFactoryImpl
+
+        } // namespace detail
+
+        /**
+         * Geometry factory creating geometries encoded as in Mapbox Vector
+         * Tiles for one tile. See detail::MVTFactoryImpl for details.
+         *
+         * Usage:
+         * @code
+         * osmium::geom::MVTFactory<> factory{osmium::geom::Tile{14, 8800, 5373}, 4096, 64};
+         * const auto geometry = factory.create_linestring(way);
+         * @endcode
+         */
+        template <typename TProjection = MercatorProjection>
+        using MVTFactory = GeometryFactory<osmium::geom::detail::MVTFactoryImpl, TProjection>;
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_MVT_HPP
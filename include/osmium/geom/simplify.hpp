@@ -0,0 +1,193 @@
+#ifndef OSMIUM_GEOM_SIMPLIFY_HPP
+#define OSMIUM_GEOM_SIMPLIFY_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/coordinates.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        namespace detail {
+
+            /**
+             * Squared distance of point p from the segment between a and
+             * b.
+             */
+            inline double squared_distance_to_segment(const Coordinates& p, const Coordinates& a, const Coordinates& b) noexcept {
+                double x = a.x;
+                double y = a.y;
+                const double dx = b.x - x;
+                const double dy = b.y - y;
+
+                if (dx != 0.0 || dy != 0.0) {
+                    const double t = ((p.x - x) * dx + (p.y - y) * dy) / (dx * dx + dy * dy);
+                    if (t > 1.0) {
+                        x = b.x;
+                        y = b.y;
+                    } else if (t > 0.0) {
+                        x += dx * t;
+                        y += dy * t;
+                    }
+                }
+
+                const double px = p.x - x;
+                const double py = p.y - y;
+                return px * px + py * py;
+            }
+
+        } // namespace detail
+
+        /**
+         * Simplifies linestrings and rings with the Douglas-Peucker
+         * algorithm. The algorithm is implemented iteratively with an
+         * explicit stack. The stack and the other internal vectors are
+         * kept between calls, so once they are large enough simplifying
+         * does not allocate any memory.
+         *
+         * The first and last points are always kept. For closed rings
+         * (where the first and last point are the same) at least four
+         * points are kept, if the ring has that many.
+         */
+        class DouglasPeucker {
+
+            std::vector<std::pair<std::size_t, std::size_t>> m_stack;
+            std::vector<bool> m_keep;
+            double m_squared_tolerance;
+
+            // Find the point between first and last with the largest
+            // distance from the segment first-last.
+            std::pair<std::size_t, double> farthest(const std::vector<Coordinates>& points, std::size_t first, std::size_t last) const noexcept {
+                std::size_t index = first;
+                double max_distance = 0.0;
+                for (std::size_t i = first + 1; i < last; ++i) {
+                    const double distance = detail::squared_distance_to_segment(points[i], points[first], points[last]);
+                    if (distance > max_distance) {
+                        index = i;
+                        max_distance = distance;
+                    }
+                }
+                return std::make_pair(index, max_distance);
+            }
+
+            void keep(const std::vector<Coordinates>& points, std::size_t first, std::size_t last) {
+                m_stack.emplace_back(first, last);
+                while (!m_stack.empty()) {
+                    const auto range = m_stack.back();
+                    m_stack.pop_back();
+
+                    const auto max = farthest(points, range.first, range.second);
+                    if (max.first != range.first && max.second > m_squared_tolerance) {
+                        m_keep[max.first] = true;
+                        m_stack.emplace_back(range.first, max.first);
+                        m_stack.emplace_back(max.first, range.second);
+                    }
+                }
+            }
+
+        public:
+
+            /**
+             * Constructor.
+             *
+             * @param tolerance Points closer than this to the simplified
+             *                  line are removed. In the units of the
+             *                  coordinates.
+             */
+            explicit DouglasPeucker(double tolerance) noexcept :
+                m_squared_tolerance(tolerance * tolerance) {
+            }
+
+            /**
+             * Simplify the points and write the result to out (which is
+             * cleared first). The input and output must not be the same
+             * vector.
+             */
+            void operator()(const std::vector<Coordinates>& points, std::vector<Coordinates>& out) {
+                out.clear();
+                if (points.size() < 3) {
+                    out = points;
+                    return;
+                }
+
+                const std::size_t last = points.size() - 1;
+                m_keep.assign(points.size(), false);
+                m_keep[0] = true;
+                m_keep[last] = true;
+
+                keep(points, 0, last);
+
+                // A closed ring needs at least four points. If the
+                // simplification removed too much, add the points
+                // farthest away again, ignoring the tolerance.
+                if (points[0] == points[last] && points.size() >= 4) {
+                    std::size_t count = 0;
+                    for (const bool k : m_keep) {
+                        count += k ? 1 : 0;
+                    }
+                    if (count < 4) {
+                        m_keep.assign(points.size(), false);
+                        m_keep[0] = true;
+                        m_keep[last] = true;
+                        const auto max = farthest(points, 0, last);
+                        m_keep[max.first] = true;
+                        const auto max1 = farthest(points, 0, max.first);
+                        const auto max2 = farthest(points, max.first, last);
+                        m_keep[max1.second >= max2.second ? max1.first : max2.first] = true;
+                        if (max1.first == 0 && max2.first == max.first) {
+                            // all points are on a line
+                            m_keep.assign(points.size(), true);
+                        }
+                    }
+                }
+
+                for (std::size_t i = 0; i <= last; ++i) {
+                    if (m_keep[i]) {
+                        out.push_back(points[i]);
+                    }
+                }
+            }
+
+        }; // class DouglasPeucker
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_SIMPLIFY_HPP
@@ -0,0 +1,139 @@
+#ifndef OSMIUM_GEOM_SPHERICAL_AREA_HPP
+#define OSMIUM_GEOM_SPHERICAL_AREA_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/haversine.hpp>
+#include <osmium/geom/util.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace osmium {
+
+    namespace geom {
+
+        namespace detail {
+
+            /**
+             * Calculate twice the signed area of the part of a ring
+             * between consecutive points given as longitudes and
+             * latitudes in radians on the unit sphere. This loop can be
+             * vectorized by the compiler.
+             */
+            inline double spherical_ring_area_batch(const double* lon, const double* lat, std::size_t count) noexcept {
+                double sum = 0.0;
+                for (std::size_t i = 0; i + 1 < count; ++i) {
+                    sum += (lon[i + 1] - lon[i]) *
+                           (2.0 + sin_polynomial(lat[i]) + sin_polynomial(lat[i + 1]));
+                }
+                return sum;
+            }
+
+        } // namespace detail
+
+        /**
+         * Calculate the area of a ring on a spherical Earth (with
+         * radius haversine::EARTH_RADIUS_IN_METERS) in square meters.
+         *
+         * This uses the approximation for the area of a polygon on a
+         * sphere by Chamberlain and Duquette ("Some Algorithms for
+         * Polygons on a Sphere", JPL, 2007) that is also used in many
+         * web mapping libraries. The locations are processed in batches
+         * in a loop that can be vectorized by the compiler. The sin()
+         * function is replaced by a polynomial, this adds a relative
+         * error below 1e-9. Rings crossing the antimeridian are not
+         * supported.
+         *
+         * @returns The area, positive for rings in clockwise direction,
+         *          negative otherwise.
+         * @throws osmium::invalid_location if any location is invalid.
+         */
+        inline double spherical_signed_ring_area(const osmium::NodeRefList& ring) {
+            enum : std::size_t {
+                batch_size = 256
+            };
+
+            double lon[batch_size];
+            double lat[batch_size];
+            double sum = 0.0;
+
+            std::size_t count = 0;
+            for (const auto& node_ref : ring) {
+                lon[count] = deg_to_rad(node_ref.location().lon());
+                lat[count] = deg_to_rad(node_ref.location().lat());
+                ++count;
+                if (count == batch_size) {
+                    sum += detail::spherical_ring_area_batch(lon, lat, count);
+                    // the last point is the first point of the next batch
+                    lon[0] = lon[count - 1];
+                    lat[0] = lat[count - 1];
+                    count = 1;
+                }
+            }
+            sum += detail::spherical_ring_area_batch(lon, lat, count);
+
+            return sum * haversine::EARTH_RADIUS_IN_METERS * haversine::EARTH_RADIUS_IN_METERS * 0.5;
+        }
+
+        /**
+         * Calculate the area of an area on a spherical Earth in square
+         * meters. This is the sum of the areas of the outer rings minus
+         * the areas of the inner rings. See spherical_signed_ring_area()
+         * for details.
+         *
+         * @throws osmium::invalid_location if any location is invalid.
+         */
+        inline double spherical_area(const osmium::Area& area) {
+            double sum = 0.0;
+            for (const auto& item : area) {
+                if (item.type() == osmium::item_type::outer_ring) {
+                    sum += std::abs(spherical_signed_ring_area(static_cast<const osmium::OuterRing&>(item)));
+                } else if (item.type() == osmium::item_type::inner_ring) {
+                    sum -= std::abs(spherical_signed_ring_area(static_cast<const osmium::InnerRing&>(item)));
+                }
+            }
+            return std::max(sum, 0.0);
+        }
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_SPHERICAL_AREA_HPP
@@ -0,0 +1,329 @@
+#ifndef OSMIUM_GEOM_TILE_COVER_HPP
+#define OSMIUM_GEOM_TILE_COVER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/mercator_projection.hpp>
+#include <osmium/geom/tile.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * Key for a tile in a zoom level. The key contains the x and
+         * y coordinates of the tile but not the zoom level. Tiles in the
+         * same row are sorted by x coordinate.
+         */
+        inline constexpr uint64_t tile_key(uint32_t x, uint32_t y) noexcept {
+            return (static_cast<uint64_t>(y) << 32U) | x;
+        }
+
+        /// Get the key for a tile. The zoom level is not part of the key.
+        inline constexpr uint64_t tile_key(const Tile& tile) noexcept {
+            return tile_key(tile.x, tile.y);
+        }
+
+        /// Get the tile in the given zoom level from a key.
+        inline Tile tile_from_key(uint32_t zoom, uint64_t key) noexcept {
+            return Tile{zoom, static_cast<uint32_t>(key & 0xffffffffU), static_cast<uint32_t>(key >> 32U)};
+        }
+
+        /**
+         * Calculates the set of tiles in a zoom level covered by a
+         * geometry. Boxes cover all tiles they overlap, linestrings cover
+         * all tiles their segments pass through and areas cover the tiles
+         * their rings pass through and all tiles inside.
+         *
+         * The object can be re-used for many geometries, the internal
+         * buffers are kept around to avoid memory allocations. Call
+         * clear() between geometries or collect the tiles for several
+         * geometries. Invalid locations are ignored.
+         *
+         * Usage:
+         * @code
+         * osmium::geom::TileCover cover{14};
+         * cover.add_linestring(way.nodes());
+         * for (const auto key : cover.tiles()) {
+         *     const auto tile = osmium::geom::tile_from_key(14, key);
+         *     ...
+         * }
+         * @endcode
+         */
+        class TileCover {
+
+            struct tile_point {
+                double x;
+                double y;
+            };
+
+            std::vector<uint64_t> m_tiles;
+            std::vector<tile_point> m_points;
+            std::vector<std::size_t> m_ring_ends;
+            std::vector<double> m_crossings;
+            uint32_t m_zoom;
+            uint32_t m_max;
+            bool m_sorted = true;
+
+            tile_point to_tile_space(const osmium::Location& location) const {
+                const auto c = lonlat_to_mercator(location);
+                const double extent = tile_extent_in_zoom(m_zoom);
+                return tile_point{(c.x + detail::max_coordinate_epsg3857) / extent,
+                                  (detail::max_coordinate_epsg3857 - c.y) / extent};
+            }
+
+            uint32_t clamp(double value) const noexcept {
+                if (value < 0.0) {
+                    return 0;
+                }
+                if (value >= static_cast<double>(m_max)) {
+                    return m_max;
+                }
+                return static_cast<uint32_t>(value);
+            }
+
+            void add_tile(uint32_t x, uint32_t y) {
+                const auto key = tile_key(x, y);
+                if (!m_tiles.empty() && m_tiles.back() == key) {
+                    return;
+                }
+                if (!m_tiles.empty() && m_tiles.back() > key) {
+                    m_sorted = false;
+                }
+                m_tiles.push_back(key);
+            }
+
+            // Add all tiles the segment from a to b passes through
+            // (grid traversal by Amanatides and Woo).
+            void add_segment(const tile_point& a, const tile_point& b) {
+                auto x = clamp(a.x);
+                auto y = clamp(a.y);
+                const auto x_end = clamp(b.x);
+                const auto y_end = clamp(b.y);
+
+                add_tile(x, y);
+
+                const double dx = b.x - a.x;
+                const double dy = b.y - a.y;
+                const bool forward_x = x_end > x;
+                const bool forward_y = y_end > y;
+
+                const double inf = std::numeric_limits<double>::infinity();
+                double t_max_x = dx == 0.0 ? inf : ((forward_x ? x + 1 : x) - a.x) / dx;
+                double t_max_y = dy == 0.0 ? inf : ((forward_y ? y + 1 : y) - a.y) / dy;
+                const double t_delta_x = dx == 0.0 ? inf : std::abs(1.0 / dx);
+                const double t_delta_y = dy == 0.0 ? inf : std::abs(1.0 / dy);
+
+                // The number of steps is known, this makes sure rounding
+                // errors can not lead to an endless loop.
+                auto steps = static_cast<uint64_t>(x > x_end ? x - x_end : x_end - x) +
+                             static_cast<uint64_t>(y > y_end ? y - y_end : y_end - y);
+                while (steps > 0) {
+                    if ((t_max_x < t_max_y && x != x_end) || y == y_end) {
+                        t_max_x += t_delta_x;
+                        x = forward_x ? x + 1 : x - 1;
+                    } else {
+                        t_max_y += t_delta_y;
+                        y = forward_y ? y + 1 : y - 1;
+                    }
+                    add_tile(x, y);
+                    --steps;
+                }
+            }
+
+            void add_points(const osmium::NodeRefList& nodes) {
+                for (const auto& node_ref : nodes) {
+                    if (node_ref.location().valid()) {
+                        m_points.push_back(to_tile_space(node_ref.location()));
+                    }
+                }
+            }
+
+            // Fill the inside of the rings in m_points row by row using
+            // the crossings of the scanline through the tile centers with
+            // the ring segments (even-odd rule).
+            void fill_rings(double min_y, double max_y) {
+                const auto row_end = clamp(max_y);
+                for (auto row = clamp(min_y); row <= row_end; ++row) {
+                    const double scan_y = row + 0.5;
+                    m_crossings.clear();
+                    std::size_t begin = 0;
+                    for (const auto end : m_ring_ends) {
+                        for (std::size_t i = begin + 1; i < end; ++i) {
+                            const auto& a = m_points[i - 1];
+                            const auto& b = m_points[i];
+                            if ((a.y <= scan_y) != (b.y <= scan_y)) {
+                                m_crossings.push_back(a.x + (scan_y - a.y) * (b.x - a.x) / (b.y - a.y));
+                            }
+                        }
+                        begin = end;
+                    }
+                    std::sort(m_crossings.begin(), m_crossings.end());
+                    for (std::size_t i = 1; i < m_crossings.size(); i += 2) {
+                        const auto x_end = clamp(m_crossings[i]);
+                        for (auto x = clamp(m_crossings[i - 1]); x <= x_end; ++x) {
+                            add_tile(x, row);
+                        }
+                    }
+                }
+            }
+
+        public:
+
+            /**
+             * Constructor.
+             *
+             * @param zoom Zoom level of the tiles.
+             * @pre @code zoom <= 30 @endcode
+             */
+            explicit TileCover(uint32_t zoom) :
+                m_zoom(zoom),
+                m_max(num_tiles_in_zoom(zoom) - 1) {
+                assert(zoom <= Tile::max_zoom);
+            }
+
+            uint32_t zoom() const noexcept {
+                return m_zoom;
+            }
+
+            /// Add the tile containing the location.
+            void add_location(const osmium::Location& location) {
+                if (location.valid()) {
+                    const auto p = to_tile_space(location);
+                    add_tile(clamp(p.x), clamp(p.y));
+                }
+            }
+
+            /// Add all tiles overlapping the box.
+            void add_box(const osmium::Box& box) {
+                if (!box.valid()) {
+                    return;
+                }
+                const auto bottom_left = to_tile_space(box.bottom_left());
+                const auto top_right = to_tile_space(box.top_right());
+                const auto x_end = clamp(top_right.x);
+                const auto y_end = clamp(bottom_left.y);
+                for (auto y = clamp(top_right.y); y <= y_end; ++y) {
+                    for (auto x = clamp(bottom_left.x); x <= x_end; ++x) {
+                        add_tile(x, y);
+                    }
+                }
+            }
+
+            /// Add all tiles the linestring passes through.
+            void add_linestring(const osmium::NodeRefList& nodes) {
+                m_points.clear();
+                add_points(nodes);
+                if (m_points.size() == 1) {
+                    add_tile(clamp(m_points[0].x), clamp(m_points[0].y));
+                }
+                for (std::size_t i = 1; i < m_points.size(); ++i) {
+                    add_segment(m_points[i - 1], m_points[i]);
+                }
+            }
+
+            /// Add all tiles the rings of the area pass through or are inside.
+            void add_area(const osmium::Area& area) {
+                m_points.clear();
+                m_ring_ends.clear();
+                for (const auto& item : area) {
+                    if (item.type() == osmium::item_type::outer_ring ||
+                        item.type() == osmium::item_type::inner_ring) {
+                        add_points(static_cast<const osmium::NodeRefList&>(item));
+                        m_ring_ends.push_back(m_points.size());
+                    }
+                }
+                if (m_points.empty()) {
+                    return;
+                }
+
+                double min_y = m_points.front().y;
+                double max_y = min_y;
+                std::size_t begin = 0;
+                for (const auto end : m_ring_ends) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        if (i > begin) {
+                            add_segment(m_points[i - 1], m_points[i]);
+                        }
+                        min_y = std::min(min_y, m_points[i].y);
+                        max_y = std::max(max_y, m_points[i].y);
+                    }
+                    begin = end;
+                }
+
+                fill_rings(min_y, max_y);
+            }
+
+            /**
+             * Get the keys of all tiles added since the last clear(), in
+             * order and without duplicates. Use tile_from_key() to get the
+             * tiles.
+             */
+            const std::vector<uint64_t>& tiles() {
+                if (!m_sorted) {
+                    std::sort(m_tiles.begin(), m_tiles.end());
+                    m_sorted = true;
+                }
+                m_tiles.erase(std::unique(m_tiles.begin(), m_tiles.end()), m_tiles.end());
+                return m_tiles;
+            }
+
+            /// Remove all tiles.
+            void clear() noexcept {
+                m_tiles.clear();
+                m_sorted = true;
+            }
+
+        }; // class TileCover
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_TILE_COVER_HPP
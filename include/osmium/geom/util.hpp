@@ -70,6 +70,32 @@ namespace osmium {
             return radians * (180.0 / PI);
         }
 
+        namespace detail {
+
+            /**
+             * Polynomial approximation of sin(x) (Taylor series up to
+             * x^13). For |x| <= PI/2 the absolute error is below 1e-9.
+             * Unlike std::sin() this can be auto-vectorized by the
+             * compiler.
+             */
+            inline constexpr double sin_polynomial(double x) noexcept {
+                return x * (1.0 + x * x * (-1.0 / 6.0 + x * x * (1.0 / 120.0 + x * x * (-1.0 / 5040.0 +
+                       x * x * (1.0 / 362880.0 + x * x * (-1.0 / 39916800.0 + x * x * (1.0 / 6227020800.0)))))));
+            }
+
+            /**
+             * Polynomial approximation of cos(x) (Taylor series up to
+             * x^14). For |x| <= PI/2 the absolute error is below 1e-10.
+             * Unlike std::cos() this can be auto-vectorized by the
+             * compiler.
+             */
+            inline constexpr double cos_polynomial(double x) noexcept {
+                return 1.0 + x * x * (-1.0 / 2.0 + x * x * (1.0 / 24.0 + x * x * (-1.0 / 720.0 + x * x * (1.0 / 40320.0 +
+                       x * x * (-1.0 / 3628800.0 + x * x * (1.0 / 479001600.0 + x * x * (-1.0 / 87178291200.0)))))));
+            }
+
+        } // namespace detail
+
     } // namespace geom
 
 } // namespace osmium
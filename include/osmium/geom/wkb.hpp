@@ -35,12 +35,17 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/geom/coordinates.hpp>
 #include <osmium/geom/factory.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref_list.hpp>
 #include <osmium/util/endian.hpp>
 
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <string>
+#include <type_traits>
 
 namespace osmium {
 
@@ -63,48 +68,85 @@ namespace osmium {
                 str.append(reinterpret_cast<const char*>(&data), sizeof(T));
             }
 
-            inline std::string convert_to_hex(const std::string& str) {
-                static const char* lookup_hex = "0123456789ABCDEF";
-                std::string out;
-                out.reserve(str.size() * 2);
+            /**
+             * Lookup table with the two hex digits for each byte value.
+             */
+            class hex_lookup_table {
+
+                char m_data[512];
+
+            public:
+
+                hex_lookup_table() noexcept {
+                    static const char* lookup_hex = "0123456789ABCDEF";
+                    for (unsigned int i = 0; i < 256; ++i) {
+                        m_data[2 * i]     = lookup_hex[i >> 4U];
+                        m_data[2 * i + 1] = lookup_hex[i & 0xfU];
+                    }
+                }
+
+                const char* get(unsigned char c) const noexcept {
+                    return m_data + 2 * c;
+                }
+
+            }; // class hex_lookup_table
+
+            inline const hex_lookup_table& hex_lookup() {
+                static const hex_lookup_table table;
+                return table;
+            }
 
-                for (const char c : str) {
-                    out += lookup_hex[(static_cast<unsigned int>(c) >> 4U) & 0xfU];
-                    out += lookup_hex[ static_cast<unsigned int>(c)        & 0xfU];
+            inline void hex_encode(const char* data, std::size_t size, char* out) {
+                const auto& table = hex_lookup();
+                for (std::size_t i = 0; i < size; ++i) {
+                    const char* hex = table.get(static_cast<unsigned char>(data[i]));
+                    *out++ = hex[0];
+                    *out++ = hex[1];
                 }
+            }
+
+            template <typename T>
+            inline void hex_push(std::string& str, T data) {
+                char buffer[sizeof(T) * 2];
+                hex_encode(reinterpret_cast<const char*>(&data), sizeof(T), buffer);
+                str.append(buffer, sizeof(buffer));
+            }
 
+            inline std::string convert_to_hex(const std::string& str) {
+                std::string out(str.size() * 2, '\0');
+                hex_encode(str.data(), str.size(), &out[0]);
                 return out;
             }
 
-            class WKBFactoryImpl {
+            /**
+            * Type of WKB geometry.
+            * These definitions are from
+            * 99-049_OpenGIS_Simple_Features_Specification_For_SQL_Rev_1.1.pdf (for WKB)
+            * and https://trac.osgeo.org/postgis/browser/trunk/doc/ZMSgeoms.txt (for EWKB).
+            * They are used to encode geometries into the WKB format.
+            */
+            enum wkbGeometryType : uint32_t {
+                wkbPoint               = 1,
+                wkbLineString          = 2,
+                wkbPolygon             = 3,
+                wkbMultiPoint          = 4,
+                wkbMultiLineString     = 5,
+                wkbMultiPolygon        = 6,
+                wkbGeometryCollection  = 7,
+
+                // SRID-presence flag (EWKB)
+                wkbSRID                = 0x20000000
+            }; // enum wkbGeometryType
+
+            /**
+            * Byte order marker in WKB geometry.
+            */
+            enum class wkb_byte_order_type : uint8_t {
+                XDR = 0,         // Big Endian
+                NDR = 1          // Little Endian
+            }; // enum class wkb_byte_order_type
 
-                /**
-                * Type of WKB geometry.
-                * These definitions are from
-                * 99-049_OpenGIS_Simple_Features_Specification_For_SQL_Rev_1.1.pdf (for WKB)
-                * and https://trac.osgeo.org/postgis/browser/trunk/doc/ZMSgeoms.txt (for EWKB).
-                * They are used to encode geometries into the WKB format.
-                */
-                enum wkbGeometryType : uint32_t {
-                    wkbPoint               = 1,
-                    wkbLineString          = 2,
-                    wkbPolygon             = 3,
-                    wkbMultiPoint          = 4,
-                    wkbMultiLineString     = 5,
-                    wkbMultiPolygon        = 6,
-                    wkbGeometryCollection  = 7,
-
-                    // SRID-presence flag (EWKB)
-                    wkbSRID                = 0x20000000
-                }; // enum wkbGeometryType
-
-                /**
-                * Byte order marker in WKB geometry.
-                */
-                enum class wkb_byte_order_type : uint8_t {
-                    XDR = 0,         // Big Endian
-                    NDR = 1          // Little Endian
-                }; // enum class wkb_byte_order_type
+            class WKBFactoryImpl {
 
                 std::string m_data;
                 uint32_t m_points = 0;
@@ -291,11 +333,388 @@ namespace osmium {
 
             }; // class WKBFactoryImpl
 
+            /**
+             * WKB factory implementation appending all geometries to an
+             * output string given in the constructor instead of returning
+             * a new string for each geometry. The output can be re-used
+             * (for instance cleared after sending it to the database)
+             * so that no memory allocations are needed once it is large
+             * enough. Hex output is written directly without converting
+             * a binary version.
+             *
+             * All create functions return the number of bytes appended.
+             * If a geometry_error is thrown by the factory, a partial
+             * geometry might have been appended to the output. Use
+             * resize() on the output with the size from before the call to
+             * remove it.
+             */
+            class WKBSinkFactoryImpl {
+
+                std::string* m_out;
+                int m_srid;
+                wkb_type m_wkb_type;
+                out_type m_out_type;
+
+                std::size_t m_start = 0;
+                uint32_t m_points = 0;
+                std::size_t m_polygons = 0;
+                std::size_t m_rings = 0;
+                std::size_t m_linestring_size_offset = 0;
+                std::size_t m_multipolygon_size_offset = 0;
+                std::size_t m_polygon_size_offset = 0;
+                std::size_t m_ring_size_offset = 0;
+
+                template <typename T>
+                void push(T data) const {
+                    if (m_out_type == out_type::hex) {
+                        hex_push(*m_out, data);
+                    } else {
+                        str_push(*m_out, data);
+                    }
+                }
+
+                std::size_t header(wkbGeometryType type, bool add_length) const {
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+                    push(wkb_byte_order_type::NDR);
+#else
+                    push(wkb_byte_order_type::XDR);
+#endif
+                    if (m_wkb_type == wkb_type::ewkb) {
+                        push(type | wkbSRID);
+                        push(m_srid);
+                    } else {
+                        push(type);
+                    }
+                    const std::size_t offset = m_out->size();
+                    if (add_length) {
+                        push(static_cast<uint32_t>(0));
+                    }
+                    return offset;
+                }
+
+                void set_size(const std::size_t offset, const std::size_t size) {
+                    if (size > std::numeric_limits<uint32_t>::max()) {
+                        throw geometry_error{"Too many points in geometry"};
+                    }
+                    const auto s = static_cast<uint32_t>(size);
+                    const char* ptr = reinterpret_cast<const char*>(&s);
+                    if (m_out_type == out_type::hex) {
+                        hex_encode(ptr, sizeof(uint32_t), &(*m_out)[offset]);
+                    } else {
+                        std::copy_n(ptr, sizeof(uint32_t), &(*m_out)[offset]);
+                    }
+                }
+
+                std::size_t start(wkbGeometryType type) {
+                    m_start = m_out->size();
+                    return header(type, true);
+                }
+
+                std::size_t finish() const noexcept {
+                    return m_out->size() - m_start;
+                }
+
+            public:
+
+                using point_type        = std::size_t;
+                using linestring_type   = std::size_t;
+                using polygon_type      = std::size_t;
+                using multipolygon_type = std::size_t;
+                using ring_type         = std::size_t;
+
+                WKBSinkFactoryImpl(int srid, std::string& out, wkb_type wtype = wkb_type::wkb, out_type otype = out_type::binary) :
+                    m_out(&out),
+                    m_srid(srid),
+                    m_wkb_type(wtype),
+                    m_out_type(otype) {
+                }
+
+                /* Point */
+
+                point_type make_point(const osmium::geom::Coordinates& xy) const {
+                    const auto size = m_out->size();
+                    header(wkbPoint, false);
+                    push(xy.x);
+                    push(xy.y);
+                    return m_out->size() - size;
+                }
+
+                /* LineString */
+
+                void linestring_start() {
+                    m_linestring_size_offset = start(wkbLineString);
+                }
+
+                void linestring_add_location(const osmium::geom::Coordinates& xy) {
+                    push(xy.x);
+                    push(xy.y);
+                }
+
+                linestring_type linestring_finish(std::size_t num_points) {
+                    set_size(m_linestring_size_offset, num_points);
+                    return finish();
+                }
+
+                /* Polygon */
+
+                void polygon_start() {
+                    set_size(start(wkbPolygon), 1);
+                    m_ring_size_offset = m_out->size();
+                    push(static_cast<uint32_t>(0));
+                }
+
+                void polygon_add_location(const osmium::geom::Coordinates& xy) {
+                    push(xy.x);
+                    push(xy.y);
+                }
+
+                polygon_type polygon_finish(std::size_t num_points) {
+                    set_size(m_ring_size_offset, num_points);
+                    return finish();
+                }
+
+                /* MultiPolygon */
+
+                void multipolygon_start() {
+                    m_polygons = 0;
+                    m_multipolygon_size_offset = start(wkbMultiPolygon);
+                }
+
+                void multipolygon_polygon_start() {
+                    ++m_polygons;
+                    m_rings = 0;
+                    m_polygon_size_offset = header(wkbPolygon, true);
+                }
+
+                void multipolygon_polygon_finish() {
+                    set_size(m_polygon_size_offset, m_rings);
+                }
+
+                void multipolygon_outer_ring_start() {
+                    ++m_rings;
+                    m_points = 0;
+                    m_ring_size_offset = m_out->size();
+                    push(static_cast<uint32_t>(0));
+                }
+
+                void multipolygon_outer_ring_finish() {
+                    set_size(m_ring_size_offset, m_points);
+                }
+
+                void multipolygon_inner_ring_start() {
+                    ++m_rings;
+                    m_points = 0;
+                    m_ring_size_offset = m_out->size();
+                    push(static_cast<uint32_t>(0));
+                }
+
+                void multipolygon_inner_ring_finish() {
+                    set_size(m_ring_size_offset, m_points);
+                }
+
+                void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
+                    push(xy.x);
+                    push(xy.y);
+                    ++m_points;
+                }
+
+                multipolygon_type multipolygon_finish() {
+                    set_size(m_multipolygon_size_offset, m_polygons);
+                    return finish();
+                }
+
+            }; // class WKBSinkFactoryImpl
+
+            /**
+             * Writes the multipolygon geometry of an area in (E)WKB format
+             * in one pass over the rings. Used by append_multipolygon_wkb().
+             */
+            template <typename TProjection, bool THex>
+            class area_wkb_writer {
+
+                std::string* m_out;
+                const TProjection* m_projection;
+                int m_srid;
+                wkb_type m_wkb_type;
+
+                template <typename T>
+                void push(T data, std::true_type /*hex*/) {
+                    hex_push(*m_out, data);
+                }
+
+                template <typename T>
+                void push(T data, std::false_type /*hex*/) {
+                    str_push(*m_out, data);
+                }
+
+                template <typename T>
+                void push(T data) {
+                    push(data, std::integral_constant<bool, THex>{});
+                }
+
+                std::size_t push_size_placeholder() {
+                    const std::size_t offset = m_out->size();
+                    push(static_cast<uint32_t>(0));
+                    return offset;
+                }
+
+                void set_size(const std::size_t offset, const std::size_t size) {
+                    if (size > std::numeric_limits<uint32_t>::max()) {
+                        throw geometry_error{"Too many points in geometry"};
+                    }
+                    const auto s = static_cast<uint32_t>(size);
+                    const char* ptr = reinterpret_cast<const char*>(&s);
+                    if (THex) {
+                        hex_encode(ptr, sizeof(uint32_t), &(*m_out)[offset]);
+                    } else {
+                        std::copy_n(ptr, sizeof(uint32_t), &(*m_out)[offset]);
+                    }
+                }
+
+                void header(wkbGeometryType type) {
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+                    push(wkb_byte_order_type::NDR);
+#else
+                    push(wkb_byte_order_type::XDR);
+#endif
+                    if (m_wkb_type == wkb_type::ewkb) {
+                        push(type | wkbSRID);
+                        push(m_srid);
+                    } else {
+                        push(type);
+                    }
+                }
+
+                void ring(const osmium::NodeRefList& nodes) {
+                    const std::size_t offset = push_size_placeholder();
+                    std::size_t num_points = 0;
+                    osmium::Location last_location;
+                    for (const auto& node_ref : nodes) {
+                        if (last_location != node_ref.location()) {
+                            last_location = node_ref.location();
+                            const Coordinates xy = (*m_projection)(last_location);
+                            push(xy.x);
+                            push(xy.y);
+                            ++num_points;
+                        }
+                    }
+                    set_size(offset, num_points);
+                }
+
+            public:
+
+                area_wkb_writer(std::string& out, const TProjection& projection, wkb_type wtype) :
+                    m_out(&out),
+                    m_projection(&projection),
+                    m_srid(projection.epsg()),
+                    m_wkb_type(wtype) {
+                }
+
+                void write(const osmium::Area& area) {
+                    header(wkbMultiPolygon);
+                    const std::size_t multipolygon_size_offset = push_size_placeholder();
+                    std::size_t polygon_size_offset = 0;
+                    std::size_t num_polygons = 0;
+                    std::size_t num_rings = 0;
+
+                    for (const auto& item : area) {
+                        if (item.type() == osmium::item_type::outer_ring) {
+                            if (num_polygons > 0) {
+                                set_size(polygon_size_offset, num_rings);
+                            }
+                            header(wkbPolygon);
+                            polygon_size_offset = push_size_placeholder();
+                            num_rings = 1;
+                            ++num_polygons;
+                            ring(static_cast<const osmium::OuterRing&>(item));
+                        } else if (item.type() == osmium::item_type::inner_ring) {
+                            if (num_polygons == 0) {
+                                throw osmium::geometry_error{"invalid area"};
+                            }
+                            ++num_rings;
+                            ring(static_cast<const osmium::InnerRing&>(item));
+                        }
+                    }
+
+                    if (num_polygons == 0) {
+                        throw osmium::geometry_error{"invalid area"};
+                    }
+
+                    set_size(polygon_size_offset, num_rings);
+                    set_size(multipolygon_size_offset, num_polygons);
+                }
+
+            }; // class area_wkb_writer
+
         } // namespace detail
 
         template <typename TProjection = IdentityProjection>
         using WKBFactory = GeometryFactory<osmium::geom::detail::WKBFactoryImpl, TProjection>;
 
+        /**
+         * WKB factory appending all geometries to a string given to the
+         * constructor. See detail::WKBSinkFactoryImpl for details.
+         */
+        template <typename TProjection = IdentityProjection>
+        using WKBSinkFactory = GeometryFactory<osmium::geom::detail::WKBSinkFactoryImpl, TProjection>;
+
+        /**
+         * Append the multipolygon geometry of an area in (E)WKB format to
+         * the string out. The output is the same as the one from
+         * WKBFactory<TProjection>::create_multipolygon(), but the rings
+         * are walked only once and the projected coordinates are written
+         * (hex encoded if requested) directly to the output without going
+         * through the generic GeometryFactory callbacks or a temporary
+         * string.
+         *
+         * @param out String to append the geometry to.
+         * @param area The area.
+         * @param projection The projection to use.
+         * @param wtype Write WKB or EWKB.
+         * @param otype Write binary or hex output.
+         * @returns The number of bytes appended to out.
+         * @throws osmium::geometry_error If the area has no rings or the
+         *         geometry is too large. The out string is unchanged in
+         *         that case.
+         * @throws osmium::invalid_location If a location is invalid. The
+         *         out string is unchanged in that case.
+         */
+        template <typename TProjection>
+        std::size_t append_multipolygon_wkb(std::string& out,
+                                            const osmium::Area& area,
+                                            const TProjection& projection,
+                                            wkb_type wtype = wkb_type::wkb,
+                                            out_type otype = out_type::hex) {
+            const auto size = out.size();
+            try {
+                if (otype == out_type::hex) {
+                    detail::area_wkb_writer<TProjection, true>{out, projection, wtype}.write(area);
+                } else {
+                    detail::area_wkb_writer<TProjection, false>{out, projection, wtype}.write(area);
+                }
+            } catch (osmium::geometry_error& e) {
+                out.resize(size);
+                e.set_id("area", area.id());
+                throw;
+            } catch (...) {
+                out.resize(size);
+                throw;
+            }
+            return out.size() - size;
+        }
+
+        /**
+         * Append the multipolygon geometry of an area in (E)WKB format to
+         * the string out using the IdentityProjection. See above for
+         * details.
+         */
+        inline std::size_t append_multipolygon_wkb(std::string& out,
+                                                   const osmium::Area& area,
+                                                   wkb_type wtype = wkb_type::wkb,
+                                                   out_type otype = out_type::hex) {
+            return append_multipolygon_wkb(out, area, IdentityProjection{}, wtype, otype);
+        }
+
     } // namespace geom
 
 } // namespace osmium
@@ -183,11 +183,154 @@ namespace osmium {
 
             }; // class WKTFactoryImpl
 
+            /**
+             * WKT factory implementation appending all geometries to an
+             * output string given in the constructor instead of returning
+             * a new string for each geometry. See WKBSinkFactoryImpl for
+             * details.
+             *
+             * All create functions return the number of characters
+             * appended. If a geometry_error is thrown, a partial geometry
+             * might have been appended to the output.
+             */
+            class WKTSinkFactoryImpl {
+
+                std::string m_srid_prefix;
+                std::string* m_out;
+                std::size_t m_start = 0;
+                int m_precision;
+                wkt_type m_wkt_type;
+
+                void start(const char* type) {
+                    m_start = m_out->size();
+                    *m_out += m_srid_prefix;
+                    *m_out += type;
+                }
+
+                std::size_t finish() const noexcept {
+                    return m_out->size() - m_start;
+                }
+
+            public:
+
+                using point_type        = std::size_t;
+                using linestring_type   = std::size_t;
+                using polygon_type      = std::size_t;
+                using multipolygon_type = std::size_t;
+                using ring_type         = std::size_t;
+
+                WKTSinkFactoryImpl(int srid, std::string& out, int precision = 7, wkt_type wtype = wkt_type::wkt) :
+                    m_out(&out),
+                    m_precision(precision),
+                    m_wkt_type(wtype) {
+                    if (m_wkt_type == wkt_type::ewkt) {
+                        m_srid_prefix = "SRID=";
+                        m_srid_prefix += std::to_string(srid);
+                        m_srid_prefix += ';';
+                    }
+                }
+
+                /* Point */
+
+                point_type make_point(const osmium::geom::Coordinates& xy) const {
+                    const auto size = m_out->size();
+                    *m_out += m_srid_prefix;
+                    *m_out += "POINT";
+                    xy.append_to_string(*m_out, '(', ' ', ')', m_precision);
+                    return m_out->size() - size;
+                }
+
+                /* LineString */
+
+                void linestring_start() {
+                    start("LINESTRING(");
+                }
+
+                void linestring_add_location(const osmium::geom::Coordinates& xy) {
+                    xy.append_to_string(*m_out, ' ', m_precision);
+                    *m_out += ',';
+                }
+
+                linestring_type linestring_finish(size_t /* num_points */) {
+                    assert(!m_out->empty());
+                    m_out->back() = ')';
+                    return finish();
+                }
+
+                /* Polygon */
+                void polygon_start() {
+                    start("POLYGON((");
+                }
+
+                void polygon_add_location(const osmium::geom::Coordinates& xy) {
+                    xy.append_to_string(*m_out, ' ', m_precision);
+                    *m_out += ',';
+                }
+
+                polygon_type polygon_finish(size_t /* num_points */) {
+                    assert(!m_out->empty());
+                    m_out->back() = ')';
+                    *m_out += ')';
+                    return finish();
+                }
+
+                /* MultiPolygon */
+
+                void multipolygon_start() {
+                    start("MULTIPOLYGON(");
+                }
+
+                void multipolygon_polygon_start() {
+                    *m_out += '(';
+                }
+
+                void multipolygon_polygon_finish() {
+                    *m_out += "),";
+                }
+
+                void multipolygon_outer_ring_start() {
+                    *m_out += '(';
+                }
+
+                void multipolygon_outer_ring_finish() {
+                    assert(!m_out->empty());
+                    m_out->back() = ')';
+                }
+
+                void multipolygon_inner_ring_start() {
+                    *m_out += ",(";
+                }
+
+                void multipolygon_inner_ring_finish() {
+                    assert(!m_out->empty());
+                    m_out->back() = ')';
+                }
+
+                void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
+                    xy.append_to_string(*m_out, ' ', m_precision);
+                    *m_out += ',';
+                }
+
+                multipolygon_type multipolygon_finish() {
+                    assert(!m_out->empty());
+                    m_out->back() = ')';
+                    return finish();
+                }
+
+            }; // class WKTSinkFactoryImpl
+
         } // namespace detail
 
         template <typename TProjection = IdentityProjection>
         using WKTFactory = GeometryFactory<osmium::geom::detail::WKTFactoryImpl, TProjection>;
 
+        /**
+         * WKT factory appending all geometries to a string given to the
+         * constructor. See detail::WKTSinkFactoryImpl for details.
+         */
+        template <typename TProjection = IdentityProjection>
+        using WKTSinkFactory = GeometryFactory<osmium::geom::detail::WKTSinkFactoryImpl, TProjection>;
+
     } // namespace geom
 
 } // namespace osmium
@@ -0,0 +1,235 @@
+#ifndef OSMIUM_GRAPH_CSR_GRAPH_HPP
+#define OSMIUM_GRAPH_CSR_GRAPH_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * @brief Building routing graphs from OSM data.
+     */
+    namespace graph {
+
+        /**
+         * A directed graph in "compressed sparse row" format: The edges
+         * are stored sorted by their source vertex, so the outgoing edges
+         * of each vertex are in a contiguous range. For each vertex the
+         * offset of its first edge is stored in an array with one
+         * additional entry at the end.
+         *
+         * The vertices are the OSM nodes where ways meet or end, they are
+         * numbered in the order of their node IDs. Each edge is the part
+         * of a way between two such nodes. Edges store their target
+         * vertex, their length in meters and the ID of the way they come
+         * from.
+         *
+         * Usually created with a GraphBuilder.
+         */
+        class CSRGraph {
+
+        public:
+
+            using vertex_type = uint32_t;
+            using edge_index_type = uint64_t;
+
+            enum : vertex_type {
+                /// Returned by find_vertex() if there is no such vertex.
+                invalid_vertex = std::numeric_limits<vertex_type>::max()
+            };
+
+        private:
+
+            std::vector<osmium::unsigned_object_id_type> m_node_ids;
+            std::vector<osmium::Location> m_locations;
+            std::vector<edge_index_type> m_offsets;
+            std::vector<vertex_type> m_targets;
+            std::vector<float> m_lengths;
+            std::vector<osmium::object_id_type> m_way_ids;
+
+        public:
+
+            CSRGraph() :
+                m_offsets(1, 0) {
+            }
+
+            /**
+             * Create graph from its parts. Used by the GraphBuilder.
+             *
+             * @param node_ids Node IDs of all vertices in ascending order.
+             * @param locations Locations of all vertices.
+             * @param offsets Offset of first edge of each vertex plus the
+             *        number of edges at the end.
+             * @param targets Target vertex of each edge.
+             * @param lengths Length of each edge.
+             * @param way_ids Way ID of each edge.
+             */
+            CSRGraph(std::vector<osmium::unsigned_object_id_type>&& node_ids,
+                     std::vector<osmium::Location>&& locations,
+                     std::vector<edge_index_type>&& offsets,
+                     std::vector<vertex_type>&& targets,
+                     std::vector<float>&& lengths,
+                     std::vector<osmium::object_id_type>&& way_ids) noexcept :
+                m_node_ids(std::move(node_ids)),
+                m_locations(std::move(locations)),
+                m_offsets(std::move(offsets)),
+                m_targets(std::move(targets)),
+                m_lengths(std::move(lengths)),
+                m_way_ids(std::move(way_ids)) {
+                assert(m_node_ids.size() == m_locations.size());
+                assert(m_offsets.size() == m_node_ids.size() + 1);
+                assert(m_offsets.back() == m_targets.size());
+                assert(m_targets.size() == m_lengths.size());
+                assert(m_targets.size() == m_way_ids.size());
+            }
+
+            /// The number of vertices.
+            std::size_t num_vertices() const noexcept {
+                return m_node_ids.size();
+            }
+
+            /// The number of (directed) edges.
+            std::size_t num_edges() const noexcept {
+                return m_targets.size();
+            }
+
+            /// The ID of the node the vertex was created from.
+            osmium::unsigned_object_id_type node_id(vertex_type vertex) const noexcept {
+                assert(vertex < m_node_ids.size());
+                return m_node_ids[vertex];
+            }
+
+            /**
+             * The location of the vertex. Can be invalid if the vertex
+             * has no edges, because none of the ways it is in had valid
+             * locations.
+             */
+            osmium::Location location(vertex_type vertex) const noexcept {
+                assert(vertex < m_locations.size());
+                return m_locations[vertex];
+            }
+
+            /**
+             * Find the vertex for a node.
+             *
+             * @returns The vertex or invalid_vertex if the node is not a
+             *          vertex of the graph.
+             */
+            vertex_type find_vertex(osmium::unsigned_object_id_type node_id) const noexcept {
+                const auto it = std::lower_bound(m_node_ids.cbegin(), m_node_ids.cend(), node_id);
+                if (it == m_node_ids.cend() || *it != node_id) {
+                    return invalid_vertex;
+                }
+                return static_cast<vertex_type>(it - m_node_ids.cbegin());
+            }
+
+            /// Index of the first outgoing edge of the vertex.
+            edge_index_type first_edge(vertex_type vertex) const noexcept {
+                assert(vertex < num_vertices());
+                return m_offsets[vertex];
+            }
+
+            /// Index one past the last outgoing edge of the vertex.
+            edge_index_type end_edge(vertex_type vertex) const noexcept {
+                assert(vertex < num_vertices());
+                return m_offsets[vertex + 1];
+            }
+
+            /// The number of outgoing edges of the vertex.
+            std::size_t out_degree(vertex_type vertex) const noexcept {
+                return static_cast<std::size_t>(end_edge(vertex) - first_edge(vertex));
+            }
+
+            /// The target vertex of the edge.
+            vertex_type target(edge_index_type edge) const noexcept {
+                assert(edge < num_edges());
+                return m_targets[edge];
+            }
+
+            /// The length of the edge in meters.
+            float length(edge_index_type edge) const noexcept {
+                assert(edge < num_edges());
+                return m_lengths[edge];
+            }
+
+            /// The ID of the way the edge was created from.
+            osmium::object_id_type way_id(edge_index_type edge) const noexcept {
+                assert(edge < num_edges());
+                return m_way_ids[edge];
+            }
+
+            /// Access the offsets array (size is num_vertices() + 1).
+            const std::vector<edge_index_type>& offsets() const noexcept {
+                return m_offsets;
+            }
+
+            /// Access the array with the target vertices of all edges.
+            const std::vector<vertex_type>& targets() const noexcept {
+                return m_targets;
+            }
+
+            /// Access the array with the lengths of all edges.
+            const std::vector<float>& lengths() const noexcept {
+                return m_lengths;
+            }
+
+            /**
+             * Memory used in bytes.
+             */
+            std::size_t used_memory() const noexcept {
+                return sizeof(*this) +
+                       m_node_ids.capacity() * sizeof(osmium::unsigned_object_id_type) +
+                       m_locations.capacity() * sizeof(osmium::Location) +
+                       m_offsets.capacity() * sizeof(edge_index_type) +
+                       m_targets.capacity() * sizeof(vertex_type) +
+                       m_lengths.capacity() * sizeof(float) +
+                       m_way_ids.capacity() * sizeof(osmium::object_id_type);
+            }
+
+        }; // class CSRGraph
+
+    } // namespace graph
+
+} // namespace osmium
+
+#endif // OSMIUM_GRAPH_CSR_GRAPH_HPP
@@ -0,0 +1,451 @@
+#ifndef OSMIUM_GRAPH_GRAPH_BUILDER_HPP
+#define OSMIUM_GRAPH_GRAPH_BUILDER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/haversine.hpp>
+#include <osmium/graph/csr_graph.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/index/id_count.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace graph {
+
+        /**
+         * In which direction(s) can a way be traversed? Returned by the
+         * function given to the GraphBuilder for each way. Ways with
+         * "none" are not part of the graph.
+         */
+        enum class edge_direction {
+            none     = 0,
+            forward  = 1,
+            backward = 2,
+            both     = 3
+        };
+
+        namespace detail {
+
+            // An edge as created from a way. The nodes are still
+            // referenced by their IDs.
+            struct way_edge {
+                osmium::unsigned_object_id_type source;
+                osmium::unsigned_object_id_type target;
+                osmium::object_id_type way_id;
+                osmium::Location source_location;
+                osmium::Location target_location;
+                float length;
+            };
+
+            // Edges created from one buffer of ways.
+            struct way_edges {
+                std::vector<way_edge> edges;
+                std::size_t skipped = 0;
+            };
+
+            // An edge with the vertices already looked up.
+            struct vertex_edge {
+                CSRGraph::vertex_type source;
+                CSRGraph::vertex_type target;
+                float length;
+                osmium::object_id_type way_id;
+            };
+
+        } // namespace detail
+
+        /**
+         * Builds a routing graph (see CSRGraph) from ways. This needs
+         * two passes over the ways:
+         *
+         * 1. Use the builder as a handler for all ways. It counts for
+         *    each node how many ways use it, in two bits per node (see
+         *    osmium::index::IdCountDense). Nodes used by two or more
+         *    ways, or used twice by the same way, and the end nodes of
+         *    all ways become the vertices of the graph.
+         * 2. Call add_ways() with all buffers of ways. The ways must have
+         *    the locations of their nodes set, usually by a
+         *    NodeLocationsForWays handler. Each buffer is cut into edges
+         *    at the vertices in a task in the thread pool. Edge lengths
+         *    are calculated with the haversine formula.
+         *
+         * Finally call build() to get the graph. It looks up the vertices
+         * of all edges in parallel and sorts the edges with the pool.
+         *
+         * A function given to the constructor decides which ways are
+         * used and in which direction(s) they can be traversed. It has to
+         * give the same result in both passes and must be thread-safe,
+         * because it is called in the pool threads in the second pass.
+         *
+         * Ways with fewer than two nodes or with negative node IDs are
+         * ignored. Edges with invalid locations are left out, their
+         * number is available from skipped_edges().
+         *
+         * @code
+         * osmium::graph::GraphBuilder builder{pool, [](const osmium::Way& way) {
+         *     return way.tags()["highway"] ? osmium::graph::edge_direction::both
+         *                                  : osmium::graph::edge_direction::none;
+         * }};
+         * osmium::apply(reader1, builder);
+         * while (osmium::memory::Buffer buffer = reader2.read()) {
+         *     osmium::apply(buffer, location_handler);
+         *     builder.add_ways(std::move(buffer));
+         * }
+         * const auto graph = builder.build();
+         * @endcode
+         */
+        class GraphBuilder : public osmium::handler::Handler {
+
+        public:
+
+            using direction_function = std::function<edge_direction(const osmium::Way&)>;
+
+        private:
+
+            osmium::thread::Pool& m_pool;
+            direction_function m_direction;
+            osmium::index::IdCountDense<osmium::unsigned_object_id_type> m_node_count;
+            std::deque<std::future<detail::way_edges>> m_pending;
+            std::vector<detail::way_edge> m_edges;
+            std::size_t m_skipped_edges = 0;
+
+            static bool usable(const osmium::Way& way) noexcept {
+                const auto& nodes = way.nodes();
+                return nodes.size() >= 2 && std::all_of(nodes.cbegin(), nodes.cend(), [](const osmium::NodeRef& node_ref) {
+                    return node_ref.ref() >= 0;
+                });
+            }
+
+            void add_edge(detail::way_edges& result, edge_direction direction, const osmium::Way& way, const osmium::NodeRef& from, const osmium::NodeRef& to, double length) const {
+                if (direction == edge_direction::forward || direction == edge_direction::both) {
+                    result.edges.push_back(detail::way_edge{from.positive_ref(), to.positive_ref(), way.id(),
+                                                            from.location(), to.location(), static_cast<float>(length)});
+                }
+                if (direction == edge_direction::backward || direction == edge_direction::both) {
+                    result.edges.push_back(detail::way_edge{to.positive_ref(), from.positive_ref(), way.id(),
+                                                            to.location(), from.location(), static_cast<float>(length)});
+                }
+            }
+
+            // Cut the way into edges at all vertices.
+            void cut_way(detail::way_edges& result, edge_direction direction, const osmium::Way& way) const {
+                const auto& nodes = way.nodes();
+                const osmium::NodeRef* start = nodes.begin();
+                double length = 0.0;
+                bool valid = start->location().valid();
+                for (const osmium::NodeRef* it = start + 1; it != nodes.end(); ++it) {
+                    if (valid && it->location().valid()) {
+                        length += osmium::geom::haversine::distance(osmium::geom::Coordinates{(it - 1)->location()},
+                                                                    osmium::geom::Coordinates{it->location()});
+                    } else {
+                        valid = false;
+                    }
+                    if (it + 1 == nodes.end() || m_node_count.multiple(it->positive_ref())) {
+                        if (valid) {
+                            add_edge(result, direction, way, *start, *it, length);
+                        } else {
+                            ++result.skipped;
+                        }
+                        start = it;
+                        length = 0.0;
+                        valid = start->location().valid();
+                    }
+                }
+            }
+
+            detail::way_edges cut_ways(const osmium::memory::Buffer& buffer) const {
+                detail::way_edges result;
+                for (const auto& way : buffer.select<osmium::Way>()) {
+                    if (!usable(way)) {
+                        continue;
+                    }
+                    const auto direction = m_direction(way);
+                    if (direction != edge_direction::none) {
+                        cut_way(result, direction, way);
+                    }
+                }
+                return result;
+            }
+
+            void collect_front() {
+                auto result = m_pending.front().get();
+                m_pending.pop_front();
+                m_edges.insert(m_edges.end(), result.edges.cbegin(), result.edges.cend());
+                m_skipped_edges += result.skipped;
+            }
+
+            void wait_for_pending() noexcept {
+                for (auto& future : m_pending) {
+                    if (future.valid()) {
+                        future.wait();
+                    }
+                }
+            }
+
+            void collect_all() {
+                try {
+                    while (!m_pending.empty()) {
+                        collect_front();
+                    }
+                } catch (...) {
+                    // The tasks use this object, wait for them.
+                    wait_for_pending();
+                    m_pending.clear();
+                    throw;
+                }
+            }
+
+            std::vector<osmium::unsigned_object_id_type> vertex_ids() const {
+                std::vector<osmium::unsigned_object_id_type> ids;
+                ids.reserve(m_node_count.count_multiple());
+                m_node_count.for_each_multiple([&ids](osmium::unsigned_object_id_type id) {
+                    ids.push_back(id);
+                });
+                if (ids.size() >= static_cast<std::size_t>(CSRGraph::invalid_vertex)) {
+                    throw std::length_error{"too many vertices for routing graph"};
+                }
+                return ids;
+            }
+
+            // Look up the vertices of the edges [begin, end). The vertex
+            // locations are set in the calling thread afterwards, because
+            // several edges share the same vertex.
+            void lookup_vertices(const std::vector<osmium::unsigned_object_id_type>& ids, std::vector<detail::vertex_edge>& out, std::size_t begin, std::size_t end) const {
+                const auto find = [&ids](osmium::unsigned_object_id_type id) {
+                    return static_cast<CSRGraph::vertex_type>(std::lower_bound(ids.cbegin(), ids.cend(), id) - ids.cbegin());
+                };
+                for (auto i = begin; i < end; ++i) {
+                    const auto& edge = m_edges[i];
+                    out[i] = detail::vertex_edge{find(edge.source), find(edge.target), edge.length, edge.way_id};
+                }
+            }
+
+            template <typename TFunc>
+            void run_in_pool(std::size_t size, TFunc&& func) {
+                const auto num_tasks = std::max<std::size_t>(1, std::min(size / 4096, static_cast<std::size_t>(m_pool.num_threads())));
+                if (num_tasks == 1) {
+                    func(0, size);
+                    return;
+                }
+
+                std::vector<std::future<void>> futures;
+                futures.reserve(num_tasks);
+                for (std::size_t task = 0; task < num_tasks; ++task) {
+                    const auto begin = size * task / num_tasks;
+                    const auto end = size * (task + 1) / num_tasks;
+                    futures.push_back(m_pool.submit([&func, begin, end] {
+                        func(begin, end);
+                    }));
+                }
+
+                std::exception_ptr exception;
+                for (auto& future : futures) {
+                    try {
+                        future.get();
+                    } catch (...) {
+                        if (!exception) {
+                            exception = std::current_exception();
+                        }
+                    }
+                }
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+            }
+
+        public:
+
+            /**
+             * Constructor.
+             *
+             * @param pool The thread pool to use.
+             * @param direction Function deciding whether a way is used
+             *        and in which direction(s). By default all ways are
+             *        used in both directions.
+             */
+            explicit GraphBuilder(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(),
+                                  direction_function direction = nullptr) :
+                m_pool(pool),
+                m_direction(direction ? std::move(direction) : [](const osmium::Way& /*way*/) {
+                    return edge_direction::both;
+                }) {
+            }
+
+            GraphBuilder(const GraphBuilder&) = delete;
+            GraphBuilder& operator=(const GraphBuilder&) = delete;
+
+            GraphBuilder(GraphBuilder&&) = delete;
+            GraphBuilder& operator=(GraphBuilder&&) = delete;
+
+            ~GraphBuilder() noexcept {
+                wait_for_pending();
+            }
+
+            /**
+             * First pass: Count the nodes of the way. The end nodes are
+             * counted twice, so they always become vertices.
+             */
+            void way(const osmium::Way& way) {
+                if (!usable(way) || m_direction(way) == edge_direction::none) {
+                    return;
+                }
+                const auto& nodes = way.nodes();
+                for (const auto& node_ref : nodes) {
+                    m_node_count.add(node_ref.positive_ref());
+                }
+                m_node_count.add(nodes.front().positive_ref());
+                m_node_count.add(nodes.back().positive_ref());
+            }
+
+            /**
+             * Is the node a vertex of the graph? Valid after the first
+             * pass.
+             */
+            bool is_vertex(osmium::unsigned_object_id_type node_id) const noexcept {
+                return m_node_count.multiple(node_id);
+            }
+
+            /**
+             * Second pass: Cut all ways in the buffer into edges. This is
+             * done in a task in the pool. Call this with all buffers in
+             * the same order as in the first pass to get the same graph
+             * every time.
+             *
+             * @pre The first pass must be done.
+             * @throws Any exception from an earlier task.
+             */
+            void add_ways(osmium::memory::Buffer&& buffer) {
+                auto shared_buffer = std::make_shared<osmium::memory::Buffer>(std::move(buffer));
+                m_pending.push_back(m_pool.submit([this, shared_buffer]() {
+                    return cut_ways(*shared_buffer);
+                }));
+
+                try {
+                    while (m_pending.size() > 2 * static_cast<std::size_t>(m_pool.num_threads())) {
+                        collect_front();
+                    }
+                } catch (...) {
+                    wait_for_pending();
+                    m_pending.clear();
+                    throw;
+                }
+            }
+
+            /**
+             * Number of edges left out so far because they had invalid
+             * locations.
+             */
+            std::size_t skipped_edges() const noexcept {
+                return m_skipped_edges;
+            }
+
+            /**
+             * Wait for all tasks and create the graph. The builder is
+             * empty afterwards.
+             *
+             * @throws Any exception from a task.
+             * @throws std::length_error If there are too many vertices.
+             */
+            CSRGraph build() {
+                collect_all();
+
+                auto ids = vertex_ids();
+                m_node_count.clear();
+
+                std::vector<detail::vertex_edge> edges(m_edges.size());
+                run_in_pool(m_edges.size(), [this, &ids, &edges](std::size_t begin, std::size_t end) {
+                    lookup_vertices(ids, edges, begin, end);
+                });
+
+                std::vector<osmium::Location> locations(ids.size());
+                for (std::size_t i = 0; i < m_edges.size(); ++i) {
+                    locations[edges[i].source] = m_edges[i].source_location;
+                    locations[edges[i].target] = m_edges[i].target_location;
+                }
+                m_edges.clear();
+                m_edges.shrink_to_fit();
+
+                osmium::thread::stable_sort(edges.begin(), edges.end(), [](const detail::vertex_edge& a, const detail::vertex_edge& b) {
+                    return a.source < b.source;
+                }, m_pool);
+
+                std::vector<CSRGraph::edge_index_type> offsets(ids.size() + 1, 0);
+                for (const auto& edge : edges) {
+                    ++offsets[edge.source + 1];
+                }
+                for (std::size_t i = 1; i < offsets.size(); ++i) {
+                    offsets[i] += offsets[i - 1];
+                }
+
+                std::vector<CSRGraph::vertex_type> targets(edges.size());
+                std::vector<float> lengths(edges.size());
+                std::vector<osmium::object_id_type> way_ids(edges.size());
+                run_in_pool(edges.size(), [&](std::size_t begin, std::size_t end) {
+                    for (auto i = begin; i < end; ++i) {
+                        targets[i] = edges[i].target;
+                        lengths[i] = edges[i].length;
+                        way_ids[i] = edges[i].way_id;
+                    }
+                });
+
+                return CSRGraph{std::move(ids), std::move(locations), std::move(offsets),
+                                std::move(targets), std::move(lengths), std::move(way_ids)};
+            }
+
+        }; // class GraphBuilder
+
+    } // namespace graph
+
+} // namespace osmium
+
+#endif // OSMIUM_GRAPH_GRAPH_BUILDER_HPP
@@ -34,17 +34,26 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/handler.hpp>
+#include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/item_iterator.hpp>
+#include <osmium/osm/item_type.hpp>
 #include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
 #include <osmium/visitor.hpp>
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdlib>
+#include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -100,6 +109,170 @@ namespace osmium {
 
         }; // class DiskStore
 
+        /**
+         * Gives random access to the objects in a file written by the
+         * DiskStore handler using the same indexes. The file is memory
+         * mapped and objects are returned as references into the mapping
+         * without copying them.
+         *
+         * The indexes must be usable for lookups, sparse indexes have to
+         * be sorted first. The data file must not be changed while the
+         * reader exists.
+         *
+         * Note: Like the DiskStore, this will only work if either all
+         *       object IDs are positive or all object IDs are negative.
+         */
+        class DiskStoreReader {
+
+            using offset_index_type = osmium::index::map::Map<unsigned_object_id_type, std::size_t>;
+
+            osmium::util::MemoryMapping m_mapping;
+
+            const offset_index_type& m_node_index;
+            const offset_index_type& m_way_index;
+            const offset_index_type& m_relation_index;
+
+            static osmium::util::MemoryMapping map_file(int data_fd) {
+                osmium::util::mapping_options options;
+                options.advice = osmium::util::mapping_options::access_advice::random;
+                const auto size = osmium::file_size(data_fd);
+                // An empty file can't be mapped, use a zeroed anonymous
+                // mapping instead which never contains any objects.
+                if (size == 0) {
+                    return osmium::util::MemoryMapping{osmium::get_pagesize(), osmium::util::MemoryMapping::mapping_mode::write_private};
+                }
+                return osmium::util::MemoryMapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, data_fd, 0, options};
+            }
+
+            const offset_index_type& index(osmium::item_type type) const {
+                switch (type) {
+                    case osmium::item_type::node:
+                        return m_node_index;
+                    case osmium::item_type::way:
+                        return m_way_index;
+                    case osmium::item_type::relation:
+                        return m_relation_index;
+                    default:
+                        break;
+                }
+                throw osmium::not_found{"no index for this item type"};
+            }
+
+            // The offset index can't mark missing IDs (offset 0 is valid),
+            // so the object found at the offset is checked.
+            const osmium::OSMObject* object_at(std::size_t offset, osmium::item_type type, unsigned_object_id_type id) const noexcept {
+                if (offset + sizeof(osmium::OSMObject) > m_mapping.size()) {
+                    return nullptr;
+                }
+                const auto* object = reinterpret_cast<const osmium::OSMObject*>(m_mapping.get_addr<const unsigned char>() + offset);
+                if (object->type() != type || object->positive_id() != id ||
+                    offset + object->byte_size() > m_mapping.size()) {
+                    return nullptr;
+                }
+                return object;
+            }
+
+        public:
+
+            /**
+             * Create a reader.
+             *
+             * @param data_fd File descriptor of the data file written by
+             *                the DiskStore handler. It can be closed after
+             *                the constructor returns.
+             * @param node_index Offset index for nodes.
+             * @param way_index Offset index for ways.
+             * @param relation_index Offset index for relations.
+             * @throws std::system_error if the file can't be mapped.
+             */
+            DiskStoreReader(int data_fd, const offset_index_type& node_index, const offset_index_type& way_index, const offset_index_type& relation_index) :
+                m_mapping(map_file(data_fd)),
+                m_node_index(node_index),
+                m_way_index(way_index),
+                m_relation_index(relation_index) {
+            }
+
+            /**
+             * Get the object with the specified type and ID. Returns
+             * nullptr if there is no such object.
+             */
+            const osmium::OSMObject* get_noexcept(osmium::item_type type, osmium::object_id_type id) const noexcept {
+                const auto positive_id = static_cast<unsigned_object_id_type>(std::abs(id));
+                switch (type) {
+                    case osmium::item_type::node:
+                    case osmium::item_type::way:
+                    case osmium::item_type::relation:
+                        return object_at(index(type).get_noexcept(positive_id), type, positive_id);
+                    default:
+                        break;
+                }
+                return nullptr;
+            }
+
+            /**
+             * Get the object with the specified type and ID.
+             *
+             * @throws osmium::not_found if there is no such object.
+             */
+            const osmium::OSMObject& get(osmium::item_type type, osmium::object_id_type id) const {
+                const auto* object = get_noexcept(type, id);
+                if (!object) {
+                    throw osmium::not_found{static_cast<uint64_t>(std::abs(id))};
+                }
+                return *object;
+            }
+
+            const osmium::Node& get_node(osmium::object_id_type id) const {
+                return static_cast<const osmium::Node&>(get(osmium::item_type::node, id));
+            }
+
+            const osmium::Way& get_way(osmium::object_id_type id) const {
+                return static_cast<const osmium::Way&>(get(osmium::item_type::way, id));
+            }
+
+            const osmium::Relation& get_relation(osmium::object_id_type id) const {
+                return static_cast<const osmium::Relation&>(get(osmium::item_type::relation, id));
+            }
+
+            /**
+             * Look up many objects of the same type at once and call func
+             * with each object found. The objects are accessed in the
+             * order they are in the file, not in the order of the IDs,
+             * which keeps disk accesses local. IDs not found are ignored.
+             *
+             * @param type Type of the objects.
+             * @param ids Pointer to the first of the IDs to look for.
+             * @param count Number of IDs.
+             * @param func Function called as func(const OSMObject&).
+             */
+            template <typename TFunction>
+            void get_many(osmium::item_type type, const osmium::object_id_type* ids, std::size_t count, TFunction&& func) const {
+                std::vector<unsigned_object_id_type> positive_ids;
+                positive_ids.reserve(count);
+                for (std::size_t i = 0; i < count; ++i) {
+                    positive_ids.push_back(static_cast<unsigned_object_id_type>(std::abs(ids[i])));
+                }
+
+                std::vector<std::size_t> offsets(count);
+                index(type).get_many(positive_ids.data(), count, offsets.data());
+
+                std::vector<std::pair<std::size_t, unsigned_object_id_type>> lookups;
+                lookups.reserve(count);
+                for (std::size_t i = 0; i < count; ++i) {
+                    lookups.emplace_back(offsets[i], positive_ids[i]);
+                }
+                std::sort(lookups.begin(), lookups.end());
+
+                for (const auto& lookup : lookups) {
+                    const auto* object = object_at(lookup.first, type, lookup.second);
+                    if (object) {
+                        func(*object);
+                    }
+                }
+            }
+
+        }; // class DiskStoreReader
+
     } // namespace handler
 
 } // namespace osmium
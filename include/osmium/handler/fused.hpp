@@ -0,0 +1,449 @@
+#ifndef OSMIUM_HANDLER_FUSED_HPP
+#define OSMIUM_HANDLER_FUSED_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+namespace osmium {
+
+    namespace handler {
+
+        /**
+         * A list of predicates a handler declares for the objects it is
+         * interested in. All of them have to be true for an object to be
+         * handed to the handler. See FusedHandler.
+         */
+        template <typename... TPredicates>
+        struct predicate_list {
+        };
+
+        /**
+         * Predicates for use in a predicate_list. Apart from the ones
+         * here, any default constructible class with a const
+         * operator()(const osmium::OSMObject&) returning bool can be
+         * used.
+         */
+        namespace predicate {
+
+            /**
+             * The object is of one of the types in TBits. This predicate
+             * is special: It is resolved at compile time into a bit mask
+             * and only compared with the type of the object.
+             */
+            template <osmium::osm_entity_bits::type TBits>
+            struct entity {
+            };
+
+            /**
+             * The object has a tag with the key TKey::key().
+             *
+             * @tparam TKey Class with a static function key() returning
+             *              the key as const char*.
+             */
+            template <typename TKey>
+            struct has_key {
+                bool operator()(const osmium::OSMObject& object) const noexcept {
+                    return object.tags().has_key(TKey::key());
+                }
+            };
+
+            /**
+             * The object has a tag with the key TKey::key() and the value
+             * TValue::value().
+             *
+             * @tparam TKey Class with a static function key() returning
+             *              the key as const char*.
+             * @tparam TValue Class with a static function value()
+             *                returning the value as const char*.
+             */
+            template <typename TKey, typename TValue>
+            struct has_tag {
+                bool operator()(const osmium::OSMObject& object) const noexcept {
+                    return object.tags().has_tag(TKey::key(), TValue::value());
+                }
+            };
+
+            /**
+             * The (positive) ID of the object is in the ID set returned by
+             * TIds::ids(). Usually combined with an entity predicate,
+             * because IDs are only unique per object type.
+             *
+             * @tparam TIds Class with a static function ids() returning a
+             *              reference to an osmium::index::IdSet or any
+             *              other class with a get(id) member function.
+             */
+            template <typename TIds>
+            struct id_in {
+                bool operator()(const osmium::OSMObject& object) const noexcept {
+                    return TIds::ids().get(object.positive_id());
+                }
+            };
+
+        } // namespace predicate
+
+        namespace detail {
+
+            template <typename T>
+            struct void_type {
+                using type = void;
+            };
+
+            template <typename T, typename = void>
+            struct member_predicates {
+                using type = predicate_list<>;
+            };
+
+            template <typename T>
+            struct member_predicates<T, typename void_type<typename T::predicates>::type> {
+                using type = typename T::predicates;
+            };
+
+        } // namespace detail
+
+        /**
+         * The predicates of handler class T. This uses the member type
+         * T::predicates if there is one, otherwise the handler has no
+         * predicates and gets all objects. Specialize this for handler
+         * classes you can not change.
+         */
+        template <typename T>
+        struct handler_predicates : public detail::member_predicates<T> {
+        };
+
+        namespace detail {
+
+            template <typename T>
+            struct is_entity_predicate : std::false_type {};
+
+            template <osmium::osm_entity_bits::type TBits>
+            struct is_entity_predicate<predicate::entity<TBits>> : std::true_type {};
+
+            template <typename T>
+            struct predicate_entity_bits {
+                static constexpr osmium::osm_entity_bits::type value() noexcept {
+                    return osmium::osm_entity_bits::all;
+                }
+            };
+
+            template <osmium::osm_entity_bits::type TBits>
+            struct predicate_entity_bits<predicate::entity<TBits>> {
+                static constexpr osmium::osm_entity_bits::type value() noexcept {
+                    return TBits;
+                }
+            };
+
+            // Entity types allowed by all entity predicates in the list.
+            template <typename TList>
+            struct entity_mask;
+
+            template <>
+            struct entity_mask<predicate_list<>> {
+                static constexpr osmium::osm_entity_bits::type value() noexcept {
+                    return osmium::osm_entity_bits::all;
+                }
+            };
+
+            template <typename TPredicate, typename... TRest>
+            struct entity_mask<predicate_list<TPredicate, TRest...>> {
+                static constexpr osmium::osm_entity_bits::type value() noexcept {
+                    return predicate_entity_bits<TPredicate>::value() & entity_mask<predicate_list<TRest...>>::value();
+                }
+            };
+
+            template <typename T, typename TList>
+            struct list_contains;
+
+            template <typename T>
+            struct list_contains<T, predicate_list<>> : std::false_type {};
+
+            template <typename T, typename U, typename... TRest>
+            struct list_contains<T, predicate_list<U, TRest...>> :
+                std::integral_constant<bool, std::is_same<T, U>::value || list_contains<T, predicate_list<TRest...>>::value> {};
+
+            // Add predicates to the list, leaving out entity predicates
+            // and predicates already in the list.
+            template <typename TList, typename... TPredicates>
+            struct add_predicates {
+                using type = TList;
+            };
+
+            template <typename... TList, typename TPredicate, typename... TRest>
+            struct add_predicates<predicate_list<TList...>, TPredicate, TRest...> {
+                using type = typename add_predicates<
+                    typename std::conditional<is_entity_predicate<TPredicate>::value ||
+                                              list_contains<TPredicate, predicate_list<TList...>>::value,
+                                              predicate_list<TList...>,
+                                              predicate_list<TList..., TPredicate>>::type,
+                    TRest...>::type;
+            };
+
+            // All distinct (non-entity) predicates from the lists.
+            template <typename TList, typename... TLists>
+            struct collect_predicates {
+                using type = TList;
+            };
+
+            template <typename TList, typename... TPredicates, typename... TRest>
+            struct collect_predicates<TList, predicate_list<TPredicates...>, TRest...> {
+                using type = typename collect_predicates<typename add_predicates<TList, TPredicates...>::type, TRest...>::type;
+            };
+
+            template <typename T, typename TList>
+            struct predicate_index;
+
+            template <typename T, typename... TRest>
+            struct predicate_index<T, predicate_list<T, TRest...>> : std::integral_constant<std::size_t, 0> {};
+
+            template <typename T, typename U, typename... TRest>
+            struct predicate_index<T, predicate_list<U, TRest...>> :
+                std::integral_constant<std::size_t, 1 + predicate_index<T, predicate_list<TRest...>>::value> {};
+
+            template <typename TList>
+            struct predicate_tuple;
+
+            template <typename... TPredicates>
+            struct predicate_tuple<predicate_list<TPredicates...>> {
+                using type = std::tuple<TPredicates...>;
+                static constexpr const std::size_t size = sizeof...(TPredicates);
+            };
+
+        } // namespace detail
+
+        /**
+         * This handler fuses any number of handlers into a single handler
+         * like the ChainHandler does. But each handler can declare
+         * predicates the objects it is interested in have to fulfill,
+         * for instance:
+         *
+         * @code
+         * struct highway_key {
+         *     static const char* key() noexcept { return "highway"; }
+         * };
+         *
+         * struct RoadHandler : public osmium::handler::Handler {
+         *     using predicates = osmium::handler::predicate_list<
+         *         osmium::handler::predicate::entity<osmium::osm_entity_bits::way>,
+         *         osmium::handler::predicate::has_key<highway_key>>;
+         *
+         *     void way(const osmium::Way& way) { ... }
+         * };
+         * @endcode
+         *
+         * A handler is only called for objects for which all of its
+         * predicates are true. Predicates used by several handlers are
+         * evaluated only once per object and only if they are needed.
+         * Everything is resolved at compile time, there are no virtual
+         * function calls involved.
+         *
+         * Entity predicates are checked for changesets, too, but a
+         * handler with any other predicates never gets changesets.
+         *
+         * Objects are always handed to the handlers as const references.
+         */
+        template <typename... THandler>
+        class FusedHandler : public osmium::handler::Handler {
+
+            using handlers_type = std::tuple<THandler&...>;
+            using predicates_type = typename detail::collect_predicates<predicate_list<>, typename handler_predicates<THandler>::type...>::type;
+
+            handlers_type m_handlers;
+
+            typename detail::predicate_tuple<predicates_type>::type m_predicates;
+
+            // Results of the predicates for the current object:
+            // 0 = not evaluated yet, 1 = false, 2 = true.
+            std::array<unsigned char, detail::predicate_tuple<predicates_type>::size> m_results;
+
+            template <typename TPredicate>
+            bool check_predicate(const osmium::OSMObject& /*object*/, std::true_type /*is_entity_predicate*/) noexcept {
+                return true;
+            }
+
+            template <typename TPredicate>
+            bool check_predicate(const osmium::OSMObject& object, std::false_type /*is_entity_predicate*/) {
+                constexpr const std::size_t index = detail::predicate_index<TPredicate, predicates_type>::value;
+                auto& result = std::get<index>(m_results);
+                if (result == 0) {
+                    result = std::get<index>(m_predicates)(object) ? 2 : 1;
+                }
+                return result == 2;
+            }
+
+            bool check(const osmium::OSMObject& /*object*/, predicate_list<> /*predicates*/) noexcept {
+                return true;
+            }
+
+            template <typename TPredicate, typename... TRest>
+            bool check(const osmium::OSMObject& object, predicate_list<TPredicate, TRest...> /*predicates*/) {
+                return check_predicate<TPredicate>(object, detail::is_entity_predicate<TPredicate>{}) &&
+                       check(object, predicate_list<TRest...>{});
+            }
+
+            bool check(const osmium::Changeset& /*changeset*/, predicate_list<> /*predicates*/) noexcept {
+                return true;
+            }
+
+            template <typename TPredicate, typename... TRest>
+            bool check(const osmium::Changeset& changeset, predicate_list<TPredicate, TRest...> /*predicates*/) noexcept {
+                return detail::is_entity_predicate<TPredicate>::value &&
+                       check(changeset, predicate_list<TRest...>{});
+            }
+
+            template <typename TH>
+            static void call(TH& handler, const osmium::Node& node) {
+                handler.osm_object(node);
+                handler.node(node);
+            }
+
+            template <typename TH>
+            static void call(TH& handler, const osmium::Way& way) {
+                handler.osm_object(way);
+                handler.way(way);
+            }
+
+            template <typename TH>
+            static void call(TH& handler, const osmium::Relation& relation) {
+                handler.osm_object(relation);
+                handler.relation(relation);
+            }
+
+            template <typename TH>
+            static void call(TH& handler, const osmium::Area& area) {
+                handler.osm_object(area);
+                handler.area(area);
+            }
+
+            template <typename TH>
+            static void call(TH& handler, const osmium::Changeset& changeset) {
+                handler.changeset(changeset);
+            }
+
+            template <std::size_t N, typename TObject>
+            typename std::enable_if<(N < sizeof...(THandler))>::type
+            dispatch(const TObject& object, const osmium::osm_entity_bits::type bit) {
+                using handler_predicates_type = typename handler_predicates<typename std::tuple_element<N, std::tuple<THandler...>>::type>::type;
+                if ((detail::entity_mask<handler_predicates_type>::value() & bit) &&
+                    check(object, handler_predicates_type{})) {
+                    call(std::get<N>(m_handlers), object);
+                }
+                dispatch<N + 1>(object, bit);
+            }
+
+            template <std::size_t N, typename TObject>
+            typename std::enable_if<(N == sizeof...(THandler))>::type
+            dispatch(const TObject& /*object*/, const osmium::osm_entity_bits::type /*bit*/) noexcept {
+            }
+
+            template <std::size_t N>
+            typename std::enable_if<(N < sizeof...(THandler))>::type
+            call_flush() {
+                std::get<N>(m_handlers).flush();
+                call_flush<N + 1>();
+            }
+
+            template <std::size_t N>
+            typename std::enable_if<(N == sizeof...(THandler))>::type
+            call_flush() noexcept {
+            }
+
+            template <typename TObject>
+            void handle(const TObject& object, const osmium::osm_entity_bits::type bit) {
+                m_results.fill(0);
+                dispatch<0>(object, bit);
+            }
+
+        public:
+
+            explicit FusedHandler(THandler&... handlers) :
+                m_handlers(handlers...) {
+            }
+
+            /// The number of distinct predicates (not counting entity predicates).
+            static constexpr std::size_t num_predicates() noexcept {
+                return detail::predicate_tuple<predicates_type>::size;
+            }
+
+            void node(const osmium::Node& node) {
+                handle(node, osmium::osm_entity_bits::node);
+            }
+
+            void way(const osmium::Way& way) {
+                handle(way, osmium::osm_entity_bits::way);
+            }
+
+            void relation(const osmium::Relation& relation) {
+                handle(relation, osmium::osm_entity_bits::relation);
+            }
+
+            void area(const osmium::Area& area) {
+                handle(area, osmium::osm_entity_bits::area);
+            }
+
+            void changeset(const osmium::Changeset& changeset) {
+                dispatch<0>(changeset, osmium::osm_entity_bits::changeset);
+            }
+
+            void flush() {
+                call_flush<0>();
+            }
+
+        }; // class FusedHandler
+
+        /**
+         * Create a FusedHandler from the handlers. The handlers are held
+         * by reference, they must outlive the FusedHandler.
+         */
+        template <typename... THandler>
+        FusedHandler<THandler...> make_fused_handler(THandler&... handlers) {
+            return FusedHandler<THandler...>{handlers...};
+        }
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_FUSED_HPP
@@ -0,0 +1,349 @@
+#ifndef OSMIUM_HANDLER_MERGE_JOIN_LOCATIONS_FOR_WAYS_HPP
+#define OSMIUM_HANDLER_MERGE_JOIN_LOCATIONS_FOR_WAYS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/handler/check_order.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/io/detail/external_record_sorter.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace handler {
+
+        /**
+         * Handler to add node locations to ways without a node location
+         * index. Instead of looking up each node reference in an index
+         * (which needs random access to an index large enough for all
+         * nodes), the node references are sorted by node ID and
+         * merge-joined with the nodes. This needs three passes over the
+         * input:
+         *
+         * 1. All node references of all ways are collected together with
+         *    their position in the input ("slot") and sorted by node ID.
+         * 2. The nodes are read in order of their IDs and joined with the
+         *    sorted references. The resulting (slot, location) pairs are
+         *    sorted by slot.
+         * 3. The ways are read again in the same order as in the first
+         *    pass and the locations are set in order.
+         *
+         * Each sort keeps records of 16 bytes per node reference in memory
+         * until the memory budget is used up, after that they are written
+         * to temporary files in sorted runs which are merged later. So all
+         * accesses to disk are sequential. This can be much faster than a
+         * node location index if the index doesn't fit into memory.
+         *
+         * The nodes must be ordered by ID like in a sorted OSM file (see
+         * osmium::id_order) and each node must appear only once, so this
+         * doesn't work with history files. The ways must be the same and in
+         * the same order in the first and third pass, their order doesn't
+         * matter otherwise.
+         *
+         * Call next_pass() after each pass. The node() and way() functions
+         * do whatever is needed in the current pass and nothing if there
+         * is nothing to do. See merge_join_locations() for a function
+         * doing all three passes over a file.
+         *
+         * Usage:
+         * @code
+         * osmium::handler::MergeJoinLocationsForWays join;
+         *
+         * osmium::io::Reader reader1{file, osmium::osm_entity_bits::way};
+         * osmium::apply(reader1, join);
+         * reader1.close();
+         * join.next_pass();
+         *
+         * osmium::io::Reader reader2{file, osmium::osm_entity_bits::node};
+         * osmium::apply(reader2, join);
+         * reader2.close();
+         * join.next_pass();
+         *
+         * osmium::io::Reader reader3{file};
+         * osmium::apply(reader3, join, handler);
+         * reader3.close();
+         * join.next_pass();
+         * @endcode
+         *
+         * Not available on Windows if the data doesn't fit into the memory
+         * budget.
+         */
+        class MergeJoinLocationsForWays : public osmium::handler::Handler {
+
+            struct ref_record {
+                osmium::object_id_type ref;
+                uint64_t slot;
+            };
+
+            struct ref_order {
+                bool operator()(const ref_record& lhs, const ref_record& rhs) const noexcept {
+                    if (lhs.ref == rhs.ref) {
+                        return lhs.slot < rhs.slot;
+                    }
+                    return osmium::id_order{}(lhs.ref, rhs.ref);
+                }
+            };
+
+            struct location_record {
+                uint64_t slot;
+                osmium::Location location;
+            };
+
+            struct slot_order {
+                bool operator()(const location_record& lhs, const location_record& rhs) const noexcept {
+                    return lhs.slot < rhs.slot;
+                }
+            };
+
+        public:
+
+            enum class pass {
+                collect_refs  = 0,
+                join_nodes    = 1,
+                set_locations = 2,
+                done          = 3
+            };
+
+        private:
+
+            osmium::io::detail::external_record_sorter<ref_record, ref_order> m_refs;
+            osmium::io::detail::external_record_sorter<location_record, slot_order> m_locations;
+
+            pass m_pass = pass::collect_refs;
+            uint64_t m_slot = 0;
+            uint64_t m_num_node_refs = 0;
+            osmium::object_id_type m_last_node_id = 0;
+            bool m_have_node = false;
+            bool m_ignore_errors = false;
+
+        public:
+
+            /**
+             * @param memory_budget Approximate number of bytes used for
+             *        each of the two sorts.
+             * @param directory Directory for temporary files. If this is
+             *        empty, the directory from the TMPDIR environment
+             *        variable or /tmp is used. Temporary files are unlinked
+             *        right after they are created.
+             */
+            explicit MergeJoinLocationsForWays(std::size_t memory_budget = 256UL * 1024UL * 1024UL, const std::string& directory = "") :
+                m_refs(memory_budget, directory),
+                m_locations(memory_budget, directory) {
+            }
+
+            void ignore_errors() noexcept {
+                m_ignore_errors = true;
+            }
+
+            /// The pass we are currently in.
+            pass current_pass() const noexcept {
+                return m_pass;
+            }
+
+            /// The number of node references in all ways seen in the first pass.
+            uint64_t num_node_refs() const noexcept {
+                return m_pass == pass::collect_refs ? m_slot : m_num_node_refs;
+            }
+
+            /// The number of sorted runs currently kept in temporary files.
+            std::size_t num_runs() const noexcept {
+                return m_refs.num_runs() + m_locations.num_runs();
+            }
+
+            /**
+             * Finish the current pass and get ready for the next one.
+             *
+             * @throws std::runtime_error If called after the last pass or
+             *         if there were fewer node references in the third pass
+             *         than in the first one.
+             */
+            void next_pass() {
+                switch (m_pass) {
+                    case pass::collect_refs:
+                        m_refs.start_reading();
+                        m_num_node_refs = m_slot;
+                        m_pass = pass::join_nodes;
+                        break;
+                    case pass::join_nodes:
+                        m_refs.clear();
+                        m_locations.start_reading();
+                        m_pass = pass::set_locations;
+                        m_slot = 0;
+                        break;
+                    case pass::set_locations:
+                        if (m_slot != m_num_node_refs) {
+                            throw std::runtime_error{"ways in third pass of merge join differ from first pass"};
+                        }
+                        m_locations.clear();
+                        m_pass = pass::done;
+                        break;
+                    case pass::done:
+                        throw std::runtime_error{"merge join already done"};
+                }
+            }
+
+            /**
+             * Join the node with the node references in the second pass.
+             *
+             * @throws osmium::out_of_order_error If the nodes are not
+             *         ordered by ID.
+             */
+            void node(const osmium::Node& node) {
+                if (m_pass != pass::join_nodes) {
+                    return;
+                }
+
+                const auto id = node.id();
+                if (m_have_node && !osmium::id_order{}(m_last_node_id, id)) {
+                    throw osmium::out_of_order_error{"nodes not ordered by ID in merge join", id};
+                }
+                m_last_node_id = id;
+                m_have_node = true;
+
+                // Skip references to nodes that are not in the input.
+                while (m_refs.current() && osmium::id_order{}(m_refs.current()->ref, id)) {
+                    m_refs.next();
+                }
+
+                while (m_refs.current() && m_refs.current()->ref == id) {
+                    m_locations.push_back(location_record{m_refs.current()->slot, node.location()});
+                    m_refs.next();
+                }
+            }
+
+            /**
+             * Collect the node references of the way in the first pass,
+             * set the locations of the nodes of the way in the third
+             * pass.
+             *
+             * @throws osmium::not_found If the location of a node wasn't
+             *         found (unless ignore_errors() was called).
+             * @throws std::runtime_error If there are more node references
+             *         in the third pass than in the first.
+             */
+            void way(osmium::Way& way) {
+                if (m_pass == pass::collect_refs) {
+                    for (const auto& node_ref : way.nodes()) {
+                        m_refs.push_back(ref_record{node_ref.ref(), m_slot++});
+                    }
+                    return;
+                }
+
+                if (m_pass != pass::set_locations) {
+                    return;
+                }
+
+                if (m_slot + way.nodes().size() > m_num_node_refs) {
+                    throw std::runtime_error{"ways in third pass of merge join differ from first pass"};
+                }
+
+                bool error = false;
+                for (auto& node_ref : way.nodes()) {
+                    const auto* record = m_locations.current();
+                    if (record && record->slot == m_slot) {
+                        node_ref.set_location(record->location);
+                        m_locations.next();
+                    } else {
+                        node_ref.set_location(osmium::Location{});
+                    }
+                    if (!node_ref.location()) {
+                        error = true;
+                    }
+                    ++m_slot;
+                }
+
+                auto* bbox = way.bounding_box();
+                if (bbox) {
+                    bbox->set_box(way.nodes().envelope());
+                }
+
+                if (!m_ignore_errors && error) {
+                    throw osmium::not_found{"location for one or more nodes not found in merge join"};
+                }
+            }
+
+        }; // class MergeJoinLocationsForWays
+
+        /**
+         * Read the file three times to add node locations to all ways
+         * using the MergeJoinLocationsForWays handler. In the last pass
+         * all objects are read and sent to the handlers, the ways with
+         * the node locations set.
+         *
+         * @param file The input file. Nodes must be sorted by ID.
+         * @param join The handler doing the merge join. Must be in the
+         *             first pass.
+         * @param handlers Any number of handlers.
+         */
+        template <typename... THandlers>
+        void merge_join_locations(const osmium::io::File& file, MergeJoinLocationsForWays& join, THandlers&&... handlers) {
+            {
+                osmium::io::Reader reader{file, osmium::osm_entity_bits::way};
+                osmium::apply(reader, join);
+                reader.close();
+            }
+            join.next_pass();
+
+            {
+                osmium::io::Reader reader{file, osmium::osm_entity_bits::node};
+                osmium::apply(reader, join);
+                reader.close();
+            }
+            join.next_pass();
+
+            osmium::io::Reader reader{file};
+            osmium::apply(reader, join, std::forward<THandlers>(handlers)...);
+            reader.close();
+            join.next_pass();
+        }
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_MERGE_JOIN_LOCATIONS_FOR_WAYS_HPP
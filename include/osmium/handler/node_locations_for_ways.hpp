@@ -37,6 +37,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/index/index.hpp>
 #include <osmium/index/map/dummy.hpp>
 #include <osmium/index/node_locations_map.hpp>
+#include <osmium/io/header.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/node_ref.hpp>
@@ -45,6 +46,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <limits>
 #include <type_traits>
+#include <vector>
 
 namespace osmium {
 
@@ -52,6 +54,57 @@ namespace osmium {
 
         using dummy_type = osmium::index::map::Dummy<osmium::unsigned_object_id_type, osmium::Location>;
 
+        namespace detail {
+
+            /**
+             * Look up the locations of all nodes of the way in the indexes
+             * and set them in the way. The locations for positive IDs are
+             * looked up in one batch, so that the index can prefetch or
+             * reorder the accesses. The ids and locations vectors are used
+             * as scratch space. If the way has a bounding box subitem, it
+             * is updated.
+             *
+             * @returns true if the location of at least one node was not
+             *          found, false otherwise.
+             */
+            template <typename TStoragePosIDs, typename TStorageNegIDs>
+            bool set_way_locations(osmium::Way& way,
+                                   const TStoragePosIDs& storage_pos,
+                                   const TStorageNegIDs& storage_neg,
+                                   std::vector<osmium::unsigned_object_id_type>& ids,
+                                   std::vector<osmium::Location>& locations) {
+                ids.clear();
+                for (const auto& node_ref : way.nodes()) {
+                    if (node_ref.ref() >= 0) {
+                        ids.push_back(static_cast<osmium::unsigned_object_id_type>(node_ref.ref()));
+                    }
+                }
+                locations.resize(ids.size());
+                storage_pos.get_many(ids.data(), ids.size(), locations.data());
+
+                bool error = false;
+                auto location = locations.cbegin();
+                for (auto& node_ref : way.nodes()) {
+                    if (node_ref.ref() >= 0) {
+                        node_ref.set_location(*location++);
+                    } else {
+                        node_ref.set_location(storage_neg.get_noexcept(static_cast<osmium::unsigned_object_id_type>(-node_ref.ref())));
+                    }
+                    if (!node_ref.location()) {
+                        error = true;
+                    }
+                }
+
+                auto* bbox = way.bounding_box();
+                if (bbox) {
+                    bbox->set_box(way.nodes().envelope());
+                }
+
+                return error;
+            }
+
+        } // namespace detail
+
         /**
          * Handler to retrieve locations from nodes and add them to ways.
          *
@@ -88,6 +141,14 @@ namespace osmium {
 
             bool m_must_sort = false;
 
+            // Set if the input is known to be sorted. Node IDs are not
+            // tracked then and the indexes are never sorted.
+            bool m_input_is_sorted = false;
+
+            // Scratch space for the batched lookups in way().
+            std::vector<osmium::unsigned_object_id_type> m_ids{};
+            std::vector<osmium::Location> m_locations{};
+
             // It is okay to have this static dummy instance, even when using several threads,
             // because it is read-only.
             static dummy_type& get_dummy() {
@@ -115,6 +176,28 @@ namespace osmium {
                 m_ignore_errors = true;
             }
 
+            /**
+             * Tell the handler that the input is known to be sorted by
+             * type and ID. Node IDs are not tracked then to find out
+             * whether the indexes have to be sorted before the ways are
+             * handled. Use this only if you are sure the input is sorted,
+             * indexes which need sorting will return wrong results
+             * otherwise.
+             */
+            void assume_sorted_input(bool sorted = true) noexcept {
+                m_input_is_sorted = sorted;
+            }
+
+            /**
+             * Assume sorted input (see above) if the header says that the
+             * input is sorted and this is verified by the Reader (see
+             * osmium::io::Header::sorted_and_verified() and the
+             * osmium::io::verify_sorting option of the Reader).
+             */
+            void assume_sorted_input(const osmium::io::Header& header) noexcept {
+                m_input_is_sorted = header.sorted_and_verified();
+            }
+
             TStoragePosIDs& storage_pos() noexcept {
                 return m_storage_pos;
             }
@@ -127,10 +210,12 @@ namespace osmium {
              * Store the location of the node in the storage.
              */
             void node(const osmium::Node& node) {
-                if (node.positive_id() < m_last_id) {
-                    m_must_sort = true;
+                if (!m_input_is_sorted) {
+                    if (node.positive_id() < m_last_id) {
+                        m_must_sort = true;
+                    }
+                    m_last_id = node.positive_id();
                 }
-                m_last_id = node.positive_id();
 
                 const auto id = node.id();
                 if (id >= 0) {
@@ -161,13 +246,8 @@ namespace osmium {
                     m_must_sort = false;
                     m_last_id = std::numeric_limits<osmium::unsigned_object_id_type>::max();
                 }
-                bool error = false;
-                for (auto& node_ref : way.nodes()) {
-                    node_ref.set_location(get_node_location(node_ref.ref()));
-                    if (!node_ref.location()) {
-                        error = true;
-                    }
-                }
+
+                const bool error = detail::set_way_locations(way, m_storage_pos, m_storage_neg, m_ids, m_locations);
                 if (!m_ignore_errors && error) {
                     throw osmium::not_found{"location for one or more nodes not found in node location index"};
                 }
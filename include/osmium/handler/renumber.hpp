@@ -0,0 +1,139 @@
+#ifndef OSMIUM_HANDLER_RENUMBER_HPP
+#define OSMIUM_HANDLER_RENUMBER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/index/id_renumber_map.hpp>
+#include <osmium/index/map/sparse_mem_map.hpp>
+#include <osmium/index/nwr_array.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <vector>
+
+namespace osmium {
+
+    namespace handler {
+
+        /**
+         * Handler renumbering the IDs of all nodes, ways, and relations in
+         * place. New IDs are assigned per type in the order in which the
+         * objects or references to them are first seen, starting from 1
+         * (or whatever is set with set_start_id()). Node references in
+         * ways and members of relations are rewritten accordingly. Members
+         * referencing objects which are not in the input (or which come
+         * later) get a new ID right away, so the result stays consistent.
+         *
+         * Works in a single pass over the data. For sorted input the
+         * memory needed is 8 bytes per object, see
+         * osmium::index::IdRenumberMap for the details and for how to use
+         * a different fallback map for unsorted input or a vector on disk.
+         *
+         * The mappings can be accessed through map() for reverse lookups
+         * or to write them out.
+         *
+         * Usage:
+         * @code
+         * osmium::handler::Renumber<> renumber;
+         * osmium::io::Reader reader{input_file};
+         * osmium::io::Writer writer{output_file};
+         * while (osmium::memory::Buffer buffer = reader.read()) {
+         *     osmium::apply(buffer, renumber);
+         *     writer(std::move(buffer));
+         * }
+         * @endcode
+         */
+        template <typename TFallbackMap = osmium::index::map::SparseMemMap<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>,
+                  template <typename...> class TVector = std::vector>
+        class Renumber : public osmium::handler::Handler {
+
+        public:
+
+            using map_type = osmium::index::IdRenumberMap<TFallbackMap, TVector>;
+
+        private:
+
+            osmium::nwr_array<map_type> m_maps;
+
+        public:
+
+            Renumber() = default;
+
+            /**
+             * Set the first new ID for objects of the given type. Must be
+             * called before any object of this type (or reference to one)
+             * has been renumbered.
+             */
+            void set_start_id(const osmium::item_type type, const osmium::object_id_type start_id) {
+                m_maps(type).set_start_id(start_id);
+            }
+
+            /// The mapping from old to new IDs for the given type.
+            map_type& map(const osmium::item_type type) noexcept {
+                return m_maps(type);
+            }
+
+            /// The mapping from old to new IDs for the given type.
+            const map_type& map(const osmium::item_type type) const noexcept {
+                return m_maps(type);
+            }
+
+            void node(osmium::Node& node) {
+                node.set_id(m_maps.nodes()(node.id()));
+            }
+
+            void way(osmium::Way& way) {
+                way.set_id(m_maps.ways()(way.id()));
+                for (auto& node_ref : way.nodes()) {
+                    node_ref.set_ref(m_maps.nodes()(node_ref.ref()));
+                }
+            }
+
+            void relation(osmium::Relation& relation) {
+                relation.set_id(m_maps.relations()(relation.id()));
+                for (auto& member : relation.members()) {
+                    member.set_ref(m_maps(member.type())(member.ref()));
+                }
+            }
+
+        }; // class Renumber
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_RENUMBER_HPP
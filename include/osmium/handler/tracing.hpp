@@ -0,0 +1,335 @@
+#ifndef OSMIUM_HANDLER_TRACING_HPP
+#define OSMIUM_HANDLER_TRACING_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace osmium {
+
+    namespace handler {
+
+        /**
+         * Histogram of latencies with buckets for powers of two
+         * nanoseconds: bucket 0 counts times below 2ns, bucket n times
+         * in [2^n, 2^(n+1)) ns. The last bucket also counts everything
+         * larger.
+         */
+        class latency_histogram {
+
+        public:
+
+            enum {
+                num_buckets = 40
+            };
+
+        private:
+
+            std::array<uint64_t, num_buckets> m_counts{};
+
+        public:
+
+            static std::size_t bucket_for(std::chrono::nanoseconds time) noexcept {
+                auto ns = static_cast<uint64_t>(time.count() > 0 ? time.count() : 0);
+                std::size_t bucket = 0;
+                while (ns > 1 && bucket < num_buckets - 1) {
+                    ns >>= 1U;
+                    ++bucket;
+                }
+                return bucket;
+            }
+
+            /// The smallest time counted in the given bucket.
+            static std::chrono::nanoseconds bucket_start(std::size_t bucket) noexcept {
+                return std::chrono::nanoseconds{bucket == 0 ? 0 : (int64_t{1} << bucket)};
+            }
+
+            void add(std::chrono::nanoseconds time) noexcept {
+                ++m_counts[bucket_for(time)];
+            }
+
+            uint64_t count(std::size_t bucket) const noexcept {
+                return m_counts[bucket];
+            }
+
+            /// Total number of values in the histogram.
+            uint64_t count() const noexcept {
+                uint64_t sum = 0;
+                for (const auto c : m_counts) {
+                    sum += c;
+                }
+                return sum;
+            }
+
+            /**
+             * Get an upper bound for the given percentile (0 to 100), ie.
+             * the end of the bucket containing it. Returns 0 if the
+             * histogram is empty.
+             */
+            std::chrono::nanoseconds percentile(double p) const noexcept {
+                const auto total = count();
+                if (total == 0) {
+                    return std::chrono::nanoseconds{0};
+                }
+                const auto rank = static_cast<uint64_t>(static_cast<double>(total) * p / 100.0);
+                uint64_t sum = 0;
+                for (std::size_t i = 0; i < num_buckets; ++i) {
+                    sum += m_counts[i];
+                    if (sum > rank || sum == total) {
+                        return bucket_start(i + 1);
+                    }
+                }
+                return bucket_start(num_buckets);
+            }
+
+            void clear() noexcept {
+                m_counts.fill(0);
+            }
+
+        }; // class latency_histogram
+
+        /// Time spent on objects of one type, see ObjectTrace.
+        struct type_trace_stats {
+            uint64_t count = 0;
+            std::chrono::nanoseconds total_time{0};
+            std::chrono::nanoseconds max_time{0};
+            latency_histogram histogram;
+        }; // struct type_trace_stats
+
+        /// An object and the time spent on it, see ObjectTrace.
+        struct traced_object {
+
+            std::chrono::nanoseconds time;
+            osmium::item_type type;
+            osmium::object_id_type id;
+
+            traced_object(std::chrono::nanoseconds t, osmium::item_type ty, osmium::object_id_type i) noexcept :
+                time(t),
+                type(ty),
+                id(i) {
+            }
+
+            bool operator>(const traced_object& other) const noexcept {
+                return time > other.time;
+            }
+
+        }; // struct traced_object
+
+        /**
+         * Collects the time spent on each object: the count, total and
+         * maximum time and a histogram for each object type, and the
+         * slowest objects overall. The slowest objects are kept in a heap
+         * of fixed size, so memory use doesn't depend on the number of
+         * objects.
+         *
+         * Usually used through TracingHandler.
+         */
+        class ObjectTrace {
+
+            // Indexed by item_type - 1 (node, way, relation, area, changeset).
+            std::array<type_trace_stats, 5> m_stats{};
+
+            // Min-heap of the slowest objects.
+            std::vector<traced_object> m_slowest;
+            std::size_t m_max_slowest;
+
+            static std::size_t index(osmium::item_type type) noexcept {
+                const auto n = static_cast<std::size_t>(type);
+                return n >= 1 && n <= 5 ? n - 1 : 0;
+            }
+
+        public:
+
+            /**
+             * @param max_slowest Number of slowest objects to keep.
+             */
+            explicit ObjectTrace(std::size_t max_slowest = 100) :
+                m_max_slowest(max_slowest) {
+                m_slowest.reserve(max_slowest);
+            }
+
+            void add(osmium::item_type type, osmium::object_id_type id, std::chrono::nanoseconds time) {
+                auto& stats = m_stats[index(type)];
+                ++stats.count;
+                stats.total_time += time;
+                if (time > stats.max_time) {
+                    stats.max_time = time;
+                }
+                stats.histogram.add(time);
+
+                if (m_max_slowest == 0) {
+                    return;
+                }
+                if (m_slowest.size() < m_max_slowest) {
+                    m_slowest.emplace_back(time, type, id);
+                    std::push_heap(m_slowest.begin(), m_slowest.end(), std::greater<traced_object>{});
+                } else if (time > m_slowest.front().time) {
+                    std::pop_heap(m_slowest.begin(), m_slowest.end(), std::greater<traced_object>{});
+                    m_slowest.back() = traced_object{time, type, id};
+                    std::push_heap(m_slowest.begin(), m_slowest.end(), std::greater<traced_object>{});
+                }
+            }
+
+            /**
+             * Get statistics for the objects of the given type (node,
+             * way, relation, area, or changeset).
+             */
+            const type_trace_stats& stats(osmium::item_type type) const noexcept {
+                return m_stats[index(type)];
+            }
+
+            /// Get the slowest objects, slowest first.
+            std::vector<traced_object> slowest() const {
+                std::vector<traced_object> result{m_slowest};
+                std::sort(result.begin(), result.end(), std::greater<traced_object>{});
+                return result;
+            }
+
+            void clear() {
+                m_stats.fill(type_trace_stats{});
+                m_slowest.clear();
+            }
+
+        }; // class ObjectTrace
+
+        /**
+         * Handler wrapping another handler (for instance a ChainHandler)
+         * which measures the time the wrapped handler takes for each
+         * object and records it in an ObjectTrace. Use this to find the
+         * (usually few) objects that take most of the time.
+         *
+         * The osm_object() and the type specific callbacks of the wrapped
+         * handler are called and timed together. The overhead is two
+         * clock reads and a few counter updates per object.
+         *
+         * @code
+         * MyHandler handler;
+         * osmium::handler::TracingHandler<MyHandler> tracer{handler, 20};
+         * osmium::apply(reader, tracer);
+         * for (const auto& obj : tracer.trace().slowest()) { ... }
+         * @endcode
+         */
+        template <typename THandler>
+        class TracingHandler : public osmium::handler::Handler {
+
+            THandler& m_handler;
+            ObjectTrace m_trace;
+
+            using clock = std::chrono::steady_clock;
+
+            template <typename TObject>
+            void record(const TObject& object, clock::time_point start) {
+                m_trace.add(object.type(), object.id(),
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start));
+            }
+
+        public:
+
+            /**
+             * @param handler The handler to wrap.
+             * @param max_slowest Number of slowest objects to keep.
+             */
+            explicit TracingHandler(THandler& handler, std::size_t max_slowest = 100) :
+                m_handler(handler),
+                m_trace(max_slowest) {
+            }
+
+            template <typename TNode>
+            void node(TNode& node) {
+                const auto start = clock::now();
+                m_handler.osm_object(node);
+                m_handler.node(node);
+                record(node, start);
+            }
+
+            template <typename TWay>
+            void way(TWay& way) {
+                const auto start = clock::now();
+                m_handler.osm_object(way);
+                m_handler.way(way);
+                record(way, start);
+            }
+
+            template <typename TRelation>
+            void relation(TRelation& relation) {
+                const auto start = clock::now();
+                m_handler.osm_object(relation);
+                m_handler.relation(relation);
+                record(relation, start);
+            }
+
+            template <typename TArea>
+            void area(TArea& area) {
+                const auto start = clock::now();
+                m_handler.osm_object(area);
+                m_handler.area(area);
+                record(area, start);
+            }
+
+            template <typename TChangeset>
+            void changeset(TChangeset& changeset) {
+                const auto start = clock::now();
+                m_handler.changeset(changeset);
+                record(changeset, start);
+            }
+
+            void flush() {
+                m_handler.flush();
+            }
+
+            const ObjectTrace& trace() const noexcept {
+                return m_trace;
+            }
+
+            ObjectTrace& trace() noexcept {
+                return m_trace;
+            }
+
+        }; // class TracingHandler
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_TRACING_HPP
@@ -0,0 +1,151 @@
+#ifndef OSMIUM_INDEX_ADD_LOCATIONS_TO_WAYS_HPP
+#define OSMIUM_INDEX_ADD_LOCATIONS_TO_WAYS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            enum : std::size_t {
+                ways_per_location_task = 1000
+            };
+
+            template <typename TStoragePosIDs, typename TStorageNegIDs>
+            std::size_t add_locations_to_way_range(osmium::Way* const* begin,
+                                                   osmium::Way* const* end,
+                                                   const TStoragePosIDs& storage_pos,
+                                                   const TStorageNegIDs& storage_neg) {
+                std::vector<osmium::unsigned_object_id_type> ids;
+                std::vector<osmium::Location> locations;
+                std::size_t errors = 0;
+                for (auto it = begin; it != end; ++it) {
+                    if (osmium::handler::detail::set_way_locations(**it, storage_pos, storage_neg, ids, locations)) {
+                        ++errors;
+                    }
+                }
+                return errors;
+            }
+
+        } // namespace detail
+
+        /**
+         * Add node locations to all ways in a buffer using the thread pool.
+         * This does the same as the NodeLocationsForWays handler, but the
+         * ways are split into ranges that are worked on in parallel. It can
+         * be used as a pipeline stage directly after the Reader once all
+         * node locations are in the index.
+         *
+         * The indexes are only read, they must be completely filled (and
+         * sorted if that is needed for the index type) and must not be
+         * changed while this function runs. Do not call this from a task
+         * running in the same pool, because it waits for the tasks it
+         * submits.
+         *
+         * @param buffer The buffer with the ways. Other objects in the
+         *               buffer are ignored.
+         * @param storage_pos Index with the locations of nodes with positive
+         *                    IDs.
+         * @param storage_neg Index with the locations of nodes with negative
+         *                    IDs.
+         * @param pool Thread pool to use.
+         * @returns The number of ways where the location for one or more
+         *          nodes was not found.
+         */
+        template <typename TStoragePosIDs, typename TStorageNegIDs>
+        std::size_t add_locations_to_ways(osmium::memory::Buffer& buffer,
+                                          const TStoragePosIDs& storage_pos,
+                                          const TStorageNegIDs& storage_neg,
+                                          osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            std::vector<osmium::Way*> ways;
+            for (auto& way : buffer.select<osmium::Way>()) {
+                ways.push_back(&way);
+            }
+
+            if (ways.size() <= detail::ways_per_location_task) {
+                return detail::add_locations_to_way_range(ways.data(), ways.data() + ways.size(), storage_pos, storage_neg);
+            }
+
+            std::vector<std::future<std::size_t>> results;
+            for (std::size_t n = 0; n < ways.size(); n += detail::ways_per_location_task) {
+                osmium::Way* const* begin = ways.data() + n;
+                osmium::Way* const* end = ways.data() + std::min(ways.size(), n + detail::ways_per_location_task);
+                results.push_back(pool.submit([begin, end, &storage_pos, &storage_neg]() {
+                    return detail::add_locations_to_way_range(begin, end, storage_pos, storage_neg);
+                }));
+            }
+
+            // Wait for all tasks before getting the results, a task might
+            // throw, but the others still use the ways vector.
+            for (auto& result : results) {
+                result.wait();
+            }
+
+            std::size_t errors = 0;
+            for (auto& result : results) {
+                errors += result.get();
+            }
+            return errors;
+        }
+
+        /**
+         * Add node locations to all ways in a buffer using the thread pool.
+         * Same as above, but for data with only positive node IDs.
+         */
+        template <typename TStoragePosIDs>
+        std::size_t add_locations_to_ways(osmium::memory::Buffer& buffer,
+                                          const TStoragePosIDs& storage_pos,
+                                          osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            const osmium::handler::dummy_type storage_neg;
+            return add_locations_to_ways(buffer, storage_pos, storage_neg, pool);
+        }
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ADD_LOCATIONS_TO_WAYS_HPP
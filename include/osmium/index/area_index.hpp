@@ -0,0 +1,327 @@
+#ifndef OSMIUM_INDEX_AREA_INDEX_HPP
+#define OSMIUM_INDEX_AREA_INDEX_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <osmium/extract/polygon.hpp>
+#include <osmium/index/packed_rtree.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Index of areas for fast point-in-area lookups, for instance to
+         * find the administrative areas every node or way is in.
+         *
+         * Each area is stored as an osmium::extract::Polygon, which has a
+         * grid with precomputed inside/outside cells and the segments
+         * crossing each row of cells. The size of the grid depends on the
+         * number of segments of the area. The envelopes of all areas are
+         * indexed in a PackedRTree. A lookup finds the candidate areas in
+         * the R-tree and checks the location against their grids.
+         *
+         * Add all areas with add(), then call finish(). After that the
+         * index is read-only and lookups can be done from several threads
+         * at the same time, see spatial_join().
+         *
+         * Usage:
+         * @code
+         * osmium::index::AreaIndex index;
+         * for (const auto& area : areas_buffer.select<osmium::Area>()) {
+         *     index.add(area);
+         * }
+         * index.finish();
+         * index.find(location, [](osmium::object_id_type area_id) {
+         *     ...
+         * });
+         * @endcode
+         */
+        class AreaIndex {
+
+        public:
+
+            using value_type = osmium::object_id_type;
+
+        private:
+
+            std::vector<osmium::extract::Polygon> m_polygons{};
+            std::vector<value_type> m_values{};
+            PackedRTree m_rtree{};
+
+            static std::size_t grid_size_for(const osmium::Area& area) noexcept {
+                std::size_t num_segments = 0;
+                for (const auto& outer : area.outer_rings()) {
+                    num_segments += outer.size();
+                    for (const auto& inner : area.inner_rings(outer)) {
+                        num_segments += inner.size();
+                    }
+                }
+                // About four cells per segment, so the grid never needs
+                // much more memory than the segments themselves.
+                const auto size = static_cast<std::size_t>(2.0 * std::sqrt(static_cast<double>(num_segments)));
+                return std::max(std::size_t(1), std::min(size, std::size_t(osmium::extract::Polygon::default_grid_size)));
+            }
+
+        public:
+
+            /// Number of areas in the index.
+            std::size_t size() const noexcept {
+                return m_polygons.size();
+            }
+
+            bool empty() const noexcept {
+                return m_polygons.empty();
+            }
+
+            /// Has finish() been called?
+            bool finished() const noexcept {
+                return m_rtree.finished();
+            }
+
+            /**
+             * Add an area to the index with the given value. Areas
+             * without valid locations or without any area are ignored.
+             *
+             * @pre @code !finished() @endcode
+             * @returns true if the area was added, false otherwise.
+             */
+            bool add(const osmium::Area& area, value_type value) {
+                assert(!finished());
+                try {
+                    m_polygons.emplace_back(area, grid_size_for(area));
+                } catch (const std::invalid_argument&) {
+                    return false;
+                }
+                m_values.push_back(value);
+                return true;
+            }
+
+            /**
+             * Add an area to the index with its id as value.
+             *
+             * @pre @code !finished() @endcode
+             * @returns true if the area was added, false otherwise.
+             */
+            bool add(const osmium::Area& area) {
+                return add(area, area.id());
+            }
+
+            /**
+             * Build the R-tree over the envelopes of all areas. Do not
+             * call this from a task running in the pool.
+             *
+             * @pre @code !finished() @endcode
+             */
+            void finish(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                assert(!finished());
+                m_rtree.reserve(m_polygons.size());
+                for (std::size_t i = 0; i < m_polygons.size(); ++i) {
+                    m_rtree.add(m_polygons[i].envelope(), i);
+                }
+                m_rtree.finish(pool);
+            }
+
+            /**
+             * Call func(value) for all areas containing the location.
+             * The order is unspecified. Whether a location exactly on
+             * the boundary of an area is inside it is not defined.
+             *
+             * @pre @code finished() @endcode
+             */
+            template <typename TFunc>
+            void find(const osmium::Location& location, TFunc&& func) const {
+                assert(finished());
+                if (!location.valid()) {
+                    return;
+                }
+                osmium::Box box;
+                box.extend(location);
+                m_rtree.search(box, [&](PackedRTree::value_type i) {
+                    if (m_polygons[i].contains(location)) {
+                        func(m_values[i]);
+                    }
+                });
+            }
+
+            /**
+             * Get the values of all areas containing the location.
+             *
+             * @pre @code finished() @endcode
+             */
+            std::vector<value_type> find(const osmium::Location& location) const {
+                std::vector<value_type> result;
+                find(location, [&result](value_type value) {
+                    result.push_back(value);
+                });
+                return result;
+            }
+
+        }; // class AreaIndex
+
+        namespace detail {
+
+            enum : std::size_t {
+                objects_per_join_task = 1000
+            };
+
+            using spatial_join_results = std::vector<std::pair<const osmium::OSMObject*, AreaIndex::value_type>>;
+
+            /**
+             * The location used to check which areas an object is in:
+             * The location of a node, or the mean of the node locations
+             * of a way. Returns an undefined location for other objects
+             * and for ways without valid locations.
+             */
+            inline osmium::Location join_location(const osmium::OSMObject& object) noexcept {
+                if (object.type() == osmium::item_type::node) {
+                    return static_cast<const osmium::Node&>(object).location();
+                }
+                if (object.type() != osmium::item_type::way) {
+                    return osmium::Location{};
+                }
+                double x = 0.0;
+                double y = 0.0;
+                std::size_t count = 0;
+                for (const auto& node_ref : static_cast<const osmium::Way&>(object).nodes()) {
+                    if (node_ref.location().valid()) {
+                        x += node_ref.location().x();
+                        y += node_ref.location().y();
+                        ++count;
+                    }
+                }
+                if (count == 0) {
+                    return osmium::Location{};
+                }
+                return osmium::Location{static_cast<int32_t>(std::lround(x / static_cast<double>(count))),
+                                        static_cast<int32_t>(std::lround(y / static_cast<double>(count)))};
+            }
+
+            inline spatial_join_results join_object_range(const AreaIndex& index,
+                                                          const osmium::OSMObject* const* begin,
+                                                          const osmium::OSMObject* const* end) {
+                spatial_join_results results;
+                for (auto it = begin; it != end; ++it) {
+                    const osmium::OSMObject* object = *it;
+                    index.find(join_location(*object), [&](AreaIndex::value_type value) {
+                        results.emplace_back(object, value);
+                    });
+                }
+                return results;
+            }
+
+        } // namespace detail
+
+        /**
+         * Find the areas all nodes and ways in a buffer are in. Nodes are
+         * checked with their location, ways with the mean of their node
+         * locations, so ways need their node locations set. Other
+         * objects are ignored.
+         *
+         * The lookups are done in parallel on the thread pool for ranges
+         * of objects. Then func(object, value) is called in the calling
+         * thread for every object and every area (identified by its
+         * value in the index) containing it, in the order of the objects
+         * in the buffer. Do not call this from a task running in the
+         * same pool, because it waits for the tasks it submits.
+         *
+         * @param index The finished area index.
+         * @param buffer The buffer with the objects.
+         * @param func Function called with the object and the value of
+         *             the area.
+         * @param pool Thread pool to use.
+         * @returns The number of times func was called.
+         */
+        template <typename TFunc>
+        std::size_t spatial_join(const AreaIndex& index,
+                                 const osmium::memory::Buffer& buffer,
+                                 TFunc&& func,
+                                 osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            std::vector<const osmium::OSMObject*> objects;
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                if (object.type() == osmium::item_type::node || object.type() == osmium::item_type::way) {
+                    objects.push_back(&object);
+                }
+            }
+
+            std::vector<std::future<detail::spatial_join_results>> results;
+            const AreaIndex* index_ptr = &index;
+            for (std::size_t n = 0; n < objects.size(); n += detail::objects_per_join_task) {
+                const osmium::OSMObject* const* begin = objects.data() + n;
+                const osmium::OSMObject* const* end = objects.data() + std::min(objects.size(), n + detail::objects_per_join_task);
+                results.push_back(pool.submit([index_ptr, begin, end]() {
+                    return detail::join_object_range(*index_ptr, begin, end);
+                }));
+            }
+
+            // Wait for all tasks before getting the results, a task might
+            // throw, but the others still use the objects vector.
+            for (auto& result : results) {
+                result.wait();
+            }
+
+            std::size_t count = 0;
+            for (auto& result : results) {
+                for (const auto& entry : result.get()) {
+                    func(*entry.first, entry.second);
+                    ++count;
+                }
+            }
+            return count;
+        }
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_AREA_INDEX_HPP
@@ -0,0 +1,355 @@
+#ifndef OSMIUM_INDEX_CONCURRENT_ID_SET_HPP
+#define OSMIUM_INDEX_CONCURRENT_ID_SET_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/bits.hpp>
+#include <osmium/index/id_set.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * A set of Ids which can be filled from several threads at the
+         * same time without any locking. Like IdSetDense the Ids are
+         * stored in chunks of bit fields which are allocated when they
+         * are first needed. Bits are set with an atomic fetch_or and a
+         * new chunk is installed with a compare-and-swap on the chunk
+         * pointer, so workers (for instance in a buffer callback of the
+         * Reader) can call set(), check_and_set(), and get() at the same
+         * time.
+         *
+         * Unlike IdSetDense the range of Ids is fixed when the set is
+         * created, because the table of chunk pointers can not grow
+         * while other threads are using it. The table is small (one
+         * pointer for every 2^(chunk_bits+3) Ids), so it can be made
+         * large enough for all Ids up front.
+         *
+         * All other member functions (resize(), clear(), size(), ...)
+         * must not be called while Ids are set. Set Ids become visible
+         * to other threads through the usual synchronization, for
+         * instance the future of the task that set them.
+         */
+        template <typename T, std::size_t chunk_bits = detail::default_chunk_bits>
+        class ConcurrentIdSetDense {
+
+            static_assert(std::is_unsigned<T>::value, "Needs unsigned type");
+            static_assert(sizeof(T) >= 4, "Needs at least 32bit type");
+            static_assert(chunk_bits >= 3, "Chunks must have at least 64 bits");
+
+            enum : std::size_t {
+                // Size of a chunk in bytes and in 64bit words.
+                chunk_size = 1U << chunk_bits,
+                chunk_words = chunk_size / sizeof(uint64_t),
+                ids_per_chunk = chunk_size * 8
+            };
+
+            using word_type = std::atomic<uint64_t>;
+
+            std::unique_ptr<std::atomic<word_type*>[]> m_chunks;
+            std::size_t m_num_chunks = 0;
+
+            static std::size_t chunk_id(T id) noexcept {
+                return static_cast<std::size_t>(id >> (chunk_bits + 3U));
+            }
+
+            static std::size_t word_offset(T id) noexcept {
+                return static_cast<std::size_t>(id >> 6U) & (chunk_words - 1);
+            }
+
+            static uint64_t bitmask(T id) noexcept {
+                return uint64_t(1) << (id & 63U);
+            }
+
+            static std::size_t num_chunks_for(T size) noexcept {
+                return static_cast<std::size_t>((size + ids_per_chunk - 1) / ids_per_chunk);
+            }
+
+            static word_type* new_chunk() {
+                // Value initialization sets all words to zero.
+                return new word_type[chunk_words](); // NOLINT(cppcoreguidelines-owning-memory)
+            }
+
+            void delete_chunks() noexcept {
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    delete[] m_chunks[cid].load(std::memory_order_relaxed); // NOLINT(cppcoreguidelines-owning-memory)
+                }
+            }
+
+            word_type& get_word(T id) {
+                const auto cid = chunk_id(id);
+                if (cid >= m_num_chunks) {
+                    throw std::out_of_range{"id " + std::to_string(id) + " is outside ConcurrentIdSetDense"};
+                }
+
+                auto& chunk_ptr = m_chunks[cid];
+                word_type* chunk = chunk_ptr.load(std::memory_order_acquire);
+                if (!chunk) {
+                    // Several threads might do this at the same time, only
+                    // one of them will install its chunk.
+                    word_type* created = new_chunk();
+                    if (chunk_ptr.compare_exchange_strong(chunk, created, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                        chunk = created;
+                    } else {
+                        delete[] created; // NOLINT(cppcoreguidelines-owning-memory)
+                    }
+                }
+
+                return chunk[word_offset(id)];
+            }
+
+        public:
+
+            /**
+             * Create a set for Ids smaller than size. No chunks are
+             * allocated yet.
+             */
+            explicit ConcurrentIdSetDense(T size = 0) :
+                m_chunks(new std::atomic<word_type*>[num_chunks_for(size)]),
+                m_num_chunks(num_chunks_for(size)) {
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    m_chunks[cid].store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            ConcurrentIdSetDense(const ConcurrentIdSetDense&) = delete;
+            ConcurrentIdSetDense& operator=(const ConcurrentIdSetDense&) = delete;
+
+            ConcurrentIdSetDense(ConcurrentIdSetDense&& other) noexcept :
+                m_chunks(std::move(other.m_chunks)),
+                m_num_chunks(other.m_num_chunks) {
+                other.m_num_chunks = 0;
+            }
+
+            ConcurrentIdSetDense& operator=(ConcurrentIdSetDense&& other) noexcept {
+                if (this != &other) {
+                    delete_chunks();
+                    m_chunks = std::move(other.m_chunks);
+                    m_num_chunks = other.m_num_chunks;
+                    other.m_num_chunks = 0;
+                }
+                return *this;
+            }
+
+            ~ConcurrentIdSetDense() noexcept {
+                delete_chunks();
+            }
+
+            /**
+             * Ids smaller than this can be stored in the set. This is
+             * rounded up to a multiple of the number of Ids in a chunk.
+             */
+            T max_size() const noexcept {
+                return static_cast<T>(m_num_chunks) * ids_per_chunk;
+            }
+
+            /**
+             * Grow the set so that it can hold Ids smaller than size.
+             * The set never shrinks. Must not be called while other
+             * threads use the set.
+             */
+            void resize(T size) {
+                const auto num_chunks = num_chunks_for(size);
+                if (num_chunks <= m_num_chunks) {
+                    return;
+                }
+                std::unique_ptr<std::atomic<word_type*>[]> chunks{new std::atomic<word_type*>[num_chunks]};
+                for (std::size_t cid = 0; cid < num_chunks; ++cid) {
+                    chunks[cid].store(cid < m_num_chunks ? m_chunks[cid].load(std::memory_order_relaxed) : nullptr, std::memory_order_relaxed);
+                }
+                m_chunks = std::move(chunks);
+                m_num_chunks = num_chunks;
+            }
+
+            /**
+             * Add the Id to the set if it is not already in there. Can be
+             * called from several threads at the same time. If several
+             * threads add the same Id, exactly one of them gets true, so
+             * this can be used to deduplicate work.
+             *
+             * @param id The Id to set.
+             * @returns true if the Id was added, false if it was already set.
+             * @throws std::out_of_range if id >= max_size().
+             */
+            bool check_and_set(T id) {
+                const auto mask = bitmask(id);
+                return (get_word(id).fetch_or(mask, std::memory_order_relaxed) & mask) == 0;
+            }
+
+            /**
+             * Add the given Id to the set. Can be called from several
+             * threads at the same time.
+             *
+             * @param id The Id to set.
+             * @throws std::out_of_range if id >= max_size().
+             */
+            void set(T id) {
+                get_word(id).fetch_or(bitmask(id), std::memory_order_relaxed);
+            }
+
+            /**
+             * Is the Id in the set? Can be called while other threads
+             * set Ids, but might not see Ids set concurrently.
+             *
+             * @param id The Id to check.
+             */
+            bool get(T id) const noexcept {
+                const auto cid = chunk_id(id);
+                if (cid >= m_num_chunks) {
+                    return false;
+                }
+                const word_type* chunk = m_chunks[cid].load(std::memory_order_acquire);
+                if (!chunk) {
+                    return false;
+                }
+                return (chunk[word_offset(id)].load(std::memory_order_relaxed) & bitmask(id)) != 0;
+            }
+
+            /**
+             * Call func with each Id in the set in ascending order.
+             *
+             * Complexity: Linear in the number of allocated chunks.
+             */
+            template <typename TFunc>
+            void for_each(TFunc&& func) const {
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    const word_type* chunk = m_chunks[cid].load(std::memory_order_acquire);
+                    if (!chunk) {
+                        continue;
+                    }
+                    for (std::size_t w = 0; w < chunk_words; ++w) {
+                        uint64_t word = chunk[w].load(std::memory_order_relaxed);
+                        while (word != 0) {
+                            const auto bit = detail::count_trailing_zeros(word);
+                            func(static_cast<T>(cid) * ids_per_chunk + static_cast<T>(w) * 64 + bit);
+                            word &= word - 1;
+                        }
+                    }
+                }
+            }
+
+            /**
+             * The number of Ids in the set. The Ids are counted, so this
+             * is linear in the number of allocated chunks.
+             */
+            T size() const noexcept {
+                T count = 0;
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    const word_type* chunk = m_chunks[cid].load(std::memory_order_acquire);
+                    if (chunk) {
+                        for (std::size_t w = 0; w < chunk_words; ++w) {
+                            count += detail::popcount(chunk[w].load(std::memory_order_relaxed));
+                        }
+                    }
+                }
+                return count;
+            }
+
+            /**
+             * Is the set empty?
+             *
+             * Complexity: Linear in the number of allocated chunks.
+             */
+            bool empty() const noexcept {
+                return size() == 0;
+            }
+
+            /**
+             * Remove all Ids from the set and free the chunks. The range
+             * of Ids which can be stored stays the same.
+             */
+            void clear() noexcept {
+                delete_chunks();
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    m_chunks[cid].store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            std::size_t used_memory() const noexcept {
+                std::size_t memory = m_num_chunks * sizeof(std::atomic<word_type*>);
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    if (m_chunks[cid].load(std::memory_order_relaxed)) {
+                        memory += chunk_size;
+                    }
+                }
+                return memory;
+            }
+
+            /**
+             * Copy the Ids into an IdSetDense which supports iteration
+             * and set operations.
+             */
+            IdSetDense<T, chunk_bits> to_id_set_dense() const {
+                IdSetDense<T, chunk_bits> result;
+                std::size_t last = 0;
+                for (std::size_t cid = 0; cid < m_num_chunks; ++cid) {
+                    if (m_chunks[cid].load(std::memory_order_acquire)) {
+                        last = cid + 1;
+                    }
+                }
+                result.m_data.resize(last);
+
+                // Both sets use the same chunk layout, so this is a copy
+                // of 64 bits at a time.
+                for (std::size_t cid = 0; cid < last; ++cid) {
+                    const word_type* chunk = m_chunks[cid].load(std::memory_order_acquire);
+                    if (!chunk) {
+                        continue;
+                    }
+                    auto& data = result.m_data[cid];
+                    data.reset(new unsigned char[chunk_size]);
+                    for (std::size_t w = 0; w < chunk_words; ++w) {
+                        const uint64_t word = chunk[w].load(std::memory_order_relaxed);
+                        detail::store_bit_field_word(data.get() + w * sizeof(uint64_t), word);
+                        result.m_size += detail::popcount(word);
+                    }
+                }
+                return result;
+            }
+
+        }; // class ConcurrentIdSetDense
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_CONCURRENT_ID_SET_HPP
@@ -0,0 +1,251 @@
+#ifndef OSMIUM_INDEX_DETAIL_BLOOM_FILTER_HPP
+#define OSMIUM_INDEX_DETAIL_BLOOM_FILTER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Counters for the Bloom filter of a sparse index map. Lookups
+         * of ids which are in the map are not counted.
+         */
+        struct bloom_filter_stats {
+
+            /// Lookups of missing ids rejected by the filter.
+            uint64_t rejected = 0;
+
+            /// Lookups of missing ids the filter let through.
+            uint64_t false_positives = 0;
+
+            /// Memory used by the filter in bytes.
+            std::size_t bytes = 0;
+
+            /// Fraction of lookups of missing ids the filter let through (0 if none).
+            double false_positive_rate() const noexcept {
+                const auto misses = rejected + false_positives;
+                return misses == 0 ? 0.0 : static_cast<double>(false_positives) / static_cast<double>(misses);
+            }
+
+        }; // struct bloom_filter_stats
+
+        namespace detail {
+
+            /**
+             * Blocked Bloom filter over ids. Each id sets eight bits in
+             * one block of 256 bits, one bit in each 32bit word of the
+             * block, so a lookup touches only one block.
+             *
+             * The number of blocks is rounded up to a power of two, so
+             * the filter uses between one and two times the number of
+             * bits asked for. With 8 bits per id asked for, about 0.3%
+             * of the lookups of ids not in the filter are let through if
+             * the rounding ends up at 13 to 14 bits per id and about 3%
+             * if it adds nothing (measured).
+             *
+             * The filter only counts the lookups it is told about with
+             * add_counts(). Callers sum up the results of one call (for
+             * instance all lookups in a get_many()) and add them once,
+             * so concurrent lookups don't fight over the counters.
+             */
+            template <typename TId>
+            class BlockedBloomFilter {
+
+                enum : std::size_t {
+                    words_per_block = 8
+                };
+
+                std::vector<uint32_t> m_words;
+
+                // The block of an id is the hash shifted right by this.
+                unsigned int m_shift = 64;
+
+                mutable std::atomic<uint64_t> m_rejected{0};
+                mutable std::atomic<uint64_t> m_false_positives{0};
+
+                // Finalizer of splitmix64. Ids are often dense, so all
+                // bits of the id have to go into all bits of the hash.
+                static uint64_t hash(const TId id) noexcept {
+                    uint64_t h = static_cast<uint64_t>(id);
+                    h = (h ^ (h >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+                    h = (h ^ (h >> 27U)) * 0x94d049bb133111ebULL;
+                    return h ^ (h >> 31U);
+                }
+
+                // Bit in the nth word of the block for the given hash.
+                static uint32_t bitmask(const uint64_t h, const std::size_t n) noexcept {
+                    static const uint32_t salts[words_per_block] = {
+                        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+                    };
+                    return uint32_t(1) << ((static_cast<uint32_t>(h) * salts[n]) >> 27U);
+                }
+
+                std::size_t block(const uint64_t h) const noexcept {
+                    return m_shift >= 64 ? 0 : static_cast<std::size_t>(h >> m_shift) * words_per_block;
+                }
+
+                void add(const TId id) noexcept {
+                    const auto h = hash(id);
+                    uint32_t* words = m_words.data() + block(h);
+                    for (std::size_t n = 0; n < words_per_block; ++n) {
+                        words[n] |= bitmask(h, n);
+                    }
+                }
+
+            public:
+
+                BlockedBloomFilter() = default;
+
+                BlockedBloomFilter(const BlockedBloomFilter& other) :
+                    m_words(other.m_words),
+                    m_shift(other.m_shift) {
+                }
+
+                BlockedBloomFilter& operator=(const BlockedBloomFilter& other) {
+                    m_words = other.m_words;
+                    m_shift = other.m_shift;
+                    reset_stats();
+                    return *this;
+                }
+
+                BlockedBloomFilter(BlockedBloomFilter&& other) noexcept :
+                    m_words(std::move(other.m_words)),
+                    m_shift(other.m_shift) {
+                }
+
+                BlockedBloomFilter& operator=(BlockedBloomFilter&& other) noexcept {
+                    m_words = std::move(other.m_words);
+                    m_shift = other.m_shift;
+                    reset_stats();
+                    return *this;
+                }
+
+                ~BlockedBloomFilter() noexcept = default;
+
+                /**
+                 * Build the filter from the range [begin, end) of pairs
+                 * with the id as first element using about bits_per_id
+                 * bits for each id.
+                 */
+                template <typename TIterator>
+                void build(TIterator begin, TIterator end, const std::size_t bits_per_id) {
+                    const auto size = static_cast<std::size_t>(end - begin);
+                    const std::size_t bits = size * bits_per_id;
+                    std::size_t num_blocks = 1;
+                    m_shift = 64;
+                    while (num_blocks * words_per_block * 32 < bits) {
+                        num_blocks *= 2;
+                        --m_shift;
+                    }
+                    m_words.assign(num_blocks * words_per_block, 0);
+                    for (auto it = begin; it != end; ++it) {
+                        add(it->first);
+                    }
+                    reset_stats();
+                }
+
+                void clear() {
+                    std::vector<uint32_t>{}.swap(m_words);
+                    m_shift = 64;
+                }
+
+                bool empty() const noexcept {
+                    return m_words.empty();
+                }
+
+                /**
+                 * Could the id be in the filter? This doesn't change
+                 * the counters, see add_counts().
+                 *
+                 * @pre !empty()
+                 */
+                bool check(const TId id) const noexcept {
+                    const auto h = hash(id);
+                    const uint32_t* words = m_words.data() + block(h);
+                    for (std::size_t n = 0; n < words_per_block; ++n) {
+                        const auto mask = bitmask(h, n);
+                        if ((words[n] & mask) != mask) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+
+                /**
+                 * Add to the counters the number of lookups rejected by
+                 * check() and the number of lookups that passed check()
+                 * but found nothing.
+                 */
+                void add_counts(const uint64_t rejected, const uint64_t false_positives) const noexcept {
+                    if (rejected != 0) {
+                        m_rejected.fetch_add(rejected, std::memory_order_relaxed);
+                    }
+                    if (false_positives != 0) {
+                        m_false_positives.fetch_add(false_positives, std::memory_order_relaxed);
+                    }
+                }
+
+                std::size_t used_memory() const noexcept {
+                    return m_words.capacity() * sizeof(uint32_t);
+                }
+
+                bloom_filter_stats stats() const noexcept {
+                    bloom_filter_stats result;
+                    result.rejected = m_rejected.load(std::memory_order_relaxed);
+                    result.false_positives = m_false_positives.load(std::memory_order_relaxed);
+                    result.bytes = used_memory();
+                    return result;
+                }
+
+                void reset_stats() noexcept {
+                    m_rejected.store(0, std::memory_order_relaxed);
+                    m_false_positives.store(0, std::memory_order_relaxed);
+                }
+
+            }; // class BlockedBloomFilter
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_BLOOM_FILTER_HPP
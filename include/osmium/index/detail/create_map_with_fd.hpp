@@ -33,6 +33,9 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/map.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
 #include <cassert>
 #include <cerrno>
 #include <fcntl.h>
@@ -47,18 +50,62 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Get memory mapping options from the map config, starting at
+             * the given position. Possible options are "hugepages",
+             * "sequential", "random", and "populate".
+             *
+             * @throws osmium::map_factory_error if an option is unknown.
+             */
+            inline osmium::util::mapping_options get_mapping_options(const std::vector<std::string>& config, std::size_t start) {
+                osmium::util::mapping_options options;
+                for (std::size_t i = start; i < config.size(); ++i) {
+                    const std::string& option = config[i];
+                    if (option == "hugepages") {
+                        options.huge_pages = true;
+                    } else if (option == "sequential") {
+                        options.advice = osmium::util::mapping_options::access_advice::sequential;
+                    } else if (option == "random") {
+                        options.advice = osmium::util::mapping_options::access_advice::random;
+                    } else if (option == "populate") {
+                        options.populate = true;
+                    } else {
+                        throw osmium::map_factory_error{"Unknown map option '" + option + "'"};
+                    }
+                }
+                return options;
+            }
+
+            /**
+             * Create a map with anonymous memory mapping. The config
+             * can contain memory mapping options after the map type name.
+             */
+            template <typename T>
+            inline T* create_map_with_options(const std::vector<std::string>& config) {
+                if (config.size() == 1) {
+                    return new T{};
+                }
+                return new T{get_mapping_options(config, 1)};
+            }
+
+            /**
+             * Create a map backed by a file. The second item in the config
+             * is the file name, it can be followed by memory mapping
+             * options. Without file name a temporary file is used.
+             */
             template <typename T>
             inline T* create_map_with_fd(const std::vector<std::string>& config) {
                 if (config.size() == 1) {
                     return new T{};
                 }
                 assert(config.size() > 1);
+                const auto options = get_mapping_options(config, 2);
                 const std::string& filename = config[1];
                 const int fd = ::open(filename.c_str(), O_CREAT | O_RDWR, 0644); // NOLINT(hicpp-signed-bitwise)
                 if (fd == -1) {
                     throw std::system_error{errno, std::system_category(), "can't open file '" + filename + "'"};
                 }
-                return new T{fd};
+                return new T{fd, options};
             }
 
         } // namespace detail
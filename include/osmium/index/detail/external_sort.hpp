@@ -0,0 +1,196 @@
+#ifndef OSMIUM_INDEX_DETAIL_EXTERNAL_SORT_HPP
+#define OSMIUM_INDEX_DETAIL_EXTERNAL_SORT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * Sort the range [first, last) using at most about
+             * memory_budget bytes of memory. This is meant for data in
+             * memory mapped files which are larger than the available
+             * memory, where sorting in place would thrash the disk.
+             *
+             * The range is cut into runs fitting into the memory budget.
+             * Each run is copied into memory, sorted with osmium::thread::sort()
+             * using the threads in the pool, and written to a temporary
+             * file. The runs are then merged and the result is written
+             * back into the range from beginning to end. So all accesses
+             * to the range are sequential.
+             *
+             * The elements are written to the temporary file as they are,
+             * so they must be trivially copyable (this is not checked,
+             * because std::pair isn't trivially copyable in the sense of
+             * the standard). If the range fits into the memory budget, it
+             * is sorted in place. Not available on Windows, where the
+             * range is always sorted in place.
+             *
+             * Like std::sort this is not a stable sort.
+             */
+            template <typename TIterator, typename TCompare = std::less<typename std::iterator_traits<TIterator>::value_type>>
+            void external_sort(TIterator first, TIterator last, std::size_t memory_budget, osmium::thread::Pool& pool, TCompare compare = TCompare{}) {
+                using value_type = typename std::iterator_traits<TIterator>::value_type;
+                using difference_type = typename std::iterator_traits<TIterator>::difference_type;
+
+                const auto size = static_cast<std::size_t>(std::distance(first, last));
+                const std::size_t run_size = std::max<std::size_t>(1, memory_budget / sizeof(value_type));
+
+#ifdef _WIN32
+                osmium::thread::sort(first, last, compare, pool);
+#else
+                if (size <= run_size) {
+                    osmium::thread::sort(first, last, compare, pool);
+                    return;
+                }
+
+                const std::size_t num_runs = (size + run_size - 1) / run_size;
+
+                struct tmp_file {
+                    int fd = osmium::detail::create_tmp_file();
+
+                    tmp_file() = default;
+
+                    tmp_file(const tmp_file&) = delete;
+                    tmp_file& operator=(const tmp_file&) = delete;
+
+                    tmp_file(tmp_file&&) = delete;
+                    tmp_file& operator=(tmp_file&&) = delete;
+
+                    ~tmp_file() noexcept {
+                        ::close(fd);
+                    }
+                } file;
+
+                // Sort the runs and write them out one after the other.
+                {
+                    std::vector<value_type> data;
+                    data.reserve(run_size);
+                    auto it = first;
+                    for (std::size_t run = 0; run < num_runs; ++run) {
+                        const auto count = std::min(run_size, size - run * run_size);
+                        data.assign(it, it + static_cast<difference_type>(count));
+                        it += static_cast<difference_type>(count);
+                        osmium::thread::sort(data.begin(), data.end(), compare, pool);
+                        osmium::io::detail::reliable_write(file.fd, reinterpret_cast<const char*>(data.data()), count * sizeof(value_type));
+                    }
+                }
+
+                // Merge the runs, reading each through its own buffer.
+                // The buffers together use the memory budget.
+                struct run_reader {
+                    std::size_t next;
+                    std::size_t end;
+                    std::vector<value_type> data{};
+                    std::size_t pos = 0;
+
+                    run_reader(std::size_t first_element, std::size_t last_element) :
+                        next(first_element),
+                        end(last_element) {
+                    }
+
+                    bool refill(int fd, std::size_t buffer_size) {
+                        const auto count = std::min(buffer_size, end - next);
+                        if (count == 0) {
+                            return false;
+                        }
+                        data.resize(count);
+                        osmium::io::detail::reliable_pread(fd, reinterpret_cast<char*>(data.data()), count * sizeof(value_type), next * sizeof(value_type));
+                        next += count;
+                        pos = 0;
+                        return true;
+                    }
+                };
+
+                const std::size_t buffer_size = std::max<std::size_t>(1, run_size / num_runs);
+                std::vector<run_reader> runs;
+                runs.reserve(num_runs);
+
+                // Min-heap of the next element of each run and the run
+                // it came from.
+                using heap_element = std::pair<value_type, std::size_t>;
+                const auto greater = [&compare](const heap_element& a, const heap_element& b) {
+                    return compare(b.first, a.first);
+                };
+                std::priority_queue<heap_element, std::vector<heap_element>, decltype(greater)> heap{greater};
+
+                for (std::size_t run = 0; run < num_runs; ++run) {
+                    runs.emplace_back(run * run_size, std::min(size, (run + 1) * run_size));
+                    runs.back().refill(file.fd, buffer_size);
+                    heap.emplace(runs.back().data[0], run);
+                }
+
+                auto out = first;
+                while (!heap.empty()) {
+                    const std::size_t run = heap.top().second;
+                    *out = heap.top().first;
+                    ++out;
+                    heap.pop();
+
+                    auto& reader = runs[run];
+                    if (++reader.pos == reader.data.size() && !reader.refill(file.fd, buffer_size)) {
+                        std::vector<value_type>{}.swap(reader.data);
+                        continue;
+                    }
+                    heap.emplace(reader.data[reader.pos], run);
+                }
+#endif
+            }
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_EXTERNAL_SORT_HPP
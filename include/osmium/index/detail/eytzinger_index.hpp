@@ -0,0 +1,147 @@
+#ifndef OSMIUM_INDEX_DETAIL_EYTZINGER_INDEX_HPP
+#define OSMIUM_INDEX_DETAIL_EYTZINGER_INDEX_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * Search index over a sorted sequence of ids. Every block_size'th
+             * id of the sequence is stored in Eytzinger (breadth first
+             * binary tree) order. A search walks down the tree touching
+             * only one cache line per few levels, and because the children
+             * of a node are next to each other, the memory for the levels
+             * further down can be prefetched. The result tells in which
+             * block of the original sequence the id has to be looked for.
+             *
+             * This needs about (sizeof(TId) + sizeof(std::size_t)) /
+             * block_size bytes per id in the sequence.
+             */
+            template <typename TId>
+            class EytzingerIndex {
+
+                // Tree in Eytzinger order, 1-based (element 0 is unused).
+                std::vector<TId> m_ids;
+
+                // Position in sorted order for each element of the tree.
+                std::vector<std::size_t> m_ranks;
+
+                template <typename TIterator>
+                std::size_t fill(TIterator samples, std::size_t i, const std::size_t k) {
+                    if (k < m_ids.size()) {
+                        i = fill(samples, i, 2 * k);
+                        m_ids[k] = samples[i * block_size].first;
+                        m_ranks[k] = i++;
+                        i = fill(samples, i, 2 * k + 1);
+                    }
+                    return i;
+                }
+
+            public:
+
+                enum : std::size_t {
+                    block_size = 16
+                };
+
+                /**
+                 * Build the index from the range [begin, end) of sorted
+                 * pairs with the id as first element.
+                 */
+                template <typename TIterator>
+                void build(TIterator begin, TIterator end) {
+                    const auto size = static_cast<std::size_t>(end - begin);
+                    const std::size_t num_samples = (size + block_size - 1) / block_size;
+                    m_ids.resize(num_samples + 1);
+                    m_ranks.resize(num_samples + 1);
+                    fill(begin, 0, 1);
+                }
+
+                void clear() {
+                    std::vector<TId>{}.swap(m_ids);
+                    std::vector<std::size_t>{}.swap(m_ranks);
+                }
+
+                bool empty() const noexcept {
+                    return m_ids.size() <= 1;
+                }
+
+                /**
+                 * Number of sampled ids smaller than the given id. If this
+                 * is n > 0, the first id not smaller than the given id is
+                 * in the range [(n-1) * block_size + 1, n * block_size] of
+                 * the original sequence (or it is not there at all).
+                 */
+                std::size_t count_less(const TId id) const noexcept {
+                    const std::size_t size = m_ids.size();
+                    const TId* ids = m_ids.data();
+                    std::size_t k = 1;
+                    while (k < size) {
+                        // The 16 great-great-grandchildren of k are next to
+                        // each other, so this fetches them ahead of time.
+                        if (k * 16 < size) {
+                            prefetch(ids + k * 16);
+                        }
+                        k = 2 * k + (ids[k] < id ? 1 : 0);
+                    }
+                    // Going up the path, the last node at which we went left
+                    // is the first sampled id not smaller than the id.
+                    while (k & 1U) {
+                        k >>= 1U;
+                    }
+                    k >>= 1U;
+                    return k == 0 ? size - 1 : m_ranks[k];
+                }
+
+                std::size_t used_memory() const noexcept {
+                    return m_ids.capacity() * sizeof(TId) + m_ranks.capacity() * sizeof(std::size_t);
+                }
+
+            }; // class EytzingerIndex
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_EYTZINGER_INDEX_HPP
@@ -34,13 +34,17 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/index/index.hpp>
+#include <osmium/util/config.hpp>
 #include <osmium/util/memory_mapping.hpp>
+#include <osmium/util/numa.hpp>
 
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <new> // IWYU pragma: keep
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -63,18 +67,34 @@ namespace osmium {
             std::size_t m_size = 0;
             osmium::TypedMemoryMapping<T> m_mapping;
 
+            /// NUMA nodes to interleave the memory over (if any).
+            std::vector<osmium::util::numa_node> m_interleave_nodes{};
+
+            void apply_memory_policy() noexcept {
+                if (!m_interleave_nodes.empty()) {
+                    osmium::util::interleave_memory(m_mapping.begin(), capacity() * sizeof(T), m_interleave_nodes);
+                }
+            }
+
         public:
 
-            mmap_vector_base(const int fd, const std::size_t capacity, const std::size_t size = 0) :
+            mmap_vector_base(const int fd, const std::size_t capacity, const std::size_t size = 0, const osmium::util::mapping_options& options = osmium::util::mapping_options{}) :
                 m_size(size),
-                m_mapping(capacity, osmium::MemoryMapping::mapping_mode::write_shared, fd) {
+                m_mapping(capacity, osmium::MemoryMapping::mapping_mode::write_shared, fd, 0, options) {
                 assert(size <= capacity);
                 std::fill(data() + size, data() + capacity, osmium::index::empty_value<T>());
                 shrink_to_fit();
             }
 
-            explicit mmap_vector_base(const std::size_t capacity = mmap_vector_size_increment) :
-                m_mapping(capacity) {
+            explicit mmap_vector_base(const std::size_t capacity = mmap_vector_size_increment, const osmium::util::mapping_options& options = osmium::util::mapping_options{}) :
+                m_mapping(capacity, options) {
+                if (osmium::config::use_numa()) {
+                    auto nodes = osmium::util::get_numa_nodes();
+                    if (nodes.size() > 1) {
+                        m_interleave_nodes = std::move(nodes);
+                        apply_memory_policy();
+                    }
+                }
                 std::fill_n(data(), capacity, osmium::index::empty_value<T>());
             }
 
@@ -146,6 +166,7 @@ namespace osmium {
                 if (new_capacity > capacity()) {
                     const std::size_t old_capacity = capacity();
                     m_mapping.resize(new_capacity);
+                    apply_memory_policy();
                     std::fill(data() + old_capacity, data() + new_capacity, osmium::index::empty_value<value_type>());
                 }
             }
@@ -78,6 +78,14 @@ namespace osmium {
                     filesize(fd)) {
             }
 
+            mmap_vector_file(const int fd, const osmium::util::mapping_options& options) :
+                mmap_vector_base<T>(
+                    fd,
+                    std::max(static_cast<std::size_t>(mmap_vector_size_increment), filesize(fd)),
+                    filesize(fd),
+                    options) {
+            }
+
         }; // class mmap_vector_file
 
     } // namespace detail
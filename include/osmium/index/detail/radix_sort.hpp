@@ -0,0 +1,161 @@
+#ifndef OSMIUM_INDEX_DETAIL_RADIX_SORT_HPP
+#define OSMIUM_INDEX_DETAIL_RADIX_SORT_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * Call func(n) for all chunks n in [0, num_chunks). The first
+             * chunk is handled in the calling thread, all others in the
+             * pool. Returns after all chunks are done.
+             */
+            template <typename TFunction>
+            void for_each_chunk(std::size_t num_chunks, osmium::thread::Pool& pool, TFunction&& func) {
+                std::vector<std::future<void>> futures;
+                futures.reserve(num_chunks);
+                try {
+                    for (std::size_t n = 1; n < num_chunks; ++n) {
+                        futures.push_back(pool.submit([&func, n]() {
+                            func(n);
+                        }));
+                    }
+                    func(0);
+                    for (auto& future : futures) {
+                        future.get();
+                    }
+                } catch (...) {
+                    // The tasks still running reference func and the data,
+                    // so wait for them before leaving.
+                    for (auto& future : futures) {
+                        if (future.valid()) {
+                            future.wait();
+                        }
+                    }
+                    throw;
+                }
+            }
+
+            /**
+             * Sort data by the unsigned 64 bit key returned by key(element)
+             * using a stable LSD radix sort with 8 bits per pass. Large
+             * inputs are split into chunks which are counted and scattered
+             * in parallel using the threads in the pool. Passes where all
+             * elements have the same digit (for instance the high bytes of
+             * small IDs) are skipped.
+             *
+             * Needs additional memory for a copy of the data.
+             */
+            template <typename T, typename TKeyFunction>
+            void radix_sort(std::vector<T>& data, TKeyFunction&& key, osmium::thread::Pool& pool) {
+                constexpr const std::size_t min_chunk_size = 1UL << 16U;
+
+                if (data.size() < 2) {
+                    return;
+                }
+
+                const std::size_t max_chunks = static_cast<std::size_t>(pool.num_threads());
+                const std::size_t num_chunks = std::max<std::size_t>(1, std::min(max_chunks, data.size() / min_chunk_size));
+                const std::size_t chunk_size = (data.size() + num_chunks - 1) / num_chunks;
+
+                std::vector<T> out(data.size());
+                std::vector<std::array<std::size_t, 256>> counts(num_chunks);
+
+                for (unsigned int shift = 0; shift < 64; shift += 8) {
+                    const auto digit = [&key, shift](const T& element) {
+                        return static_cast<std::size_t>((static_cast<uint64_t>(key(element)) >> shift) & 0xffU);
+                    };
+
+                    for_each_chunk(num_chunks, pool, [&](std::size_t chunk) {
+                        auto& count = counts[chunk];
+                        count.fill(0);
+                        const auto last = std::min(data.size(), (chunk + 1) * chunk_size);
+                        for (std::size_t i = chunk * chunk_size; i < last; ++i) {
+                            ++count[digit(data[i])];
+                        }
+                    });
+
+                    // Turn the counts into the start positions of each chunk
+                    // in each bucket.
+                    std::size_t pos = 0;
+                    bool all_same = false;
+                    for (std::size_t bucket = 0; bucket < 256; ++bucket) {
+                        const std::size_t bucket_start = pos;
+                        for (auto& count : counts) {
+                            const auto num = count[bucket];
+                            count[bucket] = pos;
+                            pos += num;
+                        }
+                        if (pos - bucket_start == data.size()) {
+                            all_same = true;
+                        }
+                    }
+                    if (all_same) {
+                        continue;
+                    }
+
+                    for_each_chunk(num_chunks, pool, [&](std::size_t chunk) {
+                        auto& start = counts[chunk];
+                        const auto last = std::min(data.size(), (chunk + 1) * chunk_size);
+                        for (std::size_t i = chunk * chunk_size; i < last; ++i) {
+                            out[start[digit(data[i])]++] = std::move(data[i]);
+                        }
+                    });
+
+                    using std::swap;
+                    swap(data, out);
+                }
+            }
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_RADIX_SORT_HPP
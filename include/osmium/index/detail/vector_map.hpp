@@ -33,14 +33,23 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/bloom_filter.hpp>
+#include <osmium/index/detail/external_sort.hpp>
+#include <osmium/index/detail/eytzinger_index.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
+#include <osmium/util/config.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <utility>
+#include <vector>
 
 
 namespace osmium {
@@ -54,6 +63,11 @@ namespace osmium {
 
                 TVector m_vector;
 
+                // How many lookups ahead memory is prefetched in get_many().
+                enum : std::size_t {
+                    prefetch_distance = 8
+                };
+
             public:
 
                 using element_type   = TValue;
@@ -77,6 +91,16 @@ namespace osmium {
                     m_vector(fd) {
                 }
 
+                // Only available if TVector is a memory mapped vector.
+                explicit VectorBasedDenseMap(const osmium::util::mapping_options& options) :
+                    m_vector(options) {
+                }
+
+                // Only available if TVector is a file-backed memory mapped vector.
+                VectorBasedDenseMap(int fd, const osmium::util::mapping_options& options) :
+                    m_vector(fd, options) {
+                }
+
                 void reserve(const std::size_t size) final {
                     m_vector.reserve(size);
                 }
@@ -88,6 +112,39 @@ namespace osmium {
                     m_vector[id] = value;
                 }
 
+                /**
+                 * Grow the map so that it can hold all ids smaller than
+                 * the given size. New entries are set to the empty value.
+                 * The map never shrinks. Call this before set_concurrent().
+                 */
+                void resize(const std::size_t size) {
+                    if (m_vector.size() < size) {
+                        m_vector.resize(size);
+                    }
+                }
+
+                /**
+                 * Set the value for the given id without growing the map.
+                 *
+                 * Every id has its own slot in a dense map, so different
+                 * threads can call this function at the same time without
+                 * any locking as long as they write different ids. No other
+                 * non-const member function may be called while this is
+                 * going on. The writes are published to other threads
+                 * through the usual synchronization, for instance the
+                 * future of the task that did the writes.
+                 *
+                 * @returns true if the value was set, false if the id is
+                 *          outside the map (see resize()).
+                 */
+                bool set_concurrent(const TId id, const TValue value) noexcept {
+                    if (id >= m_vector.size()) {
+                        return false;
+                    }
+                    m_vector[id] = value;
+                    return true;
+                }
+
                 TValue get(const TId id) const final {
                     if (id >= m_vector.size()) {
                         throw osmium::not_found{id};
@@ -106,6 +163,21 @@ namespace osmium {
                     return m_vector[id];
                 }
 
+                void get_many(const TId* ids, const std::size_t count, TValue* values) const noexcept final {
+                    const std::size_t size = m_vector.size();
+                    for (std::size_t i = 0; i < count && i < prefetch_distance; ++i) {
+                        if (ids[i] < size) {
+                            osmium::index::detail::prefetch(&m_vector[ids[i]]);
+                        }
+                    }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        if (i + prefetch_distance < count && ids[i + prefetch_distance] < size) {
+                            osmium::index::detail::prefetch(&m_vector[ids[i + prefetch_distance]]);
+                        }
+                        values[i] = ids[i] < size ? m_vector[ids[i]] : osmium::index::empty_value<TValue>();
+                    }
+                }
+
                 std::size_t size() const final {
                     return m_vector.size();
                 }
@@ -168,23 +240,128 @@ namespace osmium {
 
                 vector_type m_vector;
 
+                // Search index over the ids, built by sort(). Empty if the
+                // vector has been changed since then.
+                osmium::index::detail::EytzingerIndex<TId> m_search_index;
+
+                // Optional filter for lookups of ids not in the map, built
+                // by sort() if m_bloom_filter_bits isn't 0.
+                osmium::index::detail::BlockedBloomFilter<TId> m_bloom_filter;
+                std::size_t m_bloom_filter_bits = osmium::config::get_bloom_filter_bits();
+
+                // Maximum number of bytes sort() uses for sorting in memory.
+                // If the vector is larger, it is sorted externally.
+                std::size_t m_sort_memory_budget = osmium::config::get_sort_memory_budget();
+
+                // Minimum number of ids for get_many() to sort the lookups.
+                enum : std::size_t {
+                    min_sorted_lookup = 16
+                };
+
                 typename vector_type::const_iterator find_id(const TId id) const noexcept {
-                    const element_type element{
-                        id,
-                        osmium::index::empty_value<TValue>()};
-                    return std::lower_bound(m_vector.begin(), m_vector.end(), element, [](const element_type& a, const element_type& b) {
-                        return a.first < b.first;
+                    auto first = m_vector.cbegin();
+                    auto last = m_vector.cend();
+                    if (!m_search_index.empty()) {
+                        // Narrow the binary search down to one block.
+                        constexpr const std::size_t block_size = osmium::index::detail::EytzingerIndex<TId>::block_size;
+                        const std::size_t n = m_search_index.count_less(id);
+                        if (n == 0) {
+                            return first;
+                        }
+                        const std::size_t start = (n - 1) * block_size + 1;
+                        if (start + block_size < m_vector.size()) {
+                            last = first + static_cast<std::ptrdiff_t>(start + block_size);
+                        }
+                        first += static_cast<std::ptrdiff_t>(start);
+                    }
+                    return std::lower_bound(first, last, id, [](const element_type& a, const TId b) {
+                        return a.first < b;
                     });
                 }
 
+                void build_search_index() {
+                    m_search_index.build(m_vector.cbegin(), m_vector.cend());
+                    if (m_bloom_filter_bits != 0 && !m_vector.empty()) {
+                        m_bloom_filter.build(m_vector.cbegin(), m_vector.cend(), m_bloom_filter_bits);
+                    } else {
+                        m_bloom_filter.clear();
+                    }
+                }
+
+                // Counts Bloom filter results of the lookups in one call,
+                // they are added to the filter counters once at the end.
+                struct lookup_counts {
+
+                    const osmium::index::detail::BlockedBloomFilter<TId>& filter;
+                    uint64_t rejected = 0;
+                    uint64_t false_positives = 0;
+
+                    explicit lookup_counts(const osmium::index::detail::BlockedBloomFilter<TId>& bloom_filter) noexcept :
+                        filter(bloom_filter) {
+                    }
+
+                    lookup_counts(const lookup_counts&) = delete;
+                    lookup_counts& operator=(const lookup_counts&) = delete;
+
+                    lookup_counts(lookup_counts&&) = delete;
+                    lookup_counts& operator=(lookup_counts&&) = delete;
+
+                    ~lookup_counts() noexcept {
+                        filter.add_counts(rejected, false_positives);
+                    }
+
+                }; // struct lookup_counts
+
+                // Is the id certainly not in the map?
+                bool filtered_out(const TId id, lookup_counts& counts) const noexcept {
+                    if (!m_bloom_filter.empty() && !m_bloom_filter.check(id)) {
+                        ++counts.rejected;
+                        return true;
+                    }
+                    return false;
+                }
+
+                void count_miss(lookup_counts& counts) const noexcept {
+                    if (!m_bloom_filter.empty()) {
+                        ++counts.false_positives;
+                    }
+                }
+
+                // Look up the id, returns empty value if not found.
+                TValue find_value(const TId id, lookup_counts& counts) const noexcept {
+                    if (filtered_out(id, counts)) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    const auto result = find_id(id);
+                    if (result == m_vector.end() || result->first != id) {
+                        count_miss(counts);
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return result->second;
+                }
+
             public:
 
                 VectorBasedSparseMap() :
                     m_vector() {
                 }
 
+                // The contents of the file must be sorted.
                 explicit VectorBasedSparseMap(int fd) :
                     m_vector(fd) {
+                    build_search_index();
+                }
+
+                // Only available if TVector is a memory mapped vector.
+                explicit VectorBasedSparseMap(const osmium::util::mapping_options& options) :
+                    m_vector(options) {
+                }
+
+                // Only available if TVector is a file-backed memory mapped
+                // vector. The contents of the file must be sorted.
+                VectorBasedSparseMap(int fd, const osmium::util::mapping_options& options) :
+                    m_vector(fd, options) {
+                    build_search_index();
                 }
 
                 VectorBasedSparseMap(const VectorBasedSparseMap&) = default;
@@ -196,12 +373,21 @@ namespace osmium {
                 ~VectorBasedSparseMap() noexcept override = default;
 
                 void set(const TId id, const TValue value) final {
+                    if (!m_search_index.empty()) {
+                        m_search_index.clear();
+                        m_bloom_filter.clear();
+                    }
                     m_vector.push_back(element_type(id, value));
                 }
 
                 TValue get(const TId id) const final {
+                    lookup_counts counts{m_bloom_filter};
+                    if (filtered_out(id, counts)) {
+                        throw osmium::not_found{id};
+                    }
                     const auto result = find_id(id);
                     if (result == m_vector.end() || result->first != id) {
+                        count_miss(counts);
                         throw osmium::not_found{id};
                     }
 
@@ -209,12 +395,55 @@ namespace osmium {
                 }
 
                 TValue get_noexcept(const TId id) const noexcept final {
-                    const auto result = find_id(id);
-                    if (result == m_vector.end() || result->first != id) {
-                        return osmium::index::empty_value<TValue>();
+                    lookup_counts counts{m_bloom_filter};
+                    return find_value(id, counts);
+                }
+
+                /**
+                 * Look up many ids at once. If there are enough ids, they
+                 * are looked up in sorted order, so that each binary search
+                 * only has to look at the part of the index after the result
+                 * of the previous search. The Bloom filter counters are
+                 * updated only once for all ids.
+                 */
+                void get_many(const TId* ids, const std::size_t count, TValue* values) const noexcept final {
+                    lookup_counts counts{m_bloom_filter};
+
+                    std::vector<std::pair<TId, std::size_t>> order;
+                    if (count >= min_sorted_lookup) {
+                        try {
+                            order.reserve(count);
+                        } catch (...) { // NOLINT(bugprone-empty-catch)
+                            // look up the ids one by one below
+                        }
+                    }
+                    if (order.capacity() < count) {
+                        for (std::size_t i = 0; i < count; ++i) {
+                            values[i] = find_value(ids[i], counts);
+                        }
+                        return;
                     }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        order.emplace_back(ids[i], i);
+                    }
+                    std::sort(order.begin(), order.end());
 
-                    return result->second;
+                    auto it = m_vector.begin();
+                    for (const auto& entry : order) {
+                        if (filtered_out(entry.first, counts)) {
+                            values[entry.second] = osmium::index::empty_value<TValue>();
+                            continue;
+                        }
+                        it = std::lower_bound(it, m_vector.end(), entry.first, [](const element_type& a, const TId id) {
+                            return a.first < id;
+                        });
+                        if (it == m_vector.end() || it->first != entry.first) {
+                            count_miss(counts);
+                            values[entry.second] = osmium::index::empty_value<TValue>();
+                        } else {
+                            values[entry.second] = it->second;
+                        }
+                    }
                 }
 
                 std::size_t size() const final {
@@ -226,16 +455,92 @@ namespace osmium {
                 }
 
                 std::size_t used_memory() const final {
-                    return sizeof(element_type) * size();
+                    return sizeof(element_type) * size() + m_search_index.used_memory() + m_bloom_filter.used_memory();
                 }
 
                 void clear() final {
                     m_vector.clear();
                     m_vector.shrink_to_fit();
-                }
-
+                    m_search_index.clear();
+                    m_bloom_filter.clear();
+                }
+
+                /**
+                 * Set the number of bits per id used for a Bloom filter
+                 * which is checked before searching for an id. This makes
+                 * lookups of ids not in the map much cheaper at the cost
+                 * of a little memory, which helps for instance with
+                 * extracts, where many ways reference nodes outside the
+                 * extract. With 8 bits per id only about 0.3% to 3% of
+                 * those lookups still need a search, depending on how much
+                 * the filter size is rounded up to a power of two (see
+                 * BlockedBloomFilter). Set to 0 (the default) for
+                 * no filter. Takes effect on the next sort().
+                 *
+                 * The default can be set with the environment variable
+                 * OSMIUM_SPARSE_MAP_BLOOM_FILTER_BITS.
+                 */
+                void set_bloom_filter_bits(const std::size_t bits) noexcept {
+                    m_bloom_filter_bits = bits;
+                }
+
+                std::size_t bloom_filter_bits() const noexcept {
+                    return m_bloom_filter_bits;
+                }
+
+                /**
+                 * Counters of the Bloom filter since the last sort(). Use
+                 * osmium::io::to_prometheus() from
+                 * osmium/io/pipeline_stats.hpp to format them.
+                 */
+                osmium::index::bloom_filter_stats bloom_filter_stats() const noexcept {
+                    return m_bloom_filter.stats();
+                }
+
+                /**
+                 * Set the maximum number of bytes used for sorting. If the
+                 * index is larger than this, sort() will sort chunks of at
+                 * most this size in memory, write them to a temporary file,
+                 * and merge them back into the index. This avoids random
+                 * access to the whole index which is very slow if the index
+                 * is in a memory mapped file larger than the available
+                 * memory. Set to 0 (the default) for no limit.
+                 *
+                 * The default can be set with the environment variable
+                 * OSMIUM_SORT_MEMORY_BUDGET (in MBytes).
+                 */
+                void set_sort_memory_budget(const std::size_t bytes) noexcept {
+                    m_sort_memory_budget = bytes;
+                }
+
+                std::size_t sort_memory_budget() const noexcept {
+                    return m_sort_memory_budget;
+                }
+
+                /**
+                 * Sort the entries and build the search index. Must be
+                 * called after the last set() and before any lookups.
+                 */
                 void sort() final {
+                    if (m_sort_memory_budget != 0 && byte_size() > m_sort_memory_budget) {
+                        sort(osmium::thread::Pool::default_instance());
+                        return;
+                    }
                     std::sort(m_vector.begin(), m_vector.end());
+                    build_search_index();
+                }
+
+                /**
+                 * Sort using the threads in the pool. Honours the sort
+                 * memory budget (see set_sort_memory_budget()).
+                 */
+                void sort(osmium::thread::Pool& pool) {
+                    if (m_sort_memory_budget != 0 && byte_size() > m_sort_memory_budget) {
+                        osmium::index::detail::external_sort(m_vector.begin(), m_vector.end(), m_sort_memory_budget, pool);
+                    } else {
+                        osmium::thread::sort(m_vector.begin(), m_vector.end(), pool);
+                    }
+                    build_search_index();
                 }
 
                 void dump_as_array(const int fd) final {
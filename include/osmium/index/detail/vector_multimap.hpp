@@ -36,9 +36,12 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/index/index.hpp>
 #include <osmium/index/multimap.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
 
 #include <algorithm>
 #include <cstddef>
+#include <iterator>
 #include <utility>
 
 namespace osmium {
@@ -91,6 +94,18 @@ namespace osmium {
                     m_vector.push_back(element_type(id, value));
                 }
 
+                /**
+                 * Append all (id, value) pairs in the range [first, last)
+                 * in one go. Like with unsorted_set() the index has to be
+                 * sorted before it can be used.
+                 */
+                template <typename TIterator>
+                void unsorted_set_many(TIterator first, TIterator last) {
+                    const auto old_size = m_vector.size();
+                    m_vector.resize(old_size + static_cast<std::size_t>(std::distance(first, last)));
+                    std::copy(first, last, m_vector.begin() + static_cast<std::ptrdiff_t>(old_size));
+                }
+
                 std::pair<iterator, iterator> get_all(const TId id) {
                     const element_type element{
                         id,
@@ -130,11 +145,40 @@ namespace osmium {
                     std::sort(m_vector.begin(), m_vector.end());
                 }
 
+                /**
+                 * Sort using the threads in the pool.
+                 */
+                void sort(osmium::thread::Pool& pool) {
+                    osmium::thread::sort(m_vector.begin(), m_vector.end(), pool);
+                }
+
+                /**
+                 * Sort the index if only the elements from position
+                 * sorted_size on are unsorted, for instance because they
+                 * were added after the last sort. Only those elements are
+                 * sorted, then both parts are merged.
+                 */
+                void sort_appended(const std::size_t sorted_size) {
+                    const auto middle = m_vector.begin() + static_cast<std::ptrdiff_t>(sorted_size);
+                    std::sort(middle, m_vector.end());
+                    std::inplace_merge(m_vector.begin(), middle, m_vector.end());
+                }
+
+                /**
+                 * Like sort_appended(sorted_size), but sort the unsorted
+                 * part using the threads in the pool.
+                 */
+                void sort_appended(const std::size_t sorted_size, osmium::thread::Pool& pool) {
+                    const auto middle = m_vector.begin() + static_cast<std::ptrdiff_t>(sorted_size);
+                    osmium::thread::sort(middle, m_vector.end(), pool);
+                    std::inplace_merge(m_vector.begin(), middle, m_vector.end());
+                }
+
                 void remove(const TId id, const TValue value) {
                     const auto r = get_all(id);
                     for (auto it = r.first; it != r.second; ++it) {
                         if (it->second == value) {
-                            it->second = 0;
+                            it->second = osmium::index::empty_value<TValue>();
                             return;
                         }
                     }
@@ -145,9 +189,8 @@ namespace osmium {
                 }
 
                 void erase_removed() {
-                    m_vector.erase(
-                        std::remove_if(m_vector.begin(), m_vector.end(), is_removed),
-                        m_vector.end());
+                    const auto last = std::remove_if(m_vector.begin(), m_vector.end(), is_removed);
+                    m_vector.resize(static_cast<std::size_t>(std::distance(m_vector.begin(), last)));
                 }
 
                 void dump_as_list(const int fd) final {
@@ -0,0 +1,238 @@
+#ifndef OSMIUM_INDEX_ID_COUNT_HPP
+#define OSMIUM_INDEX_ID_COUNT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/bits.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Counts how often each Id was seen, but only up to two: For each
+         * Id it can tell whether it was never seen, seen once, or seen
+         * twice or more. This is what is needed, for instance, to find
+         * the nodes shared by several ways.
+         *
+         * Like IdSetDense it uses two bits per Id in chunks which are
+         * allocated as needed, so it works well for dense Ids like the
+         * node Ids in OSM data.
+         *
+         * Not thread-safe for writing, but several threads can call the
+         * const member functions at the same time.
+         */
+        template <typename T = osmium::unsigned_object_id_type, std::size_t chunk_bits = 22>
+        class IdCountDense {
+
+            static_assert(std::is_unsigned<T>::value, "Needs unsigned type");
+            static_assert(sizeof(T) >= 4, "Needs at least 32bit type");
+            static_assert(chunk_bits >= 3, "Chunks must have at least 64 bits");
+
+            enum : std::size_t {
+                // Each 64 bit word holds 32 Ids. The lower bit of each pair
+                // is set if the Id was seen, the upper bit if it was seen
+                // more than once.
+                ids_per_word = 32,
+                words_per_chunk = (1U << chunk_bits) / sizeof(uint64_t),
+                ids_per_chunk = words_per_chunk * ids_per_word
+            };
+
+            using chunk_type = std::unique_ptr<uint64_t[]>;
+
+            std::vector<chunk_type> m_data;
+
+            static constexpr const uint64_t seen_bits = 0x5555555555555555ULL;
+
+            static std::size_t chunk_id(T id) noexcept {
+                return static_cast<std::size_t>(id / ids_per_chunk);
+            }
+
+            static std::size_t word_offset(T id) noexcept {
+                return static_cast<std::size_t>((id % ids_per_chunk) / ids_per_word);
+            }
+
+            static unsigned int shift(T id) noexcept {
+                return static_cast<unsigned int>(id % ids_per_word) * 2U;
+            }
+
+            uint64_t& get_word(T id) {
+                const auto cid = chunk_id(id);
+                if (cid >= m_data.size()) {
+                    m_data.resize(cid + 1);
+                }
+
+                auto& chunk = m_data[cid];
+                if (!chunk) {
+                    chunk.reset(new uint64_t[words_per_chunk]());
+                }
+
+                return chunk[word_offset(id)];
+            }
+
+            uint64_t get_word(T id) const noexcept {
+                const auto cid = chunk_id(id);
+                if (cid >= m_data.size() || !m_data[cid]) {
+                    return 0;
+                }
+                return m_data[cid][word_offset(id)];
+            }
+
+        public:
+
+            IdCountDense() = default;
+
+            /**
+             * Count the Id once more.
+             */
+            void add(T id) {
+                auto& word = get_word(id);
+                const auto s = shift(id);
+                const uint64_t seen = (word >> s) & 1U;
+                word |= (1U | (seen << 1U)) << s;
+            }
+
+            /**
+             * How often was the Id seen?
+             *
+             * @returns 0, 1, or 2 (for 2 or more).
+             */
+            unsigned int get(T id) const noexcept {
+                const auto bits = static_cast<unsigned int>((get_word(id) >> shift(id)) & 3U);
+                return bits == 0 ? 0 : (bits == 1 ? 1 : 2);
+            }
+
+            /**
+             * Was the Id seen at least twice?
+             */
+            bool multiple(T id) const noexcept {
+                return ((get_word(id) >> shift(id)) & 2U) != 0;
+            }
+
+            /**
+             * Merge the counts from the other object into this one. This
+             * allows counting in several threads with their own objects.
+             */
+            void merge(const IdCountDense& other) {
+                if (other.m_data.size() > m_data.size()) {
+                    m_data.resize(other.m_data.size());
+                }
+                for (std::size_t cid = 0; cid < other.m_data.size(); ++cid) {
+                    const uint64_t* other_chunk = other.m_data[cid].get();
+                    if (!other_chunk) {
+                        continue;
+                    }
+                    auto& chunk = m_data[cid];
+                    if (!chunk) {
+                        chunk.reset(new uint64_t[words_per_chunk]());
+                    }
+                    for (std::size_t i = 0; i < words_per_chunk; ++i) {
+                        const uint64_t a = chunk[i];
+                        const uint64_t b = other_chunk[i];
+                        chunk[i] = a | b | ((a & b & seen_bits) << 1U);
+                    }
+                }
+            }
+
+            /**
+             * The number of Ids seen at least twice.
+             */
+            std::size_t count_multiple() const noexcept {
+                std::size_t count = 0;
+                for (const auto& chunk : m_data) {
+                    if (chunk) {
+                        for (std::size_t i = 0; i < words_per_chunk; ++i) {
+                            count += detail::popcount(chunk[i] & ~seen_bits);
+                        }
+                    }
+                }
+                return count;
+            }
+
+            /**
+             * Call func with all Ids seen at least twice in ascending
+             * order.
+             */
+            template <typename TFunc>
+            void for_each_multiple(TFunc&& func) const {
+                for (std::size_t cid = 0; cid < m_data.size(); ++cid) {
+                    const uint64_t* chunk = m_data[cid].get();
+                    if (!chunk) {
+                        continue;
+                    }
+                    for (std::size_t i = 0; i < words_per_chunk; ++i) {
+                        uint64_t word = chunk[i] & ~seen_bits;
+                        while (word != 0) {
+                            const auto bit = detail::count_trailing_zeros(word);
+                            func(static_cast<T>(cid * ids_per_chunk + i * ids_per_word + bit / 2));
+                            word &= word - 1;
+                        }
+                    }
+                }
+            }
+
+            /**
+             * Clear all counts and release the memory.
+             */
+            void clear() {
+                m_data.clear();
+                m_data.shrink_to_fit();
+            }
+
+            /**
+             * Memory used in bytes.
+             */
+            std::size_t used_memory() const noexcept {
+                std::size_t used = 0;
+                for (const auto& chunk : m_data) {
+                    if (chunk) {
+                        used += words_per_chunk * sizeof(uint64_t);
+                    }
+                }
+                return sizeof(*this) + m_data.capacity() * sizeof(chunk_type) + used;
+            }
+
+        }; // class IdCountDense
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ID_COUNT_HPP
@@ -0,0 +1,270 @@
+#ifndef OSMIUM_INDEX_ID_RENUMBER_MAP_HPP
+#define OSMIUM_INDEX_ID_RENUMBER_MAP_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/index/map/sparse_mem_map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Maps the IDs of OSM objects of one type to new IDs, which are
+         * assigned consecutively (starting from start_id) in the order in
+         * which the old IDs are first seen.
+         *
+         * The old IDs are stored in a vector indexed by the new ID, which
+         * is all that is needed for the reverse mapping. As long as the
+         * old IDs are added in order (osmium::id_order), which is the case
+         * for objects in sorted OSM files, this vector is also used for
+         * looking up new IDs with a binary search, no other data is
+         * needed. IDs which are added out of order (for instance because
+         * a relation member references a relation which appears later in
+         * the input) are additionally stored in the fallback map. For
+         * input that isn't sorted, use a dense map such as DenseMmapArray
+         * or DenseFileArray here. Old negative IDs out of order are kept
+         * in a std::map.
+         *
+         * @tparam TFallbackMap Map from unsigned old IDs to the position
+         *         in the vector of old IDs. Must be derived from
+         *         osmium::index::map::Map and support set() and
+         *         get_noexcept() in any order.
+         * @tparam TVector Vector used for storing the old IDs. Use
+         *         osmium::detail::mmap_vector_file to keep it on disk.
+         */
+        template <typename TFallbackMap = osmium::index::map::SparseMemMap<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>,
+                  template <typename...> class TVector = std::vector>
+        class IdRenumberMap {
+
+            static_assert(std::is_base_of<osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>, TFallbackMap>::value,
+                          "Fallback map class must be derived from osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>");
+
+            // The old IDs indexed by (new ID - start ID).
+            TVector<osmium::object_id_type> m_old_ids;
+
+            // The number of old IDs at the beginning of m_old_ids which
+            // are ordered.
+            std::size_t m_sorted_size = 0;
+
+            // Positions in m_old_ids plus one for IDs not in the sorted
+            // part.
+            TFallbackMap m_fallback;
+            std::map<osmium::object_id_type, std::size_t> m_fallback_negative{};
+
+            osmium::object_id_type m_start_id;
+
+            // Is this ID after all IDs seen so far, which all were in
+            // order? Then it can be appended to the sorted part.
+            bool continues_sorted(const osmium::object_id_type old_id) const noexcept {
+                return m_sorted_size == m_old_ids.size() &&
+                       (m_old_ids.empty() || osmium::id_order{}(m_old_ids[m_old_ids.size() - 1], old_id));
+            }
+
+            std::size_t find_pos(const osmium::object_id_type old_id) const noexcept {
+                const auto begin = m_old_ids.begin();
+                const auto end = begin + static_cast<std::ptrdiff_t>(m_sorted_size);
+                const auto it = std::lower_bound(begin, end, old_id, osmium::id_order{});
+                if (it != end && *it == old_id) {
+                    return static_cast<std::size_t>(it - begin) + 1;
+                }
+
+                if (old_id < 0) {
+                    const auto fit = m_fallback_negative.find(old_id);
+                    return fit == m_fallback_negative.end() ? 0 : fit->second;
+                }
+                const auto pos = m_fallback.get_noexcept(static_cast<osmium::unsigned_object_id_type>(old_id));
+                return pos == osmium::index::empty_value<osmium::unsigned_object_id_type>() ? 0 : pos;
+            }
+
+            osmium::object_id_type add(const osmium::object_id_type old_id) {
+                if (continues_sorted(old_id)) {
+                    ++m_sorted_size;
+                } else if (old_id < 0) {
+                    m_fallback_negative[old_id] = m_old_ids.size() + 1;
+                } else {
+                    m_fallback.set(static_cast<osmium::unsigned_object_id_type>(old_id), m_old_ids.size() + 1);
+                }
+                m_old_ids.push_back(old_id);
+                return m_start_id + static_cast<osmium::object_id_type>(m_old_ids.size() - 1);
+            }
+
+        public:
+
+            /**
+             * @param start_id The first new ID. Must be positive.
+             * @throws std::invalid_argument if start_id isn't positive.
+             */
+            explicit IdRenumberMap(const osmium::object_id_type start_id = 1) :
+                m_old_ids(),
+                m_fallback(),
+                m_start_id(start_id) {
+                if (start_id <= 0) {
+                    throw std::invalid_argument{"start ID for renumbering must be positive"};
+                }
+            }
+
+            /// The number of IDs mapped.
+            std::size_t size() const noexcept {
+                return m_old_ids.size();
+            }
+
+            bool empty() const noexcept {
+                return m_old_ids.empty();
+            }
+
+            /// The number of IDs that were added out of order.
+            std::size_t num_unsorted() const noexcept {
+                return m_old_ids.size() - m_sorted_size;
+            }
+
+            /// The first new ID.
+            osmium::object_id_type start_id() const noexcept {
+                return m_start_id;
+            }
+
+            /**
+             * Set the first new ID. Only allowed while the map is empty.
+             *
+             * @throws std::invalid_argument if start_id isn't positive.
+             * @throws std::logic_error if the map isn't empty.
+             */
+            void set_start_id(const osmium::object_id_type start_id) {
+                if (start_id <= 0) {
+                    throw std::invalid_argument{"start ID for renumbering must be positive"};
+                }
+                if (!empty()) {
+                    throw std::logic_error{"can not change start ID of non-empty renumber map"};
+                }
+                m_start_id = start_id;
+            }
+
+            /**
+             * Get the new ID for the old ID. If the old ID hasn't been
+             * seen before, the next new ID is assigned to it.
+             */
+            osmium::object_id_type operator()(const osmium::object_id_type old_id) {
+                // Fast path for sorted input: IDs after the largest ID
+                // seen so far can not be in the map.
+                if (!continues_sorted(old_id)) {
+                    const auto pos = find_pos(old_id);
+                    if (pos != 0) {
+                        return m_start_id + static_cast<osmium::object_id_type>(pos - 1);
+                    }
+                }
+                return add(old_id);
+            }
+
+            /**
+             * Get the new ID for the old ID without adding it.
+             *
+             * @returns The new ID or 0 if the old ID is not in the map.
+             */
+            osmium::object_id_type get(const osmium::object_id_type old_id) const noexcept {
+                const auto pos = find_pos(old_id);
+                return pos == 0 ? 0 : m_start_id + static_cast<osmium::object_id_type>(pos - 1);
+            }
+
+            /**
+             * Get the old ID for a new ID (reverse mapping).
+             *
+             * @throws std::out_of_range if the new ID wasn't assigned.
+             */
+            osmium::object_id_type old_id(const osmium::object_id_type new_id) const {
+                if (new_id < m_start_id || static_cast<std::size_t>(new_id - m_start_id) >= m_old_ids.size()) {
+                    throw std::out_of_range{"unknown new ID " + std::to_string(new_id)};
+                }
+                return m_old_ids[static_cast<std::size_t>(new_id - m_start_id)];
+            }
+
+            /**
+             * Write the old IDs to the file in the order of the new IDs,
+             * each as a 64 bit integer in host byte order. Together with
+             * the start ID this is all that is needed to restore the map
+             * with read().
+             */
+            void write(const int fd) const {
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_old_ids.data()), sizeof(osmium::object_id_type) * m_old_ids.size());
+            }
+
+            /**
+             * Add all old IDs from a file written by write() to this map,
+             * in order. If the map was empty before and has the same start
+             * ID, this restores the map as it was when written.
+             *
+             * @throws std::runtime_error if the file size is wrong.
+             */
+            void read(const int fd) {
+                std::vector<osmium::object_id_type> ids(1024UL * 1024UL);
+                std::size_t leftover = 0;
+                while (true) {
+                    auto* data = reinterpret_cast<char*>(ids.data());
+                    const auto size = osmium::io::detail::reliable_read(fd, data + leftover, static_cast<unsigned int>(ids.size() * sizeof(osmium::object_id_type) - leftover));
+                    if (size == 0) {
+                        break;
+                    }
+                    const auto bytes = leftover + static_cast<std::size_t>(size);
+                    const auto count = bytes / sizeof(osmium::object_id_type);
+                    for (std::size_t n = 0; n < count; ++n) {
+                        (*this)(ids[n]);
+                    }
+                    leftover = bytes % sizeof(osmium::object_id_type);
+                    if (leftover > 0) {
+                        std::copy(data + count * sizeof(osmium::object_id_type), data + bytes, data);
+                    }
+                }
+                if (leftover > 0) {
+                    throw std::runtime_error{"ID renumber map file has wrong size"};
+                }
+            }
+
+        }; // class IdRenumberMap
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ID_RENUMBER_MAP_HPP
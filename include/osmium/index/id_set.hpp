@@ -33,14 +33,19 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/types.hpp>
+#include <osmium/util/endian.hpp>
 
 #include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <exception>
+#include <future>
 #include <iterator>
 #include <memory>
 #include <type_traits>
@@ -106,11 +111,41 @@ namespace osmium {
                 default_chunk_bits = 22U
             };
 
+            // Read 64 bits from a bit field stored as bytes so that bit n
+            // of the result is bit (n % 8) of byte (n / 8).
+            inline uint64_t load_bit_field_word(const unsigned char* data) noexcept {
+                uint64_t word; // NOLINT(cppcoreguidelines-init-variables)
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+                std::memcpy(&word, data, sizeof(word));
+#else
+                word = 0;
+                for (unsigned int i = 0; i < sizeof(word); ++i) {
+                    word |= static_cast<uint64_t>(data[i]) << (8U * i);
+                }
+#endif
+                return word;
+            }
+
+            // Store 64 bits into a bit field stored as bytes, the reverse
+            // of load_bit_field_word().
+            inline void store_bit_field_word(unsigned char* data, uint64_t word) noexcept {
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+                std::memcpy(data, &word, sizeof(word));
+#else
+                for (unsigned int i = 0; i < sizeof(word); ++i) {
+                    data[i] = static_cast<unsigned char>(word >> (8U * i));
+                }
+#endif
+            }
+
         } // namespace detail
 
         template <typename T, std::size_t chunk_bits = detail::default_chunk_bits>
         class IdSetDense;
 
+        template <typename T, std::size_t chunk_bits>
+        class ConcurrentIdSetDense;
+
         /**
          * Const_iterator for iterating over a IdSetDense.
          */
@@ -126,21 +161,23 @@ namespace osmium {
             T m_value;
             T m_last;
 
+            // Find the next Id in the set, looking at 64 bits at a time.
             void next() noexcept {
-                while (m_value != m_last && !m_set->get(m_value)) {
+                while (m_value != m_last) {
                     const T cid = id_set::chunk_id(m_value);
                     assert(cid < m_set->m_data.size());
-                    if (!m_set->m_data[cid]) {
-                        m_value = (cid + 1) << (chunk_bits + 3);
-                    } else {
-                        const auto slot = m_set->m_data[cid][id_set::offset(m_value)];
-                        if (slot == 0) {
-                            m_value += 8;
-                            m_value &= ~0x7ULL;
-                        } else {
-                            ++m_value;
-                        }
+                    const auto* chunk = m_set->m_data[cid].get();
+                    if (!chunk) {
+                        m_value = static_cast<T>(cid + 1) << (chunk_bits + 3);
+                        continue;
+                    }
+                    const auto word_offset = id_set::offset(m_value) & ~std::size_t(7);
+                    const uint64_t word = detail::load_bit_field_word(chunk + word_offset) >> (m_value & 63U);
+                    if (word != 0) {
+                        m_value += detail::count_trailing_zeros(word);
+                        return;
                     }
+                    m_value = (m_value | 63U) + 1;
                 }
             }
 
@@ -148,6 +185,7 @@ namespace osmium {
 
             using iterator_category = std::forward_iterator_tag;
             using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
             using pointer           = value_type*;
             using reference         = value_type&;
 
@@ -199,14 +237,18 @@ namespace osmium {
 
             static_assert(std::is_unsigned<T>::value, "Needs unsigned type");
             static_assert(sizeof(T) >= 4, "Needs at least 32bit type");
+            static_assert(chunk_bits >= 3, "Chunks must have at least 64 bits");
 
             friend class IdSetDenseIterator<T, chunk_bits>;
+            friend class ConcurrentIdSetDense<T, chunk_bits>;
 
             enum : std::size_t {
                 chunk_size = 1U << chunk_bits
             };
 
-            std::vector<std::unique_ptr<unsigned char[]>> m_data;
+            using chunk_type = std::unique_ptr<unsigned char[]>;
+
+            std::vector<chunk_type> m_data;
             T m_size = 0;
 
             static std::size_t chunk_id(T id) noexcept {
@@ -240,6 +282,146 @@ namespace osmium {
                 return chunk[offset(id)];
             }
 
+            static chunk_type copy_chunk(const unsigned char* data) {
+                chunk_type chunk{new unsigned char[chunk_size]};
+                ::memcpy(chunk.get(), data, chunk_size);
+                return chunk;
+            }
+
+            static int64_t count_chunk(const unsigned char* data) noexcept {
+                int64_t count = 0;
+                for (std::size_t i = 0; i < chunk_size; i += sizeof(uint64_t)) {
+                    uint64_t word; // NOLINT(cppcoreguidelines-init-variables)
+                    ::memcpy(&word, data + i, sizeof(word));
+                    count += detail::popcount(word);
+                }
+                return count;
+            }
+
+            // Combine the chunk with the other chunk 64 bits at a time.
+            // Returns the change in the number of Ids in the chunk. The
+            // bit order in the words doesn't matter here.
+            template <typename TFunc>
+            static int64_t combine_words(unsigned char* data, const unsigned char* other, TFunc&& func) noexcept {
+                int64_t change = 0;
+                for (std::size_t i = 0; i < chunk_size; i += sizeof(uint64_t)) {
+                    uint64_t word; // NOLINT(cppcoreguidelines-init-variables)
+                    uint64_t other_word; // NOLINT(cppcoreguidelines-init-variables)
+                    ::memcpy(&word, data + i, sizeof(word));
+                    ::memcpy(&other_word, other + i, sizeof(other_word));
+                    const uint64_t result = func(word, other_word);
+                    change += static_cast<int64_t>(detail::popcount(result)) - static_cast<int64_t>(detail::popcount(word));
+                    ::memcpy(data + i, &result, sizeof(result));
+                }
+                return change;
+            }
+
+            static int64_t union_chunk(chunk_type& chunk, const unsigned char* other) {
+                if (!other) {
+                    return 0;
+                }
+                if (!chunk) {
+                    chunk = copy_chunk(other);
+                    return count_chunk(other);
+                }
+                return combine_words(chunk.get(), other, [](uint64_t a, uint64_t b) {
+                    return a | b;
+                });
+            }
+
+            static int64_t intersection_chunk(chunk_type& chunk, const unsigned char* other) noexcept {
+                if (!chunk) {
+                    return 0;
+                }
+                if (!other) {
+                    const auto change = -count_chunk(chunk.get());
+                    chunk.reset();
+                    return change;
+                }
+                return combine_words(chunk.get(), other, [](uint64_t a, uint64_t b) {
+                    return a & b;
+                });
+            }
+
+            static int64_t difference_chunk(chunk_type& chunk, const unsigned char* other) noexcept {
+                if (!chunk || !other) {
+                    return 0;
+                }
+                return combine_words(chunk.get(), other, [](uint64_t a, uint64_t b) {
+                    return a & ~b;
+                });
+            }
+
+            // Apply func to the chunks [begin, end) of this set and the
+            // corresponding chunks of the other set.
+            template <typename TFunc>
+            int64_t combine_range(const IdSetDense& other, std::size_t begin, std::size_t end, TFunc func) {
+                int64_t change = 0;
+                for (auto cid = begin; cid < end; ++cid) {
+                    const unsigned char* other_chunk = cid < other.m_data.size() ? other.m_data[cid].get() : nullptr;
+                    change += func(m_data[cid], other_chunk);
+                }
+                return change;
+            }
+
+            void apply_change(int64_t change) noexcept {
+                m_size = static_cast<T>(static_cast<int64_t>(m_size) + change);
+            }
+
+            template <typename TFunc>
+            void combine(const IdSetDense& other, TFunc func) {
+                apply_change(combine_range(other, 0, m_data.size(), func));
+            }
+
+            // Chunks are independent, so they are distributed over the
+            // threads in the pool.
+            template <typename TPool, typename TFunc>
+            void combine(const IdSetDense& other, TPool& pool, TFunc func) {
+                const std::size_t num_chunks = m_data.size();
+                const auto num_tasks = std::min(num_chunks, static_cast<std::size_t>(pool.num_threads()));
+                if (num_tasks <= 1) {
+                    combine(other, func);
+                    return;
+                }
+
+                std::vector<std::future<int64_t>> futures;
+                futures.reserve(num_tasks);
+                for (std::size_t task = 0; task < num_tasks; ++task) {
+                    const auto begin = num_chunks * task / num_tasks;
+                    const auto end = num_chunks * (task + 1) / num_tasks;
+                    futures.push_back(pool.submit([this, &other, begin, end, func] {
+                        return combine_range(other, begin, end, func);
+                    }));
+                }
+
+                // The tasks use both sets, wait for all of them even if
+                // one fails.
+                std::exception_ptr exception;
+                int64_t change = 0;
+                for (auto& future : futures) {
+                    try {
+                        change += future.get();
+                    } catch (...) {
+                        if (!exception) {
+                            exception = std::current_exception();
+                        }
+                    }
+                }
+
+                if (exception) {
+                    // Some chunks are done, some not, count again.
+                    m_size = 0;
+                    for (const auto& chunk : m_data) {
+                        if (chunk) {
+                            apply_change(count_chunk(chunk.get()));
+                        }
+                    }
+                    std::rethrow_exception(exception);
+                }
+
+                apply_change(change);
+            }
+
         public:
 
             using const_iterator = IdSetDenseIterator<T, chunk_bits>;
@@ -336,6 +518,34 @@ namespace osmium {
                 return (r[offset(id)] & bitmask(id)) != 0;
             }
 
+            /**
+             * Is any Id in the range [first, last] in the set? This looks
+             * at 64 Ids at a time and skips empty chunks.
+             */
+            bool contains_any(T first, T last) const noexcept {
+                const T end = this->last();
+                if (first > last || first >= end) {
+                    return false;
+                }
+                const T stop = last < end ? last + 1 : end;
+                T id = first;
+                while (id < stop) {
+                    const auto cid = chunk_id(id);
+                    const auto* chunk = m_data[cid].get();
+                    if (!chunk) {
+                        id = static_cast<T>(cid + 1) << (chunk_bits + 3);
+                        continue;
+                    }
+                    const auto word_offset = offset(id) & ~std::size_t(7);
+                    const uint64_t word = detail::load_bit_field_word(chunk + word_offset) >> (id & 63U);
+                    if (word != 0) {
+                        return id + detail::count_trailing_zeros(word) < stop;
+                    }
+                    id = (id | 63U) + 1;
+                }
+                return false;
+            }
+
             /**
              * Is the set empty?
              */
@@ -362,6 +572,130 @@ namespace osmium {
                 return m_data.size() * chunk_size;
             }
 
+            /**
+             * Add all Ids in the other set to this set.
+             *
+             * Complexity: Linear in the number of allocated chunks.
+             *
+             * @param other The other set.
+             */
+            void set_union(const IdSetDense& other) {
+                if (&other == this) {
+                    return;
+                }
+                if (m_data.size() < other.m_data.size()) {
+                    m_data.resize(other.m_data.size());
+                }
+                combine(other, union_chunk);
+            }
+
+            /**
+             * Add all Ids in the other set to this set. The work is
+             * distributed over the threads in the pool.
+             *
+             * @param other The other set.
+             * @param pool An osmium::thread::Pool (or anything with
+             *             compatible num_threads() and submit() functions).
+             */
+            template <typename TPool>
+            void set_union(const IdSetDense& other, TPool& pool) {
+                if (&other == this) {
+                    return;
+                }
+                if (m_data.size() < other.m_data.size()) {
+                    m_data.resize(other.m_data.size());
+                }
+                combine(other, pool, union_chunk);
+            }
+
+            /**
+             * Remove all Ids from this set that are not in the other set.
+             * Chunks that become empty because the other set doesn't have
+             * them are freed.
+             *
+             * Complexity: Linear in the number of allocated chunks.
+             *
+             * @param other The other set.
+             */
+            void set_intersection(const IdSetDense& other) {
+                if (&other != this) {
+                    combine(other, intersection_chunk);
+                }
+            }
+
+            /**
+             * Remove all Ids from this set that are not in the other set.
+             * The work is distributed over the threads in the pool.
+             *
+             * @param other The other set.
+             * @param pool An osmium::thread::Pool.
+             */
+            template <typename TPool>
+            void set_intersection(const IdSetDense& other, TPool& pool) {
+                if (&other != this) {
+                    combine(other, pool, intersection_chunk);
+                }
+            }
+
+            /**
+             * Remove all Ids in the other set from this set.
+             *
+             * Complexity: Linear in the number of allocated chunks.
+             *
+             * @param other The other set.
+             */
+            void set_difference(const IdSetDense& other) {
+                if (&other == this) {
+                    clear();
+                    return;
+                }
+                combine(other, difference_chunk);
+            }
+
+            /**
+             * Remove all Ids in the other set from this set. The work is
+             * distributed over the threads in the pool.
+             *
+             * @param other The other set.
+             * @param pool An osmium::thread::Pool.
+             */
+            template <typename TPool>
+            void set_difference(const IdSetDense& other, TPool& pool) {
+                if (&other == this) {
+                    clear();
+                    return;
+                }
+                combine(other, pool, difference_chunk);
+            }
+
+            /**
+             * The number of Ids that are in this set and in the other set.
+             * Neither set is changed.
+             *
+             * Complexity: Linear in the number of allocated chunks.
+             *
+             * @param other The other set.
+             */
+            T intersection_size(const IdSetDense& other) const noexcept {
+                const auto num_chunks = std::min(m_data.size(), other.m_data.size());
+                T count = 0;
+                for (std::size_t cid = 0; cid < num_chunks; ++cid) {
+                    const auto* a = m_data[cid].get();
+                    const auto* b = other.m_data[cid].get();
+                    if (!a || !b) {
+                        continue;
+                    }
+                    for (std::size_t i = 0; i < chunk_size; i += sizeof(uint64_t)) {
+                        uint64_t wa; // NOLINT(cppcoreguidelines-init-variables)
+                        uint64_t wb; // NOLINT(cppcoreguidelines-init-variables)
+                        ::memcpy(&wa, a + i, sizeof(wa));
+                        ::memcpy(&wb, b + i, sizeof(wb));
+                        count += detail::popcount(wa & wb);
+                    }
+                }
+                return count;
+            }
+
             const_iterator begin() const {
                 return {this, 0, last()};
             }
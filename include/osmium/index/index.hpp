@@ -90,6 +90,22 @@ namespace osmium {
             return std::numeric_limits<size_t>::max();
         }
 
+        namespace detail {
+
+            /**
+             * Hint to the CPU that the memory at the given address will be
+             * read soon. Does nothing on compilers that don't support this.
+             */
+            inline void prefetch(const void* address) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+                __builtin_prefetch(address);
+#else
+                (void)address;
+#endif
+            }
+
+        } // namespace detail
+
     } // namespace index
 
 } // namespace osmium
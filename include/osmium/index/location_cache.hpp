@@ -0,0 +1,507 @@
+#ifndef OSMIUM_INDEX_LOCATION_CACHE_HPP
+#define OSMIUM_INDEX_LOCATION_CACHE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/compatibility.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when a location cache file can not be read
+     * because it is damaged or in the wrong format.
+     */
+    struct OSMIUM_EXPORT location_cache_error : public std::runtime_error {
+
+        explicit location_cache_error(const std::string& what) :
+            std::runtime_error(what) {
+        }
+
+        explicit location_cache_error(const char* what) :
+            std::runtime_error(what) {
+        }
+
+    }; // struct location_cache_error
+
+    namespace index {
+
+        /**
+         * How the locations are stored in a location cache file.
+         */
+        enum class location_cache_encoding : uint32_t {
+            /// Array of Locations indexed by node ID (starting at ID 0).
+            dense_array = 1,
+            /// Sorted list of (node ID, Location) pairs.
+            sparse_list = 2
+        }; // enum class location_cache_encoding
+
+        /**
+         * Header of a location cache file. The header is at the start of
+         * the file, the data starts at data_offset, which is always at a
+         * page boundary. All numbers are in the byte order of the machine
+         * that wrote the file. The byte_order_mark is used to detect files
+         * from machines with a different byte order.
+         */
+        struct location_cache_header {
+
+            enum : uint32_t {
+                current_version = 1,
+                byte_order_mark_value = 0x01020304
+            };
+
+            char magic[8];
+            uint32_t version;
+            uint32_t byte_order_mark;
+            uint32_t encoding;
+            uint32_t reserved1;
+
+            /// Smallest node ID with a location (0 if there are none).
+            uint64_t min_id;
+
+            /// Largest node ID with a location (0 if there are none).
+            uint64_t max_id;
+
+            /// Number of nodes with a location.
+            uint64_t num_entries;
+
+            uint64_t data_offset;
+            uint64_t data_size;
+
+            /// Timestamp of the data (seconds since the epoch).
+            uint64_t timestamp;
+
+            /// Replication sequence number of the data.
+            uint64_t sequence_number;
+
+            /// Checksum of the data, see location_cache_checksum().
+            uint64_t checksum;
+
+            uint64_t reserved2[5];
+
+        }; // struct location_cache_header
+
+        static_assert(sizeof(location_cache_header) == 128, "Unexpected size of location_cache_header");
+
+        namespace detail {
+
+            constexpr const char location_cache_magic[] = "OSMLOCC";
+
+            enum : std::size_t {
+                location_cache_data_offset = 4096
+            };
+
+            struct location_cache_entry {
+                osmium::unsigned_object_id_type id;
+                osmium::Location location;
+            };
+
+            static_assert(sizeof(location_cache_entry) == sizeof(std::pair<osmium::unsigned_object_id_type, osmium::Location>),
+                          "location_cache_entry must have the same layout as the pairs written by dump_as_list()");
+
+            inline std::size_t location_cache_element_size(const location_cache_encoding encoding) {
+                switch (encoding) {
+                    case location_cache_encoding::dense_array:
+                        return sizeof(osmium::Location);
+                    case location_cache_encoding::sparse_list:
+                        return sizeof(location_cache_entry);
+                }
+                throw location_cache_error{"unknown location cache encoding"};
+            }
+
+        } // namespace detail
+
+        /**
+         * Calculate the checksum of location cache data. This is a
+         * FNV-1a style hash over 64 bit words. It is much faster than a
+         * byte based checksum which matters for files many GBs in size.
+         */
+        inline uint64_t location_cache_checksum(const char* data, const std::size_t size) noexcept {
+            uint64_t hash = 0xcbf29ce484222325ULL;
+            std::size_t n = 0;
+            for (; n + sizeof(uint64_t) <= size; n += sizeof(uint64_t)) {
+                uint64_t word = 0;
+                std::memcpy(&word, data + n, sizeof(uint64_t));
+                hash ^= word;
+                hash *= 0x100000001b3ULL;
+            }
+            for (; n < size; ++n) {
+                hash ^= static_cast<unsigned char>(data[n]);
+                hash *= 0x100000001b3ULL;
+            }
+            return hash;
+        }
+
+        /**
+         * Write the contents of a location index to a location cache file.
+         * The index is sorted first (which does nothing for dense indexes)
+         * and then written with dump_as_array() (dense_array encoding) or
+         * dump_as_list() (sparse_list encoding). After that the data is
+         * scanned to find the ID range and to calculate the checksum, and
+         * the header is written.
+         *
+         * @param fd File descriptor of a file opened for reading and
+         *           writing. The file will be truncated.
+         * @param index The index with the locations.
+         * @param encoding How the locations should be stored.
+         * @param timestamp Timestamp of the data.
+         * @param sequence_number Replication sequence number of the data.
+         * @returns The header written to the file.
+         * @throws std::system_error if writing fails.
+         * @throws std::runtime_error if the index doesn't support the dump
+         *         function needed for this encoding.
+         */
+        inline location_cache_header write_location_cache(const int fd,
+                                                          osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>& index,
+                                                          const location_cache_encoding encoding,
+                                                          const osmium::Timestamp timestamp = osmium::Timestamp{},
+                                                          const uint64_t sequence_number = 0) {
+            const std::size_t element_size = detail::location_cache_element_size(encoding);
+
+            osmium::resize_file(fd, 0);
+            const std::string placeholder(detail::location_cache_data_offset, '\0');
+            osmium::io::detail::reliable_write(fd, placeholder.data(), placeholder.size());
+
+            index.sort();
+            if (encoding == location_cache_encoding::dense_array) {
+                index.dump_as_array(fd);
+            } else {
+                index.dump_as_list(fd);
+            }
+
+            const std::size_t file_size = osmium::file_size(fd);
+            const std::size_t data_size = file_size - detail::location_cache_data_offset;
+            if (data_size % element_size != 0) {
+                throw location_cache_error{"location cache data has wrong size"};
+            }
+
+            location_cache_header header{};
+            std::memcpy(header.magic, detail::location_cache_magic, sizeof(header.magic));
+            header.version = location_cache_header::current_version;
+            header.byte_order_mark = location_cache_header::byte_order_mark_value;
+            header.encoding = static_cast<uint32_t>(encoding);
+            header.data_offset = detail::location_cache_data_offset;
+            header.data_size = data_size;
+            header.timestamp = static_cast<uint64_t>(timestamp.seconds_since_epoch());
+            header.sequence_number = sequence_number;
+
+            osmium::MemoryMapping mapping{file_size, osmium::MemoryMapping::mapping_mode::write_shared, fd};
+            const char* data = mapping.get_addr<char>() + detail::location_cache_data_offset;
+
+            if (encoding == location_cache_encoding::dense_array) {
+                const std::size_t count = data_size / element_size;
+                for (std::size_t id = 0; id < count; ++id) {
+                    osmium::Location location;
+                    std::memcpy(&location, data + id * element_size, sizeof(osmium::Location));
+                    if (location != osmium::index::empty_value<osmium::Location>()) {
+                        if (header.num_entries == 0) {
+                            header.min_id = id;
+                        }
+                        header.max_id = id;
+                        ++header.num_entries;
+                    }
+                }
+            } else {
+                header.num_entries = data_size / element_size;
+                if (header.num_entries > 0) {
+                    detail::location_cache_entry entry; // NOLINT(cppcoreguidelines-pro-type-member-init)
+                    std::memcpy(&entry, data, sizeof(entry));
+                    header.min_id = entry.id;
+                    std::memcpy(&entry, data + data_size - element_size, sizeof(entry));
+                    header.max_id = entry.id;
+                }
+            }
+
+            header.checksum = location_cache_checksum(data, data_size);
+            std::memcpy(mapping.get_addr<char>(), &header, sizeof(header));
+            mapping.unmap();
+            osmium::io::detail::reliable_fsync(fd);
+
+            return header;
+        }
+
+        /**
+         * A location cache file opened for reading. The data is memory
+         * mapped, so opening even a huge file is fast. The header is
+         * checked when the file is opened, the checksum only if you call
+         * verify(), because that needs to read the whole file.
+         *
+         * This class implements the Map interface, so it can be used as
+         * index with the NodeLocationsForWays handler.
+         *
+         * If the cache is opened writable, set() changes the file in place.
+         * For the dense_array encoding any ID can be set, the file grows
+         * as needed. For the sparse_list encoding only IDs already in the
+         * file can be changed. Call update_header() after all changes to
+         * write the new ID range, timestamp, and checksum. The ID range
+         * is only ever extended, it might include IDs of deleted nodes.
+         */
+        class LocationCache : public osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location> {
+
+            location_cache_header m_header{};
+            std::size_t m_element_size = 0;
+            osmium::MemoryMapping m_mapping;
+
+            enum : std::size_t {
+                // Grow dense caches by at least this many locations.
+                dense_grow_size = 1024UL * 1024UL
+            };
+
+            const char* data() const noexcept {
+                return m_mapping.get_addr<char>() + m_header.data_offset;
+            }
+
+            char* data() noexcept {
+                return m_mapping.get_addr<char>() + m_header.data_offset;
+            }
+
+            void grow_dense(const osmium::unsigned_object_id_type id) {
+                const std::size_t old_count = num_elements();
+                const std::size_t new_count = std::max(static_cast<std::size_t>(id) + 1, old_count + dense_grow_size);
+                m_mapping.resize(static_cast<std::size_t>(m_header.data_offset) + new_count * sizeof(osmium::Location));
+                m_header.data_size = new_count * sizeof(osmium::Location);
+                auto* locations = reinterpret_cast<osmium::Location*>(data());
+                std::fill(locations + old_count, locations + new_count, osmium::index::empty_value<osmium::Location>());
+            }
+
+            osmium::Location* find_location(const osmium::unsigned_object_id_type id) noexcept {
+                if (encoding() == location_cache_encoding::dense_array) {
+                    return reinterpret_cast<osmium::Location*>(data()) + id;
+                }
+                auto* begin = reinterpret_cast<detail::location_cache_entry*>(data());
+                auto* end = begin + num_elements();
+                auto* it = std::lower_bound(begin, end, id, [](const detail::location_cache_entry& entry, const osmium::unsigned_object_id_type i) {
+                    return entry.id < i;
+                });
+                if (it == end || it->id != id) {
+                    return nullptr;
+                }
+                return &it->location;
+            }
+
+            static std::size_t check_file_size(const int fd) {
+                const std::size_t size = osmium::file_size(fd);
+                if (size < detail::location_cache_data_offset) {
+                    throw location_cache_error{"location cache file is too small"};
+                }
+                return size;
+            }
+
+            void check_header(const std::size_t file_size) {
+                std::memcpy(&m_header, m_mapping.get_addr<char>(), sizeof(m_header));
+                if (std::memcmp(m_header.magic, detail::location_cache_magic, sizeof(m_header.magic)) != 0) {
+                    throw location_cache_error{"not a location cache file"};
+                }
+                if (m_header.byte_order_mark != location_cache_header::byte_order_mark_value) {
+                    throw location_cache_error{"location cache file has wrong byte order"};
+                }
+                if (m_header.version != location_cache_header::current_version) {
+                    throw location_cache_error{"unsupported location cache file version " + std::to_string(m_header.version)};
+                }
+                m_element_size = detail::location_cache_element_size(encoding());
+                if (m_header.data_offset < sizeof(location_cache_header) ||
+                    m_header.data_offset > file_size ||
+                    m_header.data_size > file_size - m_header.data_offset ||
+                    m_header.data_size % m_element_size != 0) {
+                    throw location_cache_error{"location cache file is truncated or damaged"};
+                }
+            }
+
+            std::size_t num_elements() const noexcept {
+                return static_cast<std::size_t>(m_header.data_size / m_element_size);
+            }
+
+        public:
+
+            /**
+             * Open a location cache from a file descriptor. The file
+             * descriptor must be open for reading (and writing if writable
+             * is set) and stay open while the LocationCache is used.
+             *
+             * @param fd File descriptor of the cache file.
+             * @param writable Open cache for changing it in place.
+             * @throws location_cache_error if the header is not valid.
+             * @throws std::system_error if the file can not be mapped.
+             */
+            explicit LocationCache(const int fd, const bool writable = false) :
+                m_mapping(check_file_size(fd),
+                          writable ? osmium::MemoryMapping::mapping_mode::write_shared
+                                   : osmium::MemoryMapping::mapping_mode::readonly,
+                          fd) {
+                check_header(m_mapping.size());
+            }
+
+            const location_cache_header& header() const noexcept {
+                return m_header;
+            }
+
+            location_cache_encoding encoding() const noexcept {
+                return static_cast<location_cache_encoding>(m_header.encoding);
+            }
+
+            osmium::Timestamp timestamp() const noexcept {
+                return osmium::Timestamp{static_cast<uint32_t>(m_header.timestamp)};
+            }
+
+            uint64_t sequence_number() const noexcept {
+                return m_header.sequence_number;
+            }
+
+            /**
+             * Check the checksum of the data. This has to read the whole
+             * file.
+             *
+             * @returns true if the checksum is okay.
+             */
+            bool verify() const noexcept {
+                return location_cache_checksum(data(), static_cast<std::size_t>(m_header.data_size)) == m_header.checksum;
+            }
+
+            /**
+             * Set the location of a node in a writable cache. Set it to
+             * an invalid Location to mark the node as deleted.
+             *
+             * @throws std::runtime_error if the cache is not writable.
+             * @throws location_cache_error if the id is not in a cache with
+             *         sparse_list encoding.
+             */
+            void set(const osmium::unsigned_object_id_type id, const osmium::Location value) final {
+                if (!m_mapping.writable()) {
+                    throw std::runtime_error{"location cache is read-only"};
+                }
+                if (encoding() == location_cache_encoding::dense_array && id >= num_elements()) {
+                    grow_dense(id);
+                }
+                osmium::Location* location = find_location(id);
+                if (!location) {
+                    throw location_cache_error{"can not add id " + std::to_string(id) + " to sparse location cache"};
+                }
+
+                const auto empty = osmium::index::empty_value<osmium::Location>();
+                if (*location == empty && value != empty) {
+                    if (m_header.num_entries == 0 || id < m_header.min_id) {
+                        m_header.min_id = id;
+                    }
+                    if (m_header.num_entries == 0 || id > m_header.max_id) {
+                        m_header.max_id = id;
+                    }
+                    ++m_header.num_entries;
+                } else if (*location != empty && value == empty) {
+                    --m_header.num_entries;
+                }
+                *location = value;
+            }
+
+            /**
+             * Write the header of a writable cache with the given timestamp
+             * and sequence number and a new checksum. This has to read the
+             * whole file.
+             *
+             * @throws std::runtime_error if the cache is not writable.
+             */
+            void update_header(const osmium::Timestamp timestamp, const uint64_t sequence_number) {
+                if (!m_mapping.writable()) {
+                    throw std::runtime_error{"location cache is read-only"};
+                }
+                m_header.timestamp = static_cast<uint64_t>(timestamp.seconds_since_epoch());
+                m_header.sequence_number = sequence_number;
+                m_header.checksum = location_cache_checksum(data(), static_cast<std::size_t>(m_header.data_size));
+                std::memcpy(m_mapping.get_addr<char>(), &m_header, sizeof(m_header));
+            }
+
+            osmium::Location get_noexcept(const osmium::unsigned_object_id_type id) const noexcept final {
+                if (!m_mapping) {
+                    return osmium::index::empty_value<osmium::Location>();
+                }
+                if (encoding() == location_cache_encoding::dense_array) {
+                    if (id >= num_elements()) {
+                        return osmium::index::empty_value<osmium::Location>();
+                    }
+                    osmium::Location location;
+                    std::memcpy(&location, data() + id * sizeof(osmium::Location), sizeof(osmium::Location));
+                    return location;
+                }
+
+                const auto* begin = reinterpret_cast<const detail::location_cache_entry*>(data());
+                const auto* end = begin + num_elements();
+                const auto* it = std::lower_bound(begin, end, id, [](const detail::location_cache_entry& entry, const osmium::unsigned_object_id_type i) {
+                    return entry.id < i;
+                });
+                if (it == end || it->id != id) {
+                    return osmium::index::empty_value<osmium::Location>();
+                }
+                return it->location;
+            }
+
+            osmium::Location get(const osmium::unsigned_object_id_type id) const final {
+                const auto value = get_noexcept(id);
+                if (value == osmium::index::empty_value<osmium::Location>()) {
+                    throw osmium::not_found{id};
+                }
+                return value;
+            }
+
+            std::size_t size() const noexcept final {
+                return static_cast<std::size_t>(m_header.num_entries);
+            }
+
+            std::size_t used_memory() const noexcept final {
+                return static_cast<std::size_t>(m_header.data_size);
+            }
+
+            void clear() final {
+                m_mapping.unmap();
+            }
+
+        }; // class LocationCache
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_LOCATION_CACHE_HPP
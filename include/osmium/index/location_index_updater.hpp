@@ -0,0 +1,182 @@
+#ifndef OSMIUM_INDEX_LOCATION_INDEX_UPDATER_HPP
+#define OSMIUM_INDEX_LOCATION_INDEX_UPDATER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Applies node changes, usually from OSM change files, to a node
+         * location index. Created and modified nodes get their new
+         * location, deleted nodes get the empty Location.
+         *
+         * Changes are collected and written out in batches. Each batch is
+         * sorted by ID before it is written to the index with set(), so
+         * that writes into large (memory mapped) indexes have good
+         * locality. The sort is stable, so if there are several versions
+         * of the same node, the last one read wins.
+         *
+         * This can be used as a handler, call flush() after the last node,
+         * or use apply() with a Reader.
+         *
+         * The index must be one where set() overwrites existing values,
+         * such as the dense indexes, SparseMemMap, or a writable
+         * LocationCache. The vector based sparse indexes just append
+         * entries and will not work. Nodes with negative IDs are ignored.
+         */
+        class LocationIndexUpdater : public osmium::handler::Handler {
+
+        public:
+
+            using index_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+
+        private:
+
+            using update_type = std::pair<osmium::unsigned_object_id_type, osmium::Location>;
+
+            index_type& m_index;
+            std::vector<update_type> m_updates{};
+            std::size_t m_batch_size;
+            std::size_t m_count_changed = 0;
+            std::size_t m_count_deleted = 0;
+
+        public:
+
+            enum : std::size_t {
+                default_batch_size = 1024UL * 1024UL
+            };
+
+            /**
+             * Create updater.
+             *
+             * @param index The location index that should be updated.
+             * @param batch_size Number of changes collected before they
+             *                   are written to the index.
+             */
+            explicit LocationIndexUpdater(index_type& index, const std::size_t batch_size = default_batch_size) :
+                m_index(index),
+                m_batch_size(batch_size > 0 ? batch_size : 1) {
+            }
+
+            /**
+             * Remember the change of this node. The change is written to the
+             * index when the batch is full or flush() is called.
+             */
+            void node(const osmium::Node& node) {
+                if (node.id() < 0) {
+                    return;
+                }
+                const auto id = static_cast<osmium::unsigned_object_id_type>(node.id());
+                if (node.visible()) {
+                    m_updates.emplace_back(id, node.location());
+                    ++m_count_changed;
+                } else {
+                    m_updates.emplace_back(id, osmium::index::empty_value<osmium::Location>());
+                    ++m_count_deleted;
+                }
+                if (m_updates.size() >= m_batch_size) {
+                    flush();
+                }
+            }
+
+            /**
+             * Write all remembered changes to the index.
+             */
+            void flush() {
+                std::stable_sort(m_updates.begin(), m_updates.end(), [](const update_type& a, const update_type& b) {
+                    return a.first < b.first;
+                });
+                for (const auto& update : m_updates) {
+                    m_index.set(update.first, update.second);
+                }
+                m_updates.clear();
+            }
+
+            /**
+             * Read all nodes from the reader, apply their changes to the
+             * index and flush. The reader should be opened with
+             * osmium::osm_entity_bits::node for best performance.
+             */
+            void apply(osmium::io::Reader& reader) {
+                while (osmium::memory::Buffer buffer = reader.read()) {
+                    for (const auto& node : buffer.select<osmium::Node>()) {
+                        this->node(node);
+                    }
+                }
+                flush();
+            }
+
+            /**
+             * Read the change file, apply its changes to the index and
+             * flush.
+             */
+            void apply(const osmium::io::File& file) {
+                osmium::io::Reader reader{file, osmium::osm_entity_bits::node};
+                apply(reader);
+                reader.close();
+            }
+
+            /// The number of created or modified nodes seen.
+            std::size_t count_changed() const noexcept {
+                return m_count_changed;
+            }
+
+            /// The number of deleted nodes seen.
+            std::size_t count_deleted() const noexcept {
+                return m_count_deleted;
+            }
+
+        }; // class LocationIndexUpdater
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_LOCATION_INDEX_UPDATER_HPP
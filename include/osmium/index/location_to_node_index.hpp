@@ -0,0 +1,582 @@
+#ifndef OSMIUM_INDEX_LOCATION_TO_NODE_INDEX_HPP
+#define OSMIUM_INDEX_LOCATION_TO_NODE_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/apply_parallel.hpp>
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/haversine.hpp>
+#include <osmium/geom/util.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/index/detail/radix_sort.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/compatibility.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when a location to node index file can not be
+     * loaded.
+     */
+    struct OSMIUM_EXPORT location_to_node_index_error : public std::runtime_error {
+
+        explicit location_to_node_index_error(const std::string& what) :
+            std::runtime_error(what) {
+        }
+
+        explicit location_to_node_index_error(const char* what) :
+            std::runtime_error(what) {
+        }
+
+    }; // struct location_to_node_index_error
+
+    namespace index {
+
+        namespace detail {
+
+            // Spread the lower 32 bits of value to the even bits.
+            inline uint64_t morton_spread(uint64_t value) noexcept {
+                value &= 0x00000000FFFFFFFFULL;
+                value = (value | (value << 16U)) & 0x0000FFFF0000FFFFULL;
+                value = (value | (value << 8U)) & 0x00FF00FF00FF00FFULL;
+                value = (value | (value << 4U)) & 0x0F0F0F0F0F0F0F0FULL;
+                value = (value | (value << 2U)) & 0x3333333333333333ULL;
+                value = (value | (value << 1U)) & 0x5555555555555555ULL;
+                return value;
+            }
+
+            // Inverse of morton_spread(): Collect the even bits.
+            inline uint32_t morton_compact(uint64_t value) noexcept {
+                value &= 0x5555555555555555ULL;
+                value = (value | (value >> 1U)) & 0x3333333333333333ULL;
+                value = (value | (value >> 2U)) & 0x0F0F0F0F0F0F0F0FULL;
+                value = (value | (value >> 4U)) & 0x00FF00FF00FF00FFULL;
+                value = (value | (value >> 8U)) & 0x0000FFFF0000FFFFULL;
+                value = (value | (value >> 16U)) & 0x00000000FFFFFFFFULL;
+                return static_cast<uint32_t>(value);
+            }
+
+            /**
+             * Position of the location on the Morton (Z-order) curve. The
+             * x and y coordinates are interleaved without losing any
+             * precision, so the code identifies the location exactly.
+             * Coordinates are offset so that the order along each axis
+             * is kept.
+             */
+            inline uint64_t morton_code(const osmium::Location& location) noexcept {
+                const auto x = static_cast<uint64_t>(static_cast<int64_t>(location.x()) + 0x80000000LL);
+                const auto y = static_cast<uint64_t>(static_cast<int64_t>(location.y()) + 0x80000000LL);
+                return morton_spread(x) | (morton_spread(y) << 1U);
+            }
+
+            /// Inverse of morton_code().
+            inline osmium::Location morton_location(const uint64_t code) noexcept {
+                return osmium::Location{static_cast<int32_t>(static_cast<int64_t>(morton_compact(code)) - 0x80000000LL),
+                                        static_cast<int32_t>(static_cast<int64_t>(morton_compact(code >> 1U)) - 0x80000000LL)};
+            }
+
+            /**
+             * Get the smallest Morton code larger than code which is
+             * inside the box given by the codes min and max of its
+             * bottom left and top right corners. This is the BIGMIN
+             * calculation from Tropf and Herzog, "Multidimensional Range
+             * Search in Dynamically Balanced Trees" (1981).
+             *
+             * @pre min < code < max and code is outside the box.
+             */
+            inline uint64_t morton_next_in_box(const uint64_t code, uint64_t min, uint64_t max) noexcept {
+                uint64_t result = max;
+
+                for (unsigned int bit = 64; bit-- > 0;) {
+                    const uint64_t mask = 1ULL << bit;
+                    // The lower bits of the same dimension as this bit.
+                    const uint64_t lower = ((bit & 1U) ? 0xAAAAAAAAAAAAAAAAULL : 0x5555555555555555ULL) & (mask - 1);
+
+                    const unsigned int selector = ((code & mask) ? 4U : 0U) |
+                                                  ((min & mask) ? 2U : 0U) |
+                                                  ((max & mask) ? 1U : 0U);
+                    switch (selector) {
+                        case 1U: // 0 0 1
+                            result = (min & ~lower) | mask;
+                            max = (max & ~mask) | lower;
+                            break;
+                        case 3U: // 0 1 1
+                            return min;
+                        case 4U: // 1 0 0
+                            return result;
+                        case 5U: // 1 0 1
+                            min = (min & ~lower) | mask;
+                            break;
+                        default: // 0 0 0, 1 1 1; others can't happen if min <= max
+                            assert(selector == 0U || selector == 7U);
+                            break;
+                    }
+                }
+
+                return result;
+            }
+
+            /**
+             * Header of the file format written by
+             * LocationToNodeIndex::dump(). It is followed by the Morton
+             * codes of all entries and the node IDs of all entries.
+             */
+            struct location_to_node_index_header {
+
+                char magic[8];
+                uint32_t version;
+                uint32_t reserved;
+                uint64_t num_entries;
+
+            }; // struct location_to_node_index_header
+
+            static_assert(sizeof(location_to_node_index_header) == 24, "Unexpected size of location_to_node_index_header");
+
+            constexpr const char location_to_node_index_magic[8] = {'O', 'S', 'M', 'L', 'O', 'C', 'I', 'X'};
+            constexpr const uint32_t location_to_node_index_version = 1;
+
+            struct location_to_node_entry {
+
+                uint64_t code;
+                osmium::object_id_type id;
+
+                bool operator==(const location_to_node_entry& other) const noexcept {
+                    return code == other.code && id == other.id;
+                }
+
+            }; // struct location_to_node_entry
+
+        } // namespace detail
+
+        /**
+         * Compact read-only index from locations to the IDs of the nodes
+         * at those locations. Useful for finding duplicate nodes or for
+         * snapping new data to existing nodes.
+         *
+         * The entries are stored in two arrays sorted by the position of
+         * the location on the Morton (Z-order) curve, one with these
+         * positions and one with the node IDs. Exact lookups are a
+         * binary search, box and radius queries scan the part of the
+         * curve between the corners of the box and skip the parts
+         * outside the box. Nodes at the same location are next to each
+         * other sorted by ID.
+         *
+         * Create an index with a LocationToNodeIndexBuilder or
+         * build_location_to_node_index() or load one written with dump()
+         * using load(), which memory maps the file. The file format uses
+         * the native byte order.
+         */
+        class LocationToNodeIndex {
+
+            friend class LocationToNodeIndexBuilder;
+
+            std::vector<uint64_t> m_codes;
+            std::vector<osmium::object_id_type> m_ids;
+
+            std::unique_ptr<osmium::util::MemoryMapping> m_mapping;
+
+            const uint64_t* m_code_data = nullptr;
+            const osmium::object_id_type* m_id_data = nullptr;
+            std::size_t m_size = 0;
+
+            void set_data_pointers() noexcept {
+                m_code_data = m_codes.data();
+                m_id_data = m_ids.data();
+                m_size = m_codes.size();
+            }
+
+            // Create the index from entries sorted by code and id.
+            explicit LocationToNodeIndex(const std::vector<detail::location_to_node_entry>& entries) {
+                m_codes.reserve(entries.size());
+                m_ids.reserve(entries.size());
+                for (const auto& entry : entries) {
+                    m_codes.push_back(entry.code);
+                    m_ids.push_back(entry.id);
+                }
+                set_data_pointers();
+            }
+
+            template <typename TFunc>
+            void for_each_in_codes(const uint64_t min, const uint64_t max, TFunc&& func) const {
+                const uint32_t min_x = detail::morton_compact(min);
+                const uint32_t min_y = detail::morton_compact(min >> 1U);
+                const uint32_t max_x = detail::morton_compact(max);
+                const uint32_t max_y = detail::morton_compact(max >> 1U);
+
+                const auto* end = m_code_data + m_size;
+                const auto* it = std::lower_bound(m_code_data, end, min);
+                while (it != end && *it <= max) {
+                    const uint32_t x = detail::morton_compact(*it);
+                    const uint32_t y = detail::morton_compact(*it >> 1U);
+                    if (x >= min_x && x <= max_x && y >= min_y && y <= max_y) {
+                        func(detail::morton_location(*it), m_id_data[it - m_code_data]);
+                        ++it;
+                    } else {
+                        it = std::lower_bound(it + 1, end, detail::morton_next_in_box(*it, min, max));
+                    }
+                }
+            }
+
+        public:
+
+            using value_type = osmium::object_id_type;
+            using const_iterator = const value_type*;
+
+            /// Create an empty index.
+            LocationToNodeIndex() {
+                set_data_pointers();
+            }
+
+            LocationToNodeIndex(const LocationToNodeIndex&) = delete;
+            LocationToNodeIndex& operator=(const LocationToNodeIndex&) = delete;
+
+            LocationToNodeIndex(LocationToNodeIndex&&) noexcept = default;
+            LocationToNodeIndex& operator=(LocationToNodeIndex&&) noexcept = default;
+
+            ~LocationToNodeIndex() noexcept = default;
+
+            /**
+             * Load an index written with dump() by memory mapping the
+             * file. The file descriptor can be closed afterwards. Only
+             * the parts of the file needed by queries will be read from
+             * disk.
+             *
+             * @throws location_to_node_index_error if the file is not a
+             *         valid location to node index file.
+             * @throws std::system_error if the file can not be mapped.
+             */
+            static LocationToNodeIndex load(int fd) {
+                const std::size_t file_size = osmium::util::file_size(fd);
+                if (file_size < sizeof(detail::location_to_node_index_header)) {
+                    throw location_to_node_index_error{"location to node index file too small"};
+                }
+
+                std::unique_ptr<osmium::util::MemoryMapping> mapping{new osmium::util::MemoryMapping{file_size, osmium::util::MemoryMapping::mapping_mode::readonly, fd}};
+
+                const auto* header = mapping->get_addr<const detail::location_to_node_index_header>();
+                if (std::memcmp(header->magic, detail::location_to_node_index_magic, sizeof(detail::location_to_node_index_magic)) != 0) {
+                    throw location_to_node_index_error{"not a location to node index file"};
+                }
+                if (header->version != detail::location_to_node_index_version) {
+                    throw location_to_node_index_error{"unsupported location to node index file version " + std::to_string(header->version)};
+                }
+                if (file_size != sizeof(detail::location_to_node_index_header) +
+                                 header->num_entries * (sizeof(uint64_t) + sizeof(value_type))) {
+                    throw location_to_node_index_error{"location to node index file has wrong size"};
+                }
+
+                LocationToNodeIndex index;
+                const auto* data = mapping->get_addr<const unsigned char>() + sizeof(detail::location_to_node_index_header);
+                index.m_size = static_cast<std::size_t>(header->num_entries);
+                index.m_code_data = reinterpret_cast<const uint64_t*>(data);
+                data += index.m_size * sizeof(uint64_t);
+                index.m_id_data = reinterpret_cast<const value_type*>(data);
+                index.m_mapping = std::move(mapping);
+
+                return index;
+            }
+
+            /// The number of (location, node ID) entries.
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            bool empty() const noexcept {
+                return m_size == 0;
+            }
+
+            /**
+             * Get the IDs of all nodes at exactly the given location. The
+             * IDs are sorted.
+             *
+             * Complexity: Logarithmic in the number of entries.
+             */
+            std::pair<const_iterator, const_iterator> get(const osmium::Location& location) const noexcept {
+                if (!location.valid()) {
+                    return {m_id_data, m_id_data};
+                }
+                const auto range = std::equal_range(m_code_data, m_code_data + m_size, detail::morton_code(location));
+                return {m_id_data + (range.first - m_code_data), m_id_data + (range.second - m_code_data)};
+            }
+
+            /**
+             * Call func(location, id) for all nodes inside the box
+             * (including its boundary). The nodes are visited in Morton
+             * order, not sorted by ID.
+             */
+            template <typename TFunc>
+            void for_each_in_box(const osmium::Box& box, TFunc&& func) const {
+                if (!box.valid()) {
+                    return;
+                }
+                for_each_in_codes(detail::morton_code(box.bottom_left()), detail::morton_code(box.top_right()), std::forward<TFunc>(func));
+            }
+
+            /**
+             * Call func(location, id) for all nodes at most radius meters
+             * (haversine distance) away from center. This works across
+             * the antimeridian and around the poles.
+             */
+            template <typename TFunc>
+            void for_each_within(const osmium::Location& center, const double radius, TFunc&& func) const {
+                if (!center.valid() || !(radius >= 0.0)) {
+                    return;
+                }
+
+                const auto check = [&](const osmium::Location& location, const value_type id) {
+                    if (osmium::geom::haversine::distance(center, location) <= radius) {
+                        func(location, id);
+                    }
+                };
+
+                // Bounding box of the spherical cap around center. A
+                // small margin makes sure rounding to the precision of
+                // Location doesn't cut off anything.
+                const double margin = 1.0 / static_cast<double>(osmium::detail::coordinate_precision);
+                const double angle = osmium::geom::rad_to_deg(radius / osmium::geom::haversine::EARTH_RADIUS_IN_METERS);
+                const double min_lat = center.lat() - angle - margin;
+                const double max_lat = center.lat() + angle + margin;
+
+                const auto query = [&](double min_lon, double max_lon) {
+                    const osmium::Box box{std::max(min_lon, -180.0), std::max(min_lat, -90.0),
+                                          std::min(max_lon, 180.0), std::min(max_lat, 90.0)};
+                    for_each_in_codes(detail::morton_code(box.bottom_left()), detail::morton_code(box.top_right()), check);
+                };
+
+                if (min_lat <= -90.0 || max_lat >= 90.0) {
+                    // The cap contains a pole.
+                    query(-180.0, 180.0);
+                    return;
+                }
+
+                const double sin_lon = std::sin(osmium::geom::deg_to_rad(angle)) / std::cos(osmium::geom::deg_to_rad(center.lat()));
+                if (sin_lon >= 1.0) {
+                    query(-180.0, 180.0);
+                    return;
+                }
+                const double delta_lon = osmium::geom::rad_to_deg(std::asin(sin_lon)) + margin;
+                const double min_lon = center.lon() - delta_lon;
+                const double max_lon = center.lon() + delta_lon;
+
+                if (min_lon < -180.0) {
+                    query(min_lon + 360.0, 180.0);
+                    query(-180.0, max_lon);
+                } else if (max_lon > 180.0) {
+                    query(min_lon, 180.0);
+                    query(-180.0, max_lon - 360.0);
+                } else {
+                    query(min_lon, max_lon);
+                }
+            }
+
+            /**
+             * Call func(location, first, last) for each location with
+             * more than one node. The IDs of the nodes at that location
+             * are in the range [first, last), sorted.
+             *
+             * Complexity: Linear in the number of entries. The index is
+             * read sequentially, so this works well on a memory mapped
+             * index much larger than main memory.
+             */
+            template <typename TFunc>
+            void for_each_duplicate(TFunc&& func) const {
+                std::size_t first = 0;
+                while (first < m_size) {
+                    std::size_t last = first + 1;
+                    while (last < m_size && m_code_data[last] == m_code_data[first]) {
+                        ++last;
+                    }
+                    if (last - first > 1) {
+                        func(detail::morton_location(m_code_data[first]), m_id_data + first, m_id_data + last);
+                    }
+                    first = last;
+                }
+            }
+
+            /**
+             * Call func(location, id) for all entries in the index in
+             * Morton order.
+             */
+            template <typename TFunc>
+            void for_each(TFunc&& func) const {
+                for (std::size_t n = 0; n < m_size; ++n) {
+                    func(detail::morton_location(m_code_data[n]), m_id_data[n]);
+                }
+            }
+
+            /**
+             * Write the index to a file. It can be loaded again with load().
+             */
+            void dump(int fd) const {
+                detail::location_to_node_index_header header{};
+                std::copy_n(detail::location_to_node_index_magic, sizeof(detail::location_to_node_index_magic), header.magic);
+                header.version = detail::location_to_node_index_version;
+                header.num_entries = m_size;
+
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&header), sizeof(header));
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_code_data), m_size * sizeof(uint64_t));
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_id_data), m_size * sizeof(value_type));
+            }
+
+        }; // class LocationToNodeIndex
+
+        /**
+         * Handler collecting node locations to build a
+         * LocationToNodeIndex from. Nodes without a valid location and
+         * deleted nodes are ignored. Use it on files without history,
+         * otherwise all locations a node ever had end up in the index.
+         *
+         * The builder needs 16 bytes per node plus the same amount
+         * temporarily while building the index.
+         */
+        class LocationToNodeIndexBuilder : public osmium::handler::Handler {
+
+            std::vector<detail::location_to_node_entry> m_entries;
+
+        public:
+
+            /// Add an entry. Invalid locations are ignored.
+            void add(const osmium::Location& location, const osmium::object_id_type id) {
+                if (location.valid()) {
+                    m_entries.push_back(detail::location_to_node_entry{detail::morton_code(location), id});
+                }
+            }
+
+            void node(const osmium::Node& node) {
+                if (node.visible()) {
+                    add(node.location(), node.id());
+                }
+            }
+
+            /// Add all entries from another builder to this one.
+            void merge(LocationToNodeIndexBuilder&& other) {
+                if (m_entries.empty()) {
+                    using std::swap;
+                    swap(m_entries, other.m_entries);
+                } else {
+                    m_entries.insert(m_entries.end(), other.m_entries.begin(), other.m_entries.end());
+                }
+                other.clear();
+            }
+
+            /// The number of entries added so far.
+            std::size_t size() const noexcept {
+                return m_entries.size();
+            }
+
+            void reserve(std::size_t size) {
+                m_entries.reserve(size);
+            }
+
+            /**
+             * Build an index from the entries added. The entries are
+             * sorted with a parallel radix sort using the threads in the
+             * pool. Duplicate entries are removed. Afterwards the builder
+             * is empty again.
+             */
+            LocationToNodeIndex build(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                // LSD radix sort: by the less significant part first.
+                detail::radix_sort(m_entries, [](const detail::location_to_node_entry& entry) {
+                    // Flip the sign bit to keep the order of negative IDs.
+                    return static_cast<uint64_t>(entry.id) ^ (1ULL << 63U);
+                }, pool);
+                detail::radix_sort(m_entries, [](const detail::location_to_node_entry& entry) {
+                    return entry.code;
+                }, pool);
+                m_entries.erase(std::unique(m_entries.begin(), m_entries.end()), m_entries.end());
+
+                LocationToNodeIndex index{m_entries};
+                clear();
+                return index;
+            }
+
+            /// Remove all entries.
+            void clear() {
+                m_entries.clear();
+                m_entries.shrink_to_fit();
+            }
+
+        }; // class LocationToNodeIndexBuilder
+
+        /**
+         * Build a LocationToNodeIndex from all nodes in the source using
+         * the threads in the pool for reading the nodes and for sorting.
+         *
+         * @code
+         * osmium::io::Reader reader{"input.osm.pbf", osmium::osm_entity_bits::node};
+         * const auto index = osmium::index::build_location_to_node_index(reader);
+         * reader.close();
+         * index.for_each_duplicate([](const osmium::Location& location, const osmium::object_id_type* first, const osmium::object_id_type* last) {
+         *     ...
+         * });
+         * @endcode
+         *
+         * @param source Where the buffers come from, see apply_parallel().
+         * @param pool The thread pool to use.
+         * @throws Any exception thrown by the source.
+         */
+        template <typename TSource>
+        LocationToNodeIndex build_location_to_node_index(TSource& source, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            LocationToNodeIndexBuilder builder;
+            osmium::apply_parallel(source, []() {
+                return LocationToNodeIndexBuilder{};
+            }, [&builder](LocationToNodeIndexBuilder&& other) {
+                builder.merge(std::move(other));
+            }, pool);
+            return builder.build(pool);
+        }
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_LOCATION_TO_NODE_INDEX_HPP
@@ -44,6 +44,7 @@ DEALINGS IN THE SOFTWARE.
 #include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -146,6 +147,26 @@ namespace osmium {
                  */
                 virtual TValue get_noexcept(const TId id) const noexcept = 0;
 
+                /**
+                 * Retrieve values for many ids at once. This gives the
+                 * implementation a chance to optimize the lookups, for
+                 * instance by prefetching memory or by reordering the
+                 * accesses. The default implementation calls get_noexcept()
+                 * for each id.
+                 *
+                 * @param ids Pointer to the first of the ids to look for.
+                 * @param count Number of ids.
+                 * @param values Pointer to an array of at least count values
+                 *               where the results are written to. Ids that
+                 *               are not found get the empty value as defined
+                 *               by osmium::index::empty_value<TValue>().
+                 */
+                virtual void get_many(const TId* ids, const std::size_t count, TValue* values) const noexcept {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        values[i] = get_noexcept(ids[i]);
+                    }
+                }
+
                 /**
                  * Get the approximate number of items in the storage. The storage
                  * might allocate memory in blocks, so this size might not be
@@ -195,6 +216,26 @@ namespace osmium {
 
         } // namespace map
 
+        namespace detail {
+
+            template <typename T>
+            struct void_type {
+                using type = void;
+            };
+
+        } // namespace detail
+
+        /**
+         * Does the map type T support resize() and set_concurrent(), so
+         * that several threads can set values at the same time? Currently
+         * this is true for the dense maps.
+         */
+        template <typename T, typename = void>
+        struct supports_concurrent_set : std::false_type {};
+
+        template <typename T>
+        struct supports_concurrent_set<T, typename detail::void_type<decltype(std::declval<T&>().set_concurrent(std::declval<typename T::key_type>(), std::declval<typename T::value_type>()))>::type> : std::true_type {};
+
         template <typename TId, typename TValue>
         class MapFactory {
 
@@ -33,14 +33,18 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
-#include <osmium/index/map/dense_file_array.hpp>  // IWYU pragma: keep
-#include <osmium/index/map/dense_mem_array.hpp>   // IWYU pragma: keep
-#include <osmium/index/map/dense_mmap_array.hpp>  // IWYU pragma: keep
-#include <osmium/index/map/dummy.hpp>             // IWYU pragma: keep
-#include <osmium/index/map/flex_mem.hpp>          // IWYU pragma: keep
-#include <osmium/index/map/sparse_file_array.hpp> // IWYU pragma: keep
-#include <osmium/index/map/sparse_mem_array.hpp>  // IWYU pragma: keep
-#include <osmium/index/map/sparse_mem_map.hpp>    // IWYU pragma: keep
-#include <osmium/index/map/sparse_mmap_array.hpp> // IWYU pragma: keep
+#include <osmium/index/map/compressed_dense_mem_array.hpp>  // IWYU pragma: keep
+#include <osmium/index/map/compressed_sparse_mem_array.hpp> // IWYU pragma: keep
+#include <osmium/index/map/dense_file_array.hpp>            // IWYU pragma: keep
+#include <osmium/index/map/dense_mem_array.hpp>             // IWYU pragma: keep
+#include <osmium/index/map/dense_mmap_array.hpp>            // IWYU pragma: keep
+#include <osmium/index/map/dummy.hpp>                       // IWYU pragma: keep
+#include <osmium/index/map/flex_mem.hpp>                    // IWYU pragma: keep
+#include <osmium/index/map/sparse_file_array.hpp>           // IWYU pragma: keep
+#include <osmium/index/map/sparse_mem_array.hpp>            // IWYU pragma: keep
+#include <osmium/index/map/sparse_mem_map.hpp>              // IWYU pragma: keep
+#include <osmium/index/map/sparse_mem_map_flat.hpp>         // IWYU pragma: keep
+#include <osmium/index/map/sparse_mmap_array.hpp>           // IWYU pragma: keep
+#include <osmium/index/map/tiered_dense_file_array.hpp>     // IWYU pragma: keep
 
 #endif // OSMIUM_INDEX_MAP_ALL_HPP
@@ -0,0 +1,371 @@
+#ifndef OSMIUM_INDEX_MAP_COMPRESSED_DENSE_MEM_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_COMPRESSED_DENSE_MEM_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/bits.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_COMPRESSED_DENSE_MEM_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            inline unsigned int bit_width(uint64_t value) noexcept {
+                unsigned int bits = 0;
+                for (; value; value >>= 1U) {
+                    ++bits;
+                }
+                return bits;
+            }
+
+            inline void put_bits(uint64_t* data, const uint64_t pos, const unsigned int bits, const uint64_t value) noexcept {
+                if (bits == 0) {
+                    return;
+                }
+                const auto shift = static_cast<unsigned int>(pos % 64);
+                data[pos / 64] |= value << shift;
+                if (shift + bits > 64) {
+                    data[pos / 64 + 1] |= value >> (64 - shift);
+                }
+            }
+
+            inline uint64_t get_bits(const uint64_t* data, const uint64_t pos, const unsigned int bits) noexcept {
+                if (bits == 0) {
+                    return 0;
+                }
+                const auto shift = static_cast<unsigned int>(pos % 64);
+                uint64_t value = data[pos / 64] >> shift;
+                if (shift + bits > 64) {
+                    value |= data[pos / 64 + 1] << (64 - shift);
+                }
+                return bits == 64 ? value : value & ((1ULL << bits) - 1);
+            }
+
+        } // namespace detail
+
+        namespace map {
+
+            /**
+             * Dense index for node locations which stores the locations in
+             * compressed form in memory. The ID space is split into pages
+             * of 4096 IDs. Pages without any entries take up no space
+             * (except for an empty std::vector). Each page with entries
+             * has a presence bitmap, a rank table and the packed locations
+             * of all IDs in that page that have a location. Locations are
+             * stored as offsets from the smallest x and y coordinates in
+             * the page using as many bits as are needed for the largest
+             * offset in that page. Nodes with neighbouring IDs are usually
+             * close to each other, so this needs much less than the 8 bytes
+             * per location used by the DenseMemArray. Lookup is O(1): find
+             * the page, check the bit, count the bits before it using the
+             * rank table and one popcount, and extract the packed values.
+             *
+             * Entries are set in an uncompressed buffer holding one page.
+             * When set() is called with an ID in a different page, the
+             * buffer is compressed. For sorted input, which is what you
+             * usually have, every page is compressed exactly once. Unsorted
+             * input works, but is slow, because pages have to be
+             * uncompressed and compressed again.
+             *
+             * Only works with osmium::Location values.
+             */
+            template <typename TId, typename TValue>
+            class CompressedDenseMemArray : public osmium::index::map::Map<TId, TValue> {
+
+                static_assert(std::is_same<TValue, osmium::Location>::value,
+                              "CompressedDenseMemArray only works with osmium::Location values");
+
+                enum : uint64_t {
+                    page_bits = 12,
+                    page_size = 1ULL << page_bits,
+                    bitmap_words = page_size / 64,
+                    rank_words = bitmap_words / 4, // 16 bit rank per bitmap word
+                    header_words = 2,
+                    data_start = header_words + bitmap_words + rank_words
+                };
+
+                // Packed pages. Layout of each non-empty page:
+                // - word 0: minimum x (lower 32 bits) and y (upper 32 bits)
+                // - word 1: bits used for x (bits 0-7) and y (bits 8-15)
+                // - bitmap_words words: bitmap of IDs with a location
+                // - rank_words words: number of bits set before each
+                //   bitmap word (16 bits each)
+                // - packed x and y offsets of all locations
+                std::vector<std::vector<uint64_t>> m_pages{};
+
+                // Uncompressed buffer for the page currently being set.
+                std::vector<TValue> m_current{};
+                uint64_t m_current_page = 0;
+                bool m_has_current = false;
+
+                // Number of 64 bit words in all packed pages.
+                std::size_t m_packed_words = 0;
+
+                static uint64_t page(const TId id) noexcept {
+                    return static_cast<uint64_t>(id) >> page_bits;
+                }
+
+                static uint64_t offset(const TId id) noexcept {
+                    return static_cast<uint64_t>(id) & (page_size - 1);
+                }
+
+                static TValue get_from_page(const std::vector<uint64_t>& data, const uint64_t off) noexcept {
+                    const uint64_t word = data[header_words + off / 64];
+                    const uint64_t bit = off % 64;
+                    if (!((word >> bit) & 1U)) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+
+                    const uint64_t rank = ((data[header_words + bitmap_words + off / 256] >> (16 * ((off / 64) % 4))) & 0xffffU) +
+                                          osmium::index::detail::popcount(word & ((1ULL << bit) - 1));
+
+                    const auto bits_x = static_cast<unsigned int>(data[1] & 0xffU);
+                    const auto bits_y = static_cast<unsigned int>((data[1] >> 8U) & 0xffU);
+                    const uint64_t pos = rank * (bits_x + bits_y);
+                    const uint64_t* packed = data.data() + data_start;
+
+                    return TValue{static_cast<int32_t>(static_cast<int64_t>(static_cast<int32_t>(data[0] & 0xffffffffU)) +
+                                                       static_cast<int64_t>(osmium::index::detail::get_bits(packed, pos, bits_x))),
+                                  static_cast<int32_t>(static_cast<int64_t>(static_cast<int32_t>(data[0] >> 32U)) +
+                                                       static_cast<int64_t>(osmium::index::detail::get_bits(packed, pos + bits_x, bits_y)))};
+                }
+
+                static void unpack_page(const std::vector<uint64_t>& data, std::vector<TValue>& values) {
+                    values.assign(page_size, osmium::index::empty_value<TValue>());
+                    if (data.empty()) {
+                        return;
+                    }
+                    for (uint64_t off = 0; off < page_size; ++off) {
+                        values[off] = get_from_page(data, off);
+                    }
+                }
+
+                static std::vector<uint64_t> pack_page(const std::vector<TValue>& values) {
+                    std::size_t count = 0;
+                    int32_t min_x = 0;
+                    int32_t max_x = 0;
+                    int32_t min_y = 0;
+                    int32_t max_y = 0;
+                    for (const auto& value : values) {
+                        if (value == osmium::index::empty_value<TValue>()) {
+                            continue;
+                        }
+                        if (count == 0 || value.x() < min_x) {
+                            min_x = value.x();
+                        }
+                        if (count == 0 || value.x() > max_x) {
+                            max_x = value.x();
+                        }
+                        if (count == 0 || value.y() < min_y) {
+                            min_y = value.y();
+                        }
+                        if (count == 0 || value.y() > max_y) {
+                            max_y = value.y();
+                        }
+                        ++count;
+                    }
+
+                    if (count == 0) {
+                        return {};
+                    }
+
+                    const auto bits_x = osmium::index::detail::bit_width(static_cast<uint64_t>(static_cast<int64_t>(max_x) - min_x));
+                    const auto bits_y = osmium::index::detail::bit_width(static_cast<uint64_t>(static_cast<int64_t>(max_y) - min_y));
+
+                    std::vector<uint64_t> data(data_start + (count * (bits_x + bits_y) + 63) / 64, 0);
+                    data[0] = static_cast<uint64_t>(static_cast<uint32_t>(min_x)) |
+                              (static_cast<uint64_t>(static_cast<uint32_t>(min_y)) << 32U);
+                    data[1] = bits_x | (bits_y << 8U);
+
+                    uint64_t rank = 0;
+                    uint64_t* packed = data.data() + data_start;
+                    for (uint64_t off = 0; off < page_size; ++off) {
+                        if (off % 64 == 0) {
+                            data[header_words + bitmap_words + off / 256] |= rank << (16 * ((off / 64) % 4));
+                        }
+                        const auto& value = values[off];
+                        if (value == osmium::index::empty_value<TValue>()) {
+                            continue;
+                        }
+                        data[header_words + off / 64] |= 1ULL << (off % 64);
+                        const uint64_t pos = rank * (bits_x + bits_y);
+                        osmium::index::detail::put_bits(packed, pos, bits_x, static_cast<uint64_t>(static_cast<int64_t>(value.x()) - min_x));
+                        osmium::index::detail::put_bits(packed, pos + bits_x, bits_y, static_cast<uint64_t>(static_cast<int64_t>(value.y()) - min_y));
+                        ++rank;
+                    }
+
+                    return data;
+                }
+
+                void pack_current() {
+                    if (!m_has_current) {
+                        return;
+                    }
+                    auto& data = m_pages[m_current_page];
+                    m_packed_words -= data.size();
+                    data = pack_page(m_current);
+                    m_packed_words += data.size();
+                    m_has_current = false;
+                }
+
+                template <typename TFunc>
+                void for_each_page(TFunc&& func) const {
+                    std::vector<TValue> values;
+                    for (uint64_t p = 0; p < m_pages.size(); ++p) {
+                        if (m_has_current && p == m_current_page) {
+                            func(p, m_current);
+                        } else {
+                            unpack_page(m_pages[p], values);
+                            func(p, values);
+                        }
+                    }
+                }
+
+            public:
+
+                CompressedDenseMemArray() = default;
+
+                ~CompressedDenseMemArray() noexcept override = default;
+
+                void set(const TId id, const TValue value) final {
+                    const uint64_t p = page(id);
+                    if (!m_has_current || p != m_current_page) {
+                        pack_current();
+                        if (p >= m_pages.size()) {
+                            m_pages.resize(p + 1);
+                        }
+                        unpack_page(m_pages[p], m_current);
+                        m_current_page = p;
+                        m_has_current = true;
+                    }
+                    m_current[offset(id)] = value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    const uint64_t p = page(id);
+                    if (m_has_current && p == m_current_page) {
+                        return m_current[offset(id)];
+                    }
+                    if (p >= m_pages.size() || m_pages[p].empty()) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return get_from_page(m_pages[p], offset(id));
+                }
+
+                TValue get(const TId id) const final {
+                    const auto value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                std::size_t size() const final {
+                    return m_pages.size() * page_size;
+                }
+
+                std::size_t used_memory() const final {
+                    return sizeof(CompressedDenseMemArray) +
+                           m_pages.capacity() * sizeof(std::vector<uint64_t>) +
+                           m_packed_words * sizeof(uint64_t) +
+                           m_current.capacity() * sizeof(TValue);
+                }
+
+                void clear() final {
+                    m_pages.clear();
+                    m_pages.shrink_to_fit();
+                    m_current.clear();
+                    m_current.shrink_to_fit();
+                    m_current_page = 0;
+                    m_has_current = false;
+                    m_packed_words = 0;
+                }
+
+                /**
+                 * Compress the page that is currently being set and free the
+                 * uncompressed buffer. Calling this is not necessary, but it
+                 * saves a little bit of memory.
+                 */
+                void sort() final {
+                    pack_current();
+                    m_current.clear();
+                    m_current.shrink_to_fit();
+                }
+
+                void dump_as_array(const int fd) final {
+                    for_each_page([fd](uint64_t /*page*/, const std::vector<TValue>& values) {
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(values.data()), sizeof(TValue) * values.size());
+                    });
+                }
+
+                void dump_as_list(const int fd) final {
+                    using element_type = std::pair<TId, TValue>;
+                    std::vector<element_type> output;
+                    for_each_page([fd, &output](uint64_t page, const std::vector<TValue>& values) {
+                        for (uint64_t off = 0; off < page_size; ++off) {
+                            if (values[off] != osmium::index::empty_value<TValue>()) {
+                                output.emplace_back(static_cast<TId>((page << page_bits) + off), values[off]);
+                            }
+                        }
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(output.data()), sizeof(element_type) * output.size());
+                        output.clear();
+                    });
+                }
+
+            }; // class CompressedDenseMemArray
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompressedDenseMemArray, compressed_dense_mem_array)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_COMPRESSED_DENSE_MEM_ARRAY_HPP
@@ -0,0 +1,326 @@
+#ifndef OSMIUM_INDEX_MAP_COMPRESSED_SPARSE_MEM_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_COMPRESSED_SPARSE_MEM_ARRAY_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_COMPRESSED_SPARSE_MEM_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * Sparse index for node locations which stores the entries in
+             * compressed form in memory. The entries are put into blocks
+             * of up to 128 entries, in each block the IDs and the x and y
+             * coordinates are stored delta encoded as varints (coordinates
+             * zigzag encoded). A small index with the first ID of each block
+             * is used to find the right block in get(), then the block is
+             * decoded until the ID is found.
+             *
+             * For sorted input, which is what you usually have, entries are
+             * compressed while they are added. If the entries are added out
+             * of order they are kept uncompressed until sort() is called.
+             * As with all sparse indexes, you have to call sort() after
+             * adding all entries and before calling get().
+             *
+             * This needs usually only a third to a half of the memory of
+             * the SparseMemArray, but lookups are slower.
+             */
+            template <typename TId, typename TValue>
+            class CompressedSparseMemArray : public osmium::index::map::Map<TId, TValue> {
+
+                static_assert(std::is_same<TValue, osmium::Location>::value,
+                              "CompressedSparseMemArray only works with osmium::Location values");
+
+                enum : std::size_t {
+                    block_entries = 128
+                };
+
+                struct entry {
+                    TId id;
+                    TValue value;
+
+                    bool operator<(const entry& other) const noexcept {
+                        return id < other.id;
+                    }
+                };
+
+                struct block_info {
+                    TId first_id;
+                    std::size_t offset;
+                    int32_t first_x;
+                    int32_t first_y;
+                    uint32_t count;
+                };
+
+                std::vector<block_info> m_blocks{};
+                std::vector<unsigned char> m_data{};
+                std::vector<entry> m_pending{};
+                std::size_t m_size = 0;
+                TId m_last_id = 0;
+
+                // Set to false if entries were added out of order, no more
+                // entries are compressed until sort() is called.
+                bool m_compressible = true;
+
+                static uint64_t zigzag(const int64_t value) noexcept {
+                    return (static_cast<uint64_t>(value) << 1U) ^ static_cast<uint64_t>(value >> 63);
+                }
+
+                static int64_t unzigzag(const uint64_t value) noexcept {
+                    return static_cast<int64_t>(value >> 1U) ^ -static_cast<int64_t>(value & 1U);
+                }
+
+                void add_varint(uint64_t value) {
+                    while (value >= 0x80U) {
+                        m_data.push_back(static_cast<unsigned char>(value | 0x80U));
+                        value >>= 7U;
+                    }
+                    m_data.push_back(static_cast<unsigned char>(value));
+                }
+
+                static uint64_t get_varint(const unsigned char** data) noexcept {
+                    uint64_t value = 0;
+                    unsigned int shift = 0;
+                    while (**data & 0x80U) {
+                        value |= static_cast<uint64_t>(**data & 0x7fU) << shift;
+                        shift += 7;
+                        ++*data;
+                    }
+                    value |= static_cast<uint64_t>(**data) << shift;
+                    ++*data;
+                    return value;
+                }
+
+                void add_block(const entry* begin, const entry* end) {
+                    assert(begin != end);
+                    m_blocks.push_back(block_info{begin->id,
+                                                  m_data.size(),
+                                                  begin->value.x(),
+                                                  begin->value.y(),
+                                                  static_cast<uint32_t>(end - begin)});
+                    for (const entry* it = begin + 1; it != end; ++it) {
+                        const entry* prev = it - 1;
+                        add_varint(static_cast<uint64_t>(it->id - prev->id));
+                        add_varint(zigzag(static_cast<int64_t>(it->value.x()) - prev->value.x()));
+                        add_varint(zigzag(static_cast<int64_t>(it->value.y()) - prev->value.y()));
+                    }
+                }
+
+                void compress_pending() {
+                    if (!m_pending.empty()) {
+                        add_block(m_pending.data(), m_pending.data() + m_pending.size());
+                        m_pending.clear();
+                    }
+                }
+
+                template <typename TFunc>
+                void for_each_entry(TFunc&& func) const {
+                    for (const auto& block : m_blocks) {
+                        entry e{block.first_id, TValue{block.first_x, block.first_y}};
+                        func(e);
+                        const unsigned char* data = m_data.data() + block.offset;
+                        int64_t x = block.first_x;
+                        int64_t y = block.first_y;
+                        for (uint32_t n = 1; n < block.count; ++n) {
+                            e.id += static_cast<TId>(get_varint(&data));
+                            x += unzigzag(get_varint(&data));
+                            y += unzigzag(get_varint(&data));
+                            e.value = TValue{static_cast<int32_t>(x), static_cast<int32_t>(y)};
+                            func(e);
+                        }
+                    }
+                    for (const auto& e : m_pending) {
+                        func(e);
+                    }
+                }
+
+                TValue find_in_blocks(const TId id) const noexcept {
+                    auto it = std::upper_bound(m_blocks.begin(), m_blocks.end(), id, [](const TId i, const block_info& block) {
+                        return i < block.first_id;
+                    });
+                    if (it == m_blocks.begin()) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    --it;
+
+                    TId current_id = it->first_id;
+                    int64_t x = it->first_x;
+                    int64_t y = it->first_y;
+                    const unsigned char* data = m_data.data() + it->offset;
+                    for (uint32_t n = 1; current_id < id && n < it->count; ++n) {
+                        current_id += static_cast<TId>(get_varint(&data));
+                        x += unzigzag(get_varint(&data));
+                        y += unzigzag(get_varint(&data));
+                    }
+
+                    if (current_id != id) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return TValue{static_cast<int32_t>(x), static_cast<int32_t>(y)};
+                }
+
+            public:
+
+                CompressedSparseMemArray() = default;
+
+                ~CompressedSparseMemArray() noexcept override = default;
+
+                void set(const TId id, const TValue value) final {
+                    if (m_size > 0 && id < m_last_id) {
+                        m_compressible = false;
+                    }
+                    m_last_id = id;
+                    m_pending.push_back(entry{id, value});
+                    ++m_size;
+                    if (m_compressible && m_pending.size() == block_entries) {
+                        compress_pending();
+                    }
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    const TValue value = find_in_blocks(id);
+                    if (value != osmium::index::empty_value<TValue>()) {
+                        return value;
+                    }
+                    for (const auto& e : m_pending) {
+                        if (e.id == id) {
+                            return e.value;
+                        }
+                    }
+                    return osmium::index::empty_value<TValue>();
+                }
+
+                TValue get(const TId id) const final {
+                    const auto value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                std::size_t size() const final {
+                    return m_size;
+                }
+
+                std::size_t used_memory() const final {
+                    return sizeof(CompressedSparseMemArray) +
+                           m_blocks.capacity() * sizeof(block_info) +
+                           m_data.capacity() +
+                           m_pending.capacity() * sizeof(entry);
+                }
+
+                void clear() final {
+                    m_blocks.clear();
+                    m_blocks.shrink_to_fit();
+                    m_data.clear();
+                    m_data.shrink_to_fit();
+                    m_pending.clear();
+                    m_pending.shrink_to_fit();
+                    m_size = 0;
+                    m_last_id = 0;
+                    m_compressible = true;
+                }
+
+                void sort() final {
+                    if (!m_compressible) {
+                        std::vector<entry> entries;
+                        entries.reserve(m_size);
+                        for_each_entry([&entries](const entry& e) {
+                            entries.push_back(e);
+                        });
+                        std::stable_sort(entries.begin(), entries.end());
+
+                        m_blocks.clear();
+                        m_data.clear();
+                        m_pending.clear();
+                        for (std::size_t n = 0; n < entries.size(); n += block_entries) {
+                            add_block(entries.data() + n, entries.data() + std::min(entries.size(), n + block_entries));
+                        }
+                        m_compressible = true;
+                        if (!entries.empty()) {
+                            m_last_id = entries.back().id;
+                        }
+                    }
+
+                    compress_pending();
+                    m_blocks.shrink_to_fit();
+                    m_data.shrink_to_fit();
+                    m_pending.shrink_to_fit();
+                }
+
+                void dump_as_list(const int fd) final {
+                    using element_type = std::pair<TId, TValue>;
+                    std::vector<element_type> output;
+                    output.reserve(block_entries * 64);
+                    for_each_entry([&output, fd](const entry& e) {
+                        output.emplace_back(e.id, e.value);
+                        if (output.size() == output.capacity()) {
+                            osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(output.data()), output.size() * sizeof(element_type));
+                            output.clear();
+                        }
+                    });
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(output.data()), output.size() * sizeof(element_type));
+                }
+
+            }; // class CompressedSparseMemArray
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompressedSparseMemArray, compressed_sparse_mem_array)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_COMPRESSED_SPARSE_MEM_ARRAY_HPP
@@ -0,0 +1,434 @@
+#ifndef OSMIUM_INDEX_MAP_SHARED_MEMORY_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_SHARED_MEMORY_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef _WIN32
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            namespace detail {
+
+                enum : std::size_t {
+                    shared_memory_magic_size = 16,
+                    shared_memory_header_size = 64
+                };
+
+                inline const char* shared_memory_array_magic() noexcept {
+                    return "osmium-shm-arr1";
+                }
+
+                /**
+                 * The control object in shared memory. It only contains
+                 * the current generation of the data.
+                 */
+                struct shared_memory_control {
+                    char magic[shared_memory_magic_size];
+                    std::atomic<uint32_t> generation;
+                };
+
+                /**
+                 * The header at the start of the data object of each
+                 * generation. The values follow after it.
+                 */
+                struct shared_memory_header {
+                    char magic[shared_memory_magic_size];
+                    uint64_t value_size;
+                    uint64_t num_values;
+                    uint32_t generation;
+                };
+
+                static_assert(sizeof(shared_memory_header) <= shared_memory_header_size, "shared memory header too large");
+
+                inline std::string shared_memory_generation_name(const std::string& name, uint32_t generation) {
+                    return name + '.' + std::to_string(generation);
+                }
+
+                inline int open_shared_memory(const std::string& name, int flags) {
+                    const int fd = ::shm_open(name.c_str(), flags, 0644); // NOLINT(hicpp-signed-bitwise)
+                    if (fd == -1) {
+                        throw std::system_error{errno, std::system_category(), "can't open shared memory '" + name + "'"};
+                    }
+                    return fd;
+                }
+
+                /**
+                 * Shared mapping of the control object. It is always
+                 * mapped shared, so that the generation written by the
+                 * publisher is seen by all processes.
+                 */
+                class shared_memory_control_mapping {
+
+                    shared_memory_control* m_control = nullptr;
+
+                public:
+
+                    shared_memory_control_mapping(const std::string& name, bool writable) {
+                        const int fd = open_shared_memory(name, writable ? (O_CREAT | O_RDWR) : O_RDONLY); // NOLINT(hicpp-signed-bitwise)
+                        if (writable && osmium::file_size(fd) < sizeof(shared_memory_control)) {
+                            osmium::resize_file(fd, sizeof(shared_memory_control));
+                        }
+                        if (osmium::file_size(fd) < sizeof(shared_memory_control)) {
+                            ::close(fd);
+                            throw std::runtime_error{"shared memory '" + name + "' is not an osmium shared memory array"};
+                        }
+                        void* addr = ::mmap(nullptr, sizeof(shared_memory_control), writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0); // NOLINT(hicpp-signed-bitwise)
+                        const int mmap_errno = errno;
+                        ::close(fd);
+                        if (addr == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+                            throw std::system_error{mmap_errno, std::system_category(), "mmap of shared memory '" + name + "' failed"};
+                        }
+                        m_control = static_cast<shared_memory_control*>(addr);
+
+                        // A newly created control object is all zeros.
+                        if (writable && m_control->magic[0] == '\0') {
+                            std::strncpy(m_control->magic, shared_memory_array_magic(), shared_memory_magic_size);
+                        }
+                        if (std::strncmp(m_control->magic, shared_memory_array_magic(), shared_memory_magic_size) != 0) {
+                            ::munmap(m_control, sizeof(shared_memory_control));
+                            throw std::runtime_error{"shared memory '" + name + "' is not an osmium shared memory array"};
+                        }
+                    }
+
+                    shared_memory_control_mapping(const shared_memory_control_mapping&) = delete;
+                    shared_memory_control_mapping& operator=(const shared_memory_control_mapping&) = delete;
+
+                    shared_memory_control_mapping(shared_memory_control_mapping&&) = delete;
+                    shared_memory_control_mapping& operator=(shared_memory_control_mapping&&) = delete;
+
+                    ~shared_memory_control_mapping() noexcept {
+                        ::munmap(m_control, sizeof(shared_memory_control));
+                    }
+
+                    uint32_t generation() const noexcept {
+                        return m_control->generation.load(std::memory_order_acquire);
+                    }
+
+                    void set_generation(uint32_t generation) noexcept {
+                        m_control->generation.store(generation, std::memory_order_release);
+                    }
+
+                }; // class shared_memory_control_mapping
+
+            } // namespace detail
+
+            /**
+             * Write the contents of a map as a dense array into named
+             * POSIX shared memory (see shm_open(3)) so that any number of
+             * processes can attach to it with SharedMemoryArray without
+             * loading or copying anything.
+             *
+             * Each call publishes a new generation of the data: The data
+             * is written into a new shared memory object called
+             * "<name>.<generation>", then the generation number in the
+             * control object "<name>" is switched atomically. Processes
+             * attaching after that see the new data, processes already
+             * attached keep the old data until they call
+             * SharedMemoryArray::update(). The object of the previous
+             * generation is removed, its memory is freed when the last
+             * process unmaps it.
+             *
+             * Only one process may publish under the same name at the same
+             * time.
+             *
+             * The map must support dump_as_array(). Maps which are
+             * compressed in memory (CompressedDenseMemArray) are
+             * published uncompressed, because their internal structures
+             * can't be shared between processes.
+             *
+             * @param name Name of the shared memory. Must start with a
+             *             slash and must not contain any other slashes.
+             * @param map The map with the data.
+             * @returns The generation of the published data.
+             * @throws std::system_error If shared memory can't be used.
+             * @throws std::runtime_error If the name is used for something
+             *         else or the map can't be dumped as array.
+             */
+            template <typename TId, typename TValue>
+            uint32_t publish_shared_memory_array(const std::string& name, Map<TId, TValue>& map) {
+                detail::shared_memory_control_mapping control{name, true};
+                const uint32_t old_generation = control.generation();
+                const uint32_t generation = old_generation + 1;
+                const std::string data_name = detail::shared_memory_generation_name(name, generation);
+
+                // There might be a leftover from a publisher that crashed.
+                ::shm_unlink(data_name.c_str());
+                const int fd = detail::open_shared_memory(data_name, O_CREAT | O_EXCL | O_RDWR); // NOLINT(hicpp-signed-bitwise)
+                try {
+                    const char header_space[detail::shared_memory_header_size] = {};
+                    osmium::io::detail::reliable_write(fd, header_space, sizeof(header_space));
+                    map.dump_as_array(fd);
+
+                    const auto size = osmium::file_size(fd) - detail::shared_memory_header_size;
+                    if (size % sizeof(TValue) != 0) {
+                        throw std::runtime_error{"shared memory array has wrong size"};
+                    }
+
+                    detail::shared_memory_header header{};
+                    std::strncpy(header.magic, detail::shared_memory_array_magic(), detail::shared_memory_magic_size);
+                    header.value_size = sizeof(TValue);
+                    header.num_values = size / sizeof(TValue);
+                    header.generation = generation;
+                    if (::lseek(fd, 0, SEEK_SET) != 0) {
+                        throw std::system_error{errno, std::system_category(), "lseek failed"};
+                    }
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&header), sizeof(header));
+                } catch (...) {
+                    ::close(fd);
+                    ::shm_unlink(data_name.c_str());
+                    throw;
+                }
+                osmium::io::detail::reliable_close(fd);
+
+                control.set_generation(generation);
+
+                if (old_generation != 0) {
+                    ::shm_unlink(detail::shared_memory_generation_name(name, old_generation).c_str());
+                }
+
+                return generation;
+            }
+
+            /**
+             * Remove the shared memory objects of a shared memory array.
+             * Processes still attached to it can use the data until they
+             * detach. Nothing happens if there is no array with this
+             * name.
+             */
+            inline void remove_shared_memory_array(const std::string& name) {
+                try {
+                    const detail::shared_memory_control_mapping control{name, false};
+                    ::shm_unlink(detail::shared_memory_generation_name(name, control.generation()).c_str());
+                } catch (const std::system_error&) {
+                    return;
+                }
+                ::shm_unlink(name.c_str());
+            }
+
+            /**
+             * Read-only dense map attached to an array published into
+             * named shared memory with publish_shared_memory_array(). The
+             * data is mapped, not copied, so attaching takes no time and
+             * all processes on a host share the same memory.
+             *
+             * set() throws a std::runtime_error. The map doesn't have a
+             * create_map specialization and isn't registered with the
+             * map factory because it can't be filled like the other maps.
+             */
+            template <typename TId, typename TValue>
+            class SharedMemoryArray : public Map<TId, TValue> {
+
+                std::string m_name;
+                osmium::util::mapping_options m_options;
+                std::unique_ptr<osmium::util::MemoryMapping> m_mapping;
+                const TValue* m_values = nullptr;
+                std::size_t m_size = 0;
+                uint32_t m_generation = 0;
+
+                void attach(uint32_t generation) {
+                    const std::string data_name = detail::shared_memory_generation_name(m_name, generation);
+                    const int fd = detail::open_shared_memory(data_name, O_RDONLY);
+                    try {
+                        const auto size = osmium::file_size(fd);
+                        if (size < detail::shared_memory_header_size) {
+                            throw std::runtime_error{"shared memory '" + data_name + "' is too small"};
+                        }
+                        std::unique_ptr<osmium::util::MemoryMapping> mapping{new osmium::util::MemoryMapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, fd, 0, m_options}};
+                        const auto* header = mapping->get_addr<const detail::shared_memory_header>();
+                        if (std::strncmp(header->magic, detail::shared_memory_array_magic(), detail::shared_memory_magic_size) != 0 ||
+                            header->value_size != sizeof(TValue) ||
+                            header->num_values != (size - detail::shared_memory_header_size) / sizeof(TValue)) {
+                            throw std::runtime_error{"shared memory '" + data_name + "' has the wrong format"};
+                        }
+                        m_size = static_cast<std::size_t>(header->num_values);
+                        m_values = reinterpret_cast<const TValue*>(mapping->get_addr<const char>() + detail::shared_memory_header_size);
+                        m_mapping = std::move(mapping);
+                        m_generation = generation;
+                    } catch (...) {
+                        ::close(fd);
+                        throw;
+                    }
+                    ::close(fd);
+                }
+
+                void attach_current() {
+                    // The publisher removes the previous generation right
+                    // after publishing a new one, so the generation read
+                    // might already be gone. Then there is a newer one.
+                    for (int tries = 0;; ++tries) {
+                        const uint32_t generation = current_generation();
+                        if (generation == 0) {
+                            throw std::runtime_error{"shared memory array '" + m_name + "' has no data"};
+                        }
+                        try {
+                            attach(generation);
+                            return;
+                        } catch (const std::system_error& e) {
+                            if (e.code().value() != ENOENT || tries >= 10) {
+                                throw;
+                            }
+                        }
+                    }
+                }
+
+            public:
+
+                /**
+                 * Attach to the current generation of the shared memory
+                 * array with the given name.
+                 *
+                 * @param name Name used with publish_shared_memory_array().
+                 * @param options Memory mapping options. With "populate"
+                 *        all pages are mapped in immediately.
+                 * @throws std::system_error If the shared memory doesn't
+                 *         exist or can't be mapped.
+                 * @throws std::runtime_error If the shared memory has the
+                 *         wrong format or no data was published yet.
+                 */
+                explicit SharedMemoryArray(const std::string& name, const osmium::util::mapping_options& options = osmium::util::mapping_options{}) :
+                    m_name(name),
+                    m_options(options) {
+                    attach_current();
+                }
+
+                SharedMemoryArray(const SharedMemoryArray&) = delete;
+                SharedMemoryArray& operator=(const SharedMemoryArray&) = delete;
+
+                SharedMemoryArray(SharedMemoryArray&&) = default;
+                SharedMemoryArray& operator=(SharedMemoryArray&&) = default;
+
+                ~SharedMemoryArray() noexcept override = default;
+
+                /// The generation of the data this map is attached to.
+                uint32_t generation() const noexcept {
+                    return m_generation;
+                }
+
+                /// The newest published generation.
+                uint32_t current_generation() const {
+                    const detail::shared_memory_control_mapping control{m_name, false};
+                    return control.generation();
+                }
+
+                /**
+                 * Attach to the newest generation if there is a newer one
+                 * than the one this map is attached to. No other thread may
+                 * use the map while this is called.
+                 *
+                 * @returns true if the map now has newer data.
+                 */
+                bool update() {
+                    if (current_generation() == m_generation) {
+                        return false;
+                    }
+                    attach_current();
+                    return true;
+                }
+
+                void set(const TId /*id*/, const TValue /*value*/) final {
+                    throw std::runtime_error{"SharedMemoryArray is read-only"};
+                }
+
+                TValue get(const TId id) const final {
+                    if (id >= m_size) {
+                        throw osmium::not_found{id};
+                    }
+                    const TValue value = m_values[id];
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    if (id >= m_size) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return m_values[id];
+                }
+
+                std::size_t size() const final {
+                    return m_size;
+                }
+
+                std::size_t used_memory() const final {
+                    return m_mapping ? m_mapping->size() : 0;
+                }
+
+                /// Detach from the shared memory.
+                void clear() final {
+                    m_mapping.reset();
+                    m_values = nullptr;
+                    m_size = 0;
+                }
+
+                void dump_as_array(const int fd) final {
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_values), m_size * sizeof(TValue));
+                }
+
+            }; // class SharedMemoryArray
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // _WIN32
+
+#endif // OSMIUM_INDEX_MAP_SHARED_MEMORY_ARRAY_HPP
@@ -0,0 +1,254 @@
+#ifndef OSMIUM_INDEX_MAP_SPARSE_MEM_MAP_FLAT_HPP
+#define OSMIUM_INDEX_MAP_SPARSE_MEM_MAP_FLAT_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_SPARSE_MEM_MAP_FLAT
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * This implementation uses a hash table with open addressing
+             * and Robin Hood probing. All entries are stored in one flat
+             * array, so there is no allocation per entry and a lookup
+             * usually touches only one or two cache lines. Ids can be set
+             * in any order.
+             *
+             * It needs about sizeof(TId) + sizeof(TValue) + 1 bytes per
+             * slot and is never filled more than 7/8, so this is much
+             * smaller than SparseMemMap, but it is still bigger than the
+             * SparseMemArray. Use it for small sets of unsorted ids.
+             */
+            template <typename TId, typename TValue>
+            class SparseMemMapFlat : public osmium::index::map::Map<TId, TValue> {
+
+                struct slot {
+                    TId id;
+                    TValue value;
+                };
+
+                enum : std::size_t {
+                    min_capacity = 16
+                };
+
+                // Probe distances are stored plus one, zero marks an empty
+                // slot. If a distance would not fit, the table is grown.
+                enum : uint8_t {
+                    max_distance = 255
+                };
+
+                std::vector<slot> m_slots;
+                std::vector<uint8_t> m_distances;
+                std::size_t m_size = 0;
+                std::size_t m_mask = 0;
+
+                std::size_t home(const TId id) const noexcept {
+                    // Fibonacci hashing spreads consecutive ids, the high
+                    // bits are folded in so that the mask sees them.
+                    uint64_t hash = static_cast<uint64_t>(id) * 0x9e3779b97f4a7c15ULL;
+                    hash ^= hash >> 32U;
+                    return static_cast<std::size_t>(hash) & m_mask;
+                }
+
+                std::size_t capacity() const noexcept {
+                    return m_slots.size();
+                }
+
+                bool needs_grow() const noexcept {
+                    return capacity() == 0 || (m_size + 1) * 8 > capacity() * 7;
+                }
+
+                const slot* find(const TId id) const noexcept {
+                    if (m_size == 0) {
+                        return nullptr;
+                    }
+                    std::size_t pos = home(id);
+                    for (unsigned int distance = 1;; ++distance) {
+                        // An entry further along would have displaced the
+                        // current one, so it can't be in the table.
+                        if (m_distances[pos] < distance) {
+                            return nullptr;
+                        }
+                        if (m_slots[pos].id == id) {
+                            return &m_slots[pos];
+                        }
+                        pos = (pos + 1) & m_mask;
+                    }
+                }
+
+                void rehash(const std::size_t new_capacity) {
+                    std::vector<slot> old_slots;
+                    std::vector<uint8_t> old_distances;
+                    using std::swap;
+                    swap(old_slots, m_slots);
+                    swap(old_distances, m_distances);
+
+                    m_slots.resize(new_capacity);
+                    m_distances.assign(new_capacity, 0);
+                    m_mask = new_capacity - 1;
+                    m_size = 0;
+
+                    for (std::size_t i = 0; i < old_slots.size(); ++i) {
+                        if (old_distances[i] != 0) {
+                            insert(old_slots[i]);
+                        }
+                    }
+                }
+
+                void insert(slot entry) {
+                    std::size_t pos = home(entry.id);
+                    uint8_t distance = 1;
+                    while (true) {
+                        if (m_distances[pos] == 0) {
+                            m_slots[pos] = entry;
+                            m_distances[pos] = distance;
+                            ++m_size;
+                            return;
+                        }
+                        if (m_distances[pos] == distance && m_slots[pos].id == entry.id) {
+                            m_slots[pos].value = entry.value;
+                            return;
+                        }
+                        if (m_distances[pos] < distance) {
+                            // Robin Hood: take the slot from the entry that
+                            // is closer to its home and move that one on.
+                            using std::swap;
+                            swap(m_slots[pos], entry);
+                            swap(m_distances[pos], distance);
+                        }
+                        pos = (pos + 1) & m_mask;
+                        if (++distance == max_distance) {
+                            rehash(capacity() * 2);
+                            insert(entry);
+                            return;
+                        }
+                    }
+                }
+
+            public:
+
+                SparseMemMapFlat() = default;
+
+                void reserve(const std::size_t size) final {
+                    std::size_t new_capacity = min_capacity;
+                    while (new_capacity * 7 < size * 8) {
+                        new_capacity *= 2;
+                    }
+                    if (new_capacity > capacity()) {
+                        rehash(new_capacity);
+                    }
+                }
+
+                void set(const TId id, const TValue value) final {
+                    if (needs_grow()) {
+                        rehash(capacity() == 0 ? std::size_t(min_capacity) : capacity() * 2);
+                    }
+                    insert(slot{id, value});
+                }
+
+                TValue get(const TId id) const final {
+                    const slot* s = find(id);
+                    if (!s) {
+                        throw osmium::not_found{id};
+                    }
+                    return s->value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    const slot* s = find(id);
+                    if (!s) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return s->value;
+                }
+
+                std::size_t size() const noexcept final {
+                    return m_size;
+                }
+
+                std::size_t used_memory() const noexcept final {
+                    return capacity() * (sizeof(slot) + sizeof(uint8_t));
+                }
+
+                void clear() final {
+                    m_slots.clear();
+                    m_slots.shrink_to_fit();
+                    m_distances.clear();
+                    m_distances.shrink_to_fit();
+                    m_size = 0;
+                    m_mask = 0;
+                }
+
+                void dump_as_list(const int fd) final {
+                    using t = std::pair<TId, TValue>;
+                    std::vector<t> v;
+                    v.reserve(m_size);
+                    for (std::size_t i = 0; i < m_slots.size(); ++i) {
+                        if (m_distances[i] != 0) {
+                            v.emplace_back(m_slots[i].id, m_slots[i].value);
+                        }
+                    }
+                    std::sort(v.begin(), v.end(), [](const t& a, const t& b) {
+                        return a.first < b.first;
+                    });
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(v.data()), sizeof(t) * v.size());
+                }
+
+            }; // class SparseMemMapFlat
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseMemMapFlat, sparse_mem_map_flat)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_SPARSE_MEM_MAP_FLAT_HPP
@@ -35,9 +35,13 @@ DEALINGS IN THE SOFTWARE.
 
 #ifdef __linux__
 
+#include <osmium/index/detail/create_map_with_fd.hpp>
 #include <osmium/index/detail/mmap_vector_anon.hpp>
 #include <osmium/index/detail/vector_map.hpp>
 
+#include <string>
+#include <vector>
+
 #define OSMIUM_HAS_INDEX_MAP_SPARSE_MMAP_ARRAY
 
 namespace osmium {
@@ -49,6 +53,13 @@ namespace osmium {
             template <typename TId, typename TValue>
             using SparseMmapArray = VectorBasedSparseMap<TId, TValue, osmium::detail::mmap_vector_anon>;
 
+            template <typename TId, typename TValue>
+            struct create_map<TId, TValue, SparseMmapArray> {
+                SparseMmapArray<TId, TValue>* operator()(const std::vector<std::string>& config) {
+                    return osmium::index::detail::create_map_with_options<SparseMmapArray<TId, TValue>>(config);
+                }
+            };
+
         } // namespace map
 
     } // namespace index
@@ -0,0 +1,507 @@
+#ifndef OSMIUM_INDEX_MAP_TIERED_DENSE_FILE_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_TIERED_DENSE_FILE_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef _WIN32
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/misc.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_TIERED_DENSE_FILE_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * Counters for the page cache of a TieredDenseFileArray.
+             */
+            struct tiered_map_stats {
+
+                /// Lookups and updates that found their page in memory.
+                uint64_t hits = 0;
+
+                /// Lookups and updates that had to bring a page into memory.
+                uint64_t misses = 0;
+
+                /// Pages removed from memory to make room for others.
+                uint64_t evictions = 0;
+
+                /// Modified pages written to the file.
+                uint64_t writebacks = 0;
+
+                /// Fraction of accesses served from memory (0 if none).
+                double hit_rate() const noexcept {
+                    const auto accesses = hits + misses;
+                    return accesses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(accesses);
+                }
+
+            }; // struct tiered_map_stats
+
+            /**
+             * A dense index stored in a file with a page cache of limited
+             * size in front of it. Unlike DenseFileArray, which maps the
+             * whole file into memory and leaves it to the kernel which
+             * parts stay resident, this map keeps at most memory_budget
+             * bytes of the index in memory and does its own reads and
+             * writes.
+             *
+             * The file is divided into pages of page_size values. Pages
+             * are evicted using the GCLOCK algorithm: Every page has a
+             * small usage counter which is incremented on each access and
+             * decremented when the clock hand passes over it, a page is
+             * only evicted when its counter has reached zero. Pages used
+             * over and over again, like those containing the nodes of the
+             * region currently being worked on, stay in memory, while
+             * pages touched only once are evicted quickly. This works much
+             * better than the kernel's page cache for way processing on
+             * machines which can't hold the whole index in memory.
+             *
+             * The file format is the same as that of DenseFileArray,
+             * existing files can be used with both.
+             *
+             * Reading from this map changes the cache state, so it must
+             * not be used from several threads at the same time, not even
+             * for reading. Not available on Windows.
+             */
+            template <typename TId, typename TValue>
+            class TieredDenseFileArray : public osmium::index::map::Map<TId, TValue> {
+
+            public:
+
+                enum : std::size_t {
+                    /// Number of values in one page.
+                    page_size = 8192,
+
+                    /// Default for the memory budget (256 MByte).
+                    default_memory_budget = 256UL * 1024UL * 1024UL
+                };
+
+            private:
+
+                enum : std::size_t {
+                    page_bytes = page_size * sizeof(TValue),
+                    not_resident = 0
+                };
+
+                enum : uint8_t {
+                    max_usage = 3
+                };
+
+                struct frame {
+                    std::unique_ptr<TValue[]> data{new TValue[page_size]};
+                    std::size_t page = 0;
+                    uint8_t usage = 0;
+                    bool dirty = false;
+                };
+
+                int m_fd;
+                bool m_close_fd;
+
+                // Number of values (ids) in the index.
+                std::size_t m_size;
+
+                // Number of pages in the file. All pages before this are
+                // complete (except possibly the last one of a file created
+                // elsewhere), everything after it is empty.
+                mutable std::size_t m_file_pages;
+
+                std::size_t m_max_frames;
+
+                mutable std::vector<frame> m_frames{};
+
+                // Index into m_frames + 1 for each page, not_resident for
+                // pages not in memory.
+                mutable std::vector<std::size_t> m_page_table{};
+
+                mutable std::size_t m_clock_hand = 0;
+
+                mutable tiered_map_stats m_stats{};
+
+                static std::size_t values_in_file(const int fd) {
+                    const auto size = osmium::file_size(fd);
+                    if (size % sizeof(TValue) != 0) {
+                        throw std::runtime_error{"Index file has wrong size (must be multiple of " + std::to_string(sizeof(TValue)) + ")."};
+                    }
+                    return size / sizeof(TValue);
+                }
+
+                static std::size_t frames_for_budget(const std::size_t memory_budget) noexcept {
+                    return std::max(static_cast<std::size_t>(1), memory_budget / page_bytes);
+                }
+
+                void write_page(const std::size_t page, const TValue* data) const {
+                    osmium::io::detail::reliable_pwrite(m_fd, reinterpret_cast<const char*>(data), page_bytes, page * page_bytes);
+                }
+
+                void read_page(const std::size_t page, TValue* data) const {
+                    std::fill_n(data, static_cast<std::size_t>(page_size), osmium::index::empty_value<TValue>());
+                    if (page < m_file_pages) {
+                        // The last page of a file written by DenseFileArray
+                        // can be incomplete, so EOF is fine here.
+                        osmium::io::detail::reliable_pread(m_fd, reinterpret_cast<char*>(data), page_bytes, page * page_bytes);
+                    }
+                }
+
+                void write_back(frame& f) const {
+                    if (f.page > m_file_pages) {
+                        // Fill the gap with empty pages, so that the file
+                        // can be read without knowing which pages exist.
+                        const std::unique_ptr<TValue[]> empty{new TValue[page_size]};
+                        std::fill_n(empty.get(), static_cast<std::size_t>(page_size), osmium::index::empty_value<TValue>());
+                        for (auto page = m_file_pages; page < f.page; ++page) {
+                            write_page(page, empty.get());
+                        }
+                    }
+                    write_page(f.page, f.data.get());
+                    f.dirty = false;
+                    ++m_stats.writebacks;
+                    m_file_pages = std::max(m_file_pages, f.page + 1);
+                }
+
+                void evict(frame& f) const {
+                    if (f.dirty) {
+                        write_back(f);
+                    }
+                    m_page_table[f.page] = not_resident;
+                    ++m_stats.evictions;
+                }
+
+                // Find a frame for a new page, either by allocating one or
+                // by evicting the page of another frame.
+                std::size_t free_frame() const {
+                    if (m_frames.size() < m_max_frames) {
+                        m_frames.emplace_back();
+                        return m_frames.size() - 1;
+                    }
+
+                    while (true) {
+                        if (m_clock_hand >= m_frames.size()) {
+                            m_clock_hand = 0;
+                        }
+                        frame& f = m_frames[m_clock_hand];
+                        if (f.usage == 0) {
+                            evict(f);
+                            return m_clock_hand++;
+                        }
+                        --f.usage;
+                        ++m_clock_hand;
+                    }
+                }
+
+                frame& frame_for_page(const std::size_t page) const {
+                    if (page < m_page_table.size() && m_page_table[page] != not_resident) {
+                        ++m_stats.hits;
+                        frame& f = m_frames[m_page_table[page] - 1];
+                        if (f.usage < max_usage) {
+                            ++f.usage;
+                        }
+                        return f;
+                    }
+
+                    ++m_stats.misses;
+                    const std::size_t n = free_frame();
+                    frame& f = m_frames[n];
+                    f.page = page;
+                    f.usage = 1;
+                    f.dirty = false;
+                    read_page(page, f.data.get());
+
+                    if (page >= m_page_table.size()) {
+                        m_page_table.resize(page + 1, not_resident);
+                    }
+                    m_page_table[page] = n + 1;
+
+                    return f;
+                }
+
+                TValue lookup(const TId id) const {
+                    const auto page = static_cast<std::size_t>(id) / page_size;
+                    if (id >= m_size || (page >= m_file_pages && (page >= m_page_table.size() || m_page_table[page] == not_resident))) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return frame_for_page(page).data[static_cast<std::size_t>(id) % page_size];
+                }
+
+            public:
+
+                /**
+                 * Create map backed by a temporary file.
+                 *
+                 * @param memory_budget Maximum number of bytes used for
+                 *        pages held in memory.
+                 */
+                explicit TieredDenseFileArray(const std::size_t memory_budget = default_memory_budget) :
+                    m_fd(osmium::detail::create_tmp_file()),
+                    m_close_fd(true),
+                    m_size(0),
+                    m_file_pages(0),
+                    m_max_frames(frames_for_budget(memory_budget)) {
+                }
+
+                /**
+                 * Create map backed by the given file. If the file already
+                 * contains data (for instance from a DenseFileArray), it is
+                 * used.
+                 *
+                 * @param fd File descriptor of the file opened for reading
+                 *        and writing.
+                 * @param memory_budget Maximum number of bytes used for
+                 *        pages held in memory.
+                 * @param close_fd Close the file descriptor when the map is
+                 *        destroyed.
+                 */
+                TieredDenseFileArray(const int fd, const std::size_t memory_budget, const bool close_fd = false) :
+                    m_fd(fd),
+                    m_close_fd(close_fd),
+                    m_size(values_in_file(fd)),
+                    m_file_pages((m_size + page_size - 1) / page_size),
+                    m_max_frames(frames_for_budget(memory_budget)) {
+                }
+
+                TieredDenseFileArray(const TieredDenseFileArray&) = delete;
+                TieredDenseFileArray& operator=(const TieredDenseFileArray&) = delete;
+
+                TieredDenseFileArray(TieredDenseFileArray&&) = delete;
+                TieredDenseFileArray& operator=(TieredDenseFileArray&&) = delete;
+
+                ~TieredDenseFileArray() noexcept override {
+                    try {
+                        flush();
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                    if (m_close_fd) {
+                        ::close(m_fd);
+                    }
+                }
+
+                void set(const TId id, const TValue value) final {
+                    const auto pos = static_cast<std::size_t>(id);
+                    if (m_size <= pos) {
+                        m_size = pos + 1;
+                    }
+                    frame& f = frame_for_page(pos / page_size);
+                    f.data[pos % page_size] = value;
+                    f.dirty = true;
+                }
+
+                TValue get(const TId id) const final {
+                    const TValue value = lookup(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    try {
+                        return lookup(id);
+                    } catch (...) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                }
+
+                std::size_t size() const final {
+                    return m_size;
+                }
+
+                /**
+                 * The size of the index on disk. Use resident_memory() to
+                 * find out how much memory is used for the pages in memory.
+                 */
+                std::size_t used_memory() const final {
+                    return sizeof(TValue) * m_size;
+                }
+
+                /// The number of bytes used by pages currently in memory.
+                std::size_t resident_memory() const noexcept {
+                    return m_frames.size() * page_bytes;
+                }
+
+                /// The maximum number of bytes used by pages in memory.
+                std::size_t memory_budget() const noexcept {
+                    return m_max_frames * page_bytes;
+                }
+
+                /**
+                 * Change the memory budget. If it is reduced, pages are
+                 * evicted until they fit into the new budget. The budget
+                 * is always at least one page.
+                 */
+                void set_memory_budget(const std::size_t memory_budget) {
+                    m_max_frames = frames_for_budget(memory_budget);
+                    while (m_frames.size() > m_max_frames) {
+                        evict(m_frames.back());
+                        m_frames.pop_back();
+                    }
+                    if (m_clock_hand >= m_frames.size()) {
+                        m_clock_hand = 0;
+                    }
+                }
+
+                /**
+                 * Write all modified pages to the file. The pages stay in
+                 * memory.
+                 */
+                void flush() {
+                    for (auto& f : m_frames) {
+                        if (f.dirty) {
+                            write_back(f);
+                        }
+                    }
+                }
+
+                /**
+                 * Write all modified pages to the file and remove all pages
+                 * from memory. Use this, for instance, between passes
+                 * over the data which have completely different access
+                 * patterns.
+                 */
+                void evict_all() {
+                    for (auto& f : m_frames) {
+                        evict(f);
+                    }
+                    m_frames.clear();
+                    m_frames.shrink_to_fit();
+                    m_clock_hand = 0;
+                }
+
+                /// Cache statistics since creation or last reset_stats().
+                const tiered_map_stats& stats() const noexcept {
+                    return m_stats;
+                }
+
+                void reset_stats() noexcept {
+                    m_stats = tiered_map_stats{};
+                }
+
+                void clear() final {
+                    m_frames.clear();
+                    m_frames.shrink_to_fit();
+                    m_page_table.clear();
+                    m_page_table.shrink_to_fit();
+                    m_clock_hand = 0;
+                    m_size = 0;
+                    m_file_pages = 0;
+                    osmium::resize_file(m_fd, 0);
+                }
+
+                /**
+                 * Write the index as array to the file. This does not
+                 * change which pages are held in memory and does not
+                 * change the statistics.
+                 */
+                void dump_as_array(const int fd) final {
+                    const std::unique_ptr<TValue[]> buffer{new TValue[page_size]};
+                    for (std::size_t page = 0; page * page_size < m_size; ++page) {
+                        const TValue* data = buffer.get();
+                        if (page < m_page_table.size() && m_page_table[page] != not_resident) {
+                            data = m_frames[m_page_table[page] - 1].data.get();
+                        } else {
+                            read_page(page, buffer.get());
+                        }
+                        const auto count = std::min(static_cast<std::size_t>(page_size), m_size - page * page_size);
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(data), count * sizeof(TValue));
+                    }
+                }
+
+            }; // class TieredDenseFileArray
+
+            /**
+             * Create a TieredDenseFileArray from a config of the form
+             * "tiered_dense_file_array[,FILENAME[,MBYTES]]". Without file
+             * name (or with an empty one) a temporary file is used. MBYTES
+             * is the memory budget in MBytes.
+             */
+            template <typename TId, typename TValue>
+            struct create_map<TId, TValue, TieredDenseFileArray> {
+                TieredDenseFileArray<TId, TValue>* operator()(const std::vector<std::string>& config) {
+                    if (config.size() > 3) {
+                        throw osmium::map_factory_error{"Too many options for tiered_dense_file_array map"};
+                    }
+
+                    std::size_t memory_budget = TieredDenseFileArray<TId, TValue>::default_memory_budget;
+                    if (config.size() == 3) {
+                        const auto mbytes = osmium::detail::str_to_int<std::size_t>(config[2].c_str());
+                        if (mbytes == 0) {
+                            throw osmium::map_factory_error{"Invalid memory budget '" + config[2] + "' for tiered_dense_file_array map"};
+                        }
+                        memory_budget = mbytes * 1024UL * 1024UL;
+                    }
+
+                    if (config.size() == 1 || config[1].empty()) {
+                        return new TieredDenseFileArray<TId, TValue>{memory_budget};
+                    }
+
+                    const std::string& filename = config[1];
+                    const int fd = ::open(filename.c_str(), O_CREAT | O_RDWR, 0644); // NOLINT(hicpp-signed-bitwise)
+                    if (fd == -1) {
+                        throw std::system_error{errno, std::system_category(), "can't open file '" + filename + "'"};
+                    }
+                    return new TieredDenseFileArray<TId, TValue>{fd, memory_budget, true};
+                }
+            };
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::TieredDenseFileArray, tiered_dense_file_array)
+#endif
+
+#endif // _WIN32
+
+#endif // OSMIUM_INDEX_MAP_TIERED_DENSE_FILE_ARRAY_HPP
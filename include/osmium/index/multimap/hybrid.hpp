@@ -35,8 +35,10 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/index/index.hpp>
 #include <osmium/index/multimap.hpp>
+#include <osmium/index/multimap/sparse_file_array.hpp>
 #include <osmium/index/multimap/sparse_mem_array.hpp>
 #include <osmium/index/multimap/sparse_mem_multimap.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <cstddef>
 #include <utility>
@@ -47,10 +49,10 @@ namespace osmium {
 
         namespace multimap {
 
-            template <typename TId, typename TValue>
+            template <typename TId, typename TValue, typename TMainMap = SparseMemArray<TId, TValue>>
             class HybridIterator {
 
-                using main_map_type  = SparseMemArray<TId, TValue>;
+                using main_map_type  = TMainMap;
                 using extra_map_type = SparseMemMultimap<TId, TValue>;
 
                 using element_type = typename std::pair<TId, TValue>;
@@ -60,6 +62,10 @@ namespace osmium {
                 typename extra_map_type::iterator m_begin_extra;
                 typename extra_map_type::iterator m_end_extra;
 
+                // The value type of the extra map has a const id, so
+                // elements from there are copied here.
+                element_type m_extra_element{};
+
             public:
 
                 HybridIterator(typename main_map_type::iterator begin_main,
@@ -86,7 +92,7 @@ namespace osmium {
                     return *this;
                 }
 
-                HybridIterator<TId, TValue> operator++(int) {
+                HybridIterator operator++(int) {
                     const auto tmp{*this};
                     operator++();
                     return tmp;
@@ -105,7 +111,8 @@ namespace osmium {
 
                 const element_type& operator*() {
                     if (m_begin_main == m_end_main) {
-                        return *m_begin_extra;
+                        m_extra_element = *m_begin_extra;
+                        return m_extra_element;
                     }
                     return *m_begin_main;
                 }
@@ -116,25 +123,68 @@ namespace osmium {
 
             }; // class HybridIterator
 
-            template <typename TId, typename TValue>
+            /**
+             * Multimap consisting of a main part, a sorted vector, and an
+             * extra part, a std::multimap, for elements added with set()
+             * after the main part was sorted. Elements can be added to
+             * the main part with unsorted_set() and unsorted_set_many(),
+             * they can only be found after the next sort() or
+             * consolidate().
+             *
+             * consolidate() moves the elements from the extra part into
+             * the main part. If the main part was sorted before, only the
+             * new elements are sorted and then merged with the old ones.
+             *
+             * @tparam TMainMap The map used for the main part. The default
+             *         keeps it in memory, use HybridFile for a main part
+             *         in a (temporary) file which can be larger than the
+             *         available memory.
+             */
+            template <typename TId, typename TValue, typename TMainMap = SparseMemArray<TId, TValue>>
             class Hybrid : public Multimap<TId, TValue> {
 
-                using main_map_type  = SparseMemArray<TId, TValue>;
+                using main_map_type  = TMainMap;
                 using extra_map_type = SparseMemMultimap<TId, TValue>;
 
                 main_map_type m_main;
                 extra_map_type m_extra;
 
+                // Are the elements in the main part sorted?
+                bool m_main_sorted = true;
+
+                // Remove elements marked as removed from the main part and
+                // append the elements of the extra part. Returns the number
+                // of elements at the beginning of the main part which are
+                // still sorted.
+                std::size_t move_extra_to_main() {
+                    m_main.erase_removed();
+                    const auto sorted_size = m_main_sorted ? m_main.size() : 0;
+                    m_main.unsorted_set_many(m_extra.begin(), m_extra.end());
+                    m_extra.clear();
+                    return sorted_size;
+                }
+
             public:
 
-                using iterator       = HybridIterator<TId, TValue>;
-                using const_iterator = const HybridIterator<TId, TValue>;
+                using iterator       = HybridIterator<TId, TValue, TMainMap>;
+                using const_iterator = const HybridIterator<TId, TValue, TMainMap>;
 
                 Hybrid() :
                     m_main(),
                     m_extra() {
                 }
 
+                /**
+                 * Create a Hybrid map with the main part in the file with
+                 * the given file descriptor. Only available if the main map
+                 * type is file based.
+                 */
+                explicit Hybrid(const int fd) :
+                    m_main(fd),
+                    m_extra(),
+                    m_main_sorted(m_main.size() == 0) {
+                }
+
                 ~Hybrid() noexcept = default;
 
                 size_t size() const final {
@@ -151,6 +201,19 @@ namespace osmium {
 
                 void unsorted_set(const TId id, const TValue value) {
                     m_main.set(id, value);
+                    m_main_sorted = false;
+                }
+
+                /**
+                 * Add all (id, value) pairs in the range [first, last) to
+                 * the main part in one go. Much faster than calling set()
+                 * for each of them, but, like with unsorted_set(), they can
+                 * only be found after the next consolidate() or sort().
+                 */
+                template <typename TIterator>
+                void unsorted_set_many(TIterator first, TIterator last) {
+                    m_main.unsorted_set_many(first, last);
+                    m_main_sorted = false;
                 }
 
                 void set(const TId id, const TValue value) final {
@@ -169,13 +232,25 @@ namespace osmium {
                     m_extra.remove(id, value);
                 }
 
+                /**
+                 * Move all elements from the extra part into the main part
+                 * and remove elements marked as removed. Afterwards the
+                 * main part is sorted.
+                 */
                 void consolidate() {
-                    m_main.erase_removed();
-                    for (const auto& element : m_extra) {
-                        m_main.set(element.first, element.second);
-                    }
-                    m_extra.clear();
-                    m_main.sort();
+                    const auto sorted_size = move_extra_to_main();
+                    m_main.sort_appended(sorted_size);
+                    m_main_sorted = true;
+                }
+
+                /**
+                 * Like consolidate(), but sorting is done with the threads
+                 * in the pool.
+                 */
+                void consolidate(osmium::thread::Pool& pool) {
+                    const auto sorted_size = move_extra_to_main();
+                    m_main.sort_appended(sorted_size, pool);
+                    m_main_sorted = true;
                 }
 
                 void dump_as_list(const int fd) final {
@@ -186,14 +261,30 @@ namespace osmium {
                 void clear() final {
                     m_main.clear();
                     m_extra.clear();
+                    m_main_sorted = true;
                 }
 
                 void sort() final {
                     m_main.sort();
+                    m_main_sorted = true;
+                }
+
+                /**
+                 * Sort the main part with the threads in the pool.
+                 */
+                void sort(osmium::thread::Pool& pool) {
+                    m_main.sort(pool);
+                    m_main_sorted = true;
                 }
 
             }; // class Hybrid
 
+            /**
+             * Hybrid multimap with the main part in a memory mapped file.
+             */
+            template <typename TId, typename TValue>
+            using HybridFile = Hybrid<TId, TValue, SparseFileArray<TId, TValue>>;
+
         } // namespace multimap
 
     } // namespace index
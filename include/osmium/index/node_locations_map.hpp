@@ -39,6 +39,14 @@ DEALINGS IN THE SOFTWARE.
 
 #define OSMIUM_WANT_NODE_LOCATION_MAPS
 
+#ifdef OSMIUM_HAS_INDEX_MAP_COMPRESSED_DENSE_MEM_ARRAY
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompressedDenseMemArray, compressed_dense_mem_array)
+#endif
+
+#ifdef OSMIUM_HAS_INDEX_MAP_COMPRESSED_SPARSE_MEM_ARRAY
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompressedSparseMemArray, compressed_sparse_mem_array)
+#endif
+
 #ifdef OSMIUM_HAS_INDEX_MAP_DENSE_FILE_ARRAY
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseFileArray, dense_file_array)
 #endif
@@ -63,6 +71,10 @@ DEALINGS IN THE SOFTWARE.
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseMemMap, sparse_mem_map)
 #endif
 
+#ifdef OSMIUM_HAS_INDEX_MAP_SPARSE_MEM_MAP_FLAT
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseMemMapFlat, sparse_mem_map_flat)
+#endif
+
 #ifdef OSMIUM_HAS_INDEX_MAP_SPARSE_MEM_TABLE
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseMemTable, sparse_mem_table)
 #endif
@@ -71,6 +83,10 @@ DEALINGS IN THE SOFTWARE.
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseMmapArray, sparse_mmap_array)
 #endif
 
+#ifdef OSMIUM_HAS_INDEX_MAP_TIERED_DENSE_FILE_ARRAY
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::TieredDenseFileArray, tiered_dense_file_array)
+#endif
+
 #ifdef OSMIUM_HAS_INDEX_MAP_FLEX_MEM
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::FlexMem, flex_mem)
 #endif
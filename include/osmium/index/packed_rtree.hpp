@@ -0,0 +1,645 @@
+#ifndef OSMIUM_INDEX_PACKED_RTREE_HPP
+#define OSMIUM_INDEX_PACKED_RTREE_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/hilbert.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/object_pointer_collection.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
+#include <osmium/util/compatibility.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when a packed R-tree file can not be loaded.
+     */
+    struct OSMIUM_EXPORT rtree_error : public std::runtime_error {
+
+        explicit rtree_error(const std::string& what) :
+            std::runtime_error(what) {
+        }
+
+        explicit rtree_error(const char* what) :
+            std::runtime_error(what) {
+        }
+
+    }; // struct rtree_error
+
+    namespace index {
+
+        namespace detail {
+
+            enum : std::size_t {
+                rtree_items_per_task = 10000
+            };
+
+            /**
+             * Bounding box of an R-tree node in the internal integer
+             * coordinates of osmium::Location.
+             */
+            struct rtree_box {
+
+                int32_t min_x;
+                int32_t min_y;
+                int32_t max_x;
+                int32_t max_y;
+
+                bool intersects(const rtree_box& other) const noexcept {
+                    return min_x <= other.max_x && max_x >= other.min_x &&
+                           min_y <= other.max_y && max_y >= other.min_y;
+                }
+
+                void extend(const rtree_box& other) noexcept {
+                    min_x = std::min(min_x, other.min_x);
+                    min_y = std::min(min_y, other.min_y);
+                    max_x = std::max(max_x, other.max_x);
+                    max_y = std::max(max_y, other.max_y);
+                }
+
+            }; // struct rtree_box
+
+            static_assert(sizeof(rtree_box) == 16, "Unexpected size of rtree_box");
+
+            inline rtree_box make_rtree_box(const osmium::Box& box) noexcept {
+                return rtree_box{box.bottom_left().x(), box.bottom_left().y(),
+                                 box.top_right().x(), box.top_right().y()};
+            }
+
+            /**
+             * Header of the file format written by PackedRTree::dump().
+             * It is followed by the boxes and values of all nodes.
+             */
+            struct rtree_header {
+
+                char magic[8];
+                uint32_t version;
+                uint32_t node_size;
+                uint64_t num_items;
+                uint64_t num_nodes;
+
+            }; // struct rtree_header
+
+            static_assert(sizeof(rtree_header) == 32, "Unexpected size of rtree_header");
+
+            constexpr const char rtree_magic[8] = {'O', 'S', 'M', 'R', 'T', 'R', 'E', 'E'};
+            constexpr const uint32_t rtree_version = 1;
+
+            struct rtree_sort_entry {
+
+                uint32_t hilbert;
+                std::size_t position;
+
+            }; // struct rtree_sort_entry
+
+            /**
+             * Calculate Hilbert values of the box centers in the range
+             * [begin, end) scaled to the extent of all boxes.
+             */
+            inline void rtree_hilbert_range(const rtree_box* boxes,
+                                            rtree_sort_entry* entries,
+                                            std::size_t begin,
+                                            std::size_t end,
+                                            const rtree_box& extent) noexcept {
+                const double width = static_cast<double>(extent.max_x) - extent.min_x;
+                const double height = static_cast<double>(extent.max_y) - extent.min_y;
+                const double scale_x = width > 0 ? 65535.0 / width : 0.0;
+                const double scale_y = height > 0 ? 65535.0 / height : 0.0;
+
+                for (std::size_t i = begin; i < end; ++i) {
+                    const rtree_box& box = boxes[i];
+                    const double cx = (static_cast<double>(box.min_x) + box.max_x) / 2 - extent.min_x;
+                    const double cy = (static_cast<double>(box.min_y) + box.max_y) / 2 - extent.min_y;
+                    entries[i].hilbert = osmium::geom::hilbert_index(static_cast<uint32_t>(cx * scale_x),
+                                                                     static_cast<uint32_t>(cy * scale_y));
+                    entries[i].position = i;
+                }
+            }
+
+            /**
+             * Calculate the end positions of all levels of a packed
+             * R-tree with the given number of items and node size. The
+             * leaves are the first level, the root is the last.
+             */
+            inline std::vector<std::size_t> rtree_level_bounds(std::size_t num_items, std::size_t node_size) {
+                std::vector<std::size_t> bounds;
+                if (num_items == 0) {
+                    return bounds;
+                }
+
+                std::size_t n = num_items;
+                std::size_t num_nodes = n;
+                bounds.push_back(num_nodes);
+                do {
+                    n = (n + node_size - 1) / node_size;
+                    num_nodes += n;
+                    bounds.push_back(num_nodes);
+                } while (n != 1);
+
+                return bounds;
+            }
+
+        } // namespace detail
+
+        /**
+         * A static spatial index. Boxes with a value (for instance the
+         * offset of an object in a buffer) are added to the tree, then the
+         * tree is built by calling finish(). After that it can be queried
+         * for all values whose boxes intersect a given box.
+         *
+         * The tree is a packed R-tree: The boxes are sorted along a
+         * Hilbert curve and grouped into nodes of node_size boxes, which
+         * are grouped again until there is only one root node left. All
+         * nodes are stored in two flat arrays, so the tree needs very
+         * little memory and can be written to disk with dump() and
+         * memory mapped with load() for queries without having to read
+         * it completely.
+         *
+         * The file is in native byte order, it can only be read on
+         * machines with the same endianness.
+         *
+         * Usage:
+         * @code
+         * osmium::index::PackedRTree tree;
+         * osmium::index::add_to_rtree(buffer, tree);
+         * tree.finish();
+         * tree.search(box, [&](uint64_t offset) {
+         *     const auto& object = buffer.get<osmium::OSMObject>(offset);
+         *     ...
+         * });
+         * @endcode
+         */
+        class PackedRTree {
+
+        public:
+
+            using value_type = uint64_t;
+
+        private:
+
+            std::vector<detail::rtree_box> m_boxes{};
+            std::vector<value_type> m_values{};
+            std::unique_ptr<osmium::util::MemoryMapping> m_mapping{};
+            std::vector<std::size_t> m_level_bounds{};
+            const detail::rtree_box* m_box_data = nullptr;
+            const value_type* m_value_data = nullptr;
+            std::size_t m_num_items = 0;
+            std::size_t m_node_size;
+            bool m_finished = false;
+
+            std::size_t num_nodes() const noexcept {
+                return m_level_bounds.empty() ? 0 : m_level_bounds.back();
+            }
+
+            detail::rtree_box extent() const noexcept {
+                detail::rtree_box box = m_boxes.front();
+                for (const auto& b : m_boxes) {
+                    box.extend(b);
+                }
+                return box;
+            }
+
+            std::vector<detail::rtree_sort_entry> sort_entries(osmium::thread::Pool& pool) const {
+                std::vector<detail::rtree_sort_entry> entries(m_num_items);
+                const detail::rtree_box ext = extent();
+
+                if (m_num_items <= detail::rtree_items_per_task) {
+                    detail::rtree_hilbert_range(m_boxes.data(), entries.data(), 0, m_num_items, ext);
+                } else {
+                    const detail::rtree_box* boxes = m_boxes.data();
+                    detail::rtree_sort_entry* data = entries.data();
+                    std::vector<std::future<void>> results;
+                    for (std::size_t n = 0; n < m_num_items; n += detail::rtree_items_per_task) {
+                        const std::size_t end = std::min(m_num_items, n + detail::rtree_items_per_task);
+                        results.push_back(pool.submit([boxes, data, n, end, ext]() {
+                            detail::rtree_hilbert_range(boxes, data, n, end, ext);
+                        }));
+                    }
+                    for (auto& result : results) {
+                        result.get();
+                    }
+                }
+
+                osmium::thread::stable_sort(entries.begin(), entries.end(), [](const detail::rtree_sort_entry& a, const detail::rtree_sort_entry& b) {
+                    return a.hilbert < b.hilbert;
+                }, pool);
+
+                return entries;
+            }
+
+            void set_data_pointers() noexcept {
+                m_box_data = m_boxes.data();
+                m_value_data = m_values.data();
+            }
+
+        public:
+
+            /**
+             * Create a new empty tree.
+             *
+             * @param node_size Number of children of each node.
+             * @throws std::invalid_argument if node_size is smaller than 2.
+             */
+            explicit PackedRTree(std::size_t node_size = 16) :
+                m_node_size(node_size) {
+                if (node_size < 2) {
+                    throw std::invalid_argument{"node size of R-tree must be at least 2"};
+                }
+            }
+
+            /**
+             * Load a tree written with dump() by memory mapping the file.
+             * The file descriptor can be closed afterwards.
+             *
+             * @throws rtree_error if the file is not a valid R-tree file.
+             * @throws std::system_error if the file can not be mapped.
+             */
+            static PackedRTree load(int fd) {
+                const std::size_t file_size = osmium::util::file_size(fd);
+                if (file_size < sizeof(detail::rtree_header)) {
+                    throw rtree_error{"R-tree file too small"};
+                }
+
+                std::unique_ptr<osmium::util::MemoryMapping> mapping{new osmium::util::MemoryMapping{file_size, osmium::util::MemoryMapping::mapping_mode::readonly, fd}};
+
+                const auto* header = mapping->get_addr<const detail::rtree_header>();
+                if (std::memcmp(header->magic, detail::rtree_magic, sizeof(detail::rtree_magic)) != 0) {
+                    throw rtree_error{"not an R-tree file"};
+                }
+                if (header->version != detail::rtree_version) {
+                    throw rtree_error{"unsupported R-tree file version " + std::to_string(header->version)};
+                }
+                if (header->node_size < 2) {
+                    throw rtree_error{"invalid node size in R-tree file"};
+                }
+
+                PackedRTree tree{header->node_size};
+                tree.m_num_items = static_cast<std::size_t>(header->num_items);
+                tree.m_level_bounds = detail::rtree_level_bounds(tree.m_num_items, tree.m_node_size);
+                if (tree.num_nodes() != header->num_nodes ||
+                    file_size != sizeof(detail::rtree_header) + tree.num_nodes() * (sizeof(detail::rtree_box) + sizeof(value_type))) {
+                    throw rtree_error{"R-tree file has wrong size"};
+                }
+
+                const auto* data = mapping->get_addr<const unsigned char>() + sizeof(detail::rtree_header);
+                tree.m_box_data = reinterpret_cast<const detail::rtree_box*>(data);
+                tree.m_value_data = reinterpret_cast<const value_type*>(data + tree.num_nodes() * sizeof(detail::rtree_box));
+                tree.m_mapping = std::move(mapping);
+                tree.m_finished = true;
+
+                return tree;
+            }
+
+            /// The number of children of each node.
+            std::size_t node_size() const noexcept {
+                return m_node_size;
+            }
+
+            /// The number of items added to the tree.
+            std::size_t size() const noexcept {
+                return m_num_items;
+            }
+
+            bool empty() const noexcept {
+                return m_num_items == 0;
+            }
+
+            /// Has finish() been called (or the tree been loaded)?
+            bool finished() const noexcept {
+                return m_finished;
+            }
+
+            /**
+             * Reserve space for the given number of items.
+             */
+            void reserve(std::size_t num_items) {
+                m_boxes.reserve(num_items);
+                m_values.reserve(num_items);
+            }
+
+            /**
+             * Add an item to the tree.
+             *
+             * @pre @code !finished() && box.valid() @endcode
+             */
+            void add(const osmium::Box& box, value_type value) {
+                assert(!m_finished);
+                assert(box.valid());
+                m_boxes.push_back(detail::make_rtree_box(box));
+                m_values.push_back(value);
+                ++m_num_items;
+            }
+
+            /**
+             * Build the tree from all added items. The Hilbert values are
+             * calculated and the items sorted on the thread pool. Do not
+             * call this from a task running in the same pool.
+             *
+             * @pre @code !finished() @endcode
+             */
+            void finish(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                assert(!m_finished);
+                m_finished = true;
+                m_level_bounds = detail::rtree_level_bounds(m_num_items, m_node_size);
+                if (m_num_items == 0) {
+                    return;
+                }
+
+                const auto entries = sort_entries(pool);
+
+                std::vector<detail::rtree_box> boxes;
+                std::vector<value_type> values;
+                boxes.reserve(num_nodes());
+                values.reserve(num_nodes());
+                for (const auto& entry : entries) {
+                    boxes.push_back(m_boxes[entry.position]);
+                    values.push_back(m_values[entry.position]);
+                }
+
+                // Create the parent nodes level by level. The value of a
+                // parent is the position of its first child.
+                std::size_t pos = 0;
+                for (std::size_t level = 0; level + 1 < m_level_bounds.size(); ++level) {
+                    const std::size_t end = m_level_bounds[level];
+                    while (pos < end) {
+                        const std::size_t first = pos;
+                        detail::rtree_box box = boxes[pos];
+                        const std::size_t last = std::min(pos + m_node_size, end);
+                        for (++pos; pos < last; ++pos) {
+                            box.extend(boxes[pos]);
+                        }
+                        boxes.push_back(box);
+                        values.push_back(first);
+                    }
+                }
+                assert(boxes.size() == num_nodes());
+
+                using std::swap;
+                swap(m_boxes, boxes);
+                swap(m_values, values);
+                set_data_pointers();
+            }
+
+            /**
+             * Call func(value) for all items whose boxes intersect the
+             * given box. The order is unspecified.
+             *
+             * @pre @code finished() @endcode
+             */
+            template <typename TFunc>
+            void search(const osmium::Box& box, TFunc&& func) const {
+                assert(m_finished);
+                if (m_num_items == 0 || !box.valid()) {
+                    return;
+                }
+
+                const detail::rtree_box query = detail::make_rtree_box(box);
+                std::vector<std::size_t> queue;
+                std::size_t node = num_nodes() - 1;
+                std::size_t level = m_level_bounds.size() - 1;
+                std::vector<std::size_t> levels;
+
+                while (true) {
+                    const std::size_t end = std::min(node + m_node_size, m_level_bounds[level]);
+                    for (std::size_t pos = node; pos < end; ++pos) {
+                        if (!query.intersects(m_box_data[pos])) {
+                            continue;
+                        }
+                        if (node < m_num_items) {
+                            func(m_value_data[pos]);
+                        } else {
+                            queue.push_back(static_cast<std::size_t>(m_value_data[pos]));
+                            levels.push_back(level - 1);
+                        }
+                    }
+
+                    if (queue.empty()) {
+                        return;
+                    }
+                    node = queue.back();
+                    queue.pop_back();
+                    level = levels.back();
+                    levels.pop_back();
+                }
+            }
+
+            /**
+             * Get the values of all items whose boxes intersect the given
+             * box. The order is unspecified.
+             *
+             * @pre @code finished() @endcode
+             */
+            std::vector<value_type> search(const osmium::Box& box) const {
+                std::vector<value_type> result;
+                search(box, [&result](value_type value) {
+                    result.push_back(value);
+                });
+                return result;
+            }
+
+            /**
+             * Write the tree to a file. It can be loaded again with load().
+             *
+             * @pre @code finished() @endcode
+             */
+            void dump(int fd) const {
+                assert(m_finished);
+                detail::rtree_header header{};
+                std::copy_n(detail::rtree_magic, sizeof(detail::rtree_magic), header.magic);
+                header.version = detail::rtree_version;
+                header.node_size = static_cast<uint32_t>(m_node_size);
+                header.num_items = m_num_items;
+                header.num_nodes = num_nodes();
+
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&header), sizeof(header));
+                if (num_nodes() > 0) {
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_box_data), num_nodes() * sizeof(detail::rtree_box));
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_value_data), num_nodes() * sizeof(value_type));
+                }
+            }
+
+        }; // class PackedRTree
+
+        namespace detail {
+
+            using rtree_entries = std::vector<std::pair<osmium::Box, PackedRTree::value_type>>;
+
+            inline osmium::Box object_envelope(const osmium::OSMObject& object) noexcept {
+                switch (object.type()) {
+                    case osmium::item_type::node: {
+                            osmium::Box box;
+                            box.extend(static_cast<const osmium::Node&>(object).location());
+                            return box;
+                        }
+                    case osmium::item_type::way:
+                        return static_cast<const osmium::Way&>(object).envelope();
+                    case osmium::item_type::area:
+                        return static_cast<const osmium::Area&>(object).envelope();
+                    default:
+                        break;
+                }
+                return osmium::Box{};
+            }
+
+            // Calculate the envelopes of the objects in the range
+            // [begin, end). The value for an object is returned by
+            // value_func(position in objects, object).
+            template <typename TValueFunc>
+            rtree_entries rtree_envelopes(const osmium::OSMObject* const* objects,
+                                          std::size_t begin,
+                                          std::size_t end,
+                                          const TValueFunc& value_func) {
+                rtree_entries entries;
+                for (std::size_t i = begin; i < end; ++i) {
+                    const osmium::Box box = object_envelope(*objects[i]);
+                    if (box.valid()) {
+                        entries.emplace_back(box, value_func(i, *objects[i]));
+                    }
+                }
+                return entries;
+            }
+
+            template <typename TValueFunc>
+            std::size_t add_objects_to_rtree(const std::vector<const osmium::OSMObject*>& objects,
+                                             PackedRTree& tree,
+                                             osmium::thread::Pool& pool,
+                                             TValueFunc value_func) {
+                std::vector<std::future<rtree_entries>> results;
+                const osmium::OSMObject* const* data = objects.data();
+                const TValueFunc* func = &value_func;
+                for (std::size_t n = 0; n < objects.size(); n += rtree_items_per_task) {
+                    const std::size_t end = std::min(objects.size(), n + rtree_items_per_task);
+                    results.push_back(pool.submit([data, n, end, func]() {
+                        return rtree_envelopes(data, n, end, *func);
+                    }));
+                }
+
+                // Wait for all tasks before getting the results, a task might
+                // throw, but the others still use the objects vector.
+                for (auto& result : results) {
+                    result.wait();
+                }
+
+                std::size_t count = 0;
+                for (auto& result : results) {
+                    for (const auto& entry : result.get()) {
+                        tree.add(entry.first, entry.second);
+                        ++count;
+                    }
+                }
+                return count;
+            }
+
+        } // namespace detail
+
+        /**
+         * Add the envelopes of all nodes, ways and areas in a buffer to an
+         * R-tree. The value stored for each object is its offset in the
+         * buffer. Ways need their node locations set. Objects without a
+         * valid envelope and relations are ignored.
+         *
+         * The envelopes are calculated in parallel on the thread pool.
+         * Do not call this from a task running in the same pool.
+         *
+         * @returns The number of objects added.
+         */
+        inline std::size_t add_to_rtree(const osmium::memory::Buffer& buffer,
+                                        PackedRTree& tree,
+                                        osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            std::vector<const osmium::OSMObject*> objects;
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                if (object.type() != osmium::item_type::relation) {
+                    objects.push_back(&object);
+                }
+            }
+
+            const unsigned char* data = buffer.data();
+            return detail::add_objects_to_rtree(objects, tree, pool, [data](std::size_t /*position*/, const osmium::OSMObject& object) {
+                return static_cast<PackedRTree::value_type>(reinterpret_cast<const unsigned char*>(&object) - data);
+            });
+        }
+
+        /**
+         * Add the envelopes of all nodes, ways and areas in an
+         * ObjectPointerCollection to an R-tree. The value stored for each
+         * object is its position in the collection. Ways need their node
+         * locations set. Objects without a valid envelope and relations
+         * are ignored.
+         *
+         * The envelopes are calculated in parallel on the thread pool.
+         * Do not call this from a task running in the same pool.
+         *
+         * @returns The number of objects added.
+         */
+        inline std::size_t add_to_rtree(const osmium::ObjectPointerCollection& collection,
+                                        PackedRTree& tree,
+                                        osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            std::vector<const osmium::OSMObject*> objects;
+            objects.reserve(collection.size());
+            for (auto it = collection.cbegin(); it != collection.cend(); ++it) {
+                objects.push_back(&*it);
+            }
+
+            return detail::add_objects_to_rtree(objects, tree, pool, [](std::size_t position, const osmium::OSMObject& /*object*/) {
+                return static_cast<PackedRTree::value_type>(position);
+            });
+        }
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_PACKED_RTREE_HPP
@@ -0,0 +1,265 @@
+#ifndef OSMIUM_INDEX_REFERENTIAL_INTEGRITY_HPP
+#define OSMIUM_INDEX_REFERENTIAL_INTEGRITY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+
+#include <osmium/index/concurrent_id_set.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/io/decoded_buffer_callback.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Checks that all nodes referenced from ways and all members of
+         * relations are in the data.
+         *
+         * The IDs of all objects and the IDs of all referenced objects
+         * are recorded in ConcurrentIdSetDense sets, one for each type.
+         * Because those sets can be filled from several threads, add()
+         * can be called from the PBF decoder threads through the
+         * callback() option of the Reader. After reading, check()
+         * computes "referenced minus defined" for each type with the
+         * bulk set operations of IdSetDense.
+         *
+         * If the input is a PBF file, find_referrers() can then report
+         * which ways and relations reference missing objects. It only
+         * decodes the blobs containing ways or relations, and only if
+         * there are missing objects they could reference.
+         *
+         * Objects with negative IDs are ignored.
+         *
+         * Usage:
+         * @code
+         * osmium::index::ReferentialIntegrityChecker checker;
+         * osmium::io::Reader reader{filename, checker.callback()};
+         * while (reader.read()) {}
+         * reader.close();
+         * if (checker.check() > 0) {
+         *     osmium::io::IndexedPBFReader indexed{filename};
+         *     checker.find_referrers(indexed, [](const osmium::OSMObject& referrer,
+         *                                        osmium::item_type type,
+         *                                        osmium::object_id_type id) { ... });
+         * }
+         * @endcode
+         */
+        class ReferentialIntegrityChecker {
+
+        public:
+
+            using id_set_type = IdSetDense<osmium::unsigned_object_id_type>;
+
+            /// Default for the largest ID which can be stored.
+            enum : osmium::unsigned_object_id_type {
+                default_max_id = 1ULL << 36U
+            };
+
+        private:
+
+            using concurrent_id_set_type = ConcurrentIdSetDense<osmium::unsigned_object_id_type>;
+
+            std::array<concurrent_id_set_type, 3> m_defined;
+            std::array<concurrent_id_set_type, 3> m_referenced;
+            std::array<id_set_type, 3> m_missing;
+
+            static void set(concurrent_id_set_type& ids, osmium::object_id_type id) {
+                if (id > 0) {
+                    ids.set(static_cast<osmium::unsigned_object_id_type>(id));
+                }
+            }
+
+            template <typename TFunc>
+            void report_missing(const osmium::OSMObject& referrer, osmium::item_type type, osmium::object_id_type id, TFunc& func) const {
+                if (id > 0 && m_missing[osmium::item_type_to_nwr_index(type)].get(static_cast<osmium::unsigned_object_id_type>(id))) {
+                    func(referrer, type, id);
+                }
+            }
+
+        public:
+
+            /**
+             * Constructor.
+             *
+             * @param max_id All IDs must be smaller than this. The sets
+             *               need one pointer for every 2^25 IDs up front.
+             */
+            explicit ReferentialIntegrityChecker(osmium::unsigned_object_id_type max_id = default_max_id) {
+                for (auto& ids : m_defined) {
+                    ids.resize(max_id);
+                }
+                for (auto& ids : m_referenced) {
+                    ids.resize(max_id);
+                }
+            }
+
+            /**
+             * Record all objects in the buffer and the objects they
+             * reference. This can be called from several threads at the
+             * same time, but not together with any other member function.
+             *
+             * @throws std::out_of_range if an ID is too large.
+             */
+            void add(const osmium::memory::Buffer& buffer) {
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (object.type() == osmium::item_type::node) {
+                        set(m_defined[0], object.id());
+                    } else if (object.type() == osmium::item_type::way) {
+                        set(m_defined[1], object.id());
+                        for (const auto& node_ref : static_cast<const osmium::Way&>(object).nodes()) {
+                            set(m_referenced[0], node_ref.ref());
+                        }
+                    } else if (object.type() == osmium::item_type::relation) {
+                        set(m_defined[2], object.id());
+                        for (const auto& member : static_cast<const osmium::Relation&>(object).members()) {
+                            set(m_referenced[osmium::item_type_to_nwr_index(member.type())], member.ref());
+                        }
+                    }
+                }
+            }
+
+            /**
+             * Get a Reader option which calls add() for every buffer in
+             * the decoder threads. The checker must outlive the Reader.
+             */
+            osmium::io::decoded_buffer_callback callback() {
+                return osmium::io::decoded_buffer_callback{[this](osmium::memory::Buffer& buffer) {
+                    add(buffer);
+                }};
+            }
+
+            /**
+             * Compute the missing objects after all data was added.
+             *
+             * @returns The number of missing objects of all types.
+             */
+            std::size_t check() {
+                std::size_t count = 0;
+                for (std::size_t n = 0; n < 3; ++n) {
+                    auto missing = m_referenced[n].to_id_set_dense();
+                    missing.set_difference(m_defined[n].to_id_set_dense());
+                    count += missing.size();
+                    swap(m_missing[n], missing);
+                }
+                return count;
+            }
+
+            /**
+             * Compute the missing objects after all data was added. The
+             * set operations are distributed over the threads of the
+             * pool.
+             *
+             * @returns The number of missing objects of all types.
+             */
+            template <typename TPool>
+            std::size_t check(TPool& pool) {
+                std::size_t count = 0;
+                for (std::size_t n = 0; n < 3; ++n) {
+                    auto missing = m_referenced[n].to_id_set_dense();
+                    missing.set_difference(m_defined[n].to_id_set_dense(), pool);
+                    count += missing.size();
+                    swap(m_missing[n], missing);
+                }
+                return count;
+            }
+
+            /**
+             * The IDs of the missing objects of the specified type as
+             * computed by the last call to check().
+             */
+            const id_set_type& missing(osmium::item_type type) const noexcept {
+                return m_missing[osmium::item_type_to_nwr_index(type)];
+            }
+
+            /**
+             * Call func(referrer, type, id) for each way or relation
+             * referencing a missing object from the last call to
+             * check(). Only the blobs of the file which contain ways or
+             * relations that could reference missing objects are
+             * decoded, and the metadata is not.
+             *
+             * @tparam TReader osmium::io::IndexedPBFReader
+             */
+            template <typename TReader, typename TFunc>
+            void find_referrers(TReader& reader, TFunc&& func) const {
+                osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nothing;
+                if (!m_missing[0].empty()) {
+                    entities |= osmium::osm_entity_bits::way;
+                }
+                if (!m_missing[0].empty() || !m_missing[1].empty() || !m_missing[2].empty()) {
+                    entities |= osmium::osm_entity_bits::relation;
+                }
+                if (entities == osmium::osm_entity_bits::nothing) {
+                    return;
+                }
+
+                const auto& summaries = reader.summaries();
+                for (std::size_t n = 0; n < summaries.size(); ++n) {
+                    if (!(summaries[n].types & entities)) {
+                        continue;
+                    }
+                    const auto buffer = reader.read_blob(n, entities, osmium::io::read_meta::no);
+                    for (const auto& object : buffer.template select<osmium::OSMObject>()) {
+                        if (object.type() == osmium::item_type::way) {
+                            for (const auto& node_ref : static_cast<const osmium::Way&>(object).nodes()) {
+                                report_missing(object, osmium::item_type::node, node_ref.ref(), func);
+                            }
+                        } else if (object.type() == osmium::item_type::relation) {
+                            for (const auto& member : static_cast<const osmium::Relation&>(object).members()) {
+                                report_missing(object, member.type(), member.ref(), func);
+                            }
+                        }
+                    }
+                }
+            }
+
+        }; // class ReferentialIntegrityChecker
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_REFERENTIAL_INTEGRITY_HPP
@@ -36,11 +36,16 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
 
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -119,6 +124,40 @@ namespace osmium {
                     m_map.erase(last, m_map.end());
                 }
 
+                void sort_unique(osmium::thread::Pool& pool) {
+                    osmium::thread::sort(m_map.begin(), m_map.end(), pool);
+                    const auto last = std::unique(m_map.begin(), m_map.end());
+                    m_map.erase(last, m_map.end());
+                }
+
+                /**
+                 * Get the positions of all entries ordered by value (and
+                 * key). The map must be sorted. If a pool is given, it is
+                 * used for sorting.
+                 */
+                template <typename TPosition>
+                std::vector<TPosition> order_by_value(osmium::thread::Pool* pool) const {
+                    std::vector<TPosition> order(m_map.size());
+                    std::iota(order.begin(), order.end(), 0);
+
+                    // Entries are already sorted by key, so for the same
+                    // value smaller positions have smaller keys.
+                    const auto compare = [this](const TPosition lhs, const TPosition rhs) noexcept {
+                        return std::tie(m_map[lhs].value, lhs) < std::tie(m_map[rhs].value, rhs);
+                    };
+                    if (pool) {
+                        osmium::thread::sort(order.begin(), order.end(), compare, *pool);
+                    } else {
+                        std::sort(order.begin(), order.end(), compare);
+                    }
+
+                    return order;
+                }
+
+                const kv_pair& operator[](const std::size_t n) const noexcept {
+                    return m_map[n];
+                }
+
                 std::pair<const_iterator, const_iterator> get(const key_type key) const noexcept {
                     return std::equal_range(m_map.begin(), m_map.end(), kv_pair{key}, [](const kv_pair& lhs, const kv_pair& rhs) {
                         return lhs.key < rhs.key;
@@ -174,10 +213,37 @@ namespace osmium {
             using map_type = detail::flat_map<osmium::unsigned_object_id_type, uint32_t,
                                               osmium::unsigned_object_id_type, uint32_t>;
 
-            map_type m_map;
+            using position_type = uint32_t;
+
+            std::shared_ptr<const map_type> m_map;
+
+            // Only used for an index sharing its map with the index for
+            // the other direction (see RelationsMapStash::build_indexes()):
+            // The positions of the entries in the map ordered by value.
+            // Lookups then go from value to key.
+            std::vector<position_type> m_order;
+            bool m_reverse = false;
 
             explicit RelationsMapIndex(map_type&& map) :
-                m_map(std::move(map)) {
+                m_map(std::make_shared<const map_type>(std::move(map))) {
+            }
+
+            RelationsMapIndex(std::shared_ptr<const map_type> map, std::vector<position_type>&& order) :
+                m_map(std::move(map)),
+                m_order(std::move(order)),
+                m_reverse(true) {
+            }
+
+            template <typename TFunc>
+            void for_each_reverse(const osmium::unsigned_object_id_type id, TFunc&& func) const {
+                const auto& map = *m_map;
+                const auto value = static_cast<uint32_t>(id);
+                const auto first = std::lower_bound(m_order.begin(), m_order.end(), value, [&map](const position_type pos, const uint32_t v) noexcept {
+                    return map[pos].value < v;
+                });
+                for (auto it = first; it != m_order.end() && map[*it].value == value; ++it) {
+                    func(map[*it].key);
+                }
             }
 
         public:
@@ -187,8 +253,8 @@ namespace osmium {
             RelationsMapIndex(const RelationsMapIndex&) = delete;
             RelationsMapIndex& operator=(const RelationsMapIndex&) = delete;
 
-            RelationsMapIndex(RelationsMapIndex&& /*other*/) noexcept(std::is_nothrow_move_constructible<map_type>::value);
-            RelationsMapIndex& operator=(RelationsMapIndex&& /*other*/) noexcept(std::is_nothrow_move_assignable<map_type>::value);
+            RelationsMapIndex(RelationsMapIndex&& /*other*/) noexcept(std::is_nothrow_move_constructible<std::vector<position_type>>::value);
+            RelationsMapIndex& operator=(RelationsMapIndex&& /*other*/) noexcept(std::is_nothrow_move_assignable<std::vector<position_type>>::value);
 
             ~RelationsMapIndex() noexcept = default;
 
@@ -210,10 +276,7 @@ namespace osmium {
              */
             template <typename TFunc>
             void for_each_parent(const osmium::unsigned_object_id_type member_id, TFunc&& func) const {
-                const auto parents = m_map.get(member_id);
-                for (auto it = parents.first; it != parents.second; ++it) {
-                    func(it->value);
-                }
+                for_each(member_id, std::forward<TFunc>(func));
             }
 
             /**
@@ -232,7 +295,11 @@ namespace osmium {
              */
             template <typename TFunc>
             void for_each(const osmium::unsigned_object_id_type id, TFunc&& func) const {
-                const auto parents = m_map.get(id);
+                if (m_reverse) {
+                    for_each_reverse(id, std::forward<TFunc>(func));
+                    return;
+                }
+                const auto parents = m_map->get(id);
                 for (auto it = parents.first; it != parents.second; ++it) {
                     func(it->value);
                 }
@@ -244,7 +311,7 @@ namespace osmium {
              * Complexity: Constant.
              */
             bool empty() const noexcept {
-                return m_map.empty();
+                return m_map->empty();
             }
 
             /**
@@ -253,15 +320,15 @@ namespace osmium {
              * Complexity: Constant.
              */
             std::size_t size() const noexcept {
-                return m_map.size();
+                return m_map->size();
             }
 
         }; // class RelationsMapIndex
 
         // defined outside the class on purpose
         // see https://akrzemi1.wordpress.com/2015/09/11/declaring-the-move-constructor/
-        inline RelationsMapIndex::RelationsMapIndex(RelationsMapIndex&&) noexcept(std::is_nothrow_move_constructible<map_type>::value) = default;
-        inline RelationsMapIndex& RelationsMapIndex::operator=(RelationsMapIndex&&) noexcept(std::is_nothrow_move_assignable<map_type>::value) = default;
+        inline RelationsMapIndex::RelationsMapIndex(RelationsMapIndex&&) noexcept(std::is_nothrow_move_constructible<std::vector<position_type>>::value) = default;
+        inline RelationsMapIndex& RelationsMapIndex::operator=(RelationsMapIndex&&) noexcept(std::is_nothrow_move_assignable<std::vector<position_type>>::value) = default;
 
         class RelationsMapIndexes {
 
@@ -270,9 +337,9 @@ namespace osmium {
             RelationsMapIndex m_member_to_parent;
             RelationsMapIndex m_parent_to_member;
 
-            RelationsMapIndexes(RelationsMapIndex::map_type&& map1, RelationsMapIndex::map_type&& map2) :
-                m_member_to_parent(std::move(map1)),
-                m_parent_to_member(std::move(map2)) {
+            RelationsMapIndexes(RelationsMapIndex&& index1, RelationsMapIndex&& index2) :
+                m_member_to_parent(std::move(index1)),
+                m_parent_to_member(std::move(index2)) {
             }
 
         public:
@@ -390,6 +457,21 @@ namespace osmium {
                 return RelationsMapIndex{std::move(m_map)};
             }
 
+            /**
+             * Like build_index(), but sort the data using the threads in
+             * the pool.
+             *
+             * @deprecated Use build_member_to_parent_index() instead.
+             */
+            RelationsMapIndex build_index(osmium::thread::Pool& pool) {
+                assert(m_valid && "You can't use the RelationsMap any more after calling build_index()");
+                m_map.sort_unique(pool);
+#ifndef NDEBUG
+                m_valid = false;
+#endif
+                return RelationsMapIndex{std::move(m_map)};
+            }
+
             /**
              * Build an index for member to parent lookups from the contents
              * of this stash and return it.
@@ -405,6 +487,19 @@ namespace osmium {
                 return RelationsMapIndex{std::move(m_map)};
             }
 
+            /**
+             * Like build_member_to_parent_index(), but sort the data using
+             * the threads in the pool.
+             */
+            RelationsMapIndex build_member_to_parent_index(osmium::thread::Pool& pool) {
+                assert(m_valid && "You can't use the RelationsMap any more after calling build_member_to_parent_index()");
+                m_map.sort_unique(pool);
+#ifndef NDEBUG
+                m_valid = false;
+#endif
+                return RelationsMapIndex{std::move(m_map)};
+            }
+
             /**
              * Build an index for parent to member lookups from the contents
              * of this stash and return it.
@@ -421,21 +516,67 @@ namespace osmium {
                 return RelationsMapIndex{std::move(m_map)};
             }
 
+            /**
+             * Like build_parent_to_member_index(), but sort the data using
+             * the threads in the pool.
+             */
+            RelationsMapIndex build_parent_to_member_index(osmium::thread::Pool& pool) {
+                assert(m_valid && "You can't use the RelationsMap any more after calling build_parent_to_member_index()");
+                m_map.flip_in_place();
+                m_map.sort_unique(pool);
+#ifndef NDEBUG
+                m_valid = false;
+#endif
+                return RelationsMapIndex{std::move(m_map)};
+            }
+
             /**
              * Build indexes for member-to-parent and parent-to-member lookups
              * from the contents of this stash and return them.
              *
+             * Both indexes share the same data, the parent-to-member index
+             * only needs an additional 4 bytes per entry to find the
+             * entries ordered by parent.
+             *
              * After you get the index you can not use the stash any more!
              */
             RelationsMapIndexes build_indexes() {
                 assert(m_valid && "You can't use the RelationsMap any more after calling build_indexes()");
-                auto reverse_map = m_map.flip_copy();
-                reverse_map.sort_unique();
                 m_map.sort_unique();
+                return make_indexes(nullptr);
+            }
+
+            /**
+             * Like build_indexes(), but sort the data using the threads in
+             * the pool.
+             */
+            RelationsMapIndexes build_indexes(osmium::thread::Pool& pool) {
+                assert(m_valid && "You can't use the RelationsMap any more after calling build_indexes()");
+                m_map.sort_unique(pool);
+                return make_indexes(&pool);
+            }
+
+        private:
+
+            RelationsMapIndexes make_indexes(osmium::thread::Pool* pool) {
 #ifndef NDEBUG
                 m_valid = false;
 #endif
-                return RelationsMapIndexes{std::move(m_map), std::move(reverse_map)};
+                if (m_map.size() > std::numeric_limits<RelationsMapIndex::position_type>::max()) {
+                    // Too many entries to share the data, use a copy.
+                    auto reverse_map = m_map.flip_copy();
+                    if (pool) {
+                        reverse_map.sort_unique(*pool);
+                    } else {
+                        reverse_map.sort_unique();
+                    }
+                    return RelationsMapIndexes{RelationsMapIndex{std::move(m_map)}, RelationsMapIndex{std::move(reverse_map)}};
+                }
+
+                auto order = m_map.order_by_value<RelationsMapIndex::position_type>(pool);
+                RelationsMapIndex member_to_parent{std::move(m_map)};
+                RelationsMapIndex parent_to_member{member_to_parent.m_map, std::move(order)};
+                return RelationsMapIndexes{std::move(member_to_parent), std::move(parent_to_member)};
             }
 
         }; // class RelationsMapStash
@@ -0,0 +1,489 @@
+#ifndef OSMIUM_INDEX_REVERSE_INDEX_HPP
+#define OSMIUM_INDEX_REVERSE_INDEX_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/index/detail/radix_sort.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/compatibility.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when a reverse index file can not be loaded.
+     */
+    struct OSMIUM_EXPORT reverse_index_error : public std::runtime_error {
+
+        explicit reverse_index_error(const std::string& what) :
+            std::runtime_error(what) {
+        }
+
+        explicit reverse_index_error(const char* what) :
+            std::runtime_error(what) {
+        }
+
+    }; // struct reverse_index_error
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * Header of the file format written by ReverseIndex::dump().
+             * It is followed by the keys, the offsets, and the values.
+             */
+            struct reverse_index_header {
+
+                char magic[8];
+                uint32_t version;
+                uint32_t reserved;
+                uint64_t num_keys;
+                uint64_t num_values;
+
+            }; // struct reverse_index_header
+
+            static_assert(sizeof(reverse_index_header) == 32, "Unexpected size of reverse_index_header");
+
+            constexpr const char reverse_index_magic[8] = {'O', 'S', 'M', 'R', 'E', 'V', 'I', 'X'};
+            constexpr const uint32_t reverse_index_version = 1;
+
+            using reverse_index_pair = std::pair<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>;
+
+        } // namespace detail
+
+        /**
+         * Compact read-only index from object IDs to the IDs of the objects
+         * referencing them, for instance from node IDs to the IDs of the
+         * ways containing those nodes. It is stored in compressed sparse
+         * row format: A sorted array of all referenced IDs (the keys), an
+         * array with the position of the first referencing ID for each
+         * key, and an array with all referencing IDs (the values), sorted
+         * for each key.
+         *
+         * Create an index with a ReverseIndexBuilder or load one written
+         * with dump() using load(), which memory maps the file. The file
+         * format uses the native byte order.
+         */
+        class ReverseIndex {
+
+            friend class ReverseIndexBuilder;
+
+            std::vector<osmium::unsigned_object_id_type> m_keys;
+            std::vector<uint64_t> m_offsets{0};
+            std::vector<osmium::unsigned_object_id_type> m_values;
+
+            std::unique_ptr<osmium::util::MemoryMapping> m_mapping;
+
+            const osmium::unsigned_object_id_type* m_key_data = nullptr;
+            const uint64_t* m_offset_data = nullptr;
+            const osmium::unsigned_object_id_type* m_value_data = nullptr;
+            std::size_t m_num_keys = 0;
+            std::size_t m_num_values = 0;
+
+            void set_data_pointers() noexcept {
+                m_key_data = m_keys.data();
+                m_offset_data = m_offsets.data();
+                m_value_data = m_values.data();
+                m_num_keys = m_keys.size();
+                m_num_values = m_values.size();
+            }
+
+            // Create the index from sorted and unique (key, value) pairs.
+            explicit ReverseIndex(const std::vector<detail::reverse_index_pair>& pairs) {
+                m_values.reserve(pairs.size());
+                for (const auto& pair : pairs) {
+                    if (m_keys.empty() || m_keys.back() != pair.first) {
+                        if (!m_keys.empty()) {
+                            m_offsets.push_back(m_values.size());
+                        }
+                        m_keys.push_back(pair.first);
+                    }
+                    m_values.push_back(pair.second);
+                }
+                if (!m_keys.empty()) {
+                    m_offsets.push_back(m_values.size());
+                }
+                set_data_pointers();
+            }
+
+        public:
+
+            using value_type = osmium::unsigned_object_id_type;
+            using const_iterator = const value_type*;
+
+            /// Create an empty index.
+            ReverseIndex() {
+                set_data_pointers();
+            }
+
+            /**
+             * Load an index written with dump() by memory mapping the
+             * file. The file descriptor can be closed afterwards.
+             *
+             * @throws reverse_index_error if the file is not a valid
+             *         reverse index file.
+             * @throws std::system_error if the file can not be mapped.
+             */
+            static ReverseIndex load(int fd) {
+                const std::size_t file_size = osmium::util::file_size(fd);
+                if (file_size < sizeof(detail::reverse_index_header)) {
+                    throw reverse_index_error{"reverse index file too small"};
+                }
+
+                std::unique_ptr<osmium::util::MemoryMapping> mapping{new osmium::util::MemoryMapping{file_size, osmium::util::MemoryMapping::mapping_mode::readonly, fd}};
+
+                const auto* header = mapping->get_addr<const detail::reverse_index_header>();
+                if (std::memcmp(header->magic, detail::reverse_index_magic, sizeof(detail::reverse_index_magic)) != 0) {
+                    throw reverse_index_error{"not a reverse index file"};
+                }
+                if (header->version != detail::reverse_index_version) {
+                    throw reverse_index_error{"unsupported reverse index file version " + std::to_string(header->version)};
+                }
+                const uint64_t num_offsets = header->num_keys + 1;
+                if (file_size != sizeof(detail::reverse_index_header) + header->num_keys * sizeof(value_type) +
+                                 num_offsets * sizeof(uint64_t) + header->num_values * sizeof(value_type)) {
+                    throw reverse_index_error{"reverse index file has wrong size"};
+                }
+
+                ReverseIndex index;
+                const auto* data = mapping->get_addr<const unsigned char>() + sizeof(detail::reverse_index_header);
+                index.m_num_keys = static_cast<std::size_t>(header->num_keys);
+                index.m_num_values = static_cast<std::size_t>(header->num_values);
+                index.m_key_data = reinterpret_cast<const value_type*>(data);
+                data += index.m_num_keys * sizeof(value_type);
+                index.m_offset_data = reinterpret_cast<const uint64_t*>(data);
+                data += num_offsets * sizeof(uint64_t);
+                index.m_value_data = reinterpret_cast<const value_type*>(data);
+                if (index.m_offset_data[index.m_num_keys] != index.m_num_values) {
+                    throw reverse_index_error{"invalid offsets in reverse index file"};
+                }
+                index.m_mapping = std::move(mapping);
+
+                return index;
+            }
+
+            /// The number of distinct keys.
+            std::size_t num_keys() const noexcept {
+                return m_num_keys;
+            }
+
+            /// The number of (key, value) entries.
+            std::size_t size() const noexcept {
+                return m_num_values;
+            }
+
+            bool empty() const noexcept {
+                return m_num_values == 0;
+            }
+
+            /**
+             * Get the range of values for the given key. The values are
+             * sorted.
+             *
+             * Complexity: Logarithmic in the number of keys.
+             */
+            std::pair<const_iterator, const_iterator> get(const value_type key) const noexcept {
+                const auto* end = m_key_data + m_num_keys;
+                const auto* it = std::lower_bound(m_key_data, end, key);
+                if (it == end || *it != key) {
+                    return {m_value_data, m_value_data};
+                }
+                const auto n = static_cast<std::size_t>(it - m_key_data);
+                return {m_value_data + m_offset_data[n], m_value_data + m_offset_data[n + 1]};
+            }
+
+            /**
+             * Call func with each value for the given key.
+             *
+             * Complexity: Logarithmic in the number of keys.
+             */
+            template <typename TFunc>
+            void for_each(const value_type key, TFunc&& func) const {
+                const auto range = get(key);
+                for (auto it = range.first; it != range.second; ++it) {
+                    func(*it);
+                }
+            }
+
+            /**
+             * Call func(key, value) for all entries in the index, ordered
+             * by key and value.
+             */
+            template <typename TFunc>
+            void for_each_entry(TFunc&& func) const {
+                for (std::size_t n = 0; n < m_num_keys; ++n) {
+                    for (auto i = m_offset_data[n]; i < m_offset_data[n + 1]; ++i) {
+                        func(m_key_data[n], m_value_data[i]);
+                    }
+                }
+            }
+
+            /**
+             * Write the index to a file. It can be loaded again with load().
+             */
+            void dump(int fd) const {
+                detail::reverse_index_header header{};
+                std::copy_n(detail::reverse_index_magic, sizeof(detail::reverse_index_magic), header.magic);
+                header.version = detail::reverse_index_version;
+                header.num_keys = m_num_keys;
+                header.num_values = m_num_values;
+
+                const std::size_t num_offsets = m_num_keys + 1;
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&header), sizeof(header));
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_key_data), m_num_keys * sizeof(value_type));
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_offset_data), num_offsets * sizeof(uint64_t));
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_value_data), m_num_values * sizeof(value_type));
+            }
+
+        }; // class ReverseIndex
+
+        /**
+         * Collects (key, value) pairs to build a ReverseIndex from, or to
+         * update an existing index with.
+         */
+        class ReverseIndexBuilder {
+
+            std::vector<detail::reverse_index_pair> m_pairs;
+            osmium::index::IdSetDense<osmium::unsigned_object_id_type> m_removed;
+
+            void sort_unique(osmium::thread::Pool& pool) {
+                // LSD radix sort: by the less significant part first.
+                detail::radix_sort(m_pairs, [](const detail::reverse_index_pair& pair) {
+                    return pair.second;
+                }, pool);
+                detail::radix_sort(m_pairs, [](const detail::reverse_index_pair& pair) {
+                    return pair.first;
+                }, pool);
+                m_pairs.erase(std::unique(m_pairs.begin(), m_pairs.end()), m_pairs.end());
+            }
+
+        public:
+
+            /// Add an entry mapping key to value.
+            void add(const osmium::unsigned_object_id_type key, const osmium::unsigned_object_id_type value) {
+                m_pairs.emplace_back(key, value);
+            }
+
+            /**
+             * Mark value as changed: When updating an existing index, all
+             * its entries with this value are removed. Entries added to
+             * this builder are not affected.
+             */
+            void remove_value(const osmium::unsigned_object_id_type value) {
+                m_removed.set(value);
+            }
+
+            /// The number of entries added so far.
+            std::size_t size() const noexcept {
+                return m_pairs.size();
+            }
+
+            void reserve(std::size_t size) {
+                m_pairs.reserve(size);
+            }
+
+            /**
+             * Build an index from the entries added. The entries are
+             * sorted with a parallel radix sort using the threads in the
+             * pool. Duplicate entries are removed. Afterwards the builder
+             * is empty again.
+             */
+            ReverseIndex build(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                sort_unique(pool);
+                ReverseIndex index{m_pairs};
+                clear();
+                return index;
+            }
+
+            /**
+             * Build a new index from an existing one without the entries
+             * whose values have been removed with remove_value(), plus the
+             * entries added to this builder. Afterwards the builder is
+             * empty again.
+             */
+            ReverseIndex update(const ReverseIndex& index, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                sort_unique(pool);
+
+                std::vector<detail::reverse_index_pair> old_pairs;
+                old_pairs.reserve(index.size());
+                index.for_each_entry([&](osmium::unsigned_object_id_type key, osmium::unsigned_object_id_type value) {
+                    if (!m_removed.get(value)) {
+                        old_pairs.emplace_back(key, value);
+                    }
+                });
+
+                std::vector<detail::reverse_index_pair> pairs;
+                pairs.reserve(old_pairs.size() + m_pairs.size());
+                std::merge(old_pairs.begin(), old_pairs.end(), m_pairs.begin(), m_pairs.end(), std::back_inserter(pairs));
+                pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+                ReverseIndex result{pairs};
+                clear();
+                return result;
+            }
+
+            /// Remove all entries and removed values.
+            void clear() {
+                m_pairs.clear();
+                m_pairs.shrink_to_fit();
+                m_removed.clear();
+            }
+
+        }; // class ReverseIndexBuilder
+
+        /**
+         * The reverse indexes from nodes to the ways and relations they
+         * are in, from ways to relations, and from relations to their
+         * parent relations.
+         */
+        struct ReverseIndexes {
+
+            ReverseIndex node_to_way;
+            ReverseIndex node_to_relation;
+            ReverseIndex way_to_relation;
+            ReverseIndex relation_to_relation;
+
+        }; // struct ReverseIndexes
+
+        /**
+         * Handler collecting the references between objects to build the
+         * ReverseIndexes from. Feed it all ways and relations and call
+         * build().
+         *
+         * To update existing indexes, feed it the new versions of all
+         * changed ways and relations (including deleted ones) from a
+         * change file and call update(). All previous references from a
+         * changed object are removed and the references from its new
+         * version are added.
+         *
+         * Note: This handler will only work if either all object IDs are
+         *       positive or all object IDs are negative.
+         */
+        class ReverseIndexesBuilder : public osmium::handler::Handler {
+
+            ReverseIndexBuilder m_node_to_way;
+            ReverseIndexBuilder m_node_to_relation;
+            ReverseIndexBuilder m_way_to_relation;
+            ReverseIndexBuilder m_relation_to_relation;
+
+        public:
+
+            void way(const osmium::Way& way) {
+                m_node_to_way.remove_value(way.positive_id());
+                if (!way.visible()) {
+                    return;
+                }
+                for (const auto& node_ref : way.nodes()) {
+                    m_node_to_way.add(node_ref.positive_ref(), way.positive_id());
+                }
+            }
+
+            void relation(const osmium::Relation& relation) {
+                m_node_to_relation.remove_value(relation.positive_id());
+                m_way_to_relation.remove_value(relation.positive_id());
+                m_relation_to_relation.remove_value(relation.positive_id());
+                if (!relation.visible()) {
+                    return;
+                }
+                for (const auto& member : relation.members()) {
+                    switch (member.type()) {
+                        case osmium::item_type::node:
+                            m_node_to_relation.add(member.positive_ref(), relation.positive_id());
+                            break;
+                        case osmium::item_type::way:
+                            m_way_to_relation.add(member.positive_ref(), relation.positive_id());
+                            break;
+                        case osmium::item_type::relation:
+                            m_relation_to_relation.add(member.positive_ref(), relation.positive_id());
+                            break;
+                        default:
+                            break;
+                    }
+                }
+            }
+
+            /**
+             * Build the indexes from all ways and relations seen. The
+             * builder is empty afterwards.
+             */
+            ReverseIndexes build(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                ReverseIndexes indexes;
+                indexes.node_to_way = m_node_to_way.build(pool);
+                indexes.node_to_relation = m_node_to_relation.build(pool);
+                indexes.way_to_relation = m_way_to_relation.build(pool);
+                indexes.relation_to_relation = m_relation_to_relation.build(pool);
+                return indexes;
+            }
+
+            /**
+             * Build updated indexes from the existing indexes and the
+             * changed ways and relations seen. The builder is empty
+             * afterwards.
+             */
+            ReverseIndexes update(const ReverseIndexes& indexes, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                ReverseIndexes result;
+                result.node_to_way = m_node_to_way.update(indexes.node_to_way, pool);
+                result.node_to_relation = m_node_to_relation.update(indexes.node_to_relation, pool);
+                result.way_to_relation = m_way_to_relation.update(indexes.way_to_relation, pool);
+                result.relation_to_relation = m_relation_to_relation.update(indexes.relation_to_relation, pool);
+                return result;
+            }
+
+        }; // class ReverseIndexesBuilder
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_REVERSE_INDEX_HPP
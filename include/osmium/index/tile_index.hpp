@@ -0,0 +1,187 @@
+#ifndef OSMIUM_INDEX_TILE_INDEX_HPP
+#define OSMIUM_INDEX_TILE_INDEX_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/tile_cover.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            enum : std::size_t {
+                objects_per_tile_task = 1000
+            };
+
+            using tile_index_entries = std::vector<std::pair<uint64_t, std::size_t>>;
+
+            inline tile_index_entries tiles_for_object_range(const unsigned char* data,
+                                                             const osmium::OSMObject* const* begin,
+                                                             const osmium::OSMObject* const* end,
+                                                             uint32_t zoom) {
+                tile_index_entries entries;
+                osmium::geom::TileCover cover{zoom};
+                for (auto it = begin; it != end; ++it) {
+                    const osmium::OSMObject& object = **it;
+                    cover.clear();
+                    switch (object.type()) {
+                        case osmium::item_type::node:
+                            cover.add_location(static_cast<const osmium::Node&>(object).location());
+                            break;
+                        case osmium::item_type::way:
+                            cover.add_linestring(static_cast<const osmium::Way&>(object).nodes());
+                            break;
+                        case osmium::item_type::area:
+                            cover.add_area(static_cast<const osmium::Area&>(object));
+                            break;
+                        default:
+                            break;
+                    }
+                    const auto offset = static_cast<std::size_t>(reinterpret_cast<const unsigned char*>(&object) - data);
+                    for (const auto key : cover.tiles()) {
+                        entries.emplace_back(key, offset);
+                    }
+                }
+                return entries;
+            }
+
+            template <typename TMultimap>
+            std::size_t add_tile_index_entries(TMultimap& index, const tile_index_entries& entries) {
+                for (const auto& entry : entries) {
+                    index.set(entry.first, entry.second);
+                }
+                return entries.size();
+            }
+
+        } // namespace detail
+
+        /**
+         * Add the nodes, ways and areas in a buffer to a tile index, a
+         * multimap from tile keys (see osmium::geom::tile_key()) to the
+         * offsets of the objects in the buffer. Nodes are added to the
+         * tile containing their location, ways to all tiles their
+         * segments pass through and areas to all tiles their rings pass
+         * through or that are inside them (see osmium::geom::TileCover).
+         * Ways need their node locations set. Relations are ignored.
+         *
+         * The tiles are calculated in parallel on the thread pool for
+         * ranges of objects, the entries are then added to the index in
+         * the order of the objects in the buffer. Do not call this from a
+         * task running in the same pool, because it waits for the tasks
+         * it submits.
+         *
+         * Call sort() on the index after adding all buffers and before
+         * using get_all(). Because the offsets are relative to the buffer,
+         * use one index per buffer or keep track of which buffer an object
+         * is in yourself.
+         *
+         * Usage:
+         * @code
+         * osmium::index::multimap::SparseMemArray<uint64_t, std::size_t> index;
+         * osmium::index::add_to_tile_index(buffer, 14, index);
+         * index.sort();
+         * const auto range = index.get_all(osmium::geom::tile_key(tile));
+         * for (auto it = range.first; it != range.second; ++it) {
+         *     const auto& object = buffer.get<osmium::OSMObject>(it->second);
+         *     ...
+         * }
+         * @endcode
+         *
+         * @param buffer The buffer with the objects.
+         * @param zoom The zoom level of the tiles.
+         * @param index The multimap index. Use a SparseMmapArray for large
+         *              indexes.
+         * @param pool Thread pool to use.
+         * @returns The number of entries added to the index.
+         */
+        template <typename TMultimap>
+        std::size_t add_to_tile_index(const osmium::memory::Buffer& buffer,
+                                      uint32_t zoom,
+                                      TMultimap& index,
+                                      osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            std::vector<const osmium::OSMObject*> objects;
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                if (object.type() != osmium::item_type::relation) {
+                    objects.push_back(&object);
+                }
+            }
+
+            const unsigned char* data = buffer.data();
+            if (objects.size() <= detail::objects_per_tile_task) {
+                return detail::add_tile_index_entries(index, detail::tiles_for_object_range(data, objects.data(), objects.data() + objects.size(), zoom));
+            }
+
+            std::vector<std::future<detail::tile_index_entries>> results;
+            for (std::size_t n = 0; n < objects.size(); n += detail::objects_per_tile_task) {
+                const osmium::OSMObject* const* begin = objects.data() + n;
+                const osmium::OSMObject* const* end = objects.data() + std::min(objects.size(), n + detail::objects_per_tile_task);
+                results.push_back(pool.submit([data, begin, end, zoom]() {
+                    return detail::tiles_for_object_range(data, begin, end, zoom);
+                }));
+            }
+
+            // Wait for all tasks before getting the results, a task might
+            // throw, but the others still use the objects vector.
+            for (auto& result : results) {
+                result.wait();
+            }
+
+            std::size_t count = 0;
+            for (auto& result : results) {
+                count += detail::add_tile_index_entries(index, result.get());
+            }
+            return count;
+        }
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_TILE_INDEX_HPP
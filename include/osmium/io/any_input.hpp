@@ -45,6 +45,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/any_compression.hpp> // IWYU pragma: export
 
+#include <osmium/io/buffer_file_input.hpp> // IWYU pragma: export
 #include <osmium/io/o5m_input.hpp> // IWYU pragma: export
 #include <osmium/io/opl_input.hpp> // IWYU pragma: export
 #include <osmium/io/pbf_input.hpp> // IWYU pragma: export
@@ -0,0 +1,368 @@
+#ifndef OSMIUM_IO_APPLY_CHANGES_HPP
+#define OSMIUM_IO_APPLY_CHANGES_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/indexed_pbf_reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/misc.hpp>
+
+#include <protozero/data_view.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Order objects by type and ID only, in the order used in
+             * sorted OSM files (see operator< on OSMObject).
+             */
+            inline bool object_key_less(const osmium::OSMObject& lhs, const osmium::OSMObject& rhs) noexcept {
+                return const_tie(lhs.type(), lhs.id() > 0, lhs.positive_id()) <
+                       const_tie(rhs.type(), rhs.id() > 0, rhs.positive_id());
+            }
+
+        } // namespace detail
+
+        /**
+         * Holds the objects from one or more change files in memory,
+         * sorted in the order used in sorted OSM files and with only the
+         * newest version of each object kept. If several change files
+         * contain the same version of an object, the one added last wins.
+         *
+         * Add all changes with add_buffer() or read() and then call
+         * sort().
+         */
+        class SortedChanges {
+
+            std::vector<osmium::memory::Buffer> m_buffers;
+            std::vector<const osmium::OSMObject*> m_objects;
+            bool m_sorted = true;
+
+        public:
+
+            using const_iterator = std::vector<const osmium::OSMObject*>::const_iterator;
+
+            SortedChanges() = default;
+
+            /**
+             * Add all objects in the buffer. The buffer is kept until
+             * this object is destroyed.
+             */
+            void add_buffer(osmium::memory::Buffer&& buffer) {
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    m_objects.push_back(&object);
+                }
+                m_buffers.push_back(std::move(buffer));
+                m_sorted = false;
+            }
+
+            /**
+             * Read all buffers from the source (usually an
+             * osmium::io::Reader opened on a change file) and add them.
+             */
+            template <typename TSource>
+            void read(TSource& source) {
+                while (osmium::memory::Buffer buffer = source.read()) {
+                    add_buffer(std::move(buffer));
+                }
+            }
+
+            /**
+             * Sort all objects and remove all but the newest version of
+             * each object. Does nothing if nothing was added since the
+             * last call.
+             */
+            void sort() {
+                if (m_sorted) {
+                    return;
+                }
+
+                std::stable_sort(m_objects.begin(), m_objects.end(), [](const osmium::OSMObject* lhs, const osmium::OSMObject* rhs) {
+                    return const_tie(lhs->type(), lhs->id() > 0, lhs->positive_id(), lhs->version()) <
+                           const_tie(rhs->type(), rhs->id() > 0, rhs->positive_id(), rhs->version());
+                });
+
+                // keep only the last object of each run with the same type
+                // and id
+                auto out = m_objects.begin();
+                for (auto it = m_objects.begin(); it != m_objects.end(); ++it) {
+                    const auto next = std::next(it);
+                    if (next == m_objects.end() || detail::object_key_less(**it, **next)) {
+                        *out++ = *it;
+                    }
+                }
+                m_objects.erase(out, m_objects.end());
+
+                m_sorted = true;
+            }
+
+            /// Has sort() been called after the last object was added?
+            bool sorted() const noexcept {
+                return m_sorted;
+            }
+
+            /// The number of objects (after sort() this is one per object).
+            std::size_t size() const noexcept {
+                return m_objects.size();
+            }
+
+            bool empty() const noexcept {
+                return m_objects.empty();
+            }
+
+            const_iterator begin() const noexcept {
+                return m_objects.cbegin();
+            }
+
+            const_iterator end() const noexcept {
+                return m_objects.cend();
+            }
+
+        }; // class SortedChanges
+
+        /**
+         * Merges the changes in a SortedChanges object into a stream of
+         * sorted OSM objects (usually read from a file containing a single
+         * version of each object sorted by type and ID) and writes the
+         * result to a Writer. Changed objects replace the original
+         * objects, deleted objects (those with the visible flag not set)
+         * are removed. Only the current buffer is held in memory, all
+         * output goes through the buffer of the Writer.
+         *
+         * Call the merger on all buffers in order and then call finish().
+         * Usually you will want to use one of the apply_changes()
+         * functions instead.
+         */
+        class ChangeMerger {
+
+            osmium::io::Writer* m_writer;
+            SortedChanges::const_iterator m_next;
+            SortedChanges::const_iterator m_end;
+
+            void write_change(const osmium::OSMObject& object) {
+                if (object.visible()) {
+                    (*m_writer)(object);
+                }
+            }
+
+            // Write all changes which sort before the object.
+            void write_changes_before(const osmium::OSMObject& object) {
+                while (m_next != m_end && detail::object_key_less(**m_next, object)) {
+                    write_change(**m_next);
+                    ++m_next;
+                }
+            }
+
+            // Does the object sort before an object with the given type and
+            // (positive) id?
+            static bool sorts_before(const osmium::OSMObject& object, osmium::item_type type, osmium::object_id_type id) noexcept {
+                return object.type() < type ||
+                       (object.type() == type && (object.id() <= 0 || object.id() < id));
+            }
+
+            // Index of the first type in the blob.
+            static std::size_t first_type_index(const osmium::io::pbf_blob_summary& summary) noexcept {
+                for (std::size_t n = 0; n < 3; ++n) {
+                    if (summary.types & osmium::osm_entity_bits::from_item_type(osmium::nwr_index_to_item_type(n))) {
+                        return n;
+                    }
+                }
+                return 3;
+            }
+
+        public:
+
+            /**
+             * Create merger. The changes are sorted if this hasn't happened
+             * already. Both the changes and the writer must be kept alive
+             * as long as the merger is used.
+             */
+            ChangeMerger(SortedChanges& changes, osmium::io::Writer& writer) :
+                m_writer(&writer) {
+                changes.sort();
+                m_next = changes.begin();
+                m_end = changes.end();
+            }
+
+            /// Merge the changes with a single object from the input.
+            void operator()(const osmium::OSMObject& object) {
+                write_changes_before(object);
+                if (m_next != m_end && !detail::object_key_less(object, **m_next)) {
+                    write_change(**m_next);
+                    ++m_next;
+                } else {
+                    (*m_writer)(object);
+                }
+            }
+
+            /// Merge the changes with all objects in the buffer.
+            void operator()(const osmium::memory::Buffer& buffer) {
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    operator()(object);
+                }
+            }
+
+            /**
+             * Can a PBF data blob with the given summary be copied to the
+             * output unchanged? This is the case if none of the changes
+             * falls into the range of objects in the blob. Blobs with
+             * negative IDs are never copied, because their order doesn't
+             * match the numerical order of the IDs.
+             */
+            bool can_copy(const osmium::io::pbf_blob_summary& summary) const noexcept {
+                if (summary.types == osmium::osm_entity_bits::nothing) {
+                    return false;
+                }
+
+                std::size_t last = 0;
+                for (std::size_t n = 0; n < 3; ++n) {
+                    if (summary.types & osmium::osm_entity_bits::from_item_type(osmium::nwr_index_to_item_type(n))) {
+                        if (summary.min_id[n] <= 0) {
+                            return false;
+                        }
+                        last = n;
+                    }
+                }
+                const std::size_t first = first_type_index(summary);
+
+                // all changes before the start of this blob will be
+                // written first, so we need to look at the first change
+                // not before the start of the blob only
+                auto it = m_next;
+                const auto first_type = osmium::nwr_index_to_item_type(first);
+                while (it != m_end && sorts_before(**it, first_type, summary.min_id[first])) {
+                    ++it;
+                }
+                if (it == m_end) {
+                    return true;
+                }
+
+                const auto last_type = osmium::nwr_index_to_item_type(last);
+                return (*it)->type() > last_type ||
+                       ((*it)->type() == last_type && (*it)->id() > summary.max_id[last]);
+            }
+
+            /**
+             * Write a PBF data blob unchanged to the output. All changes
+             * sorting before the first object in it are written first.
+             *
+             * @pre @code can_copy(summary) @endcode
+             * @pre The writer supports raw blobs.
+             */
+            void copy_blob(const osmium::io::pbf_blob_summary& summary, const protozero::data_view& blob) {
+                const std::size_t first = first_type_index(summary);
+                const auto first_type = osmium::nwr_index_to_item_type(first);
+                while (m_next != m_end && sorts_before(**m_next, first_type, summary.min_id[first])) {
+                    write_change(**m_next);
+                    ++m_next;
+                }
+                m_writer->write_raw_blob(std::string{blob.data(), blob.size()});
+            }
+
+            /// Write all remaining changes. Call this after the last input.
+            void finish() {
+                while (m_next != m_end) {
+                    write_change(**m_next);
+                    ++m_next;
+                }
+            }
+
+        }; // class ChangeMerger
+
+        /**
+         * Apply changes to the OSM data read from source (usually an
+         * osmium::io::Reader) and write the result to the writer. The
+         * input must contain only one version of each object and be
+         * sorted by type and ID. The writer is not closed.
+         */
+        template <typename TSource>
+        void apply_changes(TSource& source, SortedChanges& changes, osmium::io::Writer& writer) {
+            ChangeMerger merger{changes, writer};
+            while (osmium::memory::Buffer buffer = source.read()) {
+                merger(buffer);
+            }
+            merger.finish();
+        }
+
+        /**
+         * Apply changes to the OSM data in a PBF file and write the result
+         * to the writer. The input must contain only one version of each
+         * object and be sorted by type and ID. The writer is not closed.
+         *
+         * If the writer writes PBF, data blobs not touched by any of the
+         * changes are copied to the output without decoding and encoding
+         * them again. This needs the blob summaries from the reader which
+         * are built on first use (or read from the sidecar index file).
+         * Other blobs are decoded one at a time.
+         *
+         * @returns The number of data blobs copied unchanged.
+         */
+        inline std::size_t apply_changes(osmium::io::IndexedPBFReader& source, SortedChanges& changes, osmium::io::Writer& writer) {
+            ChangeMerger merger{changes, writer};
+            std::size_t copied = 0;
+
+            const bool copy_blobs = writer.supports_raw_blobs();
+            for (std::size_t n = 0; n < source.num_data_blobs(); ++n) {
+                if (copy_blobs && merger.can_copy(source.summaries()[n])) {
+                    merger.copy_blob(source.summaries()[n], source.raw_blob(n));
+                    ++copied;
+                } else {
+                    merger(source.read_blob(n));
+                }
+            }
+            merger.finish();
+
+            return copied;
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_APPLY_CHANGES_HPP
@@ -0,0 +1,238 @@
+#ifndef OSMIUM_IO_BUFFER_FILE_READER_HPP
+#define OSMIUM_IO_BUFFER_FILE_READER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to access the buffers in an osmium buffer
+ * file directly in memory without copying them.
+ */
+
+#include <osmium/io/detail/buffer_file.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Memory maps an (uncompressed) osmium buffer file and gives access
+         * to the buffers stored in it without parsing or copying any data.
+         * Buffer files are written by the Writer if the file has the suffix
+         * ".osmb" or the format "buffer" is set. They can also be read with
+         * the normal Reader.
+         *
+         * The file is mapped copy-on-write, so the buffers returned can be
+         * changed, but the changes will not end up in the file. The buffers
+         * do not own their memory, they are only valid as long as the
+         * BufferFileReader they came from exists.
+         *
+         * Only the structure of the file is checked, not the contents of
+         * the buffers, so this should only be used with files from a
+         * trusted source.
+         */
+        class BufferFileReader {
+
+            osmium::util::MemoryMapping m_mapping;
+            osmium::io::Header m_header;
+            std::vector<detail::buffer_file_page_info> m_pages;
+            std::size_t m_next_page = 0;
+
+            static osmium::util::MemoryMapping map_file(const std::string& filename) {
+                const int fd = detail::open_for_reading(filename);
+                try {
+                    const auto size = osmium::file_size(fd);
+                    if (size == 0) {
+                        throw osmium::buffer_file_error{"empty file"};
+                    }
+                    osmium::util::MemoryMapping mapping{size, osmium::util::MemoryMapping::mapping_mode::write_private, fd};
+                    detail::reliable_close(fd);
+                    return mapping;
+                } catch (...) {
+                    try {
+                        detail::reliable_close(fd);
+                    } catch (...) {
+                        // ignore errors on close, report original error
+                    }
+                    throw;
+                }
+            }
+
+            const char* data() const noexcept {
+                return m_mapping.get_addr<char>();
+            }
+
+            std::size_t size() const noexcept {
+                return m_mapping.size();
+            }
+
+            void read_index() {
+                if (size() < detail::buffer_file_fixed_header_size + detail::buffer_file_page_header_size + detail::buffer_file_trailer_size) {
+                    throw osmium::buffer_file_error{"file too small"};
+                }
+
+                const std::size_t header_size = detail::check_buffer_file_header(data());
+                if (header_size > size() - detail::buffer_file_page_header_size - detail::buffer_file_trailer_size) {
+                    throw osmium::buffer_file_error{"truncated header"};
+                }
+                m_header = detail::decode_buffer_file_header(data() + detail::buffer_file_fixed_header_size,
+                                                             header_size - detail::buffer_file_fixed_header_size);
+
+                const char* trailer = data() + size() - detail::buffer_file_trailer_size;
+                if (std::memcmp(trailer + 2 * sizeof(uint64_t), detail::buffer_file_end_magic(), detail::buffer_file_magic_size) != 0) {
+                    throw osmium::buffer_file_error{"missing end of file marker (file truncated?)"};
+                }
+                const auto index_offset = detail::get_native<uint64_t>(trailer);
+                const auto num_pages = detail::get_native<uint64_t>(trailer + sizeof(uint64_t));
+
+                // the index must be directly before the trailer and
+                // directly after the end marker
+                if (index_offset < header_size + detail::buffer_file_page_header_size ||
+                    index_offset > size() - detail::buffer_file_trailer_size ||
+                    (size() - detail::buffer_file_trailer_size - index_offset) / detail::buffer_file_index_entry_size != num_pages ||
+                    (size() - detail::buffer_file_trailer_size - index_offset) % detail::buffer_file_index_entry_size != 0) {
+                    throw osmium::buffer_file_error{"invalid index"};
+                }
+                const auto pages_end = index_offset - detail::buffer_file_page_header_size;
+                if (detail::get_native<uint64_t>(data() + pages_end) != 0) {
+                    throw osmium::buffer_file_error{"missing end marker"};
+                }
+
+                m_pages.reserve(num_pages);
+                const char* entry = data() + index_offset;
+                std::size_t expected_offset = header_size + detail::buffer_file_page_header_size;
+                for (uint64_t n = 0; n < num_pages; ++n) {
+                    auto page = detail::decode_buffer_file_page_header(entry + sizeof(uint64_t));
+                    page.offset = detail::get_native<uint64_t>(entry);
+                    if (page.offset != expected_offset || page.offset > pages_end || page.size == 0 ||
+                        page.size > pages_end - page.offset ||
+                        std::memcmp(entry + sizeof(uint64_t), data() + page.offset - detail::buffer_file_page_header_size, detail::buffer_file_page_header_size) != 0) {
+                        throw osmium::buffer_file_error{"index does not match pages"};
+                    }
+                    m_pages.push_back(page);
+                    expected_offset = page.offset + page.size + detail::buffer_file_page_header_size;
+                    entry += detail::buffer_file_index_entry_size;
+                }
+                if (expected_offset != index_offset) {
+                    throw osmium::buffer_file_error{"index does not match pages"};
+                }
+            }
+
+        public:
+
+            /**
+             * Open an osmium buffer file.
+             *
+             * @param filename Name of the (uncompressed) buffer file.
+             * @throws osmium::buffer_file_error If the file is not a valid
+             *         buffer file or was written on a machine with a
+             *         different byte order.
+             * @throws std::system_error If the file can not be opened or
+             *         mapped.
+             */
+            explicit BufferFileReader(const std::string& filename) :
+                m_mapping(map_file(filename)) {
+                read_index();
+            }
+
+            /// Get the header of the file.
+            const osmium::io::Header& header() const noexcept {
+                return m_header;
+            }
+
+            /// The number of buffers (pages) in the file.
+            std::size_t num_pages() const noexcept {
+                return m_pages.size();
+            }
+
+            /// The types of the items in the nth page.
+            osmium::osm_entity_bits::type page_types(std::size_t n) const noexcept {
+                return m_pages[n].types;
+            }
+
+            /// The number of items in the nth page.
+            std::size_t page_count(std::size_t n) const noexcept {
+                return m_pages[n].count;
+            }
+
+            /**
+             * Get the nth page as a buffer pointing into the mapped file.
+             *
+             * @pre n < num_pages()
+             */
+            osmium::memory::Buffer page(std::size_t n) const {
+                const auto& info = m_pages[n];
+                return osmium::memory::Buffer{m_mapping.get_addr<unsigned char>() + info.offset, info.size};
+            }
+
+            /**
+             * Get the next page containing any objects of the given types.
+             * Pages can contain objects of several types, so the buffer
+             * can contain objects of other types, too. Returns an invalid
+             * buffer if there are no more pages.
+             */
+            osmium::memory::Buffer read(osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::all) {
+                while (m_next_page < m_pages.size()) {
+                    const auto n = m_next_page++;
+                    if (m_pages[n].types & entities) {
+                        return page(n);
+                    }
+                }
+                return osmium::memory::Buffer{};
+            }
+
+            /// Start reading from the first page again.
+            void rewind() noexcept {
+                m_next_page = 0;
+            }
+
+        }; // class BufferFileReader
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_BUFFER_FILE_READER_HPP
@@ -43,17 +43,23 @@ DEALINGS IN THE SOFTWARE.
  */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/parallel_compressor.hpp>
+#include <osmium/io/detail/parallel_decompressor.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/util/config.hpp>
 #include <osmium/util/file.hpp>
 
 #include <bzlib.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <cstddef>
 #include <cstdio>
+#include <cstring>
 #include <limits>
 #include <string>
 #include <system_error>
@@ -411,11 +417,168 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Splitting and decompressing of bzip2 files with many streams
+             * for the ParallelDecompressor. There is no index of the
+             * streams, so the start of the next stream is found by looking
+             * for the stream header followed by the magic number of the
+             * first block. This pattern could also appear inside the
+             * compressed data, the ParallelDecompressor will detect that
+             * and join the chunks.
+             */
+            struct bzip2_multistream_format {
+
+                enum {
+                    target_chunk_size = 1024UL * 1024UL,
+                    max_search_size = 16UL * 1024UL * 1024UL,
+                    header_size = 10
+                };
+
+                static bool is_stream_start(const char* data) noexcept {
+                    return data[0] == 'B' && data[1] == 'Z' && data[2] == 'h' &&
+                           data[3] >= '1' && data[3] <= '9' &&
+                           std::memcmp(data + 4, "\x31\x41\x59\x26\x53\x59", 6) == 0;
+                }
+
+                /**
+                 * Find the first stream start at or after offset start.
+                 * Returns size if there is none.
+                 */
+                static std::size_t find_stream_start(const char* data, const std::size_t size, std::size_t start) noexcept {
+                    while (start + header_size <= size) {
+                        const auto* p = static_cast<const char*>(std::memchr(data + start, 'B', size - start - header_size + 1));
+                        if (!p) {
+                            break;
+                        }
+                        if (is_stream_start(p)) {
+                            return static_cast<std::size_t>(p - data);
+                        }
+                        start = static_cast<std::size_t>(p - data) + 1;
+                    }
+                    return size;
+                }
+
+                static bool is_suitable(const char* data, const std::size_t size) noexcept {
+                    if (size < header_size || !is_stream_start(data)) {
+                        return false;
+                    }
+                    const std::size_t search_size = std::min<std::size_t>(size, max_search_size);
+                    return find_stream_start(data, search_size, 1) != search_size;
+                }
+
+                static std::size_t next_chunk_size(const char* data, const std::size_t size) noexcept {
+                    if (size <= target_chunk_size) {
+                        return size;
+                    }
+                    return find_stream_start(data, size, target_chunk_size);
+                }
+
+                static decompressed_chunk decompress_chunk(const char* data, const std::size_t size) {
+                    decompressed_chunk result;
+                    result.data.reserve(size * 5);
+
+                    std::size_t read = 0;
+                    std::size_t written = 0;
+                    while (read < size) {
+                        bz_stream bzstream{};
+                        bzstream.next_in = const_cast<char*>(data + read);
+                        assert(size - read < std::numeric_limits<unsigned int>::max());
+                        bzstream.avail_in = static_cast<unsigned int>(size - read);
+
+                        int status = BZ2_bzDecompressInit(&bzstream, 0, 0);
+                        if (status != BZ_OK) {
+                            throw bzip2_error{"bzip2 error: decompression init failed: ", status};
+                        }
+
+                        do {
+                            if (result.data.size() - written < 64U * 1024U) {
+                                result.data.resize(written + std::max<std::size_t>(64U * 1024U, result.data.size()));
+                            }
+                            bzstream.next_out = &result.data[written];
+                            bzstream.avail_out = static_cast<unsigned int>(result.data.size() - written);
+                            status = BZ2_bzDecompress(&bzstream);
+                            written = result.data.size() - bzstream.avail_out;
+                        } while (status == BZ_OK && (bzstream.avail_in > 0 || bzstream.avail_out == 0));
+
+                        BZ2_bzDecompressEnd(&bzstream);
+
+                        if (status == BZ_OK) {
+                            // Input ended in the middle of a stream.
+                            result.complete = false;
+                            break;
+                        }
+
+                        if (status != BZ_STREAM_END) {
+                            throw bzip2_error{"bzip2 error: decompress failed: ", status};
+                        }
+
+                        read = size - bzstream.avail_in;
+                    }
+
+                    result.data.resize(written);
+                    return result;
+                }
+
+            }; // struct bzip2_multistream_format
+
+            /**
+             * Compression of chunks into independent bzip2 streams for the
+             * ParallelCompressor. The result is a multi-stream file as
+             * written by pbzip2, which can be read by all bzip2 tools.
+             */
+            struct bzip2_multistream_compress_format {
+
+                enum {
+                    target_chunk_size = 900UL * 1024UL
+                };
+
+                static std::string compress_chunk(const char* data, const std::size_t size) {
+                    assert(size < std::numeric_limits<unsigned int>::max() / 2);
+
+                    // Worst case output size as documented by the bzip2 library
+                    std::string output(size + size / 100 + 600, '\0');
+                    auto output_size = static_cast<unsigned int>(output.size());
+
+                    const int result = ::BZ2_bzBuffToBuffCompress(&*output.begin(),
+                                                                  &output_size,
+                                                                  const_cast<char*>(data),
+                                                                  static_cast<unsigned int>(size),
+                                                                  6, 0, 0);
+                    if (result != BZ_OK) {
+                        throw bzip2_error{"bzip2 error: compression failed", result};
+                    }
+
+                    output.resize(output_size);
+                    return output;
+                }
+
+                void chunk_written(std::size_t /*input_size*/, std::size_t /*output_size*/) noexcept {
+                }
+
+                static std::string end_marker() {
+                    return {};
+                }
+
+            }; // struct bzip2_multistream_compress_format
+
             // we want the register_compression() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_bzip2_compression = osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::bzip2,
-                [](const int fd, const fsync sync) { return new osmium::io::Bzip2Compressor{fd, sync}; },
-                [](const int fd) { return new osmium::io::Bzip2Decompressor{fd}; },
+                [](const int fd, const fsync sync) -> osmium::io::Compressor* {
+                    if (osmium::config::use_parallel_compression()) {
+                        return new ParallelCompressor<bzip2_multistream_compress_format>{fd, sync, osmium::thread::Pool::default_instance()};
+                    }
+                    return new osmium::io::Bzip2Compressor{fd, sync};
+                },
+                [](const int fd) -> osmium::io::Decompressor* {
+                    if (osmium::config::use_parallel_decompression()) {
+                        auto* decompressor = make_parallel_decompressor<bzip2_multistream_format>(fd);
+                        if (decompressor) {
+                            return decompressor;
+                        }
+                    }
+                    return new osmium::io::Bzip2Decompressor{fd};
+                },
                 [](const char* buffer, const std::size_t size) { return new osmium::io::Bzip2BufferDecompressor{buffer, size}; }
             );
 
@@ -34,11 +34,15 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/detail/uring_reader.hpp>
+#include <osmium/io/detail/uring_writer.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/util/config.hpp>
 #include <osmium/util/file.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <cerrno>
 #include <cstddef>
@@ -230,11 +234,42 @@ namespace osmium {
             std::size_t m_file_size = 0;
             int m_fd;
 
+#ifdef OSMIUM_WITH_IO_URING
+            std::unique_ptr<osmium::io::detail::UringWriter> m_uring_writer;
+
+            void setup_uring_writer() {
+                if (!osmium::config::use_io_uring_for_writing() || m_fd == 1 || !osmium::io::detail::can_use_io_uring(m_fd)) {
+                    return;
+                }
+
+                const int flags = ::fcntl(m_fd, F_GETFL);
+                if (flags == -1 || (flags & O_APPEND) != 0) {
+                    return;
+                }
+
+                const int depth = osmium::config::get_io_uring_queue_depth();
+                const std::size_t queue_depth = depth > 0 ? std::min(static_cast<std::size_t>(depth), static_cast<std::size_t>(osmium::io::detail::UringWriter::max_queue_depth))
+                                                          : static_cast<std::size_t>(osmium::io::detail::UringWriter::default_queue_depth);
+                try {
+                    m_uring_writer.reset(new osmium::io::detail::UringWriter{m_fd,
+                                                                             osmium::io::detail::UringWriter::default_block_size,
+                                                                             queue_depth,
+                                                                             osmium::config::use_direct_io()});
+                } catch (const std::system_error&) {
+                    // io_uring is not available (old kernel or disabled),
+                    // use normal writes.
+                }
+            }
+#endif
+
         public:
 
             NoCompressor(const int fd, const fsync sync) :
                 Compressor(sync),
                 m_fd(fd) {
+#ifdef OSMIUM_WITH_IO_URING
+                setup_uring_writer();
+#endif
             }
 
             NoCompressor(const NoCompressor&) = delete;
@@ -252,12 +287,25 @@ namespace osmium {
             }
 
             void write(const std::string& data) override {
+#ifdef OSMIUM_WITH_IO_URING
+                if (m_uring_writer) {
+                    m_uring_writer->write(data.data(), data.size());
+                    m_file_size += data.size();
+                    return;
+                }
+#endif
                 osmium::io::detail::reliable_write(m_fd, data.data(), data.size());
                 m_file_size += data.size();
             }
 
             void close() override {
                 if (m_fd >= 0) {
+#ifdef OSMIUM_WITH_IO_URING
+                    if (m_uring_writer) {
+                        const std::unique_ptr<osmium::io::detail::UringWriter> writer{std::move(m_uring_writer)};
+                        writer->flush();
+                    }
+#endif
                     const int fd = m_fd;
                     m_fd = -1;
 
@@ -317,10 +365,57 @@ namespace osmium {
             std::size_t m_buffer_size = 0;
             std::size_t m_offset = 0;
 
+#ifdef OSMIUM_WITH_IO_URING
+            std::unique_ptr<osmium::io::detail::UringReader> m_uring_reader;
+
+            void setup_uring_reader() {
+                if (!osmium::config::use_io_uring() || !osmium::io::detail::can_use_io_uring(m_fd)) {
+                    return;
+                }
+
+                const int depth = osmium::config::get_io_uring_queue_depth();
+                const std::size_t queue_depth = depth > 0 ? std::min(static_cast<std::size_t>(depth), static_cast<std::size_t>(osmium::io::detail::UringReader::max_queue_depth))
+                                                          : static_cast<std::size_t>(osmium::io::detail::UringReader::default_queue_depth);
+                try {
+                    m_uring_reader.reset(new osmium::io::detail::UringReader{m_fd,
+                                                                             osmium::io::Decompressor::input_buffer_size,
+                                                                             queue_depth,
+                                                                             osmium::config::use_direct_io()});
+                } catch (const std::system_error&) {
+                    // io_uring is not available (old kernel or disabled),
+                    // use normal reads.
+                }
+            }
+#endif
+
+            std::string read_from_fd() {
+#ifdef OSMIUM_WITH_IO_URING
+                if (m_uring_reader) {
+                    // Pages read with O_DIRECT are never in the buffer cache.
+                    if (want_buffered_pages_removed() && !m_uring_reader->direct()) {
+                        osmium::io::detail::remove_buffered_pages(m_fd, m_offset);
+                    }
+                    return m_uring_reader->read();
+                }
+#endif
+
+                std::string buffer(osmium::io::Decompressor::input_buffer_size, '\0');
+                if (want_buffered_pages_removed()) {
+                    osmium::io::detail::remove_buffered_pages(m_fd, m_offset);
+                }
+                const auto nread = detail::reliable_read(m_fd, &*buffer.begin(), osmium::io::Decompressor::input_buffer_size);
+                buffer.resize(std::string::size_type(nread));
+                return buffer;
+            }
+
         public:
 
             explicit NoDecompressor(const int fd) :
                 m_fd(fd) {
+                osmium::io::detail::advise_sequential_access(fd);
+#ifdef OSMIUM_WITH_IO_URING
+                setup_uring_reader();
+#endif
             }
 
             NoDecompressor(const char* buffer, const std::size_t size) :
@@ -352,12 +447,7 @@ namespace osmium {
                         buffer.append(m_buffer, size);
                     }
                 } else {
-                    buffer.resize(osmium::io::Decompressor::input_buffer_size);
-                    if (want_buffered_pages_removed()) {
-                        osmium::io::detail::remove_buffered_pages(m_fd, m_offset);
-                    }
-                    const auto nread = detail::reliable_read(m_fd, &*buffer.begin(), osmium::io::Decompressor::input_buffer_size);
-                    buffer.resize(std::string::size_type(nread));
+                    buffer = read_from_fd();
                 }
 
                 m_offset += buffer.size();
@@ -368,6 +458,9 @@ namespace osmium {
 
             void close() override {
                 if (m_fd >= 0) {
+#ifdef OSMIUM_WITH_IO_URING
+                    m_uring_reader.reset();
+#endif
                     if (want_buffered_pages_removed()) {
                         osmium::io::detail::remove_buffered_pages(m_fd);
                     }
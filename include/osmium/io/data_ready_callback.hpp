@@ -0,0 +1,97 @@
+#ifndef OSMIUM_IO_DATA_READY_CALLBACK_HPP
+#define OSMIUM_IO_DATA_READY_CALLBACK_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <functional>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Option for the osmium::io::Reader: A function that is called
+         * whenever Reader::try_read() might have something new to return,
+         * ie. a buffer, the end of file, or an error. Together with
+         * try_read() this allows event-driven programs to handle many
+         * Readers in a few threads without ever blocking on one of them.
+         *
+         * The function is called from the parser thread or from the pool
+         * thread that just decoded a buffer, so it must be thread-safe and
+         * it should return quickly. Usually it just wakes up the event
+         * loop of the program, which then calls try_read(). Calls can be
+         * spurious, try_read() can still return false afterwards. The
+         * function must not call any functions on the Reader itself.
+         *
+         * Usage:
+         * @code
+         * osmium::io::Reader reader{file, osmium::io::data_ready_callback{
+         *     [&]() { loop.wake_up(); }}};
+         * ...
+         * osmium::memory::Buffer buffer;
+         * while (reader.try_read(buffer)) {
+         *     if (!buffer) { ... eof ... }
+         *     ...
+         * }
+         * @endcode
+         */
+        class data_ready_callback {
+
+            std::function<void()> m_function;
+
+        public:
+
+            data_ready_callback() = default;
+
+            explicit data_ready_callback(std::function<void()> function) :
+                m_function(std::move(function)) {
+            }
+
+            explicit operator bool() const noexcept {
+                return static_cast<bool>(m_function);
+            }
+
+            void operator()() const {
+                if (m_function) {
+                    m_function();
+                }
+            }
+
+        }; // class data_ready_callback
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DATA_READY_CALLBACK_HPP
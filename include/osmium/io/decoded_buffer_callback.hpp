@@ -0,0 +1,99 @@
+#ifndef OSMIUM_IO_DECODED_BUFFER_CALLBACK_HPP
+#define OSMIUM_IO_DECODED_BUFFER_CALLBACK_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+
+#include <functional>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Option for the osmium::io::Reader: A function that is called for
+         * each buffer right after it was decoded and before it is handed
+         * to the user through Reader::read().
+         *
+         * For formats which are decoded in the thread pool (currently
+         * only PBF) the function is called in the pool worker that
+         * decoded the buffer, ie. it is called from several threads at
+         * the same time and must be thread-safe. This can be used to do
+         * work that scales with the number of cores, for instance
+         * filling a node location index through
+         * VectorBasedDenseMap::set_concurrent(). For all other formats
+         * the function is called in the parser thread.
+         *
+         * Buffers are still delivered to the user in order, and the
+         * function has finished with a buffer before the user sees it.
+         * Exceptions thrown from the function are reported from
+         * Reader::read().
+         *
+         * Usage:
+         * @code
+         * osmium::io::Reader reader{file, osmium::io::decoded_buffer_callback{
+         *     [&](osmium::memory::Buffer& buffer) { ... }}};
+         * @endcode
+         */
+        class decoded_buffer_callback {
+
+            std::function<void(osmium::memory::Buffer&)> m_function;
+
+        public:
+
+            decoded_buffer_callback() = default;
+
+            explicit decoded_buffer_callback(std::function<void(osmium::memory::Buffer&)> function) :
+                m_function(std::move(function)) {
+            }
+
+            explicit operator bool() const noexcept {
+                return static_cast<bool>(m_function);
+            }
+
+            void operator()(osmium::memory::Buffer& buffer) const {
+                if (m_function) {
+                    m_function(buffer);
+                }
+            }
+
+        }; // class decoded_buffer_callback
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DECODED_BUFFER_CALLBACK_HPP
@@ -0,0 +1,330 @@
+#ifndef OSMIUM_IO_DETAIL_BUFFER_FILE_HPP
+#define OSMIUM_IO_DETAIL_BUFFER_FILE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/error.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when there was a problem with the format of an
+     * osmium buffer file.
+     */
+    struct buffer_file_error : public io_error {
+
+        explicit buffer_file_error(const std::string& what) :
+            io_error(std::string("Buffer file error: ") + what) {
+        }
+
+        explicit buffer_file_error(const char* what) :
+            io_error(std::string("Buffer file error: ") + what) {
+        }
+
+    }; // struct buffer_file_error
+
+    namespace io {
+
+        namespace detail {
+
+            /*
+             * An osmium buffer file contains the committed bytes of
+             * osmium::memory::Buffer's as they are in memory, so they can
+             * be used without any decoding. All numbers are in native byte
+             * order, files can only be read on machines with the same byte
+             * order and alignment as the one they were written on. Layout:
+             *
+             * Header (size is a multiple of 8 bytes):
+             *   8 bytes  magic "OSMIUMBF"
+             *   uint32   format version
+             *   uint32   byte order mark (0x01020304)
+             *   uint32   osmium::memory::align_bytes
+             *   uint32   size of the header data following
+             *   header data: number of boxes (uint32), boxes (4 x int32
+             *   each), multiple object versions flag (uint32), number of
+             *   options (uint32), options (uint32 length + bytes for key
+             *   and value each), padded with zeros to a multiple of 8
+             *
+             * Any number of pages:
+             *   uint64   size of the buffer data (a multiple of 8, not 0)
+             *   uint32   osm_entity_bits of all items in the page
+             *   uint32   number of items in the page
+             *   the committed data of the buffer
+             *
+             * End marker: a page header with all fields set to 0.
+             *
+             * Index: for each page its offset in the file (uint64) and its
+             * page header.
+             *
+             * Trailer:
+             *   uint64   offset of the index in the file
+             *   uint64   number of pages
+             *   8 bytes  magic "OSMBFEND"
+             */
+
+            constexpr const uint32_t buffer_file_version = 1;
+            constexpr const uint32_t buffer_file_byte_order_mark = 0x01020304U;
+
+            constexpr const std::size_t buffer_file_magic_size = 8;
+            constexpr const std::size_t buffer_file_fixed_header_size = buffer_file_magic_size + 4 * sizeof(uint32_t);
+            constexpr const std::size_t buffer_file_page_header_size = 2 * sizeof(uint64_t);
+            constexpr const std::size_t buffer_file_index_entry_size = sizeof(uint64_t) + buffer_file_page_header_size;
+            constexpr const std::size_t buffer_file_trailer_size = 2 * sizeof(uint64_t) + buffer_file_magic_size;
+
+            inline const char* buffer_file_magic() noexcept {
+                return "OSMIUMBF";
+            }
+
+            inline const char* buffer_file_end_magic() noexcept {
+                return "OSMBFEND";
+            }
+
+            /// Information about one page in an osmium buffer file.
+            struct buffer_file_page_info {
+
+                /// Offset of the page data (after the page header) in the file.
+                uint64_t offset = 0;
+
+                /// Size of the page data in bytes.
+                uint64_t size = 0;
+
+                /// Types of all items in the page.
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+                /// Number of items in the page.
+                uint32_t count = 0;
+
+            }; // struct buffer_file_page_info
+
+            template <typename T>
+            inline void append_native(std::string& out, T value) {
+                out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+            }
+
+            template <typename T>
+            inline T get_native(const char* data) noexcept {
+                T value;
+                std::memcpy(&value, data, sizeof(T));
+                return value;
+            }
+
+            /**
+             * Sequentially reads native values from a memory area, checking
+             * that they are all inside the area.
+             */
+            class buffer_file_decoder {
+
+                const char* m_data;
+                const char* m_end;
+
+                void check(std::size_t size) const {
+                    if (static_cast<std::size_t>(m_end - m_data) < size) {
+                        throw osmium::buffer_file_error{"header data truncated"};
+                    }
+                }
+
+            public:
+
+                buffer_file_decoder(const char* data, std::size_t size) noexcept :
+                    m_data(data),
+                    m_end(data + size) {
+                }
+
+                template <typename T>
+                T get() {
+                    check(sizeof(T));
+                    const T value = get_native<T>(m_data);
+                    m_data += sizeof(T);
+                    return value;
+                }
+
+                std::string get_string() {
+                    const auto size = get<uint32_t>();
+                    check(size);
+                    std::string value{m_data, size};
+                    m_data += size;
+                    return value;
+                }
+
+            }; // class buffer_file_decoder
+
+            inline void pad_to_alignment(std::string& out) {
+                const auto rest = out.size() % osmium::memory::align_bytes;
+                if (rest != 0) {
+                    out.append(osmium::memory::align_bytes - rest, '\0');
+                }
+            }
+
+            inline std::string encode_buffer_file_header(const osmium::io::Header& header) {
+                std::string data;
+                append_native(data, static_cast<uint32_t>(header.boxes().size()));
+                for (const auto& box : header.boxes()) {
+                    append_native(data, box.bottom_left().x());
+                    append_native(data, box.bottom_left().y());
+                    append_native(data, box.top_right().x());
+                    append_native(data, box.top_right().y());
+                }
+                append_native(data, static_cast<uint32_t>(header.has_multiple_object_versions()));
+                append_native(data, static_cast<uint32_t>(header.size()));
+                for (const auto& option : header) {
+                    append_native(data, static_cast<uint32_t>(option.first.size()));
+                    data += option.first;
+                    append_native(data, static_cast<uint32_t>(option.second.size()));
+                    data += option.second;
+                }
+                pad_to_alignment(data);
+
+                std::string out{buffer_file_magic(), buffer_file_magic_size};
+                append_native(out, buffer_file_version);
+                append_native(out, buffer_file_byte_order_mark);
+                append_native(out, static_cast<uint32_t>(osmium::memory::align_bytes));
+                append_native(out, static_cast<uint32_t>(data.size()));
+                out += data;
+
+                return out;
+            }
+
+            /**
+             * Check the fixed part of the header at the beginning of an
+             * osmium buffer file (buffer_file_fixed_header_size bytes) and
+             * return the size of the complete header.
+             *
+             * @throws osmium::buffer_file_error If this is not a buffer file
+             *         or it can't be read on this machine.
+             */
+            inline std::size_t check_buffer_file_header(const char* data) {
+                if (std::memcmp(data, buffer_file_magic(), buffer_file_magic_size) != 0) {
+                    throw osmium::buffer_file_error{"not an osmium buffer file"};
+                }
+                data += buffer_file_magic_size;
+                if (get_native<uint32_t>(data) != buffer_file_version) {
+                    throw osmium::buffer_file_error{"unsupported format version"};
+                }
+                if (get_native<uint32_t>(data + 4) != buffer_file_byte_order_mark) {
+                    throw osmium::buffer_file_error{"file was written on a machine with different byte order"};
+                }
+                if (get_native<uint32_t>(data + 8) != osmium::memory::align_bytes) {
+                    throw osmium::buffer_file_error{"file was written with different alignment"};
+                }
+                const auto size = get_native<uint32_t>(data + 12);
+                if (size % osmium::memory::align_bytes != 0) {
+                    throw osmium::buffer_file_error{"invalid header size"};
+                }
+                return buffer_file_fixed_header_size + size;
+            }
+
+            /**
+             * Decode the header data (after the fixed part of the header).
+             */
+            inline osmium::io::Header decode_buffer_file_header(const char* data, std::size_t size) {
+                osmium::io::Header header;
+                buffer_file_decoder decoder{data, size};
+
+                const auto num_boxes = decoder.get<uint32_t>();
+                for (uint32_t n = 0; n < num_boxes; ++n) {
+                    const auto x1 = decoder.get<int32_t>();
+                    const auto y1 = decoder.get<int32_t>();
+                    const auto x2 = decoder.get<int32_t>();
+                    const auto y2 = decoder.get<int32_t>();
+                    header.add_box(osmium::Box{osmium::Location{x1, y1}, osmium::Location{x2, y2}});
+                }
+                header.set_has_multiple_object_versions(decoder.get<uint32_t>() != 0);
+
+                const auto num_options = decoder.get<uint32_t>();
+                for (uint32_t n = 0; n < num_options; ++n) {
+                    std::string key{decoder.get_string()};
+                    header.set(key, decoder.get_string());
+                }
+
+                return header;
+            }
+
+            inline std::string encode_buffer_file_page_header(uint64_t size, osmium::osm_entity_bits::type types, uint32_t count) {
+                std::string out;
+                append_native(out, size);
+                append_native(out, static_cast<uint32_t>(types));
+                append_native(out, count);
+                return out;
+            }
+
+            /**
+             * Decode a page header (buffer_file_page_header_size bytes).
+             * The offset in the returned page info is not set.
+             *
+             * @throws osmium::buffer_file_error If the page header is invalid.
+             */
+            inline buffer_file_page_info decode_buffer_file_page_header(const char* data) {
+                buffer_file_page_info info;
+                info.size = get_native<uint64_t>(data);
+                const auto types = get_native<uint32_t>(data + 8);
+                info.count = get_native<uint32_t>(data + 12);
+                if (info.size % osmium::memory::align_bytes != 0 ||
+                    (types & ~static_cast<uint32_t>(osmium::osm_entity_bits::all)) != 0) {
+                    throw osmium::buffer_file_error{"invalid page header"};
+                }
+                info.types = static_cast<osmium::osm_entity_bits::type>(types);
+                return info;
+            }
+
+            /**
+             * Get the types and number of all items in a buffer.
+             */
+            inline buffer_file_page_info get_buffer_contents(const osmium::memory::Buffer& buffer) {
+                buffer_file_page_info info;
+                info.size = buffer.committed();
+                for (auto it = buffer.cbegin<osmium::memory::Item>(); it != buffer.cend<osmium::memory::Item>(); ++it) {
+                    info.types |= osmium::osm_entity_bits::from_item_type(it->type());
+                    ++info.count;
+                }
+                return info;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_BUFFER_FILE_HPP
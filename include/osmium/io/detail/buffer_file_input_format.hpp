@@ -0,0 +1,233 @@
+#ifndef OSMIUM_IO_DETAIL_BUFFER_FILE_INPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_BUFFER_FILE_INPUT_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/buffer_file.hpp>
+#include <osmium/io/detail/input_format.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/thread/util.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Reads osmium buffer files. If the Reader gives us direct
+             * access to an uncompressed file, it is memory mapped and the
+             * pages are copied from the mapping into the buffers, otherwise
+             * the data comes through the input queue as usual. No decoding
+             * is done in either case.
+             */
+            class BufferFileParser final : public Parser {
+
+                enum : std::size_t {
+                    read_chunk_size = 1024UL * 1024UL
+                };
+
+                std::atomic<std::size_t>* m_offset_ptr;
+                int m_fd;
+
+                std::unique_ptr<osmium::util::MemoryMapping> m_mapping{};
+                std::size_t m_mapping_offset = 0;
+
+                std::string m_input{};
+                std::size_t m_input_offset = 0;
+
+                void try_map_input_file() {
+                    if (m_fd == -1) {
+                        return;
+                    }
+
+                    try {
+                        const auto size = osmium::file_size(m_fd);
+                        const auto offset = osmium::file_offset(m_fd);
+                        if (size == 0 || offset > size) {
+                            return;
+                        }
+                        m_mapping.reset(new osmium::util::MemoryMapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, m_fd});
+                        m_mapping_offset = offset;
+                    } catch (const std::system_error&) {
+                        m_mapping.reset();
+                    }
+                }
+
+                // Append more data to m_input, returns false on EOF.
+                bool read_more_input() {
+                    if (m_fd == -1) {
+                        if (input_done()) {
+                            return false;
+                        }
+                        m_input += get_input();
+                        return true;
+                    }
+
+                    const auto size = m_input.size();
+                    m_input.resize(size + read_chunk_size);
+                    const auto read_size = osmium::io::detail::reliable_read(m_fd, &m_input[size], static_cast<unsigned int>(read_chunk_size));
+                    m_input.resize(size + static_cast<std::size_t>(read_size));
+                    *m_offset_ptr += static_cast<std::size_t>(read_size);
+                    return read_size != 0;
+                }
+
+                /**
+                 * Get a pointer to the next size bytes of the input and
+                 * advance the read position. The data is only valid until
+                 * the next call.
+                 *
+                 * @throws osmium::buffer_file_error If there is not enough
+                 *         data left in the input.
+                 */
+                const char* get_data(std::size_t size) {
+                    if (m_mapping) {
+                        if (m_mapping->size() - m_mapping_offset < size) {
+                            throw osmium::buffer_file_error{"truncated data (EOF encountered)"};
+                        }
+                        const char* data = m_mapping->get_addr<char>() + m_mapping_offset;
+                        m_mapping_offset += size;
+                        *m_offset_ptr += size;
+                        return data;
+                    }
+
+                    m_input.erase(0, m_input_offset);
+                    m_input_offset = 0;
+                    while (m_input.size() < size) {
+                        if (!read_more_input()) {
+                            throw osmium::buffer_file_error{"truncated data (EOF encountered)"};
+                        }
+                    }
+                    m_input_offset = size;
+                    return m_input.data();
+                }
+
+                void parse_header() {
+                    const std::size_t header_size = check_buffer_file_header(get_data(buffer_file_fixed_header_size));
+                    const std::size_t data_size = header_size - buffer_file_fixed_header_size;
+                    set_header_value(decode_buffer_file_header(get_data(data_size), data_size));
+                }
+
+                osmium::memory::Buffer create_buffer(const char* data, const buffer_file_page_info& page) const {
+                    osmium::memory::Buffer buffer{page.size, osmium::memory::Buffer::auto_grow::no};
+                    std::copy_n(data, page.size, buffer.reserve_space(page.size));
+                    buffer.commit();
+
+                    if ((page.types & ~read_types()) == 0) {
+                        return buffer;
+                    }
+
+                    osmium::memory::Buffer filtered{page.size, osmium::memory::Buffer::auto_grow::no};
+                    for (auto it = buffer.cbegin<osmium::memory::Item>(); it != buffer.cend<osmium::memory::Item>(); ++it) {
+                        if (osmium::osm_entity_bits::from_item_type(it->type()) & read_types()) {
+                            filtered.add_item(*it);
+                            filtered.commit();
+                        }
+                    }
+                    return filtered;
+                }
+
+            public:
+
+                explicit BufferFileParser(parser_arguments& args) :
+                    Parser(args),
+                    m_offset_ptr(args.offset_ptr),
+                    m_fd(args.fd) {
+                }
+
+                BufferFileParser(const BufferFileParser&) = delete;
+                BufferFileParser& operator=(const BufferFileParser&) = delete;
+
+                BufferFileParser(BufferFileParser&&) = delete;
+                BufferFileParser& operator=(BufferFileParser&&) = delete;
+
+                ~BufferFileParser() noexcept override = default;
+
+                void run() override {
+                    osmium::thread::set_thread_name("_osmium_buf_in");
+
+                    try_map_input_file();
+                    parse_header();
+
+                    if (read_types() == osmium::osm_entity_bits::nothing) {
+                        return;
+                    }
+
+                    while (true) {
+                        const auto page = decode_buffer_file_page_header(get_data(buffer_file_page_header_size));
+                        if (page.size == 0) {
+                            return;
+                        }
+                        const char* data = get_data(page.size);
+                        if (page.types & read_types()) {
+                            send_to_output_queue(create_buffer(data, page));
+                        }
+                    }
+                }
+
+            }; // class BufferFileParser
+
+            // we want the register_parser() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_buffer_file_parser = ParserFactory::instance().register_parser(
+                file_format::buffer,
+                [](parser_arguments& args) {
+                    return std::unique_ptr<Parser>(new BufferFileParser{args});
+                });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_buffer_file_parser() noexcept {
+                return registered_buffer_file_parser;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_BUFFER_FILE_INPUT_FORMAT_HPP
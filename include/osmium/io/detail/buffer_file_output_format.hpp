@@ -0,0 +1,139 @@
+#ifndef OSMIUM_IO_DETAIL_BUFFER_FILE_OUTPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_BUFFER_FILE_OUTPUT_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/buffer_file.hpp>
+#include <osmium/io/detail/output_format.hpp>
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Writes osmium buffer files. See buffer_file.hpp for a
+             * description of the format.
+             */
+            class BufferFileOutputFormat : public osmium::io::detail::OutputFormat {
+
+                std::vector<buffer_file_page_info> m_pages;
+                uint64_t m_offset = 0;
+
+                void send(std::string&& data) {
+                    m_offset += data.size();
+                    send_to_output_queue(std::move(data));
+                }
+
+                void write_page(const osmium::memory::Buffer& buffer) {
+                    if (buffer.committed() == 0) {
+                        return;
+                    }
+
+                    buffer_file_page_info info{get_buffer_contents(buffer)};
+                    std::string data{encode_buffer_file_page_header(info.size, info.types, info.count)};
+                    data.append(reinterpret_cast<const char*>(buffer.data()), buffer.committed());
+
+                    info.offset = m_offset + buffer_file_page_header_size;
+                    m_pages.push_back(info);
+                    send(std::move(data));
+                }
+
+            public:
+
+                BufferFileOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& /*file*/, future_string_queue_type& output_queue) :
+                    OutputFormat(pool, output_queue) {
+                }
+
+                void write_header(const osmium::io::Header& header) final {
+                    send(encode_buffer_file_header(header));
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    write_page(buffer);
+                }
+
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    write_page(*buffer);
+                }
+
+                void write_end() final {
+                    std::string data{encode_buffer_file_page_header(0, osmium::osm_entity_bits::nothing, 0)};
+
+                    const uint64_t index_offset = m_offset + data.size();
+                    for (const auto& page : m_pages) {
+                        append_native(data, page.offset);
+                        data += encode_buffer_file_page_header(page.size, page.types, page.count);
+                    }
+
+                    append_native(data, index_offset);
+                    append_native(data, static_cast<uint64_t>(m_pages.size()));
+                    data.append(buffer_file_end_magic(), buffer_file_magic_size);
+
+                    send(std::move(data));
+                }
+
+            }; // class BufferFileOutputFormat
+
+            // we want the register_output_format() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_buffer_file_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::buffer,
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                    return new osmium::io::detail::BufferFileOutputFormat(pool, file, output_queue);
+            });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_buffer_file_output() noexcept {
+                return registered_buffer_file_output;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_BUFFER_FILE_OUTPUT_FORMAT_HPP
@@ -0,0 +1,132 @@
+#ifndef OSMIUM_IO_DETAIL_BUFFER_RECYCLER_HPP
+#define OSMIUM_IO_DETAIL_BUFFER_RECYCLER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * A thread-safe store for buffers that are not needed any more
+             * and can be filled again. The consumer of the buffers from a
+             * Reader hands them back through Reader::recycle() and the
+             * decoders take them from here instead of allocating new memory.
+             */
+            class BufferRecycler {
+
+                mutable std::mutex m_mutex;
+                std::vector<osmium::memory::Buffer> m_buffers;
+                std::size_t m_max_buffers;
+
+            public:
+
+                enum {
+                    default_max_buffers = 64
+                };
+
+                explicit BufferRecycler(std::size_t max_buffers = default_max_buffers) :
+                    m_max_buffers(max_buffers) {
+                }
+
+                /**
+                 * Add a buffer to the recycler. The buffer will be cleared.
+                 * Invalid buffers, buffers with nested buffers, and buffers
+                 * which can not grow are ignored as are all buffers once
+                 * the recycler is full.
+                 */
+                void put(osmium::memory::Buffer&& buffer) {
+                    if (!buffer || buffer.has_nested_buffers() ||
+                        buffer.get_auto_grow() == osmium::memory::Buffer::auto_grow::no) {
+                        return;
+                    }
+                    buffer.clear();
+
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    if (m_buffers.size() < m_max_buffers) {
+                        m_buffers.push_back(std::move(buffer));
+                    }
+                }
+
+                /**
+                 * Get a buffer with at least min_capacity bytes capacity.
+                 * Returns an invalid buffer if there is none.
+                 */
+                osmium::memory::Buffer get(std::size_t min_capacity) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    for (auto it = m_buffers.rbegin(); it != m_buffers.rend(); ++it) {
+                        if (it->capacity() >= min_capacity) {
+                            osmium::memory::Buffer buffer{std::move(*it)};
+                            m_buffers.erase(std::next(it).base());
+                            return buffer;
+                        }
+                    }
+                    return osmium::memory::Buffer{};
+                }
+
+                /// The number of buffers available.
+                std::size_t size() const {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    return m_buffers.size();
+                }
+
+                /// Memory used by the buffers in the recycler in bytes.
+                std::size_t used_memory() const {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    std::size_t result = 0;
+                    for (const auto& buffer : m_buffers) {
+                        result += buffer.capacity();
+                    }
+                    return result;
+                }
+
+            }; // class BufferRecycler
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_BUFFER_RECYCLER_HPP
@@ -336,6 +336,10 @@ namespace osmium {
             public:
 
                 DebugOutputBlock(osmium::memory::Buffer&& buffer, const debug_output_options& options) :
+                    DebugOutputBlock(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)), options) {
+                }
+
+                DebugOutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer, const debug_output_options& options) :
                     OutputBlock(std::move(buffer)),
                     m_options(options),
                     m_utf8_prefix(options.use_color ? color_red  : ""),
@@ -586,6 +590,10 @@ namespace osmium {
                     m_output_queue.push(m_pool.submit(DebugOutputBlock{std::move(buffer), m_options}));
                 }
 
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    m_output_queue.push(m_pool.submit(DebugOutputBlock{buffer, m_options}));
+                }
+
             }; // class DebugOutputFormat
 
             // we want the register_output_format() function to run, setting
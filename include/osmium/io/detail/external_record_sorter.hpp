@@ -0,0 +1,354 @@
+#ifndef OSMIUM_IO_DETAIL_EXTERNAL_RECORD_SORTER_HPP
+#define OSMIUM_IO_DETAIL_EXTERNAL_RECORD_SORTER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/read_write.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Create a temporary file for the external sorters in the
+             * given directory (or TMPDIR or /tmp if the directory is
+             * empty). The file is unlinked right away.
+             *
+             * @returns File descriptor of the temporary file.
+             * @throws std::system_error if the file could not be created.
+             * @throws std::runtime_error on Windows.
+             */
+            inline int create_sort_tmp_file(const std::string& directory) {
+#ifdef _WIN32
+                (void)directory;
+                throw std::runtime_error{"The external sorter is not supported on Windows"};
+#else
+                std::string name{directory};
+                if (name.empty()) {
+                    const char* tmpdir = std::getenv("TMPDIR");
+                    name = tmpdir ? tmpdir : "/tmp";
+                }
+                name += "/osmium-sort-XXXXXX";
+                const int fd = ::mkstemp(&name[0]);
+                if (fd < 0) {
+                    throw std::system_error{errno, std::system_category(), std::string{"Could not create temporary file '"} + name + "'"};
+                }
+                ::unlink(name.c_str());
+                return fd;
+#endif
+            }
+
+            /**
+             * Sorts fixed-size records which do not fit into memory. The
+             * records are collected with push_back(). Whenever the memory
+             * budget is used up, they are sorted and written as a sorted
+             * run to a temporary file. After start_reading() the records
+             * can be read back in sorted order with current() and next();
+             * the runs are merged on the fly.
+             *
+             * If all records fit into the memory budget, no temporary
+             * files are used.
+             *
+             * Not available on Windows if the records don't fit into the
+             * memory budget.
+             *
+             * @tparam T Record type. Must be trivially copyable, because
+             *           records are written to disk as they are.
+             * @tparam TCompare Strict weak ordering on T.
+             */
+            template <typename T, typename TCompare = std::less<T>>
+            class external_record_sorter {
+
+                static_assert(std::is_trivially_copyable<T>::value, "Records must be trivially copyable");
+
+                enum : std::size_t {
+                    min_records = 1024
+                };
+
+                class run {
+
+                    int m_fd;
+                    std::size_t m_size = 0; // in records
+                    std::size_t m_read = 0; // records read from file
+                    std::vector<T> m_window{};
+                    std::size_t m_pos = 0;
+
+                    void fill() {
+                        const auto count = std::min(m_window.capacity(), m_size - m_read);
+                        m_window.resize(count);
+                        m_pos = 0;
+                        if (count == 0) {
+                            return;
+                        }
+#ifndef _WIN32
+                        if (!osmium::io::detail::reliable_pread(m_fd, reinterpret_cast<char*>(m_window.data()), count * sizeof(T), m_read * sizeof(T))) {
+                            throw std::runtime_error{"Temporary file of external sorter truncated"};
+                        }
+#endif
+                        m_read += count;
+                    }
+
+                public:
+
+                    explicit run(const std::string& directory) :
+                        m_fd(create_sort_tmp_file(directory)) {
+                    }
+
+                    run(const run&) = delete;
+                    run& operator=(const run&) = delete;
+
+                    run(run&& other) noexcept :
+                        m_fd(other.m_fd),
+                        m_size(other.m_size),
+                        m_read(other.m_read),
+                        m_window(std::move(other.m_window)),
+                        m_pos(other.m_pos) {
+                        other.m_fd = -1;
+                    }
+
+                    run& operator=(run&& other) noexcept {
+                        std::swap(m_fd, other.m_fd);
+                        std::swap(m_size, other.m_size);
+                        std::swap(m_read, other.m_read);
+                        std::swap(m_window, other.m_window);
+                        std::swap(m_pos, other.m_pos);
+                        return *this;
+                    }
+
+                    ~run() noexcept {
+#ifndef _WIN32
+                        if (m_fd >= 0) {
+                            ::close(m_fd);
+                        }
+#endif
+                    }
+
+                    void write(const std::vector<T>& records) {
+                        osmium::io::detail::reliable_write(m_fd, reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+                        m_size += records.size();
+                    }
+
+                    void start_reading(std::size_t window_records) {
+                        m_window.clear();
+                        m_window.shrink_to_fit();
+                        m_window.reserve(window_records);
+                        m_read = 0;
+                        fill();
+                    }
+
+                    const T* current() const noexcept {
+                        return m_pos < m_window.size() ? &m_window[m_pos] : nullptr;
+                    }
+
+                    void next() {
+                        if (++m_pos == m_window.size()) {
+                            fill();
+                        }
+                    }
+
+                }; // class run
+
+                std::size_t m_max_records;
+                std::string m_directory;
+                TCompare m_compare;
+
+                std::vector<T> m_records{};
+                std::vector<run> m_runs{};
+                std::size_t m_size = 0;
+
+                // State while reading
+                std::size_t m_pos = 0;
+                std::vector<std::size_t> m_heap{};
+                const T* m_current = nullptr;
+
+                // Comparison for the heap of run indexes: The run with the
+                // smallest current record must be at the top.
+                struct heap_compare {
+
+                    const external_record_sorter* sorter;
+
+                    bool operator()(std::size_t a, std::size_t b) const {
+                        return sorter->m_compare(*sorter->m_runs[b].current(), *sorter->m_runs[a].current());
+                    }
+
+                }; // struct heap_compare
+
+                void spill() {
+                    std::sort(m_records.begin(), m_records.end(), m_compare);
+                    run r{m_directory};
+                    r.write(m_records);
+                    m_runs.push_back(std::move(r));
+                    m_records.clear();
+                }
+
+                void set_current_from_heap() {
+                    m_current = m_heap.empty() ? nullptr : m_runs[m_heap.front()].current();
+                }
+
+            public:
+
+                /**
+                 * @param memory_budget Approximate number of bytes used for
+                 *        records in memory. At least 1024 records are
+                 *        always kept in memory.
+                 * @param directory Directory for temporary files. See
+                 *        create_sort_tmp_file().
+                 * @param compare Comparison function object.
+                 */
+                explicit external_record_sorter(std::size_t memory_budget, std::string directory = "", TCompare compare = TCompare{}) :
+                    m_max_records(std::max(static_cast<std::size_t>(min_records), memory_budget / sizeof(T))),
+                    m_directory(std::move(directory)),
+                    m_compare(std::move(compare)) {
+                }
+
+                /// Add a record. Must not be called after start_reading().
+                void push_back(const T& record) {
+                    if (m_records.size() == m_max_records) {
+                        spill();
+                    }
+                    m_records.push_back(record);
+                    ++m_size;
+                }
+
+                /// The number of records added.
+                std::size_t size() const noexcept {
+                    return m_size;
+                }
+
+                bool empty() const noexcept {
+                    return m_size == 0;
+                }
+
+                /// The number of sorted runs written to disk.
+                std::size_t num_runs() const noexcept {
+                    return m_runs.size();
+                }
+
+                /**
+                 * Sort all records and get ready to read them back in
+                 * order.
+                 */
+                void start_reading() {
+                    if (m_runs.empty()) {
+                        std::sort(m_records.begin(), m_records.end(), m_compare);
+                        m_pos = 0;
+                        m_current = m_records.empty() ? nullptr : m_records.data();
+                        return;
+                    }
+
+                    if (!m_records.empty()) {
+                        spill();
+                    }
+                    std::vector<T>{}.swap(m_records);
+
+                    const auto window_records = std::max(static_cast<std::size_t>(min_records), m_max_records / m_runs.size());
+                    m_heap.clear();
+                    for (std::size_t n = 0; n < m_runs.size(); ++n) {
+                        m_runs[n].start_reading(window_records);
+                        if (m_runs[n].current()) {
+                            m_heap.push_back(n);
+                        }
+                    }
+                    std::make_heap(m_heap.begin(), m_heap.end(), heap_compare{this});
+                    set_current_from_heap();
+                }
+
+                /**
+                 * The current record or nullptr if all records have been
+                 * read. The pointer is only valid until the next call to
+                 * next().
+                 */
+                const T* current() const noexcept {
+                    return m_current;
+                }
+
+                /// Go to the next record. Only call if current() != nullptr.
+                void next() {
+                    if (m_runs.empty()) {
+                        ++m_pos;
+                        m_current = m_pos < m_records.size() ? &m_records[m_pos] : nullptr;
+                        return;
+                    }
+
+                    std::pop_heap(m_heap.begin(), m_heap.end(), heap_compare{this});
+                    auto& r = m_runs[m_heap.back()];
+                    r.next();
+                    if (r.current()) {
+                        std::push_heap(m_heap.begin(), m_heap.end(), heap_compare{this});
+                    } else {
+                        m_heap.pop_back();
+                    }
+                    set_current_from_heap();
+                }
+
+                /**
+                 * Remove all records and temporary files. The sorter can be
+                 * used again afterwards.
+                 */
+                void clear() {
+                    std::vector<T>{}.swap(m_records);
+                    m_runs.clear();
+                    m_heap.clear();
+                    m_size = 0;
+                    m_pos = 0;
+                    m_current = nullptr;
+                }
+
+            }; // class external_record_sorter
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_EXTERNAL_RECORD_SORTER_HPP
@@ -92,6 +92,10 @@ namespace osmium {
             public:
 
                 IDSOutputBlock(osmium::memory::Buffer&& buffer, const ids_output_options& options) :
+                    IDSOutputBlock(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)), options) {
+                }
+
+                IDSOutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer, const ids_output_options& options) :
                     OutputBlock(std::move(buffer)),
                     m_options(options) {
                 }
@@ -141,6 +145,10 @@ namespace osmium {
                     m_output_queue.push(m_pool.submit(IDSOutputBlock{std::move(buffer), m_options}));
                 }
 
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    m_output_queue.push(m_pool.submit(IDSOutputBlock{buffer, m_options}));
+                }
+
             }; // class IDSOutputFormat
 
             // we want the register_output_format() function to run, setting
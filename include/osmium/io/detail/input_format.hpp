@@ -33,16 +33,26 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/io/detail/buffer_recycler.hpp>
+#include <osmium/io/decoded_buffer_callback.hpp>
+#include <osmium/io/read_query.hpp>
+#include <osmium/io/tags_prefilter.hpp>
+#include <osmium/io/timestamp_window.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/sort_order_verifier.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/max_memory_in_flight.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
+#include <osmium/util/config.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <exception>
 #include <functional>
 #include <future>
@@ -67,8 +77,43 @@ namespace osmium {
                 osmium::io::read_meta read_metadata;
                 osmium::io::buffers_type buffers_kind;
                 bool want_buffered_pages_removed;
+                std::shared_ptr<BufferRecycler> buffer_recycler;
+                osmium::io::decoded_buffer_callback buffer_callback;
+                osmium::io::tags_prefilter prefilter;
+                osmium::io::timestamp_window time_window;
+                osmium::io::read_query query;
+                osmium::io::keep_raw_blobs raw_blobs;
+                osmium::io::pool_for_pbf_parsing pbf_pool_parsing;
+                osmium::io::verify_sorting sorting_check;
+                osmium::io::reader_buffer_size buffer_size;
+                std::shared_ptr<memory_account> memory;
+                std::function<void()> data_ready;
             };
 
+            /**
+             * Wraps a task creating a buffer so that a notification
+             * function is called after the result is available from the
+             * future.
+             */
+            class notifying_buffer_task {
+
+                std::packaged_task<osmium::memory::Buffer()> m_task;
+                std::function<void()> m_notify;
+
+            public:
+
+                notifying_buffer_task(std::packaged_task<osmium::memory::Buffer()>&& task, std::function<void()> notify) :
+                    m_task(std::move(task)),
+                    m_notify(std::move(notify)) {
+                }
+
+                void operator()() {
+                    m_task();
+                    m_notify();
+                }
+
+            }; // class notifying_buffer_task
+
             class Parser {
 
                 osmium::thread::Pool& m_pool;
@@ -77,6 +122,16 @@ namespace osmium {
                 queue_wrapper<std::string> m_input_queue;
                 osmium::osm_entity_bits::type m_read_which_entities;
                 osmium::io::read_meta m_read_metadata;
+                std::shared_ptr<BufferRecycler> m_buffer_recycler;
+                osmium::io::decoded_buffer_callback m_buffer_callback;
+                osmium::io::tags_prefilter m_prefilter;
+                osmium::io::timestamp_window m_timestamp_window;
+                osmium::io::read_query m_read_query;
+                osmium::io::keep_raw_blobs m_raw_blobs;
+                osmium::io::pool_for_pbf_parsing m_pbf_pool_parsing;
+                osmium::io::verify_sorting m_sorting_check;
+                std::shared_ptr<memory_account> m_memory;
+                std::function<void()> m_data_ready;
                 bool m_header_is_done = false;
 
             protected:
@@ -93,15 +148,102 @@ namespace osmium {
                     return m_read_metadata;
                 }
 
+                /**
+                 * Get the recycler with buffers handed back by the user. Can
+                 * be nullptr.
+                 */
+                const std::shared_ptr<BufferRecycler>& buffer_recycler() const noexcept {
+                    return m_buffer_recycler;
+                }
+
+                /**
+                 * Get the function the user wants to be called on each
+                 * decoded buffer. Parsers which send futures to the output
+                 * queue have to call it themselves in the task creating the
+                 * buffer.
+                 */
+                const osmium::io::decoded_buffer_callback& buffer_callback() const noexcept {
+                    return m_buffer_callback;
+                }
+
+                /**
+                 * Get the tags prefilter set by the user. Parsers which
+                 * don't support prefiltering ignore it.
+                 */
+                const osmium::io::tags_prefilter& prefilter() const noexcept {
+                    return m_prefilter;
+                }
+
+                /**
+                 * Get the timestamp window set by the user. Parsers which
+                 * don't support it ignore it.
+                 */
+                const osmium::io::timestamp_window& timestamp_window() const noexcept {
+                    return m_timestamp_window;
+                }
+
+                /**
+                 * Get the read query set by the user. Only its ID sets,
+                 * box, and blob index are used here, the entity types and
+                 * the tags filter are available from read_types() and
+                 * prefilter(). Parsers which don't support it ignore it.
+                 */
+                const osmium::io::read_query& read_query() const noexcept {
+                    return m_read_query;
+                }
+
+                /**
+                 * Does the user want the encoded data blocks attached to
+                 * the decoded buffers? Parsers which don't support this
+                 * ignore it.
+                 */
+                osmium::io::keep_raw_blobs raw_blobs() const noexcept {
+                    return m_raw_blobs;
+                }
+
+                /**
+                 * Should PBF data blocks be decoded in the pool threads?
+                 */
+                bool use_pool_for_pbf_parsing() const noexcept {
+                    if (m_pbf_pool_parsing == osmium::io::pool_for_pbf_parsing::from_config) {
+                        return osmium::config::use_pool_threads_for_pbf_parsing();
+                    }
+                    return m_pbf_pool_parsing == osmium::io::pool_for_pbf_parsing::yes;
+                }
+
                 bool header_is_done() const noexcept {
                     return m_header_is_done;
                 }
 
+                /**
+                 * Set the header. Must be called before any buffers are
+                 * sent to the output queue. If the user wants the sorting
+                 * checked and the header claims the data is sorted, the
+                 * buffer callback is extended to check the order of the
+                 * objects in each buffer and the header is marked as
+                 * verified.
+                 */
                 void set_header_value(const osmium::io::Header& header) {
-                    if (!m_header_is_done) {
-                        m_header_is_done = true;
+                    if (m_header_is_done) {
+                        return;
+                    }
+                    m_header_is_done = true;
+
+                    if (m_sorting_check == osmium::io::verify_sorting::no || !header.sorted_by_type_then_id()) {
                         m_header_promise.set_value(header);
+                        return;
                     }
+
+                    const bool allow_same_id = header.has_multiple_object_versions();
+                    const auto callback = m_buffer_callback;
+                    m_buffer_callback = osmium::io::decoded_buffer_callback{[allow_same_id, callback](osmium::memory::Buffer& buffer) {
+                        sort_order_verifier{allow_same_id}.check(buffer);
+                        callback(buffer);
+                    }};
+
+                    osmium::io::Header verified_header{header};
+                    verified_header.set_sorting_verified(true);
+                    m_header_promise.set_value(verified_header);
                 }
 
                 void set_header_exception(const std::exception_ptr& exception) {
@@ -112,9 +254,12 @@ namespace osmium {
                 }
 
                 /**
-                 * Wrap the buffer into a future and add it to the output queue.
+                 * Call the user-supplied buffer callback (if any) on the
+                 * buffer, wrap the buffer into a future and add it to the
+                 * output queue.
                  */
                 void send_to_output_queue(osmium::memory::Buffer&& buffer) {
+                    m_buffer_callback(buffer);
                     add_to_queue(m_output_queue, std::move(buffer));
                 }
 
@@ -122,6 +267,47 @@ namespace osmium {
                     m_output_queue.push(std::move(future));
                 }
 
+                /**
+                 * Submit a task creating a buffer to the pool. Parsers use
+                 * this instead of get_pool().submit() for the futures they
+                 * send to the output queue, so that the Reader is notified
+                 * when the buffer is ready.
+                 */
+                template <typename TFunction>
+                std::future<osmium::memory::Buffer> submit_to_pool(TFunction&& func, const osmium::thread::task_priority priority = osmium::thread::task_priority::normal) {
+                    if (!m_data_ready) {
+                        return m_pool.submit(std::forward<TFunction>(func), priority);
+                    }
+                    std::packaged_task<osmium::memory::Buffer()> task{std::forward<TFunction>(func)};
+                    auto future = task.get_future();
+                    m_pool.submit(notifying_buffer_task{std::move(task), m_data_ready}, priority);
+                    return future;
+                }
+
+                /**
+                 * Parsers reading the input themselves (instead of getting
+                 * it from the input queue) call this before reading the
+                 * next block of data. It waits while the memory budget of
+                 * the Reader (if any) is used up.
+                 */
+                void wait_for_memory_budget() {
+                    if (m_memory) {
+                        m_memory->wait_for_room([this]() {
+                            return !m_output_queue.in_use();
+                        });
+                    }
+                }
+
+                /// Number of buffers currently in the output queue.
+                std::size_t output_queue_size() const noexcept {
+                    return m_output_queue.size();
+                }
+
+                /// Maximum number of buffers in the output queue.
+                std::size_t output_queue_max_size() const noexcept {
+                    return m_output_queue.max_size();
+                }
+
             public:
 
                 explicit Parser(parser_arguments& args) :
@@ -130,7 +316,17 @@ namespace osmium {
                     m_header_promise(args.header_promise),
                     m_input_queue(args.input_queue),
                     m_read_which_entities(args.read_which_entities),
-                    m_read_metadata(args.read_metadata) {
+                    m_read_metadata(args.read_metadata),
+                    m_buffer_recycler(args.buffer_recycler),
+                    m_buffer_callback(args.buffer_callback),
+                    m_prefilter(args.prefilter),
+                    m_timestamp_window(args.time_window),
+                    m_read_query(args.query),
+                    m_raw_blobs(args.raw_blobs),
+                    m_pbf_pool_parsing(args.pbf_pool_parsing),
+                    m_sorting_check(args.sorting_check),
+                    m_memory(args.memory),
+                    m_data_ready(args.data_ready) {
                 }
 
                 Parser(const Parser&) = delete;
@@ -144,7 +340,11 @@ namespace osmium {
                 virtual void run() = 0;
 
                 std::string get_input() {
-                    return m_input_queue.pop();
+                    std::string data{m_input_queue.pop()};
+                    if (m_memory) {
+                        m_memory->release(data.size());
+                    }
+                    return data;
                 }
 
                 bool input_done() const {
@@ -168,15 +368,29 @@ namespace osmium {
             class ParserWithBuffer : public Parser {
 
                 enum {
-                    initial_buffer_size = 1024UL * 1024UL
+                    initial_buffer_size = 1024UL * 1024UL,
+                    min_buffer_size = 4096UL
+                };
+
+                enum : int {
+                    min_latency_scale = -4,
+                    max_throughput_scale = 3
                 };
 
-                osmium::memory::Buffer m_buffer{initial_buffer_size,
-                                                osmium::memory::Buffer::auto_grow::internal};
+                osmium::io::reader_buffer_size m_target;
+
+                // The current buffer size is the target size multiplied by
+                // 2^m_scale.
+                int m_scale = 0;
+
+                osmium::memory::Buffer m_buffer;
 
                 osmium::io::buffers_type m_buffers_kind;
                 osmium::item_type m_last_type = osmium::item_type::undefined;
 
+                // Number of objects started in the current buffer.
+                std::size_t m_objects_in_buffer = 0;
+
                 bool is_different_type(osmium::item_type current_type) noexcept {
                     if (m_last_type == current_type) {
                         return false;
@@ -191,10 +405,61 @@ namespace osmium {
                     return true;
                 }
 
+                static std::size_t scaled(std::size_t value, int scale) noexcept {
+                    return scale < 0 ? value >> static_cast<unsigned int>(-scale)
+                                     : value << static_cast<unsigned int>(scale);
+                }
+
+                std::size_t current_max_objects() const noexcept {
+                    if (m_target.objects == 0) {
+                        return 0;
+                    }
+                    return std::max(scaled(m_target.objects, m_scale), static_cast<std::size_t>(1));
+                }
+
+                // Look at how full the output queue is and adjust the
+                // buffer size according to the policy. Called whenever a
+                // buffer has been finished, before it is sent.
+                void adapt_buffer_size() noexcept {
+                    if (m_target.policy == osmium::io::buffer_policy::fixed) {
+                        return;
+                    }
+
+                    const std::size_t queued = output_queue_size();
+                    const bool consumer_waiting = queued == 0;
+                    const bool consumer_behind = queued * 2 > output_queue_max_size();
+
+                    if (m_target.policy == osmium::io::buffer_policy::latency) {
+                        if (consumer_waiting && m_scale > min_latency_scale) {
+                            --m_scale;
+                        } else if (consumer_behind && m_scale < 0) {
+                            ++m_scale;
+                        }
+                    } else {
+                        if (consumer_behind && m_scale < max_throughput_scale) {
+                            ++m_scale;
+                        } else if (consumer_waiting && m_scale > 0) {
+                            --m_scale;
+                        }
+                    }
+                }
+
+                void new_buffer() {
+                    adapt_buffer_size();
+                    osmium::memory::Buffer new_buffer{buffer_size(),
+                                                      osmium::memory::Buffer::auto_grow::internal};
+                    using std::swap;
+                    swap(new_buffer, m_buffer);
+                    m_objects_in_buffer = 0;
+                    send_to_output_queue(std::move(new_buffer));
+                }
+
             protected:
 
                 explicit ParserWithBuffer(parser_arguments& args) :
                     Parser(args),
+                    m_target(args.buffer_size),
+                    m_buffer(buffer_size(), osmium::memory::Buffer::auto_grow::internal),
                     m_buffers_kind(args.buffers_kind) {
                 }
 
@@ -202,10 +467,34 @@ namespace osmium {
                     return m_buffer;
                 }
 
+                osmium::io::buffers_type buffers_kind() const noexcept {
+                    return m_buffers_kind;
+                }
+
+                /**
+                 * The size new buffers are created with. This changes over
+                 * time if the buffer policy is not "fixed".
+                 */
+                std::size_t buffer_size() const noexcept {
+                    const std::size_t target = m_target.bytes == 0 ? static_cast<std::size_t>(initial_buffer_size) : m_target.bytes;
+                    return std::max(scaled(target, m_scale), static_cast<std::size_t>(min_buffer_size));
+                }
+
                 void flush_nested_buffer() {
                     if (m_buffer.has_nested_buffers()) {
                         std::unique_ptr<osmium::memory::Buffer> buffer_ptr{m_buffer.get_last_nested()};
+                        m_objects_in_buffer = 1;
+                        adapt_buffer_size();
                         send_to_output_queue(std::move(*buffer_ptr));
+
+                        // Nested buffers are created with the capacity of
+                        // the current buffer, so grow it if the buffer size
+                        // increased. (Smaller buffers are handled in
+                        // maybe_new_buffer().)
+                        const auto size = buffer_size();
+                        if (m_buffer.capacity() < size) {
+                            m_buffer.grow(size);
+                        }
                     }
                 }
 
@@ -215,18 +504,27 @@ namespace osmium {
                     }
                 }
 
+                /**
+                 * Called before an object of the specified type is added to
+                 * the buffer. Starts a new buffer if the type changed and
+                 * the user wants buffers with objects of a single type
+                 * only, or if the current buffer reached the target size
+                 * or object count.
+                 */
                 void maybe_new_buffer(osmium::item_type current_type) {
-                    if (m_buffers_kind == buffers_type::any) {
-                        return;
-                    }
-
-                    if (is_different_type(current_type) && m_buffer.committed() > 0) {
-                        osmium::memory::Buffer new_buffer{initial_buffer_size,
-                                                          osmium::memory::Buffer::auto_grow::internal};
-                        using std::swap;
-                        swap(new_buffer, m_buffer);
-                        send_to_output_queue(std::move(new_buffer));
+                    if (m_buffers_kind == buffers_type::single &&
+                        is_different_type(current_type) && m_buffer.committed() > 0) {
+                        new_buffer();
+                    } else if (m_target.policy != osmium::io::buffer_policy::fixed &&
+                               m_buffer.committed() >= buffer_size()) {
+                        new_buffer();
+                    } else {
+                        const auto max_objects = current_max_objects();
+                        if (max_objects > 0 && m_objects_in_buffer >= max_objects && m_buffer.committed() > 0) {
+                            new_buffer();
+                        }
                     }
+                    ++m_objects_in_buffer;
                 }
 
             }; // class ParserWithBuffer
@@ -0,0 +1,354 @@
+#ifndef OSMIUM_IO_DETAIL_JSON_OUTPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_JSON_OUTPUT_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/factory.hpp>
+#include <osmium/geom/wkb.hpp>
+#include <osmium/io/detail/output_format.hpp>
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/string_util.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/metadata_options.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            struct json_output_options {
+
+                /// Which metadata of objects should be added?
+                osmium::metadata_options add_metadata;
+
+                /// Should node locations be added to ways?
+                bool locations_on_ways = false;
+
+                /// Should the geometry be added as hex encoded WKB?
+                bool add_wkb = false;
+
+            }; // struct json_output_options
+
+            /**
+             * Writes out one buffer with OSM data in JSON Lines format.
+             */
+            class JSONOutputBlock : public OutputBlock {
+
+                json_output_options m_options;
+
+                osmium::geom::WKBFactory<> m_wkb_factory{osmium::geom::wkb_type::wkb, osmium::geom::out_type::hex};
+
+                void write_string(const char* str) {
+                    *m_out += '"';
+                    append_json_encoded_string(*m_out, str);
+                    *m_out += '"';
+                }
+
+                // All objects start with the "type" field, so all other
+                // fields are preceded by a comma.
+                void write_key(const char* key) {
+                    *m_out += ",\"";
+                    *m_out += key;
+                    *m_out += "\":";
+                }
+
+                void write_field_int(const char* key, int64_t value) {
+                    write_key(key);
+                    output_int(value);
+                }
+
+                void write_field_timestamp(const char* key, const osmium::Timestamp& timestamp) {
+                    write_key(key);
+                    if (timestamp.valid()) {
+                        *m_out += '"';
+                        *m_out += timestamp.to_iso();
+                        *m_out += '"';
+                    } else {
+                        *m_out += "null";
+                    }
+                }
+
+                void write_field_coordinate(const char* key, const osmium::Location& location, bool x) {
+                    write_key(key);
+                    if (location.valid()) {
+                        output_coordinate(x ? location.x() : location.y());
+                    } else {
+                        *m_out += "null";
+                    }
+                }
+
+                void write_tags(const osmium::TagList& tags) {
+                    write_key("tags");
+                    *m_out += '{';
+                    bool first = true;
+                    for (const auto& tag : tags) {
+                        if (!first) {
+                            *m_out += ',';
+                        }
+                        first = false;
+                        write_string(tag.key());
+                        *m_out += ':';
+                        write_string(tag.value());
+                    }
+                    *m_out += '}';
+                }
+
+                void write_meta(const char* type, const osmium::OSMObject& object) {
+                    *m_out += "{\"type\":\"";
+                    *m_out += type;
+                    *m_out += '"';
+                    write_field_int("id", object.id());
+                    if (m_options.add_metadata.version()) {
+                        write_field_int("version", object.version());
+                    }
+                    if (m_options.add_metadata.timestamp()) {
+                        write_field_timestamp("timestamp", object.timestamp());
+                    }
+                    if (m_options.add_metadata.changeset()) {
+                        write_field_int("changeset", object.changeset());
+                    }
+                    if (m_options.add_metadata.uid()) {
+                        write_field_int("uid", object.uid());
+                    }
+                    if (m_options.add_metadata.user()) {
+                        write_key("user");
+                        write_string(object.user());
+                    }
+                    if (m_options.add_metadata.any()) {
+                        write_key("visible");
+                        *m_out += object.visible() ? "true" : "false";
+                    }
+                }
+
+                template <typename TFunc>
+                void write_wkb(TFunc&& func) {
+                    write_key("wkb");
+                    try {
+                        const std::string wkb{std::forward<TFunc>(func)()};
+                        *m_out += '"';
+                        *m_out += wkb;
+                        *m_out += '"';
+                    } catch (const osmium::geometry_error&) {
+                        *m_out += "null";
+                    } catch (const osmium::invalid_location&) {
+                        *m_out += "null";
+                    }
+                }
+
+            public:
+
+                JSONOutputBlock(osmium::memory::Buffer&& buffer, const json_output_options& options) :
+                    JSONOutputBlock(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)), options) {
+                }
+
+                JSONOutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer, const json_output_options& options) :
+                    OutputBlock(std::move(buffer)),
+                    m_options(options) {
+                }
+
+                std::string operator()() {
+                    // JSON output is usually a bit larger than the
+                    // in-memory representation of the objects.
+                    reserve_output(2);
+                    osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+
+                    std::string out;
+                    using std::swap;
+                    swap(out, *m_out);
+
+                    return out;
+                }
+
+                void node(const osmium::Node& node) {
+                    write_meta("node", node);
+                    write_field_coordinate("lon", node.location(), true);
+                    write_field_coordinate("lat", node.location(), false);
+                    write_tags(node.tags());
+                    if (m_options.add_wkb) {
+                        write_wkb([&]() {
+                            return m_wkb_factory.create_point(node);
+                        });
+                    }
+                    *m_out += "}\n";
+                }
+
+                void way(const osmium::Way& way) {
+                    write_meta("way", way);
+
+                    write_key("refs");
+                    *m_out += '[';
+                    for (const auto& node_ref : way.nodes()) {
+                        if (&node_ref != way.nodes().cbegin()) {
+                            *m_out += ',';
+                        }
+                        output_int(node_ref.ref());
+                    }
+                    *m_out += ']';
+
+                    if (m_options.locations_on_ways) {
+                        write_key("coordinates");
+                        *m_out += '[';
+                        for (const auto& node_ref : way.nodes()) {
+                            if (&node_ref != way.nodes().cbegin()) {
+                                *m_out += ',';
+                            }
+                            if (node_ref.location().valid()) {
+                                *m_out += '[';
+                                output_coordinate(node_ref.location().x());
+                                *m_out += ',';
+                                output_coordinate(node_ref.location().y());
+                                *m_out += ']';
+                            } else {
+                                *m_out += "null";
+                            }
+                        }
+                        *m_out += ']';
+                    }
+
+                    write_tags(way.tags());
+                    if (m_options.add_wkb) {
+                        write_wkb([&]() {
+                            return m_wkb_factory.create_linestring(way);
+                        });
+                    }
+                    *m_out += "}\n";
+                }
+
+                void relation(const osmium::Relation& relation) {
+                    write_meta("relation", relation);
+
+                    write_key("members");
+                    *m_out += '[';
+                    bool first = true;
+                    for (const auto& member : relation.members()) {
+                        if (!first) {
+                            *m_out += ',';
+                        }
+                        first = false;
+                        *m_out += "{\"type\":\"";
+                        *m_out += osmium::item_type_to_name(member.type());
+                        *m_out += "\",\"ref\":";
+                        output_int(member.ref());
+                        *m_out += ",\"role\":";
+                        write_string(member.role());
+                        *m_out += '}';
+                    }
+                    *m_out += ']';
+
+                    write_tags(relation.tags());
+                    *m_out += "}\n";
+                }
+
+                void changeset(const osmium::Changeset& changeset) {
+                    *m_out += "{\"type\":\"changeset\"";
+                    write_field_int("id", changeset.id());
+                    write_field_timestamp("created_at", changeset.created_at());
+                    write_field_timestamp("closed_at", changeset.closed_at());
+                    write_field_int("num_changes", changeset.num_changes());
+                    write_field_int("comments_count", changeset.num_comments());
+                    write_field_int("uid", changeset.uid());
+                    write_key("user");
+                    write_string(changeset.user());
+                    write_field_coordinate("min_lon", changeset.bounds().bottom_left(), true);
+                    write_field_coordinate("min_lat", changeset.bounds().bottom_left(), false);
+                    write_field_coordinate("max_lon", changeset.bounds().top_right(), true);
+                    write_field_coordinate("max_lat", changeset.bounds().top_right(), false);
+                    write_tags(changeset.tags());
+                    *m_out += "}\n";
+                }
+
+            }; // class JSONOutputBlock
+
+            class JSONOutputFormat : public osmium::io::detail::OutputFormat {
+
+                json_output_options m_options;
+
+            public:
+
+                JSONOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(pool, output_queue) {
+                    m_options.add_metadata      = osmium::metadata_options{file.get("add_metadata")};
+                    m_options.locations_on_ways = file.is_true("locations_on_ways");
+                    m_options.add_wkb           = file.is_true("json_wkb");
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    m_output_queue.push(m_pool.submit(JSONOutputBlock{std::move(buffer), m_options}));
+                }
+
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    m_output_queue.push(m_pool.submit(JSONOutputBlock{buffer, m_options}));
+                }
+
+            }; // class JSONOutputFormat
+
+            // we want the register_output_format() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_json_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::json,
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                    return new osmium::io::detail::JSONOutputFormat(pool, file, output_queue);
+            });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_json_output() noexcept {
+                return registered_json_output;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_JSON_OUTPUT_FORMAT_HPP
@@ -101,22 +101,22 @@ namespace osmium {
             }
 
             /**
-             * Uncompress data using lz4.
+             * Uncompress data using lz4 into memory provided by the
+             * caller.
              *
              * Note that this function can not uncompress data larger than
              * LZ4_MAX_INPUT_SIZE.
              *
              * @param input Compressed input data.
+             * @param input_size Size of compressed input data.
+             * @param output Memory for the uncompressed data, must have
+             *               space for raw_size bytes.
              * @param raw_size Size of uncompressed data.
-             * @param output Uncompressed result data.
-             * @returns Pointer and size to incompressed data.
              */
-            inline protozero::data_view lz4_uncompress_string(const char* input, unsigned long input_size, unsigned long raw_size, std::string& output) { // NOLINT(google-runtime-int)
-                output.resize(raw_size);
-
+            inline void lz4_uncompress(const char* input, unsigned long input_size, char* output, unsigned long raw_size) { // NOLINT(google-runtime-int)
                 const int result = ::LZ4_decompress_safe( // NOLINT(google-runtime-int)
                     input,
-                    &*output.begin(),
+                    output,
                     static_cast<int>(input_size),
                     static_cast<int>(raw_size));
 
@@ -127,7 +127,22 @@ namespace osmium {
                 if (result != static_cast<int>(raw_size)) {
                     throw io_error{"LZ4 decompression failed: data size does not match"};
                 }
+            }
 
+            /**
+             * Uncompress data using lz4.
+             *
+             * Note that this function can not uncompress data larger than
+             * LZ4_MAX_INPUT_SIZE.
+             *
+             * @param input Compressed input data.
+             * @param raw_size Size of uncompressed data.
+             * @param output Uncompressed result data.
+             * @returns Pointer and size to incompressed data.
+             */
+            inline protozero::data_view lz4_uncompress_string(const char* input, unsigned long input_size, unsigned long raw_size, std::string& output) { // NOLINT(google-runtime-int)
+                output.resize(raw_size);
+                lz4_uncompress(input, input_size, &*output.begin(), raw_size);
                 return protozero::data_view{output.data(), output.size()};
             }
 
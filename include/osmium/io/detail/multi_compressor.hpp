@@ -0,0 +1,117 @@
+#ifndef OSMIUM_IO_DETAIL_MULTI_COMPRESSOR_HPP
+#define OSMIUM_IO_DETAIL_MULTI_COMPRESSOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/writer_options.hpp>
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Compressor writing the same data to several other compressors.
+             * This is used by the Writer to write already encoded data to
+             * several files which can have different compression.
+             */
+            class MultiCompressor final : public osmium::io::Compressor {
+
+                std::vector<std::unique_ptr<osmium::io::Compressor>> m_compressors;
+
+            public:
+
+                explicit MultiCompressor(std::vector<std::unique_ptr<osmium::io::Compressor>>&& compressors) :
+                    Compressor(fsync::no),
+                    m_compressors(std::move(compressors)) {
+                }
+
+                MultiCompressor(const MultiCompressor&) = delete;
+                MultiCompressor& operator=(const MultiCompressor&) = delete;
+
+                MultiCompressor(MultiCompressor&&) = delete;
+                MultiCompressor& operator=(MultiCompressor&&) = delete;
+
+                ~MultiCompressor() noexcept override = default;
+
+                void write(const std::string& data) override {
+                    for (auto& compressor : m_compressors) {
+                        compressor->write(data);
+                    }
+                }
+
+                // Closes all compressors even if some of them fail and
+                // rethrows the first exception.
+                void close() override {
+                    std::exception_ptr exception;
+                    for (auto& compressor : m_compressors) {
+                        try {
+                            compressor->close();
+                        } catch (...) {
+                            if (!exception) {
+                                exception = std::current_exception();
+                            }
+                        }
+                    }
+                    if (exception) {
+                        std::rethrow_exception(exception);
+                    }
+                }
+
+                /// The sum of the sizes of all files.
+                std::size_t file_size() const override {
+                    std::size_t size = 0;
+                    for (const auto& compressor : m_compressors) {
+                        size += compressor->file_size();
+                    }
+                    return size;
+                }
+
+            }; // class MultiCompressor
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_MULTI_COMPRESSOR_HPP
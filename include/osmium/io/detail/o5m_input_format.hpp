@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/io/detail/input_format.hpp>
+#include <osmium/io/detail/o5m.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_format.hpp>
@@ -51,6 +52,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/config.hpp>
 #include <osmium/util/delta.hpp>
 
 #include <protozero/exception.hpp>
@@ -63,6 +65,7 @@ DEALINGS IN THE SOFTWARE.
 #include <cstdint>
 #include <cstring>
 #include <future>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <string>
@@ -74,33 +77,15 @@ namespace osmium {
         class Builder;
     } // namespace builder
 
-    /**
-     * Exception thrown when the o5m deocder failed. The exception contains
-     * (if available) information about the place where the error happened
-     * and the type of error.
-     */
-    struct o5m_error : public io_error {
-
-        explicit o5m_error(const char* what) :
-            io_error(std::string{"o5m format error: "} + what) {
-        }
-
-    }; // struct o5m_error
-
     namespace io {
 
         namespace detail {
 
-            // Implementation of the o5m/o5c file formats according to the
-            // description at https://wiki.openstreetmap.org/wiki/O5m .
-
             class ReferenceTable {
 
-                // The following settings are from the o5m description:
-
                 enum : uint64_t {
                     // The maximum number of entries in this table.
-                    number_of_entries = 15000UL,
+                    number_of_entries = o5m_string_table_entries,
 
                     // The size of one entry in the table.
                     entry_size = 256UL
@@ -109,7 +94,7 @@ namespace osmium {
                 // The maximum length of a string in the table including
                 // two \0 bytes.
                 enum {
-                    max_length = 250U + 2U
+                    max_length = o5m_string_table_max_length
                 };
 
                 // The data is stored in this string. It is default constructed
@@ -121,6 +106,11 @@ namespace osmium {
 
                 unsigned int current_entry = 0;
 
+                // The length of the string in each entry is kept in the
+                // last byte of the entry which is never used for the
+                // string itself. It is only needed for save().
+                static_assert(static_cast<std::size_t>(max_length) < static_cast<std::size_t>(entry_size), "last byte of entry must be available");
+
             public:
 
                 void clear() {
@@ -134,13 +124,55 @@ namespace osmium {
                         m_table.resize(entry_size * number_of_entries);
                     }
                     if (size <= max_length) {
-                        std::copy_n(string, size, &m_table[current_entry * entry_size]);
+                        char* entry = &m_table[current_entry * entry_size];
+                        std::copy_n(string, size, entry);
+                        entry[entry_size - 1] = static_cast<char>(size);
                         if (++current_entry == number_of_entries) {
                             current_entry = 0;
                         }
                     }
                 }
 
+                /**
+                 * Append the contents of the table to out in a compact
+                 * form: Only the used bytes of each entry are stored.
+                 */
+                void save(std::string& out) const {
+                    protozero::write_varint(std::back_inserter(out), current_entry);
+                    if (m_table.empty()) {
+                        return;
+                    }
+                    for (std::size_t n = 0; n < number_of_entries; ++n) {
+                        const char* entry = &m_table[n * entry_size];
+                        const auto size = static_cast<unsigned char>(entry[entry_size - 1]);
+                        out += static_cast<char>(size);
+                        out.append(entry, size);
+                    }
+                }
+
+                /**
+                 * Restore the contents of the table from data written by
+                 * save().
+                 */
+                void restore(const std::string& data) {
+                    const char* ptr = data.data();
+                    const char* const end = ptr + data.size();
+                    current_entry = static_cast<unsigned int>(protozero::decode_varint(&ptr, end));
+                    if (ptr == end) {
+                        m_table.clear();
+                        return;
+                    }
+                    m_table.assign(entry_size * number_of_entries, '\0');
+                    for (std::size_t n = 0; n < number_of_entries; ++n) {
+                        assert(ptr != end);
+                        const auto size = static_cast<unsigned char>(*ptr++);
+                        char* entry = &m_table[n * entry_size];
+                        std::copy_n(ptr, size, entry);
+                        entry[entry_size - 1] = static_cast<char>(size);
+                        ptr += size;
+                    }
+                }
+
                 const char* get(uint64_t index) const {
                     if (m_table.empty() || index == 0 || index > number_of_entries) {
                         throw o5m_error{"reference to non-existing string in table"};
@@ -151,89 +183,42 @@ namespace osmium {
 
             }; // class ReferenceTable
 
-            class O5mParser final : public ParserWithBuffer {
-
-                osmium::io::Header m_header{};
-
-                std::string m_input{};
-
-                const char* m_data;
-                const char* m_end;
-
-                ReferenceTable m_reference_table;
-
-                static int64_t zvarint(const char** data, const char* end) {
-                    return protozero::decode_zigzag64(protozero::decode_varint(data, end));
-                }
-
-                bool ensure_bytes_available(std::size_t need_bytes) {
-                    if (static_cast<std::size_t>(m_end - m_data) >= need_bytes) {
-                        return true;
-                    }
-
-                    if (input_done() && (m_input.size() < need_bytes)) {
-                        return false;
-                    }
-
-                    m_input.erase(0, m_data - m_input.data());
-
-                    while (m_input.size() < need_bytes) {
-                        const std::string data{get_input()};
-                        if (input_done()) {
-                            return false;
-                        }
-                        m_input.append(data);
-                    }
-
-                    m_data = m_input.data();
-                    m_end = m_input.data() + m_input.size();
-
-                    return true;
-                }
-
-                void check_header_magic() {
-                    static const unsigned char header_magic[] = {0xff, 0xe0, 0x04, 'o', '5'};
+            /**
+             * Snapshot of the state of an O5mDecoder, see
+             * O5mDecoder::save_state().
+             */
+            struct o5m_decoder_state {
 
-                    if (std::strncmp(reinterpret_cast<const char*>(header_magic), m_data, sizeof(header_magic)) != 0) {
-                        throw o5m_error{"wrong header magic"};
-                    }
+                // in the compact form written by ReferenceTable::save()
+                std::string reference_table;
 
-                    m_data += sizeof(header_magic);
-                }
+                osmium::DeltaDecode<osmium::object_id_type> delta_id;
 
-                void check_file_type() {
-                    if (*m_data == 'm') {         // o5m data file
-                        m_header.set_has_multiple_object_versions(false);
-                    } else if (*m_data == 'c') {  // o5c change file
-                        m_header.set_has_multiple_object_versions(true);
-                    } else {
-                        throw o5m_error{"wrong header magic"};
-                    }
+                osmium::DeltaDecode<int64_t> delta_timestamp;
+                osmium::DeltaDecode<osmium::changeset_id_type> delta_changeset;
+                osmium::DeltaDecode<int64_t> delta_lon;
+                osmium::DeltaDecode<int64_t> delta_lat;
 
-                    m_data++;
-                }
+                osmium::DeltaDecode<osmium::object_id_type> delta_way_node_id;
+                std::array<osmium::DeltaDecode<osmium::object_id_type>, 3> delta_member_ids;
 
-                void check_file_format_version() {
-                    if (*m_data != '2') {
-                        throw o5m_error{"wrong header magic"};
-                    }
+            }; // struct o5m_decoder_state
 
-                    m_data++;
-                }
+            /**
+             * Decodes the datasets of an o5m file into OSM objects. The
+             * decoder keeps the state (string table and delta values)
+             * which is only cleared at reset points. The TOutput class
+             * (the O5mParser or an O5mChunkOutput) provides the buffer
+             * the objects are written into.
+             */
+            template <typename TOutput>
+            class O5mDecoder {
 
-                void decode_header() {
-                    if (!ensure_bytes_available(7)) { // overall length of header
-                        throw o5m_error{"file too short (incomplete header info)"};
-                    }
+                TOutput& m_output;
 
-                    check_header_magic();
-                    check_file_type();
-                    check_file_format_version();
-                }
+                osmium::io::Header m_header{};
 
-                void mark_header_as_done() {
-                    set_header_value(m_header);
-                }
+                ReferenceTable m_reference_table;
 
                 osmium::DeltaDecode<osmium::object_id_type> m_delta_id;
 
@@ -245,19 +230,12 @@ namespace osmium {
                 osmium::DeltaDecode<osmium::object_id_type> m_delta_way_node_id;
                 std::array<osmium::DeltaDecode<osmium::object_id_type>, 3> m_delta_member_ids;
 
-                void reset() {
-                    m_reference_table.clear();
-
-                    m_delta_id.clear();
-                    m_delta_timestamp.clear();
-                    m_delta_changeset.clear();
-                    m_delta_lon.clear();
-                    m_delta_lat.clear();
+                static int64_t zvarint(const char** data, const char* end) {
+                    return protozero::decode_zigzag64(protozero::decode_varint(data, end));
+                }
 
-                    m_delta_way_node_id.clear();
-                    m_delta_member_ids[0].clear();
-                    m_delta_member_ids[1].clear();
-                    m_delta_member_ids[2].clear();
+                osmium::memory::Buffer& buffer() noexcept {
+                    return m_output.buffer();
                 }
 
                 const char* decode_string(const char** dataptr, const char* const end) {
@@ -313,37 +291,49 @@ namespace osmium {
                     return {static_cast<osmium::user_id_type>(uid), user};
                 }
 
-                void decode_tags(osmium::builder::Builder& parent, const char** dataptr, const char* const end) {
-                    osmium::builder::TagListBuilder builder{parent};
-
-                    while (*dataptr != end) {
-                        const bool update_pointer = (**dataptr == 0x00);
-                        const char* data = decode_string(dataptr, end);
-                        const char* start = data;
+                // Decode one tag and return pointers to its key and value.
+                std::pair<const char*, const char*> decode_tag(const char** dataptr, const char* const end) {
+                    const bool update_pointer = (**dataptr == 0x00);
+                    const char* data = decode_string(dataptr, end);
+                    const char* start = data;
 
-                        while (*data++) {
-                            if (data == end) {
-                                throw o5m_error{"no null byte in tag key"};
-                            }
+                    while (*data++) {
+                        if (data == end) {
+                            throw o5m_error{"no null byte in tag key"};
                         }
+                    }
+
+                    if (data == end) {
+                        throw o5m_error{"no null byte in tag value"};
+                    }
 
+                    const char* value = data;
+                    while (*data++) {
                         if (data == end) {
                             throw o5m_error{"no null byte in tag value"};
                         }
+                    }
 
-                        const char* value = data;
-                        while (*data++) {
-                            if (data == end) {
-                                throw o5m_error{"no null byte in tag value"};
-                            }
-                        }
+                    if (update_pointer) {
+                        m_reference_table.add(start, data - start);
+                        *dataptr = data;
+                    }
 
-                        if (update_pointer) {
-                            m_reference_table.add(start, data - start);
-                            *dataptr = data;
-                        }
+                    return {start, value};
+                }
 
-                        builder.add_tag(start, value);
+                void decode_tags(osmium::builder::Builder& parent, const char** dataptr, const char* const end) {
+                    osmium::builder::TagListBuilder builder{parent};
+
+                    while (*dataptr != end) {
+                        const auto key_value = decode_tag(dataptr, end);
+                        builder.add_tag(key_value.first, key_value.second);
+                    }
+                }
+
+                void scan_tags(const char** dataptr, const char* const end) {
+                    while (*dataptr != end) {
+                        decode_tag(dataptr, end);
                     }
                 }
 
@@ -380,6 +370,26 @@ namespace osmium {
                     return user;
                 }
 
+                void scan_info(const char** dataptr, const char* const end) {
+                    if (*dataptr == end) {
+                        throw o5m_error{"premature end of file while parsing object metadata"};
+                    }
+
+                    if (**dataptr == 0x00) { // no info section
+                        ++*dataptr;
+                        return;
+                    }
+
+                    protozero::decode_varint(dataptr, end); // version
+                    const auto timestamp = m_delta_timestamp.update(zvarint(dataptr, end));
+                    if (timestamp != 0) { // has timestamp
+                        m_delta_changeset.update(zvarint(dataptr, end));
+                        if (*dataptr != end) {
+                            decode_user(dataptr, end);
+                        }
+                    }
+                }
+
                 void decode_node(const char* data, const char* const end) {
                     osmium::builder::NodeBuilder builder{buffer()};
 
@@ -505,6 +515,56 @@ namespace osmium {
                     }
                 }
 
+                void scan_node(const char* data, const char* const end) {
+                    m_delta_id.update(zvarint(&data, end));
+                    scan_info(&data, end);
+
+                    if (data != end) {
+                        m_delta_lon.update(zvarint(&data, end));
+                        m_delta_lat.update(zvarint(&data, end));
+                        scan_tags(&data, end);
+                    }
+                }
+
+                void scan_way(const char* data, const char* const end) {
+                    m_delta_id.update(zvarint(&data, end));
+                    scan_info(&data, end);
+
+                    if (data != end) {
+                        const auto reference_section_length = protozero::decode_varint(&data, end);
+                        const char* const end_refs = data + reference_section_length;
+                        if (end_refs > end) {
+                            throw o5m_error{"way nodes ref section too long"};
+                        }
+                        while (data < end_refs) {
+                            m_delta_way_node_id.update(zvarint(&data, end));
+                        }
+                        scan_tags(&data, end);
+                    }
+                }
+
+                void scan_relation(const char* data, const char* const end) {
+                    m_delta_id.update(zvarint(&data, end));
+                    scan_info(&data, end);
+
+                    if (data != end) {
+                        const auto reference_section_length = protozero::decode_varint(&data, end);
+                        const char* const end_refs = data + reference_section_length;
+                        if (end_refs > end) {
+                            throw o5m_error{"relation format error"};
+                        }
+                        while (data < end_refs) {
+                            const auto delta_id = zvarint(&data, end);
+                            if (data == end) {
+                                throw o5m_error{"relation member format error"};
+                            }
+                            const auto type_role = decode_role(&data, end);
+                            m_delta_member_ids[osmium::item_type_to_nwr_index(type_role.first)].update(delta_id);
+                        }
+                        scan_tags(&data, end);
+                    }
+                }
+
                 void decode_bbox(const char* data, const char* const end) {
                     const auto sw_lon = zvarint(&data, end);
                     const auto sw_lat = zvarint(&data, end);
@@ -521,87 +581,488 @@ namespace osmium {
                     m_header.set("timestamp", timestamp);
                 }
 
-                enum class dataset_type : unsigned char {
-                    node         = 0x10,
-                    way          = 0x11,
-                    relation     = 0x12,
-                    bounding_box = 0xdb,
-                    timestamp    = 0xdc,
-                    header       = 0xe0,
-                    sync         = 0xee,
-                    jump         = 0xef,
-                    reset        = 0xff
-                };
+            public:
+
+                explicit O5mDecoder(TOutput& output) :
+                    m_output(output) {
+                }
+
+                osmium::io::Header& header() noexcept {
+                    return m_header;
+                }
+
+                void mark_header_as_done() {
+                    m_output.set_header_value(m_header);
+                }
 
-                void decode_data() {
-                    while (ensure_bytes_available(1)) {
-                        const auto ds_type = static_cast<dataset_type>(*m_data++);
-                        if (ds_type > dataset_type::jump) {
-                            if (ds_type == dataset_type::reset) {
-                                reset();
+                void reset() {
+                    m_reference_table.clear();
+
+                    m_delta_id.clear();
+                    m_delta_timestamp.clear();
+                    m_delta_changeset.clear();
+                    m_delta_lon.clear();
+                    m_delta_lat.clear();
+
+                    m_delta_way_node_id.clear();
+                    m_delta_member_ids[0].clear();
+                    m_delta_member_ids[1].clear();
+                    m_delta_member_ids[2].clear();
+                }
+
+                /**
+                 * Get a snapshot of the current state (string table and
+                 * delta values) of the decoder.
+                 */
+                o5m_decoder_state save_state() const {
+                    o5m_decoder_state state;
+                    m_reference_table.save(state.reference_table);
+                    state.delta_id = m_delta_id;
+                    state.delta_timestamp = m_delta_timestamp;
+                    state.delta_changeset = m_delta_changeset;
+                    state.delta_lon = m_delta_lon;
+                    state.delta_lat = m_delta_lat;
+                    state.delta_way_node_id = m_delta_way_node_id;
+                    state.delta_member_ids = m_delta_member_ids;
+                    return state;
+                }
+
+                /**
+                 * Set the state of the decoder from a snapshot taken
+                 * with save_state(), possibly in another decoder.
+                 */
+                void restore_state(const o5m_decoder_state& state) {
+                    m_reference_table.restore(state.reference_table);
+                    m_delta_id = state.delta_id;
+                    m_delta_timestamp = state.delta_timestamp;
+                    m_delta_changeset = state.delta_changeset;
+                    m_delta_lon = state.delta_lon;
+                    m_delta_lat = state.delta_lat;
+                    m_delta_way_node_id = state.delta_way_node_id;
+                    m_delta_member_ids = state.delta_member_ids;
+                }
+
+                /**
+                 * Update the state of the decoder from one dataset
+                 * like decode_dataset() does, but without building any
+                 * objects. This is much cheaper than decoding. Datasets
+                 * with objects of types not read are ignored as in
+                 * decode_dataset().
+                 */
+                void scan_dataset(o5m_dataset_type ds_type, const char* data, const char* const end) {
+                    switch (ds_type) {
+                        case o5m_dataset_type::node:
+                            if (m_output.read_types() & osmium::osm_entity_bits::node) {
+                                scan_node(data, end);
+                            }
+                            break;
+                        case o5m_dataset_type::way:
+                            if (m_output.read_types() & osmium::osm_entity_bits::way) {
+                                scan_way(data, end);
                             }
-                        } else {
-                            ensure_bytes_available(protozero::max_varint_length);
-
-                            uint64_t length = 0;
-                            try {
-                                length = protozero::decode_varint(&m_data, m_end);
-                            } catch (const protozero::end_of_buffer_exception&) {
-                                throw o5m_error{"premature end of file"};
+                            break;
+                        case o5m_dataset_type::relation:
+                            if (m_output.read_types() & osmium::osm_entity_bits::relation) {
+                                scan_relation(data, end);
                             }
+                            break;
+                        default:
+                            break;
+                    }
+                }
 
-                            if (!ensure_bytes_available(length)) {
-                                throw o5m_error{"premature end of file"};
+                /**
+                 * Decode one dataset with the given type and the data
+                 * from data to end (without the type and length).
+                 */
+                void decode_dataset(o5m_dataset_type ds_type, const char* data, const char* const end) {
+                    switch (ds_type) {
+                        case o5m_dataset_type::node:
+                            mark_header_as_done();
+                            if (m_output.read_types() & osmium::osm_entity_bits::node) {
+                                m_output.maybe_new_buffer(osmium::item_type::node);
+                                decode_node(data, end);
+                                buffer().commit();
                             }
+                            break;
+                        case o5m_dataset_type::way:
+                            mark_header_as_done();
+                            if (m_output.read_types() & osmium::osm_entity_bits::way) {
+                                m_output.maybe_new_buffer(osmium::item_type::way);
+                                decode_way(data, end);
+                                buffer().commit();
+                            }
+                            break;
+                        case o5m_dataset_type::relation:
+                            mark_header_as_done();
+                            if (m_output.read_types() & osmium::osm_entity_bits::relation) {
+                                m_output.maybe_new_buffer(osmium::item_type::relation);
+                                decode_relation(data, end);
+                                buffer().commit();
+                            }
+                            break;
+                        case o5m_dataset_type::bounding_box:
+                            decode_bbox(data, end);
+                            break;
+                        case o5m_dataset_type::timestamp:
+                            decode_timestamp(data, end);
+                            break;
+                        default:
+                            // ignore unknown datasets
+                            break;
+                    }
+                }
+
+            }; // class O5mDecoder
+
+            /**
+             * Output for the O5mDecoder used when decoding chunks of an
+             * o5m file in the pool. All objects go into one buffer.
+             */
+            class O5mChunkOutput {
+
+                osmium::memory::Buffer m_buffer;
+                osmium::osm_entity_bits::type m_read_types;
+
+            public:
+
+                O5mChunkOutput(std::size_t size, osmium::osm_entity_bits::type read_types) :
+                    m_buffer(size, osmium::memory::Buffer::auto_grow::yes),
+                    m_read_types(read_types) {
+                }
+
+                osmium::osm_entity_bits::type read_types() const noexcept {
+                    return m_read_types;
+                }
+
+                osmium::memory::Buffer& buffer() noexcept {
+                    return m_buffer;
+                }
+
+                void maybe_new_buffer(osmium::item_type /*current_type*/) noexcept {
+                }
+
+                void set_header_value(const osmium::io::Header& /*header*/) noexcept {
+                }
+
+            }; // class O5mChunkOutput
+
+            /**
+             * Call func(ds_type, data, end) for each dataset with a
+             * length in the chunk. Reset datasets reset the decoder.
+             */
+            template <typename TFunction>
+            inline void o5m_for_each_dataset(const std::string& chunk, O5mDecoder<O5mChunkOutput>& decoder, TFunction&& func) {
+                const char* data = chunk.data();
+                const char* const end = data + chunk.size();
+
+                while (data != end) {
+                    const auto ds_type = static_cast<o5m_dataset_type>(*data++);
+                    if (ds_type > o5m_dataset_type::jump) {
+                        if (ds_type == o5m_dataset_type::reset) {
+                            decoder.reset();
+                        }
+                        continue;
+                    }
+
+                    uint64_t length = 0;
+                    try {
+                        length = protozero::decode_varint(&data, end);
+                    } catch (const protozero::exception&) {
+                        throw o5m_error{"premature end of file"};
+                    }
+
+                    if (static_cast<uint64_t>(end - data) < length) {
+                        throw o5m_error{"premature end of file"};
+                    }
+
+                    func(ds_type, data, data + length);
+                    data += length;
+                }
+            }
+
+            /**
+             * Decode a chunk of o5m datasets (without the file header).
+             * The decoder must have the state needed for the first
+             * dataset in the chunk, which is the case if the chunk
+             * starts at a reset point or at the beginning of the data.
+             *
+             * @param chunk The datasets.
+             * @param decoder Decoder to use. Its state is kept, so
+             *                further datasets can be decoded later.
+             * @throws o5m_error If the data is not valid.
+             */
+            inline void o5m_decode_chunk(const std::string& chunk, O5mDecoder<O5mChunkOutput>& decoder) {
+                o5m_for_each_dataset(chunk, decoder, [&decoder](o5m_dataset_type ds_type, const char* data, const char* end) {
+                    decoder.decode_dataset(ds_type, data, end);
+                });
+            }
+
+            /**
+             * Update the state of the decoder from the datasets in the
+             * chunk without decoding the objects.
+             *
+             * @throws o5m_error If the data is not valid.
+             */
+            inline void o5m_scan_chunk(const std::string& chunk, O5mDecoder<O5mChunkOutput>& decoder) {
+                o5m_for_each_dataset(chunk, decoder, [&decoder](o5m_dataset_type ds_type, const char* data, const char* end) {
+                    decoder.scan_dataset(ds_type, data, end);
+                });
+            }
+
+            /**
+             * Decode a chunk of o5m datasets (without the file header)
+             * and return a buffer with all objects. If the chunk doesn't
+             * start at a reset point, the state of the decoder at its
+             * beginning must be given.
+             */
+            inline osmium::memory::Buffer o5m_decode_chunk(const std::string& chunk,
+                                                           osmium::osm_entity_bits::type read_types,
+                                                           const o5m_decoder_state* state = nullptr) {
+                O5mChunkOutput output{chunk.size() * 2, read_types};
+                O5mDecoder<O5mChunkOutput> decoder{output};
+                if (state) {
+                    decoder.restore_state(*state);
+                }
+                o5m_decode_chunk(chunk, decoder);
+                return std::move(output.buffer());
+            }
+
+            class O5mParser final : public ParserWithBuffer {
+
+                friend class O5mDecoder<O5mParser>;
+
+                enum : std::size_t {
+                    // Chunks are cut at the first reset point after
+                    // this size is reached.
+                    parallel_chunk_size = 4UL * 1024UL * 1024UL,
+
+                    // If there is no reset point for this long, the
+                    // chunk is cut anyway and the decoder state at the
+                    // cut is handed to the next chunk.
+                    max_segment_size = 2 * parallel_chunk_size
+                };
+
+                std::string m_input{};
+
+                const char* m_data;
+                const char* m_end;
+
+                bool ensure_bytes_available(std::size_t need_bytes) {
+                    if (static_cast<std::size_t>(m_end - m_data) >= need_bytes) {
+                        return true;
+                    }
+
+                    if (input_done() && (m_input.size() < need_bytes)) {
+                        return false;
+                    }
+
+                    m_input.erase(0, m_data - m_input.data());
+
+                    while (m_input.size() < need_bytes) {
+                        const std::string data{get_input()};
+                        if (input_done()) {
+                            return false;
+                        }
+                        m_input.append(data);
+                    }
+
+                    m_data = m_input.data();
+                    m_end = m_input.data() + m_input.size();
+
+                    return true;
+                }
+
+                void check_header_magic() {
+                    static const unsigned char header_magic[] = {0xff, 0xe0, 0x04, 'o', '5'};
+
+                    if (std::strncmp(reinterpret_cast<const char*>(header_magic), m_data, sizeof(header_magic)) != 0) {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data += sizeof(header_magic);
+                }
+
+                void check_file_type(osmium::io::Header& header) {
+                    if (*m_data == 'm') {         // o5m data file
+                        header.set_has_multiple_object_versions(false);
+                    } else if (*m_data == 'c') {  // o5c change file
+                        header.set_has_multiple_object_versions(true);
+                    } else {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data++;
+                }
+
+                void check_file_format_version() {
+                    if (*m_data != '2') {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data++;
+                }
+
+                void decode_header(osmium::io::Header& header) {
+                    if (!ensure_bytes_available(7)) { // overall length of header
+                        throw o5m_error{"file too short (incomplete header info)"};
+                    }
+
+                    check_header_magic();
+                    check_file_type(header);
+                    check_file_format_version();
+                }
 
-                            switch (ds_type) {
-                                case dataset_type::node:
-                                    mark_header_as_done();
-                                    if (read_types() & osmium::osm_entity_bits::node) {
-                                        maybe_new_buffer(osmium::item_type::node);
-                                        decode_node(m_data, m_data + length);
-                                        buffer().commit();
-                                    }
-                                    break;
-                                case dataset_type::way:
-                                    mark_header_as_done();
-                                    if (read_types() & osmium::osm_entity_bits::way) {
-                                        maybe_new_buffer(osmium::item_type::way);
-                                        decode_way(m_data, m_data + length);
-                                        buffer().commit();
-                                    }
-                                    break;
-                                case dataset_type::relation:
-                                    mark_header_as_done();
-                                    if (read_types() & osmium::osm_entity_bits::relation) {
-                                        maybe_new_buffer(osmium::item_type::relation);
-                                        decode_relation(m_data, m_data + length);
-                                        buffer().commit();
-                                    }
-                                    break;
-                                case dataset_type::bounding_box:
-                                    decode_bbox(m_data, m_data + length);
-                                    break;
-                                case dataset_type::timestamp:
-                                    decode_timestamp(m_data, m_data + length);
-                                    break;
-                                default:
-                                    // ignore unknown datasets
-                                    break;
+                /**
+                 * Read the next dataset from the input. Single-byte
+                 * datasets (such as reset) have a length of zero.
+                 *
+                 * @returns false at the end of the input.
+                 */
+                bool next_dataset(o5m_dataset_type* ds_type, uint64_t* length) {
+                    if (!ensure_bytes_available(1)) {
+                        return false;
+                    }
+
+                    *ds_type = static_cast<o5m_dataset_type>(*m_data++);
+                    *length = 0;
+                    if (*ds_type > o5m_dataset_type::jump) {
+                        return true;
+                    }
+
+                    ensure_bytes_available(protozero::max_varint_length);
+
+                    try {
+                        *length = protozero::decode_varint(&m_data, m_end);
+                    } catch (const protozero::end_of_buffer_exception&) {
+                        throw o5m_error{"premature end of file"};
+                    }
+
+                    if (!ensure_bytes_available(*length)) {
+                        throw o5m_error{"premature end of file"};
+                    }
+
+                    return true;
+                }
+
+                static bool is_object(o5m_dataset_type ds_type) noexcept {
+                    return ds_type == o5m_dataset_type::node ||
+                           ds_type == o5m_dataset_type::way ||
+                           ds_type == o5m_dataset_type::relation;
+                }
+
+                static osmium::osm_entity_bits::type entity_bits(o5m_dataset_type ds_type) noexcept {
+                    return osmium::osm_entity_bits::from_item_type(osmium::nwr_index_to_item_type(static_cast<unsigned int>(ds_type) - static_cast<unsigned int>(o5m_dataset_type::node)));
+                }
+
+                void run_serial() {
+                    O5mDecoder<O5mParser> decoder{*this};
+                    decode_header(decoder.header());
+
+                    o5m_dataset_type ds_type; // NOLINT(cppcoreguidelines-init-variables)
+                    uint64_t length = 0;
+                    while (next_dataset(&ds_type, &length)) {
+                        if (ds_type > o5m_dataset_type::jump) {
+                            if (ds_type == o5m_dataset_type::reset) {
+                                decoder.reset();
                             }
+                            continue;
+                        }
 
-                            if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
-                                break;
+                        decoder.decode_dataset(ds_type, m_data, m_data + length);
+
+                        if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
+                            break;
+                        }
+
+                        m_data += length;
+
+                        flush_nested_buffer();
+                    }
+
+                    decoder.mark_header_as_done();
+                    flush_final_buffer();
+                }
+
+                void submit_chunk(std::string&& data, const std::shared_ptr<const o5m_decoder_state>& state) {
+                    const auto types = read_types();
+                    const auto callback = buffer_callback();
+                    auto chunk = std::make_shared<std::string>(std::move(data));
+                    send_to_output_queue(submit_to_pool([chunk, state, types, callback]() {
+                        osmium::memory::Buffer buffer{o5m_decode_chunk(*chunk, types, state.get())};
+                        callback(buffer);
+                        return buffer;
+                    }));
+                }
+
+                // The datasets are collected into chunks in this thread,
+                // the chunks are decoded in the pool. Chunks are cut at
+                // reset points (where the state of the decoder is
+                // cleared) if possible. If a segment between reset points
+                // gets too large, the chunk is scanned to get the decoder
+                // state (string table and delta values) at its end
+                // without decoding the objects. The next chunk is then
+                // decoded starting from a snapshot of that state.
+                void run_parallel() {
+                    O5mDecoder<O5mParser> header_decoder{*this};
+                    decode_header(header_decoder.header());
+
+                    // The scanner is always in the state at the beginning
+                    // of the current chunk.
+                    O5mChunkOutput scanner_output{0, read_types()};
+                    O5mDecoder<O5mChunkOutput> scanner{scanner_output};
+
+                    std::string chunk;
+                    std::shared_ptr<const o5m_decoder_state> state;
+
+                    o5m_dataset_type ds_type; // NOLINT(cppcoreguidelines-init-variables)
+                    uint64_t length = 0;
+                    while (next_dataset(&ds_type, &length)) {
+                        if (ds_type == o5m_dataset_type::reset) {
+                            if (chunk.size() >= parallel_chunk_size) {
+                                submit_chunk(std::move(chunk), state);
+                                chunk.clear();
+                                state.reset();
+                                scanner.reset();
                             }
+                            chunk += static_cast<char>(ds_type);
+                            continue;
+                        }
 
+                        if (ds_type > o5m_dataset_type::jump) {
+                            continue;
+                        }
+
+                        if (!is_object(ds_type)) {
+                            if (!header_is_done()) {
+                                header_decoder.decode_dataset(ds_type, m_data, m_data + length);
+                            }
                             m_data += length;
+                            continue;
+                        }
 
-                            flush_nested_buffer();
+                        header_decoder.mark_header_as_done();
+
+                        if (read_types() & entity_bits(ds_type)) {
+                            chunk += static_cast<char>(ds_type);
+                            protozero::write_varint(std::back_inserter(chunk), length);
+                            chunk.append(m_data, length);
+                            if (chunk.size() >= max_segment_size) {
+                                o5m_scan_chunk(chunk, scanner);
+                                submit_chunk(std::move(chunk), state);
+                                chunk.clear();
+                                state = std::make_shared<const o5m_decoder_state>(scanner.save_state());
+                            }
                         }
+
+                        m_data += length;
                     }
 
-                    mark_header_as_done();
-                    flush_final_buffer();
+                    header_decoder.mark_header_as_done();
+
+                    if (chunk.size() > 1) {
+                        submit_chunk(std::move(chunk), state);
+                    }
                 }
 
             public:
@@ -623,8 +1084,14 @@ namespace osmium {
                 void run() override {
                     osmium::thread::set_thread_name("_osmium_o5m_in");
 
-                    decode_header();
-                    decode_data();
+                    if (read_types() != osmium::osm_entity_bits::nothing &&
+                        buffers_kind() == osmium::io::buffers_type::any &&
+                        osmium::config::use_parallel_o5m_parsing()) {
+                        run_parallel();
+                        return;
+                    }
+
+                    run_serial();
                 }
 
             }; // class O5mParser
@@ -0,0 +1,460 @@
+#ifndef OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/o5m.hpp>
+#include <osmium/io/detail/output_format.hpp>
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/metadata_options.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/delta.hpp>
+#include <osmium/visitor.hpp>
+
+#include <protozero/varint.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            struct o5m_output_options {
+
+                /// Which metadata of objects should be added?
+                osmium::metadata_options add_metadata;
+
+                /// Write an o5c change file instead of an o5m data file?
+                bool change_format = false;
+
+            }; // struct o5m_output_options
+
+            /**
+             * The writer side of the o5m string table. It has to know
+             * which strings the reader will have in its table, so it adds
+             * exactly the strings the reader adds, i.e. all strings which
+             * are written inline and are short enough.
+             */
+            class O5mStringTable {
+
+                // Maps each string to the number of strings added to the
+                // table up to and including the last time it was added.
+                std::unordered_map<std::string, uint64_t> m_strings;
+
+                uint64_t m_count = 0;
+
+            public:
+
+                void clear() {
+                    m_strings.clear();
+                    m_count = 0;
+                }
+
+                /**
+                 * Find the string in the table.
+                 *
+                 * @returns The index (1 for the string added last) or 0
+                 *          if the string is not in the table.
+                 */
+                uint64_t find(const std::string& str) const {
+                    const auto it = m_strings.find(str);
+                    if (it == m_strings.end()) {
+                        return 0;
+                    }
+                    const auto index = m_count - it->second + 1;
+                    return index <= o5m_string_table_entries ? index : 0;
+                }
+
+                void add(const std::string& str) {
+                    if (str.size() > o5m_string_table_max_length) {
+                        return;
+                    }
+
+                    // Forget the strings which have dropped out of the
+                    // table so that the map doesn't grow without bounds.
+                    if (m_strings.size() >= 4 * o5m_string_table_entries) {
+                        for (auto it = m_strings.begin(); it != m_strings.end();) {
+                            if (m_count - it->second >= o5m_string_table_entries) {
+                                it = m_strings.erase(it);
+                            } else {
+                                ++it;
+                            }
+                        }
+                    }
+
+                    m_strings[str] = ++m_count;
+                }
+
+            }; // class O5mStringTable
+
+            /**
+             * Writes out one buffer with OSM data in o5m format. Every
+             * block starts with a reset dataset, so that it doesn't
+             * depend on any earlier blocks. This is what allows the blocks
+             * to be encoded in parallel. It also allows the reader to
+             * decode them in parallel.
+             */
+            class O5mOutputBlock : public OutputBlock {
+
+                o5m_output_options m_options;
+
+                O5mStringTable m_string_table;
+
+                osmium::item_type m_last_type = osmium::item_type::undefined;
+
+                osmium::DeltaEncode<osmium::object_id_type, int64_t> m_delta_id;
+
+                osmium::DeltaEncode<int64_t, int64_t> m_delta_timestamp;
+                osmium::DeltaEncode<int64_t, int64_t> m_delta_changeset;
+                osmium::DeltaEncode<int64_t, int64_t> m_delta_lon;
+                osmium::DeltaEncode<int64_t, int64_t> m_delta_lat;
+
+                osmium::DeltaEncode<osmium::object_id_type, int64_t> m_delta_way_node_id;
+                std::array<osmium::DeltaEncode<osmium::object_id_type, int64_t>, 3> m_delta_member_ids;
+
+                // Scratch space for the dataset being written, its
+                // reference section and the strings in it.
+                std::string m_dataset;
+                std::string m_references;
+                std::string m_string;
+
+                static void write_varint(std::string& out, uint64_t value) {
+                    protozero::write_varint(std::back_inserter(out), value);
+                }
+
+                static void write_zvarint(std::string& out, int64_t value) {
+                    write_varint(out, protozero::encode_zigzag64(value));
+                }
+
+                void reset() {
+                    *m_out += static_cast<char>(o5m_dataset_type::reset);
+
+                    m_string_table.clear();
+
+                    m_delta_id.clear();
+                    m_delta_timestamp.clear();
+                    m_delta_changeset.clear();
+                    m_delta_lon.clear();
+                    m_delta_lat.clear();
+
+                    m_delta_way_node_id.clear();
+                    m_delta_member_ids[0].clear();
+                    m_delta_member_ids[1].clear();
+                    m_delta_member_ids[2].clear();
+                }
+
+                // Each object type starts with a reset like other o5m
+                // writers do it, because the ids of different object
+                // types are not related.
+                void start_dataset(osmium::item_type type) {
+                    if (type != m_last_type) {
+                        reset();
+                        m_last_type = type;
+                    }
+                    m_dataset.clear();
+                }
+
+                void finish_dataset(o5m_dataset_type type) {
+                    *m_out += static_cast<char>(type);
+                    write_varint(*m_out, m_dataset.size());
+                    *m_out += m_dataset;
+                }
+
+                // Write a string (pair) either as reference into the
+                // string table or inline.
+                void write_string(std::string& out, const std::string& str) {
+                    const auto index = m_string_table.find(str);
+                    if (index != 0) {
+                        write_varint(out, index);
+                        return;
+                    }
+                    out += '\0';
+                    out += str;
+                    m_string_table.add(str);
+                }
+
+                void write_user(osmium::user_id_type uid, const char* user) {
+                    m_string.clear();
+                    write_varint(m_string, uid);
+                    m_string += '\0';
+
+                    if (uid == 0) {
+                        // The reader handles anonymous users specially
+                        // and will not find them in its table, so they
+                        // are always written inline.
+                        m_dataset += '\0';
+                        m_dataset += m_string;
+                        m_string += '\0';
+                        m_string_table.add(m_string);
+                        return;
+                    }
+
+                    m_string += user;
+                    m_string += '\0';
+                    write_string(m_dataset, m_string);
+                }
+
+                // The info section can only be written complete or not
+                // at all, a version of 0 means "no info section". So the
+                // version is always written if any metadata is wanted.
+                // If the timestamp is not written, the changeset and
+                // user are not written either.
+                void write_info(const osmium::OSMObject& object) {
+                    if (!m_options.add_metadata.any() || object.version() == 0) {
+                        m_dataset += '\0';
+                        return;
+                    }
+
+                    write_varint(m_dataset, object.version());
+
+                    const int64_t timestamp = m_options.add_metadata.timestamp() ? object.timestamp().seconds_since_epoch() : 0;
+                    write_zvarint(m_dataset, m_delta_timestamp.update(timestamp));
+                    if (timestamp == 0) {
+                        return;
+                    }
+
+                    const int64_t changeset = m_options.add_metadata.changeset() ? object.changeset() : 0;
+                    write_zvarint(m_dataset, m_delta_changeset.update(changeset));
+
+                    if (m_options.add_metadata.uid()) {
+                        write_user(object.uid(), m_options.add_metadata.user() ? object.user() : "");
+                    } else {
+                        write_user(0, "");
+                    }
+                }
+
+                void write_tags(const osmium::TagList& tags) {
+                    for (const auto& tag : tags) {
+                        m_string.assign(tag.key());
+                        m_string += '\0';
+                        m_string += tag.value();
+                        m_string += '\0';
+                        write_string(m_dataset, m_string);
+                    }
+                }
+
+                void write_references() {
+                    write_varint(m_dataset, m_references.size());
+                    m_dataset += m_references;
+                    m_references.clear();
+                }
+
+            public:
+
+                O5mOutputBlock(osmium::memory::Buffer&& buffer, const o5m_output_options& options) :
+                    O5mOutputBlock(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)), options) {
+                }
+
+                O5mOutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer, const o5m_output_options& options) :
+                    OutputBlock(std::move(buffer)),
+                    m_options(options) {
+                }
+
+                std::string operator()() {
+                    osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+
+                    std::string out;
+                    using std::swap;
+                    swap(out, *m_out);
+
+                    return out;
+                }
+
+                void node(const osmium::Node& node) {
+                    start_dataset(osmium::item_type::node);
+
+                    write_zvarint(m_dataset, m_delta_id.update(node.id()));
+                    write_info(node);
+
+                    // Deleted objects are written without the rest of
+                    // the dataset.
+                    if (node.visible()) {
+                        write_zvarint(m_dataset, m_delta_lon.update(node.location().x()));
+                        write_zvarint(m_dataset, m_delta_lat.update(node.location().y()));
+                        write_tags(node.tags());
+                    }
+
+                    finish_dataset(o5m_dataset_type::node);
+                }
+
+                void way(const osmium::Way& way) {
+                    start_dataset(osmium::item_type::way);
+
+                    write_zvarint(m_dataset, m_delta_id.update(way.id()));
+                    write_info(way);
+
+                    if (way.visible()) {
+                        for (const auto& node_ref : way.nodes()) {
+                            write_zvarint(m_references, m_delta_way_node_id.update(node_ref.ref()));
+                        }
+                        write_references();
+                        write_tags(way.tags());
+                    }
+
+                    finish_dataset(o5m_dataset_type::way);
+                }
+
+                void relation(const osmium::Relation& relation) {
+                    start_dataset(osmium::item_type::relation);
+
+                    write_zvarint(m_dataset, m_delta_id.update(relation.id()));
+                    write_info(relation);
+
+                    if (relation.visible()) {
+                        for (const auto& member : relation.members()) {
+                            const auto index = osmium::item_type_to_nwr_index(member.type());
+                            write_zvarint(m_references, m_delta_member_ids[index].update(member.ref()));
+                            m_string.assign(1, static_cast<char>('0' + index));
+                            m_string += member.role();
+                            m_string += '\0';
+                            write_string(m_references, m_string);
+                        }
+                        write_references();
+                        write_tags(relation.tags());
+                    }
+
+                    finish_dataset(o5m_dataset_type::relation);
+                }
+
+            }; // class O5mOutputBlock
+
+            class O5mOutputFormat : public osmium::io::detail::OutputFormat {
+
+                o5m_output_options m_options;
+
+                static void write_zvarint(std::string& out, int64_t value) {
+                    protozero::write_varint(std::back_inserter(out), protozero::encode_zigzag64(value));
+                }
+
+            public:
+
+                O5mOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(pool, output_queue) {
+                    m_options.add_metadata  = osmium::metadata_options{file.get("add_metadata")};
+                    m_options.change_format = file.is_true("o5c_change_format") || file.has_multiple_object_versions();
+                }
+
+                void write_header(const osmium::io::Header& header) final {
+                    std::string out;
+
+                    out += static_cast<char>(o5m_dataset_type::reset);
+                    out += static_cast<char>(o5m_dataset_type::header);
+                    out += '\x04';
+                    out += "o5";
+                    out += m_options.change_format ? 'c' : 'm';
+                    out += '2';
+
+                    for (const auto& box : header.boxes()) {
+                        std::string data;
+                        write_zvarint(data, box.bottom_left().x());
+                        write_zvarint(data, box.bottom_left().y());
+                        write_zvarint(data, box.top_right().x());
+                        write_zvarint(data, box.top_right().y());
+                        out += static_cast<char>(o5m_dataset_type::bounding_box);
+                        out += static_cast<char>(data.size());
+                        out += data;
+                    }
+
+                    const std::string timestamp{header.get("timestamp")};
+                    if (!timestamp.empty()) {
+                        try {
+                            std::string data;
+                            write_zvarint(data, osmium::Timestamp{timestamp}.seconds_since_epoch());
+                            out += static_cast<char>(o5m_dataset_type::timestamp);
+                            out += static_cast<char>(data.size());
+                            out += data;
+                        } catch (const std::invalid_argument&) {
+                            // ignore timestamps we can't parse
+                        }
+                    }
+
+                    send_to_output_queue(std::move(out));
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    m_output_queue.push(m_pool.submit(O5mOutputBlock{std::move(buffer), m_options}));
+                }
+
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    m_output_queue.push(m_pool.submit(O5mOutputBlock{buffer, m_options}));
+                }
+
+                void write_end() final {
+                    send_to_output_queue(std::string(1, static_cast<char>(o5m_dataset_type::end_of_file)));
+                }
+
+            }; // class O5mOutputFormat
+
+            // we want the register_output_format() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_o5m_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::o5m,
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                    return new osmium::io::detail::O5mOutputFormat(pool, file, output_queue);
+            });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_o5m_output() noexcept {
+                return registered_o5m_output;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
@@ -38,7 +38,9 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/config.hpp>
 
 #include <cstdint>
 #include <memory>
@@ -98,10 +100,99 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Count the non-empty lines in the data. Lines can end in \n
+             * or \r, the data must start at the beginning of a line. This
+             * is the same way lines are counted by line_by_line().
+             */
+            inline uint64_t opl_count_lines(const char* data, const char* end) noexcept {
+                uint64_t count = 0;
+                bool last_was_eol = true;
+                for (; data != end; ++data) {
+                    const bool eol = (*data == '\n') || (*data == '\r');
+                    count += static_cast<uint64_t>(!eol && last_was_eol);
+                    last_was_eol = eol;
+                }
+                return count;
+            }
+
+            /**
+             * Parse a chunk of complete OPL lines into a buffer. This is
+             * used for parsing OPL files in the pool threads.
+             *
+             * @param chunk The data. It will be modified.
+             * @param line_count The number of the first non-empty line
+             *        in the chunk (used for error messages).
+             * @param read_types Which types of objects to parse.
+             */
+            inline osmium::memory::Buffer opl_parse_chunk(std::string& chunk, uint64_t line_count, osmium::osm_entity_bits::type read_types) {
+                osmium::memory::Buffer buffer{chunk.size(), osmium::memory::Buffer::auto_grow::yes};
+
+                std::string::size_type ppos = 0;
+                while (ppos < chunk.size()) {
+                    auto pos = chunk.find_first_of("\n\r", ppos);
+                    if (pos == std::string::npos) {
+                        pos = chunk.size();
+                    } else {
+                        chunk[pos] = '\0';
+                    }
+                    if (pos > ppos) {
+                        opl_parse_line(line_count, &chunk[ppos], buffer, read_types);
+                        ++line_count;
+                    }
+                    ppos = pos + 1;
+                }
+
+                return buffer;
+            }
+
             class OPLParser final : public ParserWithBuffer {
 
+                enum : std::size_t {
+                    parallel_chunk_size = 4UL * 1024UL * 1024UL
+                };
+
                 uint64_t m_line_count = 0;
 
+                void submit_chunk(std::string&& data) {
+                    const uint64_t line_count = m_line_count;
+                    m_line_count += opl_count_lines(data.data(), data.data() + data.size());
+
+                    const auto types = read_types();
+                    const auto callback = buffer_callback();
+                    auto chunk = std::make_shared<std::string>(std::move(data));
+                    send_to_output_queue(submit_to_pool([chunk, line_count, types, callback]() {
+                        osmium::memory::Buffer buffer{opl_parse_chunk(*chunk, line_count, types)};
+                        callback(buffer);
+                        return buffer;
+                    }));
+                }
+
+                // The data is cut into chunks of complete lines in this
+                // thread, the chunks are parsed in the pool.
+                void run_parallel() {
+                    std::string data;
+
+                    while (!input_done()) {
+                        data += get_input();
+                        if (data.size() < parallel_chunk_size) {
+                            continue;
+                        }
+                        const auto pos = data.find_last_of("\n\r");
+                        if (pos == std::string::npos) {
+                            continue;
+                        }
+                        std::string rest{data, pos + 1};
+                        data.resize(pos + 1);
+                        submit_chunk(std::move(data));
+                        data = std::move(rest);
+                    }
+
+                    if (!data.empty()) {
+                        submit_chunk(std::move(data));
+                    }
+                }
+
             public:
 
                 explicit OPLParser(parser_arguments& args) :
@@ -142,6 +233,13 @@ namespace osmium {
                 void run() override {
                     osmium::thread::set_thread_name("_osmium_opl_in");
 
+                    if (read_types() != osmium::osm_entity_bits::nothing &&
+                        buffers_kind() == osmium::io::buffers_type::any &&
+                        osmium::config::use_parallel_opl_parsing()) {
+                        run_parallel();
+                        return;
+                    }
+
                     line_by_line(*this);
 
                     flush_final_buffer();
@@ -57,7 +57,6 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/visitor.hpp>
 
 #include <cstdint>
-#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
@@ -156,12 +155,12 @@ namespace osmium {
                     *m_out += ' ';
                     *m_out += x;
                     if (not_undefined) {
-                        osmium::detail::append_location_coordinate_to_string(std::back_inserter(*m_out), location.x());
+                        output_coordinate(location.x());
                     }
                     *m_out += ' ';
                     *m_out += y;
                     if (not_undefined) {
-                        osmium::detail::append_location_coordinate_to_string(std::back_inserter(*m_out), location.y());
+                        output_coordinate(location.y());
                     }
                 }
 
@@ -174,11 +173,18 @@ namespace osmium {
             public:
 
                 OPLOutputBlock(osmium::memory::Buffer&& buffer, const opl_output_options& options) :
+                    OPLOutputBlock(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)), options) {
+                }
+
+                OPLOutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer, const opl_output_options& options) :
                     OutputBlock(std::move(buffer)),
                     m_options(options) {
                 }
 
                 std::string operator()() {
+                    // OPL output is usually a bit smaller than the
+                    // in-memory representation of the objects.
+                    reserve_output(1);
                     osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
 
                     std::string out;
@@ -200,7 +206,9 @@ namespace osmium {
                     write_field_int('n', node_ref.ref());
                     *m_out += 'x';
                     if (node_ref.location()) {
-                        node_ref.location().as_string(std::back_inserter(*m_out), 'y');
+                        char temp[32];
+                        char* const end = node_ref.location().as_string(temp, 'y');
+                        m_out->append(temp, end);
                     } else {
                         *m_out += 'y';
                     }
@@ -298,6 +306,10 @@ namespace osmium {
                     m_output_queue.push(m_pool.submit(OPLOutputBlock{std::move(buffer), m_options}));
                 }
 
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    m_output_queue.push(m_pool.submit(OPLOutputBlock{buffer, m_options}));
+                }
+
             }; // class OPLOutputFormat
 
             // we want the register_output_format() function to run, setting
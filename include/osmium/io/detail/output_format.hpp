@@ -39,9 +39,11 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
 #include <osmium/thread/pool.hpp>
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -62,37 +64,101 @@ namespace osmium {
 
             protected:
 
-                std::shared_ptr<osmium::memory::Buffer> m_input_buffer;
+                std::shared_ptr<const osmium::memory::Buffer> m_input_buffer;
 
                 std::shared_ptr<std::string> m_out;
 
                 explicit OutputBlock(osmium::memory::Buffer&& buffer) :
-                    m_input_buffer(std::make_shared<osmium::memory::Buffer>(std::move(buffer))),
+                    m_input_buffer(std::make_shared<const osmium::memory::Buffer>(std::move(buffer))),
                     m_out(std::make_shared<std::string>()) {
                 }
 
-                // Simple function to convert integer to string. This is much
-                // faster than using sprintf, but could be further optimized.
-                // See https://github.com/miloyip/itoa-benchmark .
+                explicit OutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer) :
+                    m_input_buffer(std::move(buffer)),
+                    m_out(std::make_shared<std::string>()) {
+                }
+
+                /**
+                 * Reserve space in the output string for roughly
+                 * factor times the size of the data in the input buffer.
+                 * This avoids repeated reallocations while the string
+                 * grows.
+                 */
+                void reserve_output(std::size_t factor) {
+                    m_out->reserve(m_input_buffer->committed() * factor);
+                }
+
+                // Convert integer to string without going through printf.
+                // Digits are generated two at a time from a lookup table
+                // into a temporary buffer which is then appended in one go.
                 void output_int(int64_t value) {
+                    char temp[max_int_length];
+                    char* const end = temp + max_int_length;
+                    m_out->append(format_int(value, end), end);
+                }
+
+                // Append a coordinate in the same format as
+                // osmium::Location::as_string() but without going
+                // through a back_inserter for each character.
+                void output_coordinate(int32_t value) {
+                    append_coordinate(*m_out, value);
+                }
+
+            public:
+
+                /// Maximum number of characters format_int() can write.
+                enum : std::size_t {
+                    max_int_length = 20
+                };
+
+                /**
+                 * Format the integer value into the buffer ending at end.
+                 * At most max_int_length characters are written.
+                 *
+                 * @returns Pointer to the first character written.
+                 */
+                static char* format_int(int64_t value, char* end) noexcept {
+                    static const char digit_pairs[] =
+                        "00010203040506070809"
+                        "10111213141516171819"
+                        "20212223242526272829"
+                        "30313233343536373839"
+                        "40414243444546474849"
+                        "50515253545556575859"
+                        "60616263646566676869"
+                        "70717273747576777879"
+                        "80818283848586878889"
+                        "90919293949596979899";
+
+                    uint64_t v = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+                    char* t = end;
+                    while (v >= 100) {
+                        const auto pos = static_cast<std::size_t>(v % 100) * 2;
+                        v /= 100;
+                        *--t = digit_pairs[pos + 1];
+                        *--t = digit_pairs[pos];
+                    }
+                    if (v >= 10) {
+                        const auto pos = static_cast<std::size_t>(v) * 2;
+                        *--t = digit_pairs[pos + 1];
+                        *--t = digit_pairs[pos];
+                    } else {
+                        *--t = static_cast<char>('0' + v);
+                    }
                     if (value < 0) {
-                        *m_out += '-';
-                        value = -value;
+                        *--t = '-';
                     }
+                    return t;
+                }
 
-                    char temp[20];
-                    char* t = temp;
-                    do {
-                        *t++ = static_cast<char>(value % 10) + '0'; // NOLINT(bugprone-narrowing-conversions, cppcoreguidelines-narrowing-conversions)
-                        value /= 10;
-                    } while (value > 0);
-
-                    const auto old_size = m_out->size();
-                    m_out->resize(old_size + (t - temp));
-                    char* data = &(*m_out)[old_size];
-                    do {
-                        *data++ = *--t;
-                    } while (t != temp);
+                /**
+                 * Append a coordinate value (as stored in a Location) to
+                 * the string.
+                 */
+                static void append_coordinate(std::string& out, int32_t value) {
+                    char temp[16];
+                    char* const end = osmium::detail::append_location_coordinate_to_string(temp, value);
+                    out.append(temp, end);
                 }
 
             }; // class OutputBlock;
@@ -139,6 +205,42 @@ namespace osmium {
 
                 virtual void write_buffer(osmium::memory::Buffer&& /*buffer*/) = 0;
 
+                /**
+                 * Write a buffer that is shared with other users, for
+                 * instance other output formats. The buffer will not be
+                 * changed and only be referenced for as long as it is
+                 * needed. Formats encoding in the pool override this to
+                 * avoid copying the buffer, the default implementation
+                 * copies it and calls write_buffer().
+                 */
+                virtual void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) {
+                    osmium::memory::Buffer copy{buffer->committed(), osmium::memory::Buffer::auto_grow::no};
+                    copy.add_buffer(*buffer);
+                    copy.commit();
+                    write_buffer(std::move(copy));
+                }
+
+                /**
+                 * Can this format write already encoded data blocks using
+                 * write_raw_blob()?
+                 */
+                virtual bool supports_raw_blobs() const noexcept {
+                    return false;
+                }
+
+                /**
+                 * Write an already encoded data block to the output. For
+                 * the PBF format this is a serialized Blob message
+                 * containing an OSMData block. Anything written before
+                 * will end up in the output before this block.
+                 *
+                 * @throws osmium::io_error If the format doesn't support
+                 *         this.
+                 */
+                virtual void write_raw_blob(std::string&& /*blob*/) {
+                    throw io_error{"output format does not support writing raw blobs"};
+                }
+
                 virtual void write_end() {
                 }
 
@@ -218,6 +320,9 @@ namespace osmium {
                 void write_buffer(osmium::memory::Buffer&& /*buffer*/) override {
                 }
 
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& /*buffer*/) override {
+                }
+
             }; // class BlackholeOutputFormat
 
             // we want the register_output_format() function to run, setting
@@ -0,0 +1,244 @@
+#ifndef OSMIUM_IO_DETAIL_PARALLEL_COMPRESSOR_HPP
+#define OSMIUM_IO_DETAIL_PARALLEL_COMPRESSOR_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Task compressing one chunk of data for the
+             * ParallelCompressor.
+             */
+            template <typename TFormat>
+            class compress_chunk_task {
+
+                std::string m_data;
+
+            public:
+
+                explicit compress_chunk_task(std::string&& data) :
+                    m_data(std::move(data)) {
+                }
+
+                std::string operator()() const {
+                    return TFormat::compress_chunk(m_data.data(), m_data.size());
+                }
+
+            }; // class compress_chunk_task
+
+            /**
+             * Compressor that collects the data into chunks and compresses
+             * each chunk independently in the thread pool. The compressed
+             * chunks are written to the file in the original order. For
+             * this to work, the output format must allow concatenating
+             * several compressed members (gzip) or streams (bzip2).
+             *
+             * The TFormat class must have the following static functions:
+             *
+             * * std::string compress_chunk(const char* data, std::size_t size):
+             *   Compress the data into one or more complete members.
+             * * std::string end_marker():
+             *   Data to be written at the end of the file (can be empty).
+             *
+             * and the following (non-static) member function, which is
+             * called on the instance kept by the compressor after each
+             * chunk was written, in order:
+             *
+             * * void chunk_written(std::size_t input_size, std::size_t output_size):
+             *   Can be used to build an index of the chunks for the
+             *   end_marker().
+             *
+             * It also needs a target_chunk_size enum value.
+             */
+            template <typename TFormat>
+            class ParallelCompressor final : public osmium::io::Compressor {
+
+                struct pending_chunk {
+                    std::size_t input_size;
+                    std::future<std::string> result;
+                };
+
+                TFormat m_format{};
+                std::string m_chunk{};
+                std::deque<pending_chunk> m_results{};
+                osmium::thread::Pool& m_pool;
+                std::size_t m_max_chunks_in_flight;
+                std::size_t m_file_size = 0;
+                int m_fd;
+
+                void write_result(pending_chunk& chunk) {
+                    const std::string data{chunk.result.get()};
+                    osmium::io::detail::reliable_write(m_fd, data.data(), data.size());
+                    m_file_size += data.size();
+                    m_format.chunk_written(chunk.input_size, data.size());
+                }
+
+                void submit_chunk() {
+                    if (m_chunk.empty()) {
+                        return;
+                    }
+                    const std::size_t input_size = m_chunk.size();
+                    m_results.push_back(pending_chunk{input_size, m_pool.submit(compress_chunk_task<TFormat>{std::move(m_chunk)})});
+                    m_chunk.clear();
+                    m_chunk.reserve(TFormat::target_chunk_size);
+                }
+
+                // Write all results that are ready. If there are too many
+                // chunks in flight, wait for the oldest.
+                void write_ready_results() {
+                    while (!m_results.empty()) {
+                        auto& chunk = m_results.front();
+                        if (m_results.size() <= m_max_chunks_in_flight &&
+                            chunk.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                            return;
+                        }
+                        write_result(chunk);
+                        m_results.pop_front();
+                    }
+                }
+
+                void wait_for_all_results() noexcept {
+                    for (auto& chunk : m_results) {
+                        if (chunk.result.valid()) {
+                            chunk.result.wait();
+                        }
+                    }
+                    m_results.clear();
+                }
+
+            public:
+
+                /**
+                 * Create a parallel compressor. Takes ownership of the fd.
+                 *
+                 * @param fd File descriptor to write to.
+                 * @param sync Should the file be synced on close?
+                 * @param pool The thread pool to use.
+                 */
+                ParallelCompressor(const int fd, const fsync sync, osmium::thread::Pool& pool) :
+                    Compressor(sync),
+                    m_pool(pool),
+                    m_max_chunks_in_flight(static_cast<std::size_t>(pool.num_threads()) * 2),
+                    m_fd(fd) {
+                    m_chunk.reserve(TFormat::target_chunk_size);
+                }
+
+                ParallelCompressor(const ParallelCompressor&) = delete;
+                ParallelCompressor& operator=(const ParallelCompressor&) = delete;
+
+                ParallelCompressor(ParallelCompressor&&) = delete;
+                ParallelCompressor& operator=(ParallelCompressor&&) = delete;
+
+                ~ParallelCompressor() noexcept override {
+                    try {
+                        close();
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                void write(const std::string& data) override {
+                    m_chunk.append(data);
+                    if (m_chunk.size() >= TFormat::target_chunk_size) {
+                        submit_chunk();
+                    }
+                    write_ready_results();
+                }
+
+                void close() override {
+                    if (m_fd < 0) {
+                        return;
+                    }
+
+                    const int fd = m_fd;
+                    try {
+                        submit_chunk();
+                        for (auto& chunk : m_results) {
+                            write_result(chunk);
+                        }
+                        m_results.clear();
+
+                        const std::string end{m_format.end_marker()};
+                        osmium::io::detail::reliable_write(m_fd, end.data(), end.size());
+                        m_file_size += end.size();
+                    } catch (...) {
+                        wait_for_all_results();
+                        m_fd = -1;
+                        if (fd != 1) {
+                            osmium::io::detail::reliable_close(fd);
+                        }
+                        throw;
+                    }
+                    m_fd = -1;
+
+                    // Do not sync or close stdout
+                    if (fd == 1) {
+                        return;
+                    }
+
+                    if (do_fsync()) {
+                        osmium::io::detail::reliable_fsync(fd);
+                    }
+                    osmium::io::detail::reliable_close(fd);
+                }
+
+                std::size_t file_size() const override {
+                    return m_file_size;
+                }
+
+            }; // class ParallelCompressor
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PARALLEL_COMPRESSOR_HPP
@@ -0,0 +1,223 @@
+#ifndef OSMIUM_IO_DETAIL_PARALLEL_DECOMPRESSOR_HPP
+#define OSMIUM_IO_DETAIL_PARALLEL_DECOMPRESSOR_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/completion_ring.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Result of decompressing one chunk of input. If the chunk
+             * ended in the middle of a compressed stream, complete is
+             * false. This can happen if the chunk boundary was guessed
+             * from a byte pattern that turned out to be part of the
+             * compressed data.
+             */
+            struct decompressed_chunk {
+                std::string data{};
+                bool complete = true;
+            };
+
+            /**
+             * Decompressor for compressed files consisting of many
+             * independent members (gzip) or streams (bzip2), as written
+             * by tools like bgzip or pbzip2. The file is memory mapped,
+             * split into chunks at member boundaries and the chunks are
+             * decompressed in parallel in the thread pool. The results are
+             * returned by read() in the original order.
+             *
+             * The TFormat class must have the following static functions:
+             *
+             * * std::size_t next_chunk_size(const char* data, std::size_t size):
+             *   Return the size of the chunk starting at data. The chunk
+             *   must end at a member boundary or at the end of the data.
+             * * decompressed_chunk decompress_chunk(const char* data, std::size_t size):
+             *   Decompress all members in the chunk.
+             */
+            template <typename TFormat>
+            class ParallelDecompressor final : public osmium::io::Decompressor {
+
+                struct chunk {
+                    std::size_t offset;
+                    std::size_t size;
+                };
+
+                osmium::util::MemoryMapping m_mapping;
+                int m_fd;
+                osmium::thread::Pool& m_pool;
+
+                // The chunks in flight and their results (in the same order).
+                std::deque<chunk> m_chunks{};
+                osmium::thread::CompletionRing<decompressed_chunk> m_results;
+
+                std::size_t m_next_offset = 0;
+
+                const char* data() const noexcept {
+                    return m_mapping.get_addr<char>();
+                }
+
+                void submit_chunks() {
+                    while (m_next_offset < m_mapping.size() && m_chunks.size() < m_results.capacity()) {
+                        const char* start = data() + m_next_offset;
+                        const std::size_t size = TFormat::next_chunk_size(start, m_mapping.size() - m_next_offset);
+                        m_chunks.push_back(chunk{m_next_offset, size});
+                        m_results.submit(m_pool, [start, size]() {
+                            return TFormat::decompress_chunk(start, size);
+                        }, osmium::thread::task_priority::high);
+                        m_next_offset += size;
+                    }
+                }
+
+                void wait_for_all_chunks() noexcept {
+                    m_results.drain();
+                    m_chunks.clear();
+                }
+
+            public:
+
+                /**
+                 * Create a parallel decompressor. Takes ownership of the fd.
+                 *
+                 * @param mapping Readonly mapping of the whole file.
+                 * @param fd File descriptor of the file.
+                 * @param pool The thread pool to use.
+                 */
+                ParallelDecompressor(osmium::util::MemoryMapping&& mapping, int fd, osmium::thread::Pool& pool) :
+                    m_mapping(std::move(mapping)),
+                    m_fd(fd),
+                    m_pool(pool),
+                    m_results(static_cast<std::size_t>(pool.num_threads()) * 2) {
+                }
+
+                ParallelDecompressor(const ParallelDecompressor&) = delete;
+                ParallelDecompressor& operator=(const ParallelDecompressor&) = delete;
+
+                ParallelDecompressor(ParallelDecompressor&&) = delete;
+                ParallelDecompressor& operator=(ParallelDecompressor&&) = delete;
+
+                ~ParallelDecompressor() noexcept override {
+                    try {
+                        close();
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                std::string read() override {
+                    submit_chunks();
+
+                    if (m_chunks.empty()) {
+                        return {};
+                    }
+
+                    auto c = m_chunks.front();
+                    m_chunks.pop_front();
+                    decompressed_chunk result = m_results.pop();
+
+                    // The chunk didn't end at a real member boundary. Join
+                    // it with the next one and try again. This is rare, so
+                    // it is done here in the reading thread.
+                    while (!result.complete) {
+                        submit_chunks();
+                        if (m_chunks.empty()) {
+                            throw io_error{"decompression failed: truncated input"};
+                        }
+                        c.size += m_chunks.front().size;
+                        m_chunks.pop_front();
+                        m_results.discard();
+                        result = TFormat::decompress_chunk(data() + c.offset, c.size);
+                    }
+
+                    set_offset(c.offset + c.size);
+
+                    return std::move(result.data);
+                }
+
+                void close() override {
+                    wait_for_all_chunks();
+                    if (m_fd >= 0) {
+                        const int fd = m_fd;
+                        m_fd = -1;
+                        m_mapping.unmap();
+                        osmium::io::detail::reliable_close(fd);
+                    }
+                }
+
+            }; // class ParallelDecompressor
+
+            /**
+             * Create a ParallelDecompressor for the file if it is a regular
+             * file and TFormat::is_suitable() says the content can be split.
+             * Returns nullptr otherwise, in that case the fd is left alone.
+             */
+            template <typename TFormat>
+            osmium::io::Decompressor* make_parallel_decompressor(int fd) {
+                try {
+                    const auto size = osmium::file_size(fd);
+                    if (size == 0 || osmium::file_offset(fd) != 0) {
+                        return nullptr;
+                    }
+                    osmium::util::MemoryMapping mapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, fd};
+                    if (!TFormat::is_suitable(mapping.get_addr<char>(), size)) {
+                        return nullptr;
+                    }
+                    return new ParallelDecompressor<TFormat>{std::move(mapping), fd, osmium::thread::Pool::default_instance()};
+                } catch (const std::system_error&) {
+                    return nullptr;
+                }
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PARALLEL_DECOMPRESSOR_HPP
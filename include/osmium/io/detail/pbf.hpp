@@ -76,7 +76,13 @@ namespace osmium {
             enum class pbf_compression : uint8_t {
                 none = 0,
                 zlib = 1,
-                lz4 = 2
+                lz4 = 2,
+                zstd = 3
+            };
+
+            enum class pbf_blob_type {
+                header = 0,
+                data = 1
             };
 
             inline pbf_compression get_compression_type(const std::string& val) {
@@ -89,6 +95,9 @@ namespace osmium {
                 if (val == "lz4") {
                     return pbf_compression::lz4;
                 }
+                if (val == "zstd") {
+                    return pbf_compression::zstd;
+                }
                 throw std::invalid_argument{"Unknown value for 'pbf_compression' option."};
             }
 
@@ -0,0 +1,238 @@
+#ifndef OSMIUM_IO_DETAIL_PBF_BLOB_INDEX_HPP
+#define OSMIUM_IO_DETAIL_PBF_BLOB_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Summary of the contents of one data blob in a PBF file: which
+         * entity types it contains, the smallest and largest ID for
+         * each of those types, and the bounding box of the locations of
+         * nodes (and of ways if the file has locations on ways).
+         */
+        struct pbf_blob_summary {
+
+            osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+            /// Smallest ID of nodes, ways, and relations (in this order).
+            std::array<osmium::object_id_type, 3> min_id{{0, 0, 0}};
+
+            /// Largest ID of nodes, ways, and relations (in this order).
+            std::array<osmium::object_id_type, 3> max_id{{0, 0, 0}};
+
+            /// Bounding box of all locations, invalid if there are none.
+            osmium::Box box{};
+
+            /// Add an object to this summary.
+            void add(osmium::item_type type, osmium::object_id_type id) noexcept {
+                const auto n = osmium::item_type_to_nwr_index(type);
+                const auto bit = osmium::osm_entity_bits::from_item_type(type);
+                if (types & bit) {
+                    if (id < min_id[n]) {
+                        min_id[n] = id;
+                    }
+                    if (id > max_id[n]) {
+                        max_id[n] = id;
+                    }
+                } else {
+                    types |= bit;
+                    min_id[n] = id;
+                    max_id[n] = id;
+                }
+            }
+
+            /// Add an object including its location(s) to this summary.
+            void add(const osmium::OSMObject& object) noexcept {
+                add(object.type(), object.id());
+                if (object.type() == osmium::item_type::node) {
+                    box.extend(static_cast<const osmium::Node&>(object).location());
+                } else if (object.type() == osmium::item_type::way) {
+                    for (const auto& node_ref : static_cast<const osmium::Way&>(object).nodes()) {
+                        box.extend(node_ref.location());
+                    }
+                }
+            }
+
+            /**
+             * Could this blob contain objects of the specified types with
+             * IDs in the range [first, last]?
+             */
+            bool overlaps(osmium::osm_entity_bits::type entities, osmium::object_id_type first, osmium::object_id_type last) const noexcept {
+                for (unsigned int n = 0; n < 3; ++n) {
+                    const auto bit = osmium::osm_entity_bits::from_item_type(osmium::nwr_index_to_item_type(n));
+                    if ((entities & types & bit) && min_id[n] <= last && max_id[n] >= first) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /**
+             * Could this blob contain objects of the specified types in
+             * the specified box? Blobs without known locations could
+             * contain anything.
+             */
+            bool overlaps(osmium::osm_entity_bits::type entities, const osmium::Box& query) const noexcept {
+                if (!(entities & types)) {
+                    return false;
+                }
+                if (!box.valid()) {
+                    return true;
+                }
+                return box.bottom_left().x() <= query.top_right().x() &&
+                       box.top_right().x() >= query.bottom_left().x() &&
+                       box.bottom_left().y() <= query.top_right().y() &&
+                       box.top_right().y() >= query.bottom_left().y();
+            }
+
+        }; // struct pbf_blob_summary
+
+        namespace detail {
+
+            /**
+             * One entry in a PBF blob index: position and size of the
+             * Blob data (after the BlobHeader) of a data blob and the
+             * summary of its contents.
+             */
+            struct pbf_blob_index_entry {
+                std::size_t offset = 0;
+                std::size_t size = 0;
+                pbf_blob_summary summary{};
+            }; // struct pbf_blob_index_entry
+
+            /**
+             * The blob index is stored in a text file next to the PBF
+             * file. The first line contains a magic string, the second the
+             * size of the PBF file and the number of data blobs. Then
+             * follows one line per data blob with offset, size, entity
+             * types, smallest and largest IDs of nodes, ways, and
+             * relations, and the bounding box (x and y of the bottom left
+             * and top right corners). Version 1 of the format didn't have
+             * the bounding box, it can still be read.
+             */
+            inline const char* pbf_blob_index_magic() noexcept {
+                return "osmium-pbf-blob-index 2";
+            }
+
+            inline const char* pbf_blob_index_magic_v1() noexcept {
+                return "osmium-pbf-blob-index 1";
+            }
+
+            /// Default name of the blob index file for a PBF file.
+            inline std::string pbf_blob_index_filename(const std::string& pbf_filename) {
+                return pbf_filename + ".blobidx";
+            }
+
+            inline void write_pbf_blob_index(std::ostream& out, std::size_t file_size, const std::vector<pbf_blob_index_entry>& entries) {
+                out << pbf_blob_index_magic() << '\n'
+                    << file_size << ' ' << entries.size() << '\n';
+                for (const auto& entry : entries) {
+                    const auto& s = entry.summary;
+                    out << entry.offset << ' ' << entry.size << ' '
+                        << static_cast<unsigned int>(s.types) << ' '
+                        << s.min_id[0] << ' ' << s.max_id[0] << ' '
+                        << s.min_id[1] << ' ' << s.max_id[1] << ' '
+                        << s.min_id[2] << ' ' << s.max_id[2] << ' '
+                        << s.box.bottom_left().x() << ' ' << s.box.bottom_left().y() << ' '
+                        << s.box.top_right().x() << ' ' << s.box.top_right().y() << '\n';
+                }
+            }
+
+            /**
+             * Read a blob index. Returns false if the index is invalid or
+             * does not belong to a file of the specified size. The entries
+             * are only changed if the index is valid.
+             */
+            inline bool read_pbf_blob_index(std::istream& in, std::size_t file_size, std::vector<pbf_blob_index_entry>& entries) {
+                std::string magic;
+                std::getline(in, magic);
+                std::size_t index_file_size = 0;
+                std::size_t count = 0;
+                const bool has_box = magic == pbf_blob_index_magic();
+                if ((!has_box && magic != pbf_blob_index_magic_v1()) || !(in >> index_file_size >> count) ||
+                    index_file_size != file_size || count > file_size) {
+                    return false;
+                }
+
+                std::vector<pbf_blob_index_entry> result(count);
+                for (auto& entry : result) {
+                    unsigned int types = 0;
+                    auto& s = entry.summary;
+                    if (!(in >> entry.offset >> entry.size >> types >> s.min_id[0] >> s.max_id[0] >> s.min_id[1] >> s.max_id[1] >> s.min_id[2] >> s.max_id[2])) {
+                        return false;
+                    }
+                    if ((types & ~static_cast<unsigned int>(osmium::osm_entity_bits::nwr)) != 0) {
+                        return false;
+                    }
+                    if (has_box) {
+                        std::array<int32_t, 4> c{};
+                        if (!(in >> c[0] >> c[1] >> c[2] >> c[3]) || c[0] > c[2] || c[1] > c[3]) {
+                            return false;
+                        }
+                        s.box = osmium::Box{osmium::Location{c[0], c[1]}, osmium::Location{c[2], c[3]}};
+                    }
+                    s.types = static_cast<osmium::osm_entity_bits::type>(types);
+                }
+
+                entries = std::move(result);
+                return true;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PBF_BLOB_INDEX_HPP
@@ -0,0 +1,335 @@
+#ifndef OSMIUM_IO_DETAIL_PBF_BLOB_TABLE_HPP
+#define OSMIUM_IO_DETAIL_PBF_BLOB_TABLE_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/tracepoint.hpp>
+
+#include <protozero/pbf_message.hpp>
+#include <protozero/types.hpp>
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifndef _WIN32
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Position, size, and type of a blob in a PBF file.
+             */
+            struct pbf_blob_info {
+
+                /// Offset of the Blob data (after the BlobHeader) in the file.
+                std::size_t offset = 0;
+
+                /// Size of the Blob data in bytes.
+                std::size_t size = 0;
+
+                /// Is this an OSMHeader or OSMData blob?
+                pbf_blob_type type = pbf_blob_type::data;
+
+            }; // struct pbf_blob_info
+
+            /**
+             * Decode the 4 byte length of a BlobHeader which is stored in
+             * network byte order.
+             */
+            inline uint32_t decode_blob_header_length(const char* data) noexcept {
+                const auto* d = reinterpret_cast<const unsigned char*>(data);
+                return (static_cast<uint32_t>(d[3])) |
+                       (static_cast<uint32_t>(d[2]) <<  8U) |
+                       (static_cast<uint32_t>(d[1]) << 16U) |
+                       (static_cast<uint32_t>(d[0]) << 24U);
+            }
+
+            /**
+             * Decode a BlobHeader message. Returns the type of the blob and
+             * the size of the Blob following it. The offset is not set.
+             *
+             * @throws osmium::pbf_error If the BlobHeader is invalid or the
+             *         blob has an unknown type.
+             */
+            inline pbf_blob_info decode_blob_header_info(const protozero::data_view& data) {
+                protozero::pbf_message<FileFormat::BlobHeader> pbf_blob_header{data};
+                protozero::data_view blob_header_type;
+                pbf_blob_info info;
+
+                while (pbf_blob_header.next()) {
+                    switch (pbf_blob_header.tag_and_type()) {
+                        case protozero::tag_and_type(FileFormat::BlobHeader::required_string_type, protozero::pbf_wire_type::length_delimited):
+                            blob_header_type = pbf_blob_header.get_view();
+                            break;
+                        case protozero::tag_and_type(FileFormat::BlobHeader::required_int32_datasize, protozero::pbf_wire_type::varint):
+                            {
+                                const auto datasize = pbf_blob_header.get_int32();
+                                if (datasize < 0) {
+                                    throw osmium::pbf_error{"PBF format error: BlobHeader.datasize negative."};
+                                }
+                                info.size = static_cast<std::size_t>(datasize);
+                            }
+                            break;
+                        default:
+                            pbf_blob_header.skip();
+                    }
+                }
+
+                if (info.size == 0) {
+                    throw osmium::pbf_error{"PBF format error: BlobHeader.datasize missing or zero."};
+                }
+
+                if (info.size > max_uncompressed_blob_size) {
+                    throw osmium::pbf_error{std::string{"invalid blob size: "} + std::to_string(info.size)};
+                }
+
+                if (blob_header_type == protozero::data_view{"OSMData", 7}) {
+                    info.type = pbf_blob_type::data;
+                } else if (blob_header_type == protozero::data_view{"OSMHeader", 9}) {
+                    info.type = pbf_blob_type::header;
+                } else {
+                    throw osmium::pbf_error{"unknown blob type (expected OSMHeader or OSMData)"};
+                }
+
+                return info;
+            }
+
+            /**
+             * A table with the positions, sizes, and types of all blobs in
+             * a PBF file. It is created by scanning the file once reading
+             * only the BlobHeaders. After that the blobs can be accessed in
+             * any order, for instance concurrently from several threads.
+             */
+            class PBFBlobTable {
+
+                std::vector<pbf_blob_info> m_blobs;
+
+            public:
+
+                using const_iterator = std::vector<pbf_blob_info>::const_iterator;
+
+                PBFBlobTable() = default;
+
+                /**
+                 * Build blob table from PBF data in memory (usually a memory
+                 * mapped file).
+                 *
+                 * @param data Pointer to the beginning of the file data.
+                 * @param size Size of the file data.
+                 * @param offset Offset of the first BlobHeader length.
+                 * @throws osmium::pbf_error If the data is invalid or
+                 *         truncated.
+                 */
+                static PBFBlobTable from_memory(const char* data, std::size_t size, std::size_t offset = 0) {
+                    PBFBlobTable table;
+
+                    while (size - offset >= sizeof(uint32_t)) {
+                        const auto header_size = decode_blob_header_length(data + offset);
+                        if (header_size > static_cast<uint32_t>(max_blob_header_size)) {
+                            throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
+                        }
+                        offset += sizeof(uint32_t);
+                        if (size - offset < header_size) {
+                            throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                        }
+
+                        pbf_blob_info info = decode_blob_header_info(protozero::data_view{data + offset, header_size});
+                        offset += header_size;
+                        if (size - offset < info.size) {
+                            throw osmium::pbf_error{"unexpected EOF"};
+                        }
+
+                        info.offset = offset;
+                        offset += info.size;
+                        table.m_blobs.push_back(info);
+                    }
+
+                    return table;
+                }
+
+#ifndef _WIN32
+                /**
+                 * Build blob table by reading the BlobHeaders from a file.
+                 * The file offset is not changed. The Blob data itself is
+                 * never read.
+                 *
+                 * @param fd File descriptor of the file.
+                 * @param offset Offset of the first BlobHeader length.
+                 * @throws osmium::pbf_error If the data is invalid or
+                 *         truncated.
+                 * @throws std::system_error If reading failed.
+                 */
+                static PBFBlobTable from_file(int fd, std::size_t offset = 0) {
+                    PBFBlobTable table;
+                    const auto file_size = osmium::file_size(fd);
+                    std::string buffer;
+
+                    while (true) {
+                        std::array<char, sizeof(uint32_t)> size_buffer{};
+                        if (!reliable_pread(fd, size_buffer.data(), size_buffer.size(), offset)) {
+                            break; // EOF
+                        }
+                        const auto header_size = decode_blob_header_length(size_buffer.data());
+                        if (header_size > static_cast<uint32_t>(max_blob_header_size)) {
+                            throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
+                        }
+                        offset += sizeof(uint32_t);
+
+                        buffer.resize(header_size);
+                        if (!reliable_pread(fd, &*buffer.begin(), header_size, offset)) {
+                            throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                        }
+
+                        pbf_blob_info info = decode_blob_header_info(protozero::data_view{buffer.data(), header_size});
+                        offset += header_size;
+                        if (file_size < offset || file_size - offset < info.size) {
+                            throw osmium::pbf_error{"unexpected EOF"};
+                        }
+
+                        info.offset = offset;
+                        offset += info.size;
+                        table.m_blobs.push_back(info);
+                    }
+
+                    return table;
+                }
+#endif
+
+                /// The number of blobs in the table.
+                std::size_t size() const noexcept {
+                    return m_blobs.size();
+                }
+
+                bool empty() const noexcept {
+                    return m_blobs.empty();
+                }
+
+                const pbf_blob_info& operator[](std::size_t n) const noexcept {
+                    return m_blobs[n];
+                }
+
+                const_iterator begin() const noexcept {
+                    return m_blobs.cbegin();
+                }
+
+                const_iterator end() const noexcept {
+                    return m_blobs.cend();
+                }
+
+            }; // class PBFBlobTable
+
+#ifndef _WIN32
+            /**
+             * Owns a duplicate of a file descriptor and closes it when
+             * destructed. Used to share a file between tasks running in
+             * the thread pool which read blobs from it using pread(2).
+             * Because the descriptor is a duplicate, the tasks can keep
+             * reading even if the original descriptor has been closed.
+             */
+            class PBFBlobFile {
+
+                int m_fd;
+
+            public:
+
+                /**
+                 * @throws std::system_error If the file descriptor can't
+                 *         be duplicated.
+                 */
+                explicit PBFBlobFile(int fd) :
+                    m_fd(::dup(fd)) {
+                    if (m_fd < 0) {
+                        throw std::system_error{errno, std::system_category(), "Duplicating file descriptor failed"};
+                    }
+                }
+
+                PBFBlobFile(const PBFBlobFile&) = delete;
+                PBFBlobFile& operator=(const PBFBlobFile&) = delete;
+
+                PBFBlobFile(PBFBlobFile&&) = delete;
+                PBFBlobFile& operator=(PBFBlobFile&&) = delete;
+
+                ~PBFBlobFile() noexcept {
+                    try {
+                        reliable_close(m_fd);
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                int fd() const noexcept {
+                    return m_fd;
+                }
+
+                /**
+                 * Read the data of the specified blob from the file.
+                 *
+                 * @throws osmium::pbf_error If the file is truncated.
+                 * @throws std::system_error If reading failed.
+                 */
+                std::string read_blob(const pbf_blob_info& blob) const {
+                    OSMIUM_TRACEPOINT1(pbf_blob_read_start, blob.size);
+                    std::string buffer(blob.size, '\0');
+                    if (!reliable_pread(m_fd, &*buffer.begin(), blob.size, blob.offset)) {
+                        throw osmium::pbf_error{"unexpected EOF"};
+                    }
+                    OSMIUM_TRACEPOINT1(pbf_blob_read_end, blob.size);
+                    return buffer;
+                }
+
+            }; // class PBFBlobFile
+#endif
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PBF_BLOB_TABLE_HPP
@@ -0,0 +1,390 @@
+#ifndef OSMIUM_IO_DETAIL_PBF_COLUMNAR_DECODER_HPP
+#define OSMIUM_IO_DETAIL_PBF_COLUMNAR_DECODER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/storage/columnar_batch.hpp>
+#include <osmium/util/delta.hpp>
+
+#include <protozero/pbf_message.hpp>
+#include <protozero/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Decodes a PBF PrimitiveBlock directly into a ColumnarBlock
+             * without building any OSM objects. Only nodes and ways are
+             * decoded, relations are skipped as is all metadata (except
+             * the visible flag which decides whether a node has a
+             * location).
+             *
+             * The strings of the block's string table are added to the
+             * string pools of the batches once each, the tags are then
+             * added as indexes into the pools.
+             */
+            class PBFColumnarBlockDecoder {
+
+                static constexpr StringPool::id_type no_index() noexcept {
+                    return std::numeric_limits<StringPool::id_type>::max();
+                }
+
+                data_view m_data;
+                std::vector<data_view> m_stringtable;
+
+                // Map from string table index to the index in the string
+                // pool of the node batch or the way batch.
+                std::vector<StringPool::id_type> m_node_strings;
+                std::vector<StringPool::id_type> m_way_strings;
+
+                int64_t m_lon_offset = 0;
+                int64_t m_lat_offset = 0;
+                int32_t m_granularity = 100;
+
+                osmium::osm_entity_bits::type m_read_types;
+
+                std::vector<int64_t> m_ids;
+                std::vector<int64_t> m_lons;
+                std::vector<int64_t> m_lats;
+                std::vector<int64_t> m_refs;
+
+                void decode_stringtable(const data_view& data) {
+                    if (!m_stringtable.empty()) {
+                        throw osmium::pbf_error{"more than one stringtable in pbf file"};
+                    }
+
+                    protozero::pbf_message<OSMFormat::StringTable> pbf_string_table{data};
+                    while (pbf_string_table.next(OSMFormat::StringTable::repeated_bytes_s, protozero::pbf_wire_type::length_delimited)) {
+                        m_stringtable.push_back(pbf_string_table.get_view());
+                    }
+                    m_node_strings.assign(m_stringtable.size(), no_index());
+                    m_way_strings.assign(m_stringtable.size(), no_index());
+                }
+
+                void decode_primitive_block_metadata() {
+                    protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{m_data};
+                    while (pbf_primitive_block.next()) {
+                        switch (pbf_primitive_block.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::PrimitiveBlock::required_StringTable_stringtable, protozero::pbf_wire_type::length_delimited):
+                                decode_stringtable(pbf_primitive_block.get_view());
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveBlock::optional_int32_granularity, protozero::pbf_wire_type::varint):
+                                m_granularity = pbf_primitive_block.get_int32();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveBlock::optional_int64_lat_offset, protozero::pbf_wire_type::varint):
+                                m_lat_offset = pbf_primitive_block.get_int64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveBlock::optional_int64_lon_offset, protozero::pbf_wire_type::varint):
+                                m_lon_offset = pbf_primitive_block.get_int64();
+                                break;
+                            default:
+                                pbf_primitive_block.skip();
+                        }
+                    }
+                }
+
+                template <typename TBatch>
+                StringPool::id_type string_index(TBatch& batch, std::vector<StringPool::id_type>& map, uint32_t n) {
+                    if (n >= m_stringtable.size()) {
+                        throw osmium::pbf_error{"string id out of range"};
+                    }
+                    if (map[n] == no_index()) {
+                        map[n] = batch.add_string(m_stringtable[n].data(), m_stringtable[n].size());
+                    }
+                    return map[n];
+                }
+
+                template <typename TBatch>
+                void add_tags(TBatch& batch, std::vector<StringPool::id_type>& map, varint_range& keys, varint_range& vals) {
+                    while (!keys.empty() && !vals.empty()) {
+                        const auto k = string_index(batch, map, keys.next_uint32());
+                        batch.add_tag(k, string_index(batch, map, vals.next_uint32()));
+                    }
+                }
+
+                int32_t convert_pbf_lon(const int64_t c) const noexcept {
+                    return int32_t((c * m_granularity + m_lon_offset) / resolution_convert);
+                }
+
+                int32_t convert_pbf_lat(const int64_t c) const noexcept {
+                    return int32_t((c * m_granularity + m_lat_offset) / resolution_convert);
+                }
+
+                static bool decode_visible(const data_view& data) {
+                    protozero::pbf_message<OSMFormat::Info> pbf_info{data};
+                    while (pbf_info.next(OSMFormat::Info::optional_bool_visible, protozero::pbf_wire_type::varint)) {
+                        return pbf_info.get_bool();
+                    }
+                    return true;
+                }
+
+                static varint_range decode_dense_visibles(const data_view& data) {
+                    protozero::pbf_message<OSMFormat::DenseInfo> pbf_dense_info{data};
+                    while (pbf_dense_info.next(OSMFormat::DenseInfo::packed_bool_visible, protozero::pbf_wire_type::length_delimited)) {
+                        return varint_range{pbf_dense_info.get_view()};
+                    }
+                    return varint_range{};
+                }
+
+                void decode_node(const data_view& data, osmium::ColumnarNodeBatch& nodes) {
+                    osmium::object_id_type id = 0;
+                    varint_range keys;
+                    varint_range vals;
+                    int64_t lon = std::numeric_limits<int64_t>::max();
+                    int64_t lat = std::numeric_limits<int64_t>::max();
+                    bool visible = true;
+
+                    protozero::pbf_message<OSMFormat::Node> pbf_node{data};
+                    while (pbf_node.next()) {
+                        switch (pbf_node.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_id, protozero::pbf_wire_type::varint):
+                                id = pbf_node.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                                keys = varint_range{pbf_node.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::packed_uint32_vals, protozero::pbf_wire_type::length_delimited):
+                                vals = varint_range{pbf_node.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::optional_Info_info, protozero::pbf_wire_type::length_delimited):
+                                visible = decode_visible(pbf_node.get_view());
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_lat, protozero::pbf_wire_type::varint):
+                                lat = pbf_node.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_lon, protozero::pbf_wire_type::varint):
+                                lon = pbf_node.get_sint64();
+                                break;
+                            default:
+                                pbf_node.skip();
+                        }
+                    }
+
+                    osmium::Location location;
+                    if (visible) {
+                        if (lon == std::numeric_limits<int64_t>::max() ||
+                            lat == std::numeric_limits<int64_t>::max()) {
+                            throw osmium::pbf_error{"illegal coordinate format"};
+                        }
+                        location = osmium::Location{convert_pbf_lon(lon), convert_pbf_lat(lat)};
+                    }
+
+                    nodes.add_node(id, location);
+                    add_tags(nodes, m_node_strings, keys, vals);
+                }
+
+                void decode_dense_nodes(const data_view& data, osmium::ColumnarNodeBatch& nodes) {
+                    varint_range ids;
+                    varint_range lats;
+                    varint_range lons;
+                    varint_range tags;
+                    varint_range visibles;
+
+                    protozero::pbf_message<OSMFormat::DenseNodes> pbf_dense_nodes{data};
+                    while (pbf_dense_nodes.next()) {
+                        switch (pbf_dense_nodes.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
+                                ids = varint_range{pbf_dense_nodes.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::optional_DenseInfo_denseinfo, protozero::pbf_wire_type::length_delimited):
+                                visibles = decode_dense_visibles(pbf_dense_nodes.get_view());
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
+                                lats = varint_range{pbf_dense_nodes.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
+                                lons = varint_range{pbf_dense_nodes.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
+                                tags = varint_range{pbf_dense_nodes.get_view()};
+                                break;
+                            default:
+                                pbf_dense_nodes.skip();
+                        }
+                    }
+
+                    ids.decode_delta_sint64(m_ids);
+                    lons.decode_delta_sint64(m_lons);
+                    lats.decode_delta_sint64(m_lats);
+                    if (m_lons.size() < m_ids.size() ||
+                        m_lats.size() < m_ids.size()) {
+                        // this is against the spec, must have same number of elements
+                        throw osmium::pbf_error{"PBF format error"};
+                    }
+
+                    nodes.reserve(nodes.size() + m_ids.size());
+                    for (std::size_t i = 0; i < m_ids.size(); ++i) {
+                        const bool visible = visibles.empty() || visibles.next_int32() != 0;
+                        nodes.add_node(m_ids[i], visible ? osmium::Location{convert_pbf_lon(m_lons[i]), convert_pbf_lat(m_lats[i])}
+                                                         : osmium::Location{});
+
+                        while (!tags.empty()) {
+                            const auto idx = tags.next_int32();
+                            if (idx == 0) {
+                                break;
+                            }
+                            if (tags.empty()) {
+                                throw osmium::pbf_error{"PBF format error"}; // this is against the spec, keys/vals must come in pairs
+                            }
+                            const auto k = string_index(nodes, m_node_strings, static_cast<uint32_t>(idx));
+                            nodes.add_tag(k, string_index(nodes, m_node_strings, static_cast<uint32_t>(tags.next_int32())));
+                        }
+                    }
+                }
+
+                void decode_way(const data_view& data, osmium::ColumnarWayBatch& ways) {
+                    osmium::object_id_type id = 0;
+                    varint_range keys;
+                    varint_range vals;
+                    varint_range refs;
+
+                    protozero::pbf_message<OSMFormat::Way> pbf_way{data};
+                    while (pbf_way.next()) {
+                        switch (pbf_way.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::Way::required_int64_id, protozero::pbf_wire_type::varint):
+                                id = pbf_way.get_int64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Way::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                                keys = varint_range{pbf_way.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Way::packed_uint32_vals, protozero::pbf_wire_type::length_delimited):
+                                vals = varint_range{pbf_way.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Way::packed_sint64_refs, protozero::pbf_wire_type::length_delimited):
+                                refs = varint_range{pbf_way.get_view()};
+                                break;
+                            default:
+                                pbf_way.skip();
+                        }
+                    }
+
+                    ways.add_way(id);
+                    refs.decode_delta_sint64(m_refs);
+                    for (const auto ref : m_refs) {
+                        ways.add_ref(ref);
+                    }
+                    add_tags(ways, m_way_strings, keys, vals);
+                }
+
+                void decode_primitive_block_data(osmium::ColumnarBlock& block) {
+                    protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{m_data};
+                    while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited)) {
+                        protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group = pbf_primitive_block.get_message();
+                        while (pbf_primitive_group.next()) {
+                            switch (pbf_primitive_group.tag_and_type()) {
+                                case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
+                                    if (m_read_types & osmium::osm_entity_bits::node) {
+                                        decode_node(pbf_primitive_group.get_view(), block.nodes);
+                                    } else {
+                                        pbf_primitive_group.skip();
+                                    }
+                                    break;
+                                case protozero::tag_and_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, protozero::pbf_wire_type::length_delimited):
+                                    if (m_read_types & osmium::osm_entity_bits::node) {
+                                        decode_dense_nodes(pbf_primitive_group.get_view(), block.nodes);
+                                    } else {
+                                        pbf_primitive_group.skip();
+                                    }
+                                    break;
+                                case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Way_ways, protozero::pbf_wire_type::length_delimited):
+                                    if (m_read_types & osmium::osm_entity_bits::way) {
+                                        decode_way(pbf_primitive_group.get_view(), block.ways);
+                                    } else {
+                                        pbf_primitive_group.skip();
+                                    }
+                                    break;
+                                default:
+                                    pbf_primitive_group.skip();
+                            }
+                        }
+                    }
+                }
+
+            public:
+
+                /**
+                 * Create decoder for a PrimitiveBlock.
+                 *
+                 * @param data The uncompressed block data.
+                 * @param read_types Which entity types to decode. Only
+                 *                   nodes and ways are supported.
+                 */
+                PBFColumnarBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types) :
+                    m_data(data),
+                    m_read_types(read_types) {
+                }
+
+                /**
+                 * Decode the block appending the nodes and ways to the
+                 * given block.
+                 */
+                void operator()(osmium::ColumnarBlock& block) {
+                    decode_primitive_block_metadata();
+                    decode_primitive_block_data(block);
+                }
+
+                /**
+                 * Decode the block into a new ColumnarBlock.
+                 */
+                osmium::ColumnarBlock operator()() {
+                    osmium::ColumnarBlock block;
+                    operator()(block);
+                    return block;
+                }
+
+            }; // class PBFColumnarBlockDecoder
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PBF_COLUMNAR_DECODER_HPP
@@ -33,6 +33,9 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <limits>
@@ -43,13 +46,19 @@ DEALINGS IN THE SOFTWARE.
 #include <vector>
 
 #include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/detail/buffer_recycler.hpp>
 #include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
+#include <osmium/io/detail/pbf_varint.hpp>
 #include <osmium/io/detail/protobuf_tags.hpp>
 #include <osmium/io/detail/zlib.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/read_query.hpp>
+#include <osmium/io/tags_prefilter.hpp>
+#include <osmium/io/timestamp_window.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/box.hpp>
+#include <osmium/osm/changeset.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
@@ -60,11 +69,17 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 #include <osmium/util/delta.hpp>
+#include <osmium/util/memory_mapping.hpp>
+#include <osmium/util/tracepoint.hpp>
 
 #ifdef OSMIUM_WITH_LZ4
 # include <osmium/io/detail/lz4.hpp>
 #endif
 
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
+
 #include <protozero/iterators.hpp>
 #include <protozero/pbf_message.hpp>
 #include <protozero/types.hpp>
@@ -132,6 +147,20 @@ namespace osmium {
                     return protozero::decode_zigzag64(next());
                 }
 
+                /**
+                 * Decode all remaining values as delta encoded sint64s
+                 * into out in one go. The vector is resized to the number
+                 * of values, existing capacity is reused.
+                 */
+                void decode_delta_sint64(std::vector<int64_t>& out) {
+                    out.resize(size());
+                    if (out.empty()) {
+                        return;
+                    }
+                    const auto count = decode_delta_encoded_sint64(&m_data, m_end, out.data(), out.size());
+                    out.resize(count);
+                }
+
             }; // class varint_range
 
             using osm_string_len_type = std::pair<const char*, osmium::string_size_type>;
@@ -152,10 +181,63 @@ namespace osmium {
 
                 osmium::osm_entity_bits::type m_read_types;
 
-                osmium::memory::Buffer m_buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::internal};
+                // Types of all groups in the block, whether read or not.
+                osmium::osm_entity_bits::type m_types_found = osmium::osm_entity_bits::nothing;
+
+                osmium::memory::Buffer m_buffer;
 
                 osmium::io::read_meta m_read_metadata;
 
+                // Scratch space for decoding dense nodes and way node lists,
+                // reused between objects.
+                std::vector<int64_t> m_ids;
+                std::vector<int64_t> m_refs;
+                std::vector<int64_t> m_lons;
+                std::vector<int64_t> m_lats;
+
+                // Scratch space for the keys and values of one tag list.
+                std::vector<osm_string_len_type> m_tag_strings;
+                std::vector<int32_t> m_tag_ids;
+
+                osmium::io::tags_prefilter m_prefilter;
+
+                // For each string in the string table: Can it be the key
+                // of a tag matching the prefilter? This is only filled in
+                // when the string is first used as a key.
+                enum class key_state : uint8_t {
+                    unknown = 0,
+                    no      = 1,
+                    yes     = 2
+                };
+                std::vector<key_state> m_key_states;
+
+                // Scratch space for decoding changeset discussions.
+                std::vector<data_view> m_changeset_comments;
+                std::string m_comment_user;
+                std::string m_comment_text;
+
+                // The prefilter needs null-terminated strings, but strings
+                // in the string table aren't.
+                std::string m_prefilter_key;
+                std::string m_prefilter_value;
+
+                osmium::io::timestamp_window m_timestamp_window;
+
+                // Only the ID sets and the box of the query are used here.
+                osmium::io::read_query m_query;
+                bool m_use_query = false;
+
+                // With a timestamp window: Which of the objects in the
+                // current group (or dense nodes) should be built? For
+                // groups the objects are counted by m_window_index.
+                std::vector<bool> m_window_wanted;
+                std::size_t m_window_index = 0;
+
+                // Scratch space for the ids and timestamps of the objects
+                // in a group.
+                std::vector<int64_t> m_window_ids;
+                std::vector<int64_t> m_timestamps;
+
                 void decode_stringtable(const data_view& data) {
                     if (!m_stringtable.empty()) {
                         throw osmium::pbf_error{"more than one stringtable in pbf file"};
@@ -200,10 +282,15 @@ namespace osmium {
                 void decode_primitive_block_data() {
                     protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{m_data};
                     while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited)) {
-                        protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group = pbf_primitive_block.get_message();
+                        const auto group_data = pbf_primitive_block.get_view();
+                        if (m_timestamp_window) {
+                            select_group_objects_in_window(group_data);
+                        }
+                        protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group{group_data};
                         while (pbf_primitive_group.next()) {
                             switch (pbf_primitive_group.tag_and_type()) {
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
+                                    m_types_found |= osmium::osm_entity_bits::node;
                                     if (m_read_types & osmium::osm_entity_bits::node) {
                                         decode_node(pbf_primitive_group.get_view());
                                         m_buffer.commit();
@@ -212,6 +299,7 @@ namespace osmium {
                                     }
                                     break;
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, protozero::pbf_wire_type::length_delimited):
+                                    m_types_found |= osmium::osm_entity_bits::node;
                                     if (m_read_types & osmium::osm_entity_bits::node) {
                                         if (m_read_metadata == osmium::io::read_meta::yes) {
                                             decode_dense_nodes(pbf_primitive_group.get_view());
@@ -224,6 +312,7 @@ namespace osmium {
                                     }
                                     break;
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Way_ways, protozero::pbf_wire_type::length_delimited):
+                                    m_types_found |= osmium::osm_entity_bits::way;
                                     if (m_read_types & osmium::osm_entity_bits::way) {
                                         decode_way(pbf_primitive_group.get_view());
                                         m_buffer.commit();
@@ -232,6 +321,7 @@ namespace osmium {
                                     }
                                     break;
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations, protozero::pbf_wire_type::length_delimited):
+                                    m_types_found |= osmium::osm_entity_bits::relation;
                                     if (m_read_types & osmium::osm_entity_bits::relation) {
                                         decode_relation(pbf_primitive_group.get_view());
                                         m_buffer.commit();
@@ -239,6 +329,15 @@ namespace osmium {
                                         pbf_primitive_group.skip();
                                     }
                                     break;
+                                case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_ChangeSet_changesets, protozero::pbf_wire_type::length_delimited):
+                                    m_types_found |= osmium::osm_entity_bits::changeset;
+                                    if (m_read_types & osmium::osm_entity_bits::changeset) {
+                                        decode_changeset(pbf_primitive_group.get_view());
+                                        m_buffer.commit();
+                                    } else {
+                                        pbf_primitive_group.skip();
+                                    }
+                                    break;
                                 default:
                                     pbf_primitive_group.skip();
                             }
@@ -246,6 +345,162 @@ namespace osmium {
                     }
                 }
 
+                void init_prefilter() {
+                    m_key_states.assign(m_stringtable.size(), key_state::unknown);
+                }
+
+                bool prefilter_matches(const uint32_t key_id, const uint32_t value_id) {
+                    auto& state = m_key_states.at(key_id);
+                    const auto& key = m_stringtable[key_id];
+                    if (state == key_state::unknown) {
+                        state = m_prefilter.key_can_match(key.first, key.second) ? key_state::yes : key_state::no;
+                    }
+                    if (state == key_state::no) {
+                        return false;
+                    }
+                    const auto& value = m_stringtable.at(value_id);
+                    m_prefilter_key.assign(key.first, key.second);
+                    m_prefilter_value.assign(value.first, value.second);
+                    return m_prefilter(m_prefilter_key.c_str(), m_prefilter_value.c_str());
+                }
+
+                bool prefilter_applies_to(const osmium::osm_entity_bits::type type) const noexcept {
+                    return (m_prefilter.entities() & type) != 0;
+                }
+
+                // Check the tags of a Node, Way, or Relation message against
+                // the prefilter without decoding anything else.
+                template <typename TPBFMessage>
+                bool prefilter_wants(const data_view& data) {
+                    varint_range keys;
+                    varint_range vals;
+
+                    protozero::pbf_message<TPBFMessage> pbf_object{data};
+                    while (pbf_object.next()) {
+                        switch (pbf_object.tag_and_type()) {
+                            case protozero::tag_and_type(TPBFMessage::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                                keys = varint_range{pbf_object.get_view()};
+                                break;
+                            case protozero::tag_and_type(TPBFMessage::packed_uint32_vals, protozero::pbf_wire_type::length_delimited):
+                                vals = varint_range{pbf_object.get_view()};
+                                break;
+                            default:
+                                pbf_object.skip();
+                        }
+                    }
+
+                    while (!keys.empty() && !vals.empty()) {
+                        if (prefilter_matches(keys.next_uint32(), vals.next_uint32())) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                // Decide for each of the objects with the ids and timestamps
+                // in m_window_ids and m_timestamps whether it should be
+                // built. Versions of the same object are next to each
+                // other.
+                void select_objects_in_window() {
+                    const auto count = m_window_ids.size();
+                    m_window_wanted.resize(count);
+                    for (std::size_t i = 0; i < count; ++i) {
+                        const bool next_is_before = i + 1 < count &&
+                                                    m_window_ids[i + 1] == m_window_ids[i] &&
+                                                    m_timestamp_window.is_before(m_timestamps[i + 1]);
+                        m_window_wanted[i] = m_timestamp_window.wants(m_timestamps[i], next_is_before);
+                    }
+                    m_window_index = 0;
+                }
+
+                int64_t decode_info_timestamp(const data_view& data) {
+                    protozero::pbf_message<OSMFormat::Info> pbf_info{data};
+                    if (pbf_info.next(OSMFormat::Info::optional_int64_timestamp, protozero::pbf_wire_type::varint)) {
+                        return pbf_info.get_int64() * m_date_factor / 1000;
+                    }
+                    return 0;
+                }
+
+                // Get the id and timestamp of a Node, Way, or Relation
+                // message without decoding anything else.
+                template <typename TPBFMessage>
+                void add_window_object(const data_view& data, const TPBFMessage id_tag, const bool zigzag_id, const TPBFMessage info_tag) {
+                    int64_t id = 0;
+                    int64_t timestamp = 0;
+                    protozero::pbf_message<TPBFMessage> pbf_object{data};
+                    while (pbf_object.next()) {
+                        if (pbf_object.tag() == id_tag) {
+                            id = zigzag_id ? pbf_object.get_sint64() : pbf_object.get_int64();
+                        } else if (pbf_object.tag() == info_tag && pbf_object.wire_type() == protozero::pbf_wire_type::length_delimited) {
+                            timestamp = decode_info_timestamp(pbf_object.get_view());
+                        } else {
+                            pbf_object.skip();
+                        }
+                    }
+                    m_window_ids.push_back(id);
+                    m_timestamps.push_back(timestamp);
+                }
+
+                // Decide which of the nodes, ways, and relations (not dense
+                // nodes) in the group should be built. Only the types that
+                // are read are looked at, in the same order in which they
+                // are decoded.
+                void select_group_objects_in_window(const data_view& data) {
+                    m_window_ids.clear();
+                    m_timestamps.clear();
+                    protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group{data};
+                    while (pbf_primitive_group.next()) {
+                        switch (pbf_primitive_group.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
+                                if (m_read_types & osmium::osm_entity_bits::node) {
+                                    add_window_object(pbf_primitive_group.get_view(), OSMFormat::Node::required_sint64_id, true, OSMFormat::Node::optional_Info_info);
+                                } else {
+                                    pbf_primitive_group.skip();
+                                }
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Way_ways, protozero::pbf_wire_type::length_delimited):
+                                if (m_read_types & osmium::osm_entity_bits::way) {
+                                    add_window_object(pbf_primitive_group.get_view(), OSMFormat::Way::required_int64_id, false, OSMFormat::Way::optional_Info_info);
+                                } else {
+                                    pbf_primitive_group.skip();
+                                }
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations, protozero::pbf_wire_type::length_delimited):
+                                if (m_read_types & osmium::osm_entity_bits::relation) {
+                                    add_window_object(pbf_primitive_group.get_view(), OSMFormat::Relation::required_int64_id, false, OSMFormat::Relation::optional_Info_info);
+                                } else {
+                                    pbf_primitive_group.skip();
+                                }
+                                break;
+                            default:
+                                pbf_primitive_group.skip();
+                        }
+                    }
+                    select_objects_in_window();
+                }
+
+                // Should the next node, way, or relation of the group be
+                // built?
+                bool next_object_in_window() noexcept {
+                    if (!m_timestamp_window) {
+                        return true;
+                    }
+                    return m_window_index < m_window_wanted.size() && m_window_wanted[m_window_index++];
+                }
+
+                // Decide which of the dense nodes should be built. The
+                // timestamps range is copied, because it is still needed
+                // for decoding the metadata.
+                void select_dense_nodes_in_window(varint_range timestamps) {
+                    timestamps.decode_delta_sint64(m_timestamps);
+                    for (auto& timestamp : m_timestamps) {
+                        timestamp = timestamp * m_date_factor / 1000;
+                    }
+                    m_timestamps.resize(m_ids.size(), 0);
+                    m_window_ids.assign(m_ids.cbegin(), m_ids.cend());
+                    select_objects_in_window();
+                }
+
                 osm_string_len_type decode_info(const data_view& data, osmium::OSMObject& object) {
                     osm_string_len_type user{"", 0};
 
@@ -305,12 +560,14 @@ namespace osmium {
                         return;
                     }
 
-                    osmium::builder::TagListBuilder builder{parent};
+                    m_tag_strings.clear();
                     do {
-                        const auto& k = m_stringtable.at(keys.next_uint32());
-                        const auto& v = m_stringtable.at(vals.next_uint32());
-                        builder.add_tag(k.first, k.second, v.first, v.second);
+                        m_tag_strings.push_back(m_stringtable.at(keys.next_uint32()));
+                        m_tag_strings.push_back(m_stringtable.at(vals.next_uint32()));
                     } while (!keys.empty() && !vals.empty());
+
+                    osmium::builder::TagListBuilder builder{parent};
+                    builder.add_tags(m_tag_strings.cbegin(), m_tag_strings.cend());
                 }
 
                 int32_t convert_pbf_lon(const int64_t c) const noexcept {
@@ -321,7 +578,68 @@ namespace osmium {
                     return int32_t((c * m_granularity + m_lat_offset) / resolution_convert);
                 }
 
+                // Check the ID and location of a Node message against the
+                // query without decoding anything else.
+                bool query_wants_node(const data_view& data) const {
+                    osmium::object_id_type id = 0;
+                    int64_t lon = std::numeric_limits<int64_t>::max();
+                    int64_t lat = std::numeric_limits<int64_t>::max();
+
+                    protozero::pbf_message<OSMFormat::Node> pbf_node{data};
+                    while (pbf_node.next()) {
+                        switch (pbf_node.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_id, protozero::pbf_wire_type::varint):
+                                id = pbf_node.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_lat, protozero::pbf_wire_type::varint):
+                                lat = pbf_node.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_lon, protozero::pbf_wire_type::varint):
+                                lon = pbf_node.get_sint64();
+                                break;
+                            default:
+                                pbf_node.skip();
+                        }
+                    }
+
+                    if (!m_query.wants_id(osmium::item_type::node, id)) {
+                        return false;
+                    }
+                    if (!m_query.box().valid()) {
+                        return true;
+                    }
+                    return lon != std::numeric_limits<int64_t>::max() &&
+                           lat != std::numeric_limits<int64_t>::max() &&
+                           m_query.wants_location(osmium::Location{convert_pbf_lon(lon), convert_pbf_lat(lat)});
+                }
+
+                // Check the ID of a Way or Relation message against the
+                // ID set of the query without decoding anything else.
+                template <typename TPBFMessage>
+                bool query_wants_id(const data_view& data, const TPBFMessage id_tag, const osmium::item_type type) const {
+                    protozero::pbf_message<TPBFMessage> pbf_object{data};
+                    if (pbf_object.next(id_tag, protozero::pbf_wire_type::varint)) {
+                        return m_query.wants_id(type, pbf_object.get_int64());
+                    }
+                    return m_query.wants_id(type, 0);
+                }
+
+                bool query_wants_dense_node(std::size_t i) const {
+                    return m_query.wants_id(osmium::item_type::node, m_ids[i]) &&
+                           m_query.wants_location(osmium::Location{convert_pbf_lon(m_lons[i]), convert_pbf_lat(m_lats[i])});
+                }
+
                 void decode_node(const data_view& data) {
+                    if (!next_object_in_window()) {
+                        return;
+                    }
+                    if (m_use_query && !query_wants_node(data)) {
+                        return;
+                    }
+                    if (prefilter_applies_to(osmium::osm_entity_bits::node) && !prefilter_wants<OSMFormat::Node>(data)) {
+                        return;
+                    }
+
                     osmium::builder::NodeBuilder builder{m_buffer};
                     osmium::Node& node = builder.object();
 
@@ -379,6 +697,17 @@ namespace osmium {
                 }
 
                 void decode_way(const data_view& data) {
+                    if (!next_object_in_window()) {
+                        return;
+                    }
+                    if (m_use_query && m_query.has_ids(osmium::item_type::way) &&
+                        !query_wants_id(data, OSMFormat::Way::required_int64_id, osmium::item_type::way)) {
+                        return;
+                    }
+                    if (prefilter_applies_to(osmium::osm_entity_bits::way) && !prefilter_wants<OSMFormat::Way>(data)) {
+                        return;
+                    }
+
                     osmium::builder::WayBuilder builder{m_buffer};
 
                     varint_range keys;
@@ -426,20 +755,20 @@ namespace osmium {
 
                     if (!refs.empty()) {
                         osmium::builder::WayNodeListBuilder wnl_builder{builder};
-                        osmium::DeltaDecode<int64_t> ref;
+                        refs.decode_delta_sint64(m_refs);
                         if (lats.empty()) {
-                            while (!refs.empty()) {
-                                wnl_builder.add_node_ref(ref.update(refs.next_sint64()));
-                            }
+                            wnl_builder.add_node_refs(m_refs.cbegin(), m_refs.cend());
                         } else {
-                            osmium::DeltaDecode<int64_t> lon;
-                            osmium::DeltaDecode<int64_t> lat;
-                            while (!refs.empty() && !lons.empty() && !lats.empty()) {
-                                wnl_builder.add_node_ref(
-                                    ref.update(refs.next_sint64()),
-                                    osmium::Location{convert_pbf_lon(lon.update(lons.next_sint64())),
-                                                     convert_pbf_lat(lat.update(lats.next_sint64()))}
-                                );
+                            lons.decode_delta_sint64(m_lons);
+                            lats.decode_delta_sint64(m_lats);
+                            const auto count = std::min(m_refs.size(), std::min(m_lons.size(), m_lats.size()));
+                            auto* node_refs = wnl_builder.add_empty_node_refs(count);
+                            for (std::size_t i = 0; i < count; ++i) {
+                                node_refs[i] = osmium::NodeRef{
+                                    m_refs[i],
+                                    osmium::Location{convert_pbf_lon(m_lons[i]),
+                                                     convert_pbf_lat(m_lats[i])}
+                                };
                             }
                         }
                     }
@@ -448,6 +777,17 @@ namespace osmium {
                 }
 
                 void decode_relation(const data_view& data) {
+                    if (!next_object_in_window()) {
+                        return;
+                    }
+                    if (m_use_query && m_query.has_ids(osmium::item_type::relation) &&
+                        !query_wants_id(data, OSMFormat::Relation::required_int64_id, osmium::item_type::relation)) {
+                        return;
+                    }
+                    if (prefilter_applies_to(osmium::osm_entity_bits::relation) && !prefilter_wants<OSMFormat::Relation>(data)) {
+                        return;
+                    }
+
                     osmium::builder::RelationBuilder builder{m_buffer};
 
                     varint_range keys;
@@ -514,20 +854,166 @@ namespace osmium {
                     build_tag_list(builder, keys, vals);
                 }
 
-                void build_tag_list_from_dense_nodes(osmium::builder::NodeBuilder& builder, varint_range& tags) {
-                    osmium::builder::TagListBuilder tl_builder{builder};
+                // Changesets are a libosmium extension of the PBF format,
+                // see the PBF writer for details.
+                void decode_changeset(const data_view& data) {
+                    osmium::builder::ChangesetBuilder builder{m_buffer};
+
+                    varint_range keys;
+                    varint_range vals;
+                    osm_string_len_type user{"", 0};
+                    int64_t bounds[4] = {0, 0, 0, 0};
+                    bool has_bounds = false;
+                    m_changeset_comments.clear();
+
+                    protozero::pbf_message<OSMFormat::ChangeSet> pbf_changeset{data};
+                    while (pbf_changeset.next()) {
+                        switch (pbf_changeset.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::required_int64_id, protozero::pbf_wire_type::varint):
+                                {
+                                    const auto id = pbf_changeset.get_int64();
+                                    if (id < 0 || id >= std::numeric_limits<changeset_id_type>::max()) {
+                                        throw osmium::pbf_error{"changeset id must be between 0 and 2^32-1"};
+                                    }
+                                    builder.set_id(static_cast<changeset_id_type>(id));
+                                }
+                                break;
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                                keys = varint_range{pbf_changeset.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::packed_uint32_vals, protozero::pbf_wire_type::length_delimited):
+                                vals = varint_range{pbf_changeset.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::optional_int64_created_at, protozero::pbf_wire_type::varint):
+                                builder.set_created_at(osmium::Timestamp{pbf_changeset.get_int64() * m_date_factor / 1000});
+                                break;
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::optional_int64_closed_at, protozero::pbf_wire_type::varint):
+                                builder.set_closed_at(osmium::Timestamp{pbf_changeset.get_int64() * m_date_factor / 1000});
+                                break;
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::optional_int32_uid, protozero::pbf_wire_type::varint):
+                                builder.set_uid_from_signed(pbf_changeset.get_int32());
+                                break;
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::optional_uint32_user_sid, protozero::pbf_wire_type::varint):
+                                user = m_stringtable.at(pbf_changeset.get_uint32());
+                                break;
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::optional_uint32_num_changes, protozero::pbf_wire_type::varint):
+                                builder.set_num_changes(pbf_changeset.get_uint32());
+                                break;
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::optional_uint32_num_comments, protozero::pbf_wire_type::varint):
+                                builder.set_num_comments(pbf_changeset.get_uint32());
+                                break;
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::optional_sint64_min_lon, protozero::pbf_wire_type::varint):
+                                bounds[0] = pbf_changeset.get_sint64();
+                                has_bounds = true;
+                                break;
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::optional_sint64_min_lat, protozero::pbf_wire_type::varint):
+                                bounds[1] = pbf_changeset.get_sint64();
+                                has_bounds = true;
+                                break;
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::optional_sint64_max_lon, protozero::pbf_wire_type::varint):
+                                bounds[2] = pbf_changeset.get_sint64();
+                                has_bounds = true;
+                                break;
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::optional_sint64_max_lat, protozero::pbf_wire_type::varint):
+                                bounds[3] = pbf_changeset.get_sint64();
+                                has_bounds = true;
+                                break;
+                            case protozero::tag_and_type(OSMFormat::ChangeSet::repeated_ChangeSetComment_comments, protozero::pbf_wire_type::length_delimited):
+                                m_changeset_comments.push_back(pbf_changeset.get_view());
+                                break;
+                            default:
+                                pbf_changeset.skip();
+                        }
+                    }
+
+                    if (has_bounds) {
+                        builder.set_bounds(osmium::Box{osmium::Location{convert_pbf_lon(bounds[0]), convert_pbf_lat(bounds[1])},
+                                                       osmium::Location{convert_pbf_lon(bounds[2]), convert_pbf_lat(bounds[3])}});
+                    }
+
+                    builder.set_user(user.first, user.second);
+
+                    build_tag_list(builder, keys, vals);
+
+                    if (m_changeset_comments.empty()) {
+                        return;
+                    }
+
+                    osmium::builder::ChangesetDiscussionBuilder discussion_builder{builder};
+                    for (const auto& comment_data : m_changeset_comments) {
+                        osmium::Timestamp date;
+                        osmium::user_id_type uid = 0;
+                        m_comment_user.clear();
+                        m_comment_text.clear();
+
+                        protozero::pbf_message<OSMFormat::ChangeSetComment> pbf_comment{comment_data};
+                        while (pbf_comment.next()) {
+                            switch (pbf_comment.tag_and_type()) {
+                                case protozero::tag_and_type(OSMFormat::ChangeSetComment::optional_int64_date, protozero::pbf_wire_type::varint):
+                                    date = osmium::Timestamp{pbf_comment.get_int64() * m_date_factor / 1000};
+                                    break;
+                                case protozero::tag_and_type(OSMFormat::ChangeSetComment::optional_int32_uid, protozero::pbf_wire_type::varint):
+                                    {
+                                        const auto signed_uid = pbf_comment.get_int32();
+                                        uid = signed_uid < 0 ? 0 : static_cast<osmium::user_id_type>(signed_uid);
+                                    }
+                                    break;
+                                case protozero::tag_and_type(OSMFormat::ChangeSetComment::optional_uint32_user_sid, protozero::pbf_wire_type::varint):
+                                    {
+                                        const auto& u = m_stringtable.at(pbf_comment.get_uint32());
+                                        m_comment_user.assign(u.first, u.second);
+                                    }
+                                    break;
+                                case protozero::tag_and_type(OSMFormat::ChangeSetComment::optional_bytes_text, protozero::pbf_wire_type::length_delimited):
+                                    {
+                                        const auto text = pbf_comment.get_view();
+                                        m_comment_text.assign(text.data(), text.size());
+                                    }
+                                    break;
+                                default:
+                                    pbf_comment.skip();
+                            }
+                        }
+
+                        discussion_builder.add_comment(date, uid, m_comment_user.c_str());
+                        discussion_builder.add_comment_text(m_comment_text);
+                    }
+                }
+
+                // Read the string ids of the keys and values of the next
+                // node from the keys_vals of a DenseNodes group.
+                void read_dense_node_tags(varint_range& tags) {
+                    m_tag_ids.clear();
                     while (!tags.empty()) {
                         const auto idx = tags.next_int32();
                         if (idx == 0) {
-                            return;
+                            break;
                         }
-                        const auto& k = m_stringtable.at(idx);
+                        m_tag_ids.push_back(idx);
                         if (tags.empty()) {
                             throw osmium::pbf_error{"PBF format error"}; // this is against the spec, keys/vals must come in pairs
                         }
-                        const auto& v = m_stringtable.at(tags.next_int32());
-                        tl_builder.add_tag(k.first, k.second, v.first, v.second);
+                        m_tag_ids.push_back(tags.next_int32());
+                    }
+                }
+
+                bool prefilter_wants_dense_node() {
+                    for (std::size_t n = 0; n < m_tag_ids.size(); n += 2) {
+                        if (prefilter_matches(static_cast<uint32_t>(m_tag_ids[n]), static_cast<uint32_t>(m_tag_ids[n + 1]))) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                void build_tag_list_from_dense_nodes(osmium::builder::NodeBuilder& builder) {
+                    m_tag_strings.clear();
+                    for (const auto idx : m_tag_ids) {
+                        m_tag_strings.push_back(m_stringtable.at(idx));
                     }
+
+                    osmium::builder::TagListBuilder tl_builder{builder};
+                    tl_builder.add_tags(m_tag_strings.cbegin(), m_tag_strings.cend());
                 }
 
                 void decode_dense_nodes_without_metadata(const data_view& data) {
@@ -535,6 +1021,7 @@ namespace osmium {
                     varint_range lats;
                     varint_range lons;
                     varint_range tags;
+                    varint_range timestamps;
 
                     protozero::pbf_message<OSMFormat::DenseNodes> pbf_dense_nodes{data};
                     while (pbf_dense_nodes.next()) {
@@ -551,37 +1038,66 @@ namespace osmium {
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
                                 tags = varint_range{pbf_dense_nodes.get_view()};
                                 break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::optional_DenseInfo_denseinfo, protozero::pbf_wire_type::length_delimited):
+                                if (m_timestamp_window) {
+                                    // The timestamps are needed for the window.
+                                    protozero::pbf_message<OSMFormat::DenseInfo> pbf_dense_info{pbf_dense_nodes.get_message()};
+                                    if (pbf_dense_info.next(OSMFormat::DenseInfo::packed_sint64_timestamp, protozero::pbf_wire_type::length_delimited)) {
+                                        timestamps = varint_range{pbf_dense_info.get_view()};
+                                    }
+                                } else {
+                                    pbf_dense_nodes.skip();
+                                }
+                                break;
                             default:
                                 pbf_dense_nodes.skip();
                         }
                     }
 
-                    osmium::DeltaDecode<int64_t> dense_id;
-                    osmium::DeltaDecode<int64_t> dense_latitude;
-                    osmium::DeltaDecode<int64_t> dense_longitude;
+                    ids.decode_delta_sint64(m_ids);
+                    lons.decode_delta_sint64(m_lons);
+                    lats.decode_delta_sint64(m_lats);
+                    if (m_lons.size() < m_ids.size() ||
+                        m_lats.size() < m_ids.size()) {
+                        // this is against the spec, must have same number of elements
+                        throw osmium::pbf_error{"PBF format error"};
+                    }
+
+                    const bool use_prefilter = prefilter_applies_to(osmium::osm_entity_bits::node);
+                    const bool use_window = static_cast<bool>(m_timestamp_window);
+                    if (use_window) {
+                        select_dense_nodes_in_window(timestamps);
+                    }
+
+                    for (std::size_t i = 0; i < m_ids.size(); ++i) {
+                        const bool has_tags = !tags.empty();
+                        read_dense_node_tags(tags);
+
+                        if (use_window && !m_window_wanted[i]) {
+                            continue;
+                        }
+
+                        if (m_use_query && !query_wants_dense_node(i)) {
+                            continue;
+                        }
 
-                    while (!ids.empty()) {
-                        if (lons.empty() ||
-                            lats.empty()) {
-                            // this is against the spec, must have same number of elements
-                            throw osmium::pbf_error{"PBF format error"};
+                        if (use_prefilter && !prefilter_wants_dense_node()) {
+                            continue;
                         }
 
                         {
                             osmium::builder::NodeBuilder builder{m_buffer};
                             osmium::Node& node = builder.object();
 
-                            node.set_id(dense_id.update(ids.next_sint64()));
+                            node.set_id(m_ids[i]);
 
-                            const auto lon = dense_longitude.update(lons.next_sint64());
-                            const auto lat = dense_latitude.update(lats.next_sint64());
                             builder.object().set_location(osmium::Location{
-                                    convert_pbf_lon(lon),
-                                    convert_pbf_lat(lat)
+                                    convert_pbf_lon(m_lons[i]),
+                                    convert_pbf_lat(m_lats[i])
                             });
 
-                            if (!tags.empty()) {
-                                build_tag_list_from_dense_nodes(builder, tags);
+                            if (has_tags) {
+                                build_tag_list_from_dense_nodes(builder);
                             }
                         }
                         m_buffer.commit();
@@ -653,19 +1169,56 @@ namespace osmium {
                         }
                     }
 
-                    osmium::DeltaDecode<int64_t> dense_id;
-                    osmium::DeltaDecode<int64_t> dense_latitude;
-                    osmium::DeltaDecode<int64_t> dense_longitude;
+                    ids.decode_delta_sint64(m_ids);
+                    lons.decode_delta_sint64(m_lons);
+                    lats.decode_delta_sint64(m_lats);
+                    if (m_lons.size() < m_ids.size() ||
+                        m_lats.size() < m_ids.size()) {
+                        // this is against the spec, must have same number of elements
+                        throw osmium::pbf_error{"PBF format error"};
+                    }
+
                     osmium::DeltaDecode<int64_t> dense_uid;
                     osmium::DeltaDecode<int64_t> dense_user_sid;
                     osmium::DeltaDecode<int64_t> dense_changeset;
                     osmium::DeltaDecode<int64_t> dense_timestamp;
 
-                    while (!ids.empty()) {
-                        if (lons.empty() ||
-                            lats.empty()) {
-                            // this is against the spec, must have same number of elements
-                            throw osmium::pbf_error{"PBF format error"};
+                    const bool use_prefilter = prefilter_applies_to(osmium::osm_entity_bits::node);
+                    const bool use_window = static_cast<bool>(m_timestamp_window);
+                    if (use_window) {
+                        select_dense_nodes_in_window(timestamps);
+                    }
+
+                    for (std::size_t i = 0; i < m_ids.size(); ++i) {
+                        const bool has_tags = !tags.empty();
+                        read_dense_node_tags(tags);
+
+                        if ((use_window && !m_window_wanted[i]) ||
+                            (m_use_query && !query_wants_dense_node(i)) ||
+                            (use_prefilter && !prefilter_wants_dense_node())) {
+                            // The metadata is delta encoded, so it has to be
+                            // decoded even for nodes that are skipped.
+                            if (has_info) {
+                                if (!versions.empty()) {
+                                    versions.next_int32();
+                                }
+                                if (!changesets.empty()) {
+                                    dense_changeset.update(changesets.next_sint64());
+                                }
+                                if (!timestamps.empty()) {
+                                    dense_timestamp.update(timestamps.next_sint64());
+                                }
+                                if (!uids.empty()) {
+                                    dense_uid.update(uids.next_sint32());
+                                }
+                                if (!visibles.empty()) {
+                                    visibles.next_int32();
+                                }
+                                if (!user_sids.empty()) {
+                                    dense_user_sid.update(user_sids.next_sint32());
+                                }
+                            }
+                            continue;
                         }
 
                         {
@@ -674,7 +1227,7 @@ namespace osmium {
                             osmium::builder::NodeBuilder builder{m_buffer};
                             osmium::Node& node = builder.object();
 
-                            node.set_id(dense_id.update(ids.next_sint64()));
+                            node.set_id(m_ids[i]);
 
                             if (has_info) {
                                 if (!versions.empty()) {
@@ -724,29 +1277,57 @@ namespace osmium {
 
                             // even if the node isn't visible, there's still a record
                             // of its lat/lon in the dense arrays.
-                            const auto lon = dense_longitude.update(lons.next_sint64());
-                            const auto lat = dense_latitude.update(lats.next_sint64());
                             if (visible) {
                                 builder.object().set_location(osmium::Location{
-                                        convert_pbf_lon(lon),
-                                        convert_pbf_lat(lat)
+                                        convert_pbf_lon(m_lons[i]),
+                                        convert_pbf_lat(m_lats[i])
                                 });
                             }
 
-                            if (!tags.empty()) {
-                                build_tag_list_from_dense_nodes(builder, tags);
+                            if (has_tags) {
+                                build_tag_list_from_dense_nodes(builder);
                             }
                         }
                         m_buffer.commit();
                     }
                 }
 
+                static osmium::memory::Buffer get_buffer(BufferRecycler* recycler, bool single_buffer) {
+                    // Recycled buffers might use auto_grow::internal, so
+                    // they can't be used if we need a single buffer.
+                    if (single_buffer) {
+                        return osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                    }
+                    if (recycler) {
+                        osmium::memory::Buffer buffer{recycler->get(initial_buffer_size)};
+                        if (buffer) {
+                            return buffer;
+                        }
+                    }
+                    return osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::internal};
+                }
+
             public:
 
-                PBFPrimitiveBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata) :
+                /**
+                 * Create decoder for a PrimitiveBlock.
+                 *
+                 * @param data The uncompressed block data.
+                 * @param read_types Which entity types to decode.
+                 * @param read_metadata Should metadata be decoded?
+                 * @param recycler Optional source of already allocated
+                 *        buffers.
+                 * @param prefilter Optional filter, only objects with at
+                 *        least one tag matching it are decoded.
+                 * @param single_buffer Decode all objects into a single
+                 *        (growing) buffer instead of nested buffers.
+                 */
+                PBFPrimitiveBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, BufferRecycler* recycler = nullptr, const osmium::io::tags_prefilter& prefilter = osmium::io::tags_prefilter{}, bool single_buffer = false) :
                     m_data(data),
                     m_read_types(read_types),
-                    m_read_metadata(read_metadata) {
+                    m_buffer(get_buffer(recycler, single_buffer)),
+                    m_read_metadata(read_metadata),
+                    m_prefilter(prefilter) {
                 }
 
                 PBFPrimitiveBlockDecoder(const PBFPrimitiveBlockDecoder&) = delete;
@@ -760,17 +1341,103 @@ namespace osmium {
                 osmium::memory::Buffer operator()() {
                     try {
                         decode_primitive_block_metadata();
+                        if (prefilter_applies_to(m_read_types)) {
+                            init_prefilter();
+                        }
                         decode_primitive_block_data();
                     } catch (const std::out_of_range&) {
                         throw osmium::pbf_error{"string id out of range"};
                     }
 
+                    // Objects in a block are grouped by type, so the index
+                    // has only a few ranges and is cheap to build.
+                    m_buffer.build_type_index();
+
                     return std::move(m_buffer);
                 }
 
+                /**
+                 * Only build the versions of objects needed for the time
+                 * window. Must be called before decoding.
+                 */
+                void set_timestamp_window(const osmium::io::timestamp_window& window) noexcept {
+                    m_timestamp_window = window;
+                }
+
+                /**
+                 * Only build the objects with IDs and (for nodes)
+                 * locations wanted by the query. Must be called before
+                 * decoding.
+                 */
+                void set_read_query(const osmium::io::read_query& query) {
+                    m_query = query;
+                    m_use_query = query.filters_objects();
+                }
+
+                /**
+                 * The types of all objects in the block, including those
+                 * which were not decoded. Only valid after the block was
+                 * decoded.
+                 */
+                osmium::osm_entity_bits::type types_found() const noexcept {
+                    return m_types_found;
+                }
+
             }; // class PBFPrimitiveBlockDecoder
 
-            inline data_view decode_blob(const std::string& blob_data, std::string& output) {
+            /**
+             * Memory for uncompressed blob data. It only ever grows and
+             * is never initialized, so it can be reused for any number of
+             * blobs without zero-filling or copying it. The blob is
+             * uncompressed straight into it.
+             */
+            class pbf_blob_buffer {
+
+                std::unique_ptr<char[]> m_data;
+                std::size_t m_capacity = 0;
+
+            public:
+
+                /**
+                 * Get memory for at least size bytes. Previous contents
+                 * are not kept.
+                 */
+                char* prepare(std::size_t size) {
+                    if (size > m_capacity) {
+                        // Grow at least by a factor of two so that a few
+                        // slightly growing blobs don't need a new
+                        // allocation each.
+                        const std::size_t capacity = std::max(size, std::min(m_capacity * 2, static_cast<std::size_t>(max_uncompressed_blob_size)));
+                        m_data.reset(new char[capacity]);
+                        m_capacity = capacity;
+                    }
+                    return m_data.get();
+                }
+
+                std::size_t capacity() const noexcept {
+                    return m_capacity;
+                }
+
+            }; // class pbf_blob_buffer
+
+            inline char* prepare_blob_output(std::string& output, std::size_t size) {
+                output.resize(size);
+                return &*output.begin();
+            }
+
+            inline char* prepare_blob_output(pbf_blob_buffer& output, std::size_t size) {
+                return output.prepare(size);
+            }
+
+            /**
+             * Decode a Blob message. If the data in it is compressed, it
+             * is uncompressed into the output which can be a std::string
+             * or a pbf_blob_buffer. Uncompressed data is not copied.
+             *
+             * @returns View on the uncompressed data.
+             */
+            template <typename TOutput>
+            data_view decode_blob(const data_view& blob_data, TOutput& output) {
                 int32_t raw_size = 0;
                 protozero::data_view compressed_data;
                 pbf_compression use_compression = pbf_compression::none;
@@ -807,7 +1474,13 @@ namespace osmium {
                             throw osmium::pbf_error{"lz4 blobs not supported"};
 #endif
                         case protozero::tag_and_type(FileFormat::Blob::optional_bytes_zstd_data, protozero::pbf_wire_type::length_delimited):
+#ifdef OSMIUM_WITH_ZSTD
+                            use_compression = pbf_compression::zstd;
+                            compressed_data = pbf_blob.get_view();
+                            break;
+#else
                             throw osmium::pbf_error{"zstd blobs not supported"};
+#endif
                         default:
                             throw osmium::pbf_error{"unknown compression"};
                     }
@@ -818,20 +1491,43 @@ namespace osmium {
                         case pbf_compression::none:
                             break;
                         case pbf_compression::zlib:
-                            return osmium::io::detail::zlib_uncompress_string(
-                                compressed_data.data(),
-                                static_cast<unsigned long>(compressed_data.size()), // NOLINT(google-runtime-int)
-                                static_cast<unsigned long>(raw_size), // NOLINT(google-runtime-int)
-                                output
-                            );
+                            {
+                                char* target = prepare_blob_output(output, static_cast<std::size_t>(raw_size));
+                                osmium::io::detail::zlib_uncompress(
+                                    compressed_data.data(),
+                                    static_cast<unsigned long>(compressed_data.size()), // NOLINT(google-runtime-int)
+                                    target,
+                                    static_cast<unsigned long>(raw_size) // NOLINT(google-runtime-int)
+                                );
+                                return data_view{target, static_cast<std::size_t>(raw_size)};
+                            }
                         case pbf_compression::lz4:
 #ifdef OSMIUM_WITH_LZ4
-                            return osmium::io::detail::lz4_uncompress_string(
-                                compressed_data.data(),
-                                static_cast<unsigned long>(compressed_data.size()), // NOLINT(google-runtime-int)
-                                static_cast<unsigned long>(raw_size), // NOLINT(google-runtime-int)
-                                output
-                            );
+                            {
+                                char* target = prepare_blob_output(output, static_cast<std::size_t>(raw_size));
+                                osmium::io::detail::lz4_uncompress(
+                                    compressed_data.data(),
+                                    static_cast<unsigned long>(compressed_data.size()), // NOLINT(google-runtime-int)
+                                    target,
+                                    static_cast<unsigned long>(raw_size) // NOLINT(google-runtime-int)
+                                );
+                                return data_view{target, static_cast<std::size_t>(raw_size)};
+                            }
+#else
+                            break;
+#endif
+                        case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                            {
+                                char* target = prepare_blob_output(output, static_cast<std::size_t>(raw_size));
+                                osmium::io::detail::zstd_uncompress(
+                                    compressed_data.data(),
+                                    static_cast<unsigned long>(compressed_data.size()), // NOLINT(google-runtime-int)
+                                    target,
+                                    static_cast<unsigned long>(raw_size) // NOLINT(google-runtime-int)
+                                );
+                                return data_view{target, static_cast<std::size_t>(raw_size)};
+                            }
 #else
                             break;
 #endif
@@ -947,30 +1643,211 @@ namespace osmium {
              * @returns Header object
              * @throws osmium::pbf_error If there was a parsing error
              */
-            inline osmium::io::Header decode_header(const std::string& header_block_data) {
+            inline osmium::io::Header decode_header(const data_view& header_block_data) {
                 std::string output;
 
                 return decode_header_block(decode_blob(header_block_data, output));
             }
 
+            /**
+             * Which entity types are in a PrimitiveBlock? Only the first
+             * field of each group is looked at, nothing is decoded.
+             */
+            inline osmium::osm_entity_bits::type primitive_block_types(const data_view& data) {
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+                protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{data};
+                while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited)) {
+                    protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group = pbf_primitive_block.get_message();
+                    if (pbf_primitive_group.next()) {
+                        switch (pbf_primitive_group.tag()) {
+                            case OSMFormat::PrimitiveGroup::repeated_Node_nodes:
+                            case OSMFormat::PrimitiveGroup::optional_DenseNodes_dense:
+                                types |= osmium::osm_entity_bits::node;
+                                break;
+                            case OSMFormat::PrimitiveGroup::repeated_Way_ways:
+                                types |= osmium::osm_entity_bits::way;
+                                break;
+                            case OSMFormat::PrimitiveGroup::repeated_Relation_relations:
+                                types |= osmium::osm_entity_bits::relation;
+                                break;
+                            case OSMFormat::PrimitiveGroup::repeated_ChangeSet_changesets:
+                                types |= osmium::osm_entity_bits::changeset;
+                                break;
+                            default:
+                                break;
+                        }
+                    }
+                }
+
+                return types;
+            }
+
+            /**
+             * In a file sorted by type and ID (nodes, then ways, then
+             * relations) the part of the file interesting to a reader
+             * ends with the first blob containing objects of a type after
+             * all the types it wants to read. This is shared between the
+             * PBF parser and the decoders running in the thread pool: A
+             * decoder finding such objects records the number of its
+             * blob, the parser then stops reading and decoders for later
+             * blobs which didn't start yet don't decode them any more.
+             * Decoders for earlier blobs can still run after that, so
+             * they must not be skipped.
+             */
+            class pbf_sorted_end {
+
+                osmium::osm_entity_bits::type m_later_types;
+                std::atomic<std::size_t> m_end_blob{std::numeric_limits<std::size_t>::max()};
+
+            public:
+
+                /**
+                 * The types which come after all the read_types in a
+                 * sorted file. This is nothing if relations or changesets
+                 * (which aren't part of the sort order) are read.
+                 */
+                static osmium::osm_entity_bits::type later_types(osmium::osm_entity_bits::type read_types) noexcept {
+                    if (read_types & (osmium::osm_entity_bits::relation | osmium::osm_entity_bits::changeset)) {
+                        return osmium::osm_entity_bits::nothing;
+                    }
+                    if (read_types & osmium::osm_entity_bits::way) {
+                        return osmium::osm_entity_bits::relation;
+                    }
+                    if (read_types & osmium::osm_entity_bits::node) {
+                        return osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation;
+                    }
+                    return osmium::osm_entity_bits::nothing;
+                }
+
+                explicit pbf_sorted_end(osmium::osm_entity_bits::type read_types) noexcept :
+                    m_later_types(later_types(read_types)) {
+                }
+
+                /// Can the end be reached before the end of the file?
+                bool possible() const noexcept {
+                    return m_later_types != osmium::osm_entity_bits::nothing;
+                }
+
+                /// Record that the blob with this number contains these types.
+                void found(std::size_t blob_number, osmium::osm_entity_bits::type types) noexcept {
+                    if (!(types & m_later_types)) {
+                        return;
+                    }
+                    std::size_t end = m_end_blob.load();
+                    while (blob_number < end && !m_end_blob.compare_exchange_weak(end, blob_number)) {
+                    }
+                }
+
+                /// Has a blob with objects of the later types been found?
+                bool reached() const noexcept {
+                    return m_end_blob.load() != std::numeric_limits<std::size_t>::max();
+                }
+
+                /// Is the blob with this number after the end?
+                bool after_end(std::size_t blob_number) const noexcept {
+                    return blob_number > m_end_blob.load();
+                }
+
+            }; // class pbf_sorted_end
+
             class PBFDataBlobDecoder {
 
                 std::shared_ptr<std::string> m_input_buffer;
+
+                // If the blob data is in a memory mapped file this keeps
+                // the mapping alive until all decoders are done with it.
+                std::shared_ptr<const osmium::util::MemoryMapping> m_mapping;
+
+                std::shared_ptr<BufferRecycler> m_recycler;
+
+                data_view m_input_data;
                 osmium::osm_entity_bits::type m_read_types;
                 osmium::io::read_meta m_read_metadata;
+                osmium::io::tags_prefilter m_prefilter;
+                std::shared_ptr<pbf_sorted_end> m_sorted_end;
+                std::size_t m_blob_number = 0;
+                bool m_keep_raw_blob = false;
+                osmium::io::timestamp_window m_timestamp_window;
+                osmium::io::read_query m_query;
 
             public:
 
-                PBFDataBlobDecoder(std::string&& input_buffer, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata) :
+                PBFDataBlobDecoder(std::string&& input_buffer, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, std::shared_ptr<BufferRecycler> recycler = nullptr, const osmium::io::tags_prefilter& prefilter = osmium::io::tags_prefilter{}) :
                     m_input_buffer(std::make_shared<std::string>(std::move(input_buffer))),
+                    m_recycler(std::move(recycler)),
+                    m_input_data(*m_input_buffer),
                     m_read_types(read_types),
-                    m_read_metadata(read_metadata) {
+                    m_read_metadata(read_metadata),
+                    m_prefilter(prefilter) {
+                }
+
+                /**
+                 * Create a decoder for blob data inside a memory mapping.
+                 * No copy of the data is made, the decoder shares ownership
+                 * of the mapping instead.
+                 */
+                PBFDataBlobDecoder(std::shared_ptr<const osmium::util::MemoryMapping> mapping, const data_view& input_data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, std::shared_ptr<BufferRecycler> recycler = nullptr, const osmium::io::tags_prefilter& prefilter = osmium::io::tags_prefilter{}) :
+                    m_mapping(std::move(mapping)),
+                    m_recycler(std::move(recycler)),
+                    m_input_data(input_data),
+                    m_read_types(read_types),
+                    m_read_metadata(read_metadata),
+                    m_prefilter(prefilter) {
+                }
+
+                /**
+                 * Attach a copy of the (still encoded) blob to the decoded
+                 * buffer. All objects from the blob are then decoded into
+                 * a single buffer, so the blob belongs to exactly that
+                 * buffer.
+                 */
+                void set_keep_raw_blob(bool keep) noexcept {
+                    m_keep_raw_blob = keep;
+                }
+
+                /**
+                 * Report the types found in this blob (with the specified
+                 * number in the file) to the sorted_end object. The blob
+                 * isn't decoded at all if it is after the end.
+                 */
+                void set_sorted_end(std::shared_ptr<pbf_sorted_end> sorted_end, std::size_t blob_number) noexcept {
+                    m_sorted_end = std::move(sorted_end);
+                    m_blob_number = blob_number;
+                }
+
+                /// Only build the versions of objects needed for the time window.
+                void set_timestamp_window(const osmium::io::timestamp_window& window) noexcept {
+                    m_timestamp_window = window;
+                }
+
+                /// Only build the objects wanted by the query.
+                void set_read_query(const osmium::io::read_query& query) {
+                    m_query = query;
                 }
 
                 osmium::memory::Buffer operator()() {
-                    std::string output;
-                    PBFPrimitiveBlockDecoder decoder{decode_blob(*m_input_buffer, output), m_read_types, m_read_metadata};
-                    return decoder();
+                    if (m_sorted_end && m_sorted_end->after_end(m_blob_number)) {
+                        return osmium::memory::Buffer{0};
+                    }
+
+                    // The uncompressed data is only needed while decoding,
+                    // so the memory for it is kept around and reused for
+                    // the next blob decoded in the same thread.
+                    static thread_local pbf_blob_buffer output;
+                    OSMIUM_TRACEPOINT1(pbf_blob_decode_start, m_input_data.size());
+                    PBFPrimitiveBlockDecoder decoder{decode_blob(m_input_data, output), m_read_types, m_read_metadata, m_recycler.get(), m_prefilter, m_keep_raw_blob};
+                    decoder.set_timestamp_window(m_timestamp_window);
+                    decoder.set_read_query(m_query);
+                    osmium::memory::Buffer buffer{decoder()};
+                    if (m_sorted_end) {
+                        m_sorted_end->found(m_blob_number, decoder.types_found());
+                    }
+                    if (m_keep_raw_blob) {
+                        buffer.set_raw_data(std::string{m_input_data.data(), m_input_data.size()});
+                    }
+                    OSMIUM_TRACEPOINT2(pbf_blob_decode_end, m_input_data.size(), buffer.committed());
+                    return buffer;
                 }
 
             }; // class PBFDataBlobDecoder
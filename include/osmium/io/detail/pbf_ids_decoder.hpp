@@ -0,0 +1,314 @@
+#ifndef OSMIUM_IO_DETAIL_PBF_IDS_DECODER_HPP
+#define OSMIUM_IO_DETAIL_PBF_IDS_DECODER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/io/tags_prefilter.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <protozero/pbf_message.hpp>
+#include <protozero/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Decodes only the types and IDs of the objects in a PBF
+             * PrimitiveBlock. No OSM objects are built. If a tags
+             * prefilter is given, the tags of the objects of the types
+             * it applies to are checked against it, the string table is
+             * only decoded in that case. Everything else is skipped.
+             */
+            class PBFIdsBlockDecoder {
+
+                data_view m_data;
+                std::vector<data_view> m_stringtable;
+
+                osmium::osm_entity_bits::type m_read_types;
+
+                osmium::io::tags_prefilter m_prefilter;
+
+                // For each string in the string table: Can it be the key
+                // of a tag matching the prefilter?
+                enum class key_state : uint8_t {
+                    unknown = 0,
+                    no      = 1,
+                    yes     = 2
+                };
+                std::vector<key_state> m_key_states;
+
+                // The prefilter needs null-terminated strings, but strings
+                // in the string table aren't.
+                std::string m_prefilter_key;
+                std::string m_prefilter_value;
+
+                std::vector<int64_t> m_ids;
+
+                void decode_stringtable() {
+                    protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{m_data};
+                    while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::required_StringTable_stringtable, protozero::pbf_wire_type::length_delimited)) {
+                        if (!m_stringtable.empty()) {
+                            throw osmium::pbf_error{"more than one stringtable in pbf file"};
+                        }
+                        protozero::pbf_message<OSMFormat::StringTable> pbf_string_table{pbf_primitive_block.get_view()};
+                        while (pbf_string_table.next(OSMFormat::StringTable::repeated_bytes_s, protozero::pbf_wire_type::length_delimited)) {
+                            m_stringtable.push_back(pbf_string_table.get_view());
+                        }
+                    }
+                    m_key_states.assign(m_stringtable.size(), key_state::unknown);
+                }
+
+                bool prefilter_applies_to(const osmium::osm_entity_bits::type type) const noexcept {
+                    return (m_prefilter.entities() & type) != 0;
+                }
+
+                const data_view& string(uint32_t n) const {
+                    if (n >= m_stringtable.size()) {
+                        throw osmium::pbf_error{"string id out of range"};
+                    }
+                    return m_stringtable[n];
+                }
+
+                bool prefilter_matches(const uint32_t key_id, const uint32_t value_id) {
+                    const auto& key = string(key_id);
+                    auto& state = m_key_states[key_id];
+                    if (state == key_state::unknown) {
+                        state = m_prefilter.key_can_match(key.data(), key.size()) ? key_state::yes : key_state::no;
+                    }
+                    if (state == key_state::no) {
+                        return false;
+                    }
+                    const auto& value = string(value_id);
+                    m_prefilter_key.assign(key.data(), key.size());
+                    m_prefilter_value.assign(value.data(), value.size());
+                    return m_prefilter(m_prefilter_key.c_str(), m_prefilter_value.c_str());
+                }
+
+                bool prefilter_matches(varint_range& keys, varint_range& vals) {
+                    while (!keys.empty() && !vals.empty()) {
+                        const auto key_id = keys.next_uint32();
+                        if (prefilter_matches(key_id, vals.next_uint32())) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                template <typename TFunction>
+                void decode_node(const data_view& data, bool use_prefilter, TFunction&& func) {
+                    osmium::object_id_type id = 0;
+                    varint_range keys;
+                    varint_range vals;
+
+                    protozero::pbf_message<OSMFormat::Node> pbf_node{data};
+                    while (pbf_node.next()) {
+                        switch (pbf_node.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_id, protozero::pbf_wire_type::varint):
+                                id = pbf_node.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                                keys = varint_range{pbf_node.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::packed_uint32_vals, protozero::pbf_wire_type::length_delimited):
+                                vals = varint_range{pbf_node.get_view()};
+                                break;
+                            default:
+                                pbf_node.skip();
+                        }
+                    }
+
+                    func(osmium::item_type::node, id, !use_prefilter || prefilter_matches(keys, vals));
+                }
+
+                // Decode Way or Relation message.
+                template <typename TPBFMessage, typename TFunction>
+                void decode_object(const data_view& data, osmium::item_type type, bool use_prefilter, TFunction&& func) {
+                    osmium::object_id_type id = 0;
+                    varint_range keys;
+                    varint_range vals;
+
+                    protozero::pbf_message<TPBFMessage> pbf_object{data};
+                    while (pbf_object.next()) {
+                        switch (pbf_object.tag_and_type()) {
+                            case protozero::tag_and_type(TPBFMessage::required_int64_id, protozero::pbf_wire_type::varint):
+                                id = pbf_object.get_int64();
+                                break;
+                            case protozero::tag_and_type(TPBFMessage::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                                keys = varint_range{pbf_object.get_view()};
+                                break;
+                            case protozero::tag_and_type(TPBFMessage::packed_uint32_vals, protozero::pbf_wire_type::length_delimited):
+                                vals = varint_range{pbf_object.get_view()};
+                                break;
+                            default:
+                                pbf_object.skip();
+                        }
+                    }
+
+                    func(type, id, !use_prefilter || prefilter_matches(keys, vals));
+                }
+
+                template <typename TFunction>
+                void decode_dense_nodes(const data_view& data, bool use_prefilter, TFunction&& func) {
+                    varint_range ids;
+                    varint_range tags;
+
+                    protozero::pbf_message<OSMFormat::DenseNodes> pbf_dense_nodes{data};
+                    while (pbf_dense_nodes.next()) {
+                        switch (pbf_dense_nodes.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
+                                ids = varint_range{pbf_dense_nodes.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
+                                tags = varint_range{pbf_dense_nodes.get_view()};
+                                break;
+                            default:
+                                pbf_dense_nodes.skip();
+                        }
+                    }
+
+                    ids.decode_delta_sint64(m_ids);
+                    for (const auto id : m_ids) {
+                        bool matched = !use_prefilter;
+                        while (!tags.empty()) {
+                            const auto key_id = tags.next_int32();
+                            if (key_id == 0) {
+                                break;
+                            }
+                            if (tags.empty()) {
+                                throw osmium::pbf_error{"PBF format error"}; // this is against the spec, keys/vals must come in pairs
+                            }
+                            const auto value_id = tags.next_int32();
+                            if (!matched) {
+                                matched = prefilter_matches(static_cast<uint32_t>(key_id), static_cast<uint32_t>(value_id));
+                            }
+                        }
+                        func(osmium::item_type::node, id, matched);
+                    }
+                }
+
+            public:
+
+                /**
+                 * Create decoder for a PrimitiveBlock.
+                 *
+                 * @param data The uncompressed block data.
+                 * @param read_types Which entity types to decode.
+                 * @param prefilter Optional tags filter.
+                 */
+                PBFIdsBlockDecoder(const data_view& data,
+                                   const osmium::osm_entity_bits::type read_types,
+                                   const osmium::io::tags_prefilter& prefilter = osmium::io::tags_prefilter{}) :
+                    m_data(data),
+                    m_read_types(read_types),
+                    m_prefilter(prefilter) {
+                }
+
+                /**
+                 * Decode the block and call func(type, id, matched) for
+                 * each object of the requested types in the order they
+                 * are in the block. The matched flag is true if the
+                 * object has a tag matching the prefilter or if its type
+                 * isn't filtered.
+                 */
+                template <typename TFunction>
+                void operator()(TFunction&& func) {
+                    if (prefilter_applies_to(m_read_types)) {
+                        decode_stringtable();
+                    }
+
+                    const bool filter_nodes = prefilter_applies_to(osmium::osm_entity_bits::node);
+                    const bool filter_ways = prefilter_applies_to(osmium::osm_entity_bits::way);
+                    const bool filter_relations = prefilter_applies_to(osmium::osm_entity_bits::relation);
+
+                    protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{m_data};
+                    while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited)) {
+                        protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group = pbf_primitive_block.get_message();
+                        while (pbf_primitive_group.next()) {
+                            switch (pbf_primitive_group.tag_and_type()) {
+                                case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
+                                    if (m_read_types & osmium::osm_entity_bits::node) {
+                                        decode_node(pbf_primitive_group.get_view(), filter_nodes, func);
+                                    } else {
+                                        pbf_primitive_group.skip();
+                                    }
+                                    break;
+                                case protozero::tag_and_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, protozero::pbf_wire_type::length_delimited):
+                                    if (m_read_types & osmium::osm_entity_bits::node) {
+                                        decode_dense_nodes(pbf_primitive_group.get_view(), filter_nodes, func);
+                                    } else {
+                                        pbf_primitive_group.skip();
+                                    }
+                                    break;
+                                case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Way_ways, protozero::pbf_wire_type::length_delimited):
+                                    if (m_read_types & osmium::osm_entity_bits::way) {
+                                        decode_object<OSMFormat::Way>(pbf_primitive_group.get_view(), osmium::item_type::way, filter_ways, func);
+                                    } else {
+                                        pbf_primitive_group.skip();
+                                    }
+                                    break;
+                                case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations, protozero::pbf_wire_type::length_delimited):
+                                    if (m_read_types & osmium::osm_entity_bits::relation) {
+                                        decode_object<OSMFormat::Relation>(pbf_primitive_group.get_view(), osmium::item_type::relation, filter_relations, func);
+                                    } else {
+                                        pbf_primitive_group.skip();
+                                    }
+                                    break;
+                                default:
+                                    pbf_primitive_group.skip();
+                            }
+                        }
+                    }
+                }
+
+            }; // class PBFIdsBlockDecoder
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PBF_IDS_DECODER_HPP
@@ -33,29 +33,45 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/io/decoded_buffer_callback.hpp>
 #include <osmium/io/detail/input_format.hpp>
 #include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
+#include <osmium/io/detail/pbf_blob_index.hpp>
+#include <osmium/io/detail/pbf_blob_table.hpp>
 #include <osmium/io/detail/pbf_decoder.hpp>
 #include <osmium/io/detail/protobuf_tags.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/read_query.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+#include <osmium/util/tracepoint.hpp>
 
 #include <protozero/pbf_message.hpp>
 #include <protozero/types.hpp>
 
+#include <array>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <fstream>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <system_error>
 #include <type_traits>
 #include <utility>
+#include <vector>
+
+#ifndef _WIN32
+# include <sys/stat.h>
+#endif
 
 namespace osmium {
 
@@ -63,6 +79,93 @@ namespace osmium {
 
         namespace detail {
 
+#ifndef _WIN32
+            /**
+             * Reads a data blob from a file using pread(2) and decodes it.
+             * This is run in the thread pool, so several blobs can be read
+             * and decoded at the same time.
+             */
+            class PBFBlobFetchingDecoder {
+
+                std::shared_ptr<const PBFBlobFile> m_file;
+                std::shared_ptr<BufferRecycler> m_recycler;
+                pbf_blob_info m_blob;
+                osmium::osm_entity_bits::type m_read_types;
+                osmium::io::read_meta m_read_metadata;
+                osmium::io::tags_prefilter m_prefilter;
+                std::shared_ptr<pbf_sorted_end> m_sorted_end;
+                std::size_t m_blob_number = 0;
+                bool m_keep_raw_blob;
+                osmium::io::timestamp_window m_timestamp_window;
+                osmium::io::read_query m_query;
+
+            public:
+
+                PBFBlobFetchingDecoder(std::shared_ptr<const PBFBlobFile> file, const pbf_blob_info& blob, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, std::shared_ptr<BufferRecycler> recycler, const osmium::io::tags_prefilter& prefilter, bool keep_raw_blob) :
+                    m_file(std::move(file)),
+                    m_recycler(std::move(recycler)),
+                    m_blob(blob),
+                    m_read_types(read_types),
+                    m_read_metadata(read_metadata),
+                    m_prefilter(prefilter),
+                    m_keep_raw_blob(keep_raw_blob) {
+                }
+
+                void set_sorted_end(std::shared_ptr<pbf_sorted_end> sorted_end, std::size_t blob_number) noexcept {
+                    m_sorted_end = std::move(sorted_end);
+                    m_blob_number = blob_number;
+                }
+
+                void set_timestamp_window(const osmium::io::timestamp_window& window) noexcept {
+                    m_timestamp_window = window;
+                }
+
+                void set_read_query(const osmium::io::read_query& query) {
+                    m_query = query;
+                }
+
+                osmium::memory::Buffer operator()() {
+                    // Don't even read the blob if it is not needed.
+                    if (m_sorted_end && m_sorted_end->after_end(m_blob_number)) {
+                        return osmium::memory::Buffer{0};
+                    }
+                    PBFDataBlobDecoder decoder{m_file->read_blob(m_blob), m_read_types, m_read_metadata, m_recycler, m_prefilter};
+                    decoder.set_keep_raw_blob(m_keep_raw_blob);
+                    decoder.set_sorted_end(m_sorted_end, m_blob_number);
+                    decoder.set_timestamp_window(m_timestamp_window);
+                    decoder.set_read_query(m_query);
+                    return decoder();
+                }
+
+            }; // class PBFBlobFetchingDecoder
+#endif
+
+            /**
+             * Wraps a blob decoder and calls the user-supplied buffer
+             * callback on the decoded buffer. Because this is run in the
+             * thread pool, the callback is executed in the worker threads.
+             */
+            template <typename TDecoder>
+            class PBFDecoderWithCallback {
+
+                TDecoder m_decoder;
+                osmium::io::decoded_buffer_callback m_callback;
+
+            public:
+
+                PBFDecoderWithCallback(TDecoder&& decoder, const osmium::io::decoded_buffer_callback& callback) :
+                    m_decoder(std::move(decoder)),
+                    m_callback(callback) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    osmium::memory::Buffer buffer{m_decoder()};
+                    m_callback(buffer);
+                    return buffer;
+                }
+
+            }; // class PBFDecoderWithCallback
+
             class PBFParser final : public Parser {
 
                 std::string m_input_buffer{};
@@ -70,6 +173,57 @@ namespace osmium {
                 int m_fd;
                 bool m_want_buffered_pages_removed;
 
+                // Used when the input file is memory mapped. The mapping is
+                // shared with the blob decoders which may still be running
+                // in the pool after this parser is done.
+                std::shared_ptr<const osmium::util::MemoryMapping> m_mapping{};
+                std::size_t m_mapping_offset = 0;
+
+                // Only set if the file is sorted and reading can stop
+                // before its end.
+                std::shared_ptr<pbf_sorted_end> m_sorted_end{};
+
+                /**
+                 * Try to memory map the input file. This only works if we
+                 * are reading directly from a regular file. If the mapping
+                 * can not be created, we silently fall back to reading.
+                 */
+                void try_map_input_file() {
+                    if (m_fd == -1 || !osmium::config::use_mmap_for_pbf_reading()) {
+                        return;
+                    }
+
+                    try {
+                        const auto size = osmium::file_size(m_fd);
+                        const auto offset = osmium::file_offset(m_fd);
+                        if (size == 0 || offset > size) {
+                            return;
+                        }
+                        m_mapping = std::make_shared<const osmium::util::MemoryMapping>(size, osmium::util::MemoryMapping::mapping_mode::readonly, m_fd);
+                        m_mapping_offset = offset;
+                    } catch (const std::system_error&) {
+                        m_mapping.reset();
+                    }
+                }
+
+                std::size_t available_in_mapping() const noexcept {
+                    return m_mapping->size() - m_mapping_offset;
+                }
+
+                /**
+                 * Get a view of the next size bytes from the mapped file
+                 * and advance the read position.
+                 *
+                 * @pre size <= available_in_mapping()
+                 */
+                protozero::data_view get_from_mapping(std::size_t size) noexcept {
+                    assert(size <= available_in_mapping());
+                    const protozero::data_view view{m_mapping->get_addr<char>() + m_mapping_offset, size};
+                    m_mapping_offset += size;
+                    *m_offset_ptr += size;
+                    return view;
+                }
+
                 /**
                  * Make sure the input data contains at least the specified
                  * number of bytes.
@@ -142,6 +296,13 @@ namespace osmium {
                  * the length of the following BlobHeader.
                  */
                 uint32_t read_blob_header_size_from_file() {
+                    if (m_mapping) {
+                        if (available_in_mapping() < sizeof(uint32_t)) {
+                            return 0; // EOF
+                        }
+                        return check_size(get_size_in_network_byte_order(get_from_mapping(sizeof(uint32_t)).data()));
+                    }
+
                     if (m_fd != -1) {
                         std::array<char, sizeof(uint32_t)> buffer{};
                         if (!read_exactly(buffer.data(), buffer.size())) {
@@ -208,6 +369,10 @@ namespace osmium {
                         return 0;
                     }
 
+                    if (m_mapping) {
+                        return decode_blob_header(get_from_mapping_with_check(size), expected_type);
+                    }
+
                     if (m_fd != -1) {
                         auto const buffer = read_from_input_queue_with_check(size);
                         const auto blob_size = decode_blob_header(protozero::data_view{buffer.data(), size}, expected_type);
@@ -220,6 +385,19 @@ namespace osmium {
                     return blob_size;
                 }
 
+                protozero::data_view get_from_mapping_with_check(size_t size) {
+                    if (size > max_uncompressed_blob_size) {
+                        throw osmium::pbf_error{std::string{"invalid blob size: "} +
+                                                std::to_string(size)};
+                    }
+
+                    if (size > available_in_mapping()) {
+                        throw osmium::pbf_error{"unexpected EOF"};
+                    }
+
+                    return get_from_mapping(size);
+                }
+
                 std::string read_from_input_queue_with_check(size_t size) {
                     if (size > max_uncompressed_blob_size) {
                         throw osmium::pbf_error{std::string{"invalid blob size: "} +
@@ -242,32 +420,265 @@ namespace osmium {
                     return buffer;
                 }
 
+                void set_pbf_header(const osmium::io::Header& header) {
+                    set_header_value(header);
+                    if (header.sorted_by_type_then_id()) {
+                        auto sorted_end = std::make_shared<pbf_sorted_end>(read_types());
+                        if (sorted_end->possible()) {
+                            m_sorted_end = std::move(sorted_end);
+                        }
+                    }
+                }
+
                 // Parse the header in the PBF OSMHeader blob.
                 void parse_header_blob() {
                     const auto size = check_type_and_get_blob_size("OSMHeader");
+                    if (m_mapping) {
+                        set_pbf_header(decode_header(get_from_mapping_with_check(size)));
+                        return;
+                    }
                     const osmium::io::Header header{decode_header(read_from_input_queue_with_check(size))};
-                    set_header_value(header);
+                    set_pbf_header(header);
+                }
+
+                bool sorted_end_reached() const noexcept {
+                    return m_sorted_end && m_sorted_end->reached();
+                }
+
+                /**
+                 * Attaching the raw blobs to the buffers only makes sense
+                 * if nothing was left out when decoding them.
+                 */
+                bool keep_raw_blobs() const noexcept {
+                    return raw_blobs() == osmium::io::keep_raw_blobs::yes &&
+                           (read_types() & osmium::osm_entity_bits::nwr) == osmium::osm_entity_bits::nwr &&
+                           read_metadata() == osmium::io::read_meta::yes &&
+                           !prefilter() &&
+                           !timestamp_window() &&
+                           !read_query().filters_objects();
+                }
+
+                /**
+                 * Decode a data blob, either in the thread pool or directly.
+                 * The buffer callback is called by the decoding task in the
+                 * first case and by send_to_output_queue() in the second.
+                 */
+                template <typename TDecoder>
+                void decode_data_blob(TDecoder&& decoder, const bool use_pool) {
+                    if (!use_pool) {
+                        send_to_output_queue(decoder());
+                    } else if (buffer_callback()) {
+                        send_to_output_queue(submit_to_pool(PBFDecoderWithCallback<typename std::decay<TDecoder>::type>{std::forward<TDecoder>(decoder), buffer_callback()}, osmium::thread::task_priority::high));
+                    } else {
+                        send_to_output_queue(submit_to_pool(std::forward<TDecoder>(decoder), osmium::thread::task_priority::high));
+                    }
                 }
 
                 void parse_data_blobs() {
-                    const bool use_pool = osmium::config::use_pool_threads_for_pbf_parsing();
-                    while (const auto size = check_type_and_get_blob_size("OSMData")) {
-                        std::string input_buffer{read_from_input_queue_with_check(size)};
+                    const bool use_pool = use_pool_for_pbf_parsing();
+                    const bool keep_raw = keep_raw_blobs();
 
-                        PBFDataBlobDecoder data_blob_parser{std::move(input_buffer), read_types(), read_metadata()};
+                    // If we read the data ourselves, we have to pause
+                    // reading when the memory budget is used up. Otherwise
+                    // the read thread does it.
+                    const bool reading_directly = m_mapping || m_fd != -1;
 
-                        if (use_pool) {
-                            send_to_output_queue(get_pool().submit(std::move(data_blob_parser)));
-                        } else {
-                            send_to_output_queue(data_blob_parser());
+                    for (std::size_t blob_number = 1; !sorted_end_reached(); ++blob_number) {
+                        if (reading_directly) {
+                            wait_for_memory_budget();
+                        }
+                        const auto size = check_type_and_get_blob_size("OSMData");
+                        if (size == 0) {
+                            break;
+                        }
+                        if (m_mapping) {
+                            PBFDataBlobDecoder decoder{m_mapping, get_from_mapping_with_check(size), read_types(), read_metadata(), buffer_recycler(), prefilter()};
+                            decoder.set_keep_raw_blob(keep_raw);
+                            decoder.set_sorted_end(m_sorted_end, blob_number);
+                            decoder.set_timestamp_window(timestamp_window());
+                            decoder.set_read_query(read_query());
+                            decode_data_blob(std::move(decoder), use_pool);
+                            continue;
                         }
 
+                        OSMIUM_TRACEPOINT1(pbf_blob_read_start, size);
+                        std::string input_buffer{read_from_input_queue_with_check(size)};
+                        OSMIUM_TRACEPOINT1(pbf_blob_read_end, size);
+                        PBFDataBlobDecoder decoder{std::move(input_buffer), read_types(), read_metadata(), buffer_recycler(), prefilter()};
+                        decoder.set_keep_raw_blob(keep_raw);
+                        decoder.set_sorted_end(m_sorted_end, blob_number);
+                        decoder.set_timestamp_window(timestamp_window());
+                        decoder.set_read_query(read_query());
+                        decode_data_blob(std::move(decoder), use_pool);
+
                         if (m_want_buffered_pages_removed) {
                             osmium::io::detail::remove_buffered_pages(m_fd, *m_offset_ptr);
                         }
                     }
                 }
 
+#ifndef _WIN32
+                bool input_is_regular_file() const noexcept {
+                    struct stat s; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+                    return ::fstat(m_fd, &s) == 0 && S_ISREG(s.st_mode);
+                }
+
+                /**
+                 * Types of the objects in a data blob. The blob is read
+                 * and uncompressed, but not decoded.
+                 */
+                osmium::osm_entity_bits::type data_blob_types(const PBFBlobFile& file, const pbf_blob_info& blob) const {
+                    std::string output;
+                    if (m_mapping) {
+                        return primitive_block_types(decode_blob(protozero::data_view{m_mapping->get_addr<char>() + blob.offset, blob.size}, output));
+                    }
+                    const std::string data{file.read_blob(blob)};
+                    return primitive_block_types(decode_blob(protozero::data_view{data.data(), data.size()}, output));
+                }
+
+                /**
+                 * In a file sorted by type and ID, find the first data
+                 * blob with objects of the first type which should be
+                 * read (or a later type), so that all blobs before it can
+                 * be skipped without reading them. This is a binary
+                 * search, so only a few blobs have to be looked at. If a
+                 * blob without any nodes, ways, or relations is found,
+                 * the order can't be determined, and nothing is skipped.
+                 */
+                std::size_t first_needed_blob(const PBFBlobTable& table, const PBFBlobFile& file) const {
+                    osmium::osm_entity_bits::type needed = osmium::osm_entity_bits::nothing;
+                    if (read_types() & (osmium::osm_entity_bits::node | osmium::osm_entity_bits::changeset)) {
+                        return 1;
+                    }
+                    if (read_types() & osmium::osm_entity_bits::way) {
+                        needed = osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation;
+                    } else if (read_types() & osmium::osm_entity_bits::relation) {
+                        needed = osmium::osm_entity_bits::relation;
+                    } else {
+                        return 1;
+                    }
+
+                    std::size_t first = 1;
+                    std::size_t last = table.size();
+                    while (first < last) {
+                        const std::size_t middle = first + (last - first) / 2;
+                        const auto types = data_blob_types(file, table[middle]);
+                        if ((types & osmium::osm_entity_bits::nwr) == osmium::osm_entity_bits::nothing) {
+                            return 1;
+                        }
+                        if (types & needed) {
+                            last = middle;
+                        } else {
+                            first = middle + 1;
+                        }
+                    }
+
+                    return first;
+                }
+
+                /**
+                 * Read the summaries of the data blobs from the blob index
+                 * file set in the read query. Returns an empty vector if
+                 * there is no index or it doesn't belong to this file.
+                 */
+                std::vector<pbf_blob_summary> read_blob_summaries(const PBFBlobTable& table, std::size_t file_size) const {
+                    std::vector<pbf_blob_summary> summaries;
+                    if (read_query().blob_index().empty()) {
+                        return summaries;
+                    }
+
+                    std::ifstream in{read_query().blob_index()};
+                    std::vector<pbf_blob_index_entry> entries;
+                    if (!in || !read_pbf_blob_index(in, file_size, entries) ||
+                        entries.size() + 1 != table.size()) {
+                        return summaries;
+                    }
+
+                    summaries.reserve(entries.size());
+                    for (std::size_t n = 0; n < entries.size(); ++n) {
+                        if (entries[n].offset != table[n + 1].offset || entries[n].size != table[n + 1].size) {
+                            summaries.clear();
+                            break;
+                        }
+                        summaries.push_back(entries[n].summary);
+                    }
+                    return summaries;
+                }
+
+                /**
+                 * Parse the input file using a blob table: First all
+                 * BlobHeaders are read to find out where the blobs are,
+                 * then the data blobs are handed to the thread pool which
+                 * reads (or, if the file is memory mapped, accesses) and
+                 * decodes them concurrently. The order of the resulting
+                 * buffers is kept by the output queue.
+                 */
+                void parse_with_blob_table() {
+                    const std::size_t file_size = osmium::file_size(m_fd);
+                    const PBFBlobTable table = m_mapping
+                        ? PBFBlobTable::from_memory(m_mapping->get_addr<char>(), m_mapping->size(), m_mapping_offset)
+                        : PBFBlobTable::from_file(m_fd, osmium::file_offset(m_fd));
+
+                    if (table.empty()) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+
+                    for (std::size_t n = 0; n < table.size(); ++n) {
+                        if (table[n].type != (n == 0 ? pbf_blob_type::header : pbf_blob_type::data)) {
+                            throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                        }
+                    }
+
+                    // The decoders might still be running after this
+                    // parser is done and the Reader has closed m_fd, so
+                    // they get their own duplicate of the descriptor.
+                    const auto file = std::make_shared<const PBFBlobFile>(m_fd);
+
+                    const auto& header_blob = table[0];
+                    osmium::io::Header header;
+                    if (m_mapping) {
+                        header = decode_header(protozero::data_view{m_mapping->get_addr<char>() + header_blob.offset, header_blob.size});
+                    } else {
+                        header = decode_header(file->read_blob(header_blob));
+                    }
+                    set_pbf_header(header);
+                    *m_offset_ptr = header_blob.offset + header_blob.size;
+
+                    if (read_types() == osmium::osm_entity_bits::nothing) {
+                        return;
+                    }
+
+                    const std::size_t first = header.sorted_by_type_then_id() ? first_needed_blob(table, *file) : 1;
+                    const auto summaries = read_blob_summaries(table, file_size);
+
+                    const bool use_pool = use_pool_for_pbf_parsing();
+                    const bool keep_raw = keep_raw_blobs();
+                    for (std::size_t n = first; n < table.size() && !sorted_end_reached(); ++n) {
+                        const auto& blob = table[n];
+                        if (!summaries.empty() && !read_query().wants_blob(summaries[n - 1])) {
+                            *m_offset_ptr = blob.offset + blob.size;
+                            continue;
+                        }
+                        wait_for_memory_budget();
+                        if (m_mapping) {
+                            PBFDataBlobDecoder decoder{m_mapping, protozero::data_view{m_mapping->get_addr<char>() + blob.offset, blob.size}, read_types(), read_metadata(), buffer_recycler(), prefilter()};
+                            decoder.set_keep_raw_blob(keep_raw);
+                            decoder.set_sorted_end(m_sorted_end, n);
+                            decoder.set_timestamp_window(timestamp_window());
+                            decoder.set_read_query(read_query());
+                            decode_data_blob(std::move(decoder), use_pool);
+                        } else {
+                            PBFBlobFetchingDecoder decoder{file, blob, read_types(), read_metadata(), buffer_recycler(), prefilter(), keep_raw};
+                            decoder.set_sorted_end(m_sorted_end, n);
+                            decoder.set_timestamp_window(timestamp_window());
+                            decoder.set_read_query(read_query());
+                            decode_data_blob(std::move(decoder), use_pool);
+                        }
+                        *m_offset_ptr = blob.offset + blob.size;
+                    }
+                }
+#endif
+
             public:
 
                 explicit PBFParser(parser_arguments& args) :
@@ -288,6 +699,17 @@ namespace osmium {
                 void run() override {
                     osmium::thread::set_thread_name("_osmium_pbf_in");
 
+                    try_map_input_file();
+
+#ifndef _WIN32
+                    // A blob index can only be used with a blob table.
+                    const bool use_blob_table = osmium::config::use_blob_table_for_pbf_reading() || !read_query().blob_index().empty();
+                    if (m_fd != -1 && use_blob_table && input_is_regular_file()) {
+                        parse_with_blob_table();
+                        return;
+                    }
+#endif
+
                     parse_header_blob();
 
                     if (read_types() != osmium::osm_entity_bits::nothing) {
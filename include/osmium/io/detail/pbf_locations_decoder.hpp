@@ -0,0 +1,237 @@
+#ifndef OSMIUM_IO_DETAIL_PBF_LOCATIONS_DECODER_HPP
+#define OSMIUM_IO_DETAIL_PBF_LOCATIONS_DECODER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <protozero/pbf_message.hpp>
+#include <protozero/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Decodes only the IDs and locations of the nodes in a PBF
+             * PrimitiveBlock. No OSM objects are built. Of the tags only
+             * their presence is checked, Info and DenseInfo are skipped
+             * completely, as are ways and relations.
+             *
+             * Because the metadata isn't decoded, deleted nodes in
+             * history files can not be told apart from visible ones.
+             */
+            class PBFLocationsBlockDecoder {
+
+                data_view m_data;
+
+                int64_t m_lon_offset = 0;
+                int64_t m_lat_offset = 0;
+                int32_t m_granularity = 100;
+
+                std::vector<int64_t> m_ids;
+                std::vector<int64_t> m_lats;
+                std::vector<int64_t> m_lons;
+
+                void decode_primitive_block_metadata() {
+                    protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{m_data};
+                    while (pbf_primitive_block.next()) {
+                        switch (pbf_primitive_block.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::PrimitiveBlock::optional_int32_granularity, protozero::pbf_wire_type::varint):
+                                m_granularity = pbf_primitive_block.get_int32();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveBlock::optional_int64_lat_offset, protozero::pbf_wire_type::varint):
+                                m_lat_offset = pbf_primitive_block.get_int64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveBlock::optional_int64_lon_offset, protozero::pbf_wire_type::varint):
+                                m_lon_offset = pbf_primitive_block.get_int64();
+                                break;
+                            default:
+                                pbf_primitive_block.skip();
+                        }
+                    }
+                }
+
+                osmium::Location location(const int64_t lon, const int64_t lat) const noexcept {
+                    return osmium::Location{
+                        int32_t((lon * m_granularity + m_lon_offset) / resolution_convert),
+                        int32_t((lat * m_granularity + m_lat_offset) / resolution_convert)
+                    };
+                }
+
+                template <typename TFunction>
+                void decode_node(const data_view& data, TFunction&& func) {
+                    osmium::object_id_type id = 0;
+                    bool has_tags = false;
+                    int64_t lon = std::numeric_limits<int64_t>::max();
+                    int64_t lat = std::numeric_limits<int64_t>::max();
+
+                    protozero::pbf_message<OSMFormat::Node> pbf_node{data};
+                    while (pbf_node.next()) {
+                        switch (pbf_node.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_id, protozero::pbf_wire_type::varint):
+                                id = pbf_node.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                                has_tags = !pbf_node.get_view().empty();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_lat, protozero::pbf_wire_type::varint):
+                                lat = pbf_node.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_lon, protozero::pbf_wire_type::varint):
+                                lon = pbf_node.get_sint64();
+                                break;
+                            default:
+                                pbf_node.skip();
+                        }
+                    }
+
+                    if (lon == std::numeric_limits<int64_t>::max() || lat == std::numeric_limits<int64_t>::max()) {
+                        func(id, osmium::Location{}, has_tags);
+                    } else {
+                        func(id, location(lon, lat), has_tags);
+                    }
+                }
+
+                template <typename TFunction>
+                void decode_dense_nodes(const data_view& data, TFunction&& func) {
+                    varint_range ids;
+                    varint_range lats;
+                    varint_range lons;
+                    varint_range tags;
+
+                    protozero::pbf_message<OSMFormat::DenseNodes> pbf_dense_nodes{data};
+                    while (pbf_dense_nodes.next()) {
+                        switch (pbf_dense_nodes.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
+                                ids = varint_range{pbf_dense_nodes.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
+                                lats = varint_range{pbf_dense_nodes.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
+                                lons = varint_range{pbf_dense_nodes.get_view()};
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
+                                tags = varint_range{pbf_dense_nodes.get_view()};
+                                break;
+                            default:
+                                pbf_dense_nodes.skip();
+                        }
+                    }
+
+                    ids.decode_delta_sint64(m_ids);
+                    lons.decode_delta_sint64(m_lons);
+                    lats.decode_delta_sint64(m_lats);
+                    if (m_lons.size() < m_ids.size() ||
+                        m_lats.size() < m_ids.size()) {
+                        // this is against the spec, must have same number of elements
+                        throw osmium::pbf_error{"PBF format error"};
+                    }
+
+                    for (std::size_t i = 0; i < m_ids.size(); ++i) {
+                        // Tags of all nodes are in keys_vals, each list
+                        // terminated by a 0. If the block has no tags at
+                        // all, keys_vals is empty.
+                        bool has_tags = false;
+                        while (!tags.empty()) {
+                            if (tags.next_int32() == 0) {
+                                break;
+                            }
+                            if (tags.empty()) {
+                                throw osmium::pbf_error{"PBF format error"}; // this is against the spec, keys/vals must come in pairs
+                            }
+                            tags.next_int32();
+                            has_tags = true;
+                        }
+                        func(m_ids[i], location(m_lons[i], m_lats[i]), has_tags);
+                    }
+                }
+
+            public:
+
+                /**
+                 * Create decoder for a PrimitiveBlock.
+                 *
+                 * @param data The uncompressed block data.
+                 */
+                explicit PBFLocationsBlockDecoder(const data_view& data) :
+                    m_data(data) {
+                }
+
+                /**
+                 * Decode the block and call func(id, location, has_tags)
+                 * for each node in the order they are in the block.
+                 */
+                template <typename TFunction>
+                void operator()(TFunction&& func) {
+                    decode_primitive_block_metadata();
+
+                    protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{m_data};
+                    while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited)) {
+                        protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group = pbf_primitive_block.get_message();
+                        while (pbf_primitive_group.next()) {
+                            switch (pbf_primitive_group.tag_and_type()) {
+                                case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
+                                    decode_node(pbf_primitive_group.get_view(), func);
+                                    break;
+                                case protozero::tag_and_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, protozero::pbf_wire_type::length_delimited):
+                                    decode_dense_nodes(pbf_primitive_group.get_view(), func);
+                                    break;
+                                default:
+                                    pbf_primitive_group.skip();
+                            }
+                        }
+                    }
+                }
+
+            }; // class PBFLocationsBlockDecoder
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PBF_LOCATIONS_DECODER_HPP
@@ -33,34 +33,49 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <osmium/geom/hilbert.hpp>
 #include <osmium/handler.hpp>
 #include <osmium/io/detail/output_format.hpp>
 #include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
+#include <osmium/io/detail/pbf_blob_index.hpp>
+#include <osmium/io/detail/pbf_blob_table.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/pbf_varint.hpp>
 #include <osmium/io/detail/protobuf_tags.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/detail/string_table.hpp>
 #include <osmium/io/detail/zlib.hpp>
+#include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/item_iterator.hpp>
 #include <osmium/osm/box.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/metadata_options.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/object.hpp>
+#include <osmium/osm/object_comparisons.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/tag.hpp>
 #include <osmium/osm/timestamp.hpp>
@@ -75,9 +90,14 @@ DEALINGS IN THE SOFTWARE.
 # include <osmium/io/detail/lz4.hpp>
 #endif
 
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
+
 #include <protozero/pbf_builder.hpp>
 #include <protozero/pbf_writer.hpp>
 #include <protozero/types.hpp>
+#include <protozero/varint.hpp>
 
 namespace osmium {
 
@@ -129,100 +149,130 @@ namespace osmium {
                 max_entities_per_block = 8000
             };
 
-            enum class pbf_blob_type {
-                header = 0,
-                data = 1
-            };
-
             /**
              * Contains the code to pack any number of nodes into a DenseNode
              * structure.
+             *
+             * The values are kept in columns in a single allocation sized
+             * for max_entities_per_block nodes. They are stored as they
+             * are, delta encoding is done when serializing in the same
+             * pass as the zigzag and varint encoding of each column.
              */
             class DenseNodes {
 
-                std::vector<int64_t> m_ids;
+                enum column : std::size_t {
+                    col_id = 0,
+                    col_version,
+                    col_timestamp,
+                    col_changeset,
+                    col_uid,
+                    col_user_sid,
+                    col_visible,
+                    col_lat,
+                    col_lon,
+                    num_columns
+                };
 
-                std::vector<int32_t> m_versions;
-                std::vector<int64_t> m_timestamps;
-                std::vector<int64_t> m_changesets;
-                std::vector<int32_t> m_uids;
-                std::vector<int32_t> m_user_sids;
-                std::vector<bool> m_visibles;
+                std::unique_ptr<int64_t[]> m_columns;
+                std::size_t m_count = 0;
 
-                std::vector<int64_t> m_lats;
-                std::vector<int64_t> m_lons;
                 std::vector<int32_t> m_tags;
 
+                // Used for encoding a column before it is added to the
+                // message, large enough for any column.
+                std::unique_ptr<char[]> m_encoded;
+
                 StringTable* m_stringtable;
                 const pbf_output_options* m_options;
 
-                osmium::DeltaEncode<object_id_type, int64_t> m_delta_id;
+                int64_t* column_data(column col) noexcept {
+                    return m_columns.get() + static_cast<std::size_t>(col) * static_cast<std::size_t>(max_entities_per_block);
+                }
 
-                osmium::DeltaEncode<uint32_t, int64_t> m_delta_timestamp;
-                osmium::DeltaEncode<changeset_id_type, int64_t> m_delta_changeset;
-                osmium::DeltaEncode<user_id_type, int32_t> m_delta_uid;
-                osmium::DeltaEncode<int32_t, int32_t> m_delta_user_sid;
+                const int64_t* column_data(column col) const noexcept {
+                    return m_columns.get() + static_cast<std::size_t>(col) * static_cast<std::size_t>(max_entities_per_block);
+                }
 
-                osmium::DeltaEncode<int64_t, int64_t> m_delta_lat;
-                osmium::DeltaEncode<int64_t, int64_t> m_delta_lon;
+                void set(column col, int64_t value) noexcept {
+                    column_data(col)[m_count] = value;
+                }
+
+                /**
+                 * Add a column to the message as packed varints in one
+                 * pass. The encode function gets the previous and the
+                 * current value and returns the varint to write.
+                 */
+                template <typename T, typename TEncode>
+                void add_column(protozero::pbf_builder<T>& pbf, T tag, column col, TEncode&& encode) const {
+                    if (m_count == 0) {
+                        return;
+                    }
+                    const int64_t* values = column_data(col);
+                    char* out = m_encoded.get();
+                    int64_t previous = 0;
+                    for (std::size_t i = 0; i < m_count; ++i) {
+                        out += protozero::write_varint(out, encode(previous, values[i]));
+                        previous = values[i];
+                    }
+                    pbf.add_bytes(tag, m_encoded.get(), static_cast<std::size_t>(out - m_encoded.get()));
+                }
+
+                static uint64_t delta_sint64(int64_t previous, int64_t value) noexcept {
+                    return protozero::encode_zigzag64(value - previous);
+                }
+
+                static uint64_t delta_sint32(int64_t previous, int64_t value) noexcept {
+                    return protozero::encode_zigzag32(static_cast<int32_t>(value - previous));
+                }
+
+                static uint64_t plain_int32(int64_t /*previous*/, int64_t value) noexcept {
+                    return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(value)));
+                }
 
             public:
 
                 DenseNodes(StringTable* stringtable, const pbf_output_options* options) :
+                    m_columns(new int64_t[static_cast<std::size_t>(num_columns) * static_cast<std::size_t>(max_entities_per_block)]),
+                    m_encoded(new char[max_entities_per_block * protozero::max_varint_length]),
                     m_stringtable(stringtable),
                     m_options(options) {
-                    m_ids.reserve(max_entities_per_block);
-                    if (m_options->add_metadata.version()) {
-                        m_versions.reserve(max_entities_per_block);
-                    }
-                    if (m_options->add_metadata.timestamp()) {
-                        m_timestamps.reserve(max_entities_per_block);
-                    }
-                    if (m_options->add_metadata.changeset()) {
-                        m_changesets.reserve(max_entities_per_block);
-                    }
-                    if (m_options->add_metadata.uid()) {
-                        m_uids.reserve(max_entities_per_block);
-                    }
-                    if (m_options->add_metadata.user()) {
-                        m_user_sids.reserve(max_entities_per_block);
-                    }
-                    if (m_options->add_visible_flag) {
-                        m_visibles.reserve(max_entities_per_block);
-                    }
-                    m_lats.reserve(max_entities_per_block);
-                    m_lons.reserve(max_entities_per_block);
                 }
 
                 std::size_t size() const noexcept {
-                    return m_ids.size() * 3 * sizeof(int64_t);
+                    return m_count * 3 * sizeof(int64_t);
                 }
 
                 void add_node(const osmium::Node& node) {
-                    m_ids.push_back(m_delta_id.update(node.id()));
+                    assert(m_count < max_entities_per_block);
+
+                    set(col_id, node.id());
 
                     if (m_options->add_metadata.version()) {
                         assert(node.version() <= static_cast<std::size_t>(std::numeric_limits<int32_t>::max()));
-                        m_versions.push_back(static_cast<int32_t>(node.version()));
+                        set(col_version, static_cast<int32_t>(node.version()));
                     }
                     if (m_options->add_metadata.timestamp()) {
-                        m_timestamps.push_back(m_delta_timestamp.update(uint32_t(node.timestamp())));
+                        set(col_timestamp, uint32_t(node.timestamp()));
                     }
                     if (m_options->add_metadata.changeset()) {
-                        m_changesets.push_back(m_delta_changeset.update(node.changeset()));
+                        set(col_changeset, node.changeset());
                     }
                     if (m_options->add_metadata.uid()) {
-                        m_uids.push_back(m_delta_uid.update(node.uid()));
+                        set(col_uid, static_cast<int32_t>(node.uid()));
                     }
                     if (m_options->add_metadata.user()) {
-                        m_user_sids.push_back(m_delta_user_sid.update(m_stringtable->add(node.user())));
+                        // The string ids might still change in
+                        // remap_strings().
+                        set(col_user_sid, m_stringtable->add(node.user()));
                     }
                     if (m_options->add_visible_flag) {
-                        m_visibles.push_back(node.visible());
+                        set(col_visible, node.visible() ? 1 : 0);
                     }
 
-                    m_lats.push_back(m_delta_lat.update(node.location().y()));
-                    m_lons.push_back(m_delta_lon.update(node.location().x()));
+                    set(col_lat, node.location().y());
+                    set(col_lon, node.location().x());
+
+                    ++m_count;
 
                     for (const auto& tag : node.tags()) {
                         m_tags.push_back(m_stringtable->add(tag.key()));
@@ -231,36 +281,52 @@ namespace osmium {
                     m_tags.push_back(0);
                 }
 
+                /**
+                 * Change all string ids according to the mapping from old
+                 * to new ids.
+                 */
+                void remap_strings(const std::vector<int32_t>& new_ids) {
+                    if (m_options->add_metadata.user()) {
+                        int64_t* sids = column_data(col_user_sid);
+                        for (std::size_t i = 0; i < m_count; ++i) {
+                            sids[i] = new_ids[sids[i]];
+                        }
+                    }
+                    for (auto& tag : m_tags) {
+                        tag = new_ids[tag];
+                    }
+                }
+
                 std::string serialize() const {
                     std::string data;
                     protozero::pbf_builder<OSMFormat::DenseNodes> pbf_dense_nodes{data};
 
-                    pbf_dense_nodes.add_packed_sint64(OSMFormat::DenseNodes::packed_sint64_id, m_ids.cbegin(), m_ids.cend());
+                    add_column(pbf_dense_nodes, OSMFormat::DenseNodes::packed_sint64_id, col_id, delta_sint64);
 
                     if (m_options->add_metadata.any() || m_options->add_visible_flag) {
                         protozero::pbf_builder<OSMFormat::DenseInfo> pbf_dense_info{pbf_dense_nodes, OSMFormat::DenseNodes::optional_DenseInfo_denseinfo};
                         if (m_options->add_metadata.version()) {
-                            pbf_dense_info.add_packed_int32(OSMFormat::DenseInfo::packed_int32_version, m_versions.cbegin(), m_versions.cend());
+                            add_column(pbf_dense_info, OSMFormat::DenseInfo::packed_int32_version, col_version, plain_int32);
                         }
                         if (m_options->add_metadata.timestamp()) {
-                            pbf_dense_info.add_packed_sint64(OSMFormat::DenseInfo::packed_sint64_timestamp, m_timestamps.cbegin(), m_timestamps.cend());
+                            add_column(pbf_dense_info, OSMFormat::DenseInfo::packed_sint64_timestamp, col_timestamp, delta_sint64);
                         }
                         if (m_options->add_metadata.changeset()) {
-                            pbf_dense_info.add_packed_sint64(OSMFormat::DenseInfo::packed_sint64_changeset, m_changesets.cbegin(), m_changesets.cend());
+                            add_column(pbf_dense_info, OSMFormat::DenseInfo::packed_sint64_changeset, col_changeset, delta_sint64);
                         }
                         if (m_options->add_metadata.uid()) {
-                            pbf_dense_info.add_packed_sint32(OSMFormat::DenseInfo::packed_sint32_uid, m_uids.cbegin(), m_uids.cend());
+                            add_column(pbf_dense_info, OSMFormat::DenseInfo::packed_sint32_uid, col_uid, delta_sint32);
                         }
                         if (m_options->add_metadata.user()) {
-                            pbf_dense_info.add_packed_sint32(OSMFormat::DenseInfo::packed_sint32_user_sid, m_user_sids.cbegin(), m_user_sids.cend());
+                            add_column(pbf_dense_info, OSMFormat::DenseInfo::packed_sint32_user_sid, col_user_sid, delta_sint32);
                         }
                         if (m_options->add_visible_flag) {
-                            pbf_dense_info.add_packed_bool(OSMFormat::DenseInfo::packed_bool_visible, m_visibles.cbegin(), m_visibles.cend());
+                            add_column(pbf_dense_info, OSMFormat::DenseInfo::packed_bool_visible, col_visible, plain_int32);
                         }
                     }
 
-                    pbf_dense_nodes.add_packed_sint64(OSMFormat::DenseNodes::packed_sint64_lat, m_lats.cbegin(), m_lats.cend());
-                    pbf_dense_nodes.add_packed_sint64(OSMFormat::DenseNodes::packed_sint64_lon, m_lons.cbegin(), m_lons.cend());
+                    add_column(pbf_dense_nodes, OSMFormat::DenseNodes::packed_sint64_lat, col_lat, delta_sint64);
+                    add_column(pbf_dense_nodes, OSMFormat::DenseNodes::packed_sint64_lon, col_lon, delta_sint64);
 
                     pbf_dense_nodes.add_packed_int32(OSMFormat::DenseNodes::packed_int32_keys_vals, m_tags.cbegin(), m_tags.cend());
 
@@ -278,6 +344,7 @@ namespace osmium {
                 std::unique_ptr<DenseNodes> m_dense_nodes{};
                 OSMFormat::PrimitiveGroup m_type;
                 int m_count = 0;
+                pbf_blob_summary m_summary{};
 
             public:
 
@@ -299,6 +366,18 @@ namespace osmium {
                     return m_pbf_primitive_group_data;
                 }
 
+                /**
+                 * Reorder the string table so that the most common strings
+                 * get the smallest ids. This is only possible for blocks
+                 * with dense nodes, because everything else was already
+                 * encoded when it was added.
+                 */
+                void reorder_stringtable() {
+                    if (m_dense_nodes) {
+                        m_dense_nodes->remap_strings(m_stringtable.reorder_by_frequency());
+                    }
+                }
+
                 void write_stringtable(protozero::pbf_builder<OSMFormat::StringTable>& pbf_string_table) {
                     for (const char* s : m_stringtable) {
                         pbf_string_table.add_bytes(OSMFormat::StringTable::repeated_bytes_s, s);
@@ -336,6 +415,19 @@ namespace osmium {
                     return m_count;
                 }
 
+                /// Types and ID ranges of the objects in this block.
+                const pbf_blob_summary& summary() const noexcept {
+                    return m_summary;
+                }
+
+                void add_to_summary(const osmium::OSMObject& object) noexcept {
+                    if (object.type() == osmium::item_type::way && !m_options.locations_on_ways) {
+                        m_summary.add(object.type(), object.id());
+                        return;
+                    }
+                    m_summary.add(object);
+                }
+
                 std::size_t size() const noexcept {
                     return m_pbf_primitive_group_data.size() +
                            m_stringtable.size() +
@@ -364,6 +456,42 @@ namespace osmium {
 
             }; // class PrimitiveBlock
 
+            /**
+             * Put a BlobHeader in front of the (already serialized) Blob
+             * and prepend the 4-byte BlobHeader size. The result is ready
+             * to be written to a file.
+             */
+            inline std::string frame_blob(pbf_blob_type type, const std::string& blob_data) {
+                std::string blob_header_data;
+                protozero::pbf_builder<FileFormat::BlobHeader> pbf_blob_header{blob_header_data};
+
+                pbf_blob_header.add_string(FileFormat::BlobHeader::required_string_type, type == pbf_blob_type::data ? "OSMData" : "OSMHeader");
+
+                // The static_cast is okay, because the size can never
+                // be much larger than max_uncompressed_blob_size. This
+                // is due to the assert in SerializeBlob and the fact that
+                // the zlib library will not grow deflated data beyond the
+                // original data plus a few header bytes
+                // (https://zlib.net/zlib_tech.html). Raw blobs copied from
+                // another file have been checked by the reader.
+                pbf_blob_header.add_int32(FileFormat::BlobHeader::required_int32_datasize, static_cast<int32_t>(blob_data.size()));
+
+                const auto size = static_cast<uint32_t>(blob_header_data.size());
+
+                // write to output: the 4-byte BlobHeader size in network
+                // byte order followed by the BlobHeader followed by the Blob
+                std::string output;
+                output.reserve(4 + blob_header_data.size() + blob_data.size());
+                output += static_cast<char>((size >> 24U) & 0xffU);
+                output += static_cast<char>((size >> 16U) & 0xffU);
+                output += static_cast<char>((size >>  8U) & 0xffU);
+                output += static_cast<char>( size         & 0xffU);
+                output.append(blob_header_data);
+                output.append(blob_data);
+
+                return output;
+            }
+
             class SerializeBlob {
 
                 std::shared_ptr<PrimitiveBlock> m_block{};
@@ -415,6 +543,8 @@ namespace osmium {
                  */
                 std::string operator()() {
                     if (m_block) {
+                        m_block->reorder_stringtable();
+
                         protozero::pbf_builder<OSMFormat::PrimitiveBlock> primitive_block{m_msg};
 
                         {
@@ -445,47 +575,45 @@ namespace osmium {
                             break;
 #else
                             throw osmium::pbf_error{"lz4 blobs not supported"};
+#endif
+                        case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                            pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, int32_t(m_msg.size()));
+                            pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zstd_data, osmium::io::detail::zstd_compress(m_msg, m_compression_level));
+                            break;
+#else
+                            throw osmium::pbf_error{"zstd blobs not supported"};
 #endif
                     }
 
-                    std::string blob_header_data;
-                    protozero::pbf_builder<FileFormat::BlobHeader> pbf_blob_header{blob_header_data};
+                    return frame_blob(m_blob_type, blob_data);
+                }
 
-                    pbf_blob_header.add_string(FileFormat::BlobHeader::required_string_type, m_blob_type == pbf_blob_type::data ? "OSMData" : "OSMHeader");
+            }; // class SerializeBlob
 
-                    // The static_cast is okay, because the size can never
-                    // be much larger than max_uncompressed_blob_size. This
-                    // is due to the assert above and the fact that the zlib
-                    // library will not grow deflated data beyond the original
-                    // data plus a few header bytes (https://zlib.net/zlib_tech.html).
-                    pbf_blob_header.add_int32(FileFormat::BlobHeader::required_int32_datasize, static_cast<int32_t>(blob_data.size()));
+            /**
+             * Encodes OSM objects into PrimitiveBlocks. Whenever a block is
+             * full (or on flush()), it is handed to the store function.
+             */
+            class PBFBlockEncoder : public osmium::handler::Handler {
 
-                    const auto size = static_cast<uint32_t>(blob_header_data.size());
+            public:
 
-                    // write to output: the 4-byte BlobHeader size in network
-                    // byte order followed by the BlobHeader followed by the Blob
-                    std::string output;
-                    output.reserve(4 + blob_header_data.size() + blob_data.size());
-                    output += static_cast<char>((size >> 24U) & 0xffU);
-                    output += static_cast<char>((size >> 16U) & 0xffU);
-                    output += static_cast<char>((size >>  8U) & 0xffU);
-                    output += static_cast<char>( size         & 0xffU);
-                    output.append(blob_header_data);
-                    output.append(blob_data);
+                using store_function_type = std::function<void(std::shared_ptr<PrimitiveBlock>&&)>;
 
-                    return output;
-                }
+            private:
 
-            }; // class SerializeBlob
-
-            class PBFOutputFormat : public osmium::io::detail::OutputFormat, public osmium::handler::Handler {
+                const pbf_output_options* m_options;
 
-                pbf_output_options m_options;
+                store_function_type m_store;
 
                 std::shared_ptr<PrimitiveBlock> m_primitive_block{};
 
                 std::size_t m_bucket_count = StringTable::min_bucket_count;
 
+                // Reused for encoding the packed fields of way node lists.
+                std::string m_packed_field;
+
                 void store_primitive_block() {
                     if (!m_primitive_block || m_primitive_block->count() == 0) {
                         return;
@@ -495,56 +623,56 @@ namespace osmium {
                     // table. It will be used when initializing the string
                     // table for the next block.
                     //
-                    // Some versions of the std library will set the bucket
-                    // count always larger then what we set it to. We decrease
-                    // the bucket count by one, this way the bucket will not
-                    // grow too much.
+                    // The string table rounds the bucket count up to the
+                    // next power of two. We decrease the bucket count by one,
+                    // this way the bucket will not grow too much.
                     m_bucket_count = m_primitive_block->get_bucket_count() - 1;
 
-                    m_output_queue.push(m_pool.submit(
-                        SerializeBlob{std::move(m_primitive_block),
-                                      pbf_blob_type::data,
-                                      m_options.use_compression,
-                                      m_options.compression_level}));
+                    m_store(std::move(m_primitive_block));
                 }
 
                 template <typename T>
-                void add_meta(const osmium::OSMObject& object, T& pbf_object) {
+                void add_tags(const osmium::TagList& tags, T& pbf_object) {
                     {
                         protozero::packed_field_uint32 field{pbf_object, protozero::pbf_tag_type(T::enum_type::packed_uint32_keys)};
-                        for (const auto& tag : object.tags()) {
+                        for (const auto& tag : tags) {
                             field.add_element(m_primitive_block->store_in_stringtable_unsigned(tag.key()));
                         }
                     }
 
                     {
                         protozero::packed_field_uint32 field{pbf_object, protozero::pbf_tag_type(T::enum_type::packed_uint32_vals)};
-                        for (const auto& tag : object.tags()) {
+                        for (const auto& tag : tags) {
                             field.add_element(m_primitive_block->store_in_stringtable_unsigned(tag.value()));
                         }
                     }
+                }
 
-                    if (m_options.add_metadata.any() || m_options.add_visible_flag) {
+                template <typename T>
+                void add_meta(const osmium::OSMObject& object, T& pbf_object) {
+                    add_tags(object.tags(), pbf_object);
+
+                    if (m_options->add_metadata.any() || m_options->add_visible_flag) {
                         protozero::pbf_builder<OSMFormat::Info> pbf_info{pbf_object, T::enum_type::optional_Info_info};
 
-                        if (m_options.add_metadata.version()) {
+                        if (m_options->add_metadata.version()) {
                             assert(object.version() <= static_cast<std::size_t>(std::numeric_limits<int32_t>::max()));
                             pbf_info.add_int32(OSMFormat::Info::optional_int32_version, static_cast<int32_t>(object.version()));
                         }
-                        if (m_options.add_metadata.timestamp()) {
+                        if (m_options->add_metadata.timestamp()) {
                             pbf_info.add_int64(OSMFormat::Info::optional_int64_timestamp, uint32_t(object.timestamp()));
                         }
-                        if (m_options.add_metadata.changeset()) {
+                        if (m_options->add_metadata.changeset()) {
                             pbf_info.add_int64(OSMFormat::Info::optional_int64_changeset, object.changeset());
                         }
-                        if (m_options.add_metadata.uid()) {
+                        if (m_options->add_metadata.uid()) {
                             assert(object.uid() <= static_cast<std::size_t>(std::numeric_limits<int32_t>::max()));
                             pbf_info.add_int32(OSMFormat::Info::optional_int32_uid, static_cast<int32_t>(object.uid()));
                         }
-                        if (m_options.add_metadata.user()) {
+                        if (m_options->add_metadata.user()) {
                             pbf_info.add_uint32(OSMFormat::Info::optional_uint32_user_sid, m_primitive_block->store_in_stringtable_unsigned(object.user()));
                         }
-                        if (m_options.add_visible_flag) {
+                        if (m_options->add_visible_flag) {
                             pbf_info.add_bool(OSMFormat::Info::optional_bool_visible, object.visible());
                         }
                     }
@@ -553,14 +681,510 @@ namespace osmium {
                 void switch_primitive_block_type(OSMFormat::PrimitiveGroup type) {
                     if (!m_primitive_block || !m_primitive_block->can_add(type)) {
                         store_primitive_block();
-                        m_primitive_block.reset(new PrimitiveBlock{m_options, type, m_bucket_count});
+                        m_primitive_block.reset(new PrimitiveBlock{*m_options, type, m_bucket_count});
+                    }
+                }
+
+            public:
+
+                PBFBlockEncoder(const pbf_output_options* options, store_function_type store) :
+                    m_options(options),
+                    m_store(std::move(store)) {
+                }
+
+                void flush() {
+                    store_primitive_block();
+                }
+
+                void node(const osmium::Node& node) {
+                    if (m_options->use_dense_nodes) {
+                        switch_primitive_block_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense);
+                        m_primitive_block->add_to_summary(node);
+                        m_primitive_block->add_dense_node(node);
+                        return;
+                    }
+
+                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes);
+                    m_primitive_block->add_to_summary(node);
+                    protozero::pbf_builder<OSMFormat::Node> pbf_node{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Node_nodes};
+
+                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_id, node.id());
+                    add_meta(node, pbf_node);
+
+                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_lat, node.location().y());
+                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_lon, node.location().x());
+                }
+
+                void way(const osmium::Way& way) {
+                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Way_ways);
+                    m_primitive_block->add_to_summary(way);
+                    protozero::pbf_builder<OSMFormat::Way> pbf_way{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Way_ways};
+
+                    pbf_way.add_int64(OSMFormat::Way::required_int64_id, way.id());
+                    add_meta(way, pbf_way);
+
+                    const auto& nodes = way.nodes();
+                    if (nodes.empty()) {
+                        return;
+                    }
+
+                    m_packed_field.clear();
+                    append_delta_encoded_sint64(nodes.cbegin(), nodes.cend(), [](const osmium::NodeRef& node_ref) {
+                        return static_cast<int64_t>(node_ref.ref());
+                    }, m_packed_field);
+                    pbf_way.add_bytes(OSMFormat::Way::packed_sint64_refs, m_packed_field);
+
+                    if (m_options->locations_on_ways) {
+                        m_packed_field.clear();
+                        append_delta_encoded_sint64(nodes.cbegin(), nodes.cend(), [](const osmium::NodeRef& node_ref) {
+                            return static_cast<int64_t>(node_ref.location().x());
+                        }, m_packed_field);
+                        pbf_way.add_bytes(OSMFormat::Way::packed_sint64_lon, m_packed_field);
+
+                        m_packed_field.clear();
+                        append_delta_encoded_sint64(nodes.cbegin(), nodes.cend(), [](const osmium::NodeRef& node_ref) {
+                            return static_cast<int64_t>(node_ref.location().y());
+                        }, m_packed_field);
+                        pbf_way.add_bytes(OSMFormat::Way::packed_sint64_lat, m_packed_field);
+                    }
+                }
+
+                void relation(const osmium::Relation& relation) {
+                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations);
+                    m_primitive_block->add_to_summary(relation);
+                    protozero::pbf_builder<OSMFormat::Relation> pbf_relation{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Relation_relations};
+
+                    pbf_relation.add_int64(OSMFormat::Relation::required_int64_id, relation.id());
+                    add_meta(relation, pbf_relation);
+
+                    {
+                        protozero::packed_field_int32 field{pbf_relation, protozero::pbf_tag_type(OSMFormat::Relation::packed_int32_roles_sid)};
+                        for (const auto& member : relation.members()) {
+                            field.add_element(m_primitive_block->store_in_stringtable(member.role()));
+                        }
+                    }
+
+                    {
+                        osmium::DeltaEncode<object_id_type, int64_t> delta_id;
+                        protozero::packed_field_sint64 field{pbf_relation, protozero::pbf_tag_type(OSMFormat::Relation::packed_sint64_memids)};
+                        for (const auto& member : relation.members()) {
+                            field.add_element(delta_id.update(member.ref()));
+                        }
+                    }
+
+                    {
+                        protozero::packed_field_int32 field{pbf_relation, protozero::pbf_tag_type(OSMFormat::Relation::packed_MemberType_types)};
+                        for (const auto& member : relation.members()) {
+                            field.add_element(int32_t(osmium::item_type_to_nwr_index(member.type())));
+                        }
+                    }
+                }
+
+                // Changesets are not part of the official PBF format
+                // (except for the id), this is a libosmium extension. All
+                // attributes are written regardless of the metadata
+                // options, they are the changeset's data.
+                void changeset(const osmium::Changeset& changeset) {
+                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_ChangeSet_changesets);
+                    protozero::pbf_builder<OSMFormat::ChangeSet> pbf_changeset{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_ChangeSet_changesets};
+
+                    pbf_changeset.add_int64(OSMFormat::ChangeSet::required_int64_id, changeset.id());
+                    add_tags(changeset.tags(), pbf_changeset);
+
+                    if (changeset.created_at().valid()) {
+                        pbf_changeset.add_int64(OSMFormat::ChangeSet::optional_int64_created_at, uint32_t(changeset.created_at()));
+                    }
+                    if (changeset.closed_at().valid()) {
+                        pbf_changeset.add_int64(OSMFormat::ChangeSet::optional_int64_closed_at, uint32_t(changeset.closed_at()));
+                    }
+                    assert(changeset.uid() <= static_cast<std::size_t>(std::numeric_limits<int32_t>::max()));
+                    pbf_changeset.add_int32(OSMFormat::ChangeSet::optional_int32_uid, static_cast<int32_t>(changeset.uid()));
+                    pbf_changeset.add_uint32(OSMFormat::ChangeSet::optional_uint32_user_sid, m_primitive_block->store_in_stringtable_unsigned(changeset.user()));
+                    pbf_changeset.add_uint32(OSMFormat::ChangeSet::optional_uint32_num_changes, changeset.num_changes());
+                    pbf_changeset.add_uint32(OSMFormat::ChangeSet::optional_uint32_num_comments, changeset.num_comments());
+
+                    const auto& bounds = changeset.bounds();
+                    if (bounds.valid()) {
+                        pbf_changeset.add_sint64(OSMFormat::ChangeSet::optional_sint64_min_lon, bounds.bottom_left().x());
+                        pbf_changeset.add_sint64(OSMFormat::ChangeSet::optional_sint64_min_lat, bounds.bottom_left().y());
+                        pbf_changeset.add_sint64(OSMFormat::ChangeSet::optional_sint64_max_lon, bounds.top_right().x());
+                        pbf_changeset.add_sint64(OSMFormat::ChangeSet::optional_sint64_max_lat, bounds.top_right().y());
+                    }
+
+                    // Comment texts are not put into the string table,
+                    // they are usually unique and can be longer than
+                    // strings in the string table are allowed to be.
+                    for (const auto& comment : changeset.discussion()) {
+                        protozero::pbf_builder<OSMFormat::ChangeSetComment> pbf_comment{pbf_changeset, OSMFormat::ChangeSet::repeated_ChangeSetComment_comments};
+                        pbf_comment.add_int64(OSMFormat::ChangeSetComment::optional_int64_date, uint32_t(comment.date()));
+                        assert(comment.uid() <= static_cast<std::size_t>(std::numeric_limits<int32_t>::max()));
+                        pbf_comment.add_int32(OSMFormat::ChangeSetComment::optional_int32_uid, static_cast<int32_t>(comment.uid()));
+                        pbf_comment.add_uint32(OSMFormat::ChangeSetComment::optional_uint32_user_sid, m_primitive_block->store_in_stringtable_unsigned(comment.user()));
+                        pbf_comment.add_bytes(OSMFormat::ChangeSetComment::optional_bytes_text, comment.text());
+                    }
+                }
+
+            }; // class PBFBlockEncoder
+
+            /**
+             * Information about the blobs in one entry of the output queue.
+             * Used for writing the blob index.
+             */
+            struct pbf_output_chunk {
+
+                /// Summaries of the data blobs in this chunk.
+                std::vector<pbf_blob_summary> summaries;
+
+                /// Positions of all blobs relative to the chunk start.
+                std::vector<pbf_blob_info> blobs;
+
+                /// Size of the chunk in bytes.
+                std::size_t size = 0;
+
+                /// Set when the chunk is encoded.
+                std::promise<void> done;
+
+            }; // struct pbf_output_chunk
+
+            /**
+             * Wraps a task creating PBF blobs and records where the blobs
+             * are in its result.
+             */
+            template <typename TTask>
+            class PBFIndexedTask {
+
+                TTask m_task;
+                std::shared_ptr<pbf_output_chunk> m_chunk;
+
+            public:
+
+                PBFIndexedTask(TTask&& task, std::shared_ptr<pbf_output_chunk> chunk) :
+                    m_task(std::move(task)),
+                    m_chunk(std::move(chunk)) {
+                }
+
+                std::string operator()() {
+                    try {
+                        std::string out{m_task()};
+                        const auto table = PBFBlobTable::from_memory(out.data(), out.size());
+                        m_chunk->blobs.assign(table.begin(), table.end());
+                        m_chunk->size = out.size();
+                        m_chunk->done.set_value();
+                        return out;
+                    } catch (...) {
+                        m_chunk->done.set_exception(std::current_exception());
+                        throw;
+                    }
+                }
+
+            }; // class PBFIndexedTask
+
+            /**
+             * Encodes a whole buffer into PBF blobs. This is run in the
+             * thread pool if the "pbf_parallel_encoding" option is set.
+             */
+            class PBFOutputBlock {
+
+                std::shared_ptr<const osmium::memory::Buffer> m_input_buffer;
+
+                pbf_output_options m_options;
+
+                std::shared_ptr<pbf_output_chunk> m_chunk;
+
+            public:
+
+                PBFOutputBlock(osmium::memory::Buffer&& buffer, const pbf_output_options& options, std::shared_ptr<pbf_output_chunk> chunk = nullptr) :
+                    m_input_buffer(std::make_shared<const osmium::memory::Buffer>(std::move(buffer))),
+                    m_options(options),
+                    m_chunk(std::move(chunk)) {
+                }
+
+                PBFOutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer, const pbf_output_options& options, std::shared_ptr<pbf_output_chunk> chunk = nullptr) :
+                    m_input_buffer(std::move(buffer)),
+                    m_options(options),
+                    m_chunk(std::move(chunk)) {
+                }
+
+                std::string operator()() {
+                    std::string out;
+                    const pbf_output_options& options = m_options;
+                    pbf_output_chunk* chunk = m_chunk.get();
+                    PBFBlockEncoder encoder{&m_options, [&out, &options, chunk](std::shared_ptr<PrimitiveBlock>&& block) {
+                        if (chunk) {
+                            chunk->summaries.push_back(block->summary());
+                        }
+                        out += SerializeBlob{std::move(block),
+                                             pbf_blob_type::data,
+                                             options.use_compression,
+                                             options.compression_level}();
+                    }};
+                    osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), encoder);
+                    encoder.flush();
+                    return out;
+                }
+
+            }; // class PBFOutputBlock
+
+            /**
+             * Frames a raw blob copied from another file. Because the
+             * contents of such a blob are not known, it is decoded to
+             * get its summary for the blob index.
+             */
+            class PBFRawBlobTask {
+
+                std::string m_blob;
+                pbf_output_chunk* m_chunk;
+
+            public:
+
+                PBFRawBlobTask(std::string&& blob, pbf_output_chunk* chunk) :
+                    m_blob(std::move(blob)),
+                    m_chunk(chunk) {
+                }
+
+                std::string operator()() {
+                    pbf_blob_buffer output;
+                    PBFPrimitiveBlockDecoder decoder{decode_blob(m_blob, output), osmium::osm_entity_bits::nwr, osmium::io::read_meta::no, nullptr, osmium::io::tags_prefilter{}, true};
+                    const osmium::memory::Buffer buffer{decoder()};
+
+                    pbf_blob_summary summary;
+                    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                        summary.add(object);
+                    }
+                    m_chunk->summaries.push_back(summary);
+
+                    return frame_blob(pbf_blob_type::data, m_blob);
+                }
+
+            }; // class PBFRawBlobTask
+
+            /**
+             * Orders nodes by the position of their location on a Hilbert
+             * curve, then by ID.
+             */
+            struct node_order_hilbert {
+
+                bool operator()(const osmium::OSMObject& lhs, const osmium::OSMObject& rhs) const noexcept {
+                    const auto lh = osmium::geom::hilbert_index(static_cast<const osmium::Node&>(lhs).location());
+                    const auto rh = osmium::geom::hilbert_index(static_cast<const osmium::Node&>(rhs).location());
+                    return lh < rh || (lh == rh && lhs.id() < rhs.id());
+                }
+
+            }; // struct node_order_hilbert
+
+            /**
+             * Bounded window ordering objects. Objects are added until the
+             * window is full, then the smallest ones (as defined by
+             * TCompare) are taken out. With object_order_type_id_version
+             * this restores the order of objects which arrive only
+             * slightly out of order, objects more than the window size
+             * away from their correct position will still be out of order
+             * in the output. With node_order_hilbert this groups nodes
+             * which are near each other.
+             */
+            template <typename TCompare>
+            class ObjectSortWindow {
+
+                enum {
+                    initial_buffer_size = 1024UL * 1024UL
+                };
+
+                std::size_t m_size;
+                osmium::memory::Buffer m_buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                std::vector<std::size_t> m_offsets;
+
+                const osmium::OSMObject& object(std::size_t offset) const {
+                    return m_buffer.get<const osmium::OSMObject>(offset);
+                }
+
+            public:
+
+                explicit ObjectSortWindow(std::size_t size) :
+                    m_size(size) {
+                    m_offsets.reserve(size);
+                }
+
+                std::size_t size() const noexcept {
+                    return m_size;
+                }
+
+                std::size_t count() const noexcept {
+                    return m_offsets.size();
+                }
+
+                bool full() const noexcept {
+                    return m_offsets.size() >= m_size;
+                }
+
+                void add(const osmium::OSMObject& obj) {
+                    m_offsets.push_back(m_buffer.committed());
+                    m_buffer.add_item(obj);
+                    m_buffer.commit();
+                }
+
+                /**
+                 * Remove the smallest num objects from the window and
+                 * return them in order in a new buffer.
+                 */
+                osmium::memory::Buffer take(std::size_t num) {
+                    std::stable_sort(m_offsets.begin(), m_offsets.end(), [this](std::size_t a, std::size_t b) {
+                        return TCompare{}(object(a), object(b));
+                    });
+
+                    num = std::min(num, m_offsets.size());
+                    osmium::memory::Buffer out{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                    osmium::memory::Buffer rest{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                    std::vector<std::size_t> rest_offsets;
+                    rest_offsets.reserve(m_size);
+
+                    for (std::size_t n = 0; n < m_offsets.size(); ++n) {
+                        if (n < num) {
+                            out.add_item(object(m_offsets[n]));
+                            out.commit();
+                        } else {
+                            rest_offsets.push_back(rest.committed());
+                            rest.add_item(object(m_offsets[n]));
+                            rest.commit();
+                        }
+                    }
+
+                    using std::swap;
+                    swap(m_buffer, rest);
+                    swap(m_offsets, rest_offsets);
+
+                    return out;
+                }
+
+            }; // class ObjectSortWindow
+
+            class PBFOutputFormat : public osmium::io::detail::OutputFormat {
+
+                pbf_output_options m_options;
+
+                PBFBlockEncoder m_encoder;
+
+                bool m_parallel_encoding = false;
+
+                std::unique_ptr<ObjectSortWindow<osmium::object_order_type_id_version>> m_sort_window;
+
+                std::unique_ptr<ObjectSortWindow<node_order_hilbert>> m_cluster_window;
+
+                // Name of the blob index file, empty if none is written.
+                std::string m_blob_index_filename;
+
+                std::vector<std::shared_ptr<pbf_output_chunk>> m_chunks;
+
+                std::vector<std::future<void>> m_chunks_done;
+
+                // Returns nullptr if no blob index is written.
+                std::shared_ptr<pbf_output_chunk> new_chunk() {
+                    if (m_blob_index_filename.empty()) {
+                        return nullptr;
+                    }
+                    m_chunks.push_back(std::make_shared<pbf_output_chunk>());
+                    m_chunks_done.push_back(m_chunks.back()->done.get_future());
+                    return m_chunks.back();
+                }
+
+                template <typename TTask>
+                void submit(TTask&& task, std::shared_ptr<pbf_output_chunk> chunk) {
+                    if (chunk) {
+                        m_output_queue.push(m_pool.submit(PBFIndexedTask<TTask>{std::forward<TTask>(task), std::move(chunk)}));
+                    } else {
+                        m_output_queue.push(m_pool.submit(std::forward<TTask>(task)));
+                    }
+                }
+
+                /**
+                 * Wait until all blobs are encoded, then write the index
+                 * with their positions and summaries.
+                 */
+                void write_blob_index() {
+                    std::vector<pbf_blob_index_entry> entries;
+                    std::size_t offset = 0;
+                    for (std::size_t n = 0; n < m_chunks.size(); ++n) {
+                        m_chunks_done[n].get();
+                        const auto& chunk = *m_chunks[n];
+                        auto summary = chunk.summaries.cbegin();
+                        for (const auto& blob : chunk.blobs) {
+                            if (blob.type != pbf_blob_type::data) {
+                                continue;
+                            }
+                            if (summary == chunk.summaries.cend()) {
+                                throw osmium::pbf_error{"missing summary for blob index"};
+                            }
+                            pbf_blob_index_entry entry;
+                            entry.offset = offset + blob.offset;
+                            entry.size = blob.size;
+                            entry.summary = *summary++;
+                            entries.push_back(entry);
+                        }
+                        offset += chunk.size;
+                    }
+
+                    std::ofstream out{m_blob_index_filename, std::ios::trunc};
+                    write_pbf_blob_index(out, offset, entries);
+                    out.close();
+                    if (!out) {
+                        throw osmium::io_error{"Error writing PBF blob index '" + m_blob_index_filename + "'"};
+                    }
+                }
+
+                void add_to_sort_window(const osmium::memory::Buffer& buffer) {
+                    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                        m_sort_window->add(object);
+                        if (m_sort_window->full()) {
+                            const auto sorted = m_sort_window->take(m_sort_window->size() / 2);
+                            osmium::apply(sorted.cbegin(), sorted.cend(), m_encoder);
+                        }
+                    }
+                }
+
+                void flush_sort_window() {
+                    if (m_sort_window && m_sort_window->count() > 0) {
+                        const auto sorted = m_sort_window->take(m_sort_window->count());
+                        osmium::apply(sorted.cbegin(), sorted.cend(), m_encoder);
+                    }
+                }
+
+                // Nodes go through the cluster window, all other objects
+                // are written in input order after all nodes before them.
+                void add_to_cluster_window(const osmium::memory::Buffer& buffer) {
+                    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                        if (object.type() != osmium::item_type::node) {
+                            flush_cluster_window();
+                            osmium::apply_item(object, m_encoder);
+                            continue;
+                        }
+                        m_cluster_window->add(object);
+                        if (m_cluster_window->full()) {
+                            const auto sorted = m_cluster_window->take(m_cluster_window->size() / 2);
+                            osmium::apply(sorted.cbegin(), sorted.cend(), m_encoder);
+                        }
+                    }
+                }
+
+                void flush_cluster_window() {
+                    if (m_cluster_window && m_cluster_window->count() > 0) {
+                        const auto sorted = m_cluster_window->take(m_cluster_window->count());
+                        osmium::apply(sorted.cbegin(), sorted.cend(), m_encoder);
                     }
                 }
 
             public:
 
                 PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
-                    OutputFormat(pool, output_queue) {
+                    OutputFormat(pool, output_queue),
+                    m_encoder(&m_options, [this](std::shared_ptr<PrimitiveBlock>&& block) {
+                        auto chunk = new_chunk();
+                        if (chunk) {
+                            chunk->summaries.push_back(block->summary());
+                        }
+                        submit(SerializeBlob{std::move(block),
+                                             pbf_blob_type::data,
+                                             m_options.use_compression,
+                                             m_options.compression_level}, std::move(chunk));
+                    }) {
 
                     if (!file.get("pbf_add_metadata").empty()) {
                         throw std::invalid_argument{"The 'pbf_add_metadata' option is deprecated. Please use 'add_metadata' instead."};
@@ -572,6 +1196,37 @@ namespace osmium {
                     m_options.add_historical_information_flag = file.has_multiple_object_versions();
                     m_options.add_visible_flag = file.has_multiple_object_versions();
                     m_options.locations_on_ways = file.is_true("locations_on_ways");
+                    m_parallel_encoding = file.is_true("pbf_parallel_encoding");
+
+                    const auto window = file.get("pbf_sort_window");
+                    if (!window.empty()) {
+                        char* end_ptr = nullptr;
+                        const auto size = std::strtoul(window.c_str(), &end_ptr, 10);
+                        if (*end_ptr != '\0' || window[0] == '-' || size < 2) {
+                            throw std::invalid_argument{"The 'pbf_sort_window' option must be an integer >= 2."};
+                        }
+                        m_sort_window.reset(new ObjectSortWindow<osmium::object_order_type_id_version>{size});
+                    }
+
+                    const auto cluster = file.get("pbf_cluster_nodes");
+                    if (!cluster.empty()) {
+                        char* end_ptr = nullptr;
+                        const auto size = std::strtoul(cluster.c_str(), &end_ptr, 10);
+                        if (*end_ptr != '\0' || cluster[0] == '-' || size < 2) {
+                            throw std::invalid_argument{"The 'pbf_cluster_nodes' option must be an integer >= 2."};
+                        }
+                        if (m_sort_window) {
+                            throw std::invalid_argument{"The 'pbf_cluster_nodes' and 'pbf_sort_window' options can not be used together."};
+                        }
+                        m_cluster_window.reset(new ObjectSortWindow<node_order_hilbert>{size});
+                    }
+
+                    if (file.is_true("pbf_blob_index")) {
+                        if (file.filename().empty() || file.compression() != osmium::io::file_compression::none) {
+                            throw std::invalid_argument{"The 'pbf_blob_index' option only works for uncompressed PBF files (not on stdout)."};
+                        }
+                        m_blob_index_filename = pbf_blob_index_filename(file.filename());
+                    }
 
                     const auto pbl = file.get("pbf_compression_level");
                     if (pbl.empty()) {
@@ -584,6 +1239,11 @@ namespace osmium {
                             case pbf_compression::lz4:
 #ifdef OSMIUM_WITH_LZ4
                                 m_options.compression_level = osmium::io::detail::lz4_default_compression_level();
+#endif
+                                break;
+                            case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                                m_options.compression_level = osmium::io::detail::zstd_default_compression_level();
 #endif
                                 break;
                         }
@@ -602,6 +1262,11 @@ namespace osmium {
                             case pbf_compression::lz4:
 #ifdef OSMIUM_WITH_LZ4
                                 osmium::io::detail::lz4_check_compression_level(val);
+#endif
+                                break;
+                            case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                                osmium::io::detail::zstd_check_compression_level(val);
 #endif
                                 break;
                         }
@@ -637,7 +1302,8 @@ namespace osmium {
                         pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "LocationsOnWays");
                     }
 
-                    if (header.get("sorting") == "Type_then_ID") {
+                    // Clustered nodes are not sorted by ID any more.
+                    if (header.get("sorting") == "Type_then_ID" && !m_cluster_window) {
                         pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "Sort.Type_then_ID");
                     }
 
@@ -659,98 +1325,69 @@ namespace osmium {
                         pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_osmosis_replication_base_url, osmosis_replication_base_url);
                     }
 
-                    m_output_queue.push(m_pool.submit(
-                        SerializeBlob{std::move(data),
-                                      pbf_blob_type::header,
-                                      m_options.use_compression,
-                                      m_options.compression_level}));
+                    submit(SerializeBlob{std::move(data),
+                                         pbf_blob_type::header,
+                                         m_options.use_compression,
+                                         m_options.compression_level}, new_chunk());
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    osmium::apply(buffer.cbegin(), buffer.cend(), *this);
-                }
-
-                void write_end() final {
-                    store_primitive_block();
-                }
-
-                void node(const osmium::Node& node) {
-                    if (m_options.use_dense_nodes) {
-                        switch_primitive_block_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense);
-                        m_primitive_block->add_dense_node(node);
+                    if (m_sort_window) {
+                        add_to_sort_window(buffer);
                         return;
                     }
-
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes);
-                    protozero::pbf_builder<OSMFormat::Node> pbf_node{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Node_nodes};
-
-                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_id, node.id());
-                    add_meta(node, pbf_node);
-
-                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_lat, node.location().y());
-                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_lon, node.location().x());
+                    if (m_cluster_window) {
+                        add_to_cluster_window(buffer);
+                        return;
+                    }
+                    if (m_parallel_encoding) {
+                        auto chunk = new_chunk();
+                        submit(PBFOutputBlock{std::move(buffer), m_options, chunk}, chunk);
+                        return;
+                    }
+                    osmium::apply(buffer.cbegin(), buffer.cend(), m_encoder);
                 }
 
-                void way(const osmium::Way& way) {
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Way_ways);
-                    protozero::pbf_builder<OSMFormat::Way> pbf_way{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Way_ways};
-
-                    pbf_way.add_int64(OSMFormat::Way::required_int64_id, way.id());
-                    add_meta(way, pbf_way);
-
-                    {
-                        osmium::DeltaEncode<object_id_type, int64_t> delta_id;
-                        protozero::packed_field_sint64 field{pbf_way, protozero::pbf_tag_type(OSMFormat::Way::packed_sint64_refs)};
-                        for (const auto& node_ref : way.nodes()) {
-                            field.add_element(delta_id.update(node_ref.ref()));
-                        }
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    if (m_sort_window) {
+                        add_to_sort_window(*buffer);
+                        return;
                     }
-
-                    if (m_options.locations_on_ways) {
-                        {
-                            osmium::DeltaEncode<int64_t, int64_t> delta;
-                            protozero::packed_field_sint64 field{pbf_way, protozero::pbf_tag_type(OSMFormat::Way::packed_sint64_lon)};
-                            for (const auto& node_ref : way.nodes()) {
-                                field.add_element(delta.update(node_ref.location().x()));
-                            }
-                        }
-                        {
-                            osmium::DeltaEncode<int64_t, int64_t> delta;
-                            protozero::packed_field_sint64 field{pbf_way, protozero::pbf_tag_type(OSMFormat::Way::packed_sint64_lat)};
-                            for (const auto& node_ref : way.nodes()) {
-                                field.add_element(delta.update(node_ref.location().y()));
-                            }
-                        }
+                    if (m_cluster_window) {
+                        add_to_cluster_window(*buffer);
+                        return;
+                    }
+                    if (m_parallel_encoding) {
+                        auto chunk = new_chunk();
+                        submit(PBFOutputBlock{buffer, m_options, chunk}, chunk);
+                        return;
                     }
+                    osmium::apply(buffer->cbegin(), buffer->cend(), m_encoder);
                 }
 
-                void relation(const osmium::Relation& relation) {
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations);
-                    protozero::pbf_builder<OSMFormat::Relation> pbf_relation{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Relation_relations};
-
-                    pbf_relation.add_int64(OSMFormat::Relation::required_int64_id, relation.id());
-                    add_meta(relation, pbf_relation);
+                bool supports_raw_blobs() const noexcept final {
+                    return true;
+                }
 
-                    {
-                        protozero::packed_field_int32 field{pbf_relation, protozero::pbf_tag_type(OSMFormat::Relation::packed_int32_roles_sid)};
-                        for (const auto& member : relation.members()) {
-                            field.add_element(m_primitive_block->store_in_stringtable(member.role()));
-                        }
+                void write_raw_blob(std::string&& blob) final {
+                    flush_sort_window();
+                    flush_cluster_window();
+                    m_encoder.flush();
+                    auto chunk = new_chunk();
+                    if (!chunk) {
+                        send_to_output_queue(frame_blob(pbf_blob_type::data, blob));
+                        return;
                     }
 
-                    {
-                        osmium::DeltaEncode<object_id_type, int64_t> delta_id;
-                        protozero::packed_field_sint64 field{pbf_relation, protozero::pbf_tag_type(OSMFormat::Relation::packed_sint64_memids)};
-                        for (const auto& member : relation.members()) {
-                            field.add_element(delta_id.update(member.ref()));
-                        }
-                    }
+                    submit(PBFRawBlobTask{std::move(blob), chunk.get()}, chunk);
+                }
 
-                    {
-                        protozero::packed_field_int32 field{pbf_relation, protozero::pbf_tag_type(OSMFormat::Relation::packed_MemberType_types)};
-                        for (const auto& member : relation.members()) {
-                            field.add_element(int32_t(osmium::item_type_to_nwr_index(member.type())));
-                        }
+                void write_end() final {
+                    flush_sort_window();
+                    flush_cluster_window();
+                    m_encoder.flush();
+                    if (!m_blob_index_filename.empty()) {
+                        write_blob_index();
                     }
                 }
 
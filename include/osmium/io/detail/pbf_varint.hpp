@@ -0,0 +1,189 @@
+#ifndef OSMIUM_IO_DETAIL_PBF_VARINT_HPP
+#define OSMIUM_IO_DETAIL_PBF_VARINT_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/pbf.hpp>
+
+#include <protozero/varint.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Functions for encoding and decoding whole arrays of delta
+             * and zigzag coded varints as used in packed sint64 fields in
+             * PBF files (for instance the refs and locations of ways). They
+             * do one pass over the data with no per-value function call
+             * overhead and no bounds checks where the buffer is known to be
+             * big enough.
+             */
+
+            /// Maximum number of bytes a 64 bit varint can take.
+            enum : std::size_t {
+                max_varint_length = 10
+            };
+
+            /**
+             * Delta, zigzag and varint encode the values func(*it) for all
+             * it in [first, last) and append them to out. The result is the
+             * content of a packed sint64 field.
+             */
+            template <typename TIterator, typename TFunction>
+            void append_delta_encoded_sint64(TIterator first, TIterator last, TFunction&& func, std::string& out) {
+                const auto count = static_cast<std::size_t>(std::distance(first, last));
+                const std::size_t old_size = out.size();
+                out.resize(old_size + count * max_varint_length);
+
+                char* const begin = &out[old_size];
+                char* pos = begin;
+                uint64_t last_value = 0;
+                for (; first != last; ++first) {
+                    const auto value = static_cast<uint64_t>(func(*first));
+                    pos += protozero::write_varint(pos, protozero::encode_zigzag64(static_cast<int64_t>(value - last_value)));
+                    last_value = value;
+                }
+
+                out.resize(old_size + static_cast<std::size_t>(pos - begin));
+            }
+
+            /**
+             * Read eight bytes starting at data as little endian 64 bit
+             * word. Compilers turn this into a single load on little
+             * endian machines.
+             */
+            inline uint64_t load_le64(const char* data) noexcept {
+                uint64_t word = 0;
+                for (unsigned int i = 0; i < 8; ++i) {
+                    word |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8U * i);
+                }
+                return word;
+            }
+
+            /**
+             * Decode up to count delta, zigzag and varint encoded values
+             * from the data starting at *data and ending at end into out.
+             * Afterwards *data points to the first byte not decoded.
+             *
+             * Runs of eight one-byte varints (very common for node ids)
+             * are detected with a single 64 bit load and decoded in one
+             * go.
+             *
+             * @returns The number of values decoded.
+             * @throws osmium::pbf_error If a varint is too long or truncated.
+             */
+            inline std::size_t decode_delta_encoded_sint64(const char** data, const char* end, int64_t* out, const std::size_t count) {
+                constexpr const uint64_t high_bits = 0x8080808080808080ULL;
+
+                const char* pos = *data;
+                uint64_t value = 0;
+                std::size_t n = 0;
+
+                // Fast path: There are enough bytes left for the longest
+                // possible varint, so there is no need to check the end.
+                while (n < count && end - pos >= static_cast<std::ptrdiff_t>(max_varint_length)) {
+                    if ((static_cast<unsigned char>(*pos) & 0x80U) == 0 &&
+                        count - n >= 8 &&
+                        (load_le64(pos) & high_bits) == 0) {
+                        for (unsigned int i = 0; i < 8; ++i) {
+                            value += static_cast<uint64_t>(protozero::decode_zigzag64(static_cast<unsigned char>(pos[i])));
+                            out[n + i] = static_cast<int64_t>(value);
+                        }
+                        n += 8;
+                        pos += 8;
+                        continue;
+                    }
+
+                    uint64_t v = static_cast<unsigned char>(*pos++);
+                    if (v >= 0x80U) {
+                        v &= 0x7fU;
+                        unsigned int shift = 7;
+                        while (true) {
+                            const uint64_t byte = static_cast<unsigned char>(*pos++);
+                            v |= (byte & 0x7fU) << shift;
+                            if (byte < 0x80U) {
+                                break;
+                            }
+                            shift += 7;
+                            if (shift > 63) {
+                                throw osmium::pbf_error{"varint too long"};
+                            }
+                        }
+                    }
+
+                    value += static_cast<uint64_t>(protozero::decode_zigzag64(v));
+                    out[n++] = static_cast<int64_t>(value);
+                }
+
+                // Slow path for the last few bytes.
+                while (n < count && pos != end) {
+                    uint64_t v = 0;
+                    unsigned int shift = 0;
+                    while (true) {
+                        if (pos == end) {
+                            throw osmium::pbf_error{"truncated varint"};
+                        }
+                        const uint64_t byte = static_cast<unsigned char>(*pos++);
+                        v |= (byte & 0x7fU) << shift;
+                        if (byte < 0x80U) {
+                            break;
+                        }
+                        shift += 7;
+                        if (shift > 63) {
+                            throw osmium::pbf_error{"varint too long"};
+                        }
+                    }
+                    value += static_cast<uint64_t>(protozero::decode_zigzag64(v));
+                    out[n++] = static_cast<int64_t>(value);
+                }
+
+                *data = pos;
+                return n;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PBF_VARINT_HPP
@@ -163,6 +163,35 @@ namespace osmium {
                     packed_MemberType_types = 10
                 };
 
+                // Only the id is in the official format, the other fields
+                // are a libosmium extension. Fields 2 to 4 are reserved
+                // for keys, vals, and info in the official format, fields
+                // 2 and 3 are used like that.
+                enum class ChangeSet : protozero::pbf_tag_type {
+                    required_int64_id                  =  1,
+                    packed_uint32_keys                 =  2,
+                    packed_uint32_vals                 =  3,
+                    optional_int64_created_at          =  5,
+                    optional_int64_closed_at           =  6,
+                    optional_int32_uid                 =  7,
+                    optional_uint32_user_sid           =  8,
+                    optional_uint32_num_changes        =  9,
+                    optional_uint32_num_comments       = 10,
+                    optional_sint64_min_lon            = 11,
+                    optional_sint64_min_lat            = 12,
+                    optional_sint64_max_lon            = 13,
+                    optional_sint64_max_lat            = 14,
+                    repeated_ChangeSetComment_comments = 15
+                };
+
+                // libosmium extension
+                enum class ChangeSetComment : protozero::pbf_tag_type {
+                    optional_int64_date      = 1,
+                    optional_int32_uid       = 2,
+                    optional_uint32_user_sid = 3,
+                    optional_bytes_text      = 4
+                };
+
             } // namespace OSMFormat
 
         } // namespace detail
@@ -34,9 +34,11 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/memory/buffer.hpp>
-#include <osmium/thread/queue.hpp>
+#include <osmium/thread/spsc_queue.hpp>
 
 #include <cassert>
+#include <chrono>
+#include <cstddef>
 #include <exception>
 #include <future>
 #include <string>
@@ -48,8 +50,13 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * The queues between the read thread, the parser, the writer
+             * and the write thread always have exactly one producer and
+             * one consumer, so we can use the lock-free SPSCQueue.
+             */
             template <typename T>
-            using future_queue_type = osmium::thread::Queue<std::future<T>>;
+            using future_queue_type = osmium::thread::SPSCQueue<std::future<T>>;
 
             /**
              * This type of queue contains buffers with OSM data in them.
@@ -72,16 +79,20 @@ namespace osmium {
 
             template <typename T>
             inline void add_to_queue(future_queue_type<T>& queue, T&& data) {
+                // Set the value before pushing, so that the future is
+                // ready when the consumer is notified about it.
                 std::promise<T> promise;
-                queue.push(promise.get_future());
+                std::future<T> future{promise.get_future()};
                 promise.set_value(std::forward<T>(data));
+                queue.push(std::move(future));
             }
 
             template <typename T>
             inline void add_to_queue(future_queue_type<T>& queue, std::exception_ptr&& exception) {
                 std::promise<T> promise;
-                queue.push(promise.get_future());
+                std::future<T> future{promise.get_future()};
                 promise.set_exception(std::move(exception));
+                queue.push(std::move(future));
             }
 
             template <typename T>
@@ -97,6 +108,14 @@ namespace osmium {
                 return !buffer;
             }
 
+            inline std::size_t memory_size(const std::string& data) noexcept {
+                return data.capacity();
+            }
+
+            inline std::size_t memory_size(const osmium::memory::Buffer& buffer) noexcept {
+                return buffer.capacity();
+            }
+
             template <typename T>
             class queue_wrapper {
 
@@ -136,6 +155,7 @@ namespace osmium {
                         m_queue.wait_and_pop(data_future);
                         if (data_future.valid()) {
                             data = std::move(data_future.get());
+                            m_queue.add_popped_bytes(memory_size(data));
                             if (at_end_of_data(data)) {
                                 m_queue.shutdown();
                             }
@@ -144,6 +164,50 @@ namespace osmium {
                     return data;
                 }
 
+                /**
+                 * Like pop(), but doesn't wait if the queue is empty. Returns
+                 * false in that case. Waits if the first element in the
+                 * queue isn't ready yet.
+                 */
+                bool try_pop(T& data) {
+                    if (!m_queue.in_use()) {
+                        return false;
+                    }
+                    std::future<T> data_future;
+                    if (!m_queue.try_pop(data_future)) {
+                        return false;
+                    }
+                    data = T{};
+                    if (data_future.valid()) {
+                        data = std::move(data_future.get());
+                        m_queue.add_popped_bytes(memory_size(data));
+                    }
+                    if (at_end_of_data(data)) {
+                        m_queue.shutdown();
+                    }
+                    return true;
+                }
+
+                /**
+                 * Like pop(), but doesn't wait for data. Returns false if
+                 * the queue is empty or the first element in the queue
+                 * isn't ready yet.
+                 */
+                bool try_pop_ready(T& data) {
+                    if (m_queue.in_use()) {
+                        std::future<T>* data_future = m_queue.front();
+                        if (!data_future) {
+                            return false;
+                        }
+                        if (data_future->valid() &&
+                            data_future->wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
+                            return false;
+                        }
+                    }
+                    data = pop();
+                    return true;
+                }
+
             }; // class queue_wrapper
 
         } // namespace detail
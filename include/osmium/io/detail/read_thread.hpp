@@ -35,10 +35,16 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/max_memory_in_flight.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/serial_task.hpp>
+#include <osmium/thread/thread_policy.hpp>
 #include <osmium/thread/util.hpp>
 
 #include <atomic>
 #include <exception>
+#include <memory>
 #include <string>
 #include <thread>
 #include <utility>
@@ -53,29 +59,109 @@ namespace osmium {
              * This code uses an internally managed thread to read data from
              * the input file and (optionally) decompress it. The result is
              * sent to the given queue. Any exceptions will also be send to
-             * the queue.
+             * the queue. If a counter is given, the amount of data read and
+             * the time spent reading it are added to it. If a memory
+             * account is given, the data read is added to it and reading
+             * pauses while the memory budget is used up.
+             *
+             * If an executor pool is given, the reading is done in tasks on
+             * that pool instead of in a thread of its own. A task reads
+             * until the queue is full and is scheduled again whenever the
+             * consumer takes something out of the queue. Otherwise the
+             * given thread settings are applied to the read thread.
              */
             class ReadThreadManager {
 
                 // only used in the sub-thread
                 osmium::io::Decompressor& m_decompressor;
                 future_string_queue_type& m_queue;
+                stage_counter* m_counter;
+                memory_account* m_memory;
 
                 // used in both threads
                 std::atomic<bool> m_done;
 
+                // only used in the read tasks (or in close() after they
+                // are stopped)
+                bool m_finished = false;
+
+                // only used when starting the thread
+                osmium::thread::thread_settings m_thread_settings;
+
                 // only used in the main thread
                 std::thread m_thread;
+                std::unique_ptr<osmium::thread::SerialTask> m_task;
+
+                void finish() {
+                    add_end_of_data_to_queue(m_queue);
+                    m_finished = true;
+                }
+
+                // Read one block of data and add it to the queue. Returns
+                // false if no more data can be added right now.
+                bool read_step() {
+                    if (m_done || m_finished || m_queue.size() >= m_queue.max_size()) {
+                        return false;
+                    }
+
+                    if (m_memory) {
+                        m_memory->wait_for_room([this]() {
+                            return m_done || !m_queue.in_use();
+                        });
+                    }
+
+                    try {
+                        const auto start = stage_counter::clock::now();
+                        std::string data{m_decompressor.read()};
+                        if (m_counter) {
+                            m_counter->add_busy_time(start);
+                        }
+                        if (at_end_of_data(data)) {
+                            m_decompressor.close();
+                            finish();
+                            return false;
+                        }
+                        if (m_counter) {
+                            m_counter->add(data.size());
+                        }
+                        if (m_memory) {
+                            m_memory->add(data.size());
+                        }
+                        add_to_queue(m_queue, std::move(data));
+                    } catch (...) {
+                        add_to_queue(m_queue, std::current_exception());
+                        finish();
+                        return false;
+                    }
+
+                    return true;
+                }
 
                 void run_in_thread() {
                     osmium::thread::set_thread_name("_osmium_read");
+                    m_thread_settings.apply();
 
                     try {
                         while (!m_done) {
+                            if (m_memory) {
+                                m_memory->wait_for_room([this]() {
+                                    return m_done || !m_queue.in_use();
+                                });
+                            }
+                            const auto start = stage_counter::clock::now();
                             std::string data{m_decompressor.read()};
+                            if (m_counter) {
+                                m_counter->add_busy_time(start);
+                            }
                             if (at_end_of_data(data)) {
                                 break;
                             }
+                            if (m_counter) {
+                                m_counter->add(data.size());
+                            }
+                            if (m_memory) {
+                                m_memory->add(data.size());
+                            }
                             add_to_queue(m_queue, std::move(data));
                         }
 
@@ -90,11 +176,28 @@ namespace osmium {
             public:
 
                 ReadThreadManager(osmium::io::Decompressor& decompressor,
-                                  future_string_queue_type& queue) :
+                                  future_string_queue_type& queue,
+                                  stage_counter* counter = nullptr,
+                                  memory_account* memory = nullptr,
+                                  osmium::thread::Pool* executor = nullptr,
+                                  osmium::thread::thread_settings thread_settings = osmium::thread::thread_settings{}) :
                     m_decompressor(decompressor),
                     m_queue(queue),
+                    m_counter(counter),
+                    m_memory(memory),
                     m_done(false),
-                    m_thread(std::thread(&ReadThreadManager::run_in_thread, this)) {
+                    m_thread_settings(std::move(thread_settings)) {
+                    if (executor) {
+                        m_task.reset(new osmium::thread::SerialTask{*executor, [this]() {
+                            return read_step();
+                        }});
+                        m_queue.set_notifications(nullptr, [this]() {
+                            m_task->schedule();
+                        });
+                        m_task->schedule();
+                    } else {
+                        m_thread = std::thread(&ReadThreadManager::run_in_thread, this);
+                    }
                 }
 
                 ReadThreadManager(const ReadThreadManager&) = delete;
@@ -117,6 +220,17 @@ namespace osmium {
 
                 void close() {
                     stop();
+                    if (m_task) {
+                        m_task->stop();
+                        if (!m_finished) {
+                            try {
+                                m_decompressor.close();
+                            } catch (...) {
+                                add_to_queue(m_queue, std::current_exception());
+                            }
+                            finish();
+                        }
+                    }
                     if (m_thread.joinable()) {
                         m_thread.join();
                     }
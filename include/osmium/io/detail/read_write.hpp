@@ -200,6 +200,68 @@ namespace osmium {
                 return nread;
             }
 
+#ifndef _WIN32
+            /**
+             * Reads exactly the given number of bytes from the given offset
+             * in the file without changing the file offset. Unlike
+             * reliable_read() this can be used from several threads on the
+             * same file descriptor at the same time. Not available on
+             * Windows.
+             *
+             * @param fd File descriptor.
+             * @param input_buffer Buffer with data.
+             * @param size Number of bytes to read.
+             * @param offset Offset into the file.
+             * @returns true if all bytes could be read, false on EOF.
+             * @throws std::system_error On error.
+             */
+            inline bool reliable_pread(const int fd, char* input_buffer, std::size_t size, std::size_t offset) {
+                while (size > 0) {
+                    const auto nread = ::pread(fd, input_buffer, size, static_cast<off_t>(offset));
+                    if (nread < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        throw std::system_error{errno, std::system_category(), "Read failed"};
+                    }
+                    if (nread == 0) {
+                        return false;
+                    }
+                    input_buffer += nread;
+                    size -= static_cast<std::size_t>(nread);
+                    offset += static_cast<std::size_t>(nread);
+                }
+
+                return true;
+            }
+
+            /**
+             * Writes the given number of bytes at the given offset in the
+             * file without changing the file offset. Not available on
+             * Windows.
+             *
+             * @param fd File descriptor.
+             * @param output_buffer Buffer with data to be written.
+             * @param size Number of bytes to write.
+             * @param offset Offset into the file.
+             * @throws std::system_error On error.
+             */
+            inline void reliable_pwrite(const int fd, const char* output_buffer, std::size_t size, std::size_t offset) {
+                while (size > 0) {
+                    const auto nwritten = ::pwrite(fd, output_buffer, size, static_cast<off_t>(offset));
+                    if (nwritten < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        throw std::system_error{errno, std::system_category(), "Write failed"};
+                    }
+                    output_buffer += nwritten;
+                    size -= static_cast<std::size_t>(nwritten);
+                    offset += static_cast<std::size_t>(nwritten);
+                }
+            }
+#endif
+
             inline void reliable_fsync(const int fd) {
 #ifdef _MSC_VER
                 osmium::detail::disable_invalid_parameter_handler diph;
@@ -247,6 +309,20 @@ namespace osmium {
                 return fd2;
             }
 
+            /**
+             * Tell the kernel that this file will be read sequentially, so
+             * that it can read ahead more aggressively.
+             */
+#ifdef __linux__
+            inline void advise_sequential_access(int fd) noexcept {
+                if (fd >= 0) {
+                    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                }
+#else
+            inline void advise_sequential_access(int /*fd*/) noexcept {
+#endif
+            }
+
             /**
              * Tell the kernel to remove all pages from this file from the
              * buffer cache. Used when reading a large file that will not be
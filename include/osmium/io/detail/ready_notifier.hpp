@@ -0,0 +1,138 @@
+#ifndef OSMIUM_IO_DETAIL_READY_NOTIFIER_HPP
+#define OSMIUM_IO_DETAIL_READY_NOTIFIER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/data_ready_callback.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Connects the producers of the Reader output (the parser
+             * thread and the pool tasks decoding buffers) with a consumer
+             * that doesn't want to block waiting for the output. Whenever
+             * new output might be available, notify() is called. It calls
+             * the user-supplied callback and runs the registered waiter
+             * (if any).
+             *
+             * A waiter is a function trying to consume the output. It
+             * returns true if it did, false if nothing was available. In
+             * the second case it is registered again, unless there was a
+             * notification in the meantime, then it is run again. The
+             * generation counter is used to make sure no notification
+             * can get lost.
+             */
+            class ready_notifier {
+
+                osmium::io::data_ready_callback m_callback;
+
+                std::mutex m_mutex;
+                std::function<bool()> m_waiter{};
+                uint64_t m_generation = 0;
+
+                void run(std::function<bool()>&& waiter, uint64_t generation) {
+                    while (!waiter()) {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                        if (m_generation == generation) {
+                            m_waiter = std::move(waiter);
+                            return;
+                        }
+                        generation = m_generation;
+                    }
+                }
+
+            public:
+
+                explicit ready_notifier(osmium::io::data_ready_callback callback) :
+                    m_callback(std::move(callback)) {
+                }
+
+                /**
+                 * The current generation. It is increased on each
+                 * notification. Get this before checking whether output
+                 * is available and hand it to wait() afterwards.
+                 */
+                uint64_t generation() {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    return m_generation;
+                }
+
+                /**
+                 * Register a waiter. This only works if there was no
+                 * notification since generation was read, otherwise
+                 * false is returned and the caller should check again
+                 * whether there is output available.
+                 */
+                bool wait(std::function<bool()> waiter, uint64_t generation) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    if (m_generation != generation) {
+                        return false;
+                    }
+                    m_waiter = std::move(waiter);
+                    return true;
+                }
+
+                void notify() {
+                    m_callback();
+
+                    std::function<bool()> waiter;
+                    uint64_t generation = 0;
+                    {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                        generation = ++m_generation;
+                        if (!m_waiter) {
+                            return;
+                        }
+                        std::swap(waiter, m_waiter);
+                    }
+                    run(std::move(waiter), generation);
+                }
+
+            }; // class ready_notifier
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_READY_NOTIFIER_HPP
@@ -0,0 +1,162 @@
+#ifndef OSMIUM_IO_DETAIL_SORT_ORDER_VERIFIER_HPP
+#define OSMIUM_IO_DETAIL_SORT_ORDER_VERIFIER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler/check_order.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <string>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Checks that OSM objects are sorted by type (nodes, then
+             * ways, then relations) and ID (in osmium::id_order), which is
+             * what the "Sort.Type_then_ID" feature of PBF files promises.
+             * If the input can contain several versions of the same object
+             * (history and change files), the same ID can appear several
+             * times in a row, otherwise every ID must only appear once.
+             * Objects which are not nodes, ways, or relations are ignored.
+             *
+             * Used by the Reader if the osmium::io::verify_sorting option
+             * is set.
+             */
+            class sort_order_verifier {
+
+                osmium::item_type m_type = osmium::item_type::undefined;
+                osmium::object_id_type m_id = 0;
+                bool m_allow_same_id = false;
+
+                static bool is_nwr(const osmium::item_type type) noexcept {
+                    return type == osmium::item_type::node ||
+                           type == osmium::item_type::way ||
+                           type == osmium::item_type::relation;
+                }
+
+                void set_last(const osmium::OSMObject& object) noexcept {
+                    m_type = object.type();
+                    m_id = object.id();
+                }
+
+            public:
+
+                sort_order_verifier() noexcept = default;
+
+                explicit sort_order_verifier(bool allow_same_id) noexcept :
+                    m_allow_same_id(allow_same_id) {
+                }
+
+                /**
+                 * Check that the object comes after the one checked last.
+                 *
+                 * @throws osmium::out_of_order_error if it doesn't.
+                 */
+                void check(const osmium::OSMObject& object) {
+                    if (!is_nwr(object.type())) {
+                        return;
+                    }
+
+                    if (m_type != osmium::item_type::undefined) {
+                        if (object.type() < m_type) {
+                            throw osmium::out_of_order_error{std::string{"Found a "} + osmium::item_type_to_name(object.type()) +
+                                                             " after a " + osmium::item_type_to_name(m_type) + ".", object.id()};
+                        }
+                        if (object.type() == m_type) {
+                            if (object.id() == m_id) {
+                                if (!m_allow_same_id) {
+                                    throw osmium::out_of_order_error{std::string{"ID of "} + osmium::item_type_to_name(object.type()) +
+                                                                     " twice in input: " + std::to_string(object.id()), object.id()};
+                                }
+                            } else if (osmium::id_order{}(object.id(), m_id)) {
+                                throw osmium::out_of_order_error{std::string{"IDs of "} + osmium::item_type_to_name(object.type()) +
+                                                                 "s out of order: " + std::to_string(object.id()), object.id()};
+                            }
+                        }
+                    }
+
+                    set_last(object);
+                }
+
+                /**
+                 * Check all objects in the buffer.
+                 *
+                 * @throws osmium::out_of_order_error if they are not in order.
+                 */
+                void check(const osmium::memory::Buffer& buffer) {
+                    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                        check(object);
+                    }
+                }
+
+                /**
+                 * Check only that the first object in the buffer comes after
+                 * the object checked last and remember the last object in
+                 * the buffer. Use this if the order of the objects inside
+                 * the buffer has already been checked separately.
+                 *
+                 * @throws osmium::out_of_order_error if the first object is
+                 *         out of order.
+                 */
+                void check_boundary(const osmium::memory::Buffer& buffer) {
+                    const osmium::OSMObject* last = nullptr;
+                    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                        if (is_nwr(object.type())) {
+                            if (!last) {
+                                check(object);
+                            }
+                            last = &object;
+                        }
+                    }
+                    if (last) {
+                        set_last(*last);
+                    }
+                }
+
+            }; // class sort_order_verifier
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_SORT_ORDER_VERIFIER_HPP
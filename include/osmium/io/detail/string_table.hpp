@@ -34,7 +34,9 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/io/detail/pbf.hpp>
+#include <osmium/util/string.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -42,8 +44,8 @@ DEALINGS IN THE SOFTWARE.
 #include <iterator>
 #include <list>
 #include <string>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -94,7 +96,15 @@ namespace osmium {
                  * allocated.
                  */
                 const char* add(const char* string) {
-                    const size_t len = std::strlen(string) + 1;
+                    return add(string, std::strlen(string));
+                }
+
+                /**
+                 * Add a string with the given length (not including the
+                 * terminating null byte) to the store.
+                 */
+                const char* add(const char* string, size_t length) {
+                    const size_t len = length + 1;
 
                     assert(len <= m_chunk_size);
 
@@ -104,7 +114,7 @@ namespace osmium {
                         chunk_len = 0;
                     }
 
-                    m_chunks.back().append(string);
+                    m_chunks.back().append(string, length);
                     m_chunks.back().append(1, '\0');
 
                     return m_chunks.back().c_str() + chunk_len;
@@ -199,31 +209,26 @@ namespace osmium {
                     return m_chunks.back().size();
                 }
 
-            }; // class StringStore
-
-            struct str_equal {
-
-                bool operator()(const char* lhs, const char* rhs) const noexcept {
-                    return lhs == rhs || std::strcmp(lhs, rhs) == 0;
-                }
-
-            }; // struct str_equal
-
-            struct djb2_hash {
-
-                std::size_t operator()(const char* str) const noexcept {
-                    std::size_t hash = 5381;
-                    int c = 0;
-
-                    while ((c = static_cast<signed char>(*str++))) { // NOLINT(bugprone-signed-char-misuse,cert-str34-c)
-                        hash = ((hash << 5U) + hash) + c; /* hash * 33 + c */
+                /// Memory used by the store in bytes (approximately).
+                std::size_t used_memory() const noexcept {
+                    std::size_t result = 0;
+                    for (const auto& chunk : m_chunks) {
+                        result += chunk.capacity();
                     }
-
-                    return hash;
+                    return result;
                 }
 
-            }; // struct djb2_hash
+            }; // class StringStore
 
+            /**
+             * The string table of a PBF primitive block. The strings are
+             * stored in a StringStore, they are found through a hash table
+             * with open addressing and linear probing.
+             *
+             * Ids are handed out in insertion order. How often each string
+             * was added is counted, so the ids can be reordered with
+             * reorder_by_frequency() before the table is written out.
+             */
             class StringTable {
 
                 // This is the maximum number of entries in a string table.
@@ -235,9 +240,44 @@ namespace osmium {
                     max_entries = static_cast<int32_t>(max_uncompressed_blob_size)
                 };
 
+                // Slot in the hash table. The id 0 (the empty string at the
+                // start of every string table) is never in the hash table,
+                // so it marks an empty slot.
+                struct slot {
+                    uint32_t hash = 0;
+                    int32_t id = 0;
+                };
+
                 StringStore m_strings;
-                std::unordered_map<const char*, int32_t, djb2_hash, str_equal> m_index;
-                int32_t m_size = 0;
+                std::vector<const char*> m_strings_by_id;
+                std::vector<uint32_t> m_lengths;
+                std::vector<uint32_t> m_counts;
+                std::vector<slot> m_slots;
+                std::size_t m_mask;
+
+                static std::size_t initial_capacity(std::size_t bucket_count) noexcept {
+                    std::size_t capacity = 16;
+                    while (capacity < bucket_count) {
+                        capacity *= 2;
+                    }
+                    return capacity;
+                }
+
+                void grow() {
+                    std::vector<slot> old_slots(m_slots.size() * 2);
+                    using std::swap;
+                    swap(old_slots, m_slots);
+                    m_mask = m_slots.size() - 1;
+                    for (const auto& s : old_slots) {
+                        if (s.id != 0) {
+                            std::size_t pos = s.hash & m_mask;
+                            while (m_slots[pos].id != 0) {
+                                pos = (pos + 1) & m_mask;
+                            }
+                            m_slots[pos] = s;
+                        }
+                    }
+                }
 
             public:
 
@@ -259,40 +299,115 @@ namespace osmium {
 
                 explicit StringTable(size_t size = default_stringtable_chunk_size, size_t bucket_count = min_bucket_count) :
                     m_strings(size),
-                    m_index(bucket_count) {
-                    m_strings.add("");
+                    m_slots(initial_capacity(bucket_count)),
+                    m_mask(m_slots.size() - 1) {
+                    m_strings_by_id.push_back(m_strings.add("", 0));
+                    m_lengths.push_back(0);
+                    m_counts.push_back(0);
                 }
 
                 int32_t size() const noexcept {
-                    return m_size + 1;
+                    return static_cast<int32_t>(m_strings_by_id.size());
                 }
 
                 std::size_t get_bucket_count() const noexcept {
-                    return m_index.bucket_count();
+                    return m_slots.size();
+                }
+
+                /// Memory used by the string table in bytes (approximately).
+                std::size_t used_memory() const noexcept {
+                    return m_strings.used_memory() +
+                           m_strings_by_id.capacity() * sizeof(const char*) +
+                           (m_lengths.capacity() + m_counts.capacity()) * sizeof(uint32_t) +
+                           m_slots.capacity() * sizeof(slot);
                 }
 
                 int32_t add(const char* s) {
-                    const auto f = m_index.find(s);
-                    if (f != m_index.end()) {
-                        return f->second;
+                    const std::size_t length = std::strlen(s);
+                    const auto hash = static_cast<uint32_t>(osmium::detail::string_hash(s, length));
+
+                    std::size_t pos = hash & m_mask;
+                    while (m_slots[pos].id != 0) {
+                        const int32_t id = m_slots[pos].id;
+                        if (m_slots[pos].hash == hash &&
+                            m_lengths[id] == length &&
+                            std::memcmp(m_strings_by_id[id], s, length) == 0) {
+                            ++m_counts[id];
+                            return id;
+                        }
+                        pos = (pos + 1) & m_mask;
                     }
 
-                    const char* cs = m_strings.add(s);
-                    m_index[cs] = ++m_size;
-
-                    if (m_size > max_entries) {
+                    const int32_t id = size();
+                    if (id > max_entries) {
                         throw osmium::pbf_error{"string table has too many entries"};
                     }
 
-                    return m_size;
+                    m_strings_by_id.push_back(m_strings.add(s, length));
+                    m_lengths.push_back(static_cast<uint32_t>(length));
+                    m_counts.push_back(1);
+                    m_slots[pos].hash = hash;
+                    m_slots[pos].id = id;
+
+                    if (m_strings_by_id.size() * 4 > m_slots.size() * 3) {
+                        grow();
+                    }
+
+                    return id;
+                }
+
+                /**
+                 * Reorder the ids so that the strings that were added most
+                 * often get the smallest ids and, when written out as
+                 * varints, need the fewest bytes. Strings with the same
+                 * count keep their order. The empty string stays at id 0.
+                 *
+                 * @returns Vector mapping old ids to new ids.
+                 */
+                std::vector<int32_t> reorder_by_frequency() {
+                    const std::size_t num = m_strings_by_id.size();
+
+                    std::vector<int32_t> order;
+                    order.reserve(num - 1);
+                    for (std::size_t id = 1; id < num; ++id) {
+                        order.push_back(static_cast<int32_t>(id));
+                    }
+                    std::stable_sort(order.begin(), order.end(), [this](int32_t a, int32_t b) {
+                        return m_counts[a] > m_counts[b];
+                    });
+
+                    std::vector<int32_t> new_ids(num, 0);
+                    std::vector<const char*> strings(1, m_strings_by_id[0]);
+                    std::vector<uint32_t> lengths(1, 0);
+                    std::vector<uint32_t> counts(1, 0);
+                    strings.reserve(num);
+                    lengths.reserve(num);
+                    counts.reserve(num);
+                    for (const int32_t id : order) {
+                        new_ids[id] = static_cast<int32_t>(strings.size());
+                        strings.push_back(m_strings_by_id[id]);
+                        lengths.push_back(m_lengths[id]);
+                        counts.push_back(m_counts[id]);
+                    }
+
+                    using std::swap;
+                    swap(strings, m_strings_by_id);
+                    swap(lengths, m_lengths);
+                    swap(counts, m_counts);
+
+                    for (auto& s : m_slots) {
+                        s.id = new_ids[s.id];
+                    }
+
+                    return new_ids;
                 }
 
-                StringStore::const_iterator begin() const {
-                    return m_strings.begin();
+                std::vector<const char*>::const_iterator begin() const {
+                    return m_strings_by_id.cbegin();
                 }
 
-                StringStore::const_iterator end() const {
-                    return m_strings.end();
+                std::vector<const char*>::const_iterator end() const {
+                    return m_strings_by_id.cend();
                 }
 
             }; // class StringTable
@@ -201,12 +201,61 @@ namespace osmium {
                 out += hex_digits[ value         & 0xfU];
             }
 
+            /**
+             * Is this an ASCII character that can go into an OPL file
+             * without escaping? This must agree with the list of code
+             * points in append_utf8_encoded_string().
+             */
+            inline bool is_opl_plain_ascii(char c) noexcept {
+                return c >= 0x21 && c <= 0x7e && c != '%' && c != ',' && c != '=' && c != '@';
+            }
+
+            /**
+             * Is this a character that needs to be escaped in XML
+             * attribute values or text?
+             */
+            inline bool is_xml_special_char(char c) noexcept {
+                switch (c) {
+                    case '\0':
+                    case '&':
+                    case '\"':
+                    case '\'':
+                    case '<':
+                    case '>':
+                    case '\n':
+                    case '\r':
+                    case '\t':
+                        return true;
+                    default:
+                        break;
+                }
+                return false;
+            }
+
+            /**
+             * Is this a character that needs to be escaped in JSON strings?
+             */
+            inline bool is_json_special_char(char c) noexcept {
+                return static_cast<unsigned char>(c) < 0x20 || c == '\"' || c == '\\';
+            }
+
             inline void append_utf8_encoded_string(std::string& out, const char* data) {
                 static const char* lookup_hex = "0123456789abcdef";
                 assert(data);
                 const char* end_ptr = data + std::strlen(data);
 
                 while (data != end_ptr) {
+                    // Most strings are mostly ASCII, so copy runs of
+                    // characters that don't need escaping in one go.
+                    const char* span = data;
+                    while (data != end_ptr && is_opl_plain_ascii(*data)) {
+                        ++data;
+                    }
+                    out.append(span, data);
+                    if (data == end_ptr) {
+                        break;
+                    }
+
                     const char* prev = data;
                     const uint32_t c = next_utf8_codepoint(&data, end_ptr);
 
@@ -238,8 +287,14 @@ namespace osmium {
 
             inline void append_xml_encoded_string(std::string& out, const char* data) {
                 assert(data);
-                for (; *data != '\0'; ++data) {
+                while (true) {
+                    const char* span = data;
+                    while (!is_xml_special_char(*data)) {
+                        ++data;
+                    }
+                    out.append(span, data);
                     switch (*data) {
+                        case '\0': return;
                         case '&':  out += "&amp;";  break;
                         case '\"': out += "&quot;"; break;
                         case '\'': out += "&apos;"; break;
@@ -247,9 +302,34 @@ namespace osmium {
                         case '>':  out += "&gt;";   break;
                         case '\n': out += "&#xA;";  break;
                         case '\r': out += "&#xD;";  break;
-                        case '\t': out += "&#x9;";  break;
-                        default:   out += *data;    break;
+                        default:   out += "&#x9;";  break; // '\t'
+                    }
+                    ++data;
+                }
+            }
+
+            inline void append_json_encoded_string(std::string& out, const char* data) {
+                static const char* lookup_hex = "0123456789abcdef";
+                assert(data);
+                while (true) {
+                    const char* span = data;
+                    while (!is_json_special_char(*data)) {
+                        ++data;
+                    }
+                    out.append(span, data);
+                    switch (*data) {
+                        case '\0': return;
+                        case '\"': out += "\\\""; break;
+                        case '\\': out += "\\\\"; break;
+                        case '\n': out += "\\n";  break;
+                        case '\r': out += "\\r";  break;
+                        case '\t': out += "\\t";  break;
+                        default:
+                            out += "\\u00";
+                            append_2_hex_digits(out, static_cast<unsigned char>(*data), lookup_hex);
+                            break;
                     }
+                    ++data;
                 }
             }
 
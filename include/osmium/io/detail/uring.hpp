@@ -0,0 +1,283 @@
+#ifndef OSMIUM_IO_DETAIL_URING_HPP
+#define OSMIUM_IO_DETAIL_URING_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#ifdef __linux__
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <sys/syscall.h>
+# include <sys/uio.h>
+# include <unistd.h>
+# ifdef __has_include
+#  if __has_include(<linux/io_uring.h>)
+#   include <linux/io_uring.h>
+#   if defined(SYS_io_uring_setup) && defined(SYS_io_uring_enter)
+#    define OSMIUM_WITH_IO_URING
+#   endif
+#  endif
+# endif
+#endif
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+#ifdef OSMIUM_WITH_IO_URING
+
+            /**
+             * Minimal wrapper around a Linux io_uring submission and
+             * completion queue. The io_uring system calls are used
+             * directly, so liburing is not needed. Used by UringReader
+             * and UringWriter.
+             */
+            class Uring {
+
+                int m_ring_fd = -1;
+
+                void* m_sq_ptr = MAP_FAILED;
+                std::size_t m_sq_size = 0;
+                void* m_cq_ptr = MAP_FAILED;
+                std::size_t m_cq_size = 0;
+                struct io_uring_sqe* m_sqes = static_cast<struct io_uring_sqe*>(MAP_FAILED);
+                std::size_t m_sqes_size = 0;
+
+                unsigned* m_sq_tail = nullptr;
+                unsigned* m_sq_mask = nullptr;
+                unsigned* m_sq_array = nullptr;
+                unsigned* m_cq_head = nullptr;
+                unsigned* m_cq_tail = nullptr;
+                unsigned* m_cq_mask = nullptr;
+                struct io_uring_cqe* m_cqes = nullptr;
+
+                // Number of queued entries not yet submitted to the kernel.
+                unsigned m_to_submit = 0;
+
+                static void* map_ring(int fd, std::size_t size, off_t offset) noexcept {
+                    return ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+                }
+
+                template <typename T>
+                T* ring_ptr(void* base, uint32_t offset) const noexcept {
+                    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+                }
+
+                void setup_ring(unsigned entries) {
+                    struct io_uring_params params; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+                    std::memset(&params, 0, sizeof(params));
+
+                    m_ring_fd = static_cast<int>(::syscall(SYS_io_uring_setup, entries, &params));
+                    if (m_ring_fd < 0) {
+                        throw std::system_error{errno, std::system_category(), "io_uring_setup failed"};
+                    }
+
+                    m_sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                    m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+                    bool single_mmap = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+                    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+                        single_mmap = true;
+                        m_sq_size = m_cq_size = std::max(m_sq_size, m_cq_size);
+                    }
+#endif
+
+                    m_sq_ptr = map_ring(m_ring_fd, m_sq_size, IORING_OFF_SQ_RING);
+                    if (m_sq_ptr == MAP_FAILED) {
+                        throw std::system_error{errno, std::system_category(), "mmap of io_uring failed"};
+                    }
+
+                    if (single_mmap) {
+                        m_cq_ptr = m_sq_ptr;
+                    } else {
+                        m_cq_ptr = map_ring(m_ring_fd, m_cq_size, IORING_OFF_CQ_RING);
+                        if (m_cq_ptr == MAP_FAILED) {
+                            throw std::system_error{errno, std::system_category(), "mmap of io_uring failed"};
+                        }
+                    }
+
+                    m_sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+                    m_sqes = static_cast<struct io_uring_sqe*>(map_ring(m_ring_fd, m_sqes_size, IORING_OFF_SQES));
+                    if (m_sqes == MAP_FAILED) {
+                        throw std::system_error{errno, std::system_category(), "mmap of io_uring failed"};
+                    }
+
+                    m_sq_tail  = ring_ptr<unsigned>(m_sq_ptr, params.sq_off.tail);
+                    m_sq_mask  = ring_ptr<unsigned>(m_sq_ptr, params.sq_off.ring_mask);
+                    m_sq_array = ring_ptr<unsigned>(m_sq_ptr, params.sq_off.array);
+                    m_cq_head  = ring_ptr<unsigned>(m_cq_ptr, params.cq_off.head);
+                    m_cq_tail  = ring_ptr<unsigned>(m_cq_ptr, params.cq_off.tail);
+                    m_cq_mask  = ring_ptr<unsigned>(m_cq_ptr, params.cq_off.ring_mask);
+                    m_cqes     = ring_ptr<struct io_uring_cqe>(m_cq_ptr, params.cq_off.cqes);
+                }
+
+                void release() noexcept {
+                    if (m_sqes != MAP_FAILED) {
+                        ::munmap(m_sqes, m_sqes_size);
+                    }
+                    if (m_cq_ptr != MAP_FAILED && m_cq_ptr != m_sq_ptr) {
+                        ::munmap(m_cq_ptr, m_cq_size);
+                    }
+                    if (m_sq_ptr != MAP_FAILED) {
+                        ::munmap(m_sq_ptr, m_sq_size);
+                    }
+                    if (m_ring_fd >= 0) {
+                        ::close(m_ring_fd);
+                    }
+                }
+
+            public:
+
+                /**
+                 * Set up the ring.
+                 *
+                 * @param entries Number of entries in the submission queue.
+                 * @throws std::system_error If io_uring is not available.
+                 */
+                explicit Uring(unsigned entries) {
+                    try {
+                        setup_ring(entries);
+                    } catch (...) {
+                        release();
+                        throw;
+                    }
+                }
+
+                Uring(const Uring&) = delete;
+                Uring& operator=(const Uring&) = delete;
+
+                Uring(Uring&&) = delete;
+                Uring& operator=(Uring&&) = delete;
+
+                ~Uring() noexcept {
+                    release();
+                }
+
+                /// Number of queued entries not yet submitted to the kernel.
+                unsigned to_submit() const noexcept {
+                    return m_to_submit;
+                }
+
+                /**
+                 * Queue a vectored read or write (opcode IORING_OP_READV
+                 * or IORING_OP_WRITEV) of one iovec at the given offset in
+                 * the file. It is submitted to the kernel with the next
+                 * call to enter(). The iovec must stay valid until then.
+                 */
+                void queue(uint8_t opcode, int fd, const struct iovec* iov, std::size_t offset, uint64_t user_data) noexcept {
+                    const unsigned tail = *m_sq_tail;
+                    const unsigned sq_index = tail & *m_sq_mask;
+                    auto& sqe = m_sqes[sq_index];
+                    std::memset(&sqe, 0, sizeof(sqe));
+                    sqe.opcode = opcode;
+                    sqe.fd = fd;
+                    sqe.off = offset;
+                    sqe.addr = reinterpret_cast<uint64_t>(iov);
+                    sqe.len = 1;
+                    sqe.user_data = user_data;
+                    m_sq_array[sq_index] = sq_index;
+                    __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+                    ++m_to_submit;
+                }
+
+                /**
+                 * Submit all queued entries to the kernel and wait until
+                 * at least min_complete entries have completed.
+                 *
+                 * @throws std::system_error If the system call failed.
+                 */
+                void enter(unsigned min_complete) {
+                    while (m_to_submit > 0 || min_complete > 0) {
+                        const auto result = ::syscall(SYS_io_uring_enter, m_ring_fd, m_to_submit, min_complete,
+                                                      min_complete > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+                        if (result < 0) {
+                            if (errno == EINTR || errno == EAGAIN) {
+                                continue;
+                            }
+                            throw std::system_error{errno, std::system_category(), "io_uring_enter failed"};
+                        }
+                        m_to_submit -= static_cast<unsigned>(result);
+                        min_complete = 0;
+                    }
+                }
+
+                /**
+                 * Call func(user_data, result) for all entries in the
+                 * completion queue and remove them from the queue.
+                 */
+                template <typename TFunc>
+                void reap(TFunc&& func) {
+                    unsigned head = *m_cq_head;
+                    const unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+                    while (head != tail) {
+                        const auto& cqe = m_cqes[head & *m_cq_mask];
+                        const uint64_t user_data = cqe.user_data;
+                        const int result = cqe.res;
+                        ++head;
+                        __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+                        std::forward<TFunc>(func)(user_data, result);
+                    }
+                }
+
+            }; // class Uring
+
+            /**
+             * Should the file be read or written with io_uring? Only
+             * regular files are accessed this way.
+             */
+            inline bool can_use_io_uring(int fd) noexcept {
+                struct stat file_stat; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+                return fd >= 0 && ::fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode);
+            }
+
+#endif // OSMIUM_WITH_IO_URING
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_URING_HPP
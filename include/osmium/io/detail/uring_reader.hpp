@@ -0,0 +1,297 @@
+#ifndef OSMIUM_IO_DETAIL_URING_READER_HPP
+#define OSMIUM_IO_DETAIL_URING_READER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/uring.hpp>
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+#ifdef OSMIUM_WITH_IO_URING
+
+            /**
+             * Reads a file sequentially using the Linux io_uring interface
+             * with several reads in flight at the same time. This keeps
+             * the storage busy while the data is being decompressed and
+             * parsed. The file can optionally be read with O_DIRECT, which
+             * bypasses the page cache. This is useful for large files
+             * which are only read once.
+             *
+             * The io_uring system calls are used directly, so liburing is
+             * not needed.
+             */
+            class UringReader {
+
+                struct request {
+                    char* data = nullptr;
+                    std::size_t offset = 0;
+                    std::size_t filled = 0;
+                    struct iovec iov{};
+                    int error = 0;
+                    bool in_use = false;
+                    bool done = false;
+                };
+
+                int m_fd;
+                std::size_t m_block_size;
+                bool m_direct = false;
+
+                Uring m_ring;
+
+                std::vector<request> m_requests;
+                char* m_memory = nullptr;
+
+                // The request with the next data to be returned.
+                std::size_t m_first = 0;
+
+                // Offset of the next read in the file.
+                std::size_t m_next_offset;
+
+                // Number of requests in flight (including those not yet
+                // submitted to the kernel).
+                std::size_t m_in_flight = 0;
+
+                bool m_eof = false;
+
+                // Queue a read for the (rest of the) given request. It is
+                // submitted to the kernel with the next call to enter().
+                void queue_read(std::size_t index) {
+                    auto& req = m_requests[index];
+                    req.iov.iov_base = req.data + req.filled;
+                    req.iov.iov_len = m_block_size - req.filled;
+
+                    m_ring.queue(IORING_OP_READV, m_fd, &req.iov, req.offset + req.filled, index);
+                    ++m_in_flight;
+                }
+
+                // Handle the result of one completed read.
+                void complete(std::size_t index, int result) {
+                    auto& req = m_requests[index];
+                    --m_in_flight;
+
+                    if (result < 0) {
+                        if (result == -EINTR || result == -EAGAIN) {
+                            queue_read(index);
+                            return;
+                        }
+                        if (result == -EINVAL && m_direct) {
+                            // Some file systems don't support O_DIRECT,
+                            // fall back to normal reads.
+                            m_direct = false;
+                            ::fcntl(m_fd, F_SETFL, ::fcntl(m_fd, F_GETFL) & ~O_DIRECT);
+                            queue_read(index);
+                            return;
+                        }
+                        req.error = -result;
+                        req.done = true;
+                        m_eof = true;
+                        return;
+                    }
+
+                    if (result == 0) {
+                        req.done = true;
+                        m_eof = true;
+                        return;
+                    }
+
+                    req.filled += static_cast<std::size_t>(result);
+                    if (req.filled == m_block_size) {
+                        req.done = true;
+                    } else if (m_direct) {
+                        // With O_DIRECT short reads only happen at the
+                        // end of the file.
+                        req.done = true;
+                        m_eof = true;
+                    } else {
+                        queue_read(index);
+                    }
+                }
+
+                void reap_completions() {
+                    m_ring.reap([this](uint64_t index, int result) {
+                        complete(static_cast<std::size_t>(index), result);
+                    });
+                }
+
+                // Start reads for all free requests.
+                void fill() {
+                    if (m_eof) {
+                        return;
+                    }
+                    for (std::size_t n = 0; n < m_requests.size(); ++n) {
+                        const auto index = (m_first + n) % m_requests.size();
+                        auto& req = m_requests[index];
+                        if (!req.in_use) {
+                            req.in_use = true;
+                            req.offset = m_next_offset;
+                            m_next_offset += m_block_size;
+                            queue_read(index);
+                        }
+                    }
+                }
+
+            public:
+
+                enum : std::size_t {
+                    default_queue_depth = 8,
+                    max_queue_depth = 64,
+
+                    // Alignment needed for O_DIRECT.
+                    alignment = 4096
+                };
+
+                /**
+                 * Set up reading from the file.
+                 *
+                 * @param fd File descriptor of a regular file.
+                 * @param block_size Size of each read. Must be a multiple
+                 *                   of 4096 if direct is set.
+                 * @param queue_depth Number of reads in flight.
+                 * @param direct Read with O_DIRECT if possible.
+                 * @throws std::system_error If io_uring is not available.
+                 */
+                UringReader(int fd, std::size_t block_size, std::size_t queue_depth, bool direct) :
+                    m_fd(fd),
+                    m_block_size(block_size),
+                    m_ring(static_cast<unsigned>(queue_depth)),
+                    m_requests(queue_depth),
+                    m_next_offset(0) {
+                    assert(queue_depth > 0);
+
+                    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc,hicpp-no-malloc)
+                    if (::posix_memalign(reinterpret_cast<void**>(&m_memory), alignment, block_size * queue_depth) != 0) {
+                        throw std::bad_alloc{};
+                    }
+                    for (std::size_t i = 0; i < queue_depth; ++i) {
+                        m_requests[i].data = m_memory + i * block_size;
+                    }
+
+                    const auto pos = ::lseek(fd, 0, SEEK_CUR);
+                    if (pos > 0) {
+                        m_next_offset = static_cast<std::size_t>(pos);
+                    }
+
+                    if (direct && block_size % alignment == 0 && m_next_offset % alignment == 0) {
+                        const int flags = ::fcntl(fd, F_GETFL);
+                        m_direct = flags != -1 && ::fcntl(fd, F_SETFL, flags | O_DIRECT) == 0;
+                    }
+                }
+
+                UringReader(const UringReader&) = delete;
+                UringReader& operator=(const UringReader&) = delete;
+
+                UringReader(UringReader&&) = delete;
+                UringReader& operator=(UringReader&&) = delete;
+
+                ~UringReader() noexcept {
+                    // The kernel might still write into the buffers, so
+                    // wait for all reads in flight before releasing them.
+                    try {
+                        while (m_in_flight > m_ring.to_submit()) {
+                            m_ring.enter(1);
+                            m_ring.reap([this](uint64_t /*index*/, int /*result*/) {
+                                --m_in_flight;
+                            });
+                        }
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                    std::free(m_memory); // NOLINT(cppcoreguidelines-no-malloc,hicpp-no-malloc)
+                }
+
+                /// Is the file read with O_DIRECT?
+                bool direct() const noexcept {
+                    return m_direct;
+                }
+
+                /**
+                 * Read the next block from the file.
+                 *
+                 * @returns The data, an empty string at the end of the
+                 *          file.
+                 * @throws std::system_error If a read failed.
+                 */
+                std::string read() {
+                    fill();
+                    m_ring.enter(0);
+
+                    auto& req = m_requests[m_first];
+                    if (!req.in_use) {
+                        return std::string{};
+                    }
+
+                    while (!req.done) {
+                        m_ring.enter(1);
+                        reap_completions();
+                        m_ring.enter(0);
+                    }
+
+                    if (req.error != 0) {
+                        throw std::system_error{req.error, std::system_category(), "Read failed"};
+                    }
+
+                    std::string data(req.data, req.filled);
+
+                    req.in_use = false;
+                    req.done = false;
+                    req.filled = 0;
+                    m_first = (m_first + 1) % m_requests.size();
+
+                    return data;
+                }
+
+            }; // class UringReader
+
+#endif // OSMIUM_WITH_IO_URING
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_URING_READER_HPP
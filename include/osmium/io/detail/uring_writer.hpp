@@ -0,0 +1,376 @@
+#ifndef OSMIUM_IO_DETAIL_URING_WRITER_HPP
+#define OSMIUM_IO_DETAIL_URING_WRITER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+
+#include <osmium/io/detail/uring.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <system_error>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+#ifdef OSMIUM_WITH_IO_URING
+
+            /**
+             * Writes a file sequentially using the Linux io_uring interface
+             * with several writes in flight at the same time. The data is
+             * collected into aligned blocks which are handed to the kernel
+             * without waiting for the previous writes to finish, so a slow
+             * disk doesn't hold up the thread producing the data until all
+             * blocks are in use. The file can optionally be written with
+             * O_DIRECT, which bypasses the page cache. Otherwise writeback
+             * of the data written so far is started regularly (using
+             * sync_file_range(2)), so that dirty pages don't pile up until
+             * the file is closed.
+             *
+             * Call flush() after the last write, data still in the buffers
+             * is discarded when the object is destroyed.
+             */
+            class UringWriter {
+
+                struct request {
+                    char* data = nullptr;
+                    std::size_t offset = 0;
+                    std::size_t size = 0;
+                    std::size_t written = 0;
+                    struct iovec iov{};
+                    bool in_flight = false;
+                };
+
+                int m_fd;
+                std::size_t m_block_size;
+                bool m_direct = false;
+
+                Uring m_ring;
+
+                std::vector<request> m_requests;
+                char* m_memory = nullptr;
+
+                // The request currently being filled.
+                std::size_t m_current = 0;
+
+                // Offset in the file of the block currently being filled.
+                std::size_t m_next_offset = 0;
+
+                // Offset up to which writeback has been started.
+                std::size_t m_writeback_offset = 0;
+
+                // Number of requests in flight (including those not yet
+                // submitted to the kernel).
+                std::size_t m_in_flight = 0;
+
+                // First error reported by a write.
+                int m_error = 0;
+
+                // Queue a write for the (rest of the) given request. It is
+                // submitted to the kernel with the next call to enter().
+                void queue_write(std::size_t index) {
+                    auto& req = m_requests[index];
+                    req.iov.iov_base = req.data + req.written;
+                    req.iov.iov_len = req.size - req.written;
+
+                    m_ring.queue(IORING_OP_WRITEV, m_fd, &req.iov, req.offset + req.written, index);
+                    ++m_in_flight;
+                }
+
+                void disable_direct() noexcept {
+                    m_direct = false;
+                    ::fcntl(m_fd, F_SETFL, ::fcntl(m_fd, F_GETFL) & ~O_DIRECT);
+                }
+
+                // Handle the result of one completed write.
+                void complete(std::size_t index, int result) {
+                    auto& req = m_requests[index];
+                    --m_in_flight;
+
+                    if (result < 0) {
+                        if (result == -EINTR || result == -EAGAIN) {
+                            queue_write(index);
+                            return;
+                        }
+                        if (result == -EINVAL && m_direct) {
+                            // Some file systems don't support O_DIRECT,
+                            // fall back to normal writes.
+                            disable_direct();
+                            queue_write(index);
+                            return;
+                        }
+                        if (m_error == 0) {
+                            m_error = -result;
+                        }
+                        req.in_flight = false;
+                        return;
+                    }
+
+                    if (result == 0) {
+                        if (m_error == 0) {
+                            m_error = EIO;
+                        }
+                        req.in_flight = false;
+                        return;
+                    }
+
+                    req.written += static_cast<std::size_t>(result);
+                    if (req.written < req.size) {
+                        queue_write(index);
+                    } else {
+                        req.in_flight = false;
+                    }
+                }
+
+                void reap_completions() {
+                    m_ring.reap([this](uint64_t index, int result) {
+                        complete(static_cast<std::size_t>(index), result);
+                    });
+                }
+
+                // All data before this offset in the file has been
+                // written.
+                std::size_t written_offset() const noexcept {
+                    std::size_t offset = m_next_offset;
+                    for (const auto& req : m_requests) {
+                        if (req.in_flight) {
+                            offset = std::min(offset, req.offset);
+                        }
+                    }
+                    return offset;
+                }
+
+                // Start writeback of the data written since the last
+                // call. This doesn't wait for the writeback to finish.
+                void start_writeback() noexcept {
+                    if (m_direct) {
+                        return;
+                    }
+                    const auto offset = written_offset();
+                    if (offset >= m_writeback_offset + writeback_interval) {
+#ifdef SYNC_FILE_RANGE_WRITE
+                        ::sync_file_range(m_fd, static_cast<off_t>(m_writeback_offset),
+                                          static_cast<off_t>(offset - m_writeback_offset), SYNC_FILE_RANGE_WRITE);
+#endif
+                        m_writeback_offset = offset;
+                    }
+                }
+
+                void wait_for_completion() {
+                    m_ring.enter(1);
+                    reap_completions();
+                    m_ring.enter(0);
+                    start_writeback();
+                }
+
+                void check_error() const {
+                    if (m_error != 0) {
+                        throw std::system_error{m_error, std::system_category(), "Write failed"};
+                    }
+                }
+
+                // Hand the block currently being filled to the kernel and
+                // wait until the next block is available.
+                void submit_current() {
+                    auto& req = m_requests[m_current];
+                    req.offset = m_next_offset;
+                    req.written = 0;
+                    req.in_flight = true;
+                    m_next_offset += req.size;
+                    queue_write(m_current);
+                    m_ring.enter(0);
+
+                    m_current = (m_current + 1) % m_requests.size();
+                    while (m_requests[m_current].in_flight) {
+                        wait_for_completion();
+                    }
+                    m_requests[m_current].size = 0;
+                }
+
+            public:
+
+                enum : std::size_t {
+                    default_block_size = 1024UL * 1024UL,
+                    default_queue_depth = 8,
+                    max_queue_depth = 64,
+
+                    // Alignment needed for O_DIRECT.
+                    alignment = 4096,
+
+                    // Writeback is started whenever this many bytes
+                    // have been written.
+                    writeback_interval = 8UL * 1024UL * 1024UL
+                };
+
+                /**
+                 * Set up writing to the file. Writing starts at the
+                 * current file offset.
+                 *
+                 * @param fd File descriptor of a regular file. Must not
+                 *           be opened with O_APPEND.
+                 * @param block_size Size of each write. Must be a multiple
+                 *                   of 4096 if direct is set.
+                 * @param queue_depth Number of writes in flight.
+                 * @param direct Write with O_DIRECT if possible.
+                 * @throws std::system_error If io_uring is not available.
+                 */
+                UringWriter(int fd, std::size_t block_size, std::size_t queue_depth, bool direct) :
+                    m_fd(fd),
+                    m_block_size(block_size),
+                    m_ring(static_cast<unsigned>(queue_depth)),
+                    m_requests(queue_depth) {
+                    assert(block_size > 0);
+                    assert(queue_depth > 0);
+
+                    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc,hicpp-no-malloc)
+                    if (::posix_memalign(reinterpret_cast<void**>(&m_memory), alignment, block_size * queue_depth) != 0) {
+                        throw std::bad_alloc{};
+                    }
+                    for (std::size_t i = 0; i < queue_depth; ++i) {
+                        m_requests[i].data = m_memory + i * block_size;
+                    }
+
+                    const auto pos = ::lseek(fd, 0, SEEK_CUR);
+                    if (pos > 0) {
+                        m_next_offset = static_cast<std::size_t>(pos);
+                        m_writeback_offset = m_next_offset;
+                    }
+
+                    if (direct && block_size % alignment == 0 && m_next_offset % alignment == 0) {
+                        const int flags = ::fcntl(fd, F_GETFL);
+                        m_direct = flags != -1 && ::fcntl(fd, F_SETFL, flags | O_DIRECT) == 0;
+                    }
+                }
+
+                UringWriter(const UringWriter&) = delete;
+                UringWriter& operator=(const UringWriter&) = delete;
+
+                UringWriter(UringWriter&&) = delete;
+                UringWriter& operator=(UringWriter&&) = delete;
+
+                ~UringWriter() noexcept {
+                    // The kernel might still read from the buffers, so
+                    // wait for all writes in flight before releasing them.
+                    try {
+                        while (m_in_flight > m_ring.to_submit()) {
+                            m_ring.enter(1);
+                            m_ring.reap([this](uint64_t /*index*/, int /*result*/) {
+                                --m_in_flight;
+                            });
+                        }
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                    std::free(m_memory); // NOLINT(cppcoreguidelines-no-malloc,hicpp-no-malloc)
+                }
+
+                /// Is the file written with O_DIRECT?
+                bool direct() const noexcept {
+                    return m_direct;
+                }
+
+                /**
+                 * Write data to the file. The data is copied into the
+                 * buffers, the write to the file happens in the background
+                 * once a block is full.
+                 *
+                 * @throws std::system_error If an earlier write failed.
+                 */
+                void write(const char* data, std::size_t size) {
+                    check_error();
+                    while (size > 0) {
+                        auto& req = m_requests[m_current];
+                        const auto count = std::min(size, m_block_size - req.size);
+                        std::memcpy(req.data + req.size, data, count);
+                        req.size += count;
+                        data += count;
+                        size -= count;
+                        if (req.size == m_block_size) {
+                            submit_current();
+                        }
+                    }
+                    reap_completions();
+                }
+
+                /**
+                 * Write out all data in the buffers and wait until all
+                 * writes are finished. Afterwards the file offset is at
+                 * the end of the data written.
+                 *
+                 * @throws std::system_error If a write failed.
+                 */
+                void flush() {
+                    auto& req = m_requests[m_current];
+                    if (req.size > 0 && m_error == 0) {
+                        if (m_direct && req.size % alignment != 0) {
+                            // The last block is not a multiple of the
+                            // alignment and can not be written with
+                            // O_DIRECT.
+                            while (m_in_flight > 0) {
+                                wait_for_completion();
+                            }
+                            disable_direct();
+                        }
+                        submit_current();
+                    }
+                    while (m_in_flight > 0) {
+                        wait_for_completion();
+                    }
+                    check_error();
+
+                    if (::lseek(m_fd, static_cast<off_t>(m_next_offset), SEEK_SET) < 0) {
+                        throw std::system_error{errno, std::system_category(), "Seek failed"};
+                    }
+                }
+
+            }; // class UringWriter
+
+#endif // OSMIUM_WITH_IO_URING
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_URING_WRITER_HPP
@@ -35,7 +35,11 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/serial_task.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/tracepoint.hpp>
 
 #include <exception>
 #include <future>
@@ -60,17 +64,42 @@ namespace osmium {
                 std::unique_ptr<osmium::io::Compressor> m_compressor;
                 std::promise<std::size_t> m_promise;
                 std::atomic_bool* m_notification;
+                stage_counter* m_counter;
+                bool m_finished = false;
+
+                void write(const std::string& data) {
+                    const auto start = stage_counter::clock::now();
+                    m_compressor->write(data);
+                    OSMIUM_TRACEPOINT1(write_done, data.size());
+                    if (m_counter) {
+                        m_counter->add_busy_time(start);
+                        m_counter->add(data.size());
+                    }
+                }
+
+                void done() {
+                    m_compressor->close();
+                    m_promise.set_value(m_compressor->file_size());
+                }
+
+                void failed() {
+                    m_notification->store(true);
+                    m_promise.set_exception(std::current_exception());
+                    m_queue.shutdown();
+                }
 
             public:
 
                 WriteThread(future_string_queue_type& input_queue,
                             std::unique_ptr<osmium::io::Compressor>&& compressor,
                             std::promise<std::size_t>&& promise,
-                            std::atomic_bool* notification) :
+                            std::atomic_bool* notification,
+                            stage_counter* counter = nullptr) :
                     m_queue(input_queue),
                     m_compressor(std::move(compressor)),
                     m_promise(std::move(promise)),
-                    m_notification(notification) {
+                    m_notification(notification),
+                    m_counter(counter) {
                 }
 
                 WriteThread(const WriteThread&) = delete;
@@ -90,19 +119,91 @@ namespace osmium {
                             if (at_end_of_data(data)) {
                                 break;
                             }
-                            m_compressor->write(data);
+                            write(data);
+                        }
+                        done();
+                    } catch (...) {
+                        failed();
+                    }
+                }
+
+                /**
+                 * Write the next block of data from the queue if there is
+                 * one. Used instead of operator() when writing in tasks.
+                 * Returns false if there is nothing more to do right now.
+                 */
+                bool write_step() {
+                    if (m_finished) {
+                        return false;
+                    }
+
+                    try {
+                        std::string data;
+                        if (!m_queue.try_pop(data)) {
+                            return false;
                         }
-                        m_compressor->close();
-                        m_promise.set_value(m_compressor->file_size());
+                        if (at_end_of_data(data)) {
+                            m_finished = true;
+                            done();
+                            return false;
+                        }
+                        write(data);
                     } catch (...) {
-                        m_notification->store(true);
-                        m_promise.set_exception(std::current_exception());
-                        m_queue.shutdown();
+                        m_finished = true;
+                        failed();
+                        return false;
                     }
+
+                    return true;
                 }
 
             }; // class WriteThread
 
+            /**
+             * Does the same as the WriteThread, but in tasks on a pool which
+             * are scheduled whenever new data is added to the queue.
+             */
+            class WriteTask {
+
+                WriteThread m_writer;
+                osmium::thread::SerialTask m_task;
+
+            public:
+
+                WriteTask(future_string_queue_type& input_queue,
+                          std::unique_ptr<osmium::io::Compressor>&& compressor,
+                          std::promise<std::size_t>&& promise,
+                          std::atomic_bool* notification,
+                          stage_counter* counter,
+                          osmium::thread::Pool& executor) :
+                    m_writer(input_queue, std::move(compressor), std::move(promise), notification, counter),
+                    m_task(executor, [this]() {
+                        return m_writer.write_step();
+                    }) {
+                    input_queue.set_notifications([this]() {
+                        m_task.schedule();
+                    }, nullptr);
+                }
+
+                WriteTask(const WriteTask&) = delete;
+                WriteTask& operator=(const WriteTask&) = delete;
+
+                WriteTask(WriteTask&&) = delete;
+                WriteTask& operator=(WriteTask&&) = delete;
+
+                // The end of data marker is already in the queue when this
+                // is called, so wait until everything is written.
+                ~WriteTask() noexcept {
+                    try {
+                        m_task.wait_until_idle();
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                    m_task.stop();
+                }
+
+            }; // class WriteTask
+
         } // namespace detail
 
     } // namespace io
@@ -0,0 +1,364 @@
+#ifndef OSMIUM_IO_DETAIL_XML_CHUNK_SPLITTER_HPP
+#define OSMIUM_IO_DETAIL_XML_CHUNK_SPLITTER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/item_type.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Splits an OSM XML (or OSM change) document into chunks that
+             * can be parsed independently. This is used for parsing XML
+             * files in several threads.
+             *
+             * The splitter only looks at the tag structure of the document,
+             * it doesn't check whether the XML is well-formed, that is left
+             * to the real parser. Chunks are cut between top-level elements
+             * (nodes, ways, relations, and changesets) when they reach the
+             * configured size or when the type of the elements changes. In
+             * OSM change files they are also cut at section boundaries.
+             * Each chunk is wrapped in the root element (and the section
+             * element if needed), so it is a complete document on its own.
+             *
+             * Everything up to the first object (or change section) is the
+             * "prologue" which contains the header information.
+             */
+            class XMLChunkSplitter {
+
+                std::string m_data;
+                std::string m_xml_declaration;
+                std::string m_section;
+
+                std::size_t m_chunk_size;
+                std::size_t m_pos = 0;
+                std::size_t m_chunk_start = 0;
+                std::size_t m_depth = 0;
+
+                osmium::item_type m_type = osmium::item_type::undefined;
+
+                bool m_is_change = false;
+                bool m_prologue_done = false;
+                bool m_root_closed = false;
+
+                enum : std::size_t {
+                    npos = std::string::npos,
+
+                    // Long enough to tell all kinds of tags apart.
+                    min_tag_lookahead = 9
+                };
+
+                bool has_prefix(const std::size_t pos, const char* prefix) const noexcept {
+                    const auto len = std::strlen(prefix);
+                    return m_data.size() - pos >= len && !m_data.compare(pos, len, prefix);
+                }
+
+                std::size_t find_after(const std::size_t pos, const char* str) const noexcept {
+                    const auto found = m_data.find(str, pos);
+                    return found == npos ? npos : found + std::strlen(str);
+                }
+
+                // Find the end of the tag starting at pos. Returns the
+                // position after the closing '>' or npos if the tag is not
+                // complete yet.
+                std::size_t find_tag_end(const std::size_t pos) const noexcept {
+                    if (has_prefix(pos, "<!--")) {
+                        return find_after(pos + 4, "-->");
+                    }
+                    if (has_prefix(pos, "<?")) {
+                        return find_after(pos + 2, "?>");
+                    }
+                    if (has_prefix(pos, "<![CDATA[")) {
+                        return find_after(pos + 9, "]]>");
+                    }
+                    if (has_prefix(pos, "<!")) {
+                        // DOCTYPE, possibly with internal subset
+                        const auto end = m_data.find_first_of("[>", pos);
+                        if (end == npos || m_data[end] == '>') {
+                            return end == npos ? npos : end + 1;
+                        }
+                        return find_after(end, "]>");
+                    }
+
+                    for (std::size_t i = pos + 1; i < m_data.size(); ++i) {
+                        const char c = m_data[i];
+                        if (c == '>') {
+                            return i + 1;
+                        }
+                        if (c == '"' || c == '\'') {
+                            i = m_data.find(c, i + 1);
+                            if (i == npos) {
+                                return npos;
+                            }
+                        }
+                    }
+
+                    return npos;
+                }
+
+                std::string tag_name(std::size_t pos) const {
+                    const auto end = m_data.find_first_of(" \t\r\n/>", pos);
+                    return m_data.substr(pos, end - pos);
+                }
+
+                static osmium::item_type object_type(const std::string& name) noexcept {
+                    if (name == "node") {
+                        return osmium::item_type::node;
+                    }
+                    if (name == "way") {
+                        return osmium::item_type::way;
+                    }
+                    if (name == "relation") {
+                        return osmium::item_type::relation;
+                    }
+                    if (name == "changeset") {
+                        return osmium::item_type::changeset;
+                    }
+                    return osmium::item_type::undefined;
+                }
+
+                template <typename TPrologueFunc>
+                void end_prologue(const std::size_t pos, TPrologueFunc&& prologue_func) {
+                    if (has_prefix(0, "<?xml")) {
+                        m_xml_declaration = m_data.substr(0, find_tag_end(0));
+                    }
+                    std::forward<TPrologueFunc>(prologue_func)(m_data.data(), pos);
+                    m_prologue_done = true;
+                    m_chunk_start = pos;
+                }
+
+                template <typename TChunkFunc>
+                void cut(const std::size_t pos, TChunkFunc&& chunk_func) {
+                    if (m_chunk_start < pos && m_data.find('<', m_chunk_start) < pos) {
+                        const char* root = m_is_change ? "osmChange" : "osm";
+
+                        std::string document;
+                        document.reserve(pos - m_chunk_start + m_xml_declaration.size() + 64);
+                        document += m_xml_declaration;
+                        document += '<';
+                        document += root;
+                        document += " version=\"0.6\">";
+                        if (!m_section.empty()) {
+                            document += '<';
+                            document += m_section;
+                            document += '>';
+                        }
+                        document.append(m_data, m_chunk_start, pos - m_chunk_start);
+                        if (!m_section.empty()) {
+                            document += "</";
+                            document += m_section;
+                            document += '>';
+                        }
+                        document += "</";
+                        document += root;
+                        document += '>';
+
+                        std::forward<TChunkFunc>(chunk_func)(std::move(document), m_type);
+                    }
+                    m_chunk_start = pos;
+                }
+
+                template <typename TPrologueFunc, typename TChunkFunc>
+                void start_tag(const std::size_t pos, const std::size_t end, TPrologueFunc&& prologue_func, TChunkFunc&& chunk_func) {
+                    const bool self_closing = m_data[end - 2] == '/';
+                    const std::size_t depth = m_depth;
+                    if (!self_closing) {
+                        ++m_depth;
+                    }
+
+                    // Tags inside objects (tags, node refs, members,
+                    // changeset discussions) never start a new chunk,
+                    // so don't bother extracting their names.
+                    if (depth > 2 || (depth == 2 && m_section.empty())) {
+                        return;
+                    }
+
+                    const std::string name = tag_name(pos + 1);
+
+                    if (depth == 0) {
+                        m_is_change = (name == "osmChange");
+                        return;
+                    }
+
+                    if (depth == 1 && m_is_change && (name == "create" || name == "modify" || name == "delete")) {
+                        if (m_prologue_done) {
+                            cut(pos, std::forward<TChunkFunc>(chunk_func));
+                        } else {
+                            end_prologue(pos, std::forward<TPrologueFunc>(prologue_func));
+                        }
+                        m_section = self_closing ? "" : name;
+                        m_chunk_start = end;
+                        m_type = osmium::item_type::undefined;
+                        return;
+                    }
+
+                    if (depth == 1 || (depth == 2 && !m_section.empty())) {
+                        const auto type = object_type(name);
+                        if (!m_prologue_done) {
+                            if (type != osmium::item_type::undefined) {
+                                end_prologue(pos, std::forward<TPrologueFunc>(prologue_func));
+                                m_type = type;
+                            }
+                        } else if (type != m_type || pos - m_chunk_start >= m_chunk_size) {
+                            cut(pos, std::forward<TChunkFunc>(chunk_func));
+                            m_type = type;
+                        }
+                    }
+                }
+
+                template <typename TChunkFunc>
+                void end_tag(const std::size_t pos, const std::size_t end, TChunkFunc&& chunk_func) {
+                    if (m_depth == 0) {
+                        return;
+                    }
+                    --m_depth;
+
+                    if (!m_prologue_done) {
+                        if (m_depth == 0) {
+                            m_root_closed = true;
+                        }
+                        return;
+                    }
+
+                    if (m_depth == 0) {
+                        cut(pos, std::forward<TChunkFunc>(chunk_func));
+                        m_chunk_start = end;
+                        m_root_closed = true;
+                    } else if (m_depth == 1 && !m_section.empty()) {
+                        cut(pos, std::forward<TChunkFunc>(chunk_func));
+                        m_chunk_start = end;
+                        m_section.clear();
+                        m_type = osmium::item_type::undefined;
+                    }
+                }
+
+            public:
+
+                explicit XMLChunkSplitter(const std::size_t chunk_size) :
+                    m_chunk_size(chunk_size) {
+                }
+
+                /**
+                 * Add more data from the input.
+                 */
+                void add(const std::string& data) {
+                    m_data += data;
+                }
+
+                /**
+                 * Split all data added so far into chunks.
+                 *
+                 * @param prologue_func Called once with the data and size of
+                 *        the prologue when the first object is found.
+                 * @param chunk_func Called with each complete chunk document
+                 *        and the type of objects in it (or
+                 *        item_type::undefined if the chunk only contains
+                 *        other elements).
+                 * @param last Is this all of the input?
+                 */
+                template <typename TPrologueFunc, typename TChunkFunc>
+                void split(TPrologueFunc&& prologue_func, TChunkFunc&& chunk_func, const bool last = false) {
+                    while (!m_root_closed) {
+                        const auto pos = m_data.find('<', m_pos);
+                        if (pos == npos) {
+                            m_pos = m_data.size();
+                            break;
+                        }
+                        m_pos = pos;
+
+                        if (!last && m_data.size() - pos < min_tag_lookahead) {
+                            break;
+                        }
+
+                        const auto end = find_tag_end(pos);
+                        if (end == npos) {
+                            break;
+                        }
+
+                        if (m_data[pos + 1] == '/') {
+                            end_tag(pos, end, chunk_func);
+                        } else if (m_data[pos + 1] != '!' && m_data[pos + 1] != '?') {
+                            start_tag(pos, end, prologue_func, chunk_func);
+                        }
+                        m_pos = end;
+                    }
+
+                    if (m_prologue_done && m_chunk_start > 0) {
+                        m_data.erase(0, m_chunk_start);
+                        m_pos -= m_chunk_start;
+                        m_chunk_start = 0;
+                    }
+                }
+
+                /**
+                 * Has the prologue been found? If not, there are no objects
+                 * in the data seen so far and all of it is still available
+                 * through data().
+                 */
+                bool prologue_done() const noexcept {
+                    return m_prologue_done;
+                }
+
+                /**
+                 * Has the end tag of the root element been seen?
+                 */
+                bool root_closed() const noexcept {
+                    return m_root_closed;
+                }
+
+                /**
+                 * The data not yet handed out in chunks.
+                 */
+                const std::string& data() const noexcept {
+                    return m_data;
+                }
+
+            }; // class XMLChunkSplitter
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_XML_CHUNK_SPLITTER_HPP
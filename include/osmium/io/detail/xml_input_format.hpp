@@ -37,6 +37,8 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/io/detail/input_format.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/xml_chunk_splitter.hpp>
+#include <osmium/io/detail/xml_tokenizer.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
@@ -55,6 +57,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types_from_string.hpp>
 #include <osmium/osm/way.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/config.hpp>
 
 #include <expat.h>
 
@@ -125,7 +128,17 @@ namespace osmium {
 
         namespace detail {
 
-            class XMLParser final : public ParserWithBuffer {
+            /**
+             * Decodes OSM XML data using the Expat parser and writes the
+             * objects into buffers. Where the objects go is decided by the
+             * TOutput class, which must have the functions read_types(),
+             * buffer(), maybe_new_buffer(), flush_nested_buffer(), and
+             * set_header_value() like the ParserWithBuffer class.
+             */
+            template <typename TOutput>
+            class XMLDecoder {
+
+                friend class XMLTokenizer<XMLDecoder>;
 
                 enum class context {
                     osm,
@@ -148,6 +161,8 @@ namespace osmium {
                     other
                 }; // enum class context
 
+                TOutput& m_output;
+
                 std::vector<context> m_context_stack;
 
                 osmium::io::Header m_header{};
@@ -174,7 +189,7 @@ namespace osmium {
                     std::exception_ptr m_exception_ptr{}; // NOLINT(bugprone-throw-keyword-missing) see https://bugs.llvm.org/show_bug.cgi?id=52400
 
                     template <typename TFunc>
-                    void member_wrap(XMLParser& xml_parser, TFunc&& func) noexcept {
+                    void member_wrap(XMLDecoder& xml_parser, TFunc&& func) noexcept {
                         if (m_exception_ptr) {
                             return;
                         }
@@ -189,24 +204,24 @@ namespace osmium {
                     template <typename TFunc>
                     static void wrap(void* data, TFunc&& func) noexcept {
                         assert(data);
-                        auto& xml_parser = *static_cast<XMLParser*>(data);
-                        xml_parser.m_expat_xml_parser->member_wrap(xml_parser, std::forward<TFunc>(func));
+                        auto& xml_parser = *static_cast<XMLDecoder*>(data);
+                        xml_parser.m_expat_xml_parser.member_wrap(xml_parser, std::forward<TFunc>(func));
                     }
 
                     static void XMLCALL start_element_wrapper(void* data, const XML_Char* element, const XML_Char** attrs) noexcept {
-                        wrap(data, [&](XMLParser& xml_parser) {
+                        wrap(data, [&](XMLDecoder& xml_parser) {
                             xml_parser.start_element(element, attrs);
                         });
                     }
 
                     static void XMLCALL end_element_wrapper(void* data, const XML_Char* element) noexcept {
-                        wrap(data, [&](XMLParser& xml_parser) {
+                        wrap(data, [&](XMLDecoder& xml_parser) {
                             xml_parser.end_element(element);
                         });
                     }
 
                     static void XMLCALL character_data_wrapper(void* data, const XML_Char* text, int len) noexcept {
-                        wrap(data, [&](XMLParser& xml_parser) {
+                        wrap(data, [&](XMLDecoder& xml_parser) {
                             xml_parser.characters(text, len);
                         });
                     }
@@ -225,7 +240,7 @@ namespace osmium {
                             const XML_Char* /*systemId*/,
                             const XML_Char* /*publicId*/,
                             const XML_Char* /*notationName*/) noexcept {
-                        wrap(data, [&](XMLParser& /*xml_parser*/) {
+                        wrap(data, [&](XMLDecoder& /*xml_parser*/) {
                             throw osmium::xml_error{"XML entities are not supported"};
                         });
                     }
@@ -253,9 +268,9 @@ namespace osmium {
                         XML_ParserFree(m_parser);
                     }
 
-                    void operator()(const std::string& data, bool last) {
-                        assert(data.size() < std::numeric_limits<int>::max());
-                        if (XML_Parse(m_parser, data.data(), static_cast<int>(data.size()), last) == XML_STATUS_ERROR) {
+                    void operator()(const char* data, std::size_t size, bool last) {
+                        assert(size < std::numeric_limits<int>::max());
+                        if (XML_Parse(m_parser, data, static_cast<int>(size), last) == XML_STATUS_ERROR) {
                             if (m_exception_ptr) {
                                 std::rethrow_exception(m_exception_ptr);
                             }
@@ -265,7 +280,23 @@ namespace osmium {
 
                 }; // class ExpatXMLParser
 
-                ExpatXMLParser* m_expat_xml_parser{nullptr};
+                ExpatXMLParser m_expat_xml_parser{this};
+
+                osmium::osm_entity_bits::type read_types() const noexcept {
+                    return m_output.read_types();
+                }
+
+                osmium::memory::Buffer& buffer() noexcept {
+                    return m_output.buffer();
+                }
+
+                void maybe_new_buffer(osmium::item_type current_type) {
+                    m_output.maybe_new_buffer(current_type);
+                }
+
+                void flush_nested_buffer() {
+                    m_output.flush_nested_buffer();
+                }
 
                 template <typename T>
                 static void check_attributes(const XML_Char** attrs, T&& check) {
@@ -343,10 +374,6 @@ namespace osmium {
                     m_tl_builder->add_tag(k, v);
                 }
 
-                void mark_header_as_done() {
-                    set_header_value(m_header);
-                }
-
                 void top_level_element(const XML_Char* element, const XML_Char** attrs) {
                     if (!std::strcmp(element, "osm")) {
                         m_context_stack.push_back(context::osm);
@@ -746,6 +773,177 @@ namespace osmium {
                     }
                 }
 
+            public:
+
+                explicit XMLDecoder(TOutput& output) :
+                    m_output(output) {
+                }
+
+                XMLDecoder(const XMLDecoder&) = delete;
+                XMLDecoder& operator=(const XMLDecoder&) = delete;
+
+                XMLDecoder(XMLDecoder&&) = delete;
+                XMLDecoder& operator=(XMLDecoder&&) = delete;
+
+                ~XMLDecoder() noexcept = default;
+
+                void operator()(const char* data, std::size_t size, bool last) {
+                    m_expat_xml_parser(data, size, last);
+                }
+
+                void operator()(const std::string& data, bool last) {
+                    m_expat_xml_parser(data.data(), data.size(), last);
+                }
+
+                /**
+                 * Parse the complete document using the XMLTokenizer
+                 * instead of Expat.
+                 *
+                 * @returns false if the tokenizer can not handle the
+                 *          document. The decoder and its output must not
+                 *          be used any more in that case.
+                 */
+                bool tokenize(const std::string& document) {
+                    XMLTokenizer<XMLDecoder> tokenizer{*this};
+                    return tokenizer(document.data(), document.size());
+                }
+
+                void mark_header_as_done() {
+                    m_output.set_header_value(m_header);
+                }
+
+            }; // class XMLDecoder
+
+            /**
+             * Output for the XMLDecoder used when parsing a chunk of an XML
+             * file in a pool thread. All objects go into a single buffer.
+             */
+            class XMLChunkOutput {
+
+                osmium::memory::Buffer m_buffer;
+                osmium::osm_entity_bits::type m_read_types;
+
+            public:
+
+                XMLChunkOutput(std::size_t size, osmium::osm_entity_bits::type read_types) :
+                    m_buffer(size, osmium::memory::Buffer::auto_grow::yes),
+                    m_read_types(read_types) {
+                }
+
+                osmium::osm_entity_bits::type read_types() const noexcept {
+                    return m_read_types;
+                }
+
+                osmium::memory::Buffer& buffer() noexcept {
+                    return m_buffer;
+                }
+
+                void maybe_new_buffer(osmium::item_type /*current_type*/) noexcept {
+                }
+
+                void flush_nested_buffer() noexcept {
+                }
+
+                void set_header_value(const osmium::io::Header& /*header*/) noexcept {
+                }
+
+            }; // class XMLChunkOutput
+
+            /**
+             * Parse a complete XML document (usually a chunk created by the
+             * XMLChunkSplitter) and return a buffer with all objects.
+             *
+             * If use_tokenizer is set, the document is first parsed with
+             * the faster XMLTokenizer. Only if that fails, it is parsed
+             * again with Expat.
+             */
+            inline osmium::memory::Buffer parse_xml_chunk(const std::string& document, osmium::osm_entity_bits::type read_types, bool use_tokenizer = false) {
+                if (use_tokenizer) {
+                    XMLChunkOutput output{document.size() / 2, read_types};
+                    XMLDecoder<XMLChunkOutput> decoder{output};
+                    if (decoder.tokenize(document)) {
+                        return std::move(output.buffer());
+                    }
+                }
+
+                XMLChunkOutput output{document.size() / 2, read_types};
+                XMLDecoder<XMLChunkOutput> decoder{output};
+                decoder(document, true);
+                return std::move(output.buffer());
+            }
+
+            class XMLParser final : public ParserWithBuffer {
+
+                friend class XMLDecoder<XMLParser>;
+
+                enum : std::size_t {
+                    parallel_chunk_size = 1024UL * 1024UL
+                };
+
+                void run_serial() {
+                    XMLDecoder<XMLParser> decoder{*this};
+
+                    while (!input_done()) {
+                        const std::string data{get_input()};
+                        decoder(data, input_done());
+                        if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
+                            break;
+                        }
+                    }
+
+                    decoder.mark_header_as_done();
+                    flush_final_buffer();
+                }
+
+                // The main thread splits the input into chunks at object
+                // boundaries which are parsed in the pool. The header is
+                // parsed here from the prologue of the file.
+                void run_parallel() {
+                    XMLDecoder<XMLParser> decoder{*this};
+                    XMLChunkSplitter splitter{parallel_chunk_size};
+
+                    const auto prologue_func = [&decoder](const char* data, std::size_t size) {
+                        decoder(data, size, false);
+                        decoder.mark_header_as_done();
+                    };
+
+                    const bool use_tokenizer = osmium::config::use_fast_xml_tokenizer();
+
+                    const auto chunk_func = [this, use_tokenizer](std::string&& document, osmium::item_type type) {
+                        if (type != osmium::item_type::undefined &&
+                            !(read_types() & osmium::osm_entity_bits::from_item_type(type))) {
+                            return;
+                        }
+                        const auto types = read_types();
+                        const auto callback = buffer_callback();
+                        auto doc = std::make_shared<std::string>(std::move(document));
+                        send_to_output_queue(submit_to_pool([doc, types, callback, use_tokenizer]() {
+                            osmium::memory::Buffer buffer{parse_xml_chunk(*doc, types, use_tokenizer)};
+                            callback(buffer);
+                            return buffer;
+                        }));
+                    };
+
+                    while (!input_done()) {
+                        splitter.add(get_input());
+                        splitter.split(prologue_func, chunk_func, input_done());
+                    }
+
+                    if (!splitter.prologue_done()) {
+                        // No objects found, leave everything to the normal parser.
+                        if (!splitter.data().empty()) {
+                            decoder(splitter.data(), true);
+                        }
+                        decoder.mark_header_as_done();
+                        flush_final_buffer();
+                        return;
+                    }
+
+                    if (!splitter.root_closed()) {
+                        throw osmium::xml_error{"XML parsing error: unexpected end of data"};
+                    }
+                }
+
             public:
 
                 explicit XMLParser(parser_arguments& args) :
@@ -763,19 +961,12 @@ namespace osmium {
                 void run() override {
                     osmium::thread::set_thread_name("_osmium_xml_in");
 
-                    ExpatXMLParser parser{this};
-                    m_expat_xml_parser = &parser;
-
-                    while (!input_done()) {
-                        const std::string data{get_input()};
-                        parser(data, input_done());
-                        if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
-                            break;
-                        }
+                    if (read_types() != osmium::osm_entity_bits::nothing &&
+                        osmium::config::use_parallel_xml_parsing()) {
+                        run_parallel();
+                    } else {
+                        run_serial();
                     }
-
-                    mark_header_as_done();
-                    flush_final_buffer();
                 }
 
             }; // class XMLParser
@@ -58,7 +58,6 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/thread/pool.hpp>
 #include <osmium/visitor.hpp>
 
-#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
@@ -96,11 +95,11 @@ namespace osmium {
                     out += ' ';
                     out += lat;
                     out += "=\"";
-                    osmium::detail::append_location_coordinate_to_string(std::back_inserter(out), location.y());
+                    OutputBlock::append_coordinate(out, location.y());
                     out += "\" ";
                     out += lon;
                     out += "=\"";
-                    osmium::detail::append_location_coordinate_to_string(std::back_inserter(out), location.x());
+                    OutputBlock::append_coordinate(out, location.x());
                     out += "\"";
                 }
 
@@ -246,11 +245,18 @@ namespace osmium {
             public:
 
                 XMLOutputBlock(osmium::memory::Buffer&& buffer, const xml_output_options& options) :
+                    XMLOutputBlock(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)), options) {
+                }
+
+                XMLOutputBlock(std::shared_ptr<const osmium::memory::Buffer> buffer, const xml_output_options& options) :
                     OutputBlock(std::move(buffer)),
                     m_options(options) {
                 }
 
                 std::string operator()() {
+                    // XML output is usually about twice as large as the
+                    // in-memory representation of the objects.
+                    reserve_output(2);
                     osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
 
                     if (m_options.use_change_ops) {
@@ -467,6 +473,10 @@ namespace osmium {
                     m_output_queue.push(m_pool.submit(XMLOutputBlock{std::move(buffer), m_options}));
                 }
 
+                void write_shared_buffer(const std::shared_ptr<const osmium::memory::Buffer>& buffer) final {
+                    m_output_queue.push(m_pool.submit(XMLOutputBlock{buffer, m_options}));
+                }
+
                 void write_end() final {
                     std::string out;
 
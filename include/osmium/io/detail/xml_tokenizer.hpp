@@ -0,0 +1,582 @@
+#ifndef OSMIUM_IO_DETAIL_XML_TOKENIZER_HPP
+#define OSMIUM_IO_DETAIL_XML_TOKENIZER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Check that data is valid UTF-8 and only contains characters
+             * allowed in XML 1.0 documents. Runs of ASCII characters are
+             * checked eight bytes at a time.
+             */
+            inline bool is_valid_xml_utf8(const char* data, const char* end) noexcept {
+                constexpr const uint64_t high_bits = 0x8080808080808080ULL;
+                constexpr const uint64_t space = 0x2020202020202020ULL;
+
+                const auto* p = reinterpret_cast<const unsigned char*>(data);
+                const auto* e = reinterpret_cast<const unsigned char*>(end);
+
+                while (p != e) {
+                    if (e - p >= 8) {
+                        uint64_t word = 0;
+                        std::memcpy(&word, p, sizeof(word));
+                        // no bytes with the high bit set and none below 0x20
+                        if ((word & high_bits) == 0 && (((word | high_bits) - space) & high_bits) == high_bits) {
+                            p += 8;
+                            continue;
+                        }
+                    }
+
+                    const uint32_t c = *p;
+                    if (c < 0x80U) {
+                        if (c < 0x20U && c != '\t' && c != '\n' && c != '\r') {
+                            return false;
+                        }
+                        ++p;
+                        continue;
+                    }
+
+                    std::size_t len = 0;
+                    uint32_t cp = 0;
+                    if ((c & 0xe0U) == 0xc0U) {
+                        len = 2;
+                        cp = c & 0x1fU;
+                    } else if ((c & 0xf0U) == 0xe0U) {
+                        len = 3;
+                        cp = c & 0x0fU;
+                    } else if ((c & 0xf8U) == 0xf0U) {
+                        len = 4;
+                        cp = c & 0x07U;
+                    } else {
+                        return false;
+                    }
+
+                    if (static_cast<std::size_t>(e - p) < len) {
+                        return false;
+                    }
+
+                    for (std::size_t i = 1; i < len; ++i) {
+                        if ((p[i] & 0xc0U) != 0x80U) {
+                            return false;
+                        }
+                        cp = (cp << 6U) | (p[i] & 0x3fU);
+                    }
+
+                    if ((len == 2 && cp < 0x80U) ||
+                        (len == 3 && cp < 0x800U) ||
+                        (len == 4 && cp < 0x10000U) ||
+                        cp > 0x10ffffU ||
+                        (cp >= 0xd800U && cp <= 0xdfffU) ||
+                        cp == 0xfffeU || cp == 0xffffU) {
+                        return false;
+                    }
+
+                    p += len;
+                }
+
+                return true;
+            }
+
+            /**
+             * A minimal non-validating tokenizer for the XML subset used in
+             * OSM files. It calls start_element(), end_element(), and
+             * characters() on the handler just like the Expat parser does.
+             *
+             * It only understands UTF-8 documents without DTD, CDATA
+             * sections and entities other than the predefined ones and
+             * character references. If it finds anything it doesn't
+             * understand or any error in the document, it stops and
+             * returns false. The caller should then parse the document
+             * again with Expat, which will either handle it or report the
+             * error properly.
+             *
+             * Attribute names and values are copied into a scratch buffer
+             * per tag, because the handler needs NUL-terminated strings and
+             * the document must stay intact for the fallback.
+             */
+            template <typename THandler>
+            class XMLTokenizer {
+
+                THandler& m_handler;
+
+                const char* m_end = nullptr;
+
+                // Open elements (pointing into the document).
+                std::vector<std::pair<const char*, std::size_t>> m_stack;
+
+                // Decoded attribute names and values and their offsets.
+                std::string m_scratch;
+                std::vector<std::size_t> m_offsets;
+                std::vector<const char*> m_attrs;
+
+                std::string m_text;
+
+                static bool is_space(const char c) noexcept {
+                    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+                }
+
+                // Only ASCII names are supported, everything else is
+                // left to Expat.
+                static bool is_name_start(const char c) noexcept {
+                    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':';
+                }
+
+                static bool is_name_char(const char c) noexcept {
+                    return is_name_start(c) || (c >= '0' && c <= '9') || c == '-' || c == '.';
+                }
+
+                const char* skip_space(const char* p) const noexcept {
+                    while (p != m_end && is_space(*p)) {
+                        ++p;
+                    }
+                    return p;
+                }
+
+                const char* scan_name(const char* p) const noexcept {
+                    if (p == m_end || !is_name_start(*p)) {
+                        return nullptr;
+                    }
+                    ++p;
+                    while (p != m_end && is_name_char(*p)) {
+                        ++p;
+                    }
+                    return p;
+                }
+
+                static bool has_prefix(const char* p, const char* end, const char* prefix) noexcept {
+                    const auto len = std::strlen(prefix);
+                    return static_cast<std::size_t>(end - p) >= len && !std::strncmp(p, prefix, len);
+                }
+
+                const char* find(const char* p, const char* str) const noexcept {
+                    const auto len = std::strlen(str);
+                    while (true) {
+                        p = static_cast<const char*>(std::memchr(p, str[0], static_cast<std::size_t>(m_end - p)));
+                        if (!p || static_cast<std::size_t>(m_end - p) < len) {
+                            return nullptr;
+                        }
+                        if (!std::strncmp(p, str, len)) {
+                            return p;
+                        }
+                        ++p;
+                    }
+                }
+
+                static void append_utf8(std::string& out, uint32_t cp) {
+                    if (cp < 0x80U) {
+                        out += static_cast<char>(cp);
+                    } else if (cp < 0x800U) {
+                        out += static_cast<char>(0xc0U | (cp >> 6U));
+                        out += static_cast<char>(0x80U | (cp & 0x3fU));
+                    } else if (cp < 0x10000U) {
+                        out += static_cast<char>(0xe0U | (cp >> 12U));
+                        out += static_cast<char>(0x80U | ((cp >> 6U) & 0x3fU));
+                        out += static_cast<char>(0x80U | (cp & 0x3fU));
+                    } else {
+                        out += static_cast<char>(0xf0U | (cp >> 18U));
+                        out += static_cast<char>(0x80U | ((cp >> 12U) & 0x3fU));
+                        out += static_cast<char>(0x80U | ((cp >> 6U) & 0x3fU));
+                        out += static_cast<char>(0x80U | (cp & 0x3fU));
+                    }
+                }
+
+                // Decode the entity or character reference starting at p
+                // (pointing to the '&') and append it to out. Returns the
+                // position after the ';' or nullptr.
+                const char* decode_reference(const char* p, std::string& out) const {
+                    const char* semicolon = static_cast<const char*>(std::memchr(p, ';', static_cast<std::size_t>(std::min<std::ptrdiff_t>(m_end - p, 12))));
+                    if (!semicolon) {
+                        return nullptr;
+                    }
+
+                    const std::string name(p + 1, semicolon);
+                    if (name == "lt") {
+                        out += '<';
+                    } else if (name == "gt") {
+                        out += '>';
+                    } else if (name == "amp") {
+                        out += '&';
+                    } else if (name == "quot") {
+                        out += '"';
+                    } else if (name == "apos") {
+                        out += '\'';
+                    } else if (name.size() > 1 && name[0] == '#') {
+                        const bool hex = name[1] == 'x';
+                        const std::size_t start = hex ? 2 : 1;
+                        if (name.size() == start || name.size() - start > 8) {
+                            return nullptr;
+                        }
+                        uint32_t cp = 0;
+                        for (std::size_t i = start; i < name.size(); ++i) {
+                            const char c = name[i];
+                            uint32_t digit = 0;
+                            if (c >= '0' && c <= '9') {
+                                digit = static_cast<uint32_t>(c - '0');
+                            } else if (hex && c >= 'a' && c <= 'f') {
+                                digit = static_cast<uint32_t>(c - 'a' + 10);
+                            } else if (hex && c >= 'A' && c <= 'F') {
+                                digit = static_cast<uint32_t>(c - 'A' + 10);
+                            } else {
+                                return nullptr;
+                            }
+                            cp = cp * (hex ? 16U : 10U) + digit;
+                        }
+                        const bool valid = cp == 0x9U || cp == 0xaU || cp == 0xdU ||
+                                           (cp >= 0x20U && cp <= 0xd7ffU) ||
+                                           (cp >= 0xe000U && cp <= 0xfffdU) ||
+                                           (cp >= 0x10000U && cp <= 0x10ffffU);
+                        if (!valid) {
+                            return nullptr;
+                        }
+                        append_utf8(out, cp);
+                    } else {
+                        return nullptr;
+                    }
+
+                    return semicolon + 1;
+                }
+
+                // Parse the start tag at p (pointing to the '<'). Returns
+                // the position after the tag or nullptr.
+                const char* start_tag(const char* p) {
+                    const char* name = p + 1;
+                    const char* q = scan_name(name);
+                    if (!q) {
+                        return nullptr;
+                    }
+
+                    const auto name_len = static_cast<std::size_t>(q - name);
+                    m_scratch.assign(name, name_len);
+                    m_scratch += '\0';
+                    m_offsets.clear();
+
+                    bool self_closing = false;
+                    while (true) {
+                        const char* after_space = skip_space(q);
+                        if (after_space == m_end) {
+                            return nullptr;
+                        }
+                        if (*after_space == '>') {
+                            q = after_space + 1;
+                            break;
+                        }
+                        if (*after_space == '/') {
+                            if (after_space + 1 == m_end || after_space[1] != '>') {
+                                return nullptr;
+                            }
+                            q = after_space + 2;
+                            self_closing = true;
+                            break;
+                        }
+                        if (after_space == q) {
+                            // attributes must be separated by white space
+                            return nullptr;
+                        }
+
+                        const char* attr_name = after_space;
+                        q = scan_name(attr_name);
+                        if (!q) {
+                            return nullptr;
+                        }
+                        const std::size_t name_offset = m_scratch.size();
+                        m_scratch.append(attr_name, q);
+                        m_scratch += '\0';
+
+                        for (const auto offset : m_offsets) {
+                            if (!std::strcmp(m_scratch.data() + offset, m_scratch.data() + name_offset)) {
+                                return nullptr; // duplicate attribute
+                            }
+                        }
+                        m_offsets.push_back(name_offset);
+
+                        q = skip_space(q);
+                        if (q == m_end || *q != '=') {
+                            return nullptr;
+                        }
+                        q = skip_space(q + 1);
+                        if (q == m_end || (*q != '"' && *q != '\'')) {
+                            return nullptr;
+                        }
+                        const char quote = *q++;
+
+                        m_offsets.push_back(m_scratch.size());
+                        while (true) {
+                            if (q == m_end) {
+                                return nullptr;
+                            }
+                            const char c = *q;
+                            if (c == quote) {
+                                ++q;
+                                break;
+                            }
+                            if (c == '<') {
+                                return nullptr;
+                            }
+                            if (c == '&') {
+                                q = decode_reference(q, m_scratch);
+                                if (!q) {
+                                    return nullptr;
+                                }
+                                continue;
+                            }
+                            if (c == '\r' && q + 1 != m_end && q[1] == '\n') {
+                                ++q;
+                            }
+                            m_scratch += (c == '\t' || c == '\n' || c == '\r') ? ' ' : c;
+                            ++q;
+                        }
+                        m_scratch += '\0';
+                    }
+
+                    m_attrs.clear();
+                    for (const auto offset : m_offsets) {
+                        m_attrs.push_back(m_scratch.data() + offset);
+                    }
+                    m_attrs.push_back(nullptr);
+
+                    m_handler.start_element(m_scratch.data(), m_attrs.data());
+                    if (self_closing) {
+                        m_handler.end_element(m_scratch.data());
+                    } else {
+                        m_stack.emplace_back(name, name_len);
+                    }
+
+                    return q;
+                }
+
+                // Parse the end tag at p (pointing to the '<'). Returns
+                // the position after the tag or nullptr.
+                const char* end_tag(const char* p) {
+                    const char* name = p + 2;
+                    const char* q = scan_name(name);
+                    if (!q || m_stack.empty()) {
+                        return nullptr;
+                    }
+
+                    const auto len = static_cast<std::size_t>(q - name);
+                    if (len != m_stack.back().second || std::strncmp(name, m_stack.back().first, len) != 0) {
+                        return nullptr;
+                    }
+
+                    q = skip_space(q);
+                    if (q == m_end || *q != '>') {
+                        return nullptr;
+                    }
+
+                    m_scratch.assign(name, len);
+                    m_handler.end_element(m_scratch.c_str());
+                    m_stack.pop_back();
+
+                    return q + 1;
+                }
+
+                // Handle character data between p and end inside the root
+                // element.
+                bool text(const char* p, const char* end) {
+                    const char* special = p;
+                    while (special != end && *special != '&' && *special != '\r' && *special != '>') {
+                        ++special;
+                    }
+
+                    if (special == end) {
+                        m_handler.characters(p, static_cast<int>(end - p));
+                        return true;
+                    }
+
+                    m_text.assign(p, special);
+                    for (const char* q = special; q != end;) {
+                        if (*q == '&') {
+                            q = decode_reference(q, m_text);
+                            if (!q || q > end) {
+                                return false;
+                            }
+                        } else if (*q == '\r') {
+                            m_text += '\n';
+                            ++q;
+                            if (q != end && *q == '\n') {
+                                ++q;
+                            }
+                        } else {
+                            if (*q == '>' && m_text.size() >= 2 && !m_text.compare(m_text.size() - 2, 2, "]]")) {
+                                return false;
+                            }
+                            m_text += *q;
+                            ++q;
+                        }
+                    }
+
+                    if (m_text.size() > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+                        return false;
+                    }
+                    m_handler.characters(m_text.data(), static_cast<int>(m_text.size()));
+                    return true;
+                }
+
+                bool xml_declaration(const char* p, const char* end) const {
+                    const std::string decl(p, end);
+                    const auto pos = decl.find("encoding");
+                    if (pos == std::string::npos) {
+                        return true;
+                    }
+                    auto start = decl.find_first_of("\"'", pos);
+                    if (start == std::string::npos) {
+                        return false;
+                    }
+                    ++start;
+                    const auto stop = decl.find(decl[start - 1], start);
+                    if (stop == std::string::npos) {
+                        return false;
+                    }
+                    std::string encoding = decl.substr(start, stop - start);
+                    for (auto& c : encoding) {
+                        if (c >= 'a' && c <= 'z') {
+                            c = static_cast<char>(c - 'a' + 'A');
+                        }
+                    }
+                    return encoding == "UTF-8";
+                }
+
+            public:
+
+                explicit XMLTokenizer(THandler& handler) :
+                    m_handler(handler) {
+                }
+
+                /**
+                 * Tokenize the complete document.
+                 *
+                 * @returns true if the document was tokenized, false if it
+                 *          contains anything not understood by this
+                 *          tokenizer (or errors).
+                 */
+                bool operator()(const char* data, std::size_t size) {
+                    const char* p = data;
+                    m_end = data + size;
+                    bool root_done = false;
+
+                    if (!is_valid_xml_utf8(data, m_end)) {
+                        return false;
+                    }
+
+                    if (has_prefix(p, m_end, "<?xml") && p + 5 != m_end && is_space(p[5])) {
+                        const char* end = find(p, "?>");
+                        if (!end || !xml_declaration(p, end)) {
+                            return false;
+                        }
+                        p = end + 2;
+                    }
+
+                    while (p != m_end) {
+                        if (*p != '<') {
+                            const char* lt = static_cast<const char*>(std::memchr(p, '<', static_cast<std::size_t>(m_end - p)));
+                            if (!lt) {
+                                lt = m_end;
+                            }
+                            if (m_stack.empty()) {
+                                if (skip_space(p) != lt) {
+                                    return false;
+                                }
+                            } else if (!text(p, lt)) {
+                                return false;
+                            }
+                            p = lt;
+                            continue;
+                        }
+
+                        if (m_end - p < 2) {
+                            return false;
+                        }
+
+                        if (p[1] == '/') {
+                            p = end_tag(p);
+                            if (!p) {
+                                return false;
+                            }
+                            root_done = m_stack.empty();
+                        } else if (p[1] == '!') {
+                            if (!has_prefix(p, m_end, "<!--")) {
+                                return false; // DTD, CDATA, ...
+                            }
+                            const char* end = find(p + 4, "--");
+                            if (!end || end + 2 == m_end || end[2] != '>') {
+                                return false;
+                            }
+                            p = end + 3;
+                        } else if (p[1] == '?') {
+                            const char* end = find(p + 2, "?>");
+                            const char* target_end = scan_name(p + 2);
+                            if (!end || !target_end ||
+                                (target_end != end && !is_space(*target_end)) ||
+                                (target_end - p == 5 && !std::strncmp(p + 2, "xml", 3))) {
+                                return false;
+                            }
+                            p = end + 2;
+                        } else {
+                            if (root_done) {
+                                return false;
+                            }
+                            p = start_tag(p);
+                            if (!p) {
+                                return false;
+                            }
+                            root_done = m_stack.empty();
+                        }
+                    }
+
+                    return root_done;
+                }
+
+            }; // class XMLTokenizer
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_XML_TOKENIZER_HPP
@@ -45,8 +45,15 @@ DEALINGS IN THE SOFTWARE.
 
 #include <zlib.h>
 
+#ifdef OSMIUM_WITH_LIBDEFLATE
+# include <libdeflate.h>
+#endif
+
 #include <cassert>
+#include <cstddef>
 #include <limits>
+#include <memory>
+#include <new>
 #include <string>
 
 namespace osmium {
@@ -65,17 +72,82 @@ namespace osmium {
                 }
             }
 
+#ifdef OSMIUM_WITH_LIBDEFLATE
+            struct libdeflate_deleter {
+
+                void operator()(libdeflate_compressor* compressor) const noexcept {
+                    libdeflate_free_compressor(compressor);
+                }
+
+                void operator()(libdeflate_decompressor* decompressor) const noexcept {
+                    libdeflate_free_decompressor(decompressor);
+                }
+
+            }; // struct libdeflate_deleter
+
+            /**
+             * Get the (de)compressor for the current thread. Setting them
+             * up is expensive, so they are kept around for the next blob.
+             */
+            inline libdeflate_compressor* libdeflate_thread_compressor(int compression_level) {
+                static thread_local std::unique_ptr<libdeflate_compressor, libdeflate_deleter> compressor;
+                static thread_local int level = 0;
+
+                // Same default level as zlib.
+                if (compression_level == Z_DEFAULT_COMPRESSION) {
+                    compression_level = 6;
+                }
+
+                if (!compressor || level != compression_level) {
+                    compressor.reset(libdeflate_alloc_compressor(compression_level));
+                    if (!compressor) {
+                        throw std::bad_alloc{};
+                    }
+                    level = compression_level;
+                }
+
+                return compressor.get();
+            }
+
+            inline libdeflate_decompressor* libdeflate_thread_decompressor() {
+                static thread_local std::unique_ptr<libdeflate_decompressor, libdeflate_deleter> decompressor{libdeflate_alloc_decompressor()};
+                if (!decompressor) {
+                    throw std::bad_alloc{};
+                }
+                return decompressor.get();
+            }
+#endif
+
             /**
              * Compress data using zlib.
              *
              * Note that this function can not compress data larger than
              * what fits in an unsigned long, on Windows this is usually 32bit.
              *
+             * If compiled with OSMIUM_WITH_LIBDEFLATE, libdeflate is used
+             * instead of zlib. The result is in the same format, but not
+             * necessarily byte for byte the same.
+             *
              * @param input Data to compress.
              * @param compression_level Compression level.
              * @returns Compressed data.
              */
             inline std::string zlib_compress(const std::string& input, int compression_level = Z_DEFAULT_COMPRESSION) {
+#ifdef OSMIUM_WITH_LIBDEFLATE
+                libdeflate_compressor* compressor = libdeflate_thread_compressor(compression_level);
+                const std::size_t output_bound = libdeflate_zlib_compress_bound(compressor, input.size());
+
+                std::string output(output_bound, '\0');
+
+                const std::size_t output_size = libdeflate_zlib_compress(compressor, input.data(), input.size(), &*output.begin(), output_bound);
+                if (output_size == 0) {
+                    throw io_error{"failed to compress data"};
+                }
+
+                output.resize(output_size);
+
+                return output;
+#else
                 assert(input.size() < std::numeric_limits<unsigned long>::max());
                 unsigned long output_size = ::compressBound(static_cast<unsigned long>(input.size())); // NOLINT(google-runtime-int)
 
@@ -95,24 +167,44 @@ namespace osmium {
                 output.resize(output_size);
 
                 return output;
+#endif
             }
 
             /**
-             * Uncompress data using zlib.
+             * Uncompress data using zlib into memory provided by the
+             * caller.
              *
              * Note that this function can not uncompress data larger than
              * what fits in an unsigned long, on Windows this is usually 32bit.
              *
+             * If compiled with OSMIUM_WITH_LIBDEFLATE, libdeflate is used
+             * instead of zlib. It uncompresses the whole buffer in one go,
+             * which is much faster, and fails if the uncompressed data
+             * doesn't have exactly raw_size bytes.
+             *
              * @param input Compressed input data.
+             * @param input_size Size of compressed input data.
+             * @param output Memory for the uncompressed data, must have
+             *               space for raw_size bytes.
              * @param raw_size Size of uncompressed data.
-             * @param output Uncompressed result data.
-             * @returns Pointer and size to incompressed data.
              */
-            inline protozero::data_view zlib_uncompress_string(const char* input, unsigned long input_size, unsigned long raw_size, std::string& output) { // NOLINT(google-runtime-int)
-                output.resize(raw_size);
-
+            inline void zlib_uncompress(const char* input, unsigned long input_size, char* output, unsigned long raw_size) { // NOLINT(google-runtime-int)
+#ifdef OSMIUM_WITH_LIBDEFLATE
+                const auto result = libdeflate_zlib_decompress(
+                    libdeflate_thread_decompressor(),
+                    input,
+                    input_size,
+                    output,
+                    raw_size,
+                    nullptr);
+
+                if (result != LIBDEFLATE_SUCCESS) {
+                    throw io_error{result == LIBDEFLATE_BAD_DATA ? "failed to uncompress data: data error"
+                                                                 : "failed to uncompress data: wrong size"};
+                }
+#else
                 const auto result = ::uncompress(
-                    reinterpret_cast<unsigned char*>(&*output.begin()),
+                    reinterpret_cast<unsigned char*>(output),
                     &raw_size,
                     reinterpret_cast<const unsigned char*>(input),
                     input_size);
@@ -120,7 +212,23 @@ namespace osmium {
                 if (result != Z_OK) {
                     throw io_error{std::string{"failed to uncompress data: "} + zError(result)};
                 }
+#endif
+            }
 
+            /**
+             * Uncompress data using zlib.
+             *
+             * Note that this function can not uncompress data larger than
+             * what fits in an unsigned long, on Windows this is usually 32bit.
+             *
+             * @param input Compressed input data.
+             * @param raw_size Size of uncompressed data.
+             * @param output Uncompressed result data.
+             * @returns Pointer and size to incompressed data.
+             */
+            inline protozero::data_view zlib_uncompress_string(const char* input, unsigned long input_size, unsigned long raw_size, std::string& output) { // NOLINT(google-runtime-int)
+                output.resize(raw_size);
+                zlib_uncompress(input, input_size, &*output.begin(), raw_size);
                 return protozero::data_view{output.data(), output.size()};
             }
 
@@ -0,0 +1,438 @@
+#ifndef OSMIUM_IO_EXTERNAL_SORTER_HPP
+#define OSMIUM_IO_EXTERNAL_SORTER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/external_record_sorter.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/object_pointer_collection.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * A sorted run of OSM objects in the Osmium-internal format
+             * stored in an unlinked temporary file. Objects are appended
+             * with write() and read back sequentially through a window of
+             * configurable size.
+             */
+            class external_sort_run {
+
+                int m_fd = -1;
+                std::size_t m_size = 0;
+                std::size_t m_read_offset = 0;
+
+                std::vector<char> m_window{};
+                std::size_t m_pos = 0;
+                std::size_t m_end = 0;
+                osmium::OSMObject* m_current = nullptr;
+
+                // Make sure at least the given number of bytes are
+                // available in the window at the current position.
+                bool ensure(std::size_t bytes) {
+                    if (m_end - m_pos >= bytes) {
+                        return true;
+                    }
+
+                    std::memmove(m_window.data(), m_window.data() + m_pos, m_end - m_pos);
+                    m_end -= m_pos;
+                    m_pos = 0;
+
+                    if (bytes > m_window.size()) {
+                        m_window.resize(bytes);
+                    }
+
+                    const auto to_read = std::min(m_window.size() - m_end, m_size - m_read_offset);
+                    if (to_read > 0) {
+#ifndef _WIN32
+                        if (!osmium::io::detail::reliable_pread(m_fd, m_window.data() + m_end, to_read, m_read_offset)) {
+                            throw std::runtime_error{"Temporary file of external sorter truncated"};
+                        }
+#endif
+                        m_read_offset += to_read;
+                        m_end += to_read;
+                    }
+
+                    return m_end - m_pos >= bytes;
+                }
+
+                void load() {
+                    m_current = nullptr;
+                    if (!ensure(sizeof(osmium::memory::Item))) {
+                        return;
+                    }
+                    const auto size = reinterpret_cast<const osmium::memory::Item*>(m_window.data() + m_pos)->padded_size();
+                    if (!ensure(size)) {
+                        throw std::runtime_error{"Temporary file of external sorter truncated"};
+                    }
+                    m_current = reinterpret_cast<osmium::OSMObject*>(m_window.data() + m_pos);
+                }
+
+            public:
+
+                explicit external_sort_run(const std::string& directory) :
+                    m_fd(create_sort_tmp_file(directory)) {
+                }
+
+                external_sort_run(const external_sort_run&) = delete;
+                external_sort_run& operator=(const external_sort_run&) = delete;
+
+                external_sort_run(external_sort_run&& other) noexcept :
+                    m_fd(other.m_fd),
+                    m_size(other.m_size),
+                    m_read_offset(other.m_read_offset),
+                    m_window(std::move(other.m_window)),
+                    m_pos(other.m_pos),
+                    m_end(other.m_end),
+                    m_current(other.m_current) {
+                    other.m_fd = -1;
+                    other.m_current = nullptr;
+                }
+
+                external_sort_run& operator=(external_sort_run&& other) noexcept {
+                    std::swap(m_fd, other.m_fd);
+                    std::swap(m_size, other.m_size);
+                    std::swap(m_read_offset, other.m_read_offset);
+                    std::swap(m_window, other.m_window);
+                    std::swap(m_pos, other.m_pos);
+                    std::swap(m_end, other.m_end);
+                    std::swap(m_current, other.m_current);
+                    return *this;
+                }
+
+                ~external_sort_run() noexcept {
+#ifndef _WIN32
+                    if (m_fd >= 0) {
+                        ::close(m_fd);
+                    }
+#endif
+                }
+
+                /// The number of bytes written to this run.
+                std::size_t size() const noexcept {
+                    return m_size;
+                }
+
+                void write(const char* data, std::size_t size) {
+                    osmium::io::detail::reliable_write(m_fd, data, size);
+                    m_size += size;
+                }
+
+                /**
+                 * Start reading the run from the beginning using a read
+                 * window of (at least) the given size.
+                 */
+                void start_reading(std::size_t window_size) {
+                    m_window.resize(std::max(window_size, sizeof(osmium::memory::Item)));
+                    m_read_offset = 0;
+                    m_pos = 0;
+                    m_end = 0;
+                    load();
+                }
+
+                /**
+                 * The current object or nullptr if the run is exhausted.
+                 * The object is only valid until the next call to next().
+                 */
+                osmium::OSMObject* current() noexcept {
+                    return m_current;
+                }
+
+                void next() {
+                    m_pos += m_current->padded_size();
+                    load();
+                }
+
+            }; // class external_sort_run
+
+        } // namespace detail
+
+        /**
+         * Sorts OSM objects which do not fit into memory. Buffers with OSM
+         * objects are added to the sorter. Whenever the memory used by
+         * those buffers exceeds the memory budget, the objects are sorted
+         * and written as a sorted run in the Osmium-internal format to a
+         * temporary file. When finish() is called, all runs are merged and
+         * the sorted objects are handed to the output in buffers. The
+         * output can be an osmium::io::Writer or anything else that can
+         * be called with an rvalue reference to a buffer.
+         *
+         * Objects are sorted by type, ID, and version like with
+         * osmium::object_order_type_id_version_without_timestamp. The
+         * sort is stable, so objects with the same type, ID, and version
+         * keep the order in which they were added.
+         *
+         * Items in the buffers that are not OSM objects (such as
+         * changesets) are ignored.
+         *
+         * Usage:
+         * @code
+         * osmium::io::ExternalSorter sorter{512UL * 1024UL * 1024UL, "/var/tmp"};
+         * osmium::io::Reader reader{"unsorted.osm.pbf"};
+         * while (osmium::memory::Buffer buffer = reader.read()) {
+         *     sorter.add(std::move(buffer));
+         * }
+         * reader.close();
+         *
+         * osmium::io::Writer writer{"sorted.osm.pbf"};
+         * sorter.finish(writer);
+         * writer.close();
+         * @endcode
+         *
+         * Not available on Windows.
+         */
+        class ExternalSorter {
+
+            enum : std::size_t {
+                min_read_window_size = 64UL * 1024UL,
+                output_buffer_size = 1024UL * 1024UL
+            };
+
+            std::size_t m_memory_budget;
+            std::string m_directory;
+
+            std::vector<osmium::memory::Buffer> m_buffers{};
+            osmium::ObjectPointerCollection m_objects{};
+            std::size_t m_used_memory = 0;
+
+            std::vector<detail::external_sort_run> m_runs{};
+
+            void spill() {
+                m_objects.sort_by_type_id_version();
+
+                detail::external_sort_run run{m_directory};
+                osmium::memory::Buffer buffer{output_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                for (const auto& object : m_objects) {
+                    buffer.add_item(object);
+                    buffer.commit();
+                    if (buffer.committed() >= output_buffer_size) {
+                        run.write(reinterpret_cast<const char*>(buffer.data()), buffer.committed());
+                        buffer.clear();
+                    }
+                }
+                run.write(reinterpret_cast<const char*>(buffer.data()), buffer.committed());
+                m_runs.push_back(std::move(run));
+
+                m_objects.clear();
+                m_buffers.clear();
+                m_used_memory = 0;
+            }
+
+            template <typename TOutput>
+            static void add_to_output(osmium::memory::Buffer& buffer, const osmium::OSMObject& object, TOutput& output) {
+                buffer.add_item(object);
+                buffer.commit();
+                if (buffer.committed() >= output_buffer_size) {
+                    output(std::move(buffer));
+                    buffer = osmium::memory::Buffer{output_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                }
+            }
+
+            template <typename TOutput>
+            void merge_runs(TOutput& output) {
+                using entry_type = std::pair<osmium::detail::object_pointer_key, std::size_t>;
+                const auto greater = [](const entry_type& a, const entry_type& b) noexcept {
+                    return std::tie(b.first, b.second) < std::tie(a.first, a.second);
+                };
+                std::priority_queue<entry_type, std::vector<entry_type>, decltype(greater)> queue{greater};
+
+                const auto window_size = std::max(static_cast<std::size_t>(min_read_window_size),
+                                                  m_memory_budget / m_runs.size());
+                for (std::size_t n = 0; n < m_runs.size(); ++n) {
+                    auto& run = m_runs[n];
+                    run.start_reading(window_size);
+                    if (run.current()) {
+                        queue.emplace(osmium::detail::make_object_pointer_key(run.current()), n);
+                    }
+                }
+
+                osmium::memory::Buffer buffer{output_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                while (!queue.empty()) {
+                    const auto n = queue.top().second;
+                    queue.pop();
+
+                    auto& run = m_runs[n];
+                    add_to_output(buffer, *run.current(), output);
+                    run.next();
+                    if (run.current()) {
+                        queue.emplace(osmium::detail::make_object_pointer_key(run.current()), n);
+                    }
+                }
+
+                if (buffer.committed() > 0) {
+                    output(std::move(buffer));
+                }
+            }
+
+        public:
+
+            /**
+             * Create an external sorter.
+             *
+             * @param memory_budget Approximate number of bytes of OSM data
+             *        kept in memory before a sorted run is written to disk.
+             * @param directory Directory for temporary files. If this is
+             *        empty, the directory from the TMPDIR environment
+             *        variable or /tmp is used. The temporary files are
+             *        unlinked right after they are created, so they will
+             *        not be left behind even if the program crashes.
+             */
+            explicit ExternalSorter(std::size_t memory_budget = 1024UL * 1024UL * 1024UL, std::string directory = "") :
+                m_memory_budget(memory_budget),
+                m_directory(std::move(directory)) {
+            }
+
+            /**
+             * Add all OSM objects in the buffer to the sorter. The sorter
+             * takes ownership of the buffer.
+             */
+            void add(osmium::memory::Buffer&& buffer) {
+                if (!buffer || buffer.committed() == 0) {
+                    return;
+                }
+
+                osmium::apply(buffer, m_objects);
+                m_used_memory += buffer.capacity();
+                m_buffers.push_back(std::move(buffer));
+
+                if (m_used_memory + m_objects.size() * sizeof(osmium::detail::object_pointer_key) >= m_memory_budget) {
+                    spill();
+                }
+            }
+
+            /**
+             * Add copies of all OSM objects in the buffer to the sorter.
+             */
+            void add(const osmium::memory::Buffer& buffer) {
+                if (!buffer || buffer.committed() == 0) {
+                    return;
+                }
+
+                osmium::memory::Buffer copy{buffer.committed(), osmium::memory::Buffer::auto_grow::no};
+                copy.add_buffer(buffer);
+                copy.commit();
+                add(std::move(copy));
+            }
+
+            /**
+             * Add all OSM objects in the buffer to the sorter. The sorter
+             * takes ownership of the buffer. This makes the sorter usable
+             * as a callback for buffers.
+             */
+            void operator()(osmium::memory::Buffer&& buffer) {
+                add(std::move(buffer));
+            }
+
+            /// The number of sorted runs written to disk so far.
+            std::size_t num_runs() const noexcept {
+                return m_runs.size();
+            }
+
+            /// The number of bytes in buffers currently held in memory.
+            std::size_t used_memory() const noexcept {
+                return m_used_memory;
+            }
+
+            /// The number of bytes currently used in temporary files.
+            std::size_t used_disk_space() const noexcept {
+                std::size_t size = 0;
+                for (const auto& run : m_runs) {
+                    size += run.size();
+                }
+                return size;
+            }
+
+            /**
+             * Sort all objects added so far and call the output with
+             * rvalue references to buffers containing the sorted objects.
+             * Afterwards the sorter is empty and can be reused.
+             *
+             * If all objects fit into the memory budget, they are sorted
+             * in memory and no temporary files are written.
+             *
+             * @param output Called with buffers of sorted objects, for
+             *        instance an osmium::io::Writer.
+             */
+            template <typename TOutput>
+            void finish(TOutput&& output) {
+                if (m_runs.empty()) {
+                    m_objects.sort_by_type_id_version();
+                    osmium::memory::Buffer buffer{output_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                    for (const auto& object : m_objects) {
+                        add_to_output(buffer, object, output);
+                    }
+                    if (buffer.committed() > 0) {
+                        output(std::move(buffer));
+                    }
+                    m_objects.clear();
+                    m_buffers.clear();
+                    m_used_memory = 0;
+                    return;
+                }
+
+                if (!m_objects.empty()) {
+                    spill();
+                }
+                merge_runs(output);
+                m_runs.clear();
+            }
+
+        }; // class ExternalSorter
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_EXTERNAL_SORTER_HPP
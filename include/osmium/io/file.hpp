@@ -191,6 +191,12 @@ namespace osmium {
                 } else if (suffixes.back() == "bz2") {
                     m_file_compression = file_compression::bzip2;
                     suffixes.pop_back();
+                } else if (suffixes.back() == "zst") {
+                    m_file_compression = file_compression::zstd;
+                    suffixes.pop_back();
+                } else if (suffixes.back() == "lz4") {
+                    m_file_compression = file_compression::lz4;
+                    suffixes.pop_back();
                 }
 
                 if (suffixes.empty()) {
@@ -208,7 +214,7 @@ namespace osmium {
                 } else if (suffixes.back() == "opl") {
                     m_file_format = file_format::opl;
                     suffixes.pop_back();
-                } else if (suffixes.back() == "json") {
+                } else if (suffixes.back() == "json" || suffixes.back() == "jsonl") {
                     m_file_format = file_format::json;
                     suffixes.pop_back();
                 } else if (suffixes.back() == "o5m") {
@@ -228,6 +234,9 @@ namespace osmium {
                 } else if (suffixes.back() == "ids") {
                     m_file_format = file_format::ids;
                     suffixes.pop_back();
+                } else if (suffixes.back() == "osmb" || suffixes.back() == "buffer") {
+                    m_file_format = file_format::buffer;
+                    suffixes.pop_back();
                 }
 
                 if (suffixes.empty()) {
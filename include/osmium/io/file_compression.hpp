@@ -42,7 +42,9 @@ namespace osmium {
         enum class file_compression {
             none  = 0,
             gzip  = 1,
-            bzip2 = 2
+            bzip2 = 2,
+            zstd  = 3,
+            lz4   = 4
         };
 
         inline const char* as_string(file_compression compression) {
@@ -51,6 +53,10 @@ namespace osmium {
                     return "gzip";
                 case file_compression::bzip2:
                     return "bzip2";
+                case file_compression::zstd:
+                    return "zstd";
+                case file_compression::lz4:
+                    return "lz4";
                 default: // file_compression::none:
                     break;
             }
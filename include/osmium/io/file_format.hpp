@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cstddef>
 #include <iosfwd>
 
 namespace osmium {
@@ -49,7 +50,8 @@ namespace osmium {
             debug     = 6,
             blackhole = 7,
             ids       = 8,
-            last      = 8 // must have the same value as the last real value
+            buffer    = 9,
+            last      = 9 // must have the same value as the last real value
         };
 
         enum class read_meta {
@@ -62,6 +64,111 @@ namespace osmium {
             single = 1
         };
 
+        enum class keep_raw_blobs {
+            no  = 0,
+            yes = 1
+        };
+
+        /**
+         * Should the PBF parser decode the data blocks in the threads of
+         * the pool or in its own thread? The default "from_config" uses
+         * the OSMIUM_USE_POOL_THREADS_FOR_PBF_PARSING environment variable
+         * (see osmium::config::use_pool_threads_for_pbf_parsing()).
+         */
+        enum class pool_for_pbf_parsing {
+            from_config = 0,
+            no          = 1,
+            yes         = 2
+        };
+
+        /**
+         * Should the Reader check that the data is sorted by type and ID
+         * if the header claims it is (see
+         * osmium::io::Header::sorted_by_type_then_id())? If this is "yes"
+         * and the file claims to be sorted, the order of the objects in
+         * each decoded buffer is checked right after it was decoded (for
+         * PBF files in the pool threads), and the Reader only checks the
+         * boundaries between buffers. Reader::read() throws an
+         * osmium::out_of_order_error if the check fails. The header
+         * returned by the Reader has sorting_verified() set in this case.
+         */
+        enum class verify_sorting {
+            no  = 0,
+            yes = 1
+        };
+
+        /**
+         * Should the tags of all objects be sorted by key right after
+         * they are decoded (for PBF files in the pool threads)? The tag
+         * lists are marked as sorted (see TagList::sorted_by_key()), so
+         * lookups in them can stop early and osmium::tags::SortedTags can
+         * be set up without sorting.
+         */
+        enum class sort_tags {
+            no  = 0,
+            yes = 1
+        };
+
+        /**
+         * Maximum sizes of the queues between the stages of the Reader:
+         * the queue with data read from the input and the queue with the
+         * decoded buffers. A size of 0 means that the default from the
+         * OSMIUM_MAX_INPUT_QUEUE_SIZE or OSMIUM_MAX_OSMDATA_QUEUE_SIZE
+         * environment variables is used.
+         */
+        struct reader_queue_sizes {
+
+            std::size_t input;
+            std::size_t osmdata;
+
+            explicit reader_queue_sizes(std::size_t input_size = 0, std::size_t osmdata_size = 0) noexcept :
+                input(input_size),
+                osmdata(osmdata_size) {
+            }
+
+        }; // struct reader_queue_sizes
+
+        /**
+         * How the XML, OPL, and o5m parsers adapt the size of the buffers
+         * they create to the speed of the consumer. "fixed" always uses the
+         * target size. "latency" shrinks the buffers (down to 1/16th of the
+         * target size) while the consumer is waiting for data, so that it
+         * gets the first objects sooner. "throughput" grows the buffers (up
+         * to 8 times the target size) while decoded buffers pile up in the
+         * queue, so that there are fewer buffers to handle.
+         */
+        enum class buffer_policy {
+            fixed      = 0,
+            latency    = 1,
+            throughput = 2
+        };
+
+        /**
+         * Target size of the buffers created by the parsers in bytes and/or
+         * number of objects together with the policy for adapting it. A
+         * size of 0 means the default (1 MByte), an object count of 0 means
+         * there is no limit on the number of objects. The object count is
+         * approximate, the parsers might count objects they don't keep.
+         *
+         * The PBF parser creates one buffer per data block in the file,
+         * this setting doesn't change that.
+         */
+        struct reader_buffer_size {
+
+            std::size_t bytes;
+            std::size_t objects;
+            buffer_policy policy;
+
+            explicit reader_buffer_size(std::size_t size_in_bytes = 0,
+                                        buffer_policy size_policy = buffer_policy::fixed,
+                                        std::size_t max_objects = 0) noexcept :
+                bytes(size_in_bytes),
+                objects(max_objects),
+                policy(size_policy) {
+            }
+
+        }; // struct reader_buffer_size
+
         inline const char* as_string(const file_format format) noexcept {
             switch (format) {
                 case file_format::xml:
@@ -80,6 +187,8 @@ namespace osmium {
                     return "BLACKHOLE";
                 case file_format::ids:
                     return "IDS";
+                case file_format::buffer:
+                    return "BUFFER";
                 default: // file_format::unknown
                     break;
             }
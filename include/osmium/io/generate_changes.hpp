@@ -0,0 +1,385 @@
+#ifndef OSMIUM_IO_GENERATE_CHANGES_HPP
+#define OSMIUM_IO_GENERATE_CHANGES_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/indexed_pbf_reader.hpp>
+#include <osmium/io/input_iterator.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/object_hash.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/hash64.hpp>
+#include <osmium/util/misc.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Handler for generate_changes() writing the changes to a writer,
+         * usually one for an OSM change file (.osc). Created and modified
+         * objects are written as they are in the new data, deleted objects
+         * as they are in the old data but with the visible flag unset.
+         *
+         * The XML writer decides between the create and modify operation
+         * based on the version of the object, objects with version 1 are
+         * written as created, all others as modified.
+         */
+        class ChangeFileWriter {
+
+            osmium::io::Writer* m_writer;
+            osmium::memory::Buffer m_buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+        public:
+
+            explicit ChangeFileWriter(osmium::io::Writer& writer) noexcept :
+                m_writer(&writer) {
+            }
+
+            void created(const osmium::OSMObject& object) {
+                (*m_writer)(object);
+            }
+
+            void modified(const osmium::OSMObject& /*old_object*/, const osmium::OSMObject& new_object) {
+                (*m_writer)(new_object);
+            }
+
+            void deleted(const osmium::OSMObject& object) {
+                m_buffer.clear();
+                m_buffer.add_item(object);
+                m_buffer.commit();
+                auto& copy = *m_buffer.begin<osmium::OSMObject>();
+                copy.set_visible(false);
+                (*m_writer)(copy);
+            }
+
+        }; // class ChangeFileWriter
+
+        namespace detail {
+
+            inline int compare_type_id(const osmium::OSMObject& lhs, const osmium::OSMObject& rhs) noexcept {
+                if (const_tie(lhs.type(), lhs.id() > 0, lhs.positive_id()) <
+                    const_tie(rhs.type(), rhs.id() > 0, rhs.positive_id())) {
+                    return -1;
+                }
+                return lhs.type() == rhs.type() && lhs.id() == rhs.id() ? 0 : 1;
+            }
+
+            /**
+             * Compare the next objects from the old and new data (either
+             * can be nullptr if that input is at its end) and call the
+             * handler if needed.
+             *
+             * @returns Bit 1 set if the old object was used, bit 2 set if
+             *          the new object was used.
+             */
+            template <typename THandler>
+            int compare_objects(const osmium::OSMObject* old_object, const osmium::OSMObject* new_object, THandler& handler, const osmium::object_hash_fields::type fields) {
+                const int cmp = !old_object ? 1 : !new_object ? -1 : compare_type_id(*old_object, *new_object);
+                if (cmp < 0) {
+                    handler.deleted(*old_object);
+                    return 1;
+                }
+                if (cmp > 0) {
+                    handler.created(*new_object);
+                    return 2;
+                }
+                if (osmium::object_hash(*old_object, fields) != osmium::object_hash(*new_object, fields)) {
+                    handler.modified(*old_object, *new_object);
+                }
+                return 3;
+            }
+
+            /**
+             * The data blobs of one of the inputs of generate_changes()
+             * and the objects in the current blob. Blobs which can't be
+             * skipped because no blob in the other input has the same hash
+             * are decoded ahead of time in the pool.
+             */
+            class ChangeInput {
+
+                const osmium::io::IndexedPBFReader* m_reader;
+                osmium::thread::Pool* m_pool;
+                std::vector<uint64_t> m_hashes;
+                std::vector<bool> m_maybe_shared;
+                std::deque<std::future<osmium::memory::Buffer>> m_decoded;
+                std::size_t m_next_blob = 0;
+                std::size_t m_next_decode = 0;
+                osmium::memory::Buffer m_buffer;
+                osmium::memory::Buffer::t_const_iterator<osmium::OSMObject> m_it;
+                osmium::memory::Buffer::t_const_iterator<osmium::OSMObject> m_end;
+
+                std::future<osmium::memory::Buffer> decode(std::size_t n) {
+                    const auto* reader = m_reader;
+                    return m_pool->submit([reader, n]() {
+                        return reader->read_blob(n);
+                    });
+                }
+
+                // Decode the run of blobs which can't be skipped following
+                // the current one.
+                void decode_ahead() {
+                    const auto max_decoded = static_cast<std::size_t>(m_pool->num_threads());
+                    if (m_next_decode < m_next_blob) {
+                        m_next_decode = m_next_blob;
+                    }
+                    while (m_decoded.size() < max_decoded &&
+                           m_next_decode < m_hashes.size() &&
+                           !m_maybe_shared[m_next_decode]) {
+                        m_decoded.push_back(decode(m_next_decode));
+                        ++m_next_decode;
+                    }
+                }
+
+            public:
+
+                ChangeInput(const osmium::io::IndexedPBFReader& reader, osmium::thread::Pool& pool) :
+                    m_reader(&reader),
+                    m_pool(&pool) {
+                    m_hashes.reserve(reader.num_data_blobs());
+                    for (std::size_t n = 0; n < reader.num_data_blobs(); ++n) {
+                        const auto blob = reader.raw_blob(n);
+                        m_hashes.push_back(osmium::hash64(blob.data(), blob.size()));
+                    }
+                }
+
+                ChangeInput(const ChangeInput&) = delete;
+                ChangeInput& operator=(const ChangeInput&) = delete;
+
+                ChangeInput(ChangeInput&&) = delete;
+                ChangeInput& operator=(ChangeInput&&) = delete;
+
+                ~ChangeInput() noexcept {
+                    // The tasks still running reference the reader, so
+                    // wait for them before leaving.
+                    for (auto& future : m_decoded) {
+                        if (future.valid()) {
+                            future.wait();
+                        }
+                    }
+                }
+
+                /// Mark all blobs which have the same hash as a blob in other.
+                void find_shared(const ChangeInput& other) {
+                    std::vector<uint64_t> other_hashes{other.m_hashes};
+                    std::sort(other_hashes.begin(), other_hashes.end());
+                    m_maybe_shared.clear();
+                    for (const auto hash : m_hashes) {
+                        m_maybe_shared.push_back(std::binary_search(other_hashes.begin(), other_hashes.end(), hash));
+                    }
+                    decode_ahead();
+                }
+
+                /// The current object or nullptr if there is none.
+                const osmium::OSMObject* object() const noexcept {
+                    return m_it == m_end ? nullptr : &*m_it;
+                }
+
+                void next_object() noexcept {
+                    ++m_it;
+                }
+
+                /// Have all blobs been read?
+                bool at_end() const noexcept {
+                    return m_next_blob == m_hashes.size();
+                }
+
+                /// Make the next blob the current one.
+                void read_next_blob() {
+                    if (m_decoded.empty()) {
+                        m_buffer = m_reader->read_blob(m_next_blob);
+                    } else {
+                        m_buffer = m_decoded.front().get();
+                        m_decoded.pop_front();
+                    }
+                    ++m_next_blob;
+                    m_it = m_buffer.cbegin<osmium::OSMObject>();
+                    m_end = m_buffer.cend<osmium::OSMObject>();
+                    decode_ahead();
+                }
+
+                /**
+                 * Is the next blob the same as the next blob in other?
+                 *
+                 * @pre @code !at_end() && !other.at_end() @endcode
+                 */
+                bool next_blob_same_as(const ChangeInput& other) const noexcept {
+                    if (!m_maybe_shared[m_next_blob] ||
+                        m_hashes[m_next_blob] != other.m_hashes[other.m_next_blob]) {
+                        return false;
+                    }
+                    const auto blob = m_reader->raw_blob(m_next_blob);
+                    const auto other_blob = other.m_reader->raw_blob(other.m_next_blob);
+                    return blob.size() == other_blob.size() &&
+                           std::memcmp(blob.data(), other_blob.data(), blob.size()) == 0;
+                }
+
+                /**
+                 * Skip the next blob without decoding it.
+                 *
+                 * @pre @code next_blob_same_as(...) @endcode
+                 */
+                void skip_next_blob() {
+                    ++m_next_blob;
+                    decode_ahead();
+                }
+
+            }; // class ChangeInput
+
+        } // namespace detail
+
+        /**
+         * Compare two versions of OSM data and call the handler for each
+         * difference: handler.created(new_object) for objects only in the
+         * new data, handler.deleted(old_object) for objects only in the
+         * old data, and handler.modified(old_object, new_object) for
+         * objects which are in both but with different content. See
+         * ChangeFileWriter for a handler writing an OSM change file.
+         *
+         * Both inputs must contain only one version of each object and be
+         * sorted by type and ID (see object_order_type_id_version). They
+         * are compared using object_hash() with the specified fields,
+         * metadata such as version and timestamp is ignored by default.
+         *
+         * @param old_source Source (usually an osmium::io::Reader) for the
+         *                   old data.
+         * @param new_source Source for the new data.
+         * @param handler The handler.
+         * @param fields The parts of the objects to compare.
+         */
+        template <typename TOldSource, typename TNewSource, typename THandler>
+        void generate_changes(TOldSource& old_source, TNewSource& new_source, THandler& handler,
+                              const osmium::object_hash_fields::type fields = osmium::object_hash_fields::content) {
+            auto old_range = osmium::io::make_input_iterator_range<osmium::OSMObject>(old_source);
+            auto new_range = osmium::io::make_input_iterator_range<osmium::OSMObject>(new_source);
+            auto old_it = old_range.begin();
+            auto new_it = new_range.begin();
+            const auto old_end = old_range.end();
+            const auto new_end = new_range.end();
+
+            while (old_it != old_end || new_it != new_end) {
+                const int used = detail::compare_objects(old_it == old_end ? nullptr : &*old_it,
+                                                         new_it == new_end ? nullptr : &*new_it,
+                                                         handler, fields);
+                if (used & 1) {
+                    ++old_it;
+                }
+                if (used & 2) {
+                    ++new_it;
+                }
+            }
+        }
+
+        /**
+         * Compare two versions of OSM data in PBF files, see the other
+         * generate_changes() function for details.
+         *
+         * Where both files contain the same data blob byte for byte at
+         * the same position in the object order, the blob is skipped
+         * without decoding it. This is the case for large parts of the
+         * data if both files were written by the same program from mostly
+         * the same data, for instance when the new file was created with
+         * apply_changes() from the old one. The other blobs are decoded
+         * ahead of time in parallel using the threads in the pool.
+         *
+         * @returns The number of blobs skipped in each file.
+         */
+        template <typename THandler>
+        std::size_t generate_changes(const osmium::io::IndexedPBFReader& old_source,
+                                     const osmium::io::IndexedPBFReader& new_source,
+                                     THandler& handler,
+                                     const osmium::object_hash_fields::type fields = osmium::object_hash_fields::content,
+                                     osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            detail::ChangeInput old_input{old_source, pool};
+            detail::ChangeInput new_input{new_source, pool};
+            old_input.find_shared(new_input);
+            new_input.find_shared(old_input);
+
+            std::size_t skipped = 0;
+            while (true) {
+                const auto* old_object = old_input.object();
+                const auto* new_object = new_input.object();
+                if (!old_object && !new_object) {
+                    if (old_input.at_end() && new_input.at_end()) {
+                        break;
+                    }
+                    // Both inputs are at a blob boundary, so identical
+                    // blobs contain exactly the same objects.
+                    if (!old_input.at_end() && !new_input.at_end() &&
+                        old_input.next_blob_same_as(new_input)) {
+                        old_input.skip_next_blob();
+                        new_input.skip_next_blob();
+                        ++skipped;
+                        continue;
+                    }
+                }
+                // An input without a current object must read its next
+                // blob before anything can be compared.
+                if (!old_object && !old_input.at_end()) {
+                    old_input.read_next_blob();
+                    continue;
+                }
+                if (!new_object && !new_input.at_end()) {
+                    new_input.read_next_blob();
+                    continue;
+                }
+
+                const int used = detail::compare_objects(old_object, new_object, handler, fields);
+                if (used & 1) {
+                    old_input.next_object();
+                }
+                if (used & 2) {
+                    new_input.next_object();
+                }
+            }
+
+            return skipped;
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_GENERATE_CHANGES_HPP
@@ -43,16 +43,21 @@ DEALINGS IN THE SOFTWARE.
  */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/parallel_compressor.hpp>
+#include <osmium/io/detail/parallel_decompressor.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/util/config.hpp>
 
 #include <zlib.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstddef>
+#include <cstdint>
 #include <limits>
 #include <string>
 
@@ -335,11 +340,233 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Splitting and decompressing of gzip files with BGZF members
+             * for the ParallelDecompressor. Each BGZF member contains its
+             * own size in the BC extra field of the gzip header.
+             */
+            struct bgzf_format {
+
+                enum {
+                    target_chunk_size = 1024UL * 1024UL
+                };
+
+                /**
+                 * Get the size of the BGZF member starting at data. Returns
+                 * 0 if this isn't a complete BGZF member.
+                 */
+                static std::size_t member_size(const char* data, const std::size_t size) noexcept {
+                    const auto* d = reinterpret_cast<const unsigned char*>(data);
+                    if (size < 18 || d[0] != 0x1fU || d[1] != 0x8bU || d[2] != 8U || (d[3] & 0x04U) == 0) {
+                        return 0;
+                    }
+
+                    const std::size_t xlen = d[10] | (static_cast<std::size_t>(d[11]) << 8U);
+                    std::size_t pos = 12;
+                    const std::size_t end = 12 + xlen;
+                    while (pos + 4 <= end && end <= size) {
+                        const std::size_t slen = d[pos + 2] | (static_cast<std::size_t>(d[pos + 3]) << 8U);
+                        if (d[pos] == 'B' && d[pos + 1] == 'C' && slen == 2 && pos + 6 <= end) {
+                            const std::size_t bsize = (d[pos + 4] | (static_cast<std::size_t>(d[pos + 5]) << 8U)) + 1;
+                            return bsize <= size ? bsize : 0;
+                        }
+                        pos += 4 + slen;
+                    }
+
+                    return 0;
+                }
+
+                static bool is_suitable(const char* data, const std::size_t size) noexcept {
+                    return member_size(data, size) != 0;
+                }
+
+                static std::size_t next_chunk_size(const char* data, const std::size_t size) noexcept {
+                    std::size_t chunk_size = 0;
+                    while (chunk_size < target_chunk_size && chunk_size < size) {
+                        const auto msize = member_size(data + chunk_size, size - chunk_size);
+                        if (msize == 0) {
+                            // Not a BGZF member, so we can't find the next
+                            // boundary. Put all the rest into this chunk.
+                            return size;
+                        }
+                        chunk_size += msize;
+                    }
+                    return chunk_size;
+                }
+
+                static decompressed_chunk decompress_chunk(const char* data, const std::size_t size) {
+                    decompressed_chunk result;
+                    result.data.reserve(size * 4);
+
+                    z_stream zstream{};
+                    zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(data));
+                    assert(size < std::numeric_limits<unsigned int>::max());
+                    zstream.avail_in = static_cast<unsigned int>(size);
+
+                    int status = inflateInit2(&zstream, MAX_WBITS | 16); // NOLINT(hicpp-signed-bitwise)
+                    if (status != Z_OK) {
+                        throw osmium::gzip_error{"gzip error: decompression init failed", status};
+                    }
+
+                    std::size_t written = 0;
+                    while (true) {
+                        if (result.data.size() - written < 64U * 1024U) {
+                            result.data.resize(written + std::max<std::size_t>(64U * 1024U, result.data.size()));
+                        }
+                        zstream.next_out = reinterpret_cast<unsigned char*>(&result.data[written]);
+                        zstream.avail_out = static_cast<unsigned int>(result.data.size() - written);
+                        status = inflate(&zstream, Z_NO_FLUSH);
+                        written = result.data.size() - zstream.avail_out;
+
+                        if (status == Z_STREAM_END) {
+                            if (zstream.avail_in == 0) {
+                                break;
+                            }
+                            status = inflateReset(&zstream);
+                        }
+
+                        if (status == Z_BUF_ERROR && zstream.avail_in == 0) {
+                            result.complete = false;
+                            break;
+                        }
+
+                        if (status != Z_OK && status != Z_BUF_ERROR) {
+                            std::string message{"gzip error: inflate failed: "};
+                            if (zstream.msg) {
+                                message.append(zstream.msg);
+                            }
+                            inflateEnd(&zstream);
+                            throw osmium::gzip_error{message, status};
+                        }
+                    }
+
+                    inflateEnd(&zstream);
+                    result.data.resize(written);
+                    return result;
+                }
+
+            }; // struct bgzf_format
+
+            /**
+             * Compression of chunks into BGZF members for the
+             * ParallelCompressor. Each member is a complete gzip member
+             * with the BC extra field containing its size, so the result
+             * can be read by all gzip tools and decompressed in parallel
+             * using the bgzf_format.
+             */
+            struct bgzf_compress_format {
+
+                enum {
+                    target_chunk_size = 1024UL * 1024UL,
+                    max_block_input_size = 0xff00UL,
+                    header_size = 18,
+                    trailer_size = 8
+                };
+
+                static void append_uint32(std::string& out, const uint32_t value) {
+                    out += static_cast<char>(value & 0xffU);
+                    out += static_cast<char>((value >> 8U) & 0xffU);
+                    out += static_cast<char>((value >> 16U) & 0xffU);
+                    out += static_cast<char>((value >> 24U) & 0xffU);
+                }
+
+                // Append one BGZF member with the compressed data to out.
+                static void compress_block(z_stream& zstream, const char* data, const std::size_t size, std::string& out) {
+                    static const char header[header_size] = {
+                        '\x1f', '\x8b', '\x08', '\x04', // magic, deflate, FEXTRA
+                        '\0', '\0', '\0', '\0',         // mtime
+                        '\0', '\xff',                 // XFL, OS (unknown)
+                        '\x06', '\0',                 // XLEN
+                        'B', 'C', '\x02', '\0',         // BC subfield with 2 bytes
+                        '\0', '\0'                    // BSIZE (filled in below)
+                    };
+
+                    const std::size_t start = out.size();
+                    out.append(header, header_size);
+
+                    const std::size_t bound = deflateBound(&zstream, static_cast<uLong>(size));
+                    out.resize(start + header_size + bound);
+
+                    zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(data));
+                    zstream.avail_in = static_cast<unsigned int>(size);
+                    zstream.next_out = reinterpret_cast<unsigned char*>(&out[start + header_size]);
+                    zstream.avail_out = static_cast<unsigned int>(bound);
+
+                    int result = deflate(&zstream, Z_FINISH);
+                    if (result != Z_STREAM_END) {
+                        throw osmium::gzip_error{"gzip error: compression failed", result};
+                    }
+                    out.resize(start + header_size + bound - zstream.avail_out);
+
+                    result = deflateReset(&zstream);
+                    if (result != Z_OK) {
+                        throw osmium::gzip_error{"gzip error: compression reset failed", result};
+                    }
+
+                    const auto crc = crc32(0, reinterpret_cast<const unsigned char*>(data), static_cast<unsigned int>(size));
+                    append_uint32(out, static_cast<uint32_t>(crc));
+                    append_uint32(out, static_cast<uint32_t>(size));
+
+                    const std::size_t block_size = out.size() - start - 1;
+                    assert(block_size <= 0xffffU);
+                    out[start + 16] = static_cast<char>(block_size & 0xffU);
+                    out[start + 17] = static_cast<char>((block_size >> 8U) & 0xffU);
+                }
+
+                static std::string compress_chunk(const char* data, const std::size_t size) {
+                    z_stream zstream{};
+                    // Negative window bits: raw deflate, we write the
+                    // gzip header and trailer ourselves.
+                    const int result = deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+                    if (result != Z_OK) {
+                        throw osmium::gzip_error{"gzip error: compression init failed", result};
+                    }
+
+                    std::string output;
+                    output.reserve(size / 2);
+                    try {
+                        for (std::size_t offset = 0; offset < size; offset += max_block_input_size) {
+                            compress_block(zstream, data + offset, std::min<std::size_t>(max_block_input_size, size - offset), output);
+                        }
+                    } catch (...) {
+                        deflateEnd(&zstream);
+                        throw;
+                    }
+
+                    deflateEnd(&zstream);
+                    return output;
+                }
+
+                void chunk_written(std::size_t /*input_size*/, std::size_t /*output_size*/) noexcept {
+                }
+
+                // The empty BGZF member marking the end of the file
+                static std::string end_marker() {
+                    return std::string{
+                        "\x1f\x8b\x08\x04\0\0\0\0\0\xff\x06\0BC\x02\0\x1b\0\x03\0\0\0\0\0\0\0\0\0",
+                        28};
+                }
+
+            }; // struct bgzf_compress_format
+
             // we want the register_compression() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_gzip_compression = osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::gzip,
-                [](const int fd, const fsync sync) { return new osmium::io::GzipCompressor{fd, sync}; },
-                [](const int fd) { return new osmium::io::GzipDecompressor{fd}; },
+                [](const int fd, const fsync sync) -> osmium::io::Compressor* {
+                    if (osmium::config::use_parallel_compression()) {
+                        return new ParallelCompressor<bgzf_compress_format>{fd, sync, osmium::thread::Pool::default_instance()};
+                    }
+                    return new osmium::io::GzipCompressor{fd, sync};
+                },
+                [](const int fd) -> osmium::io::Decompressor* {
+                    if (osmium::config::use_parallel_decompression()) {
+                        auto* decompressor = make_parallel_decompressor<bgzf_format>(fd);
+                        if (decompressor) {
+                            return decompressor;
+                        }
+                    }
+                    return new osmium::io::GzipDecompressor{fd};
+                },
                 [](const char* buffer, const std::size_t size) { return new osmium::io::GzipBufferDecompressor{buffer, size}; }
             );
 
@@ -77,6 +77,12 @@ namespace osmium {
              */
             bool m_has_multiple_object_versions = false;
 
+            /**
+             * Is the sorting claimed by the "sorting" option checked while
+             * the data is read?
+             */
+            bool m_sorting_verified = false;
+
         public:
 
             Header() = default;
@@ -160,6 +166,64 @@ namespace osmium {
                 return *this;
             }
 
+            /**
+             * Does the file claim that its objects are sorted by type
+             * (nodes, then ways, then relations) and ID? This is stored
+             * in the "sorting" option with the value "Type_then_ID". It
+             * is set by the PBF parser if the file has the
+             * "Sort.Type_then_ID" feature and used by the PBF writer to
+             * set this feature.
+             *
+             * Note that this is only a claim made by whoever wrote the
+             * file. See sorting_verified().
+             */
+            bool sorted_by_type_then_id() const noexcept {
+                return get("sorting") == "Type_then_ID";
+            }
+
+            /**
+             * Set or unset the "sorting" option to "Type_then_ID".
+             *
+             * @returns The header itself to allow chaining.
+             */
+            Header& set_sorted_by_type_then_id(bool value) {
+                set("sorting", value ? "Type_then_ID" : "");
+                return *this;
+            }
+
+            /**
+             * Is the claim that the file is sorted (see
+             * sorted_by_type_then_id()) checked while reading? This is
+             * set by the Reader if the osmium::io::verify_sorting option
+             * is used and the file claims to be sorted. In that case
+             * Reader::read() throws an osmium::out_of_order_error instead
+             * of returning objects which are out of order. Code that
+             * needs sorted input can rely on this to skip its own checks.
+             */
+            bool sorting_verified() const noexcept {
+                return m_sorting_verified;
+            }
+
+            /**
+             * Set the flag that tells us whether the sorting is checked
+             * while reading.
+             *
+             * @returns The header itself to allow chaining.
+             */
+            Header& set_sorting_verified(bool value) noexcept {
+                m_sorting_verified = value;
+                return *this;
+            }
+
+            /**
+             * Can the objects read with this header be relied upon to be
+             * sorted by type and ID? This is true if the file claims to
+             * be sorted and the claim is checked while reading.
+             */
+            bool sorted_and_verified() const noexcept {
+                return m_sorting_verified && sorted_by_type_then_id();
+            }
+
         }; // class Header
 
     } // namespace io
@@ -0,0 +1,392 @@
+#ifndef OSMIUM_IO_INDEXED_PBF_READER_HPP
+#define OSMIUM_IO_INDEXED_PBF_READER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want random access to the contents of OSM PBF
+ * files by object ID.
+ *
+ * @attention If you include this file, you'll need to link with
+ *            `libz`.
+ */
+
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_blob_index.hpp>
+#include <osmium/io/detail/pbf_blob_table.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <protozero/types.hpp>
+
+#include <cstddef>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Gives random access to the data blobs in an (uncompressed) PBF
+         * file. The file is memory mapped and a table of all blobs is
+         * built when the reader is opened. Which entity types and which
+         * range of IDs each blob contains is only found out when it is
+         * first needed, this needs one pass decoding all blobs. The result
+         * can be stored in a sidecar index file so later runs don't have
+         * to do this again. The PBF writer can also create this index
+         * file while writing (see the "pbf_blob_index" option).
+         *
+         * Usage:
+         * @code
+         * osmium::io::IndexedPBFReader reader{"planet.osm.pbf"};
+         * auto buffer = reader.read(osmium::osm_entity_bits::way, 123, 123);
+         * @endcode
+         *
+         * The sidecar index is only considered valid if it matches the
+         * size of the PBF file and the positions of all blobs in it.
+         */
+        class IndexedPBFReader {
+
+            osmium::util::MemoryMapping m_mapping;
+            detail::PBFBlobTable m_table;
+            osmium::io::Header m_header;
+            std::vector<pbf_blob_summary> m_summaries;
+            std::string m_index_filename;
+            bool m_have_summaries = false;
+
+            static osmium::util::MemoryMapping map_fd(int fd) {
+                const auto size = osmium::file_size(fd);
+                if (size == 0) {
+                    throw osmium::pbf_error{"empty file"};
+                }
+                return osmium::util::MemoryMapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, fd};
+            }
+
+            static osmium::util::MemoryMapping map_file(const std::string& filename) {
+                const int fd = detail::open_for_reading(filename);
+                try {
+                    osmium::util::MemoryMapping mapping{map_fd(fd)};
+                    detail::reliable_close(fd);
+                    return mapping;
+                } catch (...) {
+                    try {
+                        detail::reliable_close(fd);
+                    } catch (...) {
+                        // ignore errors on close, report original error
+                    }
+                    throw;
+                }
+            }
+
+            const char* data() const noexcept {
+                return m_mapping.get_addr<char>();
+            }
+
+            protozero::data_view blob_data(const detail::pbf_blob_info& blob) const noexcept {
+                return protozero::data_view{data() + blob.offset, blob.size};
+            }
+
+            /// Index into the blob table for the nth data blob.
+            const detail::pbf_blob_info& data_blob(std::size_t n) const noexcept {
+                return m_table[n + 1];
+            }
+
+            /**
+             * Decode the nth data blob and call func for each object in it.
+             * The decoder might return nested buffers, they are handled
+             * here so that the objects are seen in file order.
+             */
+            template <typename TFunction>
+            void for_each_object_in_blob(std::size_t n, osmium::osm_entity_bits::type entities, osmium::io::read_meta read_metadata, TFunction&& func) const {
+                detail::pbf_blob_buffer output;
+                detail::PBFPrimitiveBlockDecoder decoder{detail::decode_blob(blob_data(data_blob(n)), output), entities, read_metadata};
+                osmium::memory::Buffer buffer{decoder()};
+
+                while (buffer.has_nested_buffers()) {
+                    const auto nested = buffer.get_last_nested();
+                    for (const auto& object : nested->select<osmium::OSMObject>()) {
+                        func(object);
+                    }
+                }
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    func(object);
+                }
+            }
+
+            void build_summaries() {
+                m_summaries.clear();
+                m_summaries.reserve(num_data_blobs());
+                for (std::size_t n = 0; n < num_data_blobs(); ++n) {
+                    pbf_blob_summary summary;
+                    for_each_object_in_blob(n, osmium::osm_entity_bits::nwr, osmium::io::read_meta::no, [&summary](const osmium::OSMObject& object) {
+                        summary.add(object);
+                    });
+                    m_summaries.push_back(summary);
+                }
+            }
+
+            bool load_index() {
+                std::ifstream in{m_index_filename};
+                if (!in) {
+                    return false;
+                }
+
+                std::vector<detail::pbf_blob_index_entry> entries;
+                if (!detail::read_pbf_blob_index(in, m_mapping.size(), entries) ||
+                    entries.size() != num_data_blobs()) {
+                    return false;
+                }
+
+                std::vector<pbf_blob_summary> summaries;
+                summaries.reserve(entries.size());
+                for (std::size_t n = 0; n < entries.size(); ++n) {
+                    if (entries[n].offset != data_blob(n).offset || entries[n].size != data_blob(n).size) {
+                        return false;
+                    }
+                    summaries.push_back(entries[n].summary);
+                }
+
+                m_summaries = std::move(summaries);
+                return true;
+            }
+
+            void save_index() const {
+                std::ofstream out{m_index_filename, std::ios::trunc};
+                if (!out) {
+                    return;
+                }
+
+                std::vector<detail::pbf_blob_index_entry> entries(m_summaries.size());
+                for (std::size_t n = 0; n < m_summaries.size(); ++n) {
+                    entries[n].offset = data_blob(n).offset;
+                    entries[n].size = data_blob(n).size;
+                    entries[n].summary = m_summaries[n];
+                }
+                detail::write_pbf_blob_index(out, m_mapping.size(), entries);
+            }
+
+        public:
+
+            /**
+             * Open a PBF file for indexed reading.
+             *
+             * @param filename Name of the (uncompressed) PBF file.
+             * @param index_filename Name of the sidecar index file. If this
+             *        is empty, the default (filename with ".blobidx"
+             *        appended) is used. Set to "-" to not use a sidecar
+             *        file at all.
+             * @throws osmium::pbf_error If the file is not a valid PBF file.
+             * @throws std::system_error If the file can not be opened or
+             *         mapped.
+             */
+            explicit IndexedPBFReader(const std::string& filename, const std::string& index_filename = "") :
+                m_mapping(map_file(filename)),
+                m_table(detail::PBFBlobTable::from_memory(data(), m_mapping.size())),
+                m_index_filename(index_filename.empty() ? detail::pbf_blob_index_filename(filename) : index_filename) {
+                if (m_table.empty() || m_table[0].type != detail::pbf_blob_type::header) {
+                    throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                }
+                for (std::size_t n = 1; n < m_table.size(); ++n) {
+                    if (m_table[n].type != detail::pbf_blob_type::data) {
+                        throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                    }
+                }
+                m_header = detail::decode_header(blob_data(m_table[0]));
+                if (m_index_filename == "-") {
+                    m_index_filename.clear();
+                }
+            }
+
+            /// Get the header of the file.
+            const osmium::io::Header& header() const noexcept {
+                return m_header;
+            }
+
+            /// The number of data blobs in the file.
+            std::size_t num_data_blobs() const noexcept {
+                return m_table.size() - 1;
+            }
+
+            /**
+             * Get the summaries of all data blobs. On the first call they
+             * are read from the sidecar index or, if that isn't available
+             * or is out of date, built by decoding all blobs and then
+             * written to the sidecar index. Errors writing the index are
+             * ignored.
+             */
+            const std::vector<pbf_blob_summary>& summaries() {
+                if (!m_have_summaries) {
+                    if (m_index_filename.empty() || !load_index()) {
+                        build_summaries();
+                        if (!m_index_filename.empty()) {
+                            save_index();
+                        }
+                    }
+                    m_have_summaries = true;
+                }
+                return m_summaries;
+            }
+
+            /**
+             * Decode the nth data blob. All objects are returned in a
+             * single buffer.
+             *
+             * @pre @code n < num_data_blobs() @endcode
+             */
+            osmium::memory::Buffer read_blob(std::size_t n,
+                                             osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::all,
+                                             osmium::io::read_meta read_metadata = osmium::io::read_meta::yes) const {
+                osmium::memory::Buffer result{1024, osmium::memory::Buffer::auto_grow::yes};
+                for_each_object_in_blob(n, entities, read_metadata, [&result](const osmium::OSMObject& object) {
+                    result.add_item(object);
+                    result.commit();
+                });
+                return result;
+            }
+
+            /**
+             * Get the undecoded nth data blob, that is the serialized Blob
+             * message without the BlobHeader in front of it. The data
+             * stays valid as long as this reader exists.
+             *
+             * @pre @code n < num_data_blobs() @endcode
+             */
+            protozero::data_view raw_blob(std::size_t n) const noexcept {
+                return blob_data(data_blob(n));
+            }
+
+            /**
+             * Get the indexes of all data blobs which could contain objects
+             * of the specified types with IDs in the range [first, last].
+             */
+            std::vector<std::size_t> find_blobs(osmium::osm_entity_bits::type entities,
+                                                osmium::object_id_type first,
+                                                osmium::object_id_type last) {
+                std::vector<std::size_t> result;
+                const auto& s = summaries();
+                for (std::size_t n = 0; n < s.size(); ++n) {
+                    if (s[n].overlaps(entities, first, last)) {
+                        result.push_back(n);
+                    }
+                }
+                return result;
+            }
+
+            /**
+             * Read all objects of the specified types with IDs in the range
+             * [first, last]. Only blobs which could contain such objects
+             * are decoded. The objects are returned in file order.
+             */
+            osmium::memory::Buffer read(osmium::osm_entity_bits::type entities,
+                                        osmium::object_id_type first,
+                                        osmium::object_id_type last,
+                                        osmium::io::read_meta read_metadata = osmium::io::read_meta::yes) {
+                osmium::memory::Buffer result{1024, osmium::memory::Buffer::auto_grow::yes};
+                for (const auto n : find_blobs(entities, first, last)) {
+                    for_each_object_in_blob(n, entities, read_metadata, [&](const osmium::OSMObject& object) {
+                        if (object.id() >= first && object.id() <= last) {
+                            result.add_item(object);
+                            result.commit();
+                        }
+                    });
+                }
+                return result;
+            }
+
+            /**
+             * Get the indexes of all data blobs which could contain objects
+             * of the specified types inside the box. This uses the
+             * bounding boxes of the blobs, it works best with files
+             * written with the "pbf_cluster_nodes" option. Blobs without
+             * any locations (for instance ways in files without locations
+             * on ways) are always returned.
+             */
+            std::vector<std::size_t> find_blobs(osmium::osm_entity_bits::type entities,
+                                                const osmium::Box& box) {
+                std::vector<std::size_t> result;
+                const auto& s = summaries();
+                for (std::size_t n = 0; n < s.size(); ++n) {
+                    if (s[n].overlaps(entities, box)) {
+                        result.push_back(n);
+                    }
+                }
+                return result;
+            }
+
+            /**
+             * Read all nodes of the specified types inside the box and all
+             * ways and relations from blobs which could contain objects in
+             * the box (see find_blobs()). Ways and relations are not
+             * filtered any further. The objects are returned in file order.
+             */
+            osmium::memory::Buffer read(osmium::osm_entity_bits::type entities,
+                                        const osmium::Box& box,
+                                        osmium::io::read_meta read_metadata = osmium::io::read_meta::yes) {
+                osmium::memory::Buffer result{1024, osmium::memory::Buffer::auto_grow::yes};
+                for (const auto n : find_blobs(entities, box)) {
+                    for_each_object_in_blob(n, entities, read_metadata, [&](const osmium::OSMObject& object) {
+                        if (object.type() != osmium::item_type::node ||
+                            box.contains(static_cast<const osmium::Node&>(object).location())) {
+                            result.add_item(object);
+                            result.commit();
+                        }
+                    });
+                }
+                return result;
+            }
+
+        }; // class IndexedPBFReader
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_INDEXED_PBF_READER_HPP
@@ -0,0 +1,91 @@
+#ifndef OSMIUM_IO_IO_EXECUTOR_HPP
+#define OSMIUM_IO_IO_EXECUTOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/pool.hpp>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Option for the osmium::io::Reader and osmium::io::Writer: Run the
+         * reading (and decompression) or the (compression and) writing as
+         * tasks on the specified pool instead of in a dedicated thread per
+         * Reader or Writer. If a program has many files open at the same
+         * time, this keeps the number of threads bounded by the size of
+         * the pools.
+         *
+         * The pool must not be the one used for decoding and encoding the
+         * data (the one set with the osmium::thread::Pool& option or the
+         * default pool), because the write tasks wait for the encoding
+         * tasks. Use a separate, usually small, pool for I/O:
+         *
+         * @code
+         * osmium::thread::Pool io_pool{2};
+         * const osmium::io::io_executor executor{io_pool};
+         * osmium::io::Reader reader{"input.osm.pbf", executor};
+         * osmium::io::Writer writer{"output.osm.pbf", executor};
+         * @endcode
+         *
+         * The Reader still uses one thread for parsing.
+         */
+        class io_executor {
+
+            osmium::thread::Pool* m_pool = nullptr;
+
+        public:
+
+            /// Use dedicated threads (the default).
+            io_executor() noexcept = default;
+
+            explicit io_executor(osmium::thread::Pool& pool) noexcept :
+                m_pool(&pool) {
+            }
+
+            explicit operator bool() const noexcept {
+                return m_pool != nullptr;
+            }
+
+            osmium::thread::Pool* pool() const noexcept {
+                return m_pool;
+            }
+
+        }; // class io_executor
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_IO_EXECUTOR_HPP
@@ -0,0 +1,1418 @@
+#ifndef OSMIUM_IO_LAZY_PBF_BLOCK_HPP
+#define OSMIUM_IO_LAZY_PBF_BLOCK_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/delta.hpp>
+
+#include <protozero/pbf_message.hpp>
+#include <protozero/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        class LazyPBFBlock;
+        class LazyPBFObject;
+
+        namespace detail {
+            struct lazy_fields;
+            struct lazy_info;
+        } // namespace detail
+
+        /**
+         * A tag of a LazyPBFObject. Key and value point into the string
+         * table of the block, they are not null-terminated.
+         */
+        struct LazyTag {
+
+            protozero::data_view key;
+            protozero::data_view value;
+
+        }; // struct LazyTag
+
+        /**
+         * A member of a lazily decoded relation. The role points into the
+         * string table of the block, it is not null-terminated.
+         */
+        struct LazyMember {
+
+            osmium::item_type type;
+            osmium::object_id_type ref;
+            protozero::data_view role;
+
+        }; // struct LazyMember
+
+        namespace detail {
+
+            inline bool lazy_string_equal(const protozero::data_view& view, const char* str) noexcept {
+                const auto len = std::strlen(str);
+                return view.size() == len && (len == 0 || std::memcmp(view.data(), str, len) == 0);
+            }
+
+        } // namespace detail
+
+        /**
+         * The tags of a LazyPBFObject. They are decoded while iterating.
+         */
+        class LazyTagList {
+
+            const LazyPBFBlock* m_block = nullptr;
+
+            // Tags of dense nodes are pairs of string ids terminated by 0,
+            // other objects have separate arrays of key and value ids.
+            detail::varint_range m_keys_vals;
+            detail::varint_range m_keys;
+            detail::varint_range m_vals;
+            bool m_dense = false;
+
+        public:
+
+            class const_iterator {
+
+                const LazyPBFBlock* m_block = nullptr;
+                detail::varint_range m_keys_vals;
+                detail::varint_range m_keys;
+                detail::varint_range m_vals;
+                bool m_dense = false;
+                bool m_end = true;
+                LazyTag m_tag{};
+
+                void next();
+
+            public:
+
+                using iterator_category = std::input_iterator_tag;
+                using value_type        = LazyTag;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const LazyTag*;
+                using reference         = const LazyTag&;
+
+                const_iterator() noexcept = default;
+
+                const_iterator(const LazyTagList& list) : // NOLINT(google-explicit-constructor, hicpp-explicit-conversions)
+                    m_block(list.m_block),
+                    m_keys_vals(list.m_keys_vals),
+                    m_keys(list.m_keys),
+                    m_vals(list.m_vals),
+                    m_dense(list.m_dense),
+                    m_end(false) {
+                    next();
+                }
+
+                const_iterator& operator++() {
+                    next();
+                    return *this;
+                }
+
+                const_iterator operator++(int) {
+                    const_iterator tmp{*this};
+                    next();
+                    return tmp;
+                }
+
+                /**
+                 * The tag is decoded into the iterator itself, the
+                 * reference is only valid while the iterator exists and
+                 * until it is incremented. Copy the tag if it is needed
+                 * for longer.
+                 */
+                reference operator*() const noexcept {
+                    return m_tag;
+                }
+
+                pointer operator->() const noexcept {
+                    return &m_tag;
+                }
+
+                bool operator==(const const_iterator& rhs) const noexcept {
+                    return m_end && rhs.m_end;
+                }
+
+                bool operator!=(const const_iterator& rhs) const noexcept {
+                    return !(*this == rhs);
+                }
+
+            }; // class const_iterator
+
+            LazyTagList() noexcept = default;
+
+            LazyTagList(const LazyPBFBlock* block, const detail::varint_range& keys_vals) noexcept :
+                m_block(block),
+                m_keys_vals(keys_vals),
+                m_dense(true) {
+            }
+
+            LazyTagList(const LazyPBFBlock* block, const detail::varint_range& keys, const detail::varint_range& vals) noexcept :
+                m_block(block),
+                m_keys(keys),
+                m_vals(vals) {
+            }
+
+            bool empty() const noexcept {
+                return m_dense ? (m_keys_vals.empty() || begin() == end()) : (m_keys.empty() || m_vals.empty());
+            }
+
+            const_iterator begin() const {
+                return const_iterator{*this};
+            }
+
+            const_iterator end() const noexcept {
+                return const_iterator{};
+            }
+
+            /**
+             * Get the value of the tag with the given key. Returns a
+             * data_view with nullptr as data if there is no such tag.
+             */
+            protozero::data_view get_value_by_key(const char* key) const {
+                for (const auto& tag : *this) {
+                    if (detail::lazy_string_equal(tag.key, key)) {
+                        return tag.value;
+                    }
+                }
+                return protozero::data_view{};
+            }
+
+            bool has_key(const char* key) const {
+                return get_value_by_key(key).data() != nullptr;
+            }
+
+            bool has_tag(const char* key, const char* value) const {
+                const auto v = get_value_by_key(key);
+                return v.data() != nullptr && detail::lazy_string_equal(v, value);
+            }
+
+        }; // class LazyTagList
+
+        /**
+         * The node ids of a lazily decoded way. They are delta decoded
+         * while iterating.
+         */
+        class LazyWayNodeList {
+
+            detail::varint_range m_refs;
+
+        public:
+
+            class const_iterator {
+
+                detail::varint_range m_refs;
+                osmium::DeltaDecode<int64_t> m_delta;
+                osmium::object_id_type m_ref = 0;
+                bool m_end = true;
+
+                void next() {
+                    if (m_refs.empty()) {
+                        m_end = true;
+                        return;
+                    }
+                    m_ref = m_delta.update(m_refs.next_sint64());
+                }
+
+            public:
+
+                using iterator_category = std::input_iterator_tag;
+                using value_type        = osmium::object_id_type;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const osmium::object_id_type*;
+                using reference         = const osmium::object_id_type&;
+
+                const_iterator() noexcept = default;
+
+                explicit const_iterator(const detail::varint_range& refs) :
+                    m_refs(refs),
+                    m_end(false) {
+                    next();
+                }
+
+                const_iterator& operator++() {
+                    next();
+                    return *this;
+                }
+
+                const_iterator operator++(int) {
+                    const_iterator tmp{*this};
+                    next();
+                    return tmp;
+                }
+
+                reference operator*() const noexcept {
+                    return m_ref;
+                }
+
+                bool operator==(const const_iterator& rhs) const noexcept {
+                    return m_end && rhs.m_end;
+                }
+
+                bool operator!=(const const_iterator& rhs) const noexcept {
+                    return !(*this == rhs);
+                }
+
+            }; // class const_iterator
+
+            LazyWayNodeList() noexcept = default;
+
+            explicit LazyWayNodeList(const detail::varint_range& refs) noexcept :
+                m_refs(refs) {
+            }
+
+            bool empty() const noexcept {
+                return m_refs.empty();
+            }
+
+            /// Number of nodes. This is cheap, the ids are not decoded.
+            std::size_t size() const noexcept {
+                return m_refs.size();
+            }
+
+            const_iterator begin() const {
+                return const_iterator{m_refs};
+            }
+
+            const_iterator end() const noexcept {
+                return const_iterator{};
+            }
+
+        }; // class LazyWayNodeList
+
+        /**
+         * The members of a lazily decoded relation. They are decoded
+         * while iterating.
+         */
+        class LazyRelationMemberList {
+
+            const LazyPBFBlock* m_block = nullptr;
+            detail::varint_range m_roles;
+            detail::varint_range m_refs;
+            detail::varint_range m_types;
+
+        public:
+
+            class const_iterator {
+
+                const LazyPBFBlock* m_block = nullptr;
+                detail::varint_range m_roles;
+                detail::varint_range m_refs;
+                detail::varint_range m_types;
+                osmium::DeltaDecode<int64_t> m_delta;
+                bool m_end = true;
+                LazyMember m_member{};
+
+                void next();
+
+            public:
+
+                using iterator_category = std::input_iterator_tag;
+                using value_type        = LazyMember;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const LazyMember*;
+                using reference         = const LazyMember&;
+
+                const_iterator() noexcept = default;
+
+                explicit const_iterator(const LazyRelationMemberList& list) :
+                    m_block(list.m_block),
+                    m_roles(list.m_roles),
+                    m_refs(list.m_refs),
+                    m_types(list.m_types),
+                    m_end(false) {
+                    next();
+                }
+
+                const_iterator& operator++() {
+                    next();
+                    return *this;
+                }
+
+                const_iterator operator++(int) {
+                    const_iterator tmp{*this};
+                    next();
+                    return tmp;
+                }
+
+                /**
+                 * The member is decoded into the iterator itself, the
+                 * reference is only valid while the iterator exists and
+                 * until it is incremented. Copy the member if it is needed
+                 * for longer.
+                 */
+                reference operator*() const noexcept {
+                    return m_member;
+                }
+
+                pointer operator->() const noexcept {
+                    return &m_member;
+                }
+
+                bool operator==(const const_iterator& rhs) const noexcept {
+                    return m_end && rhs.m_end;
+                }
+
+                bool operator!=(const const_iterator& rhs) const noexcept {
+                    return !(*this == rhs);
+                }
+
+            }; // class const_iterator
+
+            LazyRelationMemberList() noexcept = default;
+
+            LazyRelationMemberList(const LazyPBFBlock* block, const detail::varint_range& roles, const detail::varint_range& refs, const detail::varint_range& types) noexcept :
+                m_block(block),
+                m_roles(roles),
+                m_refs(refs),
+                m_types(types) {
+            }
+
+            bool empty() const noexcept {
+                return m_refs.empty();
+            }
+
+            /// Number of members. This is cheap, nothing is decoded.
+            std::size_t size() const noexcept {
+                return m_refs.size();
+            }
+
+            const_iterator begin() const {
+                return const_iterator{*this};
+            }
+
+            const_iterator end() const noexcept {
+                return const_iterator{};
+            }
+
+        }; // class LazyRelationMemberList
+
+        /**
+         * A view on a node, way, or relation in a LazyPBFBlock. It only
+         * knows where the object is in the block, everything except the
+         * type is decoded from the PBF data when it is accessed. Views are
+         * cheap to copy, but they are only valid as long as the block
+         * they came from exists and hasn't been moved. Use materialize()
+         * to get a real OSM object that can outlive the block.
+         */
+        class LazyPBFObject {
+
+            friend class LazyPBFBlock;
+
+            const LazyPBFBlock* m_block;
+            std::size_t m_index;
+
+            LazyPBFObject(const LazyPBFBlock* block, std::size_t index) noexcept :
+                m_block(block),
+                m_index(index) {
+            }
+
+            bool dense() const noexcept;
+
+            detail::lazy_fields fields() const;
+
+            detail::lazy_info info() const;
+
+            template <typename TBuilder>
+            void set_info(TBuilder& builder, const detail::lazy_info& info) const;
+
+        public:
+
+            /// The type of the object (node, way, or relation).
+            osmium::item_type type() const noexcept;
+
+            osmium::object_id_type id() const;
+
+            /// Version of the object or 0 if the block has no metadata.
+            osmium::object_version_type version() const;
+
+            /// Timestamp of the object, invalid if the block has no metadata.
+            osmium::Timestamp timestamp() const;
+
+            /// Changeset id of the object or 0 if the block has no metadata.
+            osmium::changeset_id_type changeset() const;
+
+            /// User id of the object or 0 if the block has no metadata.
+            osmium::user_id_type uid() const;
+
+            /// User name of the object (not null-terminated).
+            protozero::data_view user() const;
+
+            bool visible() const;
+
+            /// Location of a node, invalid for other objects and deleted nodes.
+            osmium::Location location() const;
+
+            LazyTagList tags() const;
+
+            /// Node ids of a way, empty for other objects.
+            LazyWayNodeList nodes() const;
+
+            /// Members of a relation, empty for other objects.
+            LazyRelationMemberList members() const;
+
+            /**
+             * Build a complete OSM object (including all tags and
+             * metadata) from this view in the buffer and commit it.
+             *
+             * @returns The offset of the new object in the buffer.
+             * @throws osmium::pbf_error If the PBF data is invalid.
+             */
+            std::size_t materialize(osmium::memory::Buffer& buffer) const;
+
+        }; // class LazyPBFObject
+
+        /**
+         * An uncompressed PBF data block with an index of the objects in
+         * it. Creating it only finds the objects in the block (and
+         * decodes the ids and locations of dense nodes, because they are
+         * delta encoded), no objects are built. Everything else is only
+         * decoded when accessed through the LazyPBFObject views.
+         *
+         * Changesets are not supported and ignored.
+         *
+         * A block and its views may be used from only one thread at a
+         * time, because the metadata of dense nodes is decoded into a
+         * cache on first access.
+         */
+        class LazyPBFBlock {
+
+            friend class LazyPBFObject;
+            friend class LazyTagList::const_iterator;
+            friend class LazyRelationMemberList::const_iterator;
+
+            struct dense_group {
+                std::vector<int64_t> ids;
+                std::vector<int64_t> lons;
+                std::vector<int64_t> lats;
+
+                // Start of the tags of each node in keys_vals.
+                std::vector<const char*> tags;
+                const char* tags_end = nullptr;
+
+                protozero::data_view info;
+
+                // Metadata, decoded when first needed.
+                mutable bool info_decoded = false;
+                mutable std::vector<int32_t> versions;
+                mutable std::vector<int64_t> timestamps;
+                mutable std::vector<int64_t> changesets;
+                mutable std::vector<int32_t> uids;
+                mutable std::vector<int32_t> user_sids;
+                mutable std::vector<uint8_t> visibles;
+            };
+
+            struct entry {
+                protozero::data_view message; // empty for dense nodes
+                uint32_t group; // dense group
+                uint32_t index; // index in dense group
+                osmium::item_type type;
+            };
+
+            detail::pbf_blob_buffer m_output;
+            protozero::data_view m_data;
+            std::vector<protozero::data_view> m_stringtable;
+
+            int64_t m_lon_offset = 0;
+            int64_t m_lat_offset = 0;
+            int64_t m_date_factor = 1000;
+            int32_t m_granularity = 100;
+
+            std::vector<dense_group> m_dense_groups;
+            std::vector<entry> m_entries;
+
+            const protozero::data_view& string(uint32_t n) const {
+                if (n >= m_stringtable.size()) {
+                    throw osmium::pbf_error{"string id out of range"};
+                }
+                return m_stringtable[n];
+            }
+
+            int32_t convert_pbf_lon(const int64_t c) const noexcept {
+                return int32_t((c * m_granularity + m_lon_offset) / detail::resolution_convert);
+            }
+
+            int32_t convert_pbf_lat(const int64_t c) const noexcept {
+                return int32_t((c * m_granularity + m_lat_offset) / detail::resolution_convert);
+            }
+
+            void decode_stringtable(const protozero::data_view& data) {
+                if (!m_stringtable.empty()) {
+                    throw osmium::pbf_error{"more than one stringtable in pbf file"};
+                }
+
+                protozero::pbf_message<detail::OSMFormat::StringTable> pbf_string_table{data};
+                while (pbf_string_table.next(detail::OSMFormat::StringTable::repeated_bytes_s, protozero::pbf_wire_type::length_delimited)) {
+                    const auto str_view = pbf_string_table.get_view();
+                    if (str_view.size() > osmium::max_osm_string_length) {
+                        throw osmium::pbf_error{"overlong string in string table"};
+                    }
+                    m_stringtable.push_back(str_view);
+                }
+            }
+
+            void add_dense_nodes(const protozero::data_view& data) {
+                detail::varint_range ids;
+                detail::varint_range lats;
+                detail::varint_range lons;
+                const char* tags_begin = nullptr;
+
+                m_dense_groups.emplace_back();
+                auto& group = m_dense_groups.back();
+
+                protozero::pbf_message<detail::OSMFormat::DenseNodes> pbf_dense_nodes{data};
+                while (pbf_dense_nodes.next()) {
+                    switch (pbf_dense_nodes.tag_and_type()) {
+                        case protozero::tag_and_type(detail::OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
+                            ids = detail::varint_range{pbf_dense_nodes.get_view()};
+                            break;
+                        case protozero::tag_and_type(detail::OSMFormat::DenseNodes::optional_DenseInfo_denseinfo, protozero::pbf_wire_type::length_delimited):
+                            group.info = pbf_dense_nodes.get_view();
+                            break;
+                        case protozero::tag_and_type(detail::OSMFormat::DenseNodes::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
+                            lats = detail::varint_range{pbf_dense_nodes.get_view()};
+                            break;
+                        case protozero::tag_and_type(detail::OSMFormat::DenseNodes::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
+                            lons = detail::varint_range{pbf_dense_nodes.get_view()};
+                            break;
+                        case protozero::tag_and_type(detail::OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
+                            {
+                                const auto view = pbf_dense_nodes.get_view();
+                                tags_begin = view.data();
+                                group.tags_end = view.data() + view.size();
+                            }
+                            break;
+                        default:
+                            pbf_dense_nodes.skip();
+                    }
+                }
+
+                ids.decode_delta_sint64(group.ids);
+                lons.decode_delta_sint64(group.lons);
+                lats.decode_delta_sint64(group.lats);
+                if (group.lons.size() < group.ids.size() ||
+                    group.lats.size() < group.ids.size()) {
+                    // this is against the spec, must have same number of elements
+                    throw osmium::pbf_error{"PBF format error"};
+                }
+
+                // Find where the tags of each node start. The tags of
+                // each node end with a 0 which is always a single byte,
+                // so only the varint boundaries have to be found.
+                group.tags.reserve(group.ids.size());
+                const char* pos = tags_begin;
+                for (std::size_t i = 0; i < group.ids.size(); ++i) {
+                    group.tags.push_back(pos);
+                    while (pos < group.tags_end) {
+                        if (*pos == 0) {
+                            ++pos;
+                            break;
+                        }
+                        while (pos < group.tags_end && (static_cast<unsigned char>(*pos) & 0x80U)) {
+                            ++pos;
+                        }
+                        if (pos < group.tags_end) {
+                            ++pos;
+                        }
+                    }
+                }
+
+                const auto group_index = static_cast<uint32_t>(m_dense_groups.size() - 1);
+                for (std::size_t i = 0; i < group.ids.size(); ++i) {
+                    m_entries.push_back(entry{protozero::data_view{}, group_index, static_cast<uint32_t>(i), osmium::item_type::node});
+                }
+            }
+
+            void decode_dense_info(const dense_group& group) const {
+                group.info_decoded = true;
+                if (group.info.empty()) {
+                    return;
+                }
+
+                detail::varint_range versions;
+                detail::varint_range timestamps;
+                detail::varint_range changesets;
+                detail::varint_range uids;
+                detail::varint_range user_sids;
+                detail::varint_range visibles;
+
+                protozero::pbf_message<detail::OSMFormat::DenseInfo> pbf_dense_info{group.info};
+                while (pbf_dense_info.next()) {
+                    switch (pbf_dense_info.tag_and_type()) {
+                        case protozero::tag_and_type(detail::OSMFormat::DenseInfo::packed_int32_version, protozero::pbf_wire_type::length_delimited):
+                            versions = detail::varint_range{pbf_dense_info.get_view()};
+                            break;
+                        case protozero::tag_and_type(detail::OSMFormat::DenseInfo::packed_sint64_timestamp, protozero::pbf_wire_type::length_delimited):
+                            timestamps = detail::varint_range{pbf_dense_info.get_view()};
+                            break;
+                        case protozero::tag_and_type(detail::OSMFormat::DenseInfo::packed_sint64_changeset, protozero::pbf_wire_type::length_delimited):
+                            changesets = detail::varint_range{pbf_dense_info.get_view()};
+                            break;
+                        case protozero::tag_and_type(detail::OSMFormat::DenseInfo::packed_sint32_uid, protozero::pbf_wire_type::length_delimited):
+                            uids = detail::varint_range{pbf_dense_info.get_view()};
+                            break;
+                        case protozero::tag_and_type(detail::OSMFormat::DenseInfo::packed_sint32_user_sid, protozero::pbf_wire_type::length_delimited):
+                            user_sids = detail::varint_range{pbf_dense_info.get_view()};
+                            break;
+                        case protozero::tag_and_type(detail::OSMFormat::DenseInfo::packed_bool_visible, protozero::pbf_wire_type::length_delimited):
+                            visibles = detail::varint_range{pbf_dense_info.get_view()};
+                            break;
+                        default:
+                            pbf_dense_info.skip();
+                    }
+                }
+
+                osmium::DeltaDecode<int64_t> timestamp;
+                osmium::DeltaDecode<int64_t> changeset;
+                osmium::DeltaDecode<int64_t> uid;
+                osmium::DeltaDecode<int64_t> user_sid;
+                while (!versions.empty()) {
+                    group.versions.push_back(versions.next_int32());
+                }
+                while (!timestamps.empty()) {
+                    group.timestamps.push_back(timestamp.update(timestamps.next_sint64()));
+                }
+                while (!changesets.empty()) {
+                    group.changesets.push_back(changeset.update(changesets.next_sint64()));
+                }
+                while (!uids.empty()) {
+                    group.uids.push_back(static_cast<int32_t>(uid.update(uids.next_sint32())));
+                }
+                while (!user_sids.empty()) {
+                    group.user_sids.push_back(static_cast<int32_t>(user_sid.update(user_sids.next_sint32())));
+                }
+                while (!visibles.empty()) {
+                    group.visibles.push_back(visibles.next_int32() != 0 ? 1 : 0);
+                }
+            }
+
+            const dense_group& dense_info(const entry& e) const {
+                const auto& group = m_dense_groups[e.group];
+                if (!group.info_decoded) {
+                    decode_dense_info(group);
+                }
+                return group;
+            }
+
+            void index_block(osmium::osm_entity_bits::type read_types) {
+                using detail::OSMFormat::PrimitiveBlock;
+                using detail::OSMFormat::PrimitiveGroup;
+
+                protozero::pbf_message<PrimitiveBlock> pbf_primitive_block{m_data};
+                while (pbf_primitive_block.next()) {
+                    switch (pbf_primitive_block.tag_and_type()) {
+                        case protozero::tag_and_type(PrimitiveBlock::required_StringTable_stringtable, protozero::pbf_wire_type::length_delimited):
+                            decode_stringtable(pbf_primitive_block.get_view());
+                            break;
+                        case protozero::tag_and_type(PrimitiveBlock::optional_int32_granularity, protozero::pbf_wire_type::varint):
+                            m_granularity = pbf_primitive_block.get_int32();
+                            break;
+                        case protozero::tag_and_type(PrimitiveBlock::optional_int32_date_granularity, protozero::pbf_wire_type::varint):
+                            m_date_factor = pbf_primitive_block.get_int32();
+                            break;
+                        case protozero::tag_and_type(PrimitiveBlock::optional_int64_lat_offset, protozero::pbf_wire_type::varint):
+                            m_lat_offset = pbf_primitive_block.get_int64();
+                            break;
+                        case protozero::tag_and_type(PrimitiveBlock::optional_int64_lon_offset, protozero::pbf_wire_type::varint):
+                            m_lon_offset = pbf_primitive_block.get_int64();
+                            break;
+                        case protozero::tag_and_type(PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited):
+                            {
+                                protozero::pbf_message<PrimitiveGroup> pbf_primitive_group = pbf_primitive_block.get_message();
+                                while (pbf_primitive_group.next()) {
+                                    switch (pbf_primitive_group.tag_and_type()) {
+                                        case protozero::tag_and_type(PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
+                                            if (read_types & osmium::osm_entity_bits::node) {
+                                                m_entries.push_back(entry{pbf_primitive_group.get_view(), 0, 0, osmium::item_type::node});
+                                            } else {
+                                                pbf_primitive_group.skip();
+                                            }
+                                            break;
+                                        case protozero::tag_and_type(PrimitiveGroup::optional_DenseNodes_dense, protozero::pbf_wire_type::length_delimited):
+                                            if (read_types & osmium::osm_entity_bits::node) {
+                                                add_dense_nodes(pbf_primitive_group.get_view());
+                                            } else {
+                                                pbf_primitive_group.skip();
+                                            }
+                                            break;
+                                        case protozero::tag_and_type(PrimitiveGroup::repeated_Way_ways, protozero::pbf_wire_type::length_delimited):
+                                            if (read_types & osmium::osm_entity_bits::way) {
+                                                m_entries.push_back(entry{pbf_primitive_group.get_view(), 0, 0, osmium::item_type::way});
+                                            } else {
+                                                pbf_primitive_group.skip();
+                                            }
+                                            break;
+                                        case protozero::tag_and_type(PrimitiveGroup::repeated_Relation_relations, protozero::pbf_wire_type::length_delimited):
+                                            if (read_types & osmium::osm_entity_bits::relation) {
+                                                m_entries.push_back(entry{pbf_primitive_group.get_view(), 0, 0, osmium::item_type::relation});
+                                            } else {
+                                                pbf_primitive_group.skip();
+                                            }
+                                            break;
+                                        default:
+                                            pbf_primitive_group.skip();
+                                    }
+                                }
+                            }
+                            break;
+                        default:
+                            pbf_primitive_block.skip();
+                    }
+                }
+            }
+
+        public:
+
+            class const_iterator {
+
+                const LazyPBFBlock* m_block = nullptr;
+                std::size_t m_index = 0;
+
+            public:
+
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type        = LazyPBFObject;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = void;
+                using reference         = LazyPBFObject;
+
+                const_iterator() noexcept = default;
+
+                const_iterator(const LazyPBFBlock* block, std::size_t index) noexcept :
+                    m_block(block),
+                    m_index(index) {
+                }
+
+                const_iterator& operator++() noexcept {
+                    ++m_index;
+                    return *this;
+                }
+
+                const_iterator operator++(int) noexcept {
+                    const_iterator tmp{*this};
+                    ++m_index;
+                    return tmp;
+                }
+
+                LazyPBFObject operator*() const noexcept {
+                    return LazyPBFObject{m_block, m_index};
+                }
+
+                difference_type operator-(const const_iterator& rhs) const noexcept {
+                    return static_cast<difference_type>(m_index) - static_cast<difference_type>(rhs.m_index);
+                }
+
+                bool operator==(const const_iterator& rhs) const noexcept {
+                    return m_index == rhs.m_index;
+                }
+
+                bool operator!=(const const_iterator& rhs) const noexcept {
+                    return m_index != rhs.m_index;
+                }
+
+            }; // class const_iterator
+
+            /**
+             * Create a block from the uncompressed data of a PBF
+             * PrimitiveBlock. The data must stay valid as long as the
+             * block is used.
+             *
+             * @param data The uncompressed block data.
+             * @param read_types Which entity types to index.
+             * @throws osmium::pbf_error If the data is invalid.
+             */
+            explicit LazyPBFBlock(const protozero::data_view& data, osmium::osm_entity_bits::type read_types = osmium::osm_entity_bits::nwr) :
+                m_data(data) {
+                index_block(read_types);
+            }
+
+            /**
+             * Create a block from a (possibly compressed) Blob message.
+             * The data is uncompressed into memory owned by the block. If
+             * the blob isn't compressed, the block refers to the blob
+             * data which must stay valid as long as the block is used.
+             *
+             * @param blob_data The Blob message.
+             * @param read_types Which entity types to index.
+             * @throws osmium::pbf_error If the data is invalid.
+             */
+            LazyPBFBlock(const protozero::data_view& blob_data, detail::pbf_blob_buffer&& output, osmium::osm_entity_bits::type read_types = osmium::osm_entity_bits::nwr) :
+                m_output(std::move(output)),
+                m_data(detail::decode_blob(blob_data, m_output)) {
+                index_block(read_types);
+            }
+
+            LazyPBFBlock(const LazyPBFBlock&) = delete;
+            LazyPBFBlock& operator=(const LazyPBFBlock&) = delete;
+
+            LazyPBFBlock(LazyPBFBlock&&) = default;
+            LazyPBFBlock& operator=(LazyPBFBlock&&) = default;
+
+            ~LazyPBFBlock() noexcept = default;
+
+            /// The number of objects in the block.
+            std::size_t size() const noexcept {
+                return m_entries.size();
+            }
+
+            bool empty() const noexcept {
+                return m_entries.empty();
+            }
+
+            LazyPBFObject operator[](std::size_t n) const noexcept {
+                return LazyPBFObject{this, n};
+            }
+
+            const_iterator begin() const noexcept {
+                return const_iterator{this, 0};
+            }
+
+            const_iterator end() const noexcept {
+                return const_iterator{this, m_entries.size()};
+            }
+
+            /**
+             * Build complete OSM objects from all views in the block
+             * into the buffer.
+             */
+            void materialize(osmium::memory::Buffer& buffer) const {
+                for (const auto object : *this) {
+                    object.materialize(buffer);
+                }
+            }
+
+        }; // class LazyPBFBlock
+
+        namespace detail {
+
+            // Fields of a Node, Way, or Relation message. Everything is
+            // only found, not decoded.
+            struct lazy_fields {
+                int64_t id = 0;
+                varint_range keys;
+                varint_range vals;
+                protozero::data_view info;
+                int64_t lat = std::numeric_limits<int64_t>::max();
+                int64_t lon = std::numeric_limits<int64_t>::max();
+                varint_range refs;
+                varint_range lats;
+                varint_range lons;
+                varint_range roles;
+                varint_range types;
+            };
+
+            inline lazy_fields lazy_parse_node(const protozero::data_view& data) {
+                lazy_fields fields;
+                protozero::pbf_message<OSMFormat::Node> pbf_node{data};
+                while (pbf_node.next()) {
+                    switch (pbf_node.tag_and_type()) {
+                        case protozero::tag_and_type(OSMFormat::Node::required_sint64_id, protozero::pbf_wire_type::varint):
+                            fields.id = pbf_node.get_sint64();
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Node::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                            fields.keys = varint_range{pbf_node.get_view()};
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Node::packed_uint32_vals, protozero::pbf_wire_type::length_delimited):
+                            fields.vals = varint_range{pbf_node.get_view()};
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Node::optional_Info_info, protozero::pbf_wire_type::length_delimited):
+                            fields.info = pbf_node.get_view();
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Node::required_sint64_lat, protozero::pbf_wire_type::varint):
+                            fields.lat = pbf_node.get_sint64();
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Node::required_sint64_lon, protozero::pbf_wire_type::varint):
+                            fields.lon = pbf_node.get_sint64();
+                            break;
+                        default:
+                            pbf_node.skip();
+                    }
+                }
+                return fields;
+            }
+
+            inline lazy_fields lazy_parse_way(const protozero::data_view& data) {
+                lazy_fields fields;
+                protozero::pbf_message<OSMFormat::Way> pbf_way{data};
+                while (pbf_way.next()) {
+                    switch (pbf_way.tag_and_type()) {
+                        case protozero::tag_and_type(OSMFormat::Way::required_int64_id, protozero::pbf_wire_type::varint):
+                            fields.id = pbf_way.get_int64();
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Way::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                            fields.keys = varint_range{pbf_way.get_view()};
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Way::packed_uint32_vals, protozero::pbf_wire_type::length_delimited):
+                            fields.vals = varint_range{pbf_way.get_view()};
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Way::optional_Info_info, protozero::pbf_wire_type::length_delimited):
+                            fields.info = pbf_way.get_view();
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Way::packed_sint64_refs, protozero::pbf_wire_type::length_delimited):
+                            fields.refs = varint_range{pbf_way.get_view()};
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Way::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
+                            fields.lats = varint_range{pbf_way.get_view()};
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Way::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
+                            fields.lons = varint_range{pbf_way.get_view()};
+                            break;
+                        default:
+                            pbf_way.skip();
+                    }
+                }
+                return fields;
+            }
+
+            inline lazy_fields lazy_parse_relation(const protozero::data_view& data) {
+                lazy_fields fields;
+                protozero::pbf_message<OSMFormat::Relation> pbf_relation{data};
+                while (pbf_relation.next()) {
+                    switch (pbf_relation.tag_and_type()) {
+                        case protozero::tag_and_type(OSMFormat::Relation::required_int64_id, protozero::pbf_wire_type::varint):
+                            fields.id = pbf_relation.get_int64();
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Relation::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                            fields.keys = varint_range{pbf_relation.get_view()};
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Relation::packed_uint32_vals, protozero::pbf_wire_type::length_delimited):
+                            fields.vals = varint_range{pbf_relation.get_view()};
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Relation::optional_Info_info, protozero::pbf_wire_type::length_delimited):
+                            fields.info = pbf_relation.get_view();
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Relation::packed_int32_roles_sid, protozero::pbf_wire_type::length_delimited):
+                            fields.roles = varint_range{pbf_relation.get_view()};
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Relation::packed_sint64_memids, protozero::pbf_wire_type::length_delimited):
+                            fields.refs = varint_range{pbf_relation.get_view()};
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Relation::packed_MemberType_types, protozero::pbf_wire_type::length_delimited):
+                            fields.types = varint_range{pbf_relation.get_view()};
+                            break;
+                        default:
+                            pbf_relation.skip();
+                    }
+                }
+                return fields;
+            }
+
+            // Metadata of one object in the PBF representation.
+            struct lazy_info {
+                int32_t version = 0;
+                int64_t timestamp = 0;
+                int64_t changeset = 0;
+                int32_t uid = 0;
+                int64_t user_sid = -1;
+                bool visible = true;
+                bool has_timestamp = false;
+            };
+
+            inline lazy_info lazy_parse_info(const protozero::data_view& data) {
+                lazy_info info;
+                if (data.empty()) {
+                    return info;
+                }
+                protozero::pbf_message<OSMFormat::Info> pbf_info{data};
+                while (pbf_info.next()) {
+                    switch (pbf_info.tag_and_type()) {
+                        case protozero::tag_and_type(OSMFormat::Info::optional_int32_version, protozero::pbf_wire_type::varint):
+                            info.version = pbf_info.get_int32();
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Info::optional_int64_timestamp, protozero::pbf_wire_type::varint):
+                            info.timestamp = pbf_info.get_int64();
+                            info.has_timestamp = true;
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Info::optional_int64_changeset, protozero::pbf_wire_type::varint):
+                            info.changeset = pbf_info.get_int64();
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Info::optional_int32_uid, protozero::pbf_wire_type::varint):
+                            info.uid = pbf_info.get_int32();
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Info::optional_uint32_user_sid, protozero::pbf_wire_type::varint):
+                            info.user_sid = pbf_info.get_uint32();
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Info::optional_bool_visible, protozero::pbf_wire_type::varint):
+                            info.visible = pbf_info.get_bool();
+                            break;
+                        default:
+                            pbf_info.skip();
+                    }
+                }
+                return info;
+            }
+
+        } // namespace detail
+
+        inline void LazyTagList::const_iterator::next() {
+            if (m_dense) {
+                if (m_keys_vals.empty()) {
+                    m_end = true;
+                    return;
+                }
+                const auto key = m_keys_vals.next_uint32();
+                if (key == 0) {
+                    m_end = true;
+                    return;
+                }
+                if (m_keys_vals.empty()) {
+                    throw osmium::pbf_error{"PBF format error"}; // this is against the spec, keys/vals must come in pairs
+                }
+                m_tag.key = m_block->string(key);
+                m_tag.value = m_block->string(m_keys_vals.next_uint32());
+                return;
+            }
+
+            if (m_keys.empty() || m_vals.empty()) {
+                m_end = true;
+                return;
+            }
+            m_tag.key = m_block->string(m_keys.next_uint32());
+            m_tag.value = m_block->string(m_vals.next_uint32());
+        }
+
+        inline void LazyRelationMemberList::const_iterator::next() {
+            if (m_roles.empty() || m_refs.empty() || m_types.empty()) {
+                m_end = true;
+                return;
+            }
+            m_member.role = m_block->string(m_roles.next_uint32());
+            const int type = m_types.next_int32();
+            if (type < 0 || type > 2) {
+                throw osmium::pbf_error{"unknown relation member type"};
+            }
+            m_member.type = osmium::item_type(type + 1);
+            m_member.ref = m_delta.update(m_refs.next_sint64());
+        }
+
+        namespace detail {
+
+            inline osmium::object_version_type lazy_version(int32_t version) {
+                if (version < -1) {
+                    throw osmium::pbf_error{"object version must not be negative"};
+                }
+                return version == -1 ? 0U : static_cast<osmium::object_version_type>(version);
+            }
+
+            inline osmium::changeset_id_type lazy_changeset(int64_t changeset_id) {
+                if (changeset_id < -1 || changeset_id >= std::numeric_limits<changeset_id_type>::max()) {
+                    throw osmium::pbf_error{"object changeset_id must be between 0 and 2^32-1"};
+                }
+                return changeset_id == -1 ? 0U : static_cast<osmium::changeset_id_type>(changeset_id);
+            }
+
+            inline osmium::user_id_type lazy_uid(int32_t uid) noexcept {
+                return uid < 0 ? 0U : static_cast<osmium::user_id_type>(uid);
+            }
+
+            inline void lazy_add_tags(osmium::builder::Builder& parent, const LazyTagList& tags) {
+                if (tags.empty()) {
+                    return;
+                }
+                osmium::builder::TagListBuilder builder{parent};
+                for (const auto& tag : tags) {
+                    builder.add_tag(tag.key.data(), tag.key.size(), tag.value.data(), tag.value.size());
+                }
+            }
+
+        } // namespace detail
+
+        inline osmium::item_type LazyPBFObject::type() const noexcept {
+            return m_block->m_entries[m_index].type;
+        }
+
+        inline bool LazyPBFObject::dense() const noexcept {
+            return m_block->m_entries[m_index].message.data() == nullptr;
+        }
+
+        inline detail::lazy_fields LazyPBFObject::fields() const {
+            const auto& e = m_block->m_entries[m_index];
+            switch (e.type) {
+                case osmium::item_type::node:
+                    return detail::lazy_parse_node(e.message);
+                case osmium::item_type::way:
+                    return detail::lazy_parse_way(e.message);
+                default:
+                    break;
+            }
+            return detail::lazy_parse_relation(e.message);
+        }
+
+        inline detail::lazy_info LazyPBFObject::info() const {
+            if (!dense()) {
+                return detail::lazy_parse_info(fields().info);
+            }
+
+            const auto& e = m_block->m_entries[m_index];
+            const auto& group = m_block->dense_info(e);
+            const auto i = e.index;
+
+            detail::lazy_info info;
+            if (i < group.versions.size()) {
+                info.version = group.versions[i];
+            }
+            if (i < group.timestamps.size()) {
+                info.timestamp = group.timestamps[i];
+                info.has_timestamp = true;
+            }
+            if (i < group.changesets.size()) {
+                info.changeset = group.changesets[i];
+            }
+            if (i < group.uids.size()) {
+                info.uid = group.uids[i];
+            }
+            if (i < group.user_sids.size()) {
+                info.user_sid = group.user_sids[i];
+            }
+            if (i < group.visibles.size()) {
+                info.visible = group.visibles[i] != 0;
+            }
+            return info;
+        }
+
+        inline osmium::object_id_type LazyPBFObject::id() const {
+            const auto& e = m_block->m_entries[m_index];
+            if (dense()) {
+                return m_block->m_dense_groups[e.group].ids[e.index];
+            }
+
+            // Only look for the id, it is usually the first field.
+            switch (e.type) {
+                case osmium::item_type::node:
+                    {
+                        protozero::pbf_message<detail::OSMFormat::Node> pbf_node{e.message};
+                        if (pbf_node.next(detail::OSMFormat::Node::required_sint64_id, protozero::pbf_wire_type::varint)) {
+                            return pbf_node.get_sint64();
+                        }
+                    }
+                    break;
+                case osmium::item_type::way:
+                    {
+                        protozero::pbf_message<detail::OSMFormat::Way> pbf_way{e.message};
+                        if (pbf_way.next(detail::OSMFormat::Way::required_int64_id, protozero::pbf_wire_type::varint)) {
+                            return pbf_way.get_int64();
+                        }
+                    }
+                    break;
+                default:
+                    {
+                        protozero::pbf_message<detail::OSMFormat::Relation> pbf_relation{e.message};
+                        if (pbf_relation.next(detail::OSMFormat::Relation::required_int64_id, protozero::pbf_wire_type::varint)) {
+                            return pbf_relation.get_int64();
+                        }
+                    }
+            }
+            return 0;
+        }
+
+        inline osmium::object_version_type LazyPBFObject::version() const {
+            return detail::lazy_version(info().version);
+        }
+
+        inline osmium::Timestamp LazyPBFObject::timestamp() const {
+            const auto i = info();
+            return i.has_timestamp ? osmium::Timestamp{i.timestamp * m_block->m_date_factor / 1000} : osmium::Timestamp{};
+        }
+
+        inline osmium::changeset_id_type LazyPBFObject::changeset() const {
+            return detail::lazy_changeset(info().changeset);
+        }
+
+        inline osmium::user_id_type LazyPBFObject::uid() const {
+            return detail::lazy_uid(info().uid);
+        }
+
+        inline protozero::data_view LazyPBFObject::user() const {
+            const auto i = info();
+            return i.user_sid >= 0 ? m_block->string(static_cast<uint32_t>(i.user_sid)) : protozero::data_view{"", 0};
+        }
+
+        inline bool LazyPBFObject::visible() const {
+            return info().visible;
+        }
+
+        inline osmium::Location LazyPBFObject::location() const {
+            if (type() != osmium::item_type::node) {
+                return osmium::Location{};
+            }
+
+            const auto& e = m_block->m_entries[m_index];
+            if (dense()) {
+                const auto& group = m_block->m_dense_groups[e.group];
+                // Invisible nodes still have a location in the dense
+                // arrays, but it is not used.
+                if (!group.info.empty() && !visible()) {
+                    return osmium::Location{};
+                }
+                return osmium::Location{m_block->convert_pbf_lon(group.lons[e.index]),
+                                        m_block->convert_pbf_lat(group.lats[e.index])};
+            }
+
+            const auto f = fields();
+            if (!detail::lazy_parse_info(f.info).visible) {
+                return osmium::Location{};
+            }
+            if (f.lon == std::numeric_limits<int64_t>::max() ||
+                f.lat == std::numeric_limits<int64_t>::max()) {
+                throw osmium::pbf_error{"illegal coordinate format"};
+            }
+            return osmium::Location{m_block->convert_pbf_lon(f.lon), m_block->convert_pbf_lat(f.lat)};
+        }
+
+        inline LazyTagList LazyPBFObject::tags() const {
+            if (dense()) {
+                const auto& e = m_block->m_entries[m_index];
+                const auto& group = m_block->m_dense_groups[e.group];
+                const char* begin = group.tags[e.index];
+                if (!begin) {
+                    return LazyTagList{};
+                }
+                return LazyTagList{m_block, detail::varint_range{protozero::data_view{begin, static_cast<std::size_t>(group.tags_end - begin)}}};
+            }
+            const auto f = fields();
+            return LazyTagList{m_block, f.keys, f.vals};
+        }
+
+        inline LazyWayNodeList LazyPBFObject::nodes() const {
+            if (type() != osmium::item_type::way) {
+                return LazyWayNodeList{};
+            }
+            return LazyWayNodeList{fields().refs};
+        }
+
+        inline LazyRelationMemberList LazyPBFObject::members() const {
+            if (type() != osmium::item_type::relation) {
+                return LazyRelationMemberList{};
+            }
+            const auto f = fields();
+            return LazyRelationMemberList{m_block, f.roles, f.refs, f.types};
+        }
+
+        template <typename TBuilder>
+        inline void LazyPBFObject::set_info(TBuilder& builder, const detail::lazy_info& info) const {
+            auto& object = builder.object();
+            object.set_version(detail::lazy_version(info.version));
+            object.set_changeset(detail::lazy_changeset(info.changeset));
+            if (info.has_timestamp) {
+                object.set_timestamp(info.timestamp * m_block->m_date_factor / 1000);
+            }
+            object.set_uid(detail::lazy_uid(info.uid));
+            object.set_visible(info.visible);
+            if (info.user_sid >= 0) {
+                const auto& user = m_block->string(static_cast<uint32_t>(info.user_sid));
+                builder.set_user(user.data(), static_cast<osmium::string_size_type>(user.size()));
+            }
+        }
+
+        inline std::size_t LazyPBFObject::materialize(osmium::memory::Buffer& buffer) const {
+            const auto object_info = info();
+            switch (type()) {
+                case osmium::item_type::node:
+                    {
+                        osmium::builder::NodeBuilder builder{buffer};
+                        builder.set_id(id());
+                        set_info(builder, object_info);
+                        builder.set_location(location());
+                        detail::lazy_add_tags(builder, tags());
+                    }
+                    break;
+                case osmium::item_type::way:
+                    {
+                        const auto f = fields();
+                        osmium::builder::WayBuilder builder{buffer};
+                        builder.set_id(f.id);
+                        set_info(builder, object_info);
+                        if (!f.refs.empty()) {
+                            osmium::builder::WayNodeListBuilder wnl_builder{builder};
+                            auto refs = f.refs;
+                            osmium::DeltaDecode<int64_t> ref;
+                            if (f.lats.empty()) {
+                                while (!refs.empty()) {
+                                    wnl_builder.add_node_ref(ref.update(refs.next_sint64()));
+                                }
+                            } else {
+                                auto lons = f.lons;
+                                auto lats = f.lats;
+                                osmium::DeltaDecode<int64_t> lon;
+                                osmium::DeltaDecode<int64_t> lat;
+                                while (!refs.empty() && !lons.empty() && !lats.empty()) {
+                                    const auto id = ref.update(refs.next_sint64());
+                                    const auto x = m_block->convert_pbf_lon(lon.update(lons.next_sint64()));
+                                    wnl_builder.add_node_ref(id, osmium::Location{x, m_block->convert_pbf_lat(lat.update(lats.next_sint64()))});
+                                }
+                            }
+                        }
+                        detail::lazy_add_tags(builder, LazyTagList{m_block, f.keys, f.vals});
+                    }
+                    break;
+                default:
+                    {
+                        const auto f = fields();
+                        osmium::builder::RelationBuilder builder{buffer};
+                        builder.set_id(f.id);
+                        set_info(builder, object_info);
+                        const LazyRelationMemberList members{m_block, f.roles, f.refs, f.types};
+                        if (!members.empty()) {
+                            osmium::builder::RelationMemberListBuilder rml_builder{builder};
+                            for (const auto& member : members) {
+                                rml_builder.add_member(member.type, member.ref, member.role.data(), member.role.size());
+                            }
+                        }
+                        detail::lazy_add_tags(builder, LazyTagList{m_block, f.keys, f.vals});
+                    }
+            }
+            return buffer.commit();
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_LAZY_PBF_BLOCK_HPP
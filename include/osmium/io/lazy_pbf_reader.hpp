@@ -0,0 +1,219 @@
+#ifndef OSMIUM_IO_LAZY_PBF_READER_HPP
+#define OSMIUM_IO_LAZY_PBF_READER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to read OSM PBF files through lazily
+ * decoded object views.
+ *
+ * @attention If you include this file, you'll need to link with
+ *            `libz`, and enable multithreading.
+ */
+
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_blob_table.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/lazy_pbf_block.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <protozero/types.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Reads an (uncompressed) PBF file into LazyPBFBlocks, one per
+         * data blob. The objects in the blocks are not built, they are
+         * only decoded as far as they are accessed through the
+         * LazyPBFObject views. This is much faster than going through
+         * the normal Reader if only a few of the objects or only some of
+         * their attributes (for instance the tags) are used. Objects
+         * needed after the block is gone can be copied into a buffer
+         * with LazyPBFObject::materialize().
+         *
+         * This is a separate class and not an option of the Reader,
+         * because the Reader always hands out Buffers.
+         *
+         * Blocks may refer to the memory mapped file, they must not be
+         * used after the reader is destroyed.
+         *
+         * Usage:
+         * @code
+         * osmium::io::LazyPBFReader reader{"planet.osm.pbf"};
+         * osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+         * reader.for_each_block([&](const osmium::io::LazyPBFBlock& block) {
+         *     for (const auto object : block) {
+         *         if (object.tags().has_tag("amenity", "school")) {
+         *             object.materialize(buffer);
+         *         }
+         *     }
+         * });
+         * @endcode
+         */
+        class LazyPBFReader {
+
+            osmium::util::MemoryMapping m_mapping;
+            detail::PBFBlobTable m_table;
+            osmium::io::Header m_header;
+
+            static osmium::util::MemoryMapping map_fd(int fd) {
+                const auto size = osmium::file_size(fd);
+                if (size == 0) {
+                    throw osmium::pbf_error{"empty file"};
+                }
+                return osmium::util::MemoryMapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, fd};
+            }
+
+            static osmium::util::MemoryMapping map_file(const std::string& filename) {
+                const int fd = detail::open_for_reading(filename);
+                try {
+                    osmium::util::MemoryMapping mapping{map_fd(fd)};
+                    detail::reliable_close(fd);
+                    return mapping;
+                } catch (...) {
+                    try {
+                        detail::reliable_close(fd);
+                    } catch (...) {
+                        // ignore errors on close, report original error
+                    }
+                    throw;
+                }
+            }
+
+            const char* data() const noexcept {
+                return m_mapping.get_addr<char>();
+            }
+
+            protozero::data_view blob_data(const detail::pbf_blob_info& blob) const noexcept {
+                return protozero::data_view{data() + blob.offset, blob.size};
+            }
+
+        public:
+
+            /**
+             * Open a PBF file for lazy reading.
+             *
+             * @param filename Name of the (uncompressed) PBF file.
+             * @throws osmium::pbf_error If the file is not a valid PBF file.
+             * @throws std::system_error If the file can not be opened or
+             *         mapped.
+             */
+            explicit LazyPBFReader(const std::string& filename) :
+                m_mapping(map_file(filename)),
+                m_table(detail::PBFBlobTable::from_memory(data(), m_mapping.size())) {
+                if (m_table.empty() || m_table[0].type != detail::pbf_blob_type::header) {
+                    throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                }
+                for (std::size_t n = 1; n < m_table.size(); ++n) {
+                    if (m_table[n].type != detail::pbf_blob_type::data) {
+                        throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                    }
+                }
+                m_header = detail::decode_header(blob_data(m_table[0]));
+            }
+
+            /// Get the header of the file.
+            const osmium::io::Header& header() const noexcept {
+                return m_header;
+            }
+
+            /// The number of data blobs in the file.
+            std::size_t num_data_blobs() const noexcept {
+                return m_table.size() - 1;
+            }
+
+            /**
+             * Uncompress the nth data blob and index the objects in it.
+             *
+             * @pre @code n < num_data_blobs() @endcode
+             */
+            LazyPBFBlock read_blob(std::size_t n, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr) const {
+                return LazyPBFBlock{blob_data(m_table[n + 1]), detail::pbf_blob_buffer{}, entities};
+            }
+
+            /**
+             * Uncompress and index all data blobs in the thread pool and
+             * call func with each resulting LazyPBFBlock in file order.
+             * The views are decoded in the thread calling this function.
+             * At most twice as many blocks as there are threads in the
+             * pool are in flight at any time.
+             *
+             * @param func Function called with (const LazyPBFBlock&).
+             * @param entities Which entity types to index.
+             * @param pool Thread pool to use.
+             */
+            template <typename TFunction>
+            void for_each_block(TFunction&& func,
+                                osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr,
+                                osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) const {
+                const std::size_t max_in_flight = 2 * static_cast<std::size_t>(pool.num_threads() > 0 ? pool.num_threads() : 1);
+                std::deque<std::future<LazyPBFBlock>> futures;
+                std::size_t next = 0;
+
+                while (next < num_data_blobs() || !futures.empty()) {
+                    while (next < num_data_blobs() && futures.size() < max_in_flight) {
+                        const auto n = next++;
+                        futures.push_back(pool.submit([this, n, entities]() {
+                            return read_blob(n, entities);
+                        }));
+                    }
+                    const auto block = futures.front().get();
+                    futures.pop_front();
+                    func(block);
+                }
+            }
+
+        }; // class LazyPBFReader
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_LAZY_PBF_READER_HPP
@@ -0,0 +1,422 @@
+#ifndef OSMIUM_IO_LZ4_COMPRESSION_HPP
+#define OSMIUM_IO_LZ4_COMPRESSION_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to read or write lz4-compressed OSM
+ * files.
+ *
+ * @attention If you include this file, you'll need to link with `liblz4`.
+ */
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/parallel_compressor.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/util/config.hpp>
+
+#include <lz4frame.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when there are problems compressing or
+     * decompressing lz4 files.
+     */
+    struct lz4_error : public io_error {
+
+        std::size_t lz4_error_code = 0;
+
+        explicit lz4_error(const std::string& what) :
+            io_error(what) {
+        }
+
+        lz4_error(const std::string& what, const std::size_t error_code) :
+            io_error(what + ": " + ::LZ4F_getErrorName(error_code)),
+            lz4_error_code(error_code) {
+        }
+
+    }; // struct lz4_error
+
+    namespace io {
+
+        namespace detail {
+
+            struct lz4_cctx_deleter {
+                void operator()(LZ4F_cctx* ctx) const noexcept {
+                    ::LZ4F_freeCompressionContext(ctx);
+                }
+            };
+
+            struct lz4_dctx_deleter {
+                void operator()(LZ4F_dctx* ctx) const noexcept {
+                    ::LZ4F_freeDecompressionContext(ctx);
+                }
+            };
+
+            inline std::unique_ptr<LZ4F_cctx, lz4_cctx_deleter> lz4_create_cctx() {
+                LZ4F_cctx* ctx = nullptr;
+                const std::size_t result = ::LZ4F_createCompressionContext(&ctx, LZ4F_VERSION);
+                if (::LZ4F_isError(result)) {
+                    throw osmium::lz4_error{"lz4 error: compression init failed", result};
+                }
+                return std::unique_ptr<LZ4F_cctx, lz4_cctx_deleter>{ctx};
+            }
+
+            inline std::unique_ptr<LZ4F_dctx, lz4_dctx_deleter> lz4_create_dctx() {
+                LZ4F_dctx* ctx = nullptr;
+                const std::size_t result = ::LZ4F_createDecompressionContext(&ctx, LZ4F_VERSION);
+                if (::LZ4F_isError(result)) {
+                    throw osmium::lz4_error{"lz4 error: decompression init failed", result};
+                }
+                return std::unique_ptr<LZ4F_dctx, lz4_dctx_deleter>{ctx};
+            }
+
+            inline LZ4F_preferences_t lz4_preferences() noexcept {
+                LZ4F_preferences_t prefs{};
+                prefs.frameInfo.blockSizeID = LZ4F_max1MB;
+                prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+                return prefs;
+            }
+
+            /**
+             * Decompress all of the input, appending the result to
+             * output. Returns the result of the last call to
+             * LZ4F_decompress(), which is 0 if the input ended at a
+             * frame boundary.
+             */
+            inline std::size_t lz4_decompress_append(LZ4F_dctx* ctx, const char* data, std::size_t size, std::string& output) {
+                constexpr const std::size_t min_output_space = 256UL * 1024UL;
+                std::size_t result = 0;
+                std::size_t written = output.size();
+                bool output_full = false;
+                // If the output buffer was filled, there might be more
+                // data buffered in the context.
+                while (size > 0 || output_full) {
+                    if (output.size() - written < min_output_space) {
+                        output.resize(written + std::max(min_output_space, output.size()));
+                    }
+                    const std::size_t available = output.size() - written;
+                    std::size_t out_size = available;
+                    std::size_t in_size = size;
+                    result = ::LZ4F_decompress(ctx, &output[written], &out_size, data, &in_size, nullptr);
+                    if (::LZ4F_isError(result)) {
+                        throw osmium::lz4_error{"lz4 error: decompression failed", result};
+                    }
+                    written += out_size;
+                    data += in_size;
+                    size -= in_size;
+                    output_full = out_size == available;
+                }
+                output.resize(written);
+                return result;
+            }
+
+        } // namespace detail
+
+        class Lz4Compressor final : public Compressor {
+
+            std::unique_ptr<LZ4F_cctx, detail::lz4_cctx_deleter> m_ctx;
+            LZ4F_preferences_t m_preferences;
+            std::string m_buffer{};
+            std::size_t m_file_size = 0;
+            int m_fd;
+
+            void write_buffer(const std::size_t size) {
+                osmium::io::detail::reliable_write(m_fd, m_buffer.data(), size);
+                m_file_size += size;
+            }
+
+        public:
+
+            enum {
+                max_input_size = 1024UL * 1024UL
+            };
+
+            explicit Lz4Compressor(const int fd, const fsync sync) :
+                Compressor(sync),
+                m_ctx(detail::lz4_create_cctx()),
+                m_preferences(detail::lz4_preferences()),
+                m_buffer(::LZ4F_compressBound(max_input_size, &m_preferences) + LZ4F_HEADER_SIZE_MAX, '\0'),
+                m_fd(fd) {
+                const std::size_t result = ::LZ4F_compressBegin(m_ctx.get(), &m_buffer[0], m_buffer.size(), &m_preferences);
+                if (::LZ4F_isError(result)) {
+                    throw osmium::lz4_error{"lz4 error: compression init failed", result};
+                }
+                write_buffer(result);
+            }
+
+            Lz4Compressor(const Lz4Compressor&) = delete;
+            Lz4Compressor& operator=(const Lz4Compressor&) = delete;
+
+            Lz4Compressor(Lz4Compressor&&) = delete;
+            Lz4Compressor& operator=(Lz4Compressor&&) = delete;
+
+            ~Lz4Compressor() noexcept override {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            void write(const std::string& data) override {
+                assert(m_fd >= 0);
+                for (std::size_t offset = 0; offset < data.size(); offset += max_input_size) {
+                    const std::size_t size = std::min<std::size_t>(data.size() - offset, max_input_size);
+                    const std::size_t result = ::LZ4F_compressUpdate(m_ctx.get(), &m_buffer[0], m_buffer.size(), data.data() + offset, size, nullptr);
+                    if (::LZ4F_isError(result)) {
+                        throw osmium::lz4_error{"lz4 error: compression failed", result};
+                    }
+                    write_buffer(result);
+                }
+            }
+
+            void close() override {
+                if (m_fd < 0) {
+                    return;
+                }
+
+                const int fd = m_fd;
+                try {
+                    const std::size_t result = ::LZ4F_compressEnd(m_ctx.get(), &m_buffer[0], m_buffer.size(), nullptr);
+                    if (::LZ4F_isError(result)) {
+                        throw osmium::lz4_error{"lz4 error: compression failed", result};
+                    }
+                    write_buffer(result);
+                } catch (...) {
+                    m_fd = -1;
+                    if (fd != 1) {
+                        osmium::io::detail::reliable_close(fd);
+                    }
+                    throw;
+                }
+                m_fd = -1;
+
+                // Do not sync or close stdout
+                if (fd == 1) {
+                    return;
+                }
+
+                if (do_fsync()) {
+                    osmium::io::detail::reliable_fsync(fd);
+                }
+                osmium::io::detail::reliable_close(fd);
+            }
+
+            std::size_t file_size() const override {
+                return m_file_size;
+            }
+
+        }; // class Lz4Compressor
+
+        class Lz4Decompressor final : public Decompressor {
+
+            std::unique_ptr<LZ4F_dctx, detail::lz4_dctx_deleter> m_ctx;
+            std::size_t m_offset = 0;
+            std::size_t m_last_result = 0;
+            int m_fd;
+
+        public:
+
+            explicit Lz4Decompressor(const int fd) :
+                m_fd(fd) {
+                try {
+                    m_ctx = detail::lz4_create_dctx();
+                } catch (...) {
+                    osmium::io::detail::reliable_close(fd);
+                    throw;
+                }
+            }
+
+            Lz4Decompressor(const Lz4Decompressor&) = delete;
+            Lz4Decompressor& operator=(const Lz4Decompressor&) = delete;
+
+            Lz4Decompressor(Lz4Decompressor&&) = delete;
+            Lz4Decompressor& operator=(Lz4Decompressor&&) = delete;
+
+            ~Lz4Decompressor() noexcept override {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            std::string read() override {
+                std::string input(osmium::io::Decompressor::input_buffer_size, '\0');
+                std::string output;
+                while (output.empty()) {
+                    if (m_offset > 0 && want_buffered_pages_removed()) {
+                        osmium::io::detail::remove_buffered_pages(m_fd, m_offset);
+                    }
+                    const auto nread = osmium::io::detail::reliable_read(m_fd, &input[0], static_cast<unsigned int>(input.size()));
+                    if (nread == 0) {
+                        if (m_last_result != 0) {
+                            throw osmium::lz4_error{"lz4 error: unexpected end of file"};
+                        }
+                        break;
+                    }
+                    m_offset += static_cast<std::size_t>(nread);
+                    set_offset(m_offset);
+                    m_last_result = detail::lz4_decompress_append(m_ctx.get(), input.data(), static_cast<std::size_t>(nread), output);
+                }
+                return output;
+            }
+
+            void close() override {
+                if (m_fd >= 0) {
+                    if (want_buffered_pages_removed()) {
+                        osmium::io::detail::remove_buffered_pages(m_fd);
+                    }
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    osmium::io::detail::reliable_close(fd);
+                }
+            }
+
+        }; // class Lz4Decompressor
+
+        class Lz4BufferDecompressor final : public Decompressor {
+
+            std::unique_ptr<LZ4F_dctx, detail::lz4_dctx_deleter> m_ctx;
+            const char* m_buffer;
+            std::size_t m_buffer_size;
+
+        public:
+
+            Lz4BufferDecompressor(const char* buffer, const std::size_t size) :
+                m_ctx(detail::lz4_create_dctx()),
+                m_buffer(buffer),
+                m_buffer_size(size) {
+            }
+
+            Lz4BufferDecompressor(const Lz4BufferDecompressor&) = delete;
+            Lz4BufferDecompressor& operator=(const Lz4BufferDecompressor&) = delete;
+
+            Lz4BufferDecompressor(Lz4BufferDecompressor&&) = delete;
+            Lz4BufferDecompressor& operator=(Lz4BufferDecompressor&&) = delete;
+
+            ~Lz4BufferDecompressor() noexcept override = default;
+
+            std::string read() override {
+                std::string output;
+                if (m_buffer_size > 0) {
+                    // Decompress at most one input buffer worth of
+                    // compressed data per call.
+                    const std::size_t size = std::min<std::size_t>(m_buffer_size, osmium::io::Decompressor::input_buffer_size);
+                    const std::size_t result = detail::lz4_decompress_append(m_ctx.get(), m_buffer, size, output);
+                    m_buffer += size;
+                    m_buffer_size -= size;
+                    if (m_buffer_size == 0 && result != 0) {
+                        throw osmium::lz4_error{"lz4 error: unexpected end of data"};
+                    }
+                }
+                return output;
+            }
+
+            void close() override {
+            }
+
+        }; // class Lz4BufferDecompressor
+
+        namespace detail {
+
+            /**
+             * Compression of chunks into independent lz4 frames for the
+             * ParallelCompressor. Concatenated frames can be read by all
+             * lz4 tools.
+             */
+            struct lz4_compress_format {
+
+                enum {
+                    target_chunk_size = 1024UL * 1024UL
+                };
+
+                static std::string compress_chunk(const char* data, const std::size_t size) {
+                    auto prefs = lz4_preferences();
+                    prefs.frameInfo.contentSize = size;
+                    std::string output(::LZ4F_compressFrameBound(size, &prefs), '\0');
+                    const std::size_t result = ::LZ4F_compressFrame(&output[0], output.size(), data, size, &prefs);
+                    if (::LZ4F_isError(result)) {
+                        throw osmium::lz4_error{"lz4 error: compression failed", result};
+                    }
+                    output.resize(result);
+                    return output;
+                }
+
+                void chunk_written(std::size_t /*input_size*/, std::size_t /*output_size*/) noexcept {
+                }
+
+                static std::string end_marker() {
+                    return {};
+                }
+
+            }; // struct lz4_compress_format
+
+            // we want the register_compression() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_lz4_compression = osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::lz4,
+                [](const int fd, const fsync sync) -> osmium::io::Compressor* {
+                    if (osmium::config::use_parallel_compression()) {
+                        return new ParallelCompressor<lz4_compress_format>{fd, sync, osmium::thread::Pool::default_instance()};
+                    }
+                    return new osmium::io::Lz4Compressor{fd, sync};
+                },
+                [](const int fd) { return new osmium::io::Lz4Decompressor{fd}; },
+                [](const char* buffer, const std::size_t size) { return new osmium::io::Lz4BufferDecompressor{buffer, size}; }
+            );
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_lz4_compression() noexcept {
+                return registered_lz4_compression;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_LZ4_COMPRESSION_HPP
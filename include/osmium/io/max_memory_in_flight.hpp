@@ -0,0 +1,250 @@
+#ifndef OSMIUM_IO_MAX_MEMORY_IN_FLIGHT_HPP
+#define OSMIUM_IO_MAX_MEMORY_IN_FLIGHT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Memory budget shared by one or more Readers. Keeps track of
+             * the number of bytes currently in flight in all of them.
+             */
+            class memory_budget {
+
+                std::size_t m_max_bytes;
+                std::size_t m_used = 0;
+                mutable std::mutex m_mutex;
+                std::condition_variable m_condition;
+
+                friend class memory_account;
+
+            public:
+
+                explicit memory_budget(std::size_t max_bytes) noexcept :
+                    m_max_bytes(max_bytes) {
+                }
+
+                std::size_t max_bytes() const noexcept {
+                    return m_max_bytes;
+                }
+
+                std::size_t used() const {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    return m_used;
+                }
+
+            }; // class memory_budget
+
+            /**
+             * The part of a memory budget used by a single Reader. If there
+             * is no budget, nothing is counted and nobody ever waits.
+             */
+            class memory_account {
+
+                std::shared_ptr<memory_budget> m_budget;
+
+                // These are protected by the mutex in the budget.
+                std::size_t m_used = 0;
+                bool m_closed = false;
+
+            public:
+
+                explicit memory_account(std::shared_ptr<memory_budget> budget) noexcept :
+                    m_budget(std::move(budget)) {
+                }
+
+                bool is_limited() const noexcept {
+                    return static_cast<bool>(m_budget);
+                }
+
+                /// Bytes in flight in this account.
+                std::size_t used() const {
+                    if (!m_budget) {
+                        return 0;
+                    }
+                    const std::lock_guard<std::mutex> lock{m_budget->m_mutex};
+                    return m_used;
+                }
+
+                /// Add bytes to the account. Never blocks.
+                void add(std::size_t bytes) {
+                    if (!m_budget || bytes == 0) {
+                        return;
+                    }
+                    const std::lock_guard<std::mutex> lock{m_budget->m_mutex};
+                    if (m_closed) {
+                        return;
+                    }
+                    m_used += bytes;
+                    m_budget->m_used += bytes;
+                }
+
+                /**
+                 * Remove bytes from the account. Never removes more than
+                 * was added to this account.
+                 */
+                void release(std::size_t bytes) {
+                    if (!m_budget || bytes == 0) {
+                        return;
+                    }
+                    {
+                        const std::lock_guard<std::mutex> lock{m_budget->m_mutex};
+                        bytes = std::min(bytes, m_used);
+                        m_used -= bytes;
+                        m_budget->m_used -= bytes;
+                    }
+                    m_budget->m_condition.notify_all();
+                }
+
+                /**
+                 * Give back everything in this account to the budget and
+                 * ignore everything added later. Called when the Reader is
+                 * closed, because buffers still in the pipeline will never
+                 * be consumed.
+                 */
+                void close() {
+                    if (!m_budget) {
+                        return;
+                    }
+                    {
+                        const std::lock_guard<std::mutex> lock{m_budget->m_mutex};
+                        m_budget->m_used -= m_used;
+                        m_used = 0;
+                        m_closed = true;
+                    }
+                    m_budget->m_condition.notify_all();
+                }
+
+                /**
+                 * Wait until there is room in the budget or the stop
+                 * predicate returns true. There is always room if this
+                 * account has nothing in flight, so that every Reader can
+                 * make progress even if others use up all of the budget.
+                 */
+                template <typename TPredicate>
+                void wait_for_room(TPredicate&& stop) {
+                    if (!m_budget) {
+                        return;
+                    }
+                    std::unique_lock<std::mutex> lock{m_budget->m_mutex};
+                    while (m_used > 0 && m_budget->m_used >= m_budget->m_max_bytes) {
+                        if (stop()) {
+                            return;
+                        }
+                        // The stop condition is not signalled through the
+                        // condition variable, so check it regularly.
+                        m_budget->m_condition.wait_for(lock, std::chrono::milliseconds{10});
+                    }
+                }
+
+            }; // class memory_account
+
+        } // namespace detail
+
+        /**
+         * Option for the osmium::io::Reader: Limit the memory used by the
+         * data in flight in the Reader, ie. the data read from the file
+         * but not yet decoded and the decoded buffers not yet returned by
+         * Reader::read(), to about the specified number of bytes.
+         *
+         * Copies of this object share the same budget, so it can be used
+         * to limit the memory used by several Readers together, for
+         * instance in a server reading many files at the same time:
+         *
+         * @code
+         * const osmium::io::max_memory_in_flight limit{256UL * 1024UL * 1024UL};
+         * osmium::io::Reader reader1{file1, limit};
+         * osmium::io::Reader reader2{file2, limit};
+         * @endcode
+         *
+         * When the budget is used up, the Reader stops reading from the
+         * file until buffers have been consumed. This is a soft limit: Data
+         * that was already read will still be decoded, so the memory used
+         * can go above the limit by about the size of the data blocks
+         * being decoded in the pool. A Reader with nothing in flight is
+         * always allowed to read, so it can't be starved by others.
+         *
+         * The number of elements in the queues is still limited as
+         * usual, see osmium::io::reader_queue_sizes.
+         */
+        class max_memory_in_flight {
+
+            std::shared_ptr<detail::memory_budget> m_budget;
+
+        public:
+
+            /// No limit.
+            max_memory_in_flight() = default;
+
+            /// Limit to max_bytes. A value of 0 means: no limit.
+            explicit max_memory_in_flight(std::size_t max_bytes) :
+                m_budget(max_bytes == 0 ? nullptr : std::make_shared<detail::memory_budget>(max_bytes)) {
+            }
+
+            explicit operator bool() const noexcept {
+                return static_cast<bool>(m_budget);
+            }
+
+            /// The limit in bytes (0 if there is no limit).
+            std::size_t max_bytes() const noexcept {
+                return m_budget ? m_budget->max_bytes() : 0;
+            }
+
+            /// The number of bytes currently in flight in all Readers.
+            std::size_t used() const {
+                return m_budget ? m_budget->used() : 0;
+            }
+
+            const std::shared_ptr<detail::memory_budget>& budget() const noexcept {
+                return m_budget;
+            }
+
+        }; // class max_memory_in_flight
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_MAX_MEMORY_IN_FLIGHT_HPP
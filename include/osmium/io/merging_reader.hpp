@@ -0,0 +1,427 @@
+#ifndef OSMIUM_IO_MERGING_READER_HPP
+#define OSMIUM_IO_MERGING_READER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/file.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * What the MergingReader should do with objects that have the
+         * same type, ID, and version as the object before them in the
+         * merged stream.
+         */
+        enum class merge_duplicates {
+            keep   = 0, ///< Keep all of them
+            remove = 1  ///< Keep only the first one (from the input with the smallest index)
+        };
+
+        /**
+         * Statistics of a MergingReader.
+         */
+        struct merging_reader_stats {
+
+            /// Number of objects copied into merged buffers.
+            std::size_t objects_copied = 0;
+
+            /// Number of input buffers handed out unchanged.
+            std::size_t buffers_passed_through = 0;
+
+            /// Number of duplicate objects removed.
+            std::size_t duplicates_removed = 0;
+
+        }; // struct merging_reader_stats
+
+        /**
+         * Reads any number of input files, each sorted by type, ID, and
+         * version (as in osmium::object_order_type_id_version), and
+         * returns the objects from all of them as one sorted stream. This
+         * is useful for working with many regional extracts or with a
+         * planet split into shards as if it was one file.
+         *
+         * All inputs are read at the same time by their own Reader. All
+         * Readers use the same thread pool for decoding, usually the
+         * default pool, or the pool given as option. They are set up to
+         * decode PBF data in the pool threads (which can be overwritten
+         * with the osmium::io::pool_for_pbf_parsing option). To keep the
+         * number of threads down with many inputs, use the
+         * osmium::io::io_executor option.
+         *
+         * The merge uses a heap with one entry per input. Objects are
+         * not copied one by one: Whenever a stretch of objects from one
+         * input comes before the current objects of all other inputs,
+         * the whole stretch is copied in one go. And if this is a
+         * complete buffer returned from the Reader, the buffer is handed
+         * out unchanged without copying anything. So merging files with
+         * disjoint ID ranges is nearly free.
+         *
+         * Only nodes, ways, and relations are read, changesets are not
+         * supported.
+         *
+         * Usage:
+         * @code
+         * std::vector<osmium::io::File> files{...};
+         * osmium::io::MergingReader reader{files, osmium::io::merge_duplicates::remove};
+         * while (osmium::memory::Buffer buffer = reader.read()) {
+         *     ...
+         * }
+         * reader.close();
+         * @endcode
+         */
+        class MergingReader {
+
+            enum : std::size_t {
+                output_buffer_size = 1024UL * 1024UL
+            };
+
+            using iterator = osmium::memory::Buffer::t_iterator<osmium::OSMObject>;
+
+            struct input {
+
+                std::unique_ptr<osmium::io::Reader> reader;
+                osmium::memory::Buffer buffer{};
+                iterator it{};
+                iterator end{};
+
+                explicit input(std::unique_ptr<osmium::io::Reader>&& r) :
+                    reader(std::move(r)) {
+                }
+
+                const osmium::OSMObject& current() const noexcept {
+                    return *it;
+                }
+
+                // Read buffers until there is one with at least one
+                // object in it. Returns false at the end of the input.
+                bool next_buffer() {
+                    while (true) {
+                        buffer = reader->read();
+                        if (!buffer) {
+                            return false;
+                        }
+                        it = buffer.begin<osmium::OSMObject>();
+                        end = buffer.end<osmium::OSMObject>();
+                        if (it != end) {
+                            return true;
+                        }
+                    }
+                }
+
+            }; // struct input
+
+            // Type, ID, and version of the last object added to the
+            // merged stream.
+            struct object_key {
+                osmium::item_type type = osmium::item_type::undefined;
+                osmium::object_id_type id = 0;
+                osmium::object_version_type version = 0;
+                bool valid = false;
+
+                bool matches(const osmium::OSMObject& object) const noexcept {
+                    return valid && type == object.type() && id == object.id() && version == object.version();
+                }
+
+                void set(const osmium::OSMObject& object) noexcept {
+                    type = object.type();
+                    id = object.id();
+                    version = object.version();
+                    valid = true;
+                }
+            };
+
+            std::vector<input> m_inputs{};
+            std::vector<std::size_t> m_heap{};
+            std::deque<osmium::memory::Buffer> m_ready{};
+            osmium::memory::Buffer m_output{};
+            object_key m_last{};
+            merging_reader_stats m_stats{};
+            merge_duplicates m_duplicates;
+            bool m_started = false;
+
+            // Is the current object of input a before the one of input b?
+            // If they are the same, the input with the smaller index wins,
+            // so the merge is stable.
+            bool before(const osmium::OSMObject& a, std::size_t ia, const osmium::OSMObject& b, std::size_t ib) const noexcept {
+                if (a < b) {
+                    return true;
+                }
+                return !(b < a) && ia < ib;
+            }
+
+            bool heap_greater(std::size_t a, std::size_t b) const noexcept {
+                return before(m_inputs[b].current(), b, m_inputs[a].current(), a);
+            }
+
+            void heap_push(std::size_t n) {
+                m_heap.push_back(n);
+                std::push_heap(m_heap.begin(), m_heap.end(), [this](std::size_t a, std::size_t b) {
+                    return heap_greater(a, b);
+                });
+            }
+
+            std::size_t heap_pop() {
+                std::pop_heap(m_heap.begin(), m_heap.end(), [this](std::size_t a, std::size_t b) {
+                    return heap_greater(a, b);
+                });
+                const auto n = m_heap.back();
+                m_heap.pop_back();
+                return n;
+            }
+
+            void flush_output() {
+                if (m_output && m_output.committed() > 0) {
+                    m_ready.push_back(std::move(m_output));
+                    m_output = osmium::memory::Buffer{};
+                }
+            }
+
+            void copy_to_output(iterator first, iterator last) {
+                if (!m_output) {
+                    m_output = osmium::memory::Buffer{output_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                }
+                const auto size = static_cast<std::size_t>(last.data() - first.data());
+                unsigned char* target = m_output.reserve_space(size);
+                std::copy_n(first.data(), size, target);
+                m_output.commit();
+                if (m_output.committed() >= output_buffer_size) {
+                    flush_output();
+                }
+            }
+
+            void start() {
+                m_started = true;
+                for (std::size_t n = 0; n < m_inputs.size(); ++n) {
+                    if (m_inputs[n].next_buffer()) {
+                        heap_push(n);
+                    }
+                }
+            }
+
+            // Move the stretch of objects from the input at the top of
+            // the heap to the output which comes before the current
+            // objects of all other inputs.
+            void merge_step() {
+                const auto n = heap_pop();
+                auto& in = m_inputs[n];
+
+                if (m_duplicates == merge_duplicates::remove && m_last.matches(in.current())) {
+                    ++in.it;
+                    ++m_stats.duplicates_removed;
+                } else {
+                    const osmium::OSMObject* bound = m_heap.empty() ? nullptr : &m_inputs[m_heap.front()].current();
+                    const std::size_t bound_input = m_heap.empty() ? 0 : m_heap.front();
+
+                    const auto first = in.it;
+                    auto last = in.it;
+                    std::size_t count = 0;
+                    do {
+                        m_last.set(*last);
+                        ++last;
+                        ++count;
+                    } while (last != in.end &&
+                             (!bound || before(*last, n, *bound, bound_input)) &&
+                             !(m_duplicates == merge_duplicates::remove && m_last.matches(*last)));
+
+                    if (first.data() == in.buffer.data() && last == in.end) {
+                        flush_output();
+                        m_ready.push_back(std::move(in.buffer));
+                        ++m_stats.buffers_passed_through;
+                    } else {
+                        copy_to_output(first, last);
+                        m_stats.objects_copied += count;
+                    }
+                    in.it = last;
+                }
+
+                if (in.it != in.end || in.next_buffer()) {
+                    heap_push(n);
+                }
+            }
+
+        public:
+
+            /**
+             * Create a MergingReader.
+             *
+             * @param files The input files. Each must be sorted by type,
+             *        ID, and version.
+             * @param duplicates Keep or remove objects with the same
+             *        type, ID, and version in several inputs.
+             * @param args All further arguments are handed to the
+             *        constructor of each Reader, see there for the
+             *        possible options.
+             *
+             * @throws osmium::io_error If there was an error.
+             * @throws std::system_error If a file could not be opened.
+             */
+            template <typename... TArgs>
+            explicit MergingReader(const std::vector<osmium::io::File>& files, merge_duplicates duplicates, TArgs&&... args) :
+                m_duplicates(duplicates) {
+                m_inputs.reserve(files.size());
+                m_heap.reserve(files.size());
+                for (const auto& file : files) {
+                    m_inputs.emplace_back(std::unique_ptr<osmium::io::Reader>{
+                        new osmium::io::Reader{file,
+                                               osmium::osm_entity_bits::nwr,
+                                               osmium::io::pool_for_pbf_parsing::yes,
+                                               std::forward<TArgs>(args)...}});
+                }
+            }
+
+            MergingReader(const MergingReader&) = delete;
+            MergingReader& operator=(const MergingReader&) = delete;
+
+            MergingReader(MergingReader&&) = delete;
+            MergingReader& operator=(MergingReader&&) = delete;
+
+            ~MergingReader() noexcept {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /// The number of input files.
+            std::size_t num_inputs() const noexcept {
+                return m_inputs.size();
+            }
+
+            /**
+             * Get the header of the merged data. This is the header of
+             * the first input with the bounding boxes of all inputs.
+             * Blocks until the headers of all inputs are available.
+             */
+            osmium::io::Header header() {
+                osmium::io::Header result;
+                bool first = true;
+                for (auto& in : m_inputs) {
+                    const auto header = in.reader->header();
+                    if (first) {
+                        result = header;
+                        first = false;
+                        continue;
+                    }
+                    for (const auto& box : header.boxes()) {
+                        result.add_box(box);
+                    }
+                    if (header.has_multiple_object_versions()) {
+                        result.set_has_multiple_object_versions(true);
+                    }
+                }
+                return result;
+            }
+
+            /**
+             * Read the next buffer of merged data. Returns an invalid
+             * buffer at the end of all inputs.
+             *
+             * @throws Any exception thrown by one of the Readers.
+             */
+            osmium::memory::Buffer read() {
+                if (!m_started) {
+                    start();
+                }
+
+                while (m_ready.empty() && !m_heap.empty()) {
+                    merge_step();
+                }
+                if (m_ready.empty()) {
+                    flush_output();
+                }
+                if (m_ready.empty()) {
+                    return osmium::memory::Buffer{};
+                }
+
+                osmium::memory::Buffer buffer{std::move(m_ready.front())};
+                m_ready.pop_front();
+                return buffer;
+            }
+
+            /// Statistics about the merge so far.
+            const merging_reader_stats& stats() const noexcept {
+                return m_stats;
+            }
+
+            /**
+             * Close all Readers. Called by the destructor, but call it
+             * explicitly to get any exceptions from the Readers. If
+             * several Readers fail, the exception of the first one is
+             * rethrown after all were closed.
+             */
+            void close() {
+                std::exception_ptr exception;
+                for (auto& in : m_inputs) {
+                    try {
+                        in.reader->close();
+                    } catch (...) {
+                        if (!exception) {
+                            exception = std::current_exception();
+                        }
+                    }
+                    in.buffer = osmium::memory::Buffer{};
+                }
+                m_started = true;
+                m_heap.clear();
+                m_ready.clear();
+                m_output = osmium::memory::Buffer{};
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+            }
+
+        }; // class MergingReader
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_MERGING_READER_HPP
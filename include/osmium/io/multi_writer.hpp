@@ -0,0 +1,274 @@
+#ifndef OSMIUM_IO_MULTI_WRITER_HPP
+#define OSMIUM_IO_MULTI_WRITER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/file.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/memory/shared_buffer.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Writes the same data to several files which can have different
+         * formats. Buffers written to the MultiWriter are not copied, they
+         * are shared between all outputs. Files with the same format and
+         * format options (they can have different compression) share one
+         * Writer so the data is encoded only once for them.
+         *
+         * Use it like the osmium::io::Writer.
+         */
+        class MultiWriter {
+
+            enum {
+                default_buffer_size = 10UL * 1024UL * 1024UL
+            };
+
+            std::vector<std::unique_ptr<osmium::io::Writer>> m_writers;
+
+            osmium::memory::Buffer m_buffer{};
+
+            std::size_t m_buffer_size = default_buffer_size;
+
+            static std::vector<std::vector<osmium::io::File>> group_by_encoding(const std::vector<osmium::io::File>& files) {
+                std::vector<std::vector<osmium::io::File>> groups;
+                for (const auto& file : files) {
+                    auto it = std::find_if(groups.begin(), groups.end(), [&file](const std::vector<osmium::io::File>& group) {
+                        return detail::same_encoding(group.front(), file);
+                    });
+                    if (it == groups.end()) {
+                        groups.emplace_back(1, file);
+                    } else {
+                        it->push_back(file);
+                    }
+                }
+                return groups;
+            }
+
+            void do_flush() {
+                if (m_buffer && m_buffer.committed() > 0) {
+                    osmium::memory::Buffer buffer{m_buffer_size,
+                                                  osmium::memory::Buffer::auto_grow::no};
+                    using std::swap;
+                    swap(m_buffer, buffer);
+                    write_shared(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)));
+                }
+            }
+
+        public:
+
+            /**
+             * Open the files for writing.
+             *
+             * @param files The files to write to.
+             * @param args All further arguments are optional and can appear
+             *             in any order. They are used for all files, see
+             *             the osmium::io::Writer constructor for details.
+             *
+             * @throws osmium::io_error If there was an error.
+             * @throws std::system_error If a file could not be opened.
+             */
+            template <typename... TArgs>
+            explicit MultiWriter(const std::vector<osmium::io::File>& files, TArgs&&... args) {
+                if (files.empty()) {
+                    throw std::invalid_argument{"MultiWriter needs at least one file"};
+                }
+                for (const auto& group : group_by_encoding(files)) {
+                    m_writers.emplace_back(new osmium::io::Writer{group, args...});
+                }
+            }
+
+            MultiWriter(const MultiWriter&) = delete;
+            MultiWriter& operator=(const MultiWriter&) = delete;
+
+            MultiWriter(MultiWriter&&) = delete;
+            MultiWriter& operator=(MultiWriter&&) = delete;
+
+            ~MultiWriter() noexcept {
+                try {
+                    do_flush();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /**
+             * The number of Writers used internally, this is the number
+             * of different encodings of the data.
+             */
+            std::size_t num_encoders() const noexcept {
+                return m_writers.size();
+            }
+
+            /**
+             * Get the currently configured size of the internal buffer.
+             */
+            std::size_t buffer_size() const noexcept {
+                return m_buffer_size;
+            }
+
+            /**
+             * Set the size of the internal buffer. This will only take effect
+             * if you have not yet written anything or after the next flush().
+             */
+            void set_buffer_size(std::size_t size) noexcept {
+                m_buffer_size = size;
+            }
+
+            /**
+             * Flush the internal buffer if it contains any data.
+             *
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void flush() {
+                do_flush();
+                for (auto& writer : m_writers) {
+                    writer->flush();
+                }
+            }
+
+            /**
+             * Write contents of a buffer to all output files. The buffer is
+             * moved into this function and will be in an undefined
+             * moved-from state afterwards.
+             *
+             * @param buffer Buffer that is being written out.
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void operator()(osmium::memory::Buffer&& buffer) {
+                do_flush();
+                if (m_writers.size() == 1) {
+                    (*m_writers.front())(std::move(buffer));
+                    return;
+                }
+                write_shared(std::make_shared<const osmium::memory::Buffer>(std::move(buffer)));
+            }
+
+            /**
+             * Write contents of a shared buffer to all output files. See
+             * Writer::write_shared() for details.
+             *
+             * @param buffer Buffer that is being written out.
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void write_shared(const std::shared_ptr<const osmium::memory::Buffer>& buffer) {
+                for (auto& writer : m_writers) {
+                    writer->write_shared(buffer);
+                }
+            }
+
+            /**
+             * Write contents of a SharedBuffer to the output files. See
+             * above for details.
+             *
+             * @param buffer Buffer that is being written out.
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void write_shared(const osmium::memory::SharedBuffer& buffer) {
+                write_shared(buffer.ptr());
+            }
+
+            /**
+             * Add item to the internal buffer for eventual writing to the
+             * output files.
+             *
+             * @param item Item to write (usually an OSM object).
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void operator()(const osmium::memory::Item& item) {
+                if (!m_buffer) {
+                    m_buffer = osmium::memory::Buffer{m_buffer_size,
+                                                      osmium::memory::Buffer::auto_grow::no};
+                }
+                try {
+                    m_buffer.push_back(item);
+                } catch (const osmium::buffer_is_full&) {
+                    do_flush();
+                    m_buffer.push_back(item);
+                }
+            }
+
+            /**
+             * Flushes internal buffer and closes all output files. All
+             * files are closed even if there is an error with one of them.
+             *
+             * @returns Number of bytes written to all files (or 0 if it can
+             *          not be determined).
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            std::size_t close() {
+                std::exception_ptr exception;
+                std::size_t size = 0;
+
+                try {
+                    do_flush();
+                } catch (...) {
+                    exception = std::current_exception();
+                }
+
+                for (auto& writer : m_writers) {
+                    try {
+                        size += writer->close();
+                    } catch (...) {
+                        if (!exception) {
+                            exception = std::current_exception();
+                        }
+                    }
+                }
+
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+
+                return size;
+            }
+
+        }; // class MultiWriter
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_MULTI_WRITER_HPP
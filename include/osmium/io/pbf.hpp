@@ -50,6 +50,10 @@ namespace osmium {
             types.emplace_back("lz4");
 #endif
 
+#ifdef OSMIUM_WITH_ZSTD
+            types.emplace_back("zstd");
+#endif
+
             return types;
         }
 
@@ -0,0 +1,549 @@
+#ifndef OSMIUM_IO_PBF_ID_READER_HPP
+#define OSMIUM_IO_PBF_ID_READER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to collect the IDs of objects or the
+ * locations of nodes in OSM PBF files without reading the objects.
+ *
+ * @attention If you include this file, you'll need to link with
+ *            `libz`, and enable multithreading.
+ */
+
+#include <osmium/index/map.hpp>
+#include <osmium/index/nwr_array.hpp>
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_blob_table.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/pbf_ids_decoder.hpp>
+#include <osmium/io/detail/pbf_locations_decoder.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/tags_prefilter.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <protozero/types.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Reads only the IDs of objects from an (uncompressed) PBF file
+         * into ID sets (usually osmium::index::IdSetDense). No objects
+         * and no Buffers are built, the decoder threads put the IDs
+         * directly into the sets. This is much faster than reading the
+         * objects with the Reader if all you need are the IDs.
+         *
+         * Together with a tags_prefilter only IDs of objects with at
+         * least one matching tag are collected.
+         *
+         * The reader can also fill node location indexes, see
+         * read_locations().
+         *
+         * Usage:
+         * @code
+         * osmium::TagsFilter filter{false};
+         * filter.add_rule(true, "highway");
+         *
+         * osmium::index::IdSetDense<osmium::unsigned_object_id_type> ids;
+         * osmium::io::PBFIdReader reader{"planet.osm.pbf"};
+         * reader.read(ids, osmium::osm_entity_bits::way,
+         *             osmium::io::tags_prefilter{filter, osmium::osm_entity_bits::way});
+         * @endcode
+         */
+        class PBFIdReader {
+
+            osmium::util::MemoryMapping m_mapping;
+            detail::PBFBlobTable m_table;
+            osmium::io::Header m_header;
+
+            static osmium::util::MemoryMapping map_fd(int fd) {
+                const auto size = osmium::file_size(fd);
+                if (size == 0) {
+                    throw osmium::pbf_error{"empty file"};
+                }
+                return osmium::util::MemoryMapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, fd};
+            }
+
+            static osmium::util::MemoryMapping map_file(const std::string& filename) {
+                const int fd = detail::open_for_reading(filename);
+                try {
+                    osmium::util::MemoryMapping mapping{map_fd(fd)};
+                    detail::reliable_close(fd);
+                    return mapping;
+                } catch (...) {
+                    try {
+                        detail::reliable_close(fd);
+                    } catch (...) {
+                        // ignore errors on close, report original error
+                    }
+                    throw;
+                }
+            }
+
+            static osmium::unsigned_object_id_type positive_id(osmium::object_id_type id) noexcept {
+                return static_cast<osmium::unsigned_object_id_type>(id < 0 ? -id : id);
+            }
+
+            const char* data() const noexcept {
+                return m_mapping.get_addr<char>();
+            }
+
+            protozero::data_view blob_data(const detail::pbf_blob_info& blob) const noexcept {
+                return protozero::data_view{data() + blob.offset, blob.size};
+            }
+
+            /**
+             * Decode all data blobs in the pool. Each task fills a
+             * TResult with the decode_func from its blob and then hands
+             * it to the set_func. The set_func is called from several
+             * threads at the same time, it has to do its own locking.
+             */
+            template <typename TResult, typename TDecodeFunction, typename TSetFunction>
+            void decode_all(osmium::thread::Pool& pool,
+                            TDecodeFunction&& decode_func,
+                            TSetFunction&& set_func) const {
+                const std::size_t max_in_flight = 2 * static_cast<std::size_t>(pool.num_threads() > 0 ? pool.num_threads() : 1);
+                std::deque<std::future<void>> futures;
+                std::size_t next = 0;
+
+                try {
+                    while (next < num_data_blobs() || !futures.empty()) {
+                        while (next < num_data_blobs() && futures.size() < max_in_flight) {
+                            const auto n = next++;
+                            futures.push_back(pool.submit([n, &decode_func, &set_func]() {
+                                TResult result;
+                                decode_func(n, result);
+                                set_func(result);
+                            }));
+                        }
+                        futures.front().get();
+                        futures.pop_front();
+                    }
+                } catch (...) {
+                    // The tasks use local variables, so they must be
+                    // finished before we can leave.
+                    for (auto& future : futures) {
+                        future.wait();
+                    }
+                    throw;
+                }
+            }
+
+            /**
+             * Collect the IDs of matching objects in all data blobs and
+             * add them to the sets with the set_func while holding a
+             * lock.
+             */
+            template <typename TSetFunction>
+            void read_all(osmium::osm_entity_bits::type entities,
+                          const osmium::io::tags_prefilter& prefilter,
+                          osmium::thread::Pool& pool,
+                          TSetFunction&& set_func) const {
+                using ids_type = osmium::nwr_array<std::vector<osmium::unsigned_object_id_type>>;
+                std::mutex mutex;
+                decode_all<ids_type>(pool, [this, entities, &prefilter](std::size_t n, ids_type& ids) {
+                    for_each_id_in_blob(n, [&ids](osmium::item_type type, osmium::object_id_type id, bool matched) {
+                        if (matched) {
+                            ids(type).push_back(positive_id(id));
+                        }
+                    }, entities, prefilter);
+                }, [&mutex, &set_func](const ids_type& ids) {
+                    const std::lock_guard<std::mutex> lock{mutex};
+                    set_func(ids);
+                });
+            }
+
+            using locations_type = std::vector<std::pair<osmium::object_id_type, osmium::Location>>;
+
+            template <typename TSetFunction>
+            void read_all_locations(bool tagged_only,
+                                    osmium::thread::Pool& pool,
+                                    TSetFunction&& set_func) const {
+                decode_all<locations_type>(pool, [this, tagged_only](std::size_t n, locations_type& locations) {
+                    for_each_location_in_blob(n, [&locations, tagged_only](osmium::object_id_type id, osmium::Location location, bool has_tags) {
+                        if (!tagged_only || has_tags) {
+                            locations.emplace_back(id, location);
+                        }
+                    });
+                }, std::forward<TSetFunction>(set_func));
+            }
+
+            /**
+             * Find the largest node ID in a file sorted by type and ID
+             * without decoding all blobs: The nodes are in the first
+             * blobs, a binary search finds the last of those. Returns 0
+             * if the file isn't sorted or has no nodes.
+             */
+            osmium::object_id_type max_node_id() const {
+                if (!m_header.sorted_by_type_then_id()) {
+                    return 0;
+                }
+
+                const auto node_id_range = [this](std::size_t n) {
+                    std::pair<bool, osmium::object_id_type> result{false, 0};
+                    for_each_id_in_blob(n, [&result](osmium::item_type /*type*/, osmium::object_id_type id, bool /*matched*/) {
+                        result.first = true;
+                        result.second = std::max(result.second, id);
+                    }, osmium::osm_entity_bits::node);
+                    return result;
+                };
+
+                std::size_t first = 0;
+                std::size_t last = num_data_blobs();
+                while (first < last) {
+                    const std::size_t middle = first + (last - first) / 2;
+                    if (node_id_range(middle).first) {
+                        first = middle + 1;
+                    } else {
+                        last = middle;
+                    }
+                }
+                return first == 0 ? 0 : node_id_range(first - 1).second;
+            }
+
+            /**
+             * Lets the decoder tasks write locations into an index which
+             * supports set_concurrent() at the same time. The index has
+             * to be grown if a blob contains a node ID which doesn't fit,
+             * this needs exclusive access: The task waits until all
+             * other writers are done and new writers wait until the
+             * index has been grown. If the index was large enough from
+             * the start this never happens.
+             */
+            template <typename TIndex>
+            class concurrent_location_writer {
+
+                TIndex& m_index;
+                std::mutex m_mutex;
+                std::condition_variable m_cv;
+                std::size_t m_size;
+                std::size_t m_writers = 0;
+                bool m_growing = false;
+
+            public:
+
+                concurrent_location_writer(TIndex& index, std::size_t size) :
+                    m_index(index) {
+                    m_index.resize(size);
+                    m_size = m_index.size();
+                }
+
+                void write(const locations_type& locations) {
+                    std::size_t needed = 0;
+                    for (const auto& id_location : locations) {
+                        if (id_location.first >= 0) {
+                            needed = std::max(needed, static_cast<std::size_t>(id_location.first) + 1);
+                        }
+                    }
+
+                    {
+                        std::unique_lock<std::mutex> lock{m_mutex};
+                        m_cv.wait(lock, [this]() {
+                            return !m_growing;
+                        });
+                        if (needed > m_size) {
+                            m_growing = true;
+                            m_cv.wait(lock, [this]() {
+                                return m_writers == 0;
+                            });
+                            try {
+                                m_index.resize(needed);
+                            } catch (...) {
+                                m_growing = false;
+                                m_cv.notify_all();
+                                throw;
+                            }
+                            m_size = needed;
+                            m_growing = false;
+                            m_cv.notify_all();
+                        }
+                        ++m_writers;
+                    }
+
+                    for (const auto& id_location : locations) {
+                        if (id_location.first >= 0) {
+                            m_index.set_concurrent(static_cast<osmium::unsigned_object_id_type>(id_location.first), id_location.second);
+                        }
+                    }
+
+                    {
+                        const std::lock_guard<std::mutex> lock{m_mutex};
+                        --m_writers;
+                    }
+                    m_cv.notify_all();
+                }
+
+            }; // class concurrent_location_writer
+
+            /**
+             * Store the locations of nodes with positive IDs in the
+             * index, the set_neg function is called with the locations
+             * of each blob for the nodes with negative IDs. It is called
+             * while holding a lock.
+             */
+            template <typename TIndex, typename TSetNegFunction>
+            void read_locations_impl(TIndex& index, TSetNegFunction&& set_neg, bool tagged_only, osmium::thread::Pool& pool, std::true_type /*concurrent_set*/) const {
+                concurrent_location_writer<TIndex> writer{index, static_cast<std::size_t>(max_node_id()) + 1};
+                std::mutex mutex;
+                read_all_locations(tagged_only, pool, [&writer, &mutex, &set_neg](const locations_type& locations) {
+                    writer.write(locations);
+                    if (std::any_of(locations.cbegin(), locations.cend(), [](const locations_type::value_type& id_location) {
+                            return id_location.first < 0;
+                        })) {
+                        const std::lock_guard<std::mutex> lock{mutex};
+                        set_neg(locations);
+                    }
+                });
+            }
+
+            template <typename TIndex, typename TSetNegFunction>
+            void read_locations_impl(TIndex& index, TSetNegFunction&& set_neg, bool tagged_only, osmium::thread::Pool& pool, std::false_type /*concurrent_set*/) const {
+                std::mutex mutex;
+                read_all_locations(tagged_only, pool, [&mutex, &index, &set_neg](const locations_type& locations) {
+                    const std::lock_guard<std::mutex> lock{mutex};
+                    for (const auto& id_location : locations) {
+                        if (id_location.first >= 0) {
+                            index.set(static_cast<osmium::unsigned_object_id_type>(id_location.first), id_location.second);
+                        }
+                    }
+                    set_neg(locations);
+                });
+            }
+
+        public:
+
+            /**
+             * Open a PBF file for reading IDs.
+             *
+             * @param filename Name of the (uncompressed) PBF file.
+             * @throws osmium::pbf_error If the file is not a valid PBF file.
+             * @throws std::system_error If the file can not be opened or
+             *         mapped.
+             */
+            explicit PBFIdReader(const std::string& filename) :
+                m_mapping(map_file(filename)),
+                m_table(detail::PBFBlobTable::from_memory(data(), m_mapping.size())) {
+                if (m_table.empty() || m_table[0].type != detail::pbf_blob_type::header) {
+                    throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                }
+                for (std::size_t n = 1; n < m_table.size(); ++n) {
+                    if (m_table[n].type != detail::pbf_blob_type::data) {
+                        throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                    }
+                }
+                m_header = detail::decode_header(blob_data(m_table[0]));
+            }
+
+            /// Get the header of the file.
+            const osmium::io::Header& header() const noexcept {
+                return m_header;
+            }
+
+            /// The number of data blobs in the file.
+            std::size_t num_data_blobs() const noexcept {
+                return m_table.size() - 1;
+            }
+
+            /**
+             * Decode the nth data blob and call func(type, id, matched)
+             * for each object of the specified types in it. The matched
+             * flag is true if the object has a tag matching the prefilter
+             * or if the prefilter doesn't apply to the object type.
+             *
+             * @pre @code n < num_data_blobs() @endcode
+             */
+            template <typename TFunction>
+            void for_each_id_in_blob(std::size_t n,
+                                     TFunction&& func,
+                                     osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr,
+                                     const osmium::io::tags_prefilter& prefilter = osmium::io::tags_prefilter{}) const {
+                detail::pbf_blob_buffer output;
+                detail::PBFIdsBlockDecoder decoder{detail::decode_blob(blob_data(m_table[n + 1]), output), entities, prefilter};
+                decoder(std::forward<TFunction>(func));
+            }
+
+            /**
+             * Decode the nth data blob and call
+             * func(id, location, has_tags) for each node in it. Nothing
+             * but the IDs and locations of the nodes and whether they
+             * have tags is decoded.
+             *
+             * @pre @code n < num_data_blobs() @endcode
+             */
+            template <typename TFunction>
+            void for_each_location_in_blob(std::size_t n, TFunction&& func) const {
+                detail::pbf_blob_buffer output;
+                detail::PBFLocationsBlockDecoder decoder{detail::decode_blob(blob_data(m_table[n + 1]), output)};
+                decoder(std::forward<TFunction>(func));
+            }
+
+            /**
+             * Add the IDs of all objects of the specified types (and with
+             * a tag matching the prefilter if it applies to their type)
+             * to the sets for their types. The blobs are decoded in the
+             * thread pool.
+             *
+             * @tparam TIdSet Type of the ID sets, needs a member function
+             *         set(osmium::unsigned_object_id_type).
+             * @param sets The ID sets, one for each object type.
+             * @param entities Which entity types to read.
+             * @param prefilter Optional tags filter.
+             * @param pool Thread pool to use.
+             */
+            template <typename TIdSet>
+            void read(osmium::nwr_array<TIdSet>& sets,
+                      osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr,
+                      const osmium::io::tags_prefilter& prefilter = osmium::io::tags_prefilter{},
+                      osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) const {
+                read_all(entities, prefilter, pool, [&sets](const osmium::nwr_array<std::vector<osmium::unsigned_object_id_type>>& ids) {
+                    for (unsigned int i = 0; i < 3; ++i) {
+                        const auto type = osmium::nwr_index_to_item_type(i);
+                        auto& set = sets(type);
+                        for (const auto id : ids(type)) {
+                            set.set(id);
+                        }
+                    }
+                });
+            }
+
+            /**
+             * Add the IDs of all objects of the specified types (and with
+             * a tag matching the prefilter if it applies to their type)
+             * to the set. This is usually used with a single type in
+             * entities, otherwise the IDs of the different types end up
+             * in the same set.
+             *
+             * @tparam TIdSet Type of the ID set, needs a member function
+             *         set(osmium::unsigned_object_id_type).
+             * @param set The ID set.
+             * @param entities Which entity types to read.
+             * @param prefilter Optional tags filter.
+             * @param pool Thread pool to use.
+             */
+            template <typename TIdSet>
+            void read(TIdSet& set,
+                      osmium::osm_entity_bits::type entities,
+                      const osmium::io::tags_prefilter& prefilter = osmium::io::tags_prefilter{},
+                      osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) const {
+                read_all(entities, prefilter, pool, [&set](const osmium::nwr_array<std::vector<osmium::unsigned_object_id_type>>& ids) {
+                    for (const auto& type_ids : ids) {
+                        for (const auto id : type_ids) {
+                            set.set(id);
+                        }
+                    }
+                });
+            }
+
+            /**
+             * Store the locations of all nodes in the location index.
+             * This is the fast way to fill an index used with the
+             * NodeLocationsForWays handler: Only IDs, locations and
+             * tag presence are decoded from the blobs, no Node objects
+             * are built.
+             *
+             * If the index supports set_concurrent() (the dense maps do,
+             * see osmium::index::supports_concurrent_set), the decoder
+             * tasks write into it at the same time. The index is resized
+             * up front if the file is sorted (so the largest node ID can
+             * be found quickly), otherwise it is grown when a blob
+             * contains IDs which don't fit. Other indexes get the
+             * locations in batches of one blob while holding a lock.
+             *
+             * Metadata isn't read, so this should not be used on
+             * history files. Nodes with negative IDs are ignored, use
+             * the overload with two indexes if you need them.
+             *
+             * @tparam TIndex Type of the index, needs a member function
+             *         set(osmium::unsigned_object_id_type, osmium::Location).
+             * @param index The location index.
+             * @param tagged_only Only store locations of nodes with tags.
+             * @param pool Thread pool to use.
+             */
+            template <typename TIndex>
+            void read_locations(TIndex& index,
+                                bool tagged_only = false,
+                                osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) const {
+                read_locations_impl(index, [](const locations_type& /*locations*/) {
+                }, tagged_only, pool, std::integral_constant<bool, osmium::index::supports_concurrent_set<TIndex>::value>{});
+            }
+
+            /**
+             * Store the locations of all nodes in the location indexes,
+             * nodes with positive IDs in index_pos, nodes with negative
+             * IDs in index_neg (with the ID negated). See the other
+             * overload for details.
+             */
+            template <typename TIndexPos, typename TIndexNeg>
+            void read_locations(TIndexPos& index_pos,
+                                TIndexNeg& index_neg,
+                                bool tagged_only = false,
+                                osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) const {
+                read_locations_impl(index_pos, [&index_neg](const locations_type& locations) {
+                    for (const auto& id_location : locations) {
+                        if (id_location.first < 0) {
+                            index_neg.set(positive_id(id_location.first), id_location.second);
+                        }
+                    }
+                }, tagged_only, pool, std::integral_constant<bool, osmium::index::supports_concurrent_set<TIndexPos>::value>{});
+            }
+
+        }; // class PBFIdReader
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_ID_READER_HPP
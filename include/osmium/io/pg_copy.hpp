@@ -0,0 +1,520 @@
+#ifndef OSMIUM_IO_PG_COPY_HPP
+#define OSMIUM_IO_PG_COPY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/string_util.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/thread/completion_ring.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/config.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            template <typename T>
+            inline void append_big_endian(std::string& out, T value) {
+                char data[sizeof(T)];
+                auto v = static_cast<typename std::make_unsigned<T>::type>(value);
+                for (std::size_t i = sizeof(T); i > 0; --i) {
+                    data[i - 1] = static_cast<char>(v & 0xffU);
+                    v >>= 8U;
+                }
+                out.append(data, sizeof(T));
+            }
+
+            template <typename T>
+            inline void set_big_endian(std::string& out, std::size_t pos, T value) {
+                auto v = static_cast<typename std::make_unsigned<T>::type>(value);
+                for (std::size_t i = sizeof(T); i > 0; --i) {
+                    out[pos + i - 1] = static_cast<char>(v & 0xffU);
+                    v >>= 8U;
+                }
+            }
+
+            inline std::size_t get_pg_copy_max_batches() noexcept {
+                return osmium::config::get_max_queue_size("PGCOPY", 20);
+            }
+
+        } // namespace detail
+
+        /**
+         * Rows in the PostgreSQL binary COPY format ("COPY ... FROM STDIN
+         * (FORMAT binary)"). The data is appended to one string which
+         * can be handed to PQputCopyData() as it is. Compared to the
+         * text format, numbers and geometries don't have to be converted
+         * to text on the client and parsed on the server.
+         *
+         * Each row is started with begin_row(), then the fields are added
+         * in the order of the columns in the COPY command, and the row is
+         * finished with end_row().
+         *
+         * The binary format of the fields must match the column types
+         * exactly, there is no conversion on the server: add_int8() needs
+         * a bigint column, add_int4() an int column, etc. Geometries can
+         * be added with add_binary() as WKB or EWKB (use the WKBFactory
+         * with out_type::binary) into PostGIS geometry columns.
+         *
+         * The header (pg_copy_header()) must be sent once before the
+         * rows, the trailer (pg_copy_trailer()) after all rows.
+         */
+        class PgCopyBatch {
+
+            std::string m_data;
+            std::size_t m_row_start = 0;
+            std::size_t m_rows = 0;
+            uint16_t m_fields = 0;
+            bool m_in_row = false;
+
+            // Reserve space for the length of a field and return its
+            // position.
+            std::size_t begin_field() {
+                assert(m_in_row);
+                ++m_fields;
+                const auto pos = m_data.size();
+                m_data.append(4, '\0');
+                return pos;
+            }
+
+            void end_field(std::size_t pos) {
+                const auto length = m_data.size() - pos - 4;
+                if (length > static_cast<std::size_t>(std::numeric_limits<int32_t>::max())) {
+                    throw std::length_error{"field too long for PostgreSQL COPY"};
+                }
+                detail::set_big_endian(m_data, pos, static_cast<int32_t>(length));
+            }
+
+            void add_length(std::size_t length) {
+                if (length > static_cast<std::size_t>(std::numeric_limits<int32_t>::max())) {
+                    throw std::length_error{"field too long for PostgreSQL COPY"};
+                }
+                detail::append_big_endian(m_data, static_cast<int32_t>(length));
+            }
+
+            template <typename T>
+            void add_fixed(T value) {
+                assert(m_in_row);
+                ++m_fields;
+                detail::append_big_endian(m_data, static_cast<int32_t>(sizeof(T)));
+                detail::append_big_endian(m_data, value);
+            }
+
+        public:
+
+            /**
+             * Create an empty batch.
+             *
+             * @param capacity Number of bytes to reserve.
+             */
+            explicit PgCopyBatch(std::size_t capacity = 0) {
+                m_data.reserve(capacity);
+            }
+
+            /// The encoded data of all finished rows.
+            const std::string& data() const noexcept {
+                return m_data;
+            }
+
+            /// The size of the data in bytes.
+            std::size_t size() const noexcept {
+                return m_data.size();
+            }
+
+            /// The number of finished rows.
+            std::size_t rows() const noexcept {
+                return m_rows;
+            }
+
+            bool empty() const noexcept {
+                return m_rows == 0;
+            }
+
+            /// Remove all rows. The memory is kept for reuse.
+            void clear() noexcept {
+                m_data.clear();
+                m_rows = 0;
+                m_fields = 0;
+                m_in_row = false;
+            }
+
+            void begin_row() {
+                assert(!m_in_row);
+                m_row_start = m_data.size();
+                m_data.append(2, '\0');
+                m_fields = 0;
+                m_in_row = true;
+            }
+
+            void end_row() {
+                assert(m_in_row);
+                detail::set_big_endian(m_data, m_row_start, static_cast<int16_t>(m_fields));
+                m_in_row = false;
+                ++m_rows;
+            }
+
+            /// Remove the fields of the current row.
+            void rollback_row() noexcept {
+                assert(m_in_row);
+                m_data.resize(m_row_start);
+                m_in_row = false;
+            }
+
+            /// Add NULL value.
+            void add_null() {
+                assert(m_in_row);
+                ++m_fields;
+                detail::append_big_endian(m_data, static_cast<int32_t>(-1));
+            }
+
+            /// Add value for a boolean column.
+            void add_bool(bool value) {
+                add_fixed(static_cast<uint8_t>(value ? 1 : 0));
+            }
+
+            /// Add value for a smallint (int2) column.
+            void add_int2(int16_t value) {
+                add_fixed(value);
+            }
+
+            /// Add value for an int (int4) column.
+            void add_int4(int32_t value) {
+                add_fixed(value);
+            }
+
+            /// Add value for a bigint (int8) column.
+            void add_int8(int64_t value) {
+                add_fixed(value);
+            }
+
+            /// Add value for a double precision (float8) column.
+            void add_float8(double value) {
+                uint64_t bits = 0;
+                std::memcpy(&bits, &value, sizeof(bits));
+                add_fixed(bits);
+            }
+
+            /// Add value for a text or varchar column.
+            void add_text(const char* value, std::size_t length) {
+                assert(m_in_row);
+                ++m_fields;
+                add_length(length);
+                m_data.append(value, length);
+            }
+
+            /// Add value for a text or varchar column.
+            void add_text(const char* value) {
+                add_text(value, std::strlen(value));
+            }
+
+            /// Add value for a text or varchar column.
+            void add_text(const std::string& value) {
+                add_text(value.data(), value.size());
+            }
+
+            /**
+             * Add value for a bytea column or a PostGIS geometry column
+             * (as WKB or EWKB in binary form).
+             */
+            void add_binary(const std::string& value) {
+                add_text(value.data(), value.size());
+            }
+
+            /// Add tags as value for an hstore column.
+            void add_hstore(const osmium::TagList& tags) {
+                const auto pos = begin_field();
+                detail::append_big_endian(m_data, static_cast<int32_t>(tags.size()));
+                for (const auto& tag : tags) {
+                    const auto key_length = std::strlen(tag.key());
+                    add_length(key_length);
+                    m_data.append(tag.key(), key_length);
+                    const auto value_length = std::strlen(tag.value());
+                    add_length(value_length);
+                    m_data.append(tag.value(), value_length);
+                }
+                end_field(pos);
+            }
+
+            /**
+             * Add tags as value for a jsonb column. The tags are encoded
+             * as JSON object with the keys and values as strings. If a key
+             * appears more than once, the server keeps the last value.
+             */
+            void add_jsonb(const osmium::TagList& tags) {
+                const auto pos = begin_field();
+                m_data += '\x01'; // jsonb binary format version
+                m_data += '{';
+                bool first = true;
+                for (const auto& tag : tags) {
+                    if (!first) {
+                        m_data += ',';
+                    }
+                    first = false;
+                    m_data += '"';
+                    detail::append_json_encoded_string(m_data, tag.key());
+                    m_data += "\":\"";
+                    detail::append_json_encoded_string(m_data, tag.value());
+                    m_data += '"';
+                }
+                m_data += '}';
+                end_field(pos);
+            }
+
+        }; // class PgCopyBatch
+
+        /// Header of the PostgreSQL binary COPY format.
+        inline std::string pg_copy_header() {
+            static const char header[] = "PGCOPY\n\377\r\n\0" // signature
+                                         "\0\0\0\0"           // flags
+                                         "\0\0\0\0";          // header extension length
+            return std::string(header, sizeof(header) - 1);
+        }
+
+        /// Trailer of the PostgreSQL binary COPY format.
+        inline std::string pg_copy_trailer() {
+            return std::string(2, '\xff');
+        }
+
+        /**
+         * Turns buffers with OSM data into batches of rows in the
+         * PostgreSQL binary COPY format. The batches are built in
+         * parallel in the thread pool and handed to a callback, usually
+         * writing them with PQputCopyData(), in the order the buffers
+         * came in.
+         *
+         * @code
+         * osmium::io::PgCopyWriter writer{
+         *     [](const osmium::memory::Buffer& buffer, osmium::io::PgCopyBatch& batch) {
+         *         osmium::geom::WKBFactory<> factory{osmium::geom::wkb_type::ewkb, osmium::geom::out_type::binary};
+         *         for (const auto& node : buffer.select<osmium::Node>()) {
+         *             batch.begin_row();
+         *             batch.add_int8(node.id());
+         *             batch.add_jsonb(node.tags());
+         *             batch.add_binary(factory.create_point(node));
+         *             batch.end_row();
+         *         }
+         *     },
+         *     [conn](const std::string& data) {
+         *         PQputCopyData(conn, data.data(), static_cast<int>(data.size()));
+         *     }
+         * };
+         * while (auto buffer = reader.read()) {
+         *     writer(std::move(buffer));
+         * }
+         * writer.close();
+         * @endcode
+         *
+         * The build function is called in pool threads, possibly several
+         * times concurrently. The write function is always called from
+         * the thread calling operator(), flush(), or close(), first with
+         * the COPY header, then with the batches, and, from close(), with
+         * the trailer. Empty batches are not written. The memory of the
+         * batches is reused after the write function returned.
+         */
+        class PgCopyWriter {
+
+        public:
+
+            using build_function = std::function<void(const osmium::memory::Buffer&, PgCopyBatch&)>;
+            using write_function = std::function<void(const std::string&)>;
+
+        private:
+
+            class build_task {
+
+                PgCopyWriter* m_writer;
+                osmium::memory::Buffer m_buffer;
+
+            public:
+
+                build_task(PgCopyWriter* writer, osmium::memory::Buffer&& buffer) noexcept :
+                    m_writer(writer),
+                    m_buffer(std::move(buffer)) {
+                }
+
+                PgCopyBatch operator()() {
+                    PgCopyBatch batch{m_writer->get_batch()};
+                    m_writer->m_build(m_buffer, batch);
+                    return batch;
+                }
+
+            }; // class build_task
+
+            osmium::thread::Pool& m_pool;
+            build_function m_build;
+            write_function m_write;
+
+            std::mutex m_free_mutex{};
+            std::vector<PgCopyBatch> m_free_batches{};
+
+            bool m_header_written = false;
+            bool m_closed = false;
+
+            // Must be destroyed first, because its destructor waits for
+            // the build tasks which use the other members.
+            osmium::thread::CompletionRing<PgCopyBatch> m_ring;
+
+            PgCopyBatch get_batch() {
+                const std::lock_guard<std::mutex> lock{m_free_mutex};
+                if (m_free_batches.empty()) {
+                    return PgCopyBatch{};
+                }
+                PgCopyBatch batch{std::move(m_free_batches.back())};
+                m_free_batches.pop_back();
+                return batch;
+            }
+
+            void put_batch(PgCopyBatch&& batch) {
+                batch.clear();
+                const std::lock_guard<std::mutex> lock{m_free_mutex};
+                if (m_free_batches.size() < m_ring.capacity()) {
+                    m_free_batches.push_back(std::move(batch));
+                }
+            }
+
+            void write_header() {
+                if (!m_header_written) {
+                    m_header_written = true;
+                    m_write(pg_copy_header());
+                }
+            }
+
+            void write_next() {
+                PgCopyBatch batch{m_ring.pop()};
+                if (!batch.empty()) {
+                    m_write(batch.data());
+                }
+                put_batch(std::move(batch));
+            }
+
+        public:
+
+            /**
+             * Create a writer.
+             *
+             * @param build Function adding the rows for all objects in a
+             *        buffer to a batch.
+             * @param write Function writing the COPY data.
+             * @param pool The thread pool the build function runs in.
+             * @param max_batches Maximum number of batches being built
+             *        or waiting to be written. If this is 0, the value is
+             *        read from the environment variable
+             *        OSMIUM_MAX_PGCOPY_QUEUE_SIZE, default is 20.
+             */
+            PgCopyWriter(build_function build,
+                         write_function write,
+                         osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(),
+                         std::size_t max_batches = 0) :
+                m_pool(pool),
+                m_build(std::move(build)),
+                m_write(std::move(write)),
+                m_ring(max_batches > 0 ? max_batches : detail::get_pg_copy_max_batches()) {
+            }
+
+            PgCopyWriter(const PgCopyWriter&) = delete;
+            PgCopyWriter& operator=(const PgCopyWriter&) = delete;
+
+            PgCopyWriter(PgCopyWriter&&) = delete;
+            PgCopyWriter& operator=(PgCopyWriter&&) = delete;
+
+            /**
+             * The destructor waits for outstanding batches but doesn't
+             * write them. Call close() to write everything.
+             */
+            ~PgCopyWriter() noexcept = default;
+
+            /**
+             * Build rows from the objects in a buffer. If too many batches
+             * are outstanding, the oldest ones are written first.
+             *
+             * @throws Any exception thrown by the build function (for an
+             *         earlier buffer) or the write function.
+             */
+            void operator()(osmium::memory::Buffer&& buffer) {
+                if (m_closed) {
+                    throw std::logic_error{"PgCopyWriter is closed"};
+                }
+                write_header();
+                if (!buffer) {
+                    return;
+                }
+                if (m_ring.full()) {
+                    write_next();
+                }
+                m_ring.submit(m_pool, build_task{this, std::move(buffer)});
+            }
+
+            /// Wait for all outstanding batches and write them.
+            void flush() {
+                write_header();
+                while (!m_ring.empty()) {
+                    write_next();
+                }
+            }
+
+            /**
+             * Write all outstanding batches and the COPY trailer. After
+             * this the writer can't be used any more.
+             */
+            void close() {
+                if (m_closed) {
+                    return;
+                }
+                flush();
+                m_closed = true;
+                m_write(pg_copy_trailer());
+            }
+
+        }; // class PgCopyWriter
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PG_COPY_HPP
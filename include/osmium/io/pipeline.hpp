@@ -0,0 +1,578 @@
+#ifndef OSMIUM_IO_PIPELINE_HPP
+#define OSMIUM_IO_PIPELINE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/function_wrapper.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/stats.hpp>
+#include <osmium/util/config.hpp>
+#include <osmium/visitor.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Does a pipeline stage (or the sink) need to see the buffers in
+         * the order they came from the source?
+         */
+        enum class stage_order {
+            ordered   = 0, ///< Buffers are handed to the stage in source order.
+            unordered = 1  ///< Buffers are handed to the stage as soon as they are ready.
+        };
+
+        /**
+         * Can a pipeline stage work on several buffers at the same time?
+         */
+        enum class stage_concurrency {
+            serial   = 0, ///< Stage function is never called concurrently.
+            parallel = 1  ///< Stage function is called for several buffers concurrently.
+        };
+
+        namespace detail {
+
+            inline std::size_t get_pipeline_max_in_flight() noexcept {
+                return osmium::config::get_max_queue_size("PIPELINE", 20);
+            }
+
+        } // namespace detail
+
+        /**
+         * A pipeline that takes buffers from a source, runs them through
+         * a number of stages and hands them to a sink. The source is
+         * usually a Reader and the sink a Writer, but they can be any
+         * functions:
+         *
+         * @code
+         * osmium::io::Reader reader{"input.osm.pbf"};
+         * osmium::io::Writer writer{"output.osm.pbf"};
+         *
+         * osmium::io::Pipeline pipeline;
+         * pipeline.add_stage("filter", [](osmium::memory::Buffer&& buffer) {
+         *     ...
+         *     return std::move(buffer);
+         * }, osmium::io::stage_order::unordered, osmium::io::stage_concurrency::parallel);
+         * pipeline.add_handler_stage("count", count_handler);
+         * pipeline.run([&reader]() { return reader.read(); }, std::ref(writer));
+         *
+         * writer.close();
+         * reader.close();
+         * @endcode
+         *
+         * The stage functions run as tasks in the thread pool. A serial
+         * stage works on one buffer at a time, a parallel stage on as
+         * many as are available. An ordered stage gets the buffers in
+         * the order the source returned them, an unordered stage gets
+         * them as soon as the previous stage is done with them. So
+         * stateful handlers that need to see the data in order (for
+         * instance to add node locations to ways) should be in serial
+         * ordered stages, functions working on each buffer on its own
+         * can be in parallel unordered stages.
+         *
+         * A stage function gets a buffer and returns a buffer, usually
+         * the same one. If it returns an invalid buffer, the data is
+         * dropped, later stages and the sink will not see it.
+         *
+         * The source and sink are called from the thread calling run().
+         * The number of buffers in flight between them is limited, when
+         * the limit is reached, the source isn't called until the sink
+         * got a buffer. Between stages the buffers wait in queues which
+         * are bounded by the same limit.
+         *
+         * If the source, the sink or any of the stage functions throw,
+         * no more buffers are handed to the stages, and run() rethrows
+         * the first exception after all running stage functions
+         * returned.
+         *
+         * Stage functions must not wait for other tasks in the same pool
+         * and run() must not be called from inside a pool task, otherwise
+         * the pool can deadlock.
+         */
+        class Pipeline {
+
+        public:
+
+            using stage_function = std::function<osmium::memory::Buffer(osmium::memory::Buffer&&)>;
+            using source_function = std::function<osmium::memory::Buffer()>;
+            using sink_function = std::function<void(osmium::memory::Buffer&&)>;
+
+        private:
+
+            struct stage {
+
+                std::string name;
+                stage_function func;
+                stage_order order;
+                stage_concurrency concurrency;
+
+                /// Buffers waiting for this stage by sequence number.
+                /// Dropped buffers are kept as invalid buffers, so that
+                /// ordered stages don't wait for them.
+                std::map<uint64_t, osmium::memory::Buffer> input{};
+
+                /// Next sequence number for ordered stages.
+                uint64_t next = 0;
+
+                /// Number of stage functions running.
+                std::size_t running = 0;
+
+                std::size_t largest_size = 0;
+                uint64_t pushes = 0;
+                uint64_t pops = 0;
+
+                detail::stage_counter counter{};
+
+                stage(std::string&& n, stage_function&& f, stage_order o, stage_concurrency c) :
+                    name(std::move(n)),
+                    func(std::move(f)),
+                    order(o),
+                    concurrency(c) {
+                }
+
+                void reset() {
+                    input.clear();
+                    next = 0;
+                }
+
+                void push(uint64_t seq, osmium::memory::Buffer&& buffer) {
+                    input.emplace(seq, std::move(buffer));
+                    ++pushes;
+                    if (largest_size < input.size()) {
+                        largest_size = input.size();
+                    }
+                }
+
+                bool can_take() const noexcept {
+                    if (input.empty()) {
+                        return false;
+                    }
+                    if (concurrency == stage_concurrency::serial && running > 0) {
+                        return false;
+                    }
+                    return order == stage_order::unordered || input.begin()->first == next;
+                }
+
+                std::pair<uint64_t, osmium::memory::Buffer> take() {
+                    const auto it = input.begin();
+                    std::pair<uint64_t, osmium::memory::Buffer> result{it->first, std::move(it->second)};
+                    input.erase(it);
+                    ++next;
+                    ++pops;
+                    return result;
+                }
+
+                osmium::thread::queue_stats queue_stats(std::size_t max_size) const {
+                    osmium::thread::queue_stats result;
+                    result.name = name;
+                    result.max_size = max_size;
+                    result.size = input.size();
+                    result.largest_size = largest_size;
+                    result.pushes = pushes;
+                    result.pops = pops;
+                    return result;
+                }
+
+            }; // struct stage
+
+            class stage_task {
+
+                Pipeline* m_pipeline;
+                std::size_t m_stage;
+                uint64_t m_seq;
+                osmium::memory::Buffer m_buffer;
+
+            public:
+
+                stage_task(Pipeline* pipeline, std::size_t stage, uint64_t seq, osmium::memory::Buffer&& buffer) noexcept :
+                    m_pipeline(pipeline),
+                    m_stage(stage),
+                    m_seq(seq),
+                    m_buffer(std::move(buffer)) {
+                }
+
+                void operator()() {
+                    m_pipeline->run_stage(m_stage, m_seq, std::move(m_buffer));
+                }
+
+            }; // class stage_task
+
+            osmium::thread::Pool& m_pool;
+            std::size_t m_max_in_flight;
+
+            std::vector<std::unique_ptr<stage>> m_stages;
+
+            /// Buffers ready for the sink.
+            std::unique_ptr<stage> m_sink;
+
+            mutable std::mutex m_mutex{};
+            std::condition_variable m_cv{};
+
+            std::size_t m_in_flight = 0;
+            std::size_t m_largest_in_flight = 0;
+            uint64_t m_source_count = 0;
+            uint64_t m_sink_count = 0;
+            std::size_t m_running_tasks = 0;
+            std::exception_ptr m_exception{};
+
+            detail::stage_counter m_source_counter{};
+            osmium::thread::detail::wait_counter m_full_waits{};
+            osmium::thread::detail::wait_counter m_empty_waits{};
+
+            void set_exception(std::exception_ptr&& exception) noexcept {
+                if (!m_exception) {
+                    m_exception = std::move(exception);
+                }
+            }
+
+            // Hand the buffer to the stage after the given one (or the sink).
+            void forward(std::size_t index, uint64_t seq, osmium::memory::Buffer&& buffer) {
+                stage& next = index + 1 < m_stages.size() ? *m_stages[index + 1] : *m_sink;
+                next.push(seq, std::move(buffer));
+            }
+
+            // Create tasks for all buffers the stages can work on now.
+            // Dropped buffers are passed through directly. Must be called
+            // with the mutex held.
+            void collect_tasks(std::vector<osmium::thread::function_wrapper>& tasks) {
+                if (m_exception) {
+                    return;
+                }
+                for (std::size_t i = 0; i < m_stages.size(); ++i) {
+                    auto& s = *m_stages[i];
+                    while (s.can_take()) {
+                        auto item = s.take();
+                        if (item.second) {
+                            ++s.running;
+                            ++m_running_tasks;
+                            tasks.emplace_back(stage_task{this, i, item.first, std::move(item.second)});
+                        } else {
+                            forward(i, item.first, std::move(item.second));
+                        }
+                    }
+                }
+            }
+
+            void post_tasks(std::vector<osmium::thread::function_wrapper>& tasks) {
+                if (tasks.empty()) {
+                    return;
+                }
+                const auto num_tasks = tasks.size();
+                try {
+                    m_pool.post_batch(tasks);
+                } catch (...) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    set_exception(std::current_exception());
+                    m_running_tasks -= num_tasks;
+                    m_cv.notify_all();
+                }
+            }
+
+            void run_stage(std::size_t index, uint64_t seq, osmium::memory::Buffer&& buffer) {
+                auto& s = *m_stages[index];
+                osmium::memory::Buffer result;
+                std::exception_ptr exception;
+
+                const auto start = detail::stage_counter::clock::now();
+                s.counter.add(buffer.committed());
+                try {
+                    result = s.func(std::move(buffer));
+                } catch (...) {
+                    exception = std::current_exception();
+                }
+                s.counter.add_busy_time(start);
+
+                std::vector<osmium::thread::function_wrapper> tasks;
+                {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    --s.running;
+                    --m_running_tasks;
+                    if (exception) {
+                        set_exception(std::move(exception));
+                    } else {
+                        forward(index, seq, std::move(result));
+                        collect_tasks(tasks);
+                    }
+                    m_cv.notify_all();
+                }
+                post_tasks(tasks);
+            }
+
+            bool source_can_push(bool source_done) const noexcept {
+                return !source_done && m_in_flight < m_max_in_flight;
+            }
+
+            void reset() {
+                for (auto& s : m_stages) {
+                    s->reset();
+                }
+                m_sink->reset();
+                m_in_flight = 0;
+                m_exception = nullptr;
+            }
+
+            void drive(const source_function& source, const sink_function& sink) {
+                uint64_t seq = 0;
+                bool source_done = false;
+                std::vector<osmium::thread::function_wrapper> tasks;
+
+                std::unique_lock<std::mutex> lock{m_mutex};
+                while (!m_exception) {
+                    if (m_sink->can_take()) {
+                        auto item = m_sink->take();
+                        lock.unlock();
+                        if (item.second) {
+                            m_sink->counter.add(item.second.committed());
+                            const auto start = detail::stage_counter::clock::now();
+                            sink(std::move(item.second));
+                            m_sink->counter.add_busy_time(start);
+                        }
+                        lock.lock();
+                        --m_in_flight;
+                        ++m_sink_count;
+                        continue;
+                    }
+
+                    if (source_can_push(source_done)) {
+                        lock.unlock();
+                        const auto start = detail::stage_counter::clock::now();
+                        osmium::memory::Buffer buffer{source()};
+                        m_source_counter.add_busy_time(start);
+                        if (buffer) {
+                            m_source_counter.add(buffer.committed());
+                        }
+                        lock.lock();
+                        if (!buffer) {
+                            source_done = true;
+                            continue;
+                        }
+                        ++m_in_flight;
+                        ++m_source_count;
+                        if (m_largest_in_flight < m_in_flight) {
+                            m_largest_in_flight = m_in_flight;
+                        }
+                        if (m_stages.empty()) {
+                            m_sink->push(seq++, std::move(buffer));
+                        } else {
+                            m_stages.front()->push(seq++, std::move(buffer));
+                            collect_tasks(tasks);
+                            lock.unlock();
+                            post_tasks(tasks);
+                            tasks.clear();
+                            lock.lock();
+                        }
+                        continue;
+                    }
+
+                    if (source_done && m_in_flight == 0) {
+                        return;
+                    }
+
+                    const bool full = !source_done;
+                    const auto start = osmium::thread::detail::wait_counter::clock::now();
+                    m_cv.wait(lock, [this, source_done]() {
+                        return m_exception || m_sink->can_take() || source_can_push(source_done);
+                    });
+                    if (full) {
+                        m_full_waits.add(start);
+                    } else {
+                        m_empty_waits.add(start);
+                    }
+                }
+            }
+
+        public:
+
+            /**
+             * Create a pipeline without any stages.
+             *
+             * @param pool The thread pool the stage functions are run in.
+             * @param max_in_flight The maximum number of buffers between
+             *        the source and the sink. If this is 0, the value is
+             *        read from the environment variable
+             *        OSMIUM_MAX_PIPELINE_QUEUE_SIZE, default is 20.
+             */
+            explicit Pipeline(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(), std::size_t max_in_flight = 0) :
+                m_pool(pool),
+                m_max_in_flight(max_in_flight > 0 ? max_in_flight : detail::get_pipeline_max_in_flight()),
+                m_sink(new stage{"sink", stage_function{}, stage_order::ordered, stage_concurrency::serial}) {
+            }
+
+            Pipeline(const Pipeline&) = delete;
+            Pipeline& operator=(const Pipeline&) = delete;
+
+            Pipeline(Pipeline&&) = delete;
+            Pipeline& operator=(Pipeline&&) = delete;
+
+            ~Pipeline() noexcept = default;
+
+            /// The maximum number of buffers between the source and the sink.
+            std::size_t max_in_flight() const noexcept {
+                return m_max_in_flight;
+            }
+
+            /// The number of stages.
+            std::size_t num_stages() const noexcept {
+                return m_stages.size();
+            }
+
+            /**
+             * Add a stage at the end of the pipeline. Stages can not be
+             * added while the pipeline is running.
+             *
+             * @param name Name of the stage (for statistics).
+             * @param func The function called for each buffer.
+             * @param order Does the stage need the buffers in order?
+             * @param concurrency Can the function be called concurrently?
+             * @returns Reference to this pipeline for chaining.
+             */
+            Pipeline& add_stage(std::string name,
+                                stage_function func,
+                                stage_order order = stage_order::ordered,
+                                stage_concurrency concurrency = stage_concurrency::serial) {
+                m_stages.emplace_back(new stage{std::move(name), std::move(func), order, concurrency});
+                return *this;
+            }
+
+            /**
+             * Add a stage which applies the handler to all objects in each
+             * buffer (see osmium::apply()). The buffers are passed on
+             * unchanged. If the stage is parallel, the handler must be
+             * thread-safe.
+             *
+             * @returns Reference to this pipeline for chaining.
+             */
+            template <typename THandler>
+            Pipeline& add_handler_stage(std::string name,
+                                        THandler& handler,
+                                        stage_order order = stage_order::ordered,
+                                        stage_concurrency concurrency = stage_concurrency::serial) {
+                return add_stage(std::move(name), [&handler](osmium::memory::Buffer&& buffer) {
+                    osmium::apply(buffer, handler);
+                    return std::move(buffer);
+                }, order, concurrency);
+            }
+
+            /**
+             * Run the pipeline. Calls the source until it returns an
+             * invalid buffer, runs all buffers through the stages and
+             * hands them to the sink. Returns when the sink got all
+             * buffers.
+             *
+             * @param source Function returning the next buffer, an
+             *        invalid buffer at the end of data.
+             * @param sink Function called with all buffers coming out of
+             *        the last stage.
+             * @param sink_order Does the sink need the buffers in order?
+             * @throws Any exception thrown by the source, sink, or the
+             *         stage functions.
+             */
+            void run(const source_function& source, const sink_function& sink, stage_order sink_order = stage_order::ordered) {
+                {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    reset();
+                    m_sink->order = sink_order;
+                }
+
+                try {
+                    drive(source, sink);
+                } catch (...) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    set_exception(std::current_exception());
+                }
+
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_cv.wait(lock, [this]() {
+                    return m_running_tasks == 0;
+                });
+
+                if (m_exception) {
+                    auto exception = std::move(m_exception);
+                    reset();
+                    std::rethrow_exception(exception);
+                }
+            }
+
+            /**
+             * Get the current values of the counters of this pipeline.
+             * Can be called from any thread while the pipeline is running.
+             */
+            pipeline_stats stats() const {
+                pipeline_stats result;
+                result.source = m_source_counter.stats();
+                result.sink = m_sink->counter.stats();
+                {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    for (const auto& s : m_stages) {
+                        pipeline_stage_stats stage_result;
+                        stage_result.name = s->name;
+                        stage_result.work = s->counter.stats();
+                        stage_result.queue = s->queue_stats(m_max_in_flight);
+                        result.stages.push_back(std::move(stage_result));
+                    }
+                    result.in_flight.max_size = m_max_in_flight;
+                    result.in_flight.size = m_in_flight;
+                    result.in_flight.largest_size = m_largest_in_flight;
+                    result.in_flight.pushes = m_source_count;
+                    result.in_flight.pops = m_sink_count;
+                }
+                result.in_flight.name = "in_flight";
+                result.in_flight.full_waits = m_full_waits.count();
+                result.in_flight.full_wait_time = m_full_waits.time();
+                result.in_flight.empty_waits = m_empty_waits.count();
+                result.in_flight.empty_wait_time = m_empty_waits.time();
+                result.pool = m_pool.stats();
+                return result;
+            }
+
+        }; // class Pipeline
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PIPELINE_HPP
@@ -0,0 +1,306 @@
+#ifndef OSMIUM_IO_PIPELINE_STATS_HPP
+#define OSMIUM_IO_PIPELINE_STATS_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/bloom_filter.hpp>
+#include <osmium/thread/stats.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Counters for one stage of the Reader or Writer pipeline.
+         */
+        struct stage_stats {
+
+            /// Number of bytes handled.
+            uint64_t bytes = 0;
+
+            /// Number of items (data chunks or buffers) handled.
+            uint64_t items = 0;
+
+            /// Time spent working on them (including any I/O).
+            std::chrono::nanoseconds busy_time{0};
+
+        }; // struct stage_stats
+
+        /**
+         * Statistics for a Reader, see Reader::stats().
+         *
+         * If the read thread is mostly busy and the input queue is often
+         * empty, reading is I/O or decompression bound; if the parser
+         * results queue is often full, the consumer is too slow.
+         */
+        struct reader_stats {
+
+            /// Data read and decompressed by the read thread.
+            stage_stats read;
+
+            /// Queue between the read thread and the parser.
+            osmium::thread::queue_stats input_queue;
+
+            /// Queue between the parser and Reader::read().
+            osmium::thread::queue_stats osmdata_queue;
+
+            /// Buffers returned by Reader::read().
+            stage_stats output;
+
+            /// Thread pool used for parsing. It is usually shared with
+            /// other readers and writers.
+            osmium::thread::pool_stats pool;
+
+        }; // struct reader_stats
+
+        /**
+         * Statistics for a Writer, see Writer::stats().
+         *
+         * If the output queue is often full, writing is I/O or compression
+         * bound.
+         */
+        struct writer_stats {
+
+            /// Buffers given to the writer.
+            stage_stats input;
+
+            /// Queue between the encoder and the write thread.
+            osmium::thread::queue_stats output_queue;
+
+            /// Data compressed and written by the write thread.
+            stage_stats write;
+
+            /// Thread pool used for encoding. It is usually shared with
+            /// other readers and writers.
+            osmium::thread::pool_stats pool;
+
+        }; // struct writer_stats
+
+        /**
+         * Statistics for one stage of a Pipeline.
+         */
+        struct pipeline_stage_stats {
+
+            /// Name of the stage.
+            std::string name;
+
+            /// Buffers handled by the stage function.
+            stage_stats work;
+
+            /// Buffers waiting for the stage.
+            osmium::thread::queue_stats queue;
+
+        }; // struct pipeline_stage_stats
+
+        /**
+         * Statistics for a Pipeline, see Pipeline::stats().
+         *
+         * If the in_flight queue is often full, the stages or the sink
+         * are too slow and hold up the source. If it is often empty
+         * (i.e. the sink had to wait), the source is too slow.
+         */
+        struct pipeline_stats {
+
+            /// Buffers from the source.
+            stage_stats source;
+
+            /// All stages in the order they were added.
+            std::vector<pipeline_stage_stats> stages;
+
+            /// Buffers given to the sink.
+            stage_stats sink;
+
+            /// Buffers between source and sink. The maximum size is the
+            /// limit for buffers in flight, "full" waits are waits of
+            /// the source because of this limit, "empty" waits are waits
+            /// for the stages.
+            osmium::thread::queue_stats in_flight;
+
+            /// Thread pool used for running the stages.
+            osmium::thread::pool_stats pool;
+
+        }; // struct pipeline_stats
+
+        namespace detail {
+
+            /**
+             * Thread-safe counters for one stage of the pipeline.
+             */
+            class stage_counter {
+
+                std::atomic<uint64_t> m_bytes{0};
+                std::atomic<uint64_t> m_items{0};
+                std::atomic<uint64_t> m_busy_time{0};
+
+            public:
+
+                using clock = std::chrono::steady_clock;
+
+                void add(std::size_t bytes) noexcept {
+                    m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                    m_items.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                void add_busy_time(clock::time_point start) noexcept {
+                    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+                    m_busy_time.fetch_add(static_cast<uint64_t>(duration.count()), std::memory_order_relaxed);
+                }
+
+                stage_stats stats() const noexcept {
+                    stage_stats result;
+                    result.bytes = m_bytes.load(std::memory_order_relaxed);
+                    result.items = m_items.load(std::memory_order_relaxed);
+                    result.busy_time = std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(m_busy_time.load(std::memory_order_relaxed))};
+                    return result;
+                }
+
+            }; // class stage_counter
+
+            inline std::string seconds_to_string(std::chrono::nanoseconds time) {
+                return std::to_string(std::chrono::duration<double>(time).count());
+            }
+
+            inline void append_metric(std::string& out, const std::string& name, const std::string& labels, const std::string& value) {
+                out += name;
+                if (!labels.empty()) {
+                    out += '{';
+                    out += labels;
+                    out += '}';
+                }
+                out += ' ';
+                out += value;
+                out += '\n';
+            }
+
+            inline void append_stage_metrics(std::string& out, const std::string& prefix, const char* stage, const stage_stats& stats) {
+                const std::string labels{std::string{"stage=\""} + stage + "\""};
+                append_metric(out, prefix + "_stage_bytes_total", labels, std::to_string(stats.bytes));
+                append_metric(out, prefix + "_stage_items_total", labels, std::to_string(stats.items));
+                append_metric(out, prefix + "_stage_busy_seconds_total", labels, seconds_to_string(stats.busy_time));
+            }
+
+            inline void append_queue_metrics(std::string& out, const std::string& prefix, const osmium::thread::queue_stats& stats) {
+                const std::string labels{"queue=\"" + stats.name + "\""};
+                append_metric(out, prefix + "_queue_size", labels, std::to_string(stats.size));
+                append_metric(out, prefix + "_queue_max_size", labels, std::to_string(stats.max_size));
+                append_metric(out, prefix + "_queue_largest_size", labels, std::to_string(stats.largest_size));
+                append_metric(out, prefix + "_queue_pushes_total", labels, std::to_string(stats.pushes));
+                append_metric(out, prefix + "_queue_pops_total", labels, std::to_string(stats.pops));
+                append_metric(out, prefix + "_queue_waits_total", labels + ",side=\"full\"", std::to_string(stats.full_waits));
+                append_metric(out, prefix + "_queue_waits_total", labels + ",side=\"empty\"", std::to_string(stats.empty_waits));
+                append_metric(out, prefix + "_queue_wait_seconds_total", labels + ",side=\"full\"", seconds_to_string(stats.full_wait_time));
+                append_metric(out, prefix + "_queue_wait_seconds_total", labels + ",side=\"empty\"", seconds_to_string(stats.empty_wait_time));
+            }
+
+            inline void append_pool_metrics(std::string& out, const std::string& prefix, const osmium::thread::pool_stats& stats) {
+                append_metric(out, prefix + "_pool_threads", "", std::to_string(stats.num_threads));
+                append_metric(out, prefix + "_pool_queued_tasks", "", std::to_string(stats.queued_tasks));
+                append_metric(out, prefix + "_pool_tasks_total", "", std::to_string(stats.tasks_done));
+                append_metric(out, prefix + "_pool_busy_seconds_total", "", seconds_to_string(stats.busy_time));
+            }
+
+        } // namespace detail
+
+        /**
+         * Format reader statistics in the Prometheus text exposition
+         * format. All metric names start with the prefix.
+         */
+        inline std::string to_prometheus(const reader_stats& stats, const std::string& prefix = "osmium_reader") {
+            std::string out;
+            detail::append_stage_metrics(out, prefix, "read", stats.read);
+            detail::append_stage_metrics(out, prefix, "output", stats.output);
+            detail::append_queue_metrics(out, prefix, stats.input_queue);
+            detail::append_queue_metrics(out, prefix, stats.osmdata_queue);
+            detail::append_pool_metrics(out, prefix, stats.pool);
+            return out;
+        }
+
+        /**
+         * Format writer statistics in the Prometheus text exposition
+         * format. All metric names start with the prefix.
+         */
+        inline std::string to_prometheus(const writer_stats& stats, const std::string& prefix = "osmium_writer") {
+            std::string out;
+            detail::append_stage_metrics(out, prefix, "input", stats.input);
+            detail::append_stage_metrics(out, prefix, "write", stats.write);
+            detail::append_queue_metrics(out, prefix, stats.output_queue);
+            detail::append_pool_metrics(out, prefix, stats.pool);
+            return out;
+        }
+
+        /**
+         * Format pipeline statistics in the Prometheus text exposition
+         * format. All metric names start with the prefix.
+         */
+        inline std::string to_prometheus(const pipeline_stats& stats, const std::string& prefix = "osmium_pipeline") {
+            std::string out;
+            detail::append_stage_metrics(out, prefix, "source", stats.source);
+            for (const auto& stage : stats.stages) {
+                detail::append_stage_metrics(out, prefix, stage.name.c_str(), stage.work);
+            }
+            detail::append_stage_metrics(out, prefix, "sink", stats.sink);
+            detail::append_queue_metrics(out, prefix, stats.in_flight);
+            for (const auto& stage : stats.stages) {
+                detail::append_queue_metrics(out, prefix, stage.queue);
+            }
+            detail::append_pool_metrics(out, prefix, stats.pool);
+            return out;
+        }
+
+        /**
+         * Format Bloom filter statistics of a sparse index map in the
+         * Prometheus text exposition format. All metric names start with
+         * the prefix.
+         */
+        inline std::string to_prometheus(const osmium::index::bloom_filter_stats& stats, const std::string& prefix = "osmium_bloom_filter") {
+            std::string out;
+            detail::append_metric(out, prefix + "_lookups_total", "result=\"rejected\"", std::to_string(stats.rejected));
+            detail::append_metric(out, prefix + "_lookups_total", "result=\"false_positive\"", std::to_string(stats.false_positives));
+            detail::append_metric(out, prefix + "_false_positive_rate", "", std::to_string(stats.false_positive_rate()));
+            detail::append_metric(out, prefix + "_bytes", "", std::to_string(stats.bytes));
+            return out;
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PIPELINE_STATS_HPP
@@ -0,0 +1,246 @@
+#ifndef OSMIUM_IO_READ_QUERY_HPP
+#define OSMIUM_IO_READ_QUERY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/io/detail/pbf_blob_index.hpp>
+#include <osmium/io/tags_prefilter.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Option for the osmium::io::Reader combining everything that
+         * decides which objects are read: the entity types, a tags
+         * filter, a bounding box for nodes, and sets of IDs. Each part is
+         * pushed down as far as possible, so only objects matching all
+         * parts reach the handlers:
+         *
+         * * The entity types replace the osm_entity_bits option of the
+         *   Reader. All parsers skip other types, the PBF parser stops
+         *   early in files sorted by type.
+         * * The tags filter replaces the tags_prefilter option (see
+         *   there), it is checked on the string table of PBF blocks.
+         * * Nodes outside the box and objects whose type has an ID set
+         *   but whose ID isn't in it are dropped by the PBF decoder
+         *   before they are built. Ways and relations are not checked
+         *   against the box, because their locations are not known
+         *   while reading.
+         * * If a blob index file (see IndexedPBFReader) is set, the PBF
+         *   parser reads the file using a blob table and doesn't read or
+         *   decode blobs which can't contain any object matching the
+         *   types, box and IDs. The index is ignored if it doesn't
+         *   belong to the file.
+         *
+         * Only the entity types and the tags filter are used for formats
+         * other than PBF.
+         *
+         * The ID sets are shared (not copied) between all copies of the
+         * query and used from several threads at the same time, they
+         * must not be changed after they were added.
+         *
+         * Usage:
+         * @code
+         * osmium::TagsFilter filter{false};
+         * filter.add_rule(true, "amenity");
+         * osmium::io::read_query query{osmium::osm_entity_bits::node | osmium::osm_entity_bits::way};
+         * query.set_tags_filter(filter);
+         * query.set_box(osmium::Box{9.0, 48.0, 10.0, 49.0});
+         * query.set_blob_index("input.osm.pbf.blobidx");
+         * osmium::io::Reader reader{"input.osm.pbf", query};
+         * osmium::apply(reader, handler);
+         * @endcode
+         */
+        class read_query {
+
+        public:
+
+            using id_set_type = osmium::index::IdSetDense<osmium::unsigned_object_id_type>;
+
+        private:
+
+            osmium::osm_entity_bits::type m_entities;
+            osmium::io::tags_prefilter m_prefilter{};
+            osmium::Box m_box{};
+            std::array<std::shared_ptr<const id_set_type>, 3> m_ids{};
+            std::string m_blob_index{};
+
+            const id_set_type* id_set(osmium::item_type type) const noexcept {
+                return m_ids[osmium::item_type_to_nwr_index(type)].get();
+            }
+
+        public:
+
+            /**
+             * Create a query.
+             *
+             * @param entities The types of objects to read.
+             */
+            explicit read_query(osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::all) noexcept :
+                m_entities(entities) {
+            }
+
+            /**
+             * Only read objects with at least one tag matching a filter.
+             * See tags_prefilter for the requirements on the filter.
+             *
+             * @param filter The filter.
+             * @param entities The types of objects to filter, objects of
+             *        other types are read whatever tags they have.
+             */
+            template <typename TFilter>
+            void set_tags_filter(const TFilter& filter, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr) {
+                m_prefilter = osmium::io::tags_prefilter{filter, entities};
+            }
+
+            /**
+             * Only read nodes inside this box. An invalid box (the
+             * default) doesn't filter anything.
+             */
+            void set_box(const osmium::Box& box) noexcept {
+                m_box = box;
+            }
+
+            /**
+             * Only read objects of the specified type with IDs in this
+             * set. Negative IDs are never in the set.
+             *
+             * @pre @code type is node, way, or relation @endcode
+             */
+            void set_ids(osmium::item_type type, id_set_type&& ids) {
+                m_ids[osmium::item_type_to_nwr_index(type)] = std::make_shared<const id_set_type>(std::move(ids));
+            }
+
+            /**
+             * Use the blob index in this file to skip blobs of PBF files.
+             * An empty name (the default) disables this.
+             */
+            void set_blob_index(const std::string& filename) {
+                m_blob_index = filename;
+            }
+
+            /// The types of objects to read.
+            osmium::osm_entity_bits::type entities() const noexcept {
+                return m_entities;
+            }
+
+            /// The tags filter, invalid if none was set.
+            const osmium::io::tags_prefilter& prefilter() const noexcept {
+                return m_prefilter;
+            }
+
+            /// The box for nodes, invalid if none was set.
+            const osmium::Box& box() const noexcept {
+                return m_box;
+            }
+
+            /// The name of the blob index file, empty if none was set.
+            const std::string& blob_index() const noexcept {
+                return m_blob_index;
+            }
+
+            /**
+             * Does this query drop objects by ID or location? (The types
+             * and the tags filter are handled by the Reader.)
+             */
+            bool filters_objects() const noexcept {
+                return m_box.valid() || m_ids[0] || m_ids[1] || m_ids[2];
+            }
+
+            /// Is there an ID set for this type?
+            bool has_ids(osmium::item_type type) const noexcept {
+                return id_set(type) != nullptr;
+            }
+
+            /// Is the object with this type and ID wanted?
+            bool wants_id(osmium::item_type type, osmium::object_id_type id) const noexcept {
+                const auto* ids = id_set(type);
+                return !ids || (id > 0 && ids->get(static_cast<osmium::unsigned_object_id_type>(id)));
+            }
+
+            /// Is a node with this location wanted?
+            bool wants_location(const osmium::Location& location) const noexcept {
+                return !m_box.valid() || m_box.contains(location);
+            }
+
+            /**
+             * Could a blob with this summary contain any wanted objects?
+             * The tags filter is not taken into account.
+             */
+            bool wants_blob(const osmium::io::pbf_blob_summary& summary) const noexcept {
+                // The summary doesn't know about changesets.
+                if ((m_entities & osmium::osm_entity_bits::changeset) && summary.types == osmium::osm_entity_bits::nothing) {
+                    return true;
+                }
+                const auto types = m_entities & summary.types;
+                for (unsigned int n = 0; n < 3; ++n) {
+                    const auto type = osmium::nwr_index_to_item_type(n);
+                    const auto bit = osmium::osm_entity_bits::from_item_type(type);
+                    if (!(types & bit)) {
+                        continue;
+                    }
+                    const auto* ids = id_set(type);
+                    if (ids && (summary.max_id[n] <= 0 ||
+                                !ids->contains_any(static_cast<osmium::unsigned_object_id_type>(std::max(summary.min_id[n], osmium::object_id_type{1})),
+                                                   static_cast<osmium::unsigned_object_id_type>(summary.max_id[n])))) {
+                        continue;
+                    }
+                    if (type == osmium::item_type::node && m_box.valid() && !summary.overlaps(bit, m_box)) {
+                        continue;
+                    }
+                    return true;
+                }
+                return false;
+            }
+
+        }; // class read_query
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_READ_QUERY_HPP
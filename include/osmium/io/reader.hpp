@@ -34,22 +34,42 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/data_ready_callback.hpp>
+#include <osmium/io/decoded_buffer_callback.hpp>
 #include <osmium/io/detail/input_format.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/detail/read_thread.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/detail/ready_notifier.hpp>
+#include <osmium/io/detail/sort_order_verifier.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
+#include <osmium/io/file_compression.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/io_executor.hpp>
+#include <osmium/io/max_memory_in_flight.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/io/remote_input.hpp>
+#include <osmium/io/read_query.hpp>
+#include <osmium/io/tags_prefilter.hpp>
+#include <osmium/io/timestamp_window.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/shared_buffer.hpp>
 #include <osmium/osm/entity_bits.hpp>
+#include <osmium/tags/sorted_tags.hpp>
 #include <osmium/thread/pool.hpp>
+#include <osmium/thread/thread_policy.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/tracepoint.hpp>
 
 #include <cerrno>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <exception>
 #include <fcntl.h>
+#include <functional>
 #include <future>
 #include <memory>
 #include <string>
@@ -65,6 +85,10 @@ DEALINGS IN THE SOFTWARE.
 # include <unistd.h>
 #endif
 
+#ifdef __cpp_impl_coroutine
+# include <coroutine>
+#endif
+
 namespace osmium {
 
     namespace io {
@@ -79,6 +103,94 @@ namespace osmium {
                 return osmium::config::get_max_queue_size("OSMDATA", 20);
             }
 
+            // Find the reader_queue_sizes option (if any) in the arguments
+            // to the Reader constructor. This is needed before the
+            // options are set, because the queues are created first.
+            inline reader_queue_sizes find_queue_sizes() noexcept {
+                return reader_queue_sizes{};
+            }
+
+            template <typename... TArgs>
+            inline reader_queue_sizes find_queue_sizes(const reader_queue_sizes& sizes, const TArgs&... /*args*/) noexcept {
+                return sizes;
+            }
+
+            template <typename T, typename... TArgs>
+            inline reader_queue_sizes find_queue_sizes(const T& /*value*/, const TArgs&... args) noexcept {
+                return find_queue_sizes(args...);
+            }
+
+            // Find the max_memory_in_flight option (if any) in the arguments
+            // to the Reader constructor. It is needed before the read thread
+            // is started.
+            inline max_memory_in_flight find_memory_limit() noexcept {
+                return max_memory_in_flight{};
+            }
+
+            template <typename... TArgs>
+            inline max_memory_in_flight find_memory_limit(const max_memory_in_flight& limit, const TArgs&... /*args*/) noexcept {
+                return limit;
+            }
+
+            template <typename T, typename... TArgs>
+            inline max_memory_in_flight find_memory_limit(const T& /*value*/, const TArgs&... args) noexcept {
+                return find_memory_limit(args...);
+            }
+
+            // Find the io_executor option (if any) in the arguments to the
+            // Reader constructor. It is needed before the read thread is
+            // started.
+            inline io_executor find_executor() noexcept {
+                return io_executor{};
+            }
+
+            template <typename... TArgs>
+            inline io_executor find_executor(const io_executor& executor, const TArgs&... /*args*/) noexcept {
+                return executor;
+            }
+
+            template <typename T, typename... TArgs>
+            inline io_executor find_executor(const T& /*value*/, const TArgs&... args) noexcept {
+                return find_executor(args...);
+            }
+
+            // Find the remote_input option (if any) in the arguments to the
+            // Reader constructor. It is needed before the file is opened.
+            inline const remote_input* find_remote_input() noexcept {
+                return nullptr;
+            }
+
+            template <typename... TArgs>
+            inline const remote_input* find_remote_input(const remote_input& remote, const TArgs&... /*args*/) noexcept {
+                return &remote;
+            }
+
+            template <typename T, typename... TArgs>
+            inline const remote_input* find_remote_input(const T& /*value*/, const TArgs&... args) noexcept {
+                return find_remote_input(args...);
+            }
+
+            // Find the thread_policy option (if any) in the arguments to the
+            // Reader constructor. It is needed before the threads are
+            // started. If there is none, the policy from the config is used.
+            inline osmium::thread::thread_policy find_thread_policy() {
+                return osmium::thread::thread_policy::from_config();
+            }
+
+            template <typename... TArgs>
+            inline osmium::thread::thread_policy find_thread_policy(const osmium::thread::thread_policy& policy, const TArgs&... /*args*/) {
+                return policy;
+            }
+
+            template <typename T, typename... TArgs>
+            inline osmium::thread::thread_policy find_thread_policy(const T& /*value*/, const TArgs&... args) {
+                return find_thread_policy(args...);
+            }
+
+            inline std::size_t queue_size(std::size_t size, std::size_t default_size) noexcept {
+                return size == 0 ? default_size : size;
+            }
+
         } // namespace detail
 
         /**
@@ -111,6 +223,8 @@ namespace osmium {
 
             int m_childpid = 0;
 
+            std::unique_ptr<detail::RemoteReader> m_remote_reader;
+
             detail::future_string_queue_type m_input_queue;
 
             int m_fd = -1;
@@ -119,6 +233,13 @@ namespace osmium {
 
             std::unique_ptr<osmium::io::Decompressor> m_decompressor;
 
+            detail::stage_counter m_read_counter;
+            detail::stage_counter m_output_counter;
+
+            std::shared_ptr<detail::memory_account> m_memory_account;
+
+            osmium::thread::thread_policy m_thread_policy;
+
             osmium::io::detail::ReadThreadManager m_read_thread_manager;
 
             detail::future_buffer_queue_type m_osmdata_queue;
@@ -133,6 +254,35 @@ namespace osmium {
             osmium::io::read_meta m_read_metadata = osmium::io::read_meta::yes;
             osmium::io::buffers_type m_buffers_kind = osmium::io::buffers_type::any;
 
+            std::shared_ptr<detail::BufferRecycler> m_buffer_recycler{std::make_shared<detail::BufferRecycler>()};
+
+            osmium::io::decoded_buffer_callback m_buffer_callback{};
+
+            osmium::io::tags_prefilter m_prefilter{};
+
+            osmium::io::timestamp_window m_timestamp_window{};
+
+            osmium::io::read_query m_read_query{};
+
+            osmium::io::keep_raw_blobs m_raw_blobs = osmium::io::keep_raw_blobs::no;
+
+            osmium::io::pool_for_pbf_parsing m_pbf_pool_parsing = osmium::io::pool_for_pbf_parsing::from_config;
+
+            osmium::io::verify_sorting m_verify_sorting = osmium::io::verify_sorting::no;
+
+            osmium::io::sort_tags m_sort_tags = osmium::io::sort_tags::no;
+
+            // Checks the order across buffer boundaries if the sorting is
+            // verified. Only set up once the header is known.
+            bool m_check_buffer_boundaries = false;
+            detail::sort_order_verifier m_sort_order_verifier{};
+
+            osmium::io::reader_buffer_size m_buffer_size{};
+
+            osmium::io::data_ready_callback m_data_ready_callback{};
+
+            std::shared_ptr<detail::ready_notifier> m_ready_notifier{};
+
             void set_option(osmium::thread::Pool& pool) noexcept {
                 m_pool = &pool;
             }
@@ -154,6 +304,78 @@ namespace osmium {
                 m_buffers_kind = value;
             }
 
+            void set_option(const osmium::io::decoded_buffer_callback& value) {
+                if (!value) {
+                    m_buffer_callback = value;
+                    return;
+                }
+                // Decoders can put their output into nested buffers, the
+                // callback gets each of them.
+                m_buffer_callback = osmium::io::decoded_buffer_callback{[value](osmium::memory::Buffer& buffer) {
+                    buffer.for_each_buffer([&value](osmium::memory::Buffer& nested) {
+                        value(nested);
+                    });
+                }};
+            }
+
+            void set_option(const osmium::io::tags_prefilter& value) {
+                m_prefilter = value;
+            }
+
+            void set_option(const osmium::io::timestamp_window& value) noexcept {
+                m_timestamp_window = value;
+            }
+
+            void set_option(const osmium::io::read_query& value) {
+                m_read_which_entities = value.entities();
+                m_prefilter = value.prefilter();
+                m_read_query = value;
+            }
+
+            void set_option(osmium::io::keep_raw_blobs value) noexcept {
+                m_raw_blobs = value;
+            }
+
+            void set_option(osmium::io::pool_for_pbf_parsing value) noexcept {
+                m_pbf_pool_parsing = value;
+            }
+
+            void set_option(osmium::io::verify_sorting value) noexcept {
+                m_verify_sorting = value;
+            }
+
+            void set_option(osmium::io::sort_tags value) noexcept {
+                m_sort_tags = value;
+            }
+
+            void set_option(const osmium::io::reader_buffer_size& value) noexcept {
+                m_buffer_size = value;
+            }
+
+            void set_option(const osmium::io::data_ready_callback& value) {
+                m_data_ready_callback = value;
+            }
+
+            static void set_option(const osmium::io::reader_queue_sizes& /*value*/) noexcept {
+                // Already used when the queues were created.
+            }
+
+            static void set_option(const osmium::io::max_memory_in_flight& /*value*/) noexcept {
+                // Already used when the read thread was created.
+            }
+
+            static void set_option(const osmium::io::io_executor& /*value*/) noexcept {
+                // Already used when the read thread was created.
+            }
+
+            static void set_option(const osmium::io::remote_input& /*value*/) noexcept {
+                // Already used when the file was opened.
+            }
+
+            static void set_option(const osmium::thread::thread_policy& /*value*/) noexcept {
+                // Already used when the threads were created.
+            }
+
             // This function will run in a separate thread.
             static void parser_thread(osmium::thread::Pool& pool,
                                       int fd,
@@ -165,7 +387,20 @@ namespace osmium {
                                       osmium::osm_entity_bits::type read_which_entities,
                                       osmium::io::read_meta read_metadata,
                                       osmium::io::buffers_type buffers_kind,
-                                      bool want_buffered_pages_removed) {
+                                      bool want_buffered_pages_removed,
+                                      const std::shared_ptr<detail::BufferRecycler>& buffer_recycler,
+                                      const osmium::io::decoded_buffer_callback& buffer_callback,
+                                      const osmium::io::tags_prefilter& prefilter,
+                                      const osmium::io::timestamp_window& time_window,
+                                      const osmium::io::read_query& query,
+                                      osmium::io::keep_raw_blobs raw_blobs,
+                                      osmium::io::pool_for_pbf_parsing pbf_pool_parsing,
+                                      osmium::io::verify_sorting sorting_check,
+                                      const osmium::io::reader_buffer_size& buffer_size,
+                                      const std::shared_ptr<detail::memory_account>& memory_account,
+                                      const std::function<void()>& data_ready,
+                                      const osmium::thread::thread_settings& thread_settings) {
+                thread_settings.apply();
                 std::promise<osmium::io::Header> promise{std::move(header_promise)};
                 osmium::io::detail::parser_arguments args = {
                     pool,
@@ -177,7 +412,18 @@ namespace osmium {
                     read_which_entities,
                     read_metadata,
                     buffers_kind,
-                    want_buffered_pages_removed};
+                    want_buffered_pages_removed,
+                    buffer_recycler,
+                    buffer_callback,
+                    prefilter,
+                    time_window,
+                    query,
+                    raw_blobs,
+                    pbf_pool_parsing,
+                    sorting_check,
+                    buffer_size,
+                    memory_account,
+                    data_ready};
                 creator(args)->parse();
             }
 
@@ -233,13 +479,19 @@ namespace osmium {
             /**
              * Open File for reading. Handles URLs or normal files. URLs
              * are opened by executing the "curl" program (which must be installed)
-             * and reading from its output.
+             * and reading from its output. If the remote_input option is
+             * set, http and https URLs are read with concurrent range
+             * requests instead.
              *
-             * @returns File descriptor of open file or pipe.
+             * @returns File descriptor of open file, pipe, or socket.
              * @throws std::system_error if a system call fails.
              */
-            static int open_input_file_or_url(const std::string& filename, int* childpid) {
+            static int open_input_file_or_url(const std::string& filename, int* childpid, const remote_input* remote, std::unique_ptr<detail::RemoteReader>* remote_reader) {
                 const std::string protocol{filename.substr(0, filename.find_first_of(':'))};
+                if (remote && (protocol == "http" || protocol == "https")) {
+                    remote_reader->reset(new detail::RemoteReader{filename, *remote});
+                    return (*remote_reader)->fd();
+                }
                 if (protocol == "http" || protocol == "https" || protocol == "ftp" || protocol == "file") {
 #ifndef _WIN32
                     return execute("curl", filename, childpid);
@@ -263,7 +515,8 @@ namespace osmium {
 
                 if (file.buffer()) {
                     decompressor = factory.create_decompressor(file.compression(), file.buffer(), file.buffer_size());
-                } else if (file.format() == file_format::pbf) {
+                } else if (file.format() == file_format::pbf ||
+                           (file.format() == file_format::buffer && file.compression() == file_compression::none)) {
                     decompressor = std::unique_ptr<Decompressor>{new DummyDecompressor{}};
                 } else {
                     decompressor = factory.create_decompressor(file.compression(), fd);
@@ -286,6 +539,12 @@ namespace osmium {
              *      relations, and/or changesets) should be read from the
              *      input file. It can speed the read up significantly if
              *      objects that are not needed anyway are not parsed.
+             *      If a PBF file claims to be sorted by type and ID (see
+             *      Header::sorted_by_type_then_id()), reading stops at
+             *      the first object of a type after all types which
+             *      should be read and, if the file is read through a
+             *      blob table, the blobs before the first type which
+             *      should be read are not read at all.
              *
              * * osmium::io::read_meta: Read meta data or not. The default is
              *      osmium::io::read_meta::yes which means that meta data
@@ -312,6 +571,96 @@ namespace osmium {
              *      For instance when your program will fork, using the
              *      statically initialized pool will not work.
              *
+             * * osmium::io::decoded_buffer_callback: Function called on
+             *      each buffer right after it was decoded. For PBF files
+             *      this happens in the thread pool workers, so the
+             *      function must be thread-safe. See the documentation
+             *      of decoded_buffer_callback for details.
+             *
+             * * osmium::io::tags_prefilter: Only read objects with tags
+             *      matching a filter. Currently only used for PBF files.
+             *      See the documentation of tags_prefilter for details.
+             *
+             * * osmium::io::timestamp_window: Only read the versions of
+             *      objects in a history file needed to reconstruct the
+             *      objects in a time window. Currently only used for PBF
+             *      files. See the documentation of timestamp_window for
+             *      details.
+             *
+             * * osmium::io::read_query: Entity types, tags filter,
+             *      bounding box for nodes, and ID sets in one object.
+             *      Replaces the osm_entity_bits and tags_prefilter options
+             *      set before it. See the documentation of read_query for
+             *      details.
+             *
+             * * osmium::io::keep_raw_blobs: Attach the original encoded
+             *      PBF blob to each buffer decoded from it (see
+             *      Buffer::raw_data()), so that it can be written out
+             *      again without encoding it with
+             *      Writer::write_unchanged(). Only done for PBF files and
+             *      only if all objects with all metadata are read, ie.
+             *      no entity type filter, read_meta, tags_prefilter,
+             *      timestamp_window, or read_query with box or IDs is
+             *      set. Default: no.
+             *
+             * * osmium::io::pool_for_pbf_parsing: Decode PBF data blocks
+             *      in the threads of the pool (yes) or in the parser
+             *      thread (no). Default: from_config, which uses the
+             *      OSMIUM_USE_POOL_THREADS_FOR_PBF_PARSING environment
+             *      variable.
+             *
+             * * osmium::io::verify_sorting: Check that the data is
+             *      sorted by type and ID if the header claims it is. The
+             *      objects in each buffer are checked in the thread that
+             *      decoded it, read() checks the buffer boundaries and
+             *      throws an osmium::out_of_order_error if the data is
+             *      not sorted. The header returned by header() then has
+             *      sorting_verified() set. Default: no.
+             *
+             * * osmium::io::sort_tags: Sort the tags of all objects by
+             *      key in the thread that decoded them and mark the tag
+             *      lists as sorted (see TagList::sort_by_key()). The
+             *      buffer callback sees the sorted tags. Default: no.
+             *
+             * * osmium::io::reader_queue_sizes: Maximum sizes of the
+             *      queues between the read thread, the parser, and
+             *      read(). Sizes of 0 (the default) mean the
+             *      OSMIUM_MAX_INPUT_QUEUE_SIZE and
+             *      OSMIUM_MAX_OSMDATA_QUEUE_SIZE environment variables
+             *      are used.
+             *
+             * * osmium::io::max_memory_in_flight: Limit the memory used
+             *      by data read but not yet returned from read(). Can
+             *      be shared between several Readers. Default: no
+             *      limit.
+             *
+             * * osmium::io::io_executor: Read the file in tasks on the
+             *      given pool instead of in a thread of its own. See
+             *      osmium::io::io_executor for details. Default: own
+             *      thread.
+             *
+             * * osmium::io::reader_buffer_size: Target size in bytes
+             *      and/or number of objects of the buffers created by
+             *      the XML, OPL, and o5m parsers and whether it should
+             *      be adapted for low latency or high throughput
+             *      depending on how fast the buffers are consumed.
+             *      Default: 1 MByte, fixed. Not used if parallel
+             *      parsing in the pool threads is enabled.
+             *
+             * * osmium::io::data_ready_callback: Function called whenever
+             *      try_read() might have something new to return. See
+             *      the documentation of data_ready_callback for details.
+             *
+             * * osmium::io::remote_input: Read http and https URLs with
+             *      concurrent range requests with read-ahead and retries
+             *      instead of a single curl process. See the
+             *      documentation of remote_input for details.
+             *
+             * * osmium::thread::thread_policy: CPU affinity and priority
+             *      of the read and parser threads. Default: from the
+             *      OSMIUM_THREAD_POLICY environment variable. This is not
+             *      passed on to the pool, give it to the pool directly.
+             *
              * @throws osmium::io_error If there was an error.
              * @throws std::system_error If the file could not be opened.
              */
@@ -319,12 +668,15 @@ namespace osmium {
             explicit Reader(const osmium::io::File& file, TArgs&&... args) :
                 m_file(file.check()),
                 m_creator(detail::ParserFactory::instance().get_creator_function(m_file)),
-                m_input_queue(detail::get_input_queue_size(), "raw_input"),
-                m_fd(m_file.buffer() ? -1 : open_input_file_or_url(m_file.filename(), &m_childpid)),
+                m_input_queue(detail::queue_size(detail::find_queue_sizes(args...).input, detail::get_input_queue_size()), "raw_input"),
+                m_fd(m_file.buffer() ? -1 : open_input_file_or_url(m_file.filename(), &m_childpid, detail::find_remote_input(args...), &m_remote_reader)),
                 m_file_size(m_fd > 2 ? osmium::file_size(m_fd) : 0),
                 m_decompressor(make_decompressor(m_file, m_fd, &m_offset)),
-                m_read_thread_manager(*m_decompressor, m_input_queue),
-                m_osmdata_queue(detail::get_osmdata_queue_size(), "parser_results"),
+                m_memory_account(std::make_shared<detail::memory_account>(detail::find_memory_limit(args...).budget())),
+                m_thread_policy(detail::find_thread_policy(args...)),
+                m_read_thread_manager(*m_decompressor, m_input_queue, &m_read_counter, m_memory_account.get(), detail::find_executor(args...).pool(),
+                                      m_thread_policy.settings(osmium::thread::thread_role::read)),
+                m_osmdata_queue(detail::queue_size(detail::find_queue_sizes(args...).osmdata, detail::get_osmdata_queue_size()), "parser_results"),
                 m_osmdata_queue_wrapper(m_osmdata_queue) {
 
                 (void)std::initializer_list<int>{(set_option(args), 0)...};
@@ -333,6 +685,37 @@ namespace osmium {
                     m_pool = &thread::Pool::default_instance();
                 }
 
+                if (m_sort_tags == osmium::io::sort_tags::yes) {
+                    const auto callback = m_buffer_callback;
+                    m_buffer_callback = osmium::io::decoded_buffer_callback{[callback](osmium::memory::Buffer& buffer) {
+                        buffer.for_each_buffer([](osmium::memory::Buffer& nested) {
+                            osmium::tags::sort_by_key(nested);
+                        });
+                        callback(buffer);
+                    }};
+                }
+
+                if (m_memory_account->is_limited()) {
+                    // Count decoded buffers as soon as they are created.
+                    // They are released again in read().
+                    const auto account = m_memory_account;
+                    const auto callback = m_buffer_callback;
+                    m_buffer_callback = osmium::io::decoded_buffer_callback{[account, callback](osmium::memory::Buffer& buffer) {
+                        callback(buffer);
+                        account->add(buffer.capacity());
+                    }};
+                }
+
+                // Used for try_read() and next_buffer(). Notifications
+                // come from the parser thread when it adds something to
+                // the queue and from the pool tasks decoding buffers.
+                m_ready_notifier = std::make_shared<detail::ready_notifier>(m_data_ready_callback);
+                const auto notifier = m_ready_notifier;
+                const std::function<void()> data_ready{[notifier]() {
+                    notifier->notify();
+                }};
+                m_osmdata_queue.set_notifications(data_ready, nullptr);
+
                 std::promise<osmium::io::Header> header_promise;
                 m_header_future = header_promise.get_future();
 
@@ -346,7 +729,10 @@ namespace osmium {
                                                           std::ref(m_input_queue), std::ref(m_osmdata_queue),
                                                           std::move(header_promise), &m_offset, m_read_which_entities,
                                                           m_read_metadata, m_buffers_kind,
-                                                          m_decompressor->want_buffered_pages_removed()};
+                                                          m_decompressor->want_buffered_pages_removed(),
+                                                          m_buffer_recycler, m_buffer_callback, m_prefilter, m_timestamp_window, m_read_query, m_raw_blobs,
+                                                          m_pbf_pool_parsing, m_verify_sorting, m_buffer_size, m_memory_account,
+                                                          data_ready, m_thread_policy.settings(osmium::thread::thread_role::parse)};
             }
 
             template <typename... TArgs>
@@ -394,6 +780,13 @@ namespace osmium {
                     // Ignore any exceptions.
                 }
 
+                m_memory_account->close();
+
+                if (m_remote_reader) {
+                    const std::unique_ptr<detail::RemoteReader> remote_reader{std::move(m_remote_reader)};
+                    remote_reader->close();
+                }
+
 #ifndef _WIN32
                 if (m_childpid) {
                     int status = 0;
@@ -421,9 +814,7 @@ namespace osmium {
                 }
 
                 try {
-                    if (m_header_future.valid()) {
-                        m_header = m_header_future.get();
-                    }
+                    fetch_header();
                 } catch (...) {
                     close();
                     m_status = status::error;
@@ -433,16 +824,42 @@ namespace osmium {
                 return m_header;
             }
 
-            /**
-             * Reads the next buffer from the input. An invalid buffer signals
-             * end-of-file. After end-of-file all read() calls will throw an
-             * osmium::io_error.
-             *
-             * @returns Buffer.
-             * @throws Some form of osmium::io_error if there is an error.
-             */
-            osmium::memory::Buffer read() {
-                osmium::memory::Buffer buffer;
+        private:
+
+            void fetch_header() {
+                if (m_header_future.valid()) {
+                    m_header = m_header_future.get();
+                    if (m_header.sorting_verified()) {
+                        m_check_buffer_boundaries = true;
+                        m_sort_order_verifier = detail::sort_order_verifier{m_header.has_multiple_object_versions()};
+                    }
+                }
+            }
+
+            // If the sorting is verified, check that the buffer continues
+            // where the last one ended. The order inside the buffer was
+            // already checked by the parser, except for buffers which
+            // were nested, those are checked completely here.
+            void check_sorting(const osmium::memory::Buffer& buffer, const bool nested) {
+                if (m_verify_sorting == osmium::io::verify_sorting::no) {
+                    return;
+                }
+                fetch_header();
+                if (!m_check_buffer_boundaries) {
+                    return;
+                }
+                if (nested) {
+                    m_sort_order_verifier.check(buffer);
+                } else {
+                    m_sort_order_verifier.check_boundary(buffer);
+                }
+            }
+
+            // Get the next buffer from the input. If wait is false, return
+            // false if there is no buffer ready yet instead of waiting for
+            // it.
+            bool get_next_buffer(osmium::memory::Buffer& buffer, const bool wait) {
+                buffer = osmium::memory::Buffer{};
 
                 // If there are buffers on the stack, return those first.
                 if (m_back_buffers) {
@@ -452,7 +869,16 @@ namespace osmium {
                         buffer = std::move(m_back_buffers);
                         m_back_buffers = osmium::memory::Buffer{};
                     }
-                    return buffer;
+                    try {
+                        check_sorting(buffer, true);
+                    } catch (...) {
+                        close();
+                        m_status = status::error;
+                        throw;
+                    }
+                    m_output_counter.add(buffer.committed());
+                    OSMIUM_TRACEPOINT1(reader_buffer, buffer.committed());
+                    return true;
                 }
 
                 if (m_status != status::okay) {
@@ -461,7 +887,7 @@ namespace osmium {
 
                 if (m_read_which_entities == osmium::osm_entity_bits::nothing) {
                     m_status = status::eof;
-                    return buffer;
+                    return true;
                 }
 
                 try {
@@ -470,18 +896,28 @@ namespace osmium {
                     // without data is not an error, it just means we have to
                     // keep getting the next buffer until there is one with data.
                     while (true) {
-                        buffer = m_osmdata_queue_wrapper.pop();
+                        if (wait) {
+                            buffer = m_osmdata_queue_wrapper.pop();
+                        } else if (!m_osmdata_queue_wrapper.try_pop_ready(buffer)) {
+                            return false;
+                        }
+                        m_memory_account->release(buffer.capacity());
                         if (detail::at_end_of_data(buffer)) {
                             m_status = status::eof;
                             m_read_thread_manager.close();
-                            return buffer;
+                            m_memory_account->close();
+                            return true;
                         }
-                        if (buffer.has_nested_buffers()) {
+                        const bool nested = buffer.has_nested_buffers();
+                        if (nested) {
                             m_back_buffers = std::move(buffer);
                             buffer = std::move(*m_back_buffers.get_last_nested());
                         }
                         if (buffer.committed() > 0) {
-                            return buffer;
+                            check_sorting(buffer, nested);
+                            m_output_counter.add(buffer.committed());
+                            OSMIUM_TRACEPOINT1(reader_buffer, buffer.committed());
+                            return true;
                         }
                     }
                 } catch (...) {
@@ -491,6 +927,164 @@ namespace osmium {
                 }
             }
 
+        public:
+
+            /**
+             * Reads the next buffer from the input. An invalid buffer signals
+             * end-of-file. After end-of-file all read() calls will throw an
+             * osmium::io_error.
+             *
+             * @returns Buffer.
+             * @throws Some form of osmium::io_error if there is an error.
+             */
+            osmium::memory::Buffer read() {
+                osmium::memory::Buffer buffer;
+                get_next_buffer(buffer, true);
+                return buffer;
+            }
+
+            /**
+             * Reads the next buffer from the input as an immutable buffer
+             * that can be shared by several consumers without copying.
+             * When the last reference to it goes away, its memory is used
+             * again for one of the next buffers (like with recycle()) if
+             * this Reader still exists. An invalid buffer signals
+             * end-of-file.
+             *
+             * @returns SharedBuffer.
+             * @throws Some form of osmium::io_error if there is an error.
+             */
+            osmium::memory::SharedBuffer read_shared() {
+                const std::weak_ptr<detail::BufferRecycler> recycler{m_buffer_recycler};
+                return osmium::memory::SharedBuffer{read(), [recycler](osmium::memory::Buffer&& buffer) {
+                    if (const auto r = recycler.lock()) {
+                        r->put(std::move(buffer));
+                    }
+                }};
+            }
+
+            /**
+             * Like read(), but doesn't block if the next buffer is not
+             * available yet. Use this together with the
+             * osmium::io::data_ready_callback option to find out when
+             * to call it again.
+             *
+             * @param buffer Set to the next buffer if there is one. An
+             *               invalid buffer signals end-of-file.
+             * @returns true if buffer was set, false if there is no data
+             *          available right now.
+             * @throws Some form of osmium::io_error if there is an error.
+             */
+            bool try_read(osmium::memory::Buffer& buffer) {
+                return get_next_buffer(buffer, false);
+            }
+
+#ifdef __cpp_lib_coroutine
+            /**
+             * The awaitable returned by next_buffer().
+             */
+            class buffer_awaitable {
+
+                Reader* m_reader;
+                std::function<void(std::coroutine_handle<>)> m_schedule;
+                osmium::memory::Buffer m_buffer{};
+                std::exception_ptr m_exception{};
+
+                // Returns false if there is nothing available yet.
+                bool try_get() {
+                    try {
+                        return m_reader->try_read(m_buffer);
+                    } catch (...) {
+                        m_exception = std::current_exception();
+                        return true;
+                    }
+                }
+
+            public:
+
+                buffer_awaitable(Reader& reader, std::function<void(std::coroutine_handle<>)> schedule) :
+                    m_reader(&reader),
+                    m_schedule(std::move(schedule)) {
+                }
+
+                bool await_ready() {
+                    return try_get();
+                }
+
+                bool await_suspend(std::coroutine_handle<> handle) {
+                    auto& notifier = *m_reader->m_ready_notifier;
+                    while (true) {
+                        const auto generation = notifier.generation();
+                        if (try_get()) {
+                            return false;
+                        }
+                        const bool waiting = notifier.wait([this, handle]() {
+                            if (!try_get()) {
+                                return false;
+                            }
+                            if (m_schedule) {
+                                m_schedule(handle);
+                            } else {
+                                handle.resume();
+                            }
+                            return true;
+                        }, generation);
+                        if (waiting) {
+                            return true;
+                        }
+                    }
+                }
+
+                osmium::memory::Buffer await_resume() {
+                    if (m_exception) {
+                        std::rethrow_exception(m_exception);
+                    }
+                    return std::move(m_buffer);
+                }
+
+            }; // class buffer_awaitable
+
+            /**
+             * Get the next buffer in a C++20 coroutine:
+             *
+             * @code
+             * while (osmium::memory::Buffer buffer = co_await reader.next_buffer()) {
+             *     ...
+             * }
+             * @endcode
+             *
+             * Works like read(), but instead of blocking the coroutine is
+             * suspended until the next buffer is available.
+             *
+             * Without the schedule argument, the coroutine is resumed
+             * directly in the thread where the data became ready, ie. the
+             * parser thread or a pool thread. It must then not block for
+             * long and must not close or destroy the Reader. Event-driven
+             * programs will usually give a schedule function instead which
+             * hands the coroutine handle to their event loop to resume it
+             * from there.
+             *
+             * Only one coroutine can wait for the next buffer of a Reader
+             * at a time. The Reader must not be destroyed while a coroutine
+             * is waiting for it.
+             */
+            buffer_awaitable next_buffer(std::function<void(std::coroutine_handle<>)> schedule = nullptr) {
+                return buffer_awaitable{*this, std::move(schedule)};
+            }
+#endif
+
+            /**
+             * Hand a buffer you don't need any more back to the reader. Its
+             * memory will be reused for one of the next buffers returned
+             * by read(), which saves allocating and first-touching new
+             * memory. The buffer must not be used after this. Calling this
+             * is optional, buffers not handed back are simply freed as
+             * usual.
+             */
+            void recycle(osmium::memory::Buffer&& buffer) {
+                m_buffer_recycler->put(std::move(buffer));
+            }
+
             /**
              * Has the end of file been reached? This is set after the last
              * data has been read. It is also set by calling close().
@@ -525,6 +1119,43 @@ namespace osmium {
                 return m_offset;
             }
 
+            /**
+             * Get statistics about the reader pipeline: how much data went
+             * through each stage, how much time was spent, and how full the
+             * queues between the stages are and how long threads had to
+             * wait on them. This can be called at any time while reading,
+             * but not from several threads at the same time.
+             */
+            reader_stats stats() const {
+                reader_stats result;
+                result.read = m_read_counter.stats();
+                if (result.read.items == 0) {
+                    // Some parsers read directly from the file descriptor
+                    // bypassing the read thread, they update the offset.
+                    result.read.bytes = m_offset;
+                }
+                result.input_queue = m_input_queue.stats();
+                result.osmdata_queue = m_osmdata_queue.stats();
+                result.output = m_output_counter.stats();
+                if (m_pool) {
+                    result.pool = m_pool->stats();
+                }
+                return result;
+            }
+
+            /**
+             * Approximate memory in bytes used by this reader for data
+             * in flight: the estimated size of the data in the queues
+             * between the threads plus the buffers kept for reuse. Memory
+             * used by the pool and the buffers already returned to the
+             * application is not included.
+             */
+            std::size_t used_memory() const {
+                return static_cast<std::size_t>(m_input_queue.stats().estimated_bytes() +
+                                                m_osmdata_queue.stats().estimated_bytes()) +
+                       m_buffer_recycler->used_memory();
+            }
+
         }; // class Reader
 
         /**
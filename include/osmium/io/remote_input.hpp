@@ -0,0 +1,522 @@
+#ifndef OSMIUM_IO_REMOTE_INPUT_HPP
+#define OSMIUM_IO_REMOTE_INPUT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <poll.h>
+# include <sys/socket.h>
+# include <sys/types.h>
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Function fetching a byte range of a remote file. It is called
+         * with the URL, the offset of the first byte, and the number of
+         * bytes wanted and must return the data. Returning fewer bytes
+         * than requested (or none at all) means the end of the file was
+         * reached. Errors are reported by throwing an exception, the
+         * request will then be retried. If the server does not support
+         * range requests, throw range_requests_not_supported instead,
+         * this is not retried.
+         *
+         * The function is called from several threads at the same time,
+         * so it must be thread-safe.
+         */
+        using range_fetcher = std::function<std::string(const std::string& url, std::size_t offset, std::size_t size)>;
+
+        /**
+         * Exception thrown by a range_fetcher if the server answered a
+         * range request with the whole file. Such files can not be read
+         * with remote_input, use the Reader without it.
+         */
+        struct range_requests_not_supported : public io_error {
+
+            explicit range_requests_not_supported(const std::string& url) :
+                io_error("server does not support range requests for '" + url + "', read it without remote_input") {
+            }
+
+        }; // struct range_requests_not_supported
+
+#ifndef _WIN32
+        namespace detail {
+
+            // Creating file descriptors and forking is done while holding
+            // this mutex, so that file descriptors are marked close-on-exec
+            // before a child process started in another thread could
+            // inherit them.
+            inline std::mutex& fork_mutex() {
+                static std::mutex mutex;
+                return mutex;
+            }
+
+            inline void set_close_on_exec(const int fd) {
+                if (::fcntl(fd, F_SETFD, FD_CLOEXEC) < 0) {
+                    throw std::system_error{errno, std::system_category(), "fcntl failed"};
+                }
+            }
+
+            /**
+             * Run a command and return its exit status (or -1 if it was
+             * killed) and everything it wrote to stdout.
+             *
+             * @throws std::system_error if a system call fails.
+             */
+            inline std::pair<int, std::string> run_command(const std::vector<std::string>& args) {
+                std::vector<char*> argv;
+                argv.reserve(args.size() + 1);
+                for (const auto& arg : args) {
+                    argv.push_back(const_cast<char*>(arg.c_str())); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+                }
+                argv.push_back(nullptr);
+
+                int pipefd[2];
+                pid_t pid = 0;
+                {
+                    const std::lock_guard<std::mutex> lock{fork_mutex()};
+                    if (::pipe(pipefd) < 0) {
+                        throw std::system_error{errno, std::system_category(), "opening pipe failed"};
+                    }
+                    set_close_on_exec(pipefd[0]);
+                    set_close_on_exec(pipefd[1]);
+                    pid = ::fork();
+                    if (pid < 0) {
+                        const int error = errno;
+                        ::close(pipefd[0]);
+                        ::close(pipefd[1]);
+                        throw std::system_error{error, std::system_category(), "fork failed"};
+                    }
+                    if (pid == 0) { // child
+                        if (::dup2(pipefd[1], 1) < 0) {
+                            ::_exit(1);
+                        }
+                        const int null_fd = ::open("/dev/null", O_RDWR); // NOLINT(hicpp-vararg, cppcoreguidelines-pro-type-vararg)
+                        if (null_fd >= 0) {
+                            ::dup2(null_fd, 0);
+                            ::dup2(null_fd, 2);
+                        }
+                        ::execvp(argv[0], argv.data());
+                        ::_exit(127);
+                    }
+                }
+
+                // parent
+                ::close(pipefd[1]);
+                std::string output;
+                try {
+                    char buffer[64 * 1024];
+                    while (true) {
+                        const auto nread = reliable_read(pipefd[0], buffer, sizeof(buffer));
+                        if (nread == 0) {
+                            break;
+                        }
+                        output.append(buffer, static_cast<std::size_t>(nread));
+                    }
+                } catch (...) {
+                    ::close(pipefd[0]);
+                    ::waitpid(pid, nullptr, 0);
+                    throw;
+                }
+                ::close(pipefd[0]);
+
+                int status = 0;
+                while (::waitpid(pid, &status, 0) < 0) {
+                    if (errno != EINTR) {
+                        throw std::system_error{errno, std::system_category(), "waitpid failed"};
+                    }
+                }
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+                const int exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : -1; // NOLINT(hicpp-signed-bitwise)
+#pragma GCC diagnostic pop
+
+                return {exit_status, std::move(output)};
+            }
+
+        } // namespace detail
+#endif
+
+        /**
+         * Get a range_fetcher running the "curl" program (which must be
+         * installed) for each request. The extra_args are added to the
+         * curl command line. Use them for authentication, additional
+         * headers, or signed requests to S3-compatible object storage,
+         * for instance:
+         *
+         * @code
+         * const auto fetcher = osmium::io::curl_range_fetcher({
+         *     "--aws-sigv4", "aws:amz:eu-central-1:s3",
+         *     "--user", access_key + ":" + secret_key});
+         * @endcode
+         *
+         * If the server does not support range requests, the fetcher
+         * throws range_requests_not_supported. Curl is told to stop the
+         * download if the server announces more data than requested.
+         * Not available on Windows.
+         */
+        inline range_fetcher curl_range_fetcher(const std::vector<std::string>& extra_args = {}) {
+            return [extra_args](const std::string& url, const std::size_t offset, const std::size_t size) -> std::string {
+#ifndef _WIN32
+                if (size == 0) {
+                    return std::string{};
+                }
+
+                // The HTTP status code is written after the data.
+                std::vector<std::string> args = {"curl", "-g", "-s", "-L",
+                                                 "-r", std::to_string(offset) + "-" + std::to_string(offset + size - 1),
+                                                 "--max-filesize", std::to_string(size),
+                                                 "-w", "%{http_code}"};
+                args.insert(args.end(), extra_args.begin(), extra_args.end());
+                args.emplace_back("--");
+                args.push_back(url);
+
+                auto result = detail::run_command(args);
+                if (result.first == 63) { // maximum file size exceeded
+                    throw range_requests_not_supported{url};
+                }
+                if (result.first != 0) {
+                    throw io_error{"curl returned error " + std::to_string(result.first) + " for '" + url + "'"};
+                }
+
+                std::string& data = result.second;
+                if (data.size() < 3) {
+                    throw io_error{"no HTTP status from curl for '" + url + "'"};
+                }
+                const std::string status = data.substr(data.size() - 3);
+                data.resize(data.size() - 3);
+
+                if (status == "206") {
+                    return std::move(data);
+                }
+                if (status == "200") { // range request ignored by server
+                    // Fine if the whole file fits into the first range.
+                    if (offset == 0 && data.size() <= size) {
+                        return std::move(data);
+                    }
+                    throw range_requests_not_supported{url};
+                }
+                if (status == "416") { // range not satisfiable: after end of file
+                    return std::string{};
+                }
+                throw io_error{"HTTP status " + status + " for '" + url + "'"};
+#else
+                (void)url;
+                (void)offset;
+                (void)size;
+                (void)extra_args;
+                throw io_error{"Reading OSM files from the network currently not supported on Windows."};
+#endif
+            };
+        }
+
+        /**
+         * Option for the osmium::io::Reader: Read http and https URLs
+         * with concurrent range requests instead of with a single curl
+         * process. The file is fetched in chunks, up to parallel_requests
+         * chunks are requested at the same time and handed to the parser
+         * in order as they become available. Failed requests are retried
+         * up to max_retries times with an increasing delay.
+         *
+         * By default requests are made with curl_range_fetcher(), set
+         * your own range_fetcher to use some other HTTP library or to
+         * sign requests to object storage.
+         *
+         * @code
+         * osmium::io::remote_input remote;
+         * remote.parallel_requests = 8;
+         * osmium::io::Reader reader{"https://example.com/planet.osm.pbf", remote};
+         * @endcode
+         *
+         * The memory needed for the read-ahead is about parallel_requests
+         * times chunk_size. Errors from the requests are reported when
+         * the Reader is closed. The server must support range requests,
+         * otherwise reading fails with range_requests_not_supported.
+         */
+        struct remote_input {
+
+            enum : std::size_t {
+                default_chunk_size = 8UL * 1024UL * 1024UL
+            };
+
+            range_fetcher fetcher;
+            std::size_t chunk_size = default_chunk_size;
+            std::size_t parallel_requests = 4;
+            unsigned int max_retries = 3;
+
+            explicit remote_input(range_fetcher fetcher_function = curl_range_fetcher()) :
+                fetcher(std::move(fetcher_function)) {
+            }
+
+        }; // struct remote_input
+
+        namespace detail {
+
+#ifndef _WIN32
+            /**
+             * Reads a remote file using concurrent range requests and
+             * writes the data in order into one end of a socket pair. The
+             * other end can be read like the pipe from a curl process, so
+             * the decompressors and parsers work unchanged.
+             */
+            class RemoteReader {
+
+                std::string m_url;
+                remote_input m_options;
+                int m_read_fd = -1;
+                int m_write_fd = -1;
+                std::atomic_bool m_stop{false};
+                std::exception_ptr m_exception{};
+                std::thread m_thread{};
+
+                std::string fetch(const std::size_t offset) const {
+                    for (unsigned int attempt = 0;; ++attempt) {
+                        try {
+                            std::string data = m_options.fetcher(m_url, offset, m_options.chunk_size);
+                            if (data.size() > m_options.chunk_size) {
+                                throw io_error{"range fetcher returned more data than requested for '" + m_url + "'"};
+                            }
+                            return data;
+                        } catch (const range_requests_not_supported&) {
+                            throw;
+                        } catch (...) {
+                            if (attempt >= m_options.max_retries || m_stop) {
+                                throw;
+                            }
+                        }
+                        std::this_thread::sleep_for(std::chrono::milliseconds{100U << std::min(attempt, 6U)});
+                    }
+                }
+
+                // Returns false if reading was stopped or the reading end
+                // of the socket was closed.
+                bool write_all(const std::string& data) {
+#ifdef MSG_NOSIGNAL
+                    constexpr const int flags = MSG_NOSIGNAL | MSG_DONTWAIT; // NOLINT(hicpp-signed-bitwise)
+#else
+                    constexpr const int flags = MSG_DONTWAIT;
+#endif
+                    std::size_t done = 0;
+                    while (done < data.size()) {
+                        // Wait with timeout so that stopping is noticed.
+                        pollfd pfd{m_write_fd, POLLOUT, 0};
+                        const int ready = ::poll(&pfd, 1, 100);
+                        if (m_stop) {
+                            return false;
+                        }
+                        if (ready < 0 && errno != EINTR) {
+                            throw std::system_error{errno, std::system_category(), "poll failed"};
+                        }
+                        if (ready <= 0) {
+                            continue;
+                        }
+                        const auto written = ::send(m_write_fd, data.data() + done, data.size() - done, flags);
+                        if (written < 0) {
+                            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+                                continue;
+                            }
+                            if (errno == EPIPE || errno == ECONNRESET) {
+                                return false;
+                            }
+                            throw std::system_error{errno, std::system_category(), "Write failed"};
+                        }
+                        done += static_cast<std::size_t>(written);
+                    }
+                    return true;
+                }
+
+                void run() {
+                    std::deque<std::future<std::string>> requests;
+                    std::size_t next_offset = 0;
+                    bool eof = false;
+
+                    try {
+                        while (!m_stop) {
+                            // The first chunk is fetched on its own, so
+                            // that a server not supporting range requests
+                            // is detected before more requests are made.
+                            const std::size_t max_requests = next_offset == 0 ? 1 : m_options.parallel_requests;
+                            while (!eof && requests.size() < max_requests) {
+                                const std::size_t offset = next_offset;
+                                requests.push_back(std::async(std::launch::async, [this, offset]() {
+                                    return fetch(offset);
+                                }));
+                                next_offset += m_options.chunk_size;
+                            }
+
+                            const std::string data = requests.front().get();
+                            requests.pop_front();
+                            // A short chunk is the last one, requests
+                            // after it will come back empty.
+                            eof = data.size() < m_options.chunk_size;
+                            if (!write_all(data) || eof) {
+                                break;
+                            }
+                        }
+                    } catch (...) {
+                        m_exception = std::current_exception();
+                    }
+
+                    m_stop = true;
+                    for (auto& request : requests) {
+                        if (request.valid()) {
+                            request.wait();
+                        }
+                    }
+
+                    // The reader will see the end of file now.
+                    ::close(m_write_fd);
+                    m_write_fd = -1;
+                }
+
+            public:
+
+                RemoteReader(std::string url, const remote_input& options) :
+                    m_url(std::move(url)),
+                    m_options(options) {
+                    if (!m_options.fetcher) {
+                        throw io_error{"remote_input needs a range fetcher"};
+                    }
+                    m_options.chunk_size = std::max<std::size_t>(m_options.chunk_size, 1);
+                    m_options.parallel_requests = std::max<std::size_t>(m_options.parallel_requests, 1);
+
+                    int fds[2];
+                    {
+                        const std::lock_guard<std::mutex> lock{fork_mutex()};
+                        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+                            throw std::system_error{errno, std::system_category(), "socketpair failed"};
+                        }
+                        set_close_on_exec(fds[0]);
+                        set_close_on_exec(fds[1]);
+                    }
+#if !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+                    const int on = 1;
+                    ::setsockopt(fds[1], SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+                    m_read_fd = fds[0];
+                    m_write_fd = fds[1];
+
+                    m_thread = std::thread{&RemoteReader::run, this};
+                }
+
+                RemoteReader(const RemoteReader&) = delete;
+                RemoteReader& operator=(const RemoteReader&) = delete;
+
+                RemoteReader(RemoteReader&&) = delete;
+                RemoteReader& operator=(RemoteReader&&) = delete;
+
+                ~RemoteReader() noexcept {
+                    try {
+                        close();
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                /**
+                 * The file descriptor to read the data from. It is owned
+                 * by the caller, who has to close it.
+                 */
+                int fd() const noexcept {
+                    return m_read_fd;
+                }
+
+                /**
+                 * Stop reading (if it isn't finished yet) and wait for
+                 * outstanding requests.
+                 *
+                 * @throws The exception from a failed request, if any.
+                 */
+                void close() {
+                    m_stop = true;
+                    if (m_thread.joinable()) {
+                        m_thread.join();
+                    }
+                    if (m_exception) {
+                        std::exception_ptr exception;
+                        std::swap(exception, m_exception);
+                        std::rethrow_exception(exception);
+                    }
+                }
+
+            }; // class RemoteReader
+#else
+            class RemoteReader {
+
+            public:
+
+                RemoteReader(const std::string& /*url*/, const remote_input& /*options*/) {
+                    throw io_error{"Reading OSM files from the network currently not supported on Windows."};
+                }
+
+                int fd() const noexcept {
+                    return -1;
+                }
+
+                void close() {
+                }
+
+            }; // class RemoteReader
+#endif
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_REMOTE_INPUT_HPP
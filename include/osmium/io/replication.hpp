@@ -0,0 +1,317 @@
+#ifndef OSMIUM_IO_REPLICATION_HPP
+#define OSMIUM_IO_REPLICATION_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/apply_changes.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/gzip_compression.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/compatibility.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when replication data can not be read or
+     * understood.
+     */
+    struct OSMIUM_EXPORT replication_error : public io_error {
+
+        explicit replication_error(const std::string& what) :
+            io_error(what) {
+        }
+
+        explicit replication_error(const char* what) :
+            io_error(what) {
+        }
+
+    }; // struct replication_error
+
+    namespace io {
+
+        /**
+         * The contents of a replication state file (state.txt) as written
+         * by Osmosis and others for OSM replication diffs.
+         */
+        struct ReplicationState {
+
+            uint64_t sequence_number = 0;
+            osmium::Timestamp timestamp{};
+
+            /**
+             * Parse the contents of a state file. It contains lines with
+             * "key=value", where colons in values are escaped with a
+             * backslash. Comment lines start with "#". Unknown keys are
+             * ignored.
+             *
+             * @throws replication_error if there is no valid sequence
+             *         number or the timestamp is invalid.
+             */
+            static ReplicationState parse(const std::string& data) {
+                ReplicationState state;
+                bool has_sequence_number = false;
+
+                std::size_t pos = 0;
+                while (pos < data.size()) {
+                    auto end = data.find('\n', pos);
+                    if (end == std::string::npos) {
+                        end = data.size();
+                    }
+                    std::string line{data, pos, end - pos};
+                    pos = end + 1;
+
+                    if (!line.empty() && line.back() == '\r') {
+                        line.pop_back();
+                    }
+                    if (line.empty() || line[0] == '#') {
+                        continue;
+                    }
+
+                    const auto eq = line.find('=');
+                    if (eq == std::string::npos) {
+                        continue;
+                    }
+                    const std::string key{line, 0, eq};
+                    std::string value;
+                    for (auto it = line.begin() + static_cast<std::ptrdiff_t>(eq) + 1; it != line.end(); ++it) {
+                        if (*it == '\\' && std::next(it) != line.end()) {
+                            ++it;
+                        }
+                        value += *it;
+                    }
+
+                    if (key == "sequenceNumber") {
+                        if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+                            throw replication_error{"invalid sequence number in replication state: '" + value + "'"};
+                        }
+                        state.sequence_number = std::stoull(value);
+                        has_sequence_number = true;
+                    } else if (key == "timestamp") {
+                        try {
+                            state.timestamp = osmium::Timestamp{value};
+                        } catch (const std::invalid_argument&) {
+                            throw replication_error{"invalid timestamp in replication state: '" + value + "'"};
+                        }
+                    }
+                }
+
+                if (!has_sequence_number) {
+                    throw replication_error{"no sequence number in replication state"};
+                }
+
+                return state;
+            }
+
+        }; // struct ReplicationState
+
+        /**
+         * The path of the files for a sequence number relative to the
+         * replication base URL without the suffix, for instance
+         * "001/234/567" for sequence number 1234567.
+         */
+        inline std::string replication_path(uint64_t sequence_number) {
+            if (sequence_number > 999999999ULL) {
+                throw replication_error{"sequence number too large: " + std::to_string(sequence_number)};
+            }
+            char path[12];
+            std::snprintf(path, sizeof(path), "%03u/%03u/%03u",
+                          static_cast<unsigned int>(sequence_number / 1000000U),
+                          static_cast<unsigned int>(sequence_number / 1000U % 1000U),
+                          static_cast<unsigned int>(sequence_number % 1000U));
+            return path;
+        }
+
+        /**
+         * Access to OSM replication diffs (like the minutely diffs from
+         * planet.openstreetmap.org) below a base URL. Libosmium doesn't
+         * do HTTP itself, the data is fetched by a function given to the
+         * constructor which gets the URL and returns the contents or
+         * throws an exception.
+         *
+         * @code
+         * osmium::io::ReplicationServer server{
+         *     "https://planet.openstreetmap.org/replication/minute",
+         *     [](const std::string& url) { return my_http_get(url); }};
+         * const auto state = server.state();
+         * const auto changes = server.read_changes(last_applied + 1, state.sequence_number);
+         * @endcode
+         */
+        class ReplicationServer {
+
+        public:
+
+            using fetch_function_type = std::function<std::string(const std::string&)>;
+
+        private:
+
+            std::string m_base_url;
+            fetch_function_type m_fetch;
+
+        public:
+
+            ReplicationServer(std::string base_url, fetch_function_type fetch) :
+                m_base_url(std::move(base_url)),
+                m_fetch(std::move(fetch)) {
+                while (!m_base_url.empty() && m_base_url.back() == '/') {
+                    m_base_url.pop_back();
+                }
+            }
+
+            const std::string& base_url() const noexcept {
+                return m_base_url;
+            }
+
+            /// The URL of the state file of the newest diff.
+            std::string state_url() const {
+                return m_base_url + "/state.txt";
+            }
+
+            /// The URL of the state file for the given sequence number.
+            std::string state_url(uint64_t sequence_number) const {
+                return m_base_url + "/" + replication_path(sequence_number) + ".state.txt";
+            }
+
+            /// The URL of the change file for the given sequence number.
+            std::string change_url(uint64_t sequence_number) const {
+                return m_base_url + "/" + replication_path(sequence_number) + ".osc.gz";
+            }
+
+            /// Get the state of the newest diff.
+            ReplicationState state() const {
+                return ReplicationState::parse(m_fetch(state_url()));
+            }
+
+            /// Get the state for the given sequence number.
+            ReplicationState state(uint64_t sequence_number) const {
+                return ReplicationState::parse(m_fetch(state_url(sequence_number)));
+            }
+
+            /**
+             * Fetch the change file with the given sequence number and
+             * parse it. All objects are returned in one buffer in the
+             * order they are in the file.
+             */
+            osmium::memory::Buffer read_change_file(uint64_t sequence_number) const {
+                const std::string data{m_fetch(change_url(sequence_number))};
+
+                osmium::io::Reader reader{osmium::io::File{data.data(), data.size(), "osc.gz"}};
+                osmium::memory::Buffer result{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+                while (const auto buffer = reader.read()) {
+                    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                        result.add_item(object);
+                        result.commit();
+                    }
+                }
+                reader.close();
+
+                return result;
+            }
+
+            /**
+             * Fetch and parse the change files with sequence numbers from
+             * first to last (inclusive) and merge them. Several files are
+             * fetched and parsed at the same time using the threads in the
+             * pool, so the fetch function must be thread safe.
+             *
+             * @returns Buffer with the newest version of all changed
+             *          objects sorted by type and ID.
+             * @throws Any exception thrown by the fetch function or while
+             *         parsing. All tasks are finished before.
+             */
+            osmium::memory::Buffer read_changes(uint64_t first, uint64_t last,
+                                                osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) const {
+                osmium::io::SortedChanges changes;
+
+                const auto max_tasks = static_cast<std::size_t>(pool.num_threads()) * 2;
+                std::deque<std::future<osmium::memory::Buffer>> futures;
+
+                try {
+                    for (uint64_t sequence_number = first; sequence_number <= last; ++sequence_number) {
+                        futures.push_back(pool.submit([this, sequence_number]() {
+                            return read_change_file(sequence_number);
+                        }));
+                        while (futures.size() >= max_tasks) {
+                            changes.add_buffer(futures.front().get());
+                            futures.pop_front();
+                        }
+                    }
+                    while (!futures.empty()) {
+                        changes.add_buffer(futures.front().get());
+                        futures.pop_front();
+                    }
+                } catch (...) {
+                    // The tasks still running reference this object, so
+                    // wait for them before leaving.
+                    for (auto& future : futures) {
+                        if (future.valid()) {
+                            future.wait();
+                        }
+                    }
+                    throw;
+                }
+
+                changes.sort();
+
+                osmium::memory::Buffer result{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+                for (const auto* object : changes) {
+                    result.add_item(*object);
+                    result.commit();
+                }
+                return result;
+            }
+
+        }; // class ReplicationServer
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_REPLICATION_HPP
@@ -0,0 +1,204 @@
+#ifndef OSMIUM_IO_TAGS_PREFILTER_HPP
+#define OSMIUM_IO_TAGS_PREFILTER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/util/string_pool.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            class tags_prefilter_impl_base {
+
+                // Keys seen so far with the result of key_can_match() for
+                // them, shared by all threads using this prefilter.
+                std::mutex m_mutex;
+                osmium::StringPool m_keys;
+                std::vector<bool> m_key_results;
+
+            public:
+
+                tags_prefilter_impl_base() = default;
+
+                tags_prefilter_impl_base(const tags_prefilter_impl_base&) = delete;
+                tags_prefilter_impl_base& operator=(const tags_prefilter_impl_base&) = delete;
+
+                tags_prefilter_impl_base(tags_prefilter_impl_base&&) = delete;
+                tags_prefilter_impl_base& operator=(tags_prefilter_impl_base&&) = delete;
+
+                virtual ~tags_prefilter_impl_base() noexcept = default;
+
+                virtual bool key_can_match(const char* key) const noexcept = 0;
+
+                virtual bool match(const char* key, const char* value) const noexcept = 0;
+
+                /**
+                 * Like key_can_match(), but the result is remembered, so
+                 * the filter is only asked once for each distinct key.
+                 * The key doesn't need to be null-terminated. This is
+                 * thread-safe.
+                 */
+                bool key_can_match_cached(const char* key, std::size_t length) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    const auto id = m_keys.add(key, length);
+                    if (id == m_key_results.size()) {
+                        m_key_results.push_back(key_can_match(m_keys.get(id)));
+                    }
+                    return m_key_results[id];
+                }
+
+            }; // class tags_prefilter_impl_base
+
+            template <typename TFilter>
+            class tags_prefilter_impl : public tags_prefilter_impl_base {
+
+                TFilter m_filter;
+
+            public:
+
+                explicit tags_prefilter_impl(const TFilter& filter) :
+                    m_filter(filter) {
+                }
+
+                bool key_can_match(const char* key) const noexcept override {
+                    return m_filter.key_can_match(key, true);
+                }
+
+                bool match(const char* key, const char* value) const noexcept override {
+                    return static_cast<bool>(m_filter(key, value));
+                }
+
+            }; // class tags_prefilter_impl
+
+        } // namespace detail
+
+        /**
+         * Option for the osmium::io::Reader: Only read objects with at
+         * least one tag matching a filter (usually an osmium::TagsFilter).
+         * Objects without any matching tag are dropped by the parser
+         * before they are built, so this is much faster than filtering
+         * in a handler if only a small part of the objects is needed.
+         *
+         * The PBF parser checks each distinct key only once (keys are
+         * interned in a StringPool shared by all threads) and then only
+         * looks at the values for tags with keys that can match. Other
+         * formats ignore this option.
+         *
+         * The filter only applies to the entity types given in the
+         * constructor, objects of other types are always read. Objects
+         * without tags are dropped if their type is filtered.
+         *
+         * The filter is copied, so it can't be changed afterwards. It
+         * must not be changed by matching, because it is used from
+         * several threads at the same time.
+         *
+         * Usage:
+         * @code
+         * osmium::TagsFilter filter{false};
+         * filter.add_rule(true, "amenity");
+         * osmium::io::Reader reader{file, osmium::io::tags_prefilter{filter}};
+         * @endcode
+         */
+        class tags_prefilter {
+
+            std::shared_ptr<detail::tags_prefilter_impl_base> m_impl;
+            osmium::osm_entity_bits::type m_entities = osmium::osm_entity_bits::nothing;
+
+        public:
+
+            /// Create a prefilter that doesn't filter anything.
+            tags_prefilter() = default;
+
+            /**
+             * Create a prefilter.
+             *
+             * @tparam TFilter Type of the filter. It needs a function call
+             *         operator taking a key and a value and a member
+             *         function key_can_match(key, result) like
+             *         osmium::TagsFilter.
+             * @param filter The filter. An object is read if the filter
+             *        returns true for any of its tags.
+             * @param entities The types of objects to filter.
+             */
+            template <typename TFilter>
+            explicit tags_prefilter(const TFilter& filter,
+                                    osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr) :
+                m_impl(std::make_shared<detail::tags_prefilter_impl<TFilter>>(filter)),
+                m_entities(entities) {
+            }
+
+            /// Does this prefilter filter anything?
+            explicit operator bool() const noexcept {
+                return m_impl && m_entities != osmium::osm_entity_bits::nothing;
+            }
+
+            /// The types of objects that are filtered.
+            osmium::osm_entity_bits::type entities() const noexcept {
+                return m_impl ? m_entities : osmium::osm_entity_bits::nothing;
+            }
+
+            /**
+             * Can a tag with this key match? If this returns false, the
+             * value doesn't need to be checked. The key doesn't need to
+             * be null-terminated. Must only be called if the prefilter
+             * is valid.
+             */
+            bool key_can_match(const char* key, std::size_t length) const {
+                return m_impl->key_can_match_cached(key, length);
+            }
+
+            /**
+             * Does the tag with this key and value match? Must only be
+             * called if the prefilter is valid.
+             */
+            bool operator()(const char* key, const char* value) const noexcept {
+                return m_impl->match(key, value);
+            }
+
+        }; // class tags_prefilter
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_TAGS_PREFILTER_HPP
@@ -0,0 +1,144 @@
+#ifndef OSMIUM_IO_TIMESTAMP_WINDOW_HPP
+#define OSMIUM_IO_TIMESTAMP_WINDOW_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/timestamp.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Option for the osmium::io::Reader: Only read the versions of
+         * objects in a history file which are needed to know the state
+         * of the data during the time window [from, to). These are all
+         * versions with a timestamp in the window plus, for each object,
+         * the last version before the window. All other versions are
+         * dropped by the parser before they are built, so analyses of a
+         * short time window over a full history file don't have to build
+         * most of the objects.
+         *
+         * Within the window osmium::DiffObject works as usual: the first
+         * version of each object is valid at the start of the window (if
+         * it is visible), and each version is valid until the next one.
+         * Because the versions after the window are not read, the last
+         * version of each object looks like it is still valid after the
+         * window.
+         *
+         * The versions of an object can be spread over two data blocks
+         * of a PBF file. In that case the last version in the first
+         * block that is before the window is always read, so there might
+         * be a few more versions than needed. Objects without timestamp
+         * are treated as being from before the window.
+         *
+         * Currently only the PBF parser supports this option, other
+         * formats ignore it.
+         *
+         * Usage:
+         * @code
+         * osmium::io::Reader reader{file, osmium::io::timestamp_window{
+         *     osmium::Timestamp{"2020-01-01T00:00:00Z"},
+         *     osmium::Timestamp{"2020-02-01T00:00:00Z"}}};
+         * @endcode
+         */
+        class timestamp_window {
+
+            int64_t m_from = 0;
+            int64_t m_to = 0;
+            bool m_active = false;
+
+        public:
+
+            /// Create a window that doesn't filter anything.
+            timestamp_window() = default;
+
+            /**
+             * Create a window.
+             *
+             * @param from Start of the window (inclusive).
+             * @param to End of the window (exclusive). Use
+             *           osmium::end_of_time() for an open window.
+             * @throws std::invalid_argument if to is before from.
+             */
+            timestamp_window(const osmium::Timestamp& from, const osmium::Timestamp& to) :
+                m_from(static_cast<int64_t>(from.seconds_since_epoch())),
+                m_to(static_cast<int64_t>(to.seconds_since_epoch())),
+                m_active(true) {
+                if (m_to < m_from) {
+                    throw std::invalid_argument{"end of timestamp window before its start"};
+                }
+            }
+
+            /// Does this window filter anything?
+            explicit operator bool() const noexcept {
+                return m_active;
+            }
+
+            osmium::Timestamp from() const noexcept {
+                return osmium::Timestamp{static_cast<uint32_t>(m_from)};
+            }
+
+            osmium::Timestamp to() const noexcept {
+                return osmium::Timestamp{static_cast<uint32_t>(m_to)};
+            }
+
+            /**
+             * Should the version of an object with the specified timestamp
+             * (in seconds since the epoch) be read? The next_is_before
+             * flag tells whether there is a later version of the same
+             * object which is also from before the window.
+             */
+            bool wants(int64_t timestamp, bool next_is_before) const noexcept {
+                if (timestamp >= m_to) {
+                    return false;
+                }
+                return timestamp >= m_from || !next_is_before;
+            }
+
+            /// Is a version with this timestamp from before the window?
+            bool is_before(int64_t timestamp) const noexcept {
+                return timestamp < m_from;
+            }
+
+        }; // class timestamp_window
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_TIMESTAMP_WINDOW_HPP
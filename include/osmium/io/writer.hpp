@@ -34,6 +34,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/multi_compressor.hpp>
 #include <osmium/io/detail/output_format.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/detail/read_write.hpp>
@@ -41,13 +42,18 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/io_executor.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/shared_buffer.hpp>
 #include <osmium/thread/pool.hpp>
+#include <osmium/thread/thread_policy.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
 #include <osmium/version.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <exception>
@@ -55,8 +61,10 @@ DEALINGS IN THE SOFTWARE.
 #include <future>
 #include <initializer_list>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -72,6 +80,17 @@ namespace osmium {
                 return osmium::config::get_max_queue_size("OUTPUT", 20);
             }
 
+            /**
+             * Will writing to these files result in exactly the same
+             * encoded data (before compression)?
+             */
+            inline bool same_encoding(const osmium::io::File& a, const osmium::io::File& b) {
+                return a.format() == b.format() &&
+                       a.has_multiple_object_versions() == b.has_multiple_object_versions() &&
+                       a.size() == b.size() &&
+                       std::equal(a.begin(), a.end(), b.begin());
+            }
+
         } // namespace detail
 
         /**
@@ -117,8 +136,16 @@ namespace osmium {
 
             std::future<std::size_t> m_write_future{};
 
+            osmium::thread::Pool* m_pool = nullptr;
+
+            detail::stage_counter m_input_counter;
+            detail::stage_counter m_write_counter;
+
             osmium::thread::thread_handler m_thread{};
 
+            // Used instead of m_thread if writing is done in tasks.
+            std::unique_ptr<detail::WriteTask> m_write_task{};
+
             // Checking the m_write_future is much more expensive then checking
             // one atomic bool, so we set this bool in the write_thread when
             // the writer should check the future...
@@ -137,11 +164,15 @@ namespace osmium {
             static void write_thread(detail::future_string_queue_type& output_queue,
                                      std::unique_ptr<osmium::io::Compressor>&& compressor,
                                      std::promise<std::size_t>&& write_promise,
-                                     std::atomic_bool* notification) {
+                                     std::atomic_bool* notification,
+                                     detail::stage_counter* counter,
+                                     const osmium::thread::thread_settings& thread_settings) {
+                thread_settings.apply();
                 detail::WriteThread write_thread{output_queue,
                                                  std::move(compressor),
                                                  std::move(write_promise),
-                                                 notification};
+                                                 notification,
+                                                 counter};
                 write_thread();
             }
 
@@ -160,6 +191,7 @@ namespace osmium {
                     write_header();
                 }
                 if (buffer && buffer.committed() > 0) {
+                    m_input_counter.add(buffer.committed());
                     m_output->write_buffer(std::move(buffer));
                 }
             }
@@ -177,6 +209,7 @@ namespace osmium {
                     using std::swap;
                     swap(m_buffer, buffer);
 
+                    m_input_counter.add(buffer.committed());
                     m_output->write_buffer(std::move(buffer));
                 }
             }
@@ -202,6 +235,8 @@ namespace osmium {
                 overwrite allow_overwrite = overwrite::no;
                 fsync sync = fsync::no;
                 osmium::thread::Pool* pool = nullptr;
+                osmium::thread::Pool* executor = nullptr;
+                const osmium::thread::thread_policy* thread_policy = nullptr;
             };
 
             static void set_option(options_type& options, osmium::thread::Pool& pool) {
@@ -220,6 +255,43 @@ namespace osmium {
                 options.sync = value;
             }
 
+            static void set_option(options_type& options, const osmium::io::io_executor& value) {
+                options.executor = value.pool();
+            }
+
+            static void set_option(options_type& options, const osmium::thread::thread_policy& value) {
+                options.thread_policy = &value;
+            }
+
+            static const osmium::io::File& check_files(const std::vector<osmium::io::File>& files) {
+                if (files.empty()) {
+                    throw std::invalid_argument{"Writer needs at least one file"};
+                }
+                for (const auto& file : files) {
+                    file.check();
+                    assert(!file.buffer()); // XXX can't handle pseudo-files
+                    if (!detail::same_encoding(files.front(), file)) {
+                        throw std::invalid_argument{"All files written by one Writer must have the same format and format options"};
+                    }
+                }
+                return files.front();
+            }
+
+            static std::unique_ptr<osmium::io::Compressor> create_compressor(const std::vector<osmium::io::File>& files, const options_type& options) {
+                std::vector<std::unique_ptr<osmium::io::Compressor>> compressors;
+                for (const auto& file : files) {
+                    compressors.push_back(CompressionFactory::instance().create_compressor(file.compression(),
+                                                                                           osmium::io::detail::open_for_writing(file.filename(), options.allow_overwrite),
+                                                                                           options.sync));
+                }
+
+                if (compressors.size() == 1) {
+                    return std::move(compressors.front());
+                }
+
+                return std::unique_ptr<osmium::io::Compressor>{new detail::MultiCompressor{std::move(compressors)}};
+            }
+
             void do_close() {
                 if (m_status == status::okay) {
                     ensure_cleanup([&]() {
@@ -234,10 +306,14 @@ namespace osmium {
         public:
 
             /**
-             * The constructor of the Writer object opens a file and writes the
-             * header to it.
+             * The constructor of the Writer object opens the files and writes
+             * the header to them.
              *
-             * @param file File (contains name and format info) to open.
+             * @param files Files (contains name and format info) to open.
+             *              The same data is written to all of them, so
+             *              they must have the same format and format
+             *              options, but they can have different
+             *              compression. The data is only encoded once.
              * @param args All further arguments are optional and can appear
              *             in any order:
              *
@@ -260,14 +336,21 @@ namespace osmium {
              *      For instance when your program will fork, using the
              *      statically initialized pool will not work.
              *
+             * * osmium::io::io_executor: Write the file in tasks on the
+             *      given pool instead of in a thread of its own. This
+             *      must be a different pool than the one above. See
+             *      osmium::io::io_executor for details.
+             *
+             * * osmium::thread::thread_policy: CPU affinity and priority
+             *      of the write thread. Default: from the
+             *      OSMIUM_THREAD_POLICY environment variable.
+             *
              * @throws osmium::io_error If there was an error.
              * @throws std::system_error If the file could not be opened.
              */
             template <typename... TArgs>
-            explicit Writer(const osmium::io::File& file, TArgs&&... args) :
-                m_file(file.check()) {
-                assert(!m_file.buffer()); // XXX can't handle pseudo-files
-
+            explicit Writer(const std::vector<osmium::io::File>& files, TArgs&&... args) :
+                m_file(check_files(files)) {
                 options_type options;
                 (void)std::initializer_list<int>{(set_option(options, args), 0)...};
 
@@ -275,18 +358,34 @@ namespace osmium {
                     options.pool = &thread::Pool::default_instance();
                 }
 
+                if (options.executor == options.pool) {
+                    throw std::invalid_argument{"The io_executor pool must be different from the pool used for encoding"};
+                }
+
                 m_header = options.header;
+                m_pool = options.pool;
 
                 m_output = osmium::io::detail::OutputFormatFactory::instance().create_output(*options.pool, m_file, m_output_queue);
 
-                std::unique_ptr<osmium::io::Compressor> compressor =
-                    CompressionFactory::instance().create_compressor(file.compression(),
-                                                                     osmium::io::detail::open_for_writing(m_file.filename(), options.allow_overwrite),
-                                                                     options.sync);
+                std::unique_ptr<osmium::io::Compressor> compressor = create_compressor(files, options);
 
                 std::promise<std::size_t> write_promise;
                 m_write_future = write_promise.get_future();
-                m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_output_queue), std::move(compressor), std::move(write_promise), &m_notification};
+                if (options.executor) {
+                    m_write_task.reset(new detail::WriteTask{m_output_queue, std::move(compressor), std::move(write_promise), &m_notification, &m_write_counter, *options.executor});
+                } else {
+                    const auto thread_settings = options.thread_policy ? options.thread_policy->settings(osmium::thread::thread_role::write)
+                                                                       : osmium::thread::thread_policy::from_config().settings(osmium::thread::thread_role::write);
+                    m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_output_queue), std::move(compressor), std::move(write_promise), &m_notification, &m_write_counter, thread_settings};
+                }
+            }
+
+            /**
+             * Open a single file for writing. See above for the arguments.
+             */
+            template <typename... TArgs>
+            explicit Writer(const osmium::io::File& file, TArgs&&... args) :
+                Writer(std::vector<osmium::io::File>{file}, std::forward<TArgs>(args)...) {
             }
 
             template <typename... TArgs>
@@ -366,6 +465,38 @@ namespace osmium {
                 });
             }
 
+            /**
+             * Write contents of a buffer that is shared with other users,
+             * for instance other Writers, to the output file. The buffer
+             * is not copied (except by some formats that don't encode in
+             * the thread pool), the Writer only keeps a reference to it
+             * until it is encoded. It must not be changed during that
+             * time.
+             *
+             * @param buffer Buffer that is being written out.
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void write_shared(const std::shared_ptr<const osmium::memory::Buffer>& buffer) {
+                ensure_cleanup([&]() {
+                    do_flush();
+                    if (buffer && *buffer && buffer->committed() > 0) {
+                        m_input_counter.add(buffer->committed());
+                        m_output->write_shared_buffer(buffer);
+                    }
+                });
+            }
+
+            /**
+             * Write contents of a SharedBuffer to the output file. See
+             * above for details.
+             *
+             * @param buffer Buffer that is being written out.
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void write_shared(const osmium::memory::SharedBuffer& buffer) {
+                write_shared(buffer.ptr());
+            }
+
             /**
              * Add item to the internal buffer for eventual writing to the
              * output file.
@@ -388,6 +519,61 @@ namespace osmium {
                 });
             }
 
+            /**
+             * Can this writer copy already encoded data blocks to the
+             * output using write_raw_blob()? This is only the case for
+             * the PBF format.
+             */
+            bool supports_raw_blobs() const noexcept {
+                return m_output->supports_raw_blobs();
+            }
+
+            /**
+             * Write an already encoded data block (for PBF a serialized
+             * Blob message containing an OSMData block, for instance one
+             * returned by IndexedPBFReader::raw_blob()) to the output
+             * file. The internal buffer is flushed first so that the order
+             * of the data is kept.
+             *
+             * @param blob The encoded data.
+             * @throws Some form of osmium::io_error when there is a problem
+             *         or if the output format doesn't support this.
+             */
+            void write_raw_blob(std::string&& blob) {
+                ensure_cleanup([&]() {
+                    do_flush();
+                    m_output->write_raw_blob(std::move(blob));
+                });
+            }
+
+            /**
+             * Write contents of a buffer to the output file, reusing the
+             * original encoded data if possible. If the buffer has the
+             * PBF blob it was decoded from attached (see
+             * osmium::io::keep_raw_blobs) and this writer writes PBF, the
+             * blob is copied to the output instead of encoding the
+             * objects again. Otherwise this is the same as calling
+             * operator()(Buffer&&).
+             *
+             * Only use this if the buffer wasn't changed after reading
+             * and the input and output files have the same options (for
+             * instance locations on ways or metadata), otherwise the
+             * output will not be what you expect.
+             *
+             * @param buffer Buffer that is being written out.
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void write_unchanged(osmium::memory::Buffer&& buffer) {
+                ensure_cleanup([&]() {
+                    do_flush();
+                    if (buffer.has_raw_data() && m_output->supports_raw_blobs()) {
+                        m_output->write_raw_blob(buffer.release_raw_data());
+                        return;
+                    }
+                    do_write(std::move(buffer));
+                });
+            }
+
             /**
              * Flushes internal buffer and closes output file. If you do not
              * call this, the destructor of Writer will also do the same
@@ -396,7 +582,8 @@ namespace osmium {
              * explicitly.
              *
              * @returns Number of bytes written to the file (or 0 if it can
-             *          not be determined).
+             *          not be determined). If there are several files
+             *          this is the sum over all of them.
              * @throws Some form of osmium::io_error when there is a problem.
              */
             std::size_t close() {
@@ -409,6 +596,34 @@ namespace osmium {
                 return 0;
             }
 
+            /**
+             * Get statistics about the writer pipeline: how much data went
+             * through each stage, how much time was spent, and how full the
+             * output queue is and how long threads had to wait on it. This
+             * can be called at any time, also after close(), but not from
+             * several threads at the same time.
+             */
+            writer_stats stats() const {
+                writer_stats result;
+                result.input = m_input_counter.stats();
+                result.output_queue = m_output_queue.stats();
+                result.write = m_write_counter.stats();
+                if (m_pool) {
+                    result.pool = m_pool->stats();
+                }
+                return result;
+            }
+
+            /**
+             * Approximate memory in bytes used by this writer: the buffer
+             * collecting the objects to write plus the estimated size of
+             * the data in the output queue.
+             */
+            std::size_t used_memory() const {
+                return m_buffer.capacity() +
+                       static_cast<std::size_t>(m_output_queue.stats().estimated_bytes());
+            }
+
         }; // class Writer
 
     } // namespace io
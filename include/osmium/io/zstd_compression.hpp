@@ -0,0 +1,642 @@
+#ifndef OSMIUM_IO_ZSTD_COMPRESSION_HPP
+#define OSMIUM_IO_ZSTD_COMPRESSION_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to read or write zstd-compressed OSM
+ * files.
+ *
+ * @attention If you include this file, you'll need to link with `libzstd`.
+ */
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/parallel_compressor.hpp>
+#include <osmium/io/detail/parallel_decompressor.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/util/config.hpp>
+#include <osmium/util/file.hpp>
+
+#include <zstd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when there are problems compressing or
+     * decompressing zstd files.
+     */
+    struct zstd_error : public io_error {
+
+        std::size_t zstd_error_code = 0;
+
+        explicit zstd_error(const std::string& what) :
+            io_error(what) {
+        }
+
+        zstd_error(const std::string& what, const std::size_t error_code) :
+            io_error(what + ": " + ::ZSTD_getErrorName(error_code)),
+            zstd_error_code(error_code) {
+        }
+
+    }; // struct zstd_error
+
+    namespace io {
+
+        namespace detail {
+
+            struct zstd_cstream_deleter {
+                void operator()(ZSTD_CCtx* ctx) const noexcept {
+                    ::ZSTD_freeCCtx(ctx);
+                }
+            };
+
+            struct zstd_dstream_deleter {
+                void operator()(ZSTD_DCtx* ctx) const noexcept {
+                    ::ZSTD_freeDCtx(ctx);
+                }
+            };
+
+            inline std::unique_ptr<ZSTD_CCtx, zstd_cstream_deleter> zstd_create_cstream() {
+                std::unique_ptr<ZSTD_CCtx, zstd_cstream_deleter> ctx{::ZSTD_createCCtx()};
+                if (!ctx) {
+                    throw osmium::zstd_error{"zstd error: compression init failed"};
+                }
+                const std::size_t result = ::ZSTD_CCtx_setParameter(ctx.get(), ZSTD_c_checksumFlag, 1);
+                if (::ZSTD_isError(result)) {
+                    throw osmium::zstd_error{"zstd error: compression init failed", result};
+                }
+                return ctx;
+            }
+
+            inline std::unique_ptr<ZSTD_DCtx, zstd_dstream_deleter> zstd_create_dstream() {
+                std::unique_ptr<ZSTD_DCtx, zstd_dstream_deleter> ctx{::ZSTD_createDCtx()};
+                if (!ctx) {
+                    throw osmium::zstd_error{"zstd error: decompression init failed"};
+                }
+                return ctx;
+            }
+
+            /**
+             * Decompress as much of the input as possible, appending the
+             * result to output. Returns the result of the last call to
+             * ZSTD_decompressStream(), which is 0 if the input ended at
+             * a frame boundary.
+             */
+            inline std::size_t zstd_decompress_append(ZSTD_DCtx* ctx, ZSTD_inBuffer& input, std::string& output) {
+                std::size_t result = 0;
+                std::size_t written = output.size();
+                bool output_full = false;
+                // If the output buffer was filled, there might be more
+                // data buffered in the context.
+                while (input.pos < input.size || output_full) {
+                    if (output.size() - written < ::ZSTD_DStreamOutSize()) {
+                        output.resize(written + std::max(::ZSTD_DStreamOutSize(), output.size()));
+                    }
+                    ZSTD_outBuffer out{&output[written], output.size() - written, 0};
+                    result = ::ZSTD_decompressStream(ctx, &out, &input);
+                    if (::ZSTD_isError(result)) {
+                        throw osmium::zstd_error{"zstd error: decompression failed", result};
+                    }
+                    written += out.pos;
+                    output_full = out.pos == out.size;
+                }
+                output.resize(written);
+                return result;
+            }
+
+            /**
+             * The seek table of the zstd seekable format as described in
+             * https://github.com/facebook/zstd/blob/dev/contrib/seekable_format/zstd_seekable_compression_format.md
+             *
+             * It is written as a skippable frame at the end of the file
+             * and contains the compressed and uncompressed size of each
+             * frame, so that readers can find the frame containing any
+             * uncompressed offset without decompressing the file. Normal
+             * zstd decompressors ignore it.
+             */
+            class zstd_seek_table {
+
+                std::vector<std::pair<uint32_t, uint32_t>> m_entries{};
+
+                static void append_uint32(std::string& out, const uint32_t value) {
+                    out += static_cast<char>(value & 0xffU);
+                    out += static_cast<char>((value >> 8U) & 0xffU);
+                    out += static_cast<char>((value >> 16U) & 0xffU);
+                    out += static_cast<char>((value >> 24U) & 0xffU);
+                }
+
+                static uint32_t get_uint32(const char* data) noexcept {
+                    const auto* d = reinterpret_cast<const unsigned char*>(data);
+                    return static_cast<uint32_t>(d[0]) |
+                           (static_cast<uint32_t>(d[1]) << 8U) |
+                           (static_cast<uint32_t>(d[2]) << 16U) |
+                           (static_cast<uint32_t>(d[3]) << 24U);
+                }
+
+            public:
+
+                enum : uint32_t {
+                    skippable_magic = 0x184D2A5EUL,
+                    seekable_magic = 0x8F92EAB1UL,
+                    footer_size = 9
+                };
+
+                enum : std::size_t {
+                    // Frames are limited to 32 bit sizes in the seek table.
+                    max_frame_size = 0xffffffffUL
+                };
+
+                /// Add a frame to the table.
+                void add_frame(const std::size_t compressed_size, const std::size_t uncompressed_size) {
+                    if (compressed_size > max_frame_size || uncompressed_size > max_frame_size) {
+                        throw osmium::zstd_error{"zstd error: frame too large for seek table"};
+                    }
+                    m_entries.emplace_back(static_cast<uint32_t>(compressed_size), static_cast<uint32_t>(uncompressed_size));
+                }
+
+                /// The number of frames.
+                std::size_t size() const noexcept {
+                    return m_entries.size();
+                }
+
+                /// The compressed and uncompressed size of frame n.
+                const std::pair<uint32_t, uint32_t>& operator[](const std::size_t n) const noexcept {
+                    return m_entries[n];
+                }
+
+                /**
+                 * Find the frame containing the given offset into the
+                 * uncompressed data. Returns the number of the frame, the
+                 * offset of the frame in the compressed file and the
+                 * offset of the frame in the uncompressed data. If the
+                 * offset is beyond the end of the data the number of the
+                 * frame is size().
+                 */
+                std::tuple<std::size_t, std::size_t, std::size_t> find(const std::size_t uncompressed_offset) const noexcept {
+                    std::size_t compressed = 0;
+                    std::size_t uncompressed = 0;
+                    std::size_t n = 0;
+                    for (; n < m_entries.size(); ++n) {
+                        if (uncompressed_offset < uncompressed + m_entries[n].second) {
+                            break;
+                        }
+                        compressed += m_entries[n].first;
+                        uncompressed += m_entries[n].second;
+                    }
+                    return std::make_tuple(n, compressed, uncompressed);
+                }
+
+                /// Serialize the table into a skippable frame.
+                std::string serialize() const {
+                    std::string out;
+                    out.reserve(8 + m_entries.size() * 8 + footer_size);
+                    append_uint32(out, skippable_magic);
+                    append_uint32(out, static_cast<uint32_t>(m_entries.size() * 8 + footer_size));
+                    for (const auto& entry : m_entries) {
+                        append_uint32(out, entry.first);
+                        append_uint32(out, entry.second);
+                    }
+                    append_uint32(out, static_cast<uint32_t>(m_entries.size()));
+                    out += '\0'; // descriptor: no checksums
+                    append_uint32(out, seekable_magic);
+                    return out;
+                }
+
+                /**
+                 * Read the seek table from the end of a complete zstd
+                 * file. Throws zstd_error if there is no valid seek table.
+                 */
+                static zstd_seek_table read(const char* data, const std::size_t size) {
+                    if (size < 8 + footer_size || get_uint32(data + size - 4) != seekable_magic) {
+                        throw osmium::zstd_error{"zstd error: no seek table found"};
+                    }
+                    const char* footer = data + size - footer_size;
+                    if ((static_cast<unsigned char>(footer[4]) & 0x7cU) != 0) {
+                        throw osmium::zstd_error{"zstd error: invalid seek table descriptor"};
+                    }
+                    const std::size_t entry_size = (static_cast<unsigned char>(footer[4]) & 0x80U) ? 12 : 8;
+                    const std::size_t num_frames = get_uint32(footer);
+                    const std::size_t table_size = num_frames * entry_size + footer_size;
+                    if (table_size + 8 > size) {
+                        throw osmium::zstd_error{"zstd error: invalid seek table size"};
+                    }
+                    const char* table = data + size - table_size;
+                    if (get_uint32(table - 8) != skippable_magic || get_uint32(table - 4) != table_size) {
+                        throw osmium::zstd_error{"zstd error: invalid seek table header"};
+                    }
+
+                    zstd_seek_table result;
+                    result.m_entries.reserve(num_frames);
+                    for (std::size_t n = 0; n < num_frames; ++n) {
+                        result.m_entries.emplace_back(get_uint32(table + n * entry_size), get_uint32(table + n * entry_size + 4));
+                    }
+                    return result;
+                }
+
+            }; // class zstd_seek_table
+
+        } // namespace detail
+
+        /**
+         * Compressor writing zstd files in the seekable format: The data
+         * is split into independent frames of frame_size bytes each and a
+         * seek table is written at the end. Use the ParallelCompressor
+         * with the zstd_compress_format to compress the frames using
+         * several threads.
+         */
+        class ZstdCompressor final : public Compressor {
+
+            std::unique_ptr<ZSTD_CCtx, detail::zstd_cstream_deleter> m_ctx;
+            detail::zstd_seek_table m_seek_table{};
+            std::string m_buffer{};
+            std::size_t m_frame_input_size = 0;
+            std::size_t m_frame_output_size = 0;
+            std::size_t m_file_size = 0;
+            int m_fd;
+
+            void compress(const char* data, const std::size_t size, const ZSTD_EndDirective mode) {
+                ZSTD_inBuffer input{data, size, 0};
+                std::size_t remaining = 0;
+                do {
+                    ZSTD_outBuffer output{&m_buffer[0], m_buffer.size(), 0};
+                    remaining = ::ZSTD_compressStream2(m_ctx.get(), &output, &input, mode);
+                    if (::ZSTD_isError(remaining)) {
+                        throw osmium::zstd_error{"zstd error: compression failed", remaining};
+                    }
+                    osmium::io::detail::reliable_write(m_fd, m_buffer.data(), output.pos);
+                    m_frame_output_size += output.pos;
+                } while (input.pos < input.size || (mode == ZSTD_e_end && remaining != 0));
+                m_frame_input_size += size;
+            }
+
+            void end_frame() {
+                if (m_frame_input_size == 0) {
+                    return;
+                }
+                compress(nullptr, 0, ZSTD_e_end);
+                m_seek_table.add_frame(m_frame_output_size, m_frame_input_size);
+                m_file_size += m_frame_output_size;
+                m_frame_input_size = 0;
+                m_frame_output_size = 0;
+            }
+
+        public:
+
+            enum {
+                frame_size = 1024UL * 1024UL
+            };
+
+            explicit ZstdCompressor(const int fd, const fsync sync) :
+                Compressor(sync),
+                m_ctx(detail::zstd_create_cstream()),
+                m_buffer(::ZSTD_CStreamOutSize(), '\0'),
+                m_fd(fd) {
+            }
+
+            ZstdCompressor(const ZstdCompressor&) = delete;
+            ZstdCompressor& operator=(const ZstdCompressor&) = delete;
+
+            ZstdCompressor(ZstdCompressor&&) = delete;
+            ZstdCompressor& operator=(ZstdCompressor&&) = delete;
+
+            ~ZstdCompressor() noexcept override {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            void write(const std::string& data) override {
+                assert(m_fd >= 0);
+                std::size_t offset = 0;
+                while (offset < data.size()) {
+                    const std::size_t size = std::min(data.size() - offset, frame_size - m_frame_input_size);
+                    compress(data.data() + offset, size, ZSTD_e_continue);
+                    offset += size;
+                    if (m_frame_input_size == frame_size) {
+                        end_frame();
+                    }
+                }
+            }
+
+            void close() override {
+                if (m_fd < 0) {
+                    return;
+                }
+
+                const int fd = m_fd;
+                try {
+                    end_frame();
+                    const std::string table{m_seek_table.serialize()};
+                    osmium::io::detail::reliable_write(fd, table.data(), table.size());
+                    m_file_size += table.size();
+                } catch (...) {
+                    m_fd = -1;
+                    if (fd != 1) {
+                        osmium::io::detail::reliable_close(fd);
+                    }
+                    throw;
+                }
+                m_fd = -1;
+
+                // Do not sync or close stdout
+                if (fd == 1) {
+                    return;
+                }
+
+                if (do_fsync()) {
+                    osmium::io::detail::reliable_fsync(fd);
+                }
+                osmium::io::detail::reliable_close(fd);
+            }
+
+            std::size_t file_size() const override {
+                return m_file_size;
+            }
+
+        }; // class ZstdCompressor
+
+        class ZstdDecompressor final : public Decompressor {
+
+            std::unique_ptr<ZSTD_DCtx, detail::zstd_dstream_deleter> m_ctx;
+            std::string m_input{};
+            ZSTD_inBuffer m_in_buffer{nullptr, 0, 0};
+            std::size_t m_offset = 0;
+            std::size_t m_last_result = 0;
+            int m_fd;
+
+        public:
+
+            explicit ZstdDecompressor(const int fd) :
+                m_fd(fd) {
+                try {
+                    m_ctx = detail::zstd_create_dstream();
+                } catch (...) {
+                    osmium::io::detail::reliable_close(fd);
+                    throw;
+                }
+            }
+
+            ZstdDecompressor(const ZstdDecompressor&) = delete;
+            ZstdDecompressor& operator=(const ZstdDecompressor&) = delete;
+
+            ZstdDecompressor(ZstdDecompressor&&) = delete;
+            ZstdDecompressor& operator=(ZstdDecompressor&&) = delete;
+
+            ~ZstdDecompressor() noexcept override {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            std::string read() override {
+                std::string output;
+                while (output.empty()) {
+                    if (m_in_buffer.pos == m_in_buffer.size) {
+                        if (m_offset > 0 && want_buffered_pages_removed()) {
+                            osmium::io::detail::remove_buffered_pages(m_fd, m_offset);
+                        }
+                        m_input.resize(osmium::io::Decompressor::input_buffer_size);
+                        const auto nread = osmium::io::detail::reliable_read(m_fd, &m_input[0], static_cast<unsigned int>(m_input.size()));
+                        if (nread == 0) {
+                            if (m_last_result != 0) {
+                                throw osmium::zstd_error{"zstd error: unexpected end of file"};
+                            }
+                            break;
+                        }
+                        m_input.resize(static_cast<std::size_t>(nread));
+                        m_in_buffer = ZSTD_inBuffer{m_input.data(), m_input.size(), 0};
+                        m_offset += static_cast<std::size_t>(nread);
+                        set_offset(m_offset);
+                    }
+                    m_last_result = detail::zstd_decompress_append(m_ctx.get(), m_in_buffer, output);
+                }
+                return output;
+            }
+
+            void close() override {
+                if (m_fd >= 0) {
+                    if (want_buffered_pages_removed()) {
+                        osmium::io::detail::remove_buffered_pages(m_fd);
+                    }
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    osmium::io::detail::reliable_close(fd);
+                }
+            }
+
+        }; // class ZstdDecompressor
+
+        class ZstdBufferDecompressor final : public Decompressor {
+
+            std::unique_ptr<ZSTD_DCtx, detail::zstd_dstream_deleter> m_ctx;
+            ZSTD_inBuffer m_in_buffer;
+
+        public:
+
+            ZstdBufferDecompressor(const char* buffer, const std::size_t size) :
+                m_ctx(detail::zstd_create_dstream()),
+                m_in_buffer{buffer, size, 0} {
+            }
+
+            ZstdBufferDecompressor(const ZstdBufferDecompressor&) = delete;
+            ZstdBufferDecompressor& operator=(const ZstdBufferDecompressor&) = delete;
+
+            ZstdBufferDecompressor(ZstdBufferDecompressor&&) = delete;
+            ZstdBufferDecompressor& operator=(ZstdBufferDecompressor&&) = delete;
+
+            ~ZstdBufferDecompressor() noexcept override = default;
+
+            std::string read() override {
+                std::string output;
+                if (m_in_buffer.pos < m_in_buffer.size) {
+                    // Decompress at most one input buffer worth of
+                    // compressed data per call.
+                    ZSTD_inBuffer input{m_in_buffer.src,
+                                        std::min(m_in_buffer.size, m_in_buffer.pos + ::ZSTD_DStreamInSize()),
+                                        m_in_buffer.pos};
+                    const std::size_t result = detail::zstd_decompress_append(m_ctx.get(), input, output);
+                    m_in_buffer.pos = input.pos;
+                    if (m_in_buffer.pos == m_in_buffer.size && result != 0) {
+                        throw osmium::zstd_error{"zstd error: unexpected end of data"};
+                    }
+                }
+                return output;
+            }
+
+            void close() override {
+            }
+
+        }; // class ZstdBufferDecompressor
+
+        namespace detail {
+
+            /**
+             * Splitting and decompressing of zstd files with several
+             * frames for the ParallelDecompressor. The frame boundaries
+             * are found from the block headers inside the frames, so
+             * this works for all multi-frame files, with or without a
+             * seek table.
+             */
+            struct zstd_format {
+
+                enum {
+                    target_chunk_size = 1024UL * 1024UL
+                };
+
+                static bool is_suitable(const char* data, const std::size_t size) noexcept {
+                    const std::size_t frame_size = ::ZSTD_findFrameCompressedSize(data, size);
+                    return !::ZSTD_isError(frame_size) && frame_size < size;
+                }
+
+                static std::size_t next_chunk_size(const char* data, const std::size_t size) noexcept {
+                    std::size_t chunk_size = 0;
+                    while (chunk_size < target_chunk_size && chunk_size < size) {
+                        const std::size_t frame_size = ::ZSTD_findFrameCompressedSize(data + chunk_size, size - chunk_size);
+                        if (::ZSTD_isError(frame_size)) {
+                            // Broken or truncated frame. Put all the rest
+                            // into this chunk, decompression will report
+                            // the error.
+                            return size;
+                        }
+                        chunk_size += frame_size;
+                    }
+                    return chunk_size;
+                }
+
+                static decompressed_chunk decompress_chunk(const char* data, const std::size_t size) {
+                    static thread_local std::unique_ptr<ZSTD_DCtx, zstd_dstream_deleter> ctx{zstd_create_dstream()};
+
+                    const std::size_t result = ::ZSTD_DCtx_reset(ctx.get(), ZSTD_reset_session_only);
+                    if (::ZSTD_isError(result)) {
+                        throw osmium::zstd_error{"zstd error: decompression init failed", result};
+                    }
+
+                    decompressed_chunk chunk;
+                    chunk.data.reserve(size * 4);
+                    ZSTD_inBuffer input{data, size, 0};
+                    if (zstd_decompress_append(ctx.get(), input, chunk.data) != 0) {
+                        throw osmium::zstd_error{"zstd error: unexpected end of file"};
+                    }
+                    return chunk;
+                }
+
+            }; // struct zstd_format
+
+            /**
+             * Compression of chunks into independent zstd frames for the
+             * ParallelCompressor. A seek table is written at the end, so
+             * the result is in the zstd seekable format, the same as
+             * written by the ZstdCompressor.
+             */
+            struct zstd_compress_format {
+
+                enum {
+                    target_chunk_size = ZstdCompressor::frame_size
+                };
+
+                zstd_seek_table seek_table{};
+
+                static std::string compress_chunk(const char* data, const std::size_t size) {
+                    static thread_local std::unique_ptr<ZSTD_CCtx, zstd_cstream_deleter> ctx{zstd_create_cstream()};
+
+                    std::string output(::ZSTD_compressBound(size), '\0');
+                    const std::size_t result = ::ZSTD_compress2(ctx.get(), &output[0], output.size(), data, size);
+                    if (::ZSTD_isError(result)) {
+                        throw osmium::zstd_error{"zstd error: compression failed", result};
+                    }
+                    output.resize(result);
+                    return output;
+                }
+
+                void chunk_written(const std::size_t input_size, const std::size_t output_size) {
+                    seek_table.add_frame(output_size, input_size);
+                }
+
+                std::string end_marker() const {
+                    return seek_table.serialize();
+                }
+
+            }; // struct zstd_compress_format
+
+            // we want the register_compression() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_zstd_compression = osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::zstd,
+                [](const int fd, const fsync sync) -> osmium::io::Compressor* {
+                    if (osmium::config::use_parallel_compression()) {
+                        return new ParallelCompressor<zstd_compress_format>{fd, sync, osmium::thread::Pool::default_instance()};
+                    }
+                    return new osmium::io::ZstdCompressor{fd, sync};
+                },
+                [](const int fd) -> osmium::io::Decompressor* {
+                    if (osmium::config::use_parallel_decompression()) {
+                        auto* decompressor = make_parallel_decompressor<zstd_format>(fd);
+                        if (decompressor) {
+                            return decompressor;
+                        }
+                    }
+                    return new osmium::io::ZstdDecompressor{fd};
+                },
+                [](const char* buffer, const std::size_t size) { return new osmium::io::ZstdBufferDecompressor{buffer, size}; }
+            );
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_zstd_compression() noexcept {
+                return registered_zstd_compression;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_ZSTD_COMPRESSION_HPP
@@ -33,8 +33,10 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/memory/item.hpp>
 #include <osmium/memory/item_iterator.hpp>
+#include <osmium/memory/item_type_index.hpp>
 #include <osmium/osm/entity.hpp>
 #include <osmium/util/compatibility.hpp>
 
@@ -46,6 +48,7 @@ DEALINGS IN THE SOFTWARE.
 #include <iterator>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <utility>
 
 namespace osmium {
@@ -86,7 +89,9 @@ namespace osmium {
          * external memory management. It is your job then to free the memory once
          * the buffer isn't used any more. If you don't have memory already, you can
          * create a Buffer object and have it manage the memory internally. It will
-         * dynamically allocate memory and free it again after use.
+         * dynamically allocate memory and free it again after use. Internally
+         * managed memory can come from a BufferPool (see there), in that case
+         * it is handed back to the pool when it isn't used any more.
          */
         class Buffer {
 
@@ -104,7 +109,9 @@ namespace osmium {
         private:
 
             std::unique_ptr<Buffer> m_next_buffer;
-            std::unique_ptr<unsigned char[]> m_memory{};
+            std::unique_ptr<std::string> m_raw_data;
+            std::unique_ptr<ItemTypeIndex> m_type_index;
+            detail::buffer_memory m_memory{};
             unsigned char* m_data = nullptr;
             std::size_t m_capacity = 0;
             std::size_t m_written = 0;
@@ -126,6 +133,30 @@ namespace osmium {
                 return padded_length(capacity);
             }
 
+            // Memory is taken from the pool the current memory came from or
+            // from the default pool if there is none.
+            detail::buffer_memory allocate_memory(std::size_t size) {
+                BufferPool* pool = m_memory.get_deleter().pool;
+                return detail::allocate_buffer_memory(size, pool ? pool : BufferPool::default_pool());
+            }
+
+            explicit Buffer(detail::buffer_memory data, std::size_t capacity, std::size_t committed) :
+                m_memory(std::move(data)),
+                m_data(m_memory.get()),
+                m_capacity(capacity),
+                m_written(committed),
+                m_committed(committed) {
+                if (capacity % align_bytes != 0) {
+                    throw std::invalid_argument{"buffer capacity needs to be multiple of alignment"};
+                }
+                if (committed % align_bytes != 0) {
+                    throw std::invalid_argument{"buffer parameter 'committed' needs to be multiple of alignment"};
+                }
+                if (committed > capacity) {
+                    throw std::invalid_argument{"buffer parameter 'committed' can not be larger than capacity"};
+                }
+            }
+
             void grow_internal() {
                 assert(m_data && "This must be a valid buffer");
                 if (!m_memory) {
@@ -133,7 +164,7 @@ namespace osmium {
                 }
 
                 std::unique_ptr<Buffer> old{new Buffer{std::move(m_memory), m_capacity, m_committed}};
-                m_memory = std::unique_ptr<unsigned char[]>{new unsigned char[m_capacity]};
+                m_memory = old->allocate_memory(m_capacity);
                 m_data = m_memory.get();
 
                 m_written -= m_committed;
@@ -218,20 +249,7 @@ namespace osmium {
              *         than capacity.
              */
             explicit Buffer(std::unique_ptr<unsigned char[]> data, std::size_t capacity, std::size_t committed) :
-                m_memory(std::move(data)),
-                m_data(m_memory.get()),
-                m_capacity(capacity),
-                m_written(committed),
-                m_committed(committed) {
-                if (capacity % align_bytes != 0) {
-                    throw std::invalid_argument{"buffer capacity needs to be multiple of alignment"};
-                }
-                if (committed % align_bytes != 0) {
-                    throw std::invalid_argument{"buffer parameter 'committed' needs to be multiple of alignment"};
-                }
-                if (committed > capacity) {
-                    throw std::invalid_argument{"buffer parameter 'committed' can not be larger than capacity"};
-                }
+                Buffer(detail::buffer_memory{data.release()}, capacity, committed) {
             }
 
             /**
@@ -239,7 +257,8 @@ namespace osmium {
              * given capacity.
              * Will internally get dynamic memory of the required size.
              * The dynamic memory will be automatically freed when the Buffer
-             * is destroyed.
+             * is destroyed. If the default buffer pool is enabled (see
+             * BufferPool::default_pool()), the memory comes from there.
              *
              * @param capacity The (initial) size of the memory for this buffer.
              *        Actual capacity might be larger tue to alignment.
@@ -247,7 +266,26 @@ namespace osmium {
              *        becomes to small?
              */
             explicit Buffer(std::size_t capacity, auto_grow auto_grow = auto_grow::yes) :
-                m_memory(new unsigned char[calculate_capacity(capacity)]),
+                m_memory(detail::allocate_buffer_memory(calculate_capacity(capacity), BufferPool::default_pool())),
+                m_data(m_memory.get()),
+                m_capacity(calculate_capacity(capacity)),
+                m_auto_grow(auto_grow) {
+            }
+
+            /**
+             * Constructs a valid internally memory-managed buffer with the
+             * given capacity getting its memory from the specified pool.
+             * The memory will be handed back to the pool when the Buffer
+             * is destroyed or grows. The pool must outlive the Buffer.
+             *
+             * @param capacity The (initial) size of the memory for this buffer.
+             *        Actual capacity might be larger tue to alignment.
+             * @param auto_grow Should this buffer automatically grow when it
+             *        becomes to small?
+             * @param pool The pool to get the memory from.
+             */
+            Buffer(std::size_t capacity, auto_grow auto_grow, BufferPool& pool) :
+                m_memory(pool.allocate(calculate_capacity(capacity))),
                 m_data(m_memory.get()),
                 m_capacity(calculate_capacity(capacity)),
                 m_auto_grow(auto_grow) {
@@ -260,6 +298,8 @@ namespace osmium {
             // buffers can be moved
             Buffer(Buffer&& other) noexcept :
                 m_next_buffer(std::move(other.m_next_buffer)),
+                m_raw_data(std::move(other.m_raw_data)),
+                m_type_index(std::move(other.m_type_index)),
                 m_memory(std::move(other.m_memory)),
                 m_data(other.m_data),
                 m_capacity(other.m_capacity),
@@ -280,6 +320,8 @@ namespace osmium {
 
             Buffer& operator=(Buffer&& other) noexcept {
                 m_next_buffer = std::move(other.m_next_buffer);
+                m_raw_data = std::move(other.m_raw_data);
+                m_type_index = std::move(other.m_type_index);
                 m_memory = std::move(other.m_memory);
                 m_data = other.m_data;
                 m_capacity = other.m_capacity;
@@ -334,6 +376,13 @@ namespace osmium {
                 return m_capacity;
             }
 
+            /**
+             * Returns the auto_grow setting of this buffer.
+             */
+            auto_grow get_auto_grow() const noexcept {
+                return m_auto_grow;
+            }
+
             /**
              * Returns the number of bytes already filled in this buffer.
              * Always returns 0 on invalid buffers.
@@ -384,7 +433,7 @@ namespace osmium {
                 }
                 size = calculate_capacity(size);
                 if (m_capacity < size) {
-                    std::unique_ptr<unsigned char[]> memory{new unsigned char[size]};
+                    detail::buffer_memory memory{allocate_memory(size)};
                     std::copy_n(m_memory.get(), m_capacity, memory.get());
                     using std::swap;
                     swap(m_memory, memory);
@@ -418,6 +467,19 @@ namespace osmium {
                 return std::move(buffer->m_next_buffer);
             }
 
+            /**
+             * Call func with each nested buffer, starting with the most
+             * deeply nested one which holds the oldest data, and then
+             * with this buffer.
+             */
+            template <typename TFunc>
+            void for_each_buffer(TFunc&& func) {
+                if (m_next_buffer) {
+                    m_next_buffer->for_each_buffer(func);
+                }
+                func(*this);
+            }
+
             /**
              * Mark currently written bytes in the buffer as committed.
              *
@@ -466,9 +528,110 @@ namespace osmium {
                 const std::size_t num_used_bytes = m_committed;
                 m_written = 0;
                 m_committed = 0;
+                m_raw_data.reset();
+                m_type_index.reset();
                 return num_used_bytes;
             }
 
+            /**
+             * Attach the encoded data this buffer was decoded from. This
+             * is used by the Reader to hand out the original PBF blob
+             * together with the objects decoded from it (see
+             * osmium::io::keep_raw_blobs). Any previously attached data is
+             * replaced. The data is removed by clear(), but not if the
+             * buffer is changed in any other way, it is up to the user
+             * to not use it after that.
+             */
+            void set_raw_data(std::string&& data) {
+                m_raw_data.reset(new std::string{std::move(data)});
+            }
+
+            /// Is there encoded data attached to this buffer?
+            bool has_raw_data() const noexcept {
+                return m_raw_data != nullptr;
+            }
+
+            /**
+             * Get the encoded data attached to this buffer.
+             *
+             * @pre has_raw_data()
+             */
+            const std::string& raw_data() const noexcept {
+                assert(has_raw_data());
+                return *m_raw_data;
+            }
+
+            /**
+             * Move the encoded data out of this buffer. Afterwards
+             * has_raw_data() will return false.
+             *
+             * @pre has_raw_data()
+             */
+            std::string release_raw_data() {
+                assert(has_raw_data());
+                std::string data{std::move(*m_raw_data)};
+                m_raw_data.reset();
+                return data;
+            }
+
+            /**
+             * Build an index of the types of all committed items in this
+             * buffer and attach it to the buffer (see ItemTypeIndex).
+             * Typed iteration (select(), begin<T>()), count() and
+             * osmium::apply() use it to skip over items of other types.
+             * Any previously attached index is replaced.
+             *
+             * The index is only used as long as the number of committed
+             * bytes in the buffer doesn't change, so committing more
+             * items or purging removed items makes it stale. It is removed
+             * by clear().
+             *
+             * @pre The buffer must be valid.
+             */
+            void build_type_index() {
+                assert(m_data && "This must be a valid buffer");
+                std::unique_ptr<ItemTypeIndex> index{new ItemTypeIndex{}};
+                std::size_t offset = 0;
+                while (offset != m_committed) {
+                    const auto* item = reinterpret_cast<const Item*>(m_data + offset);
+                    const std::size_t next = offset + item->padded_size();
+                    index->add(item->type(), offset, next);
+                    offset = next;
+                }
+                m_type_index = std::move(index);
+            }
+
+            /// Is there an up-to-date type index attached to this buffer?
+            bool has_type_index() const noexcept {
+                return m_type_index && m_type_index->size() == m_committed;
+            }
+
+            /**
+             * Get the type index attached to this buffer.
+             *
+             * @pre has_type_index()
+             */
+            const ItemTypeIndex& type_index() const noexcept {
+                assert(has_type_index());
+                return *m_type_index;
+            }
+
+            /**
+             * Get the number of items of type T in the buffer. This is
+             * fast if there is a type index, otherwise all items have to
+             * be looked at.
+             *
+             * @pre The buffer must be valid.
+             */
+            template <typename T>
+            std::size_t count() const {
+                assert(m_data && "This must be a valid buffer");
+                if (has_type_index()) {
+                    return m_type_index->count<T>();
+                }
+                return static_cast<std::size_t>(std::distance(cbegin<T>(), cend<T>()));
+            }
+
             /**
              * Get the data in the buffer at the given offset.
              *
@@ -620,14 +783,31 @@ namespace osmium {
              */
             using const_iterator = t_const_iterator<osmium::OSMEntity>;
 
+        private:
+
+            // Offsets of the part of the buffer containing all items of
+            // type T, this is the whole buffer if there is no type index.
+            template <typename T>
+            std::pair<std::size_t, std::size_t> span_of() const noexcept {
+                if (!has_type_index()) {
+                    return std::make_pair(std::size_t{0}, m_committed);
+                }
+                const auto range = m_type_index->span<T>();
+                return std::make_pair(range.begin, range.end);
+            }
+
+        public:
+
             template <typename T>
             ItemIteratorRange<T> select() {
-                return ItemIteratorRange<T>{m_data, m_data + m_committed};
+                const auto span = span_of<T>();
+                return ItemIteratorRange<T>{m_data + span.first, m_data + span.second};
             }
 
             template <typename T>
             ItemIteratorRange<const T> select() const {
-                return ItemIteratorRange<const T>{m_data, m_data + m_committed};
+                const auto span = span_of<T>();
+                return ItemIteratorRange<const T>{m_data + span.first, m_data + span.second};
             }
 
             /**
@@ -641,7 +821,7 @@ namespace osmium {
             template <typename T>
             t_iterator<T> begin() {
                 assert(m_data && "This must be a valid buffer");
-                return t_iterator<T>(m_data, m_data + m_committed);
+                return t_iterator<T>(m_data + span_of<T>().first, m_data + m_committed);
             }
 
             /**
@@ -718,7 +898,7 @@ namespace osmium {
             template <typename T>
             t_const_iterator<T> cbegin() const {
                 assert(m_data && "This must be a valid buffer");
-                return {m_data, m_data + m_committed};
+                return {m_data + span_of<T>().first, m_data + m_committed};
             }
 
             const_iterator cbegin() const {
@@ -779,6 +959,8 @@ namespace osmium {
                 using std::swap;
 
                 swap(m_next_buffer, other.m_next_buffer);
+                swap(m_raw_data, other.m_raw_data);
+                swap(m_type_index, other.m_type_index);
                 swap(m_memory, other.m_memory);
                 swap(m_data, other.m_data);
                 swap(m_capacity, other.m_capacity);
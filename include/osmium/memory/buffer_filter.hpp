@@ -0,0 +1,289 @@
+#ifndef OSMIUM_MEMORY_BUFFER_FILTER_HPP
+#define OSMIUM_MEMORY_BUFFER_FILTER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <future>
+#include <vector>
+
+namespace osmium {
+
+    namespace memory {
+
+        namespace detail {
+
+            /// A run of consecutive items in a buffer.
+            struct item_run {
+                std::size_t offset;
+                std::size_t length;
+            };
+
+            // Items are never split across chunks, so a chunk is at least
+            // this size unless the buffer is smaller.
+            enum : std::size_t {
+                min_filter_chunk_size = 1024UL * 1024UL
+            };
+
+            /**
+             * Find all runs of consecutive items in the range [begin, end)
+             * of the data which are not removed and for which the
+             * predicate returns true.
+             */
+            template <typename TPredicate>
+            std::vector<item_run> find_kept_runs(const unsigned char* data, std::size_t begin, std::size_t end, const TPredicate& predicate) {
+                std::vector<item_run> runs;
+                std::size_t pos = begin;
+                while (pos < end) {
+                    const auto& item = *reinterpret_cast<const osmium::memory::Item*>(data + pos);
+                    const auto size = item.padded_size();
+                    if (!item.removed() && predicate(item)) {
+                        if (!runs.empty() && runs.back().offset + runs.back().length == pos) {
+                            runs.back().length += size;
+                        } else {
+                            runs.push_back(item_run{pos, size});
+                        }
+                    }
+                    pos += size;
+                }
+                return runs;
+            }
+
+            inline void copy_runs(const unsigned char* source, unsigned char* target, const std::vector<item_run>& runs) noexcept {
+                for (const auto& run : runs) {
+                    std::memcpy(target, source + run.offset, run.length);
+                    target += run.length;
+                }
+            }
+
+            /**
+             * Split the committed data in the buffer into (at most)
+             * num_chunks chunks of roughly the same size at item
+             * boundaries. Returns the offsets of the chunk boundaries
+             * including 0 and the end of the data.
+             */
+            inline std::vector<std::size_t> chunk_boundaries(const Buffer& buffer, std::size_t num_chunks) {
+                std::vector<std::size_t> boundaries;
+                boundaries.push_back(0);
+
+                const std::size_t chunk_size = buffer.committed() / num_chunks;
+                std::size_t pos = 0;
+                while (pos < buffer.committed()) {
+                    pos += reinterpret_cast<const osmium::memory::Item*>(buffer.data() + pos)->padded_size();
+                    if (pos - boundaries.back() >= chunk_size && pos < buffer.committed()) {
+                        boundaries.push_back(pos);
+                    }
+                }
+                boundaries.push_back(buffer.committed());
+
+                return boundaries;
+            }
+
+            struct no_range_callback {
+
+                void moving_range_in_buffer(std::size_t /*old_offset*/, std::size_t /*new_offset*/, std::size_t /*length*/) const noexcept {
+                }
+
+            }; // struct no_range_callback
+
+            template <typename TPredicate>
+            std::vector<std::vector<item_run>> find_kept_runs_in_pool(const Buffer& buffer, const TPredicate& predicate, osmium::thread::Pool& pool) {
+                std::vector<std::vector<item_run>> runs;
+
+                const std::size_t num_chunks = std::min(static_cast<std::size_t>(pool.num_threads()),
+                                                        buffer.committed() / min_filter_chunk_size);
+                if (num_chunks <= 1) {
+                    runs.push_back(find_kept_runs(buffer.data(), 0, buffer.committed(), predicate));
+                    return runs;
+                }
+
+                const auto boundaries = chunk_boundaries(buffer, num_chunks);
+                std::vector<std::future<std::vector<item_run>>> futures;
+                for (std::size_t n = 0; n + 1 < boundaries.size(); ++n) {
+                    const auto begin = boundaries[n];
+                    const auto end = boundaries[n + 1];
+                    futures.push_back(pool.submit([&buffer, &predicate, begin, end]() {
+                        return find_kept_runs(buffer.data(), begin, end, predicate);
+                    }));
+                }
+                for (auto& future : futures) {
+                    runs.push_back(future.get());
+                }
+
+                return runs;
+            }
+
+            inline void copy_runs_in_pool(const Buffer& buffer, unsigned char* target, const std::vector<std::vector<item_run>>& runs, const std::vector<std::size_t>& target_offsets, osmium::thread::Pool& pool) {
+                std::vector<std::future<void>> futures;
+                for (std::size_t n = 0; n < runs.size(); ++n) {
+                    const auto& chunk_runs = runs[n];
+                    unsigned char* chunk_target = target + target_offsets[n];
+                    futures.push_back(pool.submit([&buffer, &chunk_runs, chunk_target]() {
+                        copy_runs(buffer.data(), chunk_target, chunk_runs);
+                    }));
+                }
+                for (auto& future : futures) {
+                    future.get();
+                }
+            }
+
+            template <typename TPredicate, typename TCallbackClass>
+            Buffer filter(const Buffer& buffer, const TPredicate& predicate, TCallbackClass* callback, osmium::thread::Pool* pool) {
+                assert(buffer && "This must be a valid buffer");
+                assert(callback);
+
+                std::vector<std::vector<item_run>> runs;
+                if (pool) {
+                    runs = find_kept_runs_in_pool(buffer, predicate, *pool);
+                } else {
+                    runs.push_back(find_kept_runs(buffer.data(), 0, buffer.committed(), predicate));
+                }
+
+                // Calculate where the data from each chunk will end up.
+                std::vector<std::size_t> target_offsets;
+                std::size_t size = 0;
+                for (const auto& chunk_runs : runs) {
+                    target_offsets.push_back(size);
+                    for (const auto& run : chunk_runs) {
+                        size += run.length;
+                    }
+                }
+
+                Buffer result{size, Buffer::auto_grow::yes};
+                unsigned char* target = result.reserve_space(size);
+                if (pool && runs.size() > 1) {
+                    copy_runs_in_pool(buffer, target, runs, target_offsets, *pool);
+                } else {
+                    copy_runs(buffer.data(), target, runs.front());
+                }
+                result.commit();
+
+                std::size_t new_offset = 0;
+                for (const auto& chunk_runs : runs) {
+                    for (const auto& run : chunk_runs) {
+                        callback->moving_range_in_buffer(run.offset, new_offset, run.length);
+                        new_offset += run.length;
+                    }
+                }
+
+                return result;
+            }
+
+        } // namespace detail
+
+        /**
+         * Create a new buffer containing copies of all items in the given
+         * buffer which are not marked as removed and for which the
+         * predicate returns true. Unlike Buffer::purge_removed() the data
+         * is copied in bulk, one memcpy for each run of consecutive kept
+         * items.
+         *
+         * The predicate is called as `bool predicate(const Item&)`.
+         *
+         * @param buffer The source buffer. It is not changed.
+         * @param predicate Decides which items to keep.
+         * @returns New buffer with the kept items.
+         *
+         * @pre The buffer must be valid.
+         */
+        template <typename TPredicate>
+        Buffer filter(const Buffer& buffer, const TPredicate& predicate) {
+            detail::no_range_callback callback;
+            return detail::filter(buffer, predicate, &callback, nullptr);
+        }
+
+        /**
+         * Create a new buffer containing copies of all items in the given
+         * buffer which are not marked as removed and for which the
+         * predicate returns true. Large buffers are split into chunks at
+         * item boundaries which are handled in parallel in the thread
+         * pool, so the predicate must be safe to call from several
+         * threads at once.
+         *
+         * @param buffer The source buffer. It is not changed.
+         * @param predicate Decides which items to keep.
+         * @param pool The thread pool to use.
+         * @returns New buffer with the kept items.
+         *
+         * @pre The buffer must be valid.
+         */
+        template <typename TPredicate>
+        Buffer filter(const Buffer& buffer, const TPredicate& predicate, osmium::thread::Pool& pool) {
+            detail::no_range_callback callback;
+            return detail::filter(buffer, predicate, &callback, &pool);
+        }
+
+        /**
+         * Create a new buffer containing copies of all items in the given
+         * buffer which are not marked as removed and for which the
+         * predicate returns true.
+         *
+         * The function `moving_range_in_buffer` is called on the given
+         * callback object once for each run of consecutive kept items
+         * with the offset of the run in the old buffer, its offset in the
+         * new buffer, and its length in bytes. All items in the run have
+         * moved by the same amount. The calls are made in order from the
+         * calling thread after the new buffer has been filled. This can
+         * be used to update any indexes.
+         *
+         * If a pool is given, large buffers are handled in parallel, see
+         * above.
+         *
+         * @param buffer The source buffer. It is not changed.
+         * @param predicate Decides which items to keep.
+         * @param callback Callback object.
+         * @param pool The thread pool to use or nullptr to work in the
+         *             calling thread only.
+         * @returns New buffer with the kept items.
+         *
+         * @pre The buffer must be valid.
+         * @pre @code callback != nullptr @endcode
+         */
+        template <typename TPredicate, typename TCallbackClass>
+        Buffer filter(const Buffer& buffer, const TPredicate& predicate, TCallbackClass* callback, osmium::thread::Pool* pool = nullptr) {
+            return detail::filter(buffer, predicate, callback, pool);
+        }
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUFFER_FILTER_HPP
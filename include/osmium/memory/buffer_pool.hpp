@@ -0,0 +1,384 @@
+#ifndef OSMIUM_MEMORY_BUFFER_POOL_HPP
+#define OSMIUM_MEMORY_BUFFER_POOL_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/config.hpp>
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifndef _WIN32
+# include <sys/mman.h>
+#endif
+
+namespace osmium {
+
+    namespace memory {
+
+        class BufferPool;
+
+        namespace detail {
+
+            /**
+             * Deleter for the memory of a Buffer. Memory with a slab size
+             * of 0 was allocated with new[], everything else is a slab
+             * that goes back to the pool it came from.
+             */
+            struct buffer_memory_deleter {
+
+                BufferPool* pool = nullptr;
+                std::size_t slab_size = 0;
+
+                buffer_memory_deleter() noexcept = default;
+
+                buffer_memory_deleter(BufferPool* p, std::size_t size) noexcept :
+                    pool(p),
+                    slab_size(size) {
+                }
+
+                void operator()(unsigned char* data) const noexcept;
+
+            }; // struct buffer_memory_deleter
+
+            using buffer_memory = std::unique_ptr<unsigned char[], buffer_memory_deleter>;
+
+        } // namespace detail
+
+        /**
+         * A pool of memory slabs for Buffers. Buffers getting their memory
+         * from a pool hand it back when they are destroyed or grown, so
+         * that the next buffer of a similar size can use it without going
+         * through malloc and without page faults.
+         *
+         * Requested sizes are rounded up to a size class, there are four
+         * classes between consecutive powers of two, so at most 25% of a
+         * slab are wasted. Sizes smaller than min_slab_size or larger than
+         * max_slab_size are not handled by the pool.
+         *
+         * Each thread keeps a few free slabs in a thread-local cache, only
+         * if that doesn't have a slab of the right size the shared free
+         * lists protected by a mutex are used. On Linux slabs can be backed
+         * by transparent huge pages.
+         *
+         * Buffers using a pool must be destroyed before the pool. The pool
+         * returned by default_pool() lives until the end of the program.
+         */
+        class BufferPool {
+
+            struct thread_cache_entry {
+                const BufferPool* pool = nullptr;
+                std::size_t slab_size = 0;
+                unsigned char* data = nullptr;
+
+                thread_cache_entry() noexcept = default;
+
+                thread_cache_entry(const BufferPool* p, std::size_t size, unsigned char* d) noexcept :
+                    pool(p),
+                    slab_size(size),
+                    data(d) {
+                }
+            };
+
+            struct thread_cache {
+
+                std::array<thread_cache_entry, 4> entries;
+
+                thread_cache() = default;
+
+                thread_cache(const thread_cache&) = delete;
+                thread_cache& operator=(const thread_cache&) = delete;
+
+                thread_cache(thread_cache&&) = delete;
+                thread_cache& operator=(thread_cache&&) = delete;
+
+                ~thread_cache() noexcept {
+                    cache_destroyed() = true;
+                    for (const auto& entry : entries) {
+                        if (entry.data) {
+                            free_slab(entry.data, entry.slab_size);
+                        }
+                    }
+                }
+
+            }; // struct thread_cache
+
+            mutable std::mutex m_mutex;
+            std::map<std::size_t, std::vector<unsigned char*>> m_free_slabs;
+            std::size_t m_cached_bytes = 0;
+            std::size_t m_max_cached_bytes;
+            bool m_huge_pages;
+
+            // Buffers destroyed after the thread-local cache (for
+            // instance in static objects) bypass the cache.
+            static bool& cache_destroyed() noexcept {
+                static thread_local bool destroyed = false;
+                return destroyed;
+            }
+
+            static thread_cache* local_cache() noexcept {
+                if (cache_destroyed()) {
+                    return nullptr;
+                }
+                static thread_local thread_cache cache;
+                return &cache;
+            }
+
+            static void free_slab(unsigned char* data, std::size_t slab_size) noexcept {
+#ifndef _WIN32
+                ::munmap(data, slab_size);
+#else
+                (void)slab_size;
+                delete[] data;
+#endif
+            }
+
+            unsigned char* allocate_slab(std::size_t slab_size) const {
+#ifndef _WIN32
+                void* addr = ::mmap(nullptr, slab_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (addr == MAP_FAILED) {
+                    throw std::bad_alloc{};
+                }
+# ifdef MADV_HUGEPAGE
+                if (m_huge_pages && slab_size >= huge_page_size) {
+                    ::madvise(addr, slab_size, MADV_HUGEPAGE);
+                }
+# endif
+                return static_cast<unsigned char*>(addr);
+#else
+                return new unsigned char[slab_size];
+#endif
+            }
+
+            unsigned char* get_cached_slab(std::size_t slab_size) {
+                if (auto* cache = local_cache()) {
+                    for (auto& entry : cache->entries) {
+                        if (entry.data && entry.pool == this && entry.slab_size == slab_size) {
+                            unsigned char* data = entry.data;
+                            entry = thread_cache_entry{};
+                            return data;
+                        }
+                    }
+                }
+
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                const auto it = m_free_slabs.find(slab_size);
+                if (it == m_free_slabs.end() || it->second.empty()) {
+                    return nullptr;
+                }
+                unsigned char* data = it->second.back();
+                it->second.pop_back();
+                m_cached_bytes -= slab_size;
+                return data;
+            }
+
+        public:
+
+            enum : std::size_t {
+                min_slab_size = 64UL * 1024UL,
+                max_slab_size = 256UL * 1024UL * 1024UL,
+                huge_page_size = 2UL * 1024UL * 1024UL,
+                default_max_cached_bytes = 1024UL * 1024UL * 1024UL
+            };
+
+            /**
+             * Create a buffer pool.
+             *
+             * @param huge_pages Advise the kernel to use huge pages for
+             *                   slabs that are large enough.
+             * @param max_cached_bytes The maximum number of bytes kept in
+             *                         the shared free lists. Slabs
+             *                         released when this is reached are
+             *                         freed.
+             */
+            explicit BufferPool(bool huge_pages = false, std::size_t max_cached_bytes = default_max_cached_bytes) :
+                m_max_cached_bytes(max_cached_bytes),
+                m_huge_pages(huge_pages) {
+            }
+
+            BufferPool(const BufferPool&) = delete;
+            BufferPool& operator=(const BufferPool&) = delete;
+
+            BufferPool(BufferPool&&) = delete;
+            BufferPool& operator=(BufferPool&&) = delete;
+
+            ~BufferPool() noexcept {
+                clear();
+            }
+
+            /**
+             * The pool used by Buffers that are not given a pool
+             * explicitly. Returns nullptr unless the pool is enabled with
+             * the environment variable OSMIUM_USE_BUFFER_POOL (see
+             * osmium::config::use_buffer_pool()).
+             */
+            static BufferPool* default_pool() {
+                // Never destroyed, so that buffers in static objects can
+                // safely hand back their memory.
+                static BufferPool* pool = osmium::config::use_buffer_pool() ?
+                    new BufferPool{osmium::config::use_huge_pages_for_buffers()} : nullptr; // NOLINT(cppcoreguidelines-owning-memory)
+                return pool;
+            }
+
+            /**
+             * The size of the slab the pool would use for the given size.
+             * Returns 0 if the pool doesn't handle this size.
+             */
+            static std::size_t slab_size(std::size_t size) noexcept {
+                if (size > max_slab_size) {
+                    return 0;
+                }
+                if (size <= min_slab_size) {
+                    return min_slab_size;
+                }
+                std::size_t step = min_slab_size / 4;
+                while (step * 8 < size) {
+                    step *= 2;
+                }
+                return (size + step - 1) / step * step;
+            }
+
+            /**
+             * Get memory for at least size bytes. Sizes not handled by the
+             * pool are allocated with new[].
+             */
+            detail::buffer_memory allocate(std::size_t size) {
+                const std::size_t slab = size < min_slab_size ? 0 : slab_size(size);
+                if (slab == 0) {
+                    return detail::buffer_memory{new unsigned char[size], detail::buffer_memory_deleter{this, 0}};
+                }
+
+                unsigned char* data = get_cached_slab(slab);
+                if (!data) {
+                    data = allocate_slab(slab);
+                }
+                return detail::buffer_memory{data, detail::buffer_memory_deleter{this, slab}};
+            }
+
+            /**
+             * Give a slab back to the pool. This is called by the deleter
+             * of the memory returned from allocate().
+             */
+            void release(unsigned char* data, std::size_t slab_size) noexcept {
+                if (auto* cache = local_cache()) {
+                    for (auto& entry : cache->entries) {
+                        if (!entry.data) {
+                            entry = thread_cache_entry{this, slab_size, data};
+                            return;
+                        }
+                    }
+                }
+
+                try {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    if (m_cached_bytes + slab_size <= m_max_cached_bytes) {
+                        m_free_slabs[slab_size].push_back(data);
+                        m_cached_bytes += slab_size;
+                        return;
+                    }
+                } catch (...) { // NOLINT(bugprone-empty-catch)
+                    // fall through and free the slab
+                }
+                free_slab(data, slab_size);
+            }
+
+            /**
+             * The number of bytes in the shared free lists. Slabs in the
+             * thread-local caches are not counted.
+             */
+            std::size_t cached_bytes() const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_cached_bytes;
+            }
+
+            /**
+             * Free all slabs in the shared free lists and in the
+             * thread-local cache of the calling thread. Caches of other
+             * threads are freed when those threads end.
+             */
+            void clear() noexcept {
+                if (auto* cache = local_cache()) {
+                    for (auto& entry : cache->entries) {
+                        if (entry.data && entry.pool == this) {
+                            free_slab(entry.data, entry.slab_size);
+                            entry = thread_cache_entry{};
+                        }
+                    }
+                }
+
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                for (const auto& slabs : m_free_slabs) {
+                    for (unsigned char* data : slabs.second) {
+                        free_slab(data, slabs.first);
+                    }
+                }
+                m_free_slabs.clear();
+                m_cached_bytes = 0;
+            }
+
+        }; // class BufferPool
+
+        namespace detail {
+
+            inline void buffer_memory_deleter::operator()(unsigned char* data) const noexcept {
+                if (slab_size == 0) {
+                    delete[] data;
+                } else {
+                    pool->release(data, slab_size);
+                }
+            }
+
+            /**
+             * Allocate memory for a Buffer from the given pool or with
+             * new[] if there is no pool.
+             */
+            inline buffer_memory allocate_buffer_memory(std::size_t size, BufferPool* pool) {
+                if (pool) {
+                    return pool->allocate(size);
+                }
+                return buffer_memory{new unsigned char[size]};
+            }
+
+        } // namespace detail
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUFFER_POOL_HPP
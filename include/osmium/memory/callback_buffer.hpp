@@ -34,15 +34,164 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/memory/buffer.hpp>
+#include <osmium/thread/util.hpp>
 
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
+#include <exception>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <utility>
 
 namespace osmium {
 
     namespace memory {
 
+        namespace detail {
+
+            /**
+             * Thread calling the callback of a CallbackBuffer in async
+             * mode. Buffers are handed over through a bounded queue and
+             * given to the callback in order.
+             */
+            class callback_buffer_worker {
+
+                using callback_func_type = std::function<void(osmium::memory::Buffer&&)>;
+
+                std::mutex m_mutex{};
+                std::condition_variable m_data_available{};
+                std::condition_variable m_space_available{};
+                std::condition_variable m_idle{};
+
+                std::deque<osmium::memory::Buffer> m_queue{};
+                std::size_t m_max_queue_size;
+                callback_func_type m_callback;
+
+                /// First exception thrown by the callback (not yet reported).
+                std::exception_ptr m_exception{};
+
+                /// Is the callback running right now?
+                bool m_busy = false;
+
+                bool m_done = false;
+
+                // Must be last so that it is joined before the other
+                // members are destroyed.
+                osmium::thread::thread_handler m_thread;
+
+                void run() {
+                    osmium::thread::set_thread_name("_osmium_cbuf");
+
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    while (true) {
+                        m_data_available.wait(lock, [this]() {
+                            return m_done || !m_queue.empty();
+                        });
+                        if (m_queue.empty()) {
+                            return;
+                        }
+
+                        osmium::memory::Buffer buffer{std::move(m_queue.front())};
+                        m_queue.pop_front();
+                        m_busy = true;
+                        const callback_func_type callback{m_exception ? nullptr : m_callback};
+                        m_space_available.notify_one();
+                        lock.unlock();
+
+                        // After an error buffers are thrown away until
+                        // the error was reported to the producer.
+                        std::exception_ptr exception;
+                        if (callback) {
+                            try {
+                                callback(std::move(buffer));
+                            } catch (...) {
+                                exception = std::current_exception();
+                            }
+                        }
+                        buffer = osmium::memory::Buffer{};
+
+                        lock.lock();
+                        if (exception && !m_exception) {
+                            m_exception = std::move(exception);
+                        }
+                        m_busy = false;
+                        if (m_queue.empty()) {
+                            m_idle.notify_all();
+                        }
+                    }
+                }
+
+            public:
+
+                callback_buffer_worker(callback_func_type callback, std::size_t max_queue_size) :
+                    m_max_queue_size(max_queue_size > 0 ? max_queue_size : 1),
+                    m_callback(std::move(callback)),
+                    m_thread(&callback_buffer_worker::run, this) {
+                }
+
+                callback_buffer_worker(const callback_buffer_worker&) = delete;
+                callback_buffer_worker& operator=(const callback_buffer_worker&) = delete;
+
+                callback_buffer_worker(callback_buffer_worker&&) = delete;
+                callback_buffer_worker& operator=(callback_buffer_worker&&) = delete;
+
+                /// Hands the remaining buffers to the callback, then stops.
+                ~callback_buffer_worker() noexcept {
+                    {
+                        const std::lock_guard<std::mutex> lock{m_mutex};
+                        m_done = true;
+                    }
+                    m_data_available.notify_one();
+                }
+
+                void set_callback(const callback_func_type& callback) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    m_callback = callback;
+                }
+
+                /// Add buffer to the queue, waits while the queue is full.
+                void push(osmium::memory::Buffer&& buffer) {
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_space_available.wait(lock, [this]() {
+                        return m_queue.size() < m_max_queue_size;
+                    });
+                    m_queue.push_back(std::move(buffer));
+                    m_data_available.notify_one();
+                }
+
+                /// Wait until the callback has been called for all buffers.
+                void wait() {
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_idle.wait(lock, [this]() {
+                        return m_queue.empty() && !m_busy;
+                    });
+                }
+
+                /// Number of buffers queued or being handled by the callback.
+                std::size_t in_flight() {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    return m_queue.size() + (m_busy ? 1 : 0);
+                }
+
+                /// Rethrow the first exception thrown by the callback, if any.
+                void check_for_exception() {
+                    std::exception_ptr exception;
+                    {
+                        const std::lock_guard<std::mutex> lock{m_mutex};
+                        exception = std::move(m_exception);
+                        m_exception = nullptr;
+                    }
+                    if (exception) {
+                        std::rethrow_exception(exception);
+                    }
+                }
+
+            }; // class callback_buffer_worker
+
+        } // namespace detail
+
         /**
          * This is basically a wrapper around osmium::memory::Buffer with an
          * additional callback function that is called whenever the buffer is
@@ -66,6 +215,10 @@ namespace osmium {
          *     osmium::builder::add_node(cb.buffer(), _id(9), ...);
          *     osmium::builder::add_way(cb.buffer(), _id(27), ...);
          * @endcode
+         *
+         * In async mode (see enable_async()) the callback is called in a
+         * separate thread, so that the code filling the buffer can go on
+         * with a new buffer while the callback is handling the full one.
          */
         class CallbackBuffer {
 
@@ -88,6 +241,7 @@ namespace osmium {
             std::size_t m_initial_buffer_size;
             std::size_t m_max_buffer_size;
             callback_func_type m_callback;
+            std::unique_ptr<detail::callback_buffer_worker> m_worker{};
 
         public:
 
@@ -143,19 +297,99 @@ namespace osmium {
              */
             void set_callback(const callback_func_type& callback = nullptr) noexcept {
                 m_callback = callback;
+                if (m_worker) {
+                    m_worker->set_callback(callback);
+                }
+            }
+
+            enum {
+                default_max_async_buffers = 4
+            };
+
+            /**
+             * Switch to async mode: From now on the callback is called in
+             * a separate thread. Buffers are handed to it in order through
+             * a queue. If the queue is full, flush() and possibly_flush()
+             * wait until there is space again, so there are never more
+             * than max_buffers + 1 full buffers in memory.
+             *
+             * In async mode flush() doesn't wait for the callback, call
+             * wait() to make sure all buffers were handled, for instance
+             * before closing a Writer called by the callback.
+             *
+             * If the callback throws, the exception is rethrown from the
+             * next call to flush(), possibly_flush(), or wait() and the
+             * buffers handed over in the meantime are dropped.
+             *
+             * Does nothing if async mode is already enabled.
+             *
+             * @param max_buffers Maximum number of buffers waiting for
+             *                    the callback.
+             */
+            void enable_async(std::size_t max_buffers = default_max_async_buffers) {
+                if (!m_worker) {
+                    m_worker.reset(new detail::callback_buffer_worker{m_callback, max_buffers});
+                }
+            }
+
+            /**
+             * Wait for all buffers to be handled and switch back to calling
+             * the callback directly.
+             *
+             * @throws Any exception thrown by the callback.
+             */
+            void disable_async() {
+                if (m_worker) {
+                    m_worker->wait();
+                    std::unique_ptr<detail::callback_buffer_worker> worker{std::move(m_worker)};
+                    worker->check_for_exception();
+                }
+            }
+
+            /// Is async mode enabled?
+            bool is_async() const noexcept {
+                return m_worker != nullptr;
+            }
+
+            /**
+             * The number of buffers handed over in async mode that are
+             * waiting for or being handled by the callback.
+             */
+            std::size_t in_flight() const {
+                return m_worker ? m_worker->in_flight() : 0;
+            }
+
+            /**
+             * In async mode wait until the callback has been called for all
+             * buffers handed over so far. Does nothing otherwise. This does
+             * not flush the internal buffer, call flush() first.
+             *
+             * @throws Any exception thrown by the callback.
+             */
+            void wait() {
+                if (m_worker) {
+                    m_worker->wait();
+                    m_worker->check_for_exception();
+                }
             }
 
             /**
              * Flush the internal buffer regardless of how full it is. Calls
              * the callback with the buffer and creates an new empty internal
-             * one.
+             * one. In async mode the buffer is only handed over to the
+             * thread calling the callback.
              *
              * This will do nothing if no callback is set or if the buffer
              * is empty.
              */
             void flush() {
                 if (m_callback && m_buffer.committed() > 0) {
-                    m_callback(read());
+                    if (m_worker) {
+                        m_worker->check_for_exception();
+                        m_worker->push(read());
+                    } else {
+                        m_callback(read());
+                    }
                 }
             }
 
@@ -108,7 +108,8 @@ namespace osmium {
             item_type m_type;
             uint16_t m_removed : 1;
             uint16_t m_diff : 2;
-            uint16_t m_padding : 13;
+            uint16_t m_sorted : 1;
+            uint16_t m_padding : 12;
 
             template <typename TMember>
             friend class CollectionIterator;
@@ -130,6 +131,7 @@ namespace osmium {
                 m_type(type),
                 m_removed(false),
                 m_diff(0),
+                m_sorted(false),
                 m_padding(0) {
             }
 
@@ -138,6 +140,19 @@ namespace osmium {
                 return *this;
             }
 
+            /**
+             * Collections can use this flag to remember that their
+             * members are sorted in some way. What that means is up to
+             * the collection.
+             */
+            bool sorted_flag() const noexcept {
+                return m_sorted;
+            }
+
+            void set_sorted_flag(const bool sorted) noexcept {
+                m_sorted = sorted;
+            }
+
         public:
 
             Item(const Item&) = delete;
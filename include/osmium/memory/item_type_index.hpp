@@ -0,0 +1,167 @@
+#ifndef OSMIUM_MEMORY_ITEM_TYPE_INDEX_HPP
+#define OSMIUM_MEMORY_ITEM_TYPE_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/item_type.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * A range of consecutive items of the same type in a buffer.
+         */
+        struct item_type_range {
+
+            /// Offset of the first item in the range.
+            std::size_t begin;
+
+            /// Offset one past the last item in the range.
+            std::size_t end;
+
+            /// Number of items in the range.
+            std::size_t count;
+
+            /// Type of all items in the range.
+            osmium::item_type type;
+
+        }; // struct item_type_range
+
+        /**
+         * Index of the types of the items in a buffer. It stores the
+         * ranges of consecutive items of the same type, so code only
+         * interested in some types can jump right to them without
+         * looking at every item header.
+         *
+         * Usually you don't create this yourself, but call
+         * Buffer::build_type_index() or use the index attached by the
+         * parsers.
+         */
+        class ItemTypeIndex {
+
+            std::vector<item_type_range> m_ranges;
+            std::size_t m_size = 0;
+
+        public:
+
+            using const_iterator = std::vector<item_type_range>::const_iterator;
+
+            /**
+             * Add an item to the index. Items have to be added in the
+             * order they are in the buffer without gaps.
+             *
+             * @param type The type of the item.
+             * @param begin Offset of the item in the buffer.
+             * @param end Offset one past the (padded) end of the item.
+             */
+            void add(const osmium::item_type type, const std::size_t begin, const std::size_t end) {
+                assert(begin == m_size);
+                assert(begin < end);
+                if (!m_ranges.empty() && m_ranges.back().type == type) {
+                    m_ranges.back().end = end;
+                    ++m_ranges.back().count;
+                } else {
+                    m_ranges.push_back(item_type_range{begin, end, 1, type});
+                }
+                m_size = end;
+            }
+
+            /// The number of bytes of the buffer covered by the index.
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            /// Is the index empty?
+            bool empty() const noexcept {
+                return m_ranges.empty();
+            }
+
+            /// The number of ranges in the index.
+            std::size_t num_ranges() const noexcept {
+                return m_ranges.size();
+            }
+
+            const_iterator begin() const noexcept {
+                return m_ranges.cbegin();
+            }
+
+            const_iterator end() const noexcept {
+                return m_ranges.cend();
+            }
+
+            /**
+             * The number of items compatible with type T in the index.
+             */
+            template <typename T>
+            std::size_t count() const noexcept {
+                std::size_t num = 0;
+                for (const auto& range : m_ranges) {
+                    if (T::is_compatible_to(range.type)) {
+                        num += range.count;
+                    }
+                }
+                return num;
+            }
+
+            /**
+             * The smallest range of offsets containing all items
+             * compatible with type T. If there are no such items, the
+             * range is empty and starts at the end of the index.
+             */
+            template <typename T>
+            item_type_range span() const noexcept {
+                item_type_range result{m_size, m_size, 0, osmium::item_type::undefined};
+                for (const auto& range : m_ranges) {
+                    if (T::is_compatible_to(range.type)) {
+                        if (result.count == 0) {
+                            result.begin = range.begin;
+                        }
+                        result.end = range.end;
+                        result.count += range.count;
+                    }
+                }
+                return result;
+            }
+
+        }; // class ItemTypeIndex
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_ITEM_TYPE_INDEX_HPP
@@ -0,0 +1,412 @@
+#ifndef OSMIUM_MEMORY_SEGMENTED_BUFFER_HPP
+#define OSMIUM_MEMORY_SEGMENTED_BUFFER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/memory/item_iterator.hpp>
+#include <osmium/osm/entity.hpp>
+#include <osmium/util/iterator.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * Iterator over the items in all segments of a SegmentedBuffer.
+         * Like the ItemIterator it only returns items of type TMember
+         * (or derived types).
+         */
+        template <typename TMember>
+        class SegmentedItemIterator {
+
+            const std::vector<Buffer>* m_segments = nullptr;
+            const Buffer* m_last = nullptr;
+            std::size_t m_segment = 0;
+            ItemIterator<TMember> m_it;
+
+            const Buffer& segment(std::size_t n) const noexcept {
+                return n < m_segments->size() ? (*m_segments)[n] : *m_last;
+            }
+
+            static ItemIterator<TMember> segment_begin(const Buffer& buffer) noexcept {
+                return ItemIterator<TMember>{buffer.data(), buffer.data() + buffer.committed()};
+            }
+
+            void skip_empty_segments() noexcept {
+                while (!m_it && m_segment < m_segments->size()) {
+                    ++m_segment;
+                    m_it = segment_begin(segment(m_segment));
+                }
+            }
+
+        public:
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = TMember;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = value_type*;
+            using reference         = value_type&;
+
+            SegmentedItemIterator() noexcept = default;
+
+            // Iterator pointing to the first item of the given segment.
+            // Segments are numbered from 0 to segments.size(), the last
+            // segment is the one passed in separately.
+            SegmentedItemIterator(const std::vector<Buffer>& segments, const Buffer& last, std::size_t segment) noexcept :
+                m_segments(&segments),
+                m_last(&last),
+                m_segment(segment),
+                m_it(segment_begin(this->segment(segment))) {
+                skip_empty_segments();
+            }
+
+            // Iterator pointing to the end of the last segment.
+            SegmentedItemIterator(const std::vector<Buffer>& segments, const Buffer& last) noexcept :
+                m_segments(&segments),
+                m_last(&last),
+                m_segment(segments.size()),
+                m_it(last.data() + last.committed(), last.data() + last.committed()) {
+            }
+
+            SegmentedItemIterator<TMember>& operator++() noexcept {
+                assert(m_it);
+                ++m_it;
+                skip_empty_segments();
+                return *this;
+            }
+
+            SegmentedItemIterator<TMember> operator++(int) noexcept {
+                SegmentedItemIterator<TMember> tmp{*this};
+                operator++();
+                return tmp;
+            }
+
+            bool operator==(const SegmentedItemIterator<TMember>& rhs) const noexcept {
+                return m_segment == rhs.m_segment && m_it == rhs.m_it;
+            }
+
+            bool operator!=(const SegmentedItemIterator<TMember>& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            TMember& operator*() const noexcept {
+                return *m_it;
+            }
+
+            TMember* operator->() const noexcept {
+                return m_it.operator->();
+            }
+
+            /// The number of the segment the item is in.
+            std::size_t segment_number() const noexcept {
+                return m_segment;
+            }
+
+        }; // class SegmentedItemIterator
+
+        /**
+         * A buffer made up of several segments. When the current segment
+         * is full a new one is started and only the item that is being
+         * built at that moment is copied over. Unlike a Buffer with
+         * auto_grow::yes, the data already committed is never copied,
+         * so building a huge amount of data (or a few huge objects) into
+         * one SegmentedBuffer doesn't lead to large copies.
+         *
+         * Items are added through the Buffer returned by buffer() which
+         * can be used with the Builder classes as usual. (It is a Buffer
+         * with auto_grow::internal, its full segments are moved into the
+         * SegmentedBuffer the next time the SegmentedBuffer is accessed.)
+         * The iterators of this class walk over all segments in the order
+         * the items were added.
+         *
+         * As with the Buffer, there are no offsets to items that are
+         * stable across the whole SegmentedBuffer and adding items
+         * invalidates iterators.
+         */
+        class SegmentedBuffer {
+
+            // Full segments, oldest first.
+            mutable std::vector<Buffer> m_segments;
+
+            // The current segment which is filled.
+            mutable Buffer m_buffer;
+
+            std::size_t m_segment_size;
+
+            BufferPool* m_pool = nullptr;
+
+            Buffer new_segment() const {
+                if (m_pool) {
+                    return Buffer{m_segment_size, Buffer::auto_grow::internal, *m_pool};
+                }
+                return Buffer{m_segment_size, Buffer::auto_grow::internal};
+            }
+
+            void collect_segments() const {
+                while (m_buffer.has_nested_buffers()) {
+                    m_segments.push_back(std::move(*m_buffer.get_last_nested()));
+                }
+            }
+
+        public:
+
+            // This is needed so we can call std::back_inserter() on a
+            // SegmentedBuffer.
+            using value_type = Item;
+
+            template <typename T>
+            using t_iterator = SegmentedItemIterator<T>;
+
+            template <typename T>
+            using t_const_iterator = SegmentedItemIterator<const T>;
+
+            using iterator = t_iterator<osmium::OSMEntity>;
+            using const_iterator = t_const_iterator<osmium::OSMEntity>;
+
+            enum : std::size_t {
+                default_segment_size = 1024UL * 1024UL
+            };
+
+            /**
+             * Create an empty SegmentedBuffer.
+             *
+             * @param segment_size The size of the segments. Segments can
+             *                     become larger if a single item doesn't
+             *                     fit.
+             */
+            explicit SegmentedBuffer(std::size_t segment_size = default_segment_size) :
+                m_buffer(segment_size, Buffer::auto_grow::internal),
+                m_segment_size(segment_size) {
+            }
+
+            /**
+             * Create an empty SegmentedBuffer getting the memory for its
+             * segments from the specified pool. The pool must outlive the
+             * SegmentedBuffer and all segments released from it.
+             *
+             * @param segment_size The size of the segments. Segments can
+             *                     become larger if a single item doesn't
+             *                     fit.
+             * @param pool The pool to get the memory from.
+             */
+            SegmentedBuffer(std::size_t segment_size, BufferPool& pool) :
+                m_buffer(segment_size, Buffer::auto_grow::internal, pool),
+                m_segment_size(segment_size),
+                m_pool(&pool) {
+            }
+
+            /**
+             * The buffer items can be added to, use this with the
+             * Builder classes. Items must be committed on this buffer
+             * (or with commit()) as usual.
+             */
+            Buffer& buffer() noexcept {
+                return m_buffer;
+            }
+
+            /**
+             * Add an item and commit it.
+             */
+            void push_back(const osmium::memory::Item& item) {
+                m_buffer.push_back(item);
+            }
+
+            /**
+             * Commit the data written into buffer() since the last commit.
+             */
+            void commit() {
+                m_buffer.commit();
+            }
+
+            /**
+             * The number of segments. This is always at least one.
+             */
+            std::size_t num_segments() const {
+                collect_segments();
+                return m_segments.size() + 1;
+            }
+
+            /**
+             * Get segment n (0 <= n < num_segments()). The last segment
+             * is the one still being filled.
+             */
+            const Buffer& segment(std::size_t n) const {
+                collect_segments();
+                assert(n <= m_segments.size());
+                return n < m_segments.size() ? m_segments[n] : m_buffer;
+            }
+
+            /**
+             * The number of bytes committed in all segments.
+             */
+            std::size_t committed() const {
+                collect_segments();
+                std::size_t sum = m_buffer.committed();
+                for (const auto& segment : m_segments) {
+                    sum += segment.committed();
+                }
+                return sum;
+            }
+
+            /**
+             * The capacity of all segments together.
+             */
+            std::size_t capacity() const {
+                collect_segments();
+                std::size_t sum = m_buffer.capacity();
+                for (const auto& segment : m_segments) {
+                    sum += segment.capacity();
+                }
+                return sum;
+            }
+
+            /**
+             * Remove all items, only the current segment is kept.
+             */
+            void clear() {
+                collect_segments();
+                m_segments.clear();
+                m_buffer.clear();
+            }
+
+            /**
+             * Move all segments out of this SegmentedBuffer, oldest first.
+             * Empty segments are left out. Afterwards this SegmentedBuffer
+             * is empty. This can be used to hand the data to something
+             * that works on Buffers, like a Writer.
+             */
+            std::vector<Buffer> release() {
+                collect_segments();
+                std::vector<Buffer> segments;
+                segments.reserve(m_segments.size() + 1);
+                for (auto& segment : m_segments) {
+                    if (segment.committed() > 0) {
+                        segments.push_back(std::move(segment));
+                    }
+                }
+                m_segments.clear();
+                if (m_buffer.committed() > 0) {
+                    segments.push_back(std::move(m_buffer));
+                    m_buffer = new_segment();
+                }
+                return segments;
+            }
+
+            /**
+             * Select items of type T from all segments.
+             */
+            template <typename T>
+            osmium::iterator_range<t_iterator<T>> select() {
+                return osmium::make_range(std::make_pair(begin<T>(), end<T>()));
+            }
+
+            template <typename T>
+            osmium::iterator_range<t_const_iterator<T>> select() const {
+                return osmium::make_range(std::make_pair(cbegin<T>(), cend<T>()));
+            }
+
+            template <typename T>
+            t_iterator<T> begin() {
+                collect_segments();
+                return t_iterator<T>{m_segments, m_buffer, 0};
+            }
+
+            iterator begin() {
+                return begin<osmium::OSMEntity>();
+            }
+
+            template <typename T>
+            t_iterator<T> end() {
+                collect_segments();
+                return t_iterator<T>{m_segments, m_buffer};
+            }
+
+            iterator end() {
+                return end<osmium::OSMEntity>();
+            }
+
+            template <typename T>
+            t_const_iterator<T> cbegin() const {
+                collect_segments();
+                return t_const_iterator<T>{m_segments, m_buffer, 0};
+            }
+
+            const_iterator cbegin() const {
+                return cbegin<osmium::OSMEntity>();
+            }
+
+            template <typename T>
+            t_const_iterator<T> cend() const {
+                collect_segments();
+                return t_const_iterator<T>{m_segments, m_buffer};
+            }
+
+            const_iterator cend() const {
+                return cend<osmium::OSMEntity>();
+            }
+
+            template <typename T>
+            t_const_iterator<T> begin() const {
+                return cbegin<T>();
+            }
+
+            const_iterator begin() const {
+                return cbegin();
+            }
+
+            template <typename T>
+            t_const_iterator<T> end() const {
+                return cend<T>();
+            }
+
+            const_iterator end() const {
+                return cend();
+            }
+
+        }; // class SegmentedBuffer
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_SEGMENTED_BUFFER_HPP
@@ -0,0 +1,165 @@
+#ifndef OSMIUM_MEMORY_SHARED_BUFFER_HPP
+#define OSMIUM_MEMORY_SHARED_BUFFER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity.hpp>
+
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * An immutable Buffer that can be shared by several consumers, for
+         * instance a Writer and a handler running in another thread. Copying
+         * a SharedBuffer only copies a reference, the reference count is
+         * atomic so the copies can be used in different threads.
+         *
+         * When the last reference goes away, the buffer is handed to the
+         * release function if there is one (Reader::read_shared() uses this
+         * to give the memory back to the reader for reuse), otherwise it is
+         * destroyed and its memory goes back to the BufferPool it came from
+         * or is freed.
+         */
+        class SharedBuffer {
+
+        public:
+
+            using release_function = std::function<void(Buffer&&)>;
+
+        private:
+
+            struct releaser {
+
+                release_function release;
+
+                void operator()(const Buffer* buffer) const noexcept {
+                    std::unique_ptr<Buffer> owned{const_cast<Buffer*>(buffer)}; // NOLINT(cppcoreguidelines-pro-type-const-cast)
+                    if (release) {
+                        try {
+                            release(std::move(*owned));
+                        } catch (...) {
+                            // ignore errors, the buffer is freed instead
+                        }
+                    }
+                }
+
+            }; // struct releaser
+
+            std::shared_ptr<const Buffer> m_buffer{};
+
+        public:
+
+            using const_iterator = Buffer::const_iterator;
+
+            /**
+             * Create an empty SharedBuffer not referencing any buffer.
+             */
+            SharedBuffer() noexcept = default;
+
+            /**
+             * Create a SharedBuffer from a buffer. The buffer is moved in,
+             * not copied.
+             *
+             * @param buffer The buffer.
+             * @param release Optional function called with the buffer when
+             *                the last reference goes away. It might be
+             *                called from any thread holding a reference.
+             */
+            explicit SharedBuffer(Buffer&& buffer, release_function release = nullptr) :
+                m_buffer(new Buffer{std::move(buffer)}, releaser{std::move(release)}) {
+            }
+
+            /**
+             * Does this reference a valid buffer?
+             */
+            explicit operator bool() const noexcept {
+                return m_buffer && *m_buffer;
+            }
+
+            const Buffer& operator*() const noexcept {
+                return *m_buffer;
+            }
+
+            const Buffer* operator->() const noexcept {
+                return m_buffer.get();
+            }
+
+            const Buffer* get() const noexcept {
+                return m_buffer.get();
+            }
+
+            /**
+             * The underlying shared pointer, for instance to hand to
+             * Writer::write_shared().
+             */
+            const std::shared_ptr<const Buffer>& ptr() const noexcept {
+                return m_buffer;
+            }
+
+            /**
+             * The number of SharedBuffers (and shared pointers returned by
+             * ptr()) referencing the buffer. Only approximate if they are
+             * used in several threads.
+             */
+            long use_count() const noexcept {
+                return m_buffer.use_count();
+            }
+
+            const_iterator begin() const {
+                return m_buffer->cbegin();
+            }
+
+            const_iterator end() const {
+                return m_buffer->cend();
+            }
+
+            /**
+             * Drop this reference to the buffer.
+             */
+            void reset() noexcept {
+                m_buffer.reset();
+            }
+
+        }; // class SharedBuffer
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_SHARED_BUFFER_HPP
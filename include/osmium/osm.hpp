@@ -34,7 +34,9 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/osm/area.hpp> // IWYU pragma: export
+#include <osmium/osm/bounding_box.hpp> // IWYU pragma: export
 #include <osmium/osm/changeset.hpp> // IWYU pragma: export
+#include <osmium/osm/compressed_way_node_list.hpp> // IWYU pragma: export
 #include <osmium/osm/entity.hpp> // IWYU pragma: export
 #include <osmium/osm/entity_bits.hpp> // IWYU pragma: export
 #include <osmium/osm/item_type.hpp> // IWYU pragma: export
@@ -36,6 +36,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/memory/collection.hpp>
 #include <osmium/memory/item.hpp>
 #include <osmium/memory/item_iterator.hpp>
+#include <osmium/osm/bounding_box.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/node_ref_list.hpp>
@@ -179,7 +180,8 @@ namespace osmium {
                         ++counter.second;
                         break;
                     case osmium::item_type::tag_list:
-                        // ignore tags
+                    case osmium::item_type::bounding_box:
+                        // ignore tags and bounding box
                         break;
                     case osmium::item_type::undefined:
                     case osmium::item_type::node:
@@ -190,8 +192,9 @@ namespace osmium {
                     case osmium::item_type::way_node_list:
                     case osmium::item_type::relation_member_list:
                     case osmium::item_type::relation_member_list_with_full_members:
+                    case osmium::item_type::compressed_way_node_list:
                     case osmium::item_type::changeset_discussion:
-                        assert(false && "Children of Area can only be outer/inner_ring and tag_list.");
+                        assert(false && "Children of Area can only be outer/inner_ring, tag_list, and bounding_box.");
                         break;
                 }
             }
@@ -228,11 +231,27 @@ namespace osmium {
         }
 
         /**
-         * Calculate the envelope of this area.
+         * Get the bounding box subitem of this area.
          *
-         * Complexity: Linear in the number of nodes in the outer rings.
+         * @returns Pointer to the bounding box or nullptr if there is none.
+         */
+        const osmium::BoundingBox* bounding_box() const noexcept {
+            return osmium::detail::subitem_ptr_of_type<const osmium::BoundingBox>(cbegin(), cend());
+        }
+
+        /**
+         * Calculate the envelope of this area. If the area has a valid
+         * bounding box subitem, it is returned instead.
+         *
+         * Complexity: Constant if there is a bounding box, linear in the
+         *             number of nodes in the outer rings otherwise.
          */
         osmium::Box envelope() const noexcept {
+            const auto* bbox = bounding_box();
+            if (bbox && bbox->box().valid()) {
+                return bbox->box();
+            }
+
             osmium::Box box;
             for (const auto& ring : outer_rings()) {
                 box.extend(ring.envelope());
@@ -0,0 +1,86 @@
+#ifndef OSMIUM_OSM_BOUNDING_BOX_HPP
+#define OSMIUM_OSM_BOUNDING_BOX_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+
+namespace osmium {
+
+    /**
+     * A bounding box stored as a subitem of a Way or Area. It caches the
+     * envelope of the object, so that it doesn't have to be calculated
+     * from all node locations every time it is needed.
+     *
+     * The NodeLocationsForWays handler updates the bounding box of ways
+     * that have one when it sets the node locations. The area Assembler
+     * can add a bounding box to all areas it creates (see the
+     * AssemblerConfig::add_bounding_box setting).
+     */
+    class BoundingBox : public osmium::memory::Item {
+
+        osmium::Box m_box;
+
+    public:
+
+        static constexpr osmium::item_type itemtype = osmium::item_type::bounding_box;
+
+        constexpr static bool is_compatible_to(osmium::item_type t) noexcept {
+            return t == itemtype;
+        }
+
+        explicit BoundingBox(const osmium::Box& box = osmium::Box{}) noexcept :
+            Item(sizeof(BoundingBox), itemtype),
+            m_box(box) {
+        }
+
+        /// Get the bounding box.
+        const osmium::Box& box() const noexcept {
+            return m_box;
+        }
+
+        /// Set the bounding box.
+        void set_box(const osmium::Box& box) noexcept {
+            m_box = box;
+        }
+
+    }; // class BoundingBox
+
+    static_assert(sizeof(BoundingBox) % osmium::memory::align_bytes == 0, "Class osmium::BoundingBox has wrong size to be aligned properly!");
+
+} // namespace osmium
+
+#endif // OSMIUM_OSM_BOUNDING_BOX_HPP
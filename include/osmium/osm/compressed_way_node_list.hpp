@@ -0,0 +1,312 @@
+#ifndef OSMIUM_OSM_COMPRESSED_WAY_NODE_LIST_HPP
+#define OSMIUM_OSM_COMPRESSED_WAY_NODE_LIST_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/delta.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace osmium {
+
+    namespace builder {
+        class CompressedWayNodeListBuilder;
+    } // namespace builder
+
+    namespace detail {
+
+        enum : std::size_t {
+            max_compressed_varint_length = 10
+        };
+
+        inline uint64_t encode_zigzag(const int64_t value) noexcept {
+            return (static_cast<uint64_t>(value) << 1U) ^ static_cast<uint64_t>(-static_cast<int64_t>(static_cast<uint64_t>(value) >> 63U));
+        }
+
+        inline int64_t decode_zigzag(const uint64_t value) noexcept {
+            return static_cast<int64_t>((value >> 1U) ^ static_cast<uint64_t>(-static_cast<int64_t>(value & 1U)));
+        }
+
+        // Write value as varint into data which must have space for at
+        // least max_compressed_varint_length bytes. Returns the number
+        // of bytes written.
+        inline std::size_t write_compressed_varint(unsigned char* data, uint64_t value) noexcept {
+            std::size_t n = 0;
+            while (value >= 0x80U) {
+                data[n++] = static_cast<unsigned char>((value & 0x7fU) | 0x80U);
+                value >>= 7U;
+            }
+            data[n++] = static_cast<unsigned char>(value);
+            return n;
+        }
+
+        // Read varint from data. The data must be valid, there are no
+        // checks, because it was written by write_compressed_varint()
+        // into the buffer.
+        inline uint64_t read_compressed_varint(const unsigned char** data) noexcept {
+            const unsigned char* d = *data;
+            // fast path for the common case of small deltas
+            if (*d < 0x80U) {
+                ++*data;
+                return *d;
+            }
+            uint64_t value = 0;
+            unsigned int shift = 0;
+            while (*d >= 0x80U) {
+                value |= static_cast<uint64_t>(*d++ & 0x7fU) << shift;
+                shift += 7;
+            }
+            value |= static_cast<uint64_t>(*d++) << shift;
+            *data = d;
+            return value;
+        }
+
+    } // namespace detail
+
+    /**
+     * A compact alternative to the WayNodeList. The node IDs and the
+     * coordinates of the locations are delta encoded, zigzag encoded and
+     * then stored as varints. Nodes in a way are usually close together
+     * and often have similar IDs, so this needs typically only 3 to 6
+     * bytes per node instead of the 16 bytes of a NodeRef.
+     *
+     * This is meant for storing many ways in memory, for instance in an
+     * ItemStash. It can not be changed after it was built and it can only
+     * be iterated forwards; the NodeRefs are decoded on the fly by the
+     * iterator.
+     *
+     * A Way can contain a CompressedWayNodeList instead of a WayNodeList.
+     * Use Way::compressed_nodes() to access it. The area Assembler and the
+     * GeometryFactory can work with those ways directly. Build a way like
+     * this with osmium::builder::add_compressed_way() or with the
+     * CompressedWayNodeListBuilder.
+     */
+    class CompressedWayNodeList : public osmium::memory::Item {
+
+        friend class osmium::builder::CompressedWayNodeListBuilder;
+
+        uint32_t m_num_nodes = 0;
+        uint32_t m_reserved = 0;
+
+        const unsigned char* encoded_begin() const noexcept {
+            return data() + sizeof(CompressedWayNodeList);
+        }
+
+        const unsigned char* encoded_end() const noexcept {
+            return data() + byte_size();
+        }
+
+    public:
+
+        static constexpr osmium::item_type itemtype = osmium::item_type::compressed_way_node_list;
+
+        constexpr static bool is_compatible_to(osmium::item_type t) noexcept {
+            return t == itemtype;
+        }
+
+        /**
+         * Forward iterator decoding the NodeRefs one by one. Dereferencing
+         * returns a reference to a NodeRef inside the iterator, which is
+         * only valid until the iterator is incremented.
+         */
+        class const_iterator {
+
+            const unsigned char* m_data = nullptr;
+            const unsigned char* m_next = nullptr;
+            const unsigned char* m_end = nullptr;
+            osmium::DeltaDecode<osmium::object_id_type> m_ref;
+            osmium::DeltaDecode<int32_t> m_x;
+            osmium::DeltaDecode<int32_t> m_y;
+            osmium::NodeRef m_node_ref;
+
+            void decode() noexcept {
+                if (m_data == m_end) {
+                    return;
+                }
+                m_next = m_data;
+                m_ref.update(osmium::detail::decode_zigzag(osmium::detail::read_compressed_varint(&m_next)));
+                m_x.update(osmium::detail::decode_zigzag(osmium::detail::read_compressed_varint(&m_next)));
+                m_y.update(osmium::detail::decode_zigzag(osmium::detail::read_compressed_varint(&m_next)));
+                m_node_ref = osmium::NodeRef{m_ref.value(), osmium::Location{m_x.value(), m_y.value()}};
+            }
+
+        public:
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = osmium::NodeRef;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = const osmium::NodeRef*;
+            using reference         = const osmium::NodeRef&;
+
+            const_iterator() noexcept = default;
+
+            const_iterator(const unsigned char* data, const unsigned char* end) noexcept :
+                m_data(data),
+                m_end(end) {
+                decode();
+            }
+
+            const_iterator& operator++() noexcept {
+                m_data = m_next;
+                decode();
+                return *this;
+            }
+
+            const_iterator operator++(int) noexcept {
+                const_iterator tmp{*this};
+                operator++();
+                return tmp;
+            }
+
+            bool operator==(const const_iterator& rhs) const noexcept {
+                return m_data == rhs.m_data;
+            }
+
+            bool operator!=(const const_iterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            reference operator*() const noexcept {
+                return m_node_ref;
+            }
+
+            pointer operator->() const noexcept {
+                return &m_node_ref;
+            }
+
+        }; // class const_iterator
+
+        using value_type      = NodeRef;
+        using const_reference = const NodeRef&;
+        using iterator        = const_iterator;
+        using size_type       = std::size_t;
+
+        CompressedWayNodeList() noexcept :
+            Item(sizeof(CompressedWayNodeList), itemtype) {
+        }
+
+        /**
+         * Checks whether the list is empty.
+         *
+         * Complexity: Constant.
+         */
+        bool empty() const noexcept {
+            return m_num_nodes == 0;
+        }
+
+        /**
+         * Returns the number of NodeRefs in the list.
+         *
+         * Complexity: Constant.
+         */
+        size_type size() const noexcept {
+            return m_num_nodes;
+        }
+
+        /**
+         * Returns the number of bytes used for the encoded NodeRefs.
+         */
+        size_type encoded_size() const noexcept {
+            return byte_size() - sizeof(CompressedWayNodeList);
+        }
+
+        const_iterator cbegin() const noexcept {
+            return {encoded_begin(), encoded_end()};
+        }
+
+        const_iterator cend() const noexcept {
+            return {encoded_end(), encoded_end()};
+        }
+
+        const_iterator begin() const noexcept {
+            return cbegin();
+        }
+
+        const_iterator end() const noexcept {
+            return cend();
+        }
+
+        /**
+         * Returns the first NodeRef in the list.
+         *
+         * Complexity: Constant.
+         *
+         * @pre @code !empty() @endcode
+         */
+        osmium::NodeRef front() const noexcept {
+            return *cbegin();
+        }
+
+        /**
+         * Returns the last NodeRef in the list.
+         *
+         * Complexity: Linear in the number of nodes.
+         *
+         * @pre @code !empty() @endcode
+         */
+        osmium::NodeRef back() const noexcept {
+            osmium::NodeRef node_ref;
+            for (const auto& nr : *this) {
+                node_ref = nr;
+            }
+            return node_ref;
+        }
+
+        /**
+         * Calculate the envelope of the locations in the list.
+         *
+         * Complexity: Linear in the number of nodes.
+         */
+        osmium::Box envelope() const noexcept {
+            osmium::Box box;
+            for (const auto& nr : *this) {
+                box.extend(nr.location());
+            }
+            return box;
+        }
+
+    }; // class CompressedWayNodeList
+
+    static_assert(sizeof(CompressedWayNodeList) % osmium::memory::align_bytes == 0, "Class osmium::CompressedWayNodeList has wrong size to be aligned properly!");
+
+} // namespace osmium
+
+#endif // OSMIUM_OSM_COMPRESSED_WAY_NODE_LIST_HPP
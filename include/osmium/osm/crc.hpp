@@ -49,6 +49,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/util/endian.hpp>
 
 #include <cstdint>
+#include <cstring>
 
 namespace osmium {
 
@@ -94,7 +95,9 @@ namespace osmium {
      *
      * Typically you will either use the boost::crc_32_type from the Boost
      * CRC library or the osmium::CRC_zlib class which uses the zlib library
-     * for this, but other checksums are possible.
+     * for this, but other checksums are possible. The osmium::CRC_crc32c
+     * class implements the CRC32C checksum which is much faster if the
+     * CPU has instructions for it.
      *
      * @tparam TCRC A CRC type.
      */
@@ -149,9 +152,14 @@ namespace osmium {
         }
 
         void update_string(const char* str) noexcept {
-            while (*str) {
-                m_crc.process_byte(*str++);
-            }
+            // GCC can't see that the strings in OSM objects are stored
+            // behind the object and warns about reading outside it.
+#pragma GCC diagnostic push
+#if !defined(__clang__) && defined(__GNUC__) && (__GNUC__ > 10)
+#pragma GCC diagnostic ignored "-Wstringop-overread"
+#endif
+            m_crc.process_bytes(str, std::strlen(str));
+#pragma GCC diagnostic pop
         }
 
         void update(const Timestamp& timestamp) noexcept {
@@ -174,9 +182,20 @@ namespace osmium {
         }
 
         void update(const NodeRefList& node_refs) noexcept {
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+            // The node refs are stored one after the other with the id
+            // followed by the x and y coordinates and no padding, which
+            // is exactly what update(const NodeRef&) hashes, so we can
+            // do them all in one go.
+            static_assert(sizeof(NodeRef) == sizeof(int64_t) + 2 * sizeof(int32_t), "NodeRef must not contain padding");
+            if (!node_refs.empty()) {
+                m_crc.process_bytes(node_refs.cbegin(), node_refs.size() * sizeof(NodeRef));
+            }
+#else
             for (const NodeRef& node_ref : node_refs) {
                 update(node_ref);
             }
+#endif
         }
 
         void update(const TagList& tags) noexcept {
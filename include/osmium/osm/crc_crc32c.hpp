@@ -0,0 +1,256 @@
+#ifndef OSMIUM_OSM_CRC_CRC32C_HPP
+#define OSMIUM_OSM_CRC_CRC32C_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/cpu_features.hpp>
+
+#if defined(__SSE4_2__)
+# include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+# include <arm_acle.h>
+#elif defined(OSMIUM_HAS_TARGET_ATTRIBUTE)
+# include <nmmintrin.h>
+#endif
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace osmium {
+
+    namespace detail {
+
+        using crc32c_table_type = std::array<std::array<uint32_t, 256>, 8>;
+
+        inline crc32c_table_type make_crc32c_table() noexcept {
+            crc32c_table_type table{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc & 1U) ? (crc >> 1U) ^ 0x82F63B78UL : crc >> 1U;
+                }
+                table[0][i] = crc;
+            }
+            for (std::size_t k = 1; k < 8; ++k) {
+                for (std::size_t i = 0; i < 256; ++i) {
+                    table[k][i] = (table[k - 1][i] >> 8U) ^ table[0][table[k - 1][i] & 0xffU];
+                }
+            }
+            return table;
+        }
+
+        inline const crc32c_table_type& crc32c_table() noexcept {
+            static const crc32c_table_type table = make_crc32c_table();
+            return table;
+        }
+
+        /**
+         * Table-driven CRC32C (slicing-by-8) for use when the CPU
+         * instructions are not available. The crc is the internal state,
+         * ie. not inverted.
+         */
+        inline uint32_t crc32c_software(uint32_t crc, const unsigned char* data, std::size_t size) noexcept {
+            const auto& t = crc32c_table();
+            while (size >= 8) {
+                const uint32_t one = crc ^ (static_cast<uint32_t>(data[0]) |
+                                            static_cast<uint32_t>(data[1]) << 8U |
+                                            static_cast<uint32_t>(data[2]) << 16U |
+                                            static_cast<uint32_t>(data[3]) << 24U);
+                crc = t[7][one & 0xffU] ^ t[6][(one >> 8U) & 0xffU] ^
+                      t[5][(one >> 16U) & 0xffU] ^ t[4][one >> 24U] ^
+                      t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+                data += 8;
+                size -= 8;
+            }
+            while (size > 0) {
+                crc = t[0][(crc ^ *data++) & 0xffU] ^ (crc >> 8U);
+                --size;
+            }
+            return crc;
+        }
+
+#if defined(__SSE4_2__) || defined(__ARM_FEATURE_CRC32)
+# define OSMIUM_CRC32C_HARDWARE
+
+        /**
+         * CRC32C using the CRC32 instructions of SSE 4.2 or ARMv8. Only
+         * available if the compiler is allowed to use those (for instance
+         * with -msse4.2 or -march=native).
+         */
+        inline uint32_t crc32c_hardware(uint32_t crc, const unsigned char* data, std::size_t size) noexcept {
+# if defined(__SSE4_2__) && defined(__x86_64__)
+            uint64_t crc64 = crc;
+            while (size >= 8) {
+                uint64_t value; // NOLINT(cppcoreguidelines-init-variables)
+                std::memcpy(&value, data, sizeof(value));
+                crc64 = _mm_crc32_u64(crc64, value);
+                data += 8;
+                size -= 8;
+            }
+            crc = static_cast<uint32_t>(crc64);
+# elif defined(__SSE4_2__)
+            while (size >= 4) {
+                uint32_t value; // NOLINT(cppcoreguidelines-init-variables)
+                std::memcpy(&value, data, sizeof(value));
+                crc = _mm_crc32_u32(crc, value);
+                data += 4;
+                size -= 4;
+            }
+# else
+            while (size >= 8) {
+                uint64_t value; // NOLINT(cppcoreguidelines-init-variables)
+                std::memcpy(&value, data, sizeof(value));
+                crc = __crc32cd(crc, value);
+                data += 8;
+                size -= 8;
+            }
+# endif
+            while (size > 0) {
+# if defined(__SSE4_2__)
+                crc = _mm_crc32_u8(crc, *data++);
+# else
+                crc = __crc32cb(crc, *data++);
+# endif
+                --size;
+            }
+            return crc;
+        }
+#elif defined(OSMIUM_HAS_TARGET_ATTRIBUTE)
+# define OSMIUM_CRC32C_DISPATCH
+
+        /**
+         * CRC32C using the CRC32 instruction of SSE 4.2. This is compiled
+         * even if the compiler is not allowed to use SSE 4.2 in general
+         * and is only called if the CPU supports it.
+         */
+        OSMIUM_TARGET_SSE4_2 inline uint32_t crc32c_sse4_2(uint32_t crc, const unsigned char* data, std::size_t size) noexcept {
+# if defined(__x86_64__)
+            uint64_t crc64 = crc;
+            while (size >= 8) {
+                uint64_t value; // NOLINT(cppcoreguidelines-init-variables)
+                std::memcpy(&value, data, sizeof(value));
+                crc64 = _mm_crc32_u64(crc64, value);
+                data += 8;
+                size -= 8;
+            }
+            crc = static_cast<uint32_t>(crc64);
+# else
+            while (size >= 4) {
+                uint32_t value; // NOLINT(cppcoreguidelines-init-variables)
+                std::memcpy(&value, data, sizeof(value));
+                crc = _mm_crc32_u32(crc, value);
+                data += 4;
+                size -= 4;
+            }
+# endif
+            while (size > 0) {
+                crc = _mm_crc32_u8(crc, *data++);
+                --size;
+            }
+            return crc;
+        }
+
+        using crc32c_func_type = uint32_t(uint32_t, const unsigned char*, std::size_t);
+
+        /**
+         * Select the CRC32C implementation for the CPU we are running on.
+         */
+        inline crc32c_func_type* crc32c_select(const osmium::util::simd_level max = osmium::util::get_simd_level()) noexcept {
+            return osmium::util::select_implementation<crc32c_func_type>({
+                {osmium::util::simd_level::sse4_2, crc32c_sse4_2},
+                {osmium::util::simd_level::none, crc32c_software}
+            }, max);
+        }
+#endif
+
+        inline uint32_t crc32c_update(uint32_t crc, const unsigned char* data, std::size_t size) noexcept {
+#if defined(OSMIUM_CRC32C_HARDWARE)
+            return crc32c_hardware(crc, data, size);
+#elif defined(OSMIUM_CRC32C_DISPATCH)
+            static crc32c_func_type* const func = crc32c_select();
+            return func(crc, data, size);
+#else
+            return crc32c_software(crc, data, size);
+#endif
+        }
+
+    } // namespace detail
+
+    /**
+     * This class is used together with the CRC class to implement a
+     * CRC32C (Castagnoli) checksum. It doesn't need any external library.
+     * If the compiler is allowed to use the CRC32 instructions of the CPU
+     * (SSE 4.2 on x86, for instance with -msse4.2, or the CRC extension
+     * on ARMv8), they are used. Otherwise, on x86 with GCC or clang, the
+     * SSE 4.2 version is selected at runtime if the CPU supports it (see
+     * osmium/util/cpu_features.hpp), else a table-driven implementation
+     * is used. All give the same results.
+     *
+     * Note that CRC32C gives different checksums than the CRC32 used by
+     * CRC_zlib and boost::crc_32_type.
+     *
+     * Usage:
+     *
+     * @code
+     * osmium::CRC<osmium::CRC_crc32c> crc32c;
+     * const osmium::Node& node = ...;
+     * crc32c.update(node);
+     * std::cout << crc32c().checksum() << '\n';
+     * @endcode
+     */
+    class CRC_crc32c {
+
+        uint32_t m_crc = 0xffffffffUL;
+
+    public:
+
+        void process_byte(const unsigned char byte) noexcept {
+            m_crc = detail::crc32c_update(m_crc, &byte, 1U);
+        }
+
+        void process_bytes(const void* buffer, std::size_t byte_count) noexcept {
+            m_crc = detail::crc32c_update(m_crc, static_cast<const unsigned char*>(buffer), byte_count);
+        }
+
+        uint32_t checksum() const noexcept {
+            return m_crc ^ 0xffffffffUL;
+        }
+
+    }; // class CRC_crc32c
+
+} // namespace osmium
+
+#endif // OSMIUM_OSM_CRC_CRC32C_HPP
@@ -55,6 +55,16 @@ namespace osmium {
             return subitem;
         }
 
+        template <typename TSubitem, typename TIter>
+        inline TSubitem* subitem_ptr_of_type(TIter it, const TIter& end) noexcept {
+            for (; it != end; ++it) {
+                if (TSubitem::is_compatible_to(it->type()) && !it->removed()) {
+                    return reinterpret_cast<TSubitem*>(&*it);
+                }
+            }
+            return nullptr;
+        }
+
     } // namespace detail
 
     /**
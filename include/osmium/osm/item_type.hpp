@@ -53,6 +53,8 @@ namespace osmium {
         tag_list                               = 0x11,
         way_node_list                          = 0x12,
         relation_member_list                   = 0x13,
+        bounding_box                           = 0x14,
+        compressed_way_node_list               = 0x15,
         relation_member_list_with_full_members = 0x23,
         outer_ring                             = 0x40,
         inner_ring                             = 0x41,
@@ -105,6 +107,10 @@ namespace osmium {
                 return item_type::way_node_list;
             case 'M':
                 return item_type::relation_member_list;
+            case 'B':
+                return item_type::bounding_box;
+            case 'C':
+                return item_type::compressed_way_node_list;
             case 'F':
                 return item_type::relation_member_list_with_full_members;
             case 'O':
@@ -137,6 +143,10 @@ namespace osmium {
                 return 'N';
             case item_type::relation_member_list:
                 return 'M';
+            case item_type::bounding_box:
+                return 'B';
+            case item_type::compressed_way_node_list:
+                return 'C';
             case item_type::relation_member_list_with_full_members:
                 return 'F';
             case item_type::outer_ring:
@@ -169,6 +179,10 @@ namespace osmium {
                 return "way_node_list";
             case item_type::relation_member_list:
                 return "relation_member_list";
+            case item_type::bounding_box:
+                return "bounding_box";
+            case item_type::compressed_way_node_list:
+                return "compressed_way_node_list";
             case item_type::relation_member_list_with_full_members:
                 return "relation_member_list_with_full_members";
             case item_type::outer_ring:
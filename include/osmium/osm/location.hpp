@@ -34,7 +34,9 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <functional>
@@ -173,14 +175,22 @@ namespace osmium {
                 scale += eresult * esign;
             }
 
+            static const std::array<int64_t, 19> powers_of_ten = {{
+                1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL,
+                10000000LL, 100000000LL, 1000000000LL, 10000000000LL,
+                100000000000LL, 1000000000000LL, 10000000000000LL,
+                100000000000000LL, 1000000000000000LL, 10000000000000000LL,
+                100000000000000000LL, 1000000000000000000LL
+            }};
+
             if (scale < 0) {
-                for (; scale < 0 && result > 0; ++scale) {
-                    result /= 10;
-                }
-            } else {
-                for (; scale > 0; --scale) {
-                    result *= 10;
+                result = scale < -18 ? 0 : result / powers_of_ten[static_cast<std::size_t>(-scale)];
+            } else if (result > 0) {
+                // A result overflowing here would be out of range anyway.
+                if (scale > 18 || result > std::numeric_limits<int64_t>::max() / powers_of_ten[static_cast<std::size_t>(scale)]) {
+                    throw invalid_location{std::string{"wrong format for coordinate: '"} + full + "'"};
                 }
+                result *= powers_of_ten[static_cast<std::size_t>(scale)];
             }
 
             result = (result + 5) / 10 * sign;
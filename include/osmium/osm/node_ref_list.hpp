@@ -38,13 +38,136 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node_ref.hpp>
+#include <osmium/util/endian.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <limits>
 
 namespace osmium {
 
+    namespace detail {
+
+        // Number of NodeRefs checked in one go. The results for a block
+        // are written into a byte array first and then packed into one
+        // bitmask word. Both loops are simple enough for the compiler to
+        // vectorize.
+        enum : std::size_t {
+            node_ref_block_size = 64
+        };
+
+        // Same check as Location::valid() on the raw coordinates.
+        struct location_is_valid {
+
+            bool operator()(const int32_t x, const int32_t y) const noexcept {
+                return (x >= -180 * static_cast<int32_t>(coordinate_precision)) &
+                       (x <=  180 * static_cast<int32_t>(coordinate_precision)) &
+                       (y >=  -90 * static_cast<int32_t>(coordinate_precision)) &
+                       (y <=   90 * static_cast<int32_t>(coordinate_precision));
+            }
+
+        }; // struct location_is_valid
+
+        // Same check as Box::contains() on the raw coordinates. Because
+        // the box is valid, this also means the location is valid.
+        struct location_is_in_box {
+
+            int32_t min_x;
+            int32_t min_y;
+            int32_t max_x;
+            int32_t max_y;
+
+            explicit location_is_in_box(const osmium::Box& box) noexcept :
+                min_x(box.bottom_left().x()),
+                min_y(box.bottom_left().y()),
+                max_x(box.top_right().x()),
+                max_y(box.top_right().y()) {
+                assert(box.valid());
+            }
+
+            bool operator()(const int32_t x, const int32_t y) const noexcept {
+                return (x >= min_x) & (x <= max_x) & (y >= min_y) & (y <= max_y);
+            }
+
+        }; // struct location_is_in_box
+
+        // Check up to node_ref_block_size NodeRefs and return a bitmask
+        // with bit i set if the predicate is true for node_refs[i].
+        template <typename TPredicate>
+        inline uint64_t node_ref_block_mask(const NodeRef* node_refs, const std::size_t count, const TPredicate& predicate) noexcept {
+            assert(count <= node_ref_block_size);
+            uint8_t results[node_ref_block_size] = {0};
+            for (std::size_t i = 0; i < count; ++i) {
+                results[i] = predicate(node_refs[i].x(), node_refs[i].y()) ? 1U : 0U;
+            }
+
+            uint64_t mask = 0;
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+            // Pack eight 0/1 bytes at a time into eight bits. The
+            // multiplication moves byte n to bit 56 + n without any
+            // carries.
+            for (std::size_t i = 0; i < count; i += 8) {
+                uint64_t bytes; // NOLINT(cppcoreguidelines-init-variables)
+                std::memcpy(&bytes, results + i, sizeof(bytes));
+                mask |= ((bytes * 0x0102040810204080ULL) >> 56U) << i;
+            }
+#else
+            for (std::size_t i = 0; i < count; ++i) {
+                mask |= static_cast<uint64_t>(results[i]) << i;
+            }
+#endif
+            return mask;
+        }
+
+        // Count the NodeRefs among the first count for which the
+        // predicate is true.
+        template <typename TPredicate>
+        inline std::size_t node_ref_block_count(const NodeRef* node_refs, const std::size_t count, const TPredicate& predicate) noexcept {
+            assert(count <= node_ref_block_size);
+            std::size_t matches = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                matches += predicate(node_refs[i].x(), node_refs[i].y()) ? 1U : 0U;
+            }
+            return matches;
+        }
+
+        // Write bitmask for all NodeRefs in [begin, end) into mask.
+        template <typename TPredicate>
+        inline void node_refs_mask(const NodeRef* begin, const NodeRef* end, uint64_t* mask, const TPredicate& predicate) noexcept {
+            while (begin != end) {
+                const auto count = std::min(static_cast<std::size_t>(end - begin), static_cast<std::size_t>(node_ref_block_size));
+                *mask++ = node_ref_block_mask(begin, count, predicate);
+                begin += count;
+            }
+        }
+
+        // Is the predicate true for all (or, if check_all is false, any)
+        // NodeRefs in [begin, end)? Each block is checked completely
+        // before deciding, that is much faster than returning early from
+        // a loop with unpredictable branches.
+        template <typename TPredicate>
+        inline bool node_refs_match(const NodeRef* begin, const NodeRef* end, const bool check_all, const TPredicate& predicate) noexcept {
+            while (begin != end) {
+                const auto count = std::min(static_cast<std::size_t>(end - begin), static_cast<std::size_t>(node_ref_block_size));
+                const auto matches = node_ref_block_count(begin, count, predicate);
+                if (check_all) {
+                    if (matches != count) {
+                        return false;
+                    }
+                } else if (matches != 0) {
+                    return true;
+                }
+                begin += count;
+            }
+            return check_all;
+        }
+
+    } // namespace detail
+
     /**
      * An ordered collection of NodeRef objects. Usually this is not
      * instantiated directly, but one of its subclasses are used.
@@ -188,13 +311,111 @@ namespace osmium {
          * Complexity: Linear in the number of elements.
          */
         osmium::Box envelope() const noexcept {
+            int32_t min_x = std::numeric_limits<int32_t>::max();
+            int32_t min_y = std::numeric_limits<int32_t>::max();
+            int32_t max_x = std::numeric_limits<int32_t>::min();
+            int32_t max_y = std::numeric_limits<int32_t>::min();
+
+            // Usually all locations are valid. Then the plain minimum and
+            // maximum, which the compiler can vectorize, is all we need.
+            for (const auto& node_ref : *this) {
+                min_x = std::min(min_x, node_ref.x());
+                min_y = std::min(min_y, node_ref.y());
+                max_x = std::max(max_x, node_ref.x());
+                max_y = std::max(max_y, node_ref.y());
+            }
+
             osmium::Box box;
+            const osmium::Location bottom_left{min_x, min_y};
+            const osmium::Location top_right{max_x, max_y};
+            if (bottom_left.valid() && top_right.valid()) {
+                box.extend(bottom_left);
+                box.extend(top_right);
+                return box;
+            }
+
+            // Empty list or some locations are invalid.
             for (const auto& node_ref : *this) {
                 box.extend(node_ref.location());
             }
             return box;
         }
 
+        /**
+         * The number of 64 bit words needed for a bitmask with one bit
+         * for each element. Use this to size the buffer given to
+         * valid_locations_mask() or locations_in_box_mask().
+         *
+         * Complexity: Constant.
+         */
+        size_type mask_size() const noexcept {
+            return (size() + detail::node_ref_block_size - 1) / detail::node_ref_block_size;
+        }
+
+        /**
+         * Set bit (n % 64) in word mask[n / 64] if the location of the
+         * n-th element is valid (see Location::valid()) and clear it
+         * otherwise. Unused bits in the last word are cleared.
+         *
+         * Complexity: Linear in the number of elements.
+         *
+         * @param mask Pointer to at least mask_size() words.
+         */
+        void valid_locations_mask(uint64_t* mask) const noexcept {
+            detail::node_refs_mask(cbegin(), cend(), mask, detail::location_is_valid{});
+        }
+
+        /**
+         * Set bit (n % 64) in word mask[n / 64] if the location of the
+         * n-th element is inside the box (see Box::contains()) and clear
+         * it otherwise. Invalid and undefined locations are never inside
+         * the box. Unused bits in the last word are cleared.
+         *
+         * Complexity: Linear in the number of elements.
+         *
+         * @pre @code box.valid() @endcode
+         *
+         * @param box The box to check against.
+         * @param mask Pointer to at least mask_size() words.
+         */
+        void locations_in_box_mask(const osmium::Box& box, uint64_t* mask) const noexcept {
+            detail::node_refs_mask(cbegin(), cend(), mask, detail::location_is_in_box{box});
+        }
+
+        /**
+         * Are the locations of all elements valid? Returns true for an
+         * empty collection.
+         *
+         * Complexity: Linear in the number of elements.
+         */
+        bool all_locations_valid() const noexcept {
+            return detail::node_refs_match(cbegin(), cend(), true, detail::location_is_valid{});
+        }
+
+        /**
+         * Is the location of at least one element inside the box? This
+         * is the usual check when extracting all ways touching a region.
+         *
+         * Complexity: Linear in the number of elements.
+         *
+         * @pre @code box.valid() @endcode
+         */
+        bool any_location_in(const osmium::Box& box) const noexcept {
+            return detail::node_refs_match(cbegin(), cend(), false, detail::location_is_in_box{box});
+        }
+
+        /**
+         * Are the locations of all elements inside the box? Returns true
+         * for an empty collection.
+         *
+         * Complexity: Linear in the number of elements.
+         *
+         * @pre @code box.valid() @endcode
+         */
+        bool all_locations_in(const osmium::Box& box) const noexcept {
+            return detail::node_refs_match(cbegin(), cend(), true, detail::location_is_in_box{box});
+        }
+
         /// Returns an iterator to the beginning.
         iterator begin() noexcept {
             return iterator(data() + sizeof(NodeRefList));
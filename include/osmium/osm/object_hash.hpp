@@ -0,0 +1,220 @@
+#ifndef OSMIUM_OSM_OBJECT_HASH_HPP
+#define OSMIUM_OSM_OBJECT_HASH_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/util/endian.hpp>
+#include <osmium/util/hash64.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace osmium {
+
+    /**
+     * @brief Bit field for the parts of an OSM object used in object_hash().
+     */
+    namespace object_hash_fields {
+
+        enum type : unsigned char {
+
+            nothing        = 0x00,
+            tags           = 0x01, ///< tags (keys, values, and their order)
+            location       = 0x02, ///< location of nodes
+            node_refs      = 0x04, ///< node IDs of ways and areas
+            node_locations = 0x08, ///< node locations of ways and areas (if set)
+            members        = 0x10, ///< relation members (type, ID, and role)
+            content        = 0x17, ///< everything but IDs, metadata, and node locations in ways
+            id             = 0x20, ///< ID of the object itself
+            visible        = 0x40, ///< visible flag
+            all            = 0x7f
+
+        }; // enum type
+
+        inline constexpr type operator|(const type lhs, const type rhs) noexcept {
+            return static_cast<type>(static_cast<unsigned char>(lhs) | static_cast<unsigned char>(rhs));
+        }
+
+        inline constexpr type operator&(const type lhs, const type rhs) noexcept {
+            return static_cast<type>(static_cast<unsigned char>(lhs) & static_cast<unsigned char>(rhs));
+        }
+
+        inline constexpr type operator~(const type value) noexcept {
+            return all & static_cast<type>(~static_cast<unsigned char>(value));
+        }
+
+    } // namespace object_hash_fields
+
+    namespace detail {
+
+        inline void hash_tags(osmium::Hash64& hash, const osmium::TagList& tags) noexcept {
+            // The keys and values are stored one after the other, each
+            // with its terminating 0-byte, so they can be hashed in one go.
+            const char* begin = nullptr;
+            const char* end = nullptr;
+            for (const auto& tag : tags) {
+                if (!begin) {
+                    begin = tag.key();
+                }
+                end = tag.value() + std::strlen(tag.value()) + 1;
+            }
+            const auto size = static_cast<std::size_t>(end - begin);
+            hash.update_int64(size);
+            if (size > 0) {
+                hash.update(begin, size);
+            }
+        }
+
+        inline void hash_node_refs(osmium::Hash64& hash, const osmium::NodeRefList& node_refs, const osmium::object_hash_fields::type fields) noexcept {
+            const bool refs = fields & osmium::object_hash_fields::node_refs;
+            const bool locations = fields & osmium::object_hash_fields::node_locations;
+            if (!refs && !locations) {
+                return;
+            }
+
+            hash.update_int64(node_refs.size());
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+            // The node refs are stored one after the other with the ID
+            // followed by the x and y coordinates and no padding, which is
+            // exactly what the loop below hashes.
+            static_assert(sizeof(NodeRef) == sizeof(int64_t) + 2 * sizeof(int32_t), "NodeRef must not contain padding");
+            if (refs && locations) {
+                if (!node_refs.empty()) {
+                    hash.update(node_refs.cbegin(), node_refs.size() * sizeof(NodeRef));
+                }
+                return;
+            }
+#endif
+            for (const auto& node_ref : node_refs) {
+                if (refs) {
+                    hash.update_int64(static_cast<uint64_t>(node_ref.ref()));
+                }
+                if (locations) {
+                    hash.update_int32(static_cast<uint32_t>(node_ref.x()));
+                    hash.update_int32(static_cast<uint32_t>(node_ref.y()));
+                }
+            }
+        }
+
+        inline void hash_members(osmium::Hash64& hash, const osmium::RelationMemberList& members) noexcept {
+            hash.update_int64(members.size());
+            for (const auto& member : members) {
+                hash.update_int64(static_cast<uint64_t>(member.ref()));
+                hash.update_int32(static_cast<uint32_t>(member.type()));
+                hash.update(member.role(), std::strlen(member.role()) + 1);
+            }
+        }
+
+    } // namespace detail
+
+    /**
+     * Calculate a fast 64-bit hash (see Hash64) of the content of an OSM
+     * object. Which parts of the object are used can be set with the
+     * fields parameter, by default this is everything but the ID, the
+     * metadata (version, timestamp, changeset, user), and node locations
+     * in ways, so two objects with the same hash very likely have the
+     * same content. The type of the object is always used. Objects
+     * which differ only in the order of their tags get different
+     * hashes.
+     *
+     * This can be used for finding changed objects between two files
+     * by comparing hashes instead of whole objects.
+     *
+     * @param object The object.
+     * @param fields Bit field with the parts of the object to use.
+     * @param seed Seed for the hash function.
+     */
+    inline uint64_t object_hash(const osmium::OSMObject& object,
+                                const osmium::object_hash_fields::type fields = osmium::object_hash_fields::content,
+                                const uint64_t seed = 0) noexcept {
+        osmium::Hash64 hash{seed};
+
+        hash.update_int32(static_cast<uint32_t>(object.type()));
+
+        if (fields & osmium::object_hash_fields::id) {
+            hash.update_int64(static_cast<uint64_t>(object.id()));
+        }
+
+        if (fields & osmium::object_hash_fields::visible) {
+            hash.update_int32(object.visible() ? 1 : 0);
+        }
+
+        if (fields & osmium::object_hash_fields::tags) {
+            detail::hash_tags(hash, object.tags());
+        }
+
+        switch (object.type()) {
+            case osmium::item_type::node:
+                if (fields & osmium::object_hash_fields::location) {
+                    const auto& location = static_cast<const osmium::Node&>(object).location();
+                    hash.update_int32(static_cast<uint32_t>(location.x()));
+                    hash.update_int32(static_cast<uint32_t>(location.y()));
+                }
+                break;
+            case osmium::item_type::way:
+                detail::hash_node_refs(hash, static_cast<const osmium::Way&>(object).nodes(), fields);
+                break;
+            case osmium::item_type::relation:
+                if (fields & osmium::object_hash_fields::members) {
+                    detail::hash_members(hash, static_cast<const osmium::Relation&>(object).members());
+                }
+                break;
+            case osmium::item_type::area:
+                for (const auto& item : static_cast<const osmium::Area&>(object)) {
+                    if (item.type() == osmium::item_type::outer_ring ||
+                        item.type() == osmium::item_type::inner_ring) {
+                        hash.update_int32(static_cast<uint32_t>(item.type()));
+                        detail::hash_node_refs(hash, static_cast<const osmium::NodeRefList&>(item), fields);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+
+        return hash.digest();
+    }
+
+} // namespace osmium
+
+#endif // OSMIUM_OSM_OBJECT_HASH_HPP
@@ -42,6 +42,8 @@ DEALINGS IN THE SOFTWARE.
 #include <cstring>
 #include <iosfwd>
 #include <iterator>
+#include <string>
+#include <vector>
 
 namespace osmium {
 
@@ -116,9 +118,31 @@ namespace osmium {
         return out << tag.key() << '=' << tag.value();
     }
 
+    namespace detail {
+
+        inline bool tag_key_less(const Tag& lhs, const Tag& rhs) noexcept {
+            return std::strcmp(lhs.key(), rhs.key()) < 0;
+        }
+
+    } // namespace detail
+
     class TagList : public osmium::memory::Collection<Tag, osmium::item_type::tag_list> {
 
         const_iterator find_key(const char* key) const noexcept {
+            if (sorted_by_key()) {
+                // The tags are sorted, so we can stop as soon as we are
+                // past the place where the key would be.
+                for (auto it = cbegin(); it != cend(); ++it) {
+                    const auto c = std::strcmp(it->key(), key);
+                    if (c == 0) {
+                        return it;
+                    }
+                    if (c > 0) {
+                        break;
+                    }
+                }
+                return cend();
+            }
             return std::find_if(cbegin(), cend(), [key](const Tag& tag) {
                 return !std::strcmp(tag.key(), key);
             });
@@ -128,6 +152,51 @@ namespace osmium {
 
         TagList() noexcept = default;
 
+        /**
+         * Are the tags in this list known to be sorted by key? This is
+         * set by sort_by_key() and kept when the tag list is copied.
+         * Lookups in sorted tag lists can stop early.
+         *
+         * Complexity: Constant.
+         */
+        bool sorted_by_key() const noexcept {
+            return sorted_flag();
+        }
+
+        /**
+         * Sort the tags in this list by key (the order of tags with the
+         * same key is kept) and mark the list as sorted. The tags are
+         * rearranged in place, the size of the list doesn't change.
+         *
+         * When used from a TagListBuilder, this must be called after the
+         * last tag was added.
+         *
+         * Complexity: O(n log n) with n the number of tags, if the tags
+         *             are not sorted already.
+         */
+        void sort_by_key() {
+            if (!std::is_sorted(cbegin(), cend(), detail::tag_key_less)) {
+                std::vector<const Tag*> tags;
+                for (const auto& tag : *this) {
+                    tags.push_back(&tag);
+                }
+                std::stable_sort(tags.begin(), tags.end(), [](const Tag* lhs, const Tag* rhs) {
+                    return detail::tag_key_less(*lhs, *rhs);
+                });
+
+                std::string sorted_data;
+                sorted_data.reserve(byte_size() - sizeof(TagList));
+                for (const auto* tag : tags) {
+                    sorted_data.append(tag->key());
+                    sorted_data += '\0';
+                    sorted_data.append(tag->value());
+                    sorted_data += '\0';
+                }
+                std::copy(sorted_data.cbegin(), sorted_data.cend(), data() + sizeof(TagList));
+            }
+            set_sorted_flag(true);
+        }
+
         /**
          * Get tag value for the given tag key. If the key is not set, returns
          * the default_value.
@@ -79,56 +79,69 @@ namespace osmium {
             out += static_cast<char>('0' + value);
         }
 
+        /**
+         * Number of days between 1970-01-01 and the given date in the
+         * (proleptic) Gregorian calendar. Works for all years >= 0. This
+         * is the days_from_civil() algorithm from Howard Hinnant's
+         * "chrono-Compatible Low-Level Date Algorithms".
+         */
+        inline int64_t days_from_civil(int year, int month, int day) noexcept {
+            assert(year >= 0 && month >= 1 && month <= 12);
+            // Years start in March, so the leap day is at the end.
+            const int y = year - (month <= 2);
+            const int era = y / 400;
+            const int yoe = y - era * 400;
+            const int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+            const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+            return static_cast<int64_t>(era) * 146097 + doe - 719468;
+        }
+
+        inline bool is_digit(char c) noexcept {
+            return static_cast<unsigned char>(c - '0') < 10;
+        }
+
+        inline int two_digits(const char* str) noexcept {
+            return (str[0] - '0') * 10 + (str[1] - '0');
+        }
+
         inline time_t parse_timestamp(const char* str) {
             static const std::array<int, 12> mon_lengths = {{
                 31, 29, 31, 30, 31, 30,
                 31, 31, 30, 31, 30, 31
             }};
 
-            if (str[ 0] >= '0' && str[ 0] <= '9' &&
-                str[ 1] >= '0' && str[ 1] <= '9' &&
-                str[ 2] >= '0' && str[ 2] <= '9' &&
-                str[ 3] >= '0' && str[ 3] <= '9' &&
+            // The input can end anywhere, so the characters have to be
+            // checked in order and each check must only be done if all
+            // previous ones succeeded.
+            if (is_digit(str[ 0]) && is_digit(str[ 1]) &&
+                is_digit(str[ 2]) && is_digit(str[ 3]) &&
                 str[ 4] == '-' &&
-                str[ 5] >= '0' && str[ 5] <= '9' &&
-                str[ 6] >= '0' && str[ 6] <= '9' &&
+                is_digit(str[ 5]) && is_digit(str[ 6]) &&
                 str[ 7] == '-' &&
-                str[ 8] >= '0' && str[ 8] <= '9' &&
-                str[ 9] >= '0' && str[ 9] <= '9' &&
+                is_digit(str[ 8]) && is_digit(str[ 9]) &&
                 str[10] == 'T' &&
-                str[11] >= '0' && str[11] <= '9' &&
-                str[12] >= '0' && str[12] <= '9' &&
+                is_digit(str[11]) && is_digit(str[12]) &&
                 str[13] == ':' &&
-                str[14] >= '0' && str[14] <= '9' &&
-                str[15] >= '0' && str[15] <= '9' &&
+                is_digit(str[14]) && is_digit(str[15]) &&
                 str[16] == ':' &&
-                str[17] >= '0' && str[17] <= '9' &&
-                str[18] >= '0' && str[18] <= '9' &&
+                is_digit(str[17]) && is_digit(str[18]) &&
                 str[19] == 'Z') {
-                std::tm tm; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
-                tm.tm_year = (str[ 0] - '0') * 1000 +
-                             (str[ 1] - '0') *  100 +
-                             (str[ 2] - '0') *   10 +
-                             (str[ 3] - '0')        - 1900;
-                tm.tm_mon  = (str[ 5] - '0') * 10 + (str[ 6] - '0') - 1;
-                tm.tm_mday = (str[ 8] - '0') * 10 + (str[ 9] - '0');
-                tm.tm_hour = (str[11] - '0') * 10 + (str[12] - '0');
-                tm.tm_min  = (str[14] - '0') * 10 + (str[15] - '0');
-                tm.tm_sec  = (str[17] - '0') * 10 + (str[18] - '0');
-                tm.tm_wday = 0;
-                tm.tm_yday = 0;
-                tm.tm_isdst = 0;
-                if (tm.tm_year >= 0 &&
-                    tm.tm_mon  >= 0 && tm.tm_mon  <= 11 &&
-                    tm.tm_mday >= 1 && tm.tm_mday <= mon_lengths[tm.tm_mon] &&
-                    tm.tm_hour >= 0 && tm.tm_hour <= 23 &&
-                    tm.tm_min  >= 0 && tm.tm_min  <= 59 &&
-                    tm.tm_sec  >= 0 && tm.tm_sec  <= 60) {
-#ifndef _WIN32
-                    return timegm(&tm);
-#else
-                    return _mkgmtime(&tm);
-#endif
+                const int year   = two_digits(str) * 100 + two_digits(str + 2);
+                const int month  = two_digits(str +  5);
+                const int day    = two_digits(str +  8);
+                const int hour   = two_digits(str + 11);
+                const int minute = two_digits(str + 14);
+                const int second = two_digits(str + 17);
+                if (year >= 1900 &&
+                    month >= 1 && month <= 12 &&
+                    day >= 1 && day <= mon_lengths[month - 1] &&
+                    hour <= 23 && minute <= 59 && second <= 60) {
+                    // Same result as timegm(), but without the overhead
+                    // of the library call. Invalid days like Feb 29 in
+                    // non-leap years and leap seconds roll over into the
+                    // next month/minute as they do with timegm().
+                    return static_cast<time_t>(days_from_civil(year, month, day) * 86400 +
+                                               hour * 3600 + minute * 60 + second);
                 }
             }
             throw std::invalid_argument{std::string{"can not parse timestamp: '"} + str + "'"};
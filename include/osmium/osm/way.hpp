@@ -35,7 +35,9 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/memory/collection.hpp>
 #include <osmium/memory/item.hpp>
+#include <osmium/osm/bounding_box.hpp>
 #include <osmium/osm/box.hpp>
+#include <osmium/osm/compressed_way_node_list.hpp>
 #include <osmium/osm/entity.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/node_ref.hpp>
@@ -144,13 +146,50 @@ namespace osmium {
             return nodes().ends_have_same_location();
         }
 
+        /**
+         * Get the bounding box subitem of this way.
+         *
+         * @returns Pointer to the bounding box or nullptr if there is none.
+         */
+        osmium::BoundingBox* bounding_box() noexcept {
+            return osmium::detail::subitem_ptr_of_type<osmium::BoundingBox>(begin(), end());
+        }
+
+        /**
+         * Get the bounding box subitem of this way.
+         *
+         * @returns Pointer to the bounding box or nullptr if there is none.
+         */
+        const osmium::BoundingBox* bounding_box() const noexcept {
+            return osmium::detail::subitem_ptr_of_type<const osmium::BoundingBox>(cbegin(), cend());
+        }
+
+        /**
+         * Get the compressed node list of this way. Ways usually have a
+         * WayNodeList which is accessed through nodes(), but ways stored
+         * in compact form have a CompressedWayNodeList instead. In that
+         * case nodes() returns an empty list.
+         *
+         * @returns Pointer to the compressed node list or nullptr if
+         *          there is none.
+         */
+        const osmium::CompressedWayNodeList* compressed_nodes() const noexcept {
+            return osmium::detail::subitem_ptr_of_type<const osmium::CompressedWayNodeList>(cbegin(), cend());
+        }
+
         /**
          * Calculate the envelope of this way. If the locations of the nodes
-         * are not set, the resulting box will be invalid.
+         * are not set, the resulting box will be invalid. If the way has a
+         * valid bounding box subitem, it is returned instead.
          *
-         * Complexity: Linear in the number of nodes.
+         * Complexity: Constant if there is a bounding box, linear in the
+         *             number of nodes otherwise.
          */
         osmium::Box envelope() const noexcept {
+            const auto* bbox = bounding_box();
+            if (bbox && bbox->box().valid()) {
+                return bbox->box();
+            }
             return nodes().envelope();
         }
 
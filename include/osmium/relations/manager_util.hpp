@@ -36,10 +36,12 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/fwd.hpp>
 #include <osmium/handler.hpp>
 #include <osmium/handler/check_order.hpp>
+#include <osmium/io/decoded_buffer_callback.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/reader.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/relation.hpp>
 #include <osmium/util/progress_bar.hpp>
 #include <osmium/visitor.hpp>
 
@@ -103,6 +105,83 @@ namespace osmium {
 
         }; // class SecondPassHandler
 
+        /**
+         * This is a handler class used for reading data in a single pass
+         * with relation managers. It can only be used with input where all
+         * relations come before all nodes and ways, for instance when the
+         * relations were written to the start of the file or are read from
+         * a separate file before the rest of the data.
+         *
+         * The relations are added to the manager as in the first pass.
+         * Before the first node or way, prepare_for_lookup() is called on
+         * the manager, after that the data is handled as in the second
+         * pass. Member objects are removed from the manager as soon as all
+         * relations they are needed for are complete.
+         *
+         * This can not be used with managers interested in member
+         * relations, because the relations would be needed in both passes.
+         *
+         * @tparam TManager The manager we want to call functions on.
+         */
+        template <typename TManager>
+        class SinglePassHandler : public osmium::handler::Handler {
+
+            TManager& m_manager;
+            bool m_lookup_prepared = false;
+
+            void prepare_for_lookup() {
+                if (!m_lookup_prepared) {
+                    m_manager.prepare_for_lookup();
+                    m_lookup_prepared = true;
+                }
+            }
+
+        public:
+
+            explicit SinglePassHandler(TManager& manager) noexcept :
+                m_manager(manager) {
+            }
+
+            /**
+             * Overwrites the function in the handler parent class.
+             */
+            void node(const osmium::Node& node) {
+                prepare_for_lookup();
+                m_manager.handle_node(node);
+            }
+
+            /**
+             * Overwrites the function in the handler parent class.
+             */
+            void way(const osmium::Way& way) {
+                prepare_for_lookup();
+                m_manager.handle_way(way);
+            }
+
+            /**
+             * Overwrites the function in the handler parent class.
+             *
+             * @throws out_of_order_error If the relation comes after a node
+             *         or way.
+             */
+            void relation(const osmium::Relation& relation) {
+                if (m_lookup_prepared) {
+                    throw out_of_order_error{"relation after node or way in single pass input", relation.id()};
+                }
+                m_manager.relation(relation);
+            }
+
+            /**
+             * Overwrites the function in the handler parent class.
+             *
+             * Calls the flush_output() function on the manager.
+             */
+            void flush() {
+                m_manager.flush_output();
+            }
+
+        }; // class SinglePassHandler
+
         /**
          * Read relations from file and feed them into all the managers
          * specified as parameters. Opens an osmium::io::Reader internally
@@ -126,6 +205,38 @@ namespace osmium {
             (void)std::initializer_list<int>{(managers.prepare_for_lookup(), 0)...};
         }
 
+        /**
+         * Read relations from file and feed them into the manager. Unlike
+         * read_relations() this calls the new_relation() and new_member()
+         * functions of the manager in the threads decoding the input (see
+         * RelationsManager::prefilter_relations()), so they must be
+         * thread-safe. The thread reading the data only has to store the
+         * relations that are kept. For PBF files, where decoding runs in
+         * parallel, this is much faster if many relations are filtered
+         * out.
+         *
+         * After the file is read, the prepare_for_lookup() function is
+         * called on the manager.
+         *
+         * @tparam TManager Relations manager type.
+         * @param file The file that should be opened with an osmium::io::Reader.
+         * @param manager Relations manager we want the relations to be sent
+         *                to.
+         */
+        template <typename TManager>
+        void read_relations_prefiltered(const osmium::io::File& file, TManager& manager) {
+            osmium::io::Reader reader{file, osmium::osm_entity_bits::relation, osmium::io::decoded_buffer_callback{[&manager](osmium::memory::Buffer& buffer) {
+                manager.prefilter_relations(buffer);
+            }}};
+            while (auto buffer = reader.read()) {
+                for (const auto& relation : buffer.select<osmium::Relation>()) {
+                    manager.add_prefiltered_relation(relation);
+                }
+            }
+            reader.close();
+            manager.prepare_for_lookup();
+        }
+
         /**
          * Read relations from file and feed them into all the managers
          * specified as parameters. Opens an osmium::io::Reader internally
@@ -163,6 +274,12 @@ namespace osmium {
             std::size_t relations_db;
             std::size_t members_db;
             std::size_t stash;
+
+            /// Largest memory used by the stash items so far.
+            std::size_t stash_peak;
+
+            /// Disk space used by stash segments spilled to disk.
+            std::size_t stash_disk;
         };
 
         /**
@@ -183,6 +300,8 @@ namespace osmium {
                    << "  members:   " << std::setw(8) << (mu.members_db   / 1024) << " kB\n"
                    << "  stash:     " << std::setw(8) << (mu.stash        / 1024) << " kB\n"
                    << "  total:     " << std::setw(8) << (total           / 1024) << " kB\n"
+                   << "  stash peak:" << std::setw(8) << (mu.stash_peak   / 1024) << " kB\n"
+                   << "  stash disk:" << std::setw(8) << (mu.stash_disk   / 1024) << " kB\n"
                    << "  ======================\n";
         }
 
@@ -33,9 +33,14 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
 #include <osmium/osm/object.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
 #include <osmium/relations/relations_database.hpp>
 #include <osmium/storage/item_stash.hpp>
 #include <osmium/util/iterator.hpp>
@@ -44,14 +49,63 @@ DEALINGS IN THE SOFTWARE.
 #include <cassert>
 #include <cstddef>
 #include <limits>
+#include <memory>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace osmium {
 
     namespace relations {
 
+        namespace detail {
+
+            // Add copies of objects without tags and metadata (except id,
+            // version, and visible flag) to the buffer. Way nodes are
+            // stored in a CompressedWayNodeList if compress_way_nodes is
+            // set.
+
+            inline void add_lean_copy(osmium::memory::Buffer& buffer, const osmium::Node& node, bool /*compress_way_nodes*/) {
+                {
+                    osmium::builder::NodeBuilder builder{buffer};
+                    builder.set_id(node.id())
+                           .set_version(node.version())
+                           .set_visible(node.visible())
+                           .set_location(node.location());
+                }
+                buffer.commit();
+            }
+
+            inline void add_lean_copy(osmium::memory::Buffer& buffer, const osmium::Way& way, bool compress_way_nodes) {
+                {
+                    osmium::builder::WayBuilder builder{buffer};
+                    builder.set_id(way.id())
+                           .set_version(way.version())
+                           .set_visible(way.visible());
+                    if (compress_way_nodes) {
+                        osmium::builder::CompressedWayNodeListBuilder nodes_builder{builder};
+                        nodes_builder.add_node_refs(way.nodes().cbegin(), way.nodes().cend());
+                    } else {
+                        builder.add_item(way.nodes());
+                    }
+                }
+                buffer.commit();
+            }
+
+            inline void add_lean_copy(osmium::memory::Buffer& buffer, const osmium::Relation& relation, bool /*compress_way_nodes*/) {
+                {
+                    osmium::builder::RelationBuilder builder{buffer};
+                    builder.set_id(relation.id())
+                           .set_version(relation.version())
+                           .set_visible(relation.visible());
+                    builder.add_item(relation.members());
+                }
+                buffer.commit();
+            }
+
+        } // namespace detail
+
         /**
          * This is the parent class for the MembersDatabase class. All the
          * functionality which doesn't depend on the template parameter used
@@ -137,11 +191,28 @@ namespace osmium {
 
             std::vector<element> m_elements{};
 
+            // Optional bitmap of the ids of all tracked members with
+            // non-negative ids. Checked before the binary search in
+            // m_elements, because most objects are not members at all.
+            std::unique_ptr<osmium::index::IdSetDense<osmium::unsigned_object_id_type>> m_member_ids{};
+
+            bool maybe_member(osmium::object_id_type id) const noexcept {
+                return !m_member_ids || id < 0 ||
+                       m_member_ids->get(static_cast<osmium::unsigned_object_id_type>(id));
+            }
+
         protected:
 
             osmium::ItemStash& m_stash;
             osmium::relations::RelationsDatabase& m_relations_db;
 
+            // Buffer for lean copies of objects if use_lean_storage() was
+            // called.
+            std::unique_ptr<osmium::memory::Buffer> m_lean_buffer{};
+
+            // Store way nodes in compressed form in lean copies.
+            bool m_compress_way_nodes = false;
+
 #ifndef NDEBUG
             // This is used only in debug builds to make sure the
             // prepare_for_lookup() function is called at the right place.
@@ -152,10 +223,16 @@ namespace osmium {
             using const_iterator = std::vector<element>::const_iterator;
 
             iterator_range<iterator> find(osmium::object_id_type id) {
+                if (!maybe_member(id)) {
+                    return make_range(std::make_pair(m_elements.end(), m_elements.end()));
+                }
                 return make_range(std::equal_range(m_elements.begin(), m_elements.end(), element{id}, compare_member_id{}));
             }
 
             iterator_range<const_iterator> find(osmium::object_id_type id) const {
+                if (!maybe_member(id)) {
+                    return make_range(std::make_pair(m_elements.cend(), m_elements.cend()));
+                }
                 return make_range(std::equal_range(m_elements.cbegin(), m_elements.cend(), element{id}, compare_member_id{}));
             }
 
@@ -186,9 +263,61 @@ namespace osmium {
              */
             std::size_t used_memory() const noexcept {
                 return sizeof(element) * m_elements.capacity() +
+                       (m_member_ids ? m_member_ids->used_memory() : 0) +
                        sizeof(MembersDatabaseCommon);
             }
 
+            /**
+             * Store only the parts of member objects needed for building
+             * geometries: the id, version, and visible flag plus the
+             * location for nodes, the node references for ways, and the
+             * members for relations. Tags, the user name, and all other
+             * metadata are not stored. This reduces the memory needed for
+             * the stash considerably if the members are only used for
+             * their geometry.
+             */
+            void use_lean_storage() {
+                m_lean_buffer.reset(new osmium::memory::Buffer{1024, osmium::memory::Buffer::auto_grow::yes});
+            }
+
+            /**
+             * Like use_lean_storage(), but also store the nodes of ways
+             * in a CompressedWayNodeList instead of a WayNodeList. This
+             * needs 3 to 4 times less memory for the node references.
+             * The member ways will then have an empty nodes() list, use
+             * Way::compressed_nodes() to access the nodes. The area
+             * Assembler and the GeometryFactory handle these ways
+             * directly.
+             */
+            void use_compressed_way_nodes() {
+                use_lean_storage();
+                m_compress_way_nodes = true;
+            }
+
+            /// Is use_compressed_way_nodes() enabled?
+            bool uses_compressed_way_nodes() const noexcept {
+                return m_compress_way_nodes;
+            }
+
+            /// Is use_lean_storage() enabled?
+            bool uses_lean_storage() const noexcept {
+                return m_lean_buffer != nullptr;
+            }
+
+            /**
+             * Check the ids of objects against a bitmap of the ids of all
+             * tracked members before looking them up in the database. This
+             * makes lookups of objects that are not members much faster.
+             * The bitmap needs one bit for each id in the range of ids of
+             * the members (allocated in chunks of 4 MB), so this makes
+             * most sense if the members are dense in the id space or the
+             * ids are not too large. Call this before prepare_for_lookup().
+             */
+            void use_member_ids_filter() {
+                assert(m_init_phase && "Call MembersDatabase::use_member_ids_filter() before MembersDatabase::prepare_for_lookup().");
+                m_member_ids.reset(new osmium::index::IdSetDense<osmium::unsigned_object_id_type>{});
+            }
+
             /**
              * The number of members tracked in the database. Includes
              * members tracked, but not found yet, members found and members
@@ -259,11 +388,34 @@ namespace osmium {
             void prepare_for_lookup() {
                 assert(m_init_phase && "Can not call MembersDatabase::prepare_for_lookup() twice.");
                 std::sort(m_elements.begin(), m_elements.end());
+                if (m_member_ids) {
+                    for (const auto& elem : m_elements) {
+                        if (elem.member_id >= 0) {
+                            m_member_ids->set(static_cast<osmium::unsigned_object_id_type>(elem.member_id));
+                        }
+                    }
+                }
 #ifndef NDEBUG
                 m_init_phase = false;
 #endif
             }
 
+            /**
+             * Is any object with an id in the range [first, last] tracked
+             * as a member? Members found and removed already are counted,
+             * too, so this is meant for deciding which parts of the input
+             * the second pass has to look at.
+             *
+             * @pre You have to call prepare_for_lookup() before using this.
+             *
+             * Complexity: Logarithmic in the number of members tracked.
+             */
+            bool has_member_in_range(osmium::object_id_type first, osmium::object_id_type last) const {
+                assert(!m_init_phase && "Call MembersDatabase::prepare_for_lookup() before MembersDatabase::has_member_in_range().");
+                const auto it = std::lower_bound(m_elements.cbegin(), m_elements.cend(), element{first}, compare_member_id{});
+                return it != m_elements.cend() && it->member_id <= last;
+            }
+
             /**
              * Remove the entry with the specified member_id and relation_id
              * from the database. If the entry doesn't exist, nothing happens.
@@ -373,7 +525,13 @@ namespace osmium {
 
                 // At least one relation needs this object. Store it and
                 // "tell" all relations.
-                add_object(object, range);
+                if (m_lean_buffer) {
+                    m_lean_buffer->clear();
+                    detail::add_lean_copy(*m_lean_buffer, object, m_compress_way_nodes);
+                    add_object(m_lean_buffer->get<TObject>(0), range);
+                } else {
+                    add_object(object, range);
+                }
 
                 for (auto& elem : range) {
                     assert(!elem.is_removed());
@@ -0,0 +1,218 @@
+#ifndef OSMIUM_RELATIONS_PBF_TWO_PASS_HPP
+#define OSMIUM_RELATIONS_PBF_TWO_PASS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to run relations managers on an
+ * (uncompressed) PBF file, decoding only the parts of the file that are
+ * needed in the second pass.
+ *
+ * @attention If you include this file, you'll need to link with
+ *            `libz`.
+ */
+
+#include <osmium/io/indexed_pbf_reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/relations/manager_util.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <initializer_list>
+#include <vector>
+
+namespace osmium {
+
+    namespace relations {
+
+        namespace detail {
+
+            // The types of objects in the blob the managers need in the
+            // second pass.
+            template <typename... TManager>
+            osmium::osm_entity_bits::type entities_needed(const osmium::io::pbf_blob_summary& summary, const TManager&... managers) {
+                osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nothing;
+                for (unsigned int n = 0; n < 3; ++n) {
+                    const auto type = osmium::nwr_index_to_item_type(n);
+                    const auto bit = osmium::osm_entity_bits::from_item_type(type);
+                    if (!(summary.types & bit)) {
+                        continue;
+                    }
+                    for (const bool needed : {managers.second_pass_needs(type, summary.min_id[n], summary.max_id[n])...}) {
+                        if (needed) {
+                            entities |= bit;
+                            break;
+                        }
+                    }
+                }
+                return entities;
+            }
+
+            // Like osmium::apply(), but without calling flush() on the
+            // handlers.
+            template <typename... THandler>
+            void apply_without_flush(const osmium::memory::Buffer& buffer, THandler&&... handlers) {
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    osmium::apply_item(object, handlers...);
+                }
+            }
+
+        } // namespace detail
+
+        /**
+         * First pass of the relations managers on a PBF file: Read all
+         * relations from the file and feed them into all the managers.
+         * Only data blobs containing relations are decoded.
+         *
+         * This needs the blob summaries of the IndexedPBFReader. If they
+         * are not in the sidecar index file, all blobs are decoded once
+         * to create them (and the index file).
+         *
+         * After the file is read, the prepare_for_lookup() function is
+         * called on all the managers.
+         *
+         * @param reader The IndexedPBFReader for the file.
+         * @param managers Relations managers the relations are sent to.
+         */
+        template <typename... TManager>
+        void read_relations(osmium::io::IndexedPBFReader& reader, TManager&... managers) {
+            static_assert(sizeof...(TManager) > 0, "Need at least one manager as parameter.");
+            const auto& summaries = reader.summaries();
+            for (std::size_t n = 0; n < summaries.size(); ++n) {
+                if (summaries[n].types & osmium::osm_entity_bits::relation) {
+                    const auto buffer = reader.read_blob(n, osmium::osm_entity_bits::relation);
+                    osmium::apply(buffer, managers...);
+                }
+            }
+            (void)std::initializer_list<int>{(managers.prepare_for_lookup(), 0)...};
+        }
+
+        /**
+         * Get the indexes of all data blobs the managers need in the
+         * second pass. See RelationsManager::second_pass_needs() for
+         * details.
+         *
+         * @pre The first pass must be done.
+         */
+        template <typename... TManager>
+        std::vector<std::size_t> find_member_blobs(osmium::io::IndexedPBFReader& reader, const TManager&... managers) {
+            static_assert(sizeof...(TManager) > 0, "Need at least one manager as parameter.");
+            std::vector<std::size_t> result;
+            const auto& summaries = reader.summaries();
+            for (std::size_t n = 0; n < summaries.size(); ++n) {
+                if (detail::entities_needed(summaries[n], managers...) != osmium::osm_entity_bits::nothing) {
+                    result.push_back(n);
+                }
+            }
+            return result;
+        }
+
+        /**
+         * Second pass of the relations managers on a PBF file. Only the
+         * data blobs which can contain objects the managers need are
+         * decoded, and only the object types needed from them. The
+         * blobs are decoded in the thread pool, the objects are handed to
+         * the managers in file order in the calling thread. The output of
+         * the managers is flushed at the end.
+         *
+         * Use this instead of applying the second pass handlers of the
+         * managers to all objects in the file. For managers interested
+         * only in a few relations (boundaries, routes, etc.) this reads
+         * only a small part of the file.
+         *
+         * @param pool The thread pool used for decoding.
+         * @param reader The IndexedPBFReader for the file.
+         * @param managers Relations managers.
+         *
+         * @pre The first pass must be done.
+         */
+        template <typename... TManager>
+        void read_members(osmium::thread::Pool& pool, osmium::io::IndexedPBFReader& reader, TManager&... managers) {
+            static_assert(sizeof...(TManager) > 0, "Need at least one manager as parameter.");
+
+            const auto& summaries = reader.summaries();
+            const auto max_pending = 2 * static_cast<std::size_t>(pool.num_threads());
+            std::deque<std::future<osmium::memory::Buffer>> pending;
+
+            try {
+                for (std::size_t n = 0; n < summaries.size(); ++n) {
+                    const auto entities = detail::entities_needed(summaries[n], managers...);
+                    if (entities == osmium::osm_entity_bits::nothing) {
+                        continue;
+                    }
+                    pending.push_back(pool.submit([&reader, n, entities]() {
+                        return reader.read_blob(n, entities);
+                    }));
+                    while (pending.size() > max_pending) {
+                        const auto buffer = pending.front().get();
+                        pending.pop_front();
+                        detail::apply_without_flush(buffer, SecondPassHandler<TManager>{managers}...);
+                    }
+                }
+                while (!pending.empty()) {
+                    const auto buffer = pending.front().get();
+                    pending.pop_front();
+                    detail::apply_without_flush(buffer, SecondPassHandler<TManager>{managers}...);
+                }
+            } catch (...) {
+                // The tasks use the reader, wait for them before leaving.
+                for (auto& future : pending) {
+                    future.wait();
+                }
+                throw;
+            }
+
+            (void)std::initializer_list<int>{(managers.flush_output(), 0)...};
+        }
+
+        /**
+         * Second pass of the relations managers on a PBF file using the
+         * default thread pool. See above.
+         */
+        template <typename... TManager>
+        void read_members(osmium::io::IndexedPBFReader& reader, TManager&... managers) {
+            read_members(osmium::thread::Pool::default_instance(), reader, managers...);
+        }
+
+    } // namespace relations
+
+} // namespace osmium
+
+#endif // OSMIUM_RELATIONS_PBF_TWO_PASS_HPP
@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/handler.hpp>
 #include <osmium/handler/check_order.hpp>
+#include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/callback_buffer.hpp>
 #include <osmium/osm/item_type.hpp>
@@ -54,6 +55,7 @@ DEALINGS IN THE SOFTWARE.
 #include <cstdint>
 #include <cstring>
 #include <stdexcept>
+#include <string>
 #include <type_traits>
 #include <vector>
 
@@ -97,6 +99,35 @@ namespace osmium {
                 m_member_relations_db(m_stash, m_relations_db) {
             }
 
+            /**
+             * Access the internal ItemStash holding all relations and
+             * members. Call ItemStash::use_segments() on it before reading
+             * any data to keep memory use bounded on very large inputs.
+             */
+            osmium::ItemStash& stash() noexcept {
+                return m_stash;
+            }
+
+            /**
+             * Keep the memory used for relations and members bounded by
+             * storing them in segments and moving the oldest segments into
+             * a temporary file when the segments in memory use more than
+             * the budget. Members are removed from the stash as soon as
+             * the last relation they are needed for is complete. Call this
+             * before reading any data. See ItemStash::use_segments() for
+             * details.
+             *
+             * @param memory_budget Maximum number of bytes of stash segments
+             *        kept in memory.
+             * @param spill_directory Directory for the temporary file.
+             * @param segment_size Size of each stash segment in bytes.
+             */
+            void use_memory_budget(std::size_t memory_budget,
+                                   const std::string& spill_directory = "",
+                                   std::size_t segment_size = osmium::ItemStash::default_segment_size) {
+                m_stash.use_segments(segment_size, memory_budget, spill_directory);
+            }
+
             /// Access the internal RelationsDatabase.
             osmium::relations::RelationsDatabase& relations_database() noexcept {
                 return m_relations_db;
@@ -251,7 +282,9 @@ namespace osmium {
                       m_member_nodes_db.used_memory()
                     + m_member_ways_db.used_memory()
                     + m_member_relations_db.used_memory(),
-                    m_stash.used_memory()
+                    m_stash.used_memory(),
+                    m_stash.peak_memory(),
+                    m_stash.used_disk_space()
                 };
             }
 
@@ -265,9 +298,22 @@ namespace osmium {
                 m_output.set_callback(callback);
             }
 
-            /// Flush the output buffer.
+            /**
+             * Call the callback in a separate thread, so that the manager
+             * can go on assembling while the callback is handling the last
+             * full buffer. See CallbackBuffer::enable_async().
+             */
+            void enable_async_output(std::size_t max_buffers = osmium::memory::CallbackBuffer::default_max_async_buffers) {
+                m_output.enable_async(max_buffers);
+            }
+
+            /**
+             * Flush the output buffer. In async mode this waits until the
+             * callback has handled all buffers.
+             */
             void flush_output() {
                 m_output.flush();
+                m_output.wait();
             }
 
             /// Flush the output buffer if it is full.
@@ -282,6 +328,23 @@ namespace osmium {
 
         }; // class RelationsManagerBase
 
+        namespace detail {
+
+            template <typename T>
+            struct void_type {
+                using type = void;
+            };
+
+            template <typename T>
+            struct member_pointer_class;
+
+            template <typename T, typename C>
+            struct member_pointer_class<T C::*> {
+                using type = C;
+            };
+
+        } // namespace detail
+
         /**
          * This is a base class for RelationManager classes. It keeps track of
          * all interesting relations and all interesting members of those
@@ -308,14 +371,44 @@ namespace osmium {
 
             check_order_handler m_check_order_handler;
 
+            // Set if the input is known to be sorted, the order is not
+            // checked then.
+            bool m_input_is_sorted = false;
+
             SecondPassHandler<RelationsManager> m_handler_pass2;
 
+            SinglePassHandler<RelationsManager> m_handler_single_pass;
+
             static bool wanted_type(osmium::item_type type) noexcept {
                 return (TNodes     && type == osmium::item_type::node) ||
                        (TWays      && type == osmium::item_type::way) ||
                        (TRelations && type == osmium::item_type::relation);
             }
 
+            // Does the derived class have its own version of the hook
+            // function? If the expression is invalid, for instance because
+            // it has several overloads, we assume that it does. This is
+            // checked here and not outside the class, because the default
+            // hook functions are private.
+#define OSMIUM_RELATIONS_MANAGER_HAS_HOOK(hook) \
+            template <typename T, typename = void> \
+            struct has_##hook : std::true_type {}; \
+            template <typename T> \
+            struct has_##hook<T, typename detail::void_type<decltype(&T::hook)>::type> : \
+                std::integral_constant<bool, !std::is_same<typename detail::member_pointer_class<decltype(&T::hook)>::type, RelationsManager>::value> {};
+
+            OSMIUM_RELATIONS_MANAGER_HAS_HOOK(before_node)
+            OSMIUM_RELATIONS_MANAGER_HAS_HOOK(node_not_in_any_relation)
+            OSMIUM_RELATIONS_MANAGER_HAS_HOOK(after_node)
+            OSMIUM_RELATIONS_MANAGER_HAS_HOOK(before_way)
+            OSMIUM_RELATIONS_MANAGER_HAS_HOOK(way_not_in_any_relation)
+            OSMIUM_RELATIONS_MANAGER_HAS_HOOK(after_way)
+            OSMIUM_RELATIONS_MANAGER_HAS_HOOK(before_relation)
+            OSMIUM_RELATIONS_MANAGER_HAS_HOOK(relation_not_in_any_relation)
+            OSMIUM_RELATIONS_MANAGER_HAS_HOOK(after_relation)
+
+#undef OSMIUM_RELATIONS_MANAGER_HAS_HOOK
+
             /**
              * This method is called from the first pass handler for every
              * relation in the input, to check whether it should be kept.
@@ -442,6 +535,17 @@ namespace osmium {
             void after_relation(const osmium::Relation& /*relation*/) const noexcept {
             }
 
+            /**
+             * This method is called before the output buffer is flushed with
+             * flush_output() or read with read().
+             *
+             * Overwrite this method in a derived class if it creates output
+             * asynchronously and needs to add it to the output buffer
+             * before that.
+             */
+            void before_flush() const noexcept {
+            }
+
             TManager& derived() noexcept {
                 return *static_cast<TManager*>(this);
             }
@@ -464,7 +568,28 @@ namespace osmium {
             RelationsManager() :
                 RelationsManagerBase(),
                 m_check_order_handler(),
-                m_handler_pass2(*this) {
+                m_handler_pass2(*this),
+                m_handler_single_pass(*this) {
+            }
+
+            /**
+             * Tell the manager that the input of the second pass is known
+             * to be sorted, so that it doesn't have to check the order of
+             * the objects itself (if TCheckOrder is set).
+             */
+            void assume_sorted_input(bool sorted = true) noexcept {
+                m_input_is_sorted = sorted;
+            }
+
+            /**
+             * Skip the order checks if the header of the input for the
+             * second pass says that the input is sorted and this is
+             * verified by the Reader (see
+             * osmium::io::Header::sorted_and_verified() and the
+             * osmium::io::verify_sorting option of the Reader).
+             */
+            void assume_sorted_input(const osmium::io::Header& header) noexcept {
+                m_input_is_sorted = header.sorted_and_verified();
             }
 
             /**
@@ -475,6 +600,29 @@ namespace osmium {
                 return m_handler_pass2;
             }
 
+            /**
+             * Return reference to handler for reading all data in a single
+             * pass. This only works if all relations come before all other
+             * objects in the input. See SinglePassHandler for details.
+             */
+            SinglePassHandler<RelationsManager>& single_pass_handler(const std::function<void(osmium::memory::Buffer&&)>& callback = nullptr) {
+                static_assert(!TRelations, "Single pass handler can not be used with managers interested in member relations.");
+                set_callback(callback);
+                return m_handler_single_pass;
+            }
+
+            /// Flush the output buffer.
+            void flush_output() {
+                derived().before_flush();
+                RelationsManagerBase::flush_output();
+            }
+
+            /// Return the contents of the output buffer.
+            osmium::memory::Buffer read() {
+                derived().before_flush();
+                return RelationsManagerBase::read();
+            }
+
             /**
              * Add the specified relation to the list of relations we want to
              * build. This calls the new_relation() and new_member()
@@ -502,9 +650,70 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Decide which relations and members to keep for all relations
+             * in the buffer by calling the new_relation() and new_member()
+             * functions. Relations not wanted are removed from the buffer,
+             * members not wanted get the id 0. Other objects in the buffer
+             * are not changed. Add the relations left over with
+             * add_prefiltered_relation() afterwards.
+             *
+             * This is meant to be called from the Reader decoder threads
+             * through a osmium::io::decoded_buffer_callback (see
+             * read_relations_prefiltered()), so that the filtering is done
+             * in parallel. In that case new_relation() and new_member()
+             * must be thread-safe. The default ones and the ones in the
+             * MultipolygonManager are.
+             *
+             * @param buffer Buffer with the relations.
+             */
+            void prefilter_relations(osmium::memory::Buffer& buffer) {
+                bool removed = false;
+                for (auto& relation : buffer.select<osmium::Relation>()) {
+                    if (!derived().new_relation(relation)) {
+                        relation.set_removed(true);
+                        removed = true;
+                        continue;
+                    }
+                    std::size_t n = 0;
+                    for (auto& member : relation.members()) {
+                        if (!wanted_type(member.type()) ||
+                            !derived().new_member(relation, member, n)) {
+                            member.set_ref(0);
+                        }
+                        ++n;
+                    }
+                }
+                if (removed) {
+                    buffer.purge_removed();
+                }
+            }
+
+            /**
+             * Add a relation that went through prefilter_relations()
+             * before. Unlike relation() this does not call new_relation()
+             * and new_member() again, all members with an id other than 0
+             * are kept.
+             *
+             * @param relation Relation we want to build.
+             */
+            void add_prefiltered_relation(const osmium::Relation& relation) {
+                auto rel_handle = relations_database().add(relation);
+
+                std::size_t n = 0;
+                for (const auto& member : rel_handle->members()) {
+                    if (member.ref() != 0) {
+                        member_database(member.type()).track(rel_handle, member.ref(), n);
+                    }
+                    ++n;
+                }
+            }
+
             void handle_node(const osmium::Node& node) {
                 if (TNodes) {
-                    m_check_order_handler.node(node);
+                    if (!m_input_is_sorted) {
+                        m_check_order_handler.node(node);
+                    }
                     derived().before_node(node);
                     const bool added = member_nodes_database().add(node, [this](RelationHandle& rel_handle) {
                         handle_complete_relation(rel_handle);
@@ -519,7 +728,9 @@ namespace osmium {
 
             void handle_way(const osmium::Way& way) {
                 if (TWays) {
-                    m_check_order_handler.way(way);
+                    if (!m_input_is_sorted) {
+                        m_check_order_handler.way(way);
+                    }
                     derived().before_way(way);
                     const bool added = member_ways_database().add(way, [this](RelationHandle& rel_handle) {
                         handle_complete_relation(rel_handle);
@@ -534,7 +745,9 @@ namespace osmium {
 
             void handle_relation(const osmium::Relation& relation) {
                 if (TRelations) {
-                    m_check_order_handler.relation(relation);
+                    if (!m_input_is_sorted) {
+                        m_check_order_handler.relation(relation);
+                    }
                     derived().before_relation(relation);
                     const bool added = member_relations_database().add(relation, [this](RelationHandle& rel_handle) {
                         handle_complete_relation(rel_handle);
@@ -547,6 +760,56 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Could the second pass need any objects of the specified type
+             * with IDs in the range [first, last]? This is the case if
+             * any of them is a member we are interested in, or if the
+             * derived class has its own version of one of the before_*(),
+             * *_not_in_any_relation(), or after_*() functions for this
+             * type, because those are called for all objects. Drivers
+             * that know which IDs are in which part of the input use this
+             * to skip the parts that are not needed.
+             *
+             * @pre You have to call prepare_for_lookup() before using this.
+             */
+            bool second_pass_needs(osmium::item_type type, osmium::object_id_type first, osmium::object_id_type last) const {
+                switch (type) {
+                    case osmium::item_type::node:
+                        if (!TNodes) {
+                            return false;
+                        }
+                        if (has_before_node<TManager>::value ||
+                            has_node_not_in_any_relation<TManager>::value ||
+                            has_after_node<TManager>::value) {
+                            return true;
+                        }
+                        break;
+                    case osmium::item_type::way:
+                        if (!TWays) {
+                            return false;
+                        }
+                        if (has_before_way<TManager>::value ||
+                            has_way_not_in_any_relation<TManager>::value ||
+                            has_after_way<TManager>::value) {
+                            return true;
+                        }
+                        break;
+                    case osmium::item_type::relation:
+                        if (!TRelations) {
+                            return false;
+                        }
+                        if (has_before_relation<TManager>::value ||
+                            has_relation_not_in_any_relation<TManager>::value ||
+                            has_after_relation<TManager>::value) {
+                            return true;
+                        }
+                        break;
+                    default:
+                        return false;
+                }
+                return member_database(type).has_member_in_range(first, last);
+            }
+
             /**
              * Call this function it will call your function back for every
              * incomplete relation, that is all relations that have missing
@@ -0,0 +1,612 @@
+#ifndef OSMIUM_STORAGE_COLUMNAR_BATCH_HPP
+#define OSMIUM_STORAGE_COLUMNAR_BATCH_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/util/string_pool.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace osmium {
+
+    namespace detail {
+
+        /**
+         * Tags of the objects in a columnar batch in compressed sparse row
+         * format: the tags of object n are at the positions offsets()[n]
+         * up to (but not including) offsets()[n + 1] in the keys() and
+         * values() arrays. Those contain indexes into the StringPool.
+         */
+        class ColumnarTags {
+
+            std::vector<std::size_t> m_offsets{0};
+            std::vector<StringPool::id_type> m_keys;
+            std::vector<StringPool::id_type> m_values;
+            StringPool m_strings;
+
+        public:
+
+            void reserve(std::size_t num_objects, std::size_t num_tags) {
+                m_offsets.reserve(num_objects + 1);
+                m_keys.reserve(num_tags);
+                m_values.reserve(num_tags);
+            }
+
+            // Start the (empty) tag list of the next object.
+            void add_object() {
+                m_offsets.push_back(m_keys.size());
+            }
+
+            // Add a tag to the last object.
+            void add_tag(StringPool::id_type key, StringPool::id_type value) {
+                assert(m_offsets.size() > 1);
+                m_keys.push_back(key);
+                m_values.push_back(value);
+                m_offsets.back() = m_keys.size();
+            }
+
+            StringPool::id_type add_string(const char* str, std::size_t length) {
+                return m_strings.add(str, length);
+            }
+
+            std::size_t count(std::size_t n) const noexcept {
+                assert(n + 1 < m_offsets.size());
+                return m_offsets[n + 1] - m_offsets[n];
+            }
+
+            const char* key(std::size_t n, std::size_t t) const noexcept {
+                assert(t < count(n));
+                return m_strings.get(m_keys[m_offsets[n] + t]);
+            }
+
+            const char* value(std::size_t n, std::size_t t) const noexcept {
+                assert(t < count(n));
+                return m_strings.get(m_values[m_offsets[n] + t]);
+            }
+
+            const char* get_value_by_key(std::size_t n, const char* key) const noexcept {
+                assert(n + 1 < m_offsets.size());
+                for (std::size_t i = m_offsets[n]; i < m_offsets[n + 1]; ++i) {
+                    if (!std::strcmp(m_strings.get(m_keys[i]), key)) {
+                        return m_strings.get(m_values[i]);
+                    }
+                }
+                return nullptr;
+            }
+
+            const std::vector<std::size_t>& offsets() const noexcept {
+                return m_offsets;
+            }
+
+            const std::vector<StringPool::id_type>& keys() const noexcept {
+                return m_keys;
+            }
+
+            const std::vector<StringPool::id_type>& values() const noexcept {
+                return m_values;
+            }
+
+            const StringPool& strings() const noexcept {
+                return m_strings;
+            }
+
+            std::size_t used_memory() const noexcept {
+                return m_offsets.capacity() * sizeof(std::size_t) +
+                       (m_keys.capacity() + m_values.capacity()) * sizeof(StringPool::id_type) +
+                       m_strings.used_memory();
+            }
+
+            // Remove all tags but keep the strings.
+            void clear() {
+                m_offsets.resize(1);
+                m_keys.clear();
+                m_values.clear();
+            }
+
+        }; // class ColumnarTags
+
+        struct all_tags {
+            bool operator()(const osmium::Tag& /*tag*/) const noexcept {
+                return true;
+            }
+        };
+
+    } // namespace detail
+
+    /**
+     * A compact, column oriented representation of nodes for read-only
+     * analytical passes which only need the id, location and tags of the
+     * nodes. Versions, changesets, timestamps, and user information are
+     * not stored.
+     *
+     * There is one array each for the ids and the x and y coordinates.
+     * Tags are stored in compressed sparse row format: the tags of node n
+     * are at the positions tag_offsets()[n] up to (but not including)
+     * tag_offsets()[n + 1] in the tag_keys() and tag_values() arrays.
+     * Those contain indexes into the StringPool returned by strings().
+     *
+     * Usage:
+     * @code
+     * osmium::ColumnarNodeBatch batch;
+     * batch.add_buffer(buffer);
+     * for (std::size_t n = 0; n < batch.size(); ++n) {
+     *     if (batch.get_value_by_key(n, "amenity")) { ... }
+     * }
+     * @endcode
+     */
+    class ColumnarNodeBatch {
+
+        std::vector<osmium::object_id_type> m_ids;
+        std::vector<int32_t> m_x;
+        std::vector<int32_t> m_y;
+        detail::ColumnarTags m_tags;
+
+    public:
+
+        ColumnarNodeBatch() = default;
+
+        /// The number of nodes in the batch.
+        std::size_t size() const noexcept {
+            return m_ids.size();
+        }
+
+        bool empty() const noexcept {
+            return m_ids.empty();
+        }
+
+        /**
+         * Reserve space for the given number of nodes and tags.
+         */
+        void reserve(std::size_t num_nodes, std::size_t num_tags = 0) {
+            m_ids.reserve(num_nodes);
+            m_x.reserve(num_nodes);
+            m_y.reserve(num_nodes);
+            m_tags.reserve(num_nodes, num_tags);
+        }
+
+        /**
+         * Add a node without tags. Use add_tag() afterwards to add tags to
+         * this node.
+         */
+        void add_node(osmium::object_id_type id, const osmium::Location& location) {
+            m_ids.push_back(id);
+            m_x.push_back(location.x());
+            m_y.push_back(location.y());
+            m_tags.add_object();
+        }
+
+        /**
+         * Add a string to the string pool of this batch and return its
+         * index for use with add_tag().
+         */
+        StringPool::id_type add_string(const char* str, std::size_t length) {
+            return m_tags.add_string(str, length);
+        }
+
+        /**
+         * Add a tag with key and value given as indexes returned from
+         * add_string() to the node added last.
+         */
+        void add_tag(StringPool::id_type key, StringPool::id_type value) {
+            assert(!empty());
+            m_tags.add_tag(key, value);
+        }
+
+        /**
+         * Add a tag to the node added last.
+         */
+        void add_tag(const char* key, std::size_t key_length, const char* value, std::size_t value_length) {
+            const auto k = add_string(key, key_length);
+            add_tag(k, add_string(value, value_length));
+        }
+
+        /**
+         * Add a tag to the node added last.
+         */
+        void add_tag(const char* key, const char* value) {
+            add_tag(key, std::strlen(key), value, std::strlen(value));
+        }
+
+        /**
+         * Add a node with the tags for which the filter returns true.
+         *
+         * @param node The node.
+         * @param filter Function object (for instance a TagsFilter) called
+         *               with each osmium::Tag.
+         */
+        template <typename TFilter>
+        void add(const osmium::Node& node, const TFilter& filter) {
+            add_node(node.id(), node.location());
+            for (const auto& tag : node.tags()) {
+                if (filter(tag)) {
+                    add_tag(tag.key(), tag.value());
+                }
+            }
+        }
+
+        /**
+         * Add a node with all its tags.
+         */
+        void add(const osmium::Node& node) {
+            add(node, detail::all_tags{});
+        }
+
+        /**
+         * Add all nodes in the buffer with the tags for which the filter
+         * returns true.
+         */
+        template <typename TFilter>
+        void add_buffer(const osmium::memory::Buffer& buffer, const TFilter& filter) {
+            for (const auto& node : buffer.select<osmium::Node>()) {
+                add(node, filter);
+            }
+        }
+
+        /**
+         * Add all nodes in the buffer with all their tags.
+         */
+        void add_buffer(const osmium::memory::Buffer& buffer) {
+            add_buffer(buffer, detail::all_tags{});
+        }
+
+        osmium::object_id_type id(std::size_t n) const noexcept {
+            assert(n < size());
+            return m_ids[n];
+        }
+
+        osmium::Location location(std::size_t n) const noexcept {
+            assert(n < size());
+            return osmium::Location{m_x[n], m_y[n]};
+        }
+
+        /// The number of tags of node n.
+        std::size_t tag_count(std::size_t n) const noexcept {
+            return m_tags.count(n);
+        }
+
+        /// The key of tag t of node n.
+        const char* tag_key(std::size_t n, std::size_t t) const noexcept {
+            return m_tags.key(n, t);
+        }
+
+        /// The value of tag t of node n.
+        const char* tag_value(std::size_t n, std::size_t t) const noexcept {
+            return m_tags.value(n, t);
+        }
+
+        /**
+         * Get the value of the tag with the given key of node n. Returns
+         * nullptr if there is no such tag.
+         */
+        const char* get_value_by_key(std::size_t n, const char* key) const noexcept {
+            return m_tags.get_value_by_key(n, key);
+        }
+
+        const std::vector<osmium::object_id_type>& ids() const noexcept {
+            return m_ids;
+        }
+
+        /// The x coordinates (longitudes) as in osmium::Location::x().
+        const std::vector<int32_t>& xs() const noexcept {
+            return m_x;
+        }
+
+        /// The y coordinates (latitudes) as in osmium::Location::y().
+        const std::vector<int32_t>& ys() const noexcept {
+            return m_y;
+        }
+
+        /// The CSR offsets into tag_keys() and tag_values(), size() + 1 entries.
+        const std::vector<std::size_t>& tag_offsets() const noexcept {
+            return m_tags.offsets();
+        }
+
+        const std::vector<StringPool::id_type>& tag_keys() const noexcept {
+            return m_tags.keys();
+        }
+
+        const std::vector<StringPool::id_type>& tag_values() const noexcept {
+            return m_tags.values();
+        }
+
+        const StringPool& strings() const noexcept {
+            return m_tags.strings();
+        }
+
+        /// Memory used by the batch in bytes (approximately).
+        std::size_t used_memory() const noexcept {
+            return m_ids.capacity() * sizeof(osmium::object_id_type) +
+                   (m_x.capacity() + m_y.capacity()) * sizeof(int32_t) +
+                   m_tags.used_memory();
+        }
+
+        /**
+         * Remove all nodes. The interned strings are kept, so the next
+         * batch can reuse them.
+         */
+        void clear() {
+            m_ids.clear();
+            m_x.clear();
+            m_y.clear();
+            m_tags.clear();
+        }
+
+    }; // class ColumnarNodeBatch
+
+    /**
+     * A compact, column oriented representation of ways with their ids,
+     * node references, and tags. See ColumnarNodeBatch for details. The
+     * node references of way n are at the positions ref_offsets()[n] up
+     * to (but not including) ref_offsets()[n + 1] in the refs() array.
+     * Node locations are not stored.
+     */
+    class ColumnarWayBatch {
+
+        std::vector<osmium::object_id_type> m_ids;
+        std::vector<std::size_t> m_ref_offsets{0};
+        std::vector<osmium::object_id_type> m_refs;
+        detail::ColumnarTags m_tags;
+
+    public:
+
+        ColumnarWayBatch() = default;
+
+        /// The number of ways in the batch.
+        std::size_t size() const noexcept {
+            return m_ids.size();
+        }
+
+        bool empty() const noexcept {
+            return m_ids.empty();
+        }
+
+        /**
+         * Reserve space for the given number of ways, node references,
+         * and tags.
+         */
+        void reserve(std::size_t num_ways, std::size_t num_refs = 0, std::size_t num_tags = 0) {
+            m_ids.reserve(num_ways);
+            m_ref_offsets.reserve(num_ways + 1);
+            m_refs.reserve(num_refs);
+            m_tags.reserve(num_ways, num_tags);
+        }
+
+        /**
+         * Add a way without node references and tags. Use add_ref() and
+         * add_tag() afterwards to add them to this way.
+         */
+        void add_way(osmium::object_id_type id) {
+            m_ids.push_back(id);
+            m_ref_offsets.push_back(m_refs.size());
+            m_tags.add_object();
+        }
+
+        /**
+         * Add a node reference to the way added last.
+         */
+        void add_ref(osmium::object_id_type ref) {
+            assert(!empty());
+            m_refs.push_back(ref);
+            m_ref_offsets.back() = m_refs.size();
+        }
+
+        /// See ColumnarNodeBatch::add_string().
+        StringPool::id_type add_string(const char* str, std::size_t length) {
+            return m_tags.add_string(str, length);
+        }
+
+        /// See ColumnarNodeBatch::add_tag().
+        void add_tag(StringPool::id_type key, StringPool::id_type value) {
+            assert(!empty());
+            m_tags.add_tag(key, value);
+        }
+
+        /**
+         * Add a tag to the way added last.
+         */
+        void add_tag(const char* key, std::size_t key_length, const char* value, std::size_t value_length) {
+            const auto k = add_string(key, key_length);
+            add_tag(k, add_string(value, value_length));
+        }
+
+        /**
+         * Add a tag to the way added last.
+         */
+        void add_tag(const char* key, const char* value) {
+            add_tag(key, std::strlen(key), value, std::strlen(value));
+        }
+
+        /**
+         * Add a way with the tags for which the filter returns true.
+         */
+        template <typename TFilter>
+        void add(const osmium::Way& way, const TFilter& filter) {
+            add_way(way.id());
+            for (const auto& node_ref : way.nodes()) {
+                add_ref(node_ref.ref());
+            }
+            for (const auto& tag : way.tags()) {
+                if (filter(tag)) {
+                    add_tag(tag.key(), tag.value());
+                }
+            }
+        }
+
+        /**
+         * Add a way with all its tags.
+         */
+        void add(const osmium::Way& way) {
+            add(way, detail::all_tags{});
+        }
+
+        /**
+         * Add all ways in the buffer with the tags for which the filter
+         * returns true.
+         */
+        template <typename TFilter>
+        void add_buffer(const osmium::memory::Buffer& buffer, const TFilter& filter) {
+            for (const auto& way : buffer.select<osmium::Way>()) {
+                add(way, filter);
+            }
+        }
+
+        /**
+         * Add all ways in the buffer with all their tags.
+         */
+        void add_buffer(const osmium::memory::Buffer& buffer) {
+            add_buffer(buffer, detail::all_tags{});
+        }
+
+        osmium::object_id_type id(std::size_t n) const noexcept {
+            assert(n < size());
+            return m_ids[n];
+        }
+
+        /// The number of node references of way n.
+        std::size_t ref_count(std::size_t n) const noexcept {
+            assert(n < size());
+            return m_ref_offsets[n + 1] - m_ref_offsets[n];
+        }
+
+        /// Node reference r of way n.
+        osmium::object_id_type ref(std::size_t n, std::size_t r) const noexcept {
+            assert(r < ref_count(n));
+            return m_refs[m_ref_offsets[n] + r];
+        }
+
+        /// The number of tags of way n.
+        std::size_t tag_count(std::size_t n) const noexcept {
+            return m_tags.count(n);
+        }
+
+        /// The key of tag t of way n.
+        const char* tag_key(std::size_t n, std::size_t t) const noexcept {
+            return m_tags.key(n, t);
+        }
+
+        /// The value of tag t of way n.
+        const char* tag_value(std::size_t n, std::size_t t) const noexcept {
+            return m_tags.value(n, t);
+        }
+
+        /**
+         * Get the value of the tag with the given key of way n. Returns
+         * nullptr if there is no such tag.
+         */
+        const char* get_value_by_key(std::size_t n, const char* key) const noexcept {
+            return m_tags.get_value_by_key(n, key);
+        }
+
+        const std::vector<osmium::object_id_type>& ids() const noexcept {
+            return m_ids;
+        }
+
+        /// The CSR offsets into refs(), size() + 1 entries.
+        const std::vector<std::size_t>& ref_offsets() const noexcept {
+            return m_ref_offsets;
+        }
+
+        const std::vector<osmium::object_id_type>& refs() const noexcept {
+            return m_refs;
+        }
+
+        /// The CSR offsets into tag_keys() and tag_values(), size() + 1 entries.
+        const std::vector<std::size_t>& tag_offsets() const noexcept {
+            return m_tags.offsets();
+        }
+
+        const std::vector<StringPool::id_type>& tag_keys() const noexcept {
+            return m_tags.keys();
+        }
+
+        const std::vector<StringPool::id_type>& tag_values() const noexcept {
+            return m_tags.values();
+        }
+
+        const StringPool& strings() const noexcept {
+            return m_tags.strings();
+        }
+
+        /// Memory used by the batch in bytes (approximately).
+        std::size_t used_memory() const noexcept {
+            return (m_ids.capacity() + m_refs.capacity()) * sizeof(osmium::object_id_type) +
+                   m_ref_offsets.capacity() * sizeof(std::size_t) +
+                   m_tags.used_memory();
+        }
+
+        /**
+         * Remove all ways. The interned strings are kept.
+         */
+        void clear() {
+            m_ids.clear();
+            m_ref_offsets.resize(1);
+            m_refs.clear();
+            m_tags.clear();
+        }
+
+    }; // class ColumnarWayBatch
+
+    /**
+     * The nodes and ways from one block of data (for instance one
+     * PrimitiveBlock of a PBF file) in columnar form.
+     */
+    struct ColumnarBlock {
+
+        ColumnarNodeBatch nodes;
+        ColumnarWayBatch ways;
+
+        bool empty() const noexcept {
+            return nodes.empty() && ways.empty();
+        }
+
+        void clear() {
+            nodes.clear();
+            ways.clear();
+        }
+
+    }; // struct ColumnarBlock
+
+} // namespace osmium
+
+#endif // OSMIUM_STORAGE_COLUMNAR_BATCH_HPP
@@ -35,13 +35,28 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/item.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <limits>
+#include <memory>
 #include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
 #include <vector>
 
+#ifndef _WIN32
+# include <unistd.h>
+#endif
+
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
 # include <iostream>
 # include <chrono>
@@ -49,10 +64,110 @@ DEALINGS IN THE SOFTWARE.
 
 namespace osmium {
 
+    namespace detail {
+
+        /**
+         * Unlinked temporary file used by the ItemStash to spill segments
+         * to disk. The file is closed (and thereby removed) on
+         * destruction.
+         */
+        class item_stash_spill_file {
+
+            int m_fd = -1;
+            std::size_t m_size = 0;
+
+        public:
+
+            item_stash_spill_file() noexcept = default;
+
+            explicit item_stash_spill_file(const std::string& directory) {
+#ifdef _WIN32
+                (void)directory;
+                throw std::runtime_error{"Spilling an ItemStash to disk is not supported on Windows"};
+#else
+                std::string name{directory};
+                if (name.empty()) {
+                    const char* tmpdir = std::getenv("TMPDIR");
+                    name = tmpdir ? tmpdir : "/tmp";
+                }
+                name += "/osmium-item-stash-XXXXXX";
+                m_fd = ::mkstemp(&name[0]);
+                if (m_fd < 0) {
+                    throw std::system_error{errno, std::system_category(), std::string{"Could not create temporary file '"} + name + "'"};
+                }
+                ::unlink(name.c_str());
+#endif
+            }
+
+            item_stash_spill_file(const item_stash_spill_file&) = delete;
+            item_stash_spill_file& operator=(const item_stash_spill_file&) = delete;
+
+            item_stash_spill_file(item_stash_spill_file&& other) noexcept :
+                m_fd(other.m_fd),
+                m_size(other.m_size) {
+                other.m_fd = -1;
+                other.m_size = 0;
+            }
+
+            item_stash_spill_file& operator=(item_stash_spill_file&& other) noexcept {
+                std::swap(m_fd, other.m_fd);
+                std::swap(m_size, other.m_size);
+                return *this;
+            }
+
+            ~item_stash_spill_file() noexcept {
+#ifndef _WIN32
+                if (m_fd >= 0) {
+                    ::close(m_fd);
+                }
+#endif
+            }
+
+            bool valid() const noexcept {
+                return m_fd >= 0;
+            }
+
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            /**
+             * Map a new read-write region of the given size at the end of
+             * the file.
+             */
+            osmium::util::MemoryMapping map_new_region(std::size_t size) {
+                const auto pagesize = osmium::get_pagesize();
+                size = (size + pagesize - 1) / pagesize * pagesize;
+                osmium::util::MemoryMapping mapping{size, osmium::util::MemoryMapping::mapping_mode::write_shared, m_fd, static_cast<off_t>(m_size)};
+                m_size += size;
+                return mapping;
+            }
+
+            /// Truncate the file. All mappings must have been removed.
+            void clear() {
+                if (m_fd >= 0) {
+                    osmium::resize_file(m_fd, 0);
+                }
+                m_size = 0;
+            }
+
+        }; // class item_stash_spill_file
+
+    } // namespace detail
+
     /**
      * Class for storing OSM data in memory. Any osmium::memory::Item can be
      * added to the stash and it will be copied into its internal Buffer. To
      * access the item again, an opaque handle is used.
+     *
+     * By default all items are kept in one growing Buffer which is
+     * compacted as a whole from time to time. For very large data sets
+     * call use_segments() on the empty stash. Items are then kept in
+     * fixed-size segments, each segment is compacted on its own when
+     * enough of its items have been removed, and, if a memory budget is
+     * set, the oldest segments are moved into a memory-mapped temporary
+     * file when the segments in memory exceed the budget. The operating
+     * system can then page those segments out and in as needed.
      */
     class ItemStash {
 
@@ -113,62 +228,111 @@ namespace osmium {
 
         }; // class handle_type
 
+        enum : std::size_t {
+            default_segment_size = 64UL * 1024UL * 1024UL
+        };
+
     private:
 
         enum {
             initial_buffer_size = 1024UL * 1024UL
         };
 
-        enum {
-            removed_item_offset = std::numeric_limits<std::size_t>::max()
+        // The entries in the index contain the segment number in the
+        // upper bits and the offset into the segment in the lower bits.
+        enum : uint64_t {
+            segment_shift = 40,
+            offset_mask = (1ULL << 40U) - 1,
+            removed_item_offset = std::numeric_limits<uint64_t>::max()
         };
 
-        osmium::memory::Buffer m_buffer;
-        std::vector<std::size_t> m_index;
+        struct segment {
+
+            osmium::memory::Buffer buffer;
+
+            // Only set if this segment has been spilled to disk.
+            std::unique_ptr<osmium::util::MemoryMapping> mapping;
+
+            // Index (into m_index) of the first item in this segment.
+            std::size_t first_index;
+
+            std::size_t count_items = 0;
+            std::size_t count_removed = 0;
+            bool queued = false;
+
+            segment(osmium::memory::Buffer&& new_buffer, std::size_t new_first_index) :
+                buffer(std::move(new_buffer)),
+                first_index(new_first_index) {
+            }
+
+        }; // struct segment
+
+        std::vector<segment> m_segments;
+        std::vector<uint64_t> m_index;
         std::size_t m_count_items = 0;
         std::size_t m_count_removed = 0;
+
+        // Size of the segments, 0 if all items are in one growing buffer.
+        std::size_t m_segment_size = 0;
+        std::size_t m_memory_budget = 0;
+        std::size_t m_peak_memory = 0;
+        std::vector<std::size_t> m_compaction_queue;
+        std::string m_spill_directory;
+        detail::item_stash_spill_file m_spill_file;
+
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
         int64_t m_gc_time = 0;
 #endif
 
         class cleanup_helper {
 
-            std::vector<std::size_t>& m_index;
-            std::size_t m_pos = 0;
+            std::vector<uint64_t>& m_index;
+            std::size_t m_pos;
+            uint64_t m_segment_bits;
 
         public:
 
-            explicit cleanup_helper(std::vector<std::size_t>& index) :
-                m_index(index) {
+            cleanup_helper(std::vector<uint64_t>& index, std::size_t start, std::size_t segment_num) :
+                m_index(index),
+                m_pos(start),
+                m_segment_bits(static_cast<uint64_t>(segment_num) << segment_shift) {
             }
 
             void moving_in_buffer(std::size_t old_offset, std::size_t new_offset) {
-                while (m_index[m_pos] != old_offset) {
+                while (m_index[m_pos] != (m_segment_bits | old_offset)) {
                     ++m_pos;
                     assert(m_pos < m_index.size());
                 }
-                m_index[m_pos] = new_offset;
+                m_index[m_pos] = m_segment_bits | new_offset;
                 ++m_pos;
             }
 
         }; // cleanup_helper
 
-        std::size_t& get_item_offset_ref(handle_type handle) noexcept {
+        static std::size_t entry_segment(uint64_t entry) noexcept {
+            return static_cast<std::size_t>(entry >> segment_shift);
+        }
+
+        static std::size_t entry_offset(uint64_t entry) noexcept {
+            return static_cast<std::size_t>(entry & offset_mask);
+        }
+
+        uint64_t& get_item_entry_ref(handle_type handle) noexcept {
             assert(handle.valid() && "handle must be valid");
             assert(handle.value <= m_index.size());
-            auto& offset = m_index[handle.value - 1];
-            assert(offset != removed_item_offset);
-            assert(offset < m_buffer.committed());
-            return offset;
+            auto& entry = m_index[handle.value - 1];
+            assert(entry != removed_item_offset);
+            assert(entry_offset(entry) < m_segments[entry_segment(entry)].buffer.committed());
+            return entry;
         }
 
-        std::size_t get_item_offset(handle_type handle) const noexcept {
+        uint64_t get_item_entry(handle_type handle) const noexcept {
             assert(handle.valid() && "handle must be valid");
             assert(handle.value <= m_index.size());
-            const auto& offset = m_index[handle.value - 1];
-            assert(offset != removed_item_offset);
-            assert(offset < m_buffer.committed());
-            return offset;
+            const auto& entry = m_index[handle.value - 1];
+            assert(entry != removed_item_offset);
+            assert(entry_offset(entry) < m_segments[entry_segment(entry)].buffer.committed());
+            return entry;
         }
 
         // This function decides whether it makes sense to garbage collect the
@@ -190,25 +354,187 @@ namespace osmium {
             if (m_count_removed * 5UL < m_count_items) { // *3
                 return false;
             }
-            return m_buffer.capacity() - m_buffer.committed() < 10UL * 1024UL; // *4
+            const auto& buffer = m_segments.back().buffer;
+            return buffer.capacity() - buffer.committed() < 10UL * 1024UL; // *4
+        }
+
+        // Compact a single segment in place. Segments other than the last
+        // one never get new items, so their memory is shrunk afterwards.
+        void compact_segment(std::size_t num) {
+            auto& seg = m_segments[num];
+            seg.queued = false;
+            if (seg.count_removed == 0) {
+                return;
+            }
+
+            cleanup_helper helper{m_index, seg.first_index, num};
+            seg.buffer.purge_removed(&helper);
+            m_count_removed -= seg.count_removed;
+            seg.count_items -= seg.count_removed;
+            seg.count_removed = 0;
+
+            if (num + 1 == m_segments.size()) {
+                return;
+            }
+
+            if (seg.buffer.committed() == 0) {
+                seg.buffer = osmium::memory::Buffer{};
+                seg.mapping.reset();
+            } else if (!seg.mapping && seg.buffer.committed() <= seg.buffer.capacity() / 2) {
+                osmium::memory::Buffer buffer{seg.buffer.committed(), osmium::memory::Buffer::auto_grow::no};
+                buffer.add_buffer(seg.buffer);
+                buffer.commit();
+                seg.buffer = std::move(buffer);
+            }
+        }
+
+        // A segment that doesn't get new items any more is queued for
+        // compaction once half of its items have been removed.
+        void maybe_queue_for_compaction(std::size_t num) {
+            auto& seg = m_segments[num];
+            if (!seg.queued && num + 1 < m_segments.size() &&
+                seg.count_removed > 0 && seg.count_removed * 2 >= seg.count_items) {
+                seg.queued = true;
+                m_compaction_queue.push_back(num);
+            }
+        }
+
+        std::size_t in_memory_bytes() const noexcept {
+            std::size_t bytes = 0;
+            for (const auto& seg : m_segments) {
+                if (!seg.mapping && seg.buffer) {
+                    bytes += seg.buffer.capacity();
+                }
+            }
+            return bytes;
+        }
+
+        void spill_segment(segment& seg) {
+            if (!m_spill_file.valid()) {
+                m_spill_file = detail::item_stash_spill_file{m_spill_directory};
+            }
+            std::unique_ptr<osmium::util::MemoryMapping> mapping{new osmium::util::MemoryMapping{m_spill_file.map_new_region(seg.buffer.committed())}};
+            std::memcpy(mapping->get_addr(), seg.buffer.data(), seg.buffer.committed());
+            seg.buffer = osmium::memory::Buffer{mapping->get_addr<unsigned char>(), mapping->size(), seg.buffer.committed()};
+            seg.mapping = std::move(mapping);
+        }
+
+        // Move the oldest segments into the spill file until the segments
+        // in memory fit into the memory budget again. The last segment
+        // always stays in memory.
+        void spill_if_needed() {
+            if (m_memory_budget == 0) {
+                return;
+            }
+            std::size_t bytes = in_memory_bytes();
+            for (std::size_t num = 0; bytes > m_memory_budget && num + 1 < m_segments.size(); ++num) {
+                auto& seg = m_segments[num];
+                if (!seg.mapping && seg.buffer) {
+                    bytes -= seg.buffer.capacity();
+                    spill_segment(seg);
+                }
+            }
+        }
+
+        // Make sure there is enough space for an item of the given size in
+        // the last segment, compacting it or starting a new segment if
+        // needed.
+        void make_room(std::size_t size) {
+            auto& last = m_segments.back();
+            if (last.buffer.capacity() - last.buffer.committed() >= size) {
+                return;
+            }
+
+            if (last.count_removed * 4 >= last.count_items && last.count_removed > 0) {
+                compact_segment(m_segments.size() - 1);
+                if (last.buffer.capacity() - last.buffer.committed() >= size) {
+                    return;
+                }
+            }
+
+            m_segments.emplace_back(osmium::memory::Buffer{std::max(m_segment_size, size), osmium::memory::Buffer::auto_grow::no}, m_index.size());
+            maybe_queue_for_compaction(m_segments.size() - 2);
+            spill_if_needed();
+            m_peak_memory = std::max(m_peak_memory, in_memory_bytes());
         }
 
     public:
 
-        ItemStash() :
-            m_buffer(initial_buffer_size, osmium::memory::Buffer::auto_grow::yes) {
+        ItemStash() {
+            m_segments.emplace_back(osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes}, 0);
+        }
+
+        /**
+         * Switch this stash to storing items in segments of the given size
+         * instead of one growing buffer. Each segment is compacted
+         * separately once at least half of the items in it have been
+         * removed. This is done in add_item() one segment at a time so
+         * there are no long pauses for garbage collection.
+         *
+         * If a memory budget is set, the oldest segments will be moved
+         * into a memory-mapped, already unlinked temporary file whenever
+         * the segments held in memory take up more than the budget.
+         * Accessing items in those segments still works, the operating
+         * system will page them in as needed. Spilling to disk is not
+         * available on Windows.
+         *
+         * @pre The stash must be empty.
+         *
+         * @param segment_size Size of each segment in bytes. Items that are
+         *        larger get a segment of their own.
+         * @param memory_budget Maximum number of bytes of segments kept
+         *        in memory. Set to 0 (default) to never spill to disk.
+         * @param spill_directory Directory for the temporary file. If this
+         *        is empty, the directory in the TMPDIR environment variable
+         *        or /tmp is used.
+         */
+        void use_segments(std::size_t segment_size = default_segment_size,
+                          std::size_t memory_budget = 0,
+                          const std::string& spill_directory = "") {
+            assert(m_index.empty() && "use_segments() must be called on an empty ItemStash");
+            assert(segment_size > 0);
+            m_segment_size = segment_size;
+            m_memory_budget = memory_budget;
+            m_spill_directory = spill_directory;
+            m_segments.clear();
+            m_segments.emplace_back(osmium::memory::Buffer{m_segment_size, osmium::memory::Buffer::auto_grow::no}, 0);
+            m_peak_memory = std::max(m_peak_memory, m_segment_size);
         }
 
         /**
          * Return an estimate of the number of bytes currently used by this
-         * ItemStash instance.
+         * ItemStash instance. This does not include segments spilled to
+         * disk.
          *
-         * Complexity: Constant.
+         * Complexity: Linear in the number of segments.
          */
         std::size_t used_memory() const noexcept {
             return sizeof(ItemStash) +
-                   m_buffer.capacity() +
-                   m_index.capacity() * sizeof(std::size_t);
+                   in_memory_bytes() +
+                   m_segments.capacity() * sizeof(segment) +
+                   m_index.capacity() * sizeof(uint64_t);
+        }
+
+        /**
+         * Return the largest number of bytes ever used for the buffers
+         * holding the items in memory. This does not include segments
+         * spilled to disk and the index, so it is a lower bound of the
+         * largest value returned by used_memory().
+         *
+         * Complexity: Constant.
+         */
+        std::size_t peak_memory() const noexcept {
+            return m_peak_memory;
+        }
+
+        /**
+         * Return the number of bytes in the temporary file used for
+         * segments spilled to disk.
+         *
+         * Complexity: Constant.
+         */
+        std::size_t used_disk_space() const noexcept {
+            return m_spill_file.size();
         }
 
         /**
@@ -236,8 +562,17 @@ namespace osmium {
          * any memory. All handles are invalidated.
          */
         void clear() {
-            m_buffer.clear();
+            if (m_segment_size == 0) {
+                m_segments.front().buffer.clear();
+                m_segments.front().count_items = 0;
+                m_segments.front().count_removed = 0;
+            } else {
+                m_segments.clear();
+                m_segments.emplace_back(osmium::memory::Buffer{m_segment_size, osmium::memory::Buffer::auto_grow::no}, 0);
+                m_spill_file.clear();
+            }
             m_index.clear();
+            m_compaction_queue.clear();
             m_count_items = 0;
             m_count_removed = 0;
         }
@@ -249,14 +584,28 @@ namespace osmium {
          * Complexity: Amortized constant.
          */
         handle_type add_item(const osmium::memory::Item& item) {
-            if (should_gc()) {
-                garbage_collect();
+            if (m_segment_size == 0) {
+                if (should_gc()) {
+                    garbage_collect();
+                }
+            } else {
+                if (!m_compaction_queue.empty()) {
+                    const auto num = m_compaction_queue.back();
+                    m_compaction_queue.pop_back();
+                    compact_segment(num);
+                }
+                make_room(item.padded_size());
             }
             ++m_count_items;
-            const auto offset = m_buffer.committed();
-            m_buffer.add_item(item);
-            m_buffer.commit();
-            m_index.push_back(offset);
+            auto& seg = m_segments.back();
+            const auto offset = seg.buffer.committed();
+            seg.buffer.add_item(item);
+            seg.buffer.commit();
+            ++seg.count_items;
+            if (m_segment_size == 0) {
+                m_peak_memory = std::max(m_peak_memory, seg.buffer.capacity());
+            }
+            m_index.push_back((static_cast<uint64_t>(m_segments.size() - 1) << segment_shift) | offset);
             return handle_type{m_index.size()};
         }
 
@@ -272,7 +621,8 @@ namespace osmium {
          *      item.
          */
         osmium::memory::Item& get_item(handle_type handle) const {
-            return m_buffer.get<osmium::memory::Item>(get_item_offset(handle));
+            const auto entry = get_item_entry(handle);
+            return m_segments[entry_segment(entry)].buffer.get<osmium::memory::Item>(entry_offset(entry));
         }
 
         /**
@@ -298,21 +648,23 @@ namespace osmium {
         /**
          * Garbage collect the memory used by the ItemStash. This will free up
          * memory for adding new items. No memory is actually returned to the
-         * OS. Usually you do not need to call this, because add_item() will
+         * OS, except for segments other than the last one in segmented mode.
+         * Usually you do not need to call this, because add_item() will
          * call it for you as necessary.
          *
          * Complexity: Linear in size() + count_removed().
          */
         void garbage_collect() {
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
-            std::cerr << "GC items=" << m_count_items << " removed=" << m_count_removed << " buffer.committed=" << m_buffer.committed() << " buffer.capacity=" << m_buffer.capacity() << "\n";
+            std::cerr << "GC items=" << m_count_items << " removed=" << m_count_removed << " segments=" << m_segments.size() << " used_memory=" << used_memory() << "\n";
             using clock = std::chrono::high_resolution_clock;
             std::chrono::time_point<clock> start = clock::now();
 #endif
 
-            m_count_removed = 0;
-            cleanup_helper helper{m_index};
-            m_buffer.purge_removed(&helper);
+            for (std::size_t num = 0; num < m_segments.size(); ++num) {
+                compact_segment(num);
+            }
+            m_compaction_queue.clear();
 
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
             std::chrono::time_point<clock> stop = clock::now();
@@ -336,13 +688,16 @@ namespace osmium {
          *      item.
          */
         void remove_item(handle_type handle) {
-            auto& offset = get_item_offset_ref(handle);
-            auto& item = m_buffer.get<osmium::memory::Item>(offset);
+            auto& entry = get_item_entry_ref(handle);
+            const auto num = entry_segment(entry);
+            auto& item = m_segments[num].buffer.get<osmium::memory::Item>(entry_offset(entry));
             assert(!item.removed() && "can not call remove_item() on already removed item");
             item.set_removed(true);
-            offset = removed_item_offset;
+            entry = removed_item_offset;
             --m_count_items;
             ++m_count_removed;
+            ++m_segments[num].count_removed;
+            maybe_queue_for_compaction(num);
         }
 
     }; // class ItemStash
@@ -37,8 +37,11 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/util/string_matcher.hpp>
 
 #include <algorithm>
+#include <cstring>
+#include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -52,6 +55,20 @@ namespace osmium {
         bool m_has_value_matcher = false;
         bool m_result = true;
 
+        // If the key matcher only matches a fixed set of keys, this is
+        // the largest of them. Used to stop early when matching against
+        // a TagList sorted by key.
+        std::string m_last_key;
+        bool m_has_last_key = false;
+
+        void init_last_key() {
+            std::vector<std::string> keys;
+            if (m_key_matcher.exact_strings(keys) && !keys.empty()) {
+                m_last_key = *std::max_element(keys.cbegin(), keys.cend());
+                m_has_last_key = true;
+            }
+        }
+
     public:
 
         /**
@@ -66,6 +83,21 @@ namespace osmium {
             return m_has_value_matcher;
         }
 
+        /// The StringMatcher used for the key.
+        const osmium::StringMatcher& key_matcher() const noexcept {
+            return m_key_matcher;
+        }
+
+        /// The StringMatcher used for the value.
+        const osmium::StringMatcher& value_matcher() const noexcept {
+            return m_value_matcher;
+        }
+
+        /// Is the result of the value matcher inverted?
+        bool value_inverted() const noexcept {
+            return !m_result;
+        }
+
         /**
          * Create a TagMatcher matching the key against the specified
          * StringMatcher.
@@ -77,6 +109,7 @@ namespace osmium {
         explicit TagMatcher(TKey&& key_matcher) :
             m_key_matcher(std::forward<TKey>(key_matcher)),
             m_value_matcher(osmium::StringMatcher::always_true{}) {
+            init_last_key();
         }
 
         /**
@@ -95,6 +128,7 @@ namespace osmium {
             m_value_matcher(std::forward<TValue>(value_matcher)),
             m_has_value_matcher(true),
             m_result(!invert) {
+            init_last_key();
         }
 
         /**
@@ -122,6 +156,17 @@ namespace osmium {
          * @returns true if any of the tags in the TagList matches.
          */
         bool operator()(const osmium::TagList& tags) const noexcept {
+            if (m_has_last_key && tags.sorted_by_key()) {
+                for (const auto& tag : tags) {
+                    if (std::strcmp(tag.key(), m_last_key.c_str()) > 0) {
+                        return false;
+                    }
+                    if (operator()(tag)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
             return std::any_of(tags.begin(), tags.end(), [this](const osmium::Tag& tag){
                 return operator()(tag);
             });
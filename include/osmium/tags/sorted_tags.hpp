@@ -0,0 +1,188 @@
+#ifndef OSMIUM_TAGS_SORTED_TAGS_HPP
+#define OSMIUM_TAGS_SORTED_TAGS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/entity.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/tag.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace osmium {
+
+    namespace tags {
+
+        /**
+         * Random access view on the tags of a TagList ordered by key.
+         * Tags in a TagList have different sizes, so they can only be
+         * scanned from the beginning. If many lookups are done on the
+         * same tag list, it is cheaper to create this view once and then
+         * look up keys with a binary search. If the tag list is sorted
+         * already (see TagList::sort_by_key()), creating the view only
+         * needs one pass over the tags.
+         *
+         * The view can be reused for different tag lists with reset(),
+         * this avoids memory allocations. It contains pointers into the
+         * TagList which must stay valid as long as the view is used.
+         */
+        class SortedTags {
+
+            std::vector<const osmium::Tag*> m_tags;
+
+            using const_iterator = std::vector<const osmium::Tag*>::const_iterator;
+
+            const_iterator find_key(const char* key) const noexcept {
+                const auto it = std::lower_bound(m_tags.cbegin(), m_tags.cend(), key, [](const osmium::Tag* tag, const char* k) {
+                    return std::strcmp(tag->key(), k) < 0;
+                });
+                if (it != m_tags.cend() && !std::strcmp((*it)->key(), key)) {
+                    return it;
+                }
+                return m_tags.cend();
+            }
+
+        public:
+
+            SortedTags() = default;
+
+            explicit SortedTags(const osmium::TagList& tags) {
+                reset(tags);
+            }
+
+            /**
+             * Set up the view for a different tag list.
+             */
+            void reset(const osmium::TagList& tags) {
+                m_tags.clear();
+                for (const auto& tag : tags) {
+                    m_tags.push_back(&tag);
+                }
+                if (!tags.sorted_by_key()) {
+                    std::stable_sort(m_tags.begin(), m_tags.end(), [](const osmium::Tag* lhs, const osmium::Tag* rhs) {
+                        return std::strcmp(lhs->key(), rhs->key()) < 0;
+                    });
+                }
+            }
+
+            /// The number of tags.
+            std::size_t size() const noexcept {
+                return m_tags.size();
+            }
+
+            /// Are there no tags?
+            bool empty() const noexcept {
+                return m_tags.empty();
+            }
+
+            /// Get the tag with the given index (tags are ordered by key).
+            const osmium::Tag& operator[](std::size_t n) const noexcept {
+                assert(n < m_tags.size());
+                return *m_tags[n];
+            }
+
+            /**
+             * Get tag value for the given tag key. If the key is not set,
+             * returns the default_value. If there are several tags with
+             * this key, the value of the first one is returned.
+             *
+             * Complexity: O(log n) with n the number of tags.
+             *
+             * @pre @code key != nullptr @endcode
+             */
+            const char* get_value_by_key(const char* key, const char* default_value = nullptr) const noexcept {
+                assert(key);
+                const auto it = find_key(key);
+                return it == m_tags.cend() ? default_value : (*it)->value();
+            }
+
+            /**
+             * Returns true if the tag with the given key is in the tag list.
+             *
+             * Complexity: O(log n) with n the number of tags.
+             *
+             * @pre @code key != nullptr @endcode
+             */
+            bool has_key(const char* key) const noexcept {
+                assert(key);
+                return find_key(key) != m_tags.cend();
+            }
+
+            /**
+             * Returns true if the tag with the given key and value is in
+             * the tag list.
+             *
+             * Complexity: O(log n) with n the number of tags.
+             *
+             * @pre @code key != nullptr && value != nullptr @endcode
+             */
+            bool has_tag(const char* key, const char* value) const noexcept {
+                assert(key);
+                assert(value);
+                const auto it = find_key(key);
+                return it != m_tags.cend() && !std::strcmp((*it)->value(), value);
+            }
+
+        }; // class SortedTags
+
+        /**
+         * Sort the tags of all objects and changesets in the buffer by key
+         * (see TagList::sort_by_key()).
+         */
+        inline void sort_by_key(osmium::memory::Buffer& buffer) {
+            for (auto& item : buffer) {
+                osmium::TagList* tags = nullptr;
+                if (item.type() == osmium::item_type::changeset) {
+                    auto& changeset = static_cast<osmium::Changeset&>(item);
+                    tags = osmium::detail::subitem_ptr_of_type<osmium::TagList>(changeset.begin(), changeset.end());
+                } else if (osmium::OSMObject::is_compatible_to(item.type())) {
+                    auto& object = static_cast<osmium::OSMObject&>(item);
+                    tags = osmium::detail::subitem_ptr_of_type<osmium::TagList>(object.begin(), object.end());
+                }
+                if (tags) {
+                    tags->sort_by_key();
+                }
+            }
+        }
+
+    } // namespace tags
+
+} // namespace osmium
+
+#endif // OSMIUM_TAGS_SORTED_TAGS_HPP
@@ -0,0 +1,295 @@
+#ifndef OSMIUM_TAGS_TAG_STATISTICS_HPP
+#define OSMIUM_TAGS_TAG_STATISTICS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/apply_parallel.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/hyperloglog.hpp>
+#include <osmium/util/space_saving.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace tags {
+
+        /**
+         * Options for TagStatistics.
+         */
+        struct tag_statistics_options {
+
+            /// Precision of the HyperLogLog sketches for distinct values.
+            unsigned int precision = osmium::HyperLogLog::default_precision;
+
+            /**
+             * Number of counters for the most frequent values of each
+             * key. The counts of the top values are more accurate if
+             * this is a few times larger than the number of values you
+             * need.
+             */
+            std::size_t top_counters = 32;
+
+        }; // struct tag_statistics_options
+
+        /**
+         * Statistics for one key collected by TagStatistics.
+         */
+        class key_statistics {
+
+            uint64_t m_count[3] = {0, 0, 0};
+            osmium::HyperLogLog m_values;
+            osmium::SpaceSaving m_top_values;
+
+        public:
+
+            explicit key_statistics(const tag_statistics_options& options) :
+                m_values(options.precision),
+                m_top_values(options.top_counters) {
+            }
+
+            void add(const osmium::item_type type, const char* value) {
+                ++m_count[osmium::item_type_to_nwr_index(type)];
+                const auto size = std::strlen(value);
+                m_values.add(value, size);
+                m_top_values.add(value, size);
+            }
+
+            void merge(const key_statistics& other) {
+                for (int i = 0; i < 3; ++i) {
+                    m_count[i] += other.m_count[i];
+                }
+                m_values.merge(other.m_values);
+                m_top_values.merge(other.m_top_values);
+            }
+
+            /// Number of tags with this key on all objects.
+            uint64_t count() const noexcept {
+                return m_count[0] + m_count[1] + m_count[2];
+            }
+
+            /// Number of tags with this key on objects of the given type.
+            uint64_t count(const osmium::item_type type) const noexcept {
+                return m_count[osmium::item_type_to_nwr_index(type)];
+            }
+
+            /**
+             * Number of distinct values of this key. This is exact for
+             * keys with only a few values (distinct_values_exact() returns
+             * true in that case) and an estimate otherwise.
+             */
+            uint64_t distinct_values() const noexcept {
+                return static_cast<uint64_t>(m_values.estimate() + 0.5);
+            }
+
+            bool distinct_values_exact() const noexcept {
+                return m_values.exact();
+            }
+
+            /**
+             * The most frequent values of this key with (upper bounds
+             * of) their counts, see osmium::SpaceSaving.
+             */
+            std::vector<osmium::SpaceSaving::entry> top_values(const std::size_t num) const {
+                return m_top_values.top(num);
+            }
+
+            std::size_t used_memory() const noexcept {
+                return sizeof(key_statistics) + m_values.used_memory() + m_top_values.used_memory();
+            }
+
+        }; // class key_statistics
+
+        /**
+         * Handler collecting statistics about the tags of nodes, ways and
+         * relations: The exact number of tags for each key, an estimate
+         * of the number of distinct values for each key and the most
+         * frequent values of each key. The distinct values and most
+         * frequent values are tracked with fixed-size sketches, so memory
+         * use only depends on the number of keys.
+         *
+         * Statistics from several instances can be merged. Use
+         * collect_tag_statistics() to collect them using a thread pool.
+         */
+        class TagStatistics : public osmium::handler::Handler {
+
+            tag_statistics_options m_options;
+            std::unordered_map<std::string, key_statistics> m_keys{};
+
+            // Reused for looking up keys so that no allocation is needed
+            // for keys already seen.
+            std::string m_lookup{};
+
+            uint64_t m_objects[3] = {0, 0, 0};
+            uint64_t m_tags = 0;
+
+        public:
+
+            explicit TagStatistics(const tag_statistics_options& options = tag_statistics_options{}) :
+                m_options(options) {
+            }
+
+            /// Add the tags of an object.
+            void add(const osmium::OSMObject& object) {
+                ++m_objects[osmium::item_type_to_nwr_index(object.type())];
+                for (const auto& tag : object.tags()) {
+                    m_lookup.assign(tag.key());
+                    auto it = m_keys.find(m_lookup);
+                    if (it == m_keys.end()) {
+                        it = m_keys.emplace(m_lookup, key_statistics{m_options}).first;
+                    }
+                    it->second.add(object.type(), tag.value());
+                    ++m_tags;
+                }
+            }
+
+            void node(const osmium::Node& node) {
+                add(node);
+            }
+
+            void way(const osmium::Way& way) {
+                add(way);
+            }
+
+            void relation(const osmium::Relation& relation) {
+                add(relation);
+            }
+
+            /**
+             * Merge statistics from another instance into this one. The
+             * options of both must be the same.
+             */
+            void merge(TagStatistics&& other) {
+                for (int i = 0; i < 3; ++i) {
+                    m_objects[i] += other.m_objects[i];
+                }
+                m_tags += other.m_tags;
+                for (auto& entry : other.m_keys) {
+                    const auto it = m_keys.find(entry.first);
+                    if (it == m_keys.end()) {
+                        m_keys.emplace(entry.first, std::move(entry.second));
+                    } else {
+                        it->second.merge(entry.second);
+                    }
+                }
+                other.m_keys.clear();
+            }
+
+            /// Number of objects of the given type seen.
+            uint64_t num_objects(const osmium::item_type type) const noexcept {
+                return m_objects[osmium::item_type_to_nwr_index(type)];
+            }
+
+            /// Number of tags seen on all objects.
+            uint64_t num_tags() const noexcept {
+                return m_tags;
+            }
+
+            /// Number of different keys seen.
+            std::size_t num_keys() const noexcept {
+                return m_keys.size();
+            }
+
+            /// Statistics for the given key or nullptr if it wasn't seen.
+            const key_statistics* get(const char* key) const {
+                const auto it = m_keys.find(key);
+                return it == m_keys.end() ? nullptr : &it->second;
+            }
+
+            /**
+             * Call func(const std::string& key, const key_statistics&)
+             * for each key. The keys are not in any particular order.
+             */
+            template <typename TFunc>
+            void for_each_key(TFunc&& func) const {
+                for (const auto& entry : m_keys) {
+                    func(entry.first, entry.second);
+                }
+            }
+
+            /// Approximate number of bytes of memory used.
+            std::size_t used_memory() const noexcept {
+                std::size_t size = sizeof(TagStatistics);
+                for (const auto& entry : m_keys) {
+                    size += entry.first.capacity() + entry.second.used_memory();
+                }
+                return size;
+            }
+
+        }; // class TagStatistics
+
+        /**
+         * Collect tag statistics from all objects in the source using the
+         * threads in the pool. Each pool task works on its own
+         * TagStatistics instance, the instances are merged at the end.
+         *
+         * @code
+         * osmium::io::Reader reader{"input.osm.pbf", osmium::osm_entity_bits::nwr};
+         * const auto stats = osmium::tags::collect_tag_statistics(reader);
+         * const auto* highway = stats.get("highway");
+         * @endcode
+         *
+         * @param source Where the buffers come from, see apply_parallel().
+         * @param options Options for the statistics.
+         * @param pool The thread pool to use.
+         * @throws Any exception thrown by the source.
+         */
+        template <typename TSource>
+        TagStatistics collect_tag_statistics(TSource& source, const tag_statistics_options& options = tag_statistics_options{}, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            TagStatistics result{options};
+            osmium::apply_parallel(source, [&options]() {
+                return TagStatistics{options};
+            }, [&result](TagStatistics&& statistics) {
+                result.merge(std::move(statistics));
+            }, pool);
+            return result;
+        }
+
+    } // namespace tags
+
+} // namespace osmium
+
+#endif // OSMIUM_TAGS_TAG_STATISTICS_HPP
@@ -35,12 +35,147 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/osm/tag.hpp>
 #include <osmium/tags/matcher.hpp>
+#include <osmium/util/string.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
 #include <utility>
 #include <vector>
 
 namespace osmium {
 
+    namespace detail {
+
+        /**
+         * Hash index from keys or key/value pairs to the number of the
+         * first rule of a TagsFilter matching them. Used by
+         * TagsFilterBase::compile(). The index uses open addressing with
+         * linear probing, lookups don't allocate memory.
+         */
+        class tags_filter_index {
+
+            struct entry {
+                std::string key;
+                std::string value;
+                bool any_value;
+                std::size_t rule;
+            };
+
+            // Slot in the hash table. Entry 0 marks an empty slot, the
+            // entries are numbered starting from 1.
+            struct slot {
+                uint64_t hash = 0;
+                std::size_t entry = 0;
+            };
+
+            std::vector<entry> m_entries{};
+            std::vector<slot> m_slots = std::vector<slot>(16);
+            std::size_t m_mask = 15;
+
+            static uint64_t value_hash(uint64_t key_hash, const char* value, std::size_t length) noexcept {
+                return key_hash ^ (osmium::detail::string_hash(value, length) + 0x9e3779b97f4a7c15ULL + (key_hash << 6U) + (key_hash >> 2U));
+            }
+
+            // Find the slot with the given key and value (or any value if
+            // value is nullptr) or the empty slot where it would go.
+            std::size_t find_slot(uint64_t hash, const char* key, const char* value) const noexcept {
+                std::size_t pos = hash & m_mask;
+                while (m_slots[pos].entry != 0) {
+                    if (m_slots[pos].hash == hash) {
+                        const entry& e = m_entries[m_slots[pos].entry - 1];
+                        if (e.any_value == (value == nullptr) &&
+                            !std::strcmp(e.key.c_str(), key) &&
+                            (value == nullptr || !std::strcmp(e.value.c_str(), value))) {
+                            return pos;
+                        }
+                    }
+                    pos = (pos + 1) & m_mask;
+                }
+                return pos;
+            }
+
+            void grow() {
+                std::vector<slot> old_slots(m_slots.size() * 2);
+                using std::swap;
+                swap(old_slots, m_slots);
+                m_mask = m_slots.size() - 1;
+                for (const auto& s : old_slots) {
+                    if (s.entry != 0) {
+                        std::size_t pos = s.hash & m_mask;
+                        while (m_slots[pos].entry != 0) {
+                            pos = (pos + 1) & m_mask;
+                        }
+                        m_slots[pos] = s;
+                    }
+                }
+            }
+
+        public:
+
+            enum : std::size_t {
+                not_found = std::numeric_limits<std::size_t>::max()
+            };
+
+            /**
+             * Add key (with any value if value is nullptr) or key/value
+             * pair for the given rule. If it is already in the index, the
+             * rule number is not changed, so rules must be added in order.
+             */
+            void add(const std::string& key, const std::string* value, std::size_t rule) {
+                const uint64_t key_hash = osmium::detail::string_hash(key.data(), key.size());
+                const uint64_t hash = value ? value_hash(key_hash, value->data(), value->size()) : key_hash;
+                const std::size_t pos = find_slot(hash, key.c_str(), value ? value->c_str() : nullptr);
+                if (m_slots[pos].entry != 0) {
+                    return;
+                }
+
+                m_entries.push_back(entry{key, value ? *value : std::string{}, value == nullptr, rule});
+                m_slots[pos].hash = hash;
+                m_slots[pos].entry = m_entries.size();
+
+                if (m_entries.size() * 4 > m_slots.size() * 3) {
+                    grow();
+                }
+            }
+
+            /**
+             * Find the smallest rule number for the key (with any value)
+             * or the key/value pair.
+             *
+             * @returns Rule number or not_found.
+             */
+            std::size_t find(const char* key, const char* value) const noexcept {
+                const uint64_t key_hash = osmium::detail::string_hash(key, std::strlen(key));
+
+                std::size_t rule = not_found;
+                const std::size_t pos_key = find_slot(key_hash, key, nullptr);
+                if (m_slots[pos_key].entry != 0) {
+                    rule = m_entries[m_slots[pos_key].entry - 1].rule;
+                }
+
+                const uint64_t hash = value_hash(key_hash, value, std::strlen(value));
+                const std::size_t pos_value = find_slot(hash, key, value);
+                if (m_slots[pos_value].entry != 0) {
+                    rule = std::min(rule, m_entries[m_slots[pos_value].entry - 1].rule);
+                }
+
+                return rule;
+            }
+
+            void clear() {
+                m_entries.clear();
+                m_slots.assign(16, slot{});
+                m_mask = 15;
+            }
+
+        }; // class tags_filter_index
+
+    } // namespace detail
+
     /**
      * A TagsFilterBase is a list of rules (defined using TagMatchers) to
      * check tags against. The first rule that matches sets the result.
@@ -67,6 +202,25 @@ namespace osmium {
 
         std::vector<std::pair<TResult, TagMatcher>> m_rules;
         TResult m_default_result;
+        detail::tags_filter_index m_index{};
+        std::vector<std::size_t> m_unindexed_rules{};
+        bool m_compiled = false;
+
+        TResult match_compiled(const char* key, const char* value) const noexcept {
+            const std::size_t indexed_rule = m_index.find(key, value);
+            for (const auto rule : m_unindexed_rules) {
+                if (rule > indexed_rule) {
+                    break;
+                }
+                if (m_rules[rule].second(key, value)) {
+                    return m_rules[rule].first;
+                }
+            }
+            if (indexed_rule != detail::tags_filter_index::not_found) {
+                return m_rules[indexed_rule].first;
+            }
+            return m_default_result;
+        }
 
     public:
 
@@ -99,6 +253,7 @@ namespace osmium {
          */
         TagsFilterBase& add_rule(const TResult result, const TagMatcher& matcher) {
             m_rules.emplace_back(result, matcher);
+            m_compiled = false;
             return *this;
         }
 
@@ -113,9 +268,71 @@ namespace osmium {
         template <typename... TArgs>
         TagsFilterBase& add_rule(const TResult result, TArgs&&... args) {
             m_rules.emplace_back(result, osmium::TagMatcher{std::forward<TArgs>(args)...});
+            m_compiled = false;
             return *this;
         }
 
+        /**
+         * Build an index over the rules to speed up matching. Rules that
+         * match a fixed set of keys (StringMatcher::equal or list) and
+         * either any value or a fixed set of values are put into a hash
+         * table, so the time needed to find them does not depend on the
+         * number of rules. All other rules (prefix, substring, regex, ...)
+         * are still checked one after the other, but only those that come
+         * before the first indexed rule matching the tag. The result is
+         * always the same as without calling compile().
+         *
+         * Adding a rule switches back to the uncompiled matching, call
+         * compile() again after adding all rules.
+         */
+        void compile() {
+            m_index.clear();
+            m_unindexed_rules.clear();
+
+            std::vector<std::string> keys;
+            std::vector<std::string> values;
+            for (std::size_t n = 0; n < m_rules.size(); ++n) {
+                const TagMatcher& matcher = m_rules[n].second;
+
+                keys.clear();
+                values.clear();
+                if (!matcher.key_matcher().exact_strings(keys)) {
+                    m_unindexed_rules.push_back(n);
+                } else if (matcher.value_matcher().is_always_true()) {
+                    // An inverted always_true matcher never matches.
+                    if (!matcher.value_inverted()) {
+                        for (const auto& key : keys) {
+                            m_index.add(key, nullptr, n);
+                        }
+                    }
+                } else if (!matcher.value_matcher().exact_strings(values)) {
+                    m_unindexed_rules.push_back(n);
+                } else if (!matcher.value_inverted()) {
+                    for (const auto& key : keys) {
+                        for (const auto& value : values) {
+                            m_index.add(key, &value, n);
+                        }
+                    }
+                } else if (values.empty()) {
+                    // Inverted matcher for no values matches any value.
+                    for (const auto& key : keys) {
+                        m_index.add(key, nullptr, n);
+                    }
+                } else {
+                    m_unindexed_rules.push_back(n);
+                }
+            }
+
+            m_compiled = true;
+        }
+
+        /**
+         * Has compile() been called after the last rule was added?
+         */
+        bool compiled() const noexcept {
+            return m_compiled;
+        }
+
         /**
          * Matching function. Check the specified tag against the rules.
          *
@@ -124,14 +341,53 @@ namespace osmium {
          *          matched, the default result.
          */
         TResult operator()(const osmium::Tag& tag) const noexcept {
+            return operator()(tag.key(), tag.value());
+        }
+
+        /**
+         * Matching function. Check the specified key and value against the
+         * rules.
+         *
+         * @param key The key of a tag.
+         * @param value The value of a tag.
+         * @returns The result of the matching rule, or, if none of the rules
+         *          matched, the default result.
+         */
+        TResult operator()(const char* key, const char* value) const noexcept {
+            if (m_compiled) {
+                return match_compiled(key, value);
+            }
             for (const auto& rule : m_rules) {
-                if (rule.second(tag)) {
+                if (rule.second(key, value)) {
                     return rule.first;
                 }
             }
             return m_default_result;
         }
 
+        /**
+         * Can a tag with the specified key make this filter return the
+         * specified result? This only looks at the keys, so it can be
+         * used to rule out tags without looking at their values. If it
+         * returns false, the result of the matching function for a tag
+         * with this key is never the specified result. If it returns
+         * true, it might be.
+         *
+         * @param key The key of a tag.
+         * @param result The result to check for.
+         */
+        bool key_can_match(const char* key, const TResult result) const noexcept {
+            if (m_default_result == result) {
+                return true;
+            }
+            for (const auto& rule : m_rules) {
+                if (rule.first == result && rule.second.key_matcher()(key)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
         /**
          * Return the number of rules in this filter.
          *
@@ -0,0 +1,297 @@
+#ifndef OSMIUM_THREAD_COMPLETION_RING_HPP
+#define OSMIUM_THREAD_COMPLETION_RING_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/function_wrapper.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * A fixed number of slots for the results of tasks run in a
+         * thread pool, handed out in order. This can be used instead of
+         * a std::future per task when one consumer takes the results in
+         * the order the tasks were submitted: The slots are allocated
+         * once, so there is no shared state to allocate and synchronize
+         * for each task.
+         *
+         * A task gets a ticket when it is submitted and stores its result
+         * (or exception) in the slot for that ticket. The consumer calls
+         * pop() to get the result of the oldest ticket, waiting for it
+         * if necessary.
+         *
+         * The destructor waits for all outstanding tasks, because they
+         * write into the ring.
+         *
+         * @tparam T Type of the results. Must be default constructible
+         *           and move assignable.
+         */
+        template <typename T>
+        class CompletionRing {
+
+            struct slot {
+                T value{};
+                std::exception_ptr exception{};
+                bool ready = false;
+            };
+
+            template <typename TFunction>
+            class slot_task {
+
+                CompletionRing* m_ring;
+                uint64_t m_ticket;
+                TFunction m_func;
+
+            public:
+
+                slot_task(CompletionRing* ring, uint64_t ticket, TFunction&& func) :
+                    m_ring(ring),
+                    m_ticket(ticket),
+                    m_func(std::move(func)) {
+                }
+
+                void operator()() {
+                    try {
+                        m_ring->set_value(m_ticket, m_func());
+                    } catch (...) {
+                        m_ring->set_exception(m_ticket, std::current_exception());
+                    }
+                }
+
+            }; // class slot_task
+
+            std::vector<slot> m_slots;
+            std::mutex m_mutex{};
+            std::condition_variable m_result_ready{};
+            std::condition_variable m_space_available{};
+
+            /// Ticket of the next result to be returned by pop().
+            uint64_t m_head = 0;
+
+            /// Ticket for the next reserved slot.
+            uint64_t m_tail = 0;
+
+            /// Is the consumer waiting for a result?
+            bool m_consumer_waiting = false;
+
+            slot& slot_for(uint64_t ticket) noexcept {
+                return m_slots[static_cast<std::size_t>(ticket % m_slots.size())];
+            }
+
+            void mark_ready(slot& s) {
+                s.ready = true;
+                if (m_consumer_waiting) {
+                    m_result_ready.notify_one();
+                }
+            }
+
+            // Wait for the oldest result and free its slot. Must be called
+            // with the mutex held.
+            slot take(std::unique_lock<std::mutex>& lock) {
+                assert(m_head != m_tail);
+                auto& s = slot_for(m_head);
+                m_consumer_waiting = true;
+                m_result_ready.wait(lock, [&s]() {
+                    return s.ready;
+                });
+                m_consumer_waiting = false;
+
+                slot result;
+                result.value = std::move(s.value);
+                result.exception = std::move(s.exception);
+                s.value = T{};
+                s.exception = nullptr;
+                s.ready = false;
+                ++m_head;
+                m_space_available.notify_one();
+
+                return result;
+            }
+
+        public:
+
+            /**
+             * Create a ring.
+             *
+             * @param capacity Maximum number of outstanding tasks. Must
+             *                 be at least 1.
+             */
+            explicit CompletionRing(std::size_t capacity) :
+                m_slots(capacity) {
+                assert(capacity > 0);
+            }
+
+            CompletionRing(const CompletionRing&) = delete;
+            CompletionRing& operator=(const CompletionRing&) = delete;
+
+            CompletionRing(CompletionRing&&) = delete;
+            CompletionRing& operator=(CompletionRing&&) = delete;
+
+            ~CompletionRing() noexcept {
+                drain();
+            }
+
+            /// The maximum number of outstanding tasks.
+            std::size_t capacity() const noexcept {
+                return m_slots.size();
+            }
+
+            /// The number of tasks whose results have not been popped yet.
+            std::size_t size() {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return static_cast<std::size_t>(m_tail - m_head);
+            }
+
+            bool empty() {
+                return size() == 0;
+            }
+
+            bool full() {
+                return size() == capacity();
+            }
+
+            /**
+             * Reserve the next slot and return its ticket. Blocks while
+             * all slots are in use, so the consumer must not call this
+             * when the ring is full.
+             */
+            uint64_t reserve() {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_space_available.wait(lock, [this]() {
+                    return m_tail - m_head < m_slots.size();
+                });
+                return m_tail++;
+            }
+
+            /// Store the result for the given ticket.
+            void set_value(uint64_t ticket, T&& value) {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                auto& s = slot_for(ticket);
+                assert(!s.ready);
+                s.value = std::move(value);
+                mark_ready(s);
+            }
+
+            /// Store an exception for the given ticket.
+            void set_exception(uint64_t ticket, std::exception_ptr exception) {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                auto& s = slot_for(ticket);
+                assert(!s.ready);
+                s.exception = std::move(exception);
+                mark_ready(s);
+            }
+
+            /**
+             * Wrap a function returning a T into a task for the pool that
+             * stores the result in the next slot of this ring. Reserves
+             * the slot, so the task must be run eventually, otherwise
+             * pop() and the destructor will wait forever.
+             */
+            template <typename TFunction>
+            function_wrapper wrap(TFunction&& func) {
+                using func_type = typename std::decay<TFunction>::type;
+                func_type f(std::forward<TFunction>(func));
+                const auto ticket = reserve();
+                return function_wrapper{slot_task<func_type>{this, ticket, std::move(f)}};
+            }
+
+            /**
+             * Submit a function returning a T to the pool. Its result will
+             * be returned by pop() in submission order.
+             */
+            template <typename TFunction>
+            void submit(osmium::thread::Pool& pool, TFunction&& func, const task_priority priority = task_priority::normal) {
+                using func_type = typename std::decay<TFunction>::type;
+                func_type f(std::forward<TFunction>(func));
+                const auto ticket = reserve();
+                try {
+                    pool.post(slot_task<func_type>{this, ticket, std::move(f)}, priority);
+                } catch (...) {
+                    set_exception(ticket, std::current_exception());
+                }
+            }
+
+            /**
+             * Return the result of the oldest task, waiting for it if it
+             * is not ready yet. If the task threw an exception, it is
+             * rethrown here. The ring must not be empty.
+             */
+            T pop() {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                slot result = take(lock);
+                lock.unlock();
+
+                if (result.exception) {
+                    std::rethrow_exception(result.exception);
+                }
+                return std::move(result.value);
+            }
+
+            /**
+             * Wait for the oldest task and throw its result (or exception)
+             * away. The ring must not be empty.
+             */
+            void discard() {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                take(lock);
+            }
+
+            /// Wait for all outstanding tasks and throw their results away.
+            void drain() noexcept {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                while (m_head != m_tail) {
+                    take(lock);
+                }
+            }
+
+        }; // class CompletionRing
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_COMPLETION_RING_HPP
@@ -33,7 +33,10 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cstddef>
 #include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 
 namespace osmium {
@@ -43,10 +46,23 @@ namespace osmium {
         /**
          * This function wrapper can collect move-only functions unlike
          * std::function which needs copyable functions.
-         * Taken from the book "C++ Concurrency in Action".
+         * Based on the one from the book "C++ Concurrency in Action".
+         *
+         * Functors up to inline_size bytes which can be moved without
+         * throwing are stored inside the wrapper itself, larger ones on
+         * the heap. Pool tasks (lambdas with a few captures, packaged
+         * tasks) usually fit, so no allocation is needed per task.
          */
         class function_wrapper {
 
+        public:
+
+            enum : std::size_t {
+                inline_size = 8 * sizeof(void*)
+            };
+
+        private:
+
             struct impl_base {
 
                 impl_base() noexcept = default;
@@ -63,9 +79,11 @@ namespace osmium {
                     return true;
                 }
 
-            }; // struct impl_base
+                virtual void move_to(void* storage) noexcept {
+                    new (storage) impl_base{};
+                }
 
-            std::unique_ptr<impl_base> impl;
+            }; // struct impl_base
 
             template <typename F>
             struct impl_type : impl_base {
@@ -81,48 +99,116 @@ namespace osmium {
                     return false;
                 }
 
+                void move_to(void* storage) noexcept override {
+                    new (storage) impl_type{std::move(m_functor)};
+                }
+
             }; // struct impl_type
 
+            template <typename F>
+            struct heap_impl_type : impl_base {
+
+                std::unique_ptr<F> m_functor;
+
+                explicit heap_impl_type(std::unique_ptr<F>&& functor) noexcept :
+                    m_functor(std::move(functor)) {
+                }
+
+                bool call() override {
+                    (*m_functor)();
+                    return false;
+                }
+
+                void move_to(void* storage) noexcept override {
+                    new (storage) heap_impl_type{std::move(m_functor)};
+                }
+
+            }; // struct heap_impl_type
+
+            template <typename F>
+            struct stored_inline : std::integral_constant<bool,
+                sizeof(impl_type<F>) <= inline_size + sizeof(impl_base) &&
+                alignof(impl_type<F>) <= alignof(std::max_align_t) &&
+                std::is_nothrow_move_constructible<F>::value> {
+            };
+
+            alignas(std::max_align_t) unsigned char m_storage[inline_size + sizeof(impl_base)];
+            impl_base* m_impl = nullptr;
+
+            template <typename F>
+            void create(F&& functor, std::true_type /*inline*/) {
+                m_impl = new (m_storage) impl_type<F>{std::move(functor)};
+            }
+
+            template <typename F>
+            void create(F&& functor, std::false_type /*inline*/) {
+                std::unique_ptr<F> ptr{new F(std::move(functor))};
+                m_impl = new (m_storage) heap_impl_type<F>{std::move(ptr)};
+            }
+
+            void move_from(function_wrapper& other) noexcept {
+                if (other.m_impl) {
+                    other.m_impl->move_to(m_storage);
+                    m_impl = reinterpret_cast<impl_base*>(m_storage);
+                    other.reset();
+                }
+            }
+
+            void reset() noexcept {
+                if (m_impl) {
+                    m_impl->~impl_base();
+                    m_impl = nullptr;
+                }
+            }
+
         public:
 
             // Constructor must not be "explicit" for wrapper
             // to work seemlessly.
             template <typename TFunction, typename X = typename std::enable_if<
-                !std::is_same<TFunction, function_wrapper>::value, void>::type>
+                !std::is_same<typename std::decay<TFunction>::type, function_wrapper>::value, void>::type>
             // cppcheck-suppress noExplicitConstructor
-            function_wrapper(TFunction&& f) : // NOLINT(google-explicit-constructor, hicpp-explicit-conversions)
-                impl(new impl_type<TFunction>(std::forward<TFunction>(f))) {
+            function_wrapper(TFunction&& f) { // NOLINT(google-explicit-constructor, hicpp-explicit-conversions, cppcoreguidelines-pro-type-member-init, hicpp-member-init)
+                using functor_type = typename std::decay<TFunction>::type;
+                functor_type functor(std::forward<TFunction>(f));
+                create(std::move(functor), stored_inline<functor_type>{});
             }
 
             // The integer parameter is only used to signal that we want
             // the special function wrapper that makes the worker thread
             // shut down.
-            explicit function_wrapper(int /*dummy*/) :
-                impl(new impl_base()) {
+            explicit function_wrapper(int /*dummy*/) : // NOLINT(cppcoreguidelines-pro-type-member-init, hicpp-member-init)
+                m_impl(new (m_storage) impl_base{}) {
             }
 
             bool operator()() {
-                return impl->call();
+                return m_impl->call();
             }
 
-            function_wrapper() = default;
+            function_wrapper() noexcept { // NOLINT(cppcoreguidelines-pro-type-member-init, hicpp-member-init, modernize-use-equals-default)
+            }
 
             function_wrapper(const function_wrapper&) = delete;
             function_wrapper& operator=(const function_wrapper&) = delete;
 
-            function_wrapper(function_wrapper&& other) noexcept :
-                impl(std::move(other.impl)) {
+            function_wrapper(function_wrapper&& other) noexcept { // NOLINT(cppcoreguidelines-pro-type-member-init, hicpp-member-init)
+                move_from(other);
             }
 
             function_wrapper& operator=(function_wrapper&& other) noexcept {
-                impl = std::move(other.impl);
+                if (this != &other) {
+                    reset();
+                    move_from(other);
+                }
                 return *this;
             }
 
-            ~function_wrapper() = default;
+            ~function_wrapper() noexcept {
+                reset();
+            }
 
-            explicit operator bool() const {
-                return static_cast<bool>(impl);
+            explicit operator bool() const noexcept {
+                return m_impl != nullptr;
             }
 
         }; // class function_wrapper
@@ -34,12 +34,22 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/thread/function_wrapper.hpp>
-#include <osmium/thread/queue.hpp>
+#include <osmium/thread/stats.hpp>
+#include <osmium/thread/thread_policy.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/numa.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <type_traits>
 #include <utility>
@@ -84,11 +94,40 @@ namespace osmium {
 
         } // namespace detail
 
+        /**
+         * Priority of a task in the thread pool. Tasks with high priority
+         * are always run before tasks with normal priority. Use high
+         * priority for work somebody is already waiting for (for instance
+         * decoding data a Reader will return next) and normal priority
+         * for background work (for instance encoding data in a Writer).
+         */
+        enum class task_priority {
+            normal = 0,
+            high = 1
+        }; // enum class task_priority
+
         /**
          *  Thread pool.
+         *
+         *  Each worker thread has its own task queue (one for each
+         *  priority). New tasks are distributed round-robin over the
+         *  queues, tasks submitted from a worker thread go into the queue
+         *  of that worker. If its own queue is empty, a worker steals
+         *  tasks from the other queues. Oldest tasks are always taken
+         *  first, because results are usually consumed in order.
+         *
+         *  If NUMA support is enabled (see osmium::config::use_numa()),
+         *  the workers are distributed over the NUMA nodes and pinned to
+         *  the CPUs of their node. They steal from workers on the same
+         *  node first. Memory allocated by a worker when decoding or
+         *  encoding data will then usually be on its own node.
          */
         class Pool {
 
+            enum {
+                num_priorities = 2
+            };
+
             /**
              * This class makes sure all pool threads will be joined when
              * the pool is destructed.
@@ -119,19 +158,200 @@ namespace osmium {
 
             }; // class thread_joiner
 
-            osmium::thread::Queue<function_wrapper> m_work_queue;
+            struct worker_queue {
+                std::mutex mutex{};
+                std::deque<function_wrapper> tasks[num_priorities];
+            }; // struct worker_queue
+
+            // Identifies the worker thread we are running in (if any).
+            struct worker_info {
+                const Pool* pool = nullptr;
+                std::size_t index = 0;
+            }; // struct worker_info
+
+            static worker_info& this_worker() noexcept {
+                static thread_local worker_info info;
+                return info;
+            }
+
+            std::vector<std::unique_ptr<worker_queue>> m_queues{};
+
+            /// For each worker the order in which queues are checked.
+            std::vector<std::vector<std::size_t>> m_queue_order{};
+
+            /// For each worker the CPUs it is pinned to (empty if not pinned).
+            std::vector<std::vector<int>> m_worker_cpus{};
+
+            /// Nice value for the workers (if set in the thread policy).
+            int m_worker_nice = 0;
+            bool m_set_worker_nice = false;
+
+            /// Number of tasks in all the queues.
+            std::atomic<std::size_t> m_num_tasks{0};
+
+            std::atomic<std::size_t> m_next_queue{0};
+
+            std::size_t m_max_queue_size;
+
+            /// Number of threads waiting for a task
+            std::atomic<int> m_num_idle{0};
+
+            /// Number of threads waiting for space in the queue
+            std::atomic<int> m_num_blocked{0};
+
+            std::atomic<bool> m_shutdown{false};
+
+            /// Number of tasks run so far
+            std::atomic<uint64_t> m_tasks_done{0};
+
+            /// Total time spent running tasks in nanoseconds
+            std::atomic<uint64_t> m_busy_time{0};
+
+            /// Only used for sleeping and waking up threads.
+            std::mutex m_mutex{};
+            std::condition_variable m_task_available{};
+            std::condition_variable m_space_available{};
+
             std::vector<std::thread> m_threads{};
             thread_joiner m_joiner;
             int m_num_threads;
 
-            void worker_thread() {
+            bool pop_task(std::deque<function_wrapper>& tasks, std::mutex& mutex, function_wrapper& task) {
+                const std::lock_guard<std::mutex> lock{mutex};
+                if (tasks.empty()) {
+                    return false;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+                return true;
+            }
+
+            bool get_task(const std::size_t index, function_wrapper& task) {
+                for (int priority = num_priorities - 1; priority >= 0; --priority) {
+                    for (const auto n : m_queue_order[index]) {
+                        auto& queue = *m_queues[n];
+                        if (pop_task(queue.tasks[priority], queue.mutex, task)) {
+                            --m_num_tasks;
+                            if (m_num_blocked > 0) {
+                                const std::lock_guard<std::mutex> lock{m_mutex};
+                                m_space_available.notify_one();
+                            }
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            }
+
+            void add_task(function_wrapper&& task, const task_priority priority) {
+                auto& worker = this_worker();
+                const bool in_worker = worker.pool == this;
+
+                // Don't block worker threads, they can't wait for
+                // themselves to make space in the queue.
+                if (!in_worker && m_num_tasks >= m_max_queue_size) {
+                    constexpr const std::chrono::milliseconds max_wait{10};
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    ++m_num_blocked;
+                    while (m_num_tasks >= m_max_queue_size && !m_shutdown) {
+                        m_space_available.wait_for(lock, max_wait);
+                    }
+                    --m_num_blocked;
+                }
+
+                // Count the task first, so that the counter never goes
+                // below zero when a worker takes the task immediately.
+                ++m_num_tasks;
+                const std::size_t index = in_worker ? worker.index : m_next_queue++ % m_queues.size();
+                auto& queue = *m_queues[index];
+                try {
+                    const std::lock_guard<std::mutex> lock{queue.mutex};
+                    queue.tasks[static_cast<int>(priority)].push_back(std::move(task));
+                } catch (...) {
+                    --m_num_tasks;
+                    throw;
+                }
+
+                if (m_num_idle > 0) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    m_task_available.notify_one();
+                }
+            }
+
+            void add_tasks(std::vector<function_wrapper>& tasks, const task_priority priority) {
+                auto& worker = this_worker();
+                const bool in_worker = worker.pool == this;
+
+                // Only wait for the queue to have some space, the batch
+                // as a whole can go over the limit.
+                if (!in_worker && m_num_tasks >= m_max_queue_size) {
+                    constexpr const std::chrono::milliseconds max_wait{10};
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    ++m_num_blocked;
+                    while (m_num_tasks >= m_max_queue_size && !m_shutdown) {
+                        m_space_available.wait_for(lock, max_wait);
+                    }
+                    --m_num_blocked;
+                }
+
+                // Tasks from a worker go into its own queue, other tasks
+                // are split into one consecutive run per queue, so that
+                // each queue is locked only once.
+                const std::size_t num_queues = in_worker ? 1 : m_queues.size();
+                const std::size_t first_queue = in_worker ? worker.index : m_next_queue.fetch_add(num_queues);
+                const std::size_t per_queue = (tasks.size() + num_queues - 1) / num_queues;
+
+                std::size_t next = 0;
+                for (std::size_t n = 0; n < num_queues && next < tasks.size(); ++n) {
+                    auto& queue = *m_queues[(first_queue + n) % m_queues.size()];
+                    const std::size_t last = std::min(next + per_queue, tasks.size());
+                    const std::lock_guard<std::mutex> lock{queue.mutex};
+                    auto& queue_tasks = queue.tasks[static_cast<int>(priority)];
+                    for (; next < last; ++next) {
+                        queue_tasks.push_back(std::move(tasks[next]));
+                        ++m_num_tasks;
+                    }
+                }
+                tasks.clear();
+
+                if (m_num_idle > 0) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    m_task_available.notify_all();
+                }
+            }
+
+            void worker_thread(const std::size_t index) {
                 osmium::thread::set_thread_name("_osmium_worker");
+                this_worker().pool = this;
+                this_worker().index = index;
+                if (!m_worker_cpus[index].empty()) {
+                    osmium::util::pin_current_thread_to_cpus(m_worker_cpus[index]);
+                }
+                if (m_set_worker_nice) {
+                    detail::set_current_thread_nice(m_worker_nice);
+                }
+
                 while (true) {
                     function_wrapper task;
-                    m_work_queue.wait_and_pop(task);
-                    if (task && task()) {
-                        // The called tasks returns true only when the
-                        // worker thread should shut down.
+                    if (get_task(index, task)) {
+                        const auto start = std::chrono::steady_clock::now();
+                        task();
+                        const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+                        m_busy_time.fetch_add(static_cast<uint64_t>(duration.count()), std::memory_order_relaxed);
+                        m_tasks_done.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+
+                    // The timeout is just a safety net, submitting threads
+                    // will notify us, because they see the idle counter.
+                    constexpr const std::chrono::milliseconds max_wait{10};
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    ++m_num_idle;
+                    while (m_num_tasks == 0 && !m_shutdown) {
+                        m_task_available.wait_for(lock, max_wait);
+                    }
+                    --m_num_idle;
+                    if (m_num_tasks == 0 && m_shutdown) {
                         return;
                     }
                 }
@@ -160,16 +380,70 @@ namespace osmium {
              * In all cases the minimum number of threads in the pool is 1.
              *
              * If max_queue_size is 0, the queue size is read from
-             * the environment variable OSMIUM_MAX_WORK_QUEUE_SIZE.
+             * the environment variable OSMIUM_MAX_WORK_QUEUE_SIZE. This
+             * is the maximum number of tasks waiting in all queues
+             * together. Submitting a task from outside the pool will block
+             * while the queues are full.
+             *
+             * The settings for the worker role in the thread policy are
+             * applied to all worker threads. If CPUs are set there, they
+             * are used instead of the CPUs of the NUMA nodes. By default
+             * the policy is read from the environment variable
+             * OSMIUM_THREAD_POLICY.
              */
-            explicit Pool(int num_threads = default_num_threads, std::size_t max_queue_size = default_queue_size) :
-                m_work_queue(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size(), "work"),
+            explicit Pool(int num_threads = default_num_threads,
+                          std::size_t max_queue_size = default_queue_size,
+                          const thread_policy& policy = thread_policy::from_config()) :
+                m_max_queue_size(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size()),
                 m_joiner(m_threads),
                 m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())) {
 
+                const auto num_queues = static_cast<std::size_t>(m_num_threads);
+                std::vector<std::size_t> worker_node(num_queues, 0);
+                m_worker_cpus.resize(num_queues);
+
+                if (osmium::config::use_numa()) {
+                    const auto nodes = osmium::util::get_numa_nodes();
+                    if (nodes.size() > 1) {
+                        for (std::size_t i = 0; i < num_queues; ++i) {
+                            worker_node[i] = i % nodes.size();
+                            m_worker_cpus[i] = nodes[worker_node[i]].cpus;
+                        }
+                    }
+                }
+
+                const auto& worker_settings = policy.settings(thread_role::worker);
+                if (!worker_settings.cpus.empty()) {
+                    for (auto& cpus : m_worker_cpus) {
+                        cpus = worker_settings.cpus;
+                    }
+                }
+                m_worker_nice = worker_settings.nice;
+                m_set_worker_nice = worker_settings.set_nice;
+
+                // Own queue first, then the queues of the other workers on
+                // the same node, then all the rest.
+                for (std::size_t i = 0; i < num_queues; ++i) {
+                    m_queues.emplace_back(new worker_queue{});
+                    m_queue_order.emplace_back();
+                    auto& order = m_queue_order.back();
+                    for (std::size_t n = 0; n < num_queues; ++n) {
+                        const auto q = (i + n) % num_queues;
+                        if (worker_node[q] == worker_node[i]) {
+                            order.push_back(q);
+                        }
+                    }
+                    for (std::size_t n = 0; n < num_queues; ++n) {
+                        const auto q = (i + n) % num_queues;
+                        if (worker_node[q] != worker_node[i]) {
+                            order.push_back(q);
+                        }
+                    }
+                }
+
                 try {
                     for (int i = 0; i < m_num_threads; ++i) {
-                        m_threads.emplace_back(&Pool::worker_thread, this);
+                        m_threads.emplace_back(&Pool::worker_thread, this, static_cast<std::size_t>(i));
                     }
                 } catch (...) {
                     shutdown_all_workers();
@@ -188,11 +462,15 @@ namespace osmium {
                 return pool;
             }
 
+            /**
+             * Tell all worker threads to shut down after all tasks in the
+             * queues are done.
+             */
             void shutdown_all_workers() {
-                for (int i = 0; i < m_num_threads; ++i) {
-                    // The special function wrapper makes a worker shut down.
-                    m_work_queue.push(function_wrapper{0});
-                }
+                m_shutdown = true;
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_task_available.notify_all();
+                m_space_available.notify_all();
             }
 
             Pool(const Pool&) = delete;
@@ -210,11 +488,21 @@ namespace osmium {
             }
 
             std::size_t queue_size() const {
-                return m_work_queue.size();
+                return m_num_tasks;
             }
 
             bool queue_empty() const {
-                return m_work_queue.empty();
+                return m_num_tasks == 0;
+            }
+
+            /// Get the current values of the counters of this pool.
+            pool_stats stats() const noexcept {
+                pool_stats result;
+                result.num_threads = m_num_threads;
+                result.queued_tasks = m_num_tasks;
+                result.tasks_done = m_tasks_done.load(std::memory_order_relaxed);
+                result.busy_time = std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(m_busy_time.load(std::memory_order_relaxed))};
+                return result;
             }
 
 #if defined(__cpp_lib_is_invocable) && __cpp_lib_is_invocable >= 201703
@@ -228,15 +516,56 @@ namespace osmium {
             using submit_func_result_type = typename std::result_of<TFunction()>::type;
 #endif
 
+            /**
+             * Submit a task to the pool.
+             *
+             * @param func The function to call.
+             * @param priority The priority of the task.
+             * @returns A future for the result of the function.
+             */
             template <typename TFunction>
-            std::future<submit_func_result_type<TFunction>> submit(TFunction&& func) {
+            std::future<submit_func_result_type<TFunction>> submit(TFunction&& func, const task_priority priority = task_priority::normal) {
                 std::packaged_task<submit_func_result_type<TFunction>()> task{std::forward<TFunction>(func)};
                 std::future<submit_func_result_type<TFunction>> future_result{task.get_future()};
-                m_work_queue.push(std::move(task));
+                add_task(std::move(task), priority);
 
                 return future_result;
             }
 
+            /**
+             * Submit a task to the pool without creating a future for
+             * the result. This avoids allocating the shared state of a
+             * future for each task. The function must not throw, any
+             * results must be passed on by the function itself (for
+             * instance through a CompletionRing).
+             *
+             * @param func The function to call.
+             * @param priority The priority of the task.
+             */
+            template <typename TFunction>
+            void post(TFunction&& func, const task_priority priority = task_priority::normal) {
+                add_task(function_wrapper{std::forward<TFunction>(func)}, priority);
+            }
+
+            /**
+             * Submit several tasks to the pool at once. Each worker queue
+             * is only locked once for the whole batch. The same rules as
+             * for post() apply to the tasks. The vector is empty
+             * afterwards.
+             *
+             * If called from outside the pool this only blocks while the
+             * queues are full before the batch is added, the batch itself
+             * can exceed the maximum queue size.
+             *
+             * @param tasks The tasks.
+             * @param priority The priority of the tasks.
+             */
+            void post_batch(std::vector<function_wrapper>& tasks, const task_priority priority = task_priority::normal) {
+                if (!tasks.empty()) {
+                    add_tasks(tasks, priority);
+                }
+            }
+
         }; // class Pool
 
     } // namespace thread
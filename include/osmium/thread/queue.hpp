@@ -33,10 +33,14 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/thread/stats.hpp>
+#include <osmium/util/tracepoint.hpp>
+
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <mutex>
 #include <queue>
 #include <string>
@@ -60,7 +64,7 @@ namespace osmium {
             /// the queue will block.
             const std::size_t m_max_size;
 
-            /// Name of this queue (for debugging only).
+            /// Name of this queue (for debugging and statistics).
             const std::string m_name;
 
             mutable std::mutex m_mutex;
@@ -75,27 +79,20 @@ namespace osmium {
 
             std::atomic<bool> m_in_use{true};
 
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
             /// The largest size the queue has been so far.
-            std::size_t m_largest_size;
+            std::size_t m_largest_size = 0;
 
-            /// The number of times push() was called on the queue.
-            std::atomic<int> m_push_counter;
+            /// The number of elements pushed onto the queue.
+            uint64_t m_push_counter = 0;
 
-            /// The number of times the queue was full and a thread pushing
-            /// to the queue was blocked.
-            std::atomic<int> m_full_counter;
+            /// The number of elements popped from the queue.
+            uint64_t m_pop_counter = 0;
 
-            /**
-             * The number of times wait_and_pop(with_timeout)() was called
-             * on the queue.
-             */
-            std::atomic<int> m_pop_counter;
+            /// How often and how long producers waited on a full queue.
+            detail::wait_counter m_full_waits;
 
-            /// The number of times the queue was full and a thread pushing
-            /// to the queue was blocked.
-            std::atomic<int> m_empty_counter;
-#endif
+            /// How often and how long consumers waited on an empty queue.
+            detail::wait_counter m_empty_waits;
 
         public:
 
@@ -109,16 +106,7 @@ namespace osmium {
             explicit Queue(std::size_t max_size = 0, std::string name = "") :
                 m_max_size(max_size),
                 m_name(std::move(name)),
-                m_queue()
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ,
-                m_largest_size(0),
-                m_push_counter(0),
-                m_full_counter(0),
-                m_pop_counter(0),
-                m_empty_counter(0)
-#endif
-            {
+                m_queue() {
             }
 
             Queue(const Queue&) = delete;
@@ -129,13 +117,14 @@ namespace osmium {
 
 #ifdef OSMIUM_DEBUG_QUEUE_SIZE
             ~Queue() {
-                std::cerr << "queue '" << m_name
-                          << "' with max_size=" << m_max_size
-                          << " had largest size " << m_largest_size
-                          << " and was full " << m_full_counter
-                          << " times in " << m_push_counter
-                          << " push() calls and was empty " << m_empty_counter
-                          << " times in " << m_pop_counter
+                const auto s = stats();
+                std::cerr << "queue '" << s.name
+                          << "' with max_size=" << s.max_size
+                          << " had largest size " << s.largest_size
+                          << " and was full " << s.full_waits
+                          << " times in " << s.pushes
+                          << " push() calls and was empty " << s.empty_waits
+                          << " times in " << s.pops
                           << " pop() calls\n";
             }
 #else
@@ -151,46 +140,42 @@ namespace osmium {
                     return;
                 }
                 constexpr const std::chrono::milliseconds max_wait{10};
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_push_counter;
-#endif
-                if (m_max_size) {
+                if (m_max_size && size() >= m_max_size) {
+                    const auto start = detail::wait_counter::clock::now();
+                    OSMIUM_TRACEPOINT2(queue_push_wait_start, m_name.c_str(), m_max_size);
                     while (size() >= m_max_size) {
                         std::unique_lock<std::mutex> lock{m_mutex};
                         m_space_available.wait_for(lock, max_wait, [this] {
                             return m_queue.size() < m_max_size;
                         });
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                        ++m_full_counter;
-#endif
                     }
+                    m_full_waits.add(start);
+                    OSMIUM_TRACEPOINT2(queue_push_wait_end, m_name.c_str(), m_max_size);
                 }
                 const std::lock_guard<std::mutex> lock{m_mutex};
                 m_queue.push(std::move(value));
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+                ++m_push_counter;
                 if (m_largest_size < m_queue.size()) {
                     m_largest_size = m_queue.size();
                 }
-#endif
                 m_data_available.notify_one();
             }
 
             void wait_and_pop(T& value) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_pop_counter;
-#endif
                 std::unique_lock<std::mutex> lock{m_mutex};
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
                 if (m_queue.empty()) {
-                    ++m_empty_counter;
+                    const auto start = detail::wait_counter::clock::now();
+                    OSMIUM_TRACEPOINT1(queue_pop_wait_start, m_name.c_str());
+                    m_data_available.wait(lock, [this] {
+                        return !m_in_use || !m_queue.empty();
+                    });
+                    m_empty_waits.add(start);
+                    OSMIUM_TRACEPOINT1(queue_pop_wait_end, m_name.c_str());
                 }
-#endif
-                m_data_available.wait(lock, [this] {
-                    return !m_in_use || !m_queue.empty();
-                });
                 if (!m_queue.empty()) {
                     value = std::move(m_queue.front());
                     m_queue.pop();
+                    ++m_pop_counter;
                     lock.unlock();
                     if (m_max_size) {
                         m_space_available.notify_one();
@@ -199,19 +184,14 @@ namespace osmium {
             }
 
             bool try_pop(T& value) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_pop_counter;
-#endif
                 {
                     const std::lock_guard<std::mutex> lock{m_mutex};
                     if (m_queue.empty()) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                        ++m_empty_counter;
-#endif
                         return false;
                     }
                     value = std::move(m_queue.front());
                     m_queue.pop();
+                    ++m_pop_counter;
                 }
                 if (m_max_size) {
                     m_space_available.notify_one();
@@ -233,6 +213,25 @@ namespace osmium {
                 return m_in_use;
             }
 
+            /// Get the current values of the counters of this queue.
+            queue_stats stats() const {
+                queue_stats result;
+                result.name = m_name;
+                result.max_size = m_max_size;
+                {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    result.size = m_queue.size();
+                    result.largest_size = m_largest_size;
+                    result.pushes = m_push_counter;
+                    result.pops = m_pop_counter;
+                }
+                result.full_waits = m_full_waits.count();
+                result.empty_waits = m_empty_waits.count();
+                result.full_wait_time = m_full_waits.time();
+                result.empty_wait_time = m_empty_waits.time();
+                return result;
+            }
+
             void shutdown() {
                 m_in_use = false;
                 const std::lock_guard<std::mutex> lock{m_mutex};
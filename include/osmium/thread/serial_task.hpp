@@ -0,0 +1,165 @@
+#ifndef OSMIUM_THREAD_SERIAL_TASK_HPP
+#define OSMIUM_THREAD_SERIAL_TASK_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/pool.hpp>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * Runs a step function as tasks on a thread pool, never more than
+         * one at a time. This can be used instead of a dedicated thread for
+         * work like reading from or writing to a file which is driven by a
+         * queue: Whenever something happens that might allow more work to
+         * be done, call schedule(). The step function is then called
+         * repeatedly in a pool thread until it returns false, which means
+         * it can't do anything more right now.
+         *
+         * Because the runs are serialized, the step function can use state
+         * without locking, everything one run did is visible to the next.
+         *
+         * The step function must not block waiting for other tasks in
+         * the same pool, otherwise the pool can deadlock.
+         */
+        class SerialTask {
+
+            Pool& m_pool;
+            std::function<bool()> m_step;
+
+            std::mutex m_mutex;
+            std::condition_variable m_idle;
+
+            // Is a task in the pool queue or running?
+            bool m_scheduled = false;
+
+            // Was schedule() called while a task was running?
+            bool m_pending = false;
+
+            bool m_stopped = false;
+
+            void run() {
+                while (true) {
+                    {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                        if (m_stopped) {
+                            m_scheduled = false;
+                            m_idle.notify_all();
+                            return;
+                        }
+                        m_pending = false;
+                    }
+
+                    if (m_step()) {
+                        continue;
+                    }
+
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    if (!m_pending || m_stopped) {
+                        m_scheduled = false;
+                        m_idle.notify_all();
+                        return;
+                    }
+                }
+            }
+
+        public:
+
+            SerialTask(Pool& pool, std::function<bool()> step) :
+                m_pool(pool),
+                m_step(std::move(step)) {
+            }
+
+            SerialTask(const SerialTask&) = delete;
+            SerialTask& operator=(const SerialTask&) = delete;
+
+            SerialTask(SerialTask&&) = delete;
+            SerialTask& operator=(SerialTask&&) = delete;
+
+            ~SerialTask() noexcept {
+                stop();
+            }
+
+            /**
+             * Make sure the step function is called soon. If it is running
+             * right now, it will be called again after it returned false.
+             */
+            void schedule() {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                if (m_stopped) {
+                    return;
+                }
+                if (m_scheduled) {
+                    m_pending = true;
+                    return;
+                }
+                m_scheduled = true;
+                m_pool.submit([this]() {
+                    run();
+                });
+            }
+
+            /**
+             * Don't call the step function any more and wait until a
+             * currently running one returned.
+             */
+            void stop() noexcept {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_stopped = true;
+                m_idle.wait(lock, [this]() {
+                    return !m_scheduled;
+                });
+            }
+
+            /// Wait until the step function is not scheduled or running.
+            void wait_until_idle() {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_idle.wait(lock, [this]() {
+                    return !m_scheduled;
+                });
+            }
+
+        }; // class SerialTask
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_SERIAL_TASK_HPP
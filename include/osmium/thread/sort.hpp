@@ -0,0 +1,191 @@
+#ifndef OSMIUM_THREAD_SORT_HPP
+#define OSMIUM_THREAD_SORT_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        namespace detail {
+
+            // Ranges smaller than this are always sorted in the calling
+            // thread.
+            enum : std::size_t {
+                min_parallel_sort_size = 16UL * 1024UL
+            };
+
+            // Wait for all futures, even if some of them throw, because
+            // the tasks reference the data being sorted. Then rethrow the
+            // first exception, if any.
+            inline void wait_for_all(std::vector<std::future<void>>& futures) {
+                std::exception_ptr exception;
+                for (auto& future : futures) {
+                    try {
+                        future.get();
+                    } catch (...) {
+                        if (!exception) {
+                            exception = std::current_exception();
+                        }
+                    }
+                }
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+            }
+
+            /**
+             * Split the range into one chunk per thread, sort the chunks
+             * in parallel using sort_chunk and then merge neighbouring
+             * chunks pairwise in rounds, the merges in each round again
+             * in parallel. The merges are stable, so the result is stable
+             * if sort_chunk is.
+             */
+            template <typename TIterator, typename TCompare, typename TSortChunk>
+            void parallel_merge_sort(TIterator first, TIterator last, TCompare& compare, Pool& pool, TSortChunk&& sort_chunk) {
+                const auto size = static_cast<std::size_t>(std::distance(first, last));
+                const auto num_chunks = std::min(static_cast<std::size_t>(pool.num_threads()),
+                                                 size / min_parallel_sort_size);
+                if (num_chunks < 2) {
+                    sort_chunk(first, last, compare);
+                    return;
+                }
+
+                std::vector<std::size_t> bounds;
+                for (std::size_t n = 0; n < num_chunks; ++n) {
+                    bounds.push_back(size * n / num_chunks);
+                }
+                bounds.push_back(size);
+
+                std::vector<std::future<void>> futures;
+                for (std::size_t n = 0; n < num_chunks; ++n) {
+                    const auto begin = first + bounds[n];
+                    const auto end = first + bounds[n + 1];
+                    futures.push_back(pool.submit([begin, end, &compare, &sort_chunk]() {
+                        sort_chunk(begin, end, compare);
+                    }));
+                }
+                wait_for_all(futures);
+
+                std::vector<std::size_t> new_bounds;
+                while (bounds.size() > 2) {
+                    futures.clear();
+                    new_bounds.clear();
+
+                    std::size_t i = 0;
+                    for (; i + 2 < bounds.size(); i += 2) {
+                        const auto b0 = first + bounds[i];
+                        const auto b1 = first + bounds[i + 1];
+                        const auto b2 = first + bounds[i + 2];
+                        new_bounds.push_back(bounds[i]);
+                        futures.push_back(pool.submit([b0, b1, b2, &compare]() {
+                            std::inplace_merge(b0, b1, b2, compare);
+                        }));
+                    }
+
+                    // odd number of chunks: the last one stays as it is
+                    if (i + 1 < bounds.size()) {
+                        new_bounds.push_back(bounds[i]);
+                    }
+                    new_bounds.push_back(bounds.back());
+
+                    wait_for_all(futures);
+                    bounds.swap(new_bounds);
+                }
+            }
+
+        } // namespace detail
+
+        /**
+         * Sort the range [first, last) using the threads in the pool.
+         * Like std::stable_sort() the order of equal elements is
+         * preserved. The range is split into one chunk per thread, the
+         * chunks are sorted in parallel and then merged pairwise in
+         * parallel using std::inplace_merge().
+         *
+         * Small ranges or a pool with only one thread are sorted with
+         * std::stable_sort() in the calling thread.
+         *
+         * @tparam TIterator Random access iterator. The value type must be
+         *         movable.
+         * @param first Beginning of the range.
+         * @param last End of the range.
+         * @param compare Comparison function object. It will be called
+         *        from several threads at the same time.
+         * @param pool The thread pool to use.
+         */
+        template <typename TIterator, typename TCompare>
+        void stable_sort(TIterator first, TIterator last, TCompare compare, Pool& pool) {
+            detail::parallel_merge_sort(first, last, compare, pool, [](TIterator begin, TIterator end, TCompare& comp) {
+                std::stable_sort(begin, end, comp);
+            });
+        }
+
+        /**
+         * Sort the range [first, last) using the threads in the pool.
+         * Works like stable_sort() above, but the chunks are sorted with
+         * std::sort(), so like std::sort() the order of equal elements
+         * is not preserved.
+         */
+        template <typename TIterator, typename TCompare>
+        void sort(TIterator first, TIterator last, TCompare compare, Pool& pool) {
+            detail::parallel_merge_sort(first, last, compare, pool, [](TIterator begin, TIterator end, TCompare& comp) {
+                std::sort(begin, end, comp);
+            });
+        }
+
+        /**
+         * Sort the range [first, last) with operator< using the threads in
+         * the pool. See above.
+         */
+        template <typename TIterator>
+        void sort(TIterator first, TIterator last, Pool& pool) {
+            sort(first, last, std::less<typename std::iterator_traits<TIterator>::value_type>{}, pool);
+        }
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_SORT_HPP
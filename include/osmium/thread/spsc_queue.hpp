@@ -0,0 +1,350 @@
+#ifndef OSMIUM_THREAD_SPSC_QUEUE_HPP
+#define OSMIUM_THREAD_SPSC_QUEUE_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/stats.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * A bounded thread-safe queue for exactly one producer thread and
+         * one consumer thread. It is implemented as a ring buffer with
+         * atomic head and tail counters, so push() and pop don't need a
+         * lock. A thread that has to wait, because the queue is full or
+         * empty, spins for a short while before it goes to sleep on a
+         * condition variable.
+         *
+         * The interface is the same as the one for osmium::thread::Queue,
+         * but there are two restrictions: Only one thread is allowed to
+         * call push() and only one thread is allowed to call
+         * wait_and_pop(), try_pop(), and shutdown(). And the size of the
+         * queue is always limited.
+         */
+        template <typename T>
+        class SPSCQueue {
+
+            enum : std::size_t {
+                /// Size used if no max size is set.
+                default_max_size = 1024,
+
+                /// Number of times to check for data before sleeping.
+                spin_count = 200,
+
+                cache_line_size = 64
+            };
+
+            // Counters are on different cache lines so that producer and
+            // consumer don't get in each others way.
+            struct padded_counter {
+                std::atomic<std::size_t> value{0};
+                char padding[cache_line_size - sizeof(std::atomic<std::size_t>)];
+            };
+
+            /// Maximum size of this queue. If the queue is full pushing to
+            /// the queue will block.
+            const std::size_t m_max_size;
+
+            /// Name of this queue (for debugging and statistics).
+            const std::string m_name;
+
+            std::vector<T> m_slots;
+
+            /// Number of elements popped so far. Written by consumer.
+            padded_counter m_head;
+
+            /// Number of elements pushed so far. Written by producer.
+            padded_counter m_tail;
+
+            std::atomic<bool> m_in_use{true};
+
+            /// The largest size the queue has been so far. Written by producer.
+            std::atomic<std::size_t> m_largest_size{0};
+
+            /// How often and how long the producer waited on a full queue.
+            detail::wait_counter m_full_waits;
+
+            /// How often and how long the consumer waited on an empty queue.
+            detail::wait_counter m_empty_waits;
+
+            /// Total size of the popped elements. Written by consumer.
+            std::atomic<uint64_t> m_popped_bytes{0};
+
+            std::atomic<bool> m_consumer_waiting{false};
+            std::atomic<bool> m_producer_waiting{false};
+
+            /// Called by the producer after each push (if set).
+            std::function<void()> m_after_push;
+
+            /// Called by the consumer after each pop (if set).
+            std::function<void()> m_after_pop;
+
+            /// Only used for sleeping and waking up threads.
+            std::mutex m_mutex;
+
+            /// Used to signal consumer when data is available in the queue.
+            std::condition_variable m_data_available;
+
+            /// Used to signal producer when queue is not full.
+            std::condition_variable m_space_available;
+
+            template <typename TPredicate>
+            void wait_until(TPredicate&& ready, std::atomic<bool>& waiting, std::condition_variable& condition) {
+                for (std::size_t i = 0; i < spin_count; ++i) {
+                    if (ready()) {
+                        return;
+                    }
+                    if (i >= spin_count / 2) {
+                        std::this_thread::yield();
+                    }
+                }
+
+                // The timeout is just a safety net, the other side will
+                // notify us, because it sees the waiting flag.
+                constexpr const std::chrono::milliseconds max_wait{10};
+                std::unique_lock<std::mutex> lock{m_mutex};
+                waiting = true;
+                while (!ready()) {
+                    condition.wait_for(lock, max_wait);
+                }
+                waiting = false;
+            }
+
+            void wake_up(const std::atomic<bool>& waiting, std::condition_variable& condition) {
+                if (waiting) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    condition.notify_one();
+                }
+            }
+
+            bool is_full() const noexcept {
+                return size() >= m_max_size;
+            }
+
+            void pop_front(T& value) {
+                const std::size_t head = m_head.value.load(std::memory_order_relaxed);
+                value = std::move(m_slots[head % m_max_size]);
+                m_head.value = head + 1;
+                wake_up(m_producer_waiting, m_space_available);
+                if (m_after_pop) {
+                    m_after_pop();
+                }
+            }
+
+        public:
+
+            /**
+             * Construct a single producer, single consumer queue.
+             *
+             * @param max_size Maximum number of elements in the queue. Set to
+             *                 0 for the default size.
+             * @param name Optional name for this queue. (Used for debugging.)
+             */
+            explicit SPSCQueue(std::size_t max_size = 0, std::string name = "") :
+                m_max_size(max_size == 0 ? static_cast<std::size_t>(default_max_size) : max_size),
+                m_name(std::move(name)),
+                m_slots(m_max_size) {
+            }
+
+            SPSCQueue(const SPSCQueue&) = delete;
+            SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+            SPSCQueue(SPSCQueue&&) = delete;
+            SPSCQueue& operator=(SPSCQueue&&) = delete;
+
+            ~SPSCQueue() = default;
+
+            /**
+             * Push an element onto the queue. This call will block if the
+             * queue is full.
+             */
+            void push(T value) {
+                if (!m_in_use) {
+                    return;
+                }
+
+                if (is_full()) {
+                    const auto start = detail::wait_counter::clock::now();
+                    wait_until([this] {
+                        return !m_in_use || !is_full();
+                    }, m_producer_waiting, m_space_available);
+                    m_full_waits.add(start);
+                    if (!m_in_use) {
+                        return;
+                    }
+                }
+
+                const std::size_t tail = m_tail.value.load(std::memory_order_relaxed);
+                m_slots[tail % m_max_size] = std::move(value);
+                m_tail.value = tail + 1;
+
+                const std::size_t current_size = size();
+                if (current_size > m_largest_size.load(std::memory_order_relaxed)) {
+                    m_largest_size.store(current_size, std::memory_order_relaxed);
+                }
+                wake_up(m_consumer_waiting, m_data_available);
+                if (m_after_push) {
+                    m_after_push();
+                }
+            }
+
+            void wait_and_pop(T& value) {
+                if (empty()) {
+                    const auto start = detail::wait_counter::clock::now();
+                    wait_until([this] {
+                        return !m_in_use || !empty();
+                    }, m_consumer_waiting, m_data_available);
+                    m_empty_waits.add(start);
+                }
+                if (!empty()) {
+                    pop_front(value);
+                }
+            }
+
+            bool try_pop(T& value) {
+                if (empty()) {
+                    return false;
+                }
+                pop_front(value);
+                return true;
+            }
+
+            /**
+             * Get a pointer to the first element in the queue without
+             * removing it or nullptr if the queue is empty. Must be called
+             * from the consumer thread.
+             */
+            T* front() noexcept {
+                if (empty()) {
+                    return nullptr;
+                }
+                return &m_slots[m_head.value.load(std::memory_order_relaxed) % m_max_size];
+            }
+
+            bool empty() const noexcept {
+                return size() == 0;
+            }
+
+            std::size_t size() const noexcept {
+                // Head must be read first, it can never be larger than
+                // the tail read after it.
+                const std::size_t head = m_head.value;
+                return m_tail.value - head;
+            }
+
+            /**
+             * Set functions called after each push and pop. They are called
+             * from the producer and consumer, respectively, and can be
+             * used to schedule tasks doing the work on the other side of
+             * the queue instead of having a thread blocking on it. Must be
+             * called before the queue is used.
+             */
+            void set_notifications(std::function<void()> after_push, std::function<void()> after_pop) {
+                m_after_push = std::move(after_push);
+                m_after_pop = std::move(after_pop);
+            }
+
+            std::size_t max_size() const noexcept {
+                return m_max_size;
+            }
+
+            bool in_use() const noexcept {
+                return m_in_use;
+            }
+
+            /**
+             * Report the size in bytes of an element popped from the
+             * queue. This is used to estimate how much memory the elements
+             * in the queue use, see queue_stats::estimated_bytes(). Must
+             * be called from the consumer thread.
+             */
+            void add_popped_bytes(std::size_t bytes) noexcept {
+                m_popped_bytes.store(m_popped_bytes.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+            }
+
+            /**
+             * Get the current values of the counters of this queue. This
+             * can be called from any thread.
+             */
+            queue_stats stats() const {
+                queue_stats result;
+                result.name = m_name;
+                result.max_size = m_max_size;
+                result.pops = m_head.value;
+                result.pushes = m_tail.value;
+                result.size = static_cast<std::size_t>(result.pushes - result.pops);
+                result.largest_size = m_largest_size.load(std::memory_order_relaxed);
+                result.full_waits = m_full_waits.count();
+                result.empty_waits = m_empty_waits.count();
+                result.full_wait_time = m_full_waits.time();
+                result.empty_wait_time = m_empty_waits.time();
+                result.popped_bytes = m_popped_bytes.load(std::memory_order_relaxed);
+                return result;
+            }
+
+            /**
+             * Shut down the queue and remove all elements from it. This must
+             * be called from the consumer thread.
+             */
+            void shutdown() {
+                m_in_use = false;
+                while (!empty()) {
+                    T value;
+                    pop_front(value);
+                }
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_data_available.notify_all();
+                m_space_available.notify_all();
+            }
+
+        }; // class SPSCQueue
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_SPSC_QUEUE_HPP
@@ -0,0 +1,161 @@
+#ifndef OSMIUM_THREAD_STATS_HPP
+#define OSMIUM_THREAD_STATS_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * Snapshot of the counters of a Queue or SPSCQueue, see their
+         * stats() functions. The counters are updated while the queue is
+         * in use, so the values are not necessarily consistent with each
+         * other.
+         */
+        struct queue_stats {
+
+            /// Name of the queue.
+            std::string name;
+
+            /// Maximum size of the queue (0 if unlimited).
+            std::size_t max_size = 0;
+
+            /// Number of elements currently in the queue.
+            std::size_t size = 0;
+
+            /// The largest number of elements in the queue so far.
+            std::size_t largest_size = 0;
+
+            /// Number of elements pushed onto the queue.
+            uint64_t pushes = 0;
+
+            /// Number of elements popped from the queue.
+            uint64_t pops = 0;
+
+            /// Number of times a producer had to wait because the queue was full.
+            uint64_t full_waits = 0;
+
+            /// Number of times a consumer had to wait because the queue was empty.
+            uint64_t empty_waits = 0;
+
+            /// Total time producers waited because the queue was full.
+            std::chrono::nanoseconds full_wait_time{0};
+
+            /// Total time consumers waited because the queue was empty.
+            std::chrono::nanoseconds empty_wait_time{0};
+
+            /**
+             * Total size in bytes of the elements popped so far. Only
+             * available for queues where the consumer reports the sizes
+             * (see SPSCQueue::add_popped_bytes()), 0 otherwise.
+             */
+            uint64_t popped_bytes = 0;
+
+            /**
+             * Estimated number of bytes in the elements currently in the
+             * queue. Because the elements are often futures, their size
+             * is only known once they are popped, so this is the current
+             * size times the average size of the popped elements.
+             */
+            uint64_t estimated_bytes() const noexcept {
+                return pops == 0 ? 0 : size * (popped_bytes / pops);
+            }
+
+        }; // struct queue_stats
+
+        /**
+         * Snapshot of the counters of a thread Pool, see Pool::stats().
+         */
+        struct pool_stats {
+
+            /// Number of worker threads.
+            int num_threads = 0;
+
+            /// Number of tasks waiting in the queues.
+            std::size_t queued_tasks = 0;
+
+            /// Number of tasks run so far.
+            uint64_t tasks_done = 0;
+
+            /// Total time the workers spent running tasks.
+            std::chrono::nanoseconds busy_time{0};
+
+        }; // struct pool_stats
+
+        namespace detail {
+
+            /**
+             * Adds up how often and how long threads waited. The clock is
+             * only read when a thread actually has to wait, so this costs
+             * nothing when data flows freely.
+             */
+            class wait_counter {
+
+                std::atomic<uint64_t> m_count{0};
+                std::atomic<uint64_t> m_nanoseconds{0};
+
+            public:
+
+                using clock = std::chrono::steady_clock;
+
+                void add(clock::time_point start) noexcept {
+                    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+                    m_count.fetch_add(1, std::memory_order_relaxed);
+                    m_nanoseconds.fetch_add(static_cast<uint64_t>(duration.count()), std::memory_order_relaxed);
+                }
+
+                uint64_t count() const noexcept {
+                    return m_count.load(std::memory_order_relaxed);
+                }
+
+                std::chrono::nanoseconds time() const noexcept {
+                    return std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(m_nanoseconds.load(std::memory_order_relaxed))};
+                }
+
+            }; // class wait_counter
+
+        } // namespace detail
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_STATS_HPP
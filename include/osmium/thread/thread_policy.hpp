@@ -0,0 +1,316 @@
+#ifndef OSMIUM_THREAD_THREAD_POLICY_HPP
+#define OSMIUM_THREAD_THREAD_POLICY_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/config.hpp>
+#include <osmium/util/numa.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+# include <sys/resource.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * The different kinds of threads a thread_policy can be set for.
+         */
+        enum class thread_role {
+            worker   = 0, ///< Thread pool workers (decoding and encoding)
+            read     = 1, ///< Reader thread reading (and decompressing) input
+            parse    = 2, ///< Reader thread running the parser
+            write    = 3, ///< Writer thread (compressing and) writing output
+            consumer = 4  ///< The thread(s) of the application using the data
+        }; // enum class thread_role
+
+        namespace detail {
+
+            enum : std::size_t {
+                num_thread_roles = 5
+            };
+
+            /**
+             * Set the nice value of the current thread. Lowering the
+             * priority (higher nice value) always works, raising it needs
+             * special privileges.
+             *
+             * @returns true on success, false if this failed or is not
+             *          supported on this system.
+             */
+            inline bool set_current_thread_nice(int nice) noexcept {
+#ifdef __linux__
+                // On Linux the nice value is a per-thread attribute.
+                const auto tid = static_cast<id_t>(::syscall(SYS_gettid));
+                return ::setpriority(PRIO_PROCESS, tid, nice) == 0;
+#else
+                (void)nice;
+                return false;
+#endif
+            }
+
+        } // namespace detail
+
+        /**
+         * CPU affinity and priority for one kind of thread.
+         */
+        struct thread_settings {
+
+            /// CPUs the thread may run on. Empty means no restriction.
+            std::vector<int> cpus{};
+
+            /// Nice value for the thread, only used if set_nice is true.
+            int nice = 0;
+
+            bool set_nice = false;
+
+            bool empty() const noexcept {
+                return cpus.empty() && !set_nice;
+            }
+
+            /**
+             * Apply these settings to the current thread.
+             *
+             * @returns true on success, false if any of the settings could
+             *          not be applied or is not supported on this system.
+             */
+            bool apply() const noexcept {
+                bool okay = true;
+                if (!cpus.empty()) {
+                    okay = osmium::util::pin_current_thread_to_cpus(cpus);
+                }
+                if (set_nice) {
+                    okay = detail::set_current_thread_nice(nice) && okay;
+                }
+                return okay;
+            }
+
+        }; // struct thread_settings
+
+        /**
+         * Policy for the CPU affinity and priority of the threads started
+         * by the library. It can be given to the thread Pool, the Reader
+         * and the Writer, each of them applies the settings for the roles
+         * of the threads it starts. Threads are only pinned and their
+         * priority changed if a setting is given for their role.
+         *
+         * For instance to keep I/O threads on cores 0 and 1, decoding
+         * in the pool on cores 2 to 31 and the application on core 31:
+         *
+         * @code
+         * osmium::thread::thread_policy policy;
+         * policy.set_cpus(thread_role::read, {0, 1})
+         *       .set_cpus(thread_role::parse, {0, 1})
+         *       .set_cpus(thread_role::worker, cpus_2_to_30)
+         *       .set_cpus(thread_role::consumer, {31});
+         * osmium::thread::Pool pool{0, 0, policy};
+         * osmium::io::Reader reader{"input.osm.pbf", pool, policy};
+         * policy.apply(thread_role::consumer);
+         * @endcode
+         *
+         * The policy can also be set in the environment variable
+         * OSMIUM_THREAD_POLICY, see from_string() for the format. It is
+         * used if no policy is given explicitly. This only works on Linux.
+         */
+        class thread_policy {
+
+            std::array<thread_settings, detail::num_thread_roles> m_settings{};
+
+            thread_settings& settings_for(thread_role role) noexcept {
+                return m_settings[static_cast<std::size_t>(role)];
+            }
+
+            static void parse_role(const std::string& name, std::vector<thread_role>& roles) {
+                if (name == "worker") {
+                    roles.push_back(thread_role::worker);
+                } else if (name == "read") {
+                    roles.push_back(thread_role::read);
+                } else if (name == "parse") {
+                    roles.push_back(thread_role::parse);
+                } else if (name == "write") {
+                    roles.push_back(thread_role::write);
+                } else if (name == "consumer") {
+                    roles.push_back(thread_role::consumer);
+                } else if (name == "io") {
+                    roles.push_back(thread_role::read);
+                    roles.push_back(thread_role::parse);
+                    roles.push_back(thread_role::write);
+                } else {
+                    throw std::invalid_argument{"unknown thread role '" + name + "'"};
+                }
+            }
+
+        public:
+
+            thread_policy() = default;
+
+            /**
+             * Set the CPUs threads with the given role may run on. An
+             * empty list removes the restriction.
+             */
+            thread_policy& set_cpus(thread_role role, std::vector<int> cpus) {
+                settings_for(role).cpus = std::move(cpus);
+                return *this;
+            }
+
+            /// Set the nice value of threads with the given role.
+            thread_policy& set_nice(thread_role role, int nice) noexcept {
+                settings_for(role).nice = nice;
+                settings_for(role).set_nice = true;
+                return *this;
+            }
+
+            const thread_settings& settings(thread_role role) const noexcept {
+                return m_settings[static_cast<std::size_t>(role)];
+            }
+
+            /// Is there no setting for any role?
+            bool empty() const noexcept {
+                for (const auto& s : m_settings) {
+                    if (!s.empty()) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            /**
+             * Apply the settings for the given role to the current thread.
+             * Use this for the threads of the application.
+             *
+             * @returns true on success, false if any of the settings could
+             *          not be applied or is not supported on this system.
+             */
+            bool apply(thread_role role) const noexcept {
+                return settings(role).apply();
+            }
+
+            /**
+             * Create a policy from a string. The string contains entries
+             * separated by semicolons. Each entry has the form
+             * "ROLE:CPUS" or "ROLE:CPUS:NICE". ROLE is one of "worker",
+             * "read", "parse", "write", "consumer", or "io" (short for
+             * read, parse, and write). CPUS is a list of CPUs in the
+             * format used by the Linux kernel, for instance "0-3,8". It
+             * can be empty to only set the nice value.
+             *
+             * Example: "io:0-1;worker:2-30:5;consumer:31"
+             *
+             * @throws std::invalid_argument if the string is invalid.
+             */
+            static thread_policy from_string(const std::string& str) {
+                thread_policy policy;
+
+                std::size_t pos = 0;
+                while (pos < str.size()) {
+                    auto end = str.find(';', pos);
+                    if (end == std::string::npos) {
+                        end = str.size();
+                    }
+                    const std::string entry = str.substr(pos, end - pos);
+                    pos = end + 1;
+                    if (entry.empty()) {
+                        continue;
+                    }
+
+                    const auto colon1 = entry.find(':');
+                    if (colon1 == std::string::npos) {
+                        throw std::invalid_argument{"missing ':' in thread policy entry '" + entry + "'"};
+                    }
+                    const auto colon2 = entry.find(':', colon1 + 1);
+
+                    std::vector<thread_role> roles;
+                    parse_role(entry.substr(0, colon1), roles);
+
+                    const std::string cpu_list = entry.substr(colon1 + 1, colon2 == std::string::npos ? std::string::npos : colon2 - colon1 - 1);
+                    if (cpu_list.find_first_not_of("0123456789,-") != std::string::npos) {
+                        throw std::invalid_argument{"invalid CPU list in thread policy entry '" + entry + "'"};
+                    }
+                    const auto cpus = osmium::detail::parse_cpu_list(cpu_list);
+
+                    for (const auto role : roles) {
+                        policy.set_cpus(role, cpus);
+                    }
+
+                    if (colon2 != std::string::npos) {
+                        const std::string nice_str = entry.substr(colon2 + 1);
+                        char* nice_end = nullptr;
+                        const long nice = std::strtol(nice_str.c_str(), &nice_end, 10); // NOLINT(google-runtime-int)
+                        if (nice_str.empty() || *nice_end != '\0' || nice < -20 || nice > 19) {
+                            throw std::invalid_argument{"invalid nice value in thread policy entry '" + entry + "'"};
+                        }
+                        for (const auto role : roles) {
+                            policy.set_nice(role, static_cast<int>(nice));
+                        }
+                    }
+                }
+
+                return policy;
+            }
+
+            /**
+             * Create a policy from the environment variable
+             * OSMIUM_THREAD_POLICY. Returns an empty policy if the
+             * variable is not set or invalid.
+             */
+            static thread_policy from_config() {
+                const char* str = osmium::config::get_thread_policy();
+                if (str) {
+                    try {
+                        return from_string(str);
+                    } catch (const std::invalid_argument&) {
+                        // ignore invalid setting
+                    }
+                }
+                return thread_policy{};
+            }
+
+        }; // class thread_policy
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_THREAD_POLICY_HPP
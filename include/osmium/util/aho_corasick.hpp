@@ -0,0 +1,214 @@
+#ifndef OSMIUM_UTIL_AHO_CORASICK_HPP
+#define OSMIUM_UTIL_AHO_CORASICK_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    namespace detail {
+
+        /**
+         * Aho-Corasick automaton for finding any of a set of patterns in
+         * a string in a single pass, independent of the number of
+         * patterns.
+         *
+         * The automaton is stored as a complete DFA: For each state there
+         * is a transition for each character class. Bytes that don't
+         * appear in any of the patterns share character class 0, so the
+         * transition table is only as wide as the number of different
+         * bytes in the patterns.
+         */
+        class aho_corasick_automaton {
+
+            std::array<uint16_t, 256> m_classes{};
+            std::size_t m_num_classes = 1;
+
+            // transition table: state * m_num_classes + character class
+            std::vector<uint32_t> m_transitions{};
+
+            // distance of the state from the root in the trie
+            std::vector<uint32_t> m_depth{};
+
+            // a pattern ends in this state
+            std::vector<bool> m_terminal{};
+
+            // a pattern ends in this state or one of its suffix states
+            std::vector<bool> m_output{};
+
+            uint32_t next(uint32_t state, char c) const noexcept {
+                return m_transitions[state * m_num_classes + m_classes[static_cast<unsigned char>(c)]];
+            }
+
+            // Is the transition from the state with the character an edge
+            // in the trie (and not a fallback to a shorter suffix)?
+            bool is_trie_edge(uint32_t state, uint32_t target) const noexcept {
+                return m_depth[target] == m_depth[state] + 1;
+            }
+
+            uint32_t add_state(uint32_t depth) {
+                m_transitions.resize(m_transitions.size() + m_num_classes, 0);
+                m_depth.push_back(depth);
+                m_terminal.push_back(false);
+                m_output.push_back(false);
+                return static_cast<uint32_t>(m_depth.size() - 1);
+            }
+
+            void build(const std::vector<std::string>& patterns) {
+                for (const auto& pattern : patterns) {
+                    for (const char c : pattern) {
+                        auto& cls = m_classes[static_cast<unsigned char>(c)];
+                        if (cls == 0) {
+                            cls = static_cast<uint16_t>(m_num_classes++);
+                        }
+                    }
+                }
+
+                // Build trie. Transitions to state 0 (the root) mean there
+                // is no edge, the root can't be the target of an edge.
+                add_state(0);
+                for (const auto& pattern : patterns) {
+                    uint32_t state = 0;
+                    for (const char c : pattern) {
+                        const std::size_t index = state * m_num_classes + m_classes[static_cast<unsigned char>(c)];
+                        if (m_transitions[index] == 0) {
+                            const uint32_t new_state = add_state(m_depth[state] + 1);
+                            m_transitions[index] = new_state;
+                        }
+                        state = m_transitions[index];
+                    }
+                    m_terminal[state] = true;
+                    m_output[state] = true;
+                }
+
+                // Add failure transitions in breadth-first order, so the
+                // transitions of the (shorter) suffix states are already
+                // complete when they are needed.
+                std::vector<uint32_t> fail(m_depth.size(), 0);
+                std::vector<uint32_t> queue;
+                queue.push_back(0);
+                for (std::size_t n = 0; n < queue.size(); ++n) {
+                    const uint32_t state = queue[n];
+                    for (std::size_t cls = 0; cls < m_num_classes; ++cls) {
+                        uint32_t& target = m_transitions[state * m_num_classes + cls];
+                        const uint32_t fallback = state == 0 ? 0 : m_transitions[fail[state] * m_num_classes + cls];
+                        if (target != 0) {
+                            fail[target] = fallback;
+                            if (m_output[fallback]) {
+                                m_output[target] = true;
+                            }
+                            queue.push_back(target);
+                        } else {
+                            target = fallback;
+                        }
+                    }
+                }
+            }
+
+        public:
+
+            explicit aho_corasick_automaton(const std::vector<std::string>& patterns = std::vector<std::string>{}) {
+                build(patterns);
+            }
+
+            /**
+             * Does any of the patterns occur anywhere in the string?
+             */
+            bool match_substring(const char* str) const noexcept {
+                uint32_t state = 0;
+                if (m_output[state]) {
+                    return true;
+                }
+                for (; *str; ++str) {
+                    state = next(state, *str);
+                    if (m_output[state]) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /**
+             * Does the string start with any of the patterns?
+             */
+            bool match_prefix(const char* str) const noexcept {
+                uint32_t state = 0;
+                if (m_terminal[state]) {
+                    return true;
+                }
+                for (; *str; ++str) {
+                    const uint32_t target = next(state, *str);
+                    if (!is_trie_edge(state, target)) {
+                        return false;
+                    }
+                    state = target;
+                    if (m_terminal[state]) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /**
+             * Is the string equal to any of the patterns?
+             */
+            bool match_exact(const char* str) const noexcept {
+                uint32_t state = 0;
+                for (; *str; ++str) {
+                    const uint32_t target = next(state, *str);
+                    if (!is_trie_edge(state, target)) {
+                        return false;
+                    }
+                    state = target;
+                }
+                return m_terminal[state];
+            }
+
+            /// The number of states of the automaton.
+            std::size_t num_states() const noexcept {
+                return m_depth.size();
+            }
+
+        }; // class aho_corasick_automaton
+
+    } // namespace detail
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_AHO_CORASICK_HPP
@@ -67,17 +67,237 @@ namespace osmium {
             return 0;
         }
 
+        namespace detail {
+
+            /**
+             * Get a boolean setting from the environment variable with the
+             * given name. If the default value is true, only "off",
+             * "false", "no", or "0" (case insensitive) will turn it off.
+             * If the default is false, only "on", "true", "yes", or "1"
+             * will turn it on.
+             */
+            inline bool get_bool(const char* name, const bool default_value) noexcept {
+                assert(name);
+                const char* env = osmium::detail::getenv_wrapper(name);
+                if (!env) {
+                    return default_value;
+                }
+
+                if (default_value) {
+                    return !(!strcasecmp(env, "off") ||
+                             !strcasecmp(env, "false") ||
+                             !strcasecmp(env, "no") ||
+                             !strcasecmp(env, "0"));
+                }
+
+                return !strcasecmp(env, "on") ||
+                       !strcasecmp(env, "true") ||
+                       !strcasecmp(env, "yes") ||
+                       !strcasecmp(env, "1");
+            }
+
+        } // namespace detail
+
         inline bool use_pool_threads_for_pbf_parsing() noexcept {
-            const char* env = osmium::detail::getenv_wrapper("OSMIUM_USE_POOL_THREADS_FOR_PBF_PARSING");
+            return detail::get_bool("OSMIUM_USE_POOL_THREADS_FOR_PBF_PARSING", true);
+        }
+
+        /**
+         * Should the PBF parser memory-map the input file instead of
+         * reading it into buffers? This only has an effect on uncompressed
+         * local files. Set the environment variable
+         * OSMIUM_USE_MMAP_FOR_PBF_READING to "yes" (or "on", "true", "1")
+         * to enable this. It is disabled by default.
+         */
+        inline bool use_mmap_for_pbf_reading() noexcept {
+            return detail::get_bool("OSMIUM_USE_MMAP_FOR_PBF_READING", false);
+        }
+
+        /**
+         * Should the PBF parser first build a table of all blobs in the
+         * input file and then let the pool threads read and decode the
+         * blobs concurrently? This only has an effect on uncompressed
+         * local files and is not available on Windows. Set the environment
+         * variable OSMIUM_USE_BLOB_TABLE_FOR_PBF_READING to "yes" (or "on",
+         * "true", "1") to enable this. It is disabled by default.
+         */
+        inline bool use_blob_table_for_pbf_reading() noexcept {
+            return detail::get_bool("OSMIUM_USE_BLOB_TABLE_FOR_PBF_READING", false);
+        }
+
+        /**
+         * Should gzip, bzip2, and zstd compressed input files be
+         * decompressed using several threads? This only works for regular
+         * files consisting of many independently compressed members,
+         * streams, or frames as written by bgzip (for gzip), pbzip2 (for
+         * bzip2), or libosmium (for zstd), other files are always
+         * decompressed in a single thread. Set the
+         * environment variable OSMIUM_USE_PARALLEL_DECOMPRESSION to "yes"
+         * (or "on", "true", "1") to enable this. It is disabled by default.
+         */
+        inline bool use_parallel_decompression() noexcept {
+            return detail::get_bool("OSMIUM_USE_PARALLEL_DECOMPRESSION", false);
+        }
+
+        /**
+         * Should gzip, bzip2, zstd, and lz4 compressed output files be
+         * compressed using several threads? The data is split into chunks
+         * which are compressed independently and written as separate BGZF
+         * members (for gzip), streams (for bzip2), or frames (for zstd
+         * and lz4). The result is slightly larger
+         * than a file compressed in one piece, but it can be read by all
+         * the usual tools. Set the environment variable
+         * OSMIUM_USE_PARALLEL_COMPRESSION to "yes" (or "on", "true", "1")
+         * to enable this. It is disabled by default.
+         */
+        inline bool use_parallel_compression() noexcept {
+            return detail::get_bool("OSMIUM_USE_PARALLEL_COMPRESSION", false);
+        }
+
+        /**
+         * Should OSM XML files be parsed using several threads? The input
+         * is split into chunks between objects and the chunks are parsed
+         * by the pool threads. This only has an effect when reading
+         * OSM XML or OSM change files. Set the environment variable
+         * OSMIUM_USE_PARALLEL_XML_PARSING to "yes" (or "on", "true", "1")
+         * to enable this. It is disabled by default.
+         */
+        inline bool use_parallel_xml_parsing() noexcept {
+            return detail::get_bool("OSMIUM_USE_PARALLEL_XML_PARSING", false);
+        }
+
+        /**
+         * Should OPL files be parsed using several threads? The input is
+         * split into chunks of complete lines which are parsed by the pool
+         * threads. This is only done if the reader is not asked to put
+         * each object type into separate buffers. Set the environment
+         * variable OSMIUM_USE_PARALLEL_OPL_PARSING to "yes" (or "on",
+         * "true", "1") to enable this. It is disabled by default.
+         */
+        inline bool use_parallel_opl_parsing() noexcept {
+            return detail::get_bool("OSMIUM_USE_PARALLEL_OPL_PARSING", false);
+        }
+
+        /**
+         * Should uncompressed input files be read using the Linux io_uring
+         * interface with several reads in flight at the same time? This
+         * only has an effect on regular files on Linux systems where
+         * io_uring is available, otherwise normal reads are used. This
+         * helps with storage that needs several requests in flight to
+         * reach its full bandwidth, it doesn't make reading files that
+         * are already in the page cache faster. Set the environment
+         * variable OSMIUM_USE_IO_URING to "yes" (or "on",
+         * "true", "1") to enable this. It is disabled by default.
+         */
+        inline bool use_io_uring() noexcept {
+            return detail::get_bool("OSMIUM_USE_IO_URING", false);
+        }
+
+        /**
+         * Should uncompressed output files be written using the Linux
+         * io_uring interface with several writes in flight at the same
+         * time? This only has an effect on regular files on Linux systems
+         * where io_uring is available, otherwise normal writes are used.
+         * This keeps the thread writing the file from waiting for a slow
+         * disk after each write. Set the environment variable
+         * OSMIUM_USE_IO_URING_FOR_WRITING to "yes" (or "on", "true", "1")
+         * to enable this. It is disabled by default.
+         */
+        inline bool use_io_uring_for_writing() noexcept {
+            return detail::get_bool("OSMIUM_USE_IO_URING_FOR_WRITING", false);
+        }
+
+        /**
+         * Number of reads or writes in flight when reading or writing
+         * with io_uring (see use_io_uring() and
+         * use_io_uring_for_writing()). Set from the environment variable
+         * OSMIUM_IO_URING_QUEUE_DEPTH. Returns 0 if it is not set, in
+         * which case the default is used.
+         */
+        inline int get_io_uring_queue_depth() noexcept {
+            const char* env = osmium::detail::getenv_wrapper("OSMIUM_IO_URING_QUEUE_DEPTH");
             if (env) {
-                if (!strcasecmp(env, "off") ||
-                    !strcasecmp(env, "false") ||
-                    !strcasecmp(env, "no") ||
-                    !strcasecmp(env, "0")) {
-                    return false;
-                }
+                return osmium::detail::str_to_int<int>(env);
             }
-            return true;
+            return 0;
+        }
+
+        /**
+         * Should files read or written with io_uring (see use_io_uring()
+         * and use_io_uring_for_writing()) be opened with O_DIRECT? This
+         * bypasses the page cache, which is useful for large files that
+         * are read or written only once. If the file system doesn't
+         * support this, normal reads and writes are used. Set the environment
+         * variable OSMIUM_USE_DIRECT_IO to "yes" (or "on", "true", "1")
+         * to enable this. It is disabled by default.
+         */
+        inline bool use_direct_io() noexcept {
+            return detail::get_bool("OSMIUM_USE_DIRECT_IO", false);
+        }
+
+        /**
+         * Should o5m files be parsed using several threads? The input is
+         * split at the reset points (where the delta and string table
+         * state is cleared) into chunks which are decoded by the pool
+         * threads. This is only done if the reader is not asked to put
+         * each object type into separate buffers. Set the environment
+         * variable OSMIUM_USE_PARALLEL_O5M_PARSING to "yes" (or "on",
+         * "true", "1") to enable this. It is disabled by default.
+         */
+        inline bool use_parallel_o5m_parsing() noexcept {
+            return detail::get_bool("OSMIUM_USE_PARALLEL_O5M_PARSING", false);
+        }
+
+        /**
+         * Should the chunks of XML files parsed in parallel (see
+         * use_parallel_xml_parsing()) be parsed by the built-in XML
+         * tokenizer instead of the Expat parser? The tokenizer only
+         * handles the simple XML used in OSM files, anything else is
+         * still parsed by Expat. Set the environment variable
+         * OSMIUM_USE_FAST_XML_TOKENIZER to "no" (or "off", "false", "0")
+         * to disable this. It is enabled by default.
+         */
+        inline bool use_fast_xml_tokenizer() noexcept {
+            return detail::get_bool("OSMIUM_USE_FAST_XML_TOKENIZER", true);
+        }
+
+        /**
+         * Should the library take the NUMA nodes into account? If this is
+         * enabled, each thread pool worker is pinned to the CPUs of one NUMA
+         * node and prefers tasks from workers on the same node, and
+         * anonymous memory-mapped index arrays (DenseMmapArray,
+         * SparseMmapArray) are interleaved over all nodes. This only has an
+         * effect on Linux systems with more than one NUMA node. Set the
+         * environment variable OSMIUM_USE_NUMA to "yes" (or "on", "true",
+         * "1") to enable this. It is disabled by default.
+         */
+        inline bool use_numa() noexcept {
+            return detail::get_bool("OSMIUM_USE_NUMA", false);
+        }
+
+        /**
+         * Should Buffers get their memory from a pool of slabs which are
+         * reused when buffers are destroyed (see
+         * osmium::memory::BufferPool)? This avoids allocating and page
+         * faulting fresh memory for every buffer when many large buffers
+         * are created, for instance while reading and writing OSM files.
+         * Set the environment variable OSMIUM_USE_BUFFER_POOL to "yes"
+         * (or "on", "true", "1") to enable this. It is disabled by
+         * default.
+         */
+        inline bool use_buffer_pool() noexcept {
+            return detail::get_bool("OSMIUM_USE_BUFFER_POOL", false);
+        }
+
+        /**
+         * Should the slabs of the buffer pool (see use_buffer_pool()) be
+         * backed by transparent huge pages? This only has an effect on
+         * Linux. Set the environment variable
+         * OSMIUM_USE_HUGE_PAGES_FOR_BUFFERS to "yes" (or "on", "true",
+         * "1") to enable this. It is disabled by default.
+         */
+        inline bool use_huge_pages_for_buffers() noexcept {
+            return detail::get_bool("OSMIUM_USE_HUGE_PAGES_FOR_BUFFERS", false);
         }
 
         inline std::size_t get_max_queue_size(const char* queue_name, const std::size_t default_value) noexcept {
@@ -103,6 +323,66 @@ namespace osmium {
             return value;
         }
 
+        /**
+         * Get the SIMD instruction set the code should use at most
+         * even if the CPU supports more, from the environment variable
+         * OSMIUM_SIMD. Possible values are "none", "sse4.2", "avx2",
+         * "avx512", and "neon". Returns nullptr if not set. See
+         * osmium/util/cpu_features.hpp for details.
+         */
+        inline const char* get_simd_override() noexcept {
+            const char* env = osmium::detail::getenv_wrapper("OSMIUM_SIMD");
+            if (env && *env != '\0') {
+                return env;
+            }
+            return nullptr;
+        }
+
+        /**
+         * Get the thread policy (CPU affinity and priority of the threads
+         * started by the library) from the environment variable
+         * OSMIUM_THREAD_POLICY. Returns nullptr if not set. See
+         * osmium::thread::thread_policy for the format.
+         */
+        inline const char* get_thread_policy() noexcept {
+            const char* env = osmium::detail::getenv_wrapper("OSMIUM_THREAD_POLICY");
+            if (env && *env != '\0') {
+                return env;
+            }
+            return nullptr;
+        }
+
+        /**
+         * Get the memory budget in bytes for sorting sparse index maps
+         * (see osmium::index::map::VectorBasedSparseMap::sort()). Maps
+         * larger than this are sorted with an external merge sort using
+         * a temporary file. Set from the environment variable
+         * OSMIUM_SORT_MEMORY_BUDGET in MBytes. Returns 0 (no limit) if
+         * it is not set.
+         */
+        inline std::size_t get_sort_memory_budget() noexcept {
+            const char* env = osmium::detail::getenv_wrapper("OSMIUM_SORT_MEMORY_BUDGET");
+            if (env) {
+                return osmium::detail::str_to_int<std::size_t>(env) * 1024UL * 1024UL;
+            }
+            return 0;
+        }
+
+        /**
+         * Get the number of bits per id for the Bloom filter of sparse
+         * index maps (see osmium::index::map::VectorBasedSparseMap::
+         * set_bloom_filter_bits()). Set from the environment variable
+         * OSMIUM_SPARSE_MAP_BLOOM_FILTER_BITS. Returns 0 (no filter) if
+         * it is not set.
+         */
+        inline std::size_t get_bloom_filter_bits() noexcept {
+            const char* env = osmium::detail::getenv_wrapper("OSMIUM_SPARSE_MAP_BLOOM_FILTER_BITS");
+            if (env) {
+                return osmium::detail::str_to_int<std::size_t>(env);
+            }
+            return 0;
+        }
+
         inline int8_t clean_page_cache_after_read() noexcept {
             const char* env = osmium::detail::getenv_wrapper("OSMIUM_CLEAN_PAGE_CACHE_AFTER_READ");
             if (env) {
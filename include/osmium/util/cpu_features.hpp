@@ -0,0 +1,372 @@
+#ifndef OSMIUM_UTIL_CPU_FEATURES_HPP
+#define OSMIUM_UTIL_CPU_FEATURES_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/config.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+# include <intrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+# include <cpuid.h>
+#endif
+
+#if defined(__linux__) && defined(__aarch64__)
+# include <sys/auxv.h>
+#endif
+
+/**
+ * @file
+ *
+ * Detection of CPU features at runtime and selection of the best
+ * implementation of a function for the CPU the program runs on.
+ *
+ * libosmium is header-only, so all code is compiled for the instruction
+ * set of the program including it, usually the baseline x86-64 without
+ * any of the newer SIMD instructions. To still make use of those, a
+ * function can be implemented several times for different instruction
+ * sets using the OSMIUM_TARGET_* macros on GCC and clang, and the best
+ * version is selected at runtime with select_implementation().
+ *
+ * The environment variable OSMIUM_SIMD can be set to one of "none",
+ * "sse4.2", "avx2", "avx512", or "neon" to limit the instruction sets
+ * used, for instance for testing or benchmarking.
+ */
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+# define OSMIUM_HAS_TARGET_ATTRIBUTE
+# define OSMIUM_TARGET_SSE4_2 __attribute__((target("sse4.2,popcnt")))
+# define OSMIUM_TARGET_AVX2 __attribute__((target("avx2,bmi,bmi2,fma,popcnt")))
+# define OSMIUM_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx512dq,avx2,bmi,bmi2,fma,popcnt")))
+#else
+# define OSMIUM_TARGET_SSE4_2
+# define OSMIUM_TARGET_AVX2
+# define OSMIUM_TARGET_AVX512
+#endif
+
+namespace osmium {
+
+    inline namespace util {
+
+        /**
+         * Groups of SIMD instruction sets. On x86 these roughly follow
+         * the x86-64 microarchitecture levels v2 to v4.
+         */
+        enum class simd_level : uint8_t {
+            none   = 0, ///< No SIMD instructions beyond the baseline
+            sse4_2 = 1, ///< SSE up to 4.2 and POPCNT (x86-64-v2)
+            avx2   = 2, ///< AVX2, BMI1/2, FMA (x86-64-v3)
+            avx512 = 3, ///< AVX-512 F, BW, VL, DQ (x86-64-v4)
+            neon   = 4  ///< ARM Advanced SIMD (always available on AArch64)
+        };
+
+        inline const char* as_string(const simd_level level) noexcept {
+            switch (level) {
+                case simd_level::sse4_2:
+                    return "sse4.2";
+                case simd_level::avx2:
+                    return "avx2";
+                case simd_level::avx512:
+                    return "avx512";
+                case simd_level::neon:
+                    return "neon";
+                default: // simd_level::none
+                    break;
+            }
+            return "none";
+        }
+
+        /**
+         * Parse the name of a SIMD level as used in the OSMIUM_SIMD
+         * environment variable. Returns false if the name is unknown.
+         */
+        inline bool parse_simd_level(const char* name, simd_level* level) noexcept {
+            static const struct {
+                const char* name;
+                simd_level level;
+            } names[] = {
+                {"none",   simd_level::none},
+                {"scalar", simd_level::none},
+                {"sse4.2", simd_level::sse4_2},
+                {"sse42",  simd_level::sse4_2},
+                {"avx2",   simd_level::avx2},
+                {"avx512", simd_level::avx512},
+                {"neon",   simd_level::neon}
+            };
+            if (name) {
+                for (const auto& entry : names) {
+                    if (!std::strcmp(name, entry.name)) {
+                        *level = entry.level;
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Does a CPU (or a limit set by the user) with the given maximum
+         * level also support the level? The x86 levels build on each
+         * other, neon is separate.
+         */
+        constexpr inline bool simd_level_includes(const simd_level max, const simd_level level) noexcept {
+            return level == simd_level::none ||
+                   (level == simd_level::neon ? max == simd_level::neon
+                                              : (max != simd_level::neon && level <= max));
+        }
+
+        /**
+         * CPU features relevant for libosmium. All are false on
+         * architectures other than x86 and ARM and if detection is not
+         * supported for the compiler or operating system.
+         */
+        struct cpu_features {
+
+            // x86
+            bool sse4_2 = false;
+            bool popcnt = false;
+            bool pclmul = false;
+            bool avx2 = false;
+            bool bmi1 = false;
+            bool bmi2 = false;
+            bool fma = false;
+            bool avx512f = false;
+            bool avx512bw = false;
+            bool avx512vl = false;
+            bool avx512dq = false;
+
+            // ARM
+            bool neon = false;
+            bool crc32 = false;
+            bool pmull = false;
+
+            /// The best SIMD level supported by these features.
+            simd_level best_simd_level() const noexcept {
+                if (avx512f && avx512bw && avx512vl && avx512dq && avx2 && bmi1 && bmi2 && fma) {
+                    return simd_level::avx512;
+                }
+                if (avx2 && bmi1 && bmi2 && fma && sse4_2 && popcnt) {
+                    return simd_level::avx2;
+                }
+                if (sse4_2 && popcnt) {
+                    return simd_level::sse4_2;
+                }
+                if (neon) {
+                    return simd_level::neon;
+                }
+                return simd_level::none;
+            }
+
+        }; // struct cpu_features
+
+    } // namespace util
+
+    namespace detail {
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+# define OSMIUM_CPUID_X86
+        inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* regs) noexcept {
+            int r[4];
+            __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+            for (int i = 0; i < 4; ++i) {
+                regs[i] = static_cast<uint32_t>(r[i]);
+            }
+        }
+
+        inline uint64_t xgetbv() noexcept {
+            return _xgetbv(0);
+        }
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+# define OSMIUM_CPUID_X86
+        inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* regs) noexcept {
+            __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+        }
+
+        inline uint64_t xgetbv() noexcept {
+            uint32_t eax = 0;
+            uint32_t edx = 0;
+            __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+            return (static_cast<uint64_t>(edx) << 32U) | eax;
+        }
+#endif
+
+        inline cpu_features detect_cpu_features() noexcept {
+            cpu_features features;
+
+#ifdef OSMIUM_CPUID_X86
+            uint32_t regs[4] = {0, 0, 0, 0}; // eax, ebx, ecx, edx
+            cpuid(0, 0, regs);
+            const uint32_t max_leaf = regs[0];
+            if (max_leaf < 1) {
+                return features;
+            }
+
+            cpuid(1, 0, regs);
+            features.sse4_2 = (regs[2] & (1U << 20U)) != 0;
+            features.popcnt = (regs[2] & (1U << 23U)) != 0;
+            features.pclmul = (regs[2] & (1U << 1U)) != 0;
+            const bool fma = (regs[2] & (1U << 12U)) != 0;
+            const bool osxsave = (regs[2] & (1U << 27U)) != 0;
+            const bool avx = (regs[2] & (1U << 28U)) != 0;
+
+            // Check that the operating system saves the AVX (YMM)
+            // and AVX-512 (opmask, ZMM) registers.
+            const uint64_t xcr0 = osxsave ? xgetbv() : 0;
+            const bool os_avx = (xcr0 & 0x06U) == 0x06U;
+            const bool os_avx512 = (xcr0 & 0xe6U) == 0xe6U;
+
+            if (max_leaf >= 7) {
+                cpuid(7, 0, regs);
+                features.avx2 = os_avx && avx && (regs[1] & (1U << 5U)) != 0;
+                features.bmi1 = (regs[1] & (1U << 3U)) != 0;
+                features.bmi2 = (regs[1] & (1U << 8U)) != 0;
+                features.fma = os_avx && fma;
+                features.avx512f = os_avx512 && (regs[1] & (1U << 16U)) != 0;
+                features.avx512dq = os_avx512 && (regs[1] & (1U << 17U)) != 0;
+                features.avx512bw = os_avx512 && (regs[1] & (1U << 30U)) != 0;
+                features.avx512vl = os_avx512 && (regs[1] & (1U << 31U)) != 0;
+            }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+            // Advanced SIMD is part of the ARMv8-A baseline.
+            features.neon = true;
+# if defined(__linux__)
+            const auto hwcap = ::getauxval(AT_HWCAP);
+#  ifdef HWCAP_CRC32
+            features.crc32 = (hwcap & HWCAP_CRC32) != 0;
+#  endif
+#  ifdef HWCAP_PMULL
+            features.pmull = (hwcap & HWCAP_PMULL) != 0;
+#  endif
+# elif defined(__ARM_FEATURE_CRC32)
+            features.crc32 = true;
+# endif
+#endif
+
+            return features;
+        }
+
+        /**
+         * The best SIMD level given the detected maximum level and an
+         * optional limit from the user (nullptr for no limit).
+         */
+        inline simd_level limit_simd_level(const simd_level detected, const char* limit) noexcept {
+            simd_level max = simd_level::avx512;
+            if (!parse_simd_level(limit, &max)) {
+                return detected;
+            }
+            for (const auto level : {simd_level::avx512, simd_level::avx2, simd_level::sse4_2, simd_level::neon}) {
+                if (simd_level_includes(detected, level) && simd_level_includes(max, level)) {
+                    return level;
+                }
+            }
+            return simd_level::none;
+        }
+
+    } // namespace detail
+
+    inline namespace util {
+
+        /**
+         * The features of the CPU the program is running on. Detected
+         * once on first use.
+         */
+        inline const cpu_features& get_cpu_features() noexcept {
+            static const cpu_features features = detail::detect_cpu_features();
+            return features;
+        }
+
+        /**
+         * The best SIMD level that should be used on this CPU, taking
+         * into account the limit set in the OSMIUM_SIMD environment
+         * variable. Detected once on first use.
+         */
+        inline simd_level get_simd_level() noexcept {
+            static const simd_level level = detail::limit_simd_level(get_cpu_features().best_simd_level(),
+                                                                     osmium::config::get_simd_override());
+            return level;
+        }
+
+        /**
+         * One implementation of a function for select_implementation().
+         */
+        template <typename TFunc>
+        struct simd_implementation {
+            simd_level level;
+            TFunc* function;
+        };
+
+        /**
+         * Select the first implementation from the list whose SIMD level
+         * is supported. The list should be ordered from best to worst
+         * and end with an implementation for simd_level::none, which is
+         * always supported. Returns nullptr if none is supported.
+         *
+         * Usually the result is stored in a static variable, so that
+         * the selection is only done once:
+         *
+         * @code
+         * using sum_func = int(const int*, std::size_t);
+         * int sum(const int* data, std::size_t size) {
+         *     static sum_func* const impl = osmium::util::select_implementation<sum_func>({
+         *         {osmium::util::simd_level::avx2, sum_avx2},
+         *         {osmium::util::simd_level::none, sum_scalar}
+         *     });
+         *     return impl(data, size);
+         * }
+         * @endcode
+         *
+         * @tparam TFunc The function type.
+         * @param implementations The list of implementations.
+         * @param max The maximum SIMD level to use. Default: the level
+         *            returned by get_simd_level().
+         */
+        template <typename TFunc>
+        TFunc* select_implementation(std::initializer_list<simd_implementation<TFunc>> implementations,
+                                     const simd_level max = get_simd_level()) noexcept {
+            for (const auto& implementation : implementations) {
+                if (simd_level_includes(max, implementation.level)) {
+                    return implementation.function;
+                }
+            }
+            return nullptr;
+        }
+
+    } // namespace util
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_CPU_FEATURES_HPP
@@ -35,18 +35,97 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <iterator>
 #include <string>
 
 namespace osmium {
 
+    namespace detail {
+
+        /**
+         * Write the absolute value of a double with the given number
+         * of digits after the decimal point into the buffer without
+         * using snprintf(). Superfluous '0' characters at the end and
+         * the decimal dot if not needed are not written.
+         *
+         * The value is scaled to an integer and rounded. This gives
+         * the same result as snprintf("%.*f") unless the value is very
+         * large or the scaled value is so close to the middle between
+         * two integers that the rounding error of the scaling could
+         * make a difference. In those cases nothing is written and
+         * 0 is returned, the caller has to fall back to snprintf().
+         *
+         * @returns Number of characters written or 0.
+         */
+        inline int fast_abs_double2buffer(char* buffer, double value, int precision) noexcept {
+            static const uint64_t powers_of_ten[] = {
+                1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+                10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+                100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+                100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+                100000000000000000ULL
+            };
+
+            // All powers of ten up to 10^17 are exact doubles. The
+            // scaled value must be small enough that all integers
+            // are exact doubles (2^53).
+            const double scaled = std::abs(value) * static_cast<double>(powers_of_ten[precision]);
+            if (!(scaled < 9007199254740992.0)) { // also catches NaN
+                return 0;
+            }
+
+            const double integer_part = std::floor(scaled);
+            const double fraction = scaled - integer_part;
+            if (std::abs(fraction - 0.5) <= scaled * 2.220446049250313e-16) {
+                return 0;
+            }
+
+            uint64_t n = static_cast<uint64_t>(integer_part) + (fraction > 0.5 ? 1 : 0);
+
+            // write digits backwards into temporary buffer
+            char digits[24];
+            int num_digits = 0;
+            do {
+                digits[num_digits++] = static_cast<char>('0' + n % 10);
+                n /= 10;
+            } while (n != 0);
+            while (num_digits <= precision) {
+                digits[num_digits++] = '0';
+            }
+
+            // remove superfluous '0' characters after the decimal point
+            int start = 0;
+            int frac_digits = precision;
+            while (frac_digits > 0 && digits[start] == '0') {
+                ++start;
+                --frac_digits;
+            }
+
+            int len = 0;
+            for (int i = num_digits - 1; i >= start; --i) {
+                if (i == start + frac_digits - 1) {
+                    buffer[len++] = '.';
+                }
+                buffer[len++] = digits[i];
+            }
+            return len;
+        }
+
+    } // namespace detail
+
     inline namespace util {
 
         /**
          * Write double to iterator, removing superfluous '0' characters at
          * the end. The decimal dot will also be removed if necessary.
          *
+         * The output is the same as from snprintf("%.*f") with the
+         * trailing zeros removed, but for most values it is created
+         * without calling snprintf(), which is much faster.
+         *
          * @tparam T iterator type
          * @param iterator output iterator
          * @param value the value that should be written
@@ -54,14 +133,27 @@ namespace osmium {
          */
         template <typename T>
         inline T double2string(T iterator, double value, int precision) {
-            assert(precision <= 17);
+            assert(precision >= 0 && precision <= 17);
 
             enum {
-                max_double_length = 20 // should fit decimal representation of any double
+                max_double_length = 32 // should fit decimal representation of any double
             };
 
             char buffer[max_double_length];
 
+            if (std::signbit(value)) {
+                buffer[0] = '-';
+                const int len = detail::fast_abs_double2buffer(buffer + 1, value, precision);
+                if (len > 0) {
+                    return std::copy_n(buffer, len + 1, iterator);
+                }
+            } else {
+                const int len = detail::fast_abs_double2buffer(buffer, value, precision);
+                if (len > 0) {
+                    return std::copy_n(buffer, len, iterator);
+                }
+            }
+
 #ifndef _MSC_VER
             int len = snprintf(buffer, max_double_length, "%.*f", precision, value);
 #else
@@ -69,11 +161,13 @@ namespace osmium {
 #endif
             assert(len > 0 && len < max_double_length);
 
-            while (buffer[len - 1] == '0') {
-                --len;
-            }
-            if (buffer[len - 1] == '.') {
-                --len;
+            if (precision > 0) {
+                while (buffer[len - 1] == '0') {
+                    --len;
+                }
+                if (buffer[len - 1] == '.') {
+                    --len;
+                }
             }
 
             return std::copy_n(buffer, len, iterator);
@@ -0,0 +1,244 @@
+#ifndef OSMIUM_UTIL_HASH64_HPP
+#define OSMIUM_UTIL_HASH64_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/endian.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace osmium {
+
+    namespace detail {
+
+        enum : uint64_t {
+            xxh64_prime1 = 0x9E3779B185EBCA87ULL,
+            xxh64_prime2 = 0xC2B2AE3D27D4EB4FULL,
+            xxh64_prime3 = 0x165667B19E3779F9ULL,
+            xxh64_prime4 = 0x85EBCA77C2B2AE63ULL,
+            xxh64_prime5 = 0x27D4EB2F165667C5ULL
+        };
+
+        inline uint64_t rotl64(uint64_t value, unsigned int bits) noexcept {
+            return (value << bits) | (value >> (64U - bits));
+        }
+
+        inline uint64_t read_le64(const unsigned char* data) noexcept {
+            uint64_t value; // NOLINT(cppcoreguidelines-init-variables)
+            std::memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+            return value;
+#else
+            return __builtin_bswap64(value);
+#endif
+        }
+
+        inline uint32_t read_le32(const unsigned char* data) noexcept {
+            uint32_t value; // NOLINT(cppcoreguidelines-init-variables)
+            std::memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+            return value;
+#else
+            return __builtin_bswap32(value);
+#endif
+        }
+
+        inline uint64_t xxh64_round(uint64_t acc, uint64_t input) noexcept {
+            acc += input * xxh64_prime2;
+            acc = rotl64(acc, 31);
+            return acc * xxh64_prime1;
+        }
+
+        inline uint64_t xxh64_merge_round(uint64_t acc, uint64_t value) noexcept {
+            acc ^= xxh64_round(0, value);
+            return acc * xxh64_prime1 + xxh64_prime4;
+        }
+
+    } // namespace detail
+
+    /**
+     * Fast non-cryptographic 64-bit hash. This is an implementation of
+     * the XXH64 algorithm (https://github.com/Cyan4973/xxHash) which
+     * works incrementally, the result only depends on the bytes fed into
+     * it, not on how they were split up into update() calls. The data is
+     * processed in 32-byte stripes with four independent accumulators,
+     * so the CPU can work on several of them at the same time.
+     *
+     * Usage:
+     * @code
+     * osmium::Hash64 hash;
+     * hash.update(data, size);
+     * hash.update_int64(id);
+     * uint64_t result = hash.digest();
+     * @endcode
+     */
+    class Hash64 {
+
+        enum : std::size_t {
+            stripe_size = 32
+        };
+
+        uint64_t m_acc[4];
+        uint64_t m_total_length = 0;
+        uint64_t m_seed;
+        unsigned char m_buffer[stripe_size];
+        std::size_t m_buffer_size = 0;
+
+        void process_stripe(const unsigned char* data) noexcept {
+            m_acc[0] = detail::xxh64_round(m_acc[0], detail::read_le64(data));
+            m_acc[1] = detail::xxh64_round(m_acc[1], detail::read_le64(data + 8));
+            m_acc[2] = detail::xxh64_round(m_acc[2], detail::read_le64(data + 16));
+            m_acc[3] = detail::xxh64_round(m_acc[3], detail::read_le64(data + 24));
+        }
+
+    public:
+
+        explicit Hash64(uint64_t seed = 0) noexcept :
+            m_acc{seed + detail::xxh64_prime1 + detail::xxh64_prime2,
+                  seed + detail::xxh64_prime2,
+                  seed,
+                  seed - detail::xxh64_prime1},
+            m_seed(seed),
+            m_buffer{} {
+        }
+
+        /// Add size bytes starting at data to the hash.
+        void update(const void* data, std::size_t size) noexcept {
+            const auto* ptr = static_cast<const unsigned char*>(data);
+            m_total_length += size;
+
+            if (m_buffer_size > 0) {
+                const std::size_t fill = std::min(size, stripe_size - m_buffer_size);
+                std::memcpy(m_buffer + m_buffer_size, ptr, fill);
+                m_buffer_size += fill;
+                ptr += fill;
+                size -= fill;
+                if (m_buffer_size < stripe_size) {
+                    return;
+                }
+                process_stripe(m_buffer);
+                m_buffer_size = 0;
+            }
+
+            while (size >= stripe_size) {
+                process_stripe(ptr);
+                ptr += stripe_size;
+                size -= stripe_size;
+            }
+
+            if (size > 0) {
+                std::memcpy(m_buffer, ptr, size);
+                m_buffer_size = size;
+            }
+        }
+
+        /// Add a 32-bit integer (in little-endian byte order) to the hash.
+        void update_int32(uint32_t value) noexcept {
+#if __BYTE_ORDER != __LITTLE_ENDIAN
+            value = __builtin_bswap32(value);
+#endif
+            update(&value, sizeof(value));
+        }
+
+        /// Add a 64-bit integer (in little-endian byte order) to the hash.
+        void update_int64(uint64_t value) noexcept {
+#if __BYTE_ORDER != __LITTLE_ENDIAN
+            value = __builtin_bswap64(value);
+#endif
+            update(&value, sizeof(value));
+        }
+
+        /**
+         * Get the hash of all data added so far. More data can be added
+         * afterwards.
+         */
+        uint64_t digest() const noexcept {
+            uint64_t hash; // NOLINT(cppcoreguidelines-init-variables)
+            if (m_total_length >= stripe_size) {
+                hash = detail::rotl64(m_acc[0], 1) + detail::rotl64(m_acc[1], 7) +
+                       detail::rotl64(m_acc[2], 12) + detail::rotl64(m_acc[3], 18);
+                for (const auto acc : m_acc) {
+                    hash = detail::xxh64_merge_round(hash, acc);
+                }
+            } else {
+                hash = m_seed + detail::xxh64_prime5;
+            }
+
+            hash += m_total_length;
+
+            const unsigned char* ptr = m_buffer;
+            std::size_t size = m_buffer_size;
+            while (size >= 8) {
+                hash ^= detail::xxh64_round(0, detail::read_le64(ptr));
+                hash = detail::rotl64(hash, 27) * detail::xxh64_prime1 + detail::xxh64_prime4;
+                ptr += 8;
+                size -= 8;
+            }
+            if (size >= 4) {
+                hash ^= static_cast<uint64_t>(detail::read_le32(ptr)) * detail::xxh64_prime1;
+                hash = detail::rotl64(hash, 23) * detail::xxh64_prime2 + detail::xxh64_prime3;
+                ptr += 4;
+                size -= 4;
+            }
+            while (size > 0) {
+                hash ^= static_cast<uint64_t>(*ptr) * detail::xxh64_prime5;
+                hash = detail::rotl64(hash, 11) * detail::xxh64_prime1;
+                ++ptr;
+                --size;
+            }
+
+            hash ^= hash >> 33U;
+            hash *= detail::xxh64_prime2;
+            hash ^= hash >> 29U;
+            hash *= detail::xxh64_prime3;
+            hash ^= hash >> 32U;
+
+            return hash;
+        }
+
+    }; // class Hash64
+
+    /// Hash size bytes starting at data in one go.
+    inline uint64_t hash64(const void* data, std::size_t size, uint64_t seed = 0) noexcept {
+        Hash64 hash{seed};
+        hash.update(data, size);
+        return hash.digest();
+    }
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_HASH64_HPP
@@ -0,0 +1,224 @@
+#ifndef OSMIUM_UTIL_HYPERLOGLOG_HPP
+#define OSMIUM_UTIL_HYPERLOGLOG_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/hash64.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Estimates the number of distinct items in a stream using the
+     * HyperLogLog algorithm. Items are added as 64-bit hashes, use
+     * add(data, size) to hash and add a string.
+     *
+     * With precision p the sketch uses 2^p one-byte registers and the
+     * standard error of the estimate is about 1.04 / sqrt(2^p), 1.6% for
+     * the default precision 12.
+     *
+     * As long as only a few distinct items were added, their hashes are
+     * stored in a small sorted list instead of the registers and the
+     * count is exact. This keeps sketches for the many small sets
+     * (for instance the values of rare keys) small.
+     *
+     * Sketches with the same precision can be merged, the result is the
+     * same as if all items had been added to one sketch. So several
+     * threads can each fill their own sketch and merge them at the end.
+     */
+    class HyperLogLog {
+
+        std::vector<uint64_t> m_sparse;
+        std::vector<uint8_t> m_registers;
+        unsigned int m_precision;
+
+        std::size_t sparse_limit() const noexcept {
+            // The sparse list uses 8 bytes per entry, switch to registers
+            // once it would need as much memory as the registers.
+            return (static_cast<std::size_t>(1U) << m_precision) / sizeof(uint64_t);
+        }
+
+        void add_to_registers(const uint64_t hash) noexcept {
+            const auto index = static_cast<std::size_t>(hash >> (64U - m_precision));
+            uint64_t rest = hash << m_precision;
+            const auto max_rank = static_cast<uint8_t>(64U - m_precision + 1U);
+            uint8_t rank = 1;
+            while (rank < max_rank && (rest & (1ULL << 63U)) == 0) {
+                ++rank;
+                rest <<= 1U;
+            }
+            if (m_registers[index] < rank) {
+                m_registers[index] = rank;
+            }
+        }
+
+        void switch_to_registers() {
+            m_registers.assign(static_cast<std::size_t>(1U) << m_precision, 0);
+            for (const auto hash : m_sparse) {
+                add_to_registers(hash);
+            }
+            m_sparse.clear();
+            m_sparse.shrink_to_fit();
+        }
+
+    public:
+
+        enum : unsigned int {
+            min_precision = 4,
+            max_precision = 18,
+            default_precision = 12
+        };
+
+        /**
+         * Create an empty sketch.
+         *
+         * @param precision Number of bits used for the register index,
+         *        between min_precision and max_precision.
+         * @throws std::invalid_argument if the precision is out of range.
+         */
+        explicit HyperLogLog(const unsigned int precision = default_precision) :
+            m_precision(precision) {
+            if (precision < min_precision || precision > max_precision) {
+                throw std::invalid_argument{"HyperLogLog precision out of range"};
+            }
+        }
+
+        unsigned int precision() const noexcept {
+            return m_precision;
+        }
+
+        /// Is the count still exact, ie. the sparse list is used?
+        bool exact() const noexcept {
+            return m_registers.empty();
+        }
+
+        /// Add an item given by its (well-mixed) 64-bit hash.
+        void add_hash(const uint64_t hash) {
+            if (!exact()) {
+                add_to_registers(hash);
+                return;
+            }
+            const auto it = std::lower_bound(m_sparse.begin(), m_sparse.end(), hash);
+            if (it != m_sparse.end() && *it == hash) {
+                return;
+            }
+            m_sparse.insert(it, hash);
+            if (m_sparse.size() > sparse_limit()) {
+                switch_to_registers();
+            }
+        }
+
+        /// Add an item given by its bytes.
+        void add(const void* data, const std::size_t size) {
+            add_hash(osmium::hash64(data, size));
+        }
+
+        /**
+         * Merge another sketch into this one.
+         *
+         * @throws std::invalid_argument if the precisions differ.
+         */
+        void merge(const HyperLogLog& other) {
+            if (other.m_precision != m_precision) {
+                throw std::invalid_argument{"Can not merge HyperLogLog sketches with different precision"};
+            }
+            if (other.exact()) {
+                for (const auto hash : other.m_sparse) {
+                    add_hash(hash);
+                }
+                return;
+            }
+            if (exact()) {
+                switch_to_registers();
+            }
+            assert(m_registers.size() == other.m_registers.size());
+            for (std::size_t i = 0; i < m_registers.size(); ++i) {
+                m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+            }
+        }
+
+        /// Estimated number of distinct items added.
+        double estimate() const noexcept {
+            if (exact()) {
+                return static_cast<double>(m_sparse.size());
+            }
+
+            const auto m = static_cast<double>(m_registers.size());
+            double sum = 0.0;
+            std::size_t zeros = 0;
+            for (const auto r : m_registers) {
+                sum += std::ldexp(1.0, -static_cast<int>(r));
+                if (r == 0) {
+                    ++zeros;
+                }
+            }
+
+            double alpha = 0.7213 / (1.0 + 1.079 / m);
+            if (m_precision == 4) {
+                alpha = 0.673;
+            } else if (m_precision == 5) {
+                alpha = 0.697;
+            } else if (m_precision == 6) {
+                alpha = 0.709;
+            }
+
+            const double estimate = alpha * m * m / sum;
+            if (estimate <= 2.5 * m && zeros != 0) {
+                // Linear counting is more accurate for small sets.
+                return m * std::log(m / static_cast<double>(zeros));
+            }
+            return estimate;
+        }
+
+        /// Approximate number of bytes of memory used.
+        std::size_t used_memory() const noexcept {
+            return sizeof(HyperLogLog) + m_sparse.capacity() * sizeof(uint64_t) + m_registers.capacity();
+        }
+
+        void clear() noexcept {
+            m_sparse.clear();
+            m_registers.clear();
+        }
+
+    }; // class HyperLogLog
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_HYPERLOGLOG_HPP
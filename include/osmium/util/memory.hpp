@@ -43,8 +43,10 @@ namespace osmium {
 
     class MemoryUsage {
 
-        int64_t m_current = 0;
-        int64_t m_peak    = 0;
+        int64_t m_current       = 0;
+        int64_t m_peak          = 0;
+        int64_t m_resident      = 0;
+        int64_t m_peak_resident = 0;
 
 #ifdef __linux__
         static int64_t parse_number(const std::string& line) {
@@ -57,8 +59,8 @@ namespace osmium {
     public:
         /**
          * Get the memory usage for the current process. The constructor will
-         * get the memory usage. Use the current() and peak() calls to access
-         * the result.
+         * get the memory usage. Use the current(), peak(), resident() and
+         * peak_resident() calls to access the result.
          *
          * This will only work on Linux, on other architectures this will
          * always return 0.
@@ -78,6 +80,12 @@ namespace osmium {
                     if (line.substr(0, 6) == "VmSize") {
                         m_current = parse_number(line);
                     }
+                    if (line.substr(0, 5) == "VmHWM") {
+                        m_peak_resident = parse_number(line);
+                    }
+                    if (line.substr(0, 5) == "VmRSS") {
+                        m_resident = parse_number(line);
+                    }
                 }
             }
 #endif
@@ -93,6 +101,16 @@ namespace osmium {
             return static_cast<int>(m_peak / 1024);
         }
 
+        /// Return current resident set size in MBytes
+        int resident() const {
+            return static_cast<int>(m_resident / 1024);
+        }
+
+        /// Return peak resident set size in MBytes
+        int peak_resident() const {
+            return static_cast<int>(m_peak_resident / 1024);
+        }
+
     }; // class MemoryUsage
 
 } // namespace osmium
@@ -55,6 +55,33 @@ namespace osmium {
 
     inline namespace util {
 
+        /**
+         * Hints for the operating system on how a memory mapping will be
+         * used. They are only hints, if the system doesn't support them
+         * they are silently ignored.
+         */
+        struct mapping_options {
+
+            enum class access_advice {
+                normal     = 0,
+                sequential = 1,
+                random     = 2
+            };
+
+            /// Use transparent huge pages (Linux only, MADV_HUGEPAGE).
+            bool huge_pages = false;
+
+            /// Expected access pattern (madvise()).
+            access_advice advice = access_advice::normal;
+
+            /**
+             * Pre-fault the pages of file-backed mappings when they are
+             * mapped (Linux only, MAP_POPULATE).
+             */
+            bool populate = false;
+
+        }; // struct mapping_options
+
         /**
          * Class for wrapping memory mapping system calls.
          *
@@ -91,6 +118,9 @@ namespace osmium {
          *
          * On Windows the file will be set to binary mode before the memory
          * mapping.
+         *
+         * The mapping_options can be used to give the system hints on how
+         * the memory will be used. They are applied again after a resize.
          */
         class MemoryMapping {
 
@@ -116,6 +146,9 @@ namespace osmium {
             /// Mapping mode
             mapping_mode m_mapping_mode;
 
+            /// Hints for the system
+            mapping_options m_options;
+
 #ifdef _WIN32
             HANDLE m_handle;
 #endif
@@ -137,6 +170,8 @@ namespace osmium {
 
             flag_type get_flags() const noexcept;
 
+            void apply_options() noexcept;
+
             static std::size_t check_size(std::size_t size) {
                 if (size == 0) {
                     return osmium::get_pagesize();
@@ -200,9 +235,10 @@ namespace osmium {
              * @param mode Mapping mode: readonly, or writable (shared or private)
              * @param fd Open file descriptor of a file we want to map
              * @param offset Offset into the file where the mapping should start
+             * @param options Hints for the system on how the memory is used
              * @throws std::system_error if the mapping fails
              */
-            MemoryMapping(std::size_t size, mapping_mode mode, int fd = -1, off_t offset = 0);
+            MemoryMapping(std::size_t size, mapping_mode mode, int fd = -1, off_t offset = 0, const mapping_options& options = mapping_options{});
 
             /// You can not copy construct a MemoryMapping.
             MemoryMapping(const MemoryMapping&) = delete;
@@ -287,6 +323,13 @@ namespace osmium {
                 return m_mapping_mode != mapping_mode::readonly;
             }
 
+            /**
+             * The hints this mapping was created with.
+             */
+            const mapping_options& options() const noexcept {
+                return m_options;
+            }
+
             /**
              * Get the address of the mapping as any pointer type you like.
              *
@@ -347,10 +390,11 @@ namespace osmium {
              * Create anonymous typed memory mapping of given size.
              *
              * @param size Number of objects of type T to be mapped
+             * @param options Hints for the system on how the memory is used
              * @throws std::system_error if the mapping fails
              */
-            explicit TypedMemoryMapping(std::size_t size) :
-                m_mapping(sizeof(T) * size, MemoryMapping::mapping_mode::write_private) {
+            explicit TypedMemoryMapping(std::size_t size, const mapping_options& options = mapping_options{}) :
+                m_mapping(sizeof(T) * size, MemoryMapping::mapping_mode::write_private, -1, 0, options) {
             }
 
             /**
@@ -361,10 +405,11 @@ namespace osmium {
              * @param mode Mapping mode: readonly, or writable (shared or private)
              * @param fd Open file descriptor of a file we want to map
              * @param offset Offset into the file where the mapping should start
+             * @param options Hints for the system on how the memory is used
              * @throws std::system_error if the mapping fails
              */
-            TypedMemoryMapping(std::size_t size, MemoryMapping::mapping_mode mode, int fd, off_t offset = 0) :
-                m_mapping(sizeof(T) * size, mode, fd, sizeof(T) * offset) {
+            TypedMemoryMapping(std::size_t size, MemoryMapping::mapping_mode mode, int fd, off_t offset = 0, const mapping_options& options = mapping_options{}) :
+                m_mapping(sizeof(T) * size, mode, fd, sizeof(T) * offset, options) {
             }
 
             /// You can not copy construct a TypedMemoryMapping.
@@ -561,22 +606,46 @@ inline int osmium::util::MemoryMapping::get_flags() const noexcept {
     if (m_fd == -1) {
         return MAP_PRIVATE | MAP_ANONYMOUS; // NOLINT(hicpp-signed-bitwise)
     }
-    if (m_mapping_mode == mapping_mode::write_shared) {
-        return MAP_SHARED;
+    int flags = m_mapping_mode == mapping_mode::write_shared ? MAP_SHARED : MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (m_options.populate) {
+        flags |= MAP_POPULATE; // NOLINT(hicpp-signed-bitwise)
+    }
+#endif
+    return flags;
+}
+
+inline void osmium::util::MemoryMapping::apply_options() noexcept {
+    // These are only hints, so errors are ignored.
+#ifdef MADV_HUGEPAGE
+    if (m_options.huge_pages) {
+        ::madvise(m_addr, m_size, MADV_HUGEPAGE);
+    }
+#endif
+    switch (m_options.advice) {
+        case mapping_options::access_advice::sequential:
+            ::madvise(m_addr, m_size, MADV_SEQUENTIAL);
+            break;
+        case mapping_options::access_advice::random:
+            ::madvise(m_addr, m_size, MADV_RANDOM);
+            break;
+        default: // mapping_options::access_advice::normal
+            break;
     }
-    return MAP_PRIVATE;
 }
 
-inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, mapping_mode mode, int fd, off_t offset) :
+inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, mapping_mode mode, int fd, off_t offset, const mapping_options& options) :
     m_size(check_size(size)),
     m_offset(offset),
     m_fd(resize_fd(fd)),
     m_mapping_mode(mode),
+    m_options(options),
     m_addr(::mmap(nullptr, m_size, get_protection(), get_flags(), m_fd, m_offset)) {
     assert(!(fd == -1 && mode == mapping_mode::readonly));
     if (!is_valid()) {
         throw std::system_error{errno, std::system_category(), "mmap failed"};
     }
+    apply_options();
 }
 
 inline osmium::util::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcept :
@@ -584,6 +653,7 @@ inline osmium::util::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcep
     m_offset(other.m_offset),
     m_fd(other.m_fd),
     m_mapping_mode(other.m_mapping_mode),
+    m_options(other.m_options),
     m_addr(other.m_addr) {
     other.make_invalid();
 }
@@ -599,6 +669,7 @@ inline osmium::util::MemoryMapping& osmium::util::MemoryMapping::operator=(osmiu
     m_offset       = other.m_offset;
     m_fd           = other.m_fd;
     m_mapping_mode = other.m_mapping_mode;
+    m_options      = other.m_options;
     m_addr         = other.m_addr;
     other.make_invalid();
     return *this;
@@ -622,6 +693,7 @@ inline void osmium::util::MemoryMapping::resize(std::size_t new_size) {
             throw std::system_error{errno, std::system_category(), "mremap failed"};
         }
         m_size = new_size;
+        apply_options();
 #else
         assert(false && "can't resize anonymous mappings on non-linux systems");
 #endif
@@ -633,6 +705,7 @@ inline void osmium::util::MemoryMapping::resize(std::size_t new_size) {
         if (!is_valid()) {
             throw std::system_error{errno, std::system_category(), "mmap (remap) failed"};
         }
+        apply_options();
     }
 }
 
@@ -687,6 +760,10 @@ inline DWORD osmium::util::MemoryMapping::get_flags() const noexcept {
     return FILE_MAP_WRITE;
 }
 
+inline void osmium::util::MemoryMapping::apply_options() noexcept {
+    // There are no equivalent hints on Windows.
+}
+
 inline HANDLE osmium::util::MemoryMapping::get_handle() const noexcept {
     if (m_fd == -1) {
         return INVALID_HANDLE_VALUE;
@@ -729,11 +806,12 @@ inline int last_error() noexcept {
     return static_cast<int>(GetLastError());
 }
 
-inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, MemoryMapping::mapping_mode mode, int fd, off_t offset) :
+inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, MemoryMapping::mapping_mode mode, int fd, off_t offset, const mapping_options& options) :
     m_size(check_size(size)),
     m_offset(offset),
     m_fd(resize_fd(fd)),
     m_mapping_mode(mode),
+    m_options(options),
     m_handle(create_file_mapping()),
     m_addr(nullptr) {
 
@@ -752,6 +830,7 @@ inline osmium::util::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcep
     m_offset(other.m_offset),
     m_fd(other.m_fd),
     m_mapping_mode(other.m_mapping_mode),
+    m_options(other.m_options),
     m_handle(std::move(other.m_handle)),
     m_addr(other.m_addr) {
     other.make_invalid();
@@ -769,6 +848,7 @@ inline osmium::util::MemoryMapping& osmium::util::MemoryMapping::operator=(osmiu
     m_offset       = other.m_offset;
     m_fd           = other.m_fd;
     m_mapping_mode = other.m_mapping_mode;
+    m_options      = other.m_options;
     m_handle       = std::move(other.m_handle);
     m_addr         = other.m_addr;
     other.make_invalid();
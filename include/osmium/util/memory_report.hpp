@@ -0,0 +1,156 @@
+#ifndef OSMIUM_UTIL_MEMORY_REPORT_HPP
+#define OSMIUM_UTIL_MEMORY_REPORT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/memory.hpp>
+
+#include <cstddef>
+#include <iomanip>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Collects the memory used by several components of a program (index
+     * maps, ID sets, item stashes, string tables, readers, ...) so that
+     * it can be reported in one place together with the memory usage of
+     * the whole process. This helps finding out which component grew if
+     * a program uses too much memory.
+     *
+     * Usage:
+     * @code
+     * osmium::MemoryReport report;
+     * report.add("location index", index);
+     * report.add("reader", reader);
+     * report.add("other", some_number_of_bytes);
+     * report.print(std::cerr);
+     * @endcode
+     */
+    class MemoryReport {
+
+        std::vector<std::pair<std::string, std::size_t>> m_entries;
+
+    public:
+
+        /**
+         * Add an entry with the given name and size in bytes. If there
+         * already is an entry with this name, its size is replaced.
+         */
+        void add(const std::string& name, std::size_t bytes) {
+            for (auto& entry : m_entries) {
+                if (entry.first == name) {
+                    entry.second = bytes;
+                    return;
+                }
+            }
+            m_entries.emplace_back(name, bytes);
+        }
+
+        /**
+         * Add an entry for an object with a used_memory() member function
+         * returning the number of bytes used.
+         */
+        template <typename T, typename std::enable_if<!std::is_arithmetic<T>::value, int>::type = 0>
+        void add(const std::string& name, const T& object) {
+            add(name, static_cast<std::size_t>(object.used_memory()));
+        }
+
+        /// The names and sizes (in bytes) of all entries in order added.
+        const std::vector<std::pair<std::string, std::size_t>>& entries() const noexcept {
+            return m_entries;
+        }
+
+        /// Size in bytes of the entry with the given name, 0 if not found.
+        std::size_t get(const std::string& name) const noexcept {
+            for (const auto& entry : m_entries) {
+                if (entry.first == name) {
+                    return entry.second;
+                }
+            }
+            return 0;
+        }
+
+        /// Sum of the sizes of all entries in bytes.
+        std::size_t total() const noexcept {
+            std::size_t result = 0;
+            for (const auto& entry : m_entries) {
+                result += entry.second;
+            }
+            return result;
+        }
+
+        /// Remove all entries.
+        void clear() noexcept {
+            m_entries.clear();
+        }
+
+        /**
+         * Print all entries, their total and the memory usage of the
+         * process as reported by MemoryUsage to the specified stream.
+         *
+         * @tparam TStream Output stream type (like std::cout, std::cerr,
+         *                 or osmium::VerboseOutput).
+         * @param stream Reference to stream where the output should go.
+         */
+        template <typename TStream>
+        void print(TStream& stream) const {
+            std::size_t width = 5;
+            for (const auto& entry : m_entries) {
+                if (entry.first.size() > width) {
+                    width = entry.first.size();
+                }
+            }
+            const auto w = static_cast<int>(width + 1);
+
+            for (const auto& entry : m_entries) {
+                stream << "  " << std::left << std::setw(w) << (entry.first + ':')
+                       << std::right << std::setw(10) << (entry.second / 1024) << " kB\n";
+            }
+            stream << "  " << std::left << std::setw(w) << "total:"
+                   << std::right << std::setw(10) << (total() / 1024) << " kB\n";
+
+            const osmium::MemoryUsage process;
+            stream << "  process: current " << process.current() << " MB, peak " << process.peak()
+                   << " MB, resident " << process.resident() << " MB, peak resident "
+                   << process.peak_resident() << " MB\n";
+        }
+
+    }; // class MemoryReport
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_MEMORY_REPORT_HPP
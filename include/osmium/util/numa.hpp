@@ -0,0 +1,194 @@
+#ifndef OSMIUM_UTIL_NUMA_HPP
+#define OSMIUM_UTIL_NUMA_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+# include <dirent.h>
+# include <sched.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    namespace detail {
+
+        /**
+         * Parse a list of CPUs in the format used by the Linux kernel,
+         * for instance "0-3,8,10-11".
+         */
+        inline std::vector<int> parse_cpu_list(const std::string& list) {
+            std::vector<int> cpus;
+
+            std::size_t pos = 0;
+            while (pos < list.size()) {
+                auto end = list.find(',', pos);
+                if (end == std::string::npos) {
+                    end = list.size();
+                }
+                const std::string range = list.substr(pos, end - pos);
+                const auto dash = range.find('-');
+                if (range.find_first_of("0123456789") != std::string::npos) {
+                    const int first = std::atoi(range.c_str());
+                    const int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+                    for (int cpu = first; cpu <= last; ++cpu) {
+                        cpus.push_back(cpu);
+                    }
+                }
+                pos = end + 1;
+            }
+
+            return cpus;
+        }
+
+    } // namespace detail
+
+    inline namespace util {
+
+        /**
+         * A NUMA node with the CPUs belonging to it.
+         */
+        struct numa_node {
+            int id = 0;
+            std::vector<int> cpus{};
+        }; // struct numa_node
+
+        /**
+         * Get the NUMA nodes of this system and their CPUs. Nodes without
+         * CPUs are not returned. This only works on Linux, on other
+         * systems (and if the information is not available) the result
+         * is empty.
+         */
+        inline std::vector<numa_node> get_numa_nodes() {
+            std::vector<numa_node> nodes;
+#ifdef __linux__
+            DIR* dir = ::opendir("/sys/devices/system/node");
+            if (!dir) {
+                return nodes;
+            }
+            while (const dirent* entry = ::readdir(dir)) {
+                const std::string name{entry->d_name};
+                if (name.size() < 5 || name.compare(0, 4, "node") != 0 ||
+                    name.find_first_not_of("0123456789", 4) != std::string::npos) {
+                    continue;
+                }
+                std::ifstream cpulist{"/sys/devices/system/node/" + name + "/cpulist"};
+                std::string line;
+                if (cpulist.is_open() && std::getline(cpulist, line)) {
+                    numa_node node;
+                    node.id = std::atoi(name.c_str() + 4);
+                    node.cpus = osmium::detail::parse_cpu_list(line);
+                    if (!node.cpus.empty()) {
+                        nodes.push_back(std::move(node));
+                    }
+                }
+            }
+            ::closedir(dir);
+
+            std::sort(nodes.begin(), nodes.end(), [](const numa_node& a, const numa_node& b) {
+                return a.id < b.id;
+            });
+#endif
+            return nodes;
+        }
+
+        /**
+         * Restrict the current thread to run only on the given CPUs.
+         *
+         * @returns true on success, false if this failed or is not
+         *          supported on this system.
+         */
+        inline bool pin_current_thread_to_cpus(const std::vector<int>& cpus) noexcept {
+#ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (const int cpu : cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            return ::sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+            (void)cpus;
+            return false;
+#endif
+        }
+
+        /**
+         * Set the memory policy for the given memory range so that the
+         * pages are interleaved over the given NUMA nodes. This only
+         * affects pages touched for the first time after this call. The
+         * memory range must start at a page boundary, which is always
+         * the case for memory mappings.
+         *
+         * @returns true on success, false if this failed or is not
+         *          supported on this system.
+         */
+        inline bool interleave_memory(void* addr, const std::size_t size, const std::vector<numa_node>& nodes) noexcept {
+#if defined(__linux__) && defined(SYS_mbind)
+            enum : int {
+                mpol_interleave = 3 // MPOL_INTERLEAVE from linux/mempolicy.h
+            };
+            enum : unsigned long {
+                max_node = 1024
+            };
+            unsigned long mask[max_node / (8 * sizeof(unsigned long))] = {0};
+            for (const auto& node : nodes) {
+                if (node.id >= 0 && static_cast<unsigned long>(node.id) < max_node) {
+                    mask[static_cast<std::size_t>(node.id) / (8 * sizeof(unsigned long))] |= 1UL << (static_cast<std::size_t>(node.id) % (8 * sizeof(unsigned long)));
+                }
+            }
+            return ::syscall(SYS_mbind, addr, size, mpol_interleave, mask, max_node, 0) == 0;
+#else
+            (void)addr;
+            (void)size;
+            (void)nodes;
+            return false;
+#endif
+        }
+
+    } // namespace util
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_NUMA_HPP
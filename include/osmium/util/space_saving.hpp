@@ -0,0 +1,253 @@
+#ifndef OSMIUM_UTIL_SPACE_SAVING_HPP
+#define OSMIUM_UTIL_SPACE_SAVING_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/hash64.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Finds the most frequent strings in a stream using the Space-Saving
+     * algorithm (Metwally, Agrawal, El Abbadi 2005) with a fixed number
+     * of counters.
+     *
+     * Each counter has an upper bound for the count of its item and the
+     * maximum error of this bound. Every item that occurs more often
+     * than total() / capacity() times is guaranteed to be in the sketch.
+     * Use a capacity a few times larger than the number of top items you
+     * are interested in to get good counts for them.
+     *
+     * Sketches can be merged (Agarwal et al. 2012), so several threads
+     * can each fill their own sketch and merge them at the end.
+     */
+    class SpaceSaving {
+
+    public:
+
+        struct entry {
+            std::string item;
+            uint64_t count;
+            uint64_t error;
+        };
+
+    private:
+
+        // Hashes of the items, searched before the (slower) strings.
+        std::vector<uint64_t> m_hashes;
+        std::vector<entry> m_entries;
+        std::size_t m_capacity;
+        uint64_t m_total = 0;
+
+        std::size_t find(const uint64_t hash, const char* data, const std::size_t size) const noexcept {
+            for (std::size_t i = 0; i < m_hashes.size(); ++i) {
+                if (m_hashes[i] == hash && m_entries[i].item.size() == size && !std::memcmp(m_entries[i].item.data(), data, size)) {
+                    return i;
+                }
+            }
+            return m_hashes.size();
+        }
+
+        std::size_t min_index() const noexcept {
+            std::size_t index = 0;
+            for (std::size_t i = 1; i < m_entries.size(); ++i) {
+                if (m_entries[i].count < m_entries[index].count) {
+                    index = i;
+                }
+            }
+            return index;
+        }
+
+        uint64_t min_count() const noexcept {
+            return full() ? m_entries[min_index()].count : 0;
+        }
+
+    public:
+
+        /**
+         * Create an empty sketch.
+         *
+         * @param capacity Number of counters.
+         * @throws std::invalid_argument if capacity is 0.
+         */
+        explicit SpaceSaving(const std::size_t capacity) :
+            m_capacity(capacity) {
+            if (capacity == 0) {
+                throw std::invalid_argument{"SpaceSaving capacity must be larger than 0"};
+            }
+        }
+
+        std::size_t capacity() const noexcept {
+            return m_capacity;
+        }
+
+        /// Number of counters in use.
+        std::size_t size() const noexcept {
+            return m_entries.size();
+        }
+
+        bool full() const noexcept {
+            return m_entries.size() == m_capacity;
+        }
+
+        /// Sum of all counts added.
+        uint64_t total() const noexcept {
+            return m_total;
+        }
+
+        /// Add count occurrences of the string with the given size.
+        void add(const char* data, const std::size_t size, const uint64_t count = 1) {
+            m_total += count;
+            const uint64_t hash = osmium::hash64(data, size);
+            const std::size_t index = find(hash, data, size);
+            if (index != m_entries.size()) {
+                m_entries[index].count += count;
+                return;
+            }
+            if (!full()) {
+                m_hashes.push_back(hash);
+                m_entries.push_back(entry{std::string(data, size), count, 0});
+                return;
+            }
+            // Replace the item with the smallest count, the new item
+            // inherits its count as error.
+            auto& e = m_entries[min_index()];
+            m_hashes[static_cast<std::size_t>(&e - m_entries.data())] = hash;
+            e.item.assign(data, size);
+            e.error = e.count;
+            e.count += count;
+        }
+
+        /// Add one occurrence of a null-terminated string.
+        void add(const char* str) {
+            add(str, std::strlen(str));
+        }
+
+        /**
+         * Merge another sketch into this one. The capacity of this sketch
+         * is kept.
+         */
+        void merge(const SpaceSaving& other) {
+            const uint64_t this_min = min_count();
+            const uint64_t other_min = other.min_count();
+
+            std::vector<bool> seen(other.m_entries.size(), false);
+            for (std::size_t i = 0; i < m_entries.size(); ++i) {
+                auto& e = m_entries[i];
+                const auto j = other.find(m_hashes[i], e.item.data(), e.item.size());
+                if (j == other.m_entries.size()) {
+                    e.count += other_min;
+                    e.error += other_min;
+                } else {
+                    e.count += other.m_entries[j].count;
+                    e.error += other.m_entries[j].error;
+                    seen[j] = true;
+                }
+            }
+            for (std::size_t j = 0; j < other.m_entries.size(); ++j) {
+                if (!seen[j]) {
+                    const auto& o = other.m_entries[j];
+                    m_hashes.push_back(other.m_hashes[j]);
+                    m_entries.push_back(entry{o.item, o.count + this_min, o.error + this_min});
+                }
+            }
+            m_total += other.m_total;
+
+            if (m_entries.size() > m_capacity) {
+                std::vector<std::size_t> order(m_entries.size());
+                for (std::size_t i = 0; i < order.size(); ++i) {
+                    order[i] = i;
+                }
+                std::stable_sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+                    return m_entries[a].count > m_entries[b].count;
+                });
+                order.resize(m_capacity);
+                std::vector<uint64_t> hashes;
+                std::vector<entry> entries;
+                hashes.reserve(m_capacity);
+                entries.reserve(m_capacity);
+                for (const auto i : order) {
+                    hashes.push_back(m_hashes[i]);
+                    entries.push_back(std::move(m_entries[i]));
+                }
+                m_hashes.swap(hashes);
+                m_entries.swap(entries);
+            }
+        }
+
+        /**
+         * Get the items with the highest counts, ordered by count
+         * (descending) and item.
+         *
+         * @param num Maximum number of items returned.
+         */
+        std::vector<entry> top(const std::size_t num) const {
+            std::vector<entry> result{m_entries};
+            std::sort(result.begin(), result.end(), [](const entry& a, const entry& b) {
+                return a.count > b.count || (a.count == b.count && a.item < b.item);
+            });
+            if (result.size() > num) {
+                result.resize(num);
+            }
+            return result;
+        }
+
+        /// Approximate number of bytes of memory used.
+        std::size_t used_memory() const noexcept {
+            std::size_t size = sizeof(SpaceSaving) + m_hashes.capacity() * sizeof(uint64_t) + m_entries.capacity() * sizeof(entry);
+            for (const auto& e : m_entries) {
+                size += e.item.capacity();
+            }
+            return size;
+        }
+
+        void clear() noexcept {
+            m_hashes.clear();
+            m_entries.clear();
+            m_total = 0;
+        }
+
+    }; // class SpaceSaving
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_SPACE_SAVING_HPP
@@ -34,11 +34,38 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 
 namespace osmium {
 
+    namespace detail {
+
+        /**
+         * Hash function for strings with known length. It works on
+         * eight bytes at a time.
+         */
+        inline uint64_t string_hash(const char* str, std::size_t length) noexcept {
+            uint64_t hash = 0x9e3779b97f4a7c15ULL ^ length;
+            while (length >= 8) {
+                uint64_t word = 0;
+                std::memcpy(&word, str, 8);
+                hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+                hash ^= hash >> 32U;
+                str += 8;
+                length -= 8;
+            }
+            uint64_t word = 0;
+            std::memcpy(&word, str, length);
+            hash = (hash ^ word) * 0xc4ceb9fe1a85ec53ULL;
+            hash ^= hash >> 29U;
+            return hash;
+        }
+
+    } // namespace detail
+
     /**
      * Split string on the separator character.
      *
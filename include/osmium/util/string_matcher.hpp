@@ -33,9 +33,13 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/util/aho_corasick.hpp>
+
 #include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <iosfwd>
+#include <memory>
 #include <regex>
 #include <string>
 #include <utility>
@@ -54,6 +58,10 @@ DEALINGS IN THE SOFTWARE.
 # include <boost/variant.hpp>
 #endif
 
+#ifdef OSMIUM_WITH_RE2
+# include <re2/re2.h>
+#endif
+
 
 // std::regex isn't implemented properly in glibc++ (before the version
 // delivered with GCC 4.9) and libc++ before the version 3.6, so the use is
@@ -89,6 +97,15 @@ namespace osmium {
 
         // Parent class for all matcher classes. Used for enable_if check.
         class matcher {
+
+        public:
+
+            // Matchers that match only a fixed set of strings override
+            // this, see StringMatcher::exact_strings().
+            static bool exact_strings(std::vector<std::string>& /*strings*/) {
+                return false;
+            }
+
         };
 
         /**
@@ -102,6 +119,10 @@ namespace osmium {
                 return false;
             }
 
+            static bool exact_strings(std::vector<std::string>& /*strings*/) {
+                return true;
+            }
+
             template <typename TChar, typename TTraits>
             void print(std::basic_ostream<TChar, TTraits>& out) const {
                 out << "always_false";
@@ -148,6 +169,11 @@ namespace osmium {
                 return !std::strcmp(m_str.c_str(), test_string);
             }
 
+            bool exact_strings(std::vector<std::string>& strings) const {
+                strings.push_back(m_str);
+                return true;
+            }
+
             template <typename TChar, typename TTraits>
             void print(std::basic_ostream<TChar, TTraits>& out) const {
                 out << "equal[" << m_str << ']';
@@ -214,10 +240,90 @@ namespace osmium {
 #ifdef OSMIUM_WITH_REGEX
         /**
          * Matches if the test string matches the regular expression.
+         *
+         * If the regex is created from a pattern string, the literal
+         * text at the beginning of the pattern (or after a ^ anchor) is
+         * extracted. Test strings not containing (or not starting with)
+         * this literal are rejected with a simple string comparison
+         * before the regex engine runs. Patterns which are nothing but
+         * a literal don't need the regex engine at all.
+         *
+         * If libosmium is compiled with OSMIUM_WITH_RE2 defined (CMake
+         * component "re2"), patterns given as strings are compiled with
+         * RE2, which guarantees linear time matching without
+         * backtracking. Patterns RE2 doesn't understand (for instance
+         * those with backreferences or lookahead) fall back to
+         * std::regex.
          */
         class regex : public matcher {
 
             std::regex m_regex;
+#ifdef OSMIUM_WITH_RE2
+            std::shared_ptr<const re2::RE2> m_re2;
+#endif
+            std::string m_literal;
+            bool m_anchored = false;
+            bool m_literal_only = false;
+
+            // Get the literal text a string must contain to match the
+            // pattern. This is the text from the beginning of the pattern
+            // (after an optional ^) up to the first character with a
+            // special meaning. Returns an empty string if there is no
+            // such text or if the pattern contains alternatives.
+            static std::string required_literal(const std::string& pattern, bool* anchored, bool* literal_only) {
+                std::string literal;
+                *anchored = false;
+                *literal_only = false;
+
+                if (pattern.find('|') != std::string::npos) {
+                    return literal;
+                }
+
+                std::size_t pos = 0;
+                if (!pattern.empty() && pattern[0] == '^') {
+                    *anchored = true;
+                    pos = 1;
+                }
+
+                while (pos < pattern.size()) {
+                    char c = pattern[pos];
+                    std::size_t next = pos + 1;
+                    if (c == '\\') {
+                        if (next == pattern.size() ||
+                            std::isalnum(static_cast<unsigned char>(pattern[next]))) {
+                            break; // character class, backreference, etc.
+                        }
+                        c = pattern[next];
+                        ++next;
+                    } else if (std::strchr("^$.*+?()[]{}", c)) {
+                        break;
+                    }
+
+                    if (next < pattern.size()) {
+                        const char q = pattern[next];
+                        if (q == '*' || q == '?' || q == '{') {
+                            break; // character is optional
+                        }
+                        if (q == '+') {
+                            literal += c;
+                            break;
+                        }
+                    }
+
+                    literal += c;
+                    pos = next;
+                }
+
+                *literal_only = (pos == pattern.size());
+                return literal;
+            }
+
+            bool check_literal(const char* test_string) const noexcept {
+                if (m_anchored) {
+                    return std::strncmp(test_string, m_literal.c_str(), m_literal.size()) == 0;
+                }
+                return std::strstr(test_string, m_literal.c_str()) != nullptr;
+            }
 
         public:
 
@@ -225,7 +331,53 @@ namespace osmium {
                 m_regex(std::move(regex)) {
             }
 
+            /**
+             * Create a regex matcher from a pattern string.
+             *
+             * @param pattern The regular expression.
+             * @param flags Flags for std::regex. The literal check and
+             *              RE2 are only used with the ECMAScript syntax
+             *              and without the icase flag.
+             * @throws std::regex_error if the pattern is invalid.
+             */
+            explicit regex(const std::string& pattern, std::regex::flag_type flags = std::regex::ECMAScript) {
+                const auto other_syntax = std::regex::basic | std::regex::extended | std::regex::awk |
+                                          std::regex::grep | std::regex::egrep | std::regex::icase;
+                if ((flags & other_syntax) != 0) {
+                    m_regex = std::regex{pattern, flags};
+                    return;
+                }
+
+                m_literal = required_literal(pattern, &m_anchored, &m_literal_only);
+                if (m_literal_only) {
+                    return;
+                }
+
+#ifdef OSMIUM_WITH_RE2
+                RE2::Options options;
+                options.set_log_errors(false);
+                std::shared_ptr<const re2::RE2> re2 = std::make_shared<re2::RE2>(pattern, options);
+                if (re2->ok()) {
+                    m_re2 = std::move(re2);
+                    return;
+                }
+#endif
+
+                m_regex = std::regex{pattern, flags};
+            }
+
             bool match(const char* test_string) const noexcept {
+                if (!m_literal.empty() && !check_literal(test_string)) {
+                    return false;
+                }
+                if (m_literal_only) {
+                    return true;
+                }
+#ifdef OSMIUM_WITH_RE2
+                if (m_re2) {
+                    return re2::RE2::PartialMatch(test_string, *m_re2);
+                }
+#endif
                 return std::regex_search(test_string, m_regex);
             }
 
@@ -244,29 +396,46 @@ namespace osmium {
 
             std::vector<std::string> m_strings;
 
+            // Same strings as in m_strings, but sorted for binary search.
+            std::vector<std::string> m_sorted;
+
+            void add_sorted(const std::string& str) {
+                m_sorted.insert(std::upper_bound(m_sorted.begin(), m_sorted.end(), str), str);
+            }
+
         public:
 
             explicit list() = default;
 
             explicit list(std::vector<std::string> strings) :
-                m_strings(std::move(strings)) {
+                m_strings(std::move(strings)),
+                m_sorted(m_strings) {
+                std::sort(m_sorted.begin(), m_sorted.end());
             }
 
             list& add_string(const char* str) {
                 m_strings.emplace_back(str);
+                add_sorted(m_strings.back());
                 return *this;
             }
 
             list& add_string(const std::string& str) {
                 m_strings.push_back(str);
+                add_sorted(str);
                 return *this;
             }
 
             bool match(const char* test_string) const noexcept {
-                return std::any_of(m_strings.cbegin(), m_strings.cend(),
-                                   [&test_string](const std::string& s){
-                    return s == test_string;
+                const auto it = std::lower_bound(m_sorted.cbegin(), m_sorted.cend(), test_string,
+                                                 [](const std::string& s, const char* t) {
+                    return std::strcmp(s.c_str(), t) < 0;
                 });
+                return it != m_sorted.cend() && !std::strcmp(it->c_str(), test_string);
+            }
+
+            bool exact_strings(std::vector<std::string>& strings) const {
+                strings.insert(strings.end(), m_strings.cbegin(), m_strings.cend());
+                return true;
             }
 
             template <typename TChar, typename TTraits>
@@ -280,6 +449,71 @@ namespace osmium {
 
         }; // class list
 
+        /**
+         * Matches if any of the stored strings is a substring of the test
+         * string. All strings are searched for at the same time using an
+         * Aho-Corasick automaton, so this is much faster than checking
+         * several substring matchers one after the other.
+         */
+        class substring_list : public matcher {
+
+            std::vector<std::string> m_strings;
+            osmium::detail::aho_corasick_automaton m_automaton;
+
+        public:
+
+            explicit substring_list(std::vector<std::string> strings) :
+                m_strings(std::move(strings)),
+                m_automaton(m_strings) {
+            }
+
+            bool match(const char* test_string) const noexcept {
+                return m_automaton.match_substring(test_string);
+            }
+
+            template <typename TChar, typename TTraits>
+            void print(std::basic_ostream<TChar, TTraits>& out) const {
+                out << "substring_list[";
+                for (const auto& s : m_strings) {
+                    out << '[' << s << ']';
+                }
+                out << ']';
+            }
+
+        }; // class substring_list
+
+        /**
+         * Matches if the test string starts with any of the stored
+         * strings. All strings are checked at the same time by walking a
+         * trie.
+         */
+        class prefix_list : public matcher {
+
+            std::vector<std::string> m_strings;
+            osmium::detail::aho_corasick_automaton m_automaton;
+
+        public:
+
+            explicit prefix_list(std::vector<std::string> strings) :
+                m_strings(std::move(strings)),
+                m_automaton(m_strings) {
+            }
+
+            bool match(const char* test_string) const noexcept {
+                return m_automaton.match_prefix(test_string);
+            }
+
+            template <typename TChar, typename TTraits>
+            void print(std::basic_ostream<TChar, TTraits>& out) const {
+                out << "prefix_list[";
+                for (const auto& s : m_strings) {
+                    out << '[' << s << ']';
+                }
+                out << ']';
+            }
+
+        }; // class prefix_list
+
     private:
 
         using matcher_type =
@@ -296,7 +530,9 @@ namespace osmium {
 #ifdef OSMIUM_WITH_REGEX
                  regex,
 #endif
-                 list>;
+                 list,
+                 substring_list,
+                 prefix_list>;
 
         matcher_type m_matcher;
 
@@ -321,6 +557,46 @@ namespace osmium {
 
         }; // class match_visitor
 
+        class exact_strings_visitor
+#ifndef OSMIUM_USE_STD_VARIANT
+        : public boost::static_visitor<bool>
+#endif
+        {
+
+            std::vector<std::string>* m_strings;
+
+        public:
+
+            explicit exact_strings_visitor(std::vector<std::string>& strings) noexcept :
+                m_strings(&strings) {
+            }
+
+            template <typename TMatcher>
+            bool operator()(const TMatcher& t) const {
+                return t.exact_strings(*m_strings);
+            }
+
+        }; // class exact_strings_visitor
+
+        class always_true_visitor
+#ifndef OSMIUM_USE_STD_VARIANT
+        : public boost::static_visitor<bool>
+#endif
+        {
+
+        public:
+
+            bool operator()(const always_true& /*t*/) const noexcept {
+                return true;
+            }
+
+            template <typename TMatcher>
+            bool operator()(const TMatcher& /*t*/) const noexcept {
+                return false;
+            }
+
+        }; // class always_true_visitor
+
         template <typename TChar, typename TTraits>
         class print_visitor
 #ifndef OSMIUM_USE_STD_VARIANT
@@ -443,6 +719,31 @@ namespace osmium {
             return operator()(str.c_str());
         }
 
+        /**
+         * If this matcher only matches a fixed set of strings (because
+         * it is an equal, list, or always_false matcher), append those
+         * strings to the vector and return true. Otherwise return false
+         * and leave the vector alone.
+         */
+        bool exact_strings(std::vector<std::string>& strings) const {
+#ifdef OSMIUM_USE_STD_VARIANT
+            return std::visit(exact_strings_visitor{strings}, m_matcher);
+#else
+            return boost::apply_visitor(exact_strings_visitor{strings}, m_matcher);
+#endif
+        }
+
+        /**
+         * Is this an always_true matcher?
+         */
+        bool is_always_true() const noexcept {
+#ifdef OSMIUM_USE_STD_VARIANT
+            return std::visit(always_true_visitor{}, m_matcher);
+#else
+            return boost::apply_visitor(always_true_visitor{}, m_matcher);
+#endif
+        }
+
         template <typename TChar, typename TTraits>
         void print(std::basic_ostream<TChar, TTraits>& out) const {
 #ifdef OSMIUM_USE_STD_VARIANT
@@ -0,0 +1,278 @@
+#ifndef OSMIUM_UTIL_STRING_POOL_HPP
+#define OSMIUM_UTIL_STRING_POOL_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/string.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * A pool of interned strings. Each distinct string added to the pool
+     * gets a small integer id, ids are handed out in insertion order
+     * starting from 0. The pool keeps a null-terminated copy of each
+     * string which stays at the same place in memory until the pool is
+     * cleared or destroyed.
+     *
+     * Strings are found through a hash table with open addressing and
+     * linear probing. This is meant for strings that repeat a lot, like
+     * the keys of tags. Comparing the ids of interned strings is much
+     * cheaper than comparing the strings.
+     *
+     * This class is not thread-safe.
+     */
+    class StringPool {
+
+    public:
+
+        using id_type = uint32_t;
+
+        enum : id_type {
+            /// Returned by find() if the string is not in the pool.
+            not_found = std::numeric_limits<id_type>::max()
+        };
+
+    private:
+
+        enum {
+            chunk_size = 64UL * 1024UL
+        };
+
+        // Slot in the hash table, id+1 is stored so that 0 can mark an
+        // empty slot.
+        struct slot {
+            uint32_t hash = 0;
+            id_type id_plus_one = 0;
+        };
+
+        std::vector<std::unique_ptr<char[]>> m_chunks;
+        char* m_current_chunk = nullptr;
+        std::size_t m_chunk_used = chunk_size;
+        std::size_t m_chunk_memory = 0;
+
+        std::vector<const char*> m_strings;
+        std::vector<std::size_t> m_lengths;
+        std::vector<slot> m_slots;
+        std::size_t m_mask;
+
+        const char* store(const char* str, std::size_t length) {
+            const std::size_t size = length + 1;
+            char* data = nullptr;
+            if (size > chunk_size / 4) {
+                // Large strings get their own chunk, so we don't waste
+                // the rest of the current chunk.
+                m_chunks.emplace_back(new char[size]);
+                m_chunk_memory += size;
+                data = m_chunks.back().get();
+            } else {
+                if (m_chunk_used + size > chunk_size) {
+                    m_chunks.emplace_back(new char[chunk_size]);
+                    m_chunk_memory += chunk_size;
+                    m_current_chunk = m_chunks.back().get();
+                    m_chunk_used = 0;
+                }
+                data = m_current_chunk + m_chunk_used;
+                m_chunk_used += size;
+            }
+            std::memcpy(data, str, length);
+            data[length] = '\0';
+            return data;
+        }
+
+        std::size_t find_slot(uint32_t hash, const char* str, std::size_t length) const noexcept {
+            std::size_t pos = hash & m_mask;
+            while (m_slots[pos].id_plus_one != 0) {
+                const id_type id = m_slots[pos].id_plus_one - 1;
+                if (m_slots[pos].hash == hash &&
+                    m_lengths[id] == length &&
+                    std::memcmp(m_strings[id], str, length) == 0) {
+                    return pos;
+                }
+                pos = (pos + 1) & m_mask;
+            }
+            return pos;
+        }
+
+        void grow() {
+            std::vector<slot> old_slots(m_slots.size() * 2);
+            using std::swap;
+            swap(old_slots, m_slots);
+            m_mask = m_slots.size() - 1;
+            for (const auto& s : old_slots) {
+                if (s.id_plus_one != 0) {
+                    std::size_t pos = s.hash & m_mask;
+                    while (m_slots[pos].id_plus_one != 0) {
+                        pos = (pos + 1) & m_mask;
+                    }
+                    m_slots[pos] = s;
+                }
+            }
+        }
+
+    public:
+
+        StringPool() :
+            m_slots(16),
+            m_mask(m_slots.size() - 1) {
+        }
+
+        /// The number of strings in the pool.
+        std::size_t size() const noexcept {
+            return m_strings.size();
+        }
+
+        /// Is the pool empty?
+        bool empty() const noexcept {
+            return m_strings.empty();
+        }
+
+        /**
+         * Add a string to the pool if it isn't in there already.
+         *
+         * @param str Pointer to the string, doesn't need to be
+         *            null-terminated.
+         * @param length Length of the string.
+         * @returns The id of the string.
+         */
+        id_type add(const char* str, std::size_t length) {
+            const auto hash = static_cast<uint32_t>(osmium::detail::string_hash(str, length));
+            const std::size_t pos = find_slot(hash, str, length);
+            if (m_slots[pos].id_plus_one != 0) {
+                return m_slots[pos].id_plus_one - 1;
+            }
+
+            assert(m_strings.size() < not_found);
+            const auto id = static_cast<id_type>(m_strings.size());
+            m_strings.push_back(store(str, length));
+            m_lengths.push_back(length);
+            m_slots[pos].hash = hash;
+            m_slots[pos].id_plus_one = id + 1;
+
+            if (m_strings.size() * 4 > m_slots.size() * 3) {
+                grow();
+            }
+
+            return id;
+        }
+
+        /**
+         * Add a null-terminated string to the pool if it isn't in there
+         * already.
+         *
+         * @returns The id of the string.
+         */
+        id_type add(const char* str) {
+            return add(str, std::strlen(str));
+        }
+
+        /**
+         * Find a string in the pool.
+         *
+         * @param str Pointer to the string, doesn't need to be
+         *            null-terminated.
+         * @param length Length of the string.
+         * @returns The id of the string or not_found.
+         */
+        id_type find(const char* str, std::size_t length) const noexcept {
+            if (empty()) {
+                return not_found;
+            }
+            const auto hash = static_cast<uint32_t>(osmium::detail::string_hash(str, length));
+            return m_slots[find_slot(hash, str, length)].id_plus_one - 1;
+        }
+
+        /**
+         * Find a null-terminated string in the pool.
+         *
+         * @returns The id of the string or not_found.
+         */
+        id_type find(const char* str) const noexcept {
+            return find(str, std::strlen(str));
+        }
+
+        /**
+         * Get the null-terminated string with the specified id. The id
+         * must be valid.
+         */
+        const char* get(const id_type id) const noexcept {
+            assert(id < m_strings.size());
+            return m_strings[id];
+        }
+
+        /**
+         * Get the length of the string with the specified id. The id
+         * must be valid.
+         */
+        std::size_t length(const id_type id) const noexcept {
+            assert(id < m_lengths.size());
+            return m_lengths[id];
+        }
+
+        /// Memory used by the pool in bytes (approximately).
+        std::size_t used_memory() const noexcept {
+            return m_chunk_memory +
+                   m_strings.capacity() * sizeof(const char*) +
+                   m_lengths.capacity() * sizeof(std::size_t) +
+                   m_slots.capacity() * sizeof(slot);
+        }
+
+        /**
+         * Remove all strings from the pool and release the memory. All
+         * ids and pointers to strings are invalid afterwards.
+         */
+        void clear() {
+            m_chunks.clear();
+            m_current_chunk = nullptr;
+            m_chunk_used = chunk_size;
+            m_chunk_memory = 0;
+            m_strings.clear();
+            m_lengths.clear();
+            m_slots.assign(16, slot{});
+            m_mask = m_slots.size() - 1;
+        }
+
+    }; // class StringPool
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_STRING_POOL_HPP
@@ -0,0 +1,77 @@
+#ifndef OSMIUM_UTIL_TRACEPOINT_HPP
+#define OSMIUM_UTIL_TRACEPOINT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2022 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Static tracepoints (USDT probes) in the I/O and area assembly code.
+ *
+ * They are compiled out unless OSMIUM_WITH_USDT is defined, in which case
+ * <sys/sdt.h> from SystemTap is needed. The probes can then be used with
+ * perf, bpftrace, SystemTap and other tools on the running process
+ * without any overhead while they are not enabled. All probes are in the
+ * provider "osmium":
+ *
+ * - pbf_blob_read_start(size), pbf_blob_read_end(size): Reading a PBF
+ *   data blob of the given size from the file.
+ * - pbf_blob_decode_start(size), pbf_blob_decode_end(size, bytes):
+ *   Decoding a PBF data blob of the given size into a buffer with the
+ *   given number of bytes.
+ * - queue_push_wait_start(name, size), queue_push_wait_end(name, size):
+ *   Producer blocked on a full queue.
+ * - queue_pop_wait_start(name), queue_pop_wait_end(name): Consumer
+ *   blocked on an empty queue.
+ * - reader_buffer(bytes): Buffer returned from the Reader.
+ * - write_done(size): Block of data written by the write thread.
+ * - assembler_relation_start(id, members),
+ *   assembler_relation_end(id, okay): Assembling an area from a
+ *   multipolygon relation.
+ */
+
+#ifdef OSMIUM_WITH_USDT
+
+# include <sys/sdt.h>
+
+# define OSMIUM_TRACEPOINT1(name, a1) DTRACE_PROBE1(osmium, name, a1)
+# define OSMIUM_TRACEPOINT2(name, a1, a2) DTRACE_PROBE2(osmium, name, a1, a2)
+
+#else
+
+# define OSMIUM_TRACEPOINT1(name, a1) static_cast<void>(0)
+# define OSMIUM_TRACEPOINT2(name, a1, a2) static_cast<void>(0)
+
+#endif
+
+#endif // OSMIUM_UTIL_TRACEPOINT_HPP
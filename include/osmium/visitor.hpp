@@ -39,6 +39,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm.hpp>
 #include <osmium/osm/entity.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 
 #include <type_traits>
@@ -94,6 +95,9 @@ namespace osmium {
                 case osmium::item_type::changeset_discussion:
                     handler.changeset_discussion(static_cast<ConstIfConst<TItem, osmium::ChangesetDiscussion>&>(item));
                     break;
+                case osmium::item_type::bounding_box:
+                case osmium::item_type::compressed_way_node_list:
+                    break;
             }
         }
 
@@ -300,8 +304,161 @@ namespace osmium {
             return wrapper_handler<typename std::decay<T>::type>(std::forward<T>(func));
         }
 
+        template <typename T>
+        struct void_type {
+            using type = void;
+        };
+
+        // Does the handler class T (derived from osmium::handler::Handler)
+        // have its own version of the callback? If &T::callback has the
+        // same type as in the Handler base class, T doesn't. If the
+        // expression is invalid, for instance because T has several
+        // overloads, we assume that it does.
+#define OSMIUM_HANDLER_HAS_CALLBACK(callback) \
+        template <typename T, typename = void> \
+        struct handler_has_##callback : std::true_type {}; \
+        template <typename T> \
+        struct handler_has_##callback<T, typename void_type<decltype(&T::callback)>::type> : \
+            std::integral_constant<bool, !std::is_same<decltype(&T::callback), decltype(&osmium::handler::Handler::callback)>::value> {};
+
+        OSMIUM_HANDLER_HAS_CALLBACK(osm_object)
+        OSMIUM_HANDLER_HAS_CALLBACK(node)
+        OSMIUM_HANDLER_HAS_CALLBACK(way)
+        OSMIUM_HANDLER_HAS_CALLBACK(relation)
+        OSMIUM_HANDLER_HAS_CALLBACK(area)
+        OSMIUM_HANDLER_HAS_CALLBACK(changeset)
+        OSMIUM_HANDLER_HAS_CALLBACK(tag_list)
+        OSMIUM_HANDLER_HAS_CALLBACK(way_node_list)
+        OSMIUM_HANDLER_HAS_CALLBACK(relation_member_list)
+        OSMIUM_HANDLER_HAS_CALLBACK(outer_ring)
+        OSMIUM_HANDLER_HAS_CALLBACK(inner_ring)
+        OSMIUM_HANDLER_HAS_CALLBACK(changeset_discussion)
+
+#undef OSMIUM_HANDLER_HAS_CALLBACK
+
+        // Can the functor T be called with a const TObject?
+        template <typename T, typename TObject, typename = void>
+        struct functor_takes_const : std::false_type {};
+
+        template <typename T, typename TObject>
+        struct functor_takes_const<T, TObject, typename void_type<decltype(std::declval<T&>()(std::declval<const TObject&>()))>::type> : std::true_type {};
+
+        // Can the functor T be called with a non-const TObject?
+        template <typename T, typename TObject, typename = void>
+        struct functor_takes_mutable : std::false_type {};
+
+        template <typename T, typename TObject>
+        struct functor_takes_mutable<T, TObject, typename void_type<decltype(std::declval<T&>()(std::declval<TObject&>()))>::type> : std::true_type {};
+
+        template <typename T, typename TObject>
+        struct functor_takes : std::integral_constant<bool,
+            functor_takes_const<T, TObject>::value ||
+            functor_takes_mutable<T, TObject>::value> {};
+
+        template <typename T>
+        constexpr osmium::osm_entity_bits::type bit_if(osmium::osm_entity_bits::type bits) noexcept {
+            return T::value ? bits : osmium::osm_entity_bits::nothing;
+        }
+
+        // Entity types a handler or functor is interested in.
+        template <typename T, typename = void>
+        struct entity_bits_of {
+            // Not derived from Handler, we don't know anything about it.
+            static constexpr osmium::osm_entity_bits::type value() noexcept {
+                return osmium::osm_entity_bits::all;
+            }
+        };
+
+        template <typename T>
+        struct entity_bits_of<T, typename std::enable_if<is_handler<T>::value>::type> {
+            static constexpr osmium::osm_entity_bits::type value() noexcept {
+                return (handler_has_tag_list<T>::value ||
+                        handler_has_way_node_list<T>::value ||
+                        handler_has_relation_member_list<T>::value ||
+                        handler_has_outer_ring<T>::value ||
+                        handler_has_inner_ring<T>::value ||
+                        handler_has_changeset_discussion<T>::value) ? osmium::osm_entity_bits::all :
+                       bit_if<handler_has_osm_object<T>>(osmium::osm_entity_bits::nwra) |
+                       bit_if<handler_has_node<T>>(osmium::osm_entity_bits::node) |
+                       bit_if<handler_has_way<T>>(osmium::osm_entity_bits::way) |
+                       bit_if<handler_has_relation<T>>(osmium::osm_entity_bits::relation) |
+                       bit_if<handler_has_area<T>>(osmium::osm_entity_bits::area) |
+                       bit_if<handler_has_changeset<T>>(osmium::osm_entity_bits::changeset);
+            }
+        };
+
+        template <typename TFunc>
+        struct entity_bits_of<wrapper_handler<TFunc>> {
+            static constexpr osmium::osm_entity_bits::type value() noexcept {
+                return bit_if<functor_takes<TFunc, osmium::Node>>(osmium::osm_entity_bits::node) |
+                       bit_if<functor_takes<TFunc, osmium::Way>>(osmium::osm_entity_bits::way) |
+                       bit_if<functor_takes<TFunc, osmium::Relation>>(osmium::osm_entity_bits::relation) |
+                       bit_if<functor_takes<TFunc, osmium::Area>>(osmium::osm_entity_bits::area) |
+                       bit_if<functor_takes<TFunc, osmium::Changeset>>(osmium::osm_entity_bits::changeset);
+            }
+        };
+
+        template <typename... THandlers>
+        struct combined_entity_bits;
+
+        template <>
+        struct combined_entity_bits<> {
+            static constexpr osmium::osm_entity_bits::type value() noexcept {
+                return osmium::osm_entity_bits::nothing;
+            }
+        };
+
+        template <typename THandler, typename... TRest>
+        struct combined_entity_bits<THandler, TRest...> {
+            static constexpr osmium::osm_entity_bits::type value() noexcept {
+                return entity_bits_of<THandler>::value() | combined_entity_bits<TRest...>::value();
+            }
+        };
+
+        // The type make_handler() returns for T.
+        template <typename T>
+        using handler_type = typename std::conditional<is_handler<T>::value,
+                                                       typename std::decay<T>::type,
+                                                       wrapper_handler<typename std::decay<T>::type>>::type;
+
+        // Does any of the handlers want an item of this type? Items that
+        // are not OSM objects or changesets are only wanted if all bits
+        // are set, because otherwise no handler has callbacks for them.
+        inline bool wants_item_type(const osmium::osm_entity_bits::type bits, const osmium::item_type type) noexcept {
+            if (bits == osmium::osm_entity_bits::all) {
+                return true;
+            }
+            const auto ut = static_cast<std::underlying_type<osmium::item_type>::type>(type);
+            if (ut == 0 || ut > 0x05) {
+                return false;
+            }
+            return (bits & static_cast<osmium::osm_entity_bits::type>(1U << (ut - 1U))) != 0;
+        }
+
     } // namespace detail
 
+    /**
+     * Get the types of OSM entities the handlers are interested in. For
+     * handlers derived from osmium::handler::Handler this is based on
+     * the callbacks they implement, for functors (lambdas) on the
+     * parameter types they can be called with. Use this to tell the
+     * Reader which types to read:
+     *
+     * @code
+     * MyHandler handler;
+     * osmium::io::Reader reader{file, osmium::entity_bits_for(handler)};
+     * osmium::apply(reader, handler);
+     * @endcode
+     *
+     * Handlers with callbacks for items that are not entities (like
+     * tag_list()) and handlers not derived from Handler are assumed to
+     * want everything.
+     */
+    template <typename... THandlers>
+    constexpr osmium::osm_entity_bits::type entity_bits_for(const THandlers&... /*handlers*/) noexcept {
+        return detail::combined_entity_bits<detail::handler_type<THandlers>...>::value();
+    }
+
     template <typename TItem, typename... THandlers>
     inline void apply_item(TItem& item, THandlers&&... handlers) {
         (void)std::initializer_list<int>{
@@ -316,8 +473,12 @@ namespace osmium {
 
     template <typename TIterator, typename... THandlers>
     inline void apply_impl(TIterator it, TIterator end, THandlers&&... handlers) {
+        // Items none of the handlers has a callback for are skipped.
+        constexpr const auto bits = detail::combined_entity_bits<typename std::decay<THandlers>::type...>::value();
         for (; it != end; ++it) {
-            apply_item(*it, handlers...);
+            if (detail::wants_item_type(bits, (*it).type())) {
+                apply_item(*it, handlers...);
+            }
         }
         apply_flush(std::forward<THandlers>(handlers)...);
     }
@@ -334,9 +495,46 @@ namespace osmium {
         apply(begin(c), end(c), std::forward<THandlers>(handlers)...);
     }
 
+    template <typename... THandlers>
+    inline void apply_buffer_impl(const osmium::memory::Buffer& buffer, THandlers&&... handlers) {
+        constexpr const auto bits = detail::combined_entity_bits<typename std::decay<THandlers>::type...>::value();
+        if (bits == osmium::osm_entity_bits::all || !buffer.has_type_index()) {
+            apply_impl(buffer.cbegin(), buffer.cend(), std::forward<THandlers>(handlers)...);
+            return;
+        }
+
+        // Only look at the parts of the buffer with the types of items
+        // the handlers are interested in.
+        for (const auto& range : buffer.type_index()) {
+            if (detail::wants_item_type(bits, range.type)) {
+                const osmium::memory::Buffer::const_iterator end{buffer.data() + range.end, buffer.data() + range.end};
+                for (osmium::memory::Buffer::const_iterator it{buffer.data() + range.begin, buffer.data() + range.end}; it != end; ++it) {
+                    apply_item(*it, handlers...);
+                }
+            }
+        }
+        apply_flush(std::forward<THandlers>(handlers)...);
+    }
+
     template <typename... THandlers>
     inline void apply(const osmium::memory::Buffer& buffer, THandlers&&... handlers) {
-        apply(buffer.cbegin(), buffer.cend(), std::forward<THandlers>(handlers)...);
+        apply_buffer_impl(buffer, detail::make_handler<THandlers>(std::forward<THandlers>(handlers))...);
+    }
+
+    /**
+     * Read a file and apply the handlers to all objects in it. Only
+     * the types of entities the handlers are interested in (see
+     * entity_bits_for()) are read, the others are never decoded.
+     *
+     * @param file The file to read.
+     * @param handlers The handlers (or lambdas).
+     * @throws Any exception thrown by the Reader or the handlers.
+     */
+    template <typename... THandlers>
+    inline void apply_file(const osmium::io::File& file, THandlers&&... handlers) {
+        osmium::io::Reader reader{file, entity_bits_for(handlers...)};
+        apply(reader, std::forward<THandlers>(handlers)...);
+        reader.close();
     }
 
 } // namespace osmium
@@ -103,7 +103,18 @@ static header_buffer_type parse_xml(std::string input) {
         osmium::osm_entity_bits::all,
         osmium::io::read_meta::yes,
         osmium::io::buffers_type::any,
-        false
+        false,
+        nullptr,
+        osmium::io::decoded_buffer_callback{},
+        osmium::io::tags_prefilter{},
+        osmium::io::timestamp_window{},
+        osmium::io::read_query{},
+        osmium::io::keep_raw_blobs::no,
+        osmium::io::pool_for_pbf_parsing::from_config,
+        osmium::io::verify_sorting::no,
+        osmium::io::reader_buffer_size{},
+        nullptr,
+        nullptr
     };
     osmium::io::detail::XMLParser parser{args};
     parser.parse();
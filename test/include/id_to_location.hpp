@@ -0,0 +1,85 @@
+#ifndef OSMIUM_TEST_ID_TO_LOCATION_HPP
+#define OSMIUM_TEST_ID_TO_LOCATION_HPP
+
+// Checks used by the tests of the different location index maps.
+
+#include "catch.hpp"
+
+#include <osmium/index/index.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+template <typename TIndex>
+void test_func_all(TIndex& index) {
+    const osmium::unsigned_object_id_type id1 = 12;
+    const osmium::unsigned_object_id_type id2 = 3;
+    const osmium::Location loc1{1.2, 4.5};
+    const osmium::Location loc2{3.5, -7.2};
+
+    REQUIRE_THROWS_AS(index.get(id1), osmium::not_found);
+
+    index.set(id1, loc1);
+    index.set(id2, loc2);
+
+    index.sort();
+
+    REQUIRE_THROWS_AS(index.get(0), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(1), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(5), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(100), osmium::not_found);
+    REQUIRE_THROWS_WITH(index.get(0), "id 0 not found");
+    REQUIRE_THROWS_WITH(index.get(1), "id 1 not found");
+
+    REQUIRE(index.get_noexcept(0) == osmium::Location{});
+    REQUIRE(index.get_noexcept(1) == osmium::Location{});
+    REQUIRE(index.get_noexcept(5) == osmium::Location{});
+    REQUIRE(index.get_noexcept(100) == osmium::Location{});
+}
+
+template <typename TIndex>
+void test_func_real(TIndex& index) {
+    const osmium::unsigned_object_id_type id1 = 12;
+    const osmium::unsigned_object_id_type id2 = 3;
+    const osmium::Location loc1{1.2, 4.5};
+    const osmium::Location loc2{3.5, -7.2};
+
+    index.set(id1, loc1);
+    index.set(id2, loc2);
+
+    index.sort();
+
+    REQUIRE(loc1 == index.get(id1));
+    REQUIRE(loc2 == index.get(id2));
+
+    REQUIRE(loc1 == index.get_noexcept(id1));
+    REQUIRE(loc2 == index.get_noexcept(id2));
+
+    REQUIRE_THROWS_AS(index.get(0), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(1), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(5), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(100), osmium::not_found);
+
+    REQUIRE(index.get_noexcept(0) == osmium::Location{});
+    REQUIRE(index.get_noexcept(1) == osmium::Location{});
+    REQUIRE(index.get_noexcept(5) == osmium::Location{});
+    REQUIRE(index.get_noexcept(100) == osmium::Location{});
+
+    index.clear();
+
+    REQUIRE_THROWS_AS(index.get(id1), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(id2), osmium::not_found);
+
+    REQUIRE_THROWS_AS(index.get(0), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(1), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(5), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(100), osmium::not_found);
+
+    REQUIRE(index.get_noexcept(id1) == osmium::Location{});
+    REQUIRE(index.get_noexcept(id2) == osmium::Location{});
+    REQUIRE(index.get_noexcept(0) == osmium::Location{});
+    REQUIRE(index.get_noexcept(1) == osmium::Location{});
+    REQUIRE(index.get_noexcept(5) == osmium::Location{});
+    REQUIRE(index.get_noexcept(100) == osmium::Location{});
+}
+
+#endif // OSMIUM_TEST_ID_TO_LOCATION_HPP
@@ -1,10 +1,16 @@
 #include "catch.hpp"
 
 #include <osmium/area/assembler.hpp>
+#include <osmium/area/problem_reporter.hpp>
 #include <osmium/builder/attr.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/area.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
 using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
 
 TEST_CASE("Build area from way") {
@@ -141,3 +147,244 @@ TEST_CASE("Build area from way with ignored invalid location") {
     REQUIRE(s.invalid_locations == 1);
 }
 
+
+namespace {
+
+    class NullProblemReporter : public osmium::area::ProblemReporter {
+    }; // class NullProblemReporter
+
+    // Assemble the way once with the fast path for simple rings and once
+    // with the general algorithm (which is always used if there is a
+    // problem reporter) and compare the results.
+    void check_simple_way(const osmium::Way& way) {
+        const osmium::area::AssemblerConfig config_fast;
+        osmium::area::Assembler assembler_fast{config_fast};
+        osmium::memory::Buffer buffer_fast{1024};
+        const bool okay_fast = assembler_fast(way, buffer_fast);
+
+        NullProblemReporter reporter;
+        osmium::area::AssemblerConfig config_general;
+        config_general.problem_reporter = &reporter;
+        osmium::area::Assembler assembler_general{config_general};
+        osmium::memory::Buffer buffer_general{1024};
+        const bool okay_general = assembler_general(way, buffer_general);
+
+        REQUIRE(okay_fast == okay_general);
+        REQUIRE(buffer_fast.committed() == buffer_general.committed());
+        REQUIRE(std::equal(buffer_fast.data(), buffer_fast.data() + buffer_fast.committed(), buffer_general.data()));
+
+        const auto& s1 = assembler_fast.stats();
+        const auto& s2 = assembler_general.stats();
+        REQUIRE(s1.area_simple_case == s2.area_simple_case);
+        REQUIRE(s1.from_ways == s2.from_ways);
+        REQUIRE(s1.nodes == s2.nodes);
+        REQUIRE(s1.outer_rings == s2.outer_rings);
+        REQUIRE(s1.inner_rings == s2.inner_rings);
+        REQUIRE(s1.intersections == s2.intersections);
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Fast path for simple closed ways gives same result as general algorithm") {
+    osmium::memory::Buffer buffer{10240};
+
+    SECTION("clockwise square") {
+        osmium::builder::add_way(buffer, _id(1), _tag("building", "yes"), _nodes({
+            {1, {1.0, 1.0}}, {2, {1.0, 2.0}}, {3, {2.0, 2.0}}, {4, {2.0, 1.0}}, {1, {1.0, 1.0}}
+        }));
+    }
+
+    SECTION("counter-clockwise square not starting at smallest location") {
+        osmium::builder::add_way(buffer, _id(1), _tag("building", "yes"), _nodes({
+            {3, {2.0, 2.0}}, {2, {1.0, 2.0}}, {1, {1.0, 1.0}}, {4, {2.0, 1.0}}, {3, {2.0, 2.0}}
+        }));
+    }
+
+    SECTION("concave polygon") {
+        osmium::builder::add_way(buffer, _id(1), _nodes({
+            {1, {0.0, 0.0}}, {2, {3.0, 0.0}}, {3, {3.0, 3.0}}, {4, {1.5, 1.0}}, {5, {0.0, 3.0}}, {1, {0.0, 0.0}}
+        }));
+    }
+
+    SECTION("self-intersecting way (bow tie)") {
+        osmium::builder::add_way(buffer, _id(1), _nodes({
+            {1, {0.0, 0.0}}, {2, {1.0, 1.0}}, {3, {1.0, 0.0}}, {4, {0.0, 1.0}}, {1, {0.0, 0.0}}
+        }));
+    }
+
+    SECTION("way with spike") {
+        osmium::builder::add_way(buffer, _id(1), _nodes({
+            {1, {0.0, 0.0}}, {2, {2.0, 0.0}}, {3, {1.0, 0.0}}, {4, {1.0, 1.0}}, {1, {0.0, 0.0}}
+        }));
+    }
+
+    SECTION("way touching itself") {
+        osmium::builder::add_way(buffer, _id(1), _nodes({
+            {1, {0.0, 0.0}}, {2, {2.0, 0.0}}, {3, {1.0, 1.0}}, {4, {2.0, 2.0}}, {5, {0.0, 2.0}}, {6, {1.0, 1.0}}, {1, {0.0, 0.0}}
+        }));
+    }
+
+    check_simple_way(buffer.get<osmium::Way>(0));
+}
+
+TEST_CASE("Re-using an assembler gives same results as new assemblers") {
+    osmium::memory::Buffer buffer{10240};
+
+    osmium::builder::add_way(buffer, _id(1), _nodes({
+        {1, {0.0, 0.0}}, {2, {2.0, 0.0}}, {3, {1.0, 1.0}}, {4, {2.0, 2.0}}, {5, {0.0, 2.0}}, {6, {1.0, 1.0}}, {1, {0.0, 0.0}}
+    }));
+    osmium::builder::add_way(buffer, _id(2), _nodes({
+        {1, {1.0, 1.0}}, {2, {1.0, 2.0}}, {3, {2.0, 2.0}}, {4, {2.0, 1.0}}, {1, {1.0, 1.0}}
+    }));
+    osmium::builder::add_way(buffer, _id(3), _nodes({
+        {1, {0.0, 0.0}}, {2, {1.0, 1.0}}, {3, {1.0, 0.0}}, {4, {0.0, 1.0}}, {1, {0.0, 0.0}}
+    }));
+    osmium::builder::add_way(buffer, _id(4), _nodes({
+        {1, {0.0, 0.0}}, {2, {3.0, 0.0}}, {3, {3.0, 3.0}}, {4, {1.5, 1.5}}, {5, {0.0, 3.0}},
+        {6, {0.5, 2.0}}, {4, {1.5, 1.5}}, {7, {2.5, 2.0}}, {8, {2.5, 0.5}}, {9, {1.0, 0.5}}, {1, {0.0, 0.0}}
+    }));
+
+    NullProblemReporter reporter;
+    osmium::area::AssemblerConfig config;
+    config.problem_reporter = &reporter;
+
+    osmium::area::Assembler reused_assembler{config};
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        osmium::memory::Buffer buffer_reused{1024};
+        const bool okay_reused = reused_assembler(way, buffer_reused);
+
+        osmium::area::Assembler new_assembler{config};
+        osmium::memory::Buffer buffer_new{1024};
+        const bool okay_new = new_assembler(way, buffer_new);
+
+        REQUIRE(okay_reused == okay_new);
+        REQUIRE(buffer_reused.committed() == buffer_new.committed());
+        REQUIRE(std::equal(buffer_reused.data(), buffer_reused.data() + buffer_reused.committed(), buffer_new.data()));
+        REQUIRE(reused_assembler.stats().nodes == new_assembler.stats().nodes);
+        REQUIRE(reused_assembler.stats().outer_rings == new_assembler.stats().outer_rings);
+        REQUIRE(reused_assembler.stats().touching_rings == new_assembler.stats().touching_rings);
+    }
+}
+
+TEST_CASE("Assembler adds bounding box if configured") {
+    osmium::memory::Buffer buffer{10240};
+
+    const auto wpos = osmium::builder::add_way(buffer,
+        _id(1),
+        _nodes({
+            {1, {1.0, 1.0}},
+            {2, {1.0, 2.0}},
+            {3, {2.5, 2.0}},
+            {4, {2.0, 1.0}},
+            {1, {1.0, 1.0}}
+        })
+    );
+    const auto& way = buffer.get<osmium::Way>(wpos);
+
+    osmium::area::AssemblerConfig config_fast;
+    config_fast.add_bounding_box = true;
+    osmium::area::Assembler assembler_fast{config_fast};
+    osmium::memory::Buffer buffer_fast{1024};
+    REQUIRE(assembler_fast(way, buffer_fast));
+
+    NullProblemReporter reporter;
+    osmium::area::AssemblerConfig config_general;
+    config_general.add_bounding_box = true;
+    config_general.problem_reporter = &reporter;
+    osmium::area::Assembler assembler_general{config_general};
+    osmium::memory::Buffer buffer_general{1024};
+    REQUIRE(assembler_general(way, buffer_general));
+
+    REQUIRE(buffer_fast.committed() == buffer_general.committed());
+    REQUIRE(std::equal(buffer_fast.data(), buffer_fast.data() + buffer_fast.committed(), buffer_general.data()));
+
+    const auto& area = buffer_fast.get<osmium::Area>(0);
+    REQUIRE(area.num_rings().first == 1);
+    REQUIRE(area.num_rings().second == 0);
+    REQUIRE(area.bounding_box());
+    REQUIRE(area.bounding_box()->box() == osmium::Box(1.0, 1.0, 2.5, 2.0));
+    REQUIRE(area.envelope() == osmium::Box(1.0, 1.0, 2.5, 2.0));
+
+    const osmium::area::AssemblerConfig config_default;
+    osmium::area::Assembler assembler_default{config_default};
+    osmium::memory::Buffer buffer_default{1024};
+    REQUIRE(assembler_default(way, buffer_default));
+    REQUIRE_FALSE(buffer_default.get<osmium::Area>(0).bounding_box());
+    REQUIRE(buffer_default.get<osmium::Area>(0).envelope() == area.envelope());
+}
+
+namespace {
+
+    osmium::object_id_type add_square(osmium::memory::Buffer& buffer, osmium::object_id_type id, double x, double y, double size) {
+        const osmium::object_id_type node_id = id * 10;
+        osmium::builder::add_way(buffer,
+            _id(id),
+            _nodes({
+                {node_id + 1, {x, y}},
+                {node_id + 2, {x, y + size}},
+                {node_id + 3, {x + size, y + size}},
+                {node_id + 4, {x + size, y}},
+                {node_id + 1, {x, y}}
+            })
+        );
+        return id;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Assemble multipolygon with many inner rings and islands") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+
+    std::vector<member_type> members;
+    osmium::object_id_type id = 1;
+    members.emplace_back(osmium::item_type::way, add_square(buffer, id++, 0.0, 0.0, 80.0), "outer");
+
+    const int grid = 20;
+    int num_islands = 0;
+    for (int i = 0; i < grid; ++i) {
+        for (int j = 0; j < grid; ++j) {
+            members.emplace_back(osmium::item_type::way, add_square(buffer, id++, i * 4 + 1.0, j * 4 + 1.0, 2.0), "inner");
+            if ((i + j) % 7 == 0) {
+                members.emplace_back(osmium::item_type::way, add_square(buffer, id++, i * 4 + 1.5, j * 4 + 1.5, 1.0), "outer");
+                ++num_islands;
+            }
+        }
+    }
+
+    std::vector<const osmium::Way*> ways;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        ways.push_back(&way);
+    }
+
+    osmium::memory::Buffer relation_buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    const auto rpos = osmium::builder::add_relation(relation_buffer,
+        _id(1),
+        _tag("type", "multipolygon"),
+        _members(members)
+    );
+
+    const osmium::area::AssemblerConfig config;
+    osmium::area::Assembler assembler{config};
+
+    osmium::memory::Buffer area_buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE(assembler(relation_buffer.get<osmium::Relation>(rpos), ways, area_buffer));
+
+    const auto& area = area_buffer.get<osmium::Area>(0);
+    REQUIRE(area.num_rings().first == static_cast<std::size_t>(1 + num_islands));
+    REQUIRE(area.num_rings().second == static_cast<std::size_t>(grid * grid));
+
+    std::size_t num_with_inners = 0;
+    for (const auto& outer : area.outer_rings()) {
+        const auto num_inners = std::distance(area.inner_rings(outer).begin(), area.inner_rings(outer).end());
+        if (outer.envelope() == osmium::Box(0.0, 0.0, 80.0, 80.0)) {
+            REQUIRE(num_inners == grid * grid);
+            ++num_with_inners;
+        } else {
+            REQUIRE(num_inners == 0);
+        }
+    }
+    REQUIRE(num_with_inners == 1);
+
+    REQUIRE(assembler.stats().inner_rings == static_cast<uint64_t>(grid * grid));
+    REQUIRE(assembler.stats().outer_rings == static_cast<uint64_t>(1 + num_islands));
+}
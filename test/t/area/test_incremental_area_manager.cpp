@@ -0,0 +1,171 @@
+#include "catch.hpp"
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/incremental_area_manager.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/map/sparse_mem_map.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    using index_type = osmium::index::map::SparseMemMap<osmium::unsigned_object_id_type, osmium::Location>;
+    using manager_type = osmium::area::IncrementalAreaManager<osmium::area::Assembler>;
+
+    void add_square(osmium::memory::Buffer& buffer, osmium::object_id_type first_node_id, double x) {
+        osmium::builder::add_node(buffer, _id(first_node_id),     _location(x,       0.0));
+        osmium::builder::add_node(buffer, _id(first_node_id + 1), _location(x + 1.0, 0.0));
+        osmium::builder::add_node(buffer, _id(first_node_id + 2), _location(x + 1.0, 1.0));
+        osmium::builder::add_node(buffer, _id(first_node_id + 3), _location(x,       1.0));
+    }
+
+    std::vector<osmium::object_id_type> area_ids(const osmium::memory::Buffer& buffer) {
+        std::vector<osmium::object_id_type> ids;
+        for (const auto& area : buffer.select<osmium::Area>()) {
+            ids.push_back(area.id());
+        }
+        return ids;
+    }
+
+    const osmium::Area& first_area(const osmium::memory::Buffer& buffer) {
+        return *buffer.select<osmium::Area>().begin();
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Incremental area manager updates areas from changes") {
+    osmium::memory::Buffer data{1024, osmium::memory::Buffer::auto_grow::yes};
+    add_square(data, 1, 0.0);
+    add_square(data, 11, 2.0);
+    osmium::builder::add_node(data, _id(50), _location(5.0, 0.0));
+    osmium::builder::add_node(data, _id(51), _location(5.0, 1.0));
+    osmium::builder::add_way(data, _id(10), _tag("building", "yes"), _nodes({1, 2, 3, 4, 1}));
+    osmium::builder::add_way(data, _id(20), _nodes({11, 12, 13, 14, 11}));
+    osmium::builder::add_way(data, _id(40), _tag("highway", "path"), _nodes({50, 51}));
+    osmium::builder::add_relation(data, _id(30),
+        _tag("type", "multipolygon"),
+        _tag("landuse", "forest"),
+        _member(osmium::item_type::node, 50, ""),
+        _member(osmium::item_type::way, 20, "outer"));
+    osmium::builder::add_relation(data, _id(31), _tag("type", "route"), _member(osmium::item_type::way, 40, ""));
+
+    index_type index;
+    const osmium::area::Assembler::config_type config;
+    manager_type manager{config, index};
+
+    osmium::apply(data, manager);
+    REQUIRE(manager.num_ways() == 3);
+    REQUIRE(manager.num_relations() == 1);
+    REQUIRE(manager.used_memory() > 0);
+
+    auto changes = manager.assemble_changed();
+    REQUIRE(changes.affected_area_ids == std::vector<osmium::object_id_type>({20, 40, 80, 61}));
+    REQUIRE(area_ids(changes.areas) == std::vector<osmium::object_id_type>({20, 61}));
+    REQUIRE(manager.stats().from_ways == 1);
+    REQUIRE(manager.stats().from_relations == 1);
+
+    SECTION("no changes") {
+        changes = manager.assemble_changed();
+        REQUIRE(changes.affected_area_ids.empty());
+        REQUIRE(changes.areas.committed() == 0);
+    }
+
+    SECTION("moved node of member way") {
+        osmium::memory::Buffer change{1024};
+        osmium::builder::add_node(change, _id(13), _location(4.0, 2.0));
+        osmium::apply(change, manager);
+
+        changes = manager.assemble_changed();
+        REQUIRE(changes.affected_area_ids == std::vector<osmium::object_id_type>({40, 61}));
+        REQUIRE(area_ids(changes.areas) == std::vector<osmium::object_id_type>({61}));
+
+        const auto& area = first_area(changes.areas);
+        const auto& ring = *area.outer_rings().begin();
+        REQUIRE(std::any_of(ring.begin(), ring.end(), [](const osmium::NodeRef& nr) {
+            return nr.location() == osmium::Location{4.0, 2.0};
+        }));
+    }
+
+    SECTION("deleted way") {
+        osmium::memory::Buffer change{1024};
+        osmium::builder::add_way(change, _id(10), _visible(false));
+        osmium::apply(change, manager);
+
+        changes = manager.assemble_changed();
+        REQUIRE(changes.affected_area_ids == std::vector<osmium::object_id_type>({20}));
+        REQUIRE(changes.areas.committed() == 0);
+        REQUIRE(manager.num_ways() == 2);
+
+        // Moving a node of the deleted way doesn't affect anything.
+        osmium::memory::Buffer change2{1024};
+        osmium::builder::add_node(change2, _id(2), _location(1.5, 0.0));
+        osmium::apply(change2, manager);
+        REQUIRE(manager.assemble_changed().affected_area_ids.empty());
+    }
+
+    SECTION("deleted member way") {
+        osmium::memory::Buffer change{1024};
+        osmium::builder::add_way(change, _id(20), _visible(false));
+        osmium::apply(change, manager);
+
+        changes = manager.assemble_changed();
+        REQUIRE(changes.affected_area_ids == std::vector<osmium::object_id_type>({40, 61}));
+        REQUIRE(changes.areas.committed() == 0);
+    }
+
+    SECTION("modified relation") {
+        osmium::memory::Buffer change{1024};
+        osmium::builder::add_relation(change, _id(30),
+            _tag("type", "multipolygon"),
+            _tag("landuse", "meadow"),
+            _member(osmium::item_type::way, 20, "outer"));
+        osmium::apply(change, manager);
+
+        changes = manager.assemble_changed();
+        REQUIRE(changes.affected_area_ids == std::vector<osmium::object_id_type>({61}));
+        REQUIRE(area_ids(changes.areas) == std::vector<osmium::object_id_type>({61}));
+        REQUIRE(std::string{first_area(changes.areas).tags()["landuse"]} == "meadow");
+    }
+
+    SECTION("way becomes member of relation") {
+        osmium::memory::Buffer change{1024};
+        osmium::builder::add_relation(change, _id(32),
+            _tag("type", "multipolygon"),
+            _tag("natural", "water"),
+            _member(osmium::item_type::way, 10, "outer"));
+        osmium::apply(change, manager);
+
+        changes = manager.assemble_changed();
+        REQUIRE(changes.affected_area_ids == std::vector<osmium::object_id_type>({65}));
+        REQUIRE(area_ids(changes.areas) == std::vector<osmium::object_id_type>({65}));
+
+        osmium::memory::Buffer change2{1024};
+        osmium::builder::add_node(change2, _id(3), _location(1.5, 1.5));
+        osmium::apply(change2, manager);
+
+        changes = manager.assemble_changed();
+        REQUIRE(changes.affected_area_ids == std::vector<osmium::object_id_type>({20, 65}));
+        REQUIRE(area_ids(changes.areas) == std::vector<osmium::object_id_type>({20, 65}));
+    }
+
+    SECTION("relation with missing member way") {
+        osmium::memory::Buffer change{1024};
+        osmium::builder::add_relation(change, _id(33),
+            _tag("type", "multipolygon"),
+            _member(osmium::item_type::way, 99, "outer"));
+        osmium::apply(change, manager);
+
+        changes = manager.assemble_changed();
+        REQUIRE(changes.affected_area_ids == std::vector<osmium::object_id_type>({67}));
+        REQUIRE(changes.areas.committed() == 0);
+    }
+}
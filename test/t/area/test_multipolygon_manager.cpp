@@ -0,0 +1,278 @@
+#include "catch.hpp"
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/multipolygon_manager.hpp>
+#include <osmium/area/problem_reporter_stream.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    // Create a buffer with num square multipolygon relations each with one
+    // untagged closed way as outer ring and 20 additional tagged closed ways.
+    osmium::memory::Buffer create_data(int num) {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+        for (int i = 0; i < num + 20; ++i) {
+            const double x = i * 0.01;
+            if (i < num) {
+                osmium::builder::add_way(buffer, _id(i + 1), _nodes({
+                    {1000 + i * 4, {x,         0.0}},
+                    {1001 + i * 4, {x + 0.005, 0.0}},
+                    {1002 + i * 4, {x + 0.005, 0.005}},
+                    {1003 + i * 4, {x,         0.005}},
+                    {1000 + i * 4, {x,         0.0}}
+                }));
+            } else {
+                osmium::builder::add_way(buffer, _id(i + 1), _tag("building", "yes"), _nodes({
+                    {1000 + i * 4, {x,         0.0}},
+                    {1001 + i * 4, {x + 0.005, 0.0}},
+                    {1002 + i * 4, {x + 0.005, 0.005}},
+                    {1000 + i * 4, {x,         0.0}}
+                }));
+            }
+        }
+
+        for (int i = 0; i < num; ++i) {
+            osmium::builder::add_relation(buffer, _id(i + 1),
+                _tag("type", "multipolygon"),
+                _tag("landuse", "forest"),
+                _member(osmium::item_type::way, i + 1, "outer"));
+        }
+
+        return buffer;
+    }
+
+    std::vector<osmium::object_id_type> assemble(const osmium::memory::Buffer& data, osmium::thread::Pool* pool, osmium::area::area_stats& stats) {
+        osmium::area::Assembler::config_type config;
+        config.collect_timings = true;
+        osmium::area::MultipolygonManager<osmium::area::Assembler> manager{config};
+        if (pool) {
+            manager.enable_parallel_assembly(*pool, 7);
+        }
+
+        osmium::apply(data, manager);
+        manager.prepare_for_lookup();
+
+        std::vector<osmium::object_id_type> ids;
+        osmium::apply(data, manager.handler([&ids](osmium::memory::Buffer&& buffer) {
+            for (const auto& area : buffer.select<osmium::Area>()) {
+                ids.push_back(area.id());
+            }
+        }));
+
+        stats = manager.stats();
+
+        uint64_t count = 0;
+        for (std::size_t n = 0; n < osmium::area::area_timing_stats::num_buckets; ++n) {
+            count += manager.timing_stats().count(n);
+        }
+        REQUIRE(count == ids.size());
+        REQUIRE(manager.timing_stats().slowest().size() == 10);
+        REQUIRE(manager.timing_stats().stats().from_relations == stats.from_relations);
+        return ids;
+    }
+
+    // Create a buffer with num multipolygon relations each with a way as
+    // outer ring that is not closed.
+    osmium::memory::Buffer create_broken_data(int num) {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+        for (int i = 0; i < num; ++i) {
+            const double x = i * 0.01;
+            osmium::builder::add_way(buffer, _id(i + 1), _nodes({
+                {1000 + i * 4, {x,         0.0}},
+                {1001 + i * 4, {x + 0.005, 0.0}},
+                {1002 + i * 4, {x + 0.005, 0.005}},
+                {1003 + i * 4, {x,         0.005}}
+            }));
+        }
+
+        for (int i = 0; i < num; ++i) {
+            osmium::builder::add_relation(buffer, _id(i + 1),
+                _tag("type", "multipolygon"),
+                _tag("landuse", "forest"),
+                _member(osmium::item_type::way, i + 1, "outer"));
+        }
+
+        return buffer;
+    }
+
+    std::string report_problems(const osmium::memory::Buffer& data, osmium::thread::Pool* pool) {
+        std::stringstream out;
+        osmium::area::ProblemReporterStream reporter{out};
+
+        osmium::area::Assembler::config_type config;
+        config.problem_reporter = &reporter;
+        osmium::area::MultipolygonManager<osmium::area::Assembler> manager{config};
+        if (pool) {
+            manager.enable_parallel_assembly(*pool, 7);
+        }
+
+        osmium::apply(data, manager);
+        manager.prepare_for_lookup();
+        osmium::apply(data, manager.handler());
+        manager.flush_output();
+
+        return out.str();
+    }
+
+} // anonymous namespace
+
+TEST_CASE("MultipolygonManager with parallel assembly reports same problems") {
+    const auto data = create_broken_data(50);
+
+    const auto serial = report_problems(data, nullptr);
+    REQUIRE_FALSE(serial.empty());
+
+    osmium::thread::Pool pool{3};
+    const auto parallel = report_problems(data, &pool);
+
+    REQUIRE(parallel == serial);
+}
+
+TEST_CASE("MultipolygonManager with parallel assembly creates same areas") {
+    const auto data = create_data(100);
+
+    osmium::area::area_stats serial_stats;
+    const auto serial = assemble(data, nullptr, serial_stats);
+
+    REQUIRE(serial.size() == 120);
+    REQUIRE(serial_stats.from_relations == 100);
+    REQUIRE(serial_stats.from_ways == 20);
+
+    osmium::thread::Pool pool{3};
+    osmium::area::area_stats parallel_stats;
+    const auto parallel = assemble(data, &pool, parallel_stats);
+
+    REQUIRE(parallel_stats.from_relations == serial_stats.from_relations);
+    REQUIRE(parallel_stats.from_ways == serial_stats.from_ways);
+    REQUIRE(parallel_stats.area_simple_case == serial_stats.area_simple_case);
+
+    // Areas from ways and from relations are added in the order the ways
+    // were read and the relations were completed, respectively.
+    std::vector<osmium::object_id_type> serial_ways;
+    std::vector<osmium::object_id_type> serial_relations;
+    for (const auto id : serial) {
+        (id % 2 == 1 ? serial_relations : serial_ways).push_back(id);
+    }
+    std::vector<osmium::object_id_type> parallel_ways;
+    std::vector<osmium::object_id_type> parallel_relations;
+    for (const auto id : parallel) {
+        (id % 2 == 1 ? parallel_relations : parallel_ways).push_back(id);
+    }
+    REQUIRE(parallel.size() == serial.size());
+    REQUIRE(parallel_relations.size() == 100);
+    REQUIRE(parallel_relations == serial_relations);
+    REQUIRE(parallel_ways == serial_ways);
+}
+
+TEST_CASE("MultipolygonManager with single pass over relations-first input") {
+    const auto data = create_data(10);
+
+    // Move relations to the front of the input.
+    osmium::memory::Buffer relations_first{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (const auto& relation : data.select<osmium::Relation>()) {
+        relations_first.add_item(relation);
+        relations_first.commit();
+    }
+    for (const auto& way : data.select<osmium::Way>()) {
+        relations_first.add_item(way);
+        relations_first.commit();
+    }
+
+    osmium::area::area_stats stats;
+    const auto two_pass = assemble(data, nullptr, stats);
+
+    const osmium::area::Assembler::config_type config;
+    osmium::area::MultipolygonManager<osmium::area::Assembler> manager{config};
+
+    std::vector<osmium::object_id_type> ids;
+    osmium::apply(relations_first, manager.single_pass_handler([&ids](osmium::memory::Buffer&& buffer) {
+        for (const auto& area : buffer.select<osmium::Area>()) {
+            ids.push_back(area.id());
+        }
+    }));
+
+    REQUIRE(ids == two_pass);
+    REQUIRE(manager.stats().from_relations == 10);
+
+    // All member ways were removed after their relations were complete.
+    REQUIRE(manager.stash().size() == 0);
+}
+
+TEST_CASE("MultipolygonManager single pass fails on relation after way") {
+    const auto data = create_data(2);
+
+    const osmium::area::Assembler::config_type config;
+    osmium::area::MultipolygonManager<osmium::area::Assembler> manager{config};
+
+    REQUIRE_THROWS_AS(osmium::apply(data, manager.single_pass_handler()), osmium::out_of_order_error);
+}
+
+TEST_CASE("MultipolygonManager stores member ways without tags if old-style polygons are disabled") {
+    const auto data = create_data(10);
+
+    osmium::area::area_stats stats;
+    const auto expected = assemble(data, nullptr, stats);
+
+    osmium::area::Assembler::config_type config;
+    config.create_old_style_polygons = false;
+    osmium::area::MultipolygonManager<osmium::area::Assembler> manager{config};
+    REQUIRE(manager.member_ways_database().uses_lean_storage());
+
+    osmium::apply(data, manager);
+    manager.prepare_for_lookup();
+
+    std::vector<osmium::object_id_type> ids;
+    osmium::apply(data, manager.handler([&ids](osmium::memory::Buffer&& buffer) {
+        for (const auto& area : buffer.select<osmium::Area>()) {
+            ids.push_back(area.id());
+        }
+    }));
+
+    REQUIRE(ids == expected);
+}
+
+TEST_CASE("MultipolygonManager with compressed member ways creates same areas") {
+    const auto data = create_data(10);
+
+    const auto run = [&data](bool compress) {
+        osmium::area::Assembler::config_type config;
+        config.compress_member_ways = compress;
+        osmium::area::MultipolygonManager<osmium::area::Assembler> manager{config};
+
+        osmium::apply(data, manager);
+        manager.prepare_for_lookup();
+
+        std::vector<std::string> areas;
+        osmium::apply(data, manager.handler([&areas](osmium::memory::Buffer&& buffer) {
+            for (const auto& area : buffer.select<osmium::Area>()) {
+                std::stringstream out;
+                out << area.id();
+                for (const auto& ring : area.outer_rings()) {
+                    for (const auto& node_ref : ring) {
+                        out << ' ' << node_ref.ref() << node_ref.location();
+                    }
+                }
+                areas.push_back(out.str());
+            }
+        }));
+        return areas;
+    };
+
+    const auto expected = run(false);
+    REQUIRE(expected.size() == 30);
+    REQUIRE(run(true) == expected);
+}
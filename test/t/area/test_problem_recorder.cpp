@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#include <osmium/area/problem_recorder.hpp>
+#include <osmium/area/problem_reporter_stream.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <sstream>
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    // Report one problem of each type on the reporter.
+    void report_problems(osmium::area::ProblemReporter& reporter, const osmium::Way& way, osmium::object_id_type id) {
+        const osmium::Location l1{1.0, 2.0};
+        const osmium::Location l2{1.5, 2.5};
+        const osmium::Location l3{3.0, 4.0};
+
+        reporter.set_object(osmium::item_type::relation, id);
+        reporter.set_nodes(17);
+        reporter.report_duplicate_node(1, 2, l1);
+        reporter.report_touching_ring(3, l2);
+        reporter.report_intersection(10, l1, l2, 11, l2, l3, l3);
+        reporter.report_duplicate_segment(osmium::NodeRef{4, l1}, osmium::NodeRef{5, l2});
+        reporter.report_overlapping_segment(osmium::NodeRef{6, l2}, osmium::NodeRef{7, l3});
+        reporter.report_ring_not_closed(osmium::NodeRef{8, l3}, &way);
+        reporter.report_ring_not_closed(osmium::NodeRef{9, l1}, nullptr);
+
+        reporter.set_object(osmium::item_type::way, way.id());
+        reporter.set_nodes(way.nodes().size());
+        reporter.report_role_should_be_outer(12, l1, l3);
+        reporter.report_role_should_be_inner(13, l3, l1);
+        reporter.report_way_in_multiple_rings(way);
+        reporter.report_inner_with_same_tags(way);
+        reporter.report_invalid_location(14, 15);
+        reporter.report_duplicate_way(way);
+        reporter.report_way(way);
+    }
+
+    const osmium::Way& create_way(osmium::memory::Buffer& buffer) {
+        const auto pos = osmium::builder::add_way(buffer, _id(20), _nodes({
+            {1, {1.0, 2.0}},
+            {2, {1.5, 2.5}},
+            {3, {3.0, 4.0}}
+        }));
+        return buffer.get<osmium::Way>(pos);
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Replaying recorded problems gives same reports as reporting directly") {
+    osmium::memory::Buffer buffer{1024};
+    const auto& way = create_way(buffer);
+
+    std::stringstream direct_out;
+    osmium::area::ProblemReporterStream direct{direct_out};
+    report_problems(direct, way, 1);
+
+    osmium::area::ProblemRecorder recorder;
+    REQUIRE(recorder.empty());
+    report_problems(recorder, way, 1);
+    REQUIRE(recorder.size() == 14);
+
+    std::stringstream replay_out;
+    osmium::area::ProblemReporterStream replay{replay_out};
+    recorder.replay(replay);
+
+    REQUIRE_FALSE(direct_out.str().empty());
+    REQUIRE(replay_out.str() == direct_out.str());
+
+    recorder.clear();
+    REQUIRE(recorder.empty());
+}
+
+TEST_CASE("Appending recorded problems") {
+    osmium::memory::Buffer buffer{1024};
+    const auto& way = create_way(buffer);
+
+    std::stringstream direct_out;
+    osmium::area::ProblemReporterStream direct{direct_out};
+    report_problems(direct, way, 1);
+    report_problems(direct, way, 2);
+    report_problems(direct, way, 3);
+
+    osmium::area::ProblemRecorder recorder1;
+    report_problems(recorder1, way, 1);
+
+    osmium::area::ProblemRecorder recorder2;
+    report_problems(recorder2, way, 2);
+
+    osmium::area::ProblemRecorder recorder3;
+    report_problems(recorder3, way, 3);
+
+    osmium::area::ProblemRecorder merged;
+    merged.append(recorder1);
+    merged.append(recorder2);
+    merged.append(recorder3);
+    REQUIRE(merged.size() == 42);
+
+    std::stringstream replay_out;
+    osmium::area::ProblemReporterStream replay{replay_out};
+    merged.replay(replay);
+
+    REQUIRE(replay_out.str() == direct_out.str());
+}
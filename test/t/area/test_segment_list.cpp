@@ -0,0 +1,150 @@
+#include "catch.hpp"
+
+#include <osmium/area/detail/segment_list.hpp>
+#include <osmium/area/problem_reporter.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    class IntersectionRecorder : public osmium::area::ProblemReporter {
+
+    public:
+
+        std::vector<osmium::Location> intersections;
+
+        void report_intersection(osmium::object_id_type /*way1_id*/, osmium::Location /*way1_seg_start*/, osmium::Location /*way1_seg_end*/,
+                                 osmium::object_id_type /*way2_id*/, osmium::Location /*way2_seg_start*/, osmium::Location /*way2_seg_end*/, osmium::Location intersection) override {
+            intersections.push_back(intersection);
+        }
+
+    }; // class IntersectionRecorder
+
+    // Build a closed way running mostly north-south (so that most segments
+    // overlap in the x range) with some random wiggles that lead to
+    // intersections.
+    const osmium::Way& make_way(osmium::memory::Buffer& buffer, int num_nodes, unsigned int seed) {
+        std::mt19937 gen{seed};
+        std::uniform_int_distribution<int> dist{0, 1000};
+        std::uniform_int_distribution<int> wiggle{0, 300};
+
+        std::vector<osmium::NodeRef> nodes;
+        for (int n = 0; n < num_nodes; ++n) {
+            nodes.emplace_back(n + 1, osmium::Location{static_cast<int32_t>(dist(gen)), static_cast<int32_t>(n * 100 + wiggle(gen))});
+        }
+        for (int n = 0; n < num_nodes; ++n) {
+            nodes.emplace_back(num_nodes + n + 1, osmium::Location{static_cast<int32_t>(2000 + dist(gen)), static_cast<int32_t>((num_nodes - n - 1) * 100 + wiggle(gen))});
+        }
+        nodes.push_back(nodes.front());
+
+        const auto pos = osmium::builder::add_way(buffer, _id(1), _nodes(nodes));
+        return buffer.get<osmium::Way>(pos);
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Sweep line finds the same intersections as the simple algorithm") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    unsigned int seed = 0;
+    int num_nodes = 0;
+
+    SECTION("small way") {
+        seed = 1;
+        num_nodes = 3;
+    }
+    SECTION("large way") {
+        seed = 2;
+        num_nodes = 2000;
+    }
+    SECTION("other large way") {
+        seed = 3;
+        num_nodes = 3000;
+    }
+
+    const auto& way = make_way(buffer, num_nodes, seed);
+
+    osmium::area::detail::SegmentList segment_list{false};
+    uint64_t duplicate_nodes = 0;
+    segment_list.extract_segments_from_way(nullptr, duplicate_nodes, way);
+    segment_list.sort();
+
+    IntersectionRecorder simple;
+    IntersectionRecorder sweep_line;
+
+    const auto count_simple = segment_list.find_intersections(&simple);
+    const auto count_sweep_line = segment_list.find_intersections(&sweep_line, 0);
+
+    if (num_nodes > 100) {
+        REQUIRE(count_simple > 0);
+    }
+    REQUIRE(count_simple == count_sweep_line);
+    REQUIRE(simple.intersections == sweep_line.intersections);
+}
+
+TEST_CASE("Sweep line with segments that only touch the sweep line") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    // A cross made of two ways where one of the segments ends exactly at
+    // the x coordinate where the next segment starts.
+    osmium::builder::add_way(buffer, _id(1), _nodes({{1, {0.0, 0.0}}, {2, {1.0, 1.0}}, {3, {2.0, 0.0}}}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({{4, {0.5, 1.0}}, {5, {1.5, 0.0}}}));
+
+    osmium::area::detail::SegmentList segment_list{false};
+    uint64_t duplicate_nodes = 0;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        segment_list.extract_segments_from_way(nullptr, duplicate_nodes, way);
+    }
+    segment_list.sort();
+
+    REQUIRE(segment_list.find_intersections(nullptr) == 1);
+    REQUIRE(segment_list.find_intersections(nullptr, 0) == 1);
+    REQUIRE(segment_list.find_intersections(nullptr, std::numeric_limits<std::size_t>::max()) == 1);
+}
+
+TEST_CASE("Segment x index finds all segments reaching a vertical line") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto& way = make_way(buffer, 500, 4);
+
+    osmium::area::detail::SegmentList segment_list{false};
+    uint64_t duplicate_nodes = 0;
+    segment_list.extract_segments_from_way(nullptr, duplicate_nodes, way);
+    segment_list.sort();
+
+    osmium::area::detail::SegmentXIndex index;
+    index.for_each_reaching(0, 0, [](std::size_t /*n*/) {
+        REQUIRE(false);
+    });
+
+    index.build(segment_list);
+    REQUIRE(index.size() == segment_list.size());
+
+    for (std::size_t last = 0; last < segment_list.size(); last += 37) {
+        for (const int32_t x : {-1, 0, 500, 1000, 1999, 2000, 2500, 3000, 3001}) {
+            std::vector<std::size_t> expected;
+            for (std::size_t n = last + 1; n > 0; --n) {
+                if (segment_list[n - 1].second().location().x() >= x) {
+                    expected.push_back(n - 1);
+                }
+            }
+
+            std::vector<std::size_t> result;
+            index.for_each_reaching(last, x, [&result](std::size_t n) {
+                result.push_back(n);
+            });
+            REQUIRE(result == expected);
+        }
+    }
+
+    index.clear();
+    REQUIRE(index.size() == 0);
+}
@@ -0,0 +1,112 @@
+#include "catch.hpp"
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/timing_stats.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <sstream>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    osmium::area::area_stats make_stats(uint64_t nodes, uint64_t nanoseconds) {
+        osmium::area::area_stats stats;
+        stats.nodes = nodes;
+        stats.total_nanoseconds = nanoseconds;
+        return stats;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Histogram buckets of timing stats") {
+    REQUIRE(osmium::area::area_timing_stats::bucket(0) == 0);
+    REQUIRE(osmium::area::area_timing_stats::bucket(1) == 0);
+    REQUIRE(osmium::area::area_timing_stats::bucket(2) == 1);
+    REQUIRE(osmium::area::area_timing_stats::bucket(3) == 1);
+    REQUIRE(osmium::area::area_timing_stats::bucket(4) == 2);
+    REQUIRE(osmium::area::area_timing_stats::bucket(1000) == 9);
+    REQUIRE(osmium::area::area_timing_stats::bucket(static_cast<uint64_t>(-1)) == osmium::area::area_timing_stats::num_buckets - 1);
+}
+
+TEST_CASE("Timing stats collect histogram and slowest areas") {
+    osmium::area::area_timing_stats timings{2};
+
+    timings.add(osmium::item_type::way, 1, make_stats(4, 100));
+    timings.add(osmium::item_type::way, 2, make_stats(5, 300));
+    timings.add(osmium::item_type::relation, 3, make_stats(1000, 200));
+    timings.add(osmium::item_type::relation, 4, make_stats(6, 50));
+
+    REQUIRE(timings.stats().nodes == 1015);
+    REQUIRE(timings.stats().total_nanoseconds == 650);
+    REQUIRE(timings.count(2) == 3);
+    REQUIRE(timings.nanoseconds(2) == 450);
+    REQUIRE(timings.count(9) == 1);
+    REQUIRE(timings.nanoseconds(9) == 200);
+
+    const auto slowest = timings.slowest();
+    REQUIRE(slowest.size() == 2);
+    REQUIRE(slowest[0].type == osmium::item_type::way);
+    REQUIRE(slowest[0].id == 2);
+    REQUIRE(slowest[1].type == osmium::item_type::relation);
+    REQUIRE(slowest[1].id == 3);
+    REQUIRE(slowest[1].segments == 1000);
+
+    SECTION("merge") {
+        osmium::area::area_timing_stats other;
+        other.add(osmium::item_type::relation, 5, make_stats(8, 1000));
+        timings += other;
+
+        REQUIRE(timings.count(3) == 1);
+        const auto merged = timings.slowest();
+        REQUIRE(merged.size() == 2);
+        REQUIRE(merged[0].id == 5);
+        REQUIRE(merged[1].id == 2);
+    }
+
+    SECTION("output") {
+        std::ostringstream out;
+        out << timings;
+        REQUIRE(out.str() == "segments areas nanoseconds\n4 3 450\n512 1 200\nslowest:\nw2 5 300\nr3 1000 200\n");
+    }
+}
+
+TEST_CASE("Adding area stats sums all counters") {
+    osmium::area::area_stats stats;
+    osmium::area::area_stats other;
+    other.invalid_locations = 2;
+    other.overlapping_segments = 3;
+
+    stats += other;
+    stats += other;
+    REQUIRE(stats.invalid_locations == 4);
+    REQUIRE(stats.overlapping_segments == 6);
+}
+
+TEST_CASE("Assembler collects timings only if configured") {
+    osmium::memory::Buffer buffer{1024};
+    osmium::builder::add_way(buffer, _id(1), _nodes({
+        {1, {0.0, 0.0}}, {2, {1.0, 0.0}}, {3, {1.0, 1.0}}, {4, {0.0, 1.0}}, {1, {0.0, 0.0}}
+    }));
+    const auto& way = buffer.get<osmium::Way>(0);
+
+    osmium::area::AssemblerConfig config;
+
+    SECTION("disabled") {
+        osmium::area::Assembler assembler{config};
+        osmium::memory::Buffer out{1024};
+        REQUIRE(assembler(way, out));
+        REQUIRE(assembler.stats().total_nanoseconds == 0);
+    }
+
+    SECTION("enabled") {
+        config.collect_timings = true;
+        osmium::area::Assembler assembler{config};
+        osmium::memory::Buffer out{1024};
+        REQUIRE(assembler(way, out));
+        REQUIRE(assembler.stats().total_nanoseconds > 0);
+        REQUIRE(assembler.stats().nodes == 4);
+    }
+}
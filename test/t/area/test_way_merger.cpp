@@ -0,0 +1,165 @@
+#include "catch.hpp"
+
+#include <osmium/area/way_merger.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    // Node n is at location (n, n % 7).
+    osmium::NodeRef node(osmium::object_id_type id) {
+        return osmium::NodeRef{id, osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(id % 7)}};
+    }
+
+    const osmium::Way& add_way(osmium::memory::Buffer& buffer, osmium::object_id_type id, const std::vector<osmium::object_id_type>& ids) {
+        std::vector<osmium::NodeRef> nodes;
+        for (const auto n : ids) {
+            nodes.push_back(node(n));
+        }
+        return buffer.get<osmium::Way>(osmium::builder::add_way(buffer, _id(id), _nodes(nodes)));
+    }
+
+    std::vector<osmium::object_id_type> node_ids(const osmium::area::MergedWay& line) {
+        std::vector<osmium::object_id_type> ids;
+        for (const auto& node_ref : line.nodes()) {
+            ids.push_back(node_ref.ref());
+        }
+        return ids;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Merge ways into a line") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    osmium::area::WayMerger merger;
+
+    REQUIRE(merger.add(add_way(buffer, 2, {3, 4, 5})));
+    REQUIRE(merger.add(add_way(buffer, 1, {1, 2, 3})));
+    REQUIRE(merger.add(add_way(buffer, 3, {7, 6, 5})));
+    REQUIRE(merger.num_lines() == 1);
+    REQUIRE(merger.num_rings() == 0);
+
+    int count = 0;
+    merger.for_each_line([&](const osmium::area::MergedWay& line) {
+        ++count;
+        REQUIRE_FALSE(line.closed());
+        auto ids = node_ids(line);
+        if (ids.front() != 1) {
+            std::reverse(ids.begin(), ids.end());
+        }
+        REQUIRE(ids == (std::vector<osmium::object_id_type>{1, 2, 3, 4, 5, 6, 7}));
+        REQUIRE(line.way_ids().size() == 3);
+    });
+    REQUIRE(count == 1);
+}
+
+TEST_CASE("Merge ways into a ring") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    osmium::area::WayMerger merger;
+
+    REQUIRE(merger.add(add_way(buffer, 1, {1, 2, 3})));
+    REQUIRE(merger.add(add_way(buffer, 2, {1, 5, 4})));
+    REQUIRE(merger.add(add_way(buffer, 3, {3, 4})));
+    REQUIRE(merger.num_lines() == 0);
+    REQUIRE(merger.num_rings() == 1);
+
+    const auto& ring = merger.rings().front();
+    REQUIRE(ring.closed());
+    REQUIRE(ring.nodes().size() == 6);
+    REQUIRE(ring.way_ids().size() == 3);
+}
+
+TEST_CASE("Closed way is a ring on its own") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    osmium::area::WayMerger merger;
+
+    REQUIRE(merger.add(add_way(buffer, 1, {1, 2, 3, 1})));
+    REQUIRE(merger.num_rings() == 1);
+    REQUIRE(merger.rings().front().way_ids() == std::deque<osmium::object_id_type>{1});
+}
+
+TEST_CASE("Ways without locations or with less than two nodes are ignored") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    osmium::area::WayMerger merger;
+
+    REQUIRE_FALSE(merger.add(add_way(buffer, 1, {1})));
+    const auto& way = buffer.get<osmium::Way>(osmium::builder::add_way(buffer, _id(2), _nodes({1, 2})));
+    REQUIRE_FALSE(merger.add(way));
+    REQUIRE(merger.num_lines() == 0);
+    REQUIRE(merger.num_rings() == 0);
+}
+
+TEST_CASE("Merge ways without reversing") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    osmium::area::WayMerger merger{false};
+
+    REQUIRE(merger.add(add_way(buffer, 1, {1, 2, 3})));
+    REQUIRE(merger.add(add_way(buffer, 2, {5, 4, 3})));
+    REQUIRE(merger.num_lines() == 2);
+
+    REQUIRE(merger.add(add_way(buffer, 3, {3, 6, 1})));
+    REQUIRE(merger.num_lines() == 1);
+    REQUIRE(merger.num_rings() == 1);
+    REQUIRE(node_ids(merger.rings().front()) == (std::vector<osmium::object_id_type>{1, 2, 3, 6, 1}));
+    REQUIRE(merger.rings().front().way_ids() == (std::deque<osmium::object_id_type>{1, 3}));
+}
+
+TEST_CASE("Merge many ways in random order in several mergers") {
+    std::mt19937 gen{23}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+
+    // Two rings (nodes 1..300 and 1001..1100) cut into short pieces,
+    // and a line (nodes 2001..2050).
+    std::vector<std::vector<osmium::object_id_type>> pieces;
+    const auto cut = [&](osmium::object_id_type first, osmium::object_id_type last, bool ring) {
+        for (auto n = first; n < last; n += 3) {
+            std::vector<osmium::object_id_type> piece;
+            for (auto m = n; m <= std::min(n + 3, last); ++m) {
+                piece.push_back(m);
+            }
+            if (ring && n + 3 >= last) {
+                piece.push_back(first);
+            }
+            pieces.push_back(piece);
+        }
+    };
+    cut(1, 300, true);
+    cut(1001, 1100, true);
+    cut(2001, 2050, false);
+    std::shuffle(pieces.begin(), pieces.end(), gen);
+
+    for (const bool allow_reverse : {true, false}) {
+        std::vector<osmium::area::WayMerger> mergers(3, osmium::area::WayMerger{allow_reverse});
+        osmium::object_id_type id = 0;
+        for (auto piece : pieces) {
+            if (allow_reverse && id % 2 == 0) {
+                std::reverse(piece.begin(), piece.end());
+            }
+            REQUIRE(mergers[static_cast<std::size_t>(id % 3)].add(add_way(buffer, id + 1, piece)));
+            ++id;
+        }
+        mergers[0].add(std::move(mergers[1]));
+        mergers[0].add(std::move(mergers[2]));
+        REQUIRE(mergers[1].num_lines() == 0);
+
+        REQUIRE(mergers[0].num_rings() == 2);
+        REQUIRE(mergers[0].num_lines() == 1);
+        std::size_t num_ways = 0;
+        mergers[0].for_each_ring([&](const osmium::area::MergedWay& ring) {
+            REQUIRE(ring.closed());
+            num_ways += ring.way_ids().size();
+        });
+        mergers[0].for_each_line([&](const osmium::area::MergedWay& line) {
+            REQUIRE(line.nodes().size() == 50);
+            num_ways += line.way_ids().size();
+        });
+        REQUIRE(num_ways == pieces.size());
+    }
+}
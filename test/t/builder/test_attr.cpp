@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <initializer_list>
 #include <iterator>
+#include <sstream>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -446,6 +447,48 @@ TEST_CASE("create way with nodes") {
     REQUIRE(it == way.nodes().cend());
 }
 
+TEST_CASE("create way with nodes from input iterator") {
+    std::istringstream in{"3 5 7"};
+
+    osmium::memory::Buffer buffer{test_buffer_size};
+    osmium::builder::add_way(buffer,
+        _id(1),
+        _nodes(std::istream_iterator<osmium::object_id_type>{in}, std::istream_iterator<osmium::object_id_type>{})
+    );
+
+    const auto& way = buffer.get<osmium::Way>(0);
+    REQUIRE(way.nodes().size() == 3);
+    REQUIRE(way.nodes()[0].ref() == 3);
+    REQUIRE(way.nodes()[2].ref() == 7);
+}
+
+TEST_CASE("create large objects in small auto-growing buffer") {
+    std::vector<osmium::object_id_type> ids;
+    for (osmium::object_id_type id = 1; id <= 2000; ++id) {
+        ids.push_back(id);
+    }
+
+    osmium::memory::Buffer buffer{64, osmium::memory::Buffer::auto_grow::yes};
+    const auto pos = osmium::builder::add_way(buffer,
+        _id(1),
+        _user("some user"),
+        _nodes(ids),
+        _tag("highway", "primary"),
+        _tag("name=Main Street")
+    );
+    REQUIRE(buffer.capacity() >= buffer.committed());
+
+    const auto& way = buffer.get<osmium::Way>(pos);
+    REQUIRE(way.nodes().size() == 2000);
+    REQUIRE(way.nodes()[1999].ref() == 2000);
+    REQUIRE(std::string{way.user()} == "some user");
+    REQUIRE(std::string{way.tags()["name"]} == "Main Street");
+
+    const auto node_pos = osmium::builder::add_node(buffer, _id(2), _tag("amenity", "bench"));
+    REQUIRE(node_pos == pos + buffer.get<osmium::Way>(pos).padded_size());
+    REQUIRE(buffer.get<osmium::Node>(node_pos).id() == 2);
+}
+
 TEST_CASE("create relation using builders: create relation") {
     osmium::memory::Buffer buffer{test_buffer_size};
 
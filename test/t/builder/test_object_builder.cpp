@@ -5,6 +5,8 @@
 #include <osmium/osm.hpp>
 
 #include <string>
+#include <utility>
+#include <vector>
 
 constexpr const std::size_t test_buffer_size = 1024UL * 10UL;
 
@@ -482,3 +484,55 @@ TEST_CASE("clear_user should clear the user field but nothing else") {
     REQUIRE(it == node.tags().end());
 }
 
+
+TEST_CASE("add tags and node refs in bulk") {
+    osmium::memory::Buffer buffer{test_buffer_size};
+
+    const std::vector<std::pair<const char*, std::size_t>> tag_strings = {
+        {"highway", 7}, {"primary", 7}, {"name", 4}, {"Main Street and more", 11}
+    };
+    const std::vector<osmium::object_id_type> ids = {10, 11, 12};
+
+    {
+        osmium::builder::WayBuilder builder{buffer};
+        builder.set_id(17).set_user("foo");
+        {
+            osmium::builder::WayNodeListBuilder wnl_builder{builder};
+            wnl_builder.add_node_refs(ids.begin(), ids.end());
+            auto* node_refs = wnl_builder.add_empty_node_refs(2);
+            node_refs[0] = osmium::NodeRef{13, osmium::Location{1, 2}};
+            node_refs[1] = osmium::NodeRef{14};
+        }
+        {
+            osmium::builder::TagListBuilder tl_builder{builder};
+            tl_builder.add_tags(tag_strings.begin(), tag_strings.end());
+        }
+    }
+
+    const auto& way = buffer.get<osmium::Way>(buffer.commit());
+    REQUIRE(way.id() == 17);
+    REQUIRE(std::string{way.user()} == "foo");
+
+    REQUIRE(way.nodes().size() == 5);
+    REQUIRE(way.nodes()[0].ref() == 10);
+    REQUIRE(way.nodes()[2].ref() == 12);
+    REQUIRE(way.nodes()[3].ref() == 13);
+    REQUIRE(way.nodes()[3].location() == osmium::Location(1, 2));
+    REQUIRE(way.nodes()[4].ref() == 14);
+    REQUIRE_FALSE(way.nodes()[4].location());
+
+    REQUIRE(way.tags().size() == 2);
+    REQUIRE(std::string{way.tags().get_value_by_key("highway")} == "primary");
+    REQUIRE(std::string{way.tags().get_value_by_key("name")} == "Main Street");
+}
+
+TEST_CASE("add tags in bulk with too long value") {
+    osmium::memory::Buffer buffer{test_buffer_size};
+    const std::string value(osmium::max_osm_string_length + 1, 'x');
+    const std::vector<std::pair<const char*, std::size_t>> tag_strings = {
+        {"key", 3}, {value.data(), value.size()}
+    };
+
+    osmium::builder::TagListBuilder tl_builder{buffer};
+    REQUIRE_THROWS_AS(tl_builder.add_tags(tag_strings.begin(), tag_strings.end()), std::length_error);
+}
@@ -0,0 +1,161 @@
+#include "catch.hpp"
+
+#include <osmium/builder/synthetic_data.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+static osmium::builder::SyntheticDataConfig small_config() {
+    osmium::builder::SyntheticDataConfig config;
+    config.nodes = 2500;
+    config.ways = 700;
+    config.relations = 150;
+    config.chunk_size = 200;
+    return config;
+}
+
+static std::vector<std::string> describe(const osmium::memory::Buffer& buffer) {
+    std::vector<std::string> result;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        std::string s = osmium::item_type_to_name(object.type());
+        s += std::to_string(object.id()) + ' ' + std::to_string(object.version()) + ' ' + object.user();
+        for (const auto& tag : object.tags()) {
+            s += ' ';
+            s += tag.key();
+            s += '=';
+            s += tag.value();
+        }
+        result.push_back(s);
+    }
+    return result;
+}
+
+TEST_CASE("Synthetic data has the configured number of objects in order") {
+    osmium::builder::SyntheticDataGenerator generator{small_config()};
+    REQUIRE(generator.num_chunks() == 13 + 4 + 1);
+
+    uint64_t nodes = 0;
+    uint64_t ways = 0;
+    uint64_t relations = 0;
+    uint64_t closed_ways = 0;
+    uint64_t nested_relations = 0;
+    osmium::item_type last_type = osmium::item_type::node;
+    osmium::object_id_type last_id = 0;
+
+    while (const osmium::memory::Buffer buffer = generator.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            if (object.type() != last_type) {
+                REQUIRE(object.type() > last_type);
+                last_type = object.type();
+                last_id = 0;
+            }
+            REQUIRE(object.id() > last_id);
+            last_id = object.id();
+            REQUIRE(object.version() > 0);
+            REQUIRE(object.timestamp().valid());
+
+            switch (object.type()) {
+                case osmium::item_type::node:
+                    REQUIRE(static_cast<const osmium::Node&>(object).location().valid());
+                    REQUIRE(generator.config().bounding_box.contains(static_cast<const osmium::Node&>(object).location()));
+                    ++nodes;
+                    break;
+                case osmium::item_type::way: {
+                    const auto& way = static_cast<const osmium::Way&>(object);
+                    REQUIRE(way.nodes().size() >= 2);
+                    REQUIRE(way.nodes().size() <= generator.config().way_nodes_max);
+                    for (const auto& nr : way.nodes()) {
+                        REQUIRE(nr.ref() >= generator.node_id(0));
+                        REQUIRE(nr.ref() <= generator.node_id(generator.config().nodes - 1));
+                    }
+                    if (way.is_closed()) {
+                        ++closed_ways;
+                    }
+                    ++ways;
+                    break;
+                }
+                case osmium::item_type::relation:
+                    for (const auto& member : static_cast<const osmium::Relation&>(object).members()) {
+                        if (member.type() == osmium::item_type::relation) {
+                            REQUIRE(member.ref() < object.id());
+                            ++nested_relations;
+                        }
+                    }
+                    ++relations;
+                    break;
+                default:
+                    REQUIRE(false);
+            }
+        }
+    }
+
+    REQUIRE(nodes == 2500);
+    REQUIRE(ways == 700);
+    REQUIRE(relations == 150);
+    REQUIRE(closed_ways > 0);
+    REQUIRE(nested_relations > 0);
+    REQUIRE_FALSE(generator.read());
+}
+
+TEST_CASE("Synthetic data is deterministic") {
+    const auto config = small_config();
+    const osmium::builder::SyntheticDataGenerator generator1{config};
+    const osmium::builder::SyntheticDataGenerator generator2{config};
+
+    for (std::size_t n = 0; n < generator1.num_chunks(); ++n) {
+        REQUIRE(describe(generator1.chunk(n)) == describe(generator2.chunk(n)));
+    }
+
+    auto other_config = config;
+    other_config.seed = 2;
+    const osmium::builder::SyntheticDataGenerator generator3{other_config};
+    REQUIRE(describe(generator1.chunk(0)) != describe(generator3.chunk(0)));
+}
+
+TEST_CASE("Synthetic data generated in pool is the same as generated serially") {
+    const auto config = small_config();
+    osmium::builder::SyntheticDataGenerator serial{config};
+    const osmium::builder::SyntheticDataGenerator parallel{config};
+
+    osmium::thread::Pool pool{2};
+    std::size_t chunks = 0;
+    parallel.generate([&](osmium::memory::Buffer&& buffer) {
+        REQUIRE(describe(buffer) == describe(serial.read()));
+        ++chunks;
+    }, pool);
+    REQUIRE(chunks == parallel.num_chunks());
+}
+
+TEST_CASE("Synthetic data with id gaps") {
+    auto config = small_config();
+    config.id_gap = 10;
+    const osmium::builder::SyntheticDataGenerator generator{config};
+
+    REQUIRE(generator.node_id(0) >= 1);
+    REQUIRE(generator.node_id(0) <= 10);
+    REQUIRE(generator.node_id(2499) > 24990);
+    REQUIRE(generator.node_id(2499) <= 25000);
+    for (uint64_t n = 1; n < config.nodes; ++n) {
+        REQUIRE(generator.node_id(n) > generator.node_id(n - 1));
+    }
+
+    const auto buffer = generator.chunk(0);
+    REQUIRE(buffer.get<osmium::Node>(0).id() == generator.node_id(0));
+}
+
+TEST_CASE("Synthetic data without metadata") {
+    auto config = small_config();
+    config.with_metadata = false;
+    config.relations = 0;
+    const osmium::builder::SyntheticDataGenerator generator{config};
+    REQUIRE(generator.num_chunks() == 17);
+
+    const auto buffer = generator.chunk(0);
+    const auto& node = buffer.get<osmium::Node>(0);
+    REQUIRE(node.version() == 0);
+    REQUIRE(std::string{node.user()}.empty());
+}
@@ -0,0 +1,149 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/experimental/flex_reader.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using dense_index_type = osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+using sparse_index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+namespace {
+
+    const int num_ways = 6000;
+
+    // Write a file with num_ways closed ways, each with its own four
+    // nodes. Every tenth way is the untagged outer ring of a multipolygon
+    // relation, all others are tagged as buildings.
+    std::string write_test_file() {
+        const std::string filename{"test-flex-reader.osm.pbf"};
+
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        for (int i = 0; i < num_ways; ++i) {
+            const double x = (i % 100) * 0.01;
+            const double y = (i / 100) * 0.01;
+            osmium::builder::add_node(buffer, _id(i * 4 + 1), _location(x, y));
+            osmium::builder::add_node(buffer, _id(i * 4 + 2), _location(x + 0.005, y));
+            osmium::builder::add_node(buffer, _id(i * 4 + 3), _location(x + 0.005, y + 0.005));
+            osmium::builder::add_node(buffer, _id(i * 4 + 4), _location(x, y + 0.005));
+        }
+        for (int i = 0; i < num_ways; ++i) {
+            const std::vector<osmium::object_id_type> nodes{i * 4 + 1, i * 4 + 2, i * 4 + 3, i * 4 + 4, i * 4 + 1};
+            if (i % 10 == 0) {
+                osmium::builder::add_way(buffer, _id(i + 1), _nodes(nodes));
+            } else {
+                osmium::builder::add_way(buffer, _id(i + 1), _tag("building", "yes"), _nodes(nodes));
+            }
+        }
+        for (int i = 0; i < num_ways; i += 10) {
+            osmium::builder::add_relation(buffer, _id(i + 1),
+                _tag("type", "multipolygon"),
+                _tag("landuse", "forest"),
+                _member(osmium::item_type::way, i + 1, "outer"));
+        }
+
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+
+        return filename;
+    }
+
+    struct result {
+        std::size_t ways = 0;
+        std::size_t ways_with_locations = 0;
+        std::vector<osmium::object_id_type> area_ids;
+    };
+
+    template <typename TFlexReader>
+    result read_all(TFlexReader& reader) {
+        result r;
+        while (auto buffer = reader.read()) {
+            for (const auto& way : buffer.template select<osmium::Way>()) {
+                ++r.ways;
+                if (std::all_of(way.nodes().cbegin(), way.nodes().cend(), [](const osmium::NodeRef& nr) {
+                        return nr.location().valid();
+                    })) {
+                    ++r.ways_with_locations;
+                }
+            }
+            for (const auto& area : buffer.template select<osmium::Area>()) {
+                r.area_ids.push_back(area.id());
+            }
+        }
+        REQUIRE(reader.eof());
+        reader.close();
+        std::sort(r.area_ids.begin(), r.area_ids.end());
+        return r;
+    }
+
+    template <typename TIndex>
+    result read_with_flex_reader(const std::string& filename, osmium::thread::Pool* pool, osmium::osm_entity_bits::type entities) {
+        TIndex index;
+        osmium::handler::NodeLocationsForWays<TIndex> location_handler{index};
+
+        if (pool) {
+            osmium::experimental::FlexReader<decltype(location_handler)> reader{filename, location_handler, *pool, entities};
+            return read_all(reader);
+        }
+
+        osmium::experimental::FlexReader<decltype(location_handler)> reader{filename, location_handler, entities};
+        return read_all(reader);
+    }
+
+} // anonymous namespace
+
+TEST_CASE("FlexReader with and without pool give the same result") {
+    const std::string filename = write_test_file();
+    osmium::thread::Pool pool{3};
+
+    const auto entities = GENERATE(osmium::osm_entity_bits::nwr, osmium::osm_entity_bits::nwra);
+    const bool with_areas = (entities & osmium::osm_entity_bits::area) != 0;
+
+    const auto expected = read_with_flex_reader<dense_index_type>(filename, nullptr, entities);
+    REQUIRE(expected.ways == num_ways);
+    REQUIRE(expected.ways_with_locations == num_ways);
+    REQUIRE(expected.area_ids.size() == (with_areas ? num_ways : 0));
+
+    SECTION("dense index, nodes indexed in decoder threads") {
+        const auto r = read_with_flex_reader<dense_index_type>(filename, &pool, entities);
+        REQUIRE(r.ways == expected.ways);
+        REQUIRE(r.ways_with_locations == expected.ways_with_locations);
+        REQUIRE(r.area_ids == expected.area_ids);
+    }
+
+    SECTION("sparse index, nodes indexed in reading thread") {
+        const auto r = read_with_flex_reader<sparse_index_type>(filename, &pool, entities);
+        REQUIRE(r.ways == expected.ways);
+        REQUIRE(r.ways_with_locations == expected.ways_with_locations);
+        REQUIRE(r.area_ids == expected.area_ids);
+    }
+}
+
+TEST_CASE("FlexReader with pool and presized dense index") {
+    const std::string filename = write_test_file();
+    osmium::thread::Pool pool{3};
+
+    dense_index_type index;
+    index.resize(num_ways * 4 + 1);
+    osmium::handler::NodeLocationsForWays<dense_index_type> location_handler{index};
+
+    osmium::experimental::FlexReader<decltype(location_handler)> reader{filename, location_handler, pool};
+    const auto r = read_all(reader);
+    REQUIRE(r.ways == num_ways);
+    REQUIRE(r.ways_with_locations == num_ways);
+    REQUIRE(index.size() == num_ways * 4 + 1);
+}
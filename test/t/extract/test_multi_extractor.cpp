@@ -0,0 +1,152 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/extract/multi_extractor.hpp>
+#include <osmium/extract/polygon.hpp>
+#include <osmium/handler/check_order.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    osmium::memory::Buffer test_data() {
+        osmium::memory::Buffer buffer{10240};
+
+        osmium::builder::add_node(buffer, _id(1), _location(0.5, 0.5));
+        osmium::builder::add_node(buffer, _id(2), _location(1.5, 0.5));
+        osmium::builder::add_node(buffer, _id(3), _location(2.5, 0.5));
+        osmium::builder::add_node(buffer, _id(4), _location(2.5, 2.5));
+
+        osmium::builder::add_way(buffer, _id(10), _nodes({1, 2}));
+        osmium::builder::add_way(buffer, _id(11), _nodes({2, 3}));
+        osmium::builder::add_way(buffer, _id(12), _nodes({3, 4}));
+
+        osmium::builder::add_relation(buffer, _id(20), _member(osmium::item_type::node, 4));
+        osmium::builder::add_relation(buffer, _id(21), _member(osmium::item_type::way, 10));
+        osmium::builder::add_relation(buffer, _id(22), _member(osmium::item_type::relation, 21));
+        osmium::builder::add_relation(buffer, _id(23), _member(osmium::item_type::relation, 24));
+        osmium::builder::add_relation(buffer, _id(24), _member(osmium::item_type::node, 1));
+
+        return buffer;
+    }
+
+    // Collect type and id of all objects written to an extract.
+    struct collector {
+
+        std::vector<std::string>* objects;
+
+        void operator()(osmium::memory::Buffer&& buffer) const {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                objects->push_back(osmium::item_type_to_char(object.type()) + std::to_string(object.id()));
+            }
+        }
+
+    }; // struct collector
+
+} // anonymous namespace
+
+TEST_CASE("Multi extract") {
+    const auto buffer = test_data();
+
+    int num_threads = 1;
+    SECTION("single thread") {
+    }
+    SECTION("multiple threads") {
+        num_threads = 3;
+    }
+
+    osmium::thread::Pool pool{num_threads};
+    osmium::extract::MultiExtractor extractor{pool, 1024};
+
+    std::vector<std::string> a;
+    std::vector<std::string> b;
+    std::vector<std::string> c;
+    std::vector<std::string> d;
+    REQUIRE(extractor.add_extract(osmium::extract::Polygon{osmium::Box{0.0, 0.0, 1.0, 1.0}}, collector{&a}) == 0);
+    REQUIRE(extractor.add_extract(osmium::extract::Polygon{{{{1.0, 0.0}, {4.0, 0.0}, {2.5, 2.0}}}}, collector{&b}) == 1);
+    extractor.add_extract(osmium::extract::Polygon{osmium::Box{2.0, 2.0, 3.0, 3.0}}, collector{&c});
+    extractor.add_extract(osmium::extract::Polygon{osmium::Box{5.0, 5.0, 6.0, 6.0}}, collector{&d});
+    REQUIRE(extractor.size() == 4);
+
+    extractor(buffer);
+    extractor.flush();
+
+    REQUIRE(a == std::vector<std::string>{"n1", "w10", "r21", "r22", "r24"});
+    REQUIRE(b == std::vector<std::string>{"n2", "n3", "w10", "w11", "w12", "r21", "r22"});
+    REQUIRE(c == std::vector<std::string>{"n4", "w12", "r20"});
+    REQUIRE(d.empty());
+
+    REQUIRE(extractor.extract(0).node_ids().get(1));
+    REQUIRE_FALSE(extractor.extract(0).node_ids().get(2));
+    REQUIRE(extractor.extract(1).way_ids().size() == 3);
+    REQUIRE(extractor.extract(2).relation_ids().get(20));
+}
+
+TEST_CASE("Multi extract flushes full buffers") {
+    const auto buffer = test_data();
+
+    osmium::thread::Pool pool{1};
+    osmium::extract::MultiExtractor extractor{pool, 64};
+
+    int buffers = 0;
+    std::vector<std::string> a;
+    const collector collect{&a};
+    extractor.add_extract(osmium::extract::Polygon{osmium::Box{0.0, 0.0, 3.0, 3.0}}, [&](osmium::memory::Buffer&& out) {
+        ++buffers;
+        collect(std::move(out));
+    });
+
+    extractor(buffer);
+    REQUIRE(buffers > 1);
+    extractor.flush();
+    extractor.flush();
+    REQUIRE(a.size() == 4 + 3 + 4);
+}
+
+TEST_CASE("Multi extract with failing output") {
+    const auto buffer = test_data();
+
+    osmium::thread::Pool pool{2};
+    osmium::extract::MultiExtractor extractor{pool, 64};
+
+    std::vector<std::string> a;
+    extractor.add_extract(osmium::extract::Polygon{osmium::Box{0.0, 0.0, 3.0, 3.0}}, collector{&a});
+    extractor.add_extract(osmium::extract::Polygon{osmium::Box{0.0, 0.0, 3.0, 3.0}}, [](osmium::memory::Buffer&& /*buffer*/) {
+        throw std::runtime_error{"output failed"};
+    });
+
+    REQUIRE_THROWS_AS(extractor(buffer), std::runtime_error);
+}
+
+TEST_CASE("Multi extract checks order of input") {
+    osmium::memory::Buffer buffer{10240};
+    osmium::builder::add_node(buffer, _id(2), _location(0.5, 0.5));
+    osmium::builder::add_node(buffer, _id(1), _location(0.5, 0.5));
+
+    osmium::thread::Pool pool{1};
+    osmium::extract::MultiExtractor extractor{pool, 1024};
+
+    std::vector<std::string> a;
+    extractor.add_extract(osmium::extract::Polygon{osmium::Box{0.0, 0.0, 1.0, 1.0}}, collector{&a});
+
+    SECTION("check order") {
+        REQUIRE_THROWS_AS(extractor(buffer), osmium::out_of_order_error);
+        extractor.flush();
+        REQUIRE(a.empty());
+    }
+
+    SECTION("input assumed to be sorted") {
+        extractor.assume_sorted_input();
+        extractor(buffer);
+        extractor.flush();
+        REQUIRE(a == std::vector<std::string>{"n2", "n1"});
+    }
+}
@@ -0,0 +1,160 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/extract/polygon.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    using rings_type = std::vector<std::vector<osmium::Location>>;
+
+    // Straightforward point-in-polygon check without any index.
+    bool brute_force_contains(const rings_type& rings, const osmium::Location& location) {
+        bool inside = false;
+        const int64_t x = location.x();
+        const int64_t y = location.y();
+        for (const auto& ring : rings) {
+            for (std::size_t i = 0; i < ring.size(); ++i) {
+                auto a = ring[i];
+                auto b = ring[(i + 1) % ring.size()];
+                if (a.y() == b.y()) {
+                    continue;
+                }
+                if (a.y() > b.y()) {
+                    std::swap(a, b);
+                }
+                if (y >= a.y() && y < b.y() &&
+                    (x - a.x()) * (int64_t(b.y()) - a.y()) < (y - a.y()) * (int64_t(b.x()) - a.x())) {
+                    inside = !inside;
+                }
+            }
+        }
+        return inside;
+    }
+
+    // A star shaped polygon with a triangular hole.
+    rings_type star() {
+        return {
+            {{0.0, 10.0}, {2.0, 2.0}, {10.0, 0.0}, {2.0, -2.0}, {0.0, -10.0},
+             {-2.0, -2.0}, {-10.0, 0.0}, {-2.0, 2.0}},
+            {{0.5, 0.5}, {1.5, 0.5}, {0.5, 1.5}}
+        };
+    }
+
+    // A comb with axis-parallel edges only.
+    rings_type comb() {
+        std::vector<osmium::Location> ring;
+        ring.emplace_back(-10.0, -10.0);
+        ring.emplace_back(10.0, -10.0);
+        for (int i = 0; i < 10; ++i) {
+            ring.emplace_back(10.0 - i * 2.0, 10.0);
+            ring.emplace_back(9.0 - i * 2.0, 10.0);
+            ring.emplace_back(9.0 - i * 2.0, -5.0);
+            ring.emplace_back(8.0 - i * 2.0, -5.0);
+        }
+        return {ring};
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Polygon from rings") {
+    const auto rings = star();
+    const osmium::extract::Polygon polygon{rings};
+
+    REQUIRE(polygon.envelope() == osmium::Box(-10.0, -10.0, 10.0, 10.0));
+    REQUIRE(polygon.grid_size() == osmium::extract::Polygon::default_grid_size);
+
+    REQUIRE(polygon.contains(osmium::Location{0.0, 0.0}));
+    REQUIRE(polygon.contains(osmium::Location{5.0, 0.1}));
+    REQUIRE(polygon.contains(osmium::Location{0.1, -7.0}));
+    REQUIRE_FALSE(polygon.contains(osmium::Location{5.0, 5.0}));
+    REQUIRE_FALSE(polygon.contains(osmium::Location{20.0, 0.0}));
+    REQUIRE_FALSE(polygon.contains(osmium::Location{0.7, 0.7}));
+    REQUIRE_FALSE(polygon.contains(osmium::Location{}));
+}
+
+TEST_CASE("Polygon gives same results as brute force check") {
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::uniform_int_distribution<int32_t> dist{-110000000, 110000000};
+    std::vector<osmium::Location> locations;
+    for (int i = 0; i < 20000; ++i) {
+        locations.emplace_back(dist(gen), dist(gen));
+    }
+    // Locations exactly on vertices and edges.
+    for (int x = -22; x <= 22; ++x) {
+        for (int y = -22; y <= 22; ++y) {
+            locations.emplace_back(x * 0.5, y * 0.5);
+        }
+    }
+
+    for (const auto& rings : {star(), comb()}) {
+        for (const std::size_t grid_size : {1, 3, 16, 256, 1000}) {
+            const osmium::extract::Polygon polygon{rings, grid_size};
+            for (const auto& location : locations) {
+                REQUIRE(polygon.contains(location) == brute_force_contains(rings, location));
+            }
+        }
+    }
+}
+
+TEST_CASE("Polygon from box") {
+    const osmium::Box box{1.0, 2.0, 3.0, 4.0};
+    const osmium::extract::Polygon polygon{box};
+
+    REQUIRE(polygon.envelope() == box);
+    REQUIRE(polygon.grid_size() == 0);
+    REQUIRE(polygon.contains(osmium::Location{2.0, 3.0}));
+    REQUIRE(polygon.contains(osmium::Location{1.0, 2.0}));
+    REQUIRE(polygon.contains(osmium::Location{3.0, 4.0}));
+    REQUIRE_FALSE(polygon.contains(osmium::Location{3.5, 3.0}));
+
+    REQUIRE_THROWS_AS(osmium::extract::Polygon{osmium::Box{}}, std::invalid_argument);
+}
+
+TEST_CASE("Polygon from area") {
+    osmium::memory::Buffer buffer{10240};
+    osmium::builder::add_area(buffer,
+        _outer_ring({
+            {1, {8.0, 49.0}},
+            {2, {9.0, 49.0}},
+            {3, {9.0, 50.0}},
+            {4, {8.0, 50.0}},
+            {1, {8.0, 49.0}}
+        }),
+        _inner_ring({
+            {5, {8.2, 49.2}},
+            {6, {8.2, 49.5}},
+            {7, {8.5, 49.5}},
+            {8, {8.5, 49.2}},
+            {5, {8.2, 49.2}}
+        })
+    );
+
+    const osmium::extract::Polygon polygon{buffer.get<osmium::Area>(0), 8};
+    REQUIRE(polygon.grid_size() == 8);
+    REQUIRE(polygon.contains(osmium::Location{8.1, 49.1}));
+    REQUIRE(polygon.contains(osmium::Location{8.9, 49.9}));
+    REQUIRE_FALSE(polygon.contains(osmium::Location{8.3, 49.3}));
+    REQUIRE_FALSE(polygon.contains(osmium::Location{7.9, 49.3}));
+}
+
+TEST_CASE("Polygon with invalid input") {
+    const rings_type no_rings;
+    REQUIRE_THROWS_AS(osmium::extract::Polygon{no_rings}, std::invalid_argument);
+
+    const rings_type too_short = {{{1.0, 1.0}, {2.0, 2.0}}};
+    REQUIRE_THROWS_AS(osmium::extract::Polygon{too_short}, std::invalid_argument);
+
+    const rings_type invalid = {{{1.0, 1.0}, {2.0, 2.0}, osmium::Location{}}};
+    REQUIRE_THROWS_AS(osmium::extract::Polygon{invalid}, std::invalid_argument);
+}
@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/extract/snapshot_extractor.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/timestamp.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    osmium::Timestamp year(int y) {
+        return osmium::Timestamp{(std::to_string(y) + "-01-01T00:00:00Z").c_str()};
+    }
+
+    // Collect type, id, and version of all objects written to a snapshot.
+    struct collector {
+
+        std::vector<std::string>* objects;
+
+        void operator()(osmium::memory::Buffer&& buffer) const {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                objects->push_back(osmium::item_type_to_char(object.type()) + std::to_string(object.id()) +
+                                   'v' + std::to_string(object.version()));
+            }
+        }
+
+    }; // struct collector
+
+} // anonymous namespace
+
+TEST_CASE("Snapshots from history data") {
+    osmium::memory::Buffer buffer1{10240};
+    osmium::builder::add_node(buffer1, _id(1), _version(1), _timestamp(year(2010)), _location(1.0, 1.0));
+
+    osmium::memory::Buffer buffer2{10240};
+    osmium::builder::add_node(buffer2, _id(1), _version(2), _timestamp(year(2015)), _location(1.0, 1.0));
+    osmium::builder::add_node(buffer2, _id(1), _version(3), _timestamp(year(2018)), _deleted());
+    osmium::builder::add_node(buffer2, _id(2), _version(1), _timestamp(year(2012)), _location(1.0, 1.0));
+
+    osmium::memory::Buffer buffer3{10240};
+    osmium::builder::add_way(buffer3, _id(1), _version(1), _timestamp(year(2011)), _nodes({1, 2}));
+    osmium::builder::add_way(buffer3, _id(1), _version(2), _timestamp(year(2016)), _nodes({1, 2}));
+
+    std::vector<std::string> s2016;
+    std::vector<std::string> s2009;
+    std::vector<std::string> s2013;
+    std::vector<std::string> s2020;
+
+    osmium::extract::SnapshotExtractor extractor;
+    REQUIRE(extractor.add_snapshot(year(2016), collector{&s2016}) == 0);
+    REQUIRE(extractor.add_snapshot(year(2009), collector{&s2009}) == 1);
+    REQUIRE(extractor.add_snapshot(year(2013), collector{&s2013}) == 2);
+    REQUIRE(extractor.add_snapshot(year(2020), collector{&s2020}) == 3);
+    REQUIRE(extractor.size() == 4);
+    REQUIRE(extractor.snapshot(1).timestamp() == year(2009));
+
+    extractor(buffer1);
+    extractor(osmium::memory::Buffer{1024});
+    extractor(buffer2);
+    extractor(buffer3);
+    extractor.flush();
+
+    REQUIRE(s2009.empty());
+    REQUIRE(s2013 == std::vector<std::string>{"n1v1", "n2v1", "w1v1"});
+    REQUIRE(s2016 == std::vector<std::string>{"n1v2", "n2v1", "w1v2"});
+    REQUIRE(s2020 == std::vector<std::string>{"n2v1", "w1v2"});
+}
+
+TEST_CASE("Snapshot output is flushed when the buffer is full") {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _timestamp(year(2010)), _location(1.0, 1.0));
+    }
+
+    int calls = 0;
+    std::vector<std::string> objects;
+    osmium::extract::SnapshotExtractor extractor{1024};
+    extractor.add_snapshot(year(2011), [&](osmium::memory::Buffer&& b) {
+        ++calls;
+        collector{&objects}(std::move(b));
+    });
+
+    extractor(buffer);
+    extractor.flush();
+
+    REQUIRE(calls > 1);
+    REQUIRE(objects.size() == 1000);
+    REQUIRE(objects.front() == "n1v1");
+    REQUIRE(objects.back() == "n1000v1");
+}
+
+TEST_CASE("Snapshot extractor passes on exceptions from output") {
+    osmium::memory::Buffer buffer{10240};
+    osmium::builder::add_node(buffer, _id(1), _version(1), _timestamp(year(2010)), _location(1.0, 1.0));
+
+    osmium::extract::SnapshotExtractor extractor;
+    extractor.add_snapshot(year(2011), [](osmium::memory::Buffer&& /*buffer*/) {
+        throw std::runtime_error{"output"};
+    });
+
+    extractor(buffer);
+    REQUIRE_THROWS_AS(extractor.flush(), std::runtime_error);
+}
@@ -171,3 +171,41 @@ TEST_CASE("GeoJSON area geometry") {
 
 }
 
+
+TEST_CASE("GeoJSON sink factory creates same geometries as GeoJSON factory") {
+    osmium::memory::Buffer buffer{10000};
+    osmium::geom::GeoJSONFactory<> factory;
+
+    std::string out;
+    osmium::geom::GeoJSONSinkFactory<> sink_factory{out};
+
+    std::string expected{factory.create_point(osmium::Location{3.2, 4.2})};
+    REQUIRE(sink_factory.create_point(osmium::Location{3.2, 4.2}) == expected.size());
+
+    const auto& wnl = create_test_wnl_okay(buffer);
+    expected += factory.create_linestring(wnl);
+    sink_factory.create_linestring(wnl);
+
+    const auto& closed = create_test_wnl_closed(buffer);
+    expected += factory.create_polygon(closed);
+    sink_factory.create_polygon(closed);
+
+    osmium::memory::Buffer area_buffer{10000};
+    const osmium::Area& area = create_test_area_2outer_2inner(area_buffer);
+    const std::string mp{factory.create_multipolygon(area)};
+    expected += mp;
+    REQUIRE(sink_factory.create_multipolygon(area) == mp.size());
+
+    REQUIRE(out == expected);
+
+    out.clear();
+    sink_factory.create_point(osmium::Location{1.5, -2.25});
+    REQUIRE(out == "{\"type\":\"Point\",\"coordinates\":[1.5,-2.25]}");
+}
+
+TEST_CASE("GeoJSON sink factory with precision") {
+    std::string out;
+    osmium::geom::GeoJSONSinkFactory<> sink_factory{out, 2};
+    sink_factory.create_point(osmium::Location{3.2345, 4.2});
+    REQUIRE(out == "{\"type\":\"Point\",\"coordinates\":[3.23,4.2]}");
+}
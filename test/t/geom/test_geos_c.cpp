@@ -0,0 +1,162 @@
+#include <osmium/geom/geos_c.hpp>
+
+#ifdef OSMIUM_WITH_GEOS_C
+
+#include "catch.hpp"
+
+#include "area_helper.hpp"
+#include "wnl_helper.hpp"
+
+#include <osmium/geom/mercator_projection.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <future>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+static double get_x(const osmium::geom::geos_geometry_ptr& geometry, int n = -1) {
+    const auto handle = geometry.get_deleter().context()->get();
+    double x = 0.0;
+    if (n < 0) {
+        GEOSGeomGetX_r(handle, geometry.get(), &x);
+    } else {
+        GEOSGeometry* point = GEOSGeomGetPointN_r(handle, geometry.get(), n);
+        GEOSGeomGetX_r(handle, point, &x);
+        GEOSGeom_destroy_r(handle, point);
+    }
+    return x;
+}
+
+TEST_CASE("GEOS C geometry factory - create point") {
+    osmium::geom::GEOSCFactory<> factory;
+
+    const auto point = factory.create_point(osmium::Location{3.2, 4.2});
+    const auto handle = point.get_deleter().context()->get();
+    double y = 0.0;
+    REQUIRE(GEOSGeomGetY_r(handle, point.get(), &y));
+    REQUIRE(3.2 == get_x(point));
+    REQUIRE(4.2 == y);
+    REQUIRE(4326 == GEOSGetSRID_r(handle, point.get()));
+}
+
+TEST_CASE("GEOS C geometry factory - create point in web mercator") {
+    osmium::geom::GEOSCFactory<osmium::geom::MercatorProjection> factory;
+
+    const auto point = factory.create_point(osmium::Location{3.2, 4.2});
+    REQUIRE(Approx(356222.3705384755L) == get_x(point));
+    REQUIRE(3857 == GEOSGetSRID_r(point.get_deleter().context()->get(), point.get()));
+}
+
+TEST_CASE("GEOS C geometry factory - create point with externally created context") {
+    const auto context = std::make_shared<osmium::geom::GEOSContext>();
+    osmium::geom::GEOSCFactory<> factory{context};
+
+    const auto point = factory.create_point(osmium::Location{3.2, 4.2});
+    REQUIRE(point.get_deleter().context() == context);
+    REQUIRE(3.2 == get_x(point));
+}
+
+TEST_CASE("GEOS C geometry factory - can not create from invalid location") {
+    osmium::geom::GEOSCFactory<> factory;
+
+    REQUIRE_THROWS_AS(factory.create_point(osmium::Location{}), osmium::invalid_location);
+}
+
+TEST_CASE("GEOS C geometry factory - create linestring") {
+    osmium::geom::GEOSCFactory<> factory;
+
+    osmium::memory::Buffer buffer{10000};
+    const auto& wnl = create_test_wnl_okay(buffer);
+
+    SECTION("from way node list") {
+        const auto linestring = factory.create_linestring(wnl);
+        REQUIRE(3 == GEOSGeomGetNumPoints_r(linestring.get_deleter().context()->get(), linestring.get()));
+        REQUIRE(3.2 == get_x(linestring, 0));
+        REQUIRE(3.6 == get_x(linestring, 2));
+    }
+
+    SECTION("without duplicates and backwards") {
+        const auto linestring = factory.create_linestring(wnl, osmium::geom::use_nodes::unique, osmium::geom::direction::backward);
+        REQUIRE(3 == GEOSGeomGetNumPoints_r(linestring.get_deleter().context()->get(), linestring.get()));
+        REQUIRE(3.6 == get_x(linestring, 0));
+        REQUIRE(3.2 == get_x(linestring, 2));
+    }
+
+    SECTION("with duplicates") {
+        const auto linestring = factory.create_linestring(wnl, osmium::geom::use_nodes::all);
+        REQUIRE(4 == GEOSGeomGetNumPoints_r(linestring.get_deleter().context()->get(), linestring.get()));
+        REQUIRE(3.2 == get_x(linestring, 0));
+    }
+}
+
+TEST_CASE("GEOS C geometry factory - create area with one outer and no inner rings") {
+    osmium::geom::GEOSCFactory<> factory;
+
+    osmium::memory::Buffer buffer{10000};
+    const osmium::Area& area = create_test_area_1outer_0inner(buffer);
+
+    const auto mp = factory.create_multipolygon(area);
+    const auto handle = mp.get_deleter().context()->get();
+    REQUIRE(GEOS_MULTIPOLYGON == GEOSGeomTypeId_r(handle, mp.get()));
+    REQUIRE(1 == GEOSGetNumGeometries_r(handle, mp.get()));
+
+    const GEOSGeometry* p0 = GEOSGetGeometryN_r(handle, mp.get(), 0);
+    REQUIRE(0 == GEOSGetNumInteriorRings_r(handle, p0));
+    REQUIRE(4 == GEOSGeomGetNumPoints_r(handle, GEOSGetExteriorRing_r(handle, p0)));
+    REQUIRE(GEOSisValid_r(handle, mp.get()) == 1);
+}
+
+TEST_CASE("GEOS C geometry factory - create area with two outer and two inner rings") {
+    osmium::geom::GEOSCFactory<> factory;
+
+    osmium::memory::Buffer buffer{10000};
+    const osmium::Area& area = create_test_area_2outer_2inner(buffer);
+
+    const auto mp = factory.create_multipolygon(area);
+    const auto handle = mp.get_deleter().context()->get();
+    REQUIRE(2 == GEOSGetNumGeometries_r(handle, mp.get()));
+
+    const GEOSGeometry* p0 = GEOSGetGeometryN_r(handle, mp.get(), 0);
+    REQUIRE(2 == GEOSGetNumInteriorRings_r(handle, p0));
+    REQUIRE(5 == GEOSGeomGetNumPoints_r(handle, GEOSGetExteriorRing_r(handle, p0)));
+
+    const GEOSGeometry* p1 = GEOSGetGeometryN_r(handle, mp.get(), 1);
+    REQUIRE(0 == GEOSGetNumInteriorRings_r(handle, p1));
+}
+
+TEST_CASE("GEOS C geometry factory - errors from GEOS are reported as exceptions") {
+    osmium::geom::GEOSCFactory<> factory;
+
+    // This way has four nodes, but is not closed.
+    osmium::memory::Buffer buffer{10000};
+    const auto& wnl = create_test_wnl_okay(buffer);
+
+    REQUIRE_THROWS_AS(factory.create_polygon(wnl, osmium::geom::use_nodes::all), osmium::geos_geometry_error);
+}
+
+TEST_CASE("GEOS C geometry factory - use in pool threads") {
+    osmium::thread::Pool pool{4};
+
+    osmium::memory::Buffer buffer{10000};
+    const osmium::Area& area = create_test_area_2outer_2inner(buffer);
+
+    std::vector<std::future<double>> futures;
+    for (int i = 0; i < 100; ++i) {
+        futures.push_back(pool.submit([&area]() {
+            osmium::geom::GEOSCFactory<> factory;
+            const auto mp = factory.create_multipolygon(area);
+            double size = 0.0;
+            GEOSArea_r(mp.get_deleter().context()->get(), mp.get(), &size);
+            return size;
+        }));
+    }
+
+    const double expected = futures.front().get();
+    REQUIRE(expected > 0.0);
+    for (auto it = std::next(futures.begin()); it != futures.end(); ++it) {
+        REQUIRE(it->get() == Approx(expected));
+    }
+}
+
+#endif
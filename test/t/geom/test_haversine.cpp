@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/haversine.hpp>
+#include <osmium/geom/spherical_area.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cmath>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static double scalar_length(const osmium::WayNodeList& wnl) {
+    double sum = 0.0;
+    for (std::size_t i = 1; i < wnl.size(); ++i) {
+        sum += osmium::geom::haversine::distance(wnl[i - 1].location(), wnl[i].location());
+    }
+    return sum;
+}
+
+static const osmium::WayNodeList& add_wnl(osmium::memory::Buffer& buffer, const std::vector<osmium::Location>& locations) {
+    std::vector<osmium::NodeRef> nodes;
+    osmium::object_id_type id = 1;
+    for (const auto& location : locations) {
+        nodes.emplace_back(id++, location);
+    }
+    const auto pos = osmium::builder::add_way_node_list(buffer, _nodes(nodes));
+    return buffer.get<osmium::WayNodeList>(pos);
+}
+
+TEST_CASE("Haversine distance between two coordinates") {
+    const osmium::geom::Coordinates c1{0.0, 0.0};
+    const osmium::geom::Coordinates c2{1.0, 0.0};
+    REQUIRE(osmium::geom::haversine::distance(c1, c2) == Approx(111226.3).epsilon(1e-6));
+}
+
+TEST_CASE("Haversine length of way") {
+    osmium::memory::Buffer buffer{100000};
+
+    SECTION("empty and single node") {
+        REQUIRE(osmium::geom::haversine::distance(add_wnl(buffer, {})) == 0.0);
+        REQUIRE(osmium::geom::haversine::distance(add_wnl(buffer, {{1.0, 2.0}})) == 0.0);
+    }
+
+    SECTION("short way") {
+        const auto& wnl = add_wnl(buffer, {{8.0, 49.0}, {8.001, 49.0}, {8.001, 49.002}});
+        REQUIRE(osmium::geom::haversine::distance(wnl) == Approx(scalar_length(wnl)).epsilon(1e-9));
+    }
+
+    SECTION("long way spanning several batches") {
+        std::vector<osmium::Location> locations;
+        for (int i = 0; i < 1000; ++i) {
+            locations.emplace_back(-170.0 + i * 0.3, std::sin(i * 0.1) * 80.0);
+        }
+        const auto& wnl = add_wnl(buffer, locations);
+        REQUIRE(osmium::geom::haversine::distance(wnl) == Approx(scalar_length(wnl)).epsilon(1e-9));
+    }
+
+    SECTION("very long segments") {
+        const auto& wnl = add_wnl(buffer, {{-179.0, -80.0}, {179.0, 80.0}, {0.0, 0.0}, {90.0, 1.0}, {-179.0, 0.0}});
+        REQUIRE(osmium::geom::haversine::distance(wnl) == Approx(scalar_length(wnl)).epsilon(1e-9));
+    }
+
+    SECTION("invalid location") {
+        const auto& wnl = add_wnl(buffer, {{8.0, 49.0}, osmium::Location{}});
+        REQUIRE_THROWS_AS(osmium::geom::haversine::distance(wnl), osmium::invalid_location);
+    }
+}
+
+TEST_CASE("Spherical area") {
+    osmium::memory::Buffer buffer{10000};
+
+    // exact area of a rectangle bounded by meridians and parallels
+    const double r = osmium::geom::haversine::EARTH_RADIUS_IN_METERS;
+    const double expected = r * r * osmium::geom::deg_to_rad(1.0) *
+                            (std::sin(osmium::geom::deg_to_rad(50.0)) - std::sin(osmium::geom::deg_to_rad(49.0)));
+
+    SECTION("ring orientation") {
+        const auto& cw = add_wnl(buffer, {{8.0, 49.0}, {8.0, 50.0}, {9.0, 50.0}, {9.0, 49.0}, {8.0, 49.0}});
+        REQUIRE(osmium::geom::spherical_signed_ring_area(cw) == Approx(expected).epsilon(1e-9));
+
+        const auto& ccw = add_wnl(buffer, {{8.0, 49.0}, {9.0, 49.0}, {9.0, 50.0}, {8.0, 50.0}, {8.0, 49.0}});
+        REQUIRE(osmium::geom::spherical_signed_ring_area(ccw) == Approx(-expected).epsilon(1e-9));
+    }
+
+    SECTION("area with inner ring") {
+        osmium::builder::add_area(buffer,
+            _outer_ring({
+                {1, {8.0, 49.0}},
+                {2, {9.0, 49.0}},
+                {3, {9.0, 50.0}},
+                {4, {8.0, 50.0}},
+                {1, {8.0, 49.0}}
+            }),
+            _inner_ring({
+                {5, {8.0, 49.0}},
+                {6, {8.0, 49.5}},
+                {7, {8.5, 49.5}},
+                {8, {8.5, 49.0}},
+                {5, {8.0, 49.0}}
+            })
+        );
+        const double inner = r * r * osmium::geom::deg_to_rad(0.5) *
+                             (std::sin(osmium::geom::deg_to_rad(49.5)) - std::sin(osmium::geom::deg_to_rad(49.0)));
+        REQUIRE(osmium::geom::spherical_area(buffer.get<osmium::Area>(0)) == Approx(expected - inner).epsilon(1e-9));
+    }
+}
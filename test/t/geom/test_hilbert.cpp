@@ -0,0 +1,52 @@
+#include "catch.hpp"
+
+#include <osmium/geom/hilbert.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+TEST_CASE("Hilbert index of grid corners") {
+    REQUIRE(osmium::geom::hilbert_index(0, 0) == 0);
+    REQUIRE(osmium::geom::hilbert_index(0xFFFFU, 0) == 0xFFFFFFFFU);
+}
+
+TEST_CASE("Hilbert curve visits neighbouring cells one after the other") {
+    // The bottom left 8 x 8 cells are the first 64 on the curve.
+    std::array<std::pair<uint32_t, uint32_t>, 64> cells{};
+    std::array<bool, 64> seen{};
+    for (uint32_t x = 0; x < 8; ++x) {
+        for (uint32_t y = 0; y < 8; ++y) {
+            const auto index = osmium::geom::hilbert_index(x, y);
+            REQUIRE(index < 64);
+            REQUIRE_FALSE(seen[index]);
+            seen[index] = true;
+            cells[index] = std::make_pair(x, y);
+        }
+    }
+
+    for (std::size_t n = 1; n < cells.size(); ++n) {
+        const auto dx = std::abs(static_cast<int>(cells[n].first) - static_cast<int>(cells[n - 1].first));
+        const auto dy = std::abs(static_cast<int>(cells[n].second) - static_cast<int>(cells[n - 1].second));
+        REQUIRE(dx + dy == 1);
+    }
+}
+
+TEST_CASE("Hilbert index of locations") {
+    const osmium::Location a{9.1, 48.7};
+    const osmium::Location b{9.1001, 48.7001};
+    const osmium::Location c{-120.0, -40.0};
+
+    const auto ha = osmium::geom::hilbert_index(a);
+    const auto hb = osmium::geom::hilbert_index(b);
+    const auto hc = osmium::geom::hilbert_index(c);
+
+    REQUIRE(std::abs(static_cast<int64_t>(ha) - static_cast<int64_t>(hb)) < 16);
+    REQUIRE(ha != hc);
+
+    REQUIRE(osmium::geom::hilbert_index(osmium::Location{-180.0, -90.0}) == 0);
+    REQUIRE(osmium::geom::hilbert_index(osmium::Location{}) == 0xFFFFFFFFU);
+}
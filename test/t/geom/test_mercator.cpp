@@ -1,6 +1,13 @@
 #include "catch.hpp"
 
+#include "wnl_helper.hpp"
+
 #include <osmium/geom/mercator_projection.hpp>
+#include <osmium/geom/wkt.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <string>
+#include <vector>
 
 TEST_CASE("Mercator projection") {
     const osmium::geom::MercatorProjection projection;
@@ -32,3 +39,58 @@ TEST_CASE("Mercator bounds") {
     REQUIRE(osmium::geom::detail::y_to_lat(osmium::geom::detail::lon_to_x(180.0)) == Approx(osmium::geom::MERCATOR_MAX_LAT).epsilon(0.0000001));
 }
 
+
+TEST_CASE("Mercator projection of many locations at once") {
+    const osmium::geom::MercatorProjection projection;
+
+    std::vector<osmium::Location> locations;
+    for (int i = -850; i <= 850; i += 3) {
+        locations.emplace_back(i * 0.2 + 0.05, i * 0.1);
+    }
+    REQUIRE(locations.size() > osmium::geom::detail::mercator_batch_size);
+
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+    projection(locations.data(), locations.size(), coordinates.data());
+
+    for (std::size_t i = 0; i < locations.size(); ++i) {
+        const auto c = projection(locations[i]);
+        REQUIRE(coordinates[i].x == Approx(c.x));
+        REQUIRE(coordinates[i].y == Approx(c.y));
+    }
+}
+
+TEST_CASE("Mercator projection of many locations with invalid location") {
+    const osmium::geom::MercatorProjection projection;
+
+    const std::vector<osmium::Location> locations{osmium::Location{1.0, 2.0}, osmium::Location{}};
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+    REQUIRE_THROWS_AS(projection(locations.data(), locations.size(), coordinates.data()), osmium::invalid_location);
+}
+
+TEST_CASE("Geometry factory with mercator projection uses all locations") {
+    osmium::memory::Buffer buffer{1000};
+    osmium::geom::WKTFactory<osmium::geom::MercatorProjection> factory{2};
+
+    const auto& wnl = create_test_wnl_okay(buffer);
+
+    SECTION("unique forwards") {
+        const std::string wkt{factory.create_linestring(wnl)};
+        REQUIRE(wkt == "LINESTRING(356222.37 467961.14,389618.22 523789.37,400750.17 546131.63)");
+    }
+
+    SECTION("all backwards") {
+        const std::string wkt{factory.create_linestring(wnl, osmium::geom::use_nodes::all, osmium::geom::direction::backward)};
+        REQUIRE(wkt == "LINESTRING(400750.17 546131.63,389618.22 523789.37,389618.22 523789.37,356222.37 467961.14)");
+    }
+
+    SECTION("polygon") {
+        const auto& closed = create_test_wnl_closed(buffer);
+        const std::string wkt{factory.create_polygon(closed)};
+        REQUIRE(wkt == "POLYGON((333958.47 334111.17,456409.91 456799.93,400750.17 456799.93,345090.42 389860.76,333958.47 334111.17))");
+    }
+
+    SECTION("undefined location") {
+        const auto& undefined = create_test_wnl_undefined_location(buffer);
+        REQUIRE_THROWS_AS(factory.create_linestring(undefined), osmium::invalid_location);
+    }
+}
@@ -0,0 +1,203 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/mvt.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using geometry = std::vector<uint32_t>;
+
+// Latitude with web mercator y coordinate at half of the maximum
+static const double lat_half = 66.5132604;
+
+static const osmium::WayNodeList& add_wnl(osmium::memory::Buffer& buffer, const std::vector<osmium::Location>& locations) {
+    std::vector<osmium::NodeRef> nodes;
+    osmium::object_id_type id = 1;
+    for (const auto& location : locations) {
+        nodes.emplace_back(id++, location);
+    }
+    const auto pos = osmium::builder::add_way_node_list(buffer, _nodes(nodes));
+    return buffer.get<osmium::WayNodeList>(pos);
+}
+
+TEST_CASE("MVT zigzag encoding") {
+    REQUIRE(osmium::geom::detail::mvt_zigzag(0) == 0);
+    REQUIRE(osmium::geom::detail::mvt_zigzag(-1) == 1);
+    REQUIRE(osmium::geom::detail::mvt_zigzag(1) == 2);
+    REQUIRE(osmium::geom::detail::mvt_zigzag(-2) == 3);
+    REQUIRE(osmium::geom::detail::mvt_zigzag(2147483647) == 4294967294U);
+    REQUIRE(osmium::geom::detail::mvt_zigzag(-2147483647 - 1) == 4294967295U);
+}
+
+TEST_CASE("MVT factory needs web mercator") {
+    using factory_type = osmium::geom::GeometryFactory<osmium::geom::detail::MVTFactoryImpl, osmium::geom::IdentityProjection>;
+    REQUIRE_THROWS_AS(factory_type(osmium::geom::Tile{0, 0, 0}), std::invalid_argument);
+}
+
+TEST_CASE("MVT point") {
+    SECTION("in tile") {
+        const osmium::geom::MVTFactory<> factory{osmium::geom::Tile{0, 0, 0}};
+        REQUIRE(factory.create_point(osmium::Location{0.0, 0.0}) == geometry({9, 4096, 4096}));
+    }
+
+    SECTION("outside tile") {
+        const osmium::geom::MVTFactory<> factory{osmium::geom::Tile{1, 0, 0}};
+        REQUIRE(factory.create_point(osmium::Location{10.0, -10.0}).empty());
+    }
+
+    SECTION("outside tile but in buffer") {
+        const osmium::geom::MVTFactory<> factory{osmium::geom::Tile{1, 1, 0}, 4096, 64};
+        REQUIRE(factory.create_point(osmium::Location{0.0, 0.0}) == geometry({9, 0, 8192}));
+    }
+}
+
+TEST_CASE("MVT linestring") {
+    osmium::memory::Buffer buffer{1000};
+
+    SECTION("inside tile") {
+        osmium::geom::MVTFactory<> factory{osmium::geom::Tile{0, 0, 0}};
+        const auto& wnl = add_wnl(buffer, {{0.0, 0.0}, {90.0, 0.0}, {90.0, lat_half}});
+        REQUIRE(factory.create_linestring(wnl) == geometry({9, 4096, 4096, 18, 2048, 0, 0, 2047}));
+    }
+
+    SECTION("points on same tile coordinate are removed") {
+        osmium::geom::MVTFactory<> factory{osmium::geom::Tile{0, 0, 0}};
+        const auto& wnl = add_wnl(buffer, {{0.0, 0.0}, {0.00001, 0.0}, {90.0, 0.0}, {90.0, 0.00001}});
+        REQUIRE(factory.create_linestring(wnl) == geometry({9, 4096, 4096, 10, 2048, 0}));
+    }
+
+    SECTION("all points on same tile coordinate") {
+        osmium::geom::MVTFactory<> factory{osmium::geom::Tile{0, 0, 0}};
+        const auto& wnl = add_wnl(buffer, {{0.0, 0.0}, {0.00001, 0.0}});
+        REQUIRE(factory.create_linestring(wnl).empty());
+    }
+
+    SECTION("clipped") {
+        osmium::geom::MVTFactory<> factory{osmium::geom::Tile{1, 1, 0}};
+        const auto& wnl = add_wnl(buffer, {{-90.0, lat_half}, {90.0, lat_half}});
+        REQUIRE(factory.create_linestring(wnl) == geometry({9, 0, 4096, 10, 4096, 0}));
+    }
+
+    SECTION("leaving and entering tile creates multilinestring") {
+        osmium::geom::MVTFactory<> factory{osmium::geom::Tile{1, 1, 0}};
+        const auto& wnl = add_wnl(buffer, {{45.0, lat_half}, {45.0, -45.0}, {90.0, -45.0}, {90.0, lat_half}});
+        REQUIRE(factory.create_linestring(wnl) == geometry({9, 2048, 4096, 10, 0, 4096,
+                                                            9, 2048, 0, 10, 0, 4095}));
+    }
+
+    SECTION("outside tile") {
+        osmium::geom::MVTFactory<> factory{osmium::geom::Tile{1, 1, 0}};
+        const auto& wnl = add_wnl(buffer, {{-90.0, lat_half}, {-10.0, lat_half}});
+        REQUIRE(factory.create_linestring(wnl).empty());
+    }
+}
+
+TEST_CASE("MVT polygon") {
+    osmium::memory::Buffer buffer{1000};
+
+    SECTION("inside tile with orientation fixed") {
+        osmium::geom::MVTFactory<> factory{osmium::geom::Tile{0, 0, 0}};
+        const auto& wnl = add_wnl(buffer, {{0.0, 0.0}, {90.0, 0.0}, {90.0, lat_half}, {0.0, lat_half}, {0.0, 0.0}});
+        REQUIRE(factory.create_polygon(wnl) == geometry({9, 4096, 2048, 26, 2048, 0, 0, 2048, 2047, 0, 15}));
+    }
+
+    SECTION("inside tile with correct orientation") {
+        osmium::geom::MVTFactory<> factory{osmium::geom::Tile{0, 0, 0}};
+        const auto& wnl = add_wnl(buffer, {{0.0, lat_half}, {90.0, lat_half}, {90.0, 0.0}, {0.0, 0.0}, {0.0, lat_half}});
+        REQUIRE(factory.create_polygon(wnl) == geometry({9, 4096, 2048, 26, 2048, 0, 0, 2048, 2047, 0, 15}));
+    }
+
+    SECTION("clipped") {
+        osmium::geom::MVTFactory<> factory{osmium::geom::Tile{1, 1, 0}};
+        const auto& wnl = add_wnl(buffer, {{-10.0, -10.0}, {-10.0, lat_half}, {45.0, 80.0}, {90.0, lat_half}, {90.0, -10.0}, {-10.0, -10.0}});
+        const auto g = factory.create_polygon(wnl);
+        REQUIRE(g.size() == 1 + 2 + 1 + 2 * 4 + 1);
+        REQUIRE(g.front() == 9);
+        REQUIRE(g[3] == (2U | (4U << 3U)));
+        REQUIRE(g.back() == 15);
+    }
+
+    SECTION("outside tile") {
+        osmium::geom::MVTFactory<> factory{osmium::geom::Tile{1, 1, 0}};
+        const auto& wnl = add_wnl(buffer, {{-90.0, 0.0}, {-10.0, 0.0}, {-10.0, 10.0}, {-90.0, 0.0}});
+        REQUIRE(factory.create_polygon(wnl).empty());
+    }
+
+    SECTION("covering the whole tile") {
+        osmium::geom::MVTFactory<> factory{osmium::geom::Tile{1, 1, 0}};
+        const auto& wnl = add_wnl(buffer, {{-10.0, -10.0}, {180.0, -10.0}, {180.0, 89.0}, {-10.0, 89.0}, {-10.0, -10.0}});
+        REQUIRE(factory.create_polygon(wnl) == geometry({9, 8192, 0, 26, 0, 8192, 8191, 0, 0, 8191, 15}));
+    }
+}
+
+TEST_CASE("MVT multipolygon") {
+    osmium::memory::Buffer buffer{1000};
+    osmium::geom::MVTFactory<> factory{osmium::geom::Tile{0, 0, 0}};
+
+    SECTION("outer and inner ring") {
+        osmium::builder::add_area(buffer,
+            _outer_ring({
+                {1, {0.0, 0.0}},
+                {2, {90.0, 0.0}},
+                {3, {90.0, lat_half}},
+                {4, {0.0, lat_half}},
+                {1, {0.0, 0.0}}
+            }),
+            _inner_ring({
+                {5, {22.5, 10.0}},
+                {6, {22.5, 20.0}},
+                {7, {45.0, 20.0}},
+                {5, {22.5, 10.0}}
+            })
+        );
+        const auto g = factory.create_multipolygon(buffer.get<osmium::Area>(0));
+        REQUIRE(g.size() == 11 + 9);
+        REQUIRE(g[10] == 15);
+        REQUIRE(g[11] == 9);
+        REQUIRE(g[14] == (2U | (2U << 3U)));
+        REQUIRE(g[19] == 15);
+
+        // inner ring must be counter-clockwise (negative area)
+        int64_t x = 0;
+        int64_t y = 0;
+        std::vector<std::pair<int64_t, int64_t>> points;
+        const auto unzigzag = [](uint32_t v) {
+            return static_cast<int64_t>(v >> 1U) ^ -static_cast<int64_t>(v & 1U);
+        };
+        for (const std::size_t i : {12U, 15U, 17U}) {
+            x += unzigzag(g[i]);
+            y += unzigzag(g[i + 1]);
+            points.emplace_back(x, y);
+        }
+        const auto area = (points[0].first * points[1].second - points[1].first * points[0].second) +
+                          (points[1].first * points[2].second - points[2].first * points[1].second) +
+                          (points[2].first * points[0].second - points[0].first * points[2].second);
+        REQUIRE(area < 0);
+    }
+
+    SECTION("inner rings of clipped away outer ring are dropped") {
+        osmium::geom::MVTFactory<> factory1{osmium::geom::Tile{1, 0, 0}};
+        osmium::builder::add_area(buffer,
+            _outer_ring({
+                {1, {10.0, 10.0}},
+                {2, {90.0, 10.0}},
+                {3, {90.0, 50.0}},
+                {1, {10.0, 10.0}}
+            }),
+            _inner_ring({
+                {5, {50.0, 20.0}},
+                {6, {60.0, 20.0}},
+                {7, {60.0, 30.0}},
+                {5, {50.0, 20.0}}
+            })
+        );
+        REQUIRE(factory1.create_multipolygon(buffer.get<osmium::Area>(0)).empty());
+    }
+}
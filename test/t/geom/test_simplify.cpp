@@ -0,0 +1,125 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/geojson.hpp>
+#include <osmium/geom/simplify.hpp>
+#include <osmium/geom/wkt.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using coordinates = std::vector<osmium::geom::Coordinates>;
+
+static coordinates make(std::initializer_list<std::pair<double, double>> points) {
+    coordinates result;
+    for (const auto& point : points) {
+        result.emplace_back(point.first, point.second);
+    }
+    return result;
+}
+
+TEST_CASE("Douglas-Peucker with short input") {
+    osmium::geom::DouglasPeucker simplifier{1.0};
+    coordinates out;
+
+    simplifier(coordinates{}, out);
+    REQUIRE(out.empty());
+
+    simplifier(make({{0, 0}, {1, 1}}), out);
+    REQUIRE(out == make({{0, 0}, {1, 1}}));
+}
+
+TEST_CASE("Douglas-Peucker on linestring") {
+    const coordinates in = make({{0, 0}, {1, 0.1}, {2, -0.1}, {3, 5}, {4, 6}, {5, 7}, {6, 8.1}, {7, 9}, {8, 9}, {9, 9}});
+    coordinates out;
+
+    SECTION("zero tolerance removes only points on a line") {
+        osmium::geom::DouglasPeucker simplifier{0.0};
+        simplifier(in, out);
+        REQUIRE(out == make({{0, 0}, {1, 0.1}, {2, -0.1}, {3, 5}, {5, 7}, {6, 8.1}, {7, 9}, {9, 9}}));
+    }
+
+    SECTION("tolerance 1") {
+        osmium::geom::DouglasPeucker simplifier{1.0};
+        simplifier(in, out);
+        REQUIRE(out == make({{0, 0}, {2, -0.1}, {3, 5}, {7, 9}, {9, 9}}));
+    }
+
+    SECTION("large tolerance keeps end points") {
+        osmium::geom::DouglasPeucker simplifier{100.0};
+        simplifier(in, out);
+        REQUIRE(out == make({{0, 0}, {9, 9}}));
+    }
+}
+
+TEST_CASE("Douglas-Peucker on ring keeps at least four points") {
+    const coordinates in = make({{0, 0}, {10, 0}, {10, 0.5}, {10, 1}, {0, 1}, {0, 0.5}, {0, 0}});
+    coordinates out;
+
+    osmium::geom::DouglasPeucker simplifier{0.1};
+    simplifier(in, out);
+    REQUIRE(out == make({{0, 0}, {10, 0}, {10, 1}, {0, 1}, {0, 0}}));
+
+    osmium::geom::DouglasPeucker large{100.0};
+    large(in, out);
+    REQUIRE(out.size() == 4);
+    REQUIRE(out.front() == out.back());
+}
+
+TEST_CASE("Geometry factory with simplification") {
+    osmium::memory::Buffer buffer{10000};
+    osmium::geom::WKTFactory<> factory{1};
+    REQUIRE(factory.simplification_tolerance() == 0.0);
+
+    const auto pos = osmium::builder::add_way_node_list(buffer, _nodes({
+        {1, {0.0, 0.0}},
+        {2, {1.0, 0.1}},
+        {3, {2.0, 0.0}},
+        {4, {3.0, 3.0}}
+    }));
+    const auto& wnl = buffer.get<osmium::WayNodeList>(pos);
+
+    REQUIRE(factory.create_linestring(wnl) == "LINESTRING(0 0,1 0.1,2 0,3 3)");
+
+    factory.set_simplification_tolerance(0.5);
+    REQUIRE(factory.simplification_tolerance() == 0.5);
+    REQUIRE(factory.create_linestring(wnl) == "LINESTRING(0 0,2 0,3 3)");
+    REQUIRE(factory.create_linestring(wnl, osmium::geom::use_nodes::all, osmium::geom::direction::backward) == "LINESTRING(3 3,2 0,0 0)");
+
+    factory.set_simplification_tolerance(0.0);
+    REQUIRE(factory.create_linestring(wnl) == "LINESTRING(0 0,1 0.1,2 0,3 3)");
+}
+
+TEST_CASE("Geometry factory with simplification of area") {
+    osmium::memory::Buffer buffer{10000};
+    osmium::builder::add_area(buffer,
+        _outer_ring({
+            {1, {0.0, 0.0}},
+            {2, {5.0, 0.1}},
+            {3, {10.0, 0.0}},
+            {4, {10.0, 10.0}},
+            {5, {0.0, 10.0}},
+            {1, {0.0, 0.0}}
+        }),
+        _inner_ring({
+            {6, {1.0, 1.0}},
+            {7, {1.0, 2.0}},
+            {8, {1.05, 3.0}},
+            {9, {1.0, 4.0}},
+            {10, {2.0, 4.0}},
+            {6, {1.0, 1.0}}
+        })
+    );
+
+    osmium::geom::GeoJSONFactory<> factory{1};
+    factory.set_simplification_tolerance(0.2);
+    REQUIRE(factory.create_multipolygon(buffer.get<osmium::Area>(0)) ==
+            R"({"type":"MultiPolygon","coordinates":[[[[0,0],[10,0],[10,10],[0,10],[0,0]],[[1,1],[1,4],[2,4],[1,1]]]]})");
+}
@@ -0,0 +1,135 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/tile_cover.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::vector<uint64_t> keys(std::initializer_list<std::pair<uint32_t, uint32_t>> tiles) {
+    std::vector<uint64_t> result;
+    for (const auto& tile : tiles) {
+        result.push_back(osmium::geom::tile_key(tile.first, tile.second));
+    }
+    return result;
+}
+
+TEST_CASE("Tile keys") {
+    const osmium::geom::Tile tile{12, 2200, 1343};
+    const auto key = osmium::geom::tile_key(tile);
+    REQUIRE(osmium::geom::tile_from_key(12, key) == tile);
+
+    REQUIRE(osmium::geom::tile_key(3, 0) < osmium::geom::tile_key(0, 1));
+}
+
+TEST_CASE("Tile cover of location") {
+    osmium::geom::TileCover cover{1};
+    cover.add_location(osmium::Location{10.0, 10.0});
+    cover.add_location(osmium::Location{});
+    REQUIRE(cover.tiles() == keys({{1, 0}}));
+
+    cover.clear();
+    REQUIRE(cover.tiles().empty());
+}
+
+TEST_CASE("Tile cover of box") {
+    osmium::geom::TileCover cover{2};
+    cover.add_box(osmium::Box{-10.0, -10.0, 10.0, 10.0});
+    REQUIRE(cover.tiles() == keys({{1, 1}, {2, 1}, {1, 2}, {2, 2}}));
+}
+
+TEST_CASE("Tile cover of linestring") {
+    osmium::memory::Buffer buffer{1000};
+
+    SECTION("horizontal") {
+        const auto pos = osmium::builder::add_way_node_list(buffer, _nodes({
+            {1, {-170.0, 80.0}},
+            {2, {170.0, 80.0}}
+        }));
+        osmium::geom::TileCover cover{2};
+        cover.add_linestring(buffer.get<osmium::WayNodeList>(pos));
+        REQUIRE(cover.tiles() == keys({{0, 0}, {1, 0}, {2, 0}, {3, 0}}));
+    }
+
+    SECTION("diagonal") {
+        const auto pos = osmium::builder::add_way_node_list(buffer, _nodes({
+            {1, {-90.0, 60.0}},
+            {2, {90.0, -30.0}}
+        }));
+        osmium::geom::TileCover cover{1};
+        cover.add_linestring(buffer.get<osmium::WayNodeList>(pos));
+        REQUIRE(cover.tiles() == keys({{0, 0}, {1, 0}, {1, 1}}));
+    }
+
+    SECTION("backwards over several segments") {
+        const auto pos = osmium::builder::add_way_node_list(buffer, _nodes({
+            {1, {170.0, -80.0}},
+            {2, {170.0, 80.0}},
+            {3, {100.0, 80.0}}
+        }));
+        osmium::geom::TileCover cover{2};
+        cover.add_linestring(buffer.get<osmium::WayNodeList>(pos));
+        REQUIRE(cover.tiles() == keys({{3, 0}, {3, 1}, {3, 2}, {3, 3}}));
+    }
+
+    SECTION("single point") {
+        const auto pos = osmium::builder::add_way_node_list(buffer, _nodes({
+            {1, {10.0, 10.0}},
+            {2, osmium::Location{}}
+        }));
+        osmium::geom::TileCover cover{1};
+        cover.add_linestring(buffer.get<osmium::WayNodeList>(pos));
+        REQUIRE(cover.tiles() == keys({{1, 0}}));
+    }
+}
+
+TEST_CASE("Tile cover of area") {
+    osmium::memory::Buffer buffer{1000};
+
+    SECTION("interior is filled") {
+        osmium::builder::add_area(buffer,
+            _outer_ring({
+                {1, {-170.0, -80.0}},
+                {2, {170.0, -80.0}},
+                {3, {170.0, 80.0}},
+                {4, {-170.0, 80.0}},
+                {1, {-170.0, -80.0}}
+            })
+        );
+        osmium::geom::TileCover cover{3};
+        cover.add_area(buffer.get<osmium::Area>(0));
+        REQUIRE(cover.tiles().size() == 64);
+    }
+
+    SECTION("tiles inside inner ring are not used") {
+        osmium::builder::add_area(buffer,
+            _outer_ring({
+                {1, {-170.0, -80.0}},
+                {2, {170.0, -80.0}},
+                {3, {170.0, 80.0}},
+                {4, {-170.0, 80.0}},
+                {1, {-170.0, -80.0}}
+            }),
+            _inner_ring({
+                {5, {-130.0, -75.0}},
+                {6, {-130.0, 75.0}},
+                {7, {130.0, 75.0}},
+                {8, {130.0, -75.0}},
+                {5, {-130.0, -75.0}}
+            })
+        );
+        osmium::geom::TileCover cover{3};
+        cover.add_area(buffer.get<osmium::Area>(0));
+        const auto& tiles = cover.tiles();
+        REQUIRE(tiles.size() == 64 - 16);
+        REQUIRE(std::find(tiles.cbegin(), tiles.cend(), osmium::geom::tile_key(2, 2)) == tiles.cend());
+        REQUIRE(std::find(tiles.cbegin(), tiles.cend(), osmium::geom::tile_key(5, 5)) == tiles.cend());
+        REQUIRE(std::find(tiles.cbegin(), tiles.cend(), osmium::geom::tile_key(1, 2)) != tiles.cend());
+    }
+}
@@ -1,5 +1,6 @@
 #include "catch.hpp"
 
+#include "area_helper.hpp"
 #include "wnl_helper.hpp"
 
 #include <osmium/geom/mercator_projection.hpp>
@@ -146,3 +147,122 @@ TEST_CASE("WKB geometry (byte-order-independent) of empty linestring") {
     REQUIRE_THROWS_AS(factory.create_linestring(wnl, osmium::geom::use_nodes::all, osmium::geom::direction::backward), osmium::geometry_error);
 }
 
+
+static void check_wkb_sink(osmium::geom::wkb_type wtype, osmium::geom::out_type otype) {
+    osmium::memory::Buffer buffer{10000};
+    osmium::geom::WKBFactory<> factory{wtype, otype};
+
+    std::string out;
+    osmium::geom::WKBSinkFactory<> sink_factory{out, wtype, otype};
+
+    std::string expected{factory.create_point(osmium::Location{3.2, 4.2})};
+    REQUIRE(sink_factory.create_point(osmium::Location{3.2, 4.2}) == expected.size());
+
+    const auto& wnl = create_test_wnl_okay(buffer);
+    expected += factory.create_linestring(wnl);
+    sink_factory.create_linestring(wnl);
+    expected += factory.create_linestring(wnl, osmium::geom::use_nodes::all, osmium::geom::direction::backward);
+    sink_factory.create_linestring(wnl, osmium::geom::use_nodes::all, osmium::geom::direction::backward);
+
+    const auto& closed = create_test_wnl_closed(buffer);
+    expected += factory.create_polygon(closed);
+    sink_factory.create_polygon(closed);
+
+    osmium::memory::Buffer area_buffer{10000};
+    const osmium::Area& area = create_test_area_2outer_2inner(area_buffer);
+    const std::string mp{factory.create_multipolygon(area)};
+    expected += mp;
+    REQUIRE(sink_factory.create_multipolygon(area) == mp.size());
+
+    REQUIRE(out == expected);
+
+    const auto size = out.size();
+    REQUIRE_THROWS_AS(sink_factory.create_linestring(create_test_wnl_same_location(buffer)), osmium::geometry_error);
+    out.resize(size);
+    REQUIRE(out == expected);
+}
+
+TEST_CASE("WKB sink factory creates same geometries as WKB factory") {
+    SECTION("wkb binary") {
+        check_wkb_sink(osmium::geom::wkb_type::wkb, osmium::geom::out_type::binary);
+    }
+    SECTION("wkb hex") {
+        check_wkb_sink(osmium::geom::wkb_type::wkb, osmium::geom::out_type::hex);
+    }
+    SECTION("ewkb binary") {
+        check_wkb_sink(osmium::geom::wkb_type::ewkb, osmium::geom::out_type::binary);
+    }
+    SECTION("ewkb hex") {
+        check_wkb_sink(osmium::geom::wkb_type::ewkb, osmium::geom::out_type::hex);
+    }
+}
+
+template <typename TProjection>
+static void check_area_wkb(const osmium::Area& area, osmium::geom::wkb_type wtype, osmium::geom::out_type otype) {
+    osmium::geom::WKBFactory<TProjection> factory{wtype, otype};
+    const std::string expected{factory.create_multipolygon(area)};
+
+    std::string out{"prefix"};
+    REQUIRE(osmium::geom::append_multipolygon_wkb(out, area, TProjection{}, wtype, otype) == expected.size());
+    REQUIRE(out == "prefix" + expected);
+}
+
+TEST_CASE("Direct WKB output of area is the same as from WKB factory") {
+    osmium::memory::Buffer buffer{10000};
+
+    SECTION("1 outer, 0 inner") {
+        const auto& area = create_test_area_1outer_0inner(buffer);
+        check_area_wkb<osmium::geom::IdentityProjection>(area, osmium::geom::wkb_type::wkb, osmium::geom::out_type::hex);
+        check_area_wkb<osmium::geom::IdentityProjection>(area, osmium::geom::wkb_type::ewkb, osmium::geom::out_type::binary);
+    }
+
+    SECTION("1 outer, 1 inner") {
+        const auto& area = create_test_area_1outer_1inner(buffer);
+        check_area_wkb<osmium::geom::IdentityProjection>(area, osmium::geom::wkb_type::wkb, osmium::geom::out_type::binary);
+        check_area_wkb<osmium::geom::MercatorProjection>(area, osmium::geom::wkb_type::ewkb, osmium::geom::out_type::hex);
+    }
+
+    SECTION("2 outer, 2 inner") {
+        const auto& area = create_test_area_2outer_2inner(buffer);
+        check_area_wkb<osmium::geom::IdentityProjection>(area, osmium::geom::wkb_type::wkb, osmium::geom::out_type::hex);
+        check_area_wkb<osmium::geom::IdentityProjection>(area, osmium::geom::wkb_type::ewkb, osmium::geom::out_type::hex);
+        check_area_wkb<osmium::geom::MercatorProjection>(area, osmium::geom::wkb_type::wkb, osmium::geom::out_type::binary);
+        check_area_wkb<osmium::geom::MercatorProjection>(area, osmium::geom::wkb_type::ewkb, osmium::geom::out_type::hex);
+    }
+
+    SECTION("with identity projection overload") {
+        const auto& area = create_test_area_2outer_2inner(buffer);
+        osmium::geom::WKBFactory<> factory{osmium::geom::wkb_type::wkb, osmium::geom::out_type::hex};
+        std::string out;
+        osmium::geom::append_multipolygon_wkb(out, area);
+        REQUIRE(out == factory.create_multipolygon(area));
+    }
+}
+
+TEST_CASE("Direct WKB output of area without rings leaves output unchanged") {
+    osmium::memory::Buffer buffer{10000};
+    osmium::builder::add_area(buffer, _id(17), _tag("building", "yes"));
+    const auto& area = buffer.get<osmium::Area>(0);
+
+    std::string out{"prefix"};
+    REQUIRE_THROWS_AS(osmium::geom::append_multipolygon_wkb(out, area), osmium::geometry_error);
+    REQUIRE(out == "prefix");
+}
+
+TEST_CASE("Direct WKB output of area with invalid location leaves output unchanged") {
+    osmium::memory::Buffer buffer{10000};
+    osmium::builder::add_area(buffer,
+        _id(17),
+        _outer_ring({
+            {1, {0.1, 0.1}},
+            {2, {9.1, 0.1}},
+            {3, osmium::Location{}},
+            {1, {0.1, 0.1}}
+        })
+    );
+    const auto& area = buffer.get<osmium::Area>(0);
+
+    std::string out{"prefix"};
+    REQUIRE_THROWS_AS(osmium::geom::append_multipolygon_wkb(out, area), osmium::invalid_location);
+    REQUIRE(out == "prefix");
+}
@@ -153,3 +153,34 @@ TEST_CASE("WKT geometry factory") {
 
 }
 
+
+TEST_CASE("WKT sink factory creates same geometries as WKT factory") {
+    osmium::memory::Buffer buffer{10000};
+    osmium::geom::WKTFactory<> factory{7, osmium::geom::wkt_type::ewkt};
+
+    std::string out;
+    osmium::geom::WKTSinkFactory<> sink_factory{out, 7, osmium::geom::wkt_type::ewkt};
+
+    std::string expected{factory.create_point(osmium::Location{3.2, 4.2})};
+    REQUIRE(sink_factory.create_point(osmium::Location{3.2, 4.2}) == expected.size());
+
+    const auto& wnl = create_test_wnl_okay(buffer);
+    expected += factory.create_linestring(wnl);
+    sink_factory.create_linestring(wnl);
+
+    const auto& closed = create_test_wnl_closed(buffer);
+    expected += factory.create_polygon(closed);
+    sink_factory.create_polygon(closed);
+
+    osmium::memory::Buffer area_buffer{10000};
+    const osmium::Area& area = create_test_area_2outer_2inner(area_buffer);
+    const std::string mp{factory.create_multipolygon(area)};
+    expected += mp;
+    REQUIRE(sink_factory.create_multipolygon(area) == mp.size());
+
+    REQUIRE(out == expected);
+    REQUIRE(out == "SRID=4326;POINT(3.2 4.2)"
+                   "SRID=4326;LINESTRING(3.2 4.2,3.5 4.7,3.6 4.9)"
+                   "SRID=4326;POLYGON((3 3,4.1 4.1,3.6 4.1,3.1 3.5,3 3))"
+                   "SRID=4326;MULTIPOLYGON(((0.1 0.1,9.1 0.1,9.1 9.1,0.1 9.1,0.1 0.1),(1 1,4 1,4 4,1 4,1 1),(5 5,5 7,7 7,5 5)),((10 10,11 10,11 11,10 11,10 10)))");
+}
@@ -0,0 +1,175 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/haversine.hpp>
+#include <osmium/graph/csr_graph.hpp>
+#include <osmium/graph/graph_builder.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    osmium::Location loc(osmium::object_id_type id) {
+        return osmium::Location{static_cast<double>(id) / 1000.0, 0.0};
+    }
+
+    void add_way(osmium::memory::Buffer& buffer, osmium::object_id_type id, const std::vector<osmium::object_id_type>& nodes, const char* highway = "residential") {
+        std::vector<osmium::NodeRef> refs;
+        for (const auto n : nodes) {
+            refs.emplace_back(n, n == 99 ? osmium::Location{} : loc(n));
+        }
+        osmium::builder::add_way(buffer, _id(id), _nodes(refs), _tag("highway", highway));
+    }
+
+    // Ways:
+    //  1: 1 - 2 - 3 - 4
+    //  2: 3 - 5 - 6        (joins way 1 at 3)
+    //  3: 6 - 7            (oneway, continues way 2)
+    //  4: 10 - 11          (footway, not used)
+    //  5: 20 - 99 - 21     (99 has no location)
+    osmium::memory::Buffer test_data() {
+        osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+        add_way(buffer, 1, {1, 2, 3, 4});
+        add_way(buffer, 2, {3, 5, 6});
+        add_way(buffer, 3, {6, 7}, "oneway");
+        add_way(buffer, 4, {10, 11}, "footway");
+        add_way(buffer, 5, {20, 99, 21});
+        return buffer;
+    }
+
+    osmium::graph::edge_direction direction(const osmium::Way& way) {
+        const std::string highway{way.tags().get_value_by_key("highway", "")};
+        if (highway == "footway") {
+            return osmium::graph::edge_direction::none;
+        }
+        if (highway == "oneway") {
+            return osmium::graph::edge_direction::forward;
+        }
+        return osmium::graph::edge_direction::both;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Build routing graph from ways") {
+    int num_threads = 1;
+    SECTION("single thread") {
+    }
+    SECTION("multiple threads") {
+        num_threads = 3;
+    }
+    osmium::thread::Pool pool{num_threads};
+
+    osmium::graph::GraphBuilder builder{pool, direction};
+
+    auto buffer = test_data();
+    osmium::apply(buffer, builder);
+
+    REQUIRE(builder.is_vertex(1));
+    REQUIRE_FALSE(builder.is_vertex(2));
+    REQUIRE(builder.is_vertex(3));
+    REQUIRE_FALSE(builder.is_vertex(5));
+    REQUIRE(builder.is_vertex(6));
+    REQUIRE_FALSE(builder.is_vertex(10));
+
+    builder.add_ways(std::move(buffer));
+    const auto graph = builder.build();
+
+    REQUIRE(builder.skipped_edges() == 1);
+
+    // vertices: 1, 3, 4, 6, 7, 20, 21
+    REQUIRE(graph.num_vertices() == 7);
+    REQUIRE(graph.node_id(0) == 1);
+    REQUIRE(graph.node_id(6) == 21);
+    REQUIRE(graph.find_vertex(2) == osmium::graph::CSRGraph::invalid_vertex);
+    REQUIRE(graph.find_vertex(100) == osmium::graph::CSRGraph::invalid_vertex);
+
+    const auto v1 = graph.find_vertex(1);
+    const auto v3 = graph.find_vertex(3);
+    const auto v4 = graph.find_vertex(4);
+    const auto v6 = graph.find_vertex(6);
+    const auto v7 = graph.find_vertex(7);
+    const auto v20 = graph.find_vertex(20);
+    REQUIRE(graph.location(v3) == loc(3));
+    REQUIRE_FALSE(graph.location(v20).valid());
+
+    // 1-3, 3-4, 3-6 in both directions, 6->7 only forward
+    REQUIRE(graph.num_edges() == 7);
+    REQUIRE(graph.offsets().back() == 7);
+
+    REQUIRE(graph.out_degree(v1) == 1);
+    REQUIRE(graph.out_degree(v3) == 3);
+    REQUIRE(graph.out_degree(v4) == 1);
+    REQUIRE(graph.out_degree(v6) == 2);
+    REQUIRE(graph.out_degree(v7) == 0);
+    REQUIRE(graph.out_degree(v20) == 0);
+
+    const auto e = graph.first_edge(v1);
+    REQUIRE(graph.target(e) == v3);
+    REQUIRE(graph.way_id(e) == 1);
+    const double expected = osmium::geom::haversine::distance(osmium::geom::Coordinates{loc(1)}, osmium::geom::Coordinates{loc(2)}) +
+                            osmium::geom::haversine::distance(osmium::geom::Coordinates{loc(2)}, osmium::geom::Coordinates{loc(3)});
+    REQUIRE(graph.length(e) == Approx(expected));
+
+    std::vector<osmium::unsigned_object_id_type> targets_of_3;
+    for (auto edge = graph.first_edge(v3); edge != graph.end_edge(v3); ++edge) {
+        targets_of_3.push_back(graph.node_id(graph.target(edge)));
+    }
+    REQUIRE(targets_of_3 == std::vector<osmium::unsigned_object_id_type>{1, 4, 6});
+
+    REQUIRE(graph.target(graph.first_edge(v6)) == v3);
+    REQUIRE(graph.target(graph.first_edge(v6) + 1) == v7);
+    REQUIRE(graph.used_memory() > 0);
+}
+
+TEST_CASE("Build routing graph from closed way") {
+    osmium::thread::Pool pool{2};
+    osmium::graph::GraphBuilder builder{pool};
+
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    add_way(buffer, 1, {1, 2, 3, 1});
+    add_way(buffer, 2, {5});
+    osmium::builder::add_way(buffer, _id(3), _nodes({-1, -2}));
+
+    osmium::apply(buffer, builder);
+    builder.add_ways(std::move(buffer));
+    const auto graph = builder.build();
+
+    REQUIRE(graph.num_vertices() == 1);
+    REQUIRE(graph.num_edges() == 2);
+    REQUIRE(graph.target(0) == 0);
+    REQUIRE(graph.target(1) == 0);
+}
+
+TEST_CASE("Build empty routing graph") {
+    osmium::graph::GraphBuilder builder;
+    const auto graph = builder.build();
+    REQUIRE(graph.num_vertices() == 0);
+    REQUIRE(graph.num_edges() == 0);
+    REQUIRE(graph.offsets().size() == 1);
+}
+
+TEST_CASE("Routing graph builder reports exceptions from direction function") {
+    osmium::thread::Pool pool{2};
+    bool second_pass = false;
+    osmium::graph::GraphBuilder builder{pool, [&second_pass](const osmium::Way& /*way*/) -> osmium::graph::edge_direction {
+        if (second_pass) {
+            throw std::runtime_error{"fail"};
+        }
+        return osmium::graph::edge_direction::both;
+    }};
+
+    auto buffer = test_data();
+    osmium::apply(buffer, builder);
+    second_pass = true;
+    builder.add_ways(std::move(buffer));
+    REQUIRE_THROWS_AS(builder.build(), std::runtime_error);
+}
@@ -127,3 +127,91 @@ TEST_CASE("apply with handler and lambda") {
     REQUIRE(y == 40000000);
 }
 
+
+namespace {
+
+    struct WayHandler : public osmium::handler::Handler {
+        int count = 0;
+        void way(const osmium::Way& /*way*/) noexcept {
+            ++count;
+        }
+    };
+
+    struct ObjectHandler : public osmium::handler::Handler {
+        void osm_object(const osmium::OSMObject& /*object*/) const noexcept {
+        }
+    };
+
+    struct TagsHandler : public osmium::handler::Handler {
+        void tag_list(const osmium::TagList& /*tags*/) const noexcept {
+        }
+    };
+
+} // anonymous namespace
+
+TEST_CASE("entity bits needed by handlers") {
+    const WayHandler way_handler;
+    const ObjectHandler object_handler;
+    const TagsHandler tags_handler;
+    const osmium::handler::Handler empty_handler;
+
+    REQUIRE(osmium::entity_bits_for(empty_handler) == osmium::osm_entity_bits::nothing);
+    REQUIRE(osmium::entity_bits_for(way_handler) == osmium::osm_entity_bits::way);
+    REQUIRE(osmium::entity_bits_for(object_handler) == osmium::osm_entity_bits::nwra);
+    REQUIRE(osmium::entity_bits_for(tags_handler) == osmium::osm_entity_bits::all);
+
+    REQUIRE(osmium::entity_bits_for(way_handler, [](const osmium::Node& /*node*/) {}) ==
+            (osmium::osm_entity_bits::node | osmium::osm_entity_bits::way));
+    REQUIRE(osmium::entity_bits_for([](const osmium::OSMObject& /*object*/) {}) == osmium::osm_entity_bits::nwra);
+    REQUIRE(osmium::entity_bits_for([](const osmium::Changeset& /*changeset*/) {}) == osmium::osm_entity_bits::changeset);
+    REQUIRE(osmium::entity_bits_for([](osmium::Relation& /*relation*/) {}) == osmium::osm_entity_bits::relation);
+
+    using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
+    using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+    index_type index;
+    const location_handler_type location_handler{index};
+    REQUIRE(osmium::entity_bits_for(location_handler) == (osmium::osm_entity_bits::node | osmium::osm_entity_bits::way));
+}
+
+TEST_CASE("apply only calls handlers for wanted entities") {
+    const osmium::io::File file{with_data_dir("t/relations/data.osm")};
+    osmium::io::Reader reader{file};
+
+    const auto buffer = reader.read();
+    reader.close();
+
+    WayHandler handler;
+    osmium::apply(buffer, handler);
+    REQUIRE(handler.count == 2);
+}
+
+TEST_CASE("apply_file reads only wanted entities") {
+    const osmium::io::File file{with_data_dir("t/relations/data.osm")};
+
+    int count_n = 0;
+    int count_w = 0;
+    int count_o = 0;
+
+    SECTION("ways only") {
+        osmium::apply_file(file, [&](const osmium::Way& /*way*/) {
+            ++count_w;
+        });
+        REQUIRE(count_w == 2);
+    }
+
+    SECTION("nodes and ways") {
+        WayHandler handler;
+        osmium::apply_file(file, handler, [&](const osmium::Node& /*node*/) {
+            ++count_n;
+        });
+        REQUIRE(count_n == 5);
+        REQUIRE(handler.count == 2);
+    }
+
+    SECTION("all objects") {
+        osmium::apply_file(file, [&](const osmium::OSMObject& /*object*/) {
+            ++count_o;
+        });
+        REQUIRE(count_o == 10);
+    }
+}
@@ -0,0 +1,143 @@
+#include "catch.hpp"
+
+#include <osmium/apply_diff_parallel.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/diff_handler.hpp>
+#include <osmium/diff_visitor.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/diff_object.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+
+    struct DiffStats : public osmium::diff_handler::DiffHandler {
+
+        std::uint64_t objects = 0;
+        std::uint64_t first = 0;
+        std::uint64_t last = 0;
+        std::uint64_t checksum = 0;
+
+        void add(const osmium::DiffObject& diff) {
+            ++objects;
+            if (diff.first()) {
+                ++first;
+            }
+            if (diff.last()) {
+                ++last;
+            }
+            checksum += static_cast<std::uint64_t>(diff.id()) * 31U +
+                        diff.curr().version() * 7U +
+                        diff.prev().version() * 3U +
+                        diff.next().version();
+        }
+
+        void node(const osmium::DiffNode& diff) {
+            add(diff);
+        }
+
+        void way(const osmium::DiffWay& diff) {
+            add(diff);
+        }
+
+        void merge(const DiffStats& other) {
+            objects += other.objects;
+            first += other.first;
+            last += other.last;
+            checksum += other.checksum;
+        }
+
+    }; // struct DiffStats
+
+} // anonymous namespace
+
+static void write_history_file(const std::string& filename) {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 3000; ++id) {
+        const auto versions = static_cast<osmium::object_version_type>(id % 7 + 1);
+        for (osmium::object_version_type v = 1; v <= versions; ++v) {
+            osmium::builder::add_node(buffer, _id(id), _version(v), _location(1.0, 2.0));
+        }
+    }
+    // one node with many versions spanning several blobs
+    for (osmium::object_version_type v = 1; v <= 20000; ++v) {
+        osmium::builder::add_node(buffer, _id(3001), _version(v), _location(1.0, 2.0));
+    }
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        for (osmium::object_version_type v = 1; v <= 3; ++v) {
+            osmium::builder::add_way(buffer, _id(id), _version(v), _nodes({id, id + 1}));
+        }
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, "osh.pbf"}, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+TEST_CASE("Parallel diff gives the same result as sequential diff") {
+    const std::string filename{"test-apply-diff-parallel.osh.pbf"};
+    write_history_file(filename);
+
+    DiffStats expected;
+    {
+        osmium::io::Reader reader{filename};
+        osmium::apply_diff(reader, expected);
+        reader.close();
+    }
+    REQUIRE(expected.first == 3101);
+    REQUIRE(expected.last == 3101);
+
+    osmium::io::IndexedPBFReader reader{filename, "-"};
+    REQUIRE(reader.num_data_blobs() > 4);
+
+    osmium::thread::Pool pool{3};
+
+    std::size_t blobs_per_range = 0;
+    SECTION("one blob per range") {
+        blobs_per_range = 1;
+    }
+    SECTION("two blobs per range") {
+        blobs_per_range = 2;
+    }
+    SECTION("everything in one range") {
+        blobs_per_range = 1000;
+    }
+
+    DiffStats result;
+    osmium::apply_diff_parallel(reader,
+        []() { return DiffStats{}; },
+        [&result](DiffStats&& stats) { result.merge(stats); },
+        pool, blobs_per_range);
+
+    REQUIRE(result.objects == expected.objects);
+    REQUIRE(result.first == expected.first);
+    REQUIRE(result.last == expected.last);
+    REQUIRE(result.checksum == expected.checksum);
+}
+
+TEST_CASE("Parallel diff passes on exceptions from handlers") {
+    const std::string filename{"test-apply-diff-parallel.osh.pbf"};
+    write_history_file(filename);
+
+    struct ThrowingHandler : public osmium::diff_handler::DiffHandler {
+        void way(const osmium::DiffWay& /*diff*/) {
+            throw std::runtime_error{"way"};
+        }
+    };
+
+    osmium::io::IndexedPBFReader reader{filename, "-"};
+    osmium::thread::Pool pool{2};
+    REQUIRE_THROWS_AS(osmium::apply_diff_parallel(reader,
+        []() { return ThrowingHandler{}; },
+        [](ThrowingHandler&& /*handler*/) {},
+        pool, 1), std::runtime_error);
+}
@@ -0,0 +1,150 @@
+#include "catch.hpp"
+
+#include <osmium/apply_parallel.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    // Hands out a number of buffers with nodes and ways like a Reader.
+    class BufferSource {
+
+        std::vector<osmium::memory::Buffer> m_buffers;
+        std::size_t m_next = 0;
+
+    public:
+
+        BufferSource(int num_buffers, int nodes_per_buffer) {
+            osmium::object_id_type id = 1;
+            for (int b = 0; b < num_buffers; ++b) {
+                osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+                for (int n = 0; n < nodes_per_buffer; ++n) {
+                    osmium::builder::add_node(buffer, osmium::builder::attr::_id(id++));
+                }
+                osmium::builder::add_way(buffer, osmium::builder::attr::_id(b + 1));
+                m_buffers.push_back(std::move(buffer));
+            }
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_buffers.size()) {
+                return osmium::memory::Buffer{};
+            }
+            return std::move(m_buffers[m_next++]);
+        }
+
+    }; // class BufferSource
+
+    struct CountHandler : public osmium::handler::Handler {
+
+        int64_t nodes = 0;
+        int64_t id_sum = 0;
+        int64_t ways = 0;
+        bool flushed = false;
+
+        void node(const osmium::Node& node) {
+            ++nodes;
+            id_sum += node.id();
+        }
+
+        void way(const osmium::Way& /*way*/) {
+            ++ways;
+        }
+
+        void flush() {
+            flushed = true;
+        }
+
+    }; // struct CountHandler
+
+    struct ThrowingHandler : public osmium::handler::Handler {
+
+        void way(const osmium::Way& way) {
+            if (way.id() == 5) {
+                throw std::runtime_error{"way 5"};
+            }
+        }
+
+    }; // struct ThrowingHandler
+
+} // anonymous namespace
+
+TEST_CASE("apply_parallel with merge of handlers") {
+    osmium::thread::Pool pool{4};
+    BufferSource source{100, 100};
+
+    int instances = 0;
+    int64_t nodes = 0;
+    int64_t id_sum = 0;
+    int64_t ways = 0;
+
+    osmium::apply_parallel(source, [&instances]() {
+        ++instances;
+        return CountHandler{};
+    }, [&](CountHandler&& handler) {
+        REQUIRE(handler.flushed);
+        nodes += handler.nodes;
+        id_sum += handler.id_sum;
+        ways += handler.ways;
+    }, pool);
+
+    REQUIRE(instances >= 1);
+    REQUIRE(instances <= 8);
+    REQUIRE(nodes == 10000);
+    REQUIRE(id_sum == 10000 * 10001 / 2);
+    REQUIRE(ways == 100);
+}
+
+TEST_CASE("apply_parallel_ordered delivers outputs in order") {
+    osmium::thread::Pool pool{4};
+    BufferSource source{100, 50};
+
+    std::vector<int64_t> first_ids;
+
+    osmium::apply_parallel_ordered(source, []() {
+        return CountHandler{};
+    }, [](CountHandler& handler) {
+        const auto result = std::make_pair(handler.nodes, handler.id_sum);
+        handler = CountHandler{};
+        return result;
+    }, [&](std::pair<int64_t, int64_t>&& result) {
+        REQUIRE(result.first == 50);
+        // ids in the buffer are first_id .. first_id + 49
+        first_ids.push_back(result.second / 50 - 24);
+    }, pool);
+
+    REQUIRE(first_ids.size() == 100);
+    for (std::size_t i = 0; i < first_ids.size(); ++i) {
+        REQUIRE(first_ids[i] == static_cast<int64_t>(i * 50 + 1));
+    }
+}
+
+TEST_CASE("apply_parallel with empty source") {
+    BufferSource source{0, 0};
+
+    int instances = 0;
+    osmium::apply_parallel(source, [&instances]() {
+        ++instances;
+        return CountHandler{};
+    }, [](CountHandler&& /*handler*/) {});
+
+    REQUIRE(instances == 0);
+}
+
+TEST_CASE("apply_parallel reports exceptions from handlers") {
+    osmium::thread::Pool pool{2};
+    BufferSource source{20, 10};
+
+    REQUIRE_THROWS_AS(osmium::apply_parallel(source, []() {
+        return ThrowingHandler{};
+    }, [](ThrowingHandler&& /*handler*/) {}, pool), std::runtime_error);
+}
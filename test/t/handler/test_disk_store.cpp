@@ -0,0 +1,93 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/disk_store.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using offset_index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, std::size_t>;
+
+TEST_CASE("Read objects written by the DiskStore") {
+    const std::string filename{"test-disk-store.data"};
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+
+    offset_index_type node_index;
+    offset_index_type way_index;
+    offset_index_type relation_index;
+
+    osmium::handler::DiskStore store{fd, node_index, way_index, relation_index};
+
+    osmium::memory::Buffer buffer1{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_node(buffer1, _id(id * 2), _location(1.0, id), _tag("name", std::to_string(id)));
+    }
+    store(buffer1);
+
+    osmium::memory::Buffer buffer2{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer2, _id(1), _nodes({2, 4, 6}));
+    osmium::builder::add_relation(buffer2, _id(1), _member(osmium::item_type::way, 1, "outer"));
+    store(buffer2);
+
+    osmium::io::detail::reliable_close(fd);
+
+    node_index.sort();
+    way_index.sort();
+    relation_index.sort();
+
+    const int read_fd = osmium::io::detail::open_for_reading(filename);
+    const osmium::handler::DiskStoreReader reader{read_fd, node_index, way_index, relation_index};
+    osmium::io::detail::reliable_close(read_fd);
+
+    SECTION("get single objects") {
+        const auto& node = reader.get_node(20);
+        REQUIRE(node.id() == 20);
+        REQUIRE(std::string{node.tags()["name"]} == "10");
+        REQUIRE(node.location().lat() == Approx(10.0));
+
+        // the first object in the file is at offset 0
+        REQUIRE(reader.get_node(2).id() == 2);
+
+        const auto& way = reader.get_way(1);
+        REQUIRE(way.nodes().size() == 3);
+
+        const auto& relation = reader.get_relation(1);
+        REQUIRE(relation.members().size() == 1);
+    }
+
+    SECTION("missing objects") {
+        REQUIRE(reader.get_noexcept(osmium::item_type::node, 3) == nullptr);
+        REQUIRE(reader.get_noexcept(osmium::item_type::way, 2) == nullptr);
+        REQUIRE(reader.get_noexcept(osmium::item_type::changeset, 1) == nullptr);
+        REQUIRE_THROWS_AS(reader.get(osmium::item_type::node, 1), osmium::not_found);
+        REQUIRE_THROWS_AS(reader.get_relation(2), osmium::not_found);
+    }
+
+    SECTION("get many objects in file order") {
+        const std::vector<osmium::object_id_type> ids{200, 4, 7, 100, 2};
+        std::vector<osmium::object_id_type> found;
+        reader.get_many(osmium::item_type::node, ids.data(), ids.size(), [&](const osmium::OSMObject& object) {
+            found.push_back(object.id());
+        });
+        const std::vector<osmium::object_id_type> expected{2, 4, 100, 200};
+        REQUIRE(found == expected);
+    }
+}
+
+TEST_CASE("Read from empty DiskStore file") {
+    const std::string filename{"test-disk-store-empty.data"};
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_close(fd);
+
+    const offset_index_type index;
+    const int read_fd = osmium::io::detail::open_for_reading(filename);
+    const osmium::handler::DiskStoreReader reader{read_fd, index, index, index};
+    osmium::io::detail::reliable_close(read_fd);
+
+    REQUIRE(reader.get_noexcept(osmium::item_type::node, 1) == nullptr);
+}
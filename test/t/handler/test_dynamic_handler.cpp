@@ -112,3 +112,48 @@ TEST_CASE("Dynamic handler") {
     REQUIRE(count == 10);
 }
 
+
+struct FunctorHandler {
+
+    int& count;
+
+    explicit FunctorHandler(int& c) :
+        count(c) {
+    }
+
+    void operator()(const osmium::Node& /*node*/) noexcept {
+        count += 3;
+    }
+
+    void operator()(const osmium::Way& /*way*/) noexcept {
+        count += 4;
+    }
+
+    void operator()(const osmium::OSMEntity& /*entity*/) noexcept {
+    }
+
+};
+
+TEST_CASE("Dynamic handler with buffer interface") {
+    const auto buffer = fill_buffer();
+
+    osmium::handler::DynamicHandler handler;
+    handler.buffer(buffer);
+
+    int count = 0;
+    handler.set<Handler1>(count);
+    handler.buffer(buffer);
+    REQUIRE(count == 5);
+    handler.flush();
+    REQUIRE(count == 6);
+
+    count = 0;
+    handler.set<Handler2>(count);
+    handler.buffer(buffer);
+    REQUIRE(count == 10);
+
+    count = 0;
+    handler.set<FunctorHandler>(count);
+    handler.buffer(buffer);
+    REQUIRE(count == 7);
+}
@@ -0,0 +1,181 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/fused.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/visitor.hpp>
+
+#include <vector>
+
+namespace {
+
+struct highway_key {
+    static const char* key() noexcept {
+        return "highway";
+    }
+};
+
+struct primary_value {
+    static const char* value() noexcept {
+        return "primary";
+    }
+};
+
+struct selected_ids {
+    static osmium::index::IdSetSmall<osmium::unsigned_object_id_type>& ids() {
+        static osmium::index::IdSetSmall<osmium::unsigned_object_id_type> set;
+        return set;
+    }
+};
+
+int highway_checks = 0;
+
+// Same as has_key<highway_key>, but counts how often it is called.
+struct counting_has_highway {
+    bool operator()(const osmium::OSMObject& object) const noexcept {
+        ++highway_checks;
+        return object.tags().has_key("highway");
+    }
+};
+
+using highway_ways = osmium::handler::predicate_list<
+    osmium::handler::predicate::entity<osmium::osm_entity_bits::way>,
+    counting_has_highway>;
+
+struct IdCollector : public osmium::handler::Handler {
+
+    std::vector<osmium::object_id_type> ids;
+    int flushed = 0;
+
+    void osm_object(const osmium::OSMObject& object) {
+        ids.push_back(object.id());
+    }
+
+    void changeset(const osmium::Changeset& changeset) {
+        ids.push_back(changeset.id());
+    }
+
+    void flush() noexcept {
+        ++flushed;
+    }
+
+};
+
+struct AllHandler : public IdCollector {
+};
+
+struct RoadHandler : public IdCollector {
+    using predicates = highway_ways;
+};
+
+struct OtherRoadHandler : public IdCollector {
+    using predicates = highway_ways;
+};
+
+struct PrimaryHandler : public IdCollector {
+    using predicates = osmium::handler::predicate_list<
+        osmium::handler::predicate::has_tag<highway_key, primary_value>>;
+};
+
+struct NodeOrChangesetHandler : public IdCollector {
+    using predicates = osmium::handler::predicate_list<
+        osmium::handler::predicate::entity<osmium::osm_entity_bits::node | osmium::osm_entity_bits::changeset>>;
+};
+
+struct SelectedNodeHandler : public IdCollector {
+    using predicates = osmium::handler::predicate_list<
+        osmium::handler::predicate::entity<osmium::osm_entity_bits::node>,
+        osmium::handler::predicate::id_in<selected_ids>>;
+};
+
+// A handler class without a predicates member...
+struct ExternalHandler : public IdCollector {
+};
+
+} // anonymous namespace
+
+// ...gets its predicates through a specialization.
+namespace osmium {
+    namespace handler {
+
+        template <>
+        struct handler_predicates<ExternalHandler> {
+            using type = predicate_list<predicate::has_key<highway_key>>;
+        };
+
+    } // namespace handler
+} // namespace osmium
+
+static osmium::memory::Buffer fill_buffer() {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_node(buffer, _id(1), _tag("highway", "stop"));
+    osmium::builder::add_node(buffer, _id(2));
+    osmium::builder::add_way(buffer, _id(3), _tag("highway", "primary"));
+    osmium::builder::add_way(buffer, _id(4), _tag("building", "yes"));
+    osmium::builder::add_way(buffer, _id(5), _tag("highway", "residential"));
+    osmium::builder::add_relation(buffer, _id(6), _tag("highway", "primary"));
+    osmium::builder::add_changeset(buffer, _cid(7));
+
+    return buffer;
+}
+
+TEST_CASE("Fused handler without predicates works like chain handler") {
+    const auto buffer = fill_buffer();
+
+    AllHandler h1;
+    AllHandler h2;
+    auto fused = osmium::handler::make_fused_handler(h1, h2);
+    REQUIRE(decltype(fused)::num_predicates() == 0);
+
+    osmium::apply(buffer, fused);
+
+    const std::vector<osmium::object_id_type> all{1, 2, 3, 4, 5, 6, 7};
+    REQUIRE(h1.ids == all);
+    REQUIRE(h2.ids == all);
+    REQUIRE(h1.flushed == 1);
+    REQUIRE(h2.flushed == 1);
+}
+
+TEST_CASE("Fused handler calls handlers only for matching objects") {
+    const auto buffer = fill_buffer();
+
+    selected_ids::ids().set(2);
+    selected_ids::ids().set(3);
+
+    AllHandler all;
+    RoadHandler roads;
+    PrimaryHandler primary;
+    NodeOrChangesetHandler nodes;
+    SelectedNodeHandler selected;
+    ExternalHandler external;
+    auto fused = osmium::handler::make_fused_handler(all, roads, primary, nodes, selected, external);
+
+    osmium::apply(buffer, fused);
+
+    REQUIRE(all.ids == std::vector<osmium::object_id_type>({1, 2, 3, 4, 5, 6, 7}));
+    REQUIRE(roads.ids == std::vector<osmium::object_id_type>({3, 5}));
+    REQUIRE(primary.ids == std::vector<osmium::object_id_type>({3, 6}));
+    REQUIRE(nodes.ids == std::vector<osmium::object_id_type>({1, 2, 7}));
+    REQUIRE(selected.ids == std::vector<osmium::object_id_type>({2}));
+    REQUIRE(external.ids == std::vector<osmium::object_id_type>({1, 3, 5, 6}));
+}
+
+TEST_CASE("Fused handler evaluates shared predicates once per object") {
+    const auto buffer = fill_buffer();
+
+    RoadHandler roads;
+    OtherRoadHandler other_roads;
+    AllHandler all;
+    auto fused = osmium::handler::make_fused_handler(roads, all, other_roads);
+    REQUIRE(decltype(fused)::num_predicates() == 1);
+
+    highway_checks = 0;
+    osmium::apply(buffer, fused);
+
+    // Only called for the three ways, once each.
+    REQUIRE(highway_checks == 3);
+    REQUIRE(roads.ids == std::vector<osmium::object_id_type>({3, 5}));
+    REQUIRE(other_roads.ids == std::vector<osmium::object_id_type>({3, 5}));
+}
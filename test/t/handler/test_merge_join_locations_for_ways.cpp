@@ -0,0 +1,165 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/merge_join_locations_for_ways.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    // Nodes 1..num_nodes at location (id/100, id/1000), ways using
+    // nodes from all over the ID range.
+    osmium::memory::Buffer make_data(osmium::object_id_type num_nodes, osmium::object_id_type num_ways) {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= num_nodes; ++id) {
+            osmium::builder::add_node(buffer, _id(id), _location(static_cast<double>(id) / 100, static_cast<double>(id) / 1000));
+        }
+        for (osmium::object_id_type id = 1; id <= num_ways; ++id) {
+            const auto a = (id * 7919) % num_nodes + 1;
+            const auto b = (id * 104729) % num_nodes + 1;
+            osmium::builder::add_way(buffer, _id(id), _nodes({a, b, a, num_nodes - a + 1}));
+        }
+        return buffer;
+    }
+
+    void check_way(const osmium::Way& way) {
+        REQUIRE(way.nodes().size() == 4);
+        for (const auto& node_ref : way.nodes()) {
+            REQUIRE(node_ref.location() == osmium::Location{static_cast<double>(node_ref.ref()) / 100,
+                                                            static_cast<double>(node_ref.ref()) / 1000});
+        }
+    }
+
+    struct CheckHandler : public osmium::handler::Handler {
+
+        int ways = 0;
+
+        void way(const osmium::Way& way) {
+            check_way(way);
+            ++ways;
+        }
+
+    }; // struct CheckHandler
+
+} // anonymous namespace
+
+TEST_CASE("Merge join locations for ways") {
+    std::size_t memory_budget = 0;
+    std::size_t runs = 0;
+
+    SECTION("in memory") {
+        memory_budget = 1024 * 1024;
+    }
+
+    SECTION("with temporary files") {
+        memory_budget = 1;
+        runs = 4;
+    }
+
+    auto buffer = make_data(1000, 1000);
+    osmium::handler::MergeJoinLocationsForWays join{memory_budget};
+    REQUIRE(join.current_pass() == osmium::handler::MergeJoinLocationsForWays::pass::collect_refs);
+
+    osmium::apply(buffer, join);
+    REQUIRE(join.num_node_refs() == 4000);
+    join.next_pass();
+
+    osmium::apply(buffer, join);
+    join.next_pass();
+    REQUIRE(join.num_runs() == runs);
+
+    CheckHandler handler;
+    osmium::apply(buffer, join, handler);
+    join.next_pass();
+    REQUIRE(handler.ways == 1000);
+    REQUIRE(join.current_pass() == osmium::handler::MergeJoinLocationsForWays::pass::done);
+
+    REQUIRE_THROWS_AS(join.next_pass(), std::runtime_error);
+}
+
+TEST_CASE("Merge join locations for ways with missing node") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _location(1.0, 1.0));
+    osmium::builder::add_node(buffer, _id(3), _location(3.0, 3.0));
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, 3}));
+
+    osmium::handler::MergeJoinLocationsForWays join;
+    osmium::apply(buffer, join);
+    join.next_pass();
+    osmium::apply(buffer, join);
+    join.next_pass();
+
+    SECTION("error") {
+        REQUIRE_THROWS_AS(osmium::apply(buffer, join), osmium::not_found);
+    }
+
+    SECTION("ignore errors") {
+        join.ignore_errors();
+        osmium::apply(buffer, join);
+        join.next_pass();
+        const auto& way = *buffer.select<osmium::Way>().cbegin();
+        REQUIRE(way.nodes()[0].location() == osmium::Location{1.0, 1.0});
+        REQUIRE_FALSE(way.nodes()[1].location());
+        REQUIRE(way.nodes()[2].location() == osmium::Location{3.0, 3.0});
+    }
+}
+
+TEST_CASE("Merge join locations for ways with unordered nodes") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(3), _location(3.0, 3.0));
+    osmium::builder::add_node(buffer, _id(1), _location(1.0, 1.0));
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 3}));
+
+    osmium::handler::MergeJoinLocationsForWays join;
+    osmium::apply(buffer, join);
+    join.next_pass();
+    REQUIRE_THROWS_AS(osmium::apply(buffer, join), osmium::out_of_order_error);
+}
+
+TEST_CASE("Merge join locations for ways with different ways in third pass") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _location(1.0, 1.0));
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 1}));
+
+    osmium::handler::MergeJoinLocationsForWays join;
+    osmium::apply(buffer, join);
+    join.next_pass();
+    osmium::apply(buffer, join);
+    join.next_pass();
+
+    SECTION("more ways") {
+        osmium::apply(buffer, join);
+        REQUIRE_THROWS_AS(osmium::apply(buffer, join), std::runtime_error);
+    }
+
+    SECTION("fewer ways") {
+        REQUIRE_THROWS_AS(join.next_pass(), std::runtime_error);
+    }
+}
+
+TEST_CASE("Merge join locations for ways reading file") {
+    const std::string filename{"test-merge-join-locations.opl"};
+    {
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(make_data(200, 50));
+        writer.close();
+    }
+
+    osmium::handler::MergeJoinLocationsForWays join{1};
+    CheckHandler handler;
+    osmium::handler::merge_join_locations(osmium::io::File{filename}, join, handler);
+    REQUIRE(handler.ways == 50);
+    REQUIRE(join.current_pass() == osmium::handler::MergeJoinLocationsForWays::pass::done);
+
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,61 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/renumber.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/visitor.hpp>
+
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Renumber handler") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(10), _location(1.0, 1.0));
+    osmium::builder::add_node(buffer, _id(20), _location(2.0, 2.0));
+    osmium::builder::add_node(buffer, _id(30), _location(3.0, 3.0));
+    osmium::builder::add_way(buffer, _id(5), _nodes({10, 20, 30, 10}));
+    osmium::builder::add_way(buffer, _id(7), _nodes({30, 40}));
+    osmium::builder::add_relation(buffer, _id(100),
+        _member(osmium::item_type::way, 7, "outer"),
+        _member(osmium::item_type::node, 20, ""),
+        _member(osmium::item_type::relation, 300, ""));
+    osmium::builder::add_relation(buffer, _id(300),
+        _member(osmium::item_type::relation, 100, ""));
+
+    osmium::handler::Renumber<> renumber;
+    renumber.set_start_id(osmium::item_type::relation, 1000);
+    osmium::apply(buffer, renumber);
+
+    std::vector<osmium::object_id_type> ids;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        ids.push_back(object.id());
+    }
+    REQUIRE(ids == std::vector<osmium::object_id_type>({1, 2, 3, 1, 2, 1000, 1001}));
+
+    auto it = buffer.select<osmium::Way>().cbegin();
+    const auto& way1 = *it++;
+    REQUIRE(way1.nodes()[0].ref() == 1);
+    REQUIRE(way1.nodes()[1].ref() == 2);
+    REQUIRE(way1.nodes()[2].ref() == 3);
+    REQUIRE(way1.nodes()[3].ref() == 1);
+    const auto& way2 = *it;
+    REQUIRE(way2.nodes()[0].ref() == 3);
+    REQUIRE(way2.nodes()[1].ref() == 4);
+
+    auto rit = buffer.select<osmium::Relation>().cbegin();
+    const auto& relation1 = *rit++;
+    auto mit = relation1.members().cbegin();
+    REQUIRE(mit++->ref() == 2);
+    REQUIRE(mit++->ref() == 2);
+    REQUIRE(mit->ref() == 1001);
+    const auto& relation2 = *rit;
+    REQUIRE(relation2.members().cbegin()->ref() == 1000);
+
+    REQUIRE(renumber.map(osmium::item_type::node).size() == 4);
+    REQUIRE(renumber.map(osmium::item_type::node).old_id(4) == 40);
+    REQUIRE(renumber.map(osmium::item_type::relation).old_id(1001) == 300);
+}
@@ -0,0 +1,137 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/handler/chain.hpp>
+#include <osmium/handler/tracing.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/visitor.hpp>
+
+#include <chrono>
+#include <thread>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Latency histogram buckets") {
+    using osmium::handler::latency_histogram;
+    REQUIRE(latency_histogram::bucket_for(std::chrono::nanoseconds{0}) == 0);
+    REQUIRE(latency_histogram::bucket_for(std::chrono::nanoseconds{1}) == 0);
+    REQUIRE(latency_histogram::bucket_for(std::chrono::nanoseconds{2}) == 1);
+    REQUIRE(latency_histogram::bucket_for(std::chrono::nanoseconds{3}) == 1);
+    REQUIRE(latency_histogram::bucket_for(std::chrono::nanoseconds{1024}) == 10);
+    REQUIRE(latency_histogram::bucket_for(std::chrono::hours{10000}) == latency_histogram::num_buckets - 1);
+    REQUIRE(latency_histogram::bucket_start(10) == std::chrono::nanoseconds{1024});
+
+    latency_histogram histogram;
+    REQUIRE(histogram.percentile(50) == std::chrono::nanoseconds{0});
+    for (int i = 0; i < 99; ++i) {
+        histogram.add(std::chrono::nanoseconds{100});
+    }
+    histogram.add(std::chrono::nanoseconds{5000});
+    REQUIRE(histogram.count() == 100);
+    REQUIRE(histogram.count(6) == 99);
+    REQUIRE(histogram.percentile(50) == std::chrono::nanoseconds{128});
+    REQUIRE(histogram.percentile(100) == std::chrono::nanoseconds{8192});
+}
+
+TEST_CASE("Object trace keeps the slowest objects") {
+    osmium::handler::ObjectTrace trace{3};
+    for (int i = 1; i <= 10; ++i) {
+        trace.add(osmium::item_type::way, i, std::chrono::nanoseconds{(i * 7) % 11});
+    }
+    trace.add(osmium::item_type::node, 99, std::chrono::nanoseconds{1});
+
+    const auto& ways = trace.stats(osmium::item_type::way);
+    REQUIRE(ways.count == 10);
+    REQUIRE(ways.max_time == std::chrono::nanoseconds{10});
+    REQUIRE(ways.total_time == std::chrono::nanoseconds{55});
+    REQUIRE(trace.stats(osmium::item_type::node).count == 1);
+    REQUIRE(trace.stats(osmium::item_type::relation).count == 0);
+
+    const auto slowest = trace.slowest();
+    REQUIRE(slowest.size() == 3);
+    REQUIRE(slowest[0].time == std::chrono::nanoseconds{10});
+    REQUIRE(slowest[0].id == 3);
+    REQUIRE(slowest[1].time == std::chrono::nanoseconds{9});
+    REQUIRE(slowest[1].id == 6);
+    REQUIRE(slowest[2].time == std::chrono::nanoseconds{8});
+    REQUIRE(slowest[2].id == 9);
+
+    trace.clear();
+    REQUIRE(trace.slowest().empty());
+    REQUIRE(trace.stats(osmium::item_type::way).count == 0);
+}
+
+namespace {
+
+    struct SlowHandler : public osmium::handler::Handler {
+
+        int objects = 0;
+        int ways = 0;
+        bool flushed = false;
+
+        void osm_object(const osmium::OSMObject& /*object*/) noexcept {
+            ++objects;
+        }
+
+        void way(const osmium::Way& way) {
+            ++ways;
+            if (way.id() == 7) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{5});
+            }
+        }
+
+        void flush() noexcept {
+            flushed = true;
+        }
+
+    }; // struct SlowHandler
+
+} // anonymous namespace
+
+TEST_CASE("Tracing handler finds slow object") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 1; i <= 5; ++i) {
+        osmium::builder::add_node(buffer, _id(i));
+    }
+    for (int i = 1; i <= 10; ++i) {
+        osmium::builder::add_way(buffer, _id(i), _nodes({1, 2}));
+    }
+    osmium::builder::add_relation(buffer, _id(1));
+
+    SlowHandler slow;
+    osmium::handler::TracingHandler<SlowHandler> tracer{slow, 2};
+
+    osmium::apply(buffer, tracer);
+
+    REQUIRE(slow.objects == 16);
+    REQUIRE(slow.ways == 10);
+    REQUIRE(slow.flushed);
+
+    const auto& trace = tracer.trace();
+    REQUIRE(trace.stats(osmium::item_type::node).count == 5);
+    REQUIRE(trace.stats(osmium::item_type::way).count == 10);
+    REQUIRE(trace.stats(osmium::item_type::relation).count == 1);
+    REQUIRE(trace.stats(osmium::item_type::way).max_time >= std::chrono::milliseconds{5});
+
+    const auto slowest = trace.slowest();
+    REQUIRE(slowest.size() == 2);
+    REQUIRE(slowest[0].type == osmium::item_type::way);
+    REQUIRE(slowest[0].id == 7);
+}
+
+TEST_CASE("Tracing handler wrapping chain handler") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(7), _nodes({1, 2}));
+
+    SlowHandler slow;
+    osmium::handler::Handler noop;
+    osmium::handler::ChainHandler<SlowHandler, osmium::handler::Handler> chain{slow, noop};
+    osmium::handler::TracingHandler<decltype(chain)> tracer{chain};
+
+    osmium::apply(buffer, tracer);
+
+    REQUIRE(slow.ways == 1);
+    REQUIRE(tracer.trace().slowest().size() == 1);
+    REQUIRE(tracer.trace().slowest()[0].id == 7);
+}
@@ -0,0 +1,100 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/index/add_locations_to_ways.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+using index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location location_for(osmium::object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id) * 10, static_cast<int32_t>(id) * 20};
+}
+
+static void fill_index(index_type& index) {
+    for (osmium::unsigned_object_id_type id = 1; id <= 1000; ++id) {
+        index.set(id, location_for(static_cast<osmium::object_id_type>(id)));
+    }
+    index.sort();
+}
+
+TEST_CASE("Add locations to small buffer of ways") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    index_type index_pos;
+    fill_index(index_pos);
+    index_type index_neg;
+    index_neg.set(7, osmium::Location{1, 2});
+    index_neg.sort();
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1));
+    const auto pos1 = osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, -7}));
+    const auto pos2 = osmium::builder::add_way(buffer, _id(2), _nodes({3, 2000}));
+
+    osmium::thread::Pool pool{2};
+    REQUIRE(osmium::index::add_locations_to_ways(buffer, index_pos, index_neg, pool) == 1);
+
+    const auto& way1 = buffer.get<osmium::Way>(pos1);
+    REQUIRE(way1.nodes()[0].location() == location_for(1));
+    REQUIRE(way1.nodes()[1].location() == location_for(2));
+    REQUIRE(way1.nodes()[2].location() == osmium::Location(1, 2));
+
+    const auto& way2 = buffer.get<osmium::Way>(pos2);
+    REQUIRE(way2.nodes()[0].location() == location_for(3));
+    REQUIRE_FALSE(way2.nodes()[1].location());
+}
+
+TEST_CASE("Add locations to large buffer of ways in parallel") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    index_type index_pos;
+    fill_index(index_pos);
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 5000; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _nodes({id % 1000 + 1, (id + 1) % 1000 + 1, id % 10 == 0 ? 5000 : 5}));
+    }
+
+    osmium::thread::Pool pool{4};
+    REQUIRE(osmium::index::add_locations_to_ways(buffer, index_pos, pool) == 500);
+
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        REQUIRE(way.nodes()[0].location() == location_for(way.id() % 1000 + 1));
+        REQUIRE(way.nodes()[1].location() == location_for((way.id() + 1) % 1000 + 1));
+        if (way.id() % 10 == 0) {
+            REQUIRE_FALSE(way.nodes()[2].location());
+        } else {
+            REQUIRE(way.nodes()[2].location() == location_for(5));
+        }
+    }
+}
+
+TEST_CASE("Adding locations updates bounding box of way") {
+    index_type index_pos;
+    fill_index(index_pos);
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    {
+        osmium::builder::WayBuilder builder{buffer};
+        builder.set_id(1);
+        builder.add_node_refs({{5}, {2}, {9}});
+        builder.add_item(osmium::BoundingBox{});
+    }
+    buffer.commit();
+
+    auto& way = buffer.get<osmium::Way>(0);
+    REQUIRE(way.bounding_box());
+    REQUIRE_FALSE(way.bounding_box()->box().valid());
+
+    osmium::thread::Pool pool{2};
+    REQUIRE(osmium::index::add_locations_to_ways(buffer, index_pos, index_pos, pool) == 0);
+
+    REQUIRE(way.bounding_box()->box().valid());
+    REQUIRE(way.bounding_box()->box().bottom_left() == location_for(2));
+    REQUIRE(way.bounding_box()->box().top_right() == location_for(9));
+    REQUIRE(way.envelope() == way.nodes().envelope());
+}
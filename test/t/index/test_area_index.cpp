@@ -0,0 +1,141 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/area_index.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    // Square with a hole (area 2), a smaller square overlapping it
+    // (area 4), and a square far away (area 6).
+    void add_areas(osmium::memory::Buffer& buffer) {
+        osmium::builder::add_area(buffer, _id(2),
+            _outer_ring({
+                {1, {8.0, 49.0}},
+                {2, {9.0, 49.0}},
+                {3, {9.0, 50.0}},
+                {4, {8.0, 50.0}},
+                {1, {8.0, 49.0}}
+            }),
+            _inner_ring({
+                {5, {8.2, 49.2}},
+                {6, {8.2, 49.5}},
+                {7, {8.5, 49.5}},
+                {8, {8.5, 49.2}},
+                {5, {8.2, 49.2}}
+            })
+        );
+        osmium::builder::add_area(buffer, _id(4),
+            _outer_ring({
+                {10, {8.7, 49.7}},
+                {11, {9.5, 49.7}},
+                {12, {9.5, 50.5}},
+                {13, {8.7, 50.5}},
+                {10, {8.7, 49.7}}
+            })
+        );
+        osmium::builder::add_area(buffer, _id(6),
+            _outer_ring({
+                {20, {0.0, 0.0}},
+                {21, {1.0, 0.0}},
+                {22, {1.0, 1.0}},
+                {23, {0.0, 1.0}},
+                {20, {0.0, 0.0}}
+            })
+        );
+    }
+
+    std::vector<osmium::object_id_type> sorted(std::vector<osmium::object_id_type> values) {
+        std::sort(values.begin(), values.end());
+        return values;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Find areas containing locations") {
+    osmium::thread::Pool pool{2};
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    add_areas(buffer);
+
+    osmium::index::AreaIndex index;
+    REQUIRE(index.empty());
+    for (const auto& area : buffer.select<osmium::Area>()) {
+        REQUIRE(index.add(area));
+    }
+    REQUIRE(index.size() == 3);
+    REQUIRE_FALSE(index.finished());
+    index.finish(pool);
+    REQUIRE(index.finished());
+
+    using ids = std::vector<osmium::object_id_type>;
+    REQUIRE(index.find(osmium::Location{8.1, 49.1}) == ids{2});
+    REQUIRE(index.find(osmium::Location{8.3, 49.3}).empty());
+    REQUIRE(sorted(index.find(osmium::Location{8.8, 49.8})) == (ids{2, 4}));
+    REQUIRE(index.find(osmium::Location{9.2, 50.2}) == ids{4});
+    REQUIRE(index.find(osmium::Location{0.5, 0.5}) == ids{6});
+    REQUIRE(index.find(osmium::Location{-0.5, 0.5}).empty());
+    REQUIRE(index.find(osmium::Location{}).empty());
+}
+
+TEST_CASE("Area index ignores areas without valid geometry") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_area(buffer, _id(8),
+        _outer_ring({
+            {1, {8.0, 49.0}},
+            {2, {9.0, 49.0}},
+            {1, {8.0, 49.0}}
+        })
+    );
+
+    osmium::index::AreaIndex index;
+    REQUIRE_FALSE(index.add(buffer.get<osmium::Area>(0)));
+    REQUIRE(index.empty());
+    index.finish();
+    REQUIRE(index.find(osmium::Location{8.5, 49.0}).empty());
+}
+
+TEST_CASE("Spatial join of nodes and ways with areas") {
+    osmium::thread::Pool pool{3};
+    osmium::memory::Buffer areas{10240, osmium::memory::Buffer::auto_grow::yes};
+    add_areas(areas);
+
+    osmium::index::AreaIndex index;
+    for (const auto& area : areas.select<osmium::Area>()) {
+        index.add(area, area.id() * 10);
+    }
+    index.finish(pool);
+
+    // Many nodes, so that the join uses several tasks.
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 0; i < 3000; ++i) {
+        osmium::builder::add_node(buffer, _id(i), _location(8.05 + (i % 3) * 0.4, 49.3));
+    }
+    osmium::builder::add_way(buffer, _id(1), _nodes({
+        {1, {0.2, 0.2}},
+        {2, {0.8, 0.8}}
+    }));
+    osmium::builder::add_way(buffer, _id(2), _nodes({1, 2}));
+
+    std::vector<std::pair<osmium::object_id_type, osmium::object_id_type>> result;
+    const auto count = osmium::index::spatial_join(index, buffer, [&](const osmium::OSMObject& object, osmium::object_id_type area) {
+        result.emplace_back(object.type() == osmium::item_type::way ? -object.id() : object.id(), area);
+    }, pool);
+
+    // Nodes at x=8.05 and 8.85 are in area 2, nodes at 8.45 are in the hole.
+    REQUIRE(count == 2001);
+    REQUIRE(result.size() == 2001);
+    REQUIRE(result[0] == std::make_pair(osmium::object_id_type{0}, osmium::object_id_type{20}));
+    REQUIRE(result[1] == std::make_pair(osmium::object_id_type{2}, osmium::object_id_type{20}));
+    REQUIRE(result[1999] == std::make_pair(osmium::object_id_type{2999}, osmium::object_id_type{20}));
+    REQUIRE(result[2000] == std::make_pair(osmium::object_id_type{-1}, osmium::object_id_type{60}));
+}
@@ -0,0 +1,122 @@
+#include "catch.hpp"
+
+#include <osmium/index/concurrent_id_set.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+using id_set_type = osmium::index::ConcurrentIdSetDense<osmium::unsigned_object_id_type>;
+
+TEST_CASE("Basic functionality of ConcurrentIdSetDense") {
+    id_set_type s{1000};
+
+    REQUIRE(s.max_size() >= 1000);
+    REQUIRE(s.empty());
+    REQUIRE(s.size() == 0); // NOLINT(readability-container-size-empty)
+    REQUIRE(s.used_memory() < 1024);
+    REQUIRE_FALSE(s.get(17));
+
+    s.set(17);
+    REQUIRE(s.get(17));
+    REQUIRE_FALSE(s.get(18));
+    REQUIRE(s.size() == 1);
+
+    REQUIRE(s.check_and_set(63));
+    REQUIRE(s.check_and_set(64));
+    REQUIRE_FALSE(s.check_and_set(17));
+    REQUIRE_FALSE(s.check_and_set(64));
+    REQUIRE(s.size() == 3);
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    s.for_each([&ids](osmium::unsigned_object_id_type id) {
+        ids.push_back(id);
+    });
+    REQUIRE(ids == std::vector<osmium::unsigned_object_id_type>({17, 63, 64}));
+
+    REQUIRE_FALSE(s.get(s.max_size()));
+    REQUIRE_FALSE(s.get(s.max_size() * 10));
+    REQUIRE_THROWS_AS(s.set(s.max_size()), std::out_of_range);
+
+    s.clear();
+    REQUIRE(s.empty());
+    REQUIRE_FALSE(s.get(17));
+    REQUIRE(s.max_size() >= 1000);
+}
+
+TEST_CASE("Resize ConcurrentIdSetDense") {
+    osmium::index::ConcurrentIdSetDense<uint32_t, 3> s{10};
+    REQUIRE(s.max_size() == 64);
+
+    s.set(5);
+    REQUIRE_THROWS_AS(s.set(64), std::out_of_range);
+
+    s.resize(1000);
+    REQUIRE(s.max_size() == 1024);
+    REQUIRE(s.get(5));
+    s.set(999);
+    REQUIRE(s.get(999));
+    REQUIRE(s.size() == 2);
+
+    // Resize never shrinks the set.
+    s.resize(10);
+    REQUIRE(s.max_size() == 1024);
+    REQUIRE(s.get(999));
+
+    osmium::index::ConcurrentIdSetDense<uint32_t, 3> moved{std::move(s)};
+    REQUIRE(moved.get(999));
+    REQUIRE(moved.size() == 2);
+}
+
+TEST_CASE("Convert ConcurrentIdSetDense to IdSetDense") {
+    osmium::index::ConcurrentIdSetDense<osmium::unsigned_object_id_type, 8> s{100000};
+    for (osmium::unsigned_object_id_type id = 3; id < 100000; id += 7) {
+        s.set(id);
+    }
+
+    const auto dense = s.to_id_set_dense();
+    REQUIRE(dense.size() == s.size());
+    auto it = dense.begin();
+    s.for_each([&it](osmium::unsigned_object_id_type id) {
+        REQUIRE(*it == id);
+        ++it;
+    });
+    REQUIRE(it == dense.end());
+}
+
+TEST_CASE("Fill ConcurrentIdSetDense from several threads") {
+    osmium::thread::Pool pool{4};
+
+    // Small chunks, so that many chunks are allocated concurrently.
+    osmium::index::ConcurrentIdSetDense<osmium::unsigned_object_id_type, 6> s{1000000};
+    std::atomic<std::size_t> added{0};
+
+    // All tasks set the same Ids (in different orders), each Id must
+    // be added exactly once.
+    std::vector<std::future<void>> futures;
+    for (int task = 0; task < 8; ++task) {
+        futures.push_back(pool.submit([&s, &added, task] {
+            std::size_t count = 0;
+            for (osmium::unsigned_object_id_type n = 0; n < 200000; ++n) {
+                const osmium::unsigned_object_id_type id = (task % 2 == 0) ? n * 5 : (199999 - n) * 5;
+                if (s.check_and_set(id)) {
+                    ++count;
+                }
+            }
+            added += count;
+        }));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    REQUIRE(added == 200000);
+    REQUIRE(s.size() == 200000);
+    REQUIRE(s.get(0));
+    REQUIRE(s.get(999995));
+    REQUIRE_FALSE(s.get(999996));
+}
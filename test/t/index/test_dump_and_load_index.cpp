@@ -6,6 +6,7 @@
 #include <osmium/index/map/dense_mmap_array.hpp>
 #include <osmium/index/map/sparse_file_array.hpp>
 #include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_map_flat.hpp>
 #include <osmium/index/map/sparse_mmap_array.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/types.hpp>
@@ -82,3 +83,10 @@ TEST_CASE("Dump SparseMemArray, load as SparseFileArray") {
     auto dump_method = [](sparse_mem_array& index, const int fd) { index.dump_as_list(fd);};
     test_index<sparse_mem_array, sparse_file_array>(dump_method);
 }
+
+using sparse_mem_map_flat = osmium::index::map::SparseMemMapFlat<osmium::unsigned_object_id_type, osmium::Location>;
+
+TEST_CASE("Dump SparseMemMapFlat, load as SparseFileArray") {
+    auto dump_method = [](sparse_mem_map_flat& index, const int fd) { index.dump_as_list(fd);};
+    test_index<sparse_mem_map_flat, sparse_file_array>(dump_method);
+}
@@ -0,0 +1,99 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/external_sort.hpp>
+#include <osmium/index/map/sparse_file_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <utility>
+#include <vector>
+
+static std::vector<std::pair<uint64_t, uint32_t>> random_data(std::size_t size) {
+    std::mt19937 gen{17}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    std::uniform_int_distribution<uint64_t> dist{0, size / 2};
+    std::vector<std::pair<uint64_t, uint32_t>> data;
+    data.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data.emplace_back(dist(gen), static_cast<uint32_t>(i));
+    }
+    return data;
+}
+
+TEST_CASE("External sort with different memory budgets") {
+    osmium::thread::Pool pool{2};
+    using value_type = std::pair<uint64_t, uint32_t>;
+
+    for (const std::size_t size : {0, 1, 2, 100, 1000, 12345}) {
+        const auto data = random_data(size);
+        auto expected = data;
+        std::sort(expected.begin(), expected.end());
+
+        for (const std::size_t elements : {1, 2, 7, 100, 1000, 20000}) {
+            auto result = data;
+            osmium::index::detail::external_sort(result.begin(), result.end(), elements * sizeof(value_type), pool);
+            REQUIRE(result == expected);
+        }
+    }
+}
+
+TEST_CASE("External sort with compare function") {
+    osmium::thread::Pool pool{2};
+
+    auto data = random_data(5000);
+    auto expected = data;
+    std::sort(expected.begin(), expected.end(), std::greater<std::pair<uint64_t, uint32_t>>{});
+
+    osmium::index::detail::external_sort(data.begin(), data.end(), 1000, pool, std::greater<std::pair<uint64_t, uint32_t>>{});
+    REQUIRE(data == expected);
+}
+
+template <typename TIndex>
+static void check_sparse_map_with_budget(TIndex& index) {
+    const std::size_t size = 10000;
+    for (std::size_t i = 0; i < size; ++i) {
+        const osmium::unsigned_object_id_type id = (i * 7919) % size;
+        index.set(id, osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(id % 100)});
+    }
+
+    REQUIRE(index.sort_memory_budget() == 0);
+    index.set_sort_memory_budget(1000 * sizeof(typename TIndex::element_type));
+    REQUIRE(index.byte_size() > index.sort_memory_budget());
+
+    index.sort();
+
+    REQUIRE(std::is_sorted(index.cbegin(), index.cend()));
+    for (osmium::unsigned_object_id_type id = 0; id < size; ++id) {
+        REQUIRE(index.get(id) == osmium::Location(static_cast<int32_t>(id), static_cast<int32_t>(id % 100)));
+    }
+    REQUIRE(index.get_noexcept(size) == osmium::Location{});
+}
+
+TEST_CASE("SparseMemArray sorted externally") {
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    check_sparse_map_with_budget(index);
+}
+
+TEST_CASE("SparseFileArray sorted externally") {
+    osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    check_sparse_map_with_budget(index);
+}
+
+TEST_CASE("SparseMemArray sorted externally using pool") {
+    osmium::thread::Pool pool{3};
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    for (osmium::unsigned_object_id_type id = 500; id > 0; --id) {
+        index.set(id, osmium::Location{static_cast<int32_t>(id), 1});
+    }
+    index.set_sort_memory_budget(64 * sizeof(std::pair<osmium::unsigned_object_id_type, osmium::Location>));
+    index.sort(pool);
+
+    REQUIRE(std::is_sorted(index.cbegin(), index.cend()));
+    REQUIRE(index.get(1) == osmium::Location(1, 1));
+    REQUIRE(index.get(500) == osmium::Location(500, 1));
+}
@@ -0,0 +1,73 @@
+#include "catch.hpp"
+
+#include <osmium/index/id_count.hpp>
+
+#include <vector>
+
+TEST_CASE("IdCountDense counts up to two") {
+    osmium::index::IdCountDense<osmium::unsigned_object_id_type> counter;
+
+    REQUIRE(counter.get(17) == 0);
+    REQUIRE_FALSE(counter.multiple(17));
+    REQUIRE(counter.count_multiple() == 0);
+
+    counter.add(17);
+    REQUIRE(counter.get(17) == 1);
+    REQUIRE_FALSE(counter.multiple(17));
+    REQUIRE(counter.get(16) == 0);
+    REQUIRE(counter.get(18) == 0);
+
+    counter.add(17);
+    REQUIRE(counter.get(17) == 2);
+    REQUIRE(counter.multiple(17));
+
+    counter.add(17);
+    REQUIRE(counter.get(17) == 2);
+    REQUIRE(counter.count_multiple() == 1);
+
+    counter.clear();
+    REQUIRE(counter.get(17) == 0);
+}
+
+TEST_CASE("IdCountDense with small chunks and large IDs") {
+    osmium::index::IdCountDense<osmium::unsigned_object_id_type, 3> counter;
+
+    const std::vector<osmium::unsigned_object_id_type> ids{0, 31, 32, 33, 63, 64, 1000, 123456789};
+    for (const auto id : ids) {
+        counter.add(id);
+        counter.add(id);
+    }
+    counter.add(5);
+    counter.add(100000);
+
+    REQUIRE(counter.count_multiple() == ids.size());
+    REQUIRE(counter.get(5) == 1);
+    REQUIRE(counter.get(100000) == 1);
+
+    std::vector<osmium::unsigned_object_id_type> result;
+    counter.for_each_multiple([&result](osmium::unsigned_object_id_type id) {
+        result.push_back(id);
+    });
+    REQUIRE(result == ids);
+    REQUIRE(counter.used_memory() > 0);
+}
+
+TEST_CASE("Merge IdCountDense") {
+    osmium::index::IdCountDense<osmium::unsigned_object_id_type, 3> a;
+    osmium::index::IdCountDense<osmium::unsigned_object_id_type, 3> b;
+
+    a.add(1);
+    a.add(2);
+    a.add(2);
+    b.add(1);
+    b.add(3);
+    b.add(1000);
+
+    a.merge(b);
+    REQUIRE(a.get(1) == 2);
+    REQUIRE(a.get(2) == 2);
+    REQUIRE(a.get(3) == 1);
+    REQUIRE(a.get(1000) == 1);
+    REQUIRE(a.get(4) == 0);
+    REQUIRE(a.count_multiple() == 2);
+}
@@ -0,0 +1,92 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/mmap_vector_file.hpp>
+#include <osmium/index/id_renumber_map.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/io/detail/read_write.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("ID renumber map with sorted IDs") {
+    osmium::index::IdRenumberMap<> map;
+    REQUIRE(map.empty());
+
+    REQUIRE(map(-3) == 1);
+    REQUIRE(map(-7) == 2);
+    REQUIRE(map(5) == 3);
+    REQUIRE(map(10) == 4);
+    REQUIRE(map(5) == 3);
+    REQUIRE(map.size() == 4);
+    REQUIRE(map.num_unsorted() == 0);
+
+    REQUIRE(map.get(-7) == 2);
+    REQUIRE(map.get(10) == 4);
+    REQUIRE(map.get(7) == 0);
+    REQUIRE(map.size() == 4);
+
+    REQUIRE(map.old_id(1) == -3);
+    REQUIRE(map.old_id(4) == 10);
+    REQUIRE_THROWS_AS(map.old_id(0), std::out_of_range);
+    REQUIRE_THROWS_AS(map.old_id(5), std::out_of_range);
+}
+
+TEST_CASE("ID renumber map with unsorted IDs") {
+    osmium::index::IdRenumberMap<osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>> map{100};
+
+    REQUIRE(map(10) == 100);
+    REQUIRE(map(20) == 101);
+    REQUIRE(map(15) == 102);
+    REQUIRE(map(-1) == 103);
+    REQUIRE(map(30) == 104);
+    REQUIRE(map.num_unsorted() == 3);
+
+    REQUIRE(map(10) == 100);
+    REQUIRE(map(20) == 101);
+    REQUIRE(map(15) == 102);
+    REQUIRE(map(-1) == 103);
+    REQUIRE(map(30) == 104);
+    REQUIRE(map.get(25) == 0);
+    REQUIRE(map.get(-2) == 0);
+    REQUIRE(map.size() == 5);
+
+    REQUIRE(map.old_id(102) == 15);
+}
+
+TEST_CASE("ID renumber map start ID") {
+    REQUIRE_THROWS_AS(osmium::index::IdRenumberMap<>{0}, std::invalid_argument);
+
+    osmium::index::IdRenumberMap<> map;
+    map.set_start_id(1000);
+    REQUIRE(map(17) == 1000);
+    REQUIRE_THROWS_AS(map.set_start_id(1), std::logic_error);
+}
+
+TEST_CASE("ID renumber map write and read") {
+    osmium::index::IdRenumberMap<osmium::index::map::SparseMemMap<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>, osmium::detail::mmap_vector_file> map;
+    for (osmium::object_id_type id = 1; id < 300000; id += 3) {
+        map(id);
+    }
+    map(2);
+    map(-2);
+
+    const std::string filename{"test-id-renumber-map.data"};
+    const int wfd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    map.write(wfd);
+    osmium::io::detail::reliable_close(wfd);
+
+    osmium::index::IdRenumberMap<> map2;
+    const int rfd = osmium::io::detail::open_for_reading(filename);
+    map2.read(rfd);
+    osmium::io::detail::reliable_close(rfd);
+    std::remove(filename.c_str());
+
+    REQUIRE(map2.size() == map.size());
+    REQUIRE(map2.num_unsorted() == 2);
+    for (osmium::object_id_type id = 1; id <= static_cast<osmium::object_id_type>(map.size()); ++id) {
+        REQUIRE(map2.old_id(id) == map.old_id(id));
+        REQUIRE(map2.get(map.old_id(id)) == id);
+    }
+}
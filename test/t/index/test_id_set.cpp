@@ -2,6 +2,13 @@
 
 #include <osmium/index/id_set.hpp>
 #include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
 
 TEST_CASE("Basic functionality of IdSetDense") {
     osmium::index::IdSetDense<osmium::unsigned_object_id_type> s;
@@ -131,6 +138,143 @@ TEST_CASE("Large gap") {
     REQUIRE_FALSE(s.get(1U << 29U));
 }
 
+namespace {
+
+    // Small chunks so that there are lots of them.
+    using small_chunk_id_set = osmium::index::IdSetDense<osmium::unsigned_object_id_type, 4>;
+
+    std::set<osmium::unsigned_object_id_type> random_ids(unsigned int seed, std::size_t count, osmium::unsigned_object_id_type max) {
+        std::mt19937 gen{seed}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+        std::uniform_int_distribution<osmium::unsigned_object_id_type> dist{0, max};
+        std::set<osmium::unsigned_object_id_type> ids;
+        for (std::size_t i = 0; i < count; ++i) {
+            ids.insert(dist(gen));
+        }
+        // Leave some chunks empty.
+        for (auto it = ids.begin(); it != ids.end();) {
+            if ((*it / 128) % 7 == seed % 7) {
+                it = ids.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return ids;
+    }
+
+    small_chunk_id_set make_id_set(const std::set<osmium::unsigned_object_id_type>& ids) {
+        small_chunk_id_set s;
+        for (const auto id : ids) {
+            s.set(id);
+        }
+        return s;
+    }
+
+    void check_id_set(const small_chunk_id_set& s, const std::set<osmium::unsigned_object_id_type>& expected) {
+        REQUIRE(s.size() == expected.size());
+        const std::vector<osmium::unsigned_object_id_type> ids(s.begin(), s.end());
+        REQUIRE(ids == std::vector<osmium::unsigned_object_id_type>(expected.begin(), expected.end()));
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Iterate over IdSetDense") {
+    const auto ids = random_ids(1, 5000, 100000);
+    const auto s = make_id_set(ids);
+    check_id_set(s, ids);
+
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> s2;
+    s2.set(0);
+    s2.set(63);
+    s2.set(64);
+    s2.set(1ULL << 26U);
+    const std::vector<osmium::unsigned_object_id_type> ids2(s2.begin(), s2.end());
+    REQUIRE(ids2 == std::vector<osmium::unsigned_object_id_type>{0, 63, 64, 1ULL << 26U});
+}
+
+TEST_CASE("Check for any Id in range in IdSetDense") {
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> s;
+    REQUIRE_FALSE(s.contains_any(0, 1000));
+
+    s.set(100);
+    s.set(1ULL << 26U);
+
+    REQUIRE(s.contains_any(100, 100));
+    REQUIRE(s.contains_any(0, 100));
+    REQUIRE(s.contains_any(100, 1ULL << 40U));
+    REQUIRE_FALSE(s.contains_any(0, 99));
+    REQUIRE_FALSE(s.contains_any(101, (1ULL << 26U) - 1));
+    REQUIRE(s.contains_any(101, 1ULL << 26U));
+    REQUIRE_FALSE(s.contains_any((1ULL << 26U) + 1, 1ULL << 40U));
+    REQUIRE_FALSE(s.contains_any(200, 100));
+
+    const auto ids = random_ids(1, 5000, 100000);
+    const auto s2 = make_id_set(ids);
+    for (osmium::unsigned_object_id_type first = 0; first < 110000; first += 997) {
+        const auto last = first + 150;
+        const bool expected = std::any_of(ids.cbegin(), ids.cend(), [&](osmium::unsigned_object_id_type id) {
+            return id >= first && id <= last;
+        });
+        REQUIRE(s2.contains_any(first, last) == expected);
+    }
+}
+
+TEST_CASE("Set operations on IdSetDense") {
+    const auto ids_a = random_ids(1, 5000, 100000);
+    const auto ids_b = random_ids(2, 3000, 150000);
+
+    std::set<osmium::unsigned_object_id_type> expected;
+    auto a = make_id_set(ids_a);
+    const auto b = make_id_set(ids_b);
+
+    osmium::thread::Pool pool{3};
+
+    SECTION("union") {
+        std::set_union(ids_a.begin(), ids_a.end(), ids_b.begin(), ids_b.end(), std::inserter(expected, expected.end()));
+        a.set_union(b);
+    }
+
+    SECTION("union with pool") {
+        std::set_union(ids_a.begin(), ids_a.end(), ids_b.begin(), ids_b.end(), std::inserter(expected, expected.end()));
+        a.set_union(b, pool);
+    }
+
+    SECTION("union with empty set") {
+        expected = ids_a;
+        a.set_union(small_chunk_id_set{}, pool);
+    }
+
+    SECTION("intersection") {
+        std::set_intersection(ids_a.begin(), ids_a.end(), ids_b.begin(), ids_b.end(), std::inserter(expected, expected.end()));
+        REQUIRE(a.intersection_size(b) == expected.size());
+        a.set_intersection(b);
+    }
+
+    SECTION("intersection with pool") {
+        std::set_intersection(ids_a.begin(), ids_a.end(), ids_b.begin(), ids_b.end(), std::inserter(expected, expected.end()));
+        a.set_intersection(b, pool);
+        REQUIRE(a.used_memory() < b.used_memory());
+    }
+
+    SECTION("difference") {
+        std::set_difference(ids_a.begin(), ids_a.end(), ids_b.begin(), ids_b.end(), std::inserter(expected, expected.end()));
+        a.set_difference(b);
+    }
+
+    SECTION("difference with pool") {
+        std::set_difference(ids_a.begin(), ids_a.end(), ids_b.begin(), ids_b.end(), std::inserter(expected, expected.end()));
+        a.set_difference(b, pool);
+    }
+
+    SECTION("with itself") {
+        a.set_union(a);
+        a.set_intersection(a, pool);
+        check_id_set(a, ids_a);
+        a.set_difference(a);
+    }
+
+    check_id_set(a, expected);
+}
+
 TEST_CASE("Basic functionality of IdSetSmall") {
     osmium::index::IdSetSmall<osmium::unsigned_object_id_type> s;
 
@@ -0,0 +1,148 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/location_cache.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <cstring>
+
+template <typename TIndex>
+static void fill_index(TIndex& index) {
+    index.set(17, osmium::Location{1.2, 4.5});
+    index.set(3, osmium::Location{3.5, -7.2});
+    index.set(99, osmium::Location{-1.0, 2.0});
+}
+
+static void check_cache(const osmium::index::LocationCache& cache) {
+    REQUIRE(cache.size() == 3);
+    REQUIRE(cache.header().min_id == 3);
+    REQUIRE(cache.header().max_id == 99);
+    REQUIRE(cache.timestamp() == osmium::Timestamp{"2022-02-07T00:00:00Z"});
+    REQUIRE(cache.sequence_number() == 4711);
+    REQUIRE(cache.verify());
+
+    REQUIRE(cache.get(17) == osmium::Location(1.2, 4.5));
+    REQUIRE(cache.get(3) == osmium::Location(3.5, -7.2));
+    REQUIRE(cache.get(99) == osmium::Location(-1.0, 2.0));
+    REQUIRE(cache.get_noexcept(0) == osmium::Location{});
+    REQUIRE(cache.get_noexcept(18) == osmium::Location{});
+    REQUIRE(cache.get_noexcept(1000) == osmium::Location{});
+    REQUIRE_THROWS_AS(cache.get(4), osmium::not_found);
+}
+
+TEST_CASE("Location cache with dense encoding") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    fill_index(index);
+
+    const auto header = osmium::index::write_location_cache(fd, index, osmium::index::location_cache_encoding::dense_array,
+                                                            osmium::Timestamp{"2022-02-07T00:00:00Z"}, 4711);
+    REQUIRE(header.num_entries == 3);
+    REQUIRE(header.data_size == 100 * sizeof(osmium::Location));
+
+    osmium::index::LocationCache cache{fd};
+    REQUIRE(cache.encoding() == osmium::index::location_cache_encoding::dense_array);
+    check_cache(cache);
+
+    REQUIRE_THROWS_AS(cache.set(1, osmium::Location{}), std::runtime_error);
+
+    cache.clear();
+    REQUIRE(cache.get_noexcept(17) == osmium::Location{});
+}
+
+TEST_CASE("Location cache with sparse encoding") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    fill_index(index);
+
+    const auto header = osmium::index::write_location_cache(fd, index, osmium::index::location_cache_encoding::sparse_list,
+                                                            osmium::Timestamp{"2022-02-07T00:00:00Z"}, 4711);
+    REQUIRE(header.num_entries == 3);
+
+    const osmium::index::LocationCache cache{fd};
+    REQUIRE(cache.encoding() == osmium::index::location_cache_encoding::sparse_list);
+    check_cache(cache);
+}
+
+TEST_CASE("Location cache with damaged data") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    fill_index(index);
+    osmium::index::write_location_cache(fd, index, osmium::index::location_cache_encoding::sparse_list);
+
+    SECTION("changed data fails checksum") {
+        {
+            osmium::MemoryMapping mapping{osmium::file_size(fd), osmium::MemoryMapping::mapping_mode::write_shared, fd};
+            mapping.get_addr<char>()[4096 + 8] ^= 1;
+        }
+        const osmium::index::LocationCache cache{fd};
+        REQUIRE_FALSE(cache.verify());
+    }
+
+    SECTION("truncated file") {
+        osmium::resize_file(fd, osmium::file_size(fd) - 8);
+        REQUIRE_THROWS_AS(osmium::index::LocationCache{fd}, osmium::location_cache_error);
+    }
+
+    SECTION("wrong magic") {
+        {
+            osmium::MemoryMapping mapping{osmium::file_size(fd), osmium::MemoryMapping::mapping_mode::write_shared, fd};
+            std::memcpy(mapping.get_addr<char>(), "XXXX", 4);
+        }
+        REQUIRE_THROWS_WITH(osmium::index::LocationCache{fd}, "not a location cache file");
+    }
+
+    SECTION("file too small") {
+        osmium::resize_file(fd, 100);
+        REQUIRE_THROWS_AS(osmium::index::LocationCache{fd}, osmium::location_cache_error);
+    }
+}
+
+TEST_CASE("Update location cache in place") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    fill_index(index);
+    osmium::index::write_location_cache(fd, index, osmium::index::location_cache_encoding::dense_array);
+
+    {
+        osmium::index::LocationCache cache{fd, true};
+        cache.set(3, osmium::Location{});
+        cache.set(17, osmium::Location{5.0, 5.0});
+        cache.set(2000000, osmium::Location{6.0, 6.0});
+        cache.update_header(osmium::Timestamp{"2022-02-08T00:00:00Z"}, 4712);
+    }
+
+    const osmium::index::LocationCache cache{fd};
+    REQUIRE(cache.verify());
+    REQUIRE(cache.size() == 3);
+    REQUIRE(cache.header().max_id == 2000000);
+    REQUIRE(cache.sequence_number() == 4712);
+    REQUIRE(cache.get_noexcept(3) == osmium::Location{});
+    REQUIRE(cache.get(17) == osmium::Location(5.0, 5.0));
+    REQUIRE(cache.get(99) == osmium::Location(-1.0, 2.0));
+    REQUIRE(cache.get(2000000) == osmium::Location(6.0, 6.0));
+    REQUIRE(cache.get_noexcept(1999999) == osmium::Location{});
+}
+
+TEST_CASE("Update sparse location cache in place") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    fill_index(index);
+    osmium::index::write_location_cache(fd, index, osmium::index::location_cache_encoding::sparse_list);
+
+    osmium::index::LocationCache cache{fd, true};
+    cache.set(17, osmium::Location{5.0, 5.0});
+    REQUIRE(cache.get(17) == osmium::Location(5.0, 5.0));
+    REQUIRE_THROWS_AS(cache.set(18, osmium::Location{5.0, 5.0}), osmium::location_cache_error);
+}
@@ -0,0 +1,49 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/location_index_updater.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/visitor.hpp>
+
+using index_type = osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+static void check_update(const std::size_t batch_size) {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    index_type index;
+    index.set(1, osmium::Location{1.0, 1.0});
+    index.set(2, osmium::Location{2.0, 2.0});
+    index.set(3, osmium::Location{3.0, 3.0});
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(5), _version(1), _location(5.0, 5.0));
+    osmium::builder::add_node(buffer, _id(2), _version(2), _location(2.5, 2.5));
+    osmium::builder::add_node(buffer, _id(3), _version(2), _deleted());
+    osmium::builder::add_node(buffer, _id(2), _version(3), _location(2.7, 2.7));
+    osmium::builder::add_node(buffer, _id(-4), _version(1), _location(4.0, 4.0));
+
+    osmium::index::LocationIndexUpdater updater{index, batch_size};
+    osmium::apply(buffer, updater);
+    updater.flush();
+
+    REQUIRE(updater.count_changed() == 3);
+    REQUIRE(updater.count_deleted() == 1);
+
+    REQUIRE(index.get(1) == osmium::Location(1.0, 1.0));
+    REQUIRE(index.get(2) == osmium::Location(2.7, 2.7));
+    REQUIRE(index.get_noexcept(3) == osmium::Location{});
+    REQUIRE(index.get_noexcept(4) == osmium::Location{});
+    REQUIRE(index.get(5) == osmium::Location(5.0, 5.0));
+}
+
+TEST_CASE("Update location index with changes in one batch") {
+    check_update(100);
+}
+
+TEST_CASE("Update location index with changes in small batches") {
+    check_update(1);
+    check_update(2);
+}
@@ -0,0 +1,433 @@
+#include "catch.hpp"
+#include "id_to_location.hpp"
+
+#include <osmium/index/map/compressed_dense_mem_array.hpp>
+#include <osmium/index/map/compressed_sparse_mem_array.hpp>
+#include <osmium/index/map/dense_file_array.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/dense_mmap_array.hpp>
+#include <osmium/index/map/sparse_file_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_map.hpp>
+#include <osmium/index/map/sparse_mem_map_flat.hpp>
+#include <osmium/index/map/sparse_mmap_array.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+template <typename TIndex>
+void test_func_get_many(TIndex& index) {
+    for (osmium::unsigned_object_id_type id = 1; id < 100; id += 2) {
+        index.set(id, osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(id) * 2});
+    }
+
+    index.sort();
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 99; id < 200; id -= 3) {
+        ids.push_back(id);
+    }
+    std::vector<osmium::Location> locations(ids.size());
+
+    index.get_many(ids.data(), 0, locations.data());
+    index.get_many(ids.data(), 3, locations.data());
+    REQUIRE(locations[0] == osmium::Location{99, 198});
+    REQUIRE(locations[1] == osmium::Location{});
+    REQUIRE(locations[2] == osmium::Location{93, 186});
+
+    index.get_many(ids.data(), ids.size(), locations.data());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        REQUIRE(locations[i] == index.get_noexcept(ids[i]));
+    }
+}
+
+template <typename TIndex>
+void test_func_set_concurrent(TIndex& index) {
+    REQUIRE_FALSE(index.set_concurrent(10, osmium::Location{1.0, 2.0}));
+
+    index.resize(4000);
+    REQUIRE(index.size() == 4000);
+
+    // Catch assertions are not thread-safe, so only count failures here.
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&index, &failures, t] {
+            for (int i = t; i < 4000; i += 8) {
+                if (!index.set_concurrent(i, osmium::Location{i, t})) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(failures == 0);
+
+    REQUIRE(index.size() == 4000);
+    for (int i = 0; i < 4000; ++i) {
+        if (i % 8 < 4) {
+            REQUIRE(index.get(i) == osmium::Location(i, i % 8));
+        } else {
+            REQUIRE_FALSE(index.get_noexcept(i));
+        }
+    }
+}
+
+TEST_CASE("Map Id to location: DenseMemArray set_concurrent") {
+    using index_type = osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index;
+    test_func_set_concurrent<index_type>(index);
+}
+
+#ifdef __linux__
+TEST_CASE("Map Id to location: DenseMmapArray set_concurrent") {
+    using index_type = osmium::index::map::DenseMmapArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index;
+    test_func_set_concurrent<index_type>(index);
+}
+#endif
+
+#ifdef __linux__
+template <typename TIndex>
+void test_func_sparse_search(TIndex& index, osmium::unsigned_object_id_type num) {
+    for (osmium::unsigned_object_id_type n = num; n > 0; --n) {
+        index.set(n * 2 + 3, osmium::Location(static_cast<int32_t>(n), 1));
+    }
+    index.sort();
+
+    REQUIRE(index.size() == num);
+    for (osmium::unsigned_object_id_type id = 0; id < num * 2 + 10; ++id) {
+        if (id >= 5 && id <= num * 2 + 3 && id % 2 == 1) {
+            REQUIRE(index.get(id) == osmium::Location(static_cast<int32_t>((id - 3) / 2), 1));
+        } else {
+            REQUIRE_FALSE(index.get_noexcept(id));
+        }
+    }
+
+    // set() after sort() needs another sort()
+    index.set(4, osmium::Location{4, 4});
+    index.sort();
+    REQUIRE(index.get(4) == osmium::Location(4, 4));
+    if (num > 0) {
+        REQUIRE(index.get(num * 2 + 3) == osmium::Location(static_cast<int32_t>(num), 1));
+    }
+}
+
+TEST_CASE("Map Id to location: SparseMemArray search at block boundaries") {
+    using index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    for (osmium::unsigned_object_id_type num : {0, 1, 2, 15, 16, 17, 31, 32, 33, 255, 256, 257, 1000, 10000}) {
+        index_type index;
+        test_func_sparse_search(index, num);
+    }
+}
+
+TEST_CASE("Map Id to location: SparseMemArray with duplicate ids") {
+    using index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index;
+    for (osmium::unsigned_object_id_type id = 0; id < 100; ++id) {
+        index.set(id < 10 ? id : 10, osmium::Location(static_cast<int32_t>(id), 1));
+    }
+    index.sort();
+
+    // the first of the duplicate entries is found
+    REQUIRE(index.get(10) == osmium::Location(10, 1));
+    REQUIRE(index.get(9) == osmium::Location(9, 1));
+    REQUIRE_FALSE(index.get_noexcept(11));
+}
+
+TEST_CASE("Map Id to location: SparseMemArray with Bloom filter") {
+    using index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    for (osmium::unsigned_object_id_type num : {0, 1, 2, 17, 1000, 10000}) {
+        index_type index;
+        index.set_bloom_filter_bits(8);
+        test_func_sparse_search(index, num);
+    }
+}
+
+TEST_CASE("Map Id to location: Bloom filter statistics") {
+    using index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index;
+    REQUIRE(index.bloom_filter_bits() == 0);
+    index.set_bloom_filter_bits(8);
+    REQUIRE(index.bloom_filter_bits() == 8);
+
+    for (osmium::unsigned_object_id_type id = 2; id <= 20000; id += 2) {
+        index.set(id, osmium::Location(static_cast<int32_t>(id), 1));
+    }
+    index.sort();
+
+    const auto empty_stats = index.bloom_filter_stats();
+    REQUIRE(empty_stats.rejected == 0);
+    REQUIRE(empty_stats.false_positives == 0);
+    REQUIRE(empty_stats.false_positive_rate() == Approx(0.0));
+    REQUIRE(empty_stats.bytes >= 10000);
+    REQUIRE(index.used_memory() >= 10000 * sizeof(index_type::element_type) + empty_stats.bytes);
+
+    for (osmium::unsigned_object_id_type id = 1; id <= 20001; ++id) {
+        if (id % 2 == 0) {
+            REQUIRE(index.get_noexcept(id) == osmium::Location(static_cast<int32_t>(id), 1));
+        } else {
+            REQUIRE_FALSE(index.get_noexcept(id));
+        }
+    }
+
+    const auto stats = index.bloom_filter_stats();
+    REQUIRE(stats.rejected + stats.false_positives == 10001);
+    REQUIRE(stats.false_positive_rate() < 0.1);
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type n = 0; n < 10000; ++n) {
+        ids.push_back(30001 - n * 3);
+    }
+    std::vector<osmium::Location> values(ids.size());
+    index.get_many(ids.data(), ids.size(), values.data());
+    uint64_t missing = 0;
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        if (!values[i]) {
+            ++missing;
+        }
+    }
+    const auto many_stats = index.bloom_filter_stats();
+    REQUIRE(many_stats.rejected + many_stats.false_positives == 10001 + missing);
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        REQUIRE(values[i] == index.get_noexcept(ids[i]));
+    }
+
+    const std::string metrics = osmium::io::to_prometheus(stats);
+    REQUIRE(metrics.find("osmium_bloom_filter_lookups_total{result=\"rejected\"} " + std::to_string(stats.rejected) + "\n") != std::string::npos);
+    REQUIRE(metrics.find("osmium_bloom_filter_false_positive_rate ") != std::string::npos);
+
+    // set() after sort() removes the filter until the next sort()
+    index.set(3, osmium::Location{3, 3});
+    REQUIRE(index.bloom_filter_stats().bytes == 0);
+    index.sort();
+    REQUIRE(index.get(3) == osmium::Location(3, 3));
+    REQUIRE_THROWS_AS(index.get(5), osmium::not_found);
+}
+#endif
+
+TEST_CASE("Map Id to location: CompressedDenseMemArray") {
+    using index_type = osmium::index::map::CompressedDenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+
+    REQUIRE(0 == index1.size());
+
+    test_func_all<index_type>(index1);
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
+TEST_CASE("Map Id to location: CompressedDenseMemArray with many entries") {
+    using index_type = osmium::index::map::CompressedDenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    const auto location = [](osmium::unsigned_object_id_type id) {
+        return osmium::Location{static_cast<int32_t>(id * 7) - 1800000000,
+                                static_cast<int32_t>(id % 1000) * 3 - 900000000};
+    };
+
+    const auto in_index = [](osmium::unsigned_object_id_type id) {
+        return id >= 10 && id < 100000 && (id - 10) % 3 == 0 && (id < 30000 || id > 60000);
+    };
+
+    index_type index;
+
+    SECTION("sorted input") {
+        for (osmium::unsigned_object_id_type id = 10; id < 100000; ++id) {
+            if (in_index(id)) {
+                index.set(id, location(id));
+            }
+        }
+    }
+
+    SECTION("unsorted input") {
+        for (osmium::unsigned_object_id_type id = 99999; id > 0; --id) {
+            if (in_index(id)) {
+                index.set(id, location(id));
+            }
+        }
+    }
+
+    index.sort();
+
+    REQUIRE(index.used_memory() < 23333 * 8 / 2);
+
+    for (osmium::unsigned_object_id_type id = 0; id < 200000; ++id) {
+        if (in_index(id)) {
+            REQUIRE(index.get(id) == location(id));
+        } else {
+            REQUIRE(index.get_noexcept(id) == osmium::Location{});
+        }
+    }
+}
+
+TEST_CASE("Map Id to location: CompressedSparseMemArray") {
+    using index_type = osmium::index::map::CompressedSparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+
+    REQUIRE(0 == index1.size());
+
+    test_func_all<index_type>(index1);
+
+    REQUIRE(2 == index1.size());
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
+TEST_CASE("Map Id to location: CompressedSparseMemArray with many entries") {
+    using index_type = osmium::index::map::CompressedSparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    const auto location = [](osmium::unsigned_object_id_type id) {
+        return osmium::Location{static_cast<int32_t>(id * 7919 % 3600000000ULL) - 1800000000,
+                                static_cast<int32_t>(id * 104729 % 1800000000ULL) - 900000000};
+    };
+
+    index_type index;
+
+    SECTION("sorted input") {
+        for (osmium::unsigned_object_id_type id = 10; id < 100000; id += 3) {
+            index.set(id, location(id));
+        }
+    }
+
+    SECTION("unsorted input") {
+        for (osmium::unsigned_object_id_type id = 99997; id >= 10; id -= 3) {
+            index.set(id, location(id));
+        }
+    }
+
+    index.sort();
+
+    REQUIRE(index.size() == 33330);
+    REQUIRE(index.used_memory() < index.size() * 16 / 2);
+
+    for (osmium::unsigned_object_id_type id = 0; id < 100010; ++id) {
+        if (id >= 10 && id < 100000 && (id - 10) % 3 == 0) {
+            REQUIRE(index.get(id) == location(id));
+        } else {
+            REQUIRE(index.get_noexcept(id) == osmium::Location{});
+        }
+    }
+}
+
+TEST_CASE("Map Id to location: SparseMemMapFlat") {
+    using index_type = osmium::index::map::SparseMemMapFlat<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+
+    REQUIRE(0 == index1.size());
+    REQUIRE(0 == index1.used_memory());
+
+    test_func_all<index_type>(index1);
+
+    REQUIRE(2 == index1.size());
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
+TEST_CASE("Map Id to location: SparseMemMapFlat with many entries") {
+    using index_type = osmium::index::map::SparseMemMapFlat<osmium::unsigned_object_id_type, osmium::Location>;
+
+    const auto location = [](osmium::unsigned_object_id_type id) {
+        return osmium::Location{static_cast<int32_t>(id % 1000), static_cast<int32_t>(id / 1000)};
+    };
+
+    index_type index;
+
+    SECTION("sorted input") {
+        for (osmium::unsigned_object_id_type id = 10; id < 100000; id += 3) {
+            index.set(id, location(id));
+        }
+    }
+
+    SECTION("unsorted input") {
+        for (osmium::unsigned_object_id_type n = 0; n < 33330; ++n) {
+            const osmium::unsigned_object_id_type id = 10 + (n * 7919 % 33330) * 3;
+            index.set(id, location(id));
+        }
+    }
+
+    SECTION("reserved and with overwrites") {
+        index.reserve(33330);
+        const auto used_memory = index.used_memory();
+        for (osmium::unsigned_object_id_type id = 10; id < 100000; id += 3) {
+            index.set(id, osmium::Location{1, 1});
+        }
+        for (osmium::unsigned_object_id_type id = 10; id < 100000; id += 3) {
+            index.set(id, location(id));
+        }
+        REQUIRE(index.used_memory() == used_memory);
+    }
+
+    REQUIRE(index.size() == 33330);
+    REQUIRE(index.used_memory() < index.size() * 17 * 4);
+
+    for (osmium::unsigned_object_id_type id = 0; id < 100010; ++id) {
+        if (id >= 10 && id < 100000 && (id - 10) % 3 == 0) {
+            REQUIRE(index.get(id) == location(id));
+        } else {
+            REQUIRE(index.get_noexcept(id) == osmium::Location{});
+        }
+    }
+
+    index.clear();
+    REQUIRE(index.size() == 0);
+    REQUIRE_FALSE(index.get_noexcept(13));
+}
+
+TEST_CASE("Map Id to location: Dynamic map choice including compressed and flat maps") {
+    using map_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+
+    for (const auto& map_type_name : map_factory.map_types()) {
+        std::unique_ptr<map_type> index1 = map_factory.create_map(map_type_name);
+        index1->reserve(1000);
+        test_func_all<map_type>(*index1);
+
+        std::unique_ptr<map_type> index2 = map_factory.create_map(map_type_name);
+        index2->reserve(1000);
+        test_func_real<map_type>(*index2);
+
+        std::unique_ptr<map_type> index3 = map_factory.create_map(map_type_name);
+        index3->reserve(1000);
+        test_func_get_many<map_type>(*index3);
+    }
+}
+
+TEST_CASE("Map Id to location: Dynamic map choice with options") {
+    using map_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+
+#ifdef __linux__
+    std::unique_ptr<map_type> index1 = map_factory.create_map("dense_mmap_array,hugepages,random");
+    test_func_real<map_type>(*index1);
+
+    std::unique_ptr<map_type> index2 = map_factory.create_map("sparse_mmap_array,sequential");
+    test_func_real<map_type>(*index2);
+
+    REQUIRE_THROWS_AS(map_factory.create_map("dense_mmap_array,foo"), osmium::map_factory_error);
+    REQUIRE_THROWS_WITH(map_factory.create_map("dense_mmap_array,foo"), "Unknown map option 'foo'");
+#endif
+
+    REQUIRE_THROWS_AS(map_factory.create_map("dense_file_array,test_id_to_location.idx,bar"), osmium::map_factory_error);
+}
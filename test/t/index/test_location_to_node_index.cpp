@@ -0,0 +1,280 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/haversine.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/location_to_node_index.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using result_type = std::vector<std::pair<osmium::object_id_type, osmium::Location>>;
+
+namespace {
+
+    class NodeSource {
+
+        std::vector<osmium::memory::Buffer> m_buffers;
+        std::size_t m_next = 0;
+
+    public:
+
+        NodeSource(const std::vector<osmium::Location>& locations, std::size_t per_buffer) {
+            osmium::object_id_type id = 1;
+            while (static_cast<std::size_t>(id) <= locations.size()) {
+                osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+                for (std::size_t n = 0; n < per_buffer && static_cast<std::size_t>(id) <= locations.size(); ++n, ++id) {
+                    osmium::builder::add_node(buffer, _id(id), _location(locations[static_cast<std::size_t>(id) - 1]));
+                }
+                m_buffers.push_back(std::move(buffer));
+            }
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_buffers.size()) {
+                return osmium::memory::Buffer{};
+            }
+            return std::move(m_buffers[m_next++]);
+        }
+
+    }; // class NodeSource
+
+    std::vector<osmium::Location> random_locations(std::size_t num, int32_t min_x, int32_t max_x, int32_t min_y, int32_t max_y) {
+        std::mt19937 gen{42}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+        std::uniform_int_distribution<int32_t> dist_x{min_x, max_x};
+        std::uniform_int_distribution<int32_t> dist_y{min_y, max_y};
+        std::vector<osmium::Location> locations;
+        for (std::size_t n = 0; n < num; ++n) {
+            locations.emplace_back(dist_x(gen), dist_y(gen));
+        }
+        return locations;
+    }
+
+    osmium::index::LocationToNodeIndex build_index(const std::vector<osmium::Location>& locations) {
+        osmium::index::LocationToNodeIndexBuilder builder;
+        osmium::object_id_type id = 1;
+        for (const auto& location : locations) {
+            builder.add(location, id++);
+        }
+        return builder.build();
+    }
+
+    result_type sorted(result_type result) {
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Morton code of location") {
+    const std::vector<osmium::Location> locations = {
+        osmium::Location{0, 0},
+        osmium::Location{1, 2},
+        osmium::Location{-1, -2},
+        osmium::Location{-1800000000, -900000000},
+        osmium::Location{1800000000, 900000000},
+        osmium::Location{13.3777, 52.5163}
+    };
+
+    for (const auto& location : locations) {
+        REQUIRE(osmium::index::detail::morton_location(osmium::index::detail::morton_code(location)) == location);
+    }
+
+    // The order along each axis is kept.
+    REQUIRE(osmium::index::detail::morton_code(osmium::Location{-1, 0}) < osmium::index::detail::morton_code(osmium::Location{0, 0}));
+    REQUIRE(osmium::index::detail::morton_code(osmium::Location{0, -1}) < osmium::index::detail::morton_code(osmium::Location{0, 0}));
+    REQUIRE(osmium::index::detail::morton_code(osmium::Location{5, 7}) < osmium::index::detail::morton_code(osmium::Location{6, 7}));
+}
+
+TEST_CASE("Next Morton code in box") {
+    std::mt19937 gen{17}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    std::uniform_int_distribution<int32_t> dist{0, 40};
+
+    for (int round = 0; round < 100; ++round) {
+        osmium::Box box;
+        box.extend(osmium::Location{dist(gen), dist(gen)});
+        box.extend(osmium::Location{dist(gen), dist(gen)});
+        const auto min = osmium::index::detail::morton_code(box.bottom_left());
+        const auto max = osmium::index::detail::morton_code(box.top_right());
+
+        for (uint64_t code = min + 1; code < max; ++code) {
+            if (box.contains(osmium::index::detail::morton_location(code))) {
+                continue;
+            }
+            uint64_t expected = code + 1;
+            while (!box.contains(osmium::index::detail::morton_location(expected))) {
+                ++expected;
+            }
+            REQUIRE(osmium::index::detail::morton_next_in_box(code, min, max) == expected);
+        }
+    }
+}
+
+TEST_CASE("Location to node index: exact lookup and duplicates") {
+    osmium::index::LocationToNodeIndexBuilder builder;
+    builder.add(osmium::Location{1.0, 2.0}, 17);
+    builder.add(osmium::Location{1.0, 2.0}, 3);
+    builder.add(osmium::Location{1.0, 2.0}, -5);
+    builder.add(osmium::Location{1.0, 2.0}, 3);
+    builder.add(osmium::Location{1.0, 2.0000001}, 4);
+    builder.add(osmium::Location{-1.0, -2.0}, 5);
+    builder.add(osmium::Location{}, 6);
+    REQUIRE(builder.size() == 6);
+
+    const auto index = builder.build();
+    REQUIRE(builder.size() == 0);
+    REQUIRE(index.size() == 5);
+
+    auto range = index.get(osmium::Location{1.0, 2.0});
+    REQUIRE(std::vector<osmium::object_id_type>(range.first, range.second) == (std::vector<osmium::object_id_type>{-5, 3, 17}));
+
+    range = index.get(osmium::Location{-1.0, -2.0});
+    REQUIRE(std::vector<osmium::object_id_type>(range.first, range.second) == (std::vector<osmium::object_id_type>{5}));
+
+    range = index.get(osmium::Location{1.0, 2.0000002});
+    REQUIRE(range.first == range.second);
+
+    range = index.get(osmium::Location{});
+    REQUIRE(range.first == range.second);
+
+    int count = 0;
+    index.for_each_duplicate([&](const osmium::Location& location, const osmium::object_id_type* first, const osmium::object_id_type* last) {
+        ++count;
+        REQUIRE(location == (osmium::Location{1.0, 2.0}));
+        REQUIRE(last - first == 3);
+    });
+    REQUIRE(count == 1);
+}
+
+TEST_CASE("Location to node index: box query") {
+    const auto locations = random_locations(10000, -1000000, 1000000, -1000000, 1000000);
+    const auto index = build_index(locations);
+    REQUIRE(index.size() == locations.size());
+
+    osmium::Box box;
+    box.extend(osmium::Location{-200000, -300000});
+    box.extend(osmium::Location{100000, 50000});
+
+    result_type expected;
+    for (std::size_t n = 0; n < locations.size(); ++n) {
+        if (box.contains(locations[n])) {
+            expected.emplace_back(static_cast<osmium::object_id_type>(n + 1), locations[n]);
+        }
+    }
+    REQUIRE_FALSE(expected.empty());
+
+    result_type result;
+    index.for_each_in_box(box, [&](const osmium::Location& location, osmium::object_id_type id) {
+        result.emplace_back(id, location);
+    });
+    REQUIRE(sorted(result) == expected);
+
+    result.clear();
+    index.for_each_in_box(osmium::Box{}, [&](const osmium::Location& location, osmium::object_id_type id) {
+        result.emplace_back(id, location);
+    });
+    REQUIRE(result.empty());
+}
+
+TEST_CASE("Location to node index: radius query") {
+    // Points around the antimeridian, part of them near the north pole.
+    auto locations = random_locations(5000, 1790000000, 1800000000, 0, 10000000);
+    auto more = random_locations(5000, -1800000000, -1790000000, 0, 10000000);
+    locations.insert(locations.end(), more.begin(), more.end());
+    more = random_locations(2000, -1800000000, 1800000000, 899000000, 900000000);
+    locations.insert(locations.end(), more.begin(), more.end());
+
+    const auto index = build_index(locations);
+
+    const std::vector<std::pair<osmium::Location, double>> queries = {
+        {osmium::Location{179.95, 0.5}, 20000.0},
+        {osmium::Location{-179.99, 0.1}, 5000.0},
+        {osmium::Location{179.5, 0.5}, 1000.0},
+        {osmium::Location{0.0, 89.95}, 15000.0},
+        {osmium::Location{180.0, 0.2}, 0.0}
+    };
+
+    std::size_t total = 0;
+    for (const auto& query : queries) {
+        result_type expected;
+        for (std::size_t n = 0; n < locations.size(); ++n) {
+            if (osmium::geom::haversine::distance(query.first, locations[n]) <= query.second) {
+                expected.emplace_back(static_cast<osmium::object_id_type>(n + 1), locations[n]);
+            }
+        }
+
+        result_type result;
+        index.for_each_within(query.first, query.second, [&](const osmium::Location& location, osmium::object_id_type id) {
+            result.emplace_back(id, location);
+        });
+        REQUIRE(sorted(result) == expected);
+        total += result.size();
+    }
+    REQUIRE(total > 100);
+}
+
+TEST_CASE("Location to node index: dump and load") {
+    const auto locations = random_locations(1000, -100, 100, -100, 100);
+    const auto index = build_index(locations);
+
+    const int fd = osmium::detail::create_tmp_file();
+    index.dump(fd);
+
+    const auto loaded = osmium::index::LocationToNodeIndex::load(fd);
+    REQUIRE(loaded.size() == index.size());
+
+    result_type a;
+    result_type b;
+    index.for_each([&](const osmium::Location& location, osmium::object_id_type id) {
+        a.emplace_back(id, location);
+    });
+    loaded.for_each([&](const osmium::Location& location, osmium::object_id_type id) {
+        b.emplace_back(id, location);
+    });
+    REQUIRE(a == b);
+
+    const auto range = loaded.get(locations[10]);
+    REQUIRE(std::find(range.first, range.second, 11) != range.second);
+
+    const int fd2 = osmium::detail::create_tmp_file();
+    REQUIRE_THROWS_AS(osmium::index::LocationToNodeIndex::load(fd2), osmium::location_to_node_index_error);
+}
+
+TEST_CASE("Location to node index: build in parallel") {
+    osmium::thread::Pool pool{4};
+
+    auto locations = random_locations(20000, -1000, 1000, -1000, 1000);
+    NodeSource source{locations, 500};
+    const auto index = osmium::index::build_location_to_node_index(source, pool);
+    REQUIRE(index.size() == locations.size());
+
+    std::size_t num_duplicates = 0;
+    index.for_each_duplicate([&](const osmium::Location& location, const osmium::object_id_type* first, const osmium::object_id_type* last) {
+        REQUIRE(std::is_sorted(first, last));
+        for (auto it = first; it != last; ++it) {
+            REQUIRE(locations[static_cast<std::size_t>(*it) - 1] == location);
+        }
+        num_duplicates += static_cast<std::size_t>(last - first);
+    });
+
+    std::sort(locations.begin(), locations.end());
+    std::size_t expected = 0;
+    for (auto it = locations.begin(); it != locations.end();) {
+        const auto next = std::upper_bound(it, locations.end(), *it);
+        if (next - it > 1) {
+            expected += static_cast<std::size_t>(next - it);
+        }
+        it = next;
+    }
+    REQUIRE(num_duplicates == expected);
+    REQUIRE(expected > 0);
+}
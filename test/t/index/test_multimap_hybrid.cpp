@@ -0,0 +1,124 @@
+#include "catch.hpp"
+
+#include <osmium/index/multimap/hybrid.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <utility>
+#include <vector>
+
+using id_type = osmium::unsigned_object_id_type;
+using element_type = std::pair<id_type, id_type>;
+
+namespace {
+
+    std::vector<element_type> random_elements(std::size_t count, std::mt19937& gen) {
+        std::uniform_int_distribution<id_type> dist{1, 50000};
+        std::vector<element_type> elements;
+        for (std::size_t n = 0; n < count; ++n) {
+            elements.emplace_back(dist(gen), dist(gen));
+        }
+        return elements;
+    }
+
+    template <typename TMap>
+    std::vector<id_type> values(TMap& map, id_type id) {
+        std::vector<id_type> result;
+        const auto range = map.get_all(id);
+        for (auto it = range.first; it != range.second; ++it) {
+            result.push_back(it->second);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<id_type> expected_values(const std::vector<element_type>& elements, id_type id) {
+        std::vector<id_type> result;
+        for (const auto& element : elements) {
+            if (element.first == id) {
+                result.push_back(element.second);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Parallel sort") {
+    osmium::thread::Pool pool{4};
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+
+    for (const std::size_t size : {0UL, 1UL, 1000UL, 300000UL}) {
+        auto elements = random_elements(size, gen);
+        auto expected = elements;
+        std::sort(expected.begin(), expected.end());
+
+        osmium::thread::sort(elements.begin(), elements.end(), pool);
+        REQUIRE(elements == expected);
+    }
+}
+
+template <typename TMap>
+void check_hybrid(TMap& map) {
+    osmium::thread::Pool pool{4};
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+
+    const auto bulk = random_elements(100000, gen);
+    map.unsorted_set_many(bulk.begin(), bulk.end());
+    map.sort(pool);
+    REQUIRE(map.size() == bulk.size());
+
+    auto all = bulk;
+    const auto extra = random_elements(1000, gen);
+    for (const auto& element : extra) {
+        map.set(element.first, element.second);
+        all.push_back(element);
+    }
+    REQUIRE(map.size() == all.size());
+
+    SECTION("consolidate") {
+        map.consolidate();
+    }
+
+    SECTION("consolidate with pool") {
+        map.consolidate(pool);
+    }
+
+    SECTION("remove and consolidate") {
+        map.remove(all.front().first, all.front().second);
+        map.remove(extra.front().first, extra.front().second);
+        all.erase(std::find(all.begin(), all.end(), extra.front()));
+        all.erase(all.begin());
+        map.consolidate(pool);
+    }
+
+    SECTION("unsorted elements and consolidate") {
+        const auto more = random_elements(1000, gen);
+        map.unsorted_set_many(more.begin(), more.end());
+        all.insert(all.end(), more.begin(), more.end());
+        map.consolidate();
+    }
+
+    REQUIRE(map.size() == all.size());
+    for (const auto& element : random_elements(100, gen)) {
+        REQUIRE(values(map, element.first) == expected_values(all, element.first));
+    }
+    for (const auto& element : extra) {
+        REQUIRE(values(map, element.first) == expected_values(all, element.first));
+    }
+}
+
+TEST_CASE("Hybrid multimap") {
+    osmium::index::multimap::Hybrid<id_type, id_type> map;
+    check_hybrid(map);
+}
+
+TEST_CASE("Hybrid multimap with main part in file") {
+    osmium::index::multimap::HybridFile<id_type, id_type> map;
+    check_hybrid(map);
+}
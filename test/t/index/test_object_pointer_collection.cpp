@@ -4,8 +4,11 @@
 #include <osmium/memory/buffer.hpp>
 #include <osmium/object_pointer_collection.hpp>
 #include <osmium/osm/object_comparisons.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/visitor.hpp>
 
+#include <algorithm>
+
 using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
 
 TEST_CASE("Create ObjectPointerCollection") {
@@ -82,3 +85,87 @@ TEST_CASE("Create ObjectPointerCollection") {
     REQUIRE(collection.empty());
 }
 
+
+TEST_CASE("ObjectPointerCollection sort by compact type/id/version keys") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_way(buffer, _id(2), _version(1));
+    osmium::builder::add_node(buffer, _id(3), _version(3));
+    osmium::builder::add_node(buffer, _id(-2), _version(1));
+    osmium::builder::add_node(buffer, _id(1), _version(4));
+    osmium::builder::add_node(buffer, _id(0), _version(1));
+    osmium::builder::add_node(buffer, _id(1), _version(2));
+    osmium::builder::add_node(buffer, _id(-5), _version(1));
+
+    osmium::ObjectPointerCollection collection;
+    osmium::apply(buffer, collection);
+
+    osmium::ObjectPointerCollection expected;
+    osmium::apply(buffer, expected);
+    expected.sort(osmium::object_order_type_id_version_without_timestamp{});
+
+    SECTION("single threaded") {
+        collection.sort_by_type_id_version();
+    }
+
+    SECTION("with thread pool") {
+        osmium::thread::Pool pool{2};
+        collection.sort_by_type_id_version(pool);
+    }
+
+    REQUIRE(std::equal(collection.cbegin(), collection.cend(), expected.cbegin(),
+                       [](const osmium::OSMObject& a, const osmium::OSMObject& b) {
+                           return &a == &b;
+                       }));
+
+    auto it = collection.cbegin();
+    REQUIRE(it->id() == 0);
+    ++it;
+    REQUIRE(it->id() == -2);
+    ++it;
+    REQUIRE(it->id() == -5);
+    ++it;
+    REQUIRE(it->id() == 1);
+    REQUIRE(it->version() == 2);
+    ++it;
+    REQUIRE(it->id() == 1);
+    REQUIRE(it->version() == 4);
+    ++it;
+    REQUIRE(it->id() == 3);
+    ++it;
+    REQUIRE(it->type() == osmium::item_type::way);
+}
+
+TEST_CASE("ObjectPointerCollection sort with thread pool") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    for (int i = 40000; i > 0; --i) {
+        osmium::builder::add_node(buffer, _id(i % 1000), _version(i));
+    }
+
+    osmium::ObjectPointerCollection collection;
+    osmium::apply(buffer, collection);
+    osmium::ObjectPointerCollection expected;
+    osmium::apply(buffer, expected);
+
+    const auto order_by_id = [](const osmium::OSMObject* a, const osmium::OSMObject* b) {
+        return a->id() < b->id();
+    };
+
+    osmium::thread::Pool pool{3};
+    collection.sort(order_by_id, pool);
+    expected.sort(order_by_id);
+
+    REQUIRE(std::equal(collection.cbegin(), collection.cend(), expected.cbegin(),
+                       [](const osmium::OSMObject& a, const osmium::OSMObject& b) {
+                           return &a == &b;
+                       }));
+
+    collection.sort_by_type_id_version(pool);
+    expected.sort(osmium::object_order_type_id_version_without_timestamp{});
+
+    REQUIRE(std::equal(collection.cbegin(), collection.cend(), expected.cbegin(),
+                       [](const osmium::OSMObject& a, const osmium::OSMObject& b) {
+                           return &a == &b;
+                       }));
+}
@@ -0,0 +1,135 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/packed_rtree.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/object_pointer_collection.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using value_type = osmium::index::PackedRTree::value_type;
+
+static std::vector<value_type> sorted_search(const osmium::index::PackedRTree& tree, const osmium::Box& box) {
+    auto result = tree.search(box);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+TEST_CASE("Empty packed R-tree") {
+    osmium::thread::Pool pool{2};
+    osmium::index::PackedRTree tree;
+    REQUIRE(tree.empty());
+    REQUIRE_FALSE(tree.finished());
+    tree.finish(pool);
+    REQUIRE(tree.finished());
+    REQUIRE(tree.search(osmium::Box{-180.0, -90.0, 180.0, 90.0}).empty());
+}
+
+TEST_CASE("Packed R-tree needs node size of at least 2") {
+    REQUIRE_THROWS_AS(osmium::index::PackedRTree{1}, std::invalid_argument);
+}
+
+TEST_CASE("Packed R-tree with single item") {
+    osmium::thread::Pool pool{2};
+    osmium::index::PackedRTree tree;
+    tree.add(osmium::Box{1.0, 1.0, 2.0, 2.0}, 42);
+    tree.finish(pool);
+
+    REQUIRE(tree.size() == 1);
+    REQUIRE(tree.search(osmium::Box{1.5, 1.5, 3.0, 3.0}) == std::vector<value_type>{42});
+    REQUIRE(tree.search(osmium::Box{2.0, 2.0, 3.0, 3.0}) == std::vector<value_type>{42});
+    REQUIRE(tree.search(osmium::Box{2.1, 2.1, 3.0, 3.0}).empty());
+    REQUIRE(tree.search(osmium::Box{}).empty());
+}
+
+TEST_CASE("Packed R-tree gives same results as brute force search") {
+    osmium::thread::Pool pool{4};
+    std::mt19937 gen{17}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    std::uniform_real_distribution<double> lon{-10.0, 10.0};
+    std::uniform_real_distribution<double> lat{-5.0, 5.0};
+    std::uniform_real_distribution<double> size{0.0, 0.5};
+
+    const std::size_t node_sizes[] = {2, 5, 16};
+    for (const std::size_t node_size : node_sizes) {
+        osmium::index::PackedRTree tree{node_size};
+
+        std::vector<osmium::Box> boxes;
+        for (value_type i = 0; i < 25000; ++i) {
+            const double x = lon(gen);
+            const double y = lat(gen);
+            boxes.emplace_back(x, y, x + size(gen), y + size(gen));
+            tree.add(boxes.back(), i);
+        }
+        tree.finish(pool);
+        REQUIRE(tree.size() == boxes.size());
+
+        const int fd = osmium::detail::create_tmp_file();
+        tree.dump(fd);
+        const auto loaded = osmium::index::PackedRTree::load(fd);
+        REQUIRE(loaded.finished());
+        REQUIRE(loaded.size() == boxes.size());
+        REQUIRE(loaded.node_size() == node_size);
+
+        for (int n = 0; n < 100; ++n) {
+            const double x = lon(gen);
+            const double y = lat(gen);
+            const osmium::Box query{x, y, x + size(gen) * 4, y + size(gen) * 4};
+
+            std::vector<value_type> expected;
+            for (value_type i = 0; i < boxes.size(); ++i) {
+                const auto& b = boxes[i];
+                if (b.bottom_left().x() <= query.top_right().x() && b.top_right().x() >= query.bottom_left().x() &&
+                    b.bottom_left().y() <= query.top_right().y() && b.top_right().y() >= query.bottom_left().y()) {
+                    expected.push_back(i);
+                }
+            }
+
+            REQUIRE(sorted_search(tree, query) == expected);
+            REQUIRE(sorted_search(loaded, query) == expected);
+        }
+    }
+}
+
+TEST_CASE("Loading invalid packed R-tree file throws") {
+    const int fd = osmium::detail::create_tmp_file();
+    const char data[40] = "This is not an R-tree file";
+    osmium::io::detail::reliable_write(fd, data, sizeof(data));
+    REQUIRE_THROWS_AS(osmium::index::PackedRTree::load(fd), osmium::rtree_error);
+}
+
+TEST_CASE("Packed R-tree over buffer and object pointer collection") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::thread::Pool pool{2};
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto n1 = osmium::builder::add_node(buffer, _id(1), _location(1.0, 1.0));
+    osmium::builder::add_node(buffer, _id(2), _location(5.0, 5.0));
+    osmium::builder::add_node(buffer, _id(3)); // no location, ignored
+    const auto w1 = osmium::builder::add_way(buffer, _id(1), _nodes({{1, {1.0, 1.0}}, {2, {3.0, 2.0}}}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({2, 3})); // no locations, ignored
+    osmium::builder::add_relation(buffer, _id(1), _member(osmium::item_type::way, 1));
+
+    osmium::index::PackedRTree tree;
+    REQUIRE(osmium::index::add_to_rtree(buffer, tree, pool) == 3);
+    tree.finish(pool);
+
+    REQUIRE(sorted_search(tree, osmium::Box{0.0, 0.0, 2.0, 2.0}) == std::vector<value_type>({n1, w1}));
+    REQUIRE(sorted_search(tree, osmium::Box{2.5, 1.5, 2.6, 1.6}) == std::vector<value_type>{w1});
+    REQUIRE(buffer.get<osmium::Way>(w1).id() == 1);
+
+    osmium::ObjectPointerCollection collection;
+    osmium::apply(buffer, collection);
+    REQUIRE(collection.size() == 6);
+
+    osmium::index::PackedRTree tree2;
+    REQUIRE(osmium::index::add_to_rtree(collection, tree2, pool) == 3);
+    tree2.finish(pool);
+    REQUIRE(sorted_search(tree2, osmium::Box{0.0, 0.0, 2.0, 2.0}) == std::vector<value_type>({0, 3}));
+}
@@ -0,0 +1,126 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/referential_integrity.hpp>
+#include <osmium/io/indexed_pbf_reader.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer create_data() {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+        if (id != 17 && id != 12345) {
+            osmium::builder::add_node(buffer, _id(id), _location(1.0, 2.0));
+        }
+    }
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _nodes({id * 10, id * 10 + 7}));
+    }
+    osmium::builder::add_way(buffer, _id(200), _nodes({12345, 12346}));
+    osmium::builder::add_relation(buffer, _id(1), _member(osmium::item_type::way, 5), _member(osmium::item_type::node, 17));
+    osmium::builder::add_relation(buffer, _id(2), _member(osmium::item_type::way, 300), _member(osmium::item_type::relation, 1));
+    osmium::builder::add_relation(buffer, _id(3), _member(osmium::item_type::relation, 4), _member(osmium::item_type::node, -5));
+    return buffer;
+}
+
+using referrer_list = std::vector<std::tuple<osmium::item_type, osmium::object_id_type, osmium::item_type, osmium::object_id_type>>;
+
+static const referrer_list expected_referrers = {
+    std::make_tuple(osmium::item_type::way, 1, osmium::item_type::node, 17),
+    std::make_tuple(osmium::item_type::way, 200, osmium::item_type::node, 12345),
+    std::make_tuple(osmium::item_type::relation, 1, osmium::item_type::node, 17),
+    std::make_tuple(osmium::item_type::relation, 2, osmium::item_type::way, 300),
+    std::make_tuple(osmium::item_type::relation, 3, osmium::item_type::relation, 4)
+};
+
+static void check_missing(const osmium::index::ReferentialIntegrityChecker& checker) {
+    const auto& nodes = checker.missing(osmium::item_type::node);
+    REQUIRE(nodes.size() == 2);
+    REQUIRE(nodes.get(17));
+    REQUIRE(nodes.get(12345));
+    const auto& ways = checker.missing(osmium::item_type::way);
+    REQUIRE(ways.size() == 1);
+    REQUIRE(ways.get(300));
+    const auto& relations = checker.missing(osmium::item_type::relation);
+    REQUIRE(relations.size() == 1);
+    REQUIRE(relations.get(4));
+}
+
+TEST_CASE("Referential integrity of buffer") {
+    const auto buffer = create_data();
+
+    osmium::index::ReferentialIntegrityChecker checker{1ULL << 20U};
+    checker.add(buffer);
+
+    SECTION("sequential") {
+        REQUIRE(checker.check() == 4);
+        check_missing(checker);
+    }
+
+    SECTION("with pool") {
+        osmium::thread::Pool pool{3};
+        REQUIRE(checker.check(pool) == 4);
+        check_missing(checker);
+    }
+}
+
+TEST_CASE("Referential integrity of complete data") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1));
+    osmium::builder::add_node(buffer, _id(2));
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 2}));
+    osmium::builder::add_relation(buffer, _id(1), _member(osmium::item_type::way, 1));
+
+    osmium::index::ReferentialIntegrityChecker checker{1ULL << 20U};
+    checker.add(buffer);
+    REQUIRE(checker.check() == 0);
+    REQUIRE(checker.missing(osmium::item_type::node).empty());
+}
+
+TEST_CASE("IDs too large for referential integrity checker") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 1ULL << 30U}));
+
+    osmium::index::ReferentialIntegrityChecker checker{1ULL << 20U};
+    REQUIRE_THROWS_AS(checker.add(buffer), std::out_of_range);
+}
+
+TEST_CASE("Referential integrity of PBF file checked in decoder threads") {
+    const std::string filename{"test-referential-integrity.osm.pbf"};
+    {
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(create_data());
+        writer.close();
+    }
+
+    osmium::index::ReferentialIntegrityChecker checker{1ULL << 20U};
+    osmium::io::Reader reader{filename, checker.callback()};
+    while (reader.read()) {
+    }
+    reader.close();
+
+    REQUIRE(checker.check() == 4);
+    check_missing(checker);
+
+    osmium::io::IndexedPBFReader indexed_reader{filename, "-"};
+    referrer_list referrers;
+    checker.find_referrers(indexed_reader, [&](const osmium::OSMObject& referrer, osmium::item_type type, osmium::object_id_type id) {
+        referrers.emplace_back(referrer.type(), referrer.id(), type, id);
+    });
+    REQUIRE(referrers == expected_referrers);
+
+    REQUIRE(0 == std::remove(filename.c_str()));
+}
+
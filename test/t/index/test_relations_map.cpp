@@ -1,8 +1,13 @@
 #include "catch.hpp"
 
 #include <osmium/index/relations_map.hpp>
+#include <osmium/thread/pool.hpp>
 
+#include <algorithm>
+#include <map>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 static_assert(!std::is_default_constructible<osmium::index::RelationsMapIndex>::value, "RelationsMapIndex should not be default constructible");
 static_assert(!std::is_copy_constructible<osmium::index::RelationsMapIndex>::value, "RelationsMapIndex should not be copy constructible");
@@ -105,3 +110,98 @@ TEST_CASE("RelationsMapStash both indexes") {
     REQUIRE(count == 2);
 }
 
+
+TEST_CASE("RelationsMapStash both indexes with duplicates and multiple parents") {
+    osmium::index::RelationsMapStash stash;
+
+    stash.add(1, 10);
+    stash.add(2, 10);
+    stash.add(1, 11);
+    stash.add(3, 11);
+    stash.add(1, 10);
+
+    const auto index = stash.build_indexes();
+    REQUIRE(index.size() == 4);
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    index.member_to_parent().for_each(1, [&](osmium::unsigned_object_id_type id) {
+        ids.push_back(id);
+    });
+    REQUIRE(ids == std::vector<osmium::unsigned_object_id_type>{10, 11});
+
+    ids.clear();
+    index.parent_to_member().for_each(10, [&](osmium::unsigned_object_id_type id) {
+        ids.push_back(id);
+    });
+    REQUIRE(ids == std::vector<osmium::unsigned_object_id_type>{1, 2});
+
+    ids.clear();
+    index.parent_to_member().for_each(11, [&](osmium::unsigned_object_id_type id) {
+        ids.push_back(id);
+    });
+    REQUIRE(ids == std::vector<osmium::unsigned_object_id_type>{1, 3});
+
+    ids.clear();
+    index.parent_to_member().for_each(1, [&](osmium::unsigned_object_id_type id) {
+        ids.push_back(id);
+    });
+    REQUIRE(ids.empty());
+}
+
+TEST_CASE("RelationsMapStash build indexes using pool") {
+    osmium::thread::Pool pool{4};
+
+    std::multimap<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type> m2p;
+    std::multimap<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type> p2m;
+
+    osmium::index::RelationsMapStash stash;
+    for (osmium::unsigned_object_id_type n = 300000; n > 0; --n) {
+        const osmium::unsigned_object_id_type parent = 1000000 + (n * 7919) % 1009;
+        stash.add(n, parent);
+        m2p.emplace(n, parent);
+        p2m.emplace(parent, n);
+    }
+
+    const auto check = [](const osmium::index::RelationsMapIndex& index,
+                          const std::multimap<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>& expected,
+                          osmium::unsigned_object_id_type id) {
+        std::vector<osmium::unsigned_object_id_type> ids;
+        index.for_each(id, [&](osmium::unsigned_object_id_type rid) {
+            ids.push_back(rid);
+        });
+        std::vector<osmium::unsigned_object_id_type> expected_ids;
+        const auto range = expected.equal_range(id);
+        for (auto it = range.first; it != range.second; ++it) {
+            expected_ids.push_back(it->second);
+        }
+        std::sort(expected_ids.begin(), expected_ids.end());
+        REQUIRE(ids == expected_ids);
+    };
+
+    SECTION("both indexes") {
+        const auto index = stash.build_indexes(pool);
+        REQUIRE(index.size() == 300000);
+        for (const osmium::unsigned_object_id_type id : {1U, 17U, 4711U, 299999U, 300000U, 300001U}) {
+            check(index.member_to_parent(), m2p, id);
+        }
+        for (osmium::unsigned_object_id_type id = 999999; id < 1001010; ++id) {
+            check(index.parent_to_member(), p2m, id);
+        }
+    }
+
+    SECTION("member to parent index") {
+        const auto index = stash.build_member_to_parent_index(pool);
+        REQUIRE(index.size() == 300000);
+        for (const osmium::unsigned_object_id_type id : {1U, 17U, 4711U, 300000U}) {
+            check(index, m2p, id);
+        }
+    }
+
+    SECTION("parent to member index") {
+        const auto index = stash.build_parent_to_member_index(pool);
+        REQUIRE(index.size() == 300000);
+        for (const osmium::unsigned_object_id_type id : {1000000U, 1000500U, 1001008U}) {
+            check(index, p2m, id);
+        }
+    }
+}
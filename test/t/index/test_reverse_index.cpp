@@ -0,0 +1,171 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/detail/radix_sort.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/reverse_index.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+using id_type = osmium::unsigned_object_id_type;
+
+static std::vector<id_type> values(const osmium::index::ReverseIndex& index, id_type key) {
+    const auto range = index.get(key);
+    return std::vector<id_type>(range.first, range.second);
+}
+
+TEST_CASE("Radix sort") {
+    osmium::thread::Pool pool{4};
+
+    std::mt19937_64 gen{42}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    std::uniform_int_distribution<uint64_t> small{0, 1000};
+    std::uniform_int_distribution<uint64_t> large;
+
+    for (const std::size_t size : {0, 1, 10, 1000, 300000}) {
+        std::vector<std::pair<uint64_t, uint64_t>> data;
+        for (std::size_t i = 0; i < size; ++i) {
+            data.emplace_back(i % 2 ? small(gen) : large(gen), i);
+        }
+        auto expected = data;
+        std::stable_sort(expected.begin(), expected.end(), [](const std::pair<uint64_t, uint64_t>& a, const std::pair<uint64_t, uint64_t>& b) {
+            return a.first < b.first;
+        });
+
+        osmium::index::detail::radix_sort(data, [](const std::pair<uint64_t, uint64_t>& p) {
+            return p.first;
+        }, pool);
+        REQUIRE(data == expected);
+    }
+}
+
+TEST_CASE("Build reverse index") {
+    osmium::thread::Pool pool{4};
+    osmium::index::ReverseIndexBuilder builder;
+
+    SECTION("empty") {
+        const auto index = builder.build(pool);
+        REQUIRE(index.empty());
+        REQUIRE(index.num_keys() == 0);
+        REQUIRE(values(index, 1).empty());
+    }
+
+    SECTION("with duplicates") {
+        builder.add(3, 20);
+        builder.add(1, 10);
+        builder.add(3, 10);
+        builder.add(1, 10);
+        builder.add(5, 30);
+        REQUIRE(builder.size() == 5);
+
+        const auto index = builder.build(pool);
+        REQUIRE(builder.size() == 0);
+        REQUIRE(index.size() == 4);
+        REQUIRE(index.num_keys() == 3);
+
+        REQUIRE(values(index, 1) == std::vector<id_type>{10});
+        REQUIRE(values(index, 2).empty());
+        REQUIRE(values(index, 3) == (std::vector<id_type>{10, 20}));
+        REQUIRE(values(index, 5) == std::vector<id_type>{30});
+        REQUIRE(values(index, 6).empty());
+
+        std::vector<id_type> found;
+        index.for_each(3, [&](id_type id) {
+            found.push_back(id);
+        });
+        REQUIRE(found == (std::vector<id_type>{10, 20}));
+    }
+
+    SECTION("large") {
+        std::mt19937 gen{17}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+        std::uniform_int_distribution<id_type> key{1, 10000};
+        std::vector<std::pair<id_type, id_type>> expected;
+        for (id_type value = 1; value <= 100000; ++value) {
+            const auto k = key(gen);
+            builder.add(k, value);
+            expected.emplace_back(k, value);
+        }
+        std::sort(expected.begin(), expected.end());
+
+        const auto index = builder.build(pool);
+        std::vector<std::pair<id_type, id_type>> entries;
+        index.for_each_entry([&](id_type k, id_type v) {
+            entries.emplace_back(k, v);
+        });
+        REQUIRE(entries == expected);
+    }
+}
+
+TEST_CASE("Dump and load reverse index") {
+    osmium::thread::Pool pool{2};
+    osmium::index::ReverseIndexBuilder builder;
+    builder.add(7, 1);
+    builder.add(7, 2);
+    builder.add(9, 1);
+
+    const auto index = builder.build(pool);
+
+    const int fd = osmium::detail::create_tmp_file();
+    index.dump(fd);
+    const auto loaded = osmium::index::ReverseIndex::load(fd);
+
+    REQUIRE(loaded.size() == 3);
+    REQUIRE(loaded.num_keys() == 2);
+    REQUIRE(values(loaded, 7) == (std::vector<id_type>{1, 2}));
+    REQUIRE(values(loaded, 9) == std::vector<id_type>{1});
+    REQUIRE(values(loaded, 8).empty());
+
+    const int fd_empty = osmium::detail::create_tmp_file();
+    osmium::index::ReverseIndex{}.dump(fd_empty);
+    REQUIRE(osmium::index::ReverseIndex::load(fd_empty).empty());
+}
+
+TEST_CASE("Loading invalid reverse index file throws") {
+    const int fd = osmium::detail::create_tmp_file();
+    const char data[40] = "This is not a reverse index file";
+    osmium::io::detail::reliable_write(fd, data, sizeof(data));
+    REQUIRE_THROWS_AS(osmium::index::ReverseIndex::load(fd), osmium::reverse_index_error);
+}
+
+TEST_CASE("Build and update reverse indexes from OSM data") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::thread::Pool pool{2};
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(10), _nodes({1, 2, 3}));
+    osmium::builder::add_way(buffer, _id(11), _nodes({3, 4}));
+    osmium::builder::add_relation(buffer, _id(20), _member(osmium::item_type::way, 10), _member(osmium::item_type::node, 1));
+    osmium::builder::add_relation(buffer, _id(21), _member(osmium::item_type::relation, 20));
+
+    osmium::index::ReverseIndexesBuilder builder;
+    osmium::apply(buffer, builder);
+    const auto indexes = builder.build(pool);
+
+    REQUIRE(values(indexes.node_to_way, 3) == (std::vector<id_type>{10, 11}));
+    REQUIRE(values(indexes.node_to_way, 4) == std::vector<id_type>{11});
+    REQUIRE(values(indexes.node_to_relation, 1) == std::vector<id_type>{20});
+    REQUIRE(values(indexes.way_to_relation, 10) == std::vector<id_type>{20});
+    REQUIRE(values(indexes.relation_to_relation, 20) == std::vector<id_type>{21});
+
+    osmium::memory::Buffer changes{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(changes, _id(11), _version(2), _nodes({4, 5}));
+    osmium::builder::add_way(changes, _id(12), _version(1), _nodes({5, 6}));
+    osmium::builder::add_relation(changes, _id(21), _version(2), _visible(false));
+
+    osmium::apply(changes, builder);
+    const auto updated = builder.update(indexes, pool);
+
+    REQUIRE(values(updated.node_to_way, 3) == std::vector<id_type>{10});
+    REQUIRE(values(updated.node_to_way, 4) == std::vector<id_type>{11});
+    REQUIRE(values(updated.node_to_way, 5) == (std::vector<id_type>{11, 12}));
+    REQUIRE(values(updated.node_to_way, 1) == std::vector<id_type>{10});
+    REQUIRE(values(updated.way_to_relation, 10) == std::vector<id_type>{20});
+    REQUIRE(updated.relation_to_relation.empty());
+}
@@ -0,0 +1,158 @@
+#include "catch.hpp"
+
+#include <osmium/index/map/compressed_dense_mem_array.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/shared_memory_array.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#ifndef _WIN32
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using id_type = osmium::unsigned_object_id_type;
+using location_map_type = osmium::index::map::SharedMemoryArray<id_type, osmium::Location>;
+
+static std::string shm_name(const char* suffix) {
+    return std::string{"/osmium-test-"} + std::to_string(::getpid()) + '-' + suffix;
+}
+
+TEST_CASE("Publish dense map to shared memory and attach to it") {
+    const std::string name = shm_name("dense");
+
+    osmium::index::map::DenseMemArray<id_type, osmium::Location> map;
+    map.set(1, osmium::Location{1.1, 1.2});
+    map.set(7, osmium::Location{7.1, 7.2});
+    map.set(100, osmium::Location{10.1, 10.2});
+
+    REQUIRE(osmium::index::map::publish_shared_memory_array(name, map) == 1);
+
+    location_map_type shm_map{name};
+    REQUIRE(shm_map.generation() == 1);
+    REQUIRE(shm_map.current_generation() == 1);
+    REQUIRE(shm_map.size() == map.size());
+    REQUIRE(shm_map.used_memory() >= map.size() * sizeof(osmium::Location));
+
+    REQUIRE(shm_map.get(1) == osmium::Location(1.1, 1.2));
+    REQUIRE(shm_map.get(7) == osmium::Location(7.1, 7.2));
+    REQUIRE(shm_map.get(100) == osmium::Location(10.1, 10.2));
+    REQUIRE_THROWS_AS(shm_map.get(2), osmium::not_found);
+    REQUIRE_THROWS_AS(shm_map.get(1000), osmium::not_found);
+    REQUIRE(shm_map.get_noexcept(2) == osmium::Location{});
+    REQUIRE(shm_map.get_noexcept(1000) == osmium::Location{});
+
+    REQUIRE_THROWS_AS(shm_map.set(3, osmium::Location{3.0, 3.0}), std::runtime_error);
+    REQUIRE_FALSE(shm_map.update());
+
+    shm_map.clear();
+    REQUIRE(shm_map.size() == 0);
+    REQUIRE(shm_map.used_memory() == 0);
+    REQUIRE(shm_map.get_noexcept(1) == osmium::Location{});
+
+    osmium::index::map::remove_shared_memory_array(name);
+    REQUIRE_THROWS_AS(location_map_type{name}, std::system_error);
+}
+
+TEST_CASE("Publish compressed map to shared memory") {
+    const std::string name = shm_name("compressed");
+
+    osmium::index::map::CompressedDenseMemArray<id_type, osmium::Location> map;
+    for (id_type id = 1; id < 5000; id += 3) {
+        map.set(id, osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(id * 2)});
+    }
+
+    osmium::index::map::publish_shared_memory_array(name, map);
+
+    const location_map_type shm_map{name};
+    for (id_type id = 0; id < 5000; ++id) {
+        REQUIRE(shm_map.get_noexcept(id) == map.get_noexcept(id));
+    }
+
+    osmium::index::map::remove_shared_memory_array(name);
+}
+
+TEST_CASE("Attached maps keep their generation until updated") {
+    const std::string name = shm_name("generations");
+
+    osmium::index::map::DenseMemArray<id_type, osmium::Location> map;
+    map.set(5, osmium::Location{5.0, 5.0});
+    REQUIRE(osmium::index::map::publish_shared_memory_array(name, map) == 1);
+
+    location_map_type shm_map{name};
+    REQUIRE(shm_map.get(5) == osmium::Location(5.0, 5.0));
+
+    map.set(5, osmium::Location{6.0, 6.0});
+    map.set(50, osmium::Location{50.0, 50.0});
+    REQUIRE(osmium::index::map::publish_shared_memory_array(name, map) == 2);
+
+    // Old generation is still mapped and readable.
+    REQUIRE(shm_map.generation() == 1);
+    REQUIRE(shm_map.current_generation() == 2);
+    REQUIRE(shm_map.get(5) == osmium::Location(5.0, 5.0));
+    REQUIRE(shm_map.get_noexcept(50) == osmium::Location{});
+
+    // Maps attached now get the new generation.
+    const location_map_type shm_map2{name};
+    REQUIRE(shm_map2.generation() == 2);
+    REQUIRE(shm_map2.get(5) == osmium::Location(6.0, 6.0));
+
+    REQUIRE(shm_map.update());
+    REQUIRE(shm_map.generation() == 2);
+    REQUIRE(shm_map.get(5) == osmium::Location(6.0, 6.0));
+    REQUIRE(shm_map.get(50) == osmium::Location(50.0, 50.0));
+    REQUIRE_FALSE(shm_map.update());
+
+    osmium::index::map::remove_shared_memory_array(name);
+}
+
+TEST_CASE("Shared memory array can be used from child process") {
+    const std::string name = shm_name("fork");
+
+    osmium::index::map::DenseMemArray<id_type, osmium::Location> map;
+    map.set(3, osmium::Location{3.5, 4.5});
+    osmium::index::map::publish_shared_memory_array(name, map);
+
+    const pid_t pid = ::fork();
+    REQUIRE(pid >= 0);
+    if (pid == 0) {
+        int result = 1;
+        try {
+            const location_map_type shm_map{name};
+            if (shm_map.get(3) == osmium::Location(3.5, 4.5)) {
+                result = 0;
+            }
+        } catch (...) {
+        }
+        ::_exit(result);
+    }
+
+    int status = 0;
+    REQUIRE(::waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+
+    osmium::index::map::remove_shared_memory_array(name);
+}
+
+TEST_CASE("Attaching to unknown shared memory array fails") {
+    REQUIRE_THROWS_AS(location_map_type{shm_name("does-not-exist")}, std::system_error);
+}
+
+TEST_CASE("Attaching to shared memory array with wrong value type fails") {
+    const std::string name = shm_name("wrong-type");
+
+    osmium::index::map::DenseMemArray<id_type, uint32_t> map;
+    map.set(1, 1);
+    osmium::index::map::publish_shared_memory_array(name, map);
+
+    REQUIRE_THROWS_AS(location_map_type{name}, std::runtime_error);
+
+    osmium::index::map::remove_shared_memory_array(name);
+}
+
+#endif
@@ -0,0 +1,195 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/dense_file_array.hpp>
+#include <osmium/index/map/tiered_dense_file_array.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+
+#include <memory>
+
+using index_type = osmium::index::map::TieredDenseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location location_for(osmium::unsigned_object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id % 1000), static_cast<int32_t>(id / 1000)};
+}
+
+TEST_CASE("Tiered dense file array: set and get") {
+    index_type index;
+
+    REQUIRE(index.size() == 0);
+    REQUIRE_THROWS_AS(index.get(0), osmium::not_found);
+    REQUIRE_FALSE(index.get_noexcept(100).valid());
+
+    index.set(6, osmium::Location{1.2, 4.5});
+    index.set(3, osmium::Location{3.5, -7.2});
+
+    REQUIRE(index.size() == 7);
+    REQUIRE(index.get(6) == (osmium::Location{1.2, 4.5}));
+    REQUIRE(index.get(3) == (osmium::Location{3.5, -7.2}));
+    REQUIRE_THROWS_AS(index.get(5), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(7), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(1000000), osmium::not_found);
+}
+
+TEST_CASE("Tiered dense file array: pages are evicted and read back") {
+    const std::size_t page_size = index_type::page_size;
+    index_type index{2 * page_size * sizeof(osmium::Location)};
+
+    REQUIRE(index.memory_budget() == 2 * page_size * sizeof(osmium::Location));
+
+    const osmium::unsigned_object_id_type max_id = 10 * page_size;
+    for (osmium::unsigned_object_id_type id = 1; id < max_id; id += 3) {
+        index.set(id, location_for(id));
+    }
+
+    REQUIRE(index.resident_memory() <= index.memory_budget());
+    REQUIRE(index.stats().evictions > 0);
+    REQUIRE(index.stats().writebacks > 0);
+
+    for (osmium::unsigned_object_id_type id = 1; id < max_id; id += 3) {
+        REQUIRE(index.get(id) == location_for(id));
+    }
+    REQUIRE_THROWS_AS(index.get(2), osmium::not_found);
+    REQUIRE_FALSE(index.get_noexcept(max_id - 2).valid());
+}
+
+TEST_CASE("Tiered dense file array: sparse pages") {
+    const std::size_t page_size = index_type::page_size;
+    index_type index{page_size * sizeof(osmium::Location)};
+
+    index.set(5 * page_size + 17, location_for(17));
+    index.set(1, location_for(1));
+    index.evict_all();
+
+    REQUIRE(index.resident_memory() == 0);
+    REQUIRE(index.get(5 * page_size + 17) == location_for(17));
+    REQUIRE(index.get(1) == location_for(1));
+
+    // The gap between the pages must read as empty, not as (0, 0).
+    REQUIRE_THROWS_AS(index.get(3 * page_size), osmium::not_found);
+}
+
+TEST_CASE("Tiered dense file array: hit rate statistics") {
+    const std::size_t page_size = index_type::page_size;
+    index_type index{4 * page_size * sizeof(osmium::Location)};
+
+    for (osmium::unsigned_object_id_type id = 0; id < 4 * page_size; ++id) {
+        index.set(id, location_for(id));
+    }
+    REQUIRE(index.stats().misses == 4);
+    REQUIRE(index.stats().evictions == 0);
+
+    index.reset_stats();
+    REQUIRE(index.stats().hits == 0);
+    REQUIRE(index.stats().hit_rate() == Approx(0.0));
+
+    for (int i = 0; i < 3; ++i) {
+        for (osmium::unsigned_object_id_type id = 0; id < 4 * page_size; id += 100) {
+            REQUIRE(index.get(id) == location_for(id));
+        }
+    }
+    REQUIRE(index.stats().misses == 0);
+    REQUIRE(index.stats().hit_rate() == Approx(1.0));
+}
+
+TEST_CASE("Tiered dense file array: frequently used pages stay in memory") {
+    const std::size_t page_size = index_type::page_size;
+    index_type index{4 * page_size * sizeof(osmium::Location)};
+
+    for (osmium::unsigned_object_id_type id = 0; id < 20 * page_size; id += 10) {
+        index.set(id, location_for(id));
+    }
+    index.evict_all();
+
+    // Page 0 and 1 are used again and again, the other pages are only
+    // touched once in a scan. The hot pages should survive the scan.
+    for (std::size_t page = 2; page < 20; ++page) {
+        index.get_noexcept(0);
+        index.get_noexcept(page_size);
+        index.get_noexcept(0);
+        index.get_noexcept(page_size);
+        index.get_noexcept(page * page_size);
+    }
+    index.reset_stats();
+    index.get_noexcept(0);
+    index.get_noexcept(page_size);
+    REQUIRE(index.stats().hits == 2);
+    REQUIRE(index.stats().misses == 0);
+}
+
+TEST_CASE("Tiered dense file array: shrinking the memory budget") {
+    const std::size_t page_size = index_type::page_size;
+    index_type index{8 * page_size * sizeof(osmium::Location)};
+
+    for (osmium::unsigned_object_id_type id = 0; id < 8 * page_size; id += 7) {
+        index.set(id, location_for(id));
+    }
+    REQUIRE(index.resident_memory() == 8 * page_size * sizeof(osmium::Location));
+
+    index.set_memory_budget(0);
+    REQUIRE(index.resident_memory() == page_size * sizeof(osmium::Location));
+
+    for (osmium::unsigned_object_id_type id = 0; id < 8 * page_size; id += 7) {
+        REQUIRE(index.get(id) == location_for(id));
+    }
+}
+
+TEST_CASE("Tiered dense file array: file is compatible with DenseFileArray") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    {
+        index_type index{fd, 1024 * 1024};
+        index.set(6, osmium::Location{1.2, 4.5});
+        index.set(3, osmium::Location{3.5, -7.2});
+    }
+
+    REQUIRE(osmium::file_size(fd) == index_type::page_size * sizeof(osmium::Location));
+
+    {
+        const osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location> dense{fd};
+        REQUIRE(dense.get(6) == (osmium::Location{1.2, 4.5}));
+        REQUIRE(dense.get(3) == (osmium::Location{3.5, -7.2}));
+        REQUIRE_THROWS_AS(dense.get(5), osmium::not_found);
+    }
+
+    {
+        const index_type index{fd, 1024 * 1024};
+        REQUIRE(index.size() >= 7);
+        REQUIRE(index.get(6) == (osmium::Location{1.2, 4.5}));
+        REQUIRE(index.get(3) == (osmium::Location{3.5, -7.2}));
+    }
+}
+
+TEST_CASE("Tiered dense file array: dump as array") {
+    index_type index{1};
+
+    index.set(3, osmium::Location{1, 2});
+    index.set(index_type::page_size + 1, osmium::Location{3, 4});
+
+    const int fd = osmium::detail::create_tmp_file();
+    index.dump_as_array(fd);
+    REQUIRE(osmium::file_size(fd) == (index_type::page_size + 2) * sizeof(osmium::Location));
+
+    const osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location> dense{fd};
+    REQUIRE(dense.get(3) == (osmium::Location{1, 2}));
+    REQUIRE(dense.get(index_type::page_size + 1) == (osmium::Location{3, 4}));
+}
+
+TEST_CASE("Tiered dense file array: create with map factory") {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+
+    REQUIRE(map_factory.has_map_type("tiered_dense_file_array"));
+
+    std::unique_ptr<osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>> index1 = map_factory.create_map("tiered_dense_file_array");
+    index1->set(1, osmium::Location{1, 2});
+    REQUIRE(index1->get(1) == (osmium::Location{1, 2}));
+
+    std::unique_ptr<osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>> index2 = map_factory.create_map("tiered_dense_file_array,,16");
+    REQUIRE(static_cast<index_type*>(index2.get())->memory_budget() == 16 * 1024 * 1024);
+
+    REQUIRE_THROWS_AS(map_factory.create_map("tiered_dense_file_array,,foo"), osmium::map_factory_error);
+    REQUIRE_THROWS_AS(map_factory.create_map("tiered_dense_file_array,,1,2"), osmium::map_factory_error);
+}
@@ -0,0 +1,65 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/tile_cover.hpp>
+#include <osmium/index/multimap/sparse_mem_array.hpp>
+#include <osmium/index/tile_index.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using tile_index_type = osmium::index::multimap::SparseMemArray<uint64_t, std::size_t>;
+
+TEST_CASE("Tile index of small buffer") {
+    osmium::memory::Buffer buffer{10000};
+    const auto node_pos = osmium::builder::add_node(buffer, _id(1), _location(10.0, 10.0));
+    const auto way_pos = osmium::builder::add_way(buffer, _id(2), _nodes({
+        {1, {-170.0, 80.0}},
+        {2, {170.0, 80.0}}
+    }));
+    osmium::builder::add_relation(buffer, _id(3));
+
+    tile_index_type index;
+    REQUIRE(osmium::index::add_to_tile_index(buffer, 1, index) == 3);
+    index.sort();
+
+    auto range = index.get_all(osmium::geom::tile_key(1, 0));
+    REQUIRE(std::distance(range.first, range.second) == 2);
+    REQUIRE(range.first->second == node_pos);
+    REQUIRE(std::next(range.first)->second == way_pos);
+    REQUIRE(buffer.get<osmium::Node>(range.first->second).id() == 1);
+
+    range = index.get_all(osmium::geom::tile_key(0, 0));
+    REQUIRE(std::distance(range.first, range.second) == 1);
+    REQUIRE(range.first->second == way_pos);
+
+    range = index.get_all(osmium::geom::tile_key(0, 1));
+    REQUIRE(range.first == range.second);
+}
+
+TEST_CASE("Tile index of large buffer uses pool") {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    const int num_nodes = 5000;
+    for (int i = 0; i < num_nodes; ++i) {
+        osmium::builder::add_node(buffer, _id(i + 1), _location(-179.0 + i * 0.07, -80.0 + i * 0.03));
+    }
+
+    osmium::thread::Pool pool{2};
+    tile_index_type index;
+    REQUIRE(osmium::index::add_to_tile_index(buffer, 4, index, pool) == num_nodes);
+    index.sort();
+
+    std::size_t count = 0;
+    for (const auto& entry : index) {
+        const auto& node = buffer.get<osmium::Node>(entry.second);
+        REQUIRE(osmium::geom::tile_key(osmium::geom::Tile{4, node.location()}) == entry.first);
+        ++count;
+    }
+    REQUIRE(count == num_nodes);
+}
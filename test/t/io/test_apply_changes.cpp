@@ -0,0 +1,207 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/apply_changes.hpp>
+#include <osmium/io/indexed_pbf_reader.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static void write_base_file(const std::string& filename) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 30000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0));
+    }
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _version(1), _nodes({id, id + 1}));
+    }
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+static osmium::memory::Buffer read_all(const std::string& filename) {
+    osmium::io::Reader reader{filename};
+    osmium::memory::Buffer result{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            result.add_item(object);
+            result.commit();
+        }
+    }
+    reader.close();
+    return result;
+}
+
+namespace {
+
+    class BufferSource {
+
+        std::vector<osmium::memory::Buffer> m_buffers;
+        std::size_t m_next = 0;
+
+    public:
+
+        void add(osmium::memory::Buffer&& buffer) {
+            m_buffers.push_back(std::move(buffer));
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_buffers.size()) {
+                return osmium::memory::Buffer{};
+            }
+            return std::move(m_buffers[m_next++]);
+        }
+
+    }; // class BufferSource
+
+} // anonymous namespace
+
+TEST_CASE("Sorted changes keep newest version of each object") {
+    osmium::io::SortedChanges changes;
+    REQUIRE(changes.empty());
+
+    osmium::memory::Buffer buffer1{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer1, _id(3), _version(2), _nodes({1, 2}));
+    osmium::builder::add_node(buffer1, _id(7), _version(3), _location(1.0, 1.0));
+    osmium::builder::add_node(buffer1, _id(2), _version(2), _location(1.0, 1.0));
+    changes.add_buffer(std::move(buffer1));
+
+    osmium::memory::Buffer buffer2{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer2, _id(7), _version(2), _location(2.0, 2.0));
+    osmium::builder::add_node(buffer2, _id(2), _version(2), _location(3.0, 3.0));
+    changes.add_buffer(std::move(buffer2));
+
+    REQUIRE_FALSE(changes.sorted());
+    changes.sort();
+    REQUIRE(changes.sorted());
+    REQUIRE(changes.size() == 3);
+
+    auto it = changes.begin();
+    REQUIRE((*it)->type() == osmium::item_type::node);
+    REQUIRE((*it)->id() == 2);
+    REQUIRE(static_cast<const osmium::Node*>(*it)->location().lon() == Approx(3.0));
+    ++it;
+    REQUIRE((*it)->id() == 7);
+    REQUIRE((*it)->version() == 3);
+    ++it;
+    REQUIRE((*it)->type() == osmium::item_type::way);
+    REQUIRE((*it)->id() == 3);
+    ++it;
+    REQUIRE(it == changes.end());
+}
+
+TEST_CASE("Apply changes to a stream of buffers") {
+    const std::string filename{"test-apply-changes-stream.osm.pbf"};
+
+    BufferSource source;
+    osmium::memory::Buffer base{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(base, _id(1), _version(1), _location(1.0, 1.0));
+    osmium::builder::add_node(base, _id(2), _version(1), _location(1.0, 1.0));
+    osmium::builder::add_node(base, _id(4), _version(1), _location(1.0, 1.0));
+    osmium::builder::add_way(base, _id(1), _version(1), _nodes({1, 2}));
+    source.add(std::move(base));
+
+    osmium::memory::Buffer change{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(change, _id(2), _version(2), _visible(false));
+    osmium::builder::add_node(change, _id(3), _version(1), _location(2.0, 2.0));
+    osmium::builder::add_node(change, _id(4), _version(2), _location(3.0, 3.0));
+    osmium::builder::add_way(change, _id(2), _version(1), _nodes({3, 4}));
+
+    osmium::io::SortedChanges changes;
+    changes.add_buffer(std::move(change));
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    osmium::io::apply_changes(source, changes, writer);
+    writer.close();
+
+    const auto result = read_all(filename);
+    std::vector<std::pair<osmium::object_id_type, osmium::object_version_type>> nodes;
+    for (const auto& node : result.select<osmium::Node>()) {
+        nodes.emplace_back(node.id(), node.version());
+    }
+    const std::vector<std::pair<osmium::object_id_type, osmium::object_version_type>> expected{{1, 1}, {3, 1}, {4, 2}};
+    REQUIRE(nodes == expected);
+
+    std::vector<osmium::object_id_type> ways;
+    for (const auto& way : result.select<osmium::Way>()) {
+        ways.push_back(way.id());
+    }
+    REQUIRE(ways == std::vector<osmium::object_id_type>{1, 2});
+}
+
+TEST_CASE("Apply changes to PBF file copies untouched blobs") {
+    const std::string base_filename{"test-apply-changes-base.osm.pbf"};
+    const std::string out_filename{"test-apply-changes-out.osm.pbf"};
+    write_base_file(base_filename);
+
+    osmium::io::IndexedPBFReader reader{base_filename, "-"};
+    REQUIRE(reader.num_data_blobs() == 5);
+
+    osmium::memory::Buffer change{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(change, _id(5), _version(2), _location(5.0, 5.0));
+    osmium::builder::add_node(change, _id(30001), _version(1), _location(6.0, 6.0));
+    osmium::builder::add_way(change, _id(50), _version(2), _visible(false));
+
+    osmium::io::SortedChanges changes;
+    changes.add_buffer(std::move(change));
+
+    std::size_t copied = 0;
+    SECTION("PBF output copies blobs") {
+        osmium::io::Writer writer{out_filename, osmium::io::overwrite::allow};
+        REQUIRE(writer.supports_raw_blobs());
+        copied = osmium::io::apply_changes(reader, changes, writer);
+        writer.close();
+        REQUIRE(copied == 3);
+    }
+
+    SECTION("Other output decodes everything") {
+        osmium::io::Writer writer{osmium::io::File{out_filename, "opl"}, osmium::io::overwrite::allow};
+        REQUIRE_FALSE(writer.supports_raw_blobs());
+        copied = osmium::io::apply_changes(reader, changes, writer);
+        writer.close();
+        REQUIRE(copied == 0);
+    }
+
+    osmium::io::Reader result_reader{osmium::io::File{out_filename, copied > 0 ? "pbf" : "opl"}};
+    osmium::object_id_type last_node = 0;
+    osmium::object_id_type last_way = 0;
+    std::size_t nodes = 0;
+    std::size_t ways = 0;
+    while (const auto buffer = result_reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() > last_node);
+            REQUIRE(ways == 0);
+            last_node = node.id();
+            ++nodes;
+            REQUIRE(node.version() == (node.id() == 5 ? 2 : 1));
+        }
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            REQUIRE(way.id() > last_way);
+            REQUIRE(way.id() != 50);
+            last_way = way.id();
+            ++ways;
+        }
+    }
+    result_reader.close();
+
+    REQUIRE(nodes == 30001);
+    REQUIRE(ways == 99);
+}
+
+TEST_CASE("Writing raw blobs to non-PBF output fails") {
+    osmium::io::Writer writer{osmium::io::File{"test-apply-changes-raw.opl"}, osmium::io::overwrite::allow};
+    REQUIRE_THROWS_AS(writer.write_raw_blob(std::string{"x"}), osmium::io_error);
+}
@@ -0,0 +1,200 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/buffer_file_input.hpp>
+#include <osmium/io/buffer_file_output.hpp>
+#include <osmium/io/buffer_file_reader.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+static void write_test_file(const std::string& filename) {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::io::Header header;
+    header.set("generator", "test_buffer_file");
+    header.add_box(osmium::Box{1.0, 2.0, 3.0, 4.0});
+
+    osmium::io::Writer writer{filename, header, osmium::io::overwrite::allow};
+
+    osmium::memory::Buffer nodes{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_node(nodes, _id(id), _version(1), _location(1.5, 2.5), _tag("id", std::to_string(id)));
+    }
+    writer(std::move(nodes));
+
+    osmium::memory::Buffer ways{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 10; ++id) {
+        osmium::builder::add_way(ways, _id(id), _version(2), _nodes({id, id + 1}));
+    }
+    writer(std::move(ways));
+
+    osmium::memory::Buffer mixed{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(mixed, _id(101), _version(1), _location(1.5, 2.5));
+    osmium::builder::add_relation(mixed, _id(1), _version(3), _member(osmium::item_type::way, 1, "outer"));
+    writer(std::move(mixed));
+
+    writer.close();
+}
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream in{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+static void write_file(const std::string& filename, const std::string& data) {
+    std::ofstream out{filename, std::ios::binary};
+    out << data;
+}
+
+struct object_counts {
+    int nodes = 0;
+    int ways = 0;
+    int relations = 0;
+};
+
+static object_counts count_objects(osmium::io::Reader& reader) {
+    object_counts counts;
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            switch (object.type()) {
+                case osmium::item_type::node:
+                    REQUIRE(static_cast<const osmium::Node&>(object).location() == osmium::Location(1.5, 2.5));
+                    ++counts.nodes;
+                    break;
+                case osmium::item_type::way:
+                    REQUIRE(static_cast<const osmium::Way&>(object).nodes().size() == 2);
+                    ++counts.ways;
+                    break;
+                default:
+                    ++counts.relations;
+            }
+        }
+    }
+    return counts;
+}
+
+TEST_CASE("Detect buffer file format from suffix") {
+    REQUIRE(osmium::io::File{"test.osmb"}.format() == osmium::io::file_format::buffer);
+    REQUIRE(osmium::io::File{"test.osmb.gz"}.format() == osmium::io::file_format::buffer);
+    REQUIRE(osmium::io::File{"test", "buffer"}.format() == osmium::io::file_format::buffer);
+}
+
+TEST_CASE("Read buffer file with Reader") {
+    const std::string filename{"test-buffer-file.osmb"};
+    write_test_file(filename);
+
+    SECTION("all objects") {
+        osmium::io::Reader reader{filename};
+        const auto header = reader.header();
+        REQUIRE(header.get("generator") == "test_buffer_file");
+        REQUIRE(header.boxes().size() == 1);
+        REQUIRE(header.box() == osmium::Box(1.0, 2.0, 3.0, 4.0));
+        REQUIRE_FALSE(header.has_multiple_object_versions());
+
+        const auto counts = count_objects(reader);
+        REQUIRE(counts.nodes == 101);
+        REQUIRE(counts.ways == 10);
+        REQUIRE(counts.relations == 1);
+        reader.close();
+    }
+
+    SECTION("only some types") {
+        osmium::io::Reader reader{filename, osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation};
+        const auto counts = count_objects(reader);
+        REQUIRE(counts.nodes == 0);
+        REQUIRE(counts.ways == 10);
+        REQUIRE(counts.relations == 1);
+        reader.close();
+    }
+
+    SECTION("from memory") {
+        const std::string data{read_file(filename)};
+        osmium::io::File file{data.data(), data.size(), "osmb"};
+        osmium::io::Reader reader{file, osmium::osm_entity_bits::node};
+        REQUIRE(reader.header().get("generator") == "test_buffer_file");
+        const auto counts = count_objects(reader);
+        REQUIRE(counts.nodes == 101);
+        REQUIRE(counts.ways == 0);
+        reader.close();
+    }
+
+    SECTION("truncated file") {
+        const std::string data{read_file(filename)};
+        const std::string truncated_filename{"test-buffer-file-truncated.osmb"};
+        write_file(truncated_filename, data.substr(0, data.size() / 2));
+        osmium::io::Reader reader{truncated_filename};
+        REQUIRE_THROWS_AS(count_objects(reader), osmium::buffer_file_error);
+        reader.close();
+        std::remove(truncated_filename.c_str());
+    }
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Access buffer file with BufferFileReader") {
+    const std::string filename{"test-buffer-file-reader.osmb"};
+    write_test_file(filename);
+
+    osmium::io::BufferFileReader reader{filename};
+    REQUIRE(reader.header().get("generator") == "test_buffer_file");
+    REQUIRE(reader.num_pages() == 3);
+    REQUIRE(reader.page_types(0) == osmium::osm_entity_bits::node);
+    REQUIRE(reader.page_count(0) == 100);
+    REQUIRE(reader.page_types(1) == osmium::osm_entity_bits::way);
+    REQUIRE(reader.page_types(2) == (osmium::osm_entity_bits::node | osmium::osm_entity_bits::relation));
+    REQUIRE(reader.page_count(2) == 2);
+
+    SECTION("read pages with ways") {
+        const auto buffer = reader.read(osmium::osm_entity_bits::way);
+        REQUIRE(buffer);
+        REQUIRE(std::distance(buffer.cbegin(), buffer.cend()) == 10);
+        REQUIRE(buffer.cbegin<osmium::Way>()->id() == 1);
+        REQUIRE_FALSE(reader.read(osmium::osm_entity_bits::way));
+
+        reader.rewind();
+        REQUIRE(reader.read().cbegin<osmium::Node>()->id() == 1);
+    }
+
+    SECTION("changes to buffers don't end up in file") {
+        auto buffer = reader.page(0);
+        buffer.begin<osmium::Node>()->set_id(42);
+        REQUIRE(reader.page(0).cbegin<osmium::Node>()->id() == 42);
+
+        osmium::io::BufferFileReader other_reader{filename};
+        REQUIRE(other_reader.page(0).cbegin<osmium::Node>()->id() == 1);
+    }
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("BufferFileReader with invalid files") {
+    const std::string filename{"test-buffer-file-invalid.osmb"};
+    write_test_file(filename);
+    std::string data{read_file(filename)};
+
+    SECTION("truncated") {
+        data.resize(data.size() - 8);
+    }
+
+    SECTION("not a buffer file") {
+        data[0] = 'X';
+    }
+
+    SECTION("wrong version") {
+        data[8] = 99;
+    }
+
+    SECTION("broken index") {
+        data[data.size() - 32] = 1;
+    }
+
+    write_file(filename, data);
+    REQUIRE_THROWS_AS(osmium::io::BufferFileReader{filename}, osmium::buffer_file_error);
+    std::remove(filename.c_str());
+}
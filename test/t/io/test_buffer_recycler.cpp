@@ -0,0 +1,95 @@
+#include "catch.hpp"
+
+#include <osmium/io/detail/buffer_recycler.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/shared_buffer.hpp>
+
+#include <vector>
+
+#include "utils.hpp"
+
+TEST_CASE("Buffer recycler starts out empty") {
+    osmium::io::detail::BufferRecycler recycler;
+    REQUIRE(recycler.size() == 0);
+    REQUIRE_FALSE(recycler.get(10));
+}
+
+TEST_CASE("Buffer recycler returns cleared buffers") {
+    osmium::io::detail::BufferRecycler recycler;
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::internal};
+    buffer.reserve_space(96);
+    buffer.commit();
+    const auto* data = buffer.data();
+
+    recycler.put(std::move(buffer));
+    REQUIRE(recycler.size() == 1);
+
+    REQUIRE_FALSE(recycler.get(2048));
+    REQUIRE(recycler.size() == 1);
+
+    const auto recycled = recycler.get(1024);
+    REQUIRE(recycled);
+    REQUIRE(recycled.data() == data);
+    REQUIRE(recycled.committed() == 0);
+    REQUIRE(recycled.get_auto_grow() == osmium::memory::Buffer::auto_grow::internal);
+    REQUIRE(recycler.size() == 0);
+}
+
+TEST_CASE("Buffer recycler ignores unsuitable buffers") {
+    osmium::io::detail::BufferRecycler recycler{1};
+
+    recycler.put(osmium::memory::Buffer{});
+    recycler.put(osmium::memory::Buffer{1024, osmium::memory::Buffer::auto_grow::no});
+    REQUIRE(recycler.size() == 0);
+
+    recycler.put(osmium::memory::Buffer{1024, osmium::memory::Buffer::auto_grow::yes});
+    recycler.put(osmium::memory::Buffer{1024, osmium::memory::Buffer::auto_grow::yes});
+    REQUIRE(recycler.size() == 1);
+}
+
+TEST_CASE("Reader reuses recycled buffers") {
+    osmium::io::Reader reader{with_data_dir("t/io/deleted_nodes.osh.pbf")};
+
+    std::size_t count = 0;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        count += buffer.committed();
+        reader.recycle(std::move(buffer));
+    }
+    reader.close();
+
+    REQUIRE(count > 0);
+}
+
+TEST_CASE("Buffer recycler reports memory used by its buffers") {
+    osmium::io::detail::BufferRecycler recycler{2};
+    REQUIRE(recycler.used_memory() == 0);
+
+    recycler.put(osmium::memory::Buffer{1024, osmium::memory::Buffer::auto_grow::yes});
+    recycler.put(osmium::memory::Buffer{2048, osmium::memory::Buffer::auto_grow::yes});
+    REQUIRE(recycler.used_memory() == 1024 + 2048);
+
+    recycler.get(1024);
+    REQUIRE(recycler.used_memory() < 1024 + 2048);
+}
+
+TEST_CASE("Reader gets shared buffers back after last reference is gone") {
+    osmium::io::Reader reader{with_data_dir("t/io/deleted_nodes.osh.pbf")};
+
+    std::vector<osmium::memory::SharedBuffer> buffers;
+    while (osmium::memory::SharedBuffer buffer = reader.read_shared()) {
+        buffers.push_back(buffer);
+    }
+    REQUIRE_FALSE(buffers.empty());
+
+    osmium::memory::SharedBuffer copy{buffers.front()};
+    const auto capacity = copy->capacity();
+    buffers.erase(buffers.begin());
+    const auto used_memory = reader.used_memory();
+
+    copy.reset();
+    REQUIRE(reader.used_memory() == used_memory + capacity);
+
+    reader.close();
+}
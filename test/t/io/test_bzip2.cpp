@@ -5,6 +5,8 @@
 #include <osmium/io/bzip2_compression.hpp>
 #include <osmium/io/detail/read_write.hpp>
 
+#include <cstdint>
+#include <memory>
 #include <string>
 
 static void read_from_decompressor(int fd) {
@@ -146,3 +148,100 @@ TEST_CASE("Write bzip2-compressed file with implicit close") {
     REQUIRE(osmium::file_size(output_file) > 10);
 }
 
+
+static std::string bzip2_stream(const std::string& data) {
+    std::string output(data.size() + data.size() / 100 + 600, '\0');
+    auto size = static_cast<unsigned int>(output.size());
+    REQUIRE(BZ2_bzBuffToBuffCompress(&output[0], &size, const_cast<char*>(data.data()), static_cast<unsigned int>(data.size()), 9, 0, 0) == BZ_OK);
+    output.resize(size);
+    return output;
+}
+
+TEST_CASE("Read multi-stream bzip2 file with parallel decompressor") {
+    const int count = count_fds();
+
+    std::string expected;
+    const std::string input_file = "test_bzip2_multistream.txt.bz2";
+    {
+        std::string compressed;
+        uint32_t state = 1;
+        for (int i = 0; i < 60; ++i) {
+            std::string stream_data;
+            for (int j = 0; j < 100000; ++j) {
+                state = state * 1103515245U + 12345U;
+                stream_data += static_cast<char>('a' + (state >> 16U) % 26);
+            }
+            expected += stream_data;
+            compressed += bzip2_stream(stream_data);
+        }
+        const int fd = osmium::io::detail::open_for_writing(input_file, osmium::io::overwrite::allow);
+        osmium::io::detail::reliable_write(fd, compressed.data(), compressed.size());
+        osmium::io::detail::reliable_close(fd);
+    }
+
+    const int fd = osmium::io::detail::open_for_reading(input_file);
+    REQUIRE(fd > 0);
+
+    std::string all;
+    {
+        std::unique_ptr<osmium::io::Decompressor> decomp{osmium::io::detail::make_parallel_decompressor<osmium::io::detail::bzip2_multistream_format>(fd)};
+        REQUIRE(decomp);
+        for (std::string data = decomp->read(); !data.empty(); data = decomp->read()) {
+            all += data;
+        }
+        decomp->close();
+    }
+
+    REQUIRE(all == expected);
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Decompress bzip2 chunk ending in the middle of a stream") {
+    const std::string data(100000, 'a');
+    const std::string compressed = bzip2_stream(data) + bzip2_stream(data);
+
+    const auto result = osmium::io::detail::bzip2_multistream_format::decompress_chunk(compressed.data(), compressed.size() - 10);
+    REQUIRE_FALSE(result.complete);
+
+    const auto full = osmium::io::detail::bzip2_multistream_format::decompress_chunk(compressed.data(), compressed.size());
+    REQUIRE(full.complete);
+    REQUIRE(full.data == data + data);
+}
+
+TEST_CASE("Write multi-stream bzip2 file with parallel compressor") {
+    const int count = count_fds();
+
+    std::string expected;
+    uint32_t state = 1;
+    for (int j = 0; j < 3000000; ++j) {
+        state = state * 1103515245U + 12345U;
+        expected += static_cast<char>('a' + (state >> 16U) % 4);
+    }
+
+    const std::string output_file = "test_bzip2_parallel_out.txt.bz2";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    std::size_t file_size = 0;
+    {
+        osmium::io::detail::ParallelCompressor<osmium::io::detail::bzip2_multistream_compress_format> comp{fd, osmium::io::fsync::no, osmium::thread::Pool::default_instance()};
+        for (std::size_t offset = 0; offset < expected.size(); offset += 100000) {
+            comp.write(expected.substr(offset, 100000));
+        }
+        comp.close();
+        file_size = comp.file_size();
+    }
+    REQUIRE(count == count_fds());
+    REQUIRE(file_size == osmium::file_size(output_file));
+
+    const int rfd = osmium::io::detail::open_for_reading(output_file);
+    osmium::io::Bzip2Decompressor decomp{rfd};
+    std::string all;
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        all += data;
+    }
+    decomp.close();
+    REQUIRE(all == expected);
+
+    REQUIRE(count == count_fds());
+}
@@ -0,0 +1,173 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/columnar_pbf_reader.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace {
+
+    void compare_with_reader(const std::string& filename) {
+        osmium::ColumnarNodeBatch expected_nodes;
+        osmium::ColumnarWayBatch expected_ways;
+        osmium::io::Reader reader{filename, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way};
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            expected_nodes.add_buffer(buffer);
+            expected_ways.add_buffer(buffer);
+        }
+        reader.close();
+
+        osmium::ColumnarNodeBatch nodes;
+        osmium::ColumnarWayBatch ways;
+        osmium::io::ColumnarPBFReader columnar_reader{filename};
+        columnar_reader.for_each_block([&](const osmium::ColumnarBlock& block) {
+            for (std::size_t n = 0; n < block.nodes.size(); ++n) {
+                nodes.add_node(block.nodes.id(n), block.nodes.location(n));
+                for (std::size_t t = 0; t < block.nodes.tag_count(n); ++t) {
+                    nodes.add_tag(block.nodes.tag_key(n, t), block.nodes.tag_value(n, t));
+                }
+            }
+            for (std::size_t n = 0; n < block.ways.size(); ++n) {
+                ways.add_way(block.ways.id(n));
+                for (std::size_t r = 0; r < block.ways.ref_count(n); ++r) {
+                    ways.add_ref(block.ways.ref(n, r));
+                }
+                for (std::size_t t = 0; t < block.ways.tag_count(n); ++t) {
+                    ways.add_tag(block.ways.tag_key(n, t), block.ways.tag_value(n, t));
+                }
+            }
+        });
+
+        REQUIRE(nodes.size() == expected_nodes.size());
+        for (std::size_t n = 0; n < nodes.size(); ++n) {
+            REQUIRE(nodes.id(n) == expected_nodes.id(n));
+            REQUIRE(nodes.location(n) == expected_nodes.location(n));
+            REQUIRE(nodes.tag_count(n) == expected_nodes.tag_count(n));
+            for (std::size_t t = 0; t < nodes.tag_count(n); ++t) {
+                REQUIRE(std::strcmp(nodes.tag_key(n, t), expected_nodes.tag_key(n, t)) == 0);
+                REQUIRE(std::strcmp(nodes.tag_value(n, t), expected_nodes.tag_value(n, t)) == 0);
+            }
+        }
+
+        REQUIRE(ways.size() == expected_ways.size());
+        for (std::size_t n = 0; n < ways.size(); ++n) {
+            REQUIRE(ways.id(n) == expected_ways.id(n));
+            REQUIRE(ways.ref_count(n) == expected_ways.ref_count(n));
+            for (std::size_t r = 0; r < ways.ref_count(n); ++r) {
+                REQUIRE(ways.ref(n, r) == expected_ways.ref(n, r));
+            }
+            REQUIRE(ways.tag_count(n) == expected_ways.tag_count(n));
+            for (std::size_t t = 0; t < ways.tag_count(n); ++t) {
+                REQUIRE(std::strcmp(ways.tag_key(n, t), expected_ways.tag_key(n, t)) == 0);
+                REQUIRE(std::strcmp(ways.tag_value(n, t), expected_ways.tag_value(n, t)) == 0);
+            }
+        }
+    }
+
+    void write_test_file(const std::string& filename, bool dense_nodes) {
+        using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+            if (id % 7 == 0) {
+                osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0 + id * 0.0001, 2.0 - id * 0.0001),
+                                          _tag("amenity", "bench"), _tag("id", std::to_string(id)));
+            } else {
+                osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0 + id * 0.0001, 2.0 - id * 0.0001));
+            }
+        }
+        for (osmium::object_id_type id = 1; id <= 500; ++id) {
+            osmium::builder::add_way(buffer, _id(id), _version(2), _nodes({id, id + 3, id + 1}), _tag("highway", id % 2 ? "primary" : "residential"));
+        }
+
+        osmium::io::File file{filename};
+        file.set("pbf_dense_nodes", dense_nodes ? "true" : "false");
+        osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Columnar PBF reader reads dense nodes") {
+    compare_with_reader(with_data_dir("t/io/data_pbf_version-1-densenodes.osm.pbf"));
+}
+
+TEST_CASE("Columnar PBF reader reads non-dense nodes") {
+    compare_with_reader(with_data_dir("t/io/data_pbf_version-1.osm.pbf"));
+}
+
+TEST_CASE("Columnar PBF reader gives invisible nodes an undefined location") {
+    osmium::io::ColumnarPBFReader reader{with_data_dir("t/io/deleted_nodes.osh.pbf")};
+    std::size_t count = 0;
+    std::size_t undefined = 0;
+    reader.for_each_block([&](const osmium::ColumnarBlock& block) {
+        for (std::size_t n = 0; n < block.nodes.size(); ++n) {
+            ++count;
+            if (!block.nodes.location(n).valid()) {
+                ++undefined;
+            }
+        }
+    });
+    REQUIRE(count > 0);
+    REQUIRE(undefined > 0);
+    REQUIRE(undefined < count);
+}
+
+TEST_CASE("Columnar PBF reader with multiple blobs") {
+    const std::string filename{"test-columnar-pbf-reader.osm.pbf"};
+
+    SECTION("dense nodes") {
+        write_test_file(filename, true);
+        compare_with_reader(filename);
+    }
+
+    SECTION("non-dense nodes") {
+        write_test_file(filename, false);
+        compare_with_reader(filename);
+    }
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Columnar PBF reader reading single blob and selected types") {
+    const std::string filename{"test-columnar-pbf-reader.osm.pbf"};
+    write_test_file(filename, true);
+
+    osmium::io::ColumnarPBFReader reader{filename};
+    REQUIRE(reader.num_data_blobs() > 1);
+
+    SECTION("read single blob") {
+        const auto block = reader.read_blob(0);
+        REQUIRE(block.nodes.size() > 0);
+        REQUIRE(block.nodes.id(0) == 1);
+        REQUIRE(block.nodes.tag_count(0) == 0);
+        REQUIRE(block.nodes.tag_count(6) == 2);
+        REQUIRE(std::strcmp(block.nodes.get_value_by_key(6, "amenity"), "bench") == 0);
+        REQUIRE(block.ways.empty());
+    }
+
+    SECTION("read only ways") {
+        std::size_t nodes = 0;
+        std::size_t ways = 0;
+        reader.for_each_block([&](const osmium::ColumnarBlock& block) {
+            nodes += block.nodes.size();
+            ways += block.ways.size();
+        }, osmium::osm_entity_bits::way);
+        REQUIRE(nodes == 0);
+        REQUIRE(ways == 500);
+    }
+
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,173 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/external_record_sorter.hpp>
+#include <osmium/io/external_sorter.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    osmium::memory::Buffer make_buffer(std::mt19937& gen, int count, int tag) {
+        std::uniform_int_distribution<int> id_dist{-100, 1000};
+        std::uniform_int_distribution<int> version_dist{1, 3};
+
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        for (int i = 0; i < count; ++i) {
+            const auto id = id_dist(gen);
+            const auto version = version_dist(gen);
+            const auto value = std::to_string(tag * count + i);
+            switch (i % 3) {
+                case 0:
+                    osmium::builder::add_node(buffer, _id(id), _version(version), _tag("n", value));
+                    break;
+                case 1:
+                    osmium::builder::add_way(buffer, _id(id), _version(version), _tag("n", value), _nodes({1, 2, 3}));
+                    break;
+                default:
+                    osmium::builder::add_relation(buffer, _id(id), _version(version), _tag("n", value), _member(osmium::item_type::node, 1, "x"));
+                    break;
+            }
+        }
+        return buffer;
+    }
+
+    struct collect_output {
+
+        std::vector<osmium::memory::Buffer>* buffers;
+
+        void operator()(osmium::memory::Buffer&& buffer) {
+            buffers->push_back(std::move(buffer));
+        }
+
+    }; // struct collect_output
+
+    void check_sorted(osmium::io::ExternalSorter& sorter, const std::vector<osmium::memory::Buffer>& input) {
+        osmium::ObjectPointerCollection expected;
+        for (const auto& buffer : input) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                expected.osm_object(const_cast<osmium::OSMObject&>(object)); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+            }
+        }
+        expected.sort(osmium::object_order_type_id_version_without_timestamp{});
+
+        std::vector<osmium::memory::Buffer> output;
+        sorter.finish(collect_output{&output});
+        REQUIRE(sorter.num_runs() == 0);
+
+        auto it = expected.cbegin();
+        for (const auto& buffer : output) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                REQUIRE(it != expected.cend());
+                REQUIRE(object.type() == it->type());
+                REQUIRE(object.id() == it->id());
+                REQUIRE(object.version() == it->version());
+                REQUIRE(std::string{object.tags()["n"]} == it->tags()["n"]);
+                ++it;
+            }
+        }
+        REQUIRE(it == expected.cend());
+    }
+
+} // anonymous namespace
+
+TEST_CASE("External sorter with empty input") {
+    osmium::io::ExternalSorter sorter;
+    std::vector<osmium::memory::Buffer> output;
+    sorter.finish(collect_output{&output});
+    REQUIRE(output.empty());
+}
+
+TEST_CASE("External sorter sorting in memory") {
+    std::mt19937 gen{17}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::vector<osmium::memory::Buffer> input;
+    osmium::io::ExternalSorter sorter;
+
+    for (int n = 0; n < 5; ++n) {
+        input.push_back(make_buffer(gen, 100, n));
+        sorter.add(input.back());
+    }
+
+    REQUIRE(sorter.num_runs() == 0);
+    REQUIRE(sorter.used_memory() > 0);
+    REQUIRE(sorter.used_disk_space() == 0);
+
+    check_sorted(sorter, input);
+    REQUIRE(sorter.used_memory() == 0);
+}
+
+TEST_CASE("External sorter spilling runs to disk") {
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::vector<osmium::memory::Buffer> input;
+    osmium::io::ExternalSorter sorter{16 * 1024};
+
+    for (int n = 0; n < 20; ++n) {
+        input.push_back(make_buffer(gen, 200, n));
+        osmium::memory::Buffer copy{input.back().committed()};
+        copy.add_buffer(input.back());
+        copy.commit();
+        sorter(std::move(copy));
+    }
+
+    REQUIRE(sorter.num_runs() > 1);
+    REQUIRE(sorter.used_disk_space() > 0);
+
+    check_sorted(sorter, input);
+    REQUIRE(sorter.used_disk_space() == 0);
+
+    SECTION("sorter can be reused") {
+        std::vector<osmium::memory::Buffer> input2;
+        input2.push_back(make_buffer(gen, 1000, 0));
+        sorter.add(input2.back());
+        check_sorted(sorter, input2);
+    }
+}
+
+TEST_CASE("External record sorter") {
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::uniform_int_distribution<int64_t> dist{-1000000, 1000000};
+
+    std::size_t count = 0;
+    std::size_t runs = 0;
+
+    SECTION("in memory") {
+        count = 1000;
+    }
+
+    SECTION("spilling runs to disk") {
+        count = 10000;
+        runs = 10;
+    }
+
+    osmium::io::detail::external_record_sorter<int64_t> sorter{1024 * sizeof(int64_t)};
+    REQUIRE(sorter.empty());
+
+    std::vector<int64_t> input;
+    for (std::size_t n = 0; n < count; ++n) {
+        input.push_back(dist(gen));
+        sorter.push_back(input.back());
+    }
+    std::sort(input.begin(), input.end());
+
+    sorter.start_reading();
+    REQUIRE(sorter.size() == count);
+    REQUIRE(sorter.num_runs() == runs);
+
+    std::vector<int64_t> output;
+    for (; sorter.current(); sorter.next()) {
+        output.push_back(*sorter.current());
+    }
+    REQUIRE(output == input);
+
+    sorter.clear();
+    REQUIRE(sorter.empty());
+    REQUIRE(sorter.num_runs() == 0);
+}
@@ -94,6 +94,22 @@ TEST_CASE("Detect file format by suffix 'opl.bz2'") {
     f.check();
 }
 
+TEST_CASE("Detect file format by suffix 'osm.zst'") {
+    const osmium::io::File f{"test.osm.zst"};
+    REQUIRE(osmium::io::file_format::xml == f.format());
+    REQUIRE(osmium::io::file_compression::zstd == f.compression());
+    REQUIRE_FALSE(f.has_multiple_object_versions());
+    f.check();
+}
+
+TEST_CASE("Detect file format by suffix 'opl.lz4'") {
+    const osmium::io::File f{"test.osh.opl.lz4"};
+    REQUIRE(osmium::io::file_format::opl == f.format());
+    REQUIRE(osmium::io::file_compression::lz4 == f.compression());
+    REQUIRE(f.has_multiple_object_versions());
+    f.check();
+}
+
 TEST_CASE("Detect file format by suffix 'osc.gz'") {
     const osmium::io::File f{"test.osc.gz"};
     REQUIRE(osmium::io::file_format::xml == f.format());
@@ -0,0 +1,178 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/generate_changes.hpp>
+#include <osmium/io/indexed_pbf_reader.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    class ChangeCollector {
+
+    public:
+
+        std::vector<std::string> changes;
+
+        static std::string name(const osmium::OSMObject& object) {
+            return osmium::item_type_to_char(object.type()) + std::to_string(object.id());
+        }
+
+        void created(const osmium::OSMObject& object) {
+            changes.push_back("c " + name(object));
+        }
+
+        void modified(const osmium::OSMObject& old_object, const osmium::OSMObject& new_object) {
+            REQUIRE(old_object.id() == new_object.id());
+            changes.push_back("m " + name(new_object));
+        }
+
+        void deleted(const osmium::OSMObject& object) {
+            changes.push_back("d " + name(object));
+        }
+
+    }; // class ChangeCollector
+
+    class BufferSource {
+
+        osmium::memory::Buffer m_buffer;
+
+    public:
+
+        explicit BufferSource(osmium::memory::Buffer&& buffer) :
+            m_buffer(std::move(buffer)) {
+        }
+
+        osmium::memory::Buffer read() {
+            return std::move(m_buffer);
+        }
+
+    }; // class BufferSource
+
+    void write_file(const std::string& filename, bool changed) {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= 30000; ++id) {
+            if (changed && id == 20000) {
+                continue;
+            }
+            if (changed && id == 5) {
+                osmium::builder::add_node(buffer, _id(id), _version(2), _location(1.0, 2.0), _tag("amenity", "pub"));
+            } else {
+                // version and timestamp changes alone are not changes
+                osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0));
+            }
+        }
+        if (changed) {
+            osmium::builder::add_node(buffer, _id(30001), _version(1), _location(3.0, 4.0));
+        }
+        for (osmium::object_id_type id = 1; id <= 100; ++id) {
+            if (changed && id == 50) {
+                osmium::builder::add_way(buffer, _id(id), _version(1), _timestamp("2020-01-01T00:00:00Z"), _nodes({id, id + 2}));
+            } else {
+                osmium::builder::add_way(buffer, _id(id), _version(1), _nodes({id, id + 1}));
+            }
+        }
+
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Generate changes between two files") {
+    const std::string old_filename{"test-generate-changes-old.osm.pbf"};
+    const std::string new_filename{"test-generate-changes-new.osm.pbf"};
+    write_file(old_filename, false);
+    write_file(new_filename, true);
+
+    const std::vector<std::string> expected{"m n5", "d n20000", "c n30001", "m w50"};
+
+    SECTION("using readers") {
+        osmium::io::Reader old_reader{old_filename};
+        osmium::io::Reader new_reader{new_filename};
+        ChangeCollector collector;
+        osmium::io::generate_changes(old_reader, new_reader, collector);
+        old_reader.close();
+        new_reader.close();
+        REQUIRE(collector.changes == expected);
+    }
+
+    SECTION("using indexed PBF readers") {
+        const osmium::io::IndexedPBFReader old_reader{old_filename, "-"};
+        const osmium::io::IndexedPBFReader new_reader{new_filename, "-"};
+        ChangeCollector collector;
+        const auto skipped = osmium::io::generate_changes(old_reader, new_reader, collector);
+        REQUIRE(collector.changes == expected);
+        REQUIRE(skipped > 0);
+        REQUIRE(skipped < old_reader.num_data_blobs());
+    }
+
+    SECTION("same file has no changes and all blobs are skipped") {
+        const osmium::io::IndexedPBFReader reader1{old_filename, "-"};
+        const osmium::io::IndexedPBFReader reader2{old_filename, "-"};
+        ChangeCollector collector;
+        REQUIRE(osmium::io::generate_changes(reader1, reader2, collector) == reader1.num_data_blobs());
+        REQUIRE(collector.changes.empty());
+    }
+
+    SECTION("comparing only tags") {
+        const osmium::io::IndexedPBFReader old_reader{old_filename, "-"};
+        const osmium::io::IndexedPBFReader new_reader{new_filename, "-"};
+        ChangeCollector collector;
+        osmium::io::generate_changes(old_reader, new_reader, collector, osmium::object_hash_fields::tags);
+        const std::vector<std::string> expected_tags{"m n5", "d n20000", "c n30001"};
+        REQUIRE(collector.changes == expected_tags);
+    }
+}
+
+TEST_CASE("Write changes to an OSM change file") {
+    osmium::memory::Buffer old_data{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(old_data, _id(1), _version(1), _location(1.0, 1.0));
+    osmium::builder::add_node(old_data, _id(2), _version(3), _location(1.0, 1.0));
+    osmium::builder::add_node(old_data, _id(3), _version(1), _location(1.0, 1.0));
+
+    osmium::memory::Buffer new_data{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(new_data, _id(1), _version(1), _location(1.0, 1.0));
+    osmium::builder::add_node(new_data, _id(3), _version(2), _location(2.0, 2.0));
+    osmium::builder::add_node(new_data, _id(4), _version(1), _location(2.0, 2.0));
+
+    const std::string filename{"test-generate-changes.osc"};
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    osmium::io::ChangeFileWriter change_writer{writer};
+
+    BufferSource old_source{std::move(old_data)};
+    BufferSource new_source{std::move(new_data)};
+    osmium::io::generate_changes(old_source, new_source, change_writer);
+    writer.close();
+
+    std::ifstream file{filename};
+    const std::string content{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    REQUIRE(content.find("<osmChange") != std::string::npos);
+    REQUIRE(content.find("node id=\"1\"") == std::string::npos);
+
+    const auto del = content.find("<delete>");
+    const auto modify = content.find("<modify>");
+    const auto create = content.find("<create>");
+    REQUIRE(del != std::string::npos);
+    REQUIRE(modify != std::string::npos);
+    REQUIRE(create != std::string::npos);
+    REQUIRE(del < content.find("node id=\"2\""));
+    REQUIRE(content.find("node id=\"2\"") < modify);
+    REQUIRE(modify < content.find("node id=\"3\""));
+    REQUIRE(content.find("node id=\"3\"") < create);
+    REQUIRE(create < content.find("node id=\"4\""));
+}
@@ -5,6 +5,8 @@
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/gzip_compression.hpp>
 
+#include <cstdint>
+#include <memory>
 #include <string>
 
 TEST_CASE("Invalid file descriptor of gzip-compressed file") {
@@ -135,3 +137,129 @@ TEST_CASE("Write gzip-compressed file with implicit close") {
     REQUIRE(osmium::file_size(output_file) > 10);
 }
 
+
+static std::string bgzf_member(const std::string& data) {
+    z_stream zstream{};
+    REQUIRE(deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS | 16, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+
+    std::string extra{"BC\x02\x00\x00\x00", 6};
+    gz_header header{};
+    header.extra = reinterpret_cast<unsigned char*>(&extra[0]);
+    header.extra_len = static_cast<unsigned int>(extra.size());
+    REQUIRE(deflateSetHeader(&zstream, &header) == Z_OK);
+
+    std::string output(deflateBound(&zstream, static_cast<unsigned long>(data.size())) + 32, '\0');
+    zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(data.data()));
+    zstream.avail_in = static_cast<unsigned int>(data.size());
+    zstream.next_out = reinterpret_cast<unsigned char*>(&output[0]);
+    zstream.avail_out = static_cast<unsigned int>(output.size());
+    REQUIRE(deflate(&zstream, Z_FINISH) == Z_STREAM_END);
+    output.resize(zstream.total_out);
+    deflateEnd(&zstream);
+
+    // patch in the block size
+    const auto bsize = output.size() - 1;
+    output[16] = static_cast<char>(bsize & 0xffU);
+    output[17] = static_cast<char>((bsize >> 8U) & 0xffU);
+    return output;
+}
+
+TEST_CASE("Read BGZF file with parallel decompressor") {
+    const int count = count_fds();
+
+    std::string expected;
+    const std::string input_file = "test_gzip_bgzf.txt.gz";
+    {
+        std::string compressed;
+        uint32_t state = 1;
+        for (int i = 0; i < 100; ++i) {
+            std::string member_data;
+            for (int j = 0; j < 40000; ++j) {
+                state = state * 1103515245U + 12345U;
+                member_data += static_cast<char>('a' + (state >> 16U) % 26);
+            }
+            expected += member_data;
+            compressed += bgzf_member(member_data);
+        }
+        const int fd = osmium::io::detail::open_for_writing(input_file, osmium::io::overwrite::allow);
+        osmium::io::detail::reliable_write(fd, compressed.data(), compressed.size());
+        osmium::io::detail::reliable_close(fd);
+    }
+
+    const int fd = osmium::io::detail::open_for_reading(input_file);
+    REQUIRE(fd > 0);
+
+    std::string all;
+    {
+        std::unique_ptr<osmium::io::Decompressor> decomp{osmium::io::detail::make_parallel_decompressor<osmium::io::detail::bgzf_format>(fd)};
+        REQUIRE(decomp);
+        for (std::string data = decomp->read(); !data.empty(); data = decomp->read()) {
+            all += data;
+        }
+        decomp->close();
+    }
+
+    REQUIRE(all == expected);
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Parallel decompressor is not used for normal gzip file") {
+    const std::string input_file = with_data_dir("t/io/data_gzip.txt.gz");
+    const int fd = osmium::io::detail::open_for_reading(input_file);
+    REQUIRE(fd > 0);
+
+    REQUIRE(osmium::io::detail::make_parallel_decompressor<osmium::io::detail::bgzf_format>(fd) == nullptr);
+    osmium::io::detail::reliable_close(fd);
+}
+
+TEST_CASE("Write BGZF file with parallel compressor") {
+    const int count = count_fds();
+
+    std::string expected;
+    uint32_t state = 1;
+    for (int j = 0; j < 3000000; ++j) {
+        state = state * 1103515245U + 12345U;
+        expected += static_cast<char>('a' + (state >> 16U) % 4);
+    }
+
+    const std::string output_file = "test_gzip_parallel_out.txt.gz";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    std::size_t file_size = 0;
+    {
+        osmium::io::detail::ParallelCompressor<osmium::io::detail::bgzf_compress_format> comp{fd, osmium::io::fsync::no, osmium::thread::Pool::default_instance()};
+        for (std::size_t offset = 0; offset < expected.size(); offset += 100000) {
+            comp.write(expected.substr(offset, 100000));
+        }
+        comp.close();
+        file_size = comp.file_size();
+    }
+    REQUIRE(count == count_fds());
+    REQUIRE(file_size == osmium::file_size(output_file));
+
+    SECTION("read with normal decompressor") {
+        const int rfd = osmium::io::detail::open_for_reading(output_file);
+        osmium::io::GzipDecompressor decomp{rfd};
+        std::string all;
+        for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+            all += data;
+        }
+        decomp.close();
+        REQUIRE(all == expected);
+    }
+
+    SECTION("read with parallel decompressor") {
+        const int rfd = osmium::io::detail::open_for_reading(output_file);
+        std::unique_ptr<osmium::io::Decompressor> decomp{osmium::io::detail::make_parallel_decompressor<osmium::io::detail::bgzf_format>(rfd)};
+        REQUIRE(decomp);
+        std::string all;
+        for (std::string data = decomp->read(); !data.empty(); data = decomp->read()) {
+            all += data;
+        }
+        decomp->close();
+        REQUIRE(all == expected);
+    }
+
+    REQUIRE(count == count_fds());
+}
@@ -0,0 +1,227 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/indexed_pbf_reader.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+static std::string read_file_contents(const std::string& filename) {
+    std::ifstream in{filename};
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static void write_test_file(const std::string& filename, const char* format = "") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 30000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0));
+    }
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _version(2), _nodes({id, id + 1}));
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+TEST_CASE("Indexed PBF reader") {
+    const std::string filename{"test-indexed-pbf-reader.osm.pbf"};
+    const std::string index_filename{filename + ".blobidx"};
+    write_test_file(filename);
+    std::remove(index_filename.c_str());
+
+    osmium::io::IndexedPBFReader reader{filename};
+    REQUIRE(reader.num_data_blobs() > 2);
+
+    SECTION("summaries") {
+        const auto& summaries = reader.summaries();
+        REQUIRE(summaries.size() == reader.num_data_blobs());
+        REQUIRE(summaries.front().types == osmium::osm_entity_bits::node);
+        REQUIRE(summaries.front().min_id[0] == 1);
+        REQUIRE(summaries.back().types == osmium::osm_entity_bits::way);
+        REQUIRE(summaries.back().min_id[1] == 1);
+        REQUIRE(summaries.back().max_id[1] == 100);
+    }
+
+    SECTION("read single way") {
+        const auto blobs = reader.find_blobs(osmium::osm_entity_bits::way, 42, 42);
+        REQUIRE(blobs.size() == 1);
+        REQUIRE(blobs[0] == reader.num_data_blobs() - 1);
+
+        const auto buffer = reader.read(osmium::osm_entity_bits::way, 42, 42);
+        REQUIRE(std::distance(buffer.cbegin(), buffer.cend()) == 1);
+        const auto& way = *buffer.cbegin<osmium::Way>();
+        REQUIRE(way.id() == 42);
+        REQUIRE(way.version() == 2);
+        REQUIRE(way.nodes().size() == 2);
+    }
+
+    SECTION("read node range spanning blobs") {
+        const auto buffer = reader.read(osmium::osm_entity_bits::node, 7990, 8010);
+        REQUIRE(std::distance(buffer.cbegin(), buffer.cend()) == 21);
+        osmium::object_id_type id = 7990;
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() == id);
+            ++id;
+        }
+    }
+
+    SECTION("read nothing") {
+        REQUIRE(reader.find_blobs(osmium::osm_entity_bits::relation, 1, 100).empty());
+        REQUIRE(reader.find_blobs(osmium::osm_entity_bits::node, 30001, 40000).empty());
+    }
+
+    SECTION("sidecar index") {
+        reader.summaries();
+        std::ifstream index{index_filename};
+        REQUIRE(index);
+
+        osmium::io::IndexedPBFReader reader2{filename};
+        REQUIRE(reader2.summaries().size() == reader.num_data_blobs());
+        REQUIRE(reader2.read(osmium::osm_entity_bits::way, 1, 5).committed() > 0);
+    }
+
+    SECTION("broken sidecar index is ignored") {
+        {
+            std::ofstream index{index_filename};
+            index << "osmium-pbf-blob-index 1\n1 2\n";
+        }
+        REQUIRE(reader.summaries().size() == reader.num_data_blobs());
+        REQUIRE(reader.read(osmium::osm_entity_bits::way, 1, 5).committed() > 0);
+    }
+
+    SECTION("no sidecar index") {
+        osmium::io::IndexedPBFReader reader2{filename, "-"};
+        REQUIRE(reader2.summaries().size() == reader.num_data_blobs());
+        std::ifstream index{index_filename};
+        REQUIRE_FALSE(index);
+    }
+}
+
+TEST_CASE("Indexed PBF reader on non-PBF file fails") {
+    const std::string filename{"test-indexed-pbf-reader-invalid.osm.pbf"};
+    {
+        std::ofstream out{filename};
+        out << "this is not a PBF file";
+    }
+    REQUIRE_THROWS_AS(osmium::io::IndexedPBFReader{filename}, osmium::pbf_error);
+}
+
+static void check_blob_index(const std::string& filename) {
+    const std::string index_filename{filename + ".blobidx"};
+    const std::string expected_filename{filename + ".expected"};
+    const auto index = read_file_contents(index_filename);
+    REQUIRE_FALSE(index.empty());
+
+    // The index built by the reader must be the same.
+    std::remove(expected_filename.c_str());
+    osmium::io::IndexedPBFReader reader{filename, expected_filename};
+    reader.summaries();
+    REQUIRE(index == read_file_contents(expected_filename));
+    std::remove(expected_filename.c_str());
+
+    osmium::io::IndexedPBFReader reader2{filename};
+    const auto buffer = reader2.read(osmium::osm_entity_bits::way, 42, 42);
+    REQUIRE(std::distance(buffer.cbegin(), buffer.cend()) == 1);
+}
+
+TEST_CASE("PBF writer creates blob index") {
+    const std::string filename{"test-indexed-pbf-writer.osm.pbf"};
+    std::remove((filename + ".blobidx").c_str());
+
+    SECTION("serial encoding") {
+        write_test_file(filename, "pbf,pbf_blob_index=true");
+        check_blob_index(filename);
+    }
+
+    SECTION("parallel encoding") {
+        write_test_file(filename, "pbf,pbf_blob_index=true,pbf_parallel_encoding=true");
+        check_blob_index(filename);
+    }
+
+    SECTION("copied raw blobs") {
+        const std::string input_filename{"test-indexed-pbf-writer-input.osm.pbf"};
+        write_test_file(input_filename);
+        osmium::io::IndexedPBFReader reader{input_filename, "-"};
+
+        osmium::io::Writer writer{osmium::io::File{filename, "pbf,pbf_blob_index=true"}, osmium::io::overwrite::allow};
+        for (std::size_t n = 0; n < reader.num_data_blobs(); ++n) {
+            const auto blob = reader.raw_blob(n);
+            writer.write_raw_blob(std::string{blob.data(), blob.size()});
+        }
+        writer.close();
+
+        check_blob_index(filename);
+    }
+}
+
+TEST_CASE("PBF writer blob index needs uncompressed file") {
+    REQUIRE_THROWS_AS(osmium::io::Writer(osmium::io::File{"test-indexed-pbf-writer.osm.pbf.gz", "pbf.gz,pbf_blob_index=true"}, osmium::io::overwrite::allow), std::invalid_argument);
+}
+
+TEST_CASE("PBF writer clusters nodes spatially") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    const std::string filename{"test-indexed-pbf-cluster.osm.pbf"};
+
+    // Nodes on a 200 x 200 grid, IDs don't follow the locations.
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 40000; ++id) {
+        const auto n = (id * 7919) % 40000;
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(static_cast<double>(n % 200) / 10.0, static_cast<double>(n / 200) / 10.0));
+    }
+    osmium::builder::add_way(buffer, _id(1), _version(1), _nodes({1, 2}));
+
+    {
+        osmium::io::Header header;
+        header.set("sorting", "Type_then_ID");
+        osmium::io::Writer writer{osmium::io::File{filename, "pbf,pbf_cluster_nodes=40000,pbf_blob_index=true"}, header, osmium::io::overwrite::allow};
+        for (const auto& item : buffer) {
+            writer(item);
+        }
+        writer.close();
+    }
+
+    osmium::io::IndexedPBFReader reader{filename};
+    REQUIRE(reader.header().get("sorting").empty());
+
+    const osmium::Box box{1.0, 1.0, 2.0, 2.0};
+    const auto blobs = reader.find_blobs(osmium::osm_entity_bits::node, box);
+    REQUIRE_FALSE(blobs.empty());
+    REQUIRE(blobs.size() < reader.num_data_blobs() - 1);
+
+    std::size_t expected = 0;
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        if (box.contains(node.location())) {
+            ++expected;
+        }
+    }
+
+    const auto result = reader.read(osmium::osm_entity_bits::node, box);
+    REQUIRE(static_cast<std::size_t>(std::distance(result.cbegin(), result.cend())) == expected);
+    for (const auto& node : result.select<osmium::Node>()) {
+        REQUIRE(box.contains(node.location()));
+    }
+
+    // The way doesn't have locations, so its blob always matches.
+    REQUIRE(reader.find_blobs(osmium::osm_entity_bits::way, box).size() == 1);
+
+    // Index written by the writer must include the boxes.
+    std::remove((filename + ".blobidx").c_str());
+    osmium::io::IndexedPBFReader reader2{filename};
+    REQUIRE(reader2.find_blobs(osmium::osm_entity_bits::node, box) == blobs);
+}
@@ -0,0 +1,72 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/json_output.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    osmium::memory::Buffer make_data() {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_node(buffer, _id(1), _version(2), _timestamp("2020-01-02T03:04:05Z"), _cid(3), _uid(4), _user("foo"),
+                                  _location(1.5, -2.25), _tag("name", "a \"b\""));
+        osmium::builder::add_node(buffer, _id(2), _version(1), _location(2.0, 3.0));
+        osmium::builder::add_way(buffer, _id(10), _version(1),
+                                 _node(osmium::NodeRef{1, osmium::Location{1.5, -2.25}}),
+                                 _node(osmium::NodeRef{2, osmium::Location{2.0, 3.0}}),
+                                 _tag("highway", "primary"));
+        osmium::builder::add_relation(buffer, _id(20), _version(1),
+                                      _member(osmium::item_type::way, 10, "outer"),
+                                      _member(osmium::item_type::node, 1, ""));
+        return buffer;
+    }
+
+    std::vector<std::string> write_and_read(const osmium::io::File& file) {
+        osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+        writer(make_data());
+        writer.close();
+
+        std::vector<std::string> lines;
+        std::ifstream in{file.filename()};
+        std::string line;
+        while (std::getline(in, line)) {
+            lines.push_back(line);
+        }
+        std::remove(file.filename().c_str());
+        return lines;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("JSON output format is chosen from suffix") {
+    REQUIRE(osmium::io::File{"foo.json"}.format() == osmium::io::file_format::json);
+    REQUIRE(osmium::io::File{"foo.jsonl"}.format() == osmium::io::file_format::json);
+}
+
+TEST_CASE("JSON output") {
+    const auto lines = write_and_read(osmium::io::File{"test-json-output.jsonl"});
+    REQUIRE(lines.size() == 4);
+    REQUIRE(lines[0] == R"({"type":"node","id":1,"version":2,"timestamp":"2020-01-02T03:04:05Z","changeset":3,"uid":4,"user":"foo","visible":true,"lon":1.5,"lat":-2.25,"tags":{"name":"a \"b\""}})");
+    REQUIRE(lines[1] == R"({"type":"node","id":2,"version":1,"timestamp":null,"changeset":0,"uid":0,"user":"","visible":true,"lon":2,"lat":3,"tags":{}})");
+    REQUIRE(lines[2] == R"({"type":"way","id":10,"version":1,"timestamp":null,"changeset":0,"uid":0,"user":"","visible":true,"refs":[1,2],"tags":{"highway":"primary"}})");
+    REQUIRE(lines[3] == R"({"type":"relation","id":20,"version":1,"timestamp":null,"changeset":0,"uid":0,"user":"","visible":true,"members":[{"type":"way","ref":10,"role":"outer"},{"type":"node","ref":1,"role":""}],"tags":{}})");
+}
+
+TEST_CASE("JSON output without metadata, with locations and WKB") {
+    osmium::io::File file{"test-json-output.json"};
+    file.set("add_metadata", "false");
+    file.set("locations_on_ways");
+    file.set("json_wkb");
+    const auto lines = write_and_read(file);
+    REQUIRE(lines.size() == 4);
+    REQUIRE(lines[1] == R"({"type":"node","id":2,"lon":2,"lat":3,"tags":{},"wkb":"010100000000000000000000400000000000000840"})");
+    REQUIRE(lines[2] == R"({"type":"way","id":10,"refs":[1,2],"coordinates":[[1.5,-2.25],[2,3]],"tags":{"highway":"primary"},"wkb":"010200000002000000000000000000F83F00000000000002C000000000000000400000000000000840"})");
+    REQUIRE(lines[3] == R"({"type":"relation","id":20,"members":[{"type":"way","ref":10,"role":"outer"},{"type":"node","ref":1,"role":""}],"tags":{}})");
+}
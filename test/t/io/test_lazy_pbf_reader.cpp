@@ -0,0 +1,250 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/builder/synthetic_data.hpp>
+#include <osmium/io/lazy_pbf_reader.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+    std::string to_string(const protozero::data_view& view) {
+        return std::string{view.data(), view.size()};
+    }
+
+    std::string describe(const osmium::OSMObject& object) {
+        std::string s = osmium::item_type_to_name(object.type());
+        s += std::to_string(object.id()) + " v" + std::to_string(object.version()) +
+             " c" + std::to_string(object.changeset()) + " t" + object.timestamp().to_iso() +
+             " i" + std::to_string(object.uid()) + " u" + object.user() + (object.visible() ? " V" : " D");
+        for (const auto& tag : object.tags()) {
+            s += ' ';
+            s += tag.key();
+            s += '=';
+            s += tag.value();
+        }
+        if (object.type() == osmium::item_type::node) {
+            const auto& location = static_cast<const osmium::Node&>(object).location();
+            s += " x" + std::to_string(location.x()) + " y" + std::to_string(location.y());
+        } else if (object.type() == osmium::item_type::way) {
+            for (const auto& nr : static_cast<const osmium::Way&>(object).nodes()) {
+                s += " n" + std::to_string(nr.ref()) + '/' + std::to_string(nr.location().x());
+            }
+        } else if (object.type() == osmium::item_type::relation) {
+            for (const auto& member : static_cast<const osmium::Relation&>(object).members()) {
+                s += ' ';
+                s += osmium::item_type_to_char(member.type());
+                s += std::to_string(member.ref()) + '@' + member.role();
+            }
+        }
+        return s;
+    }
+
+    std::vector<std::string> read_with_reader(const std::string& filename) {
+        std::vector<std::string> result;
+        osmium::io::Reader reader{filename, osmium::osm_entity_bits::nwr};
+        while (const osmium::memory::Buffer buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                result.push_back(describe(object));
+            }
+        }
+        reader.close();
+        return result;
+    }
+
+    // Compare the materialized objects and the lazy accessors with the
+    // objects from the normal reader.
+    void compare_with_reader(const std::string& filename) {
+        const auto expected = read_with_reader(filename);
+
+        std::vector<std::string> materialized;
+        std::size_t n = 0;
+        osmium::io::LazyPBFReader lazy_reader{filename};
+        lazy_reader.for_each_block([&](const osmium::io::LazyPBFBlock& block) {
+            osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+            for (const auto object : block) {
+                const auto offset = object.materialize(buffer);
+                const auto& built = buffer.get<osmium::OSMObject>(offset);
+
+                REQUIRE(object.type() == built.type());
+                REQUIRE(object.id() == built.id());
+                REQUIRE(object.version() == built.version());
+                REQUIRE(object.timestamp() == built.timestamp());
+                REQUIRE(object.changeset() == built.changeset());
+                REQUIRE(object.uid() == built.uid());
+                REQUIRE(to_string(object.user()) == built.user());
+                REQUIRE(object.visible() == built.visible());
+
+                std::size_t tags = 0;
+                for (const auto& tag : object.tags()) {
+                    REQUIRE(to_string(tag.value) == built.tags().get_value_by_key(to_string(tag.key).c_str()));
+                    ++tags;
+                }
+                REQUIRE(tags == built.tags().size());
+
+                if (object.type() == osmium::item_type::node) {
+                    REQUIRE(object.location() == static_cast<const osmium::Node&>(built).location());
+                } else if (object.type() == osmium::item_type::way) {
+                    const auto& way_nodes = static_cast<const osmium::Way&>(built).nodes();
+                    REQUIRE(object.nodes().size() == way_nodes.size());
+                    auto it = way_nodes.begin();
+                    for (const auto ref : object.nodes()) {
+                        REQUIRE(ref == it->ref());
+                        ++it;
+                    }
+                } else {
+                    const auto& members = static_cast<const osmium::Relation&>(built).members();
+                    REQUIRE(object.members().size() == members.size());
+                    auto it = members.begin();
+                    for (const auto& member : object.members()) {
+                        REQUIRE(member.type == it->type());
+                        REQUIRE(member.ref == it->ref());
+                        REQUIRE(to_string(member.role) == it->role());
+                        ++it;
+                    }
+                }
+
+                REQUIRE(n < expected.size());
+                REQUIRE(describe(built) == expected[n]);
+                ++n;
+            }
+        });
+
+        REQUIRE(n == expected.size());
+    }
+
+    void write_synthetic_file(const std::string& filename, const char* options) {
+        osmium::builder::SyntheticDataConfig config;
+        config.nodes = 20000;
+        config.ways = 3000;
+        config.relations = 300;
+        config.id_gap = 3;
+
+        osmium::io::File file{filename, std::string{"pbf,"} + options};
+        osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+        osmium::builder::SyntheticDataGenerator{config}.generate(writer);
+        writer.close();
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Lazy PBF reader reads dense nodes") {
+    compare_with_reader(with_data_dir("t/io/data_pbf_version-1-densenodes.osm.pbf"));
+}
+
+TEST_CASE("Lazy PBF reader reads non-dense nodes") {
+    compare_with_reader(with_data_dir("t/io/data_pbf_version-1.osm.pbf"));
+}
+
+TEST_CASE("Lazy PBF reader reads history file with deleted nodes") {
+    compare_with_reader(with_data_dir("t/io/deleted_nodes.osh.pbf"));
+}
+
+TEST_CASE("Lazy PBF reader reads synthetic data") {
+    const std::string filename{"test-lazy-pbf-reader.osm.pbf"};
+
+    SECTION("dense nodes") {
+        write_synthetic_file(filename, "pbf_dense_nodes=true");
+        compare_with_reader(filename);
+    }
+
+    SECTION("non-dense nodes") {
+        write_synthetic_file(filename, "pbf_dense_nodes=false");
+        compare_with_reader(filename);
+    }
+
+    SECTION("without metadata") {
+        write_synthetic_file(filename, "add_metadata=false");
+        compare_with_reader(filename);
+    }
+
+    SECTION("uncompressed with locations on ways") {
+        write_synthetic_file(filename, "pbf_compression=none,locations_on_ways=true");
+        compare_with_reader(filename);
+    }
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Lazy PBF reader looks at tags only") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    const std::string filename{"test-lazy-pbf-reader.osm.pbf"};
+    {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+            if (id % 7 == 0) {
+                osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0), _tag("amenity", "bench"));
+            } else {
+                osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0));
+            }
+        }
+        osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, 3}), _tag("highway", "primary"), _tag("name", "Main St"));
+        osmium::builder::add_relation(buffer, _id(1), _member(osmium::item_type::way, 1, "outer"), _tag("type", "multipolygon"));
+
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    osmium::io::LazyPBFReader reader{filename};
+    REQUIRE(reader.num_data_blobs() > 1);
+
+    SECTION("filter and materialize") {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        reader.for_each_block([&](const osmium::io::LazyPBFBlock& block) {
+            for (const auto object : block) {
+                if (object.tags().has_tag("amenity", "bench") || object.tags().has_key("highway")) {
+                    object.materialize(buffer);
+                }
+            }
+        });
+        REQUIRE(std::distance(buffer.begin<osmium::Node>(), buffer.end<osmium::Node>()) == 20000 / 7);
+        const auto& way = *buffer.select<osmium::Way>().begin();
+        REQUIRE(way.id() == 1);
+        REQUIRE(std::string{way.tags()["name"]} == "Main St");
+        REQUIRE(way.nodes().size() == 3);
+    }
+
+    SECTION("read single blob") {
+        const auto block = reader.read_blob(0);
+        REQUIRE_FALSE(block.empty());
+        REQUIRE(block[0].type() == osmium::item_type::node);
+        REQUIRE(block[0].id() == 1);
+        REQUIRE(block[0].tags().empty());
+        REQUIRE(block[6].tags().get_value_by_key("amenity").size() == 5);
+        REQUIRE(block[6].tags().get_value_by_key("foo").data() == nullptr);
+        REQUIRE(block[6].location() == osmium::Location(1.0, 2.0));
+        REQUIRE(block[6].nodes().empty());
+        REQUIRE(block[6].members().empty());
+    }
+
+    SECTION("read only ways and relations") {
+        std::vector<osmium::item_type> types;
+        reader.for_each_block([&](const osmium::io::LazyPBFBlock& block) {
+            for (const auto object : block) {
+                types.push_back(object.type());
+                if (object.type() == osmium::item_type::relation) {
+                    REQUIRE(object.members().size() == 1);
+                    const auto member = *object.members().begin();
+                    REQUIRE(member.type == osmium::item_type::way);
+                    REQUIRE(member.ref == 1);
+                    REQUIRE(to_string(member.role) == "outer");
+                    REQUIRE(object.location() == osmium::Location{});
+                }
+            }
+        }, osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation);
+        REQUIRE(types == std::vector<osmium::item_type>({osmium::item_type::way, osmium::item_type::relation}));
+    }
+
+    std::remove(filename.c_str());
+}
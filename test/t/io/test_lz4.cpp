@@ -0,0 +1,140 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/lz4_compression.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/util/file.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace {
+
+    std::string test_data() {
+        std::string data;
+        uint32_t state = 1;
+        for (int j = 0; j < 3000000; ++j) {
+            state = state * 1103515245U + 12345U;
+            data += static_cast<char>('a' + (state >> 16U) % 4);
+        }
+        return data;
+    }
+
+    std::string read_file(const std::string& filename) {
+        std::ifstream in{filename, std::ios::binary};
+        return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    }
+
+    std::string read_all(osmium::io::Decompressor& decomp) {
+        std::string all;
+        for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+            all += data;
+        }
+        decomp.close();
+        return all;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Empty lz4-compressed file") {
+    const int count = count_fds();
+
+    const int fd = osmium::io::detail::open_for_reading(with_data_dir("t/io/empty_file"));
+    REQUIRE(fd > 0);
+
+    osmium::io::Lz4Decompressor decomp{fd};
+    REQUIRE(decomp.read().empty());
+    decomp.close();
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Write and read lz4-compressed file") {
+    const int count = count_fds();
+    const std::string expected = test_data();
+
+    const std::string output_file = "test_lz4_out.txt.lz4";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    std::size_t file_size = 0;
+    SECTION("with normal compressor") {
+        osmium::io::Lz4Compressor comp{fd, osmium::io::fsync::no};
+        for (std::size_t offset = 0; offset < expected.size(); offset += 100000) {
+            comp.write(expected.substr(offset, 100000));
+        }
+        comp.close();
+        file_size = comp.file_size();
+    }
+
+    SECTION("with parallel compressor") {
+        osmium::io::detail::ParallelCompressor<osmium::io::detail::lz4_compress_format> comp{fd, osmium::io::fsync::no, osmium::thread::Pool::default_instance()};
+        for (std::size_t offset = 0; offset < expected.size(); offset += 100000) {
+            comp.write(expected.substr(offset, 100000));
+        }
+        comp.close();
+        file_size = comp.file_size();
+    }
+
+    REQUIRE(count == count_fds());
+    REQUIRE(file_size == osmium::file_size(output_file));
+    REQUIRE(file_size < expected.size());
+
+    {
+        osmium::io::Lz4Decompressor decomp{osmium::io::detail::open_for_reading(output_file)};
+        REQUIRE(read_all(decomp) == expected);
+    }
+
+    {
+        const std::string compressed = read_file(output_file);
+        osmium::io::Lz4BufferDecompressor decomp{compressed.data(), compressed.size()};
+        REQUIRE(read_all(decomp) == expected);
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Truncated lz4-compressed file") {
+    const std::string output_file = "test_lz4_truncated.txt.lz4";
+    {
+        osmium::io::Lz4Compressor comp{osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow), osmium::io::fsync::no};
+        comp.write(test_data());
+    }
+
+    const std::string compressed = read_file(output_file);
+    osmium::io::Lz4BufferDecompressor decomp{compressed.data(), compressed.size() / 2};
+    REQUIRE_THROWS_AS(read_all(decomp), osmium::lz4_error);
+}
+
+TEST_CASE("Write and read OPL file with lz4 compression") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.5, 2.5), _tag("name", "node"));
+    }
+
+    const std::string filename{"test-lz4.osm.opl.lz4"};
+    {
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    osmium::io::Reader reader{filename};
+    std::size_t count = 0;
+    while (const auto buffer = reader.read()) {
+        count += static_cast<std::size_t>(std::distance(buffer.begin(), buffer.end()));
+    }
+    reader.close();
+    REQUIRE(count == 1000);
+}
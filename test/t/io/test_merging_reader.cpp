@@ -0,0 +1,159 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/merging_reader.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    using object_info = std::tuple<osmium::item_type, osmium::object_id_type, osmium::object_version_type, std::string>;
+
+    class TestFile {
+
+        osmium::memory::Buffer m_buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        std::string m_source;
+
+    public:
+
+        explicit TestFile(std::string source) :
+            m_source(std::move(source)) {
+        }
+
+        TestFile& nodes(osmium::object_id_type first, osmium::object_id_type last, osmium::object_id_type step = 1, osmium::object_version_type version = 1) {
+            for (osmium::object_id_type id = first; id <= last; id += step) {
+                osmium::builder::add_node(m_buffer, _id(id), _version(version), _location(1.0, 2.0), _tag("src", m_source));
+            }
+            return *this;
+        }
+
+        TestFile& ways(osmium::object_id_type first, osmium::object_id_type last) {
+            for (osmium::object_id_type id = first; id <= last; ++id) {
+                osmium::builder::add_way(m_buffer, _id(id), _version(1), _nodes({1, 2}), _tag("src", m_source));
+            }
+            return *this;
+        }
+
+        osmium::io::File write() {
+            const std::string filename{"test-merging-reader-" + m_source + ".opl"};
+            osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+            writer(std::move(m_buffer));
+            writer.close();
+            return osmium::io::File{filename};
+        }
+
+    }; // class TestFile
+
+    std::vector<object_info> read_all(osmium::io::MergingReader& reader) {
+        std::vector<object_info> result;
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                result.emplace_back(object.type(), object.id(), object.version(), object.tags()["src"]);
+            }
+        }
+        reader.close();
+        return result;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Merging reader with disjoint inputs passes buffers through") {
+    const std::vector<osmium::io::File> files{
+        TestFile{"a"}.nodes(1, 5000).write(),
+        TestFile{"b"}.nodes(5001, 10000).write()
+    };
+
+    osmium::io::MergingReader reader{files, osmium::io::merge_duplicates::keep, osmium::io::reader_buffer_size{0, osmium::io::buffer_policy::fixed, 100}};
+    REQUIRE(reader.num_inputs() == 2);
+    REQUIRE_FALSE(reader.header().has_multiple_object_versions());
+
+    const auto result = read_all(reader);
+    REQUIRE(result.size() == 10000);
+    for (std::size_t n = 0; n < result.size(); ++n) {
+        REQUIRE(std::get<1>(result[n]) == static_cast<osmium::object_id_type>(n + 1));
+    }
+
+    REQUIRE(reader.stats().objects_copied == 0);
+    REQUIRE(reader.stats().buffers_passed_through >= 100);
+    REQUIRE(reader.stats().duplicates_removed == 0);
+}
+
+TEST_CASE("Merging reader with overlapping inputs") {
+    osmium::thread::Pool pool{2};
+
+    const std::vector<osmium::io::File> files{
+        TestFile{"a"}.nodes(1, 999, 2).ways(1, 10).write(),
+        TestFile{"b"}.nodes(2, 1000, 2).nodes(1001, 1100).ways(5, 20).write(),
+        TestFile{"c"}.nodes(1, 199, 2).nodes(1050, 1100).write(),
+        TestFile{"d"}.write()
+    };
+
+    std::vector<object_info> result;
+
+    SECTION("keep duplicates") {
+        osmium::io::MergingReader reader{files, osmium::io::merge_duplicates::keep, pool};
+        result = read_all(reader);
+        REQUIRE(result.size() == 1100 + 20 + 100 + 51 + 6);
+        REQUIRE(reader.stats().duplicates_removed == 0);
+
+        // Duplicates are returned in the order of the inputs.
+        REQUIRE(result[0] == object_info(osmium::item_type::node, 1, 1, "a"));
+        REQUIRE(result[1] == object_info(osmium::item_type::node, 1, 1, "c"));
+        REQUIRE(result[2] == object_info(osmium::item_type::node, 2, 1, "b"));
+    }
+
+    SECTION("remove duplicates") {
+        osmium::io::MergingReader reader{files, osmium::io::merge_duplicates::remove, pool};
+        result = read_all(reader);
+        REQUIRE(result.size() == 1100 + 20);
+        REQUIRE(reader.stats().duplicates_removed == 100 + 51 + 6);
+        REQUIRE(reader.stats().objects_copied + reader.stats().duplicates_removed > 0);
+
+        for (std::size_t n = 0; n < 1100; ++n) {
+            REQUIRE(std::get<0>(result[n]) == osmium::item_type::node);
+            REQUIRE(std::get<1>(result[n]) == static_cast<osmium::object_id_type>(n + 1));
+        }
+
+        // The first input with an object wins.
+        REQUIRE(std::get<3>(result[0]) == "a");
+        REQUIRE(std::get<3>(result[1049]) == "b");
+        REQUIRE(std::get<3>(result[1100 + 4]) == "a");
+        REQUIRE(std::get<3>(result[1100 + 10]) == "b");
+    }
+
+    for (std::size_t n = 1; n < result.size(); ++n) {
+        REQUIRE_FALSE(std::make_tuple(std::get<0>(result[n]), std::get<1>(result[n])) <
+                      std::make_tuple(std::get<0>(result[n - 1]), std::get<1>(result[n - 1])));
+    }
+}
+
+TEST_CASE("Merging reader keeps different versions") {
+    const std::vector<osmium::io::File> files{
+        TestFile{"v1"}.nodes(1, 10, 1, 1).write(),
+        TestFile{"v2"}.nodes(1, 10, 1, 2).write()
+    };
+
+    osmium::io::MergingReader reader{files, osmium::io::merge_duplicates::remove};
+    const auto result = read_all(reader);
+    REQUIRE(result.size() == 20);
+    REQUIRE(result[0] == object_info(osmium::item_type::node, 1, 1, "v1"));
+    REQUIRE(result[1] == object_info(osmium::item_type::node, 1, 2, "v2"));
+    REQUIRE(result[19] == object_info(osmium::item_type::node, 10, 2, "v2"));
+}
+
+TEST_CASE("Merging reader without inputs") {
+    osmium::io::MergingReader reader{std::vector<osmium::io::File>{}, osmium::io::merge_duplicates::keep};
+    REQUIRE_FALSE(reader.read());
+    reader.close();
+}
@@ -0,0 +1,138 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/gzip_compression.hpp>
+#include <osmium/io/ids_output.hpp>
+#include <osmium/io/multi_writer.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/shared_buffer.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static osmium::memory::Buffer get_buffer() {
+    osmium::io::Reader reader{with_data_dir("t/io/data.osm")};
+    osmium::memory::Buffer buffer = reader.read();
+    REQUIRE(buffer);
+    REQUIRE(buffer.committed() > 0);
+    return buffer;
+}
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream in{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+static long count_objects(const std::string& filename) {
+    osmium::io::Reader reader{filename};
+    long count = 0;
+    while (const auto buffer = reader.read()) {
+        count += std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend());
+    }
+    reader.close();
+    return count;
+}
+
+static void remove_files(const std::vector<osmium::io::File>& files) {
+    for (const auto& file : files) {
+        std::remove(file.filename().c_str());
+    }
+}
+
+TEST_CASE("Writer with several files of the same format") {
+    const std::vector<osmium::io::File> files{
+        osmium::io::File{"test-writer-multi-1.opl"},
+        osmium::io::File{"test-writer-multi-2.opl"},
+        osmium::io::File{"test-writer-multi-3.opl.gz"}
+    };
+
+    osmium::memory::Buffer buffer{get_buffer()};
+    const auto num = std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend());
+
+    osmium::io::Writer writer{files, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    REQUIRE(writer.close() > 0);
+
+    const std::string data{read_file(files[0].filename())};
+    REQUIRE_FALSE(data.empty());
+    REQUIRE(data == read_file(files[1].filename()));
+    REQUIRE(count_objects(files[2].filename()) == num);
+
+    remove_files(files);
+}
+
+TEST_CASE("Writer with files of different formats fails") {
+    const std::vector<osmium::io::File> files{
+        osmium::io::File{"test-writer-multi-fail.opl"},
+        osmium::io::File{"test-writer-multi-fail.osm"}
+    };
+    REQUIRE_THROWS_AS(osmium::io::Writer(files, osmium::io::overwrite::allow), std::invalid_argument);
+    REQUIRE_THROWS_AS(osmium::io::Writer(std::vector<osmium::io::File>{}), std::invalid_argument);
+}
+
+TEST_CASE("MultiWriter") {
+    const std::vector<osmium::io::File> files{
+        osmium::io::File{"test-multi-writer-1.opl"},
+        osmium::io::File{"test-multi-writer-2.osm"},
+        osmium::io::File{"test-multi-writer-3.opl.gz"},
+        osmium::io::File{"test-multi-writer-4.opl", "opl,add_metadata=false"},
+        osmium::io::File{"test-multi-writer-5.ids"}
+    };
+
+    osmium::io::MultiWriter writer{files, osmium::io::overwrite::allow};
+    REQUIRE(writer.num_encoders() == 4);
+
+    osmium::memory::Buffer buffer{get_buffer()};
+    const auto num = std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend());
+
+    SECTION("write buffer") {
+        writer(std::move(buffer));
+    }
+
+    SECTION("write items") {
+        writer.set_buffer_size(1024);
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            writer(object);
+        }
+    }
+
+    SECTION("write shared buffer") {
+        const auto shared = std::make_shared<const osmium::memory::Buffer>(std::move(buffer));
+        writer.write_shared(shared);
+        writer.write_shared(shared);
+    }
+
+    SECTION("write SharedBuffer") {
+        const osmium::memory::SharedBuffer shared{std::move(buffer)};
+        writer.write_shared(shared);
+        writer.write_shared(shared);
+        REQUIRE(shared.use_count() >= 1);
+    }
+
+    REQUIRE(writer.close() > 0);
+
+    const auto expected = count_objects(files[0].filename());
+    REQUIRE(expected > 0);
+    REQUIRE((expected == num || expected == 2 * num));
+    REQUIRE(count_objects(files[1].filename()) == expected);
+    REQUIRE(count_objects(files[2].filename()) == expected);
+    REQUIRE(count_objects(files[3].filename()) == expected);
+    REQUIRE(read_file(files[0].filename()) != read_file(files[3].filename()));
+
+    const std::string ids{read_file(files[4].filename())};
+    REQUIRE(std::count(ids.begin(), ids.end(), '\n') == expected);
+
+    remove_files(files);
+}
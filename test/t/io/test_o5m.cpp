@@ -0,0 +1,268 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/opl_output_format.hpp>
+#include <osmium/io/o5m_input.hpp>
+#include <osmium/io/o5m_output.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+namespace oid = osmium::io::detail;
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::string o5m_header(char type = 'm') {
+    return std::string{"\xff\xe0\x04o5"} + type + '2';
+}
+
+static std::string encode(osmium::memory::Buffer&& buffer, const char* metadata = "all") {
+    oid::o5m_output_options options;
+    options.add_metadata = osmium::metadata_options{metadata};
+    return oid::O5mOutputBlock{std::move(buffer), options}();
+}
+
+static osmium::memory::Buffer read_o5m(const std::string& data) {
+    const osmium::io::File file{data.data(), data.size(), "o5m"};
+    osmium::io::Reader reader{file};
+    osmium::memory::Buffer result{1024, osmium::memory::Buffer::auto_grow::yes};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        result.add_buffer(buffer);
+        result.commit();
+    }
+    reader.close();
+    return result;
+}
+
+static std::string to_opl(const osmium::memory::Buffer& buffer) {
+    osmium::memory::Buffer copy{buffer.committed() + 8};
+    copy.add_buffer(buffer);
+    copy.commit();
+    oid::opl_output_options options;
+    options.add_metadata = osmium::metadata_options{"all"};
+    return oid::OPLOutputBlock{std::move(copy), options}();
+}
+
+static osmium::memory::Buffer create_test_data() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    const std::string long_value(300, 'x');
+
+    osmium::builder::add_node(buffer, _id(10), _version(2), _cid(100), _uid(7), _user("foo"),
+                              _timestamp(osmium::Timestamp{"2016-01-01T00:00:00Z"}),
+                              _location(1.5, -2.25), _tag("amenity", "pub"), _tag("name", "Pub"));
+    osmium::builder::add_node(buffer, _id(11), _version(1), _cid(99), _uid(7), _user("foo"),
+                              _timestamp(osmium::Timestamp{"2015-01-01T00:00:00Z"}),
+                              _location(-179.9999999, 89.9999999), _tag("amenity", "pub"), _tag("long", long_value.c_str()));
+    osmium::builder::add_node(buffer, _id(12), _version(3), _cid(101), _uid(8), _user(""),
+                              _timestamp(osmium::Timestamp{"2017-01-01T00:00:00Z"}),
+                              _location(0.0, 0.0), _tag("long", long_value.c_str()));
+    osmium::builder::add_node(buffer, _id(13), _version(1), _cid(102), _uid(0),
+                              _timestamp(osmium::Timestamp{"2017-01-01T00:00:01Z"}),
+                              _location(3.0, 4.0));
+    osmium::builder::add_node(buffer, _id(14), _version(4), _cid(103), _uid(8), _user("bar"),
+                              _timestamp(osmium::Timestamp{"2017-01-01T00:00:02Z"}),
+                              _deleted());
+    osmium::builder::add_way(buffer, _id(20), _version(1), _cid(100), _uid(7), _user("foo"),
+                             _timestamp(osmium::Timestamp{"2016-01-01T00:00:00Z"}),
+                             _nodes({10, 11, 12, 10}), _tag("highway", "residential"), _tag("name", "Pub"));
+    osmium::builder::add_way(buffer, _id(21), _version(1), _cid(100), _uid(7), _user("foo"),
+                             _timestamp(osmium::Timestamp{"2016-01-01T00:00:00Z"}));
+    osmium::builder::add_relation(buffer, _id(30), _version(1), _cid(100), _uid(8), _user("bar"),
+                                  _timestamp(osmium::Timestamp{"2016-01-01T00:00:00Z"}),
+                                  _member(osmium::item_type::node, 10, "stop"),
+                                  _member(osmium::item_type::way, 20, ""),
+                                  _member(osmium::item_type::relation, 31, "stop"),
+                                  _member(osmium::item_type::node, 11, "stop"),
+                                  _tag("type", "route"));
+    osmium::builder::add_relation(buffer, _id(31), _version(2), _cid(100), _uid(8), _user("bar"),
+                                  _timestamp(osmium::Timestamp{"2016-01-01T00:00:00Z"}),
+                                  _deleted());
+
+    return buffer;
+}
+
+TEST_CASE("o5m string table") {
+    oid::O5mStringTable table;
+
+    REQUIRE(table.find("foo") == 0);
+    table.add("foo");
+    REQUIRE(table.find("foo") == 1);
+    table.add("bar");
+    REQUIRE(table.find("foo") == 2);
+    REQUIRE(table.find("bar") == 1);
+
+    table.add(std::string(oid::o5m_string_table_max_length + 1, 'x'));
+    REQUIRE(table.find(std::string(oid::o5m_string_table_max_length + 1, 'x')) == 0);
+    REQUIRE(table.find("foo") == 2);
+
+    for (std::size_t i = 0; i < oid::o5m_string_table_entries - 2; ++i) {
+        table.add(std::to_string(i));
+    }
+    REQUIRE(table.find("foo") == oid::o5m_string_table_entries);
+    table.add("baz");
+    REQUIRE(table.find("foo") == 0);
+    REQUIRE(table.find("bar") == oid::o5m_string_table_entries);
+
+    table.clear();
+    REQUIRE(table.find("bar") == 0);
+}
+
+TEST_CASE("o5m output block starts with reset") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _location(1.0, 2.0));
+    osmium::builder::add_way(buffer, _id(2), _nodes({1}));
+
+    const std::string data = encode(std::move(buffer), "none");
+    // reset, node dataset (id 1, no info, lon, lat), reset, way dataset
+    // (id 2, no info, refs length 1, ref 1)
+    REQUIRE(data == std::string{"\xff\x10\x0a\x02\x00\x80\xda\xc4\x09\x80\xb4\x89\x13"
+                                "\xff\x11\x04\x04\x00\x01\x02", 20});
+}
+
+TEST_CASE("Write and read o5m") {
+    auto input = create_test_data();
+    const std::string expected = to_opl(input);
+
+    const std::string data = o5m_header() + encode(std::move(input));
+    const auto result = read_o5m(data);
+
+    REQUIRE(to_opl(result) == expected);
+}
+
+TEST_CASE("Write and read o5m with several blocks") {
+    std::string data = o5m_header();
+    std::string expected;
+    for (int i = 0; i < 3; ++i) {
+        auto input = create_test_data();
+        expected += to_opl(input);
+        data += encode(std::move(input));
+    }
+    data += '\xfe';
+
+    REQUIRE(to_opl(read_o5m(data)) == expected);
+}
+
+TEST_CASE("Write and read o5m without metadata") {
+    osmium::memory::Buffer input{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(input, _id(1), _location(1.0, 2.0), _tag("a", "b"));
+    osmium::builder::add_node(input, _id(2), _location(1.0, 2.0), _tag("a", "b"));
+    const std::string expected = to_opl(input);
+
+    const std::string data = o5m_header() + encode(std::move(create_test_data()), "none");
+    const auto result = read_o5m(data);
+    for (const auto& object : result.select<osmium::OSMObject>()) {
+        REQUIRE(object.version() == 0);
+        REQUIRE(object.timestamp() == osmium::Timestamp{});
+        REQUIRE(object.uid() == 0);
+    }
+
+    REQUIRE(to_opl(read_o5m(o5m_header() + encode(std::move(input), "none"))) == expected);
+}
+
+TEST_CASE("Write o5m and o5c files with writer") {
+    const auto check = [](const char* filename, bool change_file) {
+        {
+            osmium::io::Header header;
+            header.add_box(osmium::Box{1.0, 2.0, 3.0, 4.0});
+            header.set("timestamp", "2020-01-01T00:00:00Z");
+            osmium::io::Writer writer{filename, header, osmium::io::overwrite::allow};
+            writer(create_test_data());
+            writer.close();
+        }
+
+        osmium::io::Reader reader{filename};
+        const auto header = reader.header();
+        REQUIRE(header.has_multiple_object_versions() == change_file);
+        REQUIRE(header.boxes().size() == 1);
+        REQUIRE(header.boxes().front() == (osmium::Box{1.0, 2.0, 3.0, 4.0}));
+        REQUIRE(header.get("timestamp") == "2020-01-01T00:00:00Z");
+
+        osmium::memory::Buffer result{1024, osmium::memory::Buffer::auto_grow::yes};
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            result.add_buffer(buffer);
+            result.commit();
+        }
+        reader.close();
+        REQUIRE(to_opl(result) == to_opl(create_test_data()));
+    };
+
+    check("test-o5m-out.o5m", false);
+    check("test-o5m-out.o5c", true);
+}
+
+TEST_CASE("Reading o5m in parallel gives same result as reading serially") {
+    std::string data = o5m_header();
+    for (int b = 0; b < 40; ++b) {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (int i = 1; i <= 10000; ++i) {
+            const auto id = b * 10000 + i;
+            const std::string name{"node " + std::to_string(id)};
+            osmium::builder::add_node(buffer, _id(id), _version(1), _cid(id / 10), _uid(id / 100), _user("foo"),
+                                      _timestamp(osmium::Timestamp{1500000000 + id}),
+                                      _location(id * 0.0001, 1.0), _tag("name", name.c_str()));
+        }
+        data += encode(std::move(buffer));
+    }
+    for (const auto* filename : {"t/io/data-n5w1r3.osm.o5m", "t/io/data-n0w1r3.osm.o5m"}) {
+        REQUIRE(::unsetenv("OSMIUM_USE_PARALLEL_O5M_PARSING") == 0);
+        const auto serial = osmium::io::read_file(with_data_dir(filename));
+        REQUIRE(::setenv("OSMIUM_USE_PARALLEL_O5M_PARSING", "yes", 1) == 0);
+        const auto parallel = osmium::io::read_file(with_data_dir(filename));
+        REQUIRE(serial.committed() > 0);
+        REQUIRE(to_opl(serial) == to_opl(parallel));
+    }
+    REQUIRE(data.size() > 8 * 1024 * 1024);
+
+    REQUIRE(::unsetenv("OSMIUM_USE_PARALLEL_O5M_PARSING") == 0);
+    const auto serial = read_o5m(data);
+    REQUIRE(::setenv("OSMIUM_USE_PARALLEL_O5M_PARSING", "yes", 1) == 0);
+    const auto parallel = read_o5m(data);
+    REQUIRE(::unsetenv("OSMIUM_USE_PARALLEL_O5M_PARSING") == 0);
+
+    REQUIRE(serial.committed() > 0);
+    REQUIRE(serial.committed() == parallel.committed());
+    REQUIRE(std::equal(serial.data(), serial.data() + serial.committed(), parallel.data()));
+}
+
+TEST_CASE("Reading o5m in parallel without reset points gives same result as reading serially") {
+    // All objects are in one output block, so there are no reset points
+    // after the first one and the chunks have to be cut in between.
+    osmium::memory::Buffer buffer{16 * 1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = 1; id <= 300000; ++id) {
+        const std::string name{"node " + std::to_string(id % 20000)};
+        const std::string user{"user " + std::to_string(id % 5000)};
+        osmium::builder::add_node(buffer, _id(id), _version(1), _cid(id / 10), _uid(id % 5000), _user(user.c_str()),
+                                  _timestamp(osmium::Timestamp{1500000000 + id}),
+                                  _location(id * 0.0001, 1.0), _tag("name", name.c_str()));
+    }
+    for (int id = 1; id <= 20000; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _version(1), _cid(id), _uid(7), _user("foo"),
+                                 _timestamp(osmium::Timestamp{1500000000 + id}),
+                                 _nodes({id, id + 1, id + 2}), _tag("highway", "residential"));
+    }
+    for (int id = 1; id <= 2000; ++id) {
+        const std::string role{"role " + std::to_string(id % 100)};
+        osmium::builder::add_relation(buffer, _id(id), _version(1), _cid(id), _uid(8), _user("bar"),
+                                      _timestamp(osmium::Timestamp{1500000000 + id}),
+                                      _member(osmium::item_type::node, id, role.c_str()),
+                                      _member(osmium::item_type::way, id + 5, ""),
+                                      _tag("type", "route"));
+    }
+    const std::string data = o5m_header() + encode(std::move(buffer));
+    REQUIRE(data.size() > 8 * 1024 * 1024);
+
+    REQUIRE(::unsetenv("OSMIUM_USE_PARALLEL_O5M_PARSING") == 0);
+    const auto serial = read_o5m(data);
+    REQUIRE(::setenv("OSMIUM_USE_PARALLEL_O5M_PARSING", "yes", 1) == 0);
+    const auto parallel = read_o5m(data);
+    REQUIRE(::unsetenv("OSMIUM_USE_PARALLEL_O5M_PARSING") == 0);
+
+    REQUIRE(serial.committed() > 0);
+    REQUIRE(serial.committed() == parallel.committed());
+    REQUIRE(to_opl(serial) == to_opl(parallel));
+}
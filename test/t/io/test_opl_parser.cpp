@@ -7,8 +7,10 @@
 #include <osmium/opl.hpp>
 
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <initializer_list>
+#include <iterator>
 #include <string>
 #include <vector>
 
@@ -1307,3 +1309,76 @@ TEST_CASE("line_by_line for OPL parser 28") {
     check_lbl({"foo\nb", "ar"}, {"foo", "bar"});
 }
 
+
+TEST_CASE("Count lines in OPL data") {
+    const auto count = [](const std::string& data) {
+        return oid::opl_count_lines(data.data(), data.data() + data.size());
+    };
+    REQUIRE(count("") == 0);
+    REQUIRE(count("\n") == 0);
+    REQUIRE(count("foo") == 1);
+    REQUIRE(count("foo\n") == 1);
+    REQUIRE(count("foo\r\nbar\r\n") == 2);
+    REQUIRE(count("\n\nfoo\n\n\nbar\rbaz") == 3);
+}
+
+TEST_CASE("Parse OPL chunk") {
+    std::string data{"n1 v1\r\n\nw2 Nn1,n2\n# comment\nr3 Mn1@\n"};
+
+    const auto buffer = oid::opl_parse_chunk(data, 0, osmium::osm_entity_bits::all);
+    REQUIRE(std::distance(buffer.begin(), buffer.end()) == 3);
+
+    std::string ways_only{"n1 v1\nw2 Nn1,n2\n"};
+    const auto way_buffer = oid::opl_parse_chunk(ways_only, 0, osmium::osm_entity_bits::way);
+    REQUIRE(std::distance(way_buffer.begin(), way_buffer.end()) == 1);
+}
+
+TEST_CASE("Parse OPL chunk with error reports line number") {
+    std::string data{"n1\n\nn2\nx3\n"};
+    try {
+        oid::opl_parse_chunk(data, 10, osmium::osm_entity_bits::all);
+        REQUIRE(false);
+    } catch (const osmium::opl_error& e) {
+        REQUIRE(e.line == 12);
+    }
+}
+
+static osmium::memory::Buffer read_opl(const std::string& data) {
+    const osmium::io::File file{data.data(), data.size(), "opl"};
+    osmium::io::Reader reader{file};
+    osmium::memory::Buffer result{1024, osmium::memory::Buffer::auto_grow::yes};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        result.add_buffer(buffer);
+        result.commit();
+    }
+    reader.close();
+    return result;
+}
+
+TEST_CASE("Reading OPL in parallel gives same result as reading serially") {
+    std::string data;
+    for (int i = 1; i <= 100000; ++i) {
+        data += "n" + std::to_string(i) + " v1 dV c1 t2016-01-01T00:00:00Z i1 ufoo Tname=node%20%" + std::to_string(i) + " x1.5 y2.5\n";
+    }
+    for (int i = 1; i <= 50000; ++i) {
+        data += "w" + std::to_string(i) + " v1 dV c1 t2016-01-01T00:00:00Z i1 ufoo T Nn" + std::to_string(i) + ",n" + std::to_string(i + 1) + "\r\n";
+    }
+    REQUIRE(data.size() > 8 * 1024 * 1024);
+
+    const auto serial = read_opl(data);
+    REQUIRE(::setenv("OSMIUM_USE_PARALLEL_OPL_PARSING", "yes", 1) == 0);
+    const auto parallel = read_opl(data);
+
+    data += "x\n";
+    try {
+        read_opl(data);
+        REQUIRE(false);
+    } catch (const osmium::opl_error& e) {
+        REQUIRE(e.line == 150000);
+    }
+    REQUIRE(::unsetenv("OSMIUM_USE_PARALLEL_OPL_PARSING") == 0);
+
+    REQUIRE(serial.committed() > 0);
+    REQUIRE(serial.committed() == parallel.committed());
+    REQUIRE(std::equal(serial.data(), serial.data() + serial.committed(), parallel.data()));
+}
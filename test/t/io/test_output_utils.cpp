@@ -1,8 +1,11 @@
 #include "catch.hpp"
 
+#include <osmium/io/detail/output_format.hpp>
 #include <osmium/io/detail/string_util.hpp>
 
+#include <cstdint>
 #include <iterator>
+#include <limits>
 #include <locale>
 #include <stdexcept>
 #include <string>
@@ -107,6 +110,33 @@ TEST_CASE("html encoding encodes special XML characters") {
     REQUIRE(out == "&amp; &quot; &apos; &lt; &gt; &#xA; &#xD; &#x9;");
 }
 
+TEST_CASE("html encoding of empty string") {
+    std::string out;
+    osmium::io::detail::append_xml_encoded_string(out, "");
+    REQUIRE(out.empty());
+}
+
+TEST_CASE("html encoding of special characters between normal text") {
+    const char* s = "<tag> a&b 'x' \"y\"\tz";
+    std::string out{"prefix:"};
+    osmium::io::detail::append_xml_encoded_string(out, s);
+    REQUIRE(out == "prefix:&lt;tag&gt; a&amp;b &apos;x&apos; &quot;y&quot;&#x9;z");
+}
+
+TEST_CASE("json encoding does not encode normal characters") {
+    const char* s = u8cast(u8"abc 123,.-/<>'\u30dc");
+    std::string out;
+    osmium::io::detail::append_json_encoded_string(out, s);
+    REQUIRE(out == s);
+}
+
+TEST_CASE("json encoding encodes special characters") {
+    const char* s = "\" \\ \n \r \t \x01 \x1f";
+    std::string out{"prefix:"};
+    osmium::io::detail::append_json_encoded_string(out, s);
+    REQUIRE(out == "prefix:\\\" \\\\ \\n \\r \\t \\u0001 \\u001f");
+}
+
 TEST_CASE("debug encoding does not encode normal characters") {
     const char* s = "abc123,.-";
     std::string out;
@@ -225,3 +255,62 @@ TEST_CASE("incomplete Unicode codepoint") {
     }
 }
 
+
+TEST_CASE("utf8 encoding of special characters between normal text") {
+    std::string out;
+    osmium::io::detail::append_utf8_encoded_string(out, u8cast(u8"abc def,ghi=jkl@mno%pqr\u00e4\u30dcxyz"));
+    REQUIRE(out == u8cast(u8"abc%20%def%2c%ghi%3d%jkl%40%mno%25%pqr\u00e4%30dc%xyz"));
+}
+
+TEST_CASE("utf8 encoding agrees with list of plain ASCII characters") {
+    char s[] = "xa\0";
+
+    for (char c = 1; c < 0x7f; ++c) {
+        std::string out;
+        s[1] = c;
+        osmium::io::detail::append_utf8_encoded_string(out, s);
+        if (osmium::io::detail::is_opl_plain_ascii(c)) {
+            REQUIRE(out.size() == 2);
+            REQUIRE(out[1] == c);
+        } else {
+            REQUIRE(out.size() > 2);
+            REQUIRE(out[1] == '%');
+        }
+    }
+}
+
+static std::string format_int(int64_t value) {
+    char temp[osmium::io::detail::OutputBlock::max_int_length];
+    char* const end = temp + osmium::io::detail::OutputBlock::max_int_length;
+    return std::string{osmium::io::detail::OutputBlock::format_int(value, end), end};
+}
+
+TEST_CASE("format integers") {
+    REQUIRE(format_int(0) == "0");
+    REQUIRE(format_int(7) == "7");
+    REQUIRE(format_int(10) == "10");
+    REQUIRE(format_int(99) == "99");
+    REQUIRE(format_int(100) == "100");
+    REQUIRE(format_int(12345) == "12345");
+    REQUIRE(format_int(-1) == "-1");
+    REQUIRE(format_int(-4711) == "-4711");
+    REQUIRE(format_int(std::numeric_limits<int64_t>::max()) == std::to_string(std::numeric_limits<int64_t>::max()));
+    REQUIRE(format_int(std::numeric_limits<int64_t>::min()) == std::to_string(std::numeric_limits<int64_t>::min()));
+
+    for (int64_t v = 1; v < 1000000000000000000LL; v = v * 7 + 3) {
+        REQUIRE(format_int(v) == std::to_string(v));
+        REQUIRE(format_int(-v) == std::to_string(-v));
+    }
+}
+
+TEST_CASE("append coordinates") {
+    std::string out;
+    osmium::io::detail::OutputBlock::append_coordinate(out, 0);
+    out += ' ';
+    osmium::io::detail::OutputBlock::append_coordinate(out, 12345678);
+    out += ' ';
+    osmium::io::detail::OutputBlock::append_coordinate(out, -1800000000);
+    out += ' ';
+    osmium::io::detail::OutputBlock::append_coordinate(out, std::numeric_limits<int32_t>::min());
+    REQUIRE(out == "0 1.2345678 -180 -214.7483648");
+}
@@ -2,9 +2,31 @@
 
 #include "utils.hpp"
 
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/zlib.hpp>
 #include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
 #include <osmium/io/reader.hpp>
+#include <osmium/io/timestamp_window.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/node.hpp>
 #include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <protozero/pbf_writer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
 
 TEST_CASE("Get supported PBF compression types") {
     const auto types = osmium::io::supported_pbf_compression_types();
@@ -13,6 +35,169 @@ TEST_CASE("Get supported PBF compression types") {
     REQUIRE(types[1] == "zlib");
 }
 
+TEST_CASE("Compressed blobs can be uncompressed by zlib and vice versa") {
+    // If compiled with OSMIUM_WITH_LIBDEFLATE this checks that
+    // libdeflate and zlib understand each other.
+    std::string data;
+    for (int i = 0; i < 100000; ++i) {
+        data += std::to_string(i % 777);
+    }
+
+    for (const int level : {0, 1, 9, osmium::io::detail::zlib_default_compression_level()}) {
+        const std::string compressed = osmium::io::detail::zlib_compress(data, level);
+        std::string uncompressed(data.size(), '\0');
+        unsigned long size = static_cast<unsigned long>(data.size()); // NOLINT(google-runtime-int)
+        REQUIRE(::uncompress(reinterpret_cast<unsigned char*>(&*uncompressed.begin()), &size,
+                             reinterpret_cast<const unsigned char*>(compressed.data()), static_cast<unsigned long>(compressed.size())) == Z_OK); // NOLINT(google-runtime-int)
+        REQUIRE(uncompressed == data);
+    }
+
+    unsigned long size = ::compressBound(static_cast<unsigned long>(data.size())); // NOLINT(google-runtime-int)
+    std::string compressed(size, '\0');
+    REQUIRE(::compress(reinterpret_cast<unsigned char*>(&*compressed.begin()), &size,
+                       reinterpret_cast<const unsigned char*>(data.data()), static_cast<unsigned long>(data.size())) == Z_OK); // NOLINT(google-runtime-int)
+    compressed.resize(size);
+
+    std::string output;
+    const auto view = osmium::io::detail::zlib_uncompress_string(compressed.data(), static_cast<unsigned long>(compressed.size()), static_cast<unsigned long>(data.size()), output); // NOLINT(google-runtime-int)
+    REQUIRE(std::string(view.data(), view.size()) == data);
+
+    compressed[compressed.size() / 2] ^= 0x55;
+    REQUIRE_THROWS_AS(osmium::io::detail::zlib_uncompress_string(compressed.data(), static_cast<unsigned long>(compressed.size()), static_cast<unsigned long>(data.size()), output), osmium::io_error); // NOLINT(google-runtime-int)
+}
+
+#ifdef OSMIUM_WITH_ZSTD
+TEST_CASE("Uncompress blob into reused blob buffer") {
+    osmium::io::detail::pbf_blob_buffer output;
+    REQUIRE(output.capacity() == 0);
+
+    for (const std::size_t size : {1000, 100000, 50, 150000}) {
+        const std::string data(size, 'x');
+        const std::string compressed = osmium::io::detail::zlib_compress(data);
+
+        std::string blob;
+        protozero::pbf_writer pbf_blob{blob};
+        pbf_blob.add_int32(osmium::io::detail::FileFormat::Blob::optional_int32_raw_size, static_cast<int32_t>(size));
+        pbf_blob.add_bytes(osmium::io::detail::FileFormat::Blob::optional_bytes_zlib_data, compressed);
+
+        const auto view = osmium::io::detail::decode_blob(protozero::data_view{blob.data(), blob.size()}, output);
+        REQUIRE(output.capacity() >= size);
+        REQUIRE(std::string(view.data(), view.size()) == data);
+    }
+
+    REQUIRE(output.capacity() == 200000);
+}
+
+TEST_CASE("Write and read PBF file with zstd compression") {
+    const std::string filename{"test-pbf-zstd.osm.pbf"};
+
+    {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= 10000; ++id) {
+            osmium::builder::add_node(buffer,
+                osmium::builder::attr::_id(id),
+                osmium::builder::attr::_version(1),
+                osmium::builder::attr::_tag("foo", "bar"));
+        }
+
+        osmium::io::Writer writer{osmium::io::File{filename, "pbf,pbf_compression=zstd,pbf_compression_level=5"}, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    const osmium::memory::Buffer buffer = osmium::io::read_file(filename);
+    REQUIRE(std::distance(buffer.cbegin(), buffer.cend()) == 10000);
+    const auto& node = *buffer.cbegin<osmium::Node>();
+    REQUIRE(node.id() == 1);
+    REQUIRE(std::string{node.tags()["foo"]} == "bar");
+}
+
+TEST_CASE("Invalid zstd compression level") {
+    REQUIRE_THROWS_AS(osmium::io::Writer(osmium::io::File{"test-pbf-zstd-invalid.osm.pbf", "pbf,pbf_compression=zstd,pbf_compression_level=99"}, osmium::io::overwrite::allow), std::invalid_argument);
+}
+#endif
+
+TEST_CASE("Write and read PBF file with parallel encoding") {
+    const std::string filename{"test-pbf-parallel.osm.pbf"};
+
+    {
+        osmium::io::Writer writer{osmium::io::File{filename, "pbf,pbf_parallel_encoding=true"}, osmium::io::overwrite::allow};
+        osmium::object_id_type id = 1;
+        for (int n = 0; n < 5; ++n) {
+            osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+            for (int i = 0; i < 3000; ++i, ++id) {
+                osmium::builder::add_node(buffer,
+                    osmium::builder::attr::_id(id),
+                    osmium::builder::attr::_version(1),
+                    osmium::builder::attr::_user(id % 2 ? "foo" : "bar"),
+                    osmium::builder::attr::_tag("id", std::to_string(id)));
+            }
+            osmium::builder::add_way(buffer,
+                osmium::builder::attr::_id(n + 1),
+                osmium::builder::attr::_nodes({1, 2, 3}));
+            writer(std::move(buffer));
+        }
+        writer.close();
+    }
+
+    const osmium::memory::Buffer buffer = osmium::io::read_file(filename);
+    osmium::object_id_type id = 1;
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        REQUIRE(node.id() == id);
+        REQUIRE(std::string{node.user()} == (id % 2 ? "foo" : "bar"));
+        REQUIRE(std::string{node.tags()["id"]} == std::to_string(id));
+        ++id;
+    }
+    REQUIRE(id == 15001);
+
+    const auto ways = buffer.select<osmium::Way>();
+    REQUIRE(std::distance(ways.begin(), ways.end()) == 5);
+}
+
+TEST_CASE("Write PBF file with sort window") {
+    const std::string filename{"test-pbf-sort-window.osm.pbf"};
+
+    {
+        osmium::io::Writer writer{osmium::io::File{filename, "pbf,pbf_sort_window=1000"}, osmium::io::overwrite::allow};
+        osmium::object_id_type id = 1;
+        for (int n = 0; n < 5; ++n) {
+            osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+            for (int i = 0; i < 3000; i += 2, id += 2) {
+                // swap each pair of nodes
+                osmium::builder::add_node(buffer, osmium::builder::attr::_id(id + 1));
+                osmium::builder::add_node(buffer, osmium::builder::attr::_id(id));
+            }
+            // ways come before their nodes
+            osmium::builder::add_way(buffer,
+                osmium::builder::attr::_id(n + 1),
+                osmium::builder::attr::_nodes({1, 2, 3}));
+            writer(std::move(buffer));
+        }
+        writer.close();
+    }
+
+    const osmium::memory::Buffer buffer = osmium::io::read_file(filename);
+    osmium::object_id_type id = 1;
+    osmium::object_id_type way_id = 1;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        if (object.type() == osmium::item_type::node) {
+            REQUIRE(way_id == 1);
+            REQUIRE(object.id() == id);
+            ++id;
+        } else {
+            REQUIRE(object.id() == way_id);
+            ++way_id;
+        }
+    }
+    REQUIRE(id == 15001);
+    REQUIRE(way_id == 6);
+}
+
+TEST_CASE("Invalid PBF sort window") {
+    REQUIRE_THROWS_AS(osmium::io::Writer(osmium::io::File{"test-pbf-sort-window-invalid.osm.pbf", "pbf,pbf_sort_window=1"}, osmium::io::overwrite::allow), std::invalid_argument);
+    REQUIRE_THROWS_AS(osmium::io::Writer(osmium::io::File{"test-pbf-sort-window-invalid.osm.pbf", "pbf,pbf_sort_window=foo"}, osmium::io::overwrite::allow), std::invalid_argument);
+}
+
 /**
  * Osmosis writes PBF with changeset=-1 if its input file did not contain the changeset field.
  * The default value of the version field is -1 in the OSM.PBF format.
@@ -50,3 +235,680 @@ TEST_CASE("Read PBF file with version=-1 and changeset=-1 and DenseNodes (writte
     REQUIRE(object.version() == 0);
     REQUIRE(object.changeset() == 0);
 }
+
+#ifndef _WIN32
+TEST_CASE("Read PBF file using memory mapping") {
+    const osmium::memory::Buffer buffer_read = osmium::io::read_file(with_data_dir("t/io/deleted_nodes.osh.pbf"));
+
+    REQUIRE(::setenv("OSMIUM_USE_MMAP_FOR_PBF_READING", "yes", 1) == 0);
+    const osmium::memory::Buffer buffer_mapped = osmium::io::read_file(with_data_dir("t/io/deleted_nodes.osh.pbf"));
+    REQUIRE(::unsetenv("OSMIUM_USE_MMAP_FOR_PBF_READING") == 0);
+
+    REQUIRE(buffer_read.committed() > 0);
+    REQUIRE(buffer_read.committed() == buffer_mapped.committed());
+
+    auto it = buffer_mapped.cbegin<osmium::OSMObject>();
+    for (const auto& object : buffer_read.select<osmium::OSMObject>()) {
+        REQUIRE(it != buffer_mapped.cend<osmium::OSMObject>());
+        REQUIRE(object.type() == it->type());
+        REQUIRE(object.id() == it->id());
+        REQUIRE(object.version() == it->version());
+        REQUIRE(object.visible() == it->visible());
+        ++it;
+    }
+    REQUIRE(it == buffer_mapped.cend<osmium::OSMObject>());
+}
+static void compare_object_ids(const osmium::memory::Buffer& a, const osmium::memory::Buffer& b) {
+    REQUIRE(a.committed() == b.committed());
+
+    auto it = b.cbegin<osmium::OSMObject>();
+    for (const auto& object : a.select<osmium::OSMObject>()) {
+        REQUIRE(it != b.cend<osmium::OSMObject>());
+        REQUIRE(object.type() == it->type());
+        REQUIRE(object.id() == it->id());
+        REQUIRE(object.version() == it->version());
+        ++it;
+    }
+    REQUIRE(it == b.cend<osmium::OSMObject>());
+}
+
+TEST_CASE("Read PBF file with many blobs using blob table") {
+    const std::string filename{"test-pbf-blob-table.osm.pbf"};
+
+    {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= 30000; ++id) {
+            osmium::builder::add_node(buffer,
+                osmium::builder::attr::_id(id),
+                osmium::builder::attr::_version(1),
+                osmium::builder::attr::_location(1.0 + static_cast<double>(id % 100) / 100.0, 2.0));
+        }
+
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    const osmium::memory::Buffer buffer_read = osmium::io::read_file(filename);
+    REQUIRE(std::distance(buffer_read.cbegin(), buffer_read.cend()) == 30000);
+
+    REQUIRE(::setenv("OSMIUM_USE_BLOB_TABLE_FOR_PBF_READING", "yes", 1) == 0);
+
+    SECTION("using pread") {
+        const osmium::memory::Buffer buffer_table = osmium::io::read_file(filename);
+        compare_object_ids(buffer_read, buffer_table);
+    }
+
+    SECTION("using memory mapping") {
+        REQUIRE(::setenv("OSMIUM_USE_MMAP_FOR_PBF_READING", "yes", 1) == 0);
+        const osmium::memory::Buffer buffer_table = osmium::io::read_file(filename);
+        REQUIRE(::unsetenv("OSMIUM_USE_MMAP_FOR_PBF_READING") == 0);
+        compare_object_ids(buffer_read, buffer_table);
+    }
+
+    SECTION("header only") {
+        osmium::io::Reader reader{filename, osmium::osm_entity_bits::nothing};
+        REQUIRE_FALSE(reader.header().has_multiple_object_versions());
+        REQUIRE_FALSE(reader.read());
+        reader.close();
+    }
+
+    REQUIRE(::unsetenv("OSMIUM_USE_BLOB_TABLE_FOR_PBF_READING") == 0);
+}
+#endif
+
+static void write_prefilter_test_file(const std::string& filename, const char* format) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+        const char* amenity = (id % 10 == 0) ? "cafe" : "parking";
+        const std::string user = "user" + std::to_string(id % 7);
+        if (id % 5 == 0) {
+            osmium::builder::add_node(buffer,
+                osmium::builder::attr::_id(id),
+                osmium::builder::attr::_version(id % 5 + 1),
+                osmium::builder::attr::_timestamp(id * 100),
+                osmium::builder::attr::_cid(id * 3),
+                osmium::builder::attr::_uid(id),
+                osmium::builder::attr::_user(user.c_str()),
+                osmium::builder::attr::_location(1.0, 2.0),
+                osmium::builder::attr::_tag("highway", "bus_stop"),
+                osmium::builder::attr::_tag("amenity", amenity));
+        } else {
+            osmium::builder::add_node(buffer,
+                osmium::builder::attr::_id(id),
+                osmium::builder::attr::_version(id % 5 + 1),
+                osmium::builder::attr::_timestamp(id * 100),
+                osmium::builder::attr::_cid(id * 3),
+                osmium::builder::attr::_uid(id),
+                osmium::builder::attr::_user(user.c_str()),
+                osmium::builder::attr::_location(1.0, 2.0));
+        }
+    }
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_way(buffer,
+            osmium::builder::attr::_id(id),
+            osmium::builder::attr::_version(1),
+            osmium::builder::attr::_nodes({1, 2, 3}),
+            osmium::builder::attr::_tag("amenity", id % 10 == 0 ? "cafe" : "school"));
+    }
+    for (osmium::object_id_type id = 1; id <= 10; ++id) {
+        osmium::builder::add_relation(buffer,
+            osmium::builder::attr::_id(id),
+            osmium::builder::attr::_version(1),
+            osmium::builder::attr::_member(osmium::item_type::way, 1, "outer"),
+            osmium::builder::attr::_tag(id % 2 == 0 ? "amenity" : "type", "cafe"));
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+TEST_CASE("Read PBF file with tags prefilter") {
+    const std::string filename{"test-pbf-prefilter.osm.pbf"};
+
+    const char* format = "pbf";
+    SECTION("dense nodes") {
+    }
+    SECTION("no dense nodes") {
+        format = "pbf,pbf_dense_nodes=false";
+    }
+
+    write_prefilter_test_file(filename, format);
+
+    osmium::TagsFilter filter{false};
+    filter.add_rule(true, "amenity", "cafe");
+
+    SECTION("filter all types") {
+        osmium::io::read_meta read_metadata = osmium::io::read_meta::yes;
+        SECTION("with metadata") {
+        }
+        SECTION("without metadata") {
+            read_metadata = osmium::io::read_meta::no;
+        }
+
+        const osmium::memory::Buffer buffer = osmium::io::read_file(filename, osmium::io::tags_prefilter{filter}, read_metadata);
+
+        int nodes = 0;
+        int ways = 0;
+        int relations = 0;
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            REQUIRE(object.id() % (object.type() == osmium::item_type::relation ? 2 : 10) == 0);
+            REQUIRE(std::string{object.tags()["amenity"]} == "cafe");
+            switch (object.type()) {
+                case osmium::item_type::node:
+                    ++nodes;
+                    REQUIRE(object.tags().size() == 2);
+                    if (read_metadata == osmium::io::read_meta::yes) {
+                        REQUIRE(object.version() == static_cast<osmium::object_version_type>(object.id() % 5 + 1));
+                        REQUIRE(object.timestamp() == osmium::Timestamp{static_cast<uint32_t>(object.id() * 100)});
+                        REQUIRE(object.changeset() == static_cast<osmium::changeset_id_type>(object.id() * 3));
+                        REQUIRE(object.uid() == static_cast<osmium::user_id_type>(object.id()));
+                        REQUIRE(std::string{object.user()} == "user" + std::to_string(object.id() % 7));
+                    }
+                    break;
+                case osmium::item_type::way:
+                    ++ways;
+                    REQUIRE(static_cast<const osmium::Way&>(object).nodes().size() == 3);
+                    break;
+                case osmium::item_type::relation:
+                    ++relations;
+                    REQUIRE(static_cast<const osmium::Relation&>(object).members().size() == 1);
+                    break;
+                default:
+                    REQUIRE(false);
+            }
+        }
+        REQUIRE(nodes == 100);
+        REQUIRE(ways == 10);
+        REQUIRE(relations == 5);
+    }
+
+    SECTION("filter only ways") {
+        const osmium::memory::Buffer buffer = osmium::io::read_file(filename, osmium::io::tags_prefilter{filter, osmium::osm_entity_bits::way});
+
+        REQUIRE(std::distance(buffer.select<osmium::Node>().cbegin(), buffer.select<osmium::Node>().cend()) == 1000);
+        REQUIRE(std::distance(buffer.select<osmium::Way>().cbegin(), buffer.select<osmium::Way>().cend()) == 10);
+        REQUIRE(std::distance(buffer.select<osmium::Relation>().cbegin(), buffer.select<osmium::Relation>().cend()) == 10);
+    }
+
+    SECTION("filter with default result true") {
+        osmium::TagsFilter negative_filter{true};
+        negative_filter.add_rule(false, "amenity");
+        const osmium::memory::Buffer buffer = osmium::io::read_file(filename, osmium::io::tags_prefilter{negative_filter});
+
+        // Only nodes have a second tag, ways and relations without
+        // "type" tag have only the amenity tag.
+        REQUIRE(std::distance(buffer.select<osmium::Node>().cbegin(), buffer.select<osmium::Node>().cend()) == 200);
+        REQUIRE(std::distance(buffer.select<osmium::Way>().cbegin(), buffer.select<osmium::Way>().cend()) == 0);
+        REQUIRE(std::distance(buffer.select<osmium::Relation>().cbegin(), buffer.select<osmium::Relation>().cend()) == 5);
+    }
+}
+
+namespace {
+
+    // Writes 20000 nodes (in three data blocks) and two ways. The node
+    // IDs are given by the function. The header claims the file is
+    // sorted.
+    template <typename TFunc>
+    void write_sorting_test_file(const std::string& filename, TFunc&& node_id) {
+        osmium::io::Header header;
+        header.set_sorted_by_type_then_id(true);
+        REQUIRE(header.sorted_by_type_then_id());
+        REQUIRE_FALSE(header.sorting_verified());
+
+        osmium::io::Writer writer{filename, header, osmium::io::overwrite::allow};
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (int n = 0; n < 20000; ++n) {
+            osmium::builder::add_node(buffer, osmium::builder::attr::_id(node_id(n)));
+        }
+        osmium::builder::add_way(buffer, osmium::builder::attr::_id(1), osmium::builder::attr::_nodes({1, 2}));
+        osmium::builder::add_way(buffer, osmium::builder::attr::_id(2), osmium::builder::attr::_nodes({2, 3}));
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    std::size_t count_objects(osmium::io::Reader& reader) {
+        std::size_t count = 0;
+        while (const osmium::memory::Buffer buffer = reader.read()) {
+            count += static_cast<std::size_t>(std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend()));
+        }
+        return count;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Read sorted PBF file with and without verifying the sorting") {
+    const std::string filename{"test-pbf-verify-sorting.osm.pbf"};
+    write_sorting_test_file(filename, [](int n) {
+        return n + 1;
+    });
+
+    osmium::io::pool_for_pbf_parsing pool_parsing = osmium::io::pool_for_pbf_parsing::yes;
+    SECTION("decode in pool") {
+    }
+    SECTION("decode in parser thread") {
+        pool_parsing = osmium::io::pool_for_pbf_parsing::no;
+    }
+
+    SECTION("verify") {
+        osmium::io::Reader reader{filename, pool_parsing, osmium::io::verify_sorting::yes};
+        const auto header = reader.header();
+        REQUIRE(header.sorted_by_type_then_id());
+        REQUIRE(header.sorting_verified());
+        REQUIRE(header.sorted_and_verified());
+        REQUIRE(count_objects(reader) == 20002);
+        reader.close();
+    }
+
+    SECTION("don't verify") {
+        osmium::io::Reader reader{filename, pool_parsing};
+        const auto header = reader.header();
+        REQUIRE(header.sorted_by_type_then_id());
+        REQUIRE_FALSE(header.sorting_verified());
+        REQUIRE_FALSE(header.sorted_and_verified());
+        REQUIRE(count_objects(reader) == 20002);
+        reader.close();
+    }
+}
+
+TEST_CASE("Verifying the sorting of a PBF file which is not sorted") {
+    const std::string filename{"test-pbf-verify-sorting-fail.osm.pbf"};
+
+    SECTION("out of order inside data block") {
+        write_sorting_test_file(filename, [](int n) {
+            return n == 100 ? 50 : n + 1;
+        });
+    }
+    SECTION("out of order between data blocks") {
+        // The PBF writer puts 8000 objects into each block, the blocks
+        // are sorted internally.
+        write_sorting_test_file(filename, [](int n) {
+            return n < 8000 ? n + 8001 : n - 7999;
+        });
+    }
+
+    osmium::io::pool_for_pbf_parsing pool_parsing = osmium::io::pool_for_pbf_parsing::yes;
+    SECTION("decode in pool") {
+    }
+    SECTION("decode in parser thread") {
+        pool_parsing = osmium::io::pool_for_pbf_parsing::no;
+    }
+
+    osmium::io::Reader reader{filename, pool_parsing, osmium::io::verify_sorting::yes};
+    REQUIRE(reader.header().sorting_verified());
+    REQUIRE_THROWS_AS(count_objects(reader), osmium::out_of_order_error);
+
+    osmium::io::Reader unchecked_reader{filename, pool_parsing};
+    REQUIRE(count_objects(unchecked_reader) == 20002);
+}
+
+TEST_CASE("Write and read PBF file with changesets") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    const std::string filename{"test-pbf-changesets.osm.pbf"};
+
+    osmium::memory::Buffer input{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_changeset(input,
+        _cid(402757),
+        _created_at(osmium::Timestamp{"2008-12-15T12:57:57Z"}),
+        _closed_at(osmium::Timestamp{"2008-12-15T14:00:54Z"}),
+        _user("mrettig"),
+        _uid(38842),
+        _num_changes(33),
+        _tag("comment", "fix <roads> & stuff"));
+    const auto offset = osmium::builder::add_changeset(input,
+        _cid(402758),
+        _created_at(osmium::Timestamp{"2008-07-05T11:17:12Z"}),
+        _user("Jaycos"),
+        _uid(45048),
+        _num_changes(1),
+        _num_comments(2),
+        _comment({osmium::Timestamp{"2008-07-05T11:17:13Z"}, 123, "foobar", "fake comment"}),
+        _comment({osmium::Timestamp{"2008-07-05T11:17:14Z"}, 0, "", ""}));
+    input.get<osmium::Changeset>(offset).bounds() = osmium::Box{6.5904108, 51.7305590, 6.6, 51.8};
+    const auto changesets_size = input.committed();
+    osmium::builder::add_node(input, _id(1), _location(1.5, 2.5));
+
+    std::string format{"pbf"};
+    SECTION("serial encoding") {
+    }
+    SECTION("parallel encoding") {
+        format += ",pbf_parallel_encoding=true";
+    }
+
+    {
+        osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        buffer.add_buffer(input);
+        buffer.commit();
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    const osmium::memory::Buffer output = osmium::io::read_file(filename);
+    REQUIRE(output.committed() > changesets_size);
+    REQUIRE(std::equal(input.data(), input.data() + changesets_size, output.data()));
+
+    const auto& changeset = output.get<osmium::Changeset>(offset);
+    REQUIRE(changeset.id() == 402758);
+    REQUIRE(changeset.open());
+    REQUIRE(std::string{changeset.user()} == "Jaycos");
+    REQUIRE(changeset.bounds().bottom_left() == osmium::Location(6.5904108, 51.7305590));
+    REQUIRE(std::string{changeset.discussion().begin()->text()} == "fake comment");
+
+    const osmium::memory::Buffer nodes_only = osmium::io::read_file(filename, osmium::osm_entity_bits::node);
+    REQUIRE(nodes_only.select<osmium::Changeset>().empty());
+    REQUIRE(std::distance(nodes_only.select<osmium::Node>().begin(), nodes_only.select<osmium::Node>().end()) == 1);
+}
+
+TEST_CASE("Types after the types read in a sorted PBF file") {
+    using osmium::io::detail::pbf_sorted_end;
+    REQUIRE(pbf_sorted_end::later_types(osmium::osm_entity_bits::node) == (osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation));
+    REQUIRE(pbf_sorted_end::later_types(osmium::osm_entity_bits::way) == osmium::osm_entity_bits::relation);
+    REQUIRE(pbf_sorted_end::later_types(osmium::osm_entity_bits::node | osmium::osm_entity_bits::way) == osmium::osm_entity_bits::relation);
+    REQUIRE(pbf_sorted_end::later_types(osmium::osm_entity_bits::relation) == osmium::osm_entity_bits::nothing);
+    REQUIRE(pbf_sorted_end::later_types(osmium::osm_entity_bits::node | osmium::osm_entity_bits::changeset) == osmium::osm_entity_bits::nothing);
+    REQUIRE(pbf_sorted_end::later_types(osmium::osm_entity_bits::nothing) == osmium::osm_entity_bits::nothing);
+
+    pbf_sorted_end end{osmium::osm_entity_bits::node};
+    REQUIRE(end.possible());
+    REQUIRE_FALSE(end.reached());
+
+    end.found(3, osmium::osm_entity_bits::node);
+    REQUIRE_FALSE(end.reached());
+    REQUIRE_FALSE(end.after_end(100));
+
+    end.found(7, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way);
+    REQUIRE(end.reached());
+    REQUIRE_FALSE(end.after_end(6));
+    REQUIRE_FALSE(end.after_end(7));
+    REQUIRE(end.after_end(8));
+
+    // An earlier blob decoded later moves the end.
+    end.found(5, osmium::osm_entity_bits::relation);
+    REQUIRE(end.after_end(6));
+    REQUIRE_FALSE(end.after_end(5));
+
+    end.found(6, osmium::osm_entity_bits::relation);
+    REQUIRE_FALSE(end.after_end(5));
+    REQUIRE(end.after_end(6));
+}
+
+namespace {
+
+    // Writes a file claiming to be sorted with 20000 nodes, 10000 ways,
+    // and 10000 relations, so there are several data blocks of each
+    // type. If extra_nodes is set, 10 nodes are added at the end, so
+    // the file isn't really sorted.
+    void write_typed_sections_file(const std::string& filename, bool extra_nodes) {
+        osmium::io::Header header;
+        header.set_sorted_by_type_then_id(true);
+
+        osmium::io::Writer writer{filename, header, osmium::io::overwrite::allow};
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+            osmium::builder::add_node(buffer, osmium::builder::attr::_id(id), osmium::builder::attr::_location(1.0, 2.0));
+        }
+        for (osmium::object_id_type id = 1; id <= 10000; ++id) {
+            osmium::builder::add_way(buffer, osmium::builder::attr::_id(id), osmium::builder::attr::_nodes({1, 2}));
+        }
+        for (osmium::object_id_type id = 1; id <= 10000; ++id) {
+            osmium::builder::add_relation(buffer, osmium::builder::attr::_id(id), osmium::builder::attr::_member(osmium::item_type::way, id, ""));
+        }
+        if (extra_nodes) {
+            for (osmium::object_id_type id = 30001; id <= 30010; ++id) {
+                osmium::builder::add_node(buffer, osmium::builder::attr::_id(id), osmium::builder::attr::_location(1.0, 2.0));
+            }
+        }
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    struct typed_read_result {
+        std::size_t nodes = 0;
+        std::size_t ways = 0;
+        std::size_t relations = 0;
+        std::size_t buffers_decoded = 0;
+    };
+
+    typed_read_result read_types(const std::string& filename, osmium::osm_entity_bits::type types, osmium::io::pool_for_pbf_parsing pool_parsing) {
+        typed_read_result result;
+        const osmium::io::decoded_buffer_callback callback{[&result](osmium::memory::Buffer& /*buffer*/) {
+            ++result.buffers_decoded;
+        }};
+        osmium::io::Reader reader{filename, types, pool_parsing, callback};
+        while (const osmium::memory::Buffer buffer = reader.read()) {
+            result.nodes += static_cast<std::size_t>(std::distance(buffer.select<osmium::Node>().cbegin(), buffer.select<osmium::Node>().cend()));
+            result.ways += static_cast<std::size_t>(std::distance(buffer.select<osmium::Way>().cbegin(), buffer.select<osmium::Way>().cend()));
+            result.relations += static_cast<std::size_t>(std::distance(buffer.select<osmium::Relation>().cbegin(), buffer.select<osmium::Relation>().cend()));
+        }
+        reader.close();
+        return result;
+    }
+
+    void check_typed_reads(const std::string& filename) {
+        osmium::io::pool_for_pbf_parsing pool_parsing = osmium::io::pool_for_pbf_parsing::yes;
+        SECTION("decode in pool") {
+        }
+        SECTION("decode in parser thread") {
+            pool_parsing = osmium::io::pool_for_pbf_parsing::no;
+        }
+
+        const auto all = read_types(filename, osmium::osm_entity_bits::nwr, pool_parsing);
+        REQUIRE(all.nodes == 20000);
+        REQUIRE(all.ways == 10000);
+        REQUIRE(all.relations == 10000);
+
+        const auto nodes = read_types(filename, osmium::osm_entity_bits::node, pool_parsing);
+        REQUIRE(nodes.nodes == 20000);
+        REQUIRE(nodes.ways == 0);
+        REQUIRE(nodes.relations == 0);
+
+        const auto ways = read_types(filename, osmium::osm_entity_bits::way, pool_parsing);
+        REQUIRE(ways.nodes == 0);
+        REQUIRE(ways.ways == 10000);
+        REQUIRE(ways.relations == 0);
+
+        const auto relations = read_types(filename, osmium::osm_entity_bits::relation, pool_parsing);
+        REQUIRE(relations.nodes == 0);
+        REQUIRE(relations.ways == 0);
+        REQUIRE(relations.relations == 10000);
+
+        const auto nodes_and_relations = read_types(filename, osmium::osm_entity_bits::node | osmium::osm_entity_bits::relation, pool_parsing);
+        REQUIRE(nodes_and_relations.nodes == 20000);
+        REQUIRE(nodes_and_relations.ways == 0);
+        REQUIRE(nodes_and_relations.relations == 10000);
+
+        if (pool_parsing == osmium::io::pool_for_pbf_parsing::no) {
+            // When decoding in the parser thread nothing is decoded
+            // after the end has been found.
+            REQUIRE(nodes.buffers_decoded < all.buffers_decoded);
+            REQUIRE(ways.buffers_decoded < all.buffers_decoded);
+        }
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Read only some types from sorted PBF file") {
+    const std::string filename{"test-pbf-sorted-types.osm.pbf"};
+    write_typed_sections_file(filename, false);
+
+    check_typed_reads(filename);
+}
+
+#ifndef _WIN32
+TEST_CASE("Read only some types from sorted PBF file using blob table") {
+    const std::string filename{"test-pbf-sorted-types.osm.pbf"};
+    write_typed_sections_file(filename, false);
+
+    REQUIRE(::setenv("OSMIUM_USE_BLOB_TABLE_FOR_PBF_READING", "yes", 1) == 0);
+
+    SECTION("using pread") {
+        check_typed_reads(filename);
+
+        // The blobs before the first relation are not even read.
+        const auto all = read_types(filename, osmium::osm_entity_bits::nwr, osmium::io::pool_for_pbf_parsing::yes);
+        const auto relations = read_types(filename, osmium::osm_entity_bits::relation, osmium::io::pool_for_pbf_parsing::yes);
+        REQUIRE(relations.relations == 10000);
+        REQUIRE(relations.buffers_decoded < all.buffers_decoded);
+    }
+
+    SECTION("using memory mapping") {
+        REQUIRE(::setenv("OSMIUM_USE_MMAP_FOR_PBF_READING", "yes", 1) == 0);
+        check_typed_reads(filename);
+        REQUIRE(::unsetenv("OSMIUM_USE_MMAP_FOR_PBF_READING") == 0);
+    }
+
+    REQUIRE(::unsetenv("OSMIUM_USE_BLOB_TABLE_FOR_PBF_READING") == 0);
+}
+#endif
+
+TEST_CASE("Reading only nodes stops at first way if PBF file claims to be sorted") {
+    const std::string filename{"test-pbf-sorted-types.osm.pbf"};
+    write_typed_sections_file(filename, true);
+
+    // All objects are read if all types are read.
+    const auto all = read_types(filename, osmium::osm_entity_bits::nwr, osmium::io::pool_for_pbf_parsing::no);
+    REQUIRE(all.nodes == 20010);
+
+    // The nodes after the ways and relations are never seen.
+    const auto nodes = read_types(filename, osmium::osm_entity_bits::node, osmium::io::pool_for_pbf_parsing::no);
+    REQUIRE(nodes.nodes == 20000);
+}
+
+TEST_CASE("Decoded buffer callback is called on all nested buffers") {
+    const std::string filename{"test-pbf-sorted-types.osm.pbf"};
+    write_typed_sections_file(filename, false);
+
+    osmium::io::pool_for_pbf_parsing pool_parsing = osmium::io::pool_for_pbf_parsing::yes;
+    SECTION("decode in pool") {
+    }
+    SECTION("decode in parser thread") {
+        pool_parsing = osmium::io::pool_for_pbf_parsing::no;
+    }
+
+    std::atomic<std::size_t> objects{0};
+    const osmium::io::decoded_buffer_callback callback{[&objects](osmium::memory::Buffer& buffer) {
+        objects += static_cast<std::size_t>(std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend()));
+    }};
+
+    osmium::io::Reader reader{filename, pool_parsing, callback};
+    std::size_t count = 0;
+    while (const osmium::memory::Buffer buffer = reader.read()) {
+        count += static_cast<std::size_t>(std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend()));
+    }
+    reader.close();
+
+    REQUIRE(count == 40000);
+    REQUIRE(objects == count);
+}
+
+static void write_history_test_file(const std::string& filename, const char* format) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    // Objects with id % 3 == 0 only have versions from before the
+    // window, objects with id % 3 == 1 have versions at 1000, ... 5000,
+    // objects with id % 3 == 2 only have versions from after the window.
+    const auto add_versions = [&buffer](osmium::item_type type, osmium::object_id_type id) {
+        const int first = id % 3 == 2 ? 5 : 1;
+        const int last = id % 3 == 0 ? 2 : 5;
+        for (int version = first; version <= last; ++version) {
+            const auto timestamp = static_cast<uint32_t>(version * 1000);
+            switch (type) {
+                case osmium::item_type::node:
+                    osmium::builder::add_node(buffer,
+                        osmium::builder::attr::_id(id),
+                        osmium::builder::attr::_version(version),
+                        osmium::builder::attr::_timestamp(timestamp),
+                        osmium::builder::attr::_cid(version),
+                        osmium::builder::attr::_location(1.0, 2.0),
+                        osmium::builder::attr::_tag("v", std::to_string(version)));
+                    break;
+                case osmium::item_type::way:
+                    osmium::builder::add_way(buffer,
+                        osmium::builder::attr::_id(id),
+                        osmium::builder::attr::_version(version),
+                        osmium::builder::attr::_timestamp(timestamp),
+                        osmium::builder::attr::_nodes({1, 2, 3}));
+                    break;
+                default:
+                    osmium::builder::add_relation(buffer,
+                        osmium::builder::attr::_id(id),
+                        osmium::builder::attr::_version(version),
+                        osmium::builder::attr::_timestamp(timestamp),
+                        osmium::builder::attr::_member(osmium::item_type::way, 1, "outer"));
+            }
+        }
+    };
+
+    for (const auto type : {osmium::item_type::node, osmium::item_type::way, osmium::item_type::relation}) {
+        for (osmium::object_id_type id = 1; id <= 30; ++id) {
+            add_versions(type, id);
+        }
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+TEST_CASE("Read PBF history file with timestamp window") {
+    const std::string filename{"test-pbf-timestamp-window.osm.pbf"};
+
+    const char* format = "pbf";
+    SECTION("dense nodes") {
+    }
+    SECTION("no dense nodes") {
+        format = "pbf,pbf_dense_nodes=false";
+    }
+
+    write_history_test_file(filename, format);
+
+    osmium::io::read_meta read_metadata = osmium::io::read_meta::yes;
+    osmium::io::pool_for_pbf_parsing pool_parsing = osmium::io::pool_for_pbf_parsing::yes;
+    SECTION("with metadata, decode in pool") {
+    }
+    SECTION("without metadata, decode in pool") {
+        read_metadata = osmium::io::read_meta::no;
+    }
+    SECTION("with metadata, decode in parser thread") {
+        pool_parsing = osmium::io::pool_for_pbf_parsing::no;
+    }
+
+    const osmium::io::timestamp_window window{osmium::Timestamp{2500}, osmium::Timestamp{4000}};
+    const osmium::memory::Buffer buffer = osmium::io::read_file(filename, window, read_metadata, pool_parsing);
+
+    std::vector<std::tuple<osmium::item_type, osmium::object_id_type, int>> expected;
+    for (const auto type : {osmium::item_type::node, osmium::item_type::way, osmium::item_type::relation}) {
+        for (osmium::object_id_type id = 1; id <= 30; ++id) {
+            if (id % 3 == 0) {
+                expected.emplace_back(type, id, 2); // last version before the window
+            } else if (id % 3 == 1) {
+                expected.emplace_back(type, id, 2); // last version before the window
+                expected.emplace_back(type, id, 3); // version in the window
+            }
+        }
+    }
+
+    std::vector<std::tuple<osmium::item_type, osmium::object_id_type, int>> result;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        // Without metadata the version is not available, but the tag
+        // on the nodes and the number of objects still tell.
+        REQUIRE(result.size() < expected.size());
+        const int version = read_metadata == osmium::io::read_meta::yes ? static_cast<int>(object.version())
+                                                                       : std::get<2>(expected[result.size()]);
+        result.emplace_back(object.type(), object.id(), version);
+        if (object.type() == osmium::item_type::node) {
+            REQUIRE(std::to_string(version) == object.tags()["v"]);
+        }
+    }
+
+    REQUIRE(result == expected);
+}
+
+TEST_CASE("Invalid timestamp window") {
+    REQUIRE_THROWS_AS(osmium::io::timestamp_window(osmium::Timestamp{2000}, osmium::Timestamp{1000}), std::invalid_argument);
+    REQUIRE_FALSE(osmium::io::timestamp_window{});
+    REQUIRE(osmium::io::timestamp_window(osmium::Timestamp{1000}, osmium::Timestamp{1000}));
+}
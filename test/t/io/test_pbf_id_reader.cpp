@@ -0,0 +1,179 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/nwr_array.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/pbf_id_reader.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <string>
+#include <vector>
+
+using id_set_type = osmium::index::IdSetDense<osmium::unsigned_object_id_type>;
+
+static void write_test_file(const std::string& filename, const char* format, bool sorted = false) {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+        if (id % 100 == 0) {
+            osmium::builder::add_node(buffer, _id(id), _location(static_cast<double>(id) / 1000.0, 2.0), _tag("highway", "bus_stop"));
+        } else {
+            osmium::builder::add_node(buffer, _id(id), _location(static_cast<double>(id) / 1000.0, 2.0));
+        }
+    }
+    for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _nodes({1, 2}), _tag(id % 3 == 0 ? "highway" : "building", "yes"));
+    }
+    osmium::builder::add_relation(buffer, _id(-5), _member(osmium::item_type::way, 1, ""));
+
+    osmium::io::Header header;
+    header.set_sorted_by_type_then_id(sorted);
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, header, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+TEST_CASE("Read IDs from PBF file") {
+    const std::string filename{"test-pbf-id-reader.osm.pbf"};
+
+    const char* format = GENERATE("pbf", "pbf,pbf_dense_nodes=false");
+    write_test_file(filename, format);
+
+    osmium::io::PBFIdReader reader{filename};
+    REQUIRE(reader.num_data_blobs() > 2);
+
+    osmium::TagsFilter filter{false};
+    filter.add_rule(true, "highway");
+
+    SECTION("all IDs") {
+        osmium::nwr_array<id_set_type> ids;
+        reader.read(ids);
+        REQUIRE(ids.nodes().size() == 20000);
+        REQUIRE(ids.ways().size() == 1000);
+        REQUIRE(ids.relations().size() == 1);
+        REQUIRE(ids.relations().get(5));
+    }
+
+    SECTION("IDs of some types") {
+        osmium::nwr_array<id_set_type> ids;
+        reader.read(ids, osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation);
+        REQUIRE(ids.nodes().empty());
+        REQUIRE(ids.ways().size() == 1000);
+        REQUIRE(ids.relations().size() == 1);
+    }
+
+    SECTION("IDs of ways with highway tag") {
+        id_set_type ids;
+        reader.read(ids, osmium::osm_entity_bits::way, osmium::io::tags_prefilter{filter, osmium::osm_entity_bits::way});
+        REQUIRE(ids.size() == 333);
+        for (osmium::unsigned_object_id_type id = 1; id <= 1000; ++id) {
+            REQUIRE(ids.get(id) == (id % 3 == 0));
+        }
+    }
+
+    SECTION("prefilter on nodes") {
+        osmium::nwr_array<id_set_type> ids;
+        reader.read(ids, osmium::osm_entity_bits::nwr, osmium::io::tags_prefilter{filter, osmium::osm_entity_bits::node});
+        REQUIRE(ids.nodes().size() == 200);
+        REQUIRE(ids.nodes().get(100));
+        REQUIRE_FALSE(ids.nodes().get(101));
+        REQUIRE(ids.ways().size() == 1000);
+    }
+
+    SECTION("match flag") {
+        std::vector<osmium::object_id_type> matched;
+        std::size_t count = 0;
+        const osmium::io::tags_prefilter prefilter{filter};
+        for (std::size_t n = 0; n < reader.num_data_blobs(); ++n) {
+            reader.for_each_id_in_blob(n, [&](osmium::item_type type, osmium::object_id_type id, bool match) {
+                ++count;
+                if (match && type == osmium::item_type::relation) {
+                    matched.push_back(id);
+                }
+            }, osmium::osm_entity_bits::nwr, prefilter);
+        }
+        REQUIRE(count == 21001);
+        REQUIRE(matched.empty());
+    }
+}
+
+TEST_CASE("Read node locations from PBF file") {
+    const std::string filename{"test-pbf-id-reader.osm.pbf"};
+
+    const char* format = GENERATE("pbf", "pbf,pbf_dense_nodes=false");
+    write_test_file(filename, format);
+
+    osmium::io::PBFIdReader reader{filename};
+
+    SECTION("all locations") {
+        osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        reader.read_locations(index);
+        REQUIRE(index.size() == 20001);
+        for (osmium::unsigned_object_id_type id = 1; id <= 20000; ++id) {
+            REQUIRE(index.get(id) == osmium::Location(static_cast<double>(id) / 1000.0, 2.0));
+        }
+    }
+
+    SECTION("all locations into dense index presized from sorted file") {
+        write_test_file(filename, format, true);
+        osmium::io::PBFIdReader sorted_reader{filename};
+        REQUIRE(sorted_reader.header().sorted_by_type_then_id());
+
+        osmium::thread::Pool pool{4};
+        osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        sorted_reader.read_locations(index, false, pool);
+        REQUIRE(index.size() == 20001);
+        for (osmium::unsigned_object_id_type id = 1; id <= 20000; ++id) {
+            REQUIRE(index.get(id) == osmium::Location(static_cast<double>(id) / 1000.0, 2.0));
+        }
+    }
+
+    SECTION("tagged locations into dense positive and sparse negative index") {
+        osmium::thread::Pool pool{4};
+        osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> index_pos;
+        osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index_neg;
+        reader.read_locations(index_pos, index_neg, true, pool);
+        REQUIRE(index_pos.size() == 20001);
+        REQUIRE(index_pos.get(100) == osmium::Location(0.1, 2.0));
+        REQUIRE(index_pos.get_noexcept(101) == osmium::Location{});
+        REQUIRE(index_neg.size() == 0);
+    }
+
+    SECTION("locations of tagged nodes into positive and negative index") {
+        osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index_pos;
+        osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index_neg;
+        reader.read_locations(index_pos, index_neg, true);
+        index_pos.sort();
+        REQUIRE(index_pos.size() == 200);
+        REQUIRE(index_pos.get(100) == osmium::Location(0.1, 2.0));
+        REQUIRE(index_pos.get_noexcept(101) == osmium::Location{});
+        REQUIRE(index_neg.size() == 0);
+    }
+
+    SECTION("for each location in blob") {
+        std::size_t count = 0;
+        std::size_t tagged = 0;
+        for (std::size_t n = 0; n < reader.num_data_blobs(); ++n) {
+            reader.for_each_location_in_blob(n, [&](osmium::object_id_type id, osmium::Location location, bool has_tags) {
+                ++count;
+                if (has_tags) {
+                    ++tagged;
+                    REQUIRE(id % 100 == 0);
+                }
+                REQUIRE(location.valid());
+            });
+        }
+        REQUIRE(count == 20000);
+        REQUIRE(tagged == 200);
+    }
+}
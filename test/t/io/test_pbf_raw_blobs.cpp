@@ -0,0 +1,138 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/indexed_pbf_reader.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <string>
+#include <utility>
+
+static void write_test_file(const std::string& filename) {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0), _tag("n", "x"));
+    }
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _version(2), _nodes({id, id + 1}));
+    }
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+TEST_CASE("Buffer raw data") {
+    osmium::memory::Buffer buffer{1024};
+    REQUIRE_FALSE(buffer.has_raw_data());
+
+    buffer.set_raw_data(std::string{"abc"});
+    REQUIRE(buffer.has_raw_data());
+    REQUIRE(buffer.raw_data() == "abc");
+
+    osmium::memory::Buffer moved{std::move(buffer)};
+    REQUIRE(moved.has_raw_data());
+    REQUIRE(moved.release_raw_data() == "abc");
+    REQUIRE_FALSE(moved.has_raw_data());
+
+    moved.set_raw_data(std::string{"def"});
+    moved.clear();
+    REQUIRE_FALSE(moved.has_raw_data());
+}
+
+TEST_CASE("Reader attaches raw blobs only when asked to") {
+    const std::string filename{"test-pbf-raw-blobs-in.osm.pbf"};
+    write_test_file(filename);
+
+    std::size_t with_raw = 0;
+    std::size_t count = 0;
+
+    SECTION("default") {
+        osmium::io::Reader reader{filename};
+        while (const auto buffer = reader.read()) {
+            ++count;
+            with_raw += buffer.has_raw_data() ? 1 : 0;
+        }
+        reader.close();
+        REQUIRE(count > 0);
+        REQUIRE(with_raw == 0);
+    }
+
+    SECTION("keep raw blobs") {
+        osmium::io::Reader reader{filename, osmium::io::keep_raw_blobs::yes};
+        while (const auto buffer = reader.read()) {
+            ++count;
+            with_raw += buffer.has_raw_data() ? 1 : 0;
+        }
+        reader.close();
+        REQUIRE(count > 0);
+        REQUIRE(with_raw == count);
+    }
+
+    SECTION("keep raw blobs is ignored when filtering entities") {
+        osmium::io::Reader reader{filename, osmium::io::keep_raw_blobs::yes, osmium::osm_entity_bits::node};
+        while (const auto buffer = reader.read()) {
+            ++count;
+            with_raw += buffer.has_raw_data() ? 1 : 0;
+        }
+        reader.close();
+        REQUIRE(count > 0);
+        REQUIRE(with_raw == 0);
+    }
+
+    SECTION("keep raw blobs is ignored when not reading metadata") {
+        osmium::io::Reader reader{filename, osmium::io::keep_raw_blobs::yes, osmium::io::read_meta::no};
+        while (const auto buffer = reader.read()) {
+            ++count;
+            with_raw += buffer.has_raw_data() ? 1 : 0;
+        }
+        reader.close();
+        REQUIRE(count > 0);
+        REQUIRE(with_raw == 0);
+    }
+}
+
+TEST_CASE("Writer copies unchanged blobs") {
+    const std::string in_filename{"test-pbf-raw-blobs-in.osm.pbf"};
+    const std::string out_filename{"test-pbf-raw-blobs-out.osm.pbf"};
+    write_test_file(in_filename);
+
+    osmium::io::Reader reader{in_filename, osmium::io::keep_raw_blobs::yes};
+    osmium::io::Writer writer{out_filename, osmium::io::overwrite::allow};
+    while (auto buffer = reader.read()) {
+        writer.write_unchanged(std::move(buffer));
+    }
+    writer.close();
+    reader.close();
+
+    osmium::io::IndexedPBFReader in{in_filename, "-"};
+    osmium::io::IndexedPBFReader out{out_filename, "-"};
+    REQUIRE(in.num_data_blobs() > 1);
+    REQUIRE(in.num_data_blobs() == out.num_data_blobs());
+    for (std::size_t n = 0; n < in.num_data_blobs(); ++n) {
+        REQUIRE(in.raw_blob(n) == out.raw_blob(n));
+    }
+}
+
+TEST_CASE("Writer encodes unchanged buffers for other formats") {
+    const std::string in_filename{"test-pbf-raw-blobs-in.osm.pbf"};
+    const std::string out_filename{"test-pbf-raw-blobs-out.opl"};
+    write_test_file(in_filename);
+
+    osmium::io::Reader reader{in_filename, osmium::io::keep_raw_blobs::yes};
+    osmium::io::Writer writer{out_filename, osmium::io::overwrite::allow};
+    while (auto buffer = reader.read()) {
+        writer.write_unchanged(std::move(buffer));
+    }
+    const auto size = writer.close();
+    reader.close();
+
+    REQUIRE(size > 20000 * 10);
+}
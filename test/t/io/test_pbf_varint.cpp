@@ -0,0 +1,97 @@
+#include "catch.hpp"
+
+#include <osmium/io/detail/pbf_varint.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+static std::vector<int64_t> roundtrip(const std::vector<int64_t>& values) {
+    std::string data;
+    osmium::io::detail::append_delta_encoded_sint64(values.cbegin(), values.cend(), [](int64_t v) { return v; }, data);
+
+    std::vector<int64_t> result(values.size() + 1);
+    const char* pos = data.data();
+    const auto n = osmium::io::detail::decode_delta_encoded_sint64(&pos, data.data() + data.size(), result.data(), result.size());
+    REQUIRE(pos == data.data() + data.size());
+    result.resize(n);
+    return result;
+}
+
+TEST_CASE("Delta encoded sint64 known encoding") {
+    const std::vector<int64_t> values = {1, 2, 0, 150};
+    std::string data;
+    osmium::io::detail::append_delta_encoded_sint64(values.cbegin(), values.cend(), [](int64_t v) { return v; }, data);
+    // deltas 1, 1, -2, 150 zigzag encoded are 2, 2, 3, 300
+    REQUIRE(data == std::string{"\x02\x02\x03\xac\x02"});
+}
+
+TEST_CASE("Delta encoded sint64 roundtrip") {
+    REQUIRE(roundtrip({}).empty());
+
+    const std::vector<int64_t> small = {5, 6, 7, 3, -10};
+    REQUIRE(roundtrip(small) == small);
+
+    std::vector<int64_t> large;
+    for (int64_t i = 0; i < 1000; ++i) {
+        large.push_back(i * i * i * (i % 2 ? -1 : 1) * 1000000);
+    }
+    large.push_back(std::numeric_limits<int64_t>::max());
+    large.push_back(std::numeric_limits<int64_t>::min());
+    large.push_back(0);
+    REQUIRE(roundtrip(large) == large);
+}
+
+TEST_CASE("Decode delta encoded sint64 with count limit") {
+    const std::string data{"\x02\x02\x03\xac\x02"};
+    int64_t out[2];
+    const char* pos = data.data();
+    REQUIRE(osmium::io::detail::decode_delta_encoded_sint64(&pos, data.data() + data.size(), out, 2) == 2);
+    REQUIRE(out[0] == 1);
+    REQUIRE(out[1] == 2);
+    REQUIRE(pos == data.data() + 2);
+}
+
+TEST_CASE("Decode truncated or too long varints") {
+    int64_t out[20];
+
+    const std::string truncated{"\x02\xac"};
+    const char* pos = truncated.data();
+    REQUIRE_THROWS_AS(osmium::io::detail::decode_delta_encoded_sint64(&pos, truncated.data() + truncated.size(), out, 20), osmium::pbf_error);
+
+    const std::string too_long(20, '\xff');
+    pos = too_long.data();
+    REQUIRE_THROWS_AS(osmium::io::detail::decode_delta_encoded_sint64(&pos, too_long.data() + too_long.size(), out, 20), osmium::pbf_error);
+
+    const std::string too_long_at_end(11, '\xff');
+    pos = too_long_at_end.data();
+    REQUIRE_THROWS_AS(osmium::io::detail::decode_delta_encoded_sint64(&pos, too_long_at_end.data() + too_long_at_end.size(), out, 20), osmium::pbf_error);
+}
+
+TEST_CASE("Delta encoded sint64 roundtrip with runs of small values") {
+    std::vector<int64_t> values;
+    int64_t id = 1000;
+    for (int i = 0; i < 100; ++i) {
+        id += (i % 13 == 0) ? 100000 : 1;
+        values.push_back(id);
+    }
+    REQUIRE(roundtrip(values) == values);
+}
+
+TEST_CASE("Delta encoded sint64 roundtrip with all varint lengths") {
+    std::vector<int64_t> values;
+    for (int bits = 0; bits < 64; ++bits) {
+        const int64_t v = static_cast<int64_t>(1ULL << static_cast<unsigned>(bits));
+        values.push_back(v);
+        values.push_back(0);
+        values.push_back(-v);
+        values.push_back(v - 1);
+    }
+    // shorter inputs are decoded (partly) in the slow path
+    REQUIRE(roundtrip(values) == values);
+    for (std::size_t len = 1; len < 12; ++len) {
+        const std::vector<int64_t> tail(values.end() - static_cast<std::ptrdiff_t>(len), values.end());
+        REQUIRE(roundtrip(tail) == tail);
+    }
+}
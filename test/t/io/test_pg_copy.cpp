@@ -0,0 +1,237 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/wkb.hpp>
+#include <osmium/io/pg_copy.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::string be32(int32_t value) {
+    const auto v = static_cast<uint32_t>(value);
+    std::string out;
+    out += static_cast<char>(v >> 24U);
+    out += static_cast<char>((v >> 16U) & 0xffU);
+    out += static_cast<char>((v >> 8U) & 0xffU);
+    out += static_cast<char>(v & 0xffU);
+    return out;
+}
+
+static int64_t read_be(const std::string& data, std::size_t& pos, std::size_t size) {
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        value = (value << 8U) | static_cast<unsigned char>(data[pos++]);
+    }
+    if (size == 2) {
+        return static_cast<int16_t>(value);
+    }
+    if (size == 4) {
+        return static_cast<int32_t>(value);
+    }
+    return static_cast<int64_t>(value);
+}
+
+// Decode binary COPY data into rows of fields. NULL fields are returned
+// as the string "NULL".
+static std::vector<std::vector<std::string>> decode(const std::string& data) {
+    std::vector<std::vector<std::string>> rows;
+    REQUIRE(data.substr(0, 19) == osmium::io::pg_copy_header());
+    std::size_t pos = 19;
+    while (true) {
+        const auto fields = read_be(data, pos, 2);
+        if (fields == -1) {
+            break;
+        }
+        rows.emplace_back();
+        for (int64_t i = 0; i < fields; ++i) {
+            const auto length = read_be(data, pos, 4);
+            if (length == -1) {
+                rows.back().emplace_back("NULL");
+            } else {
+                rows.back().push_back(data.substr(pos, static_cast<std::size_t>(length)));
+                pos += static_cast<std::size_t>(length);
+            }
+        }
+    }
+    REQUIRE(pos == data.size());
+    return rows;
+}
+
+TEST_CASE("PostgreSQL COPY header and trailer") {
+    const std::string header = osmium::io::pg_copy_header();
+    REQUIRE(header.size() == 19);
+    REQUIRE(header.substr(0, 11) == std::string("PGCOPY\n\377\r\n\0", 11));
+    REQUIRE(header.substr(11) == std::string(8, '\0'));
+    REQUIRE(osmium::io::pg_copy_trailer() == "\xff\xff");
+}
+
+TEST_CASE("PostgreSQL COPY batch with simple fields") {
+    osmium::io::PgCopyBatch batch{1000};
+    REQUIRE(batch.empty());
+
+    batch.begin_row();
+    batch.add_int8(-2);
+    batch.add_int4(0x01020304);
+    batch.add_int2(7);
+    batch.add_bool(true);
+    batch.add_null();
+    batch.add_text("foo");
+    batch.add_float8(1.5);
+    batch.end_row();
+
+    REQUIRE(batch.rows() == 1);
+
+    const std::string expected =
+        std::string{"\x00\x07", 2} +
+        be32(8) + std::string{"\xff\xff\xff\xff\xff\xff\xff\xfe", 8} +
+        be32(4) + std::string{"\x01\x02\x03\x04", 4} +
+        be32(2) + std::string{"\x00\x07", 2} +
+        be32(1) + std::string{"\x01", 1} +
+        be32(-1) +
+        be32(3) + "foo" +
+        be32(8) + std::string{"\x3f\xf8\x00\x00\x00\x00\x00\x00", 8};
+    REQUIRE(batch.data() == expected);
+
+    batch.begin_row();
+    batch.add_int8(1);
+    batch.rollback_row();
+    REQUIRE(batch.data() == expected);
+    REQUIRE(batch.rows() == 1);
+
+    batch.clear();
+    REQUIRE(batch.empty());
+    REQUIRE(batch.size() == 0);
+}
+
+TEST_CASE("PostgreSQL COPY batch with tags") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _tag("highway", "bus_stop"), _tag("name", "\"A\"\n"));
+    const auto& node = buffer.get<osmium::Node>(0);
+
+    osmium::io::PgCopyBatch batch;
+    batch.begin_row();
+    batch.add_hstore(node.tags());
+    batch.add_jsonb(node.tags());
+    batch.end_row();
+
+    const auto rows = decode(osmium::io::pg_copy_header() + batch.data() + osmium::io::pg_copy_trailer());
+    REQUIRE(rows.size() == 1);
+    REQUIRE(rows[0].size() == 2);
+
+    const std::string hstore = be32(2) +
+                               be32(7) + "highway" + be32(8) + "bus_stop" +
+                               be32(4) + "name" + be32(4) + "\"A\"\n";
+    REQUIRE(rows[0][0] == hstore);
+    REQUIRE(rows[0][1] == "\x01{\"highway\":\"bus_stop\",\"name\":\"\\\"A\\\"\\n\"}");
+}
+
+TEST_CASE("PostgreSQL COPY batch with empty tags") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1));
+    const auto& node = buffer.get<osmium::Node>(0);
+
+    osmium::io::PgCopyBatch batch;
+    batch.begin_row();
+    batch.add_hstore(node.tags());
+    batch.add_jsonb(node.tags());
+    batch.end_row();
+
+    REQUIRE(batch.data() == std::string{"\x00\x02", 2} + be32(4) + be32(0) + be32(3) + "\x01{}");
+}
+
+TEST_CASE("PgCopyWriter builds batches in parallel and writes them in order") {
+    osmium::thread::Pool pool{3};
+
+    std::vector<osmium::memory::Buffer> buffers;
+    osmium::object_id_type id = 0;
+    for (int b = 0; b < 30; ++b) {
+        buffers.emplace_back(1024, osmium::memory::Buffer::auto_grow::yes);
+        for (int n = 0; n < 10; ++n) {
+            ++id;
+            osmium::builder::add_node(buffers.back(), _id(id), _location(1.0, 2.0), _tag("n", std::to_string(id)));
+        }
+    }
+
+    std::string data;
+    int writes = 0;
+    {
+        osmium::io::PgCopyWriter writer{
+            [](const osmium::memory::Buffer& buffer, osmium::io::PgCopyBatch& batch) {
+                osmium::geom::WKBFactory<> factory{osmium::geom::wkb_type::wkb, osmium::geom::out_type::binary};
+                for (const auto& node : buffer.select<osmium::Node>()) {
+                    if (node.id() % 10 == 0) {
+                        continue;
+                    }
+                    batch.begin_row();
+                    batch.add_int8(node.id());
+                    batch.add_hstore(node.tags());
+                    batch.add_binary(factory.create_point(node));
+                    batch.end_row();
+                }
+            },
+            [&](const std::string& batch_data) {
+                data += batch_data;
+                ++writes;
+            },
+            pool,
+            4
+        };
+
+        for (auto& buffer : buffers) {
+            writer(std::move(buffer));
+        }
+        writer.close();
+        writer.close();
+        REQUIRE_THROWS_AS(writer(osmium::memory::Buffer{}), std::logic_error);
+    }
+
+    REQUIRE(writes == 32); // header + 30 batches + trailer
+
+    const auto rows = decode(data);
+    REQUIRE(rows.size() == 270);
+
+    osmium::geom::WKBFactory<> factory{osmium::geom::wkb_type::wkb, osmium::geom::out_type::binary};
+    const std::string wkb = factory.create_point(osmium::Location{1.0, 2.0});
+
+    std::size_t r = 0;
+    for (osmium::object_id_type i = 1; i <= 300; ++i) {
+        if (i % 10 == 0) {
+            continue;
+        }
+        const auto& row = rows[r++];
+        REQUIRE(row.size() == 3);
+        std::size_t pos = 0;
+        REQUIRE(read_be(row[0], pos, 8) == i);
+        REQUIRE(row[1].substr(0, 4) == be32(1));
+        REQUIRE(row[2] == wkb);
+    }
+}
+
+TEST_CASE("PgCopyWriter passes on exceptions from build function") {
+    osmium::thread::Pool pool{2};
+
+    std::string data;
+    osmium::io::PgCopyWriter writer{
+        [](const osmium::memory::Buffer& /*buffer*/, osmium::io::PgCopyBatch& /*batch*/) {
+            throw std::runtime_error{"build failed"};
+        },
+        [&data](const std::string& batch_data) {
+            data += batch_data;
+        },
+        pool
+    };
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1));
+    writer(std::move(buffer));
+    REQUIRE_THROWS_WITH(writer.flush(), "build failed");
+    REQUIRE(data == osmium::io::pg_copy_header());
+}
@@ -0,0 +1,289 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/pipeline.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    // Source returning count buffers with one node each, the node ids
+    // are 1, 2, 3, ...
+    class node_source {
+
+        osmium::object_id_type m_id = 0;
+        osmium::object_id_type m_count;
+
+    public:
+
+        explicit node_source(osmium::object_id_type count) :
+            m_count(count) {
+        }
+
+        osmium::memory::Buffer operator()() {
+            if (m_id == m_count) {
+                return osmium::memory::Buffer{};
+            }
+            osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+            osmium::builder::add_node(buffer, _id(++m_id));
+            return buffer;
+        }
+
+    }; // class node_source
+
+    osmium::object_id_type first_id(const osmium::memory::Buffer& buffer) {
+        return buffer.get<osmium::Node>(0).id();
+    }
+
+    // Makes buffers with lower ids take longer so that they overtake
+    // each other in parallel stages.
+    osmium::memory::Buffer slow_down(osmium::memory::Buffer&& buffer) {
+        std::this_thread::sleep_for(std::chrono::microseconds{(20 - first_id(buffer) % 20) * 50});
+        return std::move(buffer);
+    }
+
+    struct count_handler : public osmium::handler::Handler {
+
+        int count = 0;
+
+        void node(const osmium::Node& /*node*/) noexcept {
+            ++count;
+        }
+
+    }; // struct count_handler
+
+} // anonymous namespace
+
+TEST_CASE("Pipeline without stages") {
+    osmium::thread::Pool pool{2};
+    osmium::io::Pipeline pipeline{pool, 3};
+    REQUIRE(pipeline.num_stages() == 0);
+    REQUIRE(pipeline.max_in_flight() == 3);
+
+    std::vector<osmium::object_id_type> ids;
+    pipeline.run(node_source{10}, [&ids](osmium::memory::Buffer&& buffer) {
+        ids.push_back(first_id(buffer));
+    });
+
+    REQUIRE(ids == std::vector<osmium::object_id_type>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+
+    const auto stats = pipeline.stats();
+    REQUIRE(stats.source.items == 10);
+    REQUIRE(stats.sink.items == 10);
+    REQUIRE(stats.in_flight.pushes == 10);
+    REQUIRE(stats.in_flight.pops == 10);
+    REQUIRE(stats.in_flight.size == 0);
+    REQUIRE(stats.in_flight.largest_size <= 3);
+}
+
+TEST_CASE("Ordered stages and sink see buffers in source order") {
+    osmium::thread::Pool pool{4};
+    osmium::io::Pipeline pipeline{pool, 8};
+
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+    std::vector<osmium::object_id_type> serial_ids;
+
+    pipeline.add_stage("parallel", [&](osmium::memory::Buffer&& buffer) {
+        const int r = ++running;
+        int m = max_running.load();
+        while (r > m && !max_running.compare_exchange_weak(m, r)) {
+        }
+        auto result = slow_down(std::move(buffer));
+        --running;
+        return result;
+    }, osmium::io::stage_order::unordered, osmium::io::stage_concurrency::parallel);
+
+    pipeline.add_stage("serial", [&](osmium::memory::Buffer&& buffer) {
+        serial_ids.push_back(first_id(buffer));
+        return std::move(buffer);
+    });
+
+    std::vector<osmium::object_id_type> sink_ids;
+    pipeline.run(node_source{100}, [&sink_ids](osmium::memory::Buffer&& buffer) {
+        sink_ids.push_back(first_id(buffer));
+    });
+
+    std::vector<osmium::object_id_type> expected(100);
+    std::iota(expected.begin(), expected.end(), 1);
+    REQUIRE(serial_ids == expected);
+    REQUIRE(sink_ids == expected);
+    REQUIRE(max_running <= 8);
+
+    const auto stats = pipeline.stats();
+    REQUIRE(stats.stages.size() == 2);
+    REQUIRE(stats.stages[0].name == "parallel");
+    REQUIRE(stats.stages[0].work.items == 100);
+    REQUIRE(stats.stages[0].queue.pushes == 100);
+    REQUIRE(stats.stages[0].queue.pops == 100);
+    REQUIRE(stats.stages[0].queue.largest_size <= 8);
+    REQUIRE(stats.stages[1].name == "serial");
+    REQUIRE(stats.stages[1].work.items == 100);
+    REQUIRE(stats.in_flight.largest_size <= 8);
+
+    const auto metrics = osmium::io::to_prometheus(stats);
+    REQUIRE(metrics.find("osmium_pipeline_stage_items_total{stage=\"parallel\"} 100\n") != std::string::npos);
+    REQUIRE(metrics.find("osmium_pipeline_queue_pushes_total{queue=\"in_flight\"} 100\n") != std::string::npos);
+}
+
+TEST_CASE("Serial stage is never called concurrently") {
+    osmium::thread::Pool pool{4};
+    osmium::io::Pipeline pipeline{pool, 10};
+
+    std::atomic<int> running{0};
+    bool overlap = false;
+    pipeline.add_stage("serial", [&](osmium::memory::Buffer&& buffer) {
+        if (++running > 1) {
+            overlap = true;
+        }
+        auto result = slow_down(std::move(buffer));
+        --running;
+        return result;
+    }, osmium::io::stage_order::unordered, osmium::io::stage_concurrency::serial);
+
+    int count = 0;
+    pipeline.run(node_source{50}, [&count](osmium::memory::Buffer&& /*buffer*/) {
+        ++count;
+    }, osmium::io::stage_order::unordered);
+
+    REQUIRE_FALSE(overlap);
+    REQUIRE(count == 50);
+}
+
+TEST_CASE("Pipeline stage can drop buffers") {
+    osmium::thread::Pool pool{3};
+    osmium::io::Pipeline pipeline{pool, 4};
+
+    pipeline.add_stage("drop_odd", [](osmium::memory::Buffer&& buffer) {
+        if (first_id(buffer) % 2 == 1) {
+            return osmium::memory::Buffer{};
+        }
+        return slow_down(std::move(buffer));
+    }, osmium::io::stage_order::unordered, osmium::io::stage_concurrency::parallel);
+
+    std::vector<osmium::object_id_type> stage_ids;
+    pipeline.add_stage("collect", [&stage_ids](osmium::memory::Buffer&& buffer) {
+        stage_ids.push_back(first_id(buffer));
+        return std::move(buffer);
+    });
+
+    std::vector<osmium::object_id_type> sink_ids;
+    pipeline.run(node_source{20}, [&sink_ids](osmium::memory::Buffer&& buffer) {
+        sink_ids.push_back(first_id(buffer));
+    });
+
+    const std::vector<osmium::object_id_type> expected{2, 4, 6, 8, 10, 12, 14, 16, 18, 20};
+    REQUIRE(stage_ids == expected);
+    REQUIRE(sink_ids == expected);
+
+    const auto stats = pipeline.stats();
+    REQUIRE(stats.stages[0].work.items == 20);
+    REQUIRE(stats.stages[1].work.items == 10);
+    REQUIRE(stats.sink.items == 10);
+    REQUIRE(stats.in_flight.pops == 20);
+}
+
+TEST_CASE("Exceptions in pipeline are passed on to caller") {
+    osmium::thread::Pool pool{2};
+    osmium::io::Pipeline pipeline{pool, 4};
+
+    pipeline.add_stage("fail", [](osmium::memory::Buffer&& buffer) {
+        if (first_id(buffer) == 7) {
+            throw std::runtime_error{"stage failed"};
+        }
+        return std::move(buffer);
+    }, osmium::io::stage_order::unordered, osmium::io::stage_concurrency::parallel);
+
+    const auto sink = [](osmium::memory::Buffer&& /*buffer*/) {};
+
+    SECTION("in a stage") {
+        REQUIRE_THROWS_WITH(pipeline.run(node_source{20}, sink), "stage failed");
+    }
+
+    SECTION("in the source") {
+        int count = 0;
+        const auto source = [&count]() -> osmium::memory::Buffer {
+            if (++count == 3) {
+                throw std::runtime_error{"source failed"};
+            }
+            return node_source{1}();
+        };
+        REQUIRE_THROWS_WITH(pipeline.run(source, sink), "source failed");
+    }
+
+    SECTION("in the sink") {
+        const auto failing_sink = [](osmium::memory::Buffer&& buffer) {
+            if (first_id(buffer) == 3) {
+                throw std::runtime_error{"sink failed"};
+            }
+        };
+        REQUIRE_THROWS_WITH(pipeline.run(node_source{5}, failing_sink), "sink failed");
+    }
+
+    // The pipeline can be run again after an error.
+    int count = 0;
+    pipeline.run(node_source{6}, [&count](osmium::memory::Buffer&& /*buffer*/) {
+        ++count;
+    });
+    REQUIRE(count == 6);
+}
+
+TEST_CASE("Pipeline from reader through handler stage to writer") {
+    const std::string input_file{"test-pipeline-in.opl"};
+    const std::string output_file{"test-pipeline-out.opl"};
+
+    {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= 2000; ++id) {
+            osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0));
+        }
+        osmium::io::Writer writer{input_file, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    osmium::thread::Pool pool{2};
+    osmium::io::Reader reader{input_file, pool};
+    osmium::io::Writer writer{output_file, osmium::io::overwrite::allow};
+
+    count_handler handler;
+    osmium::io::Pipeline pipeline{pool};
+    pipeline.add_handler_stage("count", handler);
+    pipeline.run([&reader]() {
+        return reader.read();
+    }, std::ref(writer));
+
+    writer.close();
+    reader.close();
+
+    REQUIRE(handler.count == 2000);
+
+    osmium::io::Reader check{output_file};
+    int count = 0;
+    while (const auto buffer = check.read()) {
+        count += static_cast<int>(std::distance(buffer.begin<osmium::Node>(), buffer.end<osmium::Node>()));
+    }
+    check.close();
+    REQUIRE(count == 2000);
+}
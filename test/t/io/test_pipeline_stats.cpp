@@ -0,0 +1,79 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/util/file.hpp>
+
+#include <string>
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Writer and reader statistics") {
+    const std::string filename{"test-pipeline-stats.opl"};
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0));
+    }
+    const auto committed = buffer.committed();
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    const auto file_size = writer.close();
+
+    const auto wstats = writer.stats();
+    REQUIRE(wstats.input.items == 1);
+    REQUIRE(wstats.input.bytes == committed);
+    REQUIRE(wstats.write.bytes == file_size);
+    REQUIRE(wstats.output_queue.name == "raw_output");
+    REQUIRE(wstats.output_queue.pushes == wstats.output_queue.pops);
+    REQUIRE(wstats.pool.num_threads > 0);
+
+    osmium::io::Reader reader{filename};
+    std::size_t num_buffers = 0;
+    std::size_t num_bytes = 0;
+    while (const auto b = reader.read()) {
+        ++num_buffers;
+        num_bytes += b.committed();
+    }
+    reader.close();
+
+    const auto rstats = reader.stats();
+    REQUIRE(rstats.read.bytes == file_size);
+    REQUIRE(rstats.read.items > 0);
+    REQUIRE(rstats.output.items == num_buffers);
+    REQUIRE(rstats.output.bytes == num_bytes);
+    REQUIRE(rstats.input_queue.name == "raw_input");
+    REQUIRE(rstats.osmdata_queue.name == "parser_results");
+    REQUIRE(rstats.osmdata_queue.pops > 0);
+    REQUIRE(rstats.osmdata_queue.popped_bytes > 0);
+    REQUIRE(rstats.osmdata_queue.estimated_bytes() == 0);
+    REQUIRE(reader.used_memory() == 0);
+
+    const auto text = osmium::io::to_prometheus(rstats);
+    REQUIRE(text.find("osmium_reader_stage_bytes_total{stage=\"read\"} " + std::to_string(file_size) + "\n") != std::string::npos);
+    REQUIRE(text.find("osmium_reader_queue_waits_total{queue=\"raw_input\",side=\"empty\"} ") != std::string::npos);
+    REQUIRE(text.find("osmium_reader_pool_threads ") != std::string::npos);
+
+    const auto wtext = osmium::io::to_prometheus(wstats, "my_writer");
+    REQUIRE(wtext.find("my_writer_stage_items_total{stage=\"input\"} 1\n") != std::string::npos);
+}
+
+TEST_CASE("Reader statistics when parser reads the file directly") {
+    osmium::io::Reader reader{with_data_dir("t/io/data_pbf_version-1.osm.pbf")};
+    while (reader.read()) {
+    }
+    reader.close();
+
+    const auto stats = reader.stats();
+    REQUIRE(stats.read.bytes == osmium::file_size(with_data_dir("t/io/data_pbf_version-1.osm.pbf")));
+    REQUIRE(stats.output.items > 0);
+}
@@ -0,0 +1,213 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/read_query.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+// Nodes 1 to 30000 with longitude id / 1000, every tenth node is a cafe,
+// ways 1 to 1000 with every tenth way a cafe, relations 1 to 100.
+static void write_query_test_file(const std::string& filename, const char* format) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 30000; ++id) {
+        if (id % 10 == 0) {
+            osmium::builder::add_node(buffer, _id(id), _version(1), _location(static_cast<double>(id) / 1000, 1.0), _tag("amenity", "cafe"));
+        } else {
+            osmium::builder::add_node(buffer, _id(id), _version(1), _location(static_cast<double>(id) / 1000, 1.0));
+        }
+    }
+    for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _version(1), _nodes({id, id + 1}), _tag("amenity", id % 10 == 0 ? "cafe" : "school"));
+    }
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_relation(buffer, _id(id), _version(1), _member(osmium::item_type::way, id, ""));
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+TEST_CASE("Read query combining types, tags filter, box, and IDs") {
+    const std::string filename{"test-read-query.osm.pbf"};
+
+    const char* format = "pbf";
+    SECTION("dense nodes") {
+    }
+    SECTION("no dense nodes") {
+        format = "pbf,pbf_dense_nodes=false";
+    }
+
+    write_query_test_file(filename, format);
+
+    osmium::TagsFilter filter{false};
+    filter.add_rule(true, "amenity", "cafe");
+
+    osmium::io::read_query::id_set_type way_ids;
+    for (osmium::unsigned_object_id_type id = 1; id <= 1000; id += 3) {
+        way_ids.set(id);
+    }
+
+    osmium::io::read_query query{osmium::osm_entity_bits::node | osmium::osm_entity_bits::way};
+    query.set_tags_filter(filter);
+    query.set_box(osmium::Box{2.0, 0.0, 3.0, 2.0});
+    query.set_ids(osmium::item_type::way, std::move(way_ids));
+    REQUIRE(query.filters_objects());
+
+    osmium::io::read_meta read_metadata = osmium::io::read_meta::yes;
+    SECTION("with metadata") {
+    }
+    SECTION("without metadata") {
+        read_metadata = osmium::io::read_meta::no;
+    }
+
+    const osmium::memory::Buffer buffer = osmium::io::read_file(filename, query, read_metadata);
+
+    int nodes = 0;
+    int ways = 0;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        REQUIRE(std::string{object.tags()["amenity"]} == "cafe");
+        if (object.type() == osmium::item_type::node) {
+            ++nodes;
+            REQUIRE(object.id() >= 2000);
+            REQUIRE(object.id() <= 3000);
+        } else {
+            REQUIRE(object.type() == osmium::item_type::way);
+            ++ways;
+            REQUIRE(object.id() % 10 == 0);
+            REQUIRE(object.id() % 3 == 1);
+        }
+    }
+    REQUIRE(nodes == 101);
+    REQUIRE(ways == 34);
+}
+
+TEST_CASE("Read query with node IDs") {
+    const std::string filename{"test-read-query.osm.pbf"};
+
+    const char* format = "pbf";
+    SECTION("dense nodes") {
+    }
+    SECTION("no dense nodes") {
+        format = "pbf,pbf_dense_nodes=false";
+    }
+
+    write_query_test_file(filename, format);
+
+    osmium::io::read_query::id_set_type node_ids;
+    node_ids.set(17);
+    node_ids.set(29999);
+
+    osmium::io::read_query query;
+    query.set_ids(osmium::item_type::node, std::move(node_ids));
+
+    const osmium::memory::Buffer buffer = osmium::io::read_file(filename, query);
+
+    int nodes = 0;
+    int others = 0;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        if (object.type() == osmium::item_type::node) {
+            ++nodes;
+            REQUIRE((object.id() == 17 || object.id() == 29999));
+        } else {
+            ++others;
+        }
+    }
+    REQUIRE(nodes == 2);
+    REQUIRE(others == 1100);
+}
+
+static std::size_t count_decoded_buffers(const std::string& filename, const osmium::io::read_query& query, std::size_t& objects) {
+    std::atomic<std::size_t> count{0};
+    const osmium::io::decoded_buffer_callback callback{[&count](osmium::memory::Buffer& /*buffer*/) {
+        ++count;
+    }};
+
+    osmium::io::Reader reader{filename, query, callback};
+    objects = 0;
+    while (const osmium::memory::Buffer buffer = reader.read()) {
+        objects += static_cast<std::size_t>(std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend()));
+    }
+    reader.close();
+
+    return count;
+}
+
+TEST_CASE("Read query skips blobs using the blob index") {
+    const std::string filename{"test-read-query-index.osm.pbf"};
+    const std::string index_filename{filename + ".blobidx"};
+    write_query_test_file(filename, "pbf,pbf_blob_index=true");
+
+    osmium::io::read_query query{osmium::osm_entity_bits::node};
+    query.set_box(osmium::Box{2.0, 0.0, 3.0, 2.0});
+
+    std::size_t objects_without_index = 0;
+    const auto buffers_without_index = count_decoded_buffers(filename, query, objects_without_index);
+    REQUIRE(objects_without_index == 1001);
+
+    std::size_t objects = 0;
+    SECTION("valid index") {
+        query.set_blob_index(index_filename);
+        const auto buffers = count_decoded_buffers(filename, query, objects);
+        REQUIRE(buffers < buffers_without_index);
+    }
+    SECTION("index of another file is ignored") {
+        const std::string other_filename{"test-read-query-other.osm.pbf"};
+        write_query_test_file(other_filename, "pbf,pbf_blob_index=true,pbf_dense_nodes=false");
+        query.set_blob_index(other_filename + ".blobidx");
+        count_decoded_buffers(filename, query, objects);
+        std::remove((other_filename + ".blobidx").c_str());
+    }
+    SECTION("missing index is ignored") {
+        query.set_blob_index("test-read-query-does-not-exist.blobidx");
+        count_decoded_buffers(filename, query, objects);
+    }
+    REQUIRE(objects == objects_without_index);
+
+    std::remove(index_filename.c_str());
+}
+
+TEST_CASE("Read query decides which blobs are wanted") {
+    osmium::io::pbf_blob_summary summary;
+    summary.add(osmium::item_type::node, 100);
+    summary.add(osmium::item_type::node, 200);
+    summary.box = osmium::Box{1.0, 1.0, 2.0, 2.0};
+
+    osmium::io::read_query query;
+    REQUIRE_FALSE(query.filters_objects());
+    REQUIRE(query.wants_blob(summary));
+
+    query.set_box(osmium::Box{3.0, 3.0, 4.0, 4.0});
+    REQUIRE_FALSE(query.wants_blob(summary));
+    REQUIRE(query.wants_blob(osmium::io::pbf_blob_summary{}));
+
+    query.set_box(osmium::Box{});
+    osmium::io::read_query::id_set_type ids;
+    ids.set(150);
+    query.set_ids(osmium::item_type::node, std::move(ids));
+    REQUIRE(query.wants_blob(summary));
+    REQUIRE(query.wants_id(osmium::item_type::node, 150));
+    REQUIRE_FALSE(query.wants_id(osmium::item_type::node, 151));
+    REQUIRE_FALSE(query.wants_id(osmium::item_type::node, -150));
+    REQUIRE(query.wants_id(osmium::item_type::way, 151));
+
+    osmium::io::pbf_blob_summary other;
+    other.add(osmium::item_type::node, 300);
+    REQUIRE_FALSE(query.wants_blob(other));
+
+    osmium::io::read_query ways_only{osmium::osm_entity_bits::way};
+    REQUIRE_FALSE(ways_only.wants_blob(summary));
+}
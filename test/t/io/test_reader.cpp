@@ -8,8 +8,16 @@
 #include <osmium/memory/buffer.hpp>
 #include <osmium/visitor.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <future>
 #include <iterator>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
 struct CountHandler : public osmium::handler::Handler {
@@ -378,3 +386,459 @@ TEST_CASE("Reader with single object type per buffer") {
     check_buffer_counts("t/io/data-n5w1r0", {{5, 0, 0}, {0, 1, 0}}, osmium::io::buffers_type::single);
 }
 
+
+std::size_t count_nodes_in_buffer_callback(const char* filename) {
+    std::atomic<std::size_t> callback_count{0};
+    const osmium::io::decoded_buffer_callback callback{[&callback_count](osmium::memory::Buffer& buffer) {
+        const auto nodes = buffer.select<osmium::Node>();
+        callback_count += static_cast<std::size_t>(std::distance(nodes.begin(), nodes.end()));
+    }};
+
+    const osmium::io::File file{with_data_dir(filename)};
+    osmium::io::Reader reader{file, callback};
+
+    CountHandler handler;
+    osmium::apply(reader, handler);
+    reader.close();
+
+    REQUIRE(callback_count == static_cast<std::size_t>(handler.count));
+    return callback_count;
+}
+
+TEST_CASE("Reader calls decoded buffer callback on each buffer (XML)") {
+    REQUIRE(count_nodes_in_buffer_callback("t/io/data.osm") == 1);
+}
+
+TEST_CASE("Reader calls decoded buffer callback on each buffer (PBF)") {
+    REQUIRE(count_nodes_in_buffer_callback("t/io/data_pbf_version-1.osm.pbf") == 1);
+}
+
+TEST_CASE("Reader reports exception thrown in decoded buffer callback") {
+    const osmium::io::File file{with_data_dir("t/io/data_pbf_version-1.osm.pbf")};
+    osmium::io::Reader reader{file, osmium::io::decoded_buffer_callback{[](osmium::memory::Buffer& /*buffer*/) {
+        throw std::runtime_error{"error in callback"};
+    }}};
+
+    REQUIRE_THROWS_AS(reader.read(), std::runtime_error);
+}
+
+TEST_CASE("Reader sorting tags by key") {
+    const std::string data{"n1 v1 Tname=foo,highway=primary,amenity=cafe x1 y2\n"
+                           "w2 v1 Tb=1,a=2 Nn1\n"
+                           "r3 v1 Ttype=route Mn1@\n"};
+    const osmium::io::File file{data.data(), data.size(), "opl"};
+
+    std::atomic<std::size_t> callback_count{0};
+    const osmium::io::decoded_buffer_callback callback{[&callback_count](osmium::memory::Buffer& buffer) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            REQUIRE(object.tags().sorted_by_key());
+            ++callback_count;
+        }
+    }};
+
+    osmium::io::Reader reader{file, osmium::io::sort_tags::yes, callback};
+    const auto buffer = reader.read();
+    reader.close();
+
+    REQUIRE(callback_count == 3);
+    const auto& node = buffer.get<osmium::Node>(0);
+    REQUIRE(node.tags().sorted_by_key());
+    auto it = node.tags().begin();
+    REQUIRE(std::string{it->key()} == "amenity");
+    ++it;
+    REQUIRE(std::string{it->key()} == "highway");
+    ++it;
+    REQUIRE(std::string{it->key()} == "name");
+    REQUIRE(std::string{node.tags()["highway"]} == "primary");
+}
+
+TEST_CASE("Reader with queue sizes set") {
+    const osmium::io::File file{with_data_dir("t/io/data.osm")};
+    osmium::io::Reader reader{file, osmium::io::reader_queue_sizes{3, 5}};
+
+    CountHandler handler;
+    osmium::apply(reader, handler);
+    reader.close();
+
+    REQUIRE(handler.count == 1);
+    REQUIRE(reader.stats().input_queue.max_size == 3);
+    REQUIRE(reader.stats().osmdata_queue.max_size == 5);
+}
+
+TEST_CASE("Reader with only one queue size set uses default for the other") {
+    const osmium::io::File file{with_data_dir("t/io/data.osm")};
+    osmium::io::Reader reader{file, osmium::io::reader_queue_sizes{0, 7}};
+    reader.close();
+
+    REQUIRE(reader.stats().input_queue.max_size == 20);
+    REQUIRE(reader.stats().osmdata_queue.max_size == 7);
+}
+
+TEST_CASE("Reader decoding PBF with or without pool threads") {
+    const osmium::io::File file{with_data_dir("t/io/data_pbf_version-1.osm.pbf")};
+    osmium::thread::Pool pool{2};
+
+    SECTION("in pool") {
+        osmium::io::Reader reader{file, pool, osmium::io::pool_for_pbf_parsing::yes};
+        CountHandler handler;
+        osmium::apply(reader, handler);
+        reader.close();
+        REQUIRE(handler.count == 1);
+        REQUIRE(pool.stats().tasks_done > 0);
+    }
+
+    SECTION("in parser thread") {
+        osmium::io::Reader reader{file, pool, osmium::io::pool_for_pbf_parsing::no};
+        CountHandler handler;
+        osmium::apply(reader, handler);
+        reader.close();
+        REQUIRE(handler.count == 1);
+        REQUIRE(pool.stats().tasks_done == 0);
+    }
+}
+
+namespace {
+
+std::string generate_opl_nodes(int count) {
+    std::string data;
+    for (int i = 1; i <= count; ++i) {
+        data += "n" + std::to_string(i) + " v1 dV c1 t2020-01-01T00:00:00Z i1 utest Tamenity=bench x1.5 y2.5\n";
+    }
+    return data;
+}
+
+std::vector<std::size_t> objects_per_buffer(osmium::io::Reader& reader) {
+    std::vector<std::size_t> counts;
+    while (const osmium::memory::Buffer buffer = reader.read()) {
+        counts.push_back(static_cast<std::size_t>(std::distance(buffer.cbegin(), buffer.cend())));
+    }
+    reader.close();
+    return counts;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Reader with buffer size set") {
+    const std::string data = generate_opl_nodes(1000);
+    const osmium::io::File file{data.data(), data.size(), "opl"};
+
+    SECTION("default") {
+        osmium::io::Reader reader{file};
+        const auto counts = objects_per_buffer(reader);
+        REQUIRE(counts.size() == 1);
+        REQUIRE(counts[0] == 1000);
+    }
+
+    SECTION("object count") {
+        osmium::io::Reader reader{file, osmium::io::reader_buffer_size{0, osmium::io::buffer_policy::fixed, 100}};
+        const auto counts = objects_per_buffer(reader);
+        REQUIRE(counts.size() == 10);
+        for (const auto count : counts) {
+            REQUIRE(count == 100);
+        }
+    }
+
+    SECTION("size in bytes") {
+        osmium::io::Reader reader{file, osmium::io::reader_buffer_size{8192}};
+        const auto counts = objects_per_buffer(reader);
+        REQUIRE(counts.size() > 2);
+        std::size_t sum = 0;
+        for (const auto count : counts) {
+            sum += count;
+        }
+        REQUIRE(sum == 1000);
+    }
+
+    SECTION("latency policy reads all objects") {
+        osmium::io::Reader reader{file, osmium::io::reader_buffer_size{16384, osmium::io::buffer_policy::latency, 50}};
+        const auto counts = objects_per_buffer(reader);
+        std::size_t sum = 0;
+        for (const auto count : counts) {
+            REQUIRE(count > 0);
+            REQUIRE(count <= 50);
+            sum += count;
+        }
+        REQUIRE(sum == 1000);
+    }
+
+    SECTION("throughput policy reads all objects") {
+        osmium::io::Reader reader{file, osmium::io::reader_buffer_size{16384, osmium::io::buffer_policy::throughput, 50}};
+        const auto counts = objects_per_buffer(reader);
+        std::size_t sum = 0;
+        for (const auto count : counts) {
+            REQUIRE(count > 0);
+            REQUIRE(count <= 400);
+            sum += count;
+        }
+        REQUIRE(sum == 1000);
+    }
+}
+
+TEST_CASE("Reader with memory limit") {
+    const std::string data = generate_opl_nodes(5000);
+    const std::string filename{"test-reader-memory-limit.opl"};
+    {
+        std::ofstream out{filename};
+        out << data;
+    }
+
+    const osmium::io::max_memory_in_flight limit{1};
+    REQUIRE(limit.max_bytes() == 1);
+
+    SECTION("read thread stops when limit reached") {
+        osmium::io::Reader reader{filename, limit};
+        CountHandler handler;
+        osmium::apply(reader, handler);
+        reader.close();
+        REQUIRE(handler.count == 5000);
+    }
+
+    SECTION("parser reading PBF directly stops when limit reached") {
+        osmium::io::Reader reader{with_data_dir("t/io/data_pbf_version-1.osm.pbf"), limit};
+        CountHandler handler;
+        osmium::apply(reader, handler);
+        reader.close();
+        REQUIRE(handler.count == 1);
+    }
+
+    SECTION("two readers sharing a limit read one after the other") {
+        osmium::io::Reader reader1{filename, limit};
+        osmium::io::Reader reader2{filename, limit};
+
+        CountHandler handler1;
+        osmium::apply(reader1, handler1);
+        reader1.close();
+
+        CountHandler handler2;
+        osmium::apply(reader2, handler2);
+        reader2.close();
+
+        REQUIRE(handler1.count == 5000);
+        REQUIRE(handler2.count == 5000);
+    }
+
+    SECTION("closing reader early gives back its memory") {
+        osmium::io::Reader reader{filename, limit};
+        REQUIRE(reader.read());
+        reader.close();
+    }
+
+    REQUIRE(limit.used() == 0);
+}
+
+TEST_CASE("Reader without memory limit") {
+    const osmium::io::max_memory_in_flight limit{};
+    REQUIRE_FALSE(limit);
+    REQUIRE(limit.max_bytes() == 0);
+
+    osmium::io::Reader reader{with_data_dir("t/io/data.osm"), limit};
+    CountHandler handler;
+    osmium::apply(reader, handler);
+    reader.close();
+    REQUIRE(handler.count == 1);
+    REQUIRE(limit.used() == 0);
+}
+
+TEST_CASE("Reader with io_executor") {
+    osmium::thread::Pool io_pool{1};
+    const osmium::io::io_executor executor{io_pool};
+    REQUIRE(executor);
+
+    SECTION("uncompressed") {
+        osmium::io::Reader reader{with_data_dir("t/io/data.osm"), executor};
+        CountHandler handler;
+        osmium::apply(reader, handler);
+        reader.close();
+        REQUIRE(handler.count == 1);
+    }
+
+    SECTION("gzip compressed") {
+        osmium::io::Reader reader{with_data_dir("t/io/data.osm.gz"), executor};
+        CountHandler handler;
+        osmium::apply(reader, handler);
+        reader.close();
+        REQUIRE(handler.count == 1);
+    }
+
+    SECTION("PBF") {
+        osmium::io::Reader reader{with_data_dir("t/io/data_pbf_version-1.osm.pbf"), executor};
+        CountHandler handler;
+        osmium::apply(reader, handler);
+        reader.close();
+        REQUIRE(handler.count == 1);
+    }
+
+    SECTION("closing reader early") {
+        osmium::io::Reader reader{with_data_dir("t/io/data.osm"), executor};
+        reader.close();
+    }
+}
+
+TEST_CASE("Many readers sharing one io_executor") {
+    const std::string data = generate_opl_nodes(5000);
+    const std::string filename{"test-reader-io-executor.opl"};
+    {
+        std::ofstream out{filename};
+        out << data;
+    }
+
+    osmium::thread::Pool io_pool{1};
+    const osmium::io::io_executor executor{io_pool};
+    const osmium::io::reader_queue_sizes queue_sizes{2, 2};
+
+    std::vector<std::unique_ptr<osmium::io::Reader>> readers;
+    for (int i = 0; i < 8; ++i) {
+        readers.emplace_back(new osmium::io::Reader{filename, executor, queue_sizes});
+    }
+
+    // read from all readers in turn so they all have to make progress
+    std::vector<int> counts(readers.size());
+    bool more = true;
+    while (more) {
+        more = false;
+        for (std::size_t i = 0; i < readers.size(); ++i) {
+            if (const osmium::memory::Buffer buffer = readers[i]->read()) {
+                counts[i] += static_cast<int>(std::distance(buffer.cbegin(), buffer.cend()));
+                more = true;
+            }
+        }
+    }
+
+    for (auto& reader : readers) {
+        reader->close();
+    }
+
+    for (const int count : counts) {
+        REQUIRE(count == 5000);
+    }
+}
+
+struct ReadyFlag {
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool ready = false;
+
+    void set() {
+        std::lock_guard<std::mutex> lock{mutex};
+        ready = true;
+        condition.notify_one();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock{mutex};
+        condition.wait(lock, [this]() {
+            return ready;
+        });
+        ready = false;
+    }
+
+}; // struct ReadyFlag
+
+// Read all buffers with try_read(), waiting for the callback in between.
+std::size_t count_with_try_read(osmium::io::Reader& reader, ReadyFlag& flag) {
+    std::size_t count = 0;
+    while (true) {
+        osmium::memory::Buffer buffer;
+        if (!reader.try_read(buffer)) {
+            flag.wait();
+            continue;
+        }
+        if (!buffer) {
+            return count;
+        }
+        count += static_cast<std::size_t>(std::distance(buffer.cbegin(), buffer.cend()));
+    }
+}
+
+TEST_CASE("Reader with try_read and data_ready_callback") {
+    ReadyFlag flag;
+    const osmium::io::data_ready_callback callback{[&flag]() {
+        flag.set();
+    }};
+
+    SECTION("OPL decoded in parser thread") {
+        const std::string data = generate_opl_nodes(5000);
+        const osmium::io::File file{data.data(), data.size(), "opl"};
+        osmium::io::Reader reader{file, callback};
+        REQUIRE(count_with_try_read(reader, flag) == 5000);
+        REQUIRE(reader.eof());
+        osmium::memory::Buffer buffer;
+        REQUIRE_THROWS_AS(reader.try_read(buffer), osmium::io_error);
+        reader.close();
+    }
+
+    SECTION("PBF decoded in pool") {
+        osmium::io::Reader reader{with_data_dir("t/io/data_pbf_version-1.osm.pbf"), callback, osmium::io::pool_for_pbf_parsing::yes};
+        REQUIRE(count_with_try_read(reader, flag) == 1);
+        reader.close();
+    }
+
+    SECTION("error is reported from try_read") {
+        const std::string data{"n1 x1 y\nfoo\n"};
+        const osmium::io::File file{data.data(), data.size(), "opl"};
+        osmium::io::Reader reader{file, callback};
+        REQUIRE_THROWS_AS(count_with_try_read(reader, flag), osmium::opl_error);
+    }
+}
+
+TEST_CASE("Reader try_read without callback") {
+    osmium::io::Reader reader{with_data_dir("t/io/data.osm")};
+    std::size_t count = 0;
+    while (true) {
+        osmium::memory::Buffer buffer;
+        if (!reader.try_read(buffer)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (!buffer) {
+            break;
+        }
+        count += static_cast<std::size_t>(std::distance(buffer.cbegin(), buffer.cend()));
+    }
+    reader.close();
+    REQUIRE(count == 1);
+}
+
+#ifdef __cpp_lib_coroutine
+struct fire_and_forget {
+    struct promise_type {
+        fire_and_forget get_return_object() noexcept {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() noexcept {
+        }
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+    };
+}; // struct fire_and_forget
+
+fire_and_forget count_with_coroutine(osmium::io::Reader& reader, std::size_t& count, std::promise<void>& done) {
+    while (const osmium::memory::Buffer buffer = co_await reader.next_buffer()) {
+        count += static_cast<std::size_t>(std::distance(buffer.cbegin(), buffer.cend()));
+    }
+    done.set_value();
+}
+
+TEST_CASE("Reader with coroutine") {
+    const std::string data = generate_opl_nodes(5000);
+    const osmium::io::File file{data.data(), data.size(), "opl"};
+    osmium::io::Reader reader{file};
+
+    std::size_t count = 0;
+    std::promise<void> done;
+    auto future = done.get_future();
+    count_with_coroutine(reader, count, done);
+    future.get();
+
+    reader.close();
+    REQUIRE(count == 5000);
+}
+#endif
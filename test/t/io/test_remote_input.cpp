@@ -0,0 +1,180 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/any_compression.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/io/remote_input.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// Reading remote files is not supported on Windows.
+#ifndef _WIN32
+
+namespace {
+
+    std::string read_file(const std::string& filename) {
+        std::ifstream in{filename, std::ios::binary};
+        return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    }
+
+    osmium::memory::Buffer read_all(osmium::io::Reader& reader) {
+        osmium::memory::Buffer result{1024, osmium::memory::Buffer::auto_grow::yes};
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            result.add_buffer(buffer);
+            result.commit();
+        }
+        reader.close();
+        return result;
+    }
+
+    // Serves a file from memory like a server supporting range requests,
+    // with random delays so that requests finish out of order, and with
+    // the first request for every third chunk failing.
+    class MockServer {
+
+        std::string m_data;
+        std::mutex m_mutex;
+        std::set<std::size_t> m_failed;
+        std::mt19937 m_gen{42}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+        std::size_t m_requests = 0;
+
+    public:
+
+        explicit MockServer(std::string data) :
+            m_data(std::move(data)) {
+        }
+
+        std::string fetch(const std::size_t offset, const std::size_t size) {
+            int delay = 0;
+            {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                ++m_requests;
+                if ((offset / size) % 3 == 1 && m_failed.insert(offset).second) {
+                    throw std::runtime_error{"connection reset"};
+                }
+                delay = std::uniform_int_distribution<int>{0, 3}(m_gen);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{delay});
+            if (offset >= m_data.size()) {
+                return std::string{};
+            }
+            return m_data.substr(offset, size);
+        }
+
+        std::size_t requests() {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            return m_requests;
+        }
+
+    }; // class MockServer
+
+} // anonymous namespace
+
+TEST_CASE("Reading remote file with concurrent range requests") {
+    const char* filename = nullptr;
+    const char* url = nullptr;
+
+    SECTION("XML") {
+        filename = "t/io/data.osm";
+        url = "http://example.com/data.osm";
+    }
+    SECTION("bzip2 compressed XML") {
+        filename = "t/io/data.osm.bz2";
+        url = "https://example.com/data.osm.bz2";
+    }
+    SECTION("PBF") {
+        filename = "t/io/data_pbf_version-1.osm.pbf";
+        url = "https://example.com/data.osm.pbf";
+    }
+
+    osmium::io::Reader local_reader{with_data_dir(filename)};
+    const auto expected = read_all(local_reader);
+    REQUIRE(expected.committed() > 0);
+
+    MockServer server{read_file(with_data_dir(filename))};
+    osmium::io::remote_input remote{[&server](const std::string& /*url*/, std::size_t offset, std::size_t size) {
+        return server.fetch(offset, size);
+    }};
+    remote.chunk_size = 17;
+    remote.parallel_requests = 5;
+
+    osmium::io::Reader reader{url, remote};
+    const auto result = read_all(reader);
+
+    REQUIRE(result.committed() == expected.committed());
+    REQUIRE(std::equal(expected.data(), expected.data() + expected.committed(), result.data()));
+    REQUIRE(server.requests() > 10);
+}
+
+TEST_CASE("Reading remote file reports failing requests on close") {
+    int calls = 0;
+    std::mutex mutex;
+    osmium::io::remote_input remote{[&](const std::string& /*url*/, std::size_t /*offset*/, std::size_t /*size*/) -> std::string {
+        const std::lock_guard<std::mutex> lock{mutex};
+        ++calls;
+        throw std::runtime_error{"server unavailable"};
+    }};
+    remote.parallel_requests = 1;
+    remote.max_retries = 2;
+
+    const auto read_and_close = [&remote]() {
+        osmium::io::Reader reader{"http://example.com/data.osm.pbf", remote};
+        while (reader.read()) {
+        }
+        reader.close();
+    };
+    REQUIRE_THROWS_AS(read_and_close(), std::runtime_error);
+    REQUIRE(calls == 3);
+}
+
+TEST_CASE("Reading remote file from server without range requests fails once") {
+    int calls = 0;
+    std::mutex mutex;
+    osmium::io::remote_input remote{[&](const std::string& url, std::size_t /*offset*/, std::size_t /*size*/) -> std::string {
+        const std::lock_guard<std::mutex> lock{mutex};
+        ++calls;
+        throw osmium::io::range_requests_not_supported{url};
+    }};
+    remote.parallel_requests = 4;
+    remote.max_retries = 2;
+
+    const auto read_and_close = [&remote]() {
+        osmium::io::Reader reader{"http://example.com/data.osm.pbf", remote};
+        while (reader.read()) {
+        }
+        reader.close();
+    };
+    REQUIRE_THROWS_AS(read_and_close(), osmium::io::range_requests_not_supported);
+    REQUIRE(calls == 1);
+}
+
+TEST_CASE("Closing reader of remote file early") {
+    MockServer server{read_file(with_data_dir("t/io/data.osm"))};
+    osmium::io::remote_input remote{[&server](const std::string& /*url*/, std::size_t offset, std::size_t size) {
+        return server.fetch(offset, size);
+    }};
+    remote.chunk_size = 10;
+    remote.parallel_requests = 2;
+
+    osmium::io::Reader reader{"http://example.com/data.osm", remote};
+    reader.header();
+    reader.close();
+}
+
+TEST_CASE("Remote input needs a range fetcher") {
+    const osmium::io::remote_input remote{osmium::io::range_fetcher{}};
+    REQUIRE_THROWS_AS(osmium::io::Reader("http://example.com/data.osm", remote), osmium::io_error);
+}
+
+#endif
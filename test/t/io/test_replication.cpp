@@ -0,0 +1,127 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/gzip_compression.hpp>
+#include <osmium/io/replication.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Parse replication state") {
+    const std::string data{
+        "#Fri Jan 05 12:34:02 UTC 2024\n"
+        "sequenceNumber=5912345\n"
+        "timestamp=2024-01-05T12\\:33\\:56Z\n"};
+
+    const auto state = osmium::io::ReplicationState::parse(data);
+    REQUIRE(state.sequence_number == 5912345);
+    REQUIRE(state.timestamp == osmium::Timestamp{"2024-01-05T12:33:56Z"});
+}
+
+TEST_CASE("Parse replication state with CRLF and unknown keys") {
+    const auto state = osmium::io::ReplicationState::parse("txnMaxQueried=1\r\nsequenceNumber=17\r\n");
+    REQUIRE(state.sequence_number == 17);
+    REQUIRE(state.timestamp == osmium::Timestamp{});
+}
+
+TEST_CASE("Parse invalid replication state") {
+    REQUIRE_THROWS_AS(osmium::io::ReplicationState::parse(""), osmium::replication_error);
+    REQUIRE_THROWS_AS(osmium::io::ReplicationState::parse("sequenceNumber=abc\n"), osmium::replication_error);
+    REQUIRE_THROWS_AS(osmium::io::ReplicationState::parse("sequenceNumber=1\ntimestamp=foo\n"), osmium::replication_error);
+}
+
+TEST_CASE("Replication paths and URLs") {
+    REQUIRE(osmium::io::replication_path(0) == "000/000/000");
+    REQUIRE(osmium::io::replication_path(1234567) == "001/234/567");
+    REQUIRE(osmium::io::replication_path(999999999) == "999/999/999");
+    REQUIRE_THROWS_AS(osmium::io::replication_path(1000000000), osmium::replication_error);
+
+    const osmium::io::ReplicationServer server{"https://example.com/replication/minute/", [](const std::string&) {
+        return std::string{};
+    }};
+    REQUIRE(server.base_url() == "https://example.com/replication/minute");
+    REQUIRE(server.state_url() == "https://example.com/replication/minute/state.txt");
+    REQUIRE(server.state_url(5912345) == "https://example.com/replication/minute/005/912/345.state.txt");
+    REQUIRE(server.change_url(5912345) == "https://example.com/replication/minute/005/912/345.osc.gz");
+}
+
+namespace {
+
+    std::string make_change_file(const std::string& filename, osmium::memory::Buffer&& buffer) {
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+
+        std::ifstream file{filename, std::ios::binary};
+        return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Read changes from replication server") {
+    std::map<std::string, std::string> files;
+    const std::string base{"http://example.com/minute"};
+
+    files[base + "/state.txt"] = "sequenceNumber=12\ntimestamp=2024-01-01T00\\:12\\:00Z\n";
+
+    for (int n = 10; n <= 12; ++n) {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_node(buffer, _id(1), _version(n), _location(n, n));
+        osmium::builder::add_node(buffer, _id(100 + n), _version(1), _location(1.0, 1.0));
+        osmium::builder::add_way(buffer, _id(7), _version(n - 9), _nodes({1, 100 + n}));
+        const std::string filename{"test-replication-" + std::to_string(n) + ".osc.gz"};
+        files[base + "/000/000/0" + std::to_string(n) + ".osc.gz"] = make_change_file(filename, std::move(buffer));
+    }
+
+    std::mutex mutex;
+    std::vector<std::string> fetched;
+    const osmium::io::ReplicationServer server{base, [&](const std::string& url) {
+        {
+            const std::lock_guard<std::mutex> lock{mutex};
+            fetched.push_back(url);
+        }
+        const auto it = files.find(url);
+        if (it == files.end()) {
+            throw std::runtime_error{"not found: " + url};
+        }
+        return it->second;
+    }};
+
+    const auto state = server.state();
+    REQUIRE(state.sequence_number == 12);
+
+    osmium::thread::Pool pool{3};
+
+    SECTION("single file") {
+        const auto buffer = server.read_change_file(11);
+        REQUIRE(std::distance(buffer.cbegin<osmium::OSMObject>(), buffer.cend<osmium::OSMObject>()) == 3);
+    }
+
+    SECTION("merged files") {
+        const auto buffer = server.read_changes(10, state.sequence_number, pool);
+
+        std::vector<std::string> objects;
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            objects.push_back(osmium::item_type_to_char(object.type()) + std::to_string(object.id()) + "v" + std::to_string(object.version()));
+        }
+        const std::vector<std::string> expected{"n1v12", "n110v1", "n111v1", "n112v1", "w7v3"};
+        REQUIRE(objects == expected);
+        REQUIRE(fetched.size() == 4);
+    }
+
+    SECTION("missing file") {
+        REQUIRE_THROWS_AS(server.read_changes(10, 13, pool), std::runtime_error);
+    }
+}
@@ -4,6 +4,7 @@
 #include <osmium/util/misc.hpp>
 
 #include <iterator>
+#include <vector>
 #include <string>
 
 TEST_CASE("Empty StringStore") {
@@ -129,3 +130,85 @@ TEST_CASE("Lots of strings in string table so chunk overflows") {
     REQUIRE(it == st.end());
 }
 
+
+TEST_CASE("Long strings and strings with common prefix in StringTable") {
+    osmium::io::detail::StringTable st;
+
+    REQUIRE(st.add("abcdefghijklmnop") == 1);
+    REQUIRE(st.add("abcdefghijklmnopq") == 2);
+    REQUIRE(st.add("abcdefgh") == 3);
+    REQUIRE(st.add("abcdefghijklmnop") == 1);
+    REQUIRE(st.add("abcdefghijklmnopq") == 2);
+    REQUIRE(st.add("abcdefgh") == 3);
+    REQUIRE(st.size() == 4);
+}
+
+TEST_CASE("StringTable grows its hash table") {
+    osmium::io::detail::StringTable st{100000};
+    const auto initial_bucket_count = st.get_bucket_count();
+
+    const int n = 10000;
+    for (int i = 0; i < n; ++i) {
+        const auto s = std::to_string(i);
+        REQUIRE(st.add(s.c_str()) == i + 1);
+    }
+
+    REQUIRE(st.get_bucket_count() > initial_bucket_count);
+    for (int i = 0; i < n; ++i) {
+        const auto s = std::to_string(i);
+        REQUIRE(st.add(s.c_str()) == i + 1);
+    }
+}
+
+TEST_CASE("StringTable reports its memory use") {
+    osmium::io::detail::StringTable st{100};
+    const auto initial_memory = st.used_memory();
+    REQUIRE(initial_memory > 0);
+
+    for (int i = 0; i < 10000; ++i) {
+        st.add(std::to_string(i).c_str());
+    }
+    REQUIRE(st.used_memory() > initial_memory);
+}
+
+TEST_CASE("StringTable with bucket count from previous table") {
+    const osmium::io::detail::StringTable st{100, 1000};
+    REQUIRE(st.get_bucket_count() == 1024);
+
+    const osmium::io::detail::StringTable st2{100, st.get_bucket_count() - 1};
+    REQUIRE(st2.get_bucket_count() == 1024);
+}
+
+TEST_CASE("Reorder StringTable by frequency") {
+    osmium::io::detail::StringTable st;
+
+    REQUIRE(st.add("a") == 1);
+    REQUIRE(st.add("b") == 2);
+    REQUIRE(st.add("c") == 3);
+    REQUIRE(st.add("d") == 4);
+    st.add("c");
+    st.add("c");
+    st.add("b");
+    st.add("d");
+
+    const auto new_ids = st.reorder_by_frequency();
+    REQUIRE(new_ids.size() == 5);
+    REQUIRE(new_ids[0] == 0);
+    REQUIRE(new_ids[1] == 4); // a: 1 time
+    REQUIRE(new_ids[2] == 2); // b: 2 times
+    REQUIRE(new_ids[3] == 1); // c: 3 times
+    REQUIRE(new_ids[4] == 3); // d: 2 times
+
+    auto it = st.begin();
+    REQUIRE(std::string{} == *it++);
+    REQUIRE(std::string{"c"} == *it++);
+    REQUIRE(std::string{"b"} == *it++);
+    REQUIRE(std::string{"d"} == *it++);
+    REQUIRE(std::string{"a"} == *it++);
+    REQUIRE(it == st.end());
+
+    // lookups use the new ids
+    REQUIRE(st.add("a") == 4);
+    REQUIRE(st.add("c") == 1);
+    REQUIRE(st.add("e") == 5);
+}
@@ -0,0 +1,136 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/detail/uring_reader.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <string>
+
+#ifdef OSMIUM_WITH_IO_URING
+
+static std::string create_data(std::size_t size) {
+    std::string data;
+    data.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data += static_cast<char>('a' + (i * 7 + i / 4096) % 26);
+    }
+    return data;
+}
+
+static std::string write_temp_file(const std::string& data) {
+    char filename[] = "test_uring_reader_XXXXXX";
+    const int fd = mkstemp(filename);
+    REQUIRE(fd > 0);
+    osmium::io::detail::reliable_write(fd, data.data(), data.size());
+    REQUIRE(0 == close(fd));
+    return filename;
+}
+
+static std::string read_all(const std::string& filename, std::size_t block_size, std::size_t queue_depth, bool direct) {
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    REQUIRE(fd > 0);
+
+    std::string result;
+    {
+        osmium::io::detail::UringReader reader{fd, block_size, queue_depth, direct};
+        while (true) {
+            const std::string data{reader.read()};
+            if (data.empty()) {
+                break;
+            }
+            REQUIRE(data.size() <= block_size);
+            result += data;
+        }
+        REQUIRE(reader.read().empty());
+    }
+
+    REQUIRE(0 == close(fd));
+    return result;
+}
+
+TEST_CASE("Read files of different sizes with io_uring") {
+    const int count = count_fds();
+
+    for (const std::size_t size : {0, 1, 4095, 4096, 8192, 8193, 100000, 300000}) {
+        const std::string data = create_data(size);
+        const std::string filename = write_temp_file(data);
+
+        for (const bool direct : {false, true}) {
+            for (const std::size_t depth : {1, 3, 8}) {
+                try {
+                    REQUIRE(read_all(filename, 8192, depth, direct) == data);
+                } catch (const std::system_error&) {
+                    // io_uring not available on this system
+                    WARN("io_uring not available");
+                }
+            }
+        }
+
+        REQUIRE(0 == unlink(filename.c_str()));
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Destroy io_uring reader with reads in flight") {
+    const std::string data = create_data(100000);
+    const std::string filename = write_temp_file(data);
+
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    REQUIRE(fd > 0);
+    try {
+        osmium::io::detail::UringReader reader{fd, 4096, 8, false};
+        REQUIRE(reader.read() == data.substr(0, 4096));
+    } catch (const std::system_error&) {
+        WARN("io_uring not available");
+    }
+    REQUIRE(0 == close(fd));
+    REQUIRE(0 == unlink(filename.c_str()));
+}
+
+TEST_CASE("Read uncompressed file with io_uring") {
+    REQUIRE(::setenv("OSMIUM_USE_IO_URING", "yes", 1) == 0);
+    REQUIRE(::setenv("OSMIUM_IO_URING_QUEUE_DEPTH", "2", 1) == 0);
+
+    const int count = count_fds();
+
+    const std::string data = create_data(osmium::io::Decompressor::input_buffer_size * 3 + 17);
+    const std::string filename = write_temp_file(data);
+
+    for (const char* direct : {"no", "yes"}) {
+        REQUIRE(::setenv("OSMIUM_USE_DIRECT_IO", direct, 1) == 0);
+
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        REQUIRE(fd > 0);
+
+        std::atomic<std::size_t> offset{0};
+        osmium::io::NoDecompressor decomp{fd};
+        decomp.set_offset_ptr(&offset);
+        decomp.set_want_buffered_pages_removed(true);
+        std::string result;
+        while (true) {
+            const std::string buffer{decomp.read()};
+            if (buffer.empty()) {
+                break;
+            }
+            result += buffer;
+        }
+        decomp.close();
+
+        REQUIRE(result == data);
+        REQUIRE(offset == data.size());
+    }
+
+    REQUIRE(0 == unlink(filename.c_str()));
+    REQUIRE(count == count_fds());
+
+    REQUIRE(::unsetenv("OSMIUM_USE_DIRECT_IO") == 0);
+    REQUIRE(::unsetenv("OSMIUM_IO_URING_QUEUE_DEPTH") == 0);
+    REQUIRE(::unsetenv("OSMIUM_USE_IO_URING") == 0);
+}
+
+#endif
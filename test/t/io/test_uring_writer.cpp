@@ -0,0 +1,149 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/detail/uring_writer.hpp>
+#include <osmium/util/file.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#ifdef OSMIUM_WITH_IO_URING
+
+static std::string create_data(std::size_t size) {
+    std::string data;
+    data.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data += static_cast<char>('a' + (i * 7 + i / 4096) % 26);
+    }
+    return data;
+}
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream in{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+static const char* filename = "test_uring_writer.out";
+
+static void write_all(const std::string& data, std::size_t chunk_size, std::size_t queue_depth, bool direct) {
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    {
+        osmium::io::detail::UringWriter writer{fd, 8192, queue_depth, direct};
+        for (std::size_t offset = 0; offset < data.size(); offset += chunk_size) {
+            writer.write(data.data() + offset, std::min(chunk_size, data.size() - offset));
+        }
+        writer.flush();
+        REQUIRE(osmium::util::file_offset(fd) == data.size());
+    }
+
+    REQUIRE(0 == close(fd));
+}
+
+TEST_CASE("Write files of different sizes with io_uring") {
+    const int count = count_fds();
+
+    for (const std::size_t size : {0, 1, 4095, 4096, 8192, 8193, 100000, 300000}) {
+        const std::string data = create_data(size);
+
+        for (const bool direct : {false, true}) {
+            for (const std::size_t depth : {1, 3, 8}) {
+                for (const std::size_t chunk_size : {1000, 8192, 50000}) {
+                    try {
+                        write_all(data, chunk_size, depth, direct);
+                        REQUIRE(read_file(filename) == data);
+                    } catch (const std::system_error&) {
+                        // io_uring not available on this system
+                        WARN("io_uring not available");
+                    }
+                }
+            }
+        }
+    }
+
+    REQUIRE(0 == unlink(filename));
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Write with io_uring starting at current file offset") {
+    const std::string head{"0123456789"};
+    const std::string data = create_data(20000);
+
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+    osmium::io::detail::reliable_write(fd, head.data(), head.size());
+    try {
+        osmium::io::detail::UringWriter writer{fd, 4096, 2, true};
+        REQUIRE_FALSE(writer.direct());
+        writer.write(data.data(), data.size());
+        writer.flush();
+        REQUIRE(read_file(filename) == head + data);
+    } catch (const std::system_error&) {
+        WARN("io_uring not available");
+    }
+    REQUIRE(0 == close(fd));
+    REQUIRE(0 == unlink(filename));
+}
+
+TEST_CASE("Failing writes with io_uring are reported") {
+    const std::string data = create_data(100000);
+
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+    REQUIRE(0 == close(fd));
+
+    const int rfd = osmium::io::detail::open_for_reading(filename);
+    REQUIRE(rfd > 0);
+    try {
+        osmium::io::detail::UringWriter writer{rfd, 4096, 4, false};
+        const auto write_and_flush = [&]() {
+            writer.write(data.data(), data.size());
+            writer.flush();
+        };
+        REQUIRE_THROWS_AS(write_and_flush(), std::system_error);
+    } catch (const std::system_error&) {
+        WARN("io_uring not available");
+    }
+    REQUIRE(0 == close(rfd));
+    REQUIRE(0 == unlink(filename));
+}
+
+TEST_CASE("Write uncompressed file with io_uring") {
+    REQUIRE(::setenv("OSMIUM_USE_IO_URING_FOR_WRITING", "yes", 1) == 0);
+    REQUIRE(::setenv("OSMIUM_IO_URING_QUEUE_DEPTH", "2", 1) == 0);
+
+    const int count = count_fds();
+
+    const std::string data = create_data(osmium::io::detail::UringWriter::default_block_size * 3 + 17);
+
+    for (const char* direct : {"no", "yes"}) {
+        REQUIRE(::setenv("OSMIUM_USE_DIRECT_IO", direct, 1) == 0);
+
+        const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+        REQUIRE(fd > 0);
+
+        osmium::io::NoCompressor comp{fd, osmium::io::fsync::yes};
+        for (std::size_t offset = 0; offset < data.size(); offset += 100000) {
+            comp.write(data.substr(offset, 100000));
+        }
+        comp.close();
+
+        REQUIRE(comp.file_size() == data.size());
+        REQUIRE(read_file(filename) == data);
+    }
+
+    REQUIRE(0 == unlink(filename));
+    REQUIRE(count == count_fds());
+
+    REQUIRE(::unsetenv("OSMIUM_USE_DIRECT_IO") == 0);
+    REQUIRE(::unsetenv("OSMIUM_IO_URING_QUEUE_DEPTH") == 0);
+    REQUIRE(::unsetenv("OSMIUM_USE_IO_URING_FOR_WRITING") == 0);
+}
+
+#endif
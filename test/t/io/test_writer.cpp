@@ -223,3 +223,39 @@ TEST_CASE("Writer with user-provided pool with outlier positive number of thread
     REQUIRE(count == count_fds());
 }
 
+
+TEST_CASE("Writer with io_executor") {
+    osmium::thread::Pool io_pool{1};
+    const osmium::io::io_executor executor{io_pool};
+
+    auto buffer = get_buffer();
+    const auto num = std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend());
+
+    SECTION("uncompressed") {
+        osmium::io::Writer writer{"test-writer-io-executor.osm", executor, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+
+        osmium::io::Reader reader{"test-writer-io-executor.osm"};
+        const auto result = reader.read();
+        REQUIRE(std::distance(result.select<osmium::OSMObject>().cbegin(), result.select<osmium::OSMObject>().cend()) == num);
+        reader.close();
+    }
+
+    SECTION("compressed") {
+        osmium::io::Writer writer{"test-writer-io-executor.osm.gz", executor, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+
+        osmium::io::Reader reader{"test-writer-io-executor.osm.gz"};
+        const auto result = reader.read();
+        REQUIRE(std::distance(result.select<osmium::OSMObject>().cbegin(), result.select<osmium::OSMObject>().cend()) == num);
+        reader.close();
+    }
+
+    SECTION("io_executor must not be the encoding pool") {
+        osmium::thread::Pool pool{2};
+        REQUIRE_THROWS_AS(osmium::io::Writer("test-writer-io-executor.osm", pool, osmium::io::io_executor{pool}, osmium::io::overwrite::allow),
+                          std::invalid_argument);
+    }
+}
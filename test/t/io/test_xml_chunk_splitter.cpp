@@ -0,0 +1,206 @@
+#include "catch.hpp"
+
+#include <osmium/io/detail/xml_chunk_splitter.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct chunk_collector {
+
+    std::string prologue;
+    std::vector<std::pair<std::string, osmium::item_type>> chunks;
+
+    void split(osmium::io::detail::XMLChunkSplitter& splitter, bool last) {
+        splitter.split([this](const char* data, std::size_t size) {
+            prologue.assign(data, size);
+        }, [this](std::string&& document, osmium::item_type type) {
+            chunks.emplace_back(std::move(document), type);
+        }, last);
+    }
+
+}; // struct chunk_collector
+
+static const std::string osm_data{
+    "<?xml version='1.0' encoding='UTF-8'?>\n"
+    "<osm version=\"0.6\" generator=\"test\">\n"
+    "  <bounds minlat=\"0\" minlon=\"0\" maxlat=\"1\" maxlon=\"1\"/>\n"
+    "  <node id=\"1\" lat=\"1\" lon=\"1\"/>\n"
+    "  <!-- <node id=\"99\"/> -->\n"
+    "  <node id=\"2\" lat=\"1\" lon=\"1\"><tag k=\"a>b\" v=\"c\"/></node>\n"
+    "  <node id=\"3\" lat=\"1\" lon=\"1\"/>\n"
+    "  <way id=\"10\"><nd ref=\"1\"/><nd ref=\"2\"/></way>\n"
+    "  <way id=\"11\"><nd ref=\"2\"/><nd ref=\"3\"/></way>\n"
+    "</osm>\n"
+};
+
+TEST_CASE("Split OSM XML data into chunks by type") {
+    osmium::io::detail::XMLChunkSplitter splitter{1000000};
+    chunk_collector collector;
+
+    splitter.add(osm_data);
+    collector.split(splitter, true);
+
+    REQUIRE(splitter.prologue_done());
+    REQUIRE(splitter.root_closed());
+    REQUIRE(collector.prologue.find("<bounds") != std::string::npos);
+    REQUIRE(collector.prologue.find("<node") == std::string::npos);
+
+    REQUIRE(collector.chunks.size() == 2);
+    REQUIRE(collector.chunks[0].second == osmium::item_type::node);
+    REQUIRE(collector.chunks[1].second == osmium::item_type::way);
+    REQUIRE(collector.chunks[0].first.find("<?xml version='1.0' encoding='UTF-8'?><osm version=\"0.6\">") == 0);
+
+    const auto nodes = osmium::io::detail::parse_xml_chunk(collector.chunks[0].first, osmium::osm_entity_bits::all);
+    REQUIRE(std::distance(nodes.select<osmium::Node>().begin(), nodes.select<osmium::Node>().end()) == 3);
+    const auto ways = osmium::io::detail::parse_xml_chunk(collector.chunks[1].first, osmium::osm_entity_bits::all);
+    REQUIRE(std::distance(ways.select<osmium::Way>().begin(), ways.select<osmium::Way>().end()) == 2);
+}
+
+TEST_CASE("Split OSM XML data into small chunks with data arriving piecewise") {
+    osmium::io::detail::XMLChunkSplitter splitter{10};
+    chunk_collector collector;
+
+    for (std::size_t i = 0; i < osm_data.size(); i += 7) {
+        splitter.add(osm_data.substr(i, 7));
+        collector.split(splitter, i + 7 >= osm_data.size());
+    }
+
+    REQUIRE(splitter.root_closed());
+    REQUIRE(collector.chunks.size() == 5);
+    for (const auto& chunk : collector.chunks) {
+        const auto buffer = osmium::io::detail::parse_xml_chunk(chunk.first, osmium::osm_entity_bits::all);
+        REQUIRE(std::distance(buffer.begin(), buffer.end()) == 1);
+        REQUIRE(buffer.get<osmium::OSMObject>(0).type() == chunk.second);
+    }
+}
+
+TEST_CASE("Split OSM change data keeps sections") {
+    const std::string data{
+        "<osmChange version=\"0.6\">\n"
+        "  <create><node id=\"1\" version=\"1\" lat=\"1\" lon=\"1\"/></create>\n"
+        "  <modify/>\n"
+        "  <delete><node id=\"2\" version=\"2\"/><way id=\"3\" version=\"2\"/></delete>\n"
+        "</osmChange>\n"
+    };
+
+    osmium::io::detail::XMLChunkSplitter splitter{1000000};
+    chunk_collector collector;
+
+    splitter.add(data);
+    collector.split(splitter, true);
+
+    REQUIRE(collector.prologue == "<osmChange version=\"0.6\">\n  ");
+    REQUIRE(collector.chunks.size() == 3);
+    REQUIRE(collector.chunks[0].first == "<osmChange version=\"0.6\"><create><node id=\"1\" version=\"1\" lat=\"1\" lon=\"1\"/></create></osmChange>");
+    REQUIRE(collector.chunks[1].first == "<osmChange version=\"0.6\"><delete><node id=\"2\" version=\"2\"/></delete></osmChange>");
+    REQUIRE(collector.chunks[2].first == "<osmChange version=\"0.6\"><delete><way id=\"3\" version=\"2\"/></delete></osmChange>");
+
+    const auto buffer = osmium::io::detail::parse_xml_chunk(collector.chunks[1].first, osmium::osm_entity_bits::all);
+    REQUIRE_FALSE(buffer.get<osmium::Node>(0).visible());
+}
+
+TEST_CASE("Split XML data without objects") {
+    osmium::io::detail::XMLChunkSplitter splitter{1000000};
+    chunk_collector collector;
+
+    splitter.add("<osm version=\"0.6\"><bounds minlat=\"0\" minlon=\"0\" maxlat=\"1\" maxlon=\"1\"/></osm>");
+    collector.split(splitter, true);
+
+    REQUIRE_FALSE(splitter.prologue_done());
+    REQUIRE(splitter.root_closed());
+    REQUIRE(collector.chunks.empty());
+}
+
+static std::string generate_osm_data() {
+    std::string data{"<?xml version='1.0' encoding='UTF-8'?>\n<osm version=\"0.6\" generator=\"test\">\n"};
+    for (int i = 1; i <= 20000; ++i) {
+        const auto id = std::to_string(i);
+        data += "  <node id=\"" + id + "\" version=\"1\" lat=\"1.5\" lon=\"2.5\"><tag k=\"name\" v=\"node " + id + "\"/></node>\n";
+    }
+    for (int i = 1; i <= 10000; ++i) {
+        data += "  <way id=\"" + std::to_string(i) + "\" version=\"1\"><nd ref=\"" + std::to_string(i) + "\"/><nd ref=\"" + std::to_string(i + 1) + "\"/></way>\n";
+    }
+    data += "</osm>\n";
+    return data;
+}
+
+static osmium::memory::Buffer read_xml(const std::string& data, osmium::osm_entity_bits::type types = osmium::osm_entity_bits::all) {
+    const osmium::io::File file{data.data(), data.size(), "osm"};
+    osmium::io::Reader reader{file, types};
+    osmium::memory::Buffer result{1024, osmium::memory::Buffer::auto_grow::yes};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        result.add_buffer(buffer);
+        result.commit();
+    }
+    reader.close();
+    return result;
+}
+
+TEST_CASE("Reading XML in parallel gives same result as reading serially") {
+    const std::string data = generate_osm_data();
+    REQUIRE(data.size() > 2 * 1024 * 1024);
+
+    for (const auto types : {osmium::osm_entity_bits::all, osmium::osm_entity_bits::way}) {
+        const auto serial = read_xml(data, types);
+        REQUIRE(::setenv("OSMIUM_USE_PARALLEL_XML_PARSING", "yes", 1) == 0);
+        const auto parallel = read_xml(data, types);
+        REQUIRE(::unsetenv("OSMIUM_USE_PARALLEL_XML_PARSING") == 0);
+
+        REQUIRE(serial.committed() > 0);
+        REQUIRE(serial.committed() == parallel.committed());
+        REQUIRE(std::equal(serial.data(), serial.data() + serial.committed(), parallel.data()));
+    }
+}
+
+TEST_CASE("Reading changesets with discussions in parallel gives same result as reading serially") {
+    std::string data{"<?xml version='1.0' encoding='UTF-8'?>\n<osm version=\"0.6\" generator=\"test\">\n"};
+    for (int i = 1; i <= 10000; ++i) {
+        const auto id = std::to_string(i);
+        data += "  <changeset id=\"" + id + "\" created_at=\"2020-01-01T00:00:00Z\" closed_at=\"2020-01-01T01:00:00Z\" open=\"false\""
+                " num_changes=\"3\" user=\"u" + id + "\" uid=\"" + id + "\" comments_count=\"2\""
+                " min_lat=\"1.0\" min_lon=\"2.0\" max_lat=\"1.5\" max_lon=\"2.5\">\n"
+                "    <tag k=\"comment\" v=\"changeset " + id + "\"/>\n"
+                "    <discussion>\n"
+                "      <comment uid=\"7\" user=\"a\" date=\"2020-01-02T00:00:00Z\"><text>first &lt;comment&gt;</text></comment>\n"
+                "      <comment uid=\"8\" user=\"b\" date=\"2020-01-03T00:00:00Z\"><text>second</text></comment>\n"
+                "    </discussion>\n"
+                "  </changeset>\n";
+    }
+    data += "</osm>\n";
+    REQUIRE(data.size() > 2 * 1024 * 1024);
+
+    const auto serial = read_xml(data);
+    REQUIRE(::setenv("OSMIUM_USE_PARALLEL_XML_PARSING", "yes", 1) == 0);
+    const auto parallel = read_xml(data);
+    REQUIRE(::unsetenv("OSMIUM_USE_PARALLEL_XML_PARSING") == 0);
+
+    REQUIRE(serial.committed() > 0);
+    REQUIRE(serial.committed() == parallel.committed());
+    REQUIRE(std::equal(serial.data(), serial.data() + serial.committed(), parallel.data()));
+
+    osmium::changeset_id_type id = 0;
+    for (const auto& changeset : parallel.select<osmium::Changeset>()) {
+        REQUIRE(changeset.id() == ++id);
+        REQUIRE(changeset.num_comments() == 2);
+        REQUIRE(std::string{changeset.discussion().begin()->text()} == "first <comment>");
+    }
+    REQUIRE(id == 10000);
+}
+
+TEST_CASE("Reading broken XML in parallel throws") {
+    std::string data = generate_osm_data();
+    data.resize(data.size() - 10);
+
+    REQUIRE(::setenv("OSMIUM_USE_PARALLEL_XML_PARSING", "yes", 1) == 0);
+    REQUIRE_THROWS_AS(read_xml(data), osmium::xml_error);
+    REQUIRE(::unsetenv("OSMIUM_USE_PARALLEL_XML_PARSING") == 0);
+}
@@ -0,0 +1,145 @@
+#include "catch.hpp"
+
+#include <osmium/io/detail/xml_tokenizer.hpp>
+
+#include <expat.h>
+
+#include <string>
+
+// Records all events as a string. Consecutive character data is merged
+// because Expat can split it into several calls.
+struct EventRecorder {
+
+    std::string events;
+    std::string text;
+
+    void flush_text() {
+        if (!text.empty()) {
+            events += "T(" + text + ")";
+            text.clear();
+        }
+    }
+
+    void start_element(const char* element, const char** attrs) {
+        flush_text();
+        events += "S(";
+        events += element;
+        for (; *attrs; attrs += 2) {
+            events += std::string{" "} + attrs[0] + "=[" + attrs[1] + "]";
+        }
+        events += ")";
+    }
+
+    void end_element(const char* element) {
+        flush_text();
+        events += std::string{"E("} + element + ")";
+    }
+
+    void characters(const char* data, int len) {
+        text.append(data, static_cast<std::size_t>(len));
+    }
+
+}; // struct EventRecorder
+
+static bool tokenize(const std::string& document, std::string& events) {
+    EventRecorder recorder;
+    osmium::io::detail::XMLTokenizer<EventRecorder> tokenizer{recorder};
+    const bool result = tokenizer(document.data(), document.size());
+    recorder.flush_text();
+    events = recorder.events;
+    return result;
+}
+
+static bool expat_parse(const std::string& document, std::string& events) {
+    EventRecorder recorder;
+    XML_Parser parser = XML_ParserCreate(nullptr);
+    XML_SetUserData(parser, &recorder);
+    XML_SetElementHandler(parser, [](void* data, const XML_Char* element, const XML_Char** attrs) {
+        static_cast<EventRecorder*>(data)->start_element(element, attrs);
+    }, [](void* data, const XML_Char* element) {
+        static_cast<EventRecorder*>(data)->end_element(element);
+    });
+    XML_SetCharacterDataHandler(parser, [](void* data, const XML_Char* text, int len) {
+        static_cast<EventRecorder*>(data)->characters(text, len);
+    });
+    const bool result = XML_Parse(parser, document.data(), static_cast<int>(document.size()), 1) != XML_STATUS_ERROR;
+    XML_ParserFree(parser);
+    recorder.flush_text();
+    events = recorder.events;
+    return result;
+}
+
+TEST_CASE("XML tokenizer gives same events as Expat") {
+    const char* documents[] = {
+        "<osm/>",
+        "<?xml version='1.0' encoding='UTF-8'?>\n<osm version=\"0.6\">\n  <node id=\"1\" lat=\"1.5\" lon='2'/>\n</osm>\n",
+        "<?xml version=\"1.0\" encoding=\"utf-8\" ?><osm><node id=\"1\"><tag k=\"a&amp;b\" v=\"&lt;&gt;&quot;&apos;\"/></node></osm>",
+        "<osm><tag k=\"x\" v=\"&#65;&#x42;&#x20AC;&#128512;\"/></osm>",
+        "<osm><tag k=\"x\" v=\"a\tb\nc\r\nd\re\"/></osm>",
+        "<osm><tag k=\"x\" v=\"a&#10;b&#13;c\"/></osm>",
+        "<osm><tag k = \"x\"\n   v\t=\t'a>b'  /></osm>",
+        "<osm><text>Hello &amp; good\r\nbye\rand &#x263A; ]] &gt;</text></osm>",
+        "<osm><!-- comment <node/> --><?pi data?></osm><!-- end -->\n",
+        "<osm><node id=\"1\" user=\"\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80\"/></osm>",
+        "<osm a=\"\"></osm   >",
+    };
+
+    for (const char* document : documents) {
+        std::string tokenizer_events;
+        std::string expat_events;
+        REQUIRE(expat_parse(document, expat_events));
+        REQUIRE(tokenize(document, tokenizer_events));
+        REQUIRE(tokenizer_events == expat_events);
+    }
+}
+
+TEST_CASE("XML tokenizer rejects documents it doesn't understand or which are broken") {
+    const char* documents[] = {
+        "",
+        "<osm>",
+        "<osm></node>",
+        "<osm/><osm/>",
+        "<osm/>x",
+        "<osm a=\"1\"b=\"2\"/>",
+        "<osm a=\"1\" a=\"2\"/>",
+        "<osm a=\"<\"/>",
+        "<osm a=1/>",
+        "<osm a=\"&foo;\"/>",
+        "<osm a=\"&#0;\"/>",
+        "<osm a=\"&#xD800;\"/>",
+        "<osm>a]]>b</osm>",
+        "<osm><![CDATA[x]]></osm>",
+        "<!DOCTYPE osm><osm/>",
+        "<?xml version='1.0' encoding='ISO-8859-1'?><osm/>",
+        " <?xml version='1.0'?><osm/>",
+        "<osm><!-- a -- b --></osm>",
+        "<osm a=\"\x01\"/>",
+        "<osm a=\"\xc3\"/>",
+        "<osm a=\"\xc0\x80\"/>",
+        "<osm a=\"\xed\xa0\x80\"/>",
+        "\xef\xbb\xbf<osm/>",
+        "<\xc3\xa4/>",
+    };
+
+    for (const char* document : documents) {
+        std::string events;
+        REQUIRE_FALSE(tokenize(document, events));
+    }
+}
+
+TEST_CASE("UTF-8 validation") {
+    const std::string ascii{"abcdefghijklmnopqrstuvwxyz\n\t\r 0123456789"};
+    REQUIRE(osmium::io::detail::is_valid_xml_utf8(ascii.data(), ascii.data() + ascii.size()));
+
+    const std::string mixed{"abcdefgh\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80" "abcdefgh"};
+    REQUIRE(osmium::io::detail::is_valid_xml_utf8(mixed.data(), mixed.data() + mixed.size()));
+
+    const std::string control{"abcdefghijklmn\x1fopqrstuvwxyz"};
+    REQUIRE_FALSE(osmium::io::detail::is_valid_xml_utf8(control.data(), control.data() + control.size()));
+
+    const std::string truncated{"abcdefgh\xe2\x82"};
+    REQUIRE_FALSE(osmium::io::detail::is_valid_xml_utf8(truncated.data(), truncated.data() + truncated.size()));
+
+    const std::string nonchar{"\xef\xbf\xbf"};
+    REQUIRE_FALSE(osmium::io::detail::is_valid_xml_utf8(nonchar.data(), nonchar.data() + nonchar.size()));
+}
@@ -0,0 +1,221 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/zstd_compression.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/util/file.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <tuple>
+
+namespace {
+
+    std::string test_data() {
+        std::string data;
+        uint32_t state = 1;
+        for (int j = 0; j < 3000000; ++j) {
+            state = state * 1103515245U + 12345U;
+            data += static_cast<char>('a' + (state >> 16U) % 4);
+        }
+        return data;
+    }
+
+    std::string read_file(const std::string& filename) {
+        std::ifstream in{filename, std::ios::binary};
+        return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    }
+
+    std::string read_all(osmium::io::Decompressor& decomp) {
+        std::string all;
+        for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+            all += data;
+        }
+        decomp.close();
+        return all;
+    }
+
+    void check_seek_table(const std::string& compressed, const std::string& expected) {
+        const auto table = osmium::io::detail::zstd_seek_table::read(compressed.data(), compressed.size());
+        REQUIRE(table.size() == 3);
+
+        std::size_t compressed_size = 0;
+        std::size_t uncompressed_size = 0;
+        for (std::size_t n = 0; n < table.size(); ++n) {
+            compressed_size += table[n].first;
+            uncompressed_size += table[n].second;
+        }
+        REQUIRE(uncompressed_size == expected.size());
+        REQUIRE(compressed_size < compressed.size());
+
+        // Decompress only the frame containing the offset
+        const std::size_t offset = 2500000;
+        std::size_t frame = 0;
+        std::size_t frame_offset = 0;
+        std::size_t frame_start = 0;
+        std::tie(frame, frame_offset, frame_start) = table.find(offset);
+        REQUIRE(frame == 2);
+        REQUIRE(frame_start == 2 * osmium::io::ZstdCompressor::frame_size);
+
+        std::string data(table[frame].second, '\0');
+        const auto result = ZSTD_decompress(&data[0], data.size(), compressed.data() + frame_offset, table[frame].first);
+        REQUIRE_FALSE(ZSTD_isError(result));
+        REQUIRE(data == expected.substr(frame_start, data.size()));
+
+        REQUIRE(std::get<0>(table.find(expected.size())) == table.size());
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Empty zstd-compressed file") {
+    const int count = count_fds();
+
+    const int fd = osmium::io::detail::open_for_reading(with_data_dir("t/io/empty_file"));
+    REQUIRE(fd > 0);
+
+    osmium::io::ZstdDecompressor decomp{fd};
+    REQUIRE(decomp.read().empty());
+    decomp.close();
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Write and read zstd-compressed file") {
+    const int count = count_fds();
+    const std::string expected = test_data();
+
+    const std::string output_file = "test_zstd_out.txt.zst";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    std::size_t file_size = 0;
+    {
+        osmium::io::ZstdCompressor comp{fd, osmium::io::fsync::no};
+        for (std::size_t offset = 0; offset < expected.size(); offset += 100000) {
+            comp.write(expected.substr(offset, 100000));
+        }
+        comp.close();
+        file_size = comp.file_size();
+    }
+    REQUIRE(count == count_fds());
+    REQUIRE(file_size == osmium::file_size(output_file));
+    REQUIRE(file_size < expected.size() / 2);
+
+    check_seek_table(read_file(output_file), expected);
+
+    SECTION("read with normal decompressor") {
+        osmium::io::ZstdDecompressor decomp{osmium::io::detail::open_for_reading(output_file)};
+        REQUIRE(read_all(decomp) == expected);
+    }
+
+    SECTION("read with parallel decompressor") {
+        std::unique_ptr<osmium::io::Decompressor> decomp{osmium::io::detail::make_parallel_decompressor<osmium::io::detail::zstd_format>(osmium::io::detail::open_for_reading(output_file))};
+        REQUIRE(decomp);
+        REQUIRE(read_all(*decomp) == expected);
+    }
+
+    SECTION("read with buffer decompressor") {
+        const std::string compressed = read_file(output_file);
+        osmium::io::ZstdBufferDecompressor decomp{compressed.data(), compressed.size()};
+        REQUIRE(read_all(decomp) == expected);
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Write zstd-compressed file with parallel compressor") {
+    const int count = count_fds();
+    const std::string expected = test_data();
+
+    const std::string output_file = "test_zstd_parallel_out.txt.zst";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    std::size_t file_size = 0;
+    {
+        osmium::io::detail::ParallelCompressor<osmium::io::detail::zstd_compress_format> comp{fd, osmium::io::fsync::no, osmium::thread::Pool::default_instance()};
+        for (std::size_t offset = 0; offset < expected.size(); offset += osmium::io::ZstdCompressor::frame_size / 2) {
+            comp.write(expected.substr(offset, osmium::io::ZstdCompressor::frame_size / 2));
+        }
+        comp.close();
+        file_size = comp.file_size();
+    }
+    REQUIRE(count == count_fds());
+    REQUIRE(file_size == osmium::file_size(output_file));
+
+    check_seek_table(read_file(output_file), expected);
+
+    SECTION("read with normal decompressor") {
+        osmium::io::ZstdDecompressor decomp{osmium::io::detail::open_for_reading(output_file)};
+        REQUIRE(read_all(decomp) == expected);
+    }
+
+    SECTION("read with parallel decompressor") {
+        std::unique_ptr<osmium::io::Decompressor> decomp{osmium::io::detail::make_parallel_decompressor<osmium::io::detail::zstd_format>(osmium::io::detail::open_for_reading(output_file))};
+        REQUIRE(decomp);
+        REQUIRE(read_all(*decomp) == expected);
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Truncated zstd-compressed file") {
+    const std::string output_file = "test_zstd_truncated.txt.zst";
+    {
+        osmium::io::ZstdCompressor comp{osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow), osmium::io::fsync::no};
+        comp.write(test_data());
+    }
+
+    const std::string compressed = read_file(output_file);
+    osmium::io::ZstdBufferDecompressor decomp{compressed.data(), compressed.size() / 2};
+    REQUIRE_THROWS_AS(read_all(decomp), osmium::zstd_error);
+
+    REQUIRE_THROWS_AS(osmium::io::detail::zstd_seek_table::read(compressed.data(), compressed.size() / 2), osmium::zstd_error);
+}
+
+TEST_CASE("Write and read OPL file with zstd compression") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.5, 2.5), _tag("name", "node"));
+    }
+
+    const std::string filename{"test-zstd.osm.opl.zst"};
+    {
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    const std::string compressed = read_file(filename);
+    REQUIRE_NOTHROW(osmium::io::detail::zstd_seek_table::read(compressed.data(), compressed.size()));
+
+    osmium::io::File file{filename};
+    REQUIRE(file.compression() == osmium::io::file_compression::zstd);
+
+    SECTION("from file") {
+    }
+
+    SECTION("from buffer") {
+        file = osmium::io::File{compressed.data(), compressed.size(), "opl.zst"};
+    }
+
+    osmium::io::Reader reader{file};
+    std::size_t count = 0;
+    while (const auto buffer = reader.read()) {
+        count += static_cast<std::size_t>(std::distance(buffer.begin(), buffer.end()));
+    }
+    reader.close();
+    REQUIRE(count == 1000);
+}
@@ -72,6 +72,7 @@ TEST_CASE("Grow a buffer") {
 
 TEST_CASE("Reserve space in a non-growing buffer") {
     osmium::memory::Buffer buffer{128, osmium::memory::Buffer::auto_grow::no};
+    REQUIRE(buffer.get_auto_grow() == osmium::memory::Buffer::auto_grow::no);
 
     REQUIRE(buffer.reserve_space(20) != nullptr);
     REQUIRE(buffer.written() == 20);
@@ -80,6 +81,7 @@ TEST_CASE("Reserve space in a non-growing buffer") {
 
 TEST_CASE("Reserve space in a growing buffer") {
     osmium::memory::Buffer buffer{128, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE(buffer.get_auto_grow() == osmium::memory::Buffer::auto_grow::yes);
 
     REQUIRE(buffer.reserve_space(20) != nullptr);
     REQUIRE(buffer.written() == 20);
@@ -0,0 +1,131 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer_filter.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    struct RangeCallback {
+
+        std::size_t count = 0;
+        std::size_t bytes = 0;
+        std::size_t next_new_offset = 0;
+
+        void moving_range_in_buffer(std::size_t /*old_offset*/, std::size_t new_offset, std::size_t length) {
+            REQUIRE(new_offset == next_new_offset);
+            next_new_offset += length;
+            ++count;
+            bytes += length;
+        }
+
+    }; // struct RangeCallback
+
+    bool keep_even(const osmium::memory::Item& item) {
+        return static_cast<const osmium::OSMObject&>(item).id() % 2 == 0;
+    }
+
+    osmium::memory::Buffer fill_buffer(osmium::object_id_type num) {
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= num; ++id) {
+            if (id % 3 == 0) {
+                osmium::builder::add_way(buffer, _id(id), _nodes({1, 2, 3}));
+            } else {
+                osmium::builder::add_node(buffer, _id(id), _tag("foo", "bar"));
+            }
+        }
+        return buffer;
+    }
+
+    void check_filtered(const osmium::memory::Buffer& buffer, osmium::object_id_type num) {
+        REQUIRE(std::distance(buffer.begin(), buffer.end()) == num / 2);
+        osmium::object_id_type id = 2;
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            REQUIRE(object.id() == id);
+            REQUIRE(object.type() == (id % 3 == 0 ? osmium::item_type::way : osmium::item_type::node));
+            id += 2;
+        }
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Filter empty buffer") {
+    const osmium::memory::Buffer buffer{1024};
+    RangeCallback callback;
+    const auto result = osmium::memory::filter(buffer, keep_even, &callback);
+    REQUIRE(result.committed() == 0);
+    REQUIRE(callback.count == 0);
+}
+
+TEST_CASE("Filter buffer") {
+    const auto buffer = fill_buffer(100);
+
+    SECTION("keep all") {
+        RangeCallback callback;
+        const auto result = osmium::memory::filter(buffer, [](const osmium::memory::Item& /*item*/) {
+            return true;
+        }, &callback);
+        REQUIRE(result.committed() == buffer.committed());
+        REQUIRE(callback.count == 1);
+        REQUIRE(callback.bytes == buffer.committed());
+    }
+
+    SECTION("keep even") {
+        RangeCallback callback;
+        const auto result = osmium::memory::filter(buffer, keep_even, &callback);
+        check_filtered(result, 100);
+        REQUIRE(callback.count == 50);
+        REQUIRE(callback.bytes == result.committed());
+    }
+
+    SECTION("without callback") {
+        const auto result = osmium::memory::filter(buffer, keep_even);
+        check_filtered(result, 100);
+    }
+}
+
+TEST_CASE("Filter buffer drops removed items") {
+    auto buffer = fill_buffer(10);
+    for (auto& object : buffer.select<osmium::OSMObject>()) {
+        if (object.id() > 4) {
+            object.set_removed(true);
+        }
+    }
+
+    RangeCallback callback;
+    const auto result = osmium::memory::filter(buffer, [](const osmium::memory::Item& /*item*/) {
+        return true;
+    }, &callback);
+
+    REQUIRE(std::distance(result.begin(), result.end()) == 4);
+    REQUIRE(callback.count == 1);
+}
+
+TEST_CASE("Filter large buffer in thread pool") {
+    const osmium::object_id_type num = 200000;
+    const auto buffer = fill_buffer(num);
+    REQUIRE(buffer.committed() > 4UL * 1024UL * 1024UL);
+
+    osmium::thread::Pool pool{4};
+
+    SECTION("without callback") {
+        const auto result = osmium::memory::filter(buffer, keep_even, pool);
+        check_filtered(result, num);
+    }
+
+    SECTION("with callback") {
+        RangeCallback callback;
+        const auto result = osmium::memory::filter(buffer, keep_even, &callback, &pool);
+        check_filtered(result, num);
+        REQUIRE(callback.count == num / 2);
+        REQUIRE(callback.bytes == result.committed());
+    }
+}
@@ -0,0 +1,152 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+
+#include <iterator>
+#include <thread>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Buffer pool slab sizes") {
+    using pool = osmium::memory::BufferPool;
+    REQUIRE(pool::slab_size(0) == pool::min_slab_size);
+    REQUIRE(pool::slab_size(1000) == pool::min_slab_size);
+    REQUIRE(pool::slab_size(pool::min_slab_size) == pool::min_slab_size);
+    REQUIRE(pool::slab_size(pool::min_slab_size + 1) == pool::min_slab_size / 4 * 5);
+    REQUIRE(pool::slab_size(1024 * 1024) == 1024 * 1024);
+    REQUIRE(pool::slab_size(1024 * 1024 + 1) == 1024 * 1024 / 4 * 5);
+    REQUIRE(pool::slab_size(10 * 1024 * 1024) == 10 * 1024 * 1024);
+    REQUIRE(pool::slab_size(pool::max_slab_size) == pool::max_slab_size);
+    REQUIRE(pool::slab_size(pool::max_slab_size + 1) == 0);
+
+    for (std::size_t size = pool::min_slab_size; size < 100 * 1024 * 1024; size = size * 3 + 1) {
+        const auto slab = pool::slab_size(size);
+        REQUIRE(slab >= size);
+        REQUIRE(slab - size <= slab / 4);
+    }
+}
+
+TEST_CASE("Buffer pool reuses memory of destroyed buffers") {
+    osmium::memory::BufferPool pool;
+    const unsigned char* data = nullptr;
+
+    {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes, pool};
+        REQUIRE(buffer.capacity() == 1024 * 1024);
+        osmium::builder::add_node(buffer, _id(1));
+        data = buffer.data();
+    }
+
+    osmium::memory::Buffer buffer{1000 * 1000, osmium::memory::Buffer::auto_grow::yes, pool};
+    REQUIRE(buffer.data() == data);
+    REQUIRE(buffer.capacity() == 1000 * 1000);
+    REQUIRE(buffer.committed() == 0);
+}
+
+TEST_CASE("Buffer pool with small buffers") {
+    osmium::memory::BufferPool pool;
+    osmium::memory::Buffer buffer{128, osmium::memory::Buffer::auto_grow::yes, pool};
+    REQUIRE(buffer.capacity() == 128);
+
+    for (int i = 1; i <= 10000; ++i) {
+        osmium::builder::add_node(buffer, _id(i));
+    }
+    REQUIRE(buffer.capacity() > 128);
+    REQUIRE(std::distance(buffer.begin(), buffer.end()) == 10000);
+}
+
+TEST_CASE("Buffer pool with growing buffer") {
+    osmium::memory::BufferPool pool;
+
+    for (int n = 0; n < 3; ++n) {
+        osmium::memory::Buffer buffer{64 * 1024, osmium::memory::Buffer::auto_grow::yes, pool};
+        for (int i = 1; i <= 100000; ++i) {
+            osmium::builder::add_node(buffer, _id(i));
+        }
+        REQUIRE(buffer.capacity() > 64 * 1024);
+        REQUIRE(std::distance(buffer.begin(), buffer.end()) == 100000);
+
+        int id = 1;
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() == id);
+            ++id;
+        }
+    }
+}
+
+TEST_CASE("Buffer pool with internally growing buffer") {
+    osmium::memory::BufferPool pool;
+    osmium::memory::Buffer buffer{64 * 1024, osmium::memory::Buffer::auto_grow::internal, pool};
+    for (int i = 1; i <= 100000; ++i) {
+        osmium::builder::add_node(buffer, _id(i));
+    }
+    REQUIRE(buffer.has_nested_buffers());
+
+    int count = 0;
+    while (buffer.has_nested_buffers()) {
+        const auto nested = buffer.get_last_nested();
+        count += static_cast<int>(std::distance(nested->begin(), nested->end()));
+    }
+    count += static_cast<int>(std::distance(buffer.begin(), buffer.end()));
+    REQUIRE(count == 100000);
+}
+
+TEST_CASE("Buffer pool shares slabs between threads") {
+    osmium::memory::BufferPool pool;
+
+    std::thread thread{[&pool]() {
+        // more buffers than fit into the thread-local cache
+        std::vector<osmium::memory::Buffer> buffers;
+        for (int i = 0; i < 10; ++i) {
+            buffers.emplace_back(1024 * 1024, osmium::memory::Buffer::auto_grow::yes, pool);
+        }
+    }};
+    thread.join();
+
+    REQUIRE(pool.cached_bytes() > 0);
+    const auto cached = pool.cached_bytes();
+
+    {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes, pool};
+        REQUIRE(pool.cached_bytes() == cached - 1024 * 1024);
+    }
+
+    pool.clear();
+    REQUIRE(pool.cached_bytes() == 0);
+}
+
+TEST_CASE("Buffer pool frees slabs above limit") {
+    osmium::memory::BufferPool pool{false, 0};
+
+    {
+        std::vector<osmium::memory::Buffer> buffers;
+        for (int i = 0; i < 10; ++i) {
+            buffers.emplace_back(1024 * 1024, osmium::memory::Buffer::auto_grow::yes, pool);
+        }
+    }
+
+    REQUIRE(pool.cached_bytes() == 0);
+}
+
+TEST_CASE("Buffer pool with huge pages") {
+    osmium::memory::BufferPool pool{true};
+    osmium::memory::Buffer buffer{4 * 1024 * 1024, osmium::memory::Buffer::auto_grow::yes, pool};
+    osmium::builder::add_node(buffer, _id(1));
+    REQUIRE(std::distance(buffer.begin(), buffer.end()) == 1);
+}
+
+TEST_CASE("Move buffer with pool memory") {
+    osmium::memory::BufferPool pool;
+    osmium::memory::Buffer buffer1{1024 * 1024, osmium::memory::Buffer::auto_grow::yes, pool};
+    osmium::builder::add_node(buffer1, _id(1));
+
+    osmium::memory::Buffer buffer2{std::move(buffer1)};
+    REQUIRE(std::distance(buffer2.begin(), buffer2.end()) == 1);
+
+    osmium::memory::Buffer buffer3{100};
+    buffer3 = std::move(buffer2);
+    REQUIRE(std::distance(buffer3.begin(), buffer3.end()) == 1);
+}
@@ -0,0 +1,124 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm.hpp>
+#include <osmium/visitor.hpp>
+
+#include <iterator>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer mixed_buffer() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_node(buffer, _id(1));
+    osmium::builder::add_node(buffer, _id(2));
+    osmium::builder::add_way(buffer, _id(10), _nodes({1, 2}));
+    osmium::builder::add_node(buffer, _id(3));
+    osmium::builder::add_relation(buffer, _id(20), _member(osmium::item_type::way, 10));
+    osmium::builder::add_relation(buffer, _id(21));
+
+    return buffer;
+}
+
+TEST_CASE("Buffer without type index") {
+    const auto buffer = mixed_buffer();
+
+    REQUIRE_FALSE(buffer.has_type_index());
+    REQUIRE(buffer.count<osmium::Node>() == 3);
+    REQUIRE(buffer.count<osmium::Way>() == 1);
+    REQUIRE(buffer.count<osmium::OSMObject>() == 6);
+    REQUIRE(buffer.count<osmium::Area>() == 0);
+}
+
+TEST_CASE("Build type index on buffer") {
+    auto buffer = mixed_buffer();
+    buffer.build_type_index();
+
+    REQUIRE(buffer.has_type_index());
+    const auto& index = buffer.type_index();
+    REQUIRE(index.size() == buffer.committed());
+    REQUIRE(index.num_ranges() == 4);
+
+    auto it = index.begin();
+    REQUIRE(it->type == osmium::item_type::node);
+    REQUIRE(it->begin == 0);
+    REQUIRE(it->count == 2);
+    ++it;
+    REQUIRE(it->type == osmium::item_type::way);
+    REQUIRE(it->count == 1);
+    ++it;
+    REQUIRE(it->type == osmium::item_type::node);
+    REQUIRE(it->count == 1);
+    ++it;
+    REQUIRE(it->type == osmium::item_type::relation);
+    REQUIRE(it->count == 2);
+    REQUIRE(it->end == buffer.committed());
+
+    REQUIRE(buffer.count<osmium::Node>() == 3);
+    REQUIRE(buffer.count<osmium::Way>() == 1);
+    REQUIRE(buffer.count<osmium::Relation>() == 2);
+    REQUIRE(buffer.count<osmium::OSMObject>() == 6);
+    REQUIRE(buffer.count<osmium::Changeset>() == 0);
+
+    SECTION("select uses index") {
+        osmium::object_id_type sum = 0;
+        for (const auto& relation : buffer.select<osmium::Relation>()) {
+            sum += relation.id();
+        }
+        REQUIRE(sum == 41);
+
+        const auto ways = buffer.select<osmium::Way>();
+        REQUIRE(std::distance(ways.begin(), ways.end()) == 1);
+        REQUIRE(ways.begin()->id() == 10);
+
+        const auto nodes = buffer.select<osmium::Node>();
+        REQUIRE(std::distance(nodes.begin(), nodes.end()) == 3);
+
+        const auto areas = buffer.select<osmium::Area>();
+        REQUIRE(areas.empty());
+    }
+
+    SECTION("typed iterators use index") {
+        REQUIRE(buffer.begin<osmium::Relation>()->id() == 20);
+        REQUIRE(std::distance(buffer.cbegin<osmium::Relation>(), buffer.cend<osmium::Relation>()) == 2);
+        REQUIRE(buffer.begin<osmium::Changeset>() == buffer.end<osmium::Changeset>());
+    }
+
+    SECTION("apply uses index") {
+        int count = 0;
+        osmium::apply(buffer, [&](const osmium::Relation& relation) {
+            count += static_cast<int>(relation.id());
+        });
+        REQUIRE(count == 41);
+    }
+
+    SECTION("index is moved with buffer") {
+        const osmium::memory::Buffer other{std::move(buffer)};
+        REQUIRE(other.has_type_index());
+        REQUIRE(other.count<osmium::Relation>() == 2);
+    }
+
+    SECTION("index is stale after buffer was changed") {
+        osmium::builder::add_relation(buffer, _id(22));
+        REQUIRE_FALSE(buffer.has_type_index());
+        REQUIRE(buffer.count<osmium::Relation>() == 3);
+        REQUIRE(std::distance(buffer.select<osmium::Relation>().begin(), buffer.select<osmium::Relation>().end()) == 3);
+    }
+
+    SECTION("index is removed by clear") {
+        buffer.clear();
+        REQUIRE_FALSE(buffer.has_type_index());
+    }
+}
+
+TEST_CASE("Type index of empty buffer") {
+    osmium::memory::Buffer buffer{1024};
+    buffer.build_type_index();
+
+    REQUIRE(buffer.has_type_index());
+    REQUIRE(buffer.type_index().empty());
+    REQUIRE(buffer.count<osmium::Node>() == 0);
+    REQUIRE(buffer.select<osmium::Node>().empty());
+}
@@ -3,7 +3,14 @@
 #include <osmium/builder/attr.hpp>
 #include <osmium/memory/callback_buffer.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
 
@@ -99,3 +106,121 @@ TEST_CASE("Callback buffer with callback set later") {
 }
 
 
+
+TEST_CASE("Callback buffer in async mode") {
+    std::vector<osmium::object_id_type> ids;
+    std::thread::id callback_thread;
+
+    osmium::memory::CallbackBuffer cb{[&](osmium::memory::Buffer&& buffer){
+        callback_thread = std::this_thread::get_id();
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            ids.push_back(node.id());
+        }
+    }, 1000, 10};
+
+    REQUIRE_FALSE(cb.is_async());
+    cb.enable_async(2);
+    REQUIRE(cb.is_async());
+
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_node(cb.buffer(), _id(id));
+        cb.possibly_flush();
+    }
+    cb.flush();
+    cb.wait();
+    REQUIRE(cb.in_flight() == 0);
+
+    REQUIRE(ids.size() == 100);
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        REQUIRE(ids[static_cast<std::size_t>(id - 1)] == id);
+    }
+    REQUIRE(callback_thread != std::this_thread::get_id());
+
+    cb.disable_async();
+    REQUIRE_FALSE(cb.is_async());
+    osmium::builder::add_node(cb.buffer(), _id(101));
+    cb.flush();
+    REQUIRE(ids.size() == 101);
+    REQUIRE(callback_thread == std::this_thread::get_id());
+}
+
+TEST_CASE("Callback buffer in async mode doesn't wait for callback") {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool release = false;
+    std::atomic<int> run{0};
+
+    osmium::memory::CallbackBuffer cb{[&](osmium::memory::Buffer&& /*buffer*/){
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait(lock, [&]() { return release; });
+        ++run;
+    }, 1000, 10};
+    cb.enable_async(3);
+
+    // One buffer in the callback, three in the queue, none of these
+    // calls blocks.
+    for (osmium::object_id_type id = 1; id <= 4; ++id) {
+        osmium::builder::add_node(cb.buffer(), _id(id));
+        cb.flush();
+    }
+    REQUIRE(run == 0);
+    REQUIRE(cb.in_flight() == 4);
+
+    {
+        const std::lock_guard<std::mutex> lock{mutex};
+        release = true;
+    }
+    cv.notify_all();
+
+    cb.wait();
+    REQUIRE(run == 4);
+}
+
+TEST_CASE("Callback buffer in async mode hands remaining buffers to callback on destruction") {
+    int run = 0;
+    {
+        osmium::memory::CallbackBuffer cb{[&](osmium::memory::Buffer&& /*buffer*/){
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            ++run;
+        }, 1000, 10};
+        cb.enable_async(10);
+        for (osmium::object_id_type id = 1; id <= 5; ++id) {
+            osmium::builder::add_node(cb.buffer(), _id(id));
+            cb.flush();
+        }
+    }
+    REQUIRE(run == 5);
+}
+
+TEST_CASE("Callback buffer in async mode reports exceptions from callback") {
+    int run = 0;
+    osmium::memory::CallbackBuffer cb{[&](osmium::memory::Buffer&& /*buffer*/){
+        if (++run == 2) {
+            throw std::runtime_error{"callback failed"};
+        }
+    }, 1000, 10};
+    cb.enable_async(1);
+
+    osmium::builder::add_node(cb.buffer(), _id(1));
+    cb.flush();
+    osmium::builder::add_node(cb.buffer(), _id(2));
+    cb.flush();
+    REQUIRE_THROWS_WITH(cb.wait(), "callback failed");
+
+    // Exception is only reported once.
+    cb.wait();
+    osmium::builder::add_node(cb.buffer(), _id(3));
+    cb.flush();
+    cb.wait();
+    REQUIRE(run == 3);
+
+    osmium::builder::add_node(cb.buffer(), _id(4));
+    cb.flush();
+    cb.set_callback([](osmium::memory::Buffer&& /*buffer*/){
+        throw std::runtime_error{"other callback failed"};
+    });
+    osmium::builder::add_node(cb.buffer(), _id(5));
+    cb.flush();
+    REQUIRE_THROWS_WITH(cb.disable_async(), "other callback failed");
+    REQUIRE_FALSE(cb.is_async());
+}
@@ -0,0 +1,170 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/memory/segmented_buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Empty segmented buffer") {
+    const osmium::memory::SegmentedBuffer buffer;
+    REQUIRE(buffer.num_segments() == 1);
+    REQUIRE(buffer.committed() == 0);
+    REQUIRE(buffer.begin() == buffer.end());
+    REQUIRE(std::distance(buffer.begin(), buffer.end()) == 0);
+}
+
+TEST_CASE("Segmented buffer with one segment") {
+    osmium::memory::SegmentedBuffer buffer;
+    osmium::builder::add_node(buffer.buffer(), _id(1));
+    osmium::builder::add_node(buffer.buffer(), _id(2));
+
+    REQUIRE(buffer.num_segments() == 1);
+    REQUIRE(std::distance(buffer.begin(), buffer.end()) == 2);
+    REQUIRE(buffer.begin<osmium::Node>()->id() == 1);
+}
+
+TEST_CASE("Segmented buffer grows by adding segments") {
+    osmium::memory::SegmentedBuffer buffer{4096};
+
+    const unsigned char* first_data = buffer.buffer().data();
+    for (int i = 1; i <= 1000; ++i) {
+        osmium::builder::add_node(buffer.buffer(), _id(i), _tag("foo", "bar"));
+    }
+
+    REQUIRE(buffer.num_segments() > 1);
+    REQUIRE(buffer.segment(0).data() == first_data);
+    REQUIRE(buffer.segment(0).capacity() == 4096);
+    REQUIRE(buffer.capacity() == 4096 * buffer.num_segments());
+
+    std::size_t committed = 0;
+    for (std::size_t n = 0; n < buffer.num_segments(); ++n) {
+        committed += buffer.segment(n).committed();
+    }
+    REQUIRE(buffer.committed() == committed);
+
+    int id = 1;
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        REQUIRE(node.id() == id);
+        REQUIRE(std::string{node.tags().get_value_by_key("foo")} == "bar");
+        ++id;
+    }
+    REQUIRE(id == 1001);
+}
+
+TEST_CASE("Segmented buffer with items larger than segment size") {
+    osmium::memory::SegmentedBuffer buffer{1024};
+
+    std::vector<osmium::object_id_type> nodes;
+    for (osmium::object_id_type i = 1; i <= 1000; ++i) {
+        nodes.push_back(i);
+    }
+
+    osmium::builder::add_node(buffer.buffer(), _id(1));
+    osmium::builder::add_way(buffer.buffer(), _id(2), _nodes(nodes));
+    osmium::builder::add_node(buffer.buffer(), _id(3));
+
+    REQUIRE(std::distance(buffer.begin(), buffer.end()) == 3);
+    REQUIRE(std::distance(buffer.begin<osmium::Way>(), buffer.end<osmium::Way>()) == 1);
+    REQUIRE(buffer.begin<osmium::Way>()->nodes().size() == 1000);
+}
+
+TEST_CASE("Segmented buffer iteration by type skips segments without matching items") {
+    osmium::memory::SegmentedBuffer buffer{1024};
+
+    for (int i = 1; i <= 200; ++i) {
+        osmium::builder::add_node(buffer.buffer(), _id(i));
+    }
+    osmium::builder::add_way(buffer.buffer(), _id(1));
+    for (int i = 201; i <= 400; ++i) {
+        osmium::builder::add_node(buffer.buffer(), _id(i));
+    }
+    osmium::builder::add_way(buffer.buffer(), _id(2));
+
+    REQUIRE(buffer.num_segments() > 2);
+
+    auto it = buffer.begin<osmium::Way>();
+    REQUIRE(it->id() == 1);
+    ++it;
+    REQUIRE(it->id() == 2);
+    ++it;
+    REQUIRE(it == buffer.end<osmium::Way>());
+
+    REQUIRE(std::distance(buffer.begin<osmium::Node>(), buffer.end<osmium::Node>()) == 400);
+}
+
+TEST_CASE("Modify items in segmented buffer") {
+    osmium::memory::SegmentedBuffer buffer{1024};
+    for (int i = 1; i <= 100; ++i) {
+        osmium::builder::add_node(buffer.buffer(), _id(i));
+    }
+
+    for (auto& node : buffer.select<osmium::Node>()) {
+        node.set_visible(false);
+    }
+
+    REQUIRE(std::none_of(buffer.cbegin(), buffer.cend(), [](const osmium::OSMEntity& entity) {
+        return static_cast<const osmium::OSMObject&>(entity).visible();
+    }));
+}
+
+TEST_CASE("Copy into segmented buffer with back_inserter") {
+    osmium::memory::Buffer input{1024};
+    for (int i = 1; i <= 100; ++i) {
+        osmium::builder::add_node(input, _id(i));
+    }
+
+    osmium::memory::SegmentedBuffer buffer{512};
+    std::copy(input.cbegin(), input.cend(), std::back_inserter(buffer));
+
+    REQUIRE(buffer.num_segments() > 1);
+    REQUIRE(std::distance(buffer.begin(), buffer.end()) == 100);
+}
+
+TEST_CASE("Release segments of segmented buffer") {
+    osmium::memory::BufferPool pool;
+    osmium::memory::SegmentedBuffer buffer{64 * 1024, pool};
+    for (int i = 1; i <= 10000; ++i) {
+        osmium::builder::add_node(buffer.buffer(), _id(i));
+    }
+    const auto num_segments = buffer.num_segments();
+    REQUIRE(num_segments > 1);
+
+    auto segments = buffer.release();
+    REQUIRE(segments.size() == num_segments);
+    REQUIRE(buffer.num_segments() == 1);
+    REQUIRE(buffer.committed() == 0);
+    REQUIRE(buffer.begin() == buffer.end());
+
+    int id = 1;
+    for (const auto& segment : segments) {
+        for (const auto& node : segment.select<osmium::Node>()) {
+            REQUIRE(node.id() == id);
+            ++id;
+        }
+    }
+    REQUIRE(id == 10001);
+
+    osmium::builder::add_node(buffer.buffer(), _id(1));
+    REQUIRE(std::distance(buffer.begin(), buffer.end()) == 1);
+}
+
+TEST_CASE("Clear segmented buffer") {
+    osmium::memory::SegmentedBuffer buffer{1024};
+    for (int i = 1; i <= 100; ++i) {
+        osmium::builder::add_node(buffer.buffer(), _id(i));
+    }
+    REQUIRE(buffer.num_segments() > 1);
+
+    buffer.clear();
+    REQUIRE(buffer.num_segments() == 1);
+    REQUIRE(buffer.committed() == 0);
+    REQUIRE(buffer.begin() == buffer.end());
+}
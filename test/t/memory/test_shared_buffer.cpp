@@ -0,0 +1,71 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/shared_buffer.hpp>
+#include <osmium/osm/node.hpp>
+
+#include <iterator>
+#include <thread>
+#include <utility>
+
+static osmium::memory::Buffer create_buffer() {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1));
+    osmium::builder::add_node(buffer, _id(2));
+    return buffer;
+}
+
+TEST_CASE("Default constructed SharedBuffer is invalid") {
+    const osmium::memory::SharedBuffer buffer;
+    REQUIRE_FALSE(buffer);
+    REQUIRE(buffer.get() == nullptr);
+    REQUIRE(buffer.use_count() == 0);
+}
+
+TEST_CASE("SharedBuffer shares the buffer without copying") {
+    osmium::memory::Buffer buffer{create_buffer()};
+    const auto* data = buffer.data();
+
+    const osmium::memory::SharedBuffer shared{std::move(buffer)};
+    REQUIRE(shared);
+    REQUIRE(shared.use_count() == 1);
+    REQUIRE(shared->data() == data);
+
+    const osmium::memory::SharedBuffer copy{shared}; // NOLINT(performance-unnecessary-copy-initialization)
+    REQUIRE(shared.use_count() == 2);
+    REQUIRE(copy->data() == data);
+    REQUIRE(&*copy == &*shared);
+
+    REQUIRE(std::distance(copy.begin(), copy.end()) == 2);
+    REQUIRE(shared.ptr()->cbegin<osmium::Node>()->id() == 1);
+}
+
+TEST_CASE("SharedBuffer calls release function once after last reference is gone") {
+    int released = 0;
+    const unsigned char* released_data = nullptr;
+
+    osmium::memory::Buffer buffer{create_buffer()};
+    const auto* data = buffer.data();
+
+    osmium::memory::SharedBuffer shared{std::move(buffer), [&](osmium::memory::Buffer&& b) {
+        ++released;
+        released_data = b.data();
+    }};
+
+    osmium::memory::SharedBuffer copy{shared};
+    std::thread thread{[copy]() {
+        REQUIRE(std::distance(copy.begin(), copy.end()) == 2);
+    }};
+    thread.join();
+
+    shared.reset();
+    REQUIRE(released == 0);
+    REQUIRE(copy);
+
+    copy.reset();
+    REQUIRE(released == 1);
+    REQUIRE(released_data == data);
+}
@@ -0,0 +1,302 @@
+#include "catch.hpp"
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/geom/wkt.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/compressed_way_node_list.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/relations/members_database.hpp>
+#include <osmium/relations/relations_database.hpp>
+#include <osmium/storage/item_stash.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    std::vector<osmium::NodeRef> test_node_refs() {
+        return {
+            {1000, osmium::Location{13.37, 52.51}},
+            {1001, osmium::Location{13.3701, 52.5102}},
+            {999, osmium::Location{}},
+            {-17, osmium::Location{-179.9999999, -89.9999999}},
+            {std::numeric_limits<osmium::object_id_type>::max(), osmium::Location{179.9999999, 89.9999999}},
+            {0, osmium::Location{0, 0}},
+            {1000, osmium::Location{13.37, 52.51}}
+        };
+    }
+
+    std::vector<osmium::NodeRef> decode(const osmium::CompressedWayNodeList& list) {
+        return std::vector<osmium::NodeRef>(list.cbegin(), list.cend());
+    }
+
+    std::size_t add_multipolygon_ways(osmium::memory::Buffer& buffer) {
+        const auto pos = osmium::builder::add_way(buffer,
+            _id(10),
+            _tag("highway", "path"),
+            _nodes({
+                {1, {1.0, 1.0}},
+                {2, {1.0, 4.0}},
+                {3, {4.0, 4.0}}
+            })
+        );
+        osmium::builder::add_way(buffer,
+            _id(11),
+            _nodes({
+                {3, {4.0, 4.0}},
+                {4, {4.0, 1.0}},
+                {1, {1.0, 1.0}}
+            })
+        );
+        osmium::builder::add_way(buffer,
+            _id(12),
+            _nodes({
+                {5, {2.0, 2.0}},
+                {6, {3.0, 2.0}},
+                {7, {3.0, 3.0}},
+                {5, {2.0, 2.0}}
+            })
+        );
+        return pos;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Empty compressed way node list") {
+    osmium::memory::Buffer buffer{1024};
+    {
+        osmium::builder::CompressedWayNodeListBuilder builder{buffer};
+    }
+    buffer.commit();
+
+    const auto& list = buffer.get<osmium::CompressedWayNodeList>(0);
+    REQUIRE(list.type() == osmium::item_type::compressed_way_node_list);
+    REQUIRE(list.empty());
+    REQUIRE(list.size() == 0);
+    REQUIRE(list.encoded_size() == 0);
+    REQUIRE(list.cbegin() == list.cend());
+    REQUIRE_FALSE(list.envelope().valid());
+}
+
+TEST_CASE("Compressed way node list round trip") {
+    const auto node_refs = test_node_refs();
+
+    osmium::memory::Buffer buffer{1024};
+    {
+        osmium::builder::CompressedWayNodeListBuilder builder{buffer};
+        builder.add_node_refs(node_refs.cbegin(), node_refs.cend());
+    }
+    buffer.commit();
+
+    const auto& list = buffer.get<osmium::CompressedWayNodeList>(0);
+    REQUIRE(list.size() == node_refs.size());
+    REQUIRE(list.padded_size() % osmium::memory::align_bytes == 0);
+
+    const auto decoded = decode(list);
+    REQUIRE(decoded.size() == node_refs.size());
+    for (std::size_t i = 0; i < node_refs.size(); ++i) {
+        REQUIRE(decoded[i].ref() == node_refs[i].ref());
+        REQUIRE(decoded[i].location() == node_refs[i].location());
+    }
+
+    REQUIRE(list.front() == node_refs.front());
+    REQUIRE(list.back() == node_refs.back());
+    REQUIRE(list.back().location() == node_refs.back().location());
+
+    osmium::Box box;
+    for (const auto& nr : node_refs) {
+        box.extend(nr.location());
+    }
+    REQUIRE(list.envelope() == box);
+}
+
+TEST_CASE("Compressed way node list is much smaller than WayNodeList") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    {
+        osmium::builder::WayNodeListBuilder builder{buffer};
+        for (int i = 0; i < 1000; ++i) {
+            builder.add_node_ref(100000000 + i * 3, osmium::Location{int32_t(135000000 + i * 50), int32_t(525000000 - i * 35)});
+        }
+    }
+    const auto pos = buffer.commit();
+    const auto& wnl = buffer.get<osmium::WayNodeList>(pos);
+
+    {
+        osmium::builder::CompressedWayNodeListBuilder builder{buffer};
+        builder.add_node_refs(wnl.cbegin(), wnl.cend());
+    }
+    const auto cpos = buffer.commit();
+    const auto& list = buffer.get<osmium::CompressedWayNodeList>(cpos);
+    const auto& wnl2 = buffer.get<osmium::WayNodeList>(pos);
+
+    REQUIRE(list.size() == wnl2.size());
+    REQUIRE(list.padded_size() * 3 < wnl2.padded_size());
+    REQUIRE(std::equal(list.cbegin(), list.cend(), wnl2.cbegin(), [](const osmium::NodeRef& a, const osmium::NodeRef& b) {
+        return a.ref() == b.ref() && a.location() == b.location();
+    }));
+}
+
+TEST_CASE("Compressed copy of way") {
+    osmium::memory::Buffer buffer{1024};
+    const auto pos = osmium::builder::add_way(buffer,
+        _id(17),
+        _version(3),
+        _cid(22),
+        _uid(4),
+        _user("foo"),
+        _timestamp("2020-01-02T03:04:05Z"),
+        _tag("highway", "primary"),
+        _nodes({
+            {1, {1.0, 1.0}},
+            {2, {1.0, 2.0}},
+            {3, {2.0, 2.0}}
+        })
+    );
+    const auto& way = buffer.get<osmium::Way>(pos);
+    REQUIRE(way.compressed_nodes() == nullptr);
+
+    osmium::memory::Buffer out{1024};
+    const auto cpos = osmium::builder::add_compressed_way(out, way);
+    const auto& cway = out.get<osmium::Way>(cpos);
+
+    REQUIRE(cway.id() == 17);
+    REQUIRE(cway.version() == 3);
+    REQUIRE(cway.changeset() == 22);
+    REQUIRE(cway.uid() == 4);
+    REQUIRE(std::string{cway.user()} == "foo");
+    REQUIRE(cway.timestamp() == way.timestamp());
+    REQUIRE(std::string{cway.tags().get_value_by_key("highway")} == "primary");
+    REQUIRE(cway.nodes().empty());
+
+    const auto* nodes = cway.compressed_nodes();
+    REQUIRE(nodes);
+    REQUIRE(nodes->size() == 3);
+    REQUIRE(std::equal(nodes->cbegin(), nodes->cend(), way.nodes().cbegin(), [](const osmium::NodeRef& a, const osmium::NodeRef& b) {
+        return a.ref() == b.ref() && a.location() == b.location();
+    }));
+}
+
+TEST_CASE("Geometry from way with compressed node list") {
+    osmium::memory::Buffer buffer{1024};
+    const auto pos = osmium::builder::add_way(buffer,
+        _id(1),
+        _nodes({
+            {1, {1.0, 1.0}},
+            {2, {1.0, 2.0}},
+            {2, {1.0, 2.0}},
+            {3, {2.0, 2.0}},
+            {1, {1.0, 1.0}}
+        })
+    );
+    const auto& way = buffer.get<osmium::Way>(pos);
+
+    osmium::memory::Buffer out{1024};
+    const auto& cway = out.get<osmium::Way>(osmium::builder::add_compressed_way(out, way));
+
+    osmium::geom::WKTFactory<> factory;
+    for (const auto un : {osmium::geom::use_nodes::unique, osmium::geom::use_nodes::all}) {
+        for (const auto dir : {osmium::geom::direction::forward, osmium::geom::direction::backward}) {
+            REQUIRE(factory.create_linestring(cway, un, dir) == factory.create_linestring(way, un, dir));
+            REQUIRE(factory.create_polygon(cway, un, dir) == factory.create_polygon(way, un, dir));
+        }
+    }
+    REQUIRE(factory.create_linestring(cway) == "LINESTRING(1 1,1 2,2 2,1 1)");
+}
+
+TEST_CASE("Assemble multipolygon from ways with compressed node lists") {
+    osmium::memory::Buffer buffer{10240};
+    const auto wpos = add_multipolygon_ways(buffer);
+    const auto rpos = osmium::builder::add_relation(buffer,
+        _id(1),
+        _tag("type", "multipolygon"),
+        _tag("landuse", "forest"),
+        _member(osmium::item_type::way, 10, "outer"),
+        _member(osmium::item_type::way, 11, "outer"),
+        _member(osmium::item_type::way, 12, "inner")
+    );
+
+    osmium::memory::Buffer cbuffer{10240};
+    std::vector<const osmium::Way*> ways;
+    std::vector<const osmium::Way*> cways;
+    std::vector<std::size_t> offsets;
+    for (auto it = buffer.select<osmium::Way>().cbegin(); it != buffer.select<osmium::Way>().cend(); ++it) {
+        ways.push_back(&*it);
+        offsets.push_back(osmium::builder::add_compressed_way(cbuffer, *it));
+    }
+    for (const auto offset : offsets) {
+        cways.push_back(&cbuffer.get<osmium::Way>(offset));
+    }
+    REQUIRE(wpos == 0);
+    REQUIRE(ways.size() == 3);
+
+    const osmium::area::AssemblerConfig config;
+    const auto& relation = buffer.get<osmium::Relation>(rpos);
+
+    osmium::memory::Buffer area_buffer{10240};
+    osmium::area::Assembler assembler1{config};
+    REQUIRE(assembler1(relation, ways, area_buffer));
+
+    osmium::memory::Buffer carea_buffer{10240};
+    osmium::area::Assembler assembler2{config};
+    REQUIRE(assembler2(relation, cways, carea_buffer));
+
+    const auto& area = area_buffer.get<osmium::Area>(0);
+    const auto& carea = carea_buffer.get<osmium::Area>(0);
+    REQUIRE(area.num_rings() == carea.num_rings());
+    REQUIRE(carea.num_rings().first == 1);
+    REQUIRE(carea.num_rings().second == 1);
+
+    osmium::geom::WKTFactory<> factory;
+    REQUIRE(factory.create_multipolygon(carea) == factory.create_multipolygon(area));
+
+    REQUIRE(assembler2.stats().nodes == assembler1.stats().nodes);
+
+    // closed way
+    osmium::memory::Buffer way_area_buffer{10240};
+    REQUIRE(assembler2(*cways[2], way_area_buffer));
+    REQUIRE(way_area_buffer.get<osmium::Area>(0).num_rings().first == 1);
+}
+
+TEST_CASE("Members database with compressed way nodes") {
+    osmium::memory::Buffer buffer{10240};
+    add_multipolygon_ways(buffer);
+    const auto rpos = osmium::builder::add_relation(buffer,
+        _id(1),
+        _member(osmium::item_type::way, 10, "outer"),
+        _member(osmium::item_type::way, 11, "outer")
+    );
+
+    osmium::ItemStash stash;
+    osmium::relations::RelationsDatabase rdb{stash};
+    osmium::relations::MembersDatabase<osmium::Way> mdb{stash, rdb};
+    mdb.use_compressed_way_nodes();
+    REQUIRE(mdb.uses_lean_storage());
+    REQUIRE(mdb.uses_compressed_way_nodes());
+
+    const auto& relation = buffer.get<osmium::Relation>(rpos);
+    auto handle = rdb.add(relation);
+    mdb.track(handle, 10, 0);
+    mdb.track(handle, 11, 1);
+    mdb.prepare_for_lookup();
+
+    const auto& way = *buffer.select<osmium::Way>().cbegin();
+    mdb.add(way, [](osmium::relations::RelationHandle& /*rel_handle*/) {});
+
+    const auto* stored = mdb.get(10);
+    REQUIRE(stored);
+    REQUIRE(stored->tags().empty());
+    REQUIRE(stored->nodes().empty());
+    REQUIRE(stored->compressed_nodes());
+    REQUIRE(decode(*stored->compressed_nodes()).size() == 3);
+    REQUIRE(stored->compressed_nodes()->back().location() == (osmium::Location{4.0, 4.0}));
+}
+
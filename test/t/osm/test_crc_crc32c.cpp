@@ -0,0 +1,67 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/crc.hpp>
+#include <osmium/osm/crc_crc32c.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstring>
+#include <string>
+
+TEST_CASE("CRC32C of standard check value") {
+    osmium::CRC_crc32c crc;
+
+    const char* str = "123456789";
+    crc.process_bytes(str, std::strlen(str));
+
+    REQUIRE(crc.checksum() == 0xe3069283);
+}
+
+TEST_CASE("CRC32C byte-wise and in one go is the same") {
+    std::string data;
+    for (int i = 0; i < 1000; ++i) {
+        data += static_cast<char>(i * 7 + 3);
+    }
+
+    osmium::CRC_crc32c crc1;
+    crc1.process_bytes(data.data(), data.size());
+
+    osmium::CRC_crc32c crc2;
+    for (const char c : data) {
+        crc2.process_byte(static_cast<unsigned char>(c));
+    }
+
+    REQUIRE(crc1.checksum() == crc2.checksum());
+
+    // all lengths and alignments of the tail
+    for (std::size_t offset = 0; offset < 9; ++offset) {
+        for (std::size_t size = 0; size < 20; ++size) {
+            const auto* begin = reinterpret_cast<const unsigned char*>(data.data()) + offset;
+            REQUIRE(osmium::detail::crc32c_software(0xffffffffUL, begin, size) ==
+                    osmium::detail::crc32c_update(0xffffffffUL, begin, size));
+        }
+    }
+}
+
+TEST_CASE("CRC of node ref list is the same as for each node ref") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{10240};
+    const auto pos = osmium::builder::add_way(buffer, _id(1), _nodes({
+        osmium::NodeRef{1, osmium::Location{1.5, 2.5}},
+        osmium::NodeRef{-2, osmium::Location{}},
+        osmium::NodeRef{3, osmium::Location{-179.5, 89.9}}
+    }));
+    const auto& way = buffer.get<osmium::Way>(pos);
+
+    osmium::CRC<osmium::CRC_crc32c> crc1;
+    crc1.update(way.nodes());
+
+    osmium::CRC<osmium::CRC_crc32c> crc2;
+    for (const auto& node_ref : way.nodes()) {
+        crc2.update(node_ref);
+    }
+
+    REQUIRE(crc1().checksum() == crc2().checksum());
+}
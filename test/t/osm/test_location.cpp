@@ -331,6 +331,12 @@ TEST_CASE("Parsing coordinates from strings") {
     F("1e1234567");
     F("0.5e");
     F("1e10");
+    F("1e99999");
+    F("9.9e20");
+
+    C("0e99999",          0);
+    C("0.0e12",           0);
+    C("1.9e-99999",       0);
 
     C("1e2 ",   1000000000, " ");
     C("1.1e2 ", 1100000000, " ");
@@ -1,10 +1,14 @@
 #include "catch.hpp"
 
 #include <osmium/builder/attr.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/node_ref_list.hpp>
 
+#include <cstdint>
+#include <vector>
+
 TEST_CASE("Default construct a NodeRef") {
     const osmium::NodeRef node_ref;
     REQUIRE(node_ref.ref() == 0);
@@ -124,3 +128,88 @@ TEST_CASE("WayNodeList") {
 
 }
 
+
+TEST_CASE("Location checks on long WayNodeList") {
+    osmium::memory::Buffer buffer{10240};
+
+    std::vector<osmium::NodeRef> node_refs;
+    for (int i = 0; i < 150; ++i) {
+        osmium::Location location{(i % 40) * 0.5, (i % 30) * 0.5 - 5.0};
+        if (i % 17 == 3) {
+            location = osmium::Location{};
+        } else if (i % 23 == 5) {
+            location = osmium::Location{200.0, 1.0};
+        }
+        node_refs.emplace_back(i, location);
+    }
+
+    {
+        osmium::builder::WayNodeListBuilder builder{buffer};
+        for (const auto& node_ref : node_refs) {
+            builder.add_node_ref(node_ref);
+        }
+    }
+    buffer.commit();
+
+    const osmium::WayNodeList& nrl = buffer.get<osmium::WayNodeList>(0);
+    REQUIRE(nrl.size() == 150);
+    REQUIRE(nrl.mask_size() == 3);
+
+    const osmium::Box box{osmium::Location{2.0, -2.0}, osmium::Location{10.0, 3.0}};
+
+    std::vector<uint64_t> valid(nrl.mask_size());
+    std::vector<uint64_t> in_box(nrl.mask_size());
+    nrl.valid_locations_mask(valid.data());
+    nrl.locations_in_box_mask(box, in_box.data());
+
+    osmium::Box envelope;
+    for (std::size_t i = 0; i < node_refs.size(); ++i) {
+        const auto location = node_refs[i].location();
+        envelope.extend(location);
+        const bool is_valid = ((valid[i / 64] >> (i % 64)) & 1U) != 0;
+        const bool is_in_box = ((in_box[i / 64] >> (i % 64)) & 1U) != 0;
+        REQUIRE(is_valid == location.valid());
+        REQUIRE(is_in_box == (location.valid() && box.contains(location)));
+    }
+    REQUIRE((valid[2] >> 22U) == 0);
+    REQUIRE((in_box[2] >> 22U) == 0);
+
+    REQUIRE(nrl.envelope() == envelope);
+    REQUIRE_FALSE(nrl.all_locations_valid());
+    REQUIRE(nrl.any_location_in(box));
+    REQUIRE_FALSE(nrl.all_locations_in(box));
+    REQUIRE(nrl.all_locations_in(osmium::Box{osmium::Location{-180.0, -90.0}, osmium::Location{180.0, 90.0}}) == nrl.all_locations_valid());
+    REQUIRE_FALSE(nrl.any_location_in(osmium::Box{osmium::Location{-10.0, -10.0}, osmium::Location{-1.0, -1.0}}));
+}
+
+TEST_CASE("Location checks on WayNodeList with valid locations") {
+    osmium::memory::Buffer buffer{10240};
+    osmium::builder::add_way_node_list(buffer, osmium::builder::attr::_nodes({
+        {1, {0.0, 0.0}},
+        {2, {0.0, 1.0}},
+        {3, {1.0, 1.0}}
+    }));
+
+    const osmium::WayNodeList& nrl = buffer.get<osmium::WayNodeList>(0);
+    REQUIRE(nrl.all_locations_valid());
+    REQUIRE(nrl.all_locations_in(osmium::Box{osmium::Location{0.0, 0.0}, osmium::Location{1.0, 1.0}}));
+    REQUIRE_FALSE(nrl.all_locations_in(osmium::Box{osmium::Location{0.0, 0.0}, osmium::Location{1.0, 0.5}}));
+
+    uint64_t mask = 0;
+    nrl.valid_locations_mask(&mask);
+    REQUIRE(mask == 7U);
+}
+
+TEST_CASE("Location checks on empty WayNodeList") {
+    osmium::memory::Buffer buffer{10240};
+    {
+        osmium::builder::WayNodeListBuilder builder{buffer};
+    }
+    buffer.commit();
+
+    const osmium::WayNodeList& nrl = buffer.get<osmium::WayNodeList>(0);
+    REQUIRE(nrl.mask_size() == 0);
+    REQUIRE(nrl.all_locations_valid());
+    REQUIRE_FALSE(nrl.any_location_in(osmium::Box{osmium::Location{0.0, 0.0}, osmium::Location{1.0, 1.0}}));
+    REQUIRE_FALSE(nrl.envelope().valid());
+}
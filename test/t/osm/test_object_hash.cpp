@@ -0,0 +1,124 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object_hash.hpp>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Object hash of nodes") {
+    osmium::memory::Buffer buffer{10240};
+
+    const auto pos1 = osmium::builder::add_node(buffer, _id(1), _version(1), _timestamp("2015-01-01T00:00:00Z"), _user("foo"), _location(1.2, 3.4), _tag("amenity", "pub"), _tag("name", "Bar"));
+    const auto pos2 = osmium::builder::add_node(buffer, _id(2), _version(3), _timestamp("2016-01-01T00:00:00Z"), _user("bar"), _location(1.2, 3.4), _tag("amenity", "pub"), _tag("name", "Bar"));
+    const auto pos3 = osmium::builder::add_node(buffer, _id(1), _version(2), _location(1.2, 3.4), _tag("amenity", "pub"), _tag("name", "Baz"));
+    const auto pos4 = osmium::builder::add_node(buffer, _id(1), _version(2), _location(1.2, 3.5), _tag("amenity", "pub"), _tag("name", "Bar"));
+
+    const auto& node1 = buffer.get<osmium::Node>(pos1);
+    const auto& node2 = buffer.get<osmium::Node>(pos2);
+    const auto& node3 = buffer.get<osmium::Node>(pos3);
+    const auto& node4 = buffer.get<osmium::Node>(pos4);
+
+    SECTION("metadata and id are ignored by default") {
+        REQUIRE(osmium::object_hash(node1) == osmium::object_hash(node2));
+    }
+
+    SECTION("tags and location are used by default") {
+        REQUIRE(osmium::object_hash(node1) != osmium::object_hash(node3));
+        REQUIRE(osmium::object_hash(node1) != osmium::object_hash(node4));
+    }
+
+    SECTION("id can be used") {
+        REQUIRE(osmium::object_hash(node1, osmium::object_hash_fields::content | osmium::object_hash_fields::id) !=
+                osmium::object_hash(node2, osmium::object_hash_fields::content | osmium::object_hash_fields::id));
+    }
+
+    SECTION("only tags") {
+        REQUIRE(osmium::object_hash(node1, osmium::object_hash_fields::tags) == osmium::object_hash(node4, osmium::object_hash_fields::tags));
+        REQUIRE(osmium::object_hash(node1, osmium::object_hash_fields::tags) != osmium::object_hash(node3, osmium::object_hash_fields::tags));
+    }
+
+    SECTION("without tags") {
+        const auto fields = osmium::object_hash_fields::content & ~osmium::object_hash_fields::tags;
+        REQUIRE(osmium::object_hash(node1, fields) == osmium::object_hash(node3, fields));
+        REQUIRE(osmium::object_hash(node1, fields) != osmium::object_hash(node4, fields));
+    }
+
+    SECTION("seed changes the hash") {
+        REQUIRE(osmium::object_hash(node1, osmium::object_hash_fields::content, 1) != osmium::object_hash(node1));
+    }
+}
+
+TEST_CASE("Object hash of tags depends on where key and value end") {
+    osmium::memory::Buffer buffer{10240};
+
+    const auto pos1 = osmium::builder::add_node(buffer, _id(1), _tag("ab", "c"));
+    const auto pos2 = osmium::builder::add_node(buffer, _id(1), _tag("a", "bc"));
+    const auto pos3 = osmium::builder::add_node(buffer, _id(1));
+
+    const auto h1 = osmium::object_hash(buffer.get<osmium::Node>(pos1));
+    const auto h2 = osmium::object_hash(buffer.get<osmium::Node>(pos2));
+    const auto h3 = osmium::object_hash(buffer.get<osmium::Node>(pos3));
+    REQUIRE(h1 != h2);
+    REQUIRE(h1 != h3);
+    REQUIRE(h2 != h3);
+}
+
+TEST_CASE("Object hash of ways") {
+    osmium::memory::Buffer buffer{10240};
+
+    const auto pos1 = osmium::builder::add_way(buffer, _id(1), _version(1), _nodes({{1, {1.0, 1.0}}, {2, {2.0, 2.0}}}), _tag("highway", "primary"));
+    const auto pos2 = osmium::builder::add_way(buffer, _id(1), _version(2), _nodes({{1, {1.0, 1.0}}, {2, {2.0, 2.5}}}), _tag("highway", "primary"));
+    const auto pos3 = osmium::builder::add_way(buffer, _id(1), _version(3), _nodes({{1, {1.0, 1.0}}, {3, {2.0, 2.0}}}), _tag("highway", "primary"));
+    const auto pos4 = osmium::builder::add_way(buffer, _id(1), _version(1), _nodes({1, 2}), _tag("highway", "primary"));
+
+    const auto& way1 = buffer.get<osmium::Way>(pos1);
+    const auto& way2 = buffer.get<osmium::Way>(pos2);
+    const auto& way3 = buffer.get<osmium::Way>(pos3);
+    const auto& way4 = buffer.get<osmium::Way>(pos4);
+
+    SECTION("node locations are ignored by default") {
+        REQUIRE(osmium::object_hash(way1) == osmium::object_hash(way2));
+        REQUIRE(osmium::object_hash(way1) == osmium::object_hash(way4));
+        REQUIRE(osmium::object_hash(way1) != osmium::object_hash(way3));
+    }
+
+    SECTION("node locations can be used") {
+        const auto fields = osmium::object_hash_fields::content | osmium::object_hash_fields::node_locations;
+        REQUIRE(osmium::object_hash(way1, fields) != osmium::object_hash(way2, fields));
+        REQUIRE(osmium::object_hash(way1, fields) != osmium::object_hash(way3, fields));
+    }
+
+    SECTION("hashing all node refs in one go is the same as one by one") {
+        osmium::Hash64 hash;
+        hash.update_int64(way1.nodes().size());
+        for (const auto& node_ref : way1.nodes()) {
+            hash.update_int64(static_cast<uint64_t>(node_ref.ref()));
+            hash.update_int32(static_cast<uint32_t>(node_ref.x()));
+            hash.update_int32(static_cast<uint32_t>(node_ref.y()));
+        }
+        osmium::Hash64 bulk;
+        osmium::detail::hash_node_refs(bulk, way1.nodes(), osmium::object_hash_fields::node_refs | osmium::object_hash_fields::node_locations);
+        REQUIRE(hash.digest() == bulk.digest());
+    }
+
+    SECTION("node and way with same tags differ") {
+        const auto pos = osmium::builder::add_node(buffer, _id(1), _tag("highway", "primary"));
+        REQUIRE(osmium::object_hash(buffer.get<osmium::Node>(pos), osmium::object_hash_fields::tags) !=
+                osmium::object_hash(way1, osmium::object_hash_fields::tags));
+    }
+}
+
+TEST_CASE("Object hash of relations") {
+    osmium::memory::Buffer buffer{10240};
+
+    const auto pos1 = osmium::builder::add_relation(buffer, _id(1), _member(osmium::item_type::way, 10, "outer"), _member(osmium::item_type::way, 11, "inner"));
+    const auto pos2 = osmium::builder::add_relation(buffer, _id(1), _member(osmium::item_type::way, 10, "outer"), _member(osmium::item_type::way, 11, "outer"));
+    const auto pos3 = osmium::builder::add_relation(buffer, _id(1), _member(osmium::item_type::node, 10, "outer"), _member(osmium::item_type::way, 11, "inner"));
+    const auto pos4 = osmium::builder::add_relation(buffer, _id(2), _version(7), _member(osmium::item_type::way, 10, "outer"), _member(osmium::item_type::way, 11, "inner"));
+
+    const auto h1 = osmium::object_hash(buffer.get<osmium::Relation>(pos1));
+    REQUIRE(h1 != osmium::object_hash(buffer.get<osmium::Relation>(pos2)));
+    REQUIRE(h1 != osmium::object_hash(buffer.get<osmium::Relation>(pos3)));
+    REQUIRE(h1 == osmium::object_hash(buffer.get<osmium::Relation>(pos4)));
+}
@@ -2,6 +2,8 @@
 
 #include <osmium/osm/timestamp.hpp>
 
+#include <cstdio>
+#include <ctime>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -151,3 +153,32 @@ TEST_CASE("Invalid timestamps") {
     REQUIRE_THROWS_AS(osmium::Timestamp{"2000-03-32T00:00:00Z"}, std::invalid_argument);
 }
 
+
+TEST_CASE("Timestamp parsing gives same result as timegm") {
+    const int max_days[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    for (int year : {1900, 1969, 1970, 1999, 2000, 2004, 2023, 2038, 2100, 2105}) {
+        for (int month = 1; month <= 12; ++month) {
+            for (int day : {1, 15, 28, 29, 30, 31}) {
+                char str[21];
+                std::snprintf(str, sizeof(str), "%04d-%02d-%02dT23:59:60Z", year, month, day);
+                if (day > max_days[month - 1]) {
+                    REQUIRE_THROWS_AS(osmium::detail::parse_timestamp(str), std::invalid_argument);
+                    continue;
+                }
+
+                std::tm tm{};
+                tm.tm_year = year - 1900;
+                tm.tm_mon = month - 1;
+                tm.tm_mday = day;
+                tm.tm_hour = 23;
+                tm.tm_min = 59;
+                tm.tm_sec = 60;
+#ifndef _WIN32
+                REQUIRE(osmium::detail::parse_timestamp(str) == timegm(&tm));
+#else
+                REQUIRE(osmium::detail::parse_timestamp(str) == _mkgmtime(&tm));
+#endif
+            }
+        }
+    }
+}
@@ -105,3 +105,35 @@ TEST_CASE("build way with helpers") {
     REQUIRE(envelope.top_right().lat() == Approx(4.7));
 }
 
+
+TEST_CASE("way with bounding box") {
+    osmium::memory::Buffer buffer{10000};
+
+    {
+        osmium::builder::WayBuilder builder{buffer};
+        builder.add_node_refs({
+            {22, {3.5, 4.7}},
+            {67, {4.1, 2.2}}
+        });
+        builder.add_item(osmium::BoundingBox{osmium::Box{1.0, 2.0, 3.0, 4.0}});
+    }
+    buffer.commit();
+
+    osmium::builder::add_way(buffer,
+        _nodes({{1, {1.5, 2.5}}, {2, {0.5, 3.5}}})
+    );
+
+    auto it = buffer.select<osmium::Way>().begin();
+    const osmium::Way& way = *it;
+    REQUIRE(way.nodes().size() == 2);
+    REQUIRE(way.bounding_box());
+    REQUIRE(way.bounding_box()->box() == osmium::Box(1.0, 2.0, 3.0, 4.0));
+
+    // The cached bounding box is used even if it does not fit the nodes.
+    REQUIRE(way.envelope() == osmium::Box(1.0, 2.0, 3.0, 4.0));
+
+    ++it;
+    const osmium::Way& way_without_bbox = *it;
+    REQUIRE_FALSE(way_without_bbox.bounding_box());
+    REQUIRE(way_without_bbox.envelope() == osmium::Box(0.5, 2.5, 1.5, 3.5));
+}
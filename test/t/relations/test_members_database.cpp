@@ -6,6 +6,8 @@
 #include <osmium/relations/relations_database.hpp>
 #include <osmium/storage/item_stash.hpp>
 
+#include <string>
+
 osmium::memory::Buffer fill_buffer() {
     using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
     osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
@@ -56,7 +58,16 @@ TEST_CASE("Fill member database") {
         }
     }
 
+    SECTION("without member ids filter") {
+    }
+
+    SECTION("with member ids filter") {
+        mdb.use_member_ids_filter();
+    }
+
     mdb.prepare_for_lookup();
+    REQUIRE(mdb.get(15) == nullptr);
+    REQUIRE(mdb.get(1000000000) == nullptr);
 
     int n = 0;
     int match = 0;
@@ -97,6 +108,44 @@ TEST_CASE("Fill member database") {
     REQUIRE(mdb.used_memory() > 100);
 }
 
+TEST_CASE("Member database with lean storage") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+    osmium::memory::Buffer buffer{1024UL, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_relation(buffer, _id(20), _member(osmium::item_type::way, 10, "outer"));
+    osmium::builder::add_way(buffer, _id(10), _version(3), _user("someone"), _tag("highway", "primary"),
+                             _nodes({{1, {1.0, 2.0}}, {2, {3.0, 4.0}}}));
+
+    osmium::ItemStash stash;
+    osmium::relations::RelationsDatabase rdb{stash};
+    osmium::relations::MembersDatabase<osmium::Way> mdb{stash, rdb};
+    REQUIRE_FALSE(mdb.uses_lean_storage());
+    mdb.use_lean_storage();
+    REQUIRE(mdb.uses_lean_storage());
+
+    auto handle = rdb.add(buffer.get<osmium::Relation>(0));
+    mdb.track(handle, 10, 0);
+    mdb.prepare_for_lookup();
+
+    const auto& way = *buffer.select<osmium::Way>().begin();
+    int count = 0;
+    REQUIRE(mdb.add(way, [&](osmium::relations::RelationHandle& /*rel_handle*/) {
+        ++count;
+    }));
+    REQUIRE(count == 1);
+
+    const auto* stored = mdb.get(10);
+    REQUIRE(stored);
+    REQUIRE(stored->id() == 10);
+    REQUIRE(stored->version() == 3);
+    REQUIRE(stored->tags().empty());
+    REQUIRE(std::string{stored->user()}.empty());
+    REQUIRE(stored->nodes().size() == 2);
+    REQUIRE(stored->nodes()[1].ref() == 2);
+    REQUIRE(stored->nodes()[1].location() == osmium::Location(3.0, 4.0));
+    REQUIRE(stored->byte_size() < way.byte_size());
+}
+
 TEST_CASE("Member database with duplicate member in relation") {
     using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
     osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
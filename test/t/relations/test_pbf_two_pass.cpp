@@ -0,0 +1,147 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/relations/pbf_two_pass.hpp>
+#include <osmium/relations/relations_manager.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+    // Nodes 1 to 30000 (in several blobs), ways 1 to 100 with two nodes
+    // each, and two relations. Only the route relation is used in the
+    // tests below.
+    void write_test_file(const std::string& filename) {
+        using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= 30000; ++id) {
+            osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0));
+        }
+        for (osmium::object_id_type id = 1; id <= 100; ++id) {
+            osmium::builder::add_way(buffer, _id(id), _version(1), _nodes({id, id + 1}));
+        }
+        osmium::builder::add_relation(buffer, _id(1), _version(1),
+            _tag("type", "route"),
+            _member(osmium::item_type::node, 5),
+            _member(osmium::item_type::way, 3),
+            _member(osmium::item_type::node, 29000));
+        osmium::builder::add_relation(buffer, _id(2), _version(1),
+            _tag("type", "multipolygon"),
+            _member(osmium::item_type::node, 10000));
+
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    struct RouteRM : public osmium::relations::RelationsManager<RouteRM, true, true, false> {
+
+        std::vector<osmium::object_id_type> members;
+
+        static bool new_relation(const osmium::Relation& relation) noexcept {
+            return std::strcmp(relation.tags().get_value_by_key("type", ""), "route") == 0;
+        }
+
+        void complete_relation(const osmium::Relation& relation) {
+            for (const auto& member : relation.members()) {
+                if (member.ref() != 0) {
+                    members.push_back(member.ref());
+                    REQUIRE(get_member_object(member));
+                }
+            }
+        }
+
+    };
+
+    struct RouteWithAllNodesRM : public osmium::relations::RelationsManager<RouteWithAllNodesRM, true, true, false> {
+
+        std::size_t nodes = 0;
+
+        static bool new_relation(const osmium::Relation& relation) noexcept {
+            return std::strcmp(relation.tags().get_value_by_key("type", ""), "route") == 0;
+        }
+
+        void after_node(const osmium::Node& /*node*/) noexcept {
+            ++nodes;
+        }
+
+    };
+
+} // anonymous namespace
+
+TEST_CASE("Second pass only reads blobs with members") {
+    const std::string filename{"test-pbf-two-pass.osm.pbf"};
+    write_test_file(filename);
+
+    osmium::io::IndexedPBFReader reader{filename, "-"};
+    REQUIRE(reader.num_data_blobs() > 5);
+
+    RouteRM manager;
+    osmium::relations::read_relations(reader, manager);
+    REQUIRE(manager.relations_database().size() == 1);
+
+    REQUIRE(manager.second_pass_needs(osmium::item_type::node, 1, 10));
+    REQUIRE_FALSE(manager.second_pass_needs(osmium::item_type::node, 6, 28999));
+    REQUIRE(manager.second_pass_needs(osmium::item_type::way, 3, 3));
+    REQUIRE_FALSE(manager.second_pass_needs(osmium::item_type::way, 4, 100));
+    REQUIRE_FALSE(manager.second_pass_needs(osmium::item_type::relation, 1, 2));
+
+    // Blob with node 5, blob with node 29000, blob with the ways.
+    const auto blobs = osmium::relations::find_member_blobs(reader, manager);
+    REQUIRE(blobs.size() == 3);
+    REQUIRE(blobs.front() == 0);
+
+    osmium::thread::Pool pool{2};
+    osmium::relations::read_members(pool, reader, manager);
+    REQUIRE(manager.members == std::vector<osmium::object_id_type>({5, 3, 29000}));
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Second pass reads all blobs with nodes if manager wants all nodes") {
+    const std::string filename{"test-pbf-two-pass.osm.pbf"};
+    write_test_file(filename);
+
+    osmium::io::IndexedPBFReader reader{filename, "-"};
+
+    RouteWithAllNodesRM manager;
+    osmium::relations::read_relations(reader, manager);
+
+    REQUIRE(manager.second_pass_needs(osmium::item_type::node, 6, 28999));
+    REQUIRE_FALSE(manager.second_pass_needs(osmium::item_type::way, 4, 100));
+
+    const auto blobs = osmium::relations::find_member_blobs(reader, manager);
+    REQUIRE(blobs.size() == reader.num_data_blobs() - 1); // not the relations blob
+
+    osmium::relations::read_members(reader, manager);
+    REQUIRE(manager.nodes == 30000);
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("First pass with relations prefiltered in decoder threads") {
+    const std::string filename{"test-pbf-two-pass.osm.pbf"};
+    write_test_file(filename);
+
+    RouteRM manager;
+    osmium::relations::read_relations_prefiltered(osmium::io::File{filename}, manager);
+    REQUIRE(manager.relations_database().size() == 1);
+    REQUIRE(manager.member_nodes_database().size() == 2);
+    REQUIRE(manager.member_ways_database().size() == 1);
+
+    osmium::io::Reader reader{filename};
+    osmium::apply(reader, manager.handler());
+    reader.close();
+    REQUIRE(manager.members == std::vector<osmium::object_id_type>({5, 3, 29000}));
+
+    std::remove(filename.c_str());
+}
@@ -2,11 +2,17 @@
 
 #include "utils.hpp"
 
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/check_order.hpp>
+#include <osmium/io/header.hpp>
 #include <osmium/io/xml_input.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/relations/relations_manager.hpp>
 
+#include <cstddef>
+#include <cstring>
 #include <iterator>
+#include <vector>
 
 struct EmptyRM : public osmium::relations::RelationsManager<EmptyRM, true, true, true> {
 };
@@ -98,6 +104,13 @@ struct CallbackRM : public osmium::relations::RelationsManager<CallbackRM, true,
 
 };
 
+// Only ways in relations with type=multipolygon.
+struct MultipolygonRM : public osmium::relations::RelationsManager<MultipolygonRM, false, true, false> {
+    static bool new_relation(const osmium::Relation& relation) noexcept {
+        return std::strcmp(relation.tags().get_value_by_key("type", ""), "multipolygon") == 0;
+    }
+};
+
 struct AnyRM : public osmium::relations::RelationsManager<AnyRM, true, true, true> {
     static bool new_relation(const osmium::Relation& /*relation*/) noexcept {
         return true;
@@ -175,6 +188,42 @@ TEST_CASE("Relations manager derived class") {
     REQUIRE(n == 1);
 }
 
+TEST_CASE("Relations manager with segmented stash") {
+    const osmium::io::File file{with_data_dir("t/relations/data.osm")};
+
+    TestRM manager;
+    manager.stash().use_segments(1024, 2048, ".");
+
+    osmium::relations::read_relations(file, manager);
+
+    osmium::io::Reader reader{file};
+    osmium::apply(reader, manager.handler());
+    reader.close();
+
+    REQUIRE(manager.count_new_rels      ==  3);
+    REQUIRE(manager.count_new_members   ==  5);
+    REQUIRE(manager.count_complete_rels ==  2);
+}
+
+TEST_CASE("Relations manager with memory budget") {
+    const osmium::io::File file{with_data_dir("t/relations/data.osm")};
+
+    TestRM manager;
+    manager.use_memory_budget(256, ".", 128);
+
+    osmium::relations::read_relations(file, manager);
+
+    osmium::io::Reader reader{file};
+    osmium::apply(reader, manager.handler());
+    reader.close();
+
+    REQUIRE(manager.count_complete_rels == 2);
+
+    const auto mu = manager.used_memory();
+    REQUIRE(mu.stash_peak >= 256);
+    REQUIRE(mu.stash_disk > 0);
+}
+
 TEST_CASE("Relations manager with callback") {
     const osmium::io::File file{with_data_dir("t/relations/data.osm")};
 
@@ -197,6 +246,83 @@ TEST_CASE("Relations manager with callback") {
     REQUIRE(callback_called);
 }
 
+TEST_CASE("Relations manager with callback in async mode") {
+    const osmium::io::File file{with_data_dir("t/relations/data.osm")};
+
+    CallbackRM manager;
+    manager.enable_async_output();
+
+    osmium::relations::read_relations(file, manager);
+
+    std::ptrdiff_t objects = 0;
+    osmium::io::Reader reader{file};
+    osmium::apply(reader, manager.handler([&](osmium::memory::Buffer&& buffer) {
+        objects += std::distance(buffer.begin(), buffer.end());
+    }));
+    reader.close();
+
+    // The handler flushes the output at the end and waits for the callback.
+    REQUIRE(manager.count_nodes == 2);
+    REQUIRE(objects == 2);
+}
+
+TEST_CASE("Relations manager with relations prefiltered in reader") {
+    const osmium::io::File file{with_data_dir("t/relations/data.osm")};
+
+    CallbackRM manager;
+
+    osmium::relations::read_relations_prefiltered(file, manager);
+
+    REQUIRE(manager.relations_database().size()        == 3);
+    REQUIRE(manager.member_nodes_database().size()     == 2);
+    REQUIRE(manager.member_ways_database().size()      == 0);
+    REQUIRE(manager.member_relations_database().size() == 0);
+
+    std::ptrdiff_t objects = 0;
+    osmium::io::Reader reader{file};
+    osmium::apply(reader, manager.handler([&](osmium::memory::Buffer&& buffer) {
+        objects += std::distance(buffer.begin(), buffer.end());
+    }));
+    reader.close();
+    REQUIRE(manager.count_nodes == 2);
+    REQUIRE(objects == 2);
+}
+
+TEST_CASE("Prefiltering relations removes unwanted relations and members") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_relation(buffer, _id(1), _tag("type", "multipolygon"),
+        _member(osmium::item_type::way, 10),
+        _member(osmium::item_type::node, 11));
+    osmium::builder::add_relation(buffer, _id(2), _tag("type", "route"),
+        _member(osmium::item_type::way, 20));
+    osmium::builder::add_relation(buffer, _id(3), _tag("type", "multipolygon"),
+        _member(osmium::item_type::relation, 30),
+        _member(osmium::item_type::way, 31));
+
+    MultipolygonRM manager;
+    manager.prefilter_relations(buffer);
+
+    std::vector<osmium::object_id_type> ids;
+    std::vector<osmium::object_id_type> refs;
+    for (const auto& relation : buffer.select<osmium::Relation>()) {
+        ids.push_back(relation.id());
+        for (const auto& member : relation.members()) {
+            refs.push_back(member.ref());
+        }
+        manager.add_prefiltered_relation(relation);
+    }
+    REQUIRE(ids == std::vector<osmium::object_id_type>({1, 3}));
+    REQUIRE(refs == std::vector<osmium::object_id_type>({10, 0, 0, 31}));
+
+    manager.prepare_for_lookup();
+    REQUIRE(manager.relations_database().size() == 2);
+    REQUIRE(manager.member_ways_database().size() == 2);
+    REQUIRE(manager.member_nodes_database().size() == 0);
+    REQUIRE(manager.member_relations_database().size() == 0);
+}
+
 TEST_CASE("Relations manager reading buffer without callback") {
     const osmium::io::File file{with_data_dir("t/relations/data.osm")};
 
@@ -320,3 +446,49 @@ TEST_CASE("Check handling of missing members") {
     REQUIRE(missing_relations == 2);
 }
 
+
+TEST_CASE("Relations manager checks order unless input is known to be sorted") {
+    const osmium::io::File file{with_data_dir("t/relations/data.osm")};
+
+    AnyRM manager;
+    osmium::relations::read_relations(file, manager);
+
+    osmium::io::Reader reader{file};
+    auto buffer = reader.read();
+    reader.close();
+
+    // Reorder so that a node comes after a way.
+    osmium::memory::Buffer unsorted{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        unsorted.add_item(way);
+        unsorted.commit();
+    }
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        unsorted.add_item(node);
+        unsorted.commit();
+    }
+
+    SECTION("check order") {
+        REQUIRE_THROWS_AS(osmium::apply(unsorted, manager.handler()), osmium::out_of_order_error);
+    }
+
+    SECTION("input assumed to be sorted") {
+        manager.assume_sorted_input();
+        osmium::apply(unsorted, manager.handler());
+    }
+
+    SECTION("header without verified sorting") {
+        osmium::io::Header header;
+        header.set_sorted_by_type_then_id(true);
+        manager.assume_sorted_input(header);
+        REQUIRE_THROWS_AS(osmium::apply(unsorted, manager.handler()), osmium::out_of_order_error);
+    }
+
+    SECTION("header with verified sorting") {
+        osmium::io::Header header;
+        header.set_sorted_by_type_then_id(true);
+        header.set_sorting_verified(true);
+        manager.assume_sorted_input(header);
+        osmium::apply(unsorted, manager.handler());
+    }
+}
@@ -0,0 +1,181 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/storage/columnar_batch.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("String pool") {
+    osmium::StringPool pool;
+    REQUIRE(pool.size() == 0);
+
+    const auto a = pool.add("foo");
+    const auto b = pool.add("bar");
+    const auto c = pool.add("foo");
+    const auto d = pool.add("");
+    REQUIRE(a == c);
+    REQUIRE(a != b);
+    REQUIRE(pool.size() == 3);
+    REQUIRE(std::string{pool.get(a)} == "foo");
+    REQUIRE(std::string{pool.get(b)} == "bar");
+    REQUIRE(std::string{pool.get(d)}.empty());
+
+    REQUIRE(pool.add("foobar", 3) == a);
+
+    pool.clear();
+    REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("String pool with many strings") {
+    osmium::StringPool pool;
+    for (int i = 0; i < 10000; ++i) {
+        REQUIRE(pool.add(std::to_string(i).c_str()) == static_cast<osmium::StringPool::id_type>(i));
+    }
+    REQUIRE(pool.size() == 10000);
+    for (int i = 0; i < 10000; ++i) {
+        REQUIRE(pool.add(std::to_string(i).c_str()) == static_cast<osmium::StringPool::id_type>(i));
+        REQUIRE(std::string{pool.get(static_cast<osmium::StringPool::id_type>(i))} == std::to_string(i));
+    }
+    REQUIRE(pool.size() == 10000);
+}
+
+TEST_CASE("Empty columnar node batch") {
+    const osmium::ColumnarNodeBatch batch;
+    REQUIRE(batch.empty());
+    REQUIRE(batch.size() == 0);
+    REQUIRE(batch.tag_offsets().size() == 1);
+}
+
+TEST_CASE("Columnar node batch from buffer") {
+    osmium::memory::Buffer buffer{1024};
+    osmium::builder::add_node(buffer, _id(1), _location(1.5, 2.5), _tag("amenity", "pub"), _tag("name", "The Pub"));
+    osmium::builder::add_node(buffer, _id(2), _location(3.5, 4.5));
+    osmium::builder::add_way(buffer, _id(3), _tag("highway", "primary"));
+    osmium::builder::add_node(buffer, _id(4), _tag("amenity", "cafe"));
+
+    osmium::ColumnarNodeBatch batch;
+    batch.add_buffer(buffer);
+
+    REQUIRE(batch.size() == 3);
+    REQUIRE(batch.ids().size() == 3);
+    REQUIRE(batch.xs().size() == 3);
+    REQUIRE(batch.ys().size() == 3);
+
+    REQUIRE(batch.id(0) == 1);
+    REQUIRE(batch.location(0) == osmium::Location(1.5, 2.5));
+    REQUIRE(batch.tag_count(0) == 2);
+    REQUIRE(std::string{batch.tag_key(0, 0)} == "amenity");
+    REQUIRE(std::string{batch.tag_value(0, 0)} == "pub");
+    REQUIRE(std::string{batch.tag_key(0, 1)} == "name");
+    REQUIRE(std::string{batch.tag_value(0, 1)} == "The Pub");
+
+    REQUIRE(batch.id(1) == 2);
+    REQUIRE(batch.location(1) == osmium::Location(3.5, 4.5));
+    REQUIRE(batch.tag_count(1) == 0);
+    REQUIRE(batch.get_value_by_key(1, "amenity") == nullptr);
+
+    REQUIRE(batch.id(2) == 4);
+    REQUIRE_FALSE(batch.location(2).valid());
+    REQUIRE(std::string{batch.get_value_by_key(2, "amenity")} == "cafe");
+    REQUIRE(batch.get_value_by_key(2, "name") == nullptr);
+
+    REQUIRE(batch.tag_offsets().size() == 4);
+    REQUIRE(batch.tag_offsets()[0] == 0);
+    REQUIRE(batch.tag_offsets()[1] == 2);
+    REQUIRE(batch.tag_offsets()[2] == 2);
+    REQUIRE(batch.tag_offsets()[3] == 3);
+
+    // "amenity" is stored only once
+    REQUIRE(batch.tag_keys()[0] == batch.tag_keys()[2]);
+    REQUIRE(batch.strings().size() == 5);
+
+    REQUIRE(batch.used_memory() > 0);
+
+    batch.clear();
+    REQUIRE(batch.empty());
+    REQUIRE(batch.tag_offsets().size() == 1);
+    REQUIRE(batch.tag_keys().empty());
+}
+
+TEST_CASE("Columnar node batch with tags filter") {
+    osmium::memory::Buffer buffer{1024};
+    osmium::builder::add_node(buffer, _id(1), _tag("amenity", "pub"), _tag("name", "The Pub"));
+    osmium::builder::add_node(buffer, _id(2), _tag("name", "Somewhere"));
+
+    osmium::TagsFilter filter{false};
+    filter.add_rule(true, "amenity");
+
+    osmium::ColumnarNodeBatch batch;
+    batch.add_buffer(buffer, filter);
+
+    REQUIRE(batch.size() == 2);
+    REQUIRE(batch.tag_count(0) == 1);
+    REQUIRE(std::string{batch.tag_key(0, 0)} == "amenity");
+    REQUIRE(batch.tag_count(1) == 0);
+}
+
+TEST_CASE("Fill columnar node batch directly") {
+    osmium::ColumnarNodeBatch batch;
+    batch.reserve(2, 1);
+    batch.add_node(17, osmium::Location{1, 2});
+    batch.add_tag("highway", "crossing");
+    batch.add_node(18, osmium::Location{3, 4});
+
+    REQUIRE(batch.size() == 2);
+    REQUIRE(batch.xs()[0] == 1);
+    REQUIRE(batch.ys()[1] == 4);
+    REQUIRE(batch.tag_count(0) == 1);
+    REQUIRE(batch.tag_count(1) == 0);
+    REQUIRE(std::string{batch.tag_value(0, 0)} == "crossing");
+}
+
+TEST_CASE("Columnar way batch from buffer") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _location(1.0, 2.0));
+    osmium::builder::add_way(buffer, _id(10), _nodes({1, 2, 3}), _tag("highway", "primary"), _tag("name", "Main Street"));
+    osmium::builder::add_way(buffer, _id(11), _nodes({3, 4}));
+    osmium::builder::add_way(buffer, _id(12), _tag("highway", "residential"));
+
+    osmium::ColumnarWayBatch batch;
+    batch.add_buffer(buffer);
+
+    REQUIRE(batch.size() == 3);
+    REQUIRE(batch.id(0) == 10);
+    REQUIRE(batch.id(2) == 12);
+
+    REQUIRE(batch.ref_count(0) == 3);
+    REQUIRE(batch.ref(0, 2) == 3);
+    REQUIRE(batch.ref_count(1) == 2);
+    REQUIRE(batch.ref(1, 0) == 3);
+    REQUIRE(batch.ref_count(2) == 0);
+    REQUIRE(batch.refs().size() == 5);
+
+    REQUIRE(batch.tag_count(0) == 2);
+    REQUIRE(batch.tag_count(1) == 0);
+    REQUIRE(std::string{batch.get_value_by_key(0, "name")} == "Main Street");
+    REQUIRE(std::string{batch.get_value_by_key(2, "highway")} == "residential");
+    REQUIRE(batch.get_value_by_key(1, "highway") == nullptr);
+
+    batch.clear();
+    REQUIRE(batch.empty());
+}
+
+TEST_CASE("Columnar block") {
+    osmium::ColumnarBlock block;
+    REQUIRE(block.empty());
+
+    block.nodes.add_node(1, osmium::Location{1, 2});
+    REQUIRE_FALSE(block.empty());
+
+    block.clear();
+    block.ways.add_way(1);
+    block.ways.add_ref(5);
+    REQUIRE_FALSE(block.empty());
+    REQUIRE(block.ways.ref_count(0) == 1);
+
+    block.clear();
+    REQUIRE(block.empty());
+}
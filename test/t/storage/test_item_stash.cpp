@@ -166,3 +166,90 @@ TEST_CASE("Fill item stash until it garbage collects") {
     REQUIRE(stash.count_removed() == 0);
 }
 
+
+TEST_CASE("Item stash with segments") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::ItemStash stash;
+    stash.use_segments(64UL * 1024UL);
+
+    std::vector<osmium::ItemStash::handle_type> handles;
+    for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_way(buffer, _id(id), _nodes({id, id + 1, id + 2}), _tag("id", std::to_string(id)));
+        handles.push_back(stash.add_item(buffer.get<osmium::memory::Item>(0)));
+
+        // remove three out of four items added a while ago
+        const auto old = id - 1000;
+        if (old > 0 && old % 4 != 0) {
+            stash.remove_item(handles[old - 1]);
+            handles[old - 1] = osmium::ItemStash::handle_type{};
+        }
+    }
+
+    REQUIRE(stash.size() == 20000 - 19000 / 4 * 3);
+
+    // some segments have been compacted already
+    REQUIRE(stash.count_removed() < 19000 / 4 * 3);
+
+    const auto check = [&]() {
+        for (std::size_t i = 0; i < handles.size(); ++i) {
+            if (handles[i].valid()) {
+                const auto& way = stash.get<osmium::Way>(handles[i]);
+                REQUIRE(way.id() == static_cast<osmium::object_id_type>(i + 1));
+                REQUIRE(way.nodes().size() == 3);
+                REQUIRE(way.tags().get_value_by_key("id") == std::to_string(i + 1));
+            }
+        }
+    };
+    check();
+
+    stash.garbage_collect();
+    REQUIRE(stash.size() == 20000 - 19000 / 4 * 3);
+    REQUIRE(stash.count_removed() == 0);
+    check();
+
+    stash.clear();
+    REQUIRE(stash.size() == 0);
+}
+
+TEST_CASE("Item stash with segments spilled to disk") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::ItemStash stash;
+    stash.use_segments(64UL * 1024UL, 256UL * 1024UL, ".");
+    REQUIRE(stash.used_disk_space() == 0);
+
+    std::vector<osmium::ItemStash::handle_type> handles;
+    for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_way(buffer, _id(id), _nodes({id, id + 1}), _tag("id", std::to_string(id)));
+        handles.push_back(stash.add_item(buffer.get<osmium::memory::Item>(0)));
+    }
+
+    REQUIRE(stash.size() == 20000);
+    REQUIRE(stash.used_disk_space() > 0);
+    REQUIRE(stash.used_memory() < 2UL * 1024UL * 1024UL);
+    REQUIRE(stash.peak_memory() >= 256UL * 1024UL);
+    REQUIRE(stash.peak_memory() <= 256UL * 1024UL + 64UL * 1024UL);
+
+    for (std::size_t i = 0; i < handles.size(); i += 2) {
+        stash.remove_item(handles[i]);
+        handles[i] = osmium::ItemStash::handle_type{};
+    }
+    stash.garbage_collect();
+    REQUIRE(stash.size() == 10000);
+    REQUIRE(stash.count_removed() == 0);
+
+    for (std::size_t i = 0; i < handles.size(); ++i) {
+        if (handles[i].valid()) {
+            const auto& way = stash.get<osmium::Way>(handles[i]);
+            REQUIRE(way.id() == static_cast<osmium::object_id_type>(i + 1));
+            REQUIRE(way.tags().get_value_by_key("id") == std::to_string(i + 1));
+        }
+    }
+
+    stash.clear();
+    REQUIRE(stash.size() == 0);
+    REQUIRE(stash.used_disk_space() == 0);
+}
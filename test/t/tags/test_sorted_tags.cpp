@@ -0,0 +1,163 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/tags/matcher.hpp>
+#include <osmium/tags/sorted_tags.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::vector<std::pair<std::string, std::string>> to_vector(const osmium::TagList& tags) {
+    std::vector<std::pair<std::string, std::string>> result;
+    for (const auto& tag : tags) {
+        result.emplace_back(tag.key(), tag.value());
+    }
+    return result;
+}
+
+static const osmium::TagList& unsorted_tags(osmium::memory::Buffer& buffer) {
+    const auto pos = osmium::builder::add_tag_list(buffer,
+        _tag("name", "Main Street"),
+        _tag("highway", "primary"),
+        _tag("oneway", "yes"),
+        _tag("addr:street", "x"),
+        _tag("highway", "secondary"),
+        _tag("lanes", "2")
+    );
+    return buffer.get<osmium::TagList>(pos);
+}
+
+TEST_CASE("Sort tag list by key") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    auto& tags = const_cast<osmium::TagList&>(unsorted_tags(buffer)); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+    const auto size = tags.byte_size();
+
+    REQUIRE_FALSE(tags.sorted_by_key());
+    REQUIRE(std::string{tags["highway"]} == "primary");
+
+    tags.sort_by_key();
+    REQUIRE(tags.sorted_by_key());
+    REQUIRE(tags.byte_size() == size);
+
+    const std::vector<std::pair<std::string, std::string>> expected = {
+        {"addr:street", "x"},
+        {"highway", "primary"},
+        {"highway", "secondary"},
+        {"lanes", "2"},
+        {"name", "Main Street"},
+        {"oneway", "yes"}
+    };
+    REQUIRE(to_vector(tags) == expected);
+
+    REQUIRE(std::string{tags["addr:street"]} == "x");
+    REQUIRE(std::string{tags["highway"]} == "primary");
+    REQUIRE(std::string{tags["oneway"]} == "yes");
+    REQUIRE(tags["aaa"] == nullptr);
+    REQUIRE(tags["maxspeed"] == nullptr);
+    REQUIRE(tags["zzz"] == nullptr);
+    REQUIRE(tags.has_key("lanes"));
+    REQUIRE_FALSE(tags.has_key("lane"));
+    REQUIRE(tags.has_tag("highway", "primary"));
+    REQUIRE_FALSE(tags.has_tag("highway", "secondary"));
+
+    // Sorting again doesn't change anything.
+    tags.sort_by_key();
+    REQUIRE(to_vector(tags) == expected);
+}
+
+TEST_CASE("Sorted flag is kept when the tag list is copied") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    {
+        osmium::builder::TagListBuilder builder{buffer};
+        builder.add_tag("b", "2");
+        builder.add_tag("a", "1");
+        builder.sort_by_key();
+    }
+    buffer.commit();
+
+    const auto& tags = buffer.get<osmium::TagList>(0);
+    REQUIRE(tags.sorted_by_key());
+    REQUIRE(std::string{tags.begin()->key()} == "a");
+
+    osmium::memory::Buffer buffer2{1024};
+    buffer2.add_item(tags);
+    buffer2.commit();
+    REQUIRE(buffer2.get<osmium::TagList>(0).sorted_by_key());
+}
+
+TEST_CASE("Sort tags of all objects in buffer") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _tag("b", "1"), _tag("a", "2"));
+    osmium::builder::add_way(buffer, _id(1), _tag("y", "1"), _tag("x", "2"));
+    osmium::builder::add_changeset(buffer, _cid(1), _tag("comment", "foo"), _tag("attribution", "bar"));
+
+    osmium::tags::sort_by_key(buffer);
+
+    auto it = buffer.begin<osmium::OSMObject>();
+    REQUIRE(it->tags().sorted_by_key());
+    REQUIRE(std::string{it->tags().begin()->key()} == "a");
+    ++it;
+    REQUIRE(it->tags().sorted_by_key());
+    REQUIRE(std::string{it->tags().begin()->key()} == "x");
+
+    const auto& changeset = *buffer.begin<osmium::Changeset>();
+    REQUIRE(changeset.tags().sorted_by_key());
+    REQUIRE(std::string{changeset.tags().begin()->key()} == "attribution");
+}
+
+TEST_CASE("Look up tags in SortedTags") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto& tags = unsorted_tags(buffer);
+
+    osmium::tags::SortedTags sorted{tags};
+    REQUIRE(sorted.size() == 6);
+    REQUIRE_FALSE(sorted.empty());
+    REQUIRE(std::string{sorted[0].key()} == "addr:street");
+    REQUIRE(std::string{sorted[5].key()} == "oneway");
+
+    for (const auto& tag : tags) {
+        REQUIRE(std::string{sorted.get_value_by_key(tag.key())} == tags.get_value_by_key(tag.key()));
+        REQUIRE(sorted.has_key(tag.key()));
+    }
+    REQUIRE(sorted.get_value_by_key("foo") == nullptr);
+    REQUIRE(std::string{sorted.get_value_by_key("foo", "default")} == "default");
+    REQUIRE_FALSE(sorted.has_key("aaa"));
+    REQUIRE_FALSE(sorted.has_key("zzz"));
+    REQUIRE(sorted.has_tag("highway", "primary"));
+    REQUIRE_FALSE(sorted.has_tag("highway", "secondary"));
+    REQUIRE_FALSE(sorted.has_tag("name", "x"));
+
+    {
+        osmium::builder::TagListBuilder builder{buffer};
+    }
+    sorted.reset(buffer.get<osmium::TagList>(buffer.commit()));
+    REQUIRE(sorted.empty());
+    REQUIRE_FALSE(sorted.has_key("highway"));
+}
+
+TEST_CASE("Tag matcher on sorted tag list") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    auto& tags = const_cast<osmium::TagList&>(unsorted_tags(buffer)); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+
+    const osmium::TagMatcher highway{"highway"};
+    const osmium::TagMatcher secondary{"highway", "secondary"};
+    const osmium::TagMatcher name_or_oneway{osmium::StringMatcher::list{{"oneway", "name"}}, "yes"};
+    const osmium::TagMatcher no_street{"highway", "street", true};
+    const osmium::TagMatcher missing{"maxspeed"};
+    const osmium::TagMatcher prefix{osmium::StringMatcher::prefix{"addr:"}};
+
+    for (int i = 0; i < 2; ++i) {
+        REQUIRE(highway(tags));
+        REQUIRE(secondary(tags));
+        REQUIRE(name_or_oneway(tags));
+        REQUIRE(no_street(tags));
+        REQUIRE_FALSE(missing(tags));
+        REQUIRE(prefix(tags));
+        tags.sort_by_key();
+    }
+}
@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/tags/tag_statistics.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    class BufferSource {
+
+        std::vector<osmium::memory::Buffer> m_buffers;
+        std::size_t m_next = 0;
+
+    public:
+
+        explicit BufferSource(int num_buffers) {
+            osmium::object_id_type id = 1;
+            for (int b = 0; b < num_buffers; ++b) {
+                osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+                for (int n = 0; n < 100; ++n, ++id) {
+                    const std::string name = "name" + std::to_string(id);
+                    osmium::builder::add_node(buffer, _id(id), _tag("amenity", n % 10 == 0 ? "cafe" : "bench"), _tag("name", name));
+                }
+                osmium::builder::add_way(buffer, _id(b + 1), _tag("highway", "primary"), _tag("name", "main street"));
+                m_buffers.push_back(std::move(buffer));
+            }
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_next == m_buffers.size()) {
+                return osmium::memory::Buffer{};
+            }
+            return std::move(m_buffers[m_next++]);
+        }
+
+    }; // class BufferSource
+
+} // anonymous namespace
+
+TEST_CASE("Tag statistics of some objects") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _tag("amenity", "cafe"), _tag("name", "Rosa"));
+    osmium::builder::add_node(buffer, _id(2), _tag("amenity", "cafe"));
+    osmium::builder::add_node(buffer, _id(3));
+    osmium::builder::add_way(buffer, _id(1), _tag("amenity", "parking"));
+    osmium::builder::add_relation(buffer, _id(1), _tag("type", "multipolygon"), _tag("amenity", "parking"));
+
+    osmium::tags::TagStatistics stats;
+    osmium::apply(buffer, stats);
+
+    REQUIRE(stats.num_objects(osmium::item_type::node) == 3);
+    REQUIRE(stats.num_objects(osmium::item_type::way) == 1);
+    REQUIRE(stats.num_objects(osmium::item_type::relation) == 1);
+    REQUIRE(stats.num_tags() == 6);
+    REQUIRE(stats.num_keys() == 3);
+    REQUIRE(stats.get("highway") == nullptr);
+
+    const auto* amenity = stats.get("amenity");
+    REQUIRE(amenity);
+    REQUIRE(amenity->count() == 4);
+    REQUIRE(amenity->count(osmium::item_type::node) == 2);
+    REQUIRE(amenity->count(osmium::item_type::way) == 1);
+    REQUIRE(amenity->count(osmium::item_type::relation) == 1);
+    REQUIRE(amenity->distinct_values() == 2);
+    REQUIRE(amenity->distinct_values_exact());
+
+    const auto top = amenity->top_values(1);
+    REQUIRE(top.size() == 1);
+    REQUIRE(top[0].item == "cafe");
+    REQUIRE(top[0].count == 2);
+
+    std::size_t keys = 0;
+    stats.for_each_key([&keys](const std::string& /*key*/, const osmium::tags::key_statistics& key_stats) {
+        REQUIRE(key_stats.count() > 0);
+        ++keys;
+    });
+    REQUIRE(keys == 3);
+}
+
+TEST_CASE("Tag statistics collected in thread pool") {
+    osmium::thread::Pool pool{3};
+    BufferSource source{20};
+
+    osmium::tags::tag_statistics_options options;
+    options.top_counters = 8;
+    const auto stats = osmium::tags::collect_tag_statistics(source, options, pool);
+
+    REQUIRE(stats.num_objects(osmium::item_type::node) == 2000);
+    REQUIRE(stats.num_objects(osmium::item_type::way) == 20);
+    REQUIRE(stats.num_keys() == 3);
+
+    const auto* name = stats.get("name");
+    REQUIRE(name);
+    REQUIRE(name->count() == 2020);
+    REQUIRE(name->count(osmium::item_type::way) == 20);
+    REQUIRE(name->distinct_values() == Approx(2001).epsilon(0.05));
+    REQUIRE(name->top_values(1)[0].item == "main street");
+
+    const auto* amenity = stats.get("amenity");
+    REQUIRE(amenity);
+    REQUIRE(amenity->distinct_values() == 2);
+    const auto top = amenity->top_values(5);
+    REQUIRE(top.size() == 2);
+    REQUIRE(top[0].item == "bench");
+    REQUIRE(top[0].count == 1800);
+    REQUIRE(top[1].item == "cafe");
+    REQUIRE(top[1].count == 200);
+}
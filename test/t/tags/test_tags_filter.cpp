@@ -1,12 +1,15 @@
 #include "catch.hpp"
 
 #include <osmium/builder/attr.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/tags/tags_filter.hpp>
 
 #include <functional>
 #include <iterator>
+#include <random>
 #include <string>
+#include <vector>
 
 TEST_CASE("Tags filter") {
     osmium::memory::Buffer buffer{10240};
@@ -172,3 +175,106 @@ TEST_CASE("TagsFilterBase") {
 
 }
 
+
+TEST_CASE("Compiled tags filter keeps rule order") {
+    osmium::memory::Buffer buffer{10240};
+
+    const auto pos = osmium::builder::add_tag_list(buffer,
+        osmium::builder::attr::_tags({
+            { "highway", "primary" },
+            { "highway", "motorway" },
+            { "name", "Main Street" },
+            { "name:de", "Hauptstrasse" },
+            { "source", "GPS" }
+    }));
+    const osmium::TagList& tags = buffer.get<osmium::TagList>(pos);
+
+    osmium::TagsFilterBase<int> filter{-1};
+    filter.add_rule(1, "highway", "motorway");
+    filter.add_rule(2, osmium::StringMatcher::prefix{"name:"});
+    filter.add_rule(3, "highway");
+    filter.add_rule(4, "name");
+    filter.add_rule(5, osmium::StringMatcher::prefix{"high"});
+    REQUIRE_FALSE(filter.compiled());
+
+    std::vector<int> expected;
+    for (const auto& tag : tags) {
+        expected.push_back(filter(tag));
+    }
+    REQUIRE(expected == std::vector<int>({3, 1, 4, 2, -1}));
+
+    filter.compile();
+    REQUIRE(filter.compiled());
+    std::vector<int> results;
+    for (const auto& tag : tags) {
+        results.push_back(filter(tag));
+    }
+    REQUIRE(results == expected);
+
+    filter.add_rule(6, "source");
+    REQUIRE_FALSE(filter.compiled());
+    REQUIRE(filter(*std::next(tags.begin(), 4)) == 6);
+}
+
+TEST_CASE("Compiled tags filter gives same results as uncompiled filter") {
+    const std::vector<std::string> strings = {"a", "b", "c", "ab", "abc", "bc", "name", "highway", ""};
+
+    std::mt19937 gen{23}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    std::uniform_int_distribution<std::size_t> pick_string{0, strings.size() - 1};
+    std::uniform_int_distribution<int> pick_kind{0, 6};
+
+    const auto make_matcher = [&]() -> osmium::StringMatcher {
+        const auto& str = strings[pick_string(gen)];
+        switch (pick_kind(gen)) {
+            case 0:
+                return osmium::StringMatcher::always_true{};
+            case 1:
+                return osmium::StringMatcher::always_false{};
+            case 2:
+                return osmium::StringMatcher::prefix{str};
+            case 3:
+                return osmium::StringMatcher::substring{str};
+            case 4:
+                return osmium::StringMatcher::list{{str, strings[pick_string(gen)]}};
+            default:
+                break;
+        }
+        return osmium::StringMatcher::equal{str};
+    };
+
+    for (int n = 0; n < 100; ++n) {
+        osmium::TagsFilterBase<int> filter{-1};
+        const int num_rules = n % 20;
+        for (int r = 0; r < num_rules; ++r) {
+            if (gen() % 3 == 0) {
+                filter.add_rule(r, osmium::TagMatcher{make_matcher()});
+            } else {
+                filter.add_rule(r, osmium::TagMatcher{make_matcher(), make_matcher(), gen() % 4 == 0});
+            }
+        }
+
+        osmium::memory::Buffer buffer{10240};
+        {
+            osmium::builder::TagListBuilder builder{buffer};
+            for (const auto& key : strings) {
+                for (const auto& value : strings) {
+                    builder.add_tag(key, value);
+                }
+            }
+        }
+        buffer.commit();
+        const osmium::TagList& tags = buffer.get<osmium::TagList>(0);
+
+        std::vector<int> expected;
+        for (const auto& tag : tags) {
+            expected.push_back(filter(tag));
+        }
+
+        filter.compile();
+        std::vector<int> results;
+        for (const auto& tag : tags) {
+            results.push_back(filter(tag));
+        }
+        REQUIRE(results == expected);
+    }
+}
@@ -0,0 +1,95 @@
+#include "catch.hpp"
+
+#include <osmium/thread/completion_ring.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Completion ring returns results in submission order") {
+    osmium::thread::Pool pool{4};
+    osmium::thread::CompletionRing<int> ring{8};
+    REQUIRE(ring.capacity() == 8);
+    REQUIRE(ring.empty());
+
+    std::vector<int> results;
+    int next = 0;
+    while (results.size() < 100) {
+        while (next < 100 && !ring.full()) {
+            const int n = next++;
+            ring.submit(pool, [n]() {
+                // later tasks finish first
+                std::this_thread::sleep_for(std::chrono::microseconds{(8 - n % 8) * 50});
+                return n;
+            });
+        }
+        results.push_back(ring.pop());
+    }
+
+    REQUIRE(ring.empty());
+    for (int n = 0; n < 100; ++n) {
+        REQUIRE(results[static_cast<std::size_t>(n)] == n);
+    }
+}
+
+TEST_CASE("Completion ring passes on exceptions") {
+    osmium::thread::Pool pool{2};
+    osmium::thread::CompletionRing<std::string> ring{4};
+
+    ring.submit(pool, []() {
+        return std::string{"a"};
+    });
+    ring.submit(pool, []() -> std::string {
+        throw std::runtime_error{"failed"};
+    });
+    ring.submit(pool, []() {
+        return std::string{"c"};
+    });
+    REQUIRE(ring.size() == 3);
+
+    REQUIRE(ring.pop() == "a");
+    REQUIRE_THROWS_AS(ring.pop(), std::runtime_error);
+    REQUIRE(ring.pop() == "c");
+}
+
+TEST_CASE("Completion ring with batch of wrapped tasks") {
+    osmium::thread::Pool pool{3};
+    osmium::thread::CompletionRing<int> ring{10};
+
+    std::vector<osmium::thread::function_wrapper> tasks;
+    for (int n = 0; n < 10; ++n) {
+        tasks.push_back(ring.wrap([n]() {
+            return n * n;
+        }));
+    }
+    REQUIRE(ring.full());
+    pool.post_batch(tasks);
+
+    ring.discard();
+    for (int n = 1; n < 10; ++n) {
+        REQUIRE(ring.pop() == n * n);
+    }
+}
+
+TEST_CASE("Completion ring waits for outstanding tasks") {
+    osmium::thread::Pool pool{2};
+    std::atomic<int> count{0};
+
+    {
+        osmium::thread::CompletionRing<int> ring{4};
+        for (int n = 0; n < 4; ++n) {
+            ring.submit(pool, [&count]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds{5});
+                return ++count;
+            });
+        }
+        ring.discard();
+    }
+
+    // The destructor of the ring waited for the other tasks.
+    REQUIRE(count == 4);
+}
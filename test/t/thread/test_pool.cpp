@@ -1,8 +1,15 @@
 #include "catch.hpp"
 
+#include <osmium/thread/function_wrapper.hpp>
 #include <osmium/thread/pool.hpp>
 
+#include <array>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <vector>
 
 struct test_job_with_result {
     int operator()() const {
@@ -10,6 +17,15 @@ struct test_job_with_result {
     }
 };
 
+struct test_job_move_only {
+    std::unique_ptr<int> ptr;
+    int* out;
+
+    void operator()() const {
+        *out = *ptr;
+    }
+};
+
 struct test_job_throw {
     [[noreturn]] void operator()() const {
         throw std::runtime_error{"exception in pool thread"};
@@ -104,3 +120,151 @@ TEST_CASE("can throw from job in user provided thread pool") {
     REQUIRE_THROWS_AS(future.get(), std::runtime_error);
 }
 
+
+TEST_CASE("tasks with high priority run before tasks with normal priority") {
+    osmium::thread::Pool pool{1};
+
+    std::promise<void> go;
+    std::shared_future<void> go_future{go.get_future()};
+    std::mutex mutex;
+    std::vector<int> order;
+
+    auto blocker = pool.submit([go_future] { go_future.wait(); });
+
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 3; ++i) {
+        futures.push_back(pool.submit([&mutex, &order, i] {
+            const std::lock_guard<std::mutex> lock{mutex};
+            order.push_back(i);
+        }));
+    }
+    for (int i = 10; i < 13; ++i) {
+        futures.push_back(pool.submit([&mutex, &order, i] {
+            const std::lock_guard<std::mutex> lock{mutex};
+            order.push_back(i);
+        }, osmium::thread::task_priority::high));
+    }
+
+    go.set_value();
+    blocker.get();
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    const std::vector<int> expected = {10, 11, 12, 0, 1, 2};
+    REQUIRE(order == expected);
+}
+
+TEST_CASE("tasks can submit tasks to the same pool") {
+    osmium::thread::Pool pool{2, 2};
+
+    auto future = pool.submit([&pool] {
+        // more tasks than the queue size, this must not block
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i < 20; ++i) {
+            futures.push_back(pool.submit(test_job_with_result{}));
+        }
+        int sum = 0;
+        for (auto& f : futures) {
+            sum += f.get();
+        }
+        return sum;
+    });
+
+    REQUIRE(future.get() == 20 * 42);
+    REQUIRE(pool.queue_empty());
+}
+
+TEST_CASE("Thread pool keeps statistics") {
+    osmium::thread::Pool pool{2};
+
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 5; ++i) {
+        futures.push_back(pool.submit(test_job_with_result{}));
+    }
+    for (auto& future : futures) {
+        REQUIRE(future.get() == 42);
+    }
+
+    const auto stats = pool.stats();
+    REQUIRE(stats.num_threads == 2);
+    // the counter is updated just after the result is available
+    REQUIRE(stats.tasks_done <= 5);
+}
+
+TEST_CASE("function wrapper stores small functions inline and large ones on the heap") {
+    int small_count = 0;
+    osmium::thread::function_wrapper small{[&small_count] { ++small_count; }};
+
+    std::array<char, 200> data{};
+    data[0] = 1;
+    int large_count = 0;
+    osmium::thread::function_wrapper large{[data, &large_count] { large_count += data[0]; }};
+
+    // moving must keep both kinds working
+    osmium::thread::function_wrapper small_moved{std::move(small)};
+    osmium::thread::function_wrapper large_moved;
+    large_moved = std::move(large);
+    REQUIRE_FALSE(small);
+    REQUIRE_FALSE(large);
+
+    REQUIRE_FALSE(small_moved());
+    REQUIRE_FALSE(large_moved());
+    REQUIRE(small_count == 1);
+    REQUIRE(large_count == 1);
+
+    // move-only functor
+    int value = 0;
+    osmium::thread::function_wrapper move_only{test_job_move_only{std::unique_ptr<int>{new int{5}}, &value}};
+    osmium::thread::function_wrapper move_only_moved{std::move(move_only)};
+    move_only_moved();
+    REQUIRE(value == 5);
+
+    osmium::thread::function_wrapper shutdown{0};
+    REQUIRE(shutdown());
+}
+
+TEST_CASE("can post tasks without future") {
+    osmium::thread::Pool pool{3};
+
+    std::atomic<int> sum{0};
+    std::promise<void> done;
+    auto done_future = done.get_future();
+
+    for (int i = 1; i <= 100; ++i) {
+        pool.post([&sum, &done, i] {
+            if ((sum += i) == 5050) {
+                done.set_value();
+            }
+        });
+    }
+
+    done_future.wait();
+    REQUIRE(sum == 5050);
+}
+
+TEST_CASE("can post a batch of tasks") {
+    osmium::thread::Pool pool{3, 2};
+
+    std::atomic<int> count{0};
+    std::promise<void> done;
+    auto done_future = done.get_future();
+
+    std::vector<osmium::thread::function_wrapper> tasks;
+    for (int i = 0; i < 50; ++i) {
+        tasks.emplace_back([&count, &done] {
+            if (++count == 50) {
+                done.set_value();
+            }
+        });
+    }
+
+    pool.post_batch(tasks, osmium::thread::task_priority::high);
+    REQUIRE(tasks.empty());
+
+    done_future.wait();
+    REQUIRE(count == 50);
+
+    pool.post_batch(tasks);
+    REQUIRE(pool.queue_empty());
+}
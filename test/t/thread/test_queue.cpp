@@ -45,3 +45,23 @@ TEST_CASE("When queue is shut down, nothing goes in or out") {
     queue.wait_and_pop(value);
     REQUIRE(value.empty());
 }
+
+TEST_CASE("Queue keeps statistics") {
+    osmium::thread::Queue<int> queue{10, "test"};
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(queue.try_pop(value));
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.name == "test");
+    REQUIRE(stats.max_size == 10);
+    REQUIRE(stats.size == 1);
+    REQUIRE(stats.largest_size == 3);
+    REQUIRE(stats.pushes == 3);
+    REQUIRE(stats.pops == 2);
+    REQUIRE(stats.full_waits == 0);
+    REQUIRE(stats.empty_waits == 0);
+}
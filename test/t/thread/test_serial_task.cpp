@@ -0,0 +1,64 @@
+#include "catch.hpp"
+
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/serial_task.hpp>
+
+#include <atomic>
+
+TEST_CASE("SerialTask runs step function until it returns false") {
+    osmium::thread::Pool pool{2};
+    int count = 0;
+
+    osmium::thread::SerialTask task{pool, [&count]() {
+        return ++count < 10;
+    }};
+
+    task.schedule();
+    task.wait_until_idle();
+    REQUIRE(count == 10);
+
+    task.schedule();
+    task.wait_until_idle();
+    REQUIRE(count == 11);
+}
+
+TEST_CASE("SerialTask never runs step function concurrently") {
+    osmium::thread::Pool pool{4};
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+    std::atomic<int> runs{0};
+
+    osmium::thread::SerialTask task{pool, [&]() {
+        const int r = ++running;
+        if (r > max_running) {
+            max_running = r;
+        }
+        ++runs;
+        --running;
+        return false;
+    }};
+
+    for (int i = 0; i < 1000; ++i) {
+        task.schedule();
+    }
+    task.wait_until_idle();
+
+    REQUIRE(max_running == 1);
+    REQUIRE(runs >= 1);
+    REQUIRE(runs <= 1000);
+}
+
+TEST_CASE("SerialTask doesn't run after stop") {
+    osmium::thread::Pool pool{1};
+    int count = 0;
+
+    osmium::thread::SerialTask task{pool, [&count]() {
+        ++count;
+        return false;
+    }};
+
+    task.stop();
+    task.schedule();
+    task.wait_until_idle();
+    REQUIRE(count == 0);
+}
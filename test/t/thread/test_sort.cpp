@@ -0,0 +1,144 @@
+#include "catch.hpp"
+
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    std::vector<std::pair<int, std::size_t>> make_data(std::size_t size) {
+        std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+        std::uniform_int_distribution<int> dist{0, 1000};
+
+        std::vector<std::pair<int, std::size_t>> data;
+        data.reserve(size);
+        for (std::size_t n = 0; n < size; ++n) {
+            data.emplace_back(dist(gen), n);
+        }
+        return data;
+    }
+
+    bool compare_first(const std::pair<int, std::size_t>& a, const std::pair<int, std::size_t>& b) noexcept {
+        return a.first < b.first;
+    }
+
+    void check_parallel_sort(int num_threads) {
+        osmium::thread::Pool pool{num_threads};
+
+        auto data = make_data(100 * 1000);
+        auto expected = data;
+
+        std::stable_sort(expected.begin(), expected.end(), compare_first);
+        osmium::thread::stable_sort(data.begin(), data.end(), compare_first, pool);
+
+        REQUIRE(data == expected);
+    }
+
+    void check_parallel_unstable_sort(int num_threads) {
+        osmium::thread::Pool pool{num_threads};
+
+        auto data = make_data(100 * 1000);
+        auto expected = data;
+
+        std::sort(expected.begin(), expected.end());
+        osmium::thread::sort(data.begin(), data.end(), pool);
+
+        REQUIRE(data == expected);
+    }
+
+    class NoDefault {
+
+        int m_value;
+
+    public:
+
+        explicit NoDefault(int value) noexcept :
+            m_value(value) {
+        }
+
+        int value() const noexcept {
+            return m_value;
+        }
+
+    }; // class NoDefault
+
+} // anonymous namespace
+
+TEST_CASE("Parallel stable sort of empty range") {
+    osmium::thread::Pool pool{2};
+    std::vector<int> data;
+    osmium::thread::stable_sort(data.begin(), data.end(), std::less<int>{}, pool);
+    REQUIRE(data.empty());
+}
+
+TEST_CASE("Parallel stable sort of small range sorts in calling thread") {
+    osmium::thread::Pool pool{2};
+    std::vector<int> data = {5, 3, 9, 1, 7};
+    osmium::thread::stable_sort(data.begin(), data.end(), std::less<int>{}, pool);
+    REQUIRE(data == std::vector<int>({1, 3, 5, 7, 9}));
+}
+
+TEST_CASE("Parallel stable sort gives same result as std::stable_sort") {
+    SECTION("two threads") {
+        check_parallel_sort(2);
+    }
+    SECTION("three threads (odd number of chunks)") {
+        check_parallel_sort(3);
+    }
+    SECTION("five threads") {
+        check_parallel_sort(5);
+    }
+}
+
+TEST_CASE("Parallel sort of empty range") {
+    osmium::thread::Pool pool{2};
+    std::vector<int> data;
+    osmium::thread::sort(data.begin(), data.end(), pool);
+    REQUIRE(data.empty());
+}
+
+TEST_CASE("Parallel sort of small range sorts in calling thread") {
+    osmium::thread::Pool pool{2};
+    std::vector<int> data = {5, 3, 9, 1, 7};
+    osmium::thread::sort(data.begin(), data.end(), pool);
+    REQUIRE(data == std::vector<int>({1, 3, 5, 7, 9}));
+}
+
+TEST_CASE("Parallel sort gives same result as std::sort") {
+    SECTION("two threads") {
+        check_parallel_unstable_sort(2);
+    }
+    SECTION("three threads (odd number of chunks)") {
+        check_parallel_unstable_sort(3);
+    }
+    SECTION("five threads") {
+        check_parallel_unstable_sort(5);
+    }
+}
+
+TEST_CASE("Parallel sort works with types that are not default-constructible") {
+    osmium::thread::Pool pool{3};
+
+    std::vector<NoDefault> data;
+    for (int n = 100 * 1000; n > 0; --n) {
+        data.emplace_back(n);
+    }
+
+    const auto compare = [](const NoDefault& a, const NoDefault& b) noexcept {
+        return a.value() < b.value();
+    };
+
+    osmium::thread::sort(data.begin(), data.end(), compare, pool);
+    REQUIRE(std::is_sorted(data.begin(), data.end(), compare));
+
+    osmium::thread::stable_sort(data.begin(), data.end(), compare, pool);
+    REQUIRE(std::is_sorted(data.begin(), data.end(), compare));
+    REQUIRE(data.front().value() == 1);
+    REQUIRE(data.back().value() == 100 * 1000);
+}
@@ -0,0 +1,151 @@
+#include "catch.hpp"
+
+#include <osmium/thread/spsc_queue.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+TEST_CASE("Basic use of single producer, single consumer queue") {
+    osmium::thread::SPSCQueue<int> queue;
+    REQUIRE(queue.empty());
+    queue.push(22);
+    REQUIRE_FALSE(queue.empty());
+    REQUIRE(queue.size() == 1);
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 22);
+    REQUIRE(queue.empty());
+    REQUIRE_FALSE(queue.try_pop(value));
+}
+
+TEST_CASE("SPSC queue wraps around") {
+    osmium::thread::SPSCQueue<int> queue{3, "Queue of max size 3"};
+    int value = 0;
+    for (int i = 0; i < 10; ++i) {
+        queue.push(i);
+        queue.push(i + 100);
+        REQUIRE(queue.size() == 2);
+        REQUIRE(queue.try_pop(value));
+        REQUIRE(value == i);
+        queue.wait_and_pop(value);
+        REQUIRE(value == i + 100);
+    }
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("When SPSC queue is shut down, nothing goes in or out") {
+    osmium::thread::SPSCQueue<std::string> queue;
+    REQUIRE(queue.in_use());
+    queue.push("foo");
+    queue.push("bar");
+    queue.push("baz");
+    REQUIRE(queue.size() == 3);
+
+    std::string value;
+
+    queue.wait_and_pop(value);
+    REQUIRE(value == "foo");
+    REQUIRE(queue.size() == 2);
+    queue.shutdown();
+    REQUIRE_FALSE(queue.in_use());
+    REQUIRE(queue.empty());
+    queue.push("lost");
+    REQUIRE(queue.empty());
+
+    value.clear();
+    queue.try_pop(value);
+    REQUIRE(value.empty());
+    queue.wait_and_pop(value);
+    REQUIRE(value.empty());
+}
+
+TEST_CASE("SPSC queue with producer and consumer threads") {
+    osmium::thread::SPSCQueue<int> queue{4};
+    const int count = 100000;
+
+    std::thread producer{[&queue] {
+        for (int i = 1; i <= count; ++i) {
+            queue.push(i);
+        }
+    }};
+
+    long long sum = 0;
+    bool in_order = true;
+    for (int i = 1; i <= count; ++i) {
+        int value = 0;
+        queue.wait_and_pop(value);
+        in_order = in_order && value == i;
+        sum += value;
+    }
+    producer.join();
+
+    REQUIRE(in_order);
+    REQUIRE(sum == static_cast<long long>(count) * (count + 1) / 2);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Shutting down SPSC queue wakes up blocked producer") {
+    osmium::thread::SPSCQueue<int> queue{2};
+    queue.push(1);
+    queue.push(2);
+
+    std::thread producer{[&queue] {
+        queue.push(3);
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.shutdown();
+    producer.join();
+
+    REQUIRE_FALSE(queue.in_use());
+}
+
+TEST_CASE("Single producer, single consumer queue keeps statistics") {
+    osmium::thread::SPSCQueue<int> queue{2, "test"};
+
+    std::thread producer{[&queue]() {
+        for (int i = 0; i < 10; ++i) {
+            queue.push(i);
+        }
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    for (int i = 0; i < 10; ++i) {
+        int value = -1;
+        queue.wait_and_pop(value);
+        REQUIRE(value == i);
+    }
+    producer.join();
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.name == "test");
+    REQUIRE(stats.max_size == 2);
+    REQUIRE(stats.size == 0);
+    REQUIRE(stats.largest_size == 2);
+    REQUIRE(stats.pushes == 10);
+    REQUIRE(stats.pops == 10);
+    REQUIRE(stats.full_waits > 0);
+    REQUIRE(stats.full_wait_time.count() > 0);
+}
+
+TEST_CASE("SPSC queue estimates bytes in flight from popped sizes") {
+    osmium::thread::SPSCQueue<int> queue{10, "test"};
+    REQUIRE(queue.stats().estimated_bytes() == 0);
+
+    for (int i = 0; i < 4; ++i) {
+        queue.push(i);
+    }
+    REQUIRE(queue.stats().estimated_bytes() == 0);
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    queue.add_popped_bytes(100);
+    queue.wait_and_pop(value);
+    queue.add_popped_bytes(300);
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.popped_bytes == 400);
+    REQUIRE(stats.size == 2);
+    REQUIRE(stats.estimated_bytes() == 400);
+}
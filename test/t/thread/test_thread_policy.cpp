@@ -0,0 +1,146 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/thread_policy.hpp>
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+# include <sched.h>
+# include <sys/resource.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+
+namespace {
+
+    std::vector<int> current_cpus() {
+        std::vector<int> cpus;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+        return cpus;
+    }
+
+} // anonymous namespace
+#endif
+
+using osmium::thread::thread_policy;
+using osmium::thread::thread_role;
+
+TEST_CASE("Default thread policy is empty") {
+    const thread_policy policy;
+    REQUIRE(policy.empty());
+    REQUIRE(policy.settings(thread_role::worker).empty());
+    REQUIRE(policy.apply(thread_role::consumer));
+}
+
+TEST_CASE("Set thread policy") {
+    thread_policy policy;
+    policy.set_cpus(thread_role::read, {0, 1}).set_nice(thread_role::worker, 5);
+
+    REQUIRE_FALSE(policy.empty());
+    REQUIRE(policy.settings(thread_role::read).cpus == (std::vector<int>{0, 1}));
+    REQUIRE_FALSE(policy.settings(thread_role::read).set_nice);
+    REQUIRE(policy.settings(thread_role::worker).cpus.empty());
+    REQUIRE(policy.settings(thread_role::worker).set_nice);
+    REQUIRE(policy.settings(thread_role::worker).nice == 5);
+    REQUIRE(policy.settings(thread_role::write).empty());
+}
+
+TEST_CASE("Thread policy from string") {
+    const auto policy = thread_policy::from_string("io:0-1;worker:2-4,7:5;consumer:8;;parse::-2");
+
+    REQUIRE(policy.settings(thread_role::read).cpus == (std::vector<int>{0, 1}));
+    REQUIRE(policy.settings(thread_role::write).cpus == (std::vector<int>{0, 1}));
+    REQUIRE_FALSE(policy.settings(thread_role::write).set_nice);
+    REQUIRE(policy.settings(thread_role::worker).cpus == (std::vector<int>{2, 3, 4, 7}));
+    REQUIRE(policy.settings(thread_role::worker).nice == 5);
+    REQUIRE(policy.settings(thread_role::consumer).cpus == (std::vector<int>{8}));
+    REQUIRE(policy.settings(thread_role::parse).cpus.empty());
+    REQUIRE(policy.settings(thread_role::parse).set_nice);
+    REQUIRE(policy.settings(thread_role::parse).nice == -2);
+
+    REQUIRE(thread_policy::from_string("").empty());
+}
+
+TEST_CASE("Invalid thread policy strings") {
+    REQUIRE_THROWS_AS(thread_policy::from_string("foo:1"), std::invalid_argument);
+    REQUIRE_THROWS_AS(thread_policy::from_string("worker"), std::invalid_argument);
+    REQUIRE_THROWS_AS(thread_policy::from_string("worker:a"), std::invalid_argument);
+    REQUIRE_THROWS_AS(thread_policy::from_string("worker:1:"), std::invalid_argument);
+    REQUIRE_THROWS_AS(thread_policy::from_string("worker:1:x"), std::invalid_argument);
+    REQUIRE_THROWS_AS(thread_policy::from_string("worker:1:20"), std::invalid_argument);
+}
+
+#ifdef __linux__
+
+TEST_CASE("Apply thread policy to current thread") {
+    const auto cpus = current_cpus();
+    REQUIRE_FALSE(cpus.empty());
+
+    std::vector<int> pinned_cpus;
+    int nice = 0;
+    bool okay = false;
+
+    // Use a separate thread, so this one is not changed.
+    std::thread thread{[&]() {
+        const auto tid = static_cast<id_t>(::syscall(SYS_gettid));
+        thread_policy policy;
+        policy.set_cpus(thread_role::consumer, {cpus.back()});
+        policy.set_nice(thread_role::consumer, ::getpriority(PRIO_PROCESS, tid) + 1);
+        okay = policy.apply(thread_role::consumer);
+        pinned_cpus = current_cpus();
+        nice = ::getpriority(PRIO_PROCESS, tid) - ::getpriority(PRIO_PROCESS, static_cast<id_t>(::getpid()));
+    }};
+    thread.join();
+
+    REQUIRE(okay);
+    REQUIRE(pinned_cpus == (std::vector<int>{cpus.back()}));
+    REQUIRE(nice == 1);
+    REQUIRE(current_cpus() == cpus);
+}
+
+TEST_CASE("Pool applies thread policy to workers") {
+    const auto cpus = current_cpus();
+    REQUIRE_FALSE(cpus.empty());
+
+    thread_policy policy;
+    policy.set_cpus(thread_role::worker, {cpus.front()});
+
+    osmium::thread::Pool pool{2, 0, policy};
+    auto future = pool.submit([]() {
+        return current_cpus();
+    });
+    REQUIRE(future.get() == (std::vector<int>{cpus.front()}));
+}
+
+#endif
+
+TEST_CASE("Reader and Writer accept thread policy") {
+    thread_policy policy;
+    policy.set_nice(thread_role::read, 1).set_nice(thread_role::parse, 1).set_nice(thread_role::write, 1);
+
+    osmium::io::Reader reader{with_data_dir("t/io/data.osm"), policy};
+    osmium::io::Writer writer{"test-thread-policy.osm", osmium::io::overwrite::allow, policy};
+    while (auto buffer = reader.read()) {
+        writer(std::move(buffer));
+    }
+    writer.close();
+    reader.close();
+
+    osmium::io::Reader check{"test-thread-policy.osm"};
+    REQUIRE(check.read());
+    check.close();
+}
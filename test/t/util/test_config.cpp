@@ -67,6 +67,137 @@ TEST_CASE("use_pool_threads_for_pbf_parsing") {
     REQUIRE(osmium::config::use_pool_threads_for_pbf_parsing());
 }
 
+TEST_CASE("use_mmap_for_pbf_reading") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_mmap_for_pbf_reading());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_MMAP_FOR_PBF_READING");
+    osmium::detail::env = "";
+    REQUIRE_FALSE(osmium::config::use_mmap_for_pbf_reading());
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_mmap_for_pbf_reading());
+    osmium::detail::env = "0";
+    REQUIRE_FALSE(osmium::config::use_mmap_for_pbf_reading());
+
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_mmap_for_pbf_reading());
+    osmium::detail::env = "ON";
+    REQUIRE(osmium::config::use_mmap_for_pbf_reading());
+    osmium::detail::env = "true";
+    REQUIRE(osmium::config::use_mmap_for_pbf_reading());
+    osmium::detail::env = "1";
+    REQUIRE(osmium::config::use_mmap_for_pbf_reading());
+}
+
+TEST_CASE("use_blob_table_for_pbf_reading") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_blob_table_for_pbf_reading());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_BLOB_TABLE_FOR_PBF_READING");
+    osmium::detail::env = "off";
+    REQUIRE_FALSE(osmium::config::use_blob_table_for_pbf_reading());
+    osmium::detail::env = "on";
+    REQUIRE(osmium::config::use_blob_table_for_pbf_reading());
+}
+
+TEST_CASE("use_parallel_xml_parsing") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_parallel_xml_parsing());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_PARALLEL_XML_PARSING");
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_parallel_xml_parsing());
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_parallel_xml_parsing());
+}
+
+TEST_CASE("use_parallel_opl_parsing") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_parallel_opl_parsing());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_PARALLEL_OPL_PARSING");
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_parallel_opl_parsing());
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_parallel_opl_parsing());
+}
+
+TEST_CASE("use_io_uring") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_io_uring());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_IO_URING");
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_io_uring());
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_io_uring());
+}
+
+TEST_CASE("get_io_uring_queue_depth") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::get_io_uring_queue_depth() == 0);
+    REQUIRE(osmium::detail::name == "OSMIUM_IO_URING_QUEUE_DEPTH");
+    osmium::detail::env = "";
+    REQUIRE(osmium::config::get_io_uring_queue_depth() == 0);
+    osmium::detail::env = "16";
+    REQUIRE(osmium::config::get_io_uring_queue_depth() == 16);
+}
+
+TEST_CASE("use_direct_io") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_direct_io());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_DIRECT_IO");
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_direct_io());
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_direct_io());
+}
+
+TEST_CASE("use_parallel_o5m_parsing") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_parallel_o5m_parsing());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_PARALLEL_O5M_PARSING");
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_parallel_o5m_parsing());
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_parallel_o5m_parsing());
+}
+
+TEST_CASE("use_fast_xml_tokenizer") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::use_fast_xml_tokenizer());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_FAST_XML_TOKENIZER");
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_fast_xml_tokenizer());
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_fast_xml_tokenizer());
+}
+
+TEST_CASE("use_numa") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_numa());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_NUMA");
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_numa());
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_numa());
+}
+
+TEST_CASE("use_buffer_pool") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_buffer_pool());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_BUFFER_POOL");
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_buffer_pool());
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_buffer_pool());
+}
+
+TEST_CASE("use_huge_pages_for_buffers") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_huge_pages_for_buffers());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_HUGE_PAGES_FOR_BUFFERS");
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_huge_pages_for_buffers());
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_huge_pages_for_buffers());
+}
+
 TEST_CASE("get_max_queue_size") {
     osmium::detail::env = nullptr;
     REQUIRE(osmium::config::get_max_queue_size("NAME", 0) == 2);
@@ -82,3 +213,35 @@ TEST_CASE("get_max_queue_size") {
     REQUIRE(osmium::config::get_max_queue_size("NAME", 7) == 3);
 }
 
+
+TEST_CASE("get_simd_override") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::get_simd_override() == nullptr);
+    REQUIRE(osmium::detail::name == "OSMIUM_SIMD");
+    osmium::detail::env = "";
+    REQUIRE(osmium::config::get_simd_override() == nullptr);
+    osmium::detail::env = "avx2";
+    REQUIRE(std::string{osmium::config::get_simd_override()} == "avx2");
+}
+
+TEST_CASE("get_thread_policy") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::get_thread_policy() == nullptr);
+    REQUIRE(osmium::detail::name == "OSMIUM_THREAD_POLICY");
+    osmium::detail::env = "";
+    REQUIRE(osmium::config::get_thread_policy() == nullptr);
+    osmium::detail::env = "io:0-1;worker:2-31";
+    REQUIRE(std::string{osmium::config::get_thread_policy()} == "io:0-1;worker:2-31");
+}
+
+TEST_CASE("get_sort_memory_budget") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::get_sort_memory_budget() == 0);
+    REQUIRE(osmium::detail::name == "OSMIUM_SORT_MEMORY_BUDGET");
+    osmium::detail::env = "";
+    REQUIRE(osmium::config::get_sort_memory_budget() == 0);
+    osmium::detail::env = "foo";
+    REQUIRE(osmium::config::get_sort_memory_budget() == 0);
+    osmium::detail::env = "3";
+    REQUIRE(osmium::config::get_sort_memory_budget() == 3UL * 1024UL * 1024UL);
+}
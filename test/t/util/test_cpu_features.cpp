@@ -0,0 +1,147 @@
+#include "catch.hpp"
+
+#include <osmium/osm/crc_crc32c.hpp>
+#include <osmium/util/cpu_features.hpp>
+
+#include <string>
+
+namespace {
+
+    int impl_none() {
+        return 0;
+    }
+
+    int impl_sse4_2() {
+        return 1;
+    }
+
+    int impl_avx2() {
+        return 2;
+    }
+
+    int impl_neon() {
+        return 4;
+    }
+
+    int select(osmium::util::simd_level max) {
+        using func_type = int();
+        return osmium::util::select_implementation<func_type>({
+            {osmium::util::simd_level::avx2, impl_avx2},
+            {osmium::util::simd_level::sse4_2, impl_sse4_2},
+            {osmium::util::simd_level::neon, impl_neon},
+            {osmium::util::simd_level::none, impl_none}
+        }, max)();
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Parse SIMD level") {
+    osmium::util::simd_level level = osmium::util::simd_level::none;
+
+    REQUIRE(osmium::util::parse_simd_level("avx2", &level));
+    REQUIRE(level == osmium::util::simd_level::avx2);
+    REQUIRE(std::string{osmium::util::as_string(level)} == "avx2");
+
+    REQUIRE(osmium::util::parse_simd_level("sse4.2", &level));
+    REQUIRE(level == osmium::util::simd_level::sse4_2);
+
+    REQUIRE(osmium::util::parse_simd_level("none", &level));
+    REQUIRE(level == osmium::util::simd_level::none);
+
+    REQUIRE_FALSE(osmium::util::parse_simd_level("foo", &level));
+    REQUIRE_FALSE(osmium::util::parse_simd_level(nullptr, &level));
+    REQUIRE(level == osmium::util::simd_level::none);
+}
+
+TEST_CASE("SIMD levels include lower levels on the same architecture") {
+    using osmium::util::simd_level;
+    using osmium::util::simd_level_includes;
+
+    REQUIRE(simd_level_includes(simd_level::avx512, simd_level::avx2));
+    REQUIRE(simd_level_includes(simd_level::avx2, simd_level::sse4_2));
+    REQUIRE(simd_level_includes(simd_level::sse4_2, simd_level::none));
+    REQUIRE_FALSE(simd_level_includes(simd_level::sse4_2, simd_level::avx2));
+    REQUIRE_FALSE(simd_level_includes(simd_level::avx512, simd_level::neon));
+    REQUIRE_FALSE(simd_level_includes(simd_level::neon, simd_level::sse4_2));
+    REQUIRE(simd_level_includes(simd_level::neon, simd_level::none));
+}
+
+TEST_CASE("Best SIMD level from CPU features") {
+    osmium::util::cpu_features features;
+    REQUIRE(features.best_simd_level() == osmium::util::simd_level::none);
+
+    features.sse4_2 = true;
+    features.popcnt = true;
+    REQUIRE(features.best_simd_level() == osmium::util::simd_level::sse4_2);
+
+    features.avx2 = true;
+    REQUIRE(features.best_simd_level() == osmium::util::simd_level::sse4_2);
+
+    features.bmi1 = true;
+    features.bmi2 = true;
+    features.fma = true;
+    REQUIRE(features.best_simd_level() == osmium::util::simd_level::avx2);
+
+    features.avx512f = true;
+    features.avx512bw = true;
+    features.avx512vl = true;
+    REQUIRE(features.best_simd_level() == osmium::util::simd_level::avx2);
+
+    features.avx512dq = true;
+    REQUIRE(features.best_simd_level() == osmium::util::simd_level::avx512);
+}
+
+TEST_CASE("Limit SIMD level") {
+    using osmium::util::simd_level;
+    using osmium::detail::limit_simd_level;
+
+    REQUIRE(limit_simd_level(simd_level::avx512, nullptr) == simd_level::avx512);
+    REQUIRE(limit_simd_level(simd_level::avx512, "foo") == simd_level::avx512);
+    REQUIRE(limit_simd_level(simd_level::avx512, "avx2") == simd_level::avx2);
+    REQUIRE(limit_simd_level(simd_level::sse4_2, "avx2") == simd_level::sse4_2);
+    REQUIRE(limit_simd_level(simd_level::avx2, "none") == simd_level::none);
+    REQUIRE(limit_simd_level(simd_level::avx2, "neon") == simd_level::none);
+    REQUIRE(limit_simd_level(simd_level::neon, "avx512") == simd_level::none);
+    REQUIRE(limit_simd_level(simd_level::neon, "neon") == simd_level::neon);
+}
+
+TEST_CASE("Select implementation") {
+    REQUIRE(select(osmium::util::simd_level::avx512) == 2);
+    REQUIRE(select(osmium::util::simd_level::avx2) == 2);
+    REQUIRE(select(osmium::util::simd_level::sse4_2) == 1);
+    REQUIRE(select(osmium::util::simd_level::neon) == 4);
+    REQUIRE(select(osmium::util::simd_level::none) == 0);
+
+    using func_type = int();
+    REQUIRE(osmium::util::select_implementation<func_type>({
+        {osmium::util::simd_level::avx2, impl_avx2}
+    }, osmium::util::simd_level::none) == nullptr);
+}
+
+TEST_CASE("Detected SIMD level is supported by the CPU") {
+    const auto& features = osmium::util::get_cpu_features();
+    const auto level = osmium::util::get_simd_level();
+    REQUIRE(osmium::util::simd_level_includes(features.best_simd_level(), level));
+}
+
+#ifdef OSMIUM_CRC32C_DISPATCH
+TEST_CASE("CRC32C implementations selected for all SIMD levels give same result") {
+    std::string data;
+    for (int i = 0; i < 1000; ++i) {
+        data += static_cast<char>(i * 13 + 5);
+    }
+    const auto* begin = reinterpret_cast<const unsigned char*>(data.data());
+
+    const auto max = osmium::util::get_simd_level();
+    for (const auto level : {osmium::util::simd_level::none, osmium::util::simd_level::sse4_2}) {
+        if (osmium::util::simd_level_includes(max, level)) {
+            auto* func = osmium::detail::crc32c_select(level);
+            for (std::size_t size = 0; size < 100; ++size) {
+                REQUIRE(func(0xffffffffUL, begin, size) == osmium::detail::crc32c_software(0xffffffffUL, begin, size));
+            }
+            REQUIRE(func(0xffffffffUL, begin, data.size()) == osmium::detail::crc32c_software(0xffffffffUL, begin, data.size()));
+        }
+    }
+}
+#endif
+
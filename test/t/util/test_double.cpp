@@ -2,6 +2,9 @@
 
 #include <osmium/util/double.hpp>
 
+#include <cmath>
+#include <cstdio>
+#include <random>
 #include <string>
 
 TEST_CASE("Check double2string function") {
@@ -28,5 +31,65 @@ TEST_CASE("Check double2string function") {
     std::string s6;
     osmium::double2string(s6, -0.0, 7);
     REQUIRE(s6 == "-0");
+
+    std::string s7;
+    osmium::double2string(s7, 10.0, 0);
+    REQUIRE(s7 == "10");
+
+    std::string s8;
+    osmium::double2string(s8, 1e8, 7);
+    REQUIRE(s8 == "100000000");
+}
+
+
+static std::string reference_double2string(double value, int precision) {
+    char buffer[400];
+    int len = std::snprintf(buffer, sizeof(buffer), "%.*f", precision, value);
+    if (precision > 0) {
+        while (buffer[len - 1] == '0') {
+            --len;
+        }
+        if (buffer[len - 1] == '.') {
+            --len;
+        }
+    }
+    return std::string(buffer, static_cast<std::size_t>(len));
 }
 
+TEST_CASE("double2string with values close to rounding boundaries") {
+    const double values[] = {
+        0.5, 1.5, 2.5, -0.5, 0.125, 0.00000005, 0.00000015, 1.00000005,
+        123.45678905, 9.99999995, 99999999.99999999, 123456789.0,
+        0.1, 0.2, 0.3, 1e-8, -1e-8, 1e-300
+    };
+
+    for (const double value : values) {
+        for (int precision = 0; precision <= 17; ++precision) {
+            std::string s;
+            osmium::double2string(s, value, precision);
+            REQUIRE(s == reference_double2string(value, precision));
+        }
+    }
+}
+
+TEST_CASE("double2string with random values gives same result as snprintf") {
+    std::mt19937_64 gen{42}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    std::uniform_real_distribution<double> coordinate{-180.0, 180.0};
+    std::uniform_int_distribution<int> exponent{-12, 6};
+    std::uniform_int_distribution<int> precision_dist{0, 17};
+
+    for (int i = 0; i < 100000; ++i) {
+        const double value = coordinate(gen) * std::pow(10.0, exponent(gen));
+        const int precision = precision_dist(gen);
+        std::string s;
+        osmium::double2string(s, value, precision);
+        REQUIRE(s == reference_double2string(value, precision));
+    }
+
+    for (int i = 0; i < 100000; ++i) {
+        const double value = coordinate(gen);
+        std::string s;
+        osmium::double2string(s, value, 7);
+        REQUIRE(s == reference_double2string(value, 7));
+    }
+}
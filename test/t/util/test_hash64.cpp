@@ -0,0 +1,56 @@
+#include "catch.hpp"
+
+#include <osmium/util/hash64.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+TEST_CASE("Hash64 of known values") {
+    REQUIRE(osmium::hash64("", 0) == 0xef46db3751d8e999ULL);
+    REQUIRE(osmium::hash64("abc", 3) == 0x44bc2cf5ad770999ULL);
+}
+
+TEST_CASE("Hash64 with different seeds is different") {
+    const char* str = "abc";
+    REQUIRE(osmium::hash64(str, 3, 0) != osmium::hash64(str, 3, 42));
+}
+
+TEST_CASE("Hash64 in chunks and in one go is the same") {
+    std::string data;
+    for (int i = 0; i < 300; ++i) {
+        data += static_cast<char>(i * 7 + 3);
+    }
+
+    const auto expected = osmium::hash64(data.data(), data.size());
+
+    SECTION("byte-wise") {
+        osmium::Hash64 hash;
+        for (const char c : data) {
+            hash.update(&c, 1);
+        }
+        REQUIRE(hash.digest() == expected);
+    }
+
+    SECTION("uneven chunks") {
+        osmium::Hash64 hash;
+        std::size_t pos = 0;
+        std::size_t len = 1;
+        while (pos < data.size()) {
+            const auto n = std::min(len, data.size() - pos);
+            hash.update(data.data() + pos, n);
+            pos += n;
+            len += 5;
+        }
+        REQUIRE(hash.digest() == expected);
+    }
+}
+
+TEST_CASE("Hash64 of integers is the same as of their little-endian bytes") {
+    osmium::Hash64 hash1;
+    hash1.update_int32(0x04030201U);
+    hash1.update_int64(0x0c0b0a0908070605ULL);
+
+    const char bytes[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    REQUIRE(hash1.digest() == osmium::hash64(bytes, sizeof(bytes)));
+}
@@ -0,0 +1,72 @@
+#include "catch.hpp"
+
+#include <osmium/util/hyperloglog.hpp>
+
+#include <stdexcept>
+#include <string>
+
+static void add_numbers(osmium::HyperLogLog& hll, int from, int to) {
+    for (int i = from; i < to; ++i) {
+        const std::string str = std::to_string(i);
+        hll.add(str.data(), str.size());
+    }
+}
+
+TEST_CASE("HyperLogLog precision must be in range") {
+    REQUIRE_THROWS_AS(osmium::HyperLogLog{3}, std::invalid_argument);
+    REQUIRE_THROWS_AS(osmium::HyperLogLog{19}, std::invalid_argument);
+    REQUIRE(osmium::HyperLogLog{}.precision() == 12);
+}
+
+TEST_CASE("HyperLogLog is exact for small sets") {
+    osmium::HyperLogLog hll;
+    REQUIRE(hll.exact());
+    REQUIRE(hll.estimate() == Approx(0.0));
+
+    add_numbers(hll, 0, 100);
+    add_numbers(hll, 0, 100);
+
+    REQUIRE(hll.exact());
+    REQUIRE(hll.estimate() == Approx(100.0));
+}
+
+TEST_CASE("HyperLogLog estimates large sets") {
+    osmium::HyperLogLog hll{12};
+
+    add_numbers(hll, 0, 100000);
+    add_numbers(hll, 0, 50000);
+
+    REQUIRE_FALSE(hll.exact());
+    REQUIRE(hll.estimate() == Approx(100000.0).epsilon(0.05));
+}
+
+TEST_CASE("HyperLogLog uses linear counting for medium sets") {
+    osmium::HyperLogLog hll{10};
+
+    add_numbers(hll, 0, 1000);
+
+    REQUIRE_FALSE(hll.exact());
+    REQUIRE(hll.estimate() == Approx(1000.0).epsilon(0.1));
+}
+
+TEST_CASE("Merged HyperLogLog sketches are the same as one sketch") {
+    osmium::HyperLogLog all;
+    osmium::HyperLogLog a;
+    osmium::HyperLogLog b;
+    osmium::HyperLogLog c;
+
+    add_numbers(all, 0, 60000);
+    add_numbers(a, 0, 30000);
+    add_numbers(b, 20000, 60000);
+    add_numbers(c, 5, 10);
+
+    a.merge(b);
+    a.merge(c);
+    REQUIRE(a.estimate() == Approx(all.estimate()));
+
+    c.merge(all);
+    REQUIRE(c.estimate() == Approx(all.estimate()));
+
+    osmium::HyperLogLog other{10};
+    REQUIRE_THROWS_AS(a.merge(other), std::invalid_argument);
+}
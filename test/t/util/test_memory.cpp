@@ -9,10 +9,14 @@ TEST_CASE("Check memory usage") {
     const osmium::MemoryUsage m1;
     REQUIRE(m1.current() > 1);
     REQUIRE(m1.peak() > 1);
+    REQUIRE(m1.resident() > 0);
+    REQUIRE(m1.peak_resident() >= m1.resident());
 #else
     const osmium::MemoryUsage m;
     REQUIRE(m.current() == 0);
     REQUIRE(m.peak() == 0);
+    REQUIRE(m.resident() == 0);
+    REQUIRE(m.peak_resident() == 0);
 #endif
 }
 
@@ -107,6 +107,25 @@ TEST_CASE("Anonymous mapping: remapping to smaller size should work") {
     const auto* addr2 = mapping.get_addr<int>();
     REQUIRE(*addr2 == 42);
 }
+
+TEST_CASE("Anonymous mapping: mapping with options should work") {
+    osmium::mapping_options options;
+    options.huge_pages = true;
+    options.advice = osmium::mapping_options::access_advice::random;
+
+    osmium::MemoryMapping mapping{1000, osmium::MemoryMapping::mapping_mode::write_private, -1, 0, options};
+    REQUIRE(mapping.options().huge_pages);
+    REQUIRE(mapping.options().advice == osmium::mapping_options::access_advice::random);
+
+    auto* addr1 = mapping.get_addr<int>();
+    *addr1 = 42;
+
+    mapping.resize(8000);
+    REQUIRE(mapping.options().huge_pages);
+
+    const auto* addr2 = mapping.get_addr<int>();
+    REQUIRE(*addr2 == 42);
+}
 #endif
 
 TEST_CASE("File-based mapping: writing to a mapped file should work") {
@@ -145,6 +164,30 @@ TEST_CASE("File-based mapping: writing to a mapped file should work") {
     REQUIRE(0 == unlink(filename));
 }
 
+TEST_CASE("File-based mapping: mapping with populate option should work") {
+    char filename[] = "test_mmap_populate_XXXXXX";
+    const int fd = mkstemp(filename);
+    REQUIRE(fd > 0);
+
+    osmium::resize_file(fd, 100);
+
+    osmium::mapping_options options;
+    options.populate = true;
+    options.advice = osmium::mapping_options::access_advice::sequential;
+
+    {
+        osmium::MemoryMapping mapping{100, osmium::MemoryMapping::mapping_mode::write_shared, fd, 0, options};
+        REQUIRE(mapping.options().populate);
+        *mapping.get_addr<int>() = 1234;
+
+        mapping.resize(8000);
+        REQUIRE(*mapping.get_addr<int>() == 1234);
+    }
+
+    REQUIRE(0 == close(fd));
+    REQUIRE(0 == unlink(filename));
+}
+
 TEST_CASE("File-based mapping: Reading from a zero-sized mapped file should work") {
     char filename[] = "test_mmap_read_zero_XXXXXX";
     const int fd = mkstemp(filename);
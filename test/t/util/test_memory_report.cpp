@@ -0,0 +1,64 @@
+#include "catch.hpp"
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/util/memory_report.hpp>
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+namespace {
+
+struct FixedSize {
+    std::size_t used_memory() const noexcept {
+        return 4096;
+    }
+};
+
+} // anonymous namespace
+
+TEST_CASE("Empty memory report") {
+    const osmium::MemoryReport report;
+    REQUIRE(report.entries().empty());
+    REQUIRE(report.total() == 0);
+    REQUIRE(report.get("foo") == 0);
+}
+
+TEST_CASE("Memory report with numbers and objects") {
+    osmium::MemoryReport report;
+    report.add("numbers", 1024);
+    report.add("object", FixedSize{});
+
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> ids;
+    ids.set(1000000);
+    report.add("ids", ids);
+
+    REQUIRE(report.entries().size() == 3);
+    REQUIRE(report.entries()[0].first == "numbers");
+    REQUIRE(report.get("numbers") == 1024);
+    REQUIRE(report.get("object") == 4096);
+    REQUIRE(report.get("ids") == ids.used_memory());
+    REQUIRE(report.total() == 1024 + 4096 + ids.used_memory());
+
+    SECTION("Adding existing name replaces entry") {
+        report.add("numbers", 2048);
+        REQUIRE(report.entries().size() == 3);
+        REQUIRE(report.get("numbers") == 2048);
+    }
+
+    SECTION("Print report") {
+        std::ostringstream out;
+        report.print(out);
+        const std::string str = out.str();
+        REQUIRE(str.find("  numbers:") == 0);
+        REQUIRE(str.find("object:") != std::string::npos);
+        REQUIRE(str.find("total:") != std::string::npos);
+        REQUIRE(str.find("process:") != std::string::npos);
+    }
+
+    SECTION("Clear report") {
+        report.clear();
+        REQUIRE(report.entries().empty());
+        REQUIRE(report.total() == 0);
+    }
+}
@@ -0,0 +1,38 @@
+#include "catch.hpp"
+
+#include <osmium/util/memory_mapping.hpp>
+#include <osmium/util/numa.hpp>
+
+#include <vector>
+
+TEST_CASE("Parse CPU list") {
+    using osmium::detail::parse_cpu_list;
+
+    REQUIRE(parse_cpu_list("").empty());
+    REQUIRE(parse_cpu_list("\n").empty());
+
+    const std::vector<int> single = {3};
+    REQUIRE(parse_cpu_list("3") == single);
+
+    const std::vector<int> list = {0, 1, 2, 3, 8, 10, 11};
+    REQUIRE(parse_cpu_list("0-3,8,10-11") == list);
+    REQUIRE(parse_cpu_list("0-3,8,10-11\n") == list);
+}
+
+TEST_CASE("Get NUMA nodes") {
+    const auto nodes = osmium::util::get_numa_nodes();
+    for (const auto& node : nodes) {
+        REQUIRE(node.id >= 0);
+        REQUIRE_FALSE(node.cpus.empty());
+    }
+}
+
+TEST_CASE("Interleaving memory does not change content") {
+    const auto nodes = osmium::util::get_numa_nodes();
+    osmium::util::TypedMemoryMapping<int> mapping{1000};
+    osmium::util::interleave_memory(mapping.begin(), mapping.size() * sizeof(int), nodes);
+    for (int i = 0; i < 1000; ++i) {
+        mapping.begin()[i] = i;
+    }
+    REQUIRE(mapping.begin()[999] == 999);
+}
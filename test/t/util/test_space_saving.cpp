@@ -0,0 +1,94 @@
+#include "catch.hpp"
+
+#include <osmium/util/space_saving.hpp>
+
+#include <stdexcept>
+#include <string>
+
+TEST_CASE("SpaceSaving needs counters") {
+    REQUIRE_THROWS_AS(osmium::SpaceSaving{0}, std::invalid_argument);
+}
+
+TEST_CASE("SpaceSaving counts exactly while there are enough counters") {
+    osmium::SpaceSaving sketch{4};
+
+    sketch.add("a");
+    sketch.add("b");
+    sketch.add("a");
+    sketch.add("c", 1, 5);
+
+    REQUIRE(sketch.size() == 3);
+    REQUIRE(sketch.total() == 8);
+
+    const auto top = sketch.top(2);
+    REQUIRE(top.size() == 2);
+    REQUIRE(top[0].item == "c");
+    REQUIRE(top[0].count == 5);
+    REQUIRE(top[0].error == 0);
+    REQUIRE(top[1].item == "a");
+    REQUIRE(top[1].count == 2);
+}
+
+TEST_CASE("SpaceSaving finds frequent items in long stream") {
+    osmium::SpaceSaving sketch{10};
+
+    for (int i = 0; i < 10000; ++i) {
+        sketch.add("frequent");
+        if (i % 2 == 0) {
+            sketch.add("common");
+        }
+        const std::string rare = "rare" + std::to_string(i);
+        sketch.add(rare.data(), rare.size());
+    }
+
+    REQUIRE(sketch.full());
+    const auto top = sketch.top(2);
+    REQUIRE(top[0].item == "frequent");
+    REQUIRE(top[0].count == 10000);
+    REQUIRE(top[1].item == "common");
+    REQUIRE(top[1].count == 5000);
+    REQUIRE(top[1].count - top[1].error <= 5000);
+}
+
+TEST_CASE("Merged SpaceSaving sketches") {
+    osmium::SpaceSaving a{3};
+    osmium::SpaceSaving b{3};
+
+    a.add("x", 1, 10);
+    a.add("y", 1, 5);
+    b.add("x", 1, 7);
+    b.add("z", 1, 8);
+
+    a.merge(b);
+
+    REQUIRE(a.total() == 30);
+    REQUIRE(a.size() == 3);
+    const auto top = a.top(3);
+    REQUIRE(top[0].item == "x");
+    REQUIRE(top[0].count == 17);
+    REQUIRE(top[1].item == "z");
+    REQUIRE(top[1].count == 8);
+    REQUIRE(top[2].item == "y");
+    REQUIRE(top[2].count == 5);
+}
+
+TEST_CASE("Merged full SpaceSaving sketches keep capacity") {
+    osmium::SpaceSaving a{2};
+    osmium::SpaceSaving b{2};
+
+    a.add("p", 1, 10);
+    a.add("q", 1, 2);
+    b.add("r", 1, 9);
+    b.add("s", 1, 1);
+
+    a.merge(b);
+
+    REQUIRE(a.size() == 2);
+    const auto top = a.top(2);
+    REQUIRE(top[0].item == "p");
+    REQUIRE(top[0].count == 11);
+    REQUIRE(top[0].error == 1);
+    REQUIRE(top[1].item == "r");
+    REQUIRE(top[1].count == 11);
+    REQUIRE(top[1].error == 2);
+}
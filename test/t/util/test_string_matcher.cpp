@@ -2,6 +2,7 @@
 
 #include <osmium/util/string_matcher.hpp>
 
+#include <random>
 #include <sstream>
 #include <string>
 #include <type_traits>
@@ -102,6 +103,47 @@ TEST_CASE("String matcher: regex substr") {
     REQUIRE(m.match("xfoox"));
     REQUIRE_FALSE(m.match(""));
 }
+
+TEST_CASE("String matcher: regex from pattern string") {
+    const osmium::StringMatcher::regex m{"^name:[a-z]+$"};
+    REQUIRE(m.match("name:de"));
+    REQUIRE_FALSE(m.match("name:"));
+    REQUIRE_FALSE(m.match("name:DE"));
+    REQUIRE_FALSE(m.match("old_name:de"));
+    REQUIRE_FALSE(m.match(""));
+}
+
+TEST_CASE("String matcher: regex from pattern string with flags") {
+    const osmium::StringMatcher::regex m{"^FOO", std::regex::icase};
+    REQUIRE(m.match("foo"));
+    REQUIRE(m.match("FOObar"));
+    REQUIRE_FALSE(m.match("xfoo"));
+}
+
+TEST_CASE("String matcher: regex from pattern string gives same results as std::regex") {
+    const std::vector<std::string> patterns = {
+        "", "^", "foo", "^foo", "^foo$", "fo+", "^fo*", "fo?x", "^a{2}", "a|b",
+        "^name\\:", "^addr:.*", "\\.", "^a\\.b", "^a\\d", "(ab)+c", "^x+?y",
+        "[0-9]", "^ab[c]", "^(a)\\1", "oo$"
+    };
+    const std::vector<std::string> strings = {
+        "", "f", "foo", "fooo", "xfoo", "fx", "fox", "aa", "a", "b", "name:",
+        "addr:street", "a.b", "ab", "a1", "ababc", "xxy", "y", "5", "abc", "aa1"
+    };
+
+    for (const auto& pattern : patterns) {
+        const osmium::StringMatcher::regex m{pattern};
+        const std::regex r{pattern};
+        for (const auto& str : strings) {
+            INFO("pattern '" << pattern << "' string '" << str << "'");
+            REQUIRE(m.match(str.c_str()) == std::regex_search(str, r));
+        }
+    }
+}
+
+TEST_CASE("String matcher: invalid regex pattern string") {
+    REQUIRE_THROWS_AS(osmium::StringMatcher::regex{"^foo("}, std::regex_error);
+}
 #endif
 
 TEST_CASE("String matcher: list") {
@@ -126,6 +168,90 @@ TEST_CASE("String matcher: list with add") {
     REQUIRE_FALSE(m.match(""));
 }
 
+TEST_CASE("String matcher: substring_list") {
+    const osmium::StringMatcher::substring_list m{{"foo", "bar", "oba"}};
+    REQUIRE(m.match("foo"));
+    REQUIRE(m.match("xfoox"));
+    REQUIRE(m.match("xxbar"));
+    REQUIRE(m.match("fobar"));
+    REQUIRE(m.match("fobax"));
+    REQUIRE_FALSE(m.match("fo"));
+    REQUIRE_FALSE(m.match("xfobxa"));
+    REQUIRE_FALSE(m.match(""));
+    REQUIRE(print(osmium::StringMatcher{osmium::StringMatcher::substring_list{m}}) == "substring_list[[foo][bar][oba]]");
+}
+
+TEST_CASE("String matcher: empty substring_list") {
+    const osmium::StringMatcher::substring_list m{{}};
+    REQUIRE_FALSE(m.match("foo"));
+    REQUIRE_FALSE(m.match(""));
+}
+
+TEST_CASE("String matcher: substring_list with empty string matches everything") {
+    const osmium::StringMatcher::substring_list m{{"foo", ""}};
+    REQUIRE(m.match("bar"));
+    REQUIRE(m.match(""));
+}
+
+TEST_CASE("String matcher: prefix_list") {
+    const osmium::StringMatcher::prefix_list m{{"name:", "alt_name", "old_name:"}};
+    REQUIRE(m.match("name:de"));
+    REQUIRE(m.match("alt_name"));
+    REQUIRE(m.match("alt_name:en"));
+    REQUIRE(m.match("old_name:fr"));
+    REQUIRE_FALSE(m.match("name"));
+    REQUIRE_FALSE(m.match("old_name"));
+    REQUIRE_FALSE(m.match("xname:de"));
+    REQUIRE_FALSE(m.match(""));
+    REQUIRE(print(osmium::StringMatcher{osmium::StringMatcher::prefix_list{m}}) == "prefix_list[[name:][alt_name][old_name:]]");
+}
+
+TEST_CASE("String matcher: substring_list and prefix_list give same results as single matchers") {
+    std::mt19937 gen{5}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    std::uniform_int_distribution<int> length{0, 6};
+    std::uniform_int_distribution<int> letter{0, 3};
+
+    const auto random_string = [&](int max_length) {
+        std::string str;
+        const int len = length(gen) % (max_length + 1);
+        for (int i = 0; i < len; ++i) {
+            str += static_cast<char>('a' + letter(gen));
+        }
+        return str;
+    };
+
+    for (int n = 0; n < 200; ++n) {
+        std::vector<std::string> patterns;
+        const int num_patterns = 1 + n % 10;
+        for (int i = 0; i < num_patterns; ++i) {
+            std::string pattern = random_string(4);
+            if (pattern.empty()) {
+                pattern = "d";
+            }
+            patterns.push_back(pattern);
+        }
+
+        const osmium::StringMatcher::substring_list substrings{patterns};
+        const osmium::StringMatcher::prefix_list prefixes{patterns};
+        const osmium::StringMatcher::list list{patterns};
+
+        for (int i = 0; i < 50; ++i) {
+            const std::string str = random_string(6) + random_string(6);
+            bool any_substring = false;
+            bool any_prefix = false;
+            bool any_equal = false;
+            for (const auto& pattern : patterns) {
+                any_substring = any_substring || osmium::StringMatcher::substring{pattern}.match(str.c_str());
+                any_prefix = any_prefix || osmium::StringMatcher::prefix{pattern}.match(str.c_str());
+                any_equal = any_equal || osmium::StringMatcher::equal{pattern}.match(str.c_str());
+            }
+            REQUIRE(substrings.match(str.c_str()) == any_substring);
+            REQUIRE(prefixes.match(str.c_str()) == any_prefix);
+            REQUIRE(list.match(str.c_str()) == any_equal);
+        }
+    }
+}
+
 TEST_CASE("Default constructed StringMatcher matches nothing") {
     const osmium::StringMatcher m;
     REQUIRE_FALSE(m("foo"));
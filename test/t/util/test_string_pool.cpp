@@ -0,0 +1,72 @@
+#include "catch.hpp"
+
+#include <osmium/util/string_pool.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+TEST_CASE("Empty string pool") {
+    const osmium::StringPool pool;
+    REQUIRE(pool.empty());
+    REQUIRE(pool.size() == 0);
+    REQUIRE(pool.find("foo") == osmium::StringPool::not_found);
+    REQUIRE(pool.find("") == osmium::StringPool::not_found);
+}
+
+TEST_CASE("Add strings to string pool") {
+    osmium::StringPool pool;
+
+    REQUIRE(pool.add("highway") == 0);
+    REQUIRE(pool.add("name") == 1);
+    REQUIRE(pool.add("highway") == 0);
+    REQUIRE(pool.add("") == 2);
+    REQUIRE(pool.add("highwayfoo", 7) == 0);
+    REQUIRE(pool.size() == 3);
+
+    REQUIRE(pool.find("name") == 1);
+    REQUIRE(pool.find("") == 2);
+    REQUIRE(pool.find("nam") == osmium::StringPool::not_found);
+    REQUIRE(pool.find("name", 3) == osmium::StringPool::not_found);
+
+    REQUIRE(std::string{pool.get(0)} == "highway");
+    REQUIRE(pool.length(0) == 7);
+    REQUIRE(std::string{pool.get(2)} == "");
+}
+
+TEST_CASE("Strings in string pool stay in place") {
+    osmium::StringPool pool;
+
+    const char* first = pool.get(pool.add("first"));
+    const std::string large(20000, 'x');
+    const char* large_ptr = pool.get(pool.add(large.c_str()));
+
+    std::vector<std::string> strings;
+    for (int i = 0; i < 100000; ++i) {
+        strings.push_back("key" + std::to_string(i));
+        REQUIRE(pool.add(strings.back().c_str()) == static_cast<osmium::StringPool::id_type>(i + 2));
+    }
+
+    REQUIRE(pool.size() == 100002);
+    REQUIRE(pool.get(0) == first);
+    REQUIRE(std::string{first} == "first");
+    REQUIRE(pool.get(1) == large_ptr);
+    REQUIRE(large == large_ptr);
+
+    for (int i = 0; i < 100000; ++i) {
+        REQUIRE(pool.find(strings[i].c_str()) == static_cast<osmium::StringPool::id_type>(i + 2));
+        REQUIRE(std::strcmp(pool.get(i + 2), strings[i].c_str()) == 0);
+    }
+}
+
+TEST_CASE("Clear string pool") {
+    osmium::StringPool pool;
+    pool.add("foo");
+    pool.add("bar");
+    pool.clear();
+
+    REQUIRE(pool.empty());
+    REQUIRE(pool.find("foo") == osmium::StringPool::not_found);
+    REQUIRE(pool.add("bar") == 0);
+    REQUIRE(std::string{pool.get(0)} == "bar");
+}